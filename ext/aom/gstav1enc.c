@@ -116,6 +116,24 @@ gst_end_usage_mode_get_type (void)
   return end_usage_mode_type;
 }
 
+#define GST_TYPE_USAGE_PROFILE (gst_usage_profile_get_type())
+static GType
+gst_usage_profile_get_type (void)
+{
+  static GType usage_profile_type = 0;
+  static const GEnumValue usage_profile[] = {
+    {GST_AV1_ENC_USAGE_GOOD_QUALITY, "Good Quality profile", "good-quality"},
+    {GST_AV1_ENC_USAGE_REALTIME, "Realtime profile", "realtime"},
+    {0, NULL, NULL},
+  };
+
+  if (!usage_profile_type) {
+    usage_profile_type =
+        g_enum_register_static ("GstAV1EncUsageProfile", usage_profile);
+  }
+  return usage_profile_type;
+}
+
 enum
 {
   LAST_SIGNAL
@@ -146,7 +164,8 @@ enum
   PROP_THREADS,
   PROP_ROW_MT,
   PROP_TILE_COLUMNS,
-  PROP_TILE_ROWS
+  PROP_TILE_ROWS,
+  PROP_USAGE_PROFILE
 };
 
 /* From av1/av1_cx_iface.c */
@@ -177,6 +196,7 @@ enum
 #define DEFAULT_ROW_MT                                       TRUE
 #define DEFAULT_TILE_COLUMNS                                    0
 #define DEFAULT_TILE_ROWS                                       0
+#define DEFAULT_USAGE_PROFILE            GST_AV1_ENC_USAGE_GOOD_QUALITY
 
 static void gst_av1_enc_finalize (GObject * object);
 static void gst_av1_enc_set_property (GObject * object, guint prop_id,
@@ -257,7 +277,7 @@ gst_av1_enc_class_init (GstAV1EncClass * klass)
   g_object_class_install_property (gobject_class, PROP_CPU_USED,
       g_param_spec_int ("cpu-used", "CPU Used",
           "CPU Used. A Value greater than 0 will increase encoder speed at the expense of quality.",
-          0, 5, DEFAULT_CPU_USED, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          0, 9, DEFAULT_CPU_USED, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   /* Rate control configurations */
   g_object_class_install_property (gobject_class, PROP_DROP_FRAME,
@@ -398,9 +418,26 @@ gst_av1_enc_class_init (GstAV1EncClass * klass)
           "can enable parallel encoding",
           0, 6, DEFAULT_TILE_ROWS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstAV1Enc:usage-profile:
+   *
+   * Usage profile the encoder is initialized with. The realtime profile
+   * enables the faster coding tools meant for live encoding, together with
+   * #GstAV1Enc:cpu-used values above 6, depending on the libaom version.
+   * Changes only take effect when the encoder is next initialized.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_USAGE_PROFILE,
+      g_param_spec_enum ("usage-profile", "Usage profile",
+          "Usage profile is used to guide the default config for the encoder",
+          GST_TYPE_USAGE_PROFILE, DEFAULT_USAGE_PROFILE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_type_mark_as_plugin_api (GST_TYPE_END_USAGE_MODE, 0);
   gst_type_mark_as_plugin_api (GST_TYPE_RESIZE_MODE, 0);
   gst_type_mark_as_plugin_api (GST_TYPE_SUPERRES_MODE, 0);
+  gst_type_mark_as_plugin_api (GST_TYPE_USAGE_PROFILE, 0);
 }
 
 static void
@@ -425,6 +462,7 @@ gst_av1_enc_init (GstAV1Enc * av1enc)
   av1enc->row_mt = DEFAULT_ROW_MT;
   av1enc->tile_columns = DEFAULT_TILE_COLUMNS;
   av1enc->tile_rows = DEFAULT_TILE_ROWS;
+  av1enc->aom_cfg.g_usage = DEFAULT_USAGE_PROFILE;
 
   av1enc->aom_cfg.rc_dropframe_thresh = DEFAULT_DROP_FRAME;
   av1enc->aom_cfg.rc_resize_mode = DEFAULT_RESIZE_MODE;
@@ -681,6 +719,13 @@ gst_av1_enc_set_format (GstVideoEncoder * encoder, GstVideoCodecState * state)
   av1enc->aom_cfg.g_timebase.den = GST_VIDEO_INFO_FPS_N (info);
   av1enc->aom_cfg.g_error_resilient = AOM_ERROR_RESILIENT_DEFAULT;
 
+#ifndef AOM_USAGE_REALTIME
+  if (av1enc->aom_cfg.g_usage == GST_AV1_ENC_USAGE_REALTIME) {
+    GST_WARNING_OBJECT (av1enc, "libaom has no realtime usage profile");
+    av1enc->aom_cfg.g_usage = GST_AV1_ENC_USAGE_GOOD_QUALITY;
+  }
+#endif
+
   if (av1enc->threads == DEFAULT_THREADS)
     av1enc->aom_cfg.g_threads = g_get_num_processors ();
   else
@@ -767,10 +812,15 @@ gst_av1_enc_process (GstAV1Enc * encoder)
   return ret;
 }
 
+/* libaom takes arbitrary plane pointers and strides, so the input is
+ * wrapped as is instead of being copied into an image of its own */
 static void
 gst_av1_enc_fill_image (GstAV1Enc * enc, GstVideoFrame * frame,
     aom_image_t * image)
 {
+  aom_img_wrap (image, enc->format, enc->aom_cfg.g_w, enc->aom_cfg.g_h, 1,
+      GST_VIDEO_FRAME_PLANE_DATA (frame, 0));
+
   image->planes[AOM_PLANE_Y] = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
   image->planes[AOM_PLANE_U] = GST_VIDEO_FRAME_COMP_DATA (frame, 1);
   image->planes[AOM_PLANE_V] = GST_VIDEO_FRAME_COMP_DATA (frame, 2);
@@ -789,16 +839,13 @@ gst_av1_enc_handle_frame (GstVideoEncoder * encoder, GstVideoCodecFrame * frame)
   GstFlowReturn ret = GST_FLOW_OK;
   GstVideoFrame vframe;
 
-  if (!aom_img_alloc (&raw, av1enc->format, av1enc->aom_cfg.g_w,
-          av1enc->aom_cfg.g_h, 1)) {
-    GST_ERROR_OBJECT (encoder, "Failed to initialize encoder");
-    return FALSE;
+  if (!gst_video_frame_map (&vframe, &av1enc->input_state->info,
+          frame->input_buffer, GST_MAP_READ)) {
+    GST_ERROR_OBJECT (encoder, "Failed to map frame");
+    gst_video_codec_frame_unref (frame);
+    return GST_FLOW_ERROR;
   }
-
-  gst_video_frame_map (&vframe, &av1enc->input_state->info,
-      frame->input_buffer, GST_MAP_READ);
   gst_av1_enc_fill_image (av1enc, &vframe, &raw);
-  gst_video_frame_unmap (&vframe);
 
   if (av1enc->keyframe_dist >= 30) {
     av1enc->keyframe_dist = 0;
@@ -814,7 +861,9 @@ gst_av1_enc_handle_frame (GstVideoEncoder * encoder, GstVideoCodecFrame * frame)
   }
   g_mutex_unlock (&av1enc->encoder_lock);
 
+  /* the encoder has copied the frame into its lookahead */
   aom_img_free (&raw);
+  gst_video_frame_unmap (&vframe);
   gst_video_codec_frame_unref (frame);
 
   if (ret == GST_FLOW_ERROR)
@@ -985,6 +1034,9 @@ gst_av1_enc_set_property (GObject * object, guint prop_id,
       GST_AV1_ENC_APPLY_CODEC_CONTROL (av1enc, AV1E_SET_TILE_ROWS,
           av1enc->tile_rows);
       break;
+    case PROP_USAGE_PROFILE:
+      av1enc->aom_cfg.g_usage = g_value_get_enum (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1080,6 +1132,9 @@ gst_av1_enc_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_TILE_ROWS:
       g_value_set_uint (value, av1enc->tile_rows);
       break;
+    case PROP_USAGE_PROFILE:
+      g_value_set_enum (value, av1enc->aom_cfg.g_usage);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
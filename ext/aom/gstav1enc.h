@@ -103,6 +103,21 @@ typedef enum
   GST_AV1_ENC_END_USAGE_MODES
 } GstAV1EncEndUsageMode;
 
+/**
+ * GstAV1EncUsageProfile:
+ * @GST_AV1_ENC_USAGE_GOOD_QUALITY: Good quality, for offline encoding
+ * @GST_AV1_ENC_USAGE_REALTIME: Realtime, for live encoding
+ *
+ * Encoder usage profile
+ *
+ * Since: 1.20
+ */
+typedef enum
+{
+  GST_AV1_ENC_USAGE_GOOD_QUALITY = 0,
+  GST_AV1_ENC_USAGE_REALTIME = 1,
+} GstAV1EncUsageProfile;
+
 struct _GstAV1Enc
 {
   GstVideoEncoder base_video_encoder;
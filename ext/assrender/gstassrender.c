@@ -101,6 +101,19 @@ static GstStaticPadTemplate text_sink_factory =
 #define GST_ASS_RENDER_SIGNAL(ass)   (g_cond_signal (GST_ASS_RENDER_GET_COND (ass)))
 #define GST_ASS_RENDER_BROADCAST(ass)(g_cond_broadcast (GST_ASS_RENDER_GET_COND (ass)))
 
+/* images closer than this, in pixels, share an overlay rectangle */
+#define REGION_MERGE_DISTANCE 16
+
+/* an area of the composition with the images inside it */
+typedef struct
+{
+  gint x0, y0, x1, y1;
+  /* index of the region this one was merged into, itself if none */
+  guint parent;
+  guint64 hash;
+  GstVideoOverlayRectangle *rectangle;
+} GstAssRenderRegion;
+
 static void gst_ass_render_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void gst_ass_render_get_property (GObject * object, guint prop_id,
@@ -264,6 +277,8 @@ gst_ass_render_init (GstAssRender * render)
 
   render->ass_track = NULL;
 
+  render->regions = g_array_new (FALSE, FALSE, sizeof (GstAssRenderRegion));
+
   GST_DEBUG_OBJECT (render, "init complete");
 }
 
@@ -289,9 +304,27 @@ gst_ass_render_finalize (GObject * object)
 
   g_mutex_clear (&render->ass_mutex);
 
+  gst_ass_render_reset_composition (render);
+  g_array_free (render->regions, TRUE);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gst_ass_render_clear_regions (GArray * regions)
+{
+  guint i;
+
+  for (i = 0; i < regions->len; i++) {
+    GstAssRenderRegion *region = &g_array_index (regions, GstAssRenderRegion,
+        i);
+
+    if (region->rectangle)
+      gst_video_overlay_rectangle_unref (region->rectangle);
+  }
+  g_array_set_size (regions, 0);
+}
+
 static void
 gst_ass_render_reset_composition (GstAssRender * render)
 {
@@ -299,6 +332,7 @@ gst_ass_render_reset_composition (GstAssRender * render)
     gst_video_overlay_composition_unref (render->composition);
     render->composition = NULL;
   }
+  gst_ass_render_clear_regions (render->regions);
 }
 
 static void
@@ -669,10 +703,12 @@ gst_ass_render_get_src_caps (GstPad * pad, GstAssRender * render,
 }
 
 static void
-blit_bgra_premultiplied (GstAssRender * render, ASS_Image * ass_image,
-    guint8 * data, gint width, gint height, gint stride, gint x_off, gint y_off)
+blit_bgra_premultiplied (GstAssRender * render, ASS_Image ** images,
+    guint n_images, guint8 * data, gint width, gint height, gint stride,
+    gint x_off, gint y_off)
 {
-  guint counter = 0;
+  ASS_Image *ass_image;
+  guint counter;
   gint alpha, r, g, b, k;
   const guint8 *src;
   guint8 *dst;
@@ -683,18 +719,19 @@ blit_bgra_premultiplied (GstAssRender * render, ASS_Image * ass_image,
 
   memset (data, 0, stride * height);
 
-  while (ass_image) {
+  for (counter = 0; counter < n_images; counter++) {
+    ass_image = images[counter];
     dst_x = ass_image->dst_x + x_off;
     dst_y = ass_image->dst_y + y_off;
 
     w = MIN (ass_image->w, width - dst_x);
     h = MIN (ass_image->h, height - dst_y);
     if (w <= 0 || h <= 0)
-      goto next;
+      continue;
 
     alpha = 255 - (ass_image->color & 0xff);
     if (!alpha)
-      goto next;
+      continue;
 
     r = ((ass_image->color) >> 24) & 0xff;
     g = ((ass_image->color) >> 16) & 0xff;
@@ -728,9 +765,6 @@ blit_bgra_premultiplied (GstAssRender * render, ASS_Image * ass_image,
       src += src_skip;
       dst += dst_skip;
     }
-  next:
-    counter++;
-    ass_image = ass_image->next;
   }
   GST_LOG_OBJECT (render, "amount of rendered ass_image: %u", counter);
 }
@@ -1054,44 +1088,87 @@ gst_ass_render_process_text (GstAssRender * render, GstBuffer * buffer,
   gst_buffer_unmap (buffer, &map);
 }
 
-static GstVideoOverlayComposition *
-gst_ass_render_composite_overlay (GstAssRender * render, ASS_Image * images)
+static gboolean
+gst_ass_render_regions_near (const GstAssRenderRegion * a,
+    const GstAssRenderRegion * b)
+{
+  return a->x0 <= b->x1 + REGION_MERGE_DISTANCE &&
+      b->x0 <= a->x1 + REGION_MERGE_DISTANCE &&
+      a->y0 <= b->y1 + REGION_MERGE_DISTANCE &&
+      b->y0 <= a->y1 + REGION_MERGE_DISTANCE;
+}
+
+/* grows @a to cover @b, and makes @b part of it */
+static void
+gst_ass_render_regions_merge (GArray * regions, guint a, guint b)
+{
+  GstAssRenderRegion *ra = &g_array_index (regions, GstAssRenderRegion, a);
+  GstAssRenderRegion *rb = &g_array_index (regions, GstAssRenderRegion, b);
+
+  ra->x0 = MIN (ra->x0, rb->x0);
+  ra->y0 = MIN (ra->y0, rb->y0);
+  ra->x1 = MAX (ra->x1, rb->x1);
+  ra->y1 = MAX (ra->y1, rb->y1);
+  rb->parent = a;
+}
+
+static guint
+gst_ass_render_region_root (GArray * regions, guint i)
+{
+  while (g_array_index (regions, GstAssRenderRegion, i).parent != i)
+    i = g_array_index (regions, GstAssRenderRegion, i).parent;
+
+  return i;
+}
+
+/* FNV-1a over everything that ends up in the rectangle of a region */
+static guint64
+gst_ass_render_hash_images (ASS_Image ** images, guint n_images)
+{
+  guint64 hash = G_GUINT64_CONSTANT (0xcbf29ce484222325);
+  const guint64 prime = G_GUINT64_CONSTANT (0x100000001b3);
+  guint i;
+  gint x, y;
+
+  for (i = 0; i < n_images; i++) {
+    ASS_Image *image = images[i];
+    const guint8 *src = image->bitmap;
+    gint32 params[5] = { image->dst_x, image->dst_y, image->w, image->h,
+      (gint32) image->color
+    };
+    const guint8 *p = (const guint8 *) params;
+
+    for (x = 0; x < (gint) sizeof (params); x++)
+      hash = (hash ^ p[x]) * prime;
+
+    for (y = 0; y < image->h; y++) {
+      for (x = 0; x < image->w; x++)
+        hash = (hash ^ src[x]) * prime;
+      src += image->stride;
+    }
+  }
+
+  return hash;
+}
+
+static GstVideoOverlayRectangle *
+gst_ass_render_region_rectangle (GstAssRender * render,
+    const GstAssRenderRegion * region, ASS_Image ** images, guint n_images)
 {
-  GstVideoOverlayComposition *composition;
   GstVideoOverlayRectangle *rectangle;
   GstVideoMeta *vmeta;
   GstMapInfo map;
   GstBuffer *buffer;
-  ASS_Image *image;
-  gint min_x, min_y;
-  gint max_x, max_y;
   gint width, height;
   gint stride;
   gdouble hscale, vscale;
   gpointer data;
 
-  min_x = G_MAXINT;
-  min_y = G_MAXINT;
-  max_x = 0;
-  max_y = 0;
-
-  /* find bounding box of all images, to limit the overlay rectangle size */
-  for (image = images; image; image = image->next) {
-    if (min_x > image->dst_x)
-      min_x = image->dst_x;
-    if (min_y > image->dst_y)
-      min_y = image->dst_y;
-    if (max_x < image->dst_x + image->w)
-      max_x = image->dst_x + image->w;
-    if (max_y < image->dst_y + image->h)
-      max_y = image->dst_y + image->h;
-  }
-
-  width = MIN (max_x - min_x, render->ass_frame_width);
-  height = MIN (max_y - min_y, render->ass_frame_height);
+  width = MIN (region->x1 - region->x0, render->ass_frame_width);
+  height = MIN (region->y1 - region->y0, render->ass_frame_height);
 
   GST_DEBUG_OBJECT (render, "render overlay rectangle %dx%d%+d%+d",
-      width, height, min_x, min_y);
+      width, height, region->x0, region->y0);
 
   buffer = gst_buffer_new_and_alloc (4 * width * height);
   if (!buffer) {
@@ -1108,21 +1185,169 @@ gst_ass_render_composite_overlay (GstAssRender * render, ASS_Image * images)
     return NULL;
   }
 
-  blit_bgra_premultiplied (render, images, data, width, height, stride,
-      -min_x, -min_y);
+  blit_bgra_premultiplied (render, images, n_images, (guint8 *) data, width,
+      height, stride, -region->x0, -region->y0);
   gst_video_meta_unmap (vmeta, 0, &map);
 
   hscale = (gdouble) render->info.width / (gdouble) render->ass_frame_width;
   vscale = (gdouble) render->info.height / (gdouble) render->ass_frame_height;
 
   rectangle = gst_video_overlay_rectangle_new_raw (buffer,
-      hscale * min_x, vscale * min_y, hscale * width, vscale * height,
-      GST_VIDEO_OVERLAY_FORMAT_FLAG_PREMULTIPLIED_ALPHA);
+      hscale * region->x0, vscale * region->y0, hscale * width,
+      vscale * height, GST_VIDEO_OVERLAY_FORMAT_FLAG_PREMULTIPLIED_ALPHA);
 
   gst_buffer_unref (buffer);
 
-  composition = gst_video_overlay_composition_new (rectangle);
-  gst_video_overlay_rectangle_unref (rectangle);
+  return rectangle;
+}
+
+/* Splits the images in groups of nearby ones, each group becoming one
+ * rectangle: subtitles far apart on screen don't make a rectangle covering
+ * everything in between, which would need to be cleared and blended for
+ * nothing. Rectangles of groups identical to the ones of the previous
+ * composition are reused, and so is the whole composition if nothing
+ * changed. */
+static GstVideoOverlayComposition *
+gst_ass_render_composite_overlay (GstAssRender * render, ASS_Image * images)
+{
+  GstVideoOverlayComposition *composition = NULL;
+  GArray *regions, *boxes;
+  ASS_Image **sorted, **group;
+  ASS_Image *image;
+  guint *owner;
+  guint n_images = 0, i, j, k, n_group;
+  gboolean merged, unchanged;
+
+  for (image = images; image; image = image->next)
+    n_images++;
+
+  sorted = g_new (ASS_Image *, n_images);
+  group = g_new (ASS_Image *, n_images);
+  owner = g_new (guint, n_images);
+  boxes = g_array_new (FALSE, FALSE, sizeof (GstAssRenderRegion));
+
+  /* gather the images in regions of nearby ones */
+  for (image = images, i = 0; image; image = image->next, i++) {
+    GstAssRenderRegion box = { image->dst_x, image->dst_y,
+      image->dst_x + image->w, image->dst_y + image->h, boxes->len, 0, NULL
+    };
+    guint target = G_MAXUINT;
+
+    sorted[i] = image;
+    for (j = 0; j < boxes->len; j++) {
+      GstAssRenderRegion *region = &g_array_index (boxes, GstAssRenderRegion,
+          j);
+
+      if (region->parent != j || !gst_ass_render_regions_near (region, &box))
+        continue;
+
+      if (target == G_MAXUINT) {
+        target = j;
+        region->x0 = MIN (region->x0, box.x0);
+        region->y0 = MIN (region->y0, box.y0);
+        region->x1 = MAX (region->x1, box.x1);
+        region->y1 = MAX (region->y1, box.y1);
+        box = *region;
+      } else {
+        gst_ass_render_regions_merge (boxes, target, j);
+        box = g_array_index (boxes, GstAssRenderRegion, target);
+      }
+    }
+
+    if (target == G_MAXUINT) {
+      target = boxes->len;
+      g_array_append_val (boxes, box);
+    }
+    owner[i] = target;
+  }
+
+  /* regions that grew may now be near regions they weren't before */
+  do {
+    merged = FALSE;
+    for (j = 0; j < boxes->len; j++) {
+      if (g_array_index (boxes, GstAssRenderRegion, j).parent != j)
+        continue;
+      for (k = j + 1; k < boxes->len; k++) {
+        if (g_array_index (boxes, GstAssRenderRegion, k).parent != k)
+          continue;
+        if (gst_ass_render_regions_near (&g_array_index (boxes,
+                    GstAssRenderRegion, j), &g_array_index (boxes,
+                    GstAssRenderRegion, k))) {
+          gst_ass_render_regions_merge (boxes, j, k);
+          merged = TRUE;
+        }
+      }
+    }
+  } while (merged);
+
+  for (i = 0; i < n_images; i++)
+    owner[i] = gst_ass_render_region_root (boxes, owner[i]);
+
+  /* build or reuse one rectangle per region */
+  regions = g_array_new (FALSE, FALSE, sizeof (GstAssRenderRegion));
+  unchanged = TRUE;
+  for (j = 0; j < boxes->len; j++) {
+    GstAssRenderRegion region = g_array_index (boxes, GstAssRenderRegion, j);
+
+    if (region.parent != j)
+      continue;
+
+    n_group = 0;
+    for (i = 0; i < n_images; i++) {
+      if (owner[i] == j)
+        group[n_group++] = sorted[i];
+    }
+
+    region.hash = gst_ass_render_hash_images (group, n_group);
+    region.rectangle = NULL;
+
+    for (k = 0; k < render->regions->len; k++) {
+      GstAssRenderRegion *prev = &g_array_index (render->regions,
+          GstAssRenderRegion, k);
+
+      if (prev->rectangle && prev->hash == region.hash &&
+          prev->x0 == region.x0 && prev->y0 == region.y0 &&
+          prev->x1 == region.x1 && prev->y1 == region.y1) {
+        region.rectangle = prev->rectangle;
+        prev->rectangle = NULL;
+        if (k != regions->len)
+          unchanged = FALSE;
+        break;
+      }
+    }
+
+    if (!region.rectangle) {
+      unchanged = FALSE;
+      region.rectangle = gst_ass_render_region_rectangle (render, &region,
+          group, n_group);
+      if (!region.rectangle)
+        continue;
+    }
+
+    g_array_append_val (regions, region);
+  }
+
+  if (unchanged && regions->len == render->regions->len &&
+      render->composition) {
+    GST_DEBUG_OBJECT (render, "reusing unchanged overlay composition");
+    composition = gst_video_overlay_composition_ref (render->composition);
+  } else if (regions->len > 0) {
+    GST_DEBUG_OBJECT (render, "composition of %u rectangles", regions->len);
+    composition = gst_video_overlay_composition_new (g_array_index (regions,
+            GstAssRenderRegion, 0).rectangle);
+    for (j = 1; j < regions->len; j++)
+      gst_video_overlay_composition_add_rectangle (composition,
+          g_array_index (regions, GstAssRenderRegion, j).rectangle);
+  }
+
+  gst_ass_render_clear_regions (render->regions);
+  g_array_free (render->regions, TRUE);
+  render->regions = regions;
+
+  g_array_free (boxes, TRUE);
+  g_free (owner);
+  g_free (group);
+  g_free (sorted);
 
   return composition;
 }
@@ -1331,15 +1556,23 @@ wait_for_text_buf:
           timestamp, &changed);
       g_mutex_unlock (&render->ass_mutex);
 
-      if ((!ass_image || changed) && render->composition) {
-        GST_DEBUG_OBJECT (render, "release overlay (changed %d)", changed);
+      if (!ass_image && render->composition) {
+        GST_DEBUG_OBJECT (render, "release overlay");
         gst_ass_render_reset_composition (render);
       }
 
       if (ass_image != NULL) {
-        if (!render->composition)
-          render->composition = gst_ass_render_composite_overlay (render,
-              ass_image);
+        /* the previous composition is still valid if libass tells nothing
+         * changed, otherwise update the parts that did */
+        if (!render->composition || changed) {
+          GstVideoOverlayComposition *composition;
+
+          GST_DEBUG_OBJECT (render, "update overlay (changed %d)", changed);
+          composition = gst_ass_render_composite_overlay (render, ass_image);
+          if (render->composition)
+            gst_video_overlay_composition_unref (render->composition);
+          render->composition = composition;
+        }
       } else {
         GST_DEBUG_OBJECT (render, "nothing to render right now");
       }
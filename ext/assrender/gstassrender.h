@@ -83,6 +83,8 @@ struct _GstAssRender
 
   /* overlay stuff */
   GstVideoOverlayComposition *composition;
+  /* GstAssRenderRegion, one per rectangle of the composition */
+  GArray *regions;
   guint window_width, window_height;
   gboolean attach_compo_to_buffer;
 };
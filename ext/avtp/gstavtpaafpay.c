@@ -45,11 +45,13 @@ GST_DEBUG_CATEGORY_STATIC (avtpaafpay_debug);
 #define GST_CAT_DEFAULT (avtpaafpay_debug)
 
 #define DEFAULT_TIMESTAMP_MODE GST_AVTP_AAF_TIMESTAMP_MODE_NORMAL
+#define DEFAULT_FRAMES_PER_PDU 0
 
 enum
 {
   PROP_0,
   PROP_TIMESTAMP_MODE,
+  PROP_FRAMES_PER_PDU,
 };
 
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
@@ -119,6 +121,22 @@ gst_avtp_aaf_pay_class_init (GstAvtpAafPayClass * klass)
           DEFAULT_TIMESTAMP_MODE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
           GST_PARAM_MUTABLE_PAUSED));
 
+  /**
+   * GstAvtpAafPay:frames-per-pdu:
+   *
+   * Maximum number of audio frames carried by each AVTPDU. Input buffers
+   * holding more frames are split into several AVTPDUs, pushed downstream
+   * as a single buffer list. 0 means one AVTPDU per input buffer.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (object_class, PROP_FRAMES_PER_PDU,
+      g_param_spec_uint ("frames-per-pdu", "Frames per PDU",
+          "Maximum number of audio frames per AVTPDU (0 = one AVTPDU per "
+          "input buffer)", 0, G_MAXUINT, DEFAULT_FRAMES_PER_PDU,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PAUSED));
+
   element_class->change_state =
       GST_DEBUG_FUNCPTR (gst_avtp_aaf_pay_change_state);
 
@@ -144,12 +162,15 @@ static void
 gst_avtp_aaf_pay_init (GstAvtpAafPay * avtpaafpay)
 {
   avtpaafpay->timestamp_mode = DEFAULT_TIMESTAMP_MODE;
+  avtpaafpay->frames_per_pdu = DEFAULT_FRAMES_PER_PDU;
 
   avtpaafpay->header = NULL;
   avtpaafpay->channels = 0;
   avtpaafpay->depth = 0;
   avtpaafpay->rate = 0;
   avtpaafpay->format = 0;
+  avtpaafpay->sample_rate = 0;
+  avtpaafpay->bpf = 0;
 }
 
 static void
@@ -164,6 +185,9 @@ gst_avtp_aaf_pay_set_property (GObject * object, guint prop_id,
     case PROP_TIMESTAMP_MODE:
       avtpaafpay->timestamp_mode = g_value_get_enum (value);
       break;
+    case PROP_FRAMES_PER_PDU:
+      avtpaafpay->frames_per_pdu = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -182,6 +206,9 @@ gst_avtp_aaf_pay_get_property (GObject * object, guint prop_id,
     case PROP_TIMESTAMP_MODE:
       g_value_set_enum (value, avtpaafpay->timestamp_mode);
       break;
+    case PROP_FRAMES_PER_PDU:
+      g_value_set_uint (value, avtpaafpay->frames_per_pdu);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -258,8 +285,10 @@ gst_avtp_aaf_pay_change_state (GstElement * element, GstStateChange transition)
   return ret;
 }
 
-static GstFlowReturn
-gst_avtp_aaf_pay_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+/* Turns @buffer into an AVTPDU by prepending the AAF header to it */
+static gboolean
+gst_avtp_aaf_pay_prepend_header (GstAvtpAafPay * avtpaafpay,
+    GstBuffer * buffer)
 {
   int res;
   GstMemory *mem;
@@ -267,8 +296,7 @@ gst_avtp_aaf_pay_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   gsize data_len;
   GstClockTime ptime;
   struct avtp_stream_pdu *pdu;
-  GstAvtpAafPay *avtpaafpay = GST_AVTP_AAF_PAY (parent);
-  GstAvtpBasePayload *avtpbasepayload = GST_AVTP_BASE_PAYLOAD (parent);
+  GstAvtpBasePayload *avtpbasepayload = GST_AVTP_BASE_PAYLOAD (avtpaafpay);
 
   ptime = gst_avtp_base_payload_calc_ptime (avtpbasepayload, buffer);
   data_len = gst_buffer_get_size (buffer);
@@ -277,8 +305,8 @@ gst_avtp_aaf_pay_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   if (!gst_memory_map (mem, &info, GST_MAP_WRITE)) {
     GST_ELEMENT_ERROR (avtpaafpay, RESOURCE, WRITE, ("Failed to map memory"),
         (NULL));
-    gst_buffer_unref (buffer);
-    return GST_FLOW_ERROR;
+    gst_memory_unref (mem);
+    return FALSE;
   }
   pdu = (struct avtp_stream_pdu *) info.data;
   res = avtp_aaf_pdu_set (pdu, AVTP_AAF_FIELD_TIMESTAMP, ptime);
@@ -300,7 +328,58 @@ gst_avtp_aaf_pay_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   gst_memory_unmap (mem, &info);
 
   gst_buffer_prepend_memory (buffer, mem);
-  return gst_pad_push (avtpbasepayload->srcpad, buffer);
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_avtp_aaf_pay_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstAvtpAafPay *avtpaafpay = GST_AVTP_AAF_PAY (parent);
+  GstAvtpBasePayload *avtpbasepayload = GST_AVTP_BASE_PAYLOAD (parent);
+  GstBufferList *list;
+  gsize n_frames, offset;
+  guint frames_per_pdu = avtpaafpay->frames_per_pdu;
+
+  n_frames = avtpaafpay->bpf ? gst_buffer_get_size (buffer) /
+      avtpaafpay->bpf : 0;
+
+  if (frames_per_pdu == 0 || n_frames <= frames_per_pdu) {
+    if (!gst_avtp_aaf_pay_prepend_header (avtpaafpay, buffer)) {
+      gst_buffer_unref (buffer);
+      return GST_FLOW_ERROR;
+    }
+    return gst_pad_push (avtpbasepayload->srcpad, buffer);
+  }
+
+  /* Split the buffer so each AVTPDU carries at most frames_per_pdu frames,
+   * and push them all at once so the sink can send them in one go */
+  list = gst_buffer_list_new_sized ((n_frames + frames_per_pdu - 1) /
+      frames_per_pdu);
+
+  for (offset = 0; offset < n_frames; offset += frames_per_pdu) {
+    gsize frames = MIN (frames_per_pdu, n_frames - offset);
+    GstBuffer *pdu;
+
+    pdu = gst_buffer_copy_region (buffer, GST_BUFFER_COPY_FLAGS |
+        GST_BUFFER_COPY_MEMORY, offset * avtpaafpay->bpf,
+        frames * avtpaafpay->bpf);
+    GST_BUFFER_PTS (pdu) = GST_BUFFER_PTS (buffer) +
+        gst_util_uint64_scale_int (offset, GST_SECOND,
+        avtpaafpay->sample_rate);
+    GST_BUFFER_DURATION (pdu) = gst_util_uint64_scale_int (frames,
+        GST_SECOND, avtpaafpay->sample_rate);
+
+    if (!gst_avtp_aaf_pay_prepend_header (avtpaafpay, pdu)) {
+      gst_buffer_unref (pdu);
+      gst_buffer_list_unref (list);
+      gst_buffer_unref (buffer);
+      return GST_FLOW_ERROR;
+    }
+    gst_buffer_list_add (list, pdu);
+  }
+
+  gst_buffer_unref (buffer);
+  return gst_pad_push_list (avtpbasepayload->srcpad, list);
 }
 
 static int
@@ -364,6 +443,8 @@ gst_avtp_aaf_pay_new_caps (GstAvtpAafPay * avtpaafpay, GstCaps * caps)
   avtpaafpay->depth = info.finfo->depth;
   avtpaafpay->rate = gst_to_avtp_rate (info.rate);
   avtpaafpay->format = gst_to_avtp_format (info.finfo->format);
+  avtpaafpay->sample_rate = info.rate;
+  avtpaafpay->bpf = info.bpf;
 
   GST_DEBUG_OBJECT (avtpaafpay, "channels %d, depth %d, rate %d, format %s",
       info.channels, info.finfo->depth, info.rate,
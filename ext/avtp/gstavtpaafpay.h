@@ -52,12 +52,15 @@ struct _GstAvtpAafPay
   GstAvtpBasePayload payload;
 
   GstAvtpAafTimestampMode timestamp_mode;
+  guint frames_per_pdu;
 
   GstMemory *header;
   gint channels;
   gint depth;
   gint rate;
   gint format;
+  gint sample_rate;
+  gint bpf;
 };
 
 struct _GstAvtpAafPayClass
@@ -639,19 +639,19 @@ gst_avtp_cvf_pay_push_packets (GstAvtpCvfPay * avtpcvfpay,
     GPtrArray * avtp_packets)
 {
   int i;
-  GstFlowReturn ret;
+  GstBufferList *list;
   GstAvtpBasePayload *avtpbasepayload = GST_AVTP_BASE_PAYLOAD (avtpcvfpay);
 
-  for (i = 0; i < avtp_packets->len; i++) {
-    GstBuffer *packet;
+  if (avtp_packets->len == 0)
+    return GST_FLOW_OK;
 
-    packet = g_ptr_array_index (avtp_packets, i);
-    ret = gst_pad_push (avtpbasepayload->srcpad, packet);
-    if (ret != GST_FLOW_OK)
-      return ret;
-  }
+  /* Push all the fragments of the buffer at once, so the sink can send
+   * them in one go */
+  list = gst_buffer_list_new_sized (avtp_packets->len);
+  for (i = 0; i < avtp_packets->len; i++)
+    gst_buffer_list_add (list, g_ptr_array_index (avtp_packets, i));
 
-  return GST_FLOW_OK;
+  return gst_pad_push_list (avtpbasepayload->srcpad, list);
 }
 
 static GstFlowReturn
@@ -41,8 +41,14 @@
  * ]| This example pipeline implements an AVTP talker that transmit an AAF
  * stream.
  * </refsect2>
+ *
+ * Buffer lists, as pushed by the payloaders when an input buffer results in
+ * several AVTPDUs, are sent with a single sendmmsg() call, each AVTPDU
+ * carrying its own launch time.
  */
 
+#define _GNU_SOURCE
+
 #include <arpa/inet.h>
 #include <linux/errqueue.h>
 #include <linux/if_packet.h>
@@ -68,6 +74,9 @@ GST_DEBUG_CATEGORY_STATIC (avtpsink_debug);
 #define TAI_OFFSET    (37ULL * NSEC_PER_SEC)
 #define UTC_TO_TAI(t) (t + TAI_OFFSET)
 
+/* Maximum number of AVTPDUs sent per sendmmsg() call */
+#define MAX_BATCH_SIZE 64
+
 enum
 {
   PROP_0,
@@ -95,6 +104,8 @@ static gboolean gst_avtp_sink_start (GstBaseSink * basesink);
 static gboolean gst_avtp_sink_stop (GstBaseSink * basesink);
 static GstFlowReturn gst_avtp_sink_render (GstBaseSink * basesink, GstBuffer *
     buffer);
+static GstFlowReturn gst_avtp_sink_render_list (GstBaseSink * basesink,
+    GstBufferList * list);
 static void gst_avtp_sink_get_times (GstBaseSink * bsink, GstBuffer * buffer,
     GstClockTime * start, GstClockTime * end);
 
@@ -135,6 +146,7 @@ gst_avtp_sink_class_init (GstAvtpSinkClass * klass)
   basesink_class->start = GST_DEBUG_FUNCPTR (gst_avtp_sink_start);
   basesink_class->stop = GST_DEBUG_FUNCPTR (gst_avtp_sink_stop);
   basesink_class->render = GST_DEBUG_FUNCPTR (gst_avtp_sink_render);
+  basesink_class->render_list = GST_DEBUG_FUNCPTR (gst_avtp_sink_render_list);
   basesink_class->get_times = GST_DEBUG_FUNCPTR (gst_avtp_sink_get_times);
 
   GST_DEBUG_CATEGORY_INIT (avtpsink_debug, "avtpsink", 0, "AVTP Sink");
@@ -301,6 +313,37 @@ gst_avtp_sink_init_msghdr (GstAvtpSink * avtpsink)
   avtpsink->msg = msg;
 }
 
+static void
+gst_avtp_sink_init_mmsghdr (GstAvtpSink * avtpsink)
+{
+  gint i;
+  struct iovec *iov;
+  guint8 *control;
+  gsize controllen = CMSG_SPACE (sizeof (__u64));
+
+  avtpsink->mmsg = g_new0 (struct mmsghdr, MAX_BATCH_SIZE);
+  avtpsink->mmsg_maps = g_new0 (GstMapInfo, MAX_BATCH_SIZE);
+  iov = g_new0 (struct iovec, MAX_BATCH_SIZE);
+  control = g_malloc0 (controllen * MAX_BATCH_SIZE);
+
+  for (i = 0; i < MAX_BATCH_SIZE; i++) {
+    struct msghdr *msg = &avtpsink->mmsg[i].msg_hdr;
+    struct cmsghdr *cmsg;
+
+    msg->msg_name = &avtpsink->sk_addr;
+    msg->msg_namelen = sizeof (avtpsink->sk_addr);
+    msg->msg_iovlen = 1;
+    msg->msg_iov = &iov[i];
+    msg->msg_controllen = controllen;
+    msg->msg_control = control + i * controllen;
+
+    cmsg = CMSG_FIRSTHDR (msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_TXTIME;
+    cmsg->cmsg_len = CMSG_LEN (sizeof (__u64));
+  }
+}
+
 static gboolean
 gst_avtp_sink_start (GstBaseSink * basesink)
 {
@@ -310,6 +353,7 @@ gst_avtp_sink_start (GstBaseSink * basesink)
     return FALSE;
 
   gst_avtp_sink_init_msghdr (avtpsink);
+  gst_avtp_sink_init_mmsghdr (avtpsink);
 
   GST_DEBUG_OBJECT (avtpsink, "AVTP sink started");
 
@@ -324,6 +368,12 @@ gst_avtp_sink_stop (GstBaseSink * basesink)
   g_free (avtpsink->msg->msg_iov);
   g_free (avtpsink->msg->msg_control);
   g_free (avtpsink->msg);
+  /* iovecs and control buffers are allocated in one go in
+   * gst_avtp_sink_init_mmsghdr() */
+  g_free (avtpsink->mmsg[0].msg_hdr.msg_iov);
+  g_free (avtpsink->mmsg[0].msg_hdr.msg_control);
+  g_free (avtpsink->mmsg);
+  g_free (avtpsink->mmsg_maps);
   close (avtpsink->sk_fd);
 
   GST_DEBUG_OBJECT (avtpsink, "AVTP sink stopped");
@@ -411,6 +461,30 @@ gst_avtp_sink_process_error_queue (GstAvtpSink * avtpsink, int fd)
   }
 }
 
+/* Sets the launch time of @buffer into the SCM_TXTIME control message of
+ * @msg */
+static void
+gst_avtp_sink_set_txtime (GstAvtpSink * avtpsink, struct msghdr *msg,
+    GstBuffer * buffer)
+{
+  GstBaseSink *basesink = GST_BASE_SINK (avtpsink);
+  GstClockTime base_time, running_time;
+  struct cmsghdr *cmsg = CMSG_FIRSTHDR (msg);
+  gint ret;
+
+  g_assert (GST_BUFFER_DTS_OR_PTS (buffer) != GST_CLOCK_TIME_NONE);
+
+  ret = gst_segment_to_running_time_full (&basesink->segment,
+      basesink->segment.format, GST_BUFFER_DTS_OR_PTS (buffer),
+      &running_time);
+  if (ret == -1)
+    running_time = -running_time;
+
+  base_time = gst_element_get_base_time (GST_ELEMENT (avtpsink));
+  running_time = gst_avtp_sink_adjust_time (basesink, running_time);
+  *(__u64 *) CMSG_DATA (cmsg) = UTC_TO_TAI (base_time + running_time);
+}
+
 static GstFlowReturn
 gst_avtp_sink_render (GstBaseSink * basesink, GstBuffer * buffer)
 {
@@ -419,23 +493,8 @@ gst_avtp_sink_render (GstBaseSink * basesink, GstBuffer * buffer)
   GstAvtpSink *avtpsink = GST_AVTP_SINK (basesink);
   struct iovec *iov = avtpsink->msg->msg_iov;
 
-  if (G_LIKELY (basesink->sync)) {
-    GstClockTime base_time, running_time;
-    struct cmsghdr *cmsg = CMSG_FIRSTHDR (avtpsink->msg);
-    gint ret;
-
-    g_assert (GST_BUFFER_DTS_OR_PTS (buffer) != GST_CLOCK_TIME_NONE);
-
-    ret = gst_segment_to_running_time_full (&basesink->segment,
-        basesink->segment.format, GST_BUFFER_DTS_OR_PTS (buffer),
-        &running_time);
-    if (ret == -1)
-      running_time = -running_time;
-
-    base_time = gst_element_get_base_time (GST_ELEMENT (avtpsink));
-    running_time = gst_avtp_sink_adjust_time (basesink, running_time);
-    *(__u64 *) CMSG_DATA (cmsg) = UTC_TO_TAI (base_time + running_time);
-  }
+  if (G_LIKELY (basesink->sync))
+    gst_avtp_sink_set_txtime (avtpsink, avtpsink->msg, buffer);
 
   if (!gst_buffer_map (buffer, &info, GST_MAP_READ)) {
     GST_ERROR_OBJECT (avtpsink, "Failed to map buffer");
@@ -464,6 +523,78 @@ out:
   return GST_FLOW_OK;
 }
 
+static GstFlowReturn
+gst_avtp_sink_send_batch (GstAvtpSink * avtpsink, GstBufferList * list,
+    guint first, guint len)
+{
+  GstBaseSink *basesink = GST_BASE_SINK (avtpsink);
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint i, mapped, sent = 0;
+
+  for (mapped = 0; mapped < len; mapped++) {
+    GstBuffer *buffer = gst_buffer_list_get (list, first + mapped);
+    struct msghdr *msg = &avtpsink->mmsg[mapped].msg_hdr;
+    GstMapInfo *info = &avtpsink->mmsg_maps[mapped];
+
+    if (G_LIKELY (basesink->sync))
+      gst_avtp_sink_set_txtime (avtpsink, msg, buffer);
+
+    if (!gst_buffer_map (buffer, info, GST_MAP_READ)) {
+      GST_ERROR_OBJECT (avtpsink, "Failed to map buffer");
+      ret = GST_FLOW_ERROR;
+      goto out;
+    }
+
+    msg->msg_iov->iov_base = info->data;
+    msg->msg_iov->iov_len = info->size;
+  }
+
+  while (sent < len) {
+    int n;
+
+    n = sendmmsg (avtpsink->sk_fd, &avtpsink->mmsg[sent], len - sent, 0);
+    if (n < 0) {
+      GST_INFO_OBJECT (avtpsink, "Failed to send AVTPDU: %s",
+          g_strerror (errno));
+
+      if (G_LIKELY (basesink->sync))
+        gst_avtp_sink_process_error_queue (avtpsink, avtpsink->sk_fd);
+
+      /* Drop the AVTPDU that failed and carry on with the next ones, as
+       * when sending them one by one */
+      sent++;
+      continue;
+    }
+
+    for (i = sent; i < sent + n; i++) {
+      if (avtpsink->mmsg[i].msg_len != avtpsink->mmsg_maps[i].size)
+        GST_INFO_OBJECT (avtpsink, "Incomplete AVTPDU transmission");
+    }
+    sent += n;
+  }
+
+out:
+  for (i = 0; i < mapped; i++)
+    gst_buffer_unmap (gst_buffer_list_get (list, first + i),
+        &avtpsink->mmsg_maps[i]);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_avtp_sink_render_list (GstBaseSink * basesink, GstBufferList * list)
+{
+  GstAvtpSink *avtpsink = GST_AVTP_SINK (basesink);
+  guint i, len = gst_buffer_list_length (list);
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  for (i = 0; i < len && ret == GST_FLOW_OK; i += MAX_BATCH_SIZE)
+    ret = gst_avtp_sink_send_batch (avtpsink, list, i,
+        MIN (len - i, MAX_BATCH_SIZE));
+
+  return ret;
+}
+
 static void
 gst_avtp_sink_get_times (GstBaseSink * bsink, GstBuffer * buffer,
     GstClockTime * start, GstClockTime * end)
@@ -52,6 +52,10 @@ struct _GstAvtpSink
   int sk_fd;
   struct sockaddr_ll sk_addr;
   struct msghdr * msg;
+
+  /* preallocated headers to send buffer lists with sendmmsg() */
+  struct mmsghdr * mmsg;
+  GstMapInfo * mmsg_maps;
 };
 
 struct _GstAvtpSinkClass
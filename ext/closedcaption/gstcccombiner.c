@@ -54,6 +54,14 @@ static GstStaticPadTemplate captiontemplate =
 G_DEFINE_TYPE (GstCCCombiner, gst_cc_combiner, GST_TYPE_AGGREGATOR);
 #define parent_class gst_cc_combiner_parent_class
 
+enum
+{
+  PROP_0,
+  PROP_SPARSE_CAPTIONS,
+};
+
+#define DEFAULT_SPARSE_CAPTIONS FALSE
+
 typedef struct
 {
   GstVideoCaptionType caption_type;
@@ -86,9 +94,14 @@ gst_cc_combiner_collect_captions (GstCCCombiner * self, gboolean timeout)
       GST_AGGREGATOR_PAD (GST_AGGREGATOR_SRC_PAD (self));
   GstAggregatorPad *caption_pad;
   GstBuffer *video_buf;
+  gboolean sparse_captions;
 
   g_assert (self->current_video_buffer != NULL);
 
+  GST_OBJECT_LOCK (self);
+  sparse_captions = self->sparse_captions;
+  GST_OBJECT_UNLOCK (self);
+
   caption_pad =
       GST_AGGREGATOR_PAD_CAST (gst_element_get_static_pad (GST_ELEMENT_CAST
           (self), "caption"));
@@ -115,10 +128,13 @@ gst_cc_combiner_collect_captions (GstCCCombiner * self, gboolean timeout)
       if (gst_aggregator_pad_is_eos (caption_pad)) {
         GST_DEBUG_OBJECT (self, "Caption pad is EOS, we're done");
         break;
-      } else if (!timeout) {
+      } else if (!timeout && !sparse_captions) {
         GST_DEBUG_OBJECT (self, "Need more caption data");
         gst_object_unref (caption_pad);
         return GST_FLOW_NEED_DATA;
+      } else if (!timeout) {
+        GST_LOG_OBJECT (self, "No caption data queued, not waiting for it");
+        break;
       } else {
         GST_DEBUG_OBJECT (self, "No caption data on timeout");
         break;
@@ -385,6 +401,25 @@ gst_cc_combiner_aggregate (GstAggregator * aggregator, gboolean timeout)
   return flow_ret;
 }
 
+/* Captions for a frame can arrive up to a frame duration late, unless the
+ * caption stream was declared sparse and we don't wait for it at all */
+static void
+gst_cc_combiner_update_latency (GstCCCombiner * self)
+{
+  GstClockTime latency = 0;
+  gboolean sparse_captions;
+
+  GST_OBJECT_LOCK (self);
+  sparse_captions = self->sparse_captions;
+  GST_OBJECT_UNLOCK (self);
+
+  if (!sparse_captions && self->video_fps_n != 0 && self->video_fps_d != 0)
+    latency = gst_util_uint64_scale (GST_SECOND, self->video_fps_d,
+        self->video_fps_n);
+
+  gst_aggregator_set_latency (GST_AGGREGATOR_CAST (self), latency, latency);
+}
+
 static gboolean
 gst_cc_combiner_sink_event (GstAggregator * aggregator,
     GstAggregatorPad * agg_pad, GstEvent * event)
@@ -409,15 +444,11 @@ gst_cc_combiner_sink_event (GstAggregator * aggregator,
         gst_structure_get_fraction (s, "framerate", &fps_n, &fps_d);
 
         if (fps_n != self->video_fps_n || fps_d != self->video_fps_d) {
-          GstClockTime latency;
-
-          latency = gst_util_uint64_scale (GST_SECOND, fps_d, fps_n);
-          gst_aggregator_set_latency (aggregator, latency, latency);
+          self->video_fps_n = fps_n;
+          self->video_fps_d = fps_d;
+          gst_cc_combiner_update_latency (self);
         }
 
-        self->video_fps_n = fps_n;
-        self->video_fps_d = fps_d;
-
         gst_aggregator_set_src_caps (aggregator, caps);
       }
 
@@ -655,6 +686,43 @@ gst_cc_combiner_peek_next_sample (GstAggregator * agg,
   return res;
 }
 
+static void
+gst_cc_combiner_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstCCCombiner *self = GST_CCCOMBINER (object);
+
+  switch (prop_id) {
+    case PROP_SPARSE_CAPTIONS:
+      GST_OBJECT_LOCK (self);
+      self->sparse_captions = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (self);
+      gst_cc_combiner_update_latency (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_cc_combiner_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstCCCombiner *self = GST_CCCOMBINER (object);
+
+  switch (prop_id) {
+    case PROP_SPARSE_CAPTIONS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_boolean (value, self->sparse_captions);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 gst_cc_combiner_class_init (GstCCCombinerClass * klass)
 {
@@ -667,6 +735,26 @@ gst_cc_combiner_class_init (GstCCCombinerClass * klass)
   aggregator_class = (GstAggregatorClass *) klass;
 
   gobject_class->finalize = gst_cc_combiner_finalize;
+  gobject_class->set_property = gst_cc_combiner_set_property;
+  gobject_class->get_property = gst_cc_combiner_get_property;
+
+  /**
+   * GstCCCombiner:sparse-captions:
+   *
+   * Set this when the caption stream is known to be sparse. Video frames
+   * are then output as soon as there is no caption data queued for them
+   * instead of waiting for caption data or a live timeout, and no extra
+   * latency is added for the caption stream. Caption data arriving after
+   * its video frame was output is dropped.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_SPARSE_CAPTIONS,
+      g_param_spec_boolean ("sparse-captions", "Sparse captions",
+          "Don't wait for caption data that isn't queued yet",
+          DEFAULT_SPARSE_CAPTIONS, G_PARAM_READWRITE |
+          G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_PLAYING));
+
 
   gst_element_class_set_static_metadata (gstelement_class,
       "Closed Caption Combiner",
@@ -708,8 +796,9 @@ gst_cc_combiner_init (GstCCCombiner * self)
   gst_object_unref (templ);
   gst_element_add_pad (GST_ELEMENT_CAST (self), GST_PAD_CAST (agg_pad));
 
+  /* kept allocated and only cleared between frames */
   self->current_frame_captions =
-      g_array_new (FALSE, FALSE, sizeof (CaptionData));
+      g_array_sized_new (FALSE, FALSE, sizeof (CaptionData), 4);
   g_array_set_clear_func (self->current_frame_captions,
       (GDestroyNotify) caption_data_clear);
 
@@ -717,4 +806,5 @@ gst_cc_combiner_init (GstCCCombiner * self)
       self->previous_video_running_time_end = GST_CLOCK_TIME_NONE;
 
   self->current_caption_type = GST_VIDEO_CAPTION_TYPE_UNKNOWN;
+  self->sparse_captions = DEFAULT_SPARSE_CAPTIONS;
 }
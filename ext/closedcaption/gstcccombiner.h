@@ -52,6 +52,8 @@ struct _GstCCCombiner
 
   GArray *current_frame_captions;
   GstVideoCaptionType current_caption_type;
+
+  gboolean sparse_captions;
 };
 
 struct _GstCCCombinerClass
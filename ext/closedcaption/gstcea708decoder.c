@@ -139,6 +139,7 @@ static void get_cea708dec_bufcat (gpointer data, gpointer whole_buf);
 static gboolean
 gst_cea708dec_render_text (Cea708Dec * decoder, GSList ** text_list,
     gint length, guint window_id);
+static void gst_cea708dec_clear_window_image (cea708Window * window);
 static void gst_cea708dec_window_add_char (Cea708Dec * decoder, gunichar c);
 static void
 gst_cea708dec_process_c2 (Cea708Dec * decoder, guint8 * dtvcc_buffer,
@@ -166,7 +167,7 @@ gst_cea708dec_create (PangoContext * pango_context)
 
   /* Initialize 708 variables */
   for (i = 0; i < MAX_708_WINDOWS; i++) {
-    decoder->cc_windows[i] = g_malloc (sizeof (cea708Window));
+    decoder->cc_windows[i] = g_malloc0 (sizeof (cea708Window));
     gst_cea708dec_init_window (decoder, i);
   }
   decoder->desired_service = 1;
@@ -251,11 +252,27 @@ gst_cea708dec_process_dtvcc_packet (Cea708Dec * decoder, guint8 * dtvcc_buffer,
       gst_cea708dec_process_dtvcc_byte (decoder, dtvcc_buffer, parse_index + i);
     }
 
+    /* only windows whose rendering changed need to be composed again */
     for (window_id = 0; window_id < 8; window_id++) {
+      cea708WindowState state;
+
       window = decoder->cc_windows[window_id];
-      GST_LOG ("window #%02d deleted:%d visible:%d updated:%d", window_id,
-          window->deleted, window->visible, window->updated);
-      if (!window->updated) {
+
+      memset (&state, 0, sizeof (state));
+      state.visible = window->visible;
+      state.deleted = window->deleted;
+      state.image_serial = window->image_serial;
+      state.anchor_point = window->anchor_point;
+      state.screen_vertical = window->screen_vertical;
+      state.screen_horizontal = window->screen_horizontal;
+
+      window->dirty = memcmp (&state, &window->state, sizeof (state)) != 0;
+      window->state = state;
+
+      GST_LOG ("window #%02d deleted:%d visible:%d updated:%d dirty:%d",
+          window_id, window->deleted, window->visible, window->updated,
+          window->dirty);
+      if (!window->updated || !window->dirty) {
         continue;
       }
       need_render = TRUE;
@@ -1022,6 +1039,8 @@ gst_cea708dec_show_pango_window (Cea708Dec * decoder, guint window_id)
 
   if (!display) {
     GST_DEBUG ("No visible text, skipping rendering");
+    /* don't keep showing text that was cleared */
+    gst_cea708dec_clear_window_image (window);
     return;
   }
 
@@ -1313,10 +1332,28 @@ gst_cea708dec_scroll_window_up (Cea708Dec * decoder, guint window_id)
   }
 }
 
+static void
+gst_cea708dec_clear_window_image (cea708Window * window)
+{
+  if (!window->text_image)
+    return;
+
+  g_free (window->text_image);
+  window->text_image = NULL;
+  g_free (window->image_markup);
+  window->image_markup = NULL;
+  window->image_width = 0;
+  window->image_height = 0;
+  window->image_serial++;
+}
+
 static void
 gst_cea708dec_clear_window (Cea708Dec * decoder, cea708Window * window)
 {
   g_free (window->text_image);
+  g_free (window->image_markup);
+  if (window->layout)
+    g_object_unref (window->layout);
   memset (window, 0, sizeof (cea708Window));
 }
 
@@ -1383,12 +1420,10 @@ gst_cea708dec_init_window (Cea708Dec * decoder, guint window_id)
 
   window->v_offset = 0;
   window->h_offset = 0;
-  window->layout = NULL;
   window->shadow_offset = 0;
   window->outline_offset = 0;
-  window->image_width = 0;
-  window->image_height = 0;
-  window->text_image = NULL;
+  /* the layout is kept, to be reused by the next text of the window */
+  gst_cea708dec_clear_window_image (window);
 
 }
 
@@ -1610,7 +1645,7 @@ gst_cea708dec_render_text (Cea708Dec * decoder, GSList ** text_list,
   gchar *out_str = NULL;
   PangoAlignment align_mode;
   PangoFontDescription *desc;
-  gchar *font_desc;
+  gchar *font_desc, *markup;
   cea708Window *window = decoder->cc_windows[window_id];
 
   if (length > 0) {
@@ -1618,16 +1653,32 @@ gst_cea708dec_render_text (Cea708Dec * decoder, GSList ** text_list,
     memset (out_str, 0, length + 1);
 
     g_slist_foreach (*text_list, get_cea708dec_bufcat, out_str);
-    GST_LOG ("rendering '%s'", out_str);
     g_slist_free (*text_list);
-    window->layout = pango_layout_new (decoder->pango_context);
-    align_mode = gst_cea708dec_get_align_mode (window->justify_mode);
-    pango_layout_set_alignment (window->layout, (PangoAlignment) align_mode);
-    pango_layout_set_markup (window->layout, out_str, length);
     if (!decoder->default_font_desc)
       font_desc = g_strdup_printf ("%s %s", font_names[0], pen_size_names[1]);
     else
       font_desc = g_strdup (decoder->default_font_desc);
+
+    /* displaying the same text again doesn't need a new layout and image */
+    markup = g_strdup_printf ("%d %s\n%s", window->justify_mode, font_desc,
+        out_str);
+    if (window->text_image && !g_strcmp0 (markup, window->image_markup)) {
+      GST_LOG ("window %d unchanged, keeping its image", window_id);
+      g_free (markup);
+      g_free (font_desc);
+      g_free (out_str);
+      *text_list = NULL;
+      return TRUE;
+    }
+
+    GST_LOG ("rendering '%s'", out_str);
+    /* keeping the layout keeps its shaped glyph runs if the text is the
+     * same, and the cairo glyph cache of its font */
+    if (!window->layout)
+      window->layout = pango_layout_new (decoder->pango_context);
+    align_mode = gst_cea708dec_get_align_mode (window->justify_mode);
+    pango_layout_set_alignment (window->layout, (PangoAlignment) align_mode);
+    pango_layout_set_markup (window->layout, out_str, length);
     desc = pango_font_description_from_string (font_desc);
     if (desc) {
       GST_INFO ("font description set: %s", font_desc);
@@ -1635,8 +1686,12 @@ gst_cea708dec_render_text (Cea708Dec * decoder, GSList ** text_list,
       gst_cea708dec_adjust_values_with_fontdesc (window, desc);
       pango_font_description_free (desc);
       gst_cea708dec_render_pangocairo (window);
+      g_free (window->image_markup);
+      window->image_markup = markup;
+      window->image_serial++;
     } else {
       GST_ERROR ("font description parse failed: %s", font_desc);
+      g_free (markup);
     }
     g_free (font_desc);
     g_free (out_str);
@@ -358,6 +358,18 @@ typedef struct
 } cea708char;
 
 
+/* What the on screen rendering of a window depends on, kept to tell which
+ * windows changed while processing a packet */
+typedef struct
+{
+  gboolean visible;
+  gboolean deleted;
+  guint image_serial;
+  guint8 anchor_point;
+  gfloat screen_vertical;
+  gfloat screen_horizontal;
+} cea708WindowState;
+
 /* This struct keeps track of one cea-708 CC window. There are up to 8. As new
   * windows are created, the text they contain is visible on the screen (if the
   * window visible flag is set). When a window is deleted, all text within the
@@ -442,6 +454,14 @@ typedef struct
   gint image_width;
   gint image_height;
   gboolean updated;
+
+  /* text_image was rendered from this, with font and justification */
+  gchar *image_markup;
+  /* increased each time text_image is rendered again */
+  guint image_serial;
+  /* state after the previous packet, and whether this one changed it */
+  cea708WindowState state;
+  gboolean dirty;
 } cea708Window;
 
 struct _Cea708Dec
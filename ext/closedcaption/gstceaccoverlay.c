@@ -289,6 +289,20 @@ gst_base_cea_cc_overlay_class_init (GstCeaCcOverlayClass * klass)
 
 }
 
+static void
+gst_cea_cc_overlay_clear_window_cache (GstCeaCcOverlay * overlay)
+{
+  guint i;
+
+  for (i = 0; i < MAX_708_WINDOWS; i++) {
+    GstCeaCcOverlayWindowCache *cache = &overlay->window_cache[i];
+
+    if (cache->rect)
+      gst_video_overlay_rectangle_unref (cache->rect);
+    memset (cache, 0, sizeof (*cache));
+  }
+}
+
 static void
 gst_cea_cc_overlay_finalize (GObject * object)
 {
@@ -303,6 +317,8 @@ gst_cea_cc_overlay_finalize (GObject * object)
     overlay->next_composition = NULL;
   }
 
+  gst_cea_cc_overlay_clear_window_cache (overlay);
+
   gst_cea708dec_free (overlay->decoder);
   overlay->decoder = NULL;
 
@@ -1258,131 +1274,176 @@ gst_cea_cc_overlay_image_to_ayuv (guchar * pixbuf,
 }
 
 static void
-gst_cea_cc_overlay_create_and_push_buffer (GstCeaCcOverlay * overlay)
+gst_cea_cc_overlay_place_window (GstCeaCcOverlay * overlay,
+    cea708Window * window)
+{
+  guint v_anchor = 0;
+  guint h_anchor = 0;
+
+  v_anchor = window->screen_vertical * overlay->height / 100;
+  switch (overlay->default_window_h_pos) {
+    case GST_CEA_CC_OVERLAY_WIN_H_LEFT:
+      window->h_offset = 0;
+      break;
+    case GST_CEA_CC_OVERLAY_WIN_H_CENTER:
+      window->h_offset = (overlay->width - window->image_width) / 2;
+      break;
+    case GST_CEA_CC_OVERLAY_WIN_H_RIGHT:
+      window->h_offset = overlay->width - window->image_width;
+      break;
+    case GST_CEA_CC_OVERLAY_WIN_H_AUTO:
+    default:
+      switch (window->anchor_point) {
+        case ANCHOR_PT_TOP_LEFT:
+        case ANCHOR_PT_MIDDLE_LEFT:
+        case ANCHOR_PT_BOTTOM_LEFT:
+          window->h_offset = h_anchor;
+          break;
+
+        case ANCHOR_PT_TOP_CENTER:
+        case ANCHOR_PT_CENTER:
+        case ANCHOR_PT_BOTTOM_CENTER:
+          window->h_offset = h_anchor - window->image_width / 2;
+          break;
+
+        case ANCHOR_PT_TOP_RIGHT:
+        case ANCHOR_PT_MIDDLE_RIGHT:
+        case ANCHOR_PT_BOTTOM_RIGHT:
+          window->h_offset = h_anchor - window->image_width;
+          break;
+        default:
+          break;
+      }
+      break;
+  }
+
+  switch (window->anchor_point) {
+    case ANCHOR_PT_TOP_LEFT:
+    case ANCHOR_PT_TOP_CENTER:
+    case ANCHOR_PT_TOP_RIGHT:
+      window->v_offset = v_anchor;
+      break;
+
+    case ANCHOR_PT_MIDDLE_LEFT:
+    case ANCHOR_PT_CENTER:
+    case ANCHOR_PT_MIDDLE_RIGHT:
+      window->v_offset = v_anchor - window->image_height / 2;
+      break;
+
+    case ANCHOR_PT_BOTTOM_LEFT:
+    case ANCHOR_PT_BOTTOM_CENTER:
+    case ANCHOR_PT_BOTTOM_RIGHT:
+      window->v_offset = v_anchor - window->image_height;
+      break;
+    default:
+      break;
+  }
+
+  GST_INFO_OBJECT (overlay,
+      "window->anchor_point=%d,v_anchor=%d,h_anchor=%d,window->image_height=%d,window->image_width=%d, window->v_offset=%d, window->h_offset=%d,window->justify_mode=%d",
+      window->anchor_point, v_anchor, h_anchor, window->image_height,
+      window->image_width, window->v_offset, window->h_offset,
+      window->justify_mode);
+}
+
+static GstVideoOverlayRectangle *
+gst_cea_cc_overlay_window_rectangle (GstCeaCcOverlay * overlay,
+    cea708Window * window)
 {
   Cea708Dec *decoder = overlay->decoder;
   GstBuffer *outbuf;
   GstMapInfo map;
   guint8 *window_image;
   gint n;
+  GstVideoOverlayRectangle *rect;
+
+  GST_DEBUG_OBJECT (overlay, "Allocating buffer");
+  outbuf =
+      gst_buffer_new_and_alloc (window->image_width *
+      window->image_height * 4);
+  gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
+  window_image = map.data;
+  if (decoder->use_ARGB) {
+    memset (window_image, 0, window->image_width * window->image_height * 4);
+    gst_buffer_add_video_meta (outbuf, GST_VIDEO_FRAME_FLAG_NONE,
+        GST_VIDEO_OVERLAY_COMPOSITION_FORMAT_RGB, window->image_width,
+        window->image_height);
+  } else {
+    for (n = 0; n < window->image_width * window->image_height; n++) {
+      window_image[n * 4] = window_image[n * 4 + 1] = 0;
+      window_image[n * 4 + 2] = window_image[n * 4 + 3] = 128;
+    }
+    gst_buffer_add_video_meta (outbuf, GST_VIDEO_FRAME_FLAG_NONE,
+        GST_VIDEO_OVERLAY_COMPOSITION_FORMAT_YUV, window->image_width,
+        window->image_height);
+  }
+
+  if (decoder->use_ARGB) {
+    gst_cea_cc_overlay_image_to_argb (window_image, window,
+        window->image_width * 4);
+  } else {
+    gst_cea_cc_overlay_image_to_ayuv (window_image, window,
+        window->image_width * 4);
+  }
+  gst_buffer_unmap (outbuf, &map);
+
+  rect =
+      gst_video_overlay_rectangle_new_raw (outbuf, window->h_offset,
+      window->v_offset, window->image_width, window->image_height, 0);
+  gst_buffer_unref (outbuf);
+
+  return rect;
+}
+
+static void
+gst_cea_cc_overlay_create_and_push_buffer (GstCeaCcOverlay * overlay)
+{
+  Cea708Dec *decoder = overlay->decoder;
   guint window_id;
   cea708Window *window;
-  guint v_anchor = 0;
-  guint h_anchor = 0;
   GstVideoOverlayComposition *comp = NULL;
   GstVideoOverlayRectangle *rect = NULL;
+  GstCeaCcOverlayWindowCache *cache;
   GST_CEA_CC_OVERLAY_LOCK (overlay);
 
   for (window_id = 0; window_id < 8; window_id++) {
     window = decoder->cc_windows[window_id];
+    cache = &overlay->window_cache[window_id];
 
     if (!window->updated) {
       continue;
     }
     if (!window->deleted && window->visible && window->text_image != NULL) {
-      GST_DEBUG_OBJECT (overlay, "Allocating buffer");
-      outbuf =
-          gst_buffer_new_and_alloc (window->image_width *
-          window->image_height * 4);
-      gst_buffer_map (outbuf, &map, GST_MAP_WRITE);
-      window_image = map.data;
-      if (decoder->use_ARGB) {
-        memset (window_image, 0,
-            window->image_width * window->image_height * 4);
-        gst_buffer_add_video_meta (outbuf, GST_VIDEO_FRAME_FLAG_NONE,
-            GST_VIDEO_OVERLAY_COMPOSITION_FORMAT_RGB, window->image_width,
-            window->image_height);
+      gst_cea_cc_overlay_place_window (overlay, window);
+
+      /* converting and uploading the window image again is only needed
+       * when the decoder rendered it again or it moved */
+      if (cache->rect && cache->image_serial == window->image_serial
+          && cache->h_offset == window->h_offset
+          && cache->v_offset == window->v_offset
+          && cache->use_ARGB == decoder->use_ARGB) {
+        GST_LOG_OBJECT (overlay, "reusing rectangle of window %d", window_id);
+        rect = gst_video_overlay_rectangle_ref (cache->rect);
       } else {
-        for (n = 0; n < window->image_width * window->image_height; n++) {
-          window_image[n * 4] = window_image[n * 4 + 1] = 0;
-          window_image[n * 4 + 2] = window_image[n * 4 + 3] = 128;
-        }
-        gst_buffer_add_video_meta (outbuf, GST_VIDEO_FRAME_FLAG_NONE,
-            GST_VIDEO_OVERLAY_COMPOSITION_FORMAT_YUV, window->image_width,
-            window->image_height);
+        rect = gst_cea_cc_overlay_window_rectangle (overlay, window);
+        if (cache->rect)
+          gst_video_overlay_rectangle_unref (cache->rect);
+        cache->rect = gst_video_overlay_rectangle_ref (rect);
+        cache->image_serial = window->image_serial;
+        cache->h_offset = window->h_offset;
+        cache->v_offset = window->v_offset;
+        cache->use_ARGB = decoder->use_ARGB;
       }
 
-      v_anchor = window->screen_vertical * overlay->height / 100;
-      switch (overlay->default_window_h_pos) {
-        case GST_CEA_CC_OVERLAY_WIN_H_LEFT:
-          window->h_offset = 0;
-          break;
-        case GST_CEA_CC_OVERLAY_WIN_H_CENTER:
-          window->h_offset = (overlay->width - window->image_width) / 2;
-          break;
-        case GST_CEA_CC_OVERLAY_WIN_H_RIGHT:
-          window->h_offset = overlay->width - window->image_width;
-          break;
-        case GST_CEA_CC_OVERLAY_WIN_H_AUTO:
-        default:
-          switch (window->anchor_point) {
-            case ANCHOR_PT_TOP_LEFT:
-            case ANCHOR_PT_MIDDLE_LEFT:
-            case ANCHOR_PT_BOTTOM_LEFT:
-              window->h_offset = h_anchor;
-              break;
-
-            case ANCHOR_PT_TOP_CENTER:
-            case ANCHOR_PT_CENTER:
-            case ANCHOR_PT_BOTTOM_CENTER:
-              window->h_offset = h_anchor - window->image_width / 2;
-              break;
-
-            case ANCHOR_PT_TOP_RIGHT:
-            case ANCHOR_PT_MIDDLE_RIGHT:
-            case ANCHOR_PT_BOTTOM_RIGHT:
-              window->h_offset = h_anchor - window->image_width;
-              break;
-            default:
-              break;
-          }
-          break;
-      }
-
-      switch (window->anchor_point) {
-        case ANCHOR_PT_TOP_LEFT:
-        case ANCHOR_PT_TOP_CENTER:
-        case ANCHOR_PT_TOP_RIGHT:
-          window->v_offset = v_anchor;
-          break;
-
-        case ANCHOR_PT_MIDDLE_LEFT:
-        case ANCHOR_PT_CENTER:
-        case ANCHOR_PT_MIDDLE_RIGHT:
-          window->v_offset = v_anchor - window->image_height / 2;
-          break;
-
-        case ANCHOR_PT_BOTTOM_LEFT:
-        case ANCHOR_PT_BOTTOM_CENTER:
-        case ANCHOR_PT_BOTTOM_RIGHT:
-          window->v_offset = v_anchor - window->image_height;
-          break;
-        default:
-          break;
-      }
-      if (decoder->use_ARGB) {
-        gst_cea_cc_overlay_image_to_argb (window_image, window,
-            window->image_width * 4);
-      } else {
-        gst_cea_cc_overlay_image_to_ayuv (window_image, window,
-            window->image_width * 4);
-      }
-      gst_buffer_unmap (outbuf, &map);
-      GST_INFO_OBJECT (overlay,
-          "window->anchor_point=%d,v_anchor=%d,h_anchor=%d,window->image_height=%d,window->image_width=%d, window->v_offset=%d, window->h_offset=%d,window->justify_mode=%d",
-          window->anchor_point, v_anchor, h_anchor, window->image_height,
-          window->image_width, window->v_offset, window->h_offset,
-          window->justify_mode);
-      rect =
-          gst_video_overlay_rectangle_new_raw (outbuf, window->h_offset,
-          window->v_offset, window->image_width, window->image_height, 0);
       if (comp == NULL) {
         comp = gst_video_overlay_composition_new (rect);
       } else {
         gst_video_overlay_composition_add_rectangle (comp, rect);
       }
       gst_video_overlay_rectangle_unref (rect);
-      gst_buffer_unref (outbuf);
+    } else if (cache->rect) {
+      gst_video_overlay_rectangle_unref (cache->rect);
+      cache->rect = NULL;
     }
   }
 
@@ -68,6 +68,17 @@ typedef enum
   GST_CEA_CC_OVERLAY_WIN_H_AUTO
 } GstCeaCcOverlayWinHPos;
 
+/* the overlay rectangle made for a window image, reused while the image
+ * and its position don't change */
+typedef struct
+{
+  GstVideoOverlayRectangle *rect;
+  guint image_serial;
+  guint h_offset;
+  guint v_offset;
+  gboolean use_ARGB;
+} GstCeaCcOverlayWindowCache;
+
 /**
  * GstCeaCcOverlay:
  *
@@ -119,6 +130,8 @@ struct _GstCeaCcOverlay
   gboolean need_update;
 
   gboolean attach_compo_to_buffer;
+
+  GstCeaCcOverlayWindowCache window_cache[MAX_708_WINDOWS];
 };
 
 /* FIXME : Pango context and MT-safe since 1.32.6 */
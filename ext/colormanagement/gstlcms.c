@@ -61,7 +61,53 @@ enum
   PROP_SRC_FILE,
   PROP_DST_FILE,
   PROP_PRESERVE_BLACK,
-  PROP_EMBEDDED_PROFILE
+  PROP_EMBEDDED_PROFILE,
+  PROP_CACHE_DIRECTORY,
+  PROP_N_THREADS
+};
+
+#define LUT_N_ENTRIES 0x01000000
+#define LUT_UNCACHED_ENTRY 0xAAAAAAAA
+
+/* a lookup table, shared by all instances with the same profiles, intent,
+ * lookup method and black preservation. Precalculated tables are read-only
+ * once built; cached ones are filled as colors are first met, which is
+ * fine to do concurrently since all writers store the same value. */
+struct _GstLcmsLut
+{
+  gint refcount;
+  gchar *key;
+  gboolean ready;
+  guint32 *data;
+  /* set when loaded from the cache directory */
+  GMappedFile *file;
+};
+
+static GMutex lut_cache_lock;
+static GCond lut_cache_cond;
+static GHashTable *lut_cache;
+
+#define MIN_ROWS_PER_JOB 16
+
+typedef struct _GstLcmsJob GstLcmsJob;
+
+/* either a range of frame rows to process or a range of lookup table
+ * entries to precalculate */
+struct _GstLcmsJob
+{
+  GstLcms *lcms;
+  void (*func) (GstLcmsJob * job);
+
+  guint8 *in_data, *out_data;
+  gint width, height;
+  gint in_stride, out_stride;
+  gint in_pixel_stride, out_pixel_stride;
+  const gint *in_offsets, *out_offsets;
+  gboolean has_alpha;
+
+  cmsHTRANSFORM transform;
+  guint32 *lut;
+  guint32 first, n_entries;
 };
 
 GType
@@ -115,6 +161,8 @@ gst_lcms_lookup_method_get_type (void)
 #define DEFAULT_LOOKUP_METHOD     GST_LCMS_LOOKUP_METHOD_CACHED
 #define DEFAULT_PRESERVE_BLACK    FALSE
 #define DEFAULT_EMBEDDED_PROFILE  TRUE
+#define DEFAULT_CACHE_DIRECTORY   NULL
+#define DEFAULT_N_THREADS         1
 
 static GstStaticPadTemplate gst_lcms_src_template =
 GST_STATIC_PAD_TEMPLATE ("src",
@@ -154,6 +202,7 @@ static void gst_lcms_get_ready (GstLcms * lcms);
 static void gst_lcms_create_transform (GstLcms * lcms);
 static void gst_lcms_cleanup_cms (GstLcms * lcms);
 static void gst_lcms_init_lookup_table (GstLcms * lcms);
+static void gst_lcms_lut_unref (GstLcmsLut * lut);
 static void gst_lcms_process_rgb (GstLcms * lcms, GstVideoFrame * inframe,
     GstVideoFrame * outframe);
 
@@ -207,6 +256,34 @@ gst_lcms_class_init (GstLcmsClass * klass)
           DEFAULT_EMBEDDED_PROFILE,
           (G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
+  /**
+   * GstLcms:cache-directory:
+   *
+   * Directory where precalculated lookup tables are saved, to be loaded
+   * instead of computed by later instances using the same profiles, even
+   * from other processes. Tables are only kept in memory if unset.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_CACHE_DIRECTORY,
+      g_param_spec_string ("cache-directory", "Cache directory",
+          "Directory to save and load precalculated lookup tables",
+          DEFAULT_CACHE_DIRECTORY,
+          (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+  /**
+   * GstLcms:n-threads:
+   *
+   * Maximum number of threads used to transform frames and precalculate
+   * lookup tables, 0 means one thread per processor.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of Threads",
+          "Maximum number of threads to use", 0, G_MAXUINT,
+          DEFAULT_N_THREADS, (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
   gst_element_class_set_static_metadata (element_class,
       "LCMS2 ICC correction", "Filter/Effect/Video",
       "Uses LittleCMS 2 to perform ICC profile correction",
@@ -237,16 +314,24 @@ gst_lcms_init (GstLcms * lcms)
   lcms->cms_inp_profile = NULL;
   lcms->cms_dst_profile = NULL;
   lcms->cms_transform = NULL;
+  lcms->n_threads = DEFAULT_N_THREADS;
+  g_mutex_init (&lcms->jobs_lock);
+  g_cond_init (&lcms->jobs_cond);
 }
 
 static void
 gst_lcms_finalize (GObject * object)
 {
   GstLcms *lcms = GST_LCMS (object);
-  if (lcms->color_lut)
-    g_free (lcms->color_lut);
+  if (lcms->lut)
+    gst_lcms_lut_unref (lcms->lut);
+  if (lcms->pool)
+    g_thread_pool_free (lcms->pool, FALSE, TRUE);
+  g_mutex_clear (&lcms->jobs_lock);
+  g_cond_clear (&lcms->jobs_cond);
   g_free (lcms->inp_profile_filename);
   g_free (lcms->dst_profile_filename);
+  g_free (lcms->cache_directory);
   G_OBJECT_CLASS (gst_lcms_parent_class)->finalize (object);
 }
 
@@ -366,6 +451,15 @@ gst_lcms_set_property (GObject * object, guint prop_id, const GValue * value,
     case PROP_EMBEDDED_PROFILE:
       lcms->embeddedprofiles = g_value_get_boolean (value);
       break;
+    case PROP_CACHE_DIRECTORY:
+      GST_OBJECT_LOCK (lcms);
+      g_free (lcms->cache_directory);
+      lcms->cache_directory = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (lcms);
+      break;
+    case PROP_N_THREADS:
+      lcms->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -397,6 +491,14 @@ gst_lcms_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_EMBEDDED_PROFILE:
       g_value_set_boolean (value, lcms->embeddedprofiles);
       break;
+    case PROP_CACHE_DIRECTORY:
+      GST_OBJECT_LOCK (lcms);
+      g_value_set_string (value, lcms->cache_directory);
+      GST_OBJECT_UNLOCK (lcms);
+      break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, lcms->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -498,42 +600,366 @@ gst_lcms_cleanup_cms (GstLcms * lcms)
     cmsDeleteTransform (lcms->cms_transform);
     lcms->cms_transform = NULL;
   }
+  if (lcms->lut) {
+    gst_lcms_lut_unref (lcms->lut);
+    lcms->lut = NULL;
+    lcms->color_lut = NULL;
+  }
 }
 
 static void
-gst_lcms_init_lookup_table (GstLcms * lcms)
+gst_lcms_job_func (gpointer data, gpointer user_data)
 {
-  guint32 p;
-  const guint32 color_max = 0x01000000;
+  GstLcmsJob *job = (GstLcmsJob *) data;
+  GstLcms *lcms = job->lcms;
 
-  if (lcms->color_lut)
-    g_free (lcms->color_lut);
+  job->func (job);
 
-  lcms->color_lut = g_new (guint32, color_max);
+  g_mutex_lock (&lcms->jobs_lock);
+  if (--lcms->jobs_pending == 0)
+    g_cond_signal (&lcms->jobs_cond);
+  g_mutex_unlock (&lcms->jobs_lock);
+}
 
-  if (lcms->color_lut == NULL) {
-    GST_ELEMENT_ERROR (lcms, RESOURCE, FAILED, ("LUT alloc failed"),
-        ("Unable to open allocate memory for lookup table!"));
-    return;
+/* runs @n_jobs jobs, the first one from the calling thread, and waits for
+ * all of them to be done */
+static void
+gst_lcms_run_jobs (GstLcms * lcms, GstLcmsJob * jobs, guint n_jobs)
+{
+  guint i;
+
+  if (n_jobs > 1) {
+    if (lcms->pool == NULL)
+      lcms->pool = g_thread_pool_new (gst_lcms_job_func, NULL, -1, FALSE,
+          NULL);
+
+    lcms->jobs_pending = n_jobs - 1;
+    for (i = 1; i < n_jobs; i++)
+      g_thread_pool_push (lcms->pool, &jobs[i], NULL);
   }
 
-  if (lcms->lookup_method == GST_LCMS_LOOKUP_METHOD_PRECALCULATED) {
-    cmsHTRANSFORM hTransform;
-    hTransform =
-        cmsCreateTransform (lcms->cms_inp_profile, TYPE_RGB_8,
-        lcms->cms_dst_profile, TYPE_RGB_8, lcms->intent, 0);
-    /*FIXME use cmsFLAGS_COPY_ALPHA when new lcms2 2.8 release is available */
-    for (p = 0; p < color_max; p++)
-      cmsDoTransform (hTransform, (const cmsUInt32Number *) &p,
-          &lcms->color_lut[p], 1);
-    cmsDeleteTransform (hTransform);
-    GST_DEBUG_OBJECT (lcms, "writing lookup table finished");
-  } else if (lcms->lookup_method == GST_LCMS_LOOKUP_METHOD_CACHED) {
-    memset (lcms->color_lut, 0xAA, color_max * sizeof (guint32));
+  jobs[0].func (&jobs[0]);
+
+  if (n_jobs > 1) {
+    g_mutex_lock (&lcms->jobs_lock);
+    while (lcms->jobs_pending > 0)
+      g_cond_wait (&lcms->jobs_cond, &lcms->jobs_lock);
+    g_mutex_unlock (&lcms->jobs_lock);
+  }
+}
+
+static guint
+gst_lcms_get_n_threads (GstLcms * lcms)
+{
+  guint n_threads = lcms->n_threads;
+
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+
+  return n_threads;
+}
+
+/* identifies a profile by the checksum of its serialized form, NULL stands
+ * for the sRGB fallback */
+static gchar *
+gst_lcms_profile_checksum (cmsHPROFILE profile)
+{
+  cmsUInt32Number size = 0;
+  guint8 *data;
+  gchar *checksum = NULL;
+
+  if (!profile)
+    return g_strdup ("srgb");
+
+  if (!cmsSaveProfileToMem (profile, NULL, &size) || size == 0)
+    return NULL;
+
+  data = (guint8 *) g_malloc (size);
+  if (cmsSaveProfileToMem (profile, data, &size))
+    checksum = g_compute_checksum_for_data (G_CHECKSUM_SHA1, data, size);
+  g_free (data);
+
+  return checksum;
+}
+
+static gchar *
+gst_lcms_lut_key (GstLcms * lcms)
+{
+  gchar *inp, *dst, *key = NULL;
+
+  inp = gst_lcms_profile_checksum (lcms->cms_inp_profile);
+  dst = gst_lcms_profile_checksum (lcms->cms_dst_profile);
+
+  if (inp && dst)
+    key = g_strdup_printf ("%s-%s-%d-%s%s", inp, dst, lcms->intent,
+        lcms->lookup_method == GST_LCMS_LOOKUP_METHOD_PRECALCULATED ?
+        "precalculated" : "cached", lcms->preserve_black ? "-black" : "");
+
+  g_free (inp);
+  g_free (dst);
+
+  return key;
+}
+
+static void
+gst_lcms_lut_fill (GstLcmsJob * job)
+{
+  guint32 src[256];
+  guint32 p, i;
+
+  for (p = job->first; p < job->first + job->n_entries; p += 256) {
+    for (i = 0; i < 256; i++)
+      src[i] = p + i;
+    cmsDoTransform (job->transform, src, &job->lut[p], 256);
+  }
+}
+
+/* precalculates all entries of @data, in parallel over the blue values */
+static gboolean
+gst_lcms_lut_precalculate (GstLcms * lcms, guint32 * data)
+{
+  cmsHPROFILE inp_profile, dst_profile;
+  cmsHTRANSFORM transform;
+  /* the table entries are 0x00BBGGRR, with the top byte left alone */
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+  const cmsUInt32Number format = TYPE_RGBA_8;
+#else
+  const cmsUInt32Number format = TYPE_ABGR_8;
+#endif
+  GstLcmsJob *jobs;
+  guint n_jobs, i, planes = 0;
+
+  inp_profile = lcms->cms_inp_profile;
+  if (!inp_profile)
+    inp_profile = cmsCreate_sRGBProfile ();
+  dst_profile = lcms->cms_dst_profile;
+  if (!dst_profile)
+    dst_profile = cmsCreate_sRGBProfile ();
+
+  /*FIXME use cmsFLAGS_COPY_ALPHA when new lcms2 2.8 release is available */
+  transform = cmsCreateTransform (inp_profile, format, dst_profile, format,
+      lcms->intent, 0);
+
+  if (inp_profile != lcms->cms_inp_profile)
+    cmsCloseProfile (inp_profile);
+  if (dst_profile != lcms->cms_dst_profile)
+    cmsCloseProfile (dst_profile);
+
+  if (!transform)
+    return FALSE;
+
+  n_jobs = MIN (gst_lcms_get_n_threads (lcms), 256);
+  jobs = g_newa (GstLcmsJob, n_jobs);
+  for (i = 0; i < n_jobs; i++) {
+    guint n_planes = (256 - planes) / (n_jobs - i);
+
+    jobs[i].lcms = lcms;
+    jobs[i].func = gst_lcms_lut_fill;
+    jobs[i].transform = transform;
+    jobs[i].lut = data;
+    jobs[i].first = planes << 16;
+    jobs[i].n_entries = n_planes << 16;
+    planes += n_planes;
+  }
+
+  gst_lcms_run_jobs (lcms, jobs, n_jobs);
+
+  cmsDeleteTransform (transform);
+
+  return TRUE;
+}
+
+static gchar *
+gst_lcms_lut_filename (const gchar * directory, const gchar * key)
+{
+  gchar *name, *filename;
+
+  name = g_strdup_printf ("%s-%s.lut", key,
+      G_BYTE_ORDER == G_LITTLE_ENDIAN ? "le" : "be");
+  filename = g_build_filename (directory, name, NULL);
+  g_free (name);
+
+  return filename;
+}
+
+static gboolean
+gst_lcms_lut_load (GstLcms * lcms, GstLcmsLut * lut, const gchar * filename)
+{
+  GMappedFile *file;
+
+  file = g_mapped_file_new (filename, FALSE, NULL);
+  if (!file)
+    return FALSE;
+
+  if (g_mapped_file_get_length (file) != LUT_N_ENTRIES * sizeof (guint32)) {
+    GST_WARNING_OBJECT (lcms, "ignoring lookup table file '%s' of wrong size",
+        filename);
+    g_mapped_file_unref (file);
+    return FALSE;
+  }
+
+  lut->file = file;
+  lut->data = (guint32 *) g_mapped_file_get_contents (file);
+  GST_DEBUG_OBJECT (lcms, "loaded lookup table from '%s'", filename);
+
+  return TRUE;
+}
+
+static void
+gst_lcms_lut_save (GstLcms * lcms, GstLcmsLut * lut, const gchar * filename)
+{
+  gchar *directory;
+  GError *err = NULL;
+
+  directory = g_path_get_dirname (filename);
+  g_mkdir_with_parents (directory, 0755);
+  g_free (directory);
+
+  if (!g_file_set_contents (filename, (const gchar *) lut->data,
+          LUT_N_ENTRIES * sizeof (guint32), &err)) {
+    GST_WARNING_OBJECT (lcms, "couldn't save lookup table: %s",
+        err->message);
+    g_clear_error (&err);
+  } else {
+    GST_DEBUG_OBJECT (lcms, "saved lookup table to '%s'", filename);
+  }
+}
+
+/* fills @lut, without holding the cache lock */
+static gboolean
+gst_lcms_lut_build (GstLcms * lcms, GstLcmsLut * lut)
+{
+  gchar *filename = NULL;
+
+  if (lcms->lookup_method == GST_LCMS_LOOKUP_METHOD_CACHED) {
+    lut->data = g_new (guint32, LUT_N_ENTRIES);
+    memset (lut->data, 0xAA, LUT_N_ENTRIES * sizeof (guint32));
+    if (lcms->preserve_black)
+      lut->data[0] = 0x000000;
     GST_DEBUG_OBJECT (lcms, "initialized empty lookup table for caching");
+    return TRUE;
+  }
+
+  GST_OBJECT_LOCK (lcms);
+  if (lcms->cache_directory)
+    filename = gst_lcms_lut_filename (lcms->cache_directory, lut->key);
+  GST_OBJECT_UNLOCK (lcms);
+
+  if (filename && gst_lcms_lut_load (lcms, lut, filename)) {
+    g_free (filename);
+    return TRUE;
+  }
+
+  lut->data = g_new0 (guint32, LUT_N_ENTRIES);
+  if (!gst_lcms_lut_precalculate (lcms, lut->data)) {
+    g_free (filename);
+    return FALSE;
   }
   if (lcms->preserve_black)
-    lcms->color_lut[0] = 0x000000;
+    lut->data[0] = 0x000000;
+  GST_DEBUG_OBJECT (lcms, "writing lookup table finished");
+
+  if (filename) {
+    gst_lcms_lut_save (lcms, lut, filename);
+    g_free (filename);
+  }
+
+  return TRUE;
+}
+
+static void
+gst_lcms_lut_free (GstLcmsLut * lut)
+{
+  if (lut->file)
+    g_mapped_file_unref (lut->file);
+  else
+    g_free (lut->data);
+  g_free (lut->key);
+  g_free (lut);
+}
+
+static void
+gst_lcms_lut_unref (GstLcmsLut * lut)
+{
+  g_mutex_lock (&lut_cache_lock);
+  if (--lut->refcount > 0) {
+    g_mutex_unlock (&lut_cache_lock);
+    return;
+  }
+  if (g_hash_table_lookup (lut_cache, lut->key) == lut)
+    g_hash_table_remove (lut_cache, lut->key);
+  g_mutex_unlock (&lut_cache_lock);
+
+  gst_lcms_lut_free (lut);
+}
+
+/* returns the table for the current settings, building it if no other
+ * instance has it already; the table is NULL if it couldn't be built */
+static GstLcmsLut *
+gst_lcms_lut_acquire (GstLcms * lcms, const gchar * key)
+{
+  GstLcmsLut *lut;
+  gboolean built;
+
+  g_mutex_lock (&lut_cache_lock);
+  if (!lut_cache)
+    lut_cache = g_hash_table_new (g_str_hash, g_str_equal);
+
+  lut = (GstLcmsLut *) g_hash_table_lookup (lut_cache, key);
+  if (lut) {
+    lut->refcount++;
+    /* another instance is building it */
+    while (!lut->ready)
+      g_cond_wait (&lut_cache_cond, &lut_cache_lock);
+    g_mutex_unlock (&lut_cache_lock);
+    GST_DEBUG_OBJECT (lcms, "sharing existing lookup table");
+    return lut;
+  }
+
+  lut = g_new0 (GstLcmsLut, 1);
+  lut->refcount = 1;
+  lut->key = g_strdup (key);
+  g_hash_table_insert (lut_cache, lut->key, lut);
+  g_mutex_unlock (&lut_cache_lock);
+
+  built = gst_lcms_lut_build (lcms, lut);
+
+  g_mutex_lock (&lut_cache_lock);
+  if (!built) {
+    /* don't hand out the failed table to later instances */
+    g_hash_table_remove (lut_cache, lut->key);
+    g_free (lut->data);
+    lut->data = NULL;
+  }
+  lut->ready = TRUE;
+  g_cond_broadcast (&lut_cache_cond);
+  g_mutex_unlock (&lut_cache_lock);
+
+  return lut;
+}
+
+static void
+gst_lcms_init_lookup_table (GstLcms * lcms)
+{
+  gchar *key;
+
+  if (lcms->lut) {
+    gst_lcms_lut_unref (lcms->lut);
+    lcms->lut = NULL;
+    lcms->color_lut = NULL;
+  }
+
+  key = gst_lcms_lut_key (lcms);
+  if (key) {
+    lcms->lut = gst_lcms_lut_acquire (lcms, key);
+    lcms->color_lut = lcms->lut->data;
+    g_free (key);
+  }
+
+  if (lcms->color_lut == NULL) {
+    GST_ELEMENT_ERROR (lcms, RESOURCE, FAILED, ("LUT creation failed"),
+        ("Unable to compute the lookup table!"));
+  }
 }
 
 static cmsUInt32Number
@@ -615,6 +1041,8 @@ gst_lcms_create_transform (GstLcms * lcms)
     lcms->cms_dst_profile = cmsCreate_sRGBProfile ();
     GST_INFO_OBJECT (lcms, "No output profile specified, falling back to sRGB");
   }
+  if (lcms->cms_transform)
+    cmsDeleteTransform (lcms->cms_transform);
   lcms->cms_transform =
       cmsCreateTransform (lcms->cms_inp_profile, lcms->cms_inp_format,
       lcms->cms_dst_profile, lcms->cms_dst_format, lcms->intent, 0);
@@ -737,78 +1165,32 @@ gst_lcms_transform_frame (GstVideoFilter * vfilter, GstVideoFrame * inframe,
 }
 
 static void
-gst_lcms_process_rgb (GstLcms * lcms, GstVideoFrame * inframe,
-    GstVideoFrame * outframe)
+gst_lcms_process_rows (GstLcmsJob * job)
 {
-  gint height;
-  gint width, in_stride, out_stride;
-  gint in_pixel_stride, out_pixel_stride;
-  gint in_offsets[4], out_offsets[4];
-  guint8 *in_data, *out_data;
+  GstLcms *lcms = job->lcms;
+  guint8 *in_data = job->in_data, *out_data = job->out_data;
+  const gint *in_offsets = job->in_offsets, *out_offsets = job->out_offsets;
+  gint in_pixel_stride = job->in_pixel_stride;
+  gint out_pixel_stride = job->out_pixel_stride;
+  gint width = job->width, height = job->height;
   gint i, j;
   gint in_row_wrap, out_row_wrap;
   guint8 alpha = 0;
 
-  in_data = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (inframe, 0);
-  in_stride = GST_VIDEO_FRAME_PLANE_STRIDE (inframe, 0);
-  width = GST_VIDEO_FRAME_COMP_WIDTH (inframe, 0);
-  height = GST_VIDEO_FRAME_COMP_HEIGHT (inframe, 0);
-  in_pixel_stride = GST_VIDEO_FRAME_COMP_PSTRIDE (inframe, 0);
-
-  in_offsets[0] = GST_VIDEO_FRAME_COMP_OFFSET (inframe, 0);
-  in_offsets[1] = GST_VIDEO_FRAME_COMP_OFFSET (inframe, 1);
-  in_offsets[2] = GST_VIDEO_FRAME_COMP_OFFSET (inframe, 2);
-  in_offsets[3] = GST_VIDEO_FRAME_COMP_OFFSET (inframe, 3);
-
-  if (outframe) {
-    if (width != GST_VIDEO_FRAME_COMP_WIDTH (outframe, 0)
-        || height != GST_VIDEO_FRAME_COMP_HEIGHT (outframe, 0)) {
-      GST_WARNING_OBJECT (lcms,
-          "can't transform, input dimensions != output dimensions!");
-      return;
-    }
-    out_data = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (outframe, 0);
-    out_stride = GST_VIDEO_FRAME_PLANE_STRIDE (outframe, 0);
-    out_pixel_stride = GST_VIDEO_FRAME_COMP_PSTRIDE (outframe, 0);
-    out_offsets[0] = GST_VIDEO_FRAME_COMP_OFFSET (inframe, 0);
-    out_offsets[1] = GST_VIDEO_FRAME_COMP_OFFSET (inframe, 1);
-    out_offsets[2] = GST_VIDEO_FRAME_COMP_OFFSET (inframe, 2);
-    out_offsets[3] = GST_VIDEO_FRAME_COMP_OFFSET (inframe, 3);
-    GST_LOG_OBJECT (lcms,
-        "transforming frame (%ix%i) stride=%i->%i pixel_stride=%i->%i format=%s->%s",
-        width, height, in_stride, out_stride, in_pixel_stride, out_pixel_stride,
-        gst_video_format_to_string (inframe->info.finfo->format),
-        gst_video_format_to_string (outframe->info.finfo->format));
-  } else {                      /* in-place transformation */
-    GST_LOG_OBJECT (lcms,
-        "transforming frame IN-PLACE (%ix%i) pixel_stride=%i format=%s", width,
-        height, in_pixel_stride,
-        gst_video_format_to_string (inframe->info.finfo->format));
-    out_data = in_data;
-    out_stride = in_stride;
-    out_pixel_stride = in_pixel_stride;
-    out_offsets[0] = in_offsets[0];
-    out_offsets[1] = in_offsets[1];
-    out_offsets[2] = in_offsets[2];
-    out_offsets[3] = in_offsets[3];
-  }
-
-  in_row_wrap = in_stride - in_pixel_stride * width;
-  out_row_wrap = out_stride - out_pixel_stride * width;
+  in_row_wrap = job->in_stride - in_pixel_stride * width;
+  out_row_wrap = job->out_stride - out_pixel_stride * width;
 
   if (lcms->lookup_method == GST_LCMS_LOOKUP_METHOD_UNCACHED) {
-    if (!GST_VIDEO_FORMAT_INFO_HAS_ALPHA (inframe->info.finfo)
-        && !lcms->preserve_black) {
-      GST_DEBUG_OBJECT (lcms,
-          "GST_LCMS_LOOKUP_METHOD_UNCACHED WITHOUT alpha AND WITHOUT preserve-black -> picture-at-once transformation!");
-      cmsDoTransformStride (lcms->cms_transform, in_data, out_data,
-          height * width, out_pixel_stride);
+    if (!job->has_alpha && !lcms->preserve_black) {
+      for (i = 0; i < height; i++) {
+        cmsDoTransform (lcms->cms_transform, in_data, out_data, width);
+        in_data += job->in_stride;
+        out_data += job->out_stride;
+      }
     } else {
-      GST_DEBUG_OBJECT (lcms,
-          "GST_LCMS_LOOKUP_METHOD_UNCACHED WITH alpha or preserve-black -> pixel-by-pixel transformation!");
       for (i = 0; i < height; i++) {
         for (j = 0; j < width; j++) {
-          if (GST_VIDEO_FORMAT_INFO_HAS_ALPHA (inframe->info.finfo))
+          if (job->has_alpha)
             alpha = in_data[in_offsets[3]];
           if (lcms->preserve_black && (in_data[in_offsets[0]] == 0x00)
               && (in_data[in_offsets[1]] == 0x00)
@@ -828,21 +1210,22 @@ gst_lcms_process_rgb (GstLcms * lcms, GstVideoFrame * inframe,
       }
     }
   } else if (lcms->lookup_method == GST_LCMS_LOOKUP_METHOD_PRECALCULATED) {
+    const guint32 *color_lut = lcms->color_lut;
     guint32 color, new_color;
-    GST_LOG_OBJECT (lcms, "GST_LCMS_LOOKUP_METHOD_PRECALCULATED");
+
     for (i = 0; i < height; i++) {
       for (j = 0; j < width; j++) {
         color =
             in_data[in_offsets[0]] |
             in_data[in_offsets[1]] << 0x08 | in_data[in_offsets[2]] << 0x10;
-        new_color = lcms->color_lut[color];
+        new_color = color_lut[color];
         out_data[out_offsets[0]] = (new_color & 0x0000FF) >> 0x00;
         out_data[out_offsets[1]] = (new_color & 0x00FF00) >> 0x08;
         out_data[out_offsets[2]] = (new_color & 0xFF0000) >> 0x10;
         GST_TRACE_OBJECT (lcms,
             "(%i:%i)@%p original color 0x%08X (dest was 0x%08X)", i, j, in_data,
             color, new_color);
-        if (GST_VIDEO_FORMAT_INFO_HAS_ALPHA (inframe->info.finfo)) {
+        if (job->has_alpha) {
           out_data[in_offsets[3]] = in_data[out_offsets[3]];
         }
         in_data += in_pixel_stride;
@@ -852,25 +1235,26 @@ gst_lcms_process_rgb (GstLcms * lcms, GstVideoFrame * inframe,
       out_data += out_row_wrap;
     }
   } else if (lcms->lookup_method == GST_LCMS_LOOKUP_METHOD_CACHED) {
+    guint32 *color_lut = lcms->color_lut;
     guint32 color, new_color;
-    GST_LOG_OBJECT (lcms, "GST_LCMS_LOOKUP_METHOD_CACHED");
+
     for (i = 0; i < height; i++) {
       for (j = 0; j < width; j++) {
-        if (GST_VIDEO_FORMAT_INFO_HAS_ALPHA (inframe->info.finfo))
+        if (job->has_alpha)
           alpha = in_data[in_offsets[3]];
         color =
             in_data[in_offsets[0]] |
             in_data[in_offsets[1]] << 0x08 | in_data[in_offsets[2]] << 0x10;
-        new_color = lcms->color_lut[color];
-        if (new_color == 0xAAAAAAAA) {
+        new_color = color_lut[color];
+        if (new_color == LUT_UNCACHED_ENTRY) {
           cmsDoTransform (lcms->cms_transform, in_data, out_data, 1);
           new_color =
               out_data[out_offsets[0]] |
               out_data[out_offsets[1]] << 0x08 |
               out_data[out_offsets[2]] << 0x10;
-          GST_OBJECT_LOCK (lcms);
-          lcms->color_lut[color] = new_color;
-          GST_OBJECT_UNLOCK (lcms);
+          /* the table may be shared with other threads and instances, which
+           * would all store the same value */
+          g_atomic_int_set ((gint *) & color_lut[color], new_color);
           GST_TRACE_OBJECT (lcms, "cached color 0x%08X -> 0x%08X", color,
               new_color);
         } else {
@@ -889,3 +1273,103 @@ gst_lcms_process_rgb (GstLcms * lcms, GstVideoFrame * inframe,
     }
   }
 }
+
+static void
+gst_lcms_process_rgb (GstLcms * lcms, GstVideoFrame * inframe,
+    GstVideoFrame * outframe)
+{
+  gint height;
+  gint width, in_stride, out_stride;
+  gint in_pixel_stride, out_pixel_stride;
+  gint in_offsets[4], out_offsets[4];
+  guint8 *in_data, *out_data;
+  GstLcmsJob *jobs;
+  guint n_jobs, i;
+  gint y = 0;
+
+  in_data = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (inframe, 0);
+  in_stride = GST_VIDEO_FRAME_PLANE_STRIDE (inframe, 0);
+  width = GST_VIDEO_FRAME_COMP_WIDTH (inframe, 0);
+  height = GST_VIDEO_FRAME_COMP_HEIGHT (inframe, 0);
+  in_pixel_stride = GST_VIDEO_FRAME_COMP_PSTRIDE (inframe, 0);
+
+  in_offsets[0] = GST_VIDEO_FRAME_COMP_OFFSET (inframe, 0);
+  in_offsets[1] = GST_VIDEO_FRAME_COMP_OFFSET (inframe, 1);
+  in_offsets[2] = GST_VIDEO_FRAME_COMP_OFFSET (inframe, 2);
+  in_offsets[3] = GST_VIDEO_FRAME_COMP_OFFSET (inframe, 3);
+
+  if (outframe) {
+    if (width != GST_VIDEO_FRAME_COMP_WIDTH (outframe, 0)
+        || height != GST_VIDEO_FRAME_COMP_HEIGHT (outframe, 0)) {
+      GST_WARNING_OBJECT (lcms,
+          "can't transform, input dimensions != output dimensions!");
+      return;
+    }
+    out_data = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (outframe, 0);
+    out_stride = GST_VIDEO_FRAME_PLANE_STRIDE (outframe, 0);
+    out_pixel_stride = GST_VIDEO_FRAME_COMP_PSTRIDE (outframe, 0);
+    out_offsets[0] = GST_VIDEO_FRAME_COMP_OFFSET (inframe, 0);
+    out_offsets[1] = GST_VIDEO_FRAME_COMP_OFFSET (inframe, 1);
+    out_offsets[2] = GST_VIDEO_FRAME_COMP_OFFSET (inframe, 2);
+    out_offsets[3] = GST_VIDEO_FRAME_COMP_OFFSET (inframe, 3);
+    GST_LOG_OBJECT (lcms,
+        "transforming frame (%ix%i) stride=%i->%i pixel_stride=%i->%i format=%s->%s",
+        width, height, in_stride, out_stride, in_pixel_stride, out_pixel_stride,
+        gst_video_format_to_string (inframe->info.finfo->format),
+        gst_video_format_to_string (outframe->info.finfo->format));
+  } else {                      /* in-place transformation */
+    GST_LOG_OBJECT (lcms,
+        "transforming frame IN-PLACE (%ix%i) pixel_stride=%i format=%s", width,
+        height, in_pixel_stride,
+        gst_video_format_to_string (inframe->info.finfo->format));
+    out_data = in_data;
+    out_stride = in_stride;
+    out_pixel_stride = in_pixel_stride;
+    out_offsets[0] = in_offsets[0];
+    out_offsets[1] = in_offsets[1];
+    out_offsets[2] = in_offsets[2];
+    out_offsets[3] = in_offsets[3];
+  }
+
+  if (lcms->lookup_method == GST_LCMS_LOOKUP_METHOD_UNCACHED) {
+    if (!GST_VIDEO_FORMAT_INFO_HAS_ALPHA (inframe->info.finfo)
+        && !lcms->preserve_black) {
+      GST_DEBUG_OBJECT (lcms,
+          "GST_LCMS_LOOKUP_METHOD_UNCACHED WITHOUT alpha AND WITHOUT preserve-black -> line-at-once transformation!");
+    } else {
+      GST_DEBUG_OBJECT (lcms,
+          "GST_LCMS_LOOKUP_METHOD_UNCACHED WITH alpha or preserve-black -> pixel-by-pixel transformation!");
+    }
+  } else if (!lcms->color_lut) {
+    GST_WARNING_OBJECT (lcms, "no lookup table, can't transform");
+    return;
+  } else if (lcms->lookup_method == GST_LCMS_LOOKUP_METHOD_PRECALCULATED) {
+    GST_LOG_OBJECT (lcms, "GST_LCMS_LOOKUP_METHOD_PRECALCULATED");
+  } else if (lcms->lookup_method == GST_LCMS_LOOKUP_METHOD_CACHED) {
+    GST_LOG_OBJECT (lcms, "GST_LCMS_LOOKUP_METHOD_CACHED");
+  }
+
+  /* split the frame in bands of rows, the transform is reentrant */
+  n_jobs = CLAMP (height / MIN_ROWS_PER_JOB, 1, gst_lcms_get_n_threads (lcms));
+  jobs = g_newa (GstLcmsJob, n_jobs);
+  for (i = 0; i < n_jobs; i++) {
+    gint rows = (height - y) / (n_jobs - i);
+
+    jobs[i].lcms = lcms;
+    jobs[i].func = gst_lcms_process_rows;
+    jobs[i].in_data = in_data + y * in_stride;
+    jobs[i].out_data = out_data + y * out_stride;
+    jobs[i].width = width;
+    jobs[i].height = rows;
+    jobs[i].in_stride = in_stride;
+    jobs[i].out_stride = out_stride;
+    jobs[i].in_pixel_stride = in_pixel_stride;
+    jobs[i].out_pixel_stride = out_pixel_stride;
+    jobs[i].in_offsets = in_offsets;
+    jobs[i].out_offsets = out_offsets;
+    jobs[i].has_alpha = GST_VIDEO_FORMAT_INFO_HAS_ALPHA (inframe->info.finfo);
+    y += rows;
+  }
+
+  gst_lcms_run_jobs (lcms, jobs, n_jobs);
+}
@@ -60,6 +60,7 @@ typedef enum
 
 typedef struct _GstLcms GstLcms;
 typedef struct _GstLcmsClass GstLcmsClass;
+typedef struct _GstLcmsLut GstLcmsLut;
 
 /**
  * GstLcms:
@@ -82,10 +83,19 @@ struct _GstLcms
   gchar *inp_profile_filename;
   gchar *dst_profile_filename;
 
+  /* shared with the other instances using the same profiles */
+  GstLcmsLut *lut;
   guint32 *color_lut;
+  gchar *cache_directory;
 
   gboolean preserve_black;
 
+  guint n_threads;
+  GThreadPool *pool;
+  GMutex jobs_lock;
+  GCond jobs_cond;
+  guint jobs_pending;
+
   void (*process) (GstLcms * lcms, GstVideoFrame * inframe,
       GstVideoFrame * outframe);
 };
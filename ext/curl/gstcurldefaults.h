@@ -133,6 +133,12 @@
 #define GSTCURL_DEFAULT_CONNECTIONS_SERVER 5
 #define GSTCURL_DEFAULT_CONNECTIONS_PROXY 30
 #define GSTCURL_DEFAULT_CONNECTIONS_GLOBAL 255
+#define GSTCURL_MIN_PARALLEL_RANGES 1
+#define GSTCURL_MAX_PARALLEL_RANGES 16
+#define GSTCURL_DEFAULT_PARALLEL_RANGES 1
+#define GSTCURL_MIN_RANGE_SIZE (16 * 1024)
+#define GSTCURL_MAX_RANGE_SIZE (1024 * 1024 * 1024)
+#define GSTCURL_DEFAULT_RANGE_SIZE (4 * 1024 * 1024)
 #define GSTCURL_INFO_RESPONSE(x) ((x >= 100) && (x <= 199))
 #define GSTCURL_SUCCESS_RESPONSE(x) ((x >= 200) && (x <=299))
 #define GSTCURL_REDIRECT_RESPONSE(x) ((x >= 300) && (x <= 399))
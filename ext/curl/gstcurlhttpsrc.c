@@ -104,7 +104,8 @@
  *
  * multi_task_context.task_rec_mutex is only used by GstTask.
  *
- * multi_task_context.mutex is used to protect access to queue and state
+ * multi_task_context.mutex is used to protect access to queue, ranges and
+ * state
  *
  * To avoid deadlock, it is vital that if both multi_task_context.mutex
  * and buffer_mutex are required, that they are locked in the order:
@@ -161,6 +162,8 @@ enum
   PROP_MAXCONCURRENT_GLOBAL,
   PROP_HTTPVERSION,
   PROP_IRADIO_MODE,
+  PROP_PARALLEL_RANGES,
+  PROP_RANGE_SIZE,
   PROP_MAX
 };
 
@@ -219,6 +222,14 @@ static size_t gst_curl_http_src_get_chunks (void *chunk, size_t size,
     size_t nmemb, void *src);
 static void gst_curl_http_src_request_remove (GstCurlHttpSrc * src);
 static void gst_curl_http_src_wait_until_removed (GstCurlHttpSrc * src);
+static gboolean gst_curl_http_src_schedule_ranges (GstCurlHttpSrc * src,
+    GstCurlHttpSrcMultiTaskContext * context);
+static GstFlowReturn gst_curl_http_src_drain_range (GstCurlHttpSrc * src,
+    GstBuffer ** outbuf);
+static void gst_curl_http_src_drop_ranges (GstCurlHttpSrc * src);
+static void gst_curl_http_src_free_range (GstCurlHttpSrcRange * range);
+static gboolean gst_curl_http_src_range_done (GstCurlHttpSrcMultiTaskContext *
+    context, CURL * handle, CURLcode result);
 static char *gst_curl_http_src_strcasestr (const char *haystack,
     const char *needle);
 #ifndef GST_DISABLE_GST_DEBUG
@@ -466,6 +477,39 @@ gst_curl_http_src_class_init (GstCurlHttpSrcClass * klass)
           GST_TYPE_CURL_HTTP_VERSION, pref_http_ver,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstCurlHttpSrc:parallel-ranges:
+   *
+   * Number of byte range requests to keep in flight for a single resource.
+   * When larger than 1 the resource is fetched in #GstCurlHttpSrc:range-size
+   * pieces which are requested concurrently and pushed downstream in order.
+   * This only takes effect if the server answers range requests, otherwise
+   * the resource is read in one go as usual.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_PARALLEL_RANGES,
+      g_param_spec_uint ("parallel-ranges", "Parallel Ranges",
+          "Number of concurrent byte range requests per resource (1=off)",
+          GSTCURL_MIN_PARALLEL_RANGES, GSTCURL_MAX_PARALLEL_RANGES,
+          GSTCURL_DEFAULT_PARALLEL_RANGES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstCurlHttpSrc:range-size:
+   *
+   * Size in bytes of each range request made when
+   * #GstCurlHttpSrc:parallel-ranges is enabled.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_RANGE_SIZE,
+      g_param_spec_uint ("range-size", "Range Size",
+          "Size in bytes of each parallel range request",
+          GSTCURL_MIN_RANGE_SIZE, GSTCURL_MAX_RANGE_SIZE,
+          GSTCURL_DEFAULT_RANGE_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /* Add a debugging task so it's easier to debug in the Multi worker thread */
   GST_DEBUG_CATEGORY_INIT (gst_curl_loop_debug, "curl_multi_loop", 0,
       "libcURL loop thread debugging");
@@ -477,6 +521,7 @@ gst_curl_http_src_class_init (GstCurlHttpSrcClass * klass)
   klass->multi_task_context.task = NULL;
   klass->multi_task_context.refcount = 0;
   klass->multi_task_context.queue = NULL;
+  klass->multi_task_context.ranges = NULL;
   klass->multi_task_context.state = GSTCURL_MULTI_LOOP_STATE_STOP;
   klass->multi_task_context.multi_handle = NULL;
   g_mutex_init (&klass->multi_task_context.mutex);
@@ -583,6 +628,12 @@ gst_curl_http_src_set_property (GObject * object, guint prop_id,
     case PROP_HTTPVERSION:
       source->preferred_http_version = g_value_get_enum (value);
       break;
+    case PROP_PARALLEL_RANGES:
+      source->parallel_ranges = g_value_get_uint (value);
+      break;
+    case PROP_RANGE_SIZE:
+      source->range_size = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -666,6 +717,12 @@ gst_curl_http_src_get_property (GObject * object, guint prop_id,
     case PROP_HTTPVERSION:
       g_value_set_enum (value, source->preferred_http_version);
       break;
+    case PROP_PARALLEL_RANGES:
+      g_value_set_uint (value, source->parallel_ranges);
+      break;
+    case PROP_RANGE_SIZE:
+      g_value_set_uint (value, source->range_size);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -712,6 +769,12 @@ gst_curl_http_src_init (GstCurlHttpSrc * source)
   source->content_size = 0;
   source->request_position = 0;
   source->stop_position = -1;
+  source->parallel_ranges = GSTCURL_DEFAULT_PARALLEL_RANGES;
+  source->range_size = GSTCURL_DEFAULT_RANGE_SIZE;
+  g_queue_init (&source->ranges);
+  source->range_template = NULL;
+  source->ranges_in_flight = 0;
+  source->range_next = -1;
 
   gst_base_src_set_automatic_eos (GST_BASE_SRC (source), FALSE);
 
@@ -762,16 +825,19 @@ gst_curl_http_src_ref_multi (GstCurlHttpSrc * src)
 
     /* NULL is treated as the start of the list, no need to allocate. */
     klass->multi_task_context.queue = NULL;
+    klass->multi_task_context.ranges = NULL;
 
     /* set up curl */
     klass->multi_task_context.multi_handle = curl_multi_init ();
 
+    /* Transfers of all instances to the same origin share a single HTTP/2
+     * connection where possible, see also CURLOPT_PIPEWAIT on the easy
+     * handles. HTTP/1.x transfers get up to max-connections-per-server
+     * connections of the instance that started the loop. */
     curl_multi_setopt (klass->multi_task_context.multi_handle,
-        CURLMOPT_PIPELINING, 1);
-#ifdef CURLMOPT_MAX_HOST_CONNECTIONS
+        CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
     curl_multi_setopt (klass->multi_task_context.multi_handle,
-        CURLMOPT_MAX_HOST_CONNECTIONS, 1);
-#endif
+        CURLMOPT_MAX_HOST_CONNECTIONS, (long) src->max_conns_per_server);
 
     /* Start the thread */
     g_rec_mutex_init (&klass->multi_task_context.task_rec_mutex);
@@ -889,6 +955,8 @@ retry:
 
   if (!src->transfer_begun) {
     GST_DEBUG_OBJECT (src, "Starting new request for URI %s", src->uri);
+    /* Anything left over from a previous attempt is of no use anymore */
+    gst_curl_http_src_drop_ranges (src);
     /* Create the Easy Handle and set up the session. */
     src->curl_handle = gst_curl_http_src_create_easy_handle (src);
     if (src->curl_handle == NULL) {
@@ -923,6 +991,11 @@ retry:
     GST_INFO_OBJECT (src, "Created a new headers object");
   }
 
+  if (!gst_curl_http_src_schedule_ranges (src, &klass->multi_task_context)) {
+    ret = GST_FLOW_ERROR;
+    goto escape;
+  }
+
   g_mutex_unlock (&klass->multi_task_context.mutex);
 
   /* Wait for data to become available, then punt it downstream */
@@ -1001,6 +1074,13 @@ retry:
     src->data_received = TRUE;
 
     /* ret should still be GST_FLOW_OK */
+  } else if ((src->state == GSTCURL_DONE) && (src->range_next >= 0)) {
+    /* The first range is in, carry on with the parallel ones */
+    ret = gst_curl_http_src_drain_range (src, outbuf);
+    if (ret == GST_FLOW_CUSTOM_SUCCESS) {
+      g_mutex_unlock (&src->buffer_mutex);
+      goto retry;
+    }
   } else if ((src->state == GSTCURL_DONE) && (src->buffer_len == 0)) {
     GST_INFO_OBJECT (src, "Full body received, signalling EOS for URI %s.",
         src->uri);
@@ -1076,6 +1156,7 @@ static CURL *
 gst_curl_http_src_create_easy_handle (GstCurlHttpSrc * s)
 {
   CURL *handle;
+  gint64 stop_position;
   gint i;
   GSTCURL_FUNCTION_ENTRY (s);
 
@@ -1149,9 +1230,20 @@ gst_curl_http_src_create_easy_handle (GstCurlHttpSrc * s)
   gst_curl_setopt_bool (s, handle, CURLOPT_SSL_VERIFYPEER, s->strict_ssl);
   gst_curl_setopt_str (s, handle, CURLOPT_CAINFO, s->custom_ca_file);
 
-  if (s->request_position || s->stop_position > 0) {
+  /* With parallel ranges, only ask for the first range here. The rest is
+     requested by gst_curl_http_src_schedule_ranges() once the server told
+     us how large the resource is */
+  stop_position = s->stop_position;
+  s->range_next = -1;
+  if (s->parallel_ranges > 1 && (stop_position < 1
+          || stop_position - s->request_position > s->range_size)) {
+    stop_position = s->request_position + s->range_size;
+    s->range_next = stop_position;
+  }
+
+  if (s->request_position || stop_position > 0) {
     gchar *range;
-    if (s->stop_position < 1) {
+    if (stop_position < 1) {
       /* start specified, no end specified */
       range = g_strdup_printf ("%" G_GINT64_FORMAT "-", s->request_position);
     } else {
@@ -1159,7 +1251,7 @@ gst_curl_http_src_create_easy_handle (GstCurlHttpSrc * s)
          in the range, whereas in HTTP the Content-Range header includes the
          byte listed in the end value */
       range = g_strdup_printf ("%" G_GINT64_FORMAT "-%" G_GINT64_FORMAT,
-          s->request_position, s->stop_position - 1);
+          s->request_position, stop_position - 1);
     }
     GST_TRACE_OBJECT (s, "Requesting range: %s", range);
     curl_easy_setopt (handle, CURLOPT_RANGE, range);
@@ -1196,6 +1288,14 @@ gst_curl_http_src_create_easy_handle (GstCurlHttpSrc * s)
           "Supplied a bogus HTTP version, using curl default!");
   }
 
+#ifdef CURL_VERSION_HTTP2
+  /* Rather wait for a connection to the same origin that can be multiplexed
+   * than open a new one */
+  if (s->preferred_http_version == GSTCURL_HTTP_VERSION_2_0) {
+    gst_curl_setopt_bool (s, handle, CURLOPT_PIPEWAIT, TRUE);
+  }
+#endif
+
   gst_curl_setopt_generic (s, handle, CURLOPT_HEADERFUNCTION,
       gst_curl_http_src_get_header);
   gst_curl_setopt_str (s, handle, CURLOPT_HEADERDATA, s);
@@ -1205,6 +1305,16 @@ gst_curl_http_src_create_easy_handle (GstCurlHttpSrc * s)
 
   gst_curl_setopt_str (s, handle, CURLOPT_ERRORBUFFER, s->curl_errbuf);
 
+  /* The parallel range requests are copies of this one. Take the copy now,
+     before the curl loop starts using the handle from its own thread */
+  if (s->range_template != NULL) {
+    curl_easy_cleanup (s->range_template);
+    s->range_template = NULL;
+  }
+  if (s->range_next >= 0) {
+    s->range_template = curl_easy_duphandle (handle);
+  }
+
   GSTCURL_FUNCTION_EXIT (s);
   return handle;
 }
@@ -1327,7 +1437,9 @@ gst_curl_http_src_handle_response (GstCurlHttpSrc * src)
         src->content_size = src->request_position + curl_info_offt;
       }
       basesrc = GST_BASE_SRC_CAST (src);
-      basesrc->segment.duration = src->request_position + curl_info_offt;
+      /* A ranged request only covers part of the resource, Content-Range
+         told us the full size in that case */
+      basesrc->segment.duration = src->content_size;
       if (src->seekable == GSTCURL_SEEKABLE_UNKNOWN) {
         src->seekable = GSTCURL_SEEKABLE_TRUE;
       }
@@ -1413,6 +1525,10 @@ gst_curl_http_src_destroy_easy_handle (GstCurlHttpSrc * src)
     curl_easy_cleanup (src->curl_handle);
     src->curl_handle = NULL;
   }
+  if (src->range_template != NULL) {
+    curl_easy_cleanup (src->range_template);
+    src->range_template = NULL;
+  }
   /* In addition, clean up the curl header slist if it was used. */
   if (src->slist != NULL) {
     curl_slist_free_all (src->slist);
@@ -1490,6 +1606,8 @@ gst_curl_http_src_cleanup_instance (GstCurlHttpSrc * src)
   g_free (src->user_agent);
   src->user_agent = NULL;
 
+  gst_curl_http_src_drop_ranges (src);
+
   g_mutex_clear (&src->buffer_mutex);
 
   g_cond_clear (&src->buffer_cond);
@@ -1712,6 +1830,14 @@ gst_curl_http_src_unlock (GstBaseSrc * bsrc)
       }
       want_removal = TRUE;
     }
+    if (!g_queue_is_empty (&src->ranges)) {
+      /* Outstanding ranges can't be resumed either */
+      gst_curl_http_src_drop_ranges (src);
+      if (src->state == GSTCURL_DONE) {
+        src->state = GSTCURL_REMOVED;
+      }
+      want_removal = TRUE;
+    }
     src->pending_state = src->state;
     src->state = GSTCURL_UNLOCK;
   }
@@ -1757,6 +1883,7 @@ gst_curl_http_src_curl_multi_loop (gpointer thread_data)
 {
   GstCurlHttpSrcMultiTaskContext *context;
   GstCurlHttpSrcQueueElement *qelement, *qnext;
+  GList *rlist, *rnext;
   gint i, still_running = 0;
   CURLMsg *curl_message;
   GstCurlHttpSrc *elt;
@@ -1769,7 +1896,7 @@ gst_curl_http_src_curl_multi_loop (gpointer thread_data)
   /* Someone is holding a reference to us, but isn't using us so to avoid
    * unnecessary clock cycle wasting, sit in a conditional wait until woken.
    */
-  while (context->queue == NULL
+  while (context->queue == NULL && context->ranges == NULL
       && context->state == GSTCURL_MULTI_LOOP_STATE_RUNNING) {
     GSTCURL_DEBUG_PRINT ("Waiting for an element to be added...");
     g_cond_wait (&context->signal, &context->mutex);
@@ -1809,6 +1936,36 @@ gst_curl_http_src_curl_multi_loop (gpointer thread_data)
     qelement = qnext;
   }
 
+  /* and the same for the byte ranges of parallel-ranges transfers */
+  for (rlist = context->ranges; rlist != NULL; rlist = rnext) {
+    GstCurlHttpSrcRange *range = rlist->data;
+
+    rnext = rlist->next;
+    elt = range->src;
+    g_mutex_lock (&elt->buffer_mutex);
+    if (range->cancel) {
+      if (range->added) {
+        curl_multi_remove_handle (context->multi_handle, range->handle);
+      }
+      context->ranges = g_list_delete_link (context->ranges, rlist);
+      elt->ranges_in_flight--;
+      g_cond_signal (&elt->buffer_cond);
+      g_mutex_unlock (&elt->buffer_mutex);
+      /* Nobody else knows about it anymore */
+      gst_curl_http_src_free_range (range);
+      continue;
+    }
+    active++;
+    if (!range->added) {
+      GSTCURL_DEBUG_PRINT ("Adding easy handle for range %" G_GINT64_FORMAT
+          "-%" G_GINT64_FORMAT " of URI %s", range->start, range->stop,
+          elt->uri);
+      curl_multi_add_handle (context->multi_handle, range->handle);
+      range->added = TRUE;
+    }
+    g_mutex_unlock (&elt->buffer_mutex);
+  }
+
   if (active == 0) {
     GSTCURL_DEBUG_PRINT ("No active elements");
     goto out;
@@ -1881,8 +2038,11 @@ gst_curl_http_src_curl_multi_loop (gpointer thread_data)
         if (curl_message->easy_handle != NULL) {
           curl_multi_remove_handle (context->multi_handle,
               curl_message->easy_handle);
-          gst_curl_http_src_remove_queue_handle (&context->queue,
-              curl_message->easy_handle, curl_message->data.result);
+          if (!gst_curl_http_src_range_done (context,
+                  curl_message->easy_handle, curl_message->data.result)) {
+            gst_curl_http_src_remove_queue_handle (&context->queue,
+                curl_message->easy_handle, curl_message->data.result);
+          }
         }
       }
     }
@@ -1992,8 +2152,8 @@ gst_curl_http_src_get_header (void *header, size_t size, size_t nmemb,
            the size of range requested, and the Content-Range header will
            have the start, stop and total size of the resource */
         gchar *size = strchr (header_value, '/');
-        if (size) {
-          s->content_size = atoi (size);
+        if (size && size[1] != '*') {
+          s->content_size = g_ascii_strtoull (size + 1, NULL, 10);
         }
       }
 
@@ -2088,6 +2248,7 @@ gst_curl_http_src_request_remove (GstCurlHttpSrc * src)
   if (src->connection_status == GSTCURL_CONNECTED) {
     src->connection_status = GSTCURL_WANT_REMOVAL;
   }
+  gst_curl_http_src_drop_ranges (src);
   g_mutex_unlock (&src->buffer_mutex);
   g_cond_signal (&klass->multi_task_context.signal);
   g_mutex_unlock (&klass->multi_task_context.mutex);
@@ -2103,12 +2264,307 @@ gst_curl_http_src_wait_until_removed (GstCurlHttpSrc * src)
 {
   gst_curl_http_src_request_remove (src);
   g_mutex_lock (&src->buffer_mutex);
-  while (src->connection_status != GSTCURL_NOT_CONNECTED) {
+  while (src->connection_status != GSTCURL_NOT_CONNECTED
+      || src->ranges_in_flight > 0) {
     g_cond_wait (&src->buffer_cond, &src->buffer_mutex);
   }
   g_mutex_unlock (&src->buffer_mutex);
 }
 
+/*****************************************************************************
+ * Parallel range requests
+ *****************************************************************************/
+static void
+gst_curl_http_src_free_range (GstCurlHttpSrcRange * range)
+{
+  if (range->handle != NULL) {
+    curl_easy_cleanup (range->handle);
+  }
+  curl_slist_free_all (range->slist);
+  g_free (range->buffer);
+  g_free (range);
+}
+
+/*
+ * The response headers we care about came with the first range already.
+ */
+static size_t
+gst_curl_http_src_range_get_header (void *header, size_t size, size_t nmemb,
+    void *data)
+{
+  return size * nmemb;
+}
+
+/*
+ * Receive chunks of a range request and keep them until ::create() is ready
+ * to push them.
+ */
+static size_t
+gst_curl_http_src_range_get_chunks (void *chunk, size_t size, size_t nmemb,
+    void *data)
+{
+  GstCurlHttpSrcRange *range = data;
+  GstCurlHttpSrc *s = range->src;
+  size_t chunk_len = size * nmemb;
+
+  g_mutex_lock (&s->buffer_mutex);
+  if (range->status_code == 0) {
+    curl_easy_getinfo (range->handle, CURLINFO_RESPONSE_CODE,
+        &range->status_code);
+  }
+  if (range->status_code != 206) {
+    /* Anything else isn't the bit of the resource we asked for */
+    GST_WARNING_OBJECT (s, "Range %" G_GINT64_FORMAT "-%" G_GINT64_FORMAT
+        " of URI %s answered with status %ld", range->start, range->stop - 1,
+        s->uri, range->status_code);
+    g_mutex_unlock (&s->buffer_mutex);
+    return 0;
+  }
+  range->buffer = g_realloc (range->buffer, range->buffer_len + chunk_len);
+  memcpy (range->buffer + range->buffer_len, chunk, chunk_len);
+  range->buffer_len += chunk_len;
+  range->received += chunk_len;
+  g_cond_signal (&s->buffer_cond);
+  g_mutex_unlock (&s->buffer_mutex);
+  return chunk_len;
+}
+
+static CURL *
+gst_curl_http_src_create_range_handle (GstCurlHttpSrc * s,
+    GstCurlHttpSrcRange * range)
+{
+  CURL *handle;
+  gchar *range_str;
+
+  if (s->range_template == NULL) {
+    GST_ERROR_OBJECT (s, "No request to base the range request on!");
+    return NULL;
+  }
+
+  handle = curl_easy_duphandle (s->range_template);
+  if (handle == NULL) {
+    GST_ERROR_OBJECT (s, "Couldn't init a curl easy handle!");
+    return NULL;
+  }
+
+  /* No need to go through the redirections again */
+  gst_curl_setopt_str (s, handle, CURLOPT_URL, s->redirect_uri);
+
+  /* The copy would share the header list with the first request, which may
+     be gone before this one is */
+  if (s->request_headers != NULL) {
+    gst_structure_foreach (s->request_headers, _headers_to_curl_slist,
+        &range->slist);
+    gst_curl_setopt_generic (s, handle, CURLOPT_HTTPHEADER, range->slist);
+  }
+
+  range_str = g_strdup_printf ("%" G_GINT64_FORMAT "-%" G_GINT64_FORMAT,
+      range->start, range->stop - 1);
+  GST_TRACE_OBJECT (s, "Requesting range: %s", range_str);
+  gst_curl_setopt_str (s, handle, CURLOPT_RANGE, range_str);
+  g_free (range_str);
+
+  gst_curl_setopt_generic (s, handle, CURLOPT_HEADERFUNCTION,
+      gst_curl_http_src_range_get_header);
+  gst_curl_setopt_generic (s, handle, CURLOPT_HEADERDATA, range);
+  gst_curl_setopt_generic (s, handle, CURLOPT_WRITEFUNCTION,
+      gst_curl_http_src_range_get_chunks);
+  gst_curl_setopt_generic (s, handle, CURLOPT_WRITEDATA, range);
+  gst_curl_setopt_generic (s, handle, CURLOPT_ERRORBUFFER, NULL);
+
+  return handle;
+}
+
+static gint64
+gst_curl_http_src_range_end (GstCurlHttpSrc * src)
+{
+  if (src->stop_position > 0 && src->stop_position < src->content_size) {
+    return src->stop_position;
+  }
+  return src->content_size;
+}
+
+/*
+ * Keep parallel_ranges requests in flight, the first one made by ::create()
+ * included, once its response told us that the server honours ranges and how
+ * large the resource is. Called with the multi_task_context mutex and
+ * buffer_mutex held. Returns FALSE if a request couldn't be set up.
+ */
+static gboolean
+gst_curl_http_src_schedule_ranges (GstCurlHttpSrc * src,
+    GstCurlHttpSrcMultiTaskContext * context)
+{
+  GstCurlHttpSrcRange *range;
+  guint n_ranges;
+  gint64 end;
+
+  if (src->range_next < 0) {
+    return TRUE;
+  }
+
+  /* Wait for all of the headers of the first response */
+  if (src->buffer_len == 0 && !src->data_received
+      && src->state != GSTCURL_DONE) {
+    return TRUE;
+  }
+
+  if (src->status_code != 206 || src->content_size == 0) {
+    GST_INFO_OBJECT (src, "No range support for URI %s, fetching it in one go",
+        src->uri);
+    src->range_next = -1;
+    return TRUE;
+  }
+
+  end = gst_curl_http_src_range_end (src);
+  n_ranges = g_queue_get_length (&src->ranges);
+  if (src->state == GSTCURL_OK) {
+    n_ranges++;
+  }
+
+  while (n_ranges < src->parallel_ranges && src->range_next < end) {
+    range = g_new0 (GstCurlHttpSrcRange, 1);
+    range->src = src;
+    range->start = src->range_next;
+    range->stop = MIN (range->start + src->range_size, end);
+    range->result = CURLE_OK;
+    range->handle = gst_curl_http_src_create_range_handle (src, range);
+    if (range->handle == NULL) {
+      gst_curl_http_src_free_range (range);
+      return FALSE;
+    }
+
+    GST_DEBUG_OBJECT (src, "Submitting range %" G_GINT64_FORMAT "-%"
+        G_GINT64_FORMAT " of URI %s to curl", range->start, range->stop - 1,
+        src->uri);
+    g_queue_push_tail (&src->ranges, range);
+    context->ranges = g_list_append (context->ranges, range);
+    src->ranges_in_flight++;
+    src->range_next = range->stop;
+    n_ranges++;
+  }
+  g_cond_signal (&context->signal);
+
+  return TRUE;
+}
+
+/*
+ * Hand the data of the oldest outstanding range to ::create(), waiting for it
+ * if needed. Returns GST_FLOW_CUSTOM_SUCCESS when there's nothing to hand out
+ * and ::create() should go round again so that more ranges get requested.
+ * Called with buffer_mutex held.
+ */
+static GstFlowReturn
+gst_curl_http_src_drain_range (GstCurlHttpSrc * src, GstBuffer ** outbuf)
+{
+  GstCurlHttpSrcRange *range;
+
+  range = g_queue_peek_head (&src->ranges);
+  if (range == NULL) {
+    if (src->range_next >= gst_curl_http_src_range_end (src)) {
+      GST_DEBUG_OBJECT (src, "All ranges of URI %s received", src->uri);
+      src->range_next = -1;
+    }
+    return GST_FLOW_CUSTOM_SUCCESS;
+  }
+
+  while (range->buffer_len == 0 && !range->done
+      && src->state == GSTCURL_DONE) {
+    g_cond_wait (&src->buffer_cond, &src->buffer_mutex);
+  }
+
+  /* Unlocked, the range may not even exist anymore */
+  if (src->state != GSTCURL_DONE) {
+    return GST_FLOW_FLUSHING;
+  }
+
+  if (range->buffer_len > 0) {
+    GST_DEBUG_OBJECT (src, "Pushing %u bytes of range %" G_GINT64_FORMAT "-%"
+        G_GINT64_FORMAT " for URI %s to pad", range->buffer_len, range->start,
+        range->stop - 1, src->uri);
+    *outbuf = gst_buffer_new_wrapped (range->buffer, range->buffer_len);
+    GST_BUFFER_OFFSET (*outbuf) = GST_BASE_SRC_CAST (src)->segment.position;
+    range->buffer = NULL;
+    range->buffer_len = 0;
+    return GST_FLOW_OK;
+  }
+
+  /* Complete, and curl is done with it */
+  g_queue_pop_head (&src->ranges);
+  if (range->result != CURLE_OK
+      || range->received != range->stop - range->start) {
+    GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL),
+        ("Range %" G_GINT64_FORMAT "-%" G_GINT64_FORMAT " of URI %s failed "
+            "after %" G_GUINT64_FORMAT " bytes: %s", range->start,
+            range->stop - 1, src->uri, range->received,
+            curl_easy_strerror (range->result)));
+    gst_curl_http_src_free_range (range);
+    return GST_FLOW_ERROR;
+  }
+  gst_curl_http_src_free_range (range);
+
+  return GST_FLOW_CUSTOM_SUCCESS;
+}
+
+/*
+ * Forget about all of the ranges. The ones curl is still working on are left
+ * for the curl loop to clean up, so make sure it gets woken up afterwards.
+ * Called with buffer_mutex held.
+ */
+static void
+gst_curl_http_src_drop_ranges (GstCurlHttpSrc * src)
+{
+  GstCurlHttpSrcRange *range;
+
+  while ((range = g_queue_pop_head (&src->ranges)) != NULL) {
+    if (range->done) {
+      gst_curl_http_src_free_range (range);
+    } else {
+      range->cancel = TRUE;
+    }
+  }
+  src->range_next = -1;
+}
+
+/*
+ * Called by the curl loop with the multi_task_context mutex held when a
+ * transfer has completed. Returns FALSE if it wasn't one of the ranges.
+ */
+static gboolean
+gst_curl_http_src_range_done (GstCurlHttpSrcMultiTaskContext * context,
+    CURL * handle, CURLcode result)
+{
+  GstCurlHttpSrcRange *range = NULL;
+  GstCurlHttpSrc *src;
+  gboolean orphaned;
+  GList *l;
+
+  for (l = context->ranges; l != NULL; l = l->next) {
+    range = l->data;
+    if (range->handle == handle) {
+      break;
+    }
+  }
+  if (l == NULL) {
+    return FALSE;
+  }
+
+  context->ranges = g_list_delete_link (context->ranges, l);
+  src = range->src;
+  g_mutex_lock (&src->buffer_mutex);
+  range->result = result;
+  range->done = TRUE;
+  orphaned = range->cancel;
+  src->ranges_in_flight--;
+  g_cond_signal (&src->buffer_cond);
+  g_mutex_unlock (&src->buffer_mutex);
+
+  if (orphaned) {
+    gst_curl_http_src_free_range (range);
+  }
+
+  return TRUE;
+}
+
 #ifndef GST_DISABLE_GST_DEBUG
 /*
  * This callback receives debug information, as specified in the type argument.
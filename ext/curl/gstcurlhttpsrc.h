@@ -83,6 +83,7 @@ typedef struct _GstCurlHttpSrc GstCurlHttpSrc;
 typedef struct _GstCurlHttpSrcClass GstCurlHttpSrcClass;
 typedef struct _GstCurlHttpSrcMultiTaskContext GstCurlHttpSrcMultiTaskContext;
 typedef struct _GstCurlHttpSrcQueueElement GstCurlHttpSrcQueueElement;
+typedef struct _GstCurlHttpSrcRange GstCurlHttpSrcRange;
 
 #define HTTP_HEADERS_NAME       "http-headers"
 #define HTTP_STATUS_CODE        "http-status-code"
@@ -118,6 +119,8 @@ struct _GstCurlHttpSrcMultiTaskContext
   GCond       signal;
 
   GstCurlHttpSrcQueueElement  *queue;
+  /* byte ranges of parallel-ranges transfers curl is still working on */
+  GList       *ranges;
 
   enum
   {
@@ -136,6 +139,29 @@ struct _GstCurlHttpSrcClass
   GstCurlHttpSrcMultiTaskContext multi_task_context;
 };
 
+/*
+ * One byte range request of a parallel-ranges transfer. It sits in the
+ * element's ranges queue in offset order and, until curl is done with it, in
+ * multi_task_context.ranges too. Fields are protected by the element's
+ * buffer_mutex.
+ */
+struct _GstCurlHttpSrcRange
+{
+  GstCurlHttpSrc *src;
+  CURL *handle;
+  struct curl_slist *slist;
+  gint64 start;                 /* first byte of the range */
+  gint64 stop;                  /* first byte after the range */
+  gchar *buffer;
+  guint buffer_len;
+  guint64 received;
+  glong status_code;
+  gboolean added;               /* handed to the multi handle */
+  gboolean cancel;              /* curl loop should drop and free it */
+  gboolean done;                /* curl loop won't touch it anymore */
+  CURLcode result;
+};
+
 /*
  * Our instance class.
  */
@@ -189,6 +215,14 @@ struct _GstCurlHttpSrc
   /* Some stuff for HTTP/2 */
   GstCurlHttpVersion preferred_http_version;
 
+  /* Parallel range requests */
+  guint parallel_ranges;
+  guint range_size;
+  CURL *range_template;         /* copied for each range request */
+  GQueue ranges;                /* GstCurlHttpSrcRange, in offset order */
+  guint ranges_in_flight;       /* of ours in multi_task_context.ranges */
+  gint64 range_next;            /* next byte to request, -1 if not ranging */
+
   enum
   {
     GSTCURL_NONE,
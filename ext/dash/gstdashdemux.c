@@ -359,7 +359,9 @@ struct _GstDashDemuxClockDrift
 typedef struct
 {
   guint64 start_offset, end_offset;
-  /* TODO: Timestamp and duration */
+  /* relative to the start of the fragment, GST_CLOCK_TIME_NONE if the
+   * sample durations are unknown */
+  GstClockTime timestamp;
 } GstDashStreamSyncSample;
 
 /* GObject */
@@ -1303,13 +1305,30 @@ gst_dash_demux_stream_update_fragment_info (GstAdaptiveDemuxStream * stream)
 
     dashstream->current_fragment_keyframe_distance =
         fragment.duration / dashstream->moof_sync_samples->len;
-    dashstream->actual_position =
-        fragment.timestamp +
-        dashstream->current_sync_sample *
-        dashstream->current_fragment_keyframe_distance;
-    if (stream->segment.rate < 0.0)
-      dashstream->actual_position +=
+    if (GST_CLOCK_TIME_IS_VALID (sync_sample->timestamp)) {
+      GstClockTime position = sync_sample->timestamp;
+
+      /* In reverse the position is the end of this key unit */
+      if (stream->segment.rate < 0.0) {
+        if (dashstream->current_sync_sample + 1 <
+            dashstream->moof_sync_samples->len)
+          position =
+              g_array_index (dashstream->moof_sync_samples,
+              GstDashStreamSyncSample,
+              dashstream->current_sync_sample + 1).timestamp;
+        else
+          position = fragment.duration;
+      }
+      dashstream->actual_position = fragment.timestamp + position;
+    } else {
+      dashstream->actual_position =
+          fragment.timestamp +
+          dashstream->current_sync_sample *
           dashstream->current_fragment_keyframe_distance;
+      if (stream->segment.rate < 0.0)
+        dashstream->actual_position +=
+            dashstream->current_fragment_keyframe_distance;
+    }
     dashstream->actual_position =
         MIN (dashstream->actual_position,
         fragment.timestamp + fragment.duration);
@@ -1580,14 +1599,48 @@ gst_dash_demux_stream_has_next_subfragment (GstAdaptiveDemuxStream * stream)
   return FALSE;
 }
 
+/* Returns the index of the last sync sample of the current fragment that
+ * starts at or before @target_time, -1 if there is none */
+static gint
+gst_dash_demux_stream_find_sync_sample (GstDashDemuxStream * dashstream,
+    GstClockTime target_time)
+{
+  GArray *samples = dashstream->moof_sync_samples;
+  GstClockTime offset;
+  guint lo = 0, hi = samples->len;
+
+  if (target_time < dashstream->current_fragment_timestamp)
+    return -1;
+  offset = target_time - dashstream->current_fragment_timestamp;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    if (g_array_index (samples, GstDashStreamSyncSample, mid).timestamp <=
+        offset)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return (gint) lo - 1;
+}
+
 static gboolean
 gst_dash_demux_stream_advance_sync_sample (GstAdaptiveDemuxStream * stream,
     GstClockTime target_time)
 {
   GstDashDemuxStream *dashstream = (GstDashDemuxStream *) stream;
   gboolean fragment_finished = FALSE;
+  gboolean have_timestamps;
   guint idx = -1;
 
+  /* Sync sample timestamps are either all known or all unknown */
+  have_timestamps =
+      GST_CLOCK_TIME_IS_VALID (g_array_index (dashstream->moof_sync_samples,
+          GstDashStreamSyncSample, 0).timestamp)
+      && GST_CLOCK_TIME_IS_VALID (dashstream->current_fragment_timestamp);
+
   if (GST_CLOCK_TIME_IS_VALID (target_time)) {
     GST_LOG_OBJECT (stream->pad,
         "target_time:%" GST_TIME_FORMAT " fragment ts %" GST_TIME_FORMAT
@@ -1601,10 +1654,17 @@ gst_dash_demux_stream_advance_sync_sample (GstAdaptiveDemuxStream * stream,
         GST_TIME_ARGS (stream->fragment.duration));
 
     if (stream->demux->segment.rate > 0.0) {
-      idx =
-          (target_time -
-          dashstream->current_fragment_timestamp) /
-          dashstream->current_fragment_keyframe_distance;
+      if (have_timestamps) {
+        gint found =
+            gst_dash_demux_stream_find_sync_sample (dashstream, target_time);
+
+        idx = MAX (found, 0);
+      } else {
+        idx =
+            (target_time -
+            dashstream->current_fragment_timestamp) /
+            dashstream->current_fragment_keyframe_distance;
+      }
 
       /* Prevent getting stuck in a loop due to rounding errors */
       if (idx == dashstream->current_sync_sample)
@@ -1616,6 +1676,16 @@ gst_dash_demux_stream_advance_sync_sample (GstAdaptiveDemuxStream * stream,
 
       if (end_time < target_time) {
         idx = dashstream->moof_sync_samples->len;
+      } else if (have_timestamps) {
+        gint found =
+            gst_dash_demux_stream_find_sync_sample (dashstream, target_time);
+
+        if (found < 0) {
+          dashstream->current_sync_sample = -1;
+          fragment_finished = TRUE;
+          goto beach;
+        }
+        idx = found;
       } else {
         idx =
             (end_time -
@@ -2422,6 +2492,18 @@ gst_dash_demux_update_manifest_data (GstAdaptiveDemux * demux,
 
     GST_DEBUG_OBJECT (demux, "Updating manifest");
 
+    /* Usually only the timelines of live manifests change, which can be
+     * done without setting up everything again */
+    if (gst_mpd_client_update_live (dashdemux->client, new_client)) {
+      GST_DEBUG_OBJECT (demux, "Manifest file updated in place");
+      gst_mpd_client_free (new_client);
+      gst_buffer_unmap (buffer, &mapinfo);
+      if (dashdemux->clock_drift) {
+        gst_dash_demux_poll_clock_drift (dashdemux);
+      }
+      return GST_FLOW_OK;
+    }
+
     period_id = gst_mpd_client_get_period_id (dashdemux->client);
     period_idx = gst_mpd_client_get_period_index (dashdemux->client);
 
@@ -3037,129 +3119,91 @@ gst_dash_demux_find_sync_samples (GstAdaptiveDemux * demux,
 {
   GstDashDemux *dashdemux = (GstDashDemux *) stream->demux;
   GstDashDemuxStream *dash_stream = (GstDashDemuxStream *) stream;
+  GArray *samples;
   guint i;
   guint32 track_id = 0;
-  guint64 prev_traf_end;
   gboolean trex_sample_flags = FALSE;
+  gboolean have_durations = TRUE;
+  guint64 total_duration = 0;
+  GstClockTime fragment_duration;
 
   if (!dash_stream->moof) {
     dashdemux->allow_trickmode_key_units = FALSE;
     return FALSE;
   }
 
+  samples =
+      gst_isoff_moof_box_get_samples (dash_stream->moof,
+      dash_stream->moof_offset);
+  if (!samples) {
+    GST_FIXME_OBJECT (stream->pad,
+        "Sample size given by trex - can't download only keyframes");
+    dashdemux->allow_trickmode_key_units = FALSE;
+    return FALSE;
+  }
+
+  if (gst_mpd_client_has_isoff_ondemand_profile (dashdemux->client)
+      && dash_stream->sidx_position != GST_CLOCK_TIME_NONE
+      && SIDX (dash_stream)->entries)
+    fragment_duration = SIDX_CURRENT_ENTRY (dash_stream)->duration;
+  else
+    fragment_duration = stream->fragment.duration;
+
   dash_stream->current_sync_sample = -1;
   dash_stream->moof_sync_samples =
       g_array_new (FALSE, FALSE, sizeof (GstDashStreamSyncSample));
 
-  prev_traf_end = dash_stream->moof_offset;
-
-  /* generate table of keyframes and offsets */
-  for (i = 0; i < dash_stream->moof->traf->len; i++) {
-    GstTrafBox *traf = &g_array_index (dash_stream->moof->traf, GstTrafBox, i);
-    guint64 traf_offset = 0, prev_trun_end;
-    guint j;
+  /* generate table of keyframes and offsets, the timestamps are first
+   * collected in track timescale units */
+  for (i = 0; i < samples->len; i++) {
+    GstIsoffSample *sample = &g_array_index (samples, GstIsoffSample, i);
 
     if (i == 0) {
-      track_id = traf->tfhd.track_id;
-    } else if (track_id != traf->tfhd.track_id) {
+      track_id = sample->track_id;
+    } else if (track_id != sample->track_id) {
       GST_ERROR_OBJECT (stream->pad,
           "moof with trafs of different track ids (%u != %u)", track_id,
-          traf->tfhd.track_id);
+          sample->track_id);
+      g_array_free (samples, TRUE);
       g_array_free (dash_stream->moof_sync_samples, TRUE);
       dash_stream->moof_sync_samples = NULL;
       dashdemux->allow_trickmode_key_units = FALSE;
       return FALSE;
     }
 
-    if (traf->tfhd.flags & GST_TFHD_FLAGS_BASE_DATA_OFFSET_PRESENT) {
-      traf_offset = traf->tfhd.base_data_offset;
-    } else if (traf->tfhd.flags & GST_TFHD_FLAGS_DEFAULT_BASE_IS_MOOF) {
-      traf_offset = dash_stream->moof_offset;
-    } else {
-      traf_offset = prev_traf_end;
-    }
-
-    prev_trun_end = traf_offset;
-
-    for (j = 0; j < traf->trun->len; j++) {
-      GstTrunBox *trun = &g_array_index (traf->trun, GstTrunBox, j);
-      guint64 trun_offset, prev_sample_end;
-      guint k;
-
-      if (trun->flags & GST_TRUN_FLAGS_DATA_OFFSET_PRESENT) {
-        trun_offset = traf_offset + trun->data_offset;
-      } else {
-        trun_offset = prev_trun_end;
-      }
-
-      prev_sample_end = trun_offset;
-      for (k = 0; k < trun->samples->len; k++) {
-        GstTrunSample *sample =
-            &g_array_index (trun->samples, GstTrunSample, k);
-        guint64 sample_offset;
-        guint32 sample_flags;
-#if 0
-        guint32 sample_duration;
-#endif
-
-        sample_offset = prev_sample_end;
+    if (!sample->has_flags) {
+      trex_sample_flags = TRUE;
+    } else if (!GST_ISOFF_SAMPLE_FLAGS_SAMPLE_IS_NON_SYNC_SAMPLE (sample->flags)
+        || GST_ISOFF_SAMPLE_FLAGS_SAMPLE_DEPENDS_ON (sample->flags) == 2) {
+      /* Non-non-sync sample aka sync sample */
+      GstDashStreamSyncSample sync_sample;
 
-        if (trun->flags & GST_TRUN_FLAGS_SAMPLE_FLAGS_PRESENT) {
-          sample_flags = sample->sample_flags;
-        } else if ((trun->flags & GST_TRUN_FLAGS_FIRST_SAMPLE_FLAGS_PRESENT)
-            && k == 0) {
-          sample_flags = trun->first_sample_flags;
-        } else if (traf->tfhd.
-            flags & GST_TFHD_FLAGS_DEFAULT_SAMPLE_FLAGS_PRESENT) {
-          sample_flags = traf->tfhd.default_sample_flags;
-        } else {
-          trex_sample_flags = TRUE;
-          continue;
-        }
-
-#if 0
-        if (trun->flags & GST_TRUN_FLAGS_SAMPLE_DURATION_PRESENT) {
-          sample_duration = sample->sample_duration;
-        } else if (traf->tfhd.
-            flags & GST_TFHD_FLAGS_DEFAULT_SAMPLE_DURATION_PRESENT) {
-          sample_duration = traf->tfhd.default_sample_duration;
-        } else {
-          GST_FIXME_OBJECT (stream->pad,
-              "Sample duration given by trex - can't download only keyframes");
-          g_array_free (dash_stream->moof_sync_samples, TRUE);
-          dash_stream->moof_sync_samples = NULL;
-          return FALSE;
-        }
-#endif
-
-        if (trun->flags & GST_TRUN_FLAGS_SAMPLE_SIZE_PRESENT) {
-          prev_sample_end += sample->sample_size;
-        } else if (traf->tfhd.
-            flags & GST_TFHD_FLAGS_DEFAULT_SAMPLE_SIZE_PRESENT) {
-          prev_sample_end += traf->tfhd.default_sample_size;
-        } else {
-          GST_FIXME_OBJECT (stream->pad,
-              "Sample size given by trex - can't download only keyframes");
-          g_array_free (dash_stream->moof_sync_samples, TRUE);
-          dash_stream->moof_sync_samples = NULL;
-          dashdemux->allow_trickmode_key_units = FALSE;
-          return FALSE;
-        }
-
-        /* Non-non-sync sample aka sync sample */
-        if (!GST_ISOFF_SAMPLE_FLAGS_SAMPLE_IS_NON_SYNC_SAMPLE (sample_flags) ||
-            GST_ISOFF_SAMPLE_FLAGS_SAMPLE_DEPENDS_ON (sample_flags) == 2) {
-          GstDashStreamSyncSample sync_sample =
-              { sample_offset, prev_sample_end - 1 };
-          /* TODO: need timestamps so we can decide to download or not */
-          g_array_append_val (dash_stream->moof_sync_samples, sync_sample);
-        }
-      }
-
-      prev_trun_end = prev_sample_end;
+      sync_sample.start_offset = sample->offset;
+      sync_sample.end_offset = sample->offset + sample->size - 1;
+      sync_sample.timestamp = total_duration;
+      g_array_append_val (dash_stream->moof_sync_samples, sync_sample);
     }
 
-    prev_traf_end = prev_trun_end;
+    if (sample->duration == 0)
+      have_durations = FALSE;
+    total_duration += sample->duration;
+  }
+  g_array_free (samples, TRUE);
+
+  /* Convert to a position in the fragment, assuming that the samples cover
+   * the whole fragment */
+  for (i = 0; i < dash_stream->moof_sync_samples->len; i++) {
+    GstDashStreamSyncSample *sync_sample =
+        &g_array_index (dash_stream->moof_sync_samples,
+        GstDashStreamSyncSample, i);
+
+    if (have_durations && total_duration > 0
+        && GST_CLOCK_TIME_IS_VALID (fragment_duration))
+      sync_sample->timestamp =
+          gst_util_uint64_scale (sync_sample->timestamp, fragment_duration,
+          total_duration);
+    else
+      sync_sample->timestamp = GST_CLOCK_TIME_NONE;
   }
 
   if (trex_sample_flags) {
@@ -158,6 +158,7 @@ static const DashSinkMuxer dash_muxer_list[] = {
 #define DEFAULT_MPD_USE_SEGMENT_LIST FALSE
 #define DEFAULT_MPD_MIN_BUFFER_TIME 2000
 #define DEFAULT_MPD_PERIOD_DURATION GST_CLOCK_TIME_NONE
+#define DEFAULT_CHUNK_DURATION 0
 
 #define DEFAULT_DASH_SINK_MUXER GST_DASH_SINK_MUXER_TS
 
@@ -183,6 +184,7 @@ enum
   PROP_MPD_MIN_BUFFER_TIME,
   PROP_MPD_BASEURL,
   PROP_MPD_PERIOD_DURATION,
+  PROP_CHUNK_DURATION,
 };
 
 typedef enum
@@ -256,6 +258,7 @@ struct _GstDashSink
   guint64 minimum_update_period;
   guint64 min_buffer_time;
   gint64 period_duration;
+  guint chunk_duration;
 };
 
 static GstStaticPadTemplate video_sink_template =
@@ -445,13 +448,38 @@ gst_dash_sink_class_init (GstDashSinkClass * klass)
           G_MAXUINT64, DEFAULT_MPD_PERIOD_DURATION,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstDashSink:chunk-duration:
+   *
+   * Duration in milliseconds of the CMAF chunks of a segment. When set and
+   * the mp4 muxer is used, every segment is written as a sequence of
+   * moof/mdat chunks which are flushed to storage as soon as they are
+   * produced, and a dynamic MPD advertises the chunks through the
+   * availabilityTimeOffset of its segment templates.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class,
+      PROP_CHUNK_DURATION,
+      g_param_spec_uint ("chunk-duration", "Chunk duration",
+          "Duration in milliseconds of the CMAF chunks of a segment, only "
+          "used with the mp4 muxer (0 - disabled)", 0, G_MAXUINT,
+          DEFAULT_CHUNK_DURATION, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_type_mark_as_plugin_api (GST_TYPE_DASH_SINK_MUXER, 0);
 }
 
+static gboolean
+gst_dash_sink_is_chunked (GstDashSink * sink)
+{
+  return sink->chunk_duration > 0 && sink->muxer == GST_DASH_SINK_MUXER_MP4;
+}
+
 static gboolean
 gst_dash_sink_add_splitmuxsink (GstDashSink * sink, GstDashSinkStream * stream)
 {
   GstElement *mux = NULL;
+  GstElement *filesink = NULL;
   gchar *segment_tpl;
   gchar *segment_tpl_path;
   guint start_index = 0;
@@ -465,12 +493,32 @@ gst_dash_sink_add_splitmuxsink (GstDashSink * sink, GstDashSinkStream * stream)
 
   g_return_val_if_fail (mux != NULL, FALSE);
 
+  if (gst_dash_sink_is_chunked (sink)) {
+    /* Every fragment of the muxer is a CMAF chunk. Don't let the muxer
+     * rewrite the headers at the end, and push each chunk to storage right
+     * away so that clients can fetch it while the segment is still being
+     * written. */
+    g_object_set (mux, "fragment-duration", sink->chunk_duration,
+        "streamable", TRUE, NULL);
+    filesink = gst_element_factory_make ("filesink", NULL);
+    if (filesink)
+      gst_util_set_object_arg (G_OBJECT (filesink), "buffer-mode",
+          "unbuffered");
+  } else if (sink->chunk_duration > 0) {
+    GST_WARNING_OBJECT (sink, "Chunked output requires the mp4 muxer");
+  }
+
   stream->splitmuxsink = gst_element_factory_make ("splitmuxsink", NULL);
   if (stream->splitmuxsink == NULL) {
     gst_object_unref (mux);
+    if (filesink)
+      gst_object_unref (filesink);
     return FALSE;
   }
 
+  if (filesink)
+    g_object_set (stream->splitmuxsink, "sink", filesink, NULL);
+
   gst_bin_add (GST_BIN (sink), stream->splitmuxsink);
   if (sink->use_segment_list)
     segment_tpl =
@@ -513,6 +561,7 @@ gst_dash_sink_init (GstDashSink * sink)
 
   sink->min_buffer_time = DEFAULT_MPD_MIN_BUFFER_TIME;
   sink->period_duration = DEFAULT_MPD_PERIOD_DURATION;
+  sink->chunk_duration = DEFAULT_CHUNK_DURATION;
 
   g_mutex_init (&sink->mpd_lock);
 
@@ -641,6 +690,17 @@ gst_dash_sink_generate_mpd_content (GstDashSink * sink,
             sink->current_period_id, stream->adaptation_set_id,
             stream->representation_id, "media", media_segment_template,
             "duration", sink->target_duration, NULL);
+        if (sink->is_dynamic && gst_dash_sink_is_chunked (sink)) {
+          /* The first chunk is available once it has been written, one
+           * chunk duration after the segment start */
+          gdouble offset =
+              sink->target_duration - sink->chunk_duration / 1000.0;
+
+          gst_mpd_client_set_segment_template (sink->mpd_client,
+              sink->current_period_id, stream->adaptation_set_id,
+              stream->representation_id, "availability-time-offset",
+              MAX (offset, 0.0), "availability-time-complete", FALSE, NULL);
+        }
         g_free (media_segment_template);
       }
     }
@@ -930,6 +990,9 @@ gst_dash_sink_set_property (GObject * object, guint prop_id,
     case PROP_MPD_PERIOD_DURATION:
       sink->period_duration = g_value_get_uint64 (value);
       break;
+    case PROP_CHUNK_DURATION:
+      sink->chunk_duration = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -976,6 +1039,9 @@ gst_dash_sink_get_property (GObject * object, guint prop_id,
     case PROP_MPD_PERIOD_DURATION:
       g_value_set_uint64 (value, sink->period_duration);
       break;
+    case PROP_CHUNK_DURATION:
+      g_value_set_uint (value, sink->chunk_duration);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1658,6 +1658,389 @@ gst_mpd_client_setup_streaming (GstMPDClient * client,
   return TRUE;
 }
 
+typedef struct
+{
+  GstMPDSegmentTemplateNode *seg_template;      /* template being updated */
+  GQueue S;                     /* new S nodes to append to its timeline */
+  guint n_removed;              /* S nodes gone from the front of the timeline */
+  guint removed_segments;       /* number of segments in them */
+} GstMPDTimelineUpdate;
+
+static void
+gst_mpd_timeline_update_free (GstMPDTimelineUpdate * update)
+{
+  g_queue_foreach (&update->S, (GFunc) gst_mpd_s_node_free, NULL);
+  g_queue_clear (&update->S);
+  g_slice_free (GstMPDTimelineUpdate, update);
+}
+
+/* Computes how the SegmentTimeline of @cur has to change to match the one of
+ * @update, assuming the latter only lost S nodes at its front and got new
+ * ones at its end */
+static gboolean
+gst_mpd_client_prepare_timeline_update (GstMPDSegmentTemplateNode * cur,
+    GstMPDSegmentTemplateNode * update, GList ** updates)
+{
+  GstMPDMultSegmentBaseNode *cur_seg = GST_MPD_MULT_SEGMENT_BASE_NODE (cur);
+  GstMPDMultSegmentBaseNode *new_seg = GST_MPD_MULT_SEGMENT_BASE_NODE (update);
+  GstMPDTimelineUpdate *timeline_update;
+  GList *list;
+  guint64 start = 0, end, new_start = 0;
+  guint number;
+
+  if (g_queue_is_empty (&new_seg->SegmentTimeline->S))
+    return FALSE;
+
+  timeline_update = g_slice_new0 (GstMPDTimelineUpdate);
+  timeline_update->seg_template = cur;
+  g_queue_init (&timeline_update->S);
+  *updates = g_list_prepend (*updates, timeline_update);
+
+  for (list = g_queue_peek_head_link (&cur_seg->SegmentTimeline->S); list;
+      list = g_list_next (list)) {
+    GstMPDSNode *S = list->data;
+
+    if (S->r < 0)
+      return FALSE;
+    if (S->t > 0)
+      start = S->t;
+    start += S->d * (S->r + 1);
+  }
+  end = start;
+
+  start = 0;
+  for (list = g_queue_peek_head_link (&new_seg->SegmentTimeline->S); list;
+      list = g_list_next (list)) {
+    GstMPDSNode *S = list->data;
+    guint64 S_end;
+
+    if (S->r < 0)
+      return FALSE;
+    if (S->t > 0)
+      start = S->t;
+    if (list->prev == NULL)
+      new_start = start;
+    S_end = start + S->d * (S->r + 1);
+
+    if (S_end > end) {
+      GstMPDSNode *new_S = gst_mpd_s_node_clone (S);
+
+      if (start < end) {
+        /* more repetitions of the last known S node */
+        if (S->d == 0 || (end - start) % S->d != 0) {
+          gst_mpd_s_node_free (new_S);
+          return FALSE;
+        }
+        new_S->r -= (end - start) / S->d;
+        start = end;
+      }
+      new_S->t = start;
+      g_queue_push_tail (&timeline_update->S, new_S);
+    }
+    start = S_end;
+  }
+
+  /* S nodes that went out of the time shift buffer, and the number of the
+   * segment the new timeline starts with */
+  start = 0;
+  number = cur_seg->startNumber;
+  for (list = g_queue_peek_head_link (&cur_seg->SegmentTimeline->S); list;
+      list = g_list_next (list)) {
+    GstMPDSNode *S = list->data;
+    guint64 S_end;
+
+    if (S->t > 0)
+      start = S->t;
+    S_end = start + S->d * (S->r + 1);
+    if (S_end > new_start) {
+      if (new_start > start && S->d > 0)
+        number += (new_start - start) / S->d;
+      break;
+    }
+    number += S->r + 1;
+    if (list->next) {
+      timeline_update->n_removed++;
+      timeline_update->removed_segments += S->r + 1;
+    }
+    start = S_end;
+  }
+
+  /* segment numbers have to keep matching */
+  if (cur->media && strstr (cur->media, "$Number")
+      && number != new_seg->startNumber)
+    return FALSE;
+
+  return TRUE;
+}
+
+static gboolean
+gst_mpd_client_prepare_template_update (GstMPDSegmentTemplateNode * cur,
+    GstMPDSegmentTemplateNode * update, GList ** updates)
+{
+  GstMPDMultSegmentBaseNode *cur_seg, *new_seg;
+
+  if (cur == NULL && update == NULL)
+    return TRUE;
+  if (cur == NULL || update == NULL)
+    return FALSE;
+
+  if (g_strcmp0 (cur->media, update->media) != 0
+      || g_strcmp0 (cur->index, update->index) != 0
+      || g_strcmp0 (cur->initialization, update->initialization) != 0)
+    return FALSE;
+
+  cur_seg = GST_MPD_MULT_SEGMENT_BASE_NODE (cur);
+  new_seg = GST_MPD_MULT_SEGMENT_BASE_NODE (update);
+  if (cur_seg->duration != new_seg->duration
+      || (cur_seg->SegmentBase == NULL) != (new_seg->SegmentBase == NULL)
+      || (cur_seg->SegmentTimeline == NULL) !=
+      (new_seg->SegmentTimeline == NULL))
+    return FALSE;
+
+  if (cur_seg->SegmentBase &&
+      (cur_seg->SegmentBase->timescale != new_seg->SegmentBase->timescale
+          || cur_seg->SegmentBase->presentationTimeOffset !=
+          new_seg->SegmentBase->presentationTimeOffset))
+    return FALSE;
+
+  if (cur_seg->SegmentTimeline == NULL)
+    return cur_seg->startNumber == new_seg->startNumber;
+
+  return gst_mpd_client_prepare_timeline_update (cur, update, updates);
+}
+
+static gboolean
+gst_mpd_client_prepare_period_update (GstMPDPeriodNode * cur,
+    GstMPDPeriodNode * update, GList ** updates)
+{
+  GList *cur_as, *new_as;
+
+  if (g_strcmp0 (cur->id, update->id) != 0 || cur->start != update->start
+      || cur->duration != update->duration
+      || cur->SegmentList || update->SegmentList
+      || cur->SegmentBase || update->SegmentBase
+      || g_list_length (cur->AdaptationSets) !=
+      g_list_length (update->AdaptationSets))
+    return FALSE;
+
+  if (!gst_mpd_client_prepare_template_update (cur->SegmentTemplate,
+          update->SegmentTemplate, updates))
+    return FALSE;
+
+  for (cur_as = cur->AdaptationSets, new_as = update->AdaptationSets; cur_as;
+      cur_as = cur_as->next, new_as = new_as->next) {
+    GstMPDAdaptationSetNode *cur_set = cur_as->data;
+    GstMPDAdaptationSetNode *new_set = new_as->data;
+    GList *cur_rep, *new_rep;
+
+    if (cur_set->id != new_set->id
+        || cur_set->SegmentList || new_set->SegmentList
+        || cur_set->SegmentBase || new_set->SegmentBase
+        || g_list_length (cur_set->Representations) !=
+        g_list_length (new_set->Representations))
+      return FALSE;
+
+    if (!gst_mpd_client_prepare_template_update (cur_set->SegmentTemplate,
+            new_set->SegmentTemplate, updates))
+      return FALSE;
+
+    for (cur_rep = cur_set->Representations,
+        new_rep = new_set->Representations; cur_rep;
+        cur_rep = cur_rep->next, new_rep = new_rep->next) {
+      GstMPDRepresentationNode *cur_representation = cur_rep->data;
+      GstMPDRepresentationNode *new_representation = new_rep->data;
+
+      if (g_strcmp0 (cur_representation->id, new_representation->id) != 0
+          || cur_representation->bandwidth != new_representation->bandwidth
+          || cur_representation->SegmentList
+          || new_representation->SegmentList
+          || cur_representation->SegmentBase
+          || new_representation->SegmentBase)
+        return FALSE;
+
+      if (!gst_mpd_client_prepare_template_update
+          (cur_representation->SegmentTemplate,
+              new_representation->SegmentTemplate, updates))
+        return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/* Brings the segment list of @stream in line with its updated timeline */
+static void
+gst_mpd_client_apply_stream_update (GstMPDClient * client,
+    GstActiveStream * stream, GstMPDTimelineUpdate * update)
+{
+  GstMPDMultSegmentBaseNode *mult_seg =
+      GST_MPD_MULT_SEGMENT_BASE_NODE (update->seg_template);
+  GstStreamPeriod *stream_period;
+  GstClockTime period_end, presentationTimeOffset;
+  guint timescale, number, n_removed;
+  GList *list;
+
+  stream_period = gst_mpd_client_get_stream_period (client);
+  if (GST_CLOCK_TIME_IS_VALID (stream_period->duration))
+    period_end = stream_period->start + stream_period->duration;
+  else
+    period_end = GST_CLOCK_TIME_NONE;
+
+  /* only drop the segments that were played already */
+  n_removed = MIN (update->n_removed, MAX (stream->segment_index, 0));
+  if (n_removed > 0) {
+    g_ptr_array_remove_range (stream->segments, 0, n_removed);
+    stream->segment_index -= n_removed;
+  }
+
+  if (stream->segments->len > 0) {
+    GstMediaSegment *last =
+        g_ptr_array_index (stream->segments, stream->segments->len - 1);
+    number = last->number + last->repeat + 1;
+  } else {
+    number = mult_seg->startNumber;
+  }
+
+  timescale = mult_seg->SegmentBase->timescale;
+  presentationTimeOffset =
+      gst_util_uint64_scale (mult_seg->SegmentBase->presentationTimeOffset,
+      GST_SECOND, timescale);
+
+  for (list = g_queue_peek_head_link (&update->S); list;
+      list = g_list_next (list)) {
+    GstMPDSNode *S = list->data;
+    GstClockTime start_time, duration;
+
+    duration = gst_util_uint64_scale (S->d, GST_SECOND, timescale);
+    start_time = gst_util_uint64_scale (S->t, GST_SECOND, timescale)
+        + stream_period->start - presentationTimeOffset;
+    if (GST_CLOCK_TIME_IS_VALID (period_end) && start_time >= period_end)
+      break;
+
+    gst_mpd_client_add_media_segment (stream, NULL, number, S->r, S->t, S->d,
+        start_time, duration);
+    number += S->r + 1;
+  }
+}
+
+/* Updates @client in place from the freshly parsed manifest of @update, when
+ * its only changes are SegmentTimelines growing at the end and shrinking at
+ * the front, as is usual for live profiles. This keeps the state of the
+ * active streams and avoids rebuilding the segment lists for long time
+ * shift buffers. Returns FALSE, without changing anything, if a full setup
+ * of @update is needed instead. */
+gboolean
+gst_mpd_client_update_live (GstMPDClient * client, GstMPDClient * update)
+{
+  GstMPDRootNode *cur_root, *new_root;
+  GList *updates = NULL, *cur_period, *new_period, *list, *streams;
+  GList *periods;
+  gboolean ret = FALSE;
+
+  g_return_val_if_fail (client != NULL, FALSE);
+  g_return_val_if_fail (update != NULL, FALSE);
+
+  cur_root = client->mpd_root_node;
+  new_root = update->mpd_root_node;
+  if (cur_root == NULL || new_root == NULL || client->periods == NULL)
+    return FALSE;
+
+  if (cur_root->type != GST_MPD_FILE_TYPE_DYNAMIC
+      || new_root->type != GST_MPD_FILE_TYPE_DYNAMIC
+      || cur_root->mediaPresentationDuration !=
+      new_root->mediaPresentationDuration
+      || (cur_root->availabilityStartTime == NULL) !=
+      (new_root->availabilityStartTime == NULL)
+      || g_list_length (cur_root->Periods) != g_list_length (new_root->Periods))
+    goto done;
+
+  if (cur_root->availabilityStartTime &&
+      gst_mpd_client_calculate_time_difference
+      (cur_root->availabilityStartTime,
+          new_root->availabilityStartTime) != 0)
+    goto done;
+
+  for (cur_period = cur_root->Periods, new_period = new_root->Periods;
+      cur_period; cur_period = cur_period->next, new_period = new_period->next) {
+    if (!gst_mpd_client_prepare_period_update (cur_period->data,
+            new_period->data, &updates))
+      goto done;
+  }
+
+  /* all good, update the timelines and the streams using them */
+  for (list = updates; list; list = list->next) {
+    GstMPDTimelineUpdate *timeline_update = list->data;
+    GstMPDMultSegmentBaseNode *mult_seg =
+        GST_MPD_MULT_SEGMENT_BASE_NODE (timeline_update->seg_template);
+    GQueue *S = &mult_seg->SegmentTimeline->S;
+    guint i;
+
+    for (i = 0; i < timeline_update->n_removed; i++)
+      gst_mpd_s_node_free (g_queue_pop_head (S));
+    mult_seg->startNumber += timeline_update->removed_segments;
+
+    for (streams = client->active_streams; streams; streams = streams->next) {
+      GstActiveStream *stream = streams->data;
+
+      if (stream->cur_seg_template == timeline_update->seg_template
+          && stream->segments)
+        gst_mpd_client_apply_stream_update (client, stream, timeline_update);
+    }
+
+    /* the new S nodes now belong to the timeline */
+    while (!g_queue_is_empty (&timeline_update->S))
+      g_queue_push_tail (S, g_queue_pop_head (&timeline_update->S));
+
+    GST_LOG ("Timeline of template %p: %u S nodes removed, %u now",
+        timeline_update->seg_template, timeline_update->n_removed,
+        g_queue_get_length (S));
+  }
+
+  /* Take the new MPD-level attributes, but keep the Periods the streams are
+   * pointing to */
+  periods = cur_root->Periods;
+  cur_root->Periods = new_root->Periods;
+  new_root->Periods = periods;
+  client->mpd_root_node = new_root;
+  update->mpd_root_node = cur_root;
+  client->profile_isoff_ondemand = update->profile_isoff_ondemand;
+
+  GST_DEBUG ("Updated %u timelines in place", g_list_length (updates));
+  ret = TRUE;
+
+done:
+  g_list_free_full (updates, (GDestroyNotify) gst_mpd_timeline_update_free);
+
+  return ret;
+}
+
+/* Returns the index of the first segment of @stream ending after @ts, or
+ * at @ts if @inclusive, or the number of segments if there's none. Segments
+ * are sorted and each one ends where the next one starts, so a binary
+ * search is enough even for very long timelines */
+static guint
+gst_mpd_client_find_segment (GstMPDClient * client, GstActiveStream * stream,
+    GstClockTime ts, gboolean inclusive)
+{
+  guint low = 0, high = stream->segments->len;
+
+  while (low < high) {
+    guint mid = low + (high - low) / 2;
+    GstMediaSegment *segment = g_ptr_array_index (stream->segments, mid);
+    GstClockTime end_time;
+
+    end_time = gst_mpd_client_get_segment_end_time (client, stream->segments,
+        segment, mid);
+
+    if (inclusive ? ts <= end_time : ts < end_time)
+      high = mid;
+    else
+      low = mid + 1;
+  }
+
+  return low;
+}
+
 gboolean
 gst_mpd_client_stream_seek (GstMPDClient * client, GstActiveStream * stream,
     gboolean forward, GstSeekFlags flags, GstClockTime ts,
@@ -1670,67 +2053,53 @@ gst_mpd_client_stream_seek (GstMPDClient * client, GstActiveStream * stream,
   g_return_val_if_fail (stream != NULL, 0);
 
   if (stream->segments) {
-    for (index = 0; index < stream->segments->len; index++) {
-      gboolean in_segment = FALSE;
-      GstMediaSegment *segment = g_ptr_array_index (stream->segments, index);
-      GstClockTime end_time;
-
-      GST_DEBUG ("Looking at fragment sequence chunk %d / %d", index,
-          stream->segments->len);
+    /* avoid downloading another fragment just for 1ns in reverse mode */
+    index = gst_mpd_client_find_segment (client, stream, ts, !forward);
+    GST_DEBUG ("Found fragment sequence chunk %d / %d", index,
+        stream->segments->len);
 
-      end_time =
-          gst_mpd_client_get_segment_end_time (client, stream->segments,
-          segment, index);
-
-      /* avoid downloading another fragment just for 1ns in reverse mode */
-      if (forward)
-        in_segment = ts < end_time;
-      else
-        in_segment = ts <= end_time;
-
-      if (in_segment) {
-        GstClockTime chunk_time;
+    if (index < stream->segments->len) {
+      GstMediaSegment *segment = g_ptr_array_index (stream->segments, index);
+      GstClockTime chunk_time;
 
-        selectedChunk = segment;
-        repeat_index = (ts - segment->start) / segment->duration;
+      selectedChunk = segment;
+      repeat_index = (ts - segment->start) / segment->duration;
 
-        chunk_time = segment->start + segment->duration * repeat_index;
+      chunk_time = segment->start + segment->duration * repeat_index;
 
-        /* At the end of a segment in reverse mode, start from the previous fragment */
-        if (!forward && repeat_index > 0
-            && ((ts - segment->start) % segment->duration == 0))
-          repeat_index--;
+      /* At the end of a segment in reverse mode, start from the previous fragment */
+      if (!forward && repeat_index > 0
+          && ((ts - segment->start) % segment->duration == 0))
+        repeat_index--;
 
-        if ((flags & GST_SEEK_FLAG_SNAP_NEAREST) == GST_SEEK_FLAG_SNAP_NEAREST) {
-          if (repeat_index + 1 < segment->repeat) {
-            if (ts - chunk_time > chunk_time + segment->duration - ts)
-              repeat_index++;
-          } else if (index + 1 < stream->segments->len) {
-            GstMediaSegment *next_segment =
-                g_ptr_array_index (stream->segments, index + 1);
+      if ((flags & GST_SEEK_FLAG_SNAP_NEAREST) == GST_SEEK_FLAG_SNAP_NEAREST) {
+        if (repeat_index + 1 < segment->repeat) {
+          if (ts - chunk_time > chunk_time + segment->duration - ts)
+            repeat_index++;
+        } else if (index + 1 < stream->segments->len) {
+          GstMediaSegment *next_segment =
+              g_ptr_array_index (stream->segments, index + 1);
 
-            if (ts - chunk_time > next_segment->start - ts) {
-              repeat_index = 0;
-              selectedChunk = next_segment;
-              index++;
-            }
+          if (ts - chunk_time > next_segment->start - ts) {
+            repeat_index = 0;
+            selectedChunk = next_segment;
+            index++;
           }
-        } else if (((forward && flags & GST_SEEK_FLAG_SNAP_AFTER) ||
-                (!forward && flags & GST_SEEK_FLAG_SNAP_BEFORE)) &&
-            ts != chunk_time) {
-
-          if (repeat_index + 1 < segment->repeat) {
-            repeat_index++;
+        }
+      } else if (((forward && flags & GST_SEEK_FLAG_SNAP_AFTER) ||
+              (!forward && flags & GST_SEEK_FLAG_SNAP_BEFORE)) &&
+          ts != chunk_time) {
+
+        if (repeat_index + 1 < segment->repeat) {
+          repeat_index++;
+        } else {
+          repeat_index = 0;
+          if (index + 1 >= stream->segments->len) {
+            selectedChunk = NULL;
           } else {
-            repeat_index = 0;
-            if (index + 1 >= stream->segments->len) {
-              selectedChunk = NULL;
-            } else {
-              selectedChunk = g_ptr_array_index (stream->segments, ++index);
-            }
+            selectedChunk = g_ptr_array_index (stream->segments, ++index);
           }
         }
-        break;
       }
     }
 
@@ -838,6 +838,16 @@ gst_mpdparser_parse_segment_template_node (GstMPDSegmentTemplateNode ** pointer,
         xmlMemStrdup (parent->bitstreamSwitching);
   }
 
+  if (!gst_xml_helper_get_prop_double (a_node, "availabilityTimeOffset",
+          &new_segment_template->availabilityTimeOffset) && parent) {
+    new_segment_template->availabilityTimeOffset =
+        parent->availabilityTimeOffset;
+  }
+
+  gst_xml_helper_get_prop_boolean (a_node, "availabilityTimeComplete",
+      parent ? parent->availabilityTimeComplete : TRUE,
+      &new_segment_template->availabilityTimeComplete);
+
   *pointer = new_segment_template;
   return TRUE;
 
@@ -31,6 +31,8 @@ enum
   PROP_MPD_SEGMENT_TEMPLATE_INDEX,
   PROP_MPD_SEGMENT_TEMPLATE_INITIALIZATION,
   PROP_MPD_SEGMENT_TEMPLATE_BITSTREAM_SWITCHING,
+  PROP_MPD_SEGMENT_TEMPLATE_AVAILABILITY_TIME_OFFSET,
+  PROP_MPD_SEGMENT_TEMPLATE_AVAILABILITY_TIME_COMPLETE,
 };
 
 /* GObject VMethods */
@@ -53,6 +55,12 @@ gst_mpd_segment_template_node_set_property (GObject * object, guint prop_id,
     case PROP_MPD_SEGMENT_TEMPLATE_BITSTREAM_SWITCHING:
       self->bitstreamSwitching = g_value_dup_string (value);
       break;
+    case PROP_MPD_SEGMENT_TEMPLATE_AVAILABILITY_TIME_OFFSET:
+      self->availabilityTimeOffset = g_value_get_double (value);
+      break;
+    case PROP_MPD_SEGMENT_TEMPLATE_AVAILABILITY_TIME_COMPLETE:
+      self->availabilityTimeComplete = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -77,6 +85,12 @@ gst_mpd_segment_template_node_get_property (GObject * object, guint prop_id,
     case PROP_MPD_SEGMENT_TEMPLATE_BITSTREAM_SWITCHING:
       g_value_set_string (value, self->bitstreamSwitching);
       break;
+    case PROP_MPD_SEGMENT_TEMPLATE_AVAILABILITY_TIME_OFFSET:
+      g_value_set_double (value, self->availabilityTimeOffset);
+      break;
+    case PROP_MPD_SEGMENT_TEMPLATE_AVAILABILITY_TIME_COMPLETE:
+      g_value_set_boolean (value, self->availabilityTimeComplete);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -127,6 +141,14 @@ gst_mpd_segment_template_get_xml_node (GstMPDNode * node)
     gst_xml_helper_set_prop_string (segment_template_xml_node,
         "bitstreamSwitching", self->bitstreamSwitching);
 
+  if (self->availabilityTimeOffset > 0)
+    gst_xml_helper_set_prop_double (segment_template_xml_node,
+        "availabilityTimeOffset", self->availabilityTimeOffset);
+
+  if (!self->availabilityTimeComplete)
+    gst_xml_helper_set_prop_boolean (segment_template_xml_node,
+        "availabilityTimeComplete", self->availabilityTimeComplete);
+
   return segment_template_xml_node;
 }
 
@@ -161,6 +183,16 @@ gst_mpd_segment_template_node_class_init (GstMPDSegmentTemplateNodeClass *
       g_param_spec_string ("bitstream-switching", "bitstream switching",
           "bitstream switching", NULL,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class,
+      PROP_MPD_SEGMENT_TEMPLATE_AVAILABILITY_TIME_OFFSET,
+      g_param_spec_double ("availability-time-offset",
+          "availability time offset", "availability time offset in seconds",
+          0, G_MAXDOUBLE, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class,
+      PROP_MPD_SEGMENT_TEMPLATE_AVAILABILITY_TIME_COMPLETE,
+      g_param_spec_boolean ("availability-time-complete",
+          "availability time complete", "availability time complete", TRUE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -170,6 +202,8 @@ gst_mpd_segment_template_node_init (GstMPDSegmentTemplateNode * self)
   self->index = NULL;
   self->initialization = NULL;
   self->bitstreamSwitching = NULL;
+  self->availabilityTimeOffset = 0;
+  self->availabilityTimeComplete = TRUE;
 }
 
 GstMPDSegmentTemplateNode *
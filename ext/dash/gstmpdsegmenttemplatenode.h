@@ -38,6 +38,8 @@ struct _GstMPDSegmentTemplateNode
   gchar *index;
   gchar *initialization;
   gchar *bitstreamSwitching;
+  gdouble availabilityTimeOffset;
+  gboolean availabilityTimeComplete;
 };
 
 GstMPDSegmentTemplateNode * gst_mpd_segment_template_node_new (void);
@@ -201,6 +201,12 @@ gst_dtls_agent_init (GstDtlsAgent * self)
   SSL_CTX_set_cipher_list (priv->ssl_context,
       "ALL:!ADH:!LOW:!EXP:!MD5:@STRENGTH");
   SSL_CTX_set_read_ahead (priv->ssl_context, 1);
+  /* Every WebRTC handshake has to present the certificate matching the
+   * fingerprint in the SDP, so sessions are never resumed. Don't fill the
+   * session cache of the shared context and don't send tickets, which is
+   * one message less in the final flight */
+  SSL_CTX_set_session_cache_mode (priv->ssl_context, SSL_SESS_CACHE_OFF);
+  SSL_CTX_set_options (priv->ssl_context, SSL_OP_NO_TICKET);
 #if (OPENSSL_VERSION_NUMBER >= 0x1000200fL) && (OPENSSL_VERSION_NUMBER < 0x10100000L)
   SSL_CTX_set_ecdh_auto (priv->ssl_context, 1);
 #endif
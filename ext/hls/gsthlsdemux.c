@@ -58,6 +58,9 @@ static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
 GST_DEBUG_CATEGORY (gst_hls_demux_debug);
 #define GST_CAT_DEFAULT gst_hls_demux_debug
 
+/* number of upcoming fragments to fetch the decryption keys for */
+#define KEY_PREFETCH_FRAGMENTS 3
+
 #define GST_M3U8_CLIENT_LOCK(l) /* FIXME */
 #define GST_M3U8_CLIENT_UNLOCK(l)       /* FIXME */
 
@@ -106,11 +109,15 @@ static gboolean gst_hls_demux_stream_has_next_fragment (GstAdaptiveDemuxStream *
     stream);
 static GstFlowReturn gst_hls_demux_advance_fragment (GstAdaptiveDemuxStream *
     stream);
+static gboolean gst_hls_demux_stream_peek_fragment (GstAdaptiveDemuxStream *
+    stream, guint n, gchar ** uri, gint64 * range_start, gint64 * range_end);
 static GstFlowReturn gst_hls_demux_update_fragment_info (GstAdaptiveDemuxStream
     * stream);
 static gboolean gst_hls_demux_select_bitrate (GstAdaptiveDemuxStream * stream,
     guint64 bitrate);
 static void gst_hls_demux_reset (GstAdaptiveDemux * demux);
+static void gst_hls_demux_prefetch_key_func (gpointer data,
+    gpointer user_data);
 static gboolean gst_hls_demux_get_live_seek_range (GstAdaptiveDemux * demux,
     gint64 * start, gint64 * stop);
 static GstM3U8 *gst_hls_demux_stream_get_m3u8 (GstHLSDemuxStream * hls_stream);
@@ -126,11 +133,15 @@ gst_hls_demux_finalize (GObject * obj)
   GstHLSDemux *demux = GST_HLS_DEMUX (obj);
 
   gst_hls_demux_reset (GST_ADAPTIVE_DEMUX_CAST (demux));
+  /* lets queued key fetches finish, they fail quickly once stopped */
+  g_thread_pool_free (demux->key_pool, FALSE, TRUE);
   g_mutex_clear (&demux->keys_lock);
+  g_cond_clear (&demux->keys_cond);
   if (demux->keys) {
     g_hash_table_unref (demux->keys);
     demux->keys = NULL;
   }
+  g_hash_table_unref (demux->keys_pending);
 
   G_OBJECT_CLASS (parent_class)->finalize (obj);
 }
@@ -175,6 +186,8 @@ gst_hls_demux_class_init (GstHLSDemuxClass * klass)
   adaptivedemux_class->stream_advance_fragment = gst_hls_demux_advance_fragment;
   adaptivedemux_class->stream_update_fragment_info =
       gst_hls_demux_update_fragment_info;
+  adaptivedemux_class->stream_peek_fragment =
+      gst_hls_demux_stream_peek_fragment;
   adaptivedemux_class->stream_select_bitrate = gst_hls_demux_select_bitrate;
   adaptivedemux_class->stream_free = gst_hls_demux_stream_free;
 
@@ -194,6 +207,11 @@ gst_hls_demux_init (GstHLSDemux * demux)
 
   demux->keys = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
   g_mutex_init (&demux->keys_lock);
+  demux->keys_pending =
+      g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  g_cond_init (&demux->keys_cond);
+  demux->key_pool = g_thread_pool_new (gst_hls_demux_prefetch_key_func,
+      demux, 1, FALSE, NULL);
 }
 
 static GstStateChangeReturn
@@ -455,6 +473,7 @@ gst_hls_demux_stream_seek (GstAdaptiveDemuxStream * stream, gboolean forward,
       (guint) current_sequence);
   hls_stream->reset_pts = TRUE;
   hls_stream->playlist->sequence = current_sequence;
+  hls_stream->playlist->part = 0;
   hls_stream->playlist->current_file = walk;
   hls_stream->playlist->sequence_position = current_pos;
   GST_M3U8_CLIENT_UNLOCK (hlsdemux->client);
@@ -714,6 +733,7 @@ gst_hls_demux_set_current_variant (GstHLSDemux * hlsdemux,
     variant->m3u8->sequence_position =
         hlsdemux->current_variant->m3u8->sequence_position;
     variant->m3u8->sequence = hlsdemux->current_variant->m3u8->sequence;
+    variant->m3u8->part = hlsdemux->current_variant->m3u8->part;
 
     GST_DEBUG_OBJECT (hlsdemux,
         "Switching Variant. Copying over sequence %" G_GINT64_FORMAT
@@ -735,6 +755,7 @@ gst_hls_demux_set_current_variant (GstHLSDemux * hlsdemux,
           GST_LOG_OBJECT (hlsdemux, "new_media '%s' '%s'", new_media->name,
               new_media->uri);
           new_media->playlist->sequence = old_media->playlist->sequence;
+          new_media->playlist->part = old_media->playlist->part;
           new_media->playlist->sequence_position =
               old_media->playlist->sequence_position;
         } else {
@@ -840,25 +861,19 @@ gst_hls_demux_is_live (GstAdaptiveDemux * demux)
   return is_live;
 }
 
-static const GstHLSKey *
-gst_hls_demux_get_key (GstHLSDemux * demux, const gchar * key_url,
+/* Downloads the key of @key_url, which must be in the pending keys, into
+ * the key cache. Called with keys_lock held, which is released during the
+ * download */
+static GstHLSKey *
+gst_hls_demux_fetch_key (GstHLSDemux * demux, const gchar * key_url,
     const gchar * referer, gboolean allow_cache)
 {
   GstFragment *key_fragment;
   GstBuffer *key_buffer;
-  GstHLSKey *key;
+  GstHLSKey *key = NULL;
   GError *err = NULL;
 
-  GST_LOG_OBJECT (demux, "Looking up key for key url %s", key_url);
-
-  g_mutex_lock (&demux->keys_lock);
-
-  key = g_hash_table_lookup (demux->keys, key_url);
-
-  if (key != NULL) {
-    GST_LOG_OBJECT (demux, "Found key for key url %s in key cache", key_url);
-    goto out;
-  }
+  g_mutex_unlock (&demux->keys_lock);
 
   GST_INFO_OBJECT (demux, "Fetching key %s", key_url);
 
@@ -870,21 +885,114 @@ gst_hls_demux_get_key (GstHLSDemux * demux, const gchar * key_url,
     GST_WARNING_OBJECT (demux, "Failed to download key to decrypt data: %s",
         err ? err->message : "error");
     g_clear_error (&err);
-    goto out;
+  } else {
+    key_buffer = gst_fragment_get_buffer (key_fragment);
+
+    key = g_new0 (GstHLSKey, 1);
+    if (gst_buffer_extract (key_buffer, 0, key->data, 16) < 16)
+      GST_WARNING_OBJECT (demux, "Download decryption key is too short!");
+
+    gst_buffer_unref (key_buffer);
+    g_object_unref (key_fragment);
   }
 
-  key_buffer = gst_fragment_get_buffer (key_fragment);
+  g_mutex_lock (&demux->keys_lock);
 
-  key = g_new0 (GstHLSKey, 1);
-  if (gst_buffer_extract (key_buffer, 0, key->data, 16) < 16)
-    GST_WARNING_OBJECT (demux, "Download decryption key is too short!");
+  if (key)
+    g_hash_table_insert (demux->keys, g_strdup (key_url), key);
+  g_hash_table_remove (demux->keys_pending, key_url);
+  g_cond_broadcast (&demux->keys_cond);
 
-  g_hash_table_insert (demux->keys, g_strdup (key_url), key);
+  return key;
+}
 
-  gst_buffer_unref (key_buffer);
-  g_object_unref (key_fragment);
+typedef struct
+{
+  gchar *key_url;
+  gchar *referer;
+  gboolean allow_cache;
+} GstHLSKeyFetch;
 
-out:
+static void
+gst_hls_demux_prefetch_key_func (gpointer data, gpointer user_data)
+{
+  GstHLSKeyFetch *fetch = data;
+  GstHLSDemux *demux = user_data;
+
+  g_mutex_lock (&demux->keys_lock);
+  gst_hls_demux_fetch_key (demux, fetch->key_url, fetch->referer,
+      fetch->allow_cache);
+  g_mutex_unlock (&demux->keys_lock);
+
+  g_free (fetch->key_url);
+  g_free (fetch->referer);
+  g_free (fetch);
+}
+
+/* Fetches the keys of the next fragments in the background, so they are
+ * usually in the cache once the fragments using them are started */
+static void
+gst_hls_demux_prefetch_keys (GstHLSDemux * demux, GstM3U8 * m3u8,
+    gboolean forward)
+{
+  GstM3U8MediaFile *file;
+  guint i;
+
+  for (i = 1; i <= KEY_PREFETCH_FRAGMENTS; i++) {
+    GstHLSKeyFetch *fetch;
+
+    file = gst_m3u8_peek_fragment (m3u8, forward, i);
+    if (file == NULL)
+      break;
+
+    if (file->key == NULL) {
+      gst_m3u8_media_file_unref (file);
+      continue;
+    }
+
+    g_mutex_lock (&demux->keys_lock);
+    if (g_hash_table_contains (demux->keys, file->key) ||
+        g_hash_table_contains (demux->keys_pending, file->key)) {
+      g_mutex_unlock (&demux->keys_lock);
+      gst_m3u8_media_file_unref (file);
+      continue;
+    }
+    g_hash_table_add (demux->keys_pending, g_strdup (file->key));
+    g_mutex_unlock (&demux->keys_lock);
+
+    GST_DEBUG_OBJECT (demux, "Prefetching key %s", file->key);
+
+    fetch = g_new (GstHLSKeyFetch, 1);
+    fetch->key_url = g_strdup (file->key);
+    fetch->referer = g_strdup (m3u8->uri);
+    fetch->allow_cache = m3u8->allowcache;
+    g_thread_pool_push (demux->key_pool, fetch, NULL);
+
+    gst_m3u8_media_file_unref (file);
+  }
+}
+
+static const GstHLSKey *
+gst_hls_demux_get_key (GstHLSDemux * demux, const gchar * key_url,
+    const gchar * referer, gboolean allow_cache)
+{
+  GstHLSKey *key;
+
+  GST_LOG_OBJECT (demux, "Looking up key for key url %s", key_url);
+
+  g_mutex_lock (&demux->keys_lock);
+
+  /* wait for a prefetch of the key that's already running */
+  while ((key = g_hash_table_lookup (demux->keys, key_url)) == NULL &&
+      g_hash_table_contains (demux->keys_pending, key_url))
+    g_cond_wait (&demux->keys_cond, &demux->keys_lock);
+
+  if (key != NULL) {
+    GST_LOG_OBJECT (demux, "Found key for key url %s in key cache", key_url);
+  } else {
+    g_hash_table_add (demux->keys_pending, g_strdup (key_url));
+    key = gst_hls_demux_fetch_key (demux, key_url, referer, allow_cache);
+  }
 
   g_mutex_unlock (&demux->keys_lock);
 
@@ -1279,6 +1387,8 @@ gst_hls_demux_update_fragment_info (GstAdaptiveDemuxStream * stream)
   g_free (hlsdemux_stream->current_iv);
   hlsdemux_stream->current_iv = g_memdup (file->iv, sizeof (file->iv));
 
+  gst_hls_demux_prefetch_keys (hlsdemux, m3u8, forward);
+
   g_free (stream->fragment.uri);
   stream->fragment.uri = g_strdup (file->uri);
 
@@ -1300,6 +1410,32 @@ gst_hls_demux_update_fragment_info (GstAdaptiveDemuxStream * stream)
   return GST_FLOW_OK;
 }
 
+static gboolean
+gst_hls_demux_stream_peek_fragment (GstAdaptiveDemuxStream * stream, guint n,
+    gchar ** uri, gint64 * range_start, gint64 * range_end)
+{
+  GstHLSDemuxStream *hlsdemux_stream = GST_HLS_DEMUX_STREAM_CAST (stream);
+  GstM3U8MediaFile *file;
+  GstM3U8 *m3u8;
+
+  m3u8 = gst_hls_demux_stream_get_m3u8 (hlsdemux_stream);
+
+  file = gst_m3u8_peek_fragment (m3u8, stream->demux->segment.rate > 0, n);
+  if (file == NULL)
+    return FALSE;
+
+  *uri = g_strdup (file->uri);
+  *range_start = file->offset;
+  if (file->size != -1)
+    *range_end = file->offset + file->size - 1;
+  else
+    *range_end = -1;
+
+  gst_m3u8_media_file_unref (file);
+
+  return TRUE;
+}
+
 static gboolean
 gst_hls_demux_select_bitrate (GstAdaptiveDemuxStream * stream, guint64 bitrate)
 {
@@ -1448,6 +1584,7 @@ gst_hls_demux_update_variant_playlist (GstHLSDemux * hlsdemux, gchar * data,
       /* FIXME: Deal with losing position due to missing an update */
       variant->m3u8->sequence_position = old->m3u8->sequence_position;
       variant->m3u8->sequence = old->m3u8->sequence;
+      variant->m3u8->part = old->m3u8->part;
     }
   }
 
@@ -1550,14 +1687,20 @@ gst_hls_demux_update_playlist (GstHLSDemux * demux, gboolean update,
   GstFragment *download;
   GstBuffer *buf;
   gchar *playlist;
-  gboolean main_checked = FALSE;
+  gboolean main_checked = FALSE, is_blocking;
   const gchar *main_uri;
   GstM3U8 *m3u8;
-  gchar *uri;
+  gchar *uri = NULL;
   gint i;
 
 retry:
-  uri = gst_m3u8_get_uri (demux->current_variant->m3u8);
+  /* Let the server hold the response until there is something new in
+   * low-latency playlists */
+  if (update)
+    uri = gst_m3u8_get_blocking_reload_uri (demux->current_variant->m3u8);
+  is_blocking = uri != NULL;
+  if (!is_blocking)
+    uri = gst_m3u8_get_uri (demux->current_variant->m3u8);
   main_uri = gst_adaptive_demux_get_manifest_ref_uri (adaptive_demux);
   download =
       gst_uri_downloader_fetch_uri (adaptive_demux->downloader, uri, main_uri,
@@ -1616,14 +1759,18 @@ retry:
     g_object_unref (download);
 
     main_checked = TRUE;
+    uri = NULL;
     goto retry;
   }
   g_free (uri);
 
   m3u8 = demux->current_variant->m3u8;
 
-  /* Set the base URI of the playlist to the redirect target if any */
-  if (download->redirect_permanent && download->redirect_uri) {
+  /* Set the base URI of the playlist to the redirect target if any. The
+   * delivery directives of blocking reloads must not stick to it though */
+  if (is_blocking) {
+    GST_LOG_OBJECT (demux, "Got blocking reload %s", download->uri);
+  } else if (download->redirect_permanent && download->redirect_uri) {
     gst_m3u8_set_uri (m3u8, download->redirect_uri, NULL,
         demux->current_variant->name);
   } else {
@@ -1674,8 +1821,10 @@ retry:
   }
 
   /* If it's a live source, do not let the sequence number go beyond
-   * three fragments before the end of the list */
-  if (update == FALSE && gst_m3u8_is_live (m3u8)) {
+   * three fragments before the end of the list. Low-latency playlists
+   * start from the parts close to the end instead */
+  if (update == FALSE && gst_m3u8_is_live (m3u8)
+      && !GST_CLOCK_TIME_IS_VALID (gst_m3u8_get_part_target (m3u8))) {
     gint64 last_sequence, first_sequence;
 
     GST_M3U8_CLIENT_LOCK (demux->client);
@@ -2005,6 +2154,23 @@ gst_hls_demux_decrypt_fragment (GstHLSDemux * demux, GstHLSDemuxStream * stream,
   GstBuffer *decrypted_buffer = NULL;
   GstMapInfo encrypted_info, decrypted_info;
 
+  /* The data taken from the adapter is usually only owned by us, decrypt
+   * it in place then. All crypto backends support that */
+  if (gst_buffer_is_writable (encrypted_buffer) &&
+      gst_buffer_n_memory (encrypted_buffer) == 1 &&
+      gst_buffer_map (encrypted_buffer, &encrypted_info, GST_MAP_READWRITE)) {
+    if (!decrypt_fragment (stream, encrypted_info.size,
+            encrypted_info.data, encrypted_info.data)) {
+      gst_buffer_unmap (encrypted_buffer, &encrypted_info);
+      gst_buffer_unref (encrypted_buffer);
+      goto in_place_error;
+    }
+
+    gst_buffer_unmap (encrypted_buffer, &encrypted_info);
+
+    return encrypted_buffer;
+  }
+
   decrypted_buffer =
       gst_buffer_new_allocate (NULL, gst_buffer_get_size (encrypted_buffer),
       NULL);
@@ -2036,17 +2202,36 @@ decrypt_error:
   gst_buffer_unref (decrypted_buffer);
 
   return NULL;
+
+in_place_error:
+  GST_ERROR_OBJECT (demux, "Failed to decrypt fragment");
+  g_set_error (err, GST_STREAM_ERROR, GST_STREAM_ERROR_DECRYPT,
+      "Failed to decrypt fragment");
+
+  return NULL;
 }
 
 static gint64
 gst_hls_demux_get_manifest_update_interval (GstAdaptiveDemux * demux)
 {
   GstHLSDemux *hlsdemux = GST_HLS_DEMUX_CAST (demux);
-  GstClockTime target_duration;
+  GstClockTime target_duration, part_target;
 
   if (hlsdemux->current_variant) {
-    target_duration =
-        gst_m3u8_get_target_duration (hlsdemux->current_variant->m3u8);
+    GstM3U8 *m3u8 = hlsdemux->current_variant->m3u8;
+
+    target_duration = gst_m3u8_get_target_duration (m3u8);
+
+    /* Low-latency playlists get a new part every part target duration.
+     * Blocking reloads are held by the server until that happens, so
+     * there's no need to wait much before the next one */
+    part_target = gst_m3u8_get_part_target (m3u8);
+    if (GST_CLOCK_TIME_IS_VALID (part_target)) {
+      if (gst_m3u8_can_block_reload (m3u8))
+        target_duration = part_target / 4;
+      else
+        target_duration = part_target;
+    }
   } else {
     target_duration = 5 * GST_SECOND;
   }
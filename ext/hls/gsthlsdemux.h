@@ -141,6 +141,11 @@ struct _GstHLSDemux
   /* Decryption key cache: url => GstHLSKey */
   GHashTable *keys;
   GMutex      keys_lock;
+  /* urls of the keys being fetched, protected by keys_lock */
+  GHashTable *keys_pending;
+  GCond       keys_cond;
+  /* fetches the keys of upcoming fragments */
+  GThreadPool *key_pool;
 
   /* FIXME: check locking, protected automatically by manifest_lock already? */
   /* The master playlist with the available variant streams */
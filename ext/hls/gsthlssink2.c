@@ -39,6 +39,15 @@
  * gst-launch-1.0 videotestsrc is-live=true ! x264enc ! h264parse ! hlssink2 max-files=5
  * ]|
  *
+ * When the playlist and fragments are stored on slow or remote storage,
+ * #GstHlsSink2:max-pending-writes can be used to move playlist updates and
+ * fragment deletions to a separate writer thread so that storage latency
+ * does not stall the pipeline.
+ *
+ * Setting #GstHlsSink2:part-duration produces a Low-Latency HLS playlist
+ * which lists the partial segments of the fragment being written as byte
+ * ranges while the fragment is still growing.
+ *
  */
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -61,8 +70,12 @@ GST_DEBUG_CATEGORY_STATIC (gst_hls_sink2_debug);
 #define DEFAULT_TARGET_DURATION 15
 #define DEFAULT_PLAYLIST_LENGTH 5
 #define DEFAULT_SEND_KEYFRAME_REQUESTS TRUE
+#define DEFAULT_MAX_PENDING_WRITES 0
+#define DEFAULT_PART_DURATION 0
 
 #define GST_M3U8_PLAYLIST_VERSION 3
+/* Partial segments are byte ranges, which need at least version 4 */
+#define GST_M3U8_PLAYLIST_LL_VERSION 6
 
 enum
 {
@@ -74,6 +87,8 @@ enum
   PROP_TARGET_DURATION,
   PROP_PLAYLIST_LENGTH,
   PROP_SEND_KEYFRAME_REQUESTS,
+  PROP_MAX_PENDING_WRITES,
+  PROP_PART_DURATION,
 };
 
 enum
@@ -109,12 +124,16 @@ gst_hls_sink2_change_state (GstElement * element, GstStateChange trans);
 static GstPad *gst_hls_sink2_request_new_pad (GstElement * element,
     GstPadTemplate * templ, const gchar * name, const GstCaps * caps);
 static void gst_hls_sink2_release_pad (GstElement * element, GstPad * pad);
+static void gst_hls_sink2_writer_stop (GstHlsSink2 * sink);
+static void gst_hls_sink2_write_playlist (GstHlsSink2 * sink);
 
 static void
 gst_hls_sink2_dispose (GObject * object)
 {
   GstHlsSink2 *sink = GST_HLS_SINK2_CAST (object);
 
+  gst_hls_sink2_writer_stop (sink);
+
   G_OBJECT_CLASS (parent_class)->dispose ((GObject *) sink);
 }
 
@@ -133,6 +152,13 @@ gst_hls_sink2_finalize (GObject * object)
   g_queue_foreach (&sink->old_locations, (GFunc) g_free, NULL);
   g_queue_clear (&sink->old_locations);
 
+  g_free (sink->pending_playlist_location);
+  g_free (sink->pending_playlist_content);
+  g_queue_foreach (&sink->pending_deletions, (GFunc) g_free, NULL);
+  g_queue_clear (&sink->pending_deletions);
+  g_mutex_clear (&sink->writer_lock);
+  g_cond_clear (&sink->writer_cond);
+
   G_OBJECT_CLASS (parent_class)->finalize ((GObject *) sink);
 }
 
@@ -251,6 +277,46 @@ gst_hls_sink2_class_init (GstHlsSink2Class * klass)
           DEFAULT_SEND_KEYFRAME_REQUESTS,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstHlsSink2:max-pending-writes:
+   *
+   * Maximum number of playlist updates and fragment deletions that can be
+   * queued for the writer thread before the pipeline is blocked. Successive
+   * playlist updates are coalesced and only the most recent one is written,
+   * and all pending fragment deletions are handled in one batch.
+   *
+   * When enabled, the #GstHlsSink2::get-playlist-stream and
+   * #GstHlsSink2::delete-fragment signals are emitted from the writer thread.
+   *
+   * The value set when going from READY to PAUSED decides whether the
+   * writer thread is used.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_PENDING_WRITES,
+      g_param_spec_uint ("max-pending-writes", "Max pending writes",
+          "Maximum number of playlist writes and fragment deletions queued "
+          "for the writer thread before blocking the pipeline "
+          "(0 - write synchronously from the streaming thread)",
+          0, G_MAXUINT, DEFAULT_MAX_PENDING_WRITES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstHlsSink2:part-duration:
+   *
+   * Target duration in milliseconds of the Low-Latency HLS partial segments.
+   * Parts are published in the playlist as byte ranges of the fragment that
+   * is being written, as soon as their data has been handed to the fragment
+   * stream.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_PART_DURATION,
+      g_param_spec_uint ("part-duration", "Part duration",
+          "Target duration in milliseconds of Low-Latency HLS partial segments "
+          "(0 - disabled)", 0, G_MAXUINT, DEFAULT_PART_DURATION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /**
    * GstHlsSink2::get-playlist-stream:
    * @sink: the #GstHlsSink2
@@ -330,10 +396,107 @@ on_format_location (GstElement * splitmuxsink, guint fragment_id,
   return NULL;
 }
 
+static gchar *
+gst_hls_sink2_get_entry_location (GstHlsSink2 * sink, const gchar * location)
+{
+  gchar *name = g_path_get_basename (location);
+  gchar *entry_location;
+
+  if (sink->playlist_root == NULL)
+    return name;
+
+  entry_location = g_build_filename (sink->playlist_root, name, NULL);
+  g_free (name);
+
+  return entry_location;
+}
+
+static void
+gst_hls_sink2_reset_parts (GstHlsSink2 * sink)
+{
+  sink->fragment_bytes = 0;
+  sink->part_offset = 0;
+  sink->part_start_pts = GST_CLOCK_TIME_NONE;
+  sink->parts_total_duration = 0;
+  sink->part_independent = FALSE;
+}
+
+/* Adds everything written since the previous part boundary as a new part */
+static void
+gst_hls_sink2_close_part (GstHlsSink2 * sink, GstClockTime duration)
+{
+  gchar *entry_location;
+
+  entry_location = gst_hls_sink2_get_entry_location (sink,
+      sink->current_location);
+
+  GST_LOG_OBJECT (sink, "New part of %s, %" G_GUINT64_FORMAT "@%"
+      G_GUINT64_FORMAT " duration %" GST_TIME_FORMAT, entry_location,
+      sink->fragment_bytes - sink->part_offset, sink->part_offset,
+      GST_TIME_ARGS (duration));
+
+  gst_m3u8_playlist_add_part (sink->playlist, entry_location, duration,
+      sink->part_offset, sink->fragment_bytes - sink->part_offset,
+      sink->part_independent);
+  g_free (entry_location);
+
+  sink->parts_total_duration += duration;
+  sink->part_offset = sink->fragment_bytes;
+  sink->part_independent = FALSE;
+}
+
+static void
+gst_hls_sink2_fragment_buffer (GstHlsSink2 * sink, GstBuffer * buffer)
+{
+  GstClockTime pts = GST_BUFFER_PTS (buffer);
+
+  if (GST_CLOCK_TIME_IS_VALID (pts)) {
+    if (!GST_CLOCK_TIME_IS_VALID (sink->part_start_pts)) {
+      sink->part_start_pts = pts;
+    } else if (pts >= sink->part_start_pts +
+        sink->part_duration * GST_MSECOND &&
+        sink->fragment_bytes > sink->part_offset) {
+      gst_hls_sink2_close_part (sink, pts - sink->part_start_pts);
+      sink->part_start_pts = pts;
+      gst_hls_sink2_write_playlist (sink);
+      sink->state |= GST_M3U8_PLAYLIST_RENDER_STARTED;
+    }
+  }
+
+  if (!GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT))
+    sink->part_independent = TRUE;
+
+  sink->fragment_bytes += gst_buffer_get_size (buffer);
+}
+
+/* Splits the muxed fragment data into parts. This runs in the muxer
+ * streaming thread, which is also where splitmuxsink reports closed
+ * fragments. */
+static GstPadProbeReturn
+gst_hls_sink2_fragment_probe (GstPad * pad, GstPadProbeInfo * info,
+    GstHlsSink2 * sink)
+{
+  if (sink->part_duration == 0 || !sink->current_location)
+    return GST_PAD_PROBE_OK;
+
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
+    guint i, len = gst_buffer_list_length (list);
+
+    for (i = 0; i < len; i++)
+      gst_hls_sink2_fragment_buffer (sink, gst_buffer_list_get (list, i));
+  } else {
+    gst_hls_sink2_fragment_buffer (sink, GST_PAD_PROBE_INFO_BUFFER (info));
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
 static void
 gst_hls_sink2_init (GstHlsSink2 * sink)
 {
   GstElement *mux;
+  GstPad *pad;
 
   sink->location = g_strdup (DEFAULT_LOCATION);
   sink->playlist_location = g_strdup (DEFAULT_PLAYLIST_LOCATION);
@@ -342,12 +505,22 @@ gst_hls_sink2_init (GstHlsSink2 * sink)
   sink->max_files = DEFAULT_MAX_FILES;
   sink->target_duration = DEFAULT_TARGET_DURATION;
   sink->send_keyframe_requests = DEFAULT_SEND_KEYFRAME_REQUESTS;
+  sink->max_pending_writes = DEFAULT_MAX_PENDING_WRITES;
+  sink->part_duration = DEFAULT_PART_DURATION;
   g_queue_init (&sink->old_locations);
+  g_queue_init (&sink->pending_deletions);
+  g_mutex_init (&sink->writer_lock);
+  g_cond_init (&sink->writer_cond);
 
   sink->splitmuxsink = gst_element_factory_make ("splitmuxsink", NULL);
   gst_bin_add (GST_BIN (sink), sink->splitmuxsink);
 
   sink->giostreamsink = gst_element_factory_make ("giostreamsink", NULL);
+  pad = gst_element_get_static_pad (sink->giostreamsink, "sink");
+  gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+      (GstPadProbeCallback) gst_hls_sink2_fragment_probe, sink, NULL);
+  gst_object_unref (pad);
 
   mux = gst_element_factory_make ("mpegtsmux", NULL);
   g_object_set (sink->splitmuxsink, "location", NULL, "max-size-time",
@@ -371,8 +544,11 @@ gst_hls_sink2_reset (GstHlsSink2 * sink)
   if (sink->playlist)
     gst_m3u8_playlist_free (sink->playlist);
   sink->playlist =
-      gst_m3u8_playlist_new (GST_M3U8_PLAYLIST_VERSION, sink->playlist_length,
-      FALSE);
+      gst_m3u8_playlist_new (sink->part_duration > 0 ?
+      GST_M3U8_PLAYLIST_LL_VERSION : GST_M3U8_PLAYLIST_VERSION,
+      sink->playlist_length, FALSE);
+  sink->playlist->part_target = sink->part_duration * GST_MSECOND;
+  gst_hls_sink2_reset_parts (sink);
 
   g_queue_foreach (&sink->old_locations, (GFunc) g_free, NULL);
   g_queue_clear (&sink->old_locations);
@@ -380,38 +556,225 @@ gst_hls_sink2_reset (GstHlsSink2 * sink)
   sink->state = GST_M3U8_PLAYLIST_RENDER_INIT;
 }
 
+/* Writes out the rendered playlist. Without a custom playlist stream the
+ * content is written to a temporary file that is then renamed over the
+ * playlist, so that clients never see a partially written playlist. */
 static void
-gst_hls_sink2_write_playlist (GstHlsSink2 * sink)
+gst_hls_sink2_write_playlist_content (GstHlsSink2 * sink,
+    const gchar * location, const gchar * content)
 {
-  char *playlist_content;
+  GstHlsSink2Class *klass = GST_HLS_SINK2_CLASS (G_OBJECT_GET_CLASS (sink));
   GError *error = NULL;
   GOutputStream *stream = NULL;
-  gsize bytes_to_write;
 
-  g_signal_emit (sink, signals[SIGNAL_GET_PLAYLIST_STREAM], 0,
-      sink->playlist_location, &stream);
+  if (klass->get_playlist_stream == gst_hls_sink2_get_playlist_stream &&
+      !g_signal_has_handler_pending (sink,
+          signals[SIGNAL_GET_PLAYLIST_STREAM], 0, FALSE)) {
+    if (!g_file_set_contents (location, content, -1, &error)) {
+      GST_ERROR_OBJECT (sink, "Failed to write playlist: %s", error->message);
+      GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE,
+          (("Failed to write playlist '%s'."), error->message), (NULL));
+      g_clear_error (&error);
+    }
+    return;
+  }
+
+  g_signal_emit (sink, signals[SIGNAL_GET_PLAYLIST_STREAM], 0, location,
+      &stream);
   if (!stream) {
     GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE,
-        (("Got no output stream for playlist '%s'."), sink->playlist_location),
-        (NULL));
+        (("Got no output stream for playlist '%s'."), location), (NULL));
     return;
   }
 
-  playlist_content = gst_m3u8_playlist_render (sink->playlist);
-  bytes_to_write = strlen (playlist_content);
-  if (!g_output_stream_write_all (stream, playlist_content, bytes_to_write,
-          NULL, NULL, &error)) {
-    GST_ERROR ("Failed to write playlist: %s", error->message);
+  if (!g_output_stream_write_all (stream, content, strlen (content),
+          NULL, NULL, &error) ||
+      !g_output_stream_close (stream, NULL, &error)) {
+    GST_ERROR_OBJECT (sink, "Failed to write playlist: %s", error->message);
     GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE,
         (("Failed to write playlist '%s'."), error->message), (NULL));
-    g_error_free (error);
-    error = NULL;
+    g_clear_error (&error);
   }
 
-  g_free (playlist_content);
   g_object_unref (stream);
 }
 
+static void
+gst_hls_sink2_delete_fragment (GstHlsSink2 * sink, const gchar * location)
+{
+  if (g_signal_has_handler_pending (sink,
+          signals[SIGNAL_DELETE_FRAGMENT], 0, FALSE)) {
+    g_signal_emit (sink, signals[SIGNAL_DELETE_FRAGMENT], 0, location);
+  } else {
+    GFile *file = g_file_new_for_path (location);
+    GError *err = NULL;
+
+    if (!g_file_delete (file, NULL, &err)) {
+      GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE,
+          (("Failed to delete fragment file '%s': %s."),
+              location, err->message), (NULL));
+      g_clear_error (&err);
+    }
+
+    g_object_unref (file);
+  }
+}
+
+static guint
+gst_hls_sink2_writer_pending (GstHlsSink2 * sink)
+{
+  return (sink->pending_playlist_content ? 1 : 0) +
+      g_queue_get_length (&sink->pending_deletions);
+}
+
+static gpointer
+gst_hls_sink2_writer_func (GstHlsSink2 * sink)
+{
+  g_mutex_lock (&sink->writer_lock);
+  while (TRUE) {
+    gchar *location, *content;
+    GQueue deletions = G_QUEUE_INIT;
+    gchar *old_location;
+
+    while (!sink->writer_stopping && gst_hls_sink2_writer_pending (sink) == 0)
+      g_cond_wait (&sink->writer_cond, &sink->writer_lock);
+
+    /* Only exit once everything queued has been written out */
+    if (gst_hls_sink2_writer_pending (sink) == 0)
+      break;
+
+    location = g_steal_pointer (&sink->pending_playlist_location);
+    content = g_steal_pointer (&sink->pending_playlist_content);
+    deletions = sink->pending_deletions;
+    g_queue_init (&sink->pending_deletions);
+    sink->writer_busy = TRUE;
+    g_cond_broadcast (&sink->writer_cond);
+    g_mutex_unlock (&sink->writer_lock);
+
+    /* The playlist is published before the fragments that dropped out of it
+     * are removed */
+    if (content) {
+      GST_LOG_OBJECT (sink, "Writing playlist %s", location);
+      gst_hls_sink2_write_playlist_content (sink, location, content);
+    }
+
+    if (deletions.length > 0)
+      GST_LOG_OBJECT (sink, "Deleting %u old fragments", deletions.length);
+    while ((old_location = g_queue_pop_head (&deletions))) {
+      gst_hls_sink2_delete_fragment (sink, old_location);
+      g_free (old_location);
+    }
+
+    g_free (location);
+    g_free (content);
+
+    g_mutex_lock (&sink->writer_lock);
+    sink->writer_busy = FALSE;
+    g_cond_broadcast (&sink->writer_cond);
+  }
+  g_mutex_unlock (&sink->writer_lock);
+
+  return NULL;
+}
+
+static void
+gst_hls_sink2_writer_start (GstHlsSink2 * sink)
+{
+  g_mutex_lock (&sink->writer_lock);
+  if (sink->max_pending_writes > 0 && !sink->writer_thread) {
+    GST_DEBUG_OBJECT (sink, "Starting writer thread");
+    sink->writer_stopping = FALSE;
+    sink->writer_thread = g_thread_new ("hlssink2-writer",
+        (GThreadFunc) gst_hls_sink2_writer_func, sink);
+  }
+  g_mutex_unlock (&sink->writer_lock);
+}
+
+/* Drains all pending writes and stops the writer thread */
+static void
+gst_hls_sink2_writer_stop (GstHlsSink2 * sink)
+{
+  GThread *thread;
+
+  g_mutex_lock (&sink->writer_lock);
+  thread = g_steal_pointer (&sink->writer_thread);
+  sink->writer_stopping = TRUE;
+  g_cond_broadcast (&sink->writer_cond);
+  g_mutex_unlock (&sink->writer_lock);
+
+  if (thread) {
+    GST_DEBUG_OBJECT (sink, "Stopping writer thread");
+    g_thread_join (thread);
+  }
+}
+
+/* Waits until the writer thread has written out everything queued so far */
+static void
+gst_hls_sink2_writer_flush (GstHlsSink2 * sink)
+{
+  g_mutex_lock (&sink->writer_lock);
+  while (sink->writer_thread && (sink->writer_busy ||
+          gst_hls_sink2_writer_pending (sink) > 0))
+    g_cond_wait (&sink->writer_cond, &sink->writer_lock);
+  g_mutex_unlock (&sink->writer_lock);
+}
+
+/* Must be called with the writer lock. Blocks while the queue is full. */
+static void
+gst_hls_sink2_writer_wait_space (GstHlsSink2 * sink)
+{
+  while (sink->writer_thread && !sink->writer_stopping &&
+      gst_hls_sink2_writer_pending (sink) >=
+      MAX (sink->max_pending_writes, 1)) {
+    GST_DEBUG_OBJECT (sink, "Writer queue full, waiting");
+    g_cond_wait (&sink->writer_cond, &sink->writer_lock);
+  }
+}
+
+static void
+gst_hls_sink2_write_playlist (GstHlsSink2 * sink)
+{
+  gchar *playlist_content;
+
+  playlist_content = gst_m3u8_playlist_render (sink->playlist);
+
+  g_mutex_lock (&sink->writer_lock);
+  if (sink->writer_thread) {
+    /* A newer playlist supersedes one that was not written yet */
+    if (!sink->pending_playlist_content)
+      gst_hls_sink2_writer_wait_space (sink);
+    g_free (sink->pending_playlist_location);
+    g_free (sink->pending_playlist_content);
+    sink->pending_playlist_location = g_strdup (sink->playlist_location);
+    sink->pending_playlist_content = playlist_content;
+    g_cond_broadcast (&sink->writer_cond);
+    g_mutex_unlock (&sink->writer_lock);
+    return;
+  }
+  g_mutex_unlock (&sink->writer_lock);
+
+  gst_hls_sink2_write_playlist_content (sink, sink->playlist_location,
+      playlist_content);
+  g_free (playlist_content);
+}
+
+static void
+gst_hls_sink2_remove_old_fragment (GstHlsSink2 * sink, gchar * old_location)
+{
+  g_mutex_lock (&sink->writer_lock);
+  if (sink->writer_thread) {
+    gst_hls_sink2_writer_wait_space (sink);
+    g_queue_push_tail (&sink->pending_deletions, old_location);
+    g_cond_broadcast (&sink->writer_cond);
+    g_mutex_unlock (&sink->writer_lock);
+    return;
+  }
+  g_mutex_unlock (&sink->writer_lock);
+
+  gst_hls_sink2_delete_fragment (sink, old_location);
+  g_free (old_location);
+}
+
 static void
 gst_hls_sink2_handle_message (GstBin * bin, GstMessage * message)
 {
@@ -438,14 +801,23 @@ gst_hls_sink2_handle_message (GstBin * bin, GstMessage * message)
           gst_structure_get_clock_time (s, "running-time", &running_time);
 
           GST_INFO_OBJECT (sink, "COUNT %d", sink->index);
-          if (sink->playlist_root == NULL) {
-            entry_location = g_path_get_basename (sink->current_location);
-          } else {
-            gchar *name = g_path_get_basename (sink->current_location);
-            entry_location = g_build_filename (sink->playlist_root, name, NULL);
-            g_free (name);
+
+          if (sink->part_duration > 0) {
+            GstClockTime duration =
+                running_time - sink->current_running_time_start;
+
+            /* The remainder of the fragment is its last part */
+            if (sink->fragment_bytes > sink->part_offset) {
+              gst_hls_sink2_close_part (sink,
+                  duration > sink->parts_total_duration ?
+                  duration - sink->parts_total_duration : 0);
+            }
+            gst_hls_sink2_reset_parts (sink);
           }
 
+          entry_location = gst_hls_sink2_get_entry_location (sink,
+              sink->current_location);
+
           gst_m3u8_playlist_add_entry (sink->playlist, entry_location,
               NULL, running_time - sink->current_running_time_start,
               sink->index++, FALSE);
@@ -459,27 +831,8 @@ gst_hls_sink2_handle_message (GstBin * bin, GstMessage * message)
 
           if (sink->max_files > 0) {
             while (g_queue_get_length (&sink->old_locations) > sink->max_files) {
-              gchar *old_location = g_queue_pop_head (&sink->old_locations);
-
-
-              if (g_signal_has_handler_pending (sink,
-                      signals[SIGNAL_DELETE_FRAGMENT], 0, FALSE)) {
-                g_signal_emit (sink, signals[SIGNAL_DELETE_FRAGMENT], 0,
-                    old_location);
-              } else {
-                GFile *file = g_file_new_for_path (old_location);
-                GError *err = NULL;
-
-                if (!g_file_delete (file, NULL, &err)) {
-                  GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE,
-                      (("Failed to delete fragment file '%s': %s."),
-                          old_location, err->message), (NULL));
-                  g_clear_error (&err);
-                }
-
-                g_object_unref (file);
-              }
-              g_free (old_location);
+              gst_hls_sink2_remove_old_fragment (sink,
+                  g_queue_pop_head (&sink->old_locations));
             }
           }
 
@@ -492,6 +845,8 @@ gst_hls_sink2_handle_message (GstBin * bin, GstMessage * message)
     case GST_MESSAGE_EOS:{
       sink->playlist->end_list = TRUE;
       gst_hls_sink2_write_playlist (sink);
+      /* Make sure the final playlist is out before EOS is reported */
+      gst_hls_sink2_writer_flush (sink);
       sink->state |= GST_M3U8_PLAYLIST_RENDER_ENDED;
       break;
     }
@@ -575,6 +930,9 @@ gst_hls_sink2_change_state (GstElement * element, GstStateChange trans)
         return GST_STATE_CHANGE_FAILURE;
       }
       break;
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      gst_hls_sink2_writer_start (sink);
+      break;
     default:
       break;
   }
@@ -591,6 +949,7 @@ gst_hls_sink2_change_state (GstElement * element, GstStateChange trans)
         sink->playlist->end_list = TRUE;
         gst_hls_sink2_write_playlist (sink);
       }
+      gst_hls_sink2_writer_stop (sink);
       /* fall-through */
     case GST_STATE_CHANGE_READY_TO_NULL:
       gst_hls_sink2_reset (sink);
@@ -644,6 +1003,19 @@ gst_hls_sink2_set_property (GObject * object, guint prop_id,
             sink->send_keyframe_requests, NULL);
       }
       break;
+    case PROP_MAX_PENDING_WRITES:
+      g_mutex_lock (&sink->writer_lock);
+      sink->max_pending_writes = g_value_get_uint (value);
+      g_cond_broadcast (&sink->writer_cond);
+      g_mutex_unlock (&sink->writer_lock);
+      break;
+    case PROP_PART_DURATION:
+      sink->part_duration = g_value_get_uint (value);
+      sink->playlist->part_target = sink->part_duration * GST_MSECOND;
+      if (sink->part_duration > 0)
+        sink->playlist->version = MAX (sink->playlist->version,
+            GST_M3U8_PLAYLIST_LL_VERSION);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -678,6 +1050,14 @@ gst_hls_sink2_get_property (GObject * object, guint prop_id,
     case PROP_SEND_KEYFRAME_REQUESTS:
       g_value_set_boolean (value, sink->send_keyframe_requests);
       break;
+    case PROP_MAX_PENDING_WRITES:
+      g_mutex_lock (&sink->writer_lock);
+      g_value_set_uint (value, sink->max_pending_writes);
+      g_mutex_unlock (&sink->writer_lock);
+      break;
+    case PROP_PART_DURATION:
+      g_value_set_uint (value, sink->part_duration);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
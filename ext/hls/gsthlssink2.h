@@ -58,6 +58,25 @@ struct _GstHlsSink2
   GstClockTime current_running_time_start;
   GQueue old_locations;
   GstM3U8PlaylistRenderState state;
+
+  /* Low-Latency HLS parts of the current fragment */
+  guint part_duration;
+  guint64 fragment_bytes;
+  guint64 part_offset;
+  GstClockTime part_start_pts;
+  GstClockTime parts_total_duration;
+  gboolean part_independent;
+
+  /* asynchronous writer, protected by writer_lock */
+  guint max_pending_writes;
+  GThread *writer_thread;
+  GMutex writer_lock;
+  GCond writer_cond;
+  gboolean writer_stopping;
+  gboolean writer_busy;
+  gchar *pending_playlist_location;
+  gchar *pending_playlist_content;
+  GQueue pending_deletions;
 };
 
 struct _GstHlsSink2Class
@@ -33,6 +33,7 @@ enum
 };
 
 typedef struct _GstM3U8Entry GstM3U8Entry;
+typedef struct _GstM3U8Part GstM3U8Part;
 
 struct _GstM3U8Entry
 {
@@ -40,8 +41,26 @@ struct _GstM3U8Entry
   gchar *title;
   gchar *url;
   gboolean discontinuous;
+  /* GstM3U8Part, for Low-Latency HLS */
+  GQueue *parts;
 };
 
+struct _GstM3U8Part
+{
+  gfloat duration;
+  gchar *url;
+  guint64 offset;
+  guint64 size;
+  gboolean independent;
+};
+
+static void
+gst_m3u8_part_free (GstM3U8Part * part)
+{
+  g_free (part->url);
+  g_free (part);
+}
+
 static GstM3U8Entry *
 gst_m3u8_entry_new (const gchar * url, const gchar * title,
     gfloat duration, gboolean discontinuous)
@@ -65,6 +84,10 @@ gst_m3u8_entry_free (GstM3U8Entry * entry)
 
   g_free (entry->url);
   g_free (entry->title);
+  if (entry->parts) {
+    g_queue_foreach (entry->parts, (GFunc) gst_m3u8_part_free, NULL);
+    g_queue_free (entry->parts);
+  }
   g_free (entry);
 }
 
@@ -80,6 +103,7 @@ gst_m3u8_playlist_new (guint version, guint window_size, gboolean allow_cache)
   playlist->type = GST_M3U8_PLAYLIST_TYPE_EVENT;
   playlist->end_list = FALSE;
   playlist->entries = g_queue_new ();
+  playlist->parts = g_queue_new ();
 
   return playlist;
 }
@@ -91,6 +115,8 @@ gst_m3u8_playlist_free (GstM3U8Playlist * playlist)
 
   g_queue_foreach (playlist->entries, (GFunc) gst_m3u8_entry_free, NULL);
   g_queue_free (playlist->entries);
+  g_queue_foreach (playlist->parts, (GFunc) gst_m3u8_part_free, NULL);
+  g_queue_free (playlist->parts);
   g_free (playlist);
 }
 
@@ -110,6 +136,12 @@ gst_m3u8_playlist_add_entry (GstM3U8Playlist * playlist,
 
   entry = gst_m3u8_entry_new (url, title, duration, discontinuous);
 
+  /* The parts written so far make up the new segment */
+  if (!g_queue_is_empty (playlist->parts)) {
+    entry->parts = playlist->parts;
+    playlist->parts = g_queue_new ();
+  }
+
   if (playlist->window_size > 0) {
     /* Delete old entries from the playlist */
     while (playlist->entries->length >= playlist->window_size) {
@@ -126,6 +158,48 @@ gst_m3u8_playlist_add_entry (GstM3U8Playlist * playlist,
   return TRUE;
 }
 
+/* Adds a partial segment of the segment currently being written */
+gboolean
+gst_m3u8_playlist_add_part (GstM3U8Playlist * playlist, const gchar * url,
+    gfloat duration, guint64 offset, guint64 size, gboolean independent)
+{
+  GstM3U8Part *part;
+
+  g_return_val_if_fail (playlist != NULL, FALSE);
+  g_return_val_if_fail (url != NULL, FALSE);
+
+  if (playlist->type == GST_M3U8_PLAYLIST_TYPE_VOD)
+    return FALSE;
+
+  part = g_new0 (GstM3U8Part, 1);
+  part->url = g_strdup (url);
+  part->duration = duration;
+  part->offset = offset;
+  part->size = size;
+  part->independent = independent;
+  g_queue_push_tail (playlist->parts, part);
+
+  return TRUE;
+}
+
+static void
+gst_m3u8_playlist_render_parts (GString * playlist_str, GQueue * parts)
+{
+  GList *l;
+
+  for (l = parts->head; l != NULL; l = l->next) {
+    gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+    GstM3U8Part *part = l->data;
+
+    g_string_append_printf (playlist_str,
+        "#EXT-X-PART:DURATION=%s,URI=\"%s\",BYTERANGE=\"%" G_GUINT64_FORMAT
+        "@%" G_GUINT64_FORMAT "\"%s\n",
+        g_ascii_dtostr (buf, sizeof (buf), part->duration / GST_SECOND),
+        part->url, part->size, part->offset,
+        part->independent ? ",INDEPENDENT=YES" : "");
+  }
+}
+
 static guint
 gst_m3u8_playlist_target_duration (GstM3U8Playlist * playlist)
 {
@@ -147,6 +221,9 @@ gst_m3u8_playlist_render (GstM3U8Playlist * playlist)
 {
   GString *playlist_str;
   GList *l;
+  GList *parts_entry = NULL;
+  gboolean with_parts = FALSE;
+  gdouble parts_start;
 
   g_return_val_if_fail (playlist != NULL, NULL);
 
@@ -163,6 +240,29 @@ gst_m3u8_playlist_render (GstM3U8Playlist * playlist)
 
   g_string_append_printf (playlist_str, "#EXT-X-TARGETDURATION:%u\n",
       gst_m3u8_playlist_target_duration (playlist));
+
+  if (playlist->part_target > 0) {
+    gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+    /* Three part target durations, as recommended by the specification */
+    g_string_append_printf (playlist_str,
+        "#EXT-X-SERVER-CONTROL:PART-HOLD-BACK=%s\n",
+        g_ascii_dtostr (buf, sizeof (buf),
+            (gdouble) (3 * playlist->part_target) / GST_SECOND));
+    g_string_append_printf (playlist_str, "#EXT-X-PART-INF:PART-TARGET=%s\n",
+        g_ascii_dtostr (buf, sizeof (buf),
+            (gdouble) playlist->part_target / GST_SECOND));
+
+    /* Parts are only listed for the segments that are less than three
+     * target durations away from the live edge */
+    parts_start = 3 * gst_m3u8_playlist_target_duration (playlist) *
+        (gdouble) GST_SECOND;
+    for (l = playlist->parts->head; l != NULL; l = l->next)
+      parts_start -= ((GstM3U8Part *) l->data)->duration;
+    for (l = playlist->entries->tail; l != NULL && parts_start > 0; l = l->prev)
+      parts_start -= ((GstM3U8Entry *) l->data)->duration;
+    parts_entry = l ? l->next : playlist->entries->head;
+  }
   g_string_append (playlist_str, "\n");
 
   /* Entries */
@@ -173,6 +273,11 @@ gst_m3u8_playlist_render (GstM3U8Playlist * playlist)
     if (entry->discontinuous)
       g_string_append (playlist_str, "#EXT-X-DISCONTINUITY\n");
 
+    if (l == parts_entry)
+      with_parts = TRUE;
+    if (with_parts && entry->parts)
+      gst_m3u8_playlist_render_parts (playlist_str, entry->parts);
+
     if (playlist->version < 3) {
       g_string_append_printf (playlist_str, "#EXTINF:%d,%s\n",
           (gint) ((entry->duration + 500 * GST_MSECOND) / GST_SECOND),
@@ -186,6 +291,10 @@ gst_m3u8_playlist_render (GstM3U8Playlist * playlist)
     g_string_append_printf (playlist_str, "%s\n", entry->url);
   }
 
+  /* Parts of the segment that is still being written */
+  if (playlist->part_target > 0 && !playlist->end_list)
+    gst_m3u8_playlist_render_parts (playlist_str, playlist->parts);
+
   if (playlist->end_list)
     g_string_append (playlist_str, "#EXT-X-ENDLIST");
 
@@ -36,9 +36,12 @@ struct _GstM3U8Playlist
   gint type;
   gboolean end_list;
   guint sequence_number;
+  /* Low-Latency HLS part target duration in nanoseconds, 0 if disabled */
+  guint64 part_target;
 
   /*< Private >*/
   GQueue *entries;
+  GQueue *parts;
 };
 
 typedef enum
@@ -62,6 +65,13 @@ gboolean          gst_m3u8_playlist_add_entry (GstM3U8Playlist * playlist,
                                                guint             index,
                                                gboolean          discontinuous);
 
+gboolean          gst_m3u8_playlist_add_part (GstM3U8Playlist * playlist,
+                                              const gchar     * url,
+                                              gfloat            duration,
+                                              guint64           offset,
+                                              guint64           size,
+                                              gboolean          independent);
+
 gchar *           gst_m3u8_playlist_render (GstM3U8Playlist * playlist);
 
 G_END_DECLS
@@ -49,6 +49,8 @@ gst_m3u8_new (void)
   m3u8->sequence_position = 0;
   m3u8->highest_sequence_number = -1;
   m3u8->duration = GST_CLOCK_TIME_NONE;
+  m3u8->part_target = GST_CLOCK_TIME_NONE;
+  m3u8->part_hold_back = GST_CLOCK_TIME_NONE;
 
   g_mutex_init (&m3u8->lock);
   m3u8->ref_count = 1;
@@ -107,6 +109,8 @@ gst_m3u8_unref (GstM3U8 * self)
 
     g_list_foreach (self->files, (GFunc) gst_m3u8_media_file_unref, NULL);
     g_list_free (self->files);
+    if (self->partial_file)
+      gst_m3u8_media_file_unref (self->partial_file);
 
     g_free (self->last_data);
     g_mutex_clear (&self->lock);
@@ -147,6 +151,8 @@ gst_m3u8_media_file_unref (GstM3U8MediaFile * self)
   if (g_atomic_int_dec_and_test (&self->ref_count)) {
     if (self->init_file)
       gst_m3u8_init_file_unref (self->init_file);
+    if (self->parts)
+      g_ptr_array_unref (self->parts);
     g_free (self->title);
     g_free (self->uri);
     g_free (self->key);
@@ -284,17 +290,17 @@ parse_attributes (gchar ** ptr, gchar ** a, gchar ** v)
   /* [attribute=value,]* */
 
   *a = *ptr;
-  end = p = g_utf8_strchr (*ptr, -1, ',');
+  end = p = strchr (*ptr, ',');
   if (end) {
-    gchar *q = g_utf8_strchr (*ptr, -1, '"');
+    gchar *q = strchr (*ptr, '"');
     if (q && q < end) {
       /* special case, such as CODECS="avc1.77.30, mp4a.40.2" */
       q = g_utf8_next_char (q);
       if (q) {
-        q = g_utf8_strchr (q, -1, '"');
+        q = strchr (q, '"');
       }
       if (q) {
-        end = p = g_utf8_strchr (q, -1, ',');
+        end = p = strchr (q, ',');
       }
     }
   }
@@ -305,14 +311,14 @@ parse_attributes (gchar ** ptr, gchar ** a, gchar ** v)
     *p = '\0';
   }
 
-  *v = p = g_utf8_strchr (*ptr, -1, '=');
+  *v = p = strchr (*ptr, '=');
   if (*v) {
     *p = '\0';
     *v = g_utf8_next_char (*v);
     if (**v == '"') {
       ve = g_utf8_next_char (*v);
       if (ve) {
-        ve = g_utf8_strchr (ve, -1, '"');
+        ve = strchr (ve, '"');
       }
       if (ve) {
         *v = g_utf8_next_char (*v);
@@ -330,6 +336,65 @@ parse_attributes (gchar ** ptr, gchar ** a, gchar ** v)
   return TRUE;
 }
 
+/* Returns the prefix uri_join() puts in front of relative paths */
+static gchar *
+uri_get_base_dir (const gchar * uri)
+{
+  const gchar *query, *end;
+
+  if (uri == NULL)
+    return NULL;
+
+  query = strchr (uri, '?');
+  if (query)
+    end = g_strrstr_len (uri, query - uri, "/");
+  else
+    end = strrchr (uri, '/');
+
+  return end ? g_strndup (uri, end - uri + 1) : NULL;
+}
+
+/* Whether @file, from the previous version of the playlist, is what parsing
+ * its entry again would give, so that it can be kept as is */
+static gboolean
+gst_m3u8_media_file_is_same (GstM3U8MediaFile * file, GstM3U8MediaFile * prev,
+    const gchar * base_dir, const gchar * uri, GstClockTime duration,
+    const gchar * title, const gchar * key, const guint8 * iv, gint64 size,
+    gint64 offset, gboolean discont, GstM3U8InitFile * init_file)
+{
+  gsize base_len;
+
+  if (file->duration != duration || file->discont != discont || file->parts
+      || g_strcmp0 (file->title, title) != 0 || g_strcmp0 (file->key, key) != 0)
+    return FALSE;
+
+  /* without explicit IV, it's derived from the sequence number */
+  if (key && iv && memcmp (file->iv, iv, sizeof (file->iv)) != 0)
+    return FALSE;
+
+  if (size != -1 && offset == -1)
+    offset = prev ? prev->offset + prev->size : 0;
+  if (file->size != size || (size != -1 && file->offset != offset))
+    return FALSE;
+
+  if ((file->init_file == NULL) != (init_file == NULL))
+    return FALSE;
+  if (init_file && (g_strcmp0 (file->init_file->uri, init_file->uri) != 0
+          || file->init_file->offset != init_file->offset
+          || file->init_file->size != init_file->size))
+    return FALSE;
+
+  /* compare with what uri_join() would give */
+  if (gst_uri_is_valid (uri))
+    return strcmp (file->uri, uri) == 0;
+  if (base_dir == NULL || uri[0] == '/')
+    return FALSE;
+
+  base_len = strlen (base_dir);
+  return strncmp (file->uri, base_dir, base_len) == 0 &&
+      strcmp (file->uri + base_len, uri) == 0;
+}
+
 static gint
 gst_hls_variant_stream_compare_by_bitrate (gconstpointer a, gconstpointer b)
 {
@@ -479,6 +544,139 @@ generate_media_seqnums (GstM3U8 * self, GList * previous_files)
 /*
  * @data: a m3u8 playlist text data, taking ownership
  */
+/* Parses the attributes of an EXT-X-PART or EXT-X-PRELOAD-HINT tag, @prev
+ * is the previous part of the same segment if any */
+static GstM3U8MediaFile *
+gst_m3u8_parse_part (GstM3U8 * self, gchar * data, gint64 sequence,
+    GstM3U8MediaFile * prev, gboolean preload_hint)
+{
+  GstM3U8MediaFile *part;
+  GstClockTime duration;
+  gchar *v, *a, *uri = NULL;
+  gint64 size = -1, offset = -1;
+  gboolean independent = FALSE, gap = FALSE, is_part = TRUE;
+
+  /* hints don't have a duration, assume they'll be as long as announced */
+  duration = preload_hint ? self->part_target : GST_CLOCK_TIME_NONE;
+
+  while (data != NULL && parse_attributes (&data, &a, &v)) {
+    if (strcmp (a, "URI") == 0) {
+      g_free (uri);
+      uri = uri_join (self->base_uri ? self->base_uri : self->uri, v);
+    } else if (strcmp (a, "DURATION") == 0) {
+      gdouble fval;
+
+      if (double_from_string (v, NULL, &fval))
+        duration = fval * (gdouble) GST_SECOND;
+    } else if (strcmp (a, "INDEPENDENT") == 0) {
+      independent = g_ascii_strcasecmp (v, "YES") == 0;
+    } else if (strcmp (a, "GAP") == 0) {
+      gap = g_ascii_strcasecmp (v, "YES") == 0;
+    } else if (strcmp (a, "BYTERANGE") == 0) {
+      if (!int64_from_string (v, &v, &size) ||
+          (*v == '@' && !int64_from_string (v + 1, &v, &offset))) {
+        size = offset = -1;
+      }
+    } else if (strcmp (a, "TYPE") == 0) {
+      is_part = strcmp (v, "PART") == 0;
+    } else if (strcmp (a, "BYTERANGE-START") == 0) {
+      int64_from_string (v, NULL, &offset);
+    } else if (strcmp (a, "BYTERANGE-LENGTH") == 0) {
+      int64_from_string (v, NULL, &size);
+    }
+  }
+
+  if (uri == NULL || !is_part || gap || !GST_CLOCK_TIME_IS_VALID (duration)) {
+    g_free (uri);
+    return NULL;
+  }
+
+  part = gst_m3u8_media_file_new (uri, NULL, duration, sequence);
+  part->independent = independent;
+  part->preload_hint = preload_hint;
+
+  /* without an offset, a byte range follows the previous one of the
+   * same resource */
+  if (offset == -1 && size != -1 && prev && prev->size != -1
+      && g_strcmp0 (prev->uri, uri) == 0)
+    offset = prev->offset + prev->size;
+  part->offset = offset != -1 ? offset : 0;
+  part->size = size;
+
+  return part;
+}
+
+/* call with M3U8_LOCK held.
+ * Starts at the latest independent part (or segment) that is at least
+ * PART-HOLD-BACK away from the end of a low-latency playlist */
+static gboolean
+m3u8_set_low_latency_start (GstM3U8 * self)
+{
+  GstM3U8MediaFile *segment;
+  GList *walk, *segment_link = NULL;
+  GstClockTime hold_back, distance = 0, end;
+  gint i = 0;
+
+  if (!GST_CLOCK_TIME_IS_VALID (self->part_target))
+    return FALSE;
+
+  if (GST_CLOCK_TIME_IS_VALID (self->part_hold_back))
+    hold_back = self->part_hold_back;
+  else
+    hold_back = 3 * self->part_target;
+
+  walk = g_list_last (self->files);
+  segment = self->partial_file;
+  if (segment == NULL && walk) {
+    segment = walk->data;
+    segment_link = walk;
+    walk = walk->prev;
+  }
+
+  while (segment) {
+    if (segment->parts) {
+      for (i = segment->parts->len - 1; i >= 0; i--) {
+        GstM3U8MediaFile *part = g_ptr_array_index (segment->parts, i);
+
+        distance += part->duration;
+        if (distance >= hold_back && (part->independent || i == 0))
+          goto found;
+      }
+    } else {
+      distance += segment->duration;
+      i = 0;
+      if (distance >= hold_back)
+        goto found;
+    }
+
+    if (walk) {
+      segment = walk->data;
+      segment_link = walk;
+      walk = walk->prev;
+    } else {
+      segment = NULL;
+    }
+  }
+
+  return FALSE;
+
+found:
+  end = self->last_file_end;
+  if (self->partial_file)
+    end += self->partial_file->duration;
+
+  self->current_file = segment_link;
+  self->sequence = segment->sequence;
+  self->part = i;
+  self->sequence_position = end > distance ? end - distance : 0;
+
+  GST_DEBUG ("low-latency start at part %u of sequence %" G_GINT64_FORMAT
+      ", %" GST_TIME_FORMAT " from the end", self->part, self->sequence,
+      GST_TIME_ARGS (distance));
+
+  return TRUE;
+}
+
 gboolean
 gst_m3u8_update (GstM3U8 * self, gchar * data)
 {
@@ -491,9 +689,12 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
   guint8 iv[16] = { 0, };
   gint64 size = -1, offset = -1;
   gint64 mediasequence;
-  GList *previous_files = NULL;
+  GList *previous_files = NULL, *previous_walk;
   gboolean have_mediasequence = FALSE;
   GstM3U8InitFile *last_init_file = NULL;
+  GPtrArray *parts = NULL;
+  gchar *base_dir;
+  GstM3U8MediaFile *preload_hint = NULL;
 
   g_return_val_if_fail (self != NULL, FALSE);
   g_return_val_if_fail (data != NULL, FALSE);
@@ -527,7 +728,7 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
   self->last_data = data;
 
   self->current_file = NULL;
-  previous_files = self->files;
+  previous_files = previous_walk = self->files;
   self->files = NULL;
   self->duration = GST_CLOCK_TIME_NONE;
   mediasequence = 0;
@@ -535,17 +736,27 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
   /* By default, allow caching */
   self->allowcache = TRUE;
 
+  if (self->partial_file) {
+    gst_m3u8_media_file_unref (self->partial_file);
+    self->partial_file = NULL;
+  }
+  self->part_target = GST_CLOCK_TIME_NONE;
+  self->part_hold_back = GST_CLOCK_TIME_NONE;
+  self->can_block_reload = FALSE;
+
+  base_dir = uri_get_base_dir (self->base_uri ? self->base_uri : self->uri);
+
   duration = 0;
   title = NULL;
   data += 7;
   while (TRUE) {
     gchar *r;
 
-    end = g_utf8_strchr (data, -1, '\n');
+    end = strchr (data, '\n');
     if (end)
       *end = '\0';
 
-    r = g_utf8_strchr (data, -1, '\r');
+    r = strchr (data, '\r');
     if (r)
       *r = '\0';
 
@@ -555,6 +766,39 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
         goto next_line;
       }
 
+      /* Entries that didn't change since the last update of a live playlist
+       * are kept, instead of building them again */
+      if (have_mediasequence && parts == NULL) {
+        GstM3U8MediaFile *file = NULL;
+
+        while (previous_walk && GST_M3U8_MEDIA_FILE (previous_walk->data)->
+            sequence < mediasequence)
+          previous_walk = previous_walk->next;
+        if (previous_walk)
+          file = previous_walk->data;
+
+        if (file && file->sequence == mediasequence &&
+            gst_m3u8_media_file_is_same (file,
+                self->files ? self->files->data : NULL, base_dir, data,
+                duration, title, current_key, have_iv ? iv : NULL, size,
+                offset, discontinuity, last_init_file)) {
+          mediasequence++;
+          g_free (title);
+          if (preload_hint) {
+            gst_m3u8_media_file_unref (preload_hint);
+            preload_hint = NULL;
+          }
+
+          duration = 0;
+          title = NULL;
+          discontinuity = FALSE;
+          size = offset = -1;
+          self->files =
+              g_list_prepend (self->files, gst_m3u8_media_file_ref (file));
+          goto next_line;
+        }
+      }
+
       data = uri_join (self->base_uri ? self->base_uri : self->uri, data);
       if (data != NULL) {
         GstM3U8MediaFile *file;
@@ -594,6 +838,13 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
         if (last_init_file)
           file->init_file = gst_m3u8_init_file_ref (last_init_file);
 
+        file->parts = parts;
+        parts = NULL;
+        if (preload_hint) {
+          gst_m3u8_media_file_unref (preload_hint);
+          preload_hint = NULL;
+        }
+
         duration = 0;
         title = NULL;
         discontinuity = FALSE;
@@ -649,6 +900,65 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
       } else if (g_str_has_prefix (data_ext_x, "PROGRAM-DATE-TIME:")) {
         /* <YYYY-MM-DDThh:mm:ssZ> */
         GST_DEBUG ("FIXME parse date");
+      } else if (g_str_has_prefix (data_ext_x, "PART-INF:")) {
+        gchar *v, *a;
+
+        data = data + 16;
+        while (data != NULL && parse_attributes (&data, &a, &v)) {
+          gdouble fval;
+
+          if (strcmp (a, "PART-TARGET") == 0
+              && double_from_string (v, NULL, &fval))
+            self->part_target = fval * (gdouble) GST_SECOND;
+        }
+      } else if (g_str_has_prefix (data_ext_x, "SERVER-CONTROL:")) {
+        gchar *v, *a;
+
+        data = data + 22;
+        while (data != NULL && parse_attributes (&data, &a, &v)) {
+          gdouble fval;
+
+          if (strcmp (a, "CAN-BLOCK-RELOAD") == 0) {
+            self->can_block_reload = g_ascii_strcasecmp (v, "YES") == 0;
+          } else if (strcmp (a, "PART-HOLD-BACK") == 0
+              && double_from_string (v, NULL, &fval)) {
+            self->part_hold_back = fval * (gdouble) GST_SECOND;
+          }
+        }
+      } else if (g_str_has_prefix (data_ext_x, "PART:") ||
+          g_str_has_prefix (data_ext_x, "PRELOAD-HINT:")) {
+        gboolean is_hint = g_str_has_prefix (data_ext_x, "PRELOAD-HINT:");
+        GstM3U8MediaFile *prev = NULL, *part;
+
+        if (parts && parts->len > 0)
+          prev = g_ptr_array_index (parts, parts->len - 1);
+
+        part = gst_m3u8_parse_part (self,
+            data_ext_x + (is_hint ? 13 : 5), mediasequence, prev, is_hint);
+        if (part == NULL)
+          goto next_line;
+
+        if (current_key) {
+          /* parts of encrypted segments can't be decrypted on their own */
+          GST_LOG ("Ignoring part of encrypted segment");
+          gst_m3u8_media_file_unref (part);
+          goto next_line;
+        }
+
+        part->discont = discontinuity && (parts == NULL || parts->len == 0);
+        if (last_init_file)
+          part->init_file = gst_m3u8_init_file_ref (last_init_file);
+
+        if (is_hint) {
+          if (preload_hint)
+            gst_m3u8_media_file_unref (preload_hint);
+          preload_hint = part;
+        } else {
+          if (parts == NULL)
+            parts = g_ptr_array_new_with_free_func ((GDestroyNotify)
+                gst_m3u8_media_file_unref);
+          g_ptr_array_add (parts, part);
+        }
       } else if (g_str_has_prefix (data_ext_x, "ALLOW-CACHE:")) {
         self->allowcache = g_ascii_strcasecmp (data + 19, "YES") == 0;
       } else if (g_str_has_prefix (data_ext_x, "KEY:")) {
@@ -766,6 +1076,31 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
 
   g_free (current_key);
   current_key = NULL;
+  g_free (base_dir);
+
+  /* parts after the last segment belong to the one being produced */
+  if (preload_hint) {
+    if (parts == NULL)
+      parts = g_ptr_array_new_with_free_func ((GDestroyNotify)
+          gst_m3u8_media_file_unref);
+    g_ptr_array_add (parts, preload_hint);
+    preload_hint = NULL;
+  }
+  if (parts) {
+    GstClockTime partial_duration = 0;
+    guint i;
+
+    for (i = 0; i < parts->len; i++)
+      partial_duration +=
+          GST_M3U8_MEDIA_FILE (g_ptr_array_index (parts, i))->duration;
+
+    self->partial_file =
+        gst_m3u8_media_file_new (NULL, NULL, partial_duration, mediasequence);
+    self->partial_file->parts = parts;
+    self->partial_file->discont =
+        GST_M3U8_MEDIA_FILE (g_ptr_array_index (parts, 0))->discont;
+    parts = NULL;
+  }
 
   self->files = g_list_reverse (self->files);
 
@@ -845,7 +1180,10 @@ gst_m3u8_update (GstM3U8 * self, gchar * data)
   }
 
   /* first-time setup */
-  if (self->files && self->sequence == -1) {
+  if (self->files && self->sequence == -1 && GST_M3U8_IS_LIVE (self)
+      && m3u8_set_low_latency_start (self)) {
+    GST_DEBUG ("first sequence: %u", (guint) self->sequence);
+  } else if (self->files && self->sequence == -1) {
     GList *file;
 
     if (GST_M3U8_IS_LIVE (self)) {
@@ -917,6 +1255,54 @@ m3u8_find_next_fragment (GstM3U8 * m3u8, gboolean forward)
   return l;
 }
 
+/* call with M3U8_LOCK held.
+ * Returns TRUE if the current segment has to be downloaded part by part,
+ * which is the case while it's still being produced or once some of its
+ * parts were downloaded. @part is then set to the next one, or NULL if
+ * it's not in the playlist yet */
+static gboolean
+m3u8_get_next_part (GstM3U8 * m3u8, GstM3U8MediaFile ** part)
+{
+  *part = NULL;
+
+  while (TRUE) {
+    GstM3U8MediaFile *segment = NULL;
+
+    if (m3u8->partial_file && m3u8->partial_file->sequence == m3u8->sequence) {
+      segment = m3u8->partial_file;
+    } else if (m3u8->part > 0) {
+      if (m3u8->current_file == NULL)
+        m3u8->current_file = m3u8_find_next_fragment (m3u8, TRUE);
+      if (m3u8->current_file &&
+          GST_M3U8_MEDIA_FILE (m3u8->current_file->data)->sequence ==
+          m3u8->sequence)
+        segment = m3u8->current_file->data;
+    }
+
+    if (segment == NULL) {
+      m3u8->part = 0;
+      return FALSE;
+    }
+
+    if (segment->parts && m3u8->part < segment->parts->len) {
+      *part = gst_m3u8_media_file_ref (g_ptr_array_index (segment->parts,
+              m3u8->part));
+      return TRUE;
+    }
+
+    if (segment == m3u8->partial_file)
+      return TRUE;
+
+    /* all the parts of this segment were downloaded, continue with the
+     * next one */
+    GST_DEBUG ("Done with the parts of sequence %" G_GINT64_FORMAT,
+        m3u8->sequence);
+    m3u8->current_file = m3u8->current_file->next;
+    m3u8->sequence++;
+    m3u8->part = 0;
+  }
+}
+
 GstM3U8MediaFile *
 gst_m3u8_get_next_fragment (GstM3U8 * m3u8, gboolean forward,
     GstClockTime * sequence_position, gboolean * discont)
@@ -932,6 +1318,27 @@ gst_m3u8_get_next_fragment (GstM3U8 * m3u8, gboolean forward,
   if (m3u8->sequence < 0)       /* can't happen really */
     goto out;
 
+  m3u8->current_is_part = FALSE;
+  if (forward && m3u8_get_next_part (m3u8, &file)) {
+    if (file == NULL) {
+      GST_DEBUG ("Part %u of sequence %" G_GINT64_FORMAT " not available yet",
+          m3u8->part, m3u8->sequence);
+      goto out;
+    }
+
+    GST_DEBUG ("Got part %u of sequence %" G_GINT64_FORMAT, m3u8->part,
+        m3u8->sequence);
+
+    if (sequence_position)
+      *sequence_position = m3u8->sequence_position;
+    if (discont)
+      *discont = file->discont;
+
+    m3u8->current_file_duration = file->duration;
+    m3u8->current_is_part = TRUE;
+    goto out;
+  }
+
   if (m3u8->current_file == NULL)
     m3u8->current_file = m3u8_find_next_fragment (m3u8, forward);
 
@@ -978,12 +1385,45 @@ gst_m3u8_has_next_fragment (GstM3U8 * m3u8, gboolean forward)
   }
 
   have_next = cur && ((forward && cur->next) || (!forward && cur->prev));
+  if (forward && (m3u8->partial_file || m3u8->part > 0))
+    have_next = TRUE;
 
   GST_M3U8_UNLOCK (m3u8);
 
   return have_next;
 }
 
+/* Returns the media file @n positions after the current one, without
+ * advancing, or NULL if it's not in the playlist (yet) */
+GstM3U8MediaFile *
+gst_m3u8_peek_fragment (GstM3U8 * m3u8, gboolean forward, guint n)
+{
+  GstM3U8MediaFile *file = NULL;
+  GList *cur;
+
+  g_return_val_if_fail (m3u8 != NULL, NULL);
+
+  GST_M3U8_LOCK (m3u8);
+
+  /* the following parts are only known once they're announced */
+  if (m3u8->part > 0 || m3u8->current_is_part)
+    goto out;
+
+  cur = m3u8->current_file;
+  while (cur && n > 0) {
+    cur = forward ? cur->next : cur->prev;
+    n--;
+  }
+
+  if (cur)
+    file = gst_m3u8_media_file_ref (cur->data);
+
+out:
+  GST_M3U8_UNLOCK (m3u8);
+
+  return file;
+}
+
 /* call with M3U8_LOCK held */
 static void
 m3u8_alternate_advance (GstM3U8 * m3u8, gboolean forward)
@@ -1035,6 +1475,14 @@ gst_m3u8_advance_fragment (GstM3U8 * m3u8, gboolean forward)
     GST_DEBUG ("Sequence position now %" GST_TIME_FORMAT,
         GST_TIME_ARGS (m3u8->sequence_position));
   }
+  if (m3u8->current_is_part) {
+    m3u8->current_is_part = FALSE;
+    m3u8->part++;
+    GST_DEBUG ("Advancing to part %u of sequence %" G_GINT64_FORMAT,
+        m3u8->part, m3u8->sequence);
+    goto out;
+  }
+  m3u8->part = 0;
   if (!m3u8->current_file) {
     GList *l;
 
@@ -1138,6 +1586,81 @@ gst_m3u8_get_target_duration (GstM3U8 * m3u8)
   return target_duration;
 }
 
+/* Returns the EXT-X-PART-INF target duration of parts, which is only valid
+ * for low-latency playlists */
+GstClockTime
+gst_m3u8_get_part_target (GstM3U8 * m3u8)
+{
+  GstClockTime part_target;
+
+  g_return_val_if_fail (m3u8 != NULL, GST_CLOCK_TIME_NONE);
+
+  GST_M3U8_LOCK (m3u8);
+  part_target = m3u8->part_target;
+  GST_M3U8_UNLOCK (m3u8);
+
+  return part_target;
+}
+
+gboolean
+gst_m3u8_can_block_reload (GstM3U8 * m3u8)
+{
+  gboolean can_block_reload;
+
+  g_return_val_if_fail (m3u8 != NULL, FALSE);
+
+  GST_M3U8_LOCK (m3u8);
+  can_block_reload = m3u8->can_block_reload && GST_M3U8_IS_LIVE (m3u8);
+  GST_M3U8_UNLOCK (m3u8);
+
+  return can_block_reload;
+}
+
+/* Returns the URI to reload the playlist with, asking the server to hold
+ * the response until the part after the last one listed is available, or
+ * NULL if the server doesn't support blocking reloads */
+gchar *
+gst_m3u8_get_blocking_reload_uri (GstM3U8 * m3u8)
+{
+  gchar *uri = NULL;
+  gint64 msn;
+  guint part = 0;
+
+  g_return_val_if_fail (m3u8 != NULL, NULL);
+
+  GST_M3U8_LOCK (m3u8);
+
+  if (!m3u8->can_block_reload || !GST_M3U8_IS_LIVE (m3u8) ||
+      m3u8->uri == NULL || m3u8->files == NULL)
+    goto out;
+
+  if (m3u8->partial_file) {
+    guint i;
+
+    msn = m3u8->partial_file->sequence;
+    for (i = 0; i < m3u8->partial_file->parts->len; i++) {
+      if (!GST_M3U8_MEDIA_FILE (g_ptr_array_index (m3u8->partial_file->parts,
+                  i))->preload_hint)
+        part++;
+    }
+  } else {
+    msn = GST_M3U8_MEDIA_FILE (g_list_last (m3u8->files)->data)->sequence + 1;
+  }
+
+  if (GST_CLOCK_TIME_IS_VALID (m3u8->part_target)) {
+    uri = g_strdup_printf ("%s%c_HLS_msn=%" G_GINT64_FORMAT "&_HLS_part=%u",
+        m3u8->uri, strchr (m3u8->uri, '?') ? '&' : '?', msn, part);
+  } else {
+    uri = g_strdup_printf ("%s%c_HLS_msn=%" G_GINT64_FORMAT, m3u8->uri,
+        strchr (m3u8->uri, '?') ? '&' : '?', msn);
+  }
+
+out:
+  GST_M3U8_UNLOCK (m3u8);
+
+  return uri;
+}
+
 gchar *
 gst_m3u8_get_uri (GstM3U8 * m3u8)
 {
@@ -1559,11 +2082,11 @@ gst_hls_master_playlist_new_from_data (gchar * data, const gchar * base_uri)
   while (TRUE) {
     gchar *r;
 
-    end = g_utf8_strchr (data, -1, '\n');
+    end = strchr (data, '\n');
     if (end)
       *end = '\0';
 
-    r = g_utf8_strchr (data, -1, '\r');
+    r = strchr (data, '\r');
     if (r)
       *r = '\0';
 
@@ -64,7 +64,14 @@ struct _GstM3U8
   GstClockTime targetduration;  /* last EXT-X-TARGETDURATION */
   gboolean allowcache;          /* last EXT-X-ALLOWCACHE */
 
+  /* Low-Latency HLS */
+  GstClockTime part_target;     /* last EXT-X-PART-INF PART-TARGET */
+  GstClockTime part_hold_back;  /* last EXT-X-SERVER-CONTROL PART-HOLD-BACK */
+  gboolean can_block_reload;    /* last EXT-X-SERVER-CONTROL CAN-BLOCK-RELOAD */
+
   GList *files;
+  GstM3U8MediaFile *partial_file; /* segment still being produced, only made
+                                   * of parts and the preload hint */
 
   /* state */
   GList *current_file;
@@ -76,6 +83,8 @@ struct _GstM3U8
   GstClockTime last_file_end;         /* timecode of the end of the last fragment in the current media playlist */
   GstClockTime duration;              /* cached total duration */
   gint discont_sequence;              /* currently expected EXT-X-DISCONTINUITY-SEQUENCE */
+  guint part;                         /* next part of the sequence, when downloading parts */
+  gboolean current_is_part;           /* if the current fragment is a part of a segment */
 
   /*< private > */
   gchar *last_data;
@@ -101,6 +110,9 @@ struct _GstM3U8MediaFile
   gint64 offset, size;
   gint ref_count;               /* ATOMIC */
   GstM3U8InitFile *init_file;   /* Media Initialization (hold ref) */
+  GPtrArray *parts;             /* EXT-X-PART partial segments, or NULL */
+  gboolean independent;         /* part starts with an independent frame */
+  gboolean preload_hint;        /* part only announced by EXT-X-PRELOAD-HINT */
 };
 
 struct _GstM3U8InitFile
@@ -132,6 +144,10 @@ GstM3U8MediaFile * gst_m3u8_get_next_fragment    (GstM3U8      * m3u8,
 gboolean           gst_m3u8_has_next_fragment    (GstM3U8 * m3u8,
                                                   gboolean  forward);
 
+GstM3U8MediaFile * gst_m3u8_peek_fragment        (GstM3U8 * m3u8,
+                                                  gboolean  forward,
+                                                  guint     n);
+
 void               gst_m3u8_advance_fragment     (GstM3U8 * m3u8,
                                                   gboolean  forward);
 
@@ -139,6 +155,12 @@ GstClockTime       gst_m3u8_get_duration         (GstM3U8 * m3u8);
 
 GstClockTime       gst_m3u8_get_target_duration  (GstM3U8 * m3u8);
 
+GstClockTime       gst_m3u8_get_part_target      (GstM3U8 * m3u8);
+
+gboolean           gst_m3u8_can_block_reload     (GstM3U8 * m3u8);
+
+gchar *            gst_m3u8_get_blocking_reload_uri (GstM3U8 * m3u8);
+
 gchar *            gst_m3u8_get_uri              (GstM3U8 * m3u8);
 
 gboolean           gst_m3u8_is_live              (GstM3U8 * m3u8);
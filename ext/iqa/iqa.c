@@ -33,9 +33,11 @@
  * For each reference frame, IQA will post a message containing
  * a structure named IQA.
  *
- * The only metric supported for now is "dssim", which will be available
+ * The supported metrics are "dssim", which will be available
  * if https://github.com/pornel/dssim was installed on the system
- * at the time that plugin was compiled.
+ * at the time that plugin was compiled, and "psnr", the peak
+ * signal-to-noise ratio over the red, green and blue components in dB.
+ * Identical frames are reported with a PSNR of 100.
  *
  * For each metric activated, this structure will contain another
  * structure, named after the metric.
@@ -49,6 +51,11 @@
  * sink_2\=\(double\)0.0082939683976297474\;",
  * time=(guint64)0;
  *
+ * With #GstIqa:n-threads different from 1, the comparisons of several
+ * consecutive frames are computed concurrently. The messages are still
+ * posted in order, but delayed by up to n-threads - 1 frames, and the
+ * output heat map is the one of the last frame whose comparison finished.
+ *
  * ## Example launch line
  * |[
  * gst-launch-1.0 -m uridecodebin uri=file:///test/file/1 ! iqa name=iqa do-dssim=true \
@@ -63,6 +70,8 @@
 
 #include "iqa.h"
 
+#include <math.h>
+
 #ifdef HAVE_DSSIM
 #include "dssim.h"
 #endif
@@ -76,6 +85,9 @@ GST_DEBUG_CATEGORY_STATIC (gst_iqa_debug);
 
 #define SRC_FORMAT " { RGBA } "
 #define DEFAULT_DSSIM_ERROR_THRESHOLD -1.0
+#define DEFAULT_DO_PSNR FALSE
+#define DEFAULT_N_THREADS 1
+#define PSNR_MAX 100.0
 
 static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
@@ -89,6 +101,8 @@ enum
   PROP_DO_SSIM,
   PROP_SSIM_ERROR_THRESHOLD,
   PROP_MODE,
+  PROP_DO_PSNR,
+  PROP_N_THREADS,
   PROP_LAST,
 };
 
@@ -177,6 +191,57 @@ gst_iqa_mode_flags_get_type (void)
 G_DEFINE_TYPE_WITH_CODE (GstIqa, gst_iqa, GST_TYPE_VIDEO_AGGREGATOR,
     G_IMPLEMENT_INTERFACE (GST_TYPE_CHILD_PROXY, gst_iqa_child_proxy_init));
 
+/* the metrics computed for one compared frame */
+typedef struct
+{
+  gchar *padname;
+  GstVideoFrame frame;
+  gdouble dssim;
+  gdouble psnr;
+#ifdef HAVE_DSSIM
+  /* only kept for the compared frame with the highest dssim, to produce the
+   * heat map */
+  dssim_ssim_map map;
+#endif
+} GstIqaComparison;
+
+/* all the comparisons done against one reference frame */
+typedef struct
+{
+  GstClockTime time;
+  gboolean do_dssim;
+  gboolean do_psnr;
+  gdouble ssim_threshold;
+
+  gboolean has_ref;
+  GstVideoFrame ref;
+  GArray *cmps;
+
+  gboolean done;
+} GstIqaJob;
+
+static void
+gst_iqa_job_free (GstIqaJob * job)
+{
+  guint i;
+
+  for (i = 0; i < job->cmps->len; i++) {
+    GstIqaComparison *cmp = &g_array_index (job->cmps, GstIqaComparison, i);
+
+    g_free (cmp->padname);
+    gst_video_frame_unmap (&cmp->frame);
+#ifdef HAVE_DSSIM
+    free (cmp->map.data);
+#endif
+  }
+  g_array_free (job->cmps, TRUE);
+
+  if (job->has_ref)
+    gst_video_frame_unmap (&job->ref);
+
+  g_free (job);
+}
+
 #ifdef HAVE_DSSIM
 inline static unsigned char
 to_byte (float in)
@@ -188,145 +253,276 @@ to_byte (float in)
   return in * 256.f;
 }
 
-static gboolean
-do_dssim (GstIqa * self, GstVideoFrame * ref, GstVideoFrame * cmp,
-    GstBuffer * outbuf, GstStructure * msg_structure, gchar * padname)
+static dssim_image *
+create_dssim_image (dssim_attr * attr, GstVideoFrame * frame)
 {
-  dssim_attr *attr;
   gint y;
-  unsigned char **ptrs, **ptrs2;
-  GstMapInfo ref_info;
-  GstMapInfo cmp_info;
-  GstMapInfo out_info;
+  guint8 *data = GST_VIDEO_FRAME_PLANE_DATA (frame, 0);
+  gint stride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
+  unsigned char **ptrs;
+  dssim_image *image;
+
+  ptrs = g_malloc (sizeof (char **) * GST_VIDEO_FRAME_HEIGHT (frame));
+
+  for (y = 0; y < GST_VIDEO_FRAME_HEIGHT (frame); y++)
+    ptrs[y] = data + stride * y;
+
+  image = dssim_create_image (attr, ptrs, DSSIM_RGBA,
+      GST_VIDEO_FRAME_WIDTH (frame), GST_VIDEO_FRAME_HEIGHT (frame), 0.45455);
+  g_free (ptrs);
+
+  return image;
+}
+
+static void
+do_dssim (GstVideoFrame * ref, GstIqaComparison * cmp)
+{
+  dssim_attr *attr;
   dssim_image *ref_image;
   dssim_image *cmp_image;
-  double dssim;
-  dssim_ssim_map map_meta;
-  float *map;
-  gint i;
-  dssim_rgba *out;
-  GstStructure *dssim_structure;
-  gboolean ret = TRUE;
-
-  if (ref->info.width != cmp->info.width ||
-      ref->info.height != cmp->info.height) {
-    GST_OBJECT_UNLOCK (self);
-
-    GST_ELEMENT_ERROR (self, STREAM, FAILED,
-        ("Video streams do not have the same sizes (add videoscale"
-            " and force the sizes to be equal on all sink pads.)"),
-        ("Reference width %d - compared width: %d. "
-            "Reference height %d - compared height: %d",
-            ref->info.width, cmp->info.width, ref->info.height,
-            cmp->info.height));
-
-    GST_OBJECT_LOCK (self);
-    return FALSE;
-  }
-
-  gst_structure_get (msg_structure, "dssim", GST_TYPE_STRUCTURE,
-      &dssim_structure, NULL);
 
   attr = dssim_create_attr ();
   dssim_set_save_ssim_maps (attr, 1, 1);
 
-  gst_buffer_map (ref->buffer, &ref_info, GST_MAP_READ);
-  gst_buffer_map (cmp->buffer, &cmp_info, GST_MAP_READ);
+  ref_image = create_dssim_image (attr, ref);
+  cmp_image = create_dssim_image (attr, &cmp->frame);
+
+  cmp->dssim = dssim_compare (attr, ref_image, cmp_image);
+  cmp->map = dssim_pop_ssim_map (attr, 0, 0);
+
+  dssim_dealloc_image (ref_image);
+  dssim_dealloc_image (cmp_image);
+  dssim_dealloc_attr (attr);
+}
+
+static void
+write_heat_map (GstIqaComparison * cmp, GstBuffer * outbuf)
+{
+  GstMapInfo out_info;
+  dssim_rgba *out;
+  float *map = cmp->map.data;
+  gint i;
+
   gst_buffer_map (outbuf, &out_info, GST_MAP_WRITE);
   out = (dssim_rgba *) out_info.data;
 
-  ptrs = g_malloc (sizeof (char **) * ref->info.height);
-
-  for (y = 0; y < ref->info.height; y++) {
-    ptrs[y] = ref_info.data + (ref->info.width * 4 * y);
+  for (i = 0; i < cmp->map.width * cmp->map.height; i++) {
+    const float max = 1.0 - map[i];
+    const float maxsq = max * max;
+    out[i] = (dssim_rgba) {
+    .r = to_byte (max * 3.0),.g = to_byte (maxsq * 6.0),.b =
+          to_byte (max / ((1.0 - cmp->map.dssim) * 4.0)),.a = 255,};
   }
 
-  ref_image =
-      dssim_create_image (attr, ptrs, DSSIM_RGBA, ref->info.width,
-      ref->info.height, 0.45455);
+  gst_buffer_unmap (outbuf, &out_info);
+}
+#endif
 
-  ptrs2 = g_malloc (sizeof (char **) * cmp->info.height);
+/* Peak signal-to-noise ratio over the R, G and B components, identical
+ * frames are reported as PSNR_MAX */
+static gdouble
+do_psnr (GstVideoFrame * ref, GstIqaComparison * cmp)
+{
+  const guint8 *r = GST_VIDEO_FRAME_PLANE_DATA (ref, 0);
+  const guint8 *c = GST_VIDEO_FRAME_PLANE_DATA (&cmp->frame, 0);
+  gint r_stride = GST_VIDEO_FRAME_PLANE_STRIDE (ref, 0);
+  gint c_stride = GST_VIDEO_FRAME_PLANE_STRIDE (&cmp->frame, 0);
+  gint width = GST_VIDEO_FRAME_WIDTH (ref);
+  gint height = GST_VIDEO_FRAME_HEIGHT (ref);
+  guint64 sse = 0;
+  gdouble mse;
+  gint x, y;
+
+  for (y = 0; y < height; y++) {
+    guint64 line = 0;
+
+    /* RGBA, the alpha component is skipped */
+    for (x = 0; x < width * 4; x += 4) {
+      gint d0 = r[x] - c[x];
+      gint d1 = r[x + 1] - c[x + 1];
+      gint d2 = r[x + 2] - c[x + 2];
+
+      line += d0 * d0 + d1 * d1 + d2 * d2;
+    }
 
-  for (y = 0; y < cmp->info.height; y++) {
-    ptrs2[y] = cmp_info.data + (cmp->info.width * 4 * y);
+    sse += line;
+    r += r_stride;
+    c += c_stride;
   }
 
-  cmp_image =
-      dssim_create_image (attr, ptrs2, DSSIM_RGBA, cmp->info.width,
-      cmp->info.height, 0.45455);
-  dssim = dssim_compare (attr, ref_image, cmp_image);
-
-  map_meta = dssim_pop_ssim_map (attr, 0, 0);
-
-  /* Comparing floats... should not be a big deal anyway */
-  if (self->ssim_threshold > 0 && dssim > self->ssim_threshold) {
-    /* We do not really care about our state... we are going to error ou
-     * anyway! */
-    GST_OBJECT_UNLOCK (self);
-
-    GST_ELEMENT_ERROR (self, STREAM, FAILED,
-        ("Dssim check failed on %s at %"
-            GST_TIME_FORMAT " with dssim %f > %f",
-            padname,
-            GST_TIME_ARGS (GST_AGGREGATOR_PAD (GST_AGGREGATOR (self)->
-                    srcpad)->segment.position), dssim, self->ssim_threshold),
-        (NULL));
+  mse = (gdouble) sse / (3.0 * width * height);
+  if (mse == 0.0)
+    return PSNR_MAX;
 
-    GST_OBJECT_LOCK (self);
+  return MIN (PSNR_MAX, 10.0 * log10 (255.0 * 255.0 / mse));
+}
 
-    ret = FALSE;
-    goto cleanup_return;
-  }
+static void
+gst_iqa_job_run (GstIqaJob * job)
+{
+#ifdef HAVE_DSSIM
+  GstIqaComparison *max = NULL;
+#endif
+  guint i;
 
-  if (dssim > self->max_dssim) {
-    map = map_meta.data;
+  for (i = 0; i < job->cmps->len; i++) {
+    GstIqaComparison *cmp = &g_array_index (job->cmps, GstIqaComparison, i);
 
-    for (i = 0; i < map_meta.width * map_meta.height; i++) {
-      const float max = 1.0 - map[i];
-      const float maxsq = max * max;
-      out[i] = (dssim_rgba) {
-      .r = to_byte (max * 3.0),.g = to_byte (maxsq * 6.0),.b =
-            to_byte (max / ((1.0 - map_meta.dssim) * 4.0)),.a = 255,};
+#ifdef HAVE_DSSIM
+    if (job->do_dssim) {
+      do_dssim (&job->ref, cmp);
+
+      if (cmp->dssim > (max ? max->dssim : 0.0)) {
+        if (max) {
+          free (max->map.data);
+          max->map.data = NULL;
+        }
+        max = cmp;
+      } else {
+        free (cmp->map.data);
+        cmp->map.data = NULL;
+      }
     }
-    self->max_dssim = dssim;
+#endif
+
+    if (job->do_psnr)
+      cmp->psnr = do_psnr (&job->ref, cmp);
   }
+}
 
-  gst_structure_set (dssim_structure, padname, G_TYPE_DOUBLE, dssim, NULL);
-  gst_structure_set (msg_structure, "dssim", GST_TYPE_STRUCTURE,
-      dssim_structure, NULL);
+static void
+gst_iqa_job_func (gpointer data, gpointer user_data)
+{
+  GstIqaJob *job = data;
+  GstIqa *self = user_data;
 
-  ret = TRUE;
+  gst_iqa_job_run (job);
 
-cleanup_return:
+  g_mutex_lock (&self->jobs_lock);
+  job->done = TRUE;
+  g_cond_broadcast (&self->jobs_cond);
+  g_mutex_unlock (&self->jobs_lock);
+}
 
-  gst_structure_free (dssim_structure);
+/* Posts the message of a computed job and fills @outbuf with its heat map,
+ * takes ownership of @job */
+static GstFlowReturn
+gst_iqa_job_finish (GstIqa * self, GstIqaJob * job, GstBuffer * outbuf)
+{
+  GstStructure *msg_structure = gst_structure_new_empty ("IQA");
+  GstStructure *dssim_structure = NULL;
+  GstStructure *psnr_structure = NULL;
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint i;
 
-  free (map_meta.data);
-  g_free (ptrs);
-  g_free (ptrs2);
-  gst_buffer_unmap (ref->buffer, &ref_info);
-  gst_buffer_unmap (cmp->buffer, &cmp_info);
-  gst_buffer_unmap (outbuf, &out_info);
-  dssim_dealloc_image (ref_image);
-  dssim_dealloc_image (cmp_image);
-  dssim_dealloc_attr (attr);
+  if (job->do_dssim)
+    dssim_structure = gst_structure_new_empty ("dssim");
+  if (job->do_psnr)
+    psnr_structure = gst_structure_new_empty ("psnr");
+
+  for (i = 0; i < job->cmps->len; i++) {
+    GstIqaComparison *cmp = &g_array_index (job->cmps, GstIqaComparison, i);
+
+#ifdef HAVE_DSSIM
+    if (job->do_dssim) {
+      /* Comparing floats... should not be a big deal anyway */
+      if (job->ssim_threshold > 0 && cmp->dssim > job->ssim_threshold) {
+        GST_ELEMENT_ERROR (self, STREAM, FAILED,
+            ("Dssim check failed on %s at %"
+                GST_TIME_FORMAT " with dssim %f > %f",
+                cmp->padname, GST_TIME_ARGS (job->time), cmp->dssim,
+                job->ssim_threshold), (NULL));
+
+        ret = GST_FLOW_ERROR;
+        goto done;
+      }
+
+      if (cmp->map.data && outbuf)
+        write_heat_map (cmp, outbuf);
+
+      gst_structure_set (dssim_structure, cmp->padname, G_TYPE_DOUBLE,
+          cmp->dssim, NULL);
+    }
+#endif
+
+    if (job->do_psnr)
+      gst_structure_set (psnr_structure, cmp->padname, G_TYPE_DOUBLE,
+          cmp->psnr, NULL);
+  }
+
+  if (dssim_structure)
+    gst_structure_set (msg_structure, "dssim", GST_TYPE_STRUCTURE,
+        dssim_structure, NULL);
+  if (psnr_structure)
+    gst_structure_set (msg_structure, "psnr", GST_TYPE_STRUCTURE,
+        psnr_structure, NULL);
+  gst_structure_set (msg_structure, "time", GST_TYPE_CLOCK_TIME, job->time,
+      NULL);
+
+  gst_element_post_message (GST_ELEMENT (self),
+      gst_message_new_element (GST_OBJECT (self), msg_structure));
+  msg_structure = NULL;
+
+done:
+  if (msg_structure)
+    gst_structure_free (msg_structure);
+  if (dssim_structure)
+    gst_structure_free (dssim_structure);
+  if (psnr_structure)
+    gst_structure_free (psnr_structure);
+  gst_iqa_job_free (job);
 
   return ret;
 }
-#endif
 
-static gboolean
-compare_frames (GstIqa * self, GstVideoFrame * ref, GstVideoFrame * cmp,
-    GstBuffer * outbuf, GstStructure * msg_structure, gchar * padname)
+/* Finishes the queued jobs in order, waiting for them until at most
+ * @max_pending are left in flight */
+static GstFlowReturn
+gst_iqa_finish_jobs (GstIqa * self, GstBuffer * outbuf, guint max_pending)
 {
-#ifdef HAVE_DSSIM
-  if (self->do_dssim) {
-    if (!do_dssim (self, ref, cmp, outbuf, msg_structure, padname))
-      return FALSE;
+  GstIqaJob *job;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  g_mutex_lock (&self->jobs_lock);
+  while ((job = g_queue_peek_head (&self->jobs))) {
+    if (!job->done) {
+      if (g_queue_get_length (&self->jobs) <= max_pending)
+        break;
+      g_cond_wait (&self->jobs_cond, &self->jobs_lock);
+      continue;
+    }
+
+    g_queue_pop_head (&self->jobs);
+    g_mutex_unlock (&self->jobs_lock);
+
+    ret = gst_iqa_job_finish (self, job, outbuf);
+
+    g_mutex_lock (&self->jobs_lock);
+    if (ret != GST_FLOW_OK)
+      break;
   }
-#endif
+  g_mutex_unlock (&self->jobs_lock);
+
+  return ret;
+}
 
-  return TRUE;
+/* Waits for the queued jobs and drops their results */
+static void
+gst_iqa_discard_jobs (GstIqa * self)
+{
+  GstIqaJob *job;
+
+  g_mutex_lock (&self->jobs_lock);
+  while ((job = g_queue_peek_head (&self->jobs))) {
+    if (!job->done) {
+      g_cond_wait (&self->jobs_cond, &self->jobs_lock);
+      continue;
+    }
+
+    g_queue_pop_head (&self->jobs);
+    gst_iqa_job_free (job);
+  }
+  g_mutex_unlock (&self->jobs_lock);
 }
 
 static GstFlowReturn
@@ -335,17 +531,20 @@ gst_iqa_aggregate_frames (GstVideoAggregator * vagg, GstBuffer * outbuf)
   GList *l;
   GstVideoFrame *ref_frame = NULL;
   GstIqa *self = GST_IQA (vagg);
-  GstStructure *msg_structure = gst_structure_new_empty ("IQA");
-  GstMessage *m = gst_message_new_element (GST_OBJECT (self), msg_structure);
   GstAggregator *agg = GST_AGGREGATOR (vagg);
+  GstIqaJob *job;
+  guint n_threads;
 
-  if (self->do_dssim) {
-    gst_structure_set (msg_structure, "dssim", GST_TYPE_STRUCTURE,
-        gst_structure_new_empty ("dssim"), NULL);
-    self->max_dssim = 0.0;
-  }
+  job = g_new0 (GstIqaJob, 1);
+  job->time = GST_AGGREGATOR_PAD (agg->srcpad)->segment.position;
+  job->cmps = g_array_new (FALSE, TRUE, sizeof (GstIqaComparison));
 
   GST_OBJECT_LOCK (vagg);
+  job->do_dssim = self->do_dssim;
+  job->do_psnr = self->do_psnr;
+  job->ssim_threshold = self->ssim_threshold;
+  n_threads = self->n_threads;
+
   for (l = GST_ELEMENT (vagg)->sinkpads; l; l = l->next) {
     GstVideoAggregatorPad *pad = l->data;
     GstVideoFrame *prepared_frame =
@@ -354,17 +553,36 @@ gst_iqa_aggregate_frames (GstVideoAggregator * vagg, GstBuffer * outbuf)
     if (prepared_frame != NULL) {
       if (!ref_frame) {
         ref_frame = prepared_frame;
+        job->has_ref = gst_video_frame_map (&job->ref, &ref_frame->info,
+            ref_frame->buffer, GST_MAP_READ);
+        if (!job->has_ref)
+          goto map_failed;
       } else {
-        gboolean res;
-        gchar *padname = gst_pad_get_name (pad);
-        GstVideoFrame *cmp_frame = prepared_frame;
-
-        res = compare_frames (self, ref_frame, cmp_frame, outbuf, msg_structure,
-            padname);
-        g_free (padname);
-
-        if (!res)
-          goto failed;
+        GstIqaComparison cmp = { NULL, };
+
+        if (ref_frame->info.width != prepared_frame->info.width ||
+            ref_frame->info.height != prepared_frame->info.height) {
+          GST_OBJECT_UNLOCK (vagg);
+
+          GST_ELEMENT_ERROR (self, STREAM, FAILED,
+              ("Video streams do not have the same sizes (add videoscale"
+                  " and force the sizes to be equal on all sink pads.)"),
+              ("Reference width %d - compared width: %d. "
+                  "Reference height %d - compared height: %d",
+                  ref_frame->info.width, prepared_frame->info.width,
+                  ref_frame->info.height, prepared_frame->info.height));
+
+          gst_iqa_job_free (job);
+          return GST_FLOW_ERROR;
+        }
+
+        /* the mapped frames keep a reference to the buffers for as long as
+         * the job is pending */
+        if (!gst_video_frame_map (&cmp.frame, &prepared_frame->info,
+                prepared_frame->buffer, GST_MAP_READ))
+          goto map_failed;
+        cmp.padname = gst_pad_get_name (pad);
+        g_array_append_val (job->cmps, cmp);
       }
     } else if ((self->mode & GST_IQA_MODE_STRICT) && ref_frame) {
       GST_OBJECT_UNLOCK (vagg);
@@ -381,18 +599,74 @@ gst_iqa_aggregate_frames (GstVideoAggregator * vagg, GstBuffer * outbuf)
 
   GST_OBJECT_UNLOCK (vagg);
 
-  /* We only post the message here, because we can't post it while the object
-   * is locked.
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+
+  /* We only post the message from here, because we can't post it while the
+   * object is locked.
    */
-  gst_structure_set (msg_structure, "time", GST_TYPE_CLOCK_TIME,
-      GST_AGGREGATOR_PAD (agg->srcpad)->segment.position, NULL);
-  gst_element_post_message (GST_ELEMENT (self), m);
-  return GST_FLOW_OK;
+  if (n_threads == 1 && g_queue_is_empty (&self->jobs)) {
+    gst_iqa_job_run (job);
+    return gst_iqa_job_finish (self, job, outbuf);
+  }
 
-failed:
-  GST_OBJECT_UNLOCK (vagg);
+  if (!self->pool)
+    self->pool = g_thread_pool_new (gst_iqa_job_func, self, -1, FALSE, NULL);
+
+  g_mutex_lock (&self->jobs_lock);
+  g_queue_push_tail (&self->jobs, job);
+  g_mutex_unlock (&self->jobs_lock);
+  g_thread_pool_push (self->pool, job, NULL);
+
+  /* Keep up to n_threads frames in flight, the output heat map is the one of
+   * the last finished frame */
+  return gst_iqa_finish_jobs (self, outbuf, n_threads - 1);
 
-  return GST_FLOW_ERROR;
+map_failed:
+  {
+    GST_OBJECT_UNLOCK (vagg);
+
+    GST_ELEMENT_ERROR (self, STREAM, FAILED, ("Failed to map video frame"),
+        (NULL));
+
+    gst_iqa_job_free (job);
+    return GST_FLOW_ERROR;
+  }
+}
+
+static GstFlowReturn
+gst_iqa_aggregate (GstAggregator * agg, gboolean timeout)
+{
+  GstIqa *self = GST_IQA (agg);
+  GstFlowReturn ret;
+
+  ret = GST_AGGREGATOR_CLASS (parent_class)->aggregate (agg, timeout);
+
+  /* post the results of the frames still in flight before EOS goes out */
+  if (ret == GST_FLOW_EOS) {
+    GstFlowReturn drain_ret = gst_iqa_finish_jobs (self, NULL, 0);
+
+    if (drain_ret != GST_FLOW_OK)
+      ret = drain_ret;
+  }
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_iqa_flush (GstAggregator * agg)
+{
+  gst_iqa_discard_jobs (GST_IQA (agg));
+
+  return GST_AGGREGATOR_CLASS (parent_class)->flush (agg);
+}
+
+static gboolean
+gst_iqa_stop (GstAggregator * agg)
+{
+  gst_iqa_discard_jobs (GST_IQA (agg));
+
+  return GST_AGGREGATOR_CLASS (parent_class)->stop (agg);
 }
 
 static void
@@ -417,6 +691,16 @@ _set_property (GObject * object, guint prop_id, const GValue * value,
       self->mode = g_value_get_flags (value);
       GST_OBJECT_UNLOCK (self);
       break;
+    case PROP_DO_PSNR:
+      GST_OBJECT_LOCK (self);
+      self->do_psnr = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (self);
+      self->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -445,21 +729,49 @@ _get_property (GObject * object,
       g_value_set_flags (value, self->mode);
       GST_OBJECT_UNLOCK (self);
       break;
+    case PROP_DO_PSNR:
+      GST_OBJECT_LOCK (self);
+      g_value_set_boolean (value, self->do_psnr);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->n_threads);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+static void
+gst_iqa_finalize (GObject * object)
+{
+  GstIqa *self = GST_IQA (object);
+
+  if (self->pool)
+    g_thread_pool_free (self->pool, FALSE, TRUE);
+  g_mutex_clear (&self->jobs_lock);
+  g_cond_clear (&self->jobs_cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 /* GObject boilerplate */
 static void
 gst_iqa_class_init (GstIqaClass * klass)
 {
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   GstElementClass *gstelement_class = (GstElementClass *) klass;
+  GstAggregatorClass *aggregator_class = (GstAggregatorClass *) klass;
   GstVideoAggregatorClass *videoaggregator_class =
       (GstVideoAggregatorClass *) klass;
 
+  aggregator_class->aggregate = gst_iqa_aggregate;
+  aggregator_class->flush = gst_iqa_flush;
+  aggregator_class->stop = gst_iqa_stop;
+
   videoaggregator_class->aggregate_frames = gst_iqa_aggregate_frames;
 
   gst_element_class_add_static_pad_template_with_gtype (gstelement_class,
@@ -469,6 +781,7 @@ gst_iqa_class_init (GstIqaClass * klass)
 
   gobject_class->set_property = _set_property;
   gobject_class->get_property = _get_property;
+  gobject_class->finalize = gst_iqa_finalize;
 
 #ifdef HAVE_DSSIM
   g_object_class_install_property (gobject_class, PROP_DO_SSIM,
@@ -494,6 +807,31 @@ gst_iqa_class_init (GstIqaClass * klass)
           "Controls the frame comparison mode.", GST_TYPE_IQA_MODE,
           0, G_PARAM_READWRITE));
 
+  /**
+   * iqa:do-psnr:
+   *
+   * Compute the peak signal-to-noise ratio of each compared frame.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_DO_PSNR,
+      g_param_spec_boolean ("do-psnr", "do-psnr",
+          "Compute the peak signal-to-noise ratio", DEFAULT_DO_PSNR,
+          G_PARAM_READWRITE));
+
+  /**
+   * iqa:n-threads:
+   *
+   * Maximum number of threads to use, each computing the comparisons of a
+   * different frame. 0 means one thread per processor.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of Threads",
+          "Maximum number of threads to use", 0, G_MAXUINT,
+          DEFAULT_N_THREADS, G_PARAM_READWRITE));
+
   gst_type_mark_as_plugin_api (GST_TYPE_IQA_MODE, 0);
 
   gst_element_class_set_static_metadata (gstelement_class, "Iqa",
@@ -505,6 +843,13 @@ gst_iqa_class_init (GstIqaClass * klass)
 static void
 gst_iqa_init (GstIqa * self)
 {
+  self->ssim_threshold = DEFAULT_DSSIM_ERROR_THRESHOLD;
+  self->do_psnr = DEFAULT_DO_PSNR;
+  self->n_threads = DEFAULT_N_THREADS;
+
+  g_mutex_init (&self->jobs_lock);
+  g_cond_init (&self->jobs_cond);
+  g_queue_init (&self->jobs);
 }
 
 static gboolean
@@ -50,8 +50,15 @@ struct _GstIqa
 
   gboolean do_dssim;
   gdouble ssim_threshold;
-  gdouble max_dssim;
   gint mode;
+  gboolean do_psnr;
+  guint n_threads;
+
+  GThreadPool *pool;
+  GMutex jobs_lock;
+  GCond jobs_cond;
+  /* GstIqaJob, in frame order */
+  GQueue jobs;
 };
 
 struct _GstIqaClass
@@ -105,6 +105,9 @@ static void gst_cv_laplace_get_property (GObject * object, guint prop_id,
 
 static GstFlowReturn gst_cv_laplace_transform (GstOpencvVideoFilter * filter,
     GstBuffer * buf, cv::Mat img, GstBuffer * outbuf, cv::Mat outimg);
+static GstFlowReturn gst_cv_laplace_transform_umat (GstOpencvVideoFilter *
+    filter, GstBuffer * buf, cv::UMat & img, GstBuffer * outbuf,
+    cv::UMat & outimg);
 
 static gboolean gst_cv_laplace_cv_set_caps (GstOpencvVideoFilter * trans,
     gint in_width, gint in_height, int in_cv_type,
@@ -119,6 +122,9 @@ gst_cv_laplace_finalize (GObject * obj)
   filter->intermediary_img.release ();
   filter->cvGray.release ();
   filter->Laplace.release ();
+  filter->intermediary_umat.release ();
+  filter->cvGray_umat.release ();
+  filter->Laplace_umat.release ();
 
   G_OBJECT_CLASS (gst_cv_laplace_parent_class)->finalize (obj);
 }
@@ -139,6 +145,8 @@ gst_cv_laplace_class_init (GstCvLaplaceClass * klass)
   gobject_class->get_property = gst_cv_laplace_get_property;
 
   gstopencvbasefilter_class->cv_trans_func = gst_cv_laplace_transform;
+  gstopencvbasefilter_class->cv_trans_umat_func =
+      gst_cv_laplace_transform_umat;
   gstopencvbasefilter_class->cv_set_caps = gst_cv_laplace_cv_set_caps;
 
   g_object_class_install_property (gobject_class, PROP_APERTURE_SIZE,
@@ -253,24 +261,43 @@ gst_cv_laplace_get_property (GObject * object, guint prop_id,
   }
 }
 
+/* shared by the Mat and UMat paths */
+template < typename M > static void
+gst_cv_laplace_apply (GstCvLaplace * filter, M & img, M & outimg, M & gray,
+    M & intermediary, M & laplace)
+{
+  cv::cvtColor (img, gray, cv::COLOR_RGB2GRAY);
+  cv::Laplacian (gray, intermediary, CV_16S, filter->aperture_size);
+  intermediary.convertTo (laplace, CV_8U, filter->scale, filter->shift);
+
+  outimg.setTo (cv::Scalar::all (0));
+  if (filter->mask) {
+    img.copyTo (outimg, laplace);
+  } else {
+    cv::cvtColor (laplace, outimg, cv::COLOR_GRAY2RGB);
+  }
+}
+
 static GstFlowReturn
 gst_cv_laplace_transform (GstOpencvVideoFilter * base, GstBuffer * buf,
     cv::Mat img, GstBuffer * outbuf, cv::Mat outimg)
 {
   GstCvLaplace *filter = GST_CV_LAPLACE (base);
 
-  cv::cvtColor (img, filter->cvGray, cv::COLOR_RGB2GRAY);
-  cv::Laplacian (filter->cvGray, filter->intermediary_img,
-      filter->intermediary_img.depth (), filter->aperture_size);
-  filter->intermediary_img.convertTo (filter->Laplace, filter->Laplace.type (),
-      filter->scale, filter->shift);
+  gst_cv_laplace_apply (filter, img, outimg, filter->cvGray,
+      filter->intermediary_img, filter->Laplace);
 
-  outimg.setTo (cv::Scalar::all (0));
-  if (filter->mask) {
-    img.copyTo (outimg, filter->Laplace);
-  } else {
-    cv::cvtColor (filter->Laplace, outimg, cv::COLOR_GRAY2RGB);
-  }
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_cv_laplace_transform_umat (GstOpencvVideoFilter * base, GstBuffer * buf,
+    cv::UMat & img, GstBuffer * outbuf, cv::UMat & outimg)
+{
+  GstCvLaplace *filter = GST_CV_LAPLACE (base);
+
+  gst_cv_laplace_apply (filter, img, outimg, filter->cvGray_umat,
+      filter->intermediary_umat, filter->Laplace_umat);
 
   return GST_FLOW_OK;
 }
@@ -75,6 +75,11 @@ struct _GstCvLaplace
   cv::Mat intermediary_img;
   cv::Mat cvGray;
   cv::Mat Laplace;
+
+  /* temporaries of the use-opencl mode */
+  cv::UMat intermediary_umat;
+  cv::UMat cvGray_umat;
+  cv::UMat Laplace_umat;
 };
 
 struct _GstCvLaplaceClass
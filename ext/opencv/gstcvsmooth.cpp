@@ -144,6 +144,8 @@ static void gst_cv_smooth_get_property (GObject * object, guint prop_id,
 
 static GstFlowReturn gst_cv_smooth_transform_ip (GstOpencvVideoFilter *
     filter, GstBuffer * buf, Mat img);
+static GstFlowReturn gst_cv_smooth_transform_ip_umat (GstOpencvVideoFilter *
+    filter, GstBuffer * buf, UMat & img);
 
 /* initialize the cvsmooth's class */
 static void
@@ -162,6 +164,8 @@ gst_cv_smooth_class_init (GstCvSmoothClass * klass)
   gobject_class->get_property = gst_cv_smooth_get_property;
 
   gstopencvbasefilter_class->cv_trans_ip_func = gst_cv_smooth_transform_ip;
+  gstopencvbasefilter_class->cv_trans_ip_umat_func =
+      gst_cv_smooth_transform_ip_umat;
 
   g_object_class_install_property (gobject_class, PROP_SMOOTH_TYPE,
       g_param_spec_enum ("type",
@@ -376,12 +380,10 @@ gst_cv_smooth_get_property (GObject * object, guint prop_id,
   }
 }
 
-static GstFlowReturn
-gst_cv_smooth_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
-    Mat img)
+/* shared by the Mat and UMat paths */
+template < typename M > static void
+gst_cv_smooth_apply (GstCvSmooth * filter, M img)
 {
-  GstCvSmooth *filter = GST_CV_SMOOTH (base);
-
   if (filter->positionx != 0 || filter->positiony != 0 ||
       filter->width != G_MAXINT || filter->height != G_MAXINT) {
     Size mat_size = img.size ();
@@ -389,10 +391,10 @@ gst_cv_smooth_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
     /* if the effect would start outside the image, just skip it */
     if (filter->positionx >= mat_size.width
         || filter->positiony >= mat_size.height)
-      return GST_FLOW_OK;
+      return;
     /* explicitly account for empty area */
     if (filter->width <= 0 || filter->height <= 0)
-      return GST_FLOW_OK;
+      return;
 
     Rect mat_rect (filter->positionx,
         filter->positiony,
@@ -420,6 +422,22 @@ gst_cv_smooth_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
     default:
       break;
   }
+}
+
+static GstFlowReturn
+gst_cv_smooth_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
+    Mat img)
+{
+  gst_cv_smooth_apply (GST_CV_SMOOTH (base), img);
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_cv_smooth_transform_ip_umat (GstOpencvVideoFilter * base,
+    GstBuffer * buf, UMat & img)
+{
+  gst_cv_smooth_apply (GST_CV_SMOOTH (base), img);
 
   return GST_FLOW_OK;
 }
@@ -104,6 +104,9 @@ static void gst_cv_sobel_get_property (GObject * object, guint prop_id,
 
 static GstFlowReturn gst_cv_sobel_transform (GstOpencvVideoFilter * filter,
     GstBuffer * buf, cv::Mat img, GstBuffer * outbuf, cv::Mat outimg);
+static GstFlowReturn gst_cv_sobel_transform_umat (GstOpencvVideoFilter *
+    filter, GstBuffer * buf, cv::UMat & img, GstBuffer * outbuf,
+    cv::UMat & outimg);
 static gboolean gst_cv_sobel_set_caps (GstOpencvVideoFilter * transform,
     gint in_width, gint in_height, int in_cv_type,
     gint out_width, gint out_height, int out_cv_type);
@@ -116,6 +119,8 @@ gst_cv_sobel_finalize (GObject * obj)
 
   filter->cvGray.release ();
   filter->cvSobel.release ();
+  filter->cvGray_umat.release ();
+  filter->cvSobel_umat.release ();
 
   G_OBJECT_CLASS (gst_cv_sobel_parent_class)->finalize (obj);
 }
@@ -136,6 +141,7 @@ gst_cv_sobel_class_init (GstCvSobelClass * klass)
   gobject_class->get_property = gst_cv_sobel_get_property;
 
   gstopencvbasefilter_class->cv_trans_func = gst_cv_sobel_transform;
+  gstopencvbasefilter_class->cv_trans_umat_func = gst_cv_sobel_transform_umat;
   gstopencvbasefilter_class->cv_set_caps = gst_cv_sobel_set_caps;
 
   g_object_class_install_property (gobject_class, PROP_X_ORDER,
@@ -250,22 +256,42 @@ gst_cv_sobel_get_property (GObject * object, guint prop_id,
   }
 }
 
+/* shared by the Mat and UMat paths */
+template < typename M > static void
+gst_cv_sobel_apply (GstCvSobel * filter, M & img, M & outimg, M & gray,
+    M & sobel)
+{
+  cv::cvtColor (img, gray, cv::COLOR_RGB2GRAY);
+  cv::Sobel (gray, sobel, gray.depth (), filter->x_order, filter->y_order,
+      filter->aperture_size);
+
+  outimg.setTo (cv::Scalar::all (0));
+  if (filter->mask) {
+    img.copyTo (outimg, sobel);
+  } else {
+    cv::cvtColor (sobel, outimg, cv::COLOR_GRAY2RGB);
+  }
+}
+
 static GstFlowReturn
 gst_cv_sobel_transform (GstOpencvVideoFilter * base, GstBuffer * buf,
     cv::Mat img, GstBuffer * outbuf, cv::Mat outimg)
 {
   GstCvSobel *filter = GST_CV_SOBEL (base);
 
-  cv::cvtColor (img, filter->cvGray, cv::COLOR_RGB2GRAY);
-  cv::Sobel (filter->cvGray, filter->cvSobel, filter->cvGray.depth (),
-      filter->x_order, filter->y_order, filter->aperture_size);
+  gst_cv_sobel_apply (filter, img, outimg, filter->cvGray, filter->cvSobel);
 
-  outimg.setTo (cv::Scalar::all (0));
-  if (filter->mask) {
-    img.copyTo (outimg, filter->cvSobel);
-  } else {
-    cv::cvtColor (filter->cvSobel, outimg, cv::COLOR_GRAY2RGB);
-  }
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_cv_sobel_transform_umat (GstOpencvVideoFilter * base, GstBuffer * buf,
+    cv::UMat & img, GstBuffer * outbuf, cv::UMat & outimg)
+{
+  GstCvSobel *filter = GST_CV_SOBEL (base);
+
+  gst_cv_sobel_apply (filter, img, outimg, filter->cvGray_umat,
+      filter->cvSobel_umat);
 
   return GST_FLOW_OK;
 }
@@ -74,6 +74,10 @@ struct _GstCvSobel
 
   cv::Mat cvGray;
   cv::Mat cvSobel;
+
+  /* temporaries of the use-opencl mode */
+  cv::UMat cvGray_umat;
+  cv::UMat cvSobel_umat;
 };
 
 struct _GstCvSobelClass
@@ -56,6 +56,13 @@
  * until the size is &lt;= GstFaceDetect::min-size-width or
  * GstFaceDetect::min-size-height.
  *
+ * To bound the CPU usage, the detection can be run on a downscaled frame with
+ * GstFaceDetect::detection-scale, and only every
+ * GstFaceDetect::detection-interval frames. With GstFaceDetect::async, it
+ * runs in a separate thread instead and the video frames are not held back.
+ * Frames without a detection of their own are given the last detected
+ * faces.
+ *
  * ## Example launch line
  *
  * |[
@@ -103,6 +110,9 @@ GST_DEBUG_CATEGORY_STATIC (gst_face_detect_debug);
 #define DEFAULT_MIN_SIZE_WIDTH 30
 #define DEFAULT_MIN_SIZE_HEIGHT 30
 #define DEFAULT_MIN_STDDEV 0
+#define DEFAULT_DETECTION_INTERVAL 1
+#define DEFAULT_DETECTION_SCALE 1.0
+#define DEFAULT_ASYNC FALSE
 
 using namespace cv;
 /* Filter signals and args */
@@ -126,7 +136,10 @@ enum
   PROP_MIN_SIZE_WIDTH,
   PROP_MIN_SIZE_HEIGHT,
   PROP_UPDATES,
-  PROP_MIN_STDDEV
+  PROP_MIN_STDDEV,
+  PROP_DETECTION_INTERVAL,
+  PROP_DETECTION_SCALE,
+  PROP_ASYNC
 };
 
 
@@ -143,19 +156,17 @@ typedef enum
 #define GST_TYPE_OPENCV_FACE_DETECT_FLAGS (gst_opencv_face_detect_flags_get_type())
 
 inline void
-structure_and_message (const vector < Rect > &rectangles, const gchar * name,
-    guint rx, guint ry, GstFaceDetect * filter, GstStructure * s)
+structure_and_message (const Rect & sr, const gchar * name,
+    GstFaceDetect * filter, GstStructure * s)
 {
-  Rect sr = rectangles[0];
   gchar *nx = g_strconcat (name, "->x", NULL);
   gchar *ny = g_strconcat (name, "->y", NULL);
   gchar *nw = g_strconcat (name, "->width", NULL);
   gchar *nh = g_strconcat (name, "->height", NULL);
 
-  GST_LOG_OBJECT (filter,
-      "%s/%" G_GSIZE_FORMAT ": x,y = %4u,%4u: w.h = %4u,%4u",
-      name, rectangles.size (), rx + sr.x, ry + sr.y, sr.width, sr.height);
-  gst_structure_set (s, nx, G_TYPE_UINT, rx + sr.x, ny, G_TYPE_UINT, ry + sr.y,
+  GST_LOG_OBJECT (filter, "%s: x,y = %4u,%4u: w.h = %4u,%4u",
+      name, sr.x, sr.y, sr.width, sr.height);
+  gst_structure_set (s, nx, G_TYPE_UINT, sr.x, ny, G_TYPE_UINT, sr.y,
       nw, G_TYPE_UINT, sr.width, nh, G_TYPE_UINT, sr.height, NULL);
 
   g_free (nx);
@@ -240,6 +251,8 @@ static GstFlowReturn gst_face_detect_transform_ip (GstOpencvVideoFilter * base,
 
 static CascadeClassifier *gst_face_detect_load_profile (GstFaceDetect *
     filter, gchar * profile);
+static gboolean gst_face_detect_stop (GstBaseTransform * trans);
+static void gst_face_detect_reset (GstFaceDetect * filter);
 
 /* Clean up */
 static void
@@ -247,6 +260,14 @@ gst_face_detect_finalize (GObject * obj)
 {
   GstFaceDetect *filter = GST_FACE_DETECT (obj);
 
+  if (filter->pool)
+    g_thread_pool_free (filter->pool, FALSE, TRUE);
+  g_mutex_clear (&filter->detect_lock);
+  g_mutex_clear (&filter->lock);
+  g_cond_clear (&filter->cond);
+  delete filter->faces;
+  delete filter->cvAsyncGray;
+
   filter->cvGray.release ();
 
   g_free (filter->face_profile);
@@ -271,16 +292,20 @@ static void
 gst_face_detect_class_init (GstFaceDetectClass * klass)
 {
   GObjectClass *gobject_class;
+  GstBaseTransformClass *trans_class;
   GstOpencvVideoFilterClass *gstopencvbasefilter_class;
 
   GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
   gobject_class = (GObjectClass *) klass;
+  trans_class = (GstBaseTransformClass *) klass;
   gstopencvbasefilter_class = (GstOpencvVideoFilterClass *) klass;
 
   gobject_class->finalize = GST_DEBUG_FUNCPTR (gst_face_detect_finalize);
   gobject_class->set_property = gst_face_detect_set_property;
   gobject_class->get_property = gst_face_detect_get_property;
 
+  trans_class->stop = GST_DEBUG_FUNCPTR (gst_face_detect_stop);
+
   gstopencvbasefilter_class->cv_trans_ip_func = gst_face_detect_transform_ip;
   gstopencvbasefilter_class->cv_set_caps = gst_face_detect_set_caps;
 
@@ -347,6 +372,47 @@ gst_face_detect_class_init (GstFaceDetectClass * klass)
           "false positives not performing face detection on images with "
           "little changes", 0, 255, DEFAULT_MIN_STDDEV,
           (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+  /**
+   * GstFaceDetect:detection-interval:
+   *
+   * Run the detection every detection-interval frames, the frames in between
+   * get the faces of the last detection.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_DETECTION_INTERVAL,
+      g_param_spec_uint ("detection-interval", "Detection interval",
+          "Run the detection every N frames", 1, G_MAXUINT,
+          DEFAULT_DETECTION_INTERVAL,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+  /**
+   * GstFaceDetect:detection-scale:
+   *
+   * Factor by which the frame is scaled down before running the detection.
+   * The minimum sizes are scaled accordingly, and the detected positions are
+   * reported in frame coordinates.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_DETECTION_SCALE,
+      g_param_spec_double ("detection-scale", "Detection scale",
+          "Factor by which the frame is scaled down for the detection",
+          0.1, 1.0, DEFAULT_DETECTION_SCALE,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+  /**
+   * GstFaceDetect:async:
+   *
+   * Run the detection in a separate thread. Frames are not delayed, they get
+   * the faces of the last finished detection, and a new one starts as soon as
+   * the previous one is done and detection-interval allows it.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_ASYNC,
+      g_param_spec_boolean ("async", "Asynchronous",
+          "Run the detection in a separate thread without delaying frames",
+          DEFAULT_ASYNC,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
   gst_element_class_set_static_metadata (element_class,
       "facedetect",
@@ -379,6 +445,14 @@ gst_face_detect_init (GstFaceDetect * filter)
   filter->min_size_width = DEFAULT_MIN_SIZE_WIDTH;
   filter->min_size_height = DEFAULT_MIN_SIZE_HEIGHT;
   filter->min_stddev = DEFAULT_MIN_STDDEV;
+  filter->detection_interval = DEFAULT_DETECTION_INTERVAL;
+  filter->detection_scale = DEFAULT_DETECTION_SCALE;
+  filter->async = DEFAULT_ASYNC;
+  g_mutex_init (&filter->detect_lock);
+  g_mutex_init (&filter->lock);
+  g_cond_init (&filter->cond);
+  filter->faces = new vector < GstFaceDetectFace >;
+  filter->cvAsyncGray = new Mat;
   filter->cvFaceDetect =
       gst_face_detect_load_profile (filter, filter->face_profile);
   filter->cvNoseDetect =
@@ -401,36 +475,44 @@ gst_face_detect_set_property (GObject * object, guint prop_id,
 
   switch (prop_id) {
     case PROP_FACE_PROFILE:
+      g_mutex_lock (&filter->detect_lock);
       g_free (filter->face_profile);
       if (filter->cvFaceDetect)
         delete (filter->cvFaceDetect);
       filter->face_profile = g_value_dup_string (value);
       filter->cvFaceDetect =
           gst_face_detect_load_profile (filter, filter->face_profile);
+      g_mutex_unlock (&filter->detect_lock);
       break;
     case PROP_NOSE_PROFILE:
+      g_mutex_lock (&filter->detect_lock);
       g_free (filter->nose_profile);
       if (filter->cvNoseDetect)
         delete (filter->cvNoseDetect);
       filter->nose_profile = g_value_dup_string (value);
       filter->cvNoseDetect =
           gst_face_detect_load_profile (filter, filter->nose_profile);
+      g_mutex_unlock (&filter->detect_lock);
       break;
     case PROP_MOUTH_PROFILE:
+      g_mutex_lock (&filter->detect_lock);
       g_free (filter->mouth_profile);
       if (filter->cvMouthDetect)
         delete (filter->cvMouthDetect);
       filter->mouth_profile = g_value_dup_string (value);
       filter->cvMouthDetect =
           gst_face_detect_load_profile (filter, filter->mouth_profile);
+      g_mutex_unlock (&filter->detect_lock);
       break;
     case PROP_EYES_PROFILE:
+      g_mutex_lock (&filter->detect_lock);
       g_free (filter->eyes_profile);
       if (filter->cvEyesDetect)
         delete (filter->cvEyesDetect);
       filter->eyes_profile = g_value_dup_string (value);
       filter->cvEyesDetect =
           gst_face_detect_load_profile (filter, filter->eyes_profile);
+      g_mutex_unlock (&filter->detect_lock);
       break;
     case PROP_DISPLAY:
       filter->display = g_value_get_boolean (value);
@@ -456,6 +538,15 @@ gst_face_detect_set_property (GObject * object, guint prop_id,
     case PROP_UPDATES:
       filter->updates = g_value_get_enum (value);
       break;
+    case PROP_DETECTION_INTERVAL:
+      filter->detection_interval = g_value_get_uint (value);
+      break;
+    case PROP_DETECTION_SCALE:
+      filter->detection_scale = g_value_get_double (value);
+      break;
+    case PROP_ASYNC:
+      filter->async = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -505,6 +596,15 @@ gst_face_detect_get_property (GObject * object, guint prop_id,
     case PROP_UPDATES:
       g_value_set_enum (value, filter->updates);
       break;
+    case PROP_DETECTION_INTERVAL:
+      g_value_set_uint (value, filter->detection_interval);
+      break;
+    case PROP_DETECTION_SCALE:
+      g_value_set_double (value, filter->detection_scale);
+      break;
+    case PROP_ASYNC:
+      g_value_set_boolean (value, filter->async);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -523,11 +623,22 @@ gst_face_detect_set_caps (GstOpencvVideoFilter * transform, gint in_width,
 
   filter = GST_FACE_DETECT (transform);
 
+  /* the last detected faces are for the previous frame size */
+  gst_face_detect_reset (filter);
+
   filter->cvGray.create (Size (in_width, in_height), CV_8UC1);
 
   return TRUE;
 }
 
+static gboolean
+gst_face_detect_stop (GstBaseTransform * trans)
+{
+  gst_face_detect_reset (GST_FACE_DETECT (trans));
+
+  return TRUE;
+}
+
 static GstMessage *
 gst_face_detect_message_new (GstFaceDetect * filter, GstBuffer * buf)
 {
@@ -550,25 +661,207 @@ gst_face_detect_message_new (GstFaceDetect * filter, GstBuffer * buf)
 }
 
 static void
-gst_face_detect_run_detector (GstFaceDetect * filter,
+gst_face_detect_run_detector (GstFaceDetect * filter, Mat & gray,
     CascadeClassifier * detector, gint min_size_width,
     gint min_size_height, Rect r, vector < Rect > &faces)
 {
+  Mat roi (gray, r);
+  detector->detectMultiScale (roi, faces, filter->scale_factor,
+      filter->min_neighbors, filter->flags, Size (min_size_width,
+          min_size_height), Size (0, 0));
+}
+
+/* maps a rectangle of the detection image, @offset relative to a region of
+ * it, back to the frame */
+static inline Rect
+gst_face_detect_frame_rect (const Rect & r, const Rect & offset,
+    gdouble scale)
+{
+  Rect fr (offset.x + r.x, offset.y + r.y, r.width, r.height);
+
+  if (scale == 1.0)
+    return fr;
+
+  return Rect (cvRound (fr.x / scale), cvRound (fr.y / scale),
+      cvRound (fr.width / scale), cvRound (fr.height / scale));
+}
+
+/*
+ * Performs the face and features detection on @gray, a gray version of the
+ * frame scaled by @scale.
+ */
+static void
+gst_face_detect_detect (GstFaceDetect * filter, Mat & gray, gdouble scale,
+    vector < GstFaceDetectFace > &results)
+{
+  Rect frame (0, 0, gray.size ().width, gray.size ().height);
+  vector < Rect > faces;
+  gint min_size_width = filter->min_size_width * scale;
+  gint min_size_height = filter->min_size_height * scale;
+  guint mw = min_size_width / 8;
+  guint mh = min_size_height / 8;
   double img_stddev = 0;
+
+  results.clear ();
+
   if (filter->min_stddev > 0) {
     Scalar mean, stddev;
-    meanStdDev (filter->cvGray, mean, stddev);
+    meanStdDev (gray, mean, stddev);
     img_stddev = stddev.val[0];
   }
-  if (img_stddev >= filter->min_stddev) {
-    Mat roi (filter->cvGray, r);
-    detector->detectMultiScale (roi, faces, filter->scale_factor,
-        filter->min_neighbors, filter->flags, Size (min_size_width,
-            min_size_height), Size (0, 0));
-  } else {
+  if (img_stddev < filter->min_stddev) {
     GST_LOG_OBJECT (filter,
         "Calculated stddev %f lesser than min_stddev %d, detection not performed",
         img_stddev, filter->min_stddev);
+    return;
+  }
+
+  g_mutex_lock (&filter->detect_lock);
+
+  if (filter->cvFaceDetect)
+    gst_face_detect_run_detector (filter, gray, filter->cvFaceDetect,
+        min_size_width, min_size_height, frame, faces);
+
+  for (unsigned int i = 0; i < faces.size (); ++i) {
+    GstFaceDetectFace face;
+    Rect r = faces[i];
+    guint rhh = r.height / 2;
+    vector < Rect > nose;
+    vector < Rect > mouth;
+    vector < Rect > eyes;
+
+    /* detect face features */
+
+    face.have_nose = FALSE;
+    if (filter->cvNoseDetect) {
+      Rect rn (r.x + r.width / 4, r.y + r.height / 4, r.width / 2, rhh);
+
+      gst_face_detect_run_detector (filter, gray, filter->cvNoseDetect, mw, mh,
+          rn, nose);
+      if (!nose.empty ()) {
+        face.have_nose = TRUE;
+        face.nose = gst_face_detect_frame_rect (nose[0], rn, scale);
+      }
+    }
+
+    face.have_mouth = FALSE;
+    if (filter->cvMouthDetect) {
+      Rect rm (r.x, r.y + r.height / 2, r.width, rhh);
+
+      gst_face_detect_run_detector (filter, gray, filter->cvMouthDetect, mw,
+          mh, rm, mouth);
+      if (!mouth.empty ()) {
+        face.have_mouth = TRUE;
+        face.mouth = gst_face_detect_frame_rect (mouth[0], rm, scale);
+      }
+    }
+
+    face.have_eyes = FALSE;
+    if (filter->cvEyesDetect) {
+      Rect re (r.x, r.y, r.width, rhh);
+
+      gst_face_detect_run_detector (filter, gray, filter->cvEyesDetect, mw, mh,
+          re, eyes);
+      if (!eyes.empty ()) {
+        face.have_eyes = TRUE;
+        face.eyes = gst_face_detect_frame_rect (eyes[0], re, scale);
+      }
+    }
+
+    face.r = gst_face_detect_frame_rect (r, Rect (), scale);
+
+    GST_LOG_OBJECT (filter,
+        "%2d/%2" G_GSIZE_FORMAT
+        ": x,y = %4u,%4u: w.h = %4u,%4u : features(e,n,m) = %d,%d,%d", i,
+        faces.size (), face.r.x, face.r.y, face.r.width, face.r.height,
+        face.have_eyes, face.have_nose, face.have_mouth);
+
+    results.push_back (face);
+  }
+
+  g_mutex_unlock (&filter->detect_lock);
+}
+
+static void
+gst_face_detect_async_func (gpointer data, gpointer user_data)
+{
+  GstFaceDetect *filter = GST_FACE_DETECT (data);
+  vector < GstFaceDetectFace > faces;
+
+  gst_face_detect_detect (filter, *filter->cvAsyncGray, filter->async_scale,
+      faces);
+
+  g_mutex_lock (&filter->lock);
+  *filter->faces = faces;
+  filter->detecting = FALSE;
+  g_cond_signal (&filter->cond);
+  g_mutex_unlock (&filter->lock);
+}
+
+/* waits for the async detection, if any, and forgets the last result */
+static void
+gst_face_detect_reset (GstFaceDetect * filter)
+{
+  g_mutex_lock (&filter->lock);
+  while (filter->detecting)
+    g_cond_wait (&filter->cond, &filter->lock);
+  filter->faces->clear ();
+  filter->frames_to_skip = 0;
+  g_mutex_unlock (&filter->lock);
+}
+
+static void
+gst_face_detect_draw (GstFaceDetect * filter, Mat img,
+    const GstFaceDetectFace * face, guint i)
+{
+  const Rect & r = face->r;
+  Point center;
+  Size axes;
+  gdouble w, h;
+  gint cb = 255 - ((i & 3) << 7);
+  gint cg = 255 - ((i & 12) << 5);
+  gint cr = 255 - ((i & 48) << 3);
+
+  w = r.width / 2;
+  h = r.height / 2;
+  center.x = cvRound ((r.x + w));
+  center.y = cvRound ((r.y + h));
+  axes.width = w;
+  axes.height = h * 1.25;       /* tweak for face form */
+  ellipse (img, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 3, 8, 0);
+
+  if (face->have_nose) {
+    const Rect & sr = face->nose;
+
+    w = sr.width / 2;
+    h = sr.height / 2;
+    center.x = cvRound ((sr.x + w));
+    center.y = cvRound ((sr.y + h));
+    axes.width = w;
+    axes.height = h * 1.25;     /* tweak for nose form */
+    ellipse (img, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 1, 8, 0);
+  }
+  if (face->have_mouth) {
+    const Rect & sr = face->mouth;
+
+    w = sr.width / 2;
+    h = sr.height / 2;
+    center.x = cvRound ((sr.x + w));
+    center.y = cvRound ((sr.y + h));
+    axes.width = w * 1.5;       /* tweak for mouth form */
+    axes.height = h;
+    ellipse (img, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 1, 8, 0);
+  }
+  if (face->have_eyes) {
+    const Rect & sr = face->eyes;
+
+    w = sr.width / 2;
+    h = sr.height / 2;
+    center.x = cvRound ((sr.x + w));
+    center.y = cvRound ((sr.y + h));
+    axes.width = w * 1.5;       /* tweak for eyes form */
+    axes.height = h;
+    ellipse (img, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 1, 8, 0);
   }
 }
 
@@ -586,19 +879,54 @@ gst_face_detect_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
     GstStructure *s;
     GValue facelist = { 0 };
     GValue facedata = { 0 };
-    vector < Rect > faces;
-    vector < Rect > mouth;
-    vector < Rect > nose;
-    vector < Rect > eyes;
+    vector < GstFaceDetectFace > faces;
     gboolean post_msg = FALSE;
+    gdouble scale = filter->detection_scale;
+
+    if (filter->frames_to_skip > 0) {
+      filter->frames_to_skip--;
+    } else if (filter->async) {
+      g_mutex_lock (&filter->lock);
+      if (!filter->detecting) {
+        /* the detection works on its own copy of the frame */
+        cvtColor (img, filter->cvGray, COLOR_RGB2GRAY);
+        if (scale < 1.0)
+          resize (filter->cvGray, *filter->cvAsyncGray, Size (), scale, scale,
+              INTER_AREA);
+        else
+          filter->cvGray.copyTo (*filter->cvAsyncGray);
+        filter->async_scale = scale;
+
+        if (!filter->pool)
+          filter->pool = g_thread_pool_new (gst_face_detect_async_func, NULL,
+              1, FALSE, NULL);
+        filter->detecting = TRUE;
+        g_thread_pool_push (filter->pool, filter, NULL);
+        filter->frames_to_skip = filter->detection_interval - 1;
+      }
+      /* otherwise try again on the next frame */
+      g_mutex_unlock (&filter->lock);
+    } else {
+      cvtColor (img, filter->cvGray, COLOR_RGB2GRAY);
+      if (scale < 1.0) {
+        Mat small;
+
+        resize (filter->cvGray, small, Size (), scale, scale, INTER_AREA);
+        gst_face_detect_detect (filter, small, scale, faces);
+      } else {
+        gst_face_detect_detect (filter, filter->cvGray, 1.0, faces);
+      }
 
-    cvtColor (img, filter->cvGray, COLOR_RGB2GRAY);
+      g_mutex_lock (&filter->lock);
+      *filter->faces = faces;
+      g_mutex_unlock (&filter->lock);
+      filter->frames_to_skip = filter->detection_interval - 1;
+    }
 
-    gst_face_detect_run_detector (filter, filter->cvFaceDetect,
-        filter->min_size_width, filter->min_size_height,
-        Rect (0, 0,
-            filter->cvGray.size ().width, filter->cvGray.size ().height),
-        faces);
+    /* frames without a detection hold the last result */
+    g_mutex_lock (&filter->lock);
+    faces = *filter->faces;
+    g_mutex_unlock (&filter->lock);
 
     switch (filter->updates) {
       case GST_FACEDETECT_UPDATES_EVERY_FRAME:
@@ -637,70 +965,21 @@ gst_face_detect_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
     }
 
     for (unsigned int i = 0; i < faces.size (); ++i) {
-      Rect r = faces[i];
-      guint mw = filter->min_size_width / 8;
-      guint mh = filter->min_size_height / 8;
-      guint rnx = 0, rny = 0, rnw, rnh;
-      guint rmx = 0, rmy = 0, rmw, rmh;
-      guint rex = 0, rey = 0, rew, reh;
-      guint rhh = r.height / 2;
-      gboolean have_nose, have_mouth, have_eyes;
-
-      /* detect face features */
-
-      if (filter->cvNoseDetect) {
-        rnx = r.x + r.width / 4;
-        rny = r.y + r.height / 4;
-        rnw = r.width / 2;
-        rnh = rhh;
-        gst_face_detect_run_detector (filter, filter->cvNoseDetect, mw, mh,
-            Rect (rnx, rny, rnw, rnh), nose);
-        have_nose = !nose.empty ();
-      } else {
-        have_nose = FALSE;
-      }
+      const GstFaceDetectFace *face = &faces[i];
+      const Rect & r = face->r;
 
-      if (filter->cvMouthDetect) {
-        rmx = r.x;
-        rmy = r.y + r.height / 2;
-        rmw = r.width;
-        rmh = rhh;
-        gst_face_detect_run_detector (filter, filter->cvMouthDetect, mw,
-            mh, Rect (rmx, rmy, rmw, rmh), mouth);
-        have_mouth = !mouth.empty ();
-      } else {
-        have_mouth = FALSE;
-      }
-
-      if (filter->cvEyesDetect) {
-        rex = r.x;
-        rey = r.y;
-        rew = r.width;
-        reh = rhh;
-        gst_face_detect_run_detector (filter, filter->cvEyesDetect, mw, mh,
-            Rect (rex, rey, rew, reh), eyes);
-        have_eyes = !eyes.empty ();
-      } else {
-        have_eyes = FALSE;
-      }
-
-      GST_LOG_OBJECT (filter,
-          "%2d/%2" G_GSIZE_FORMAT
-          ": x,y = %4u,%4u: w.h = %4u,%4u : features(e,n,m) = %d,%d,%d", i,
-          faces.size (), r.x, r.y, r.width, r.height, have_eyes, have_nose,
-          have_mouth);
       if (post_msg) {
         s = gst_structure_new ("face",
             "x", G_TYPE_UINT, r.x,
             "y", G_TYPE_UINT, r.y,
             "width", G_TYPE_UINT, r.width,
             "height", G_TYPE_UINT, r.height, NULL);
-        if (have_nose)
-          structure_and_message (nose, "nose", rnx, rny, filter, s);
-        if (have_mouth)
-          structure_and_message (mouth, "mouth", rmx, rmy, filter, s);
-        if (have_eyes)
-          structure_and_message (eyes, "eyes", rex, rey, filter, s);
+        if (face->have_nose)
+          structure_and_message (face->nose, "nose", filter, s);
+        if (face->have_mouth)
+          structure_and_message (face->mouth, "mouth", filter, s);
+        if (face->have_eyes)
+          structure_and_message (face->eyes, "eyes", filter, s);
 
         g_value_init (&facedata, GST_TYPE_STRUCTURE);
         g_value_take_boxed (&facedata, s);
@@ -709,56 +988,9 @@ gst_face_detect_transform_ip (GstOpencvVideoFilter * base, GstBuffer * buf,
         s = NULL;
       }
 
-      if (filter->display) {
-        Point center;
-        Size axes;
-        gdouble w, h;
-        gint cb = 255 - ((i & 3) << 7);
-        gint cg = 255 - ((i & 12) << 5);
-        gint cr = 255 - ((i & 48) << 3);
-
-        w = r.width / 2;
-        h = r.height / 2;
-        center.x = cvRound ((r.x + w));
-        center.y = cvRound ((r.y + h));
-        axes.width = w;
-        axes.height = h * 1.25; /* tweak for face form */
-        ellipse (img, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 3, 8, 0);
-
-        if (have_nose) {
-          Rect sr = nose[0];
-
-          w = sr.width / 2;
-          h = sr.height / 2;
-          center.x = cvRound ((rnx + sr.x + w));
-          center.y = cvRound ((rny + sr.y + h));
-          axes.width = w;
-          axes.height = h * 1.25;       /* tweak for nose form */
-          ellipse (img, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 1, 8, 0);
-        }
-        if (have_mouth) {
-          Rect sr = mouth[0];
-
-          w = sr.width / 2;
-          h = sr.height / 2;
-          center.x = cvRound ((rmx + sr.x + w));
-          center.y = cvRound ((rmy + sr.y + h));
-          axes.width = w * 1.5; /* tweak for mouth form */
-          axes.height = h;
-          ellipse (img, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 1, 8, 0);
-        }
-        if (have_eyes) {
-          Rect sr = eyes[0];
-
-          w = sr.width / 2;
-          h = sr.height / 2;
-          center.x = cvRound ((rex + sr.x + w));
-          center.y = cvRound ((rey + sr.y + h));
-          axes.width = w * 1.5; /* tweak for eyes form */
-          axes.height = h;
-          ellipse (img, center, axes, 0, 0, 360, Scalar (cr, cg, cb), 1, 8, 0);
-        }
-      }
+      if (filter->display)
+        gst_face_detect_draw (filter, img, face, i);
+
       gst_buffer_add_video_region_of_interest_meta (buf, "face",
           (guint) r.x, (guint) r.y, (guint) r.width, (guint) r.height);
     }
@@ -52,6 +52,7 @@
 #include <gst/gst.h>
 #include <gst/opencv/gstopencvvideofilter.h>
 #include <opencv2/objdetect.hpp>
+#include <vector>
 
 G_BEGIN_DECLS
 /* #defines don't like whitespacey bits */
@@ -84,6 +85,18 @@ enum _GstFaceDetectUpdates {
   GST_FACEDETECT_UPDATES_NONE             = 3
 };
 
+/* a detected face and its features, in frame coordinates */
+typedef struct _GstFaceDetectFace
+{
+  cv::Rect r;
+  gboolean have_nose;
+  gboolean have_mouth;
+  gboolean have_eyes;
+  cv::Rect nose;
+  cv::Rect mouth;
+  cv::Rect eyes;
+} GstFaceDetectFace;
+
 struct _GstFaceDetect
 {
   GstOpencvVideoFilter element;
@@ -102,6 +115,26 @@ struct _GstFaceDetect
   gint min_size_height;
   gint min_stddev;
   gint updates;
+  guint detection_interval;
+  gdouble detection_scale;
+  gboolean async;
+
+  /* frames left before the next detection */
+  guint frames_to_skip;
+
+  /* held while a detection runs, and when replacing the classifiers */
+  GMutex detect_lock;
+
+  /* protects faces and detecting */
+  GMutex lock;
+  GCond cond;
+  GThreadPool *pool;
+  gboolean detecting;
+  /* the result of the last detection */
+  std::vector < GstFaceDetectFace > *faces;
+  /* the downscaled gray frame being processed by the async detection */
+  cv::Mat *cvAsyncGray;
+  gdouble async_scale;
 
   cv::Mat cvGray;
   cv::CascadeClassifier *cvFaceDetect;
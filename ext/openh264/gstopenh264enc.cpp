@@ -110,6 +110,8 @@ gst_openh264enc_slice_mode_get_type (void)
     {GST_OPENH264_SLICE_MODE_N_SLICES, "Fixed number of slices", "n-slices"},
     {GST_OPENH264_SLICE_MODE_AUTO,
         "Number of slices equal to number of threads", "auto"},
+    {GST_OPENH264_SLICE_MODE_MAX_SIZE,
+        "Slices limited to max-slice-size bytes", "max-size"},
     {0, NULL, NULL},
   };
   static gsize id = 0;
@@ -281,7 +283,8 @@ gst_openh264enc_class_init (GstOpenh264EncClass * klass)
 
   g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_MULTI_THREAD,
       g_param_spec_uint ("multi-thread", "Number of threads",
-          "The number of threads.",
+          "The number of threads (0 = automatic, 1 = single threaded)."
+          " Threads encode separate slices, see slice-mode and num-slices",
           0, G_MAXUINT, DEFAULT_MULTI_THREAD,
           (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
@@ -327,7 +330,8 @@ gst_openh264enc_class_init (GstOpenh264EncClass * klass)
 
   g_object_class_install_property (gobject_class, PROP_MAX_SLICE_SIZE,
       g_param_spec_uint ("max-slice-size", "Max slice size",
-          "The maximum size of one slice (in bytes).",
+          "The maximum size of one slice (in bytes, "
+          "needs slice-mode=max-size)",
           0, G_MAXUINT, DEFAULT_MAX_SLICE_SIZE,
           (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
@@ -805,6 +809,12 @@ gst_openh264enc_set_format (GstVideoEncoder * encoder,
 #else
     slice_mode = SM_FIXEDSLCNUM_SLICE;
     n_slices = 0;
+#endif
+  } else if (openh264enc->slice_mode == GST_OPENH264_SLICE_MODE_MAX_SIZE) {
+#if OPENH264_MAJOR == 1 && OPENH264_MINOR < 6
+    slice_mode = SM_DYN_SLICE;
+#else
+    slice_mode = SM_SIZELIMITED_SLICE;
 #endif
   } else {
     GST_ERROR_OBJECT (openh264enc, "unexpected slice mode %d",
@@ -815,9 +825,13 @@ gst_openh264enc_set_format (GstVideoEncoder * encoder,
 #if OPENH264_MAJOR == 1 && OPENH264_MINOR < 6
   enc_params.sSpatialLayers[0].sSliceCfg.uiSliceMode = slice_mode;
   enc_params.sSpatialLayers[0].sSliceCfg.sSliceArgument.uiSliceNum = n_slices;
+  enc_params.sSpatialLayers[0].sSliceCfg.sSliceArgument.uiSliceSizeConstraint =
+      openh264enc->max_slice_size;
 #else
   enc_params.sSpatialLayers[0].sSliceArgument.uiSliceMode = slice_mode;
   enc_params.sSpatialLayers[0].sSliceArgument.uiSliceNum = n_slices;
+  enc_params.sSpatialLayers[0].sSliceArgument.uiSliceSizeConstraint =
+      openh264enc->max_slice_size;
 #endif
 
   openh264enc->framerate = (1 + fps_n / fps_d);
@@ -857,6 +871,7 @@ gst_openh264enc_handle_frame (GstVideoEncoder * encoder,
     GstVideoCodecFrame * frame)
 {
   GstOpenh264Enc *openh264enc = GST_OPENH264ENC (encoder);
+  SSourcePicture src_pic_storage;
   SSourcePicture *src_pic = NULL;
   GstVideoFrame video_frame;
   gboolean force_keyframe;
@@ -899,13 +914,9 @@ gst_openh264enc_handle_frame (GstVideoEncoder * encoder,
   GST_OBJECT_UNLOCK (openh264enc);
 
   if (frame) {
-    src_pic = new SSourcePicture;
+    src_pic = &src_pic_storage;
+    memset (src_pic, 0, sizeof (SSourcePicture));
 
-    if (src_pic == NULL) {
-      if (frame)
-        gst_video_codec_frame_unref (frame);
-      return GST_FLOW_ERROR;
-    }
     //fill default src_pic
     src_pic->iColorFormat = videoFormatI420;
     src_pic->uiTimeStamp = frame->pts / GST_MSECOND;
@@ -929,8 +940,16 @@ gst_openh264enc_handle_frame (GstVideoEncoder * encoder,
   }
 
   if (frame) {
-    gst_video_frame_map (&video_frame, &openh264enc->input_state->info,
-        frame->input_buffer, GST_MAP_READ);
+    /* the planes are handed to openh264 with the strides of the input
+     * buffer's video meta, so buffers from any upstream pool are encoded
+     * without a copy */
+    if (!gst_video_frame_map (&video_frame, &openh264enc->input_state->info,
+            frame->input_buffer, GST_MAP_READ)) {
+      GST_ELEMENT_ERROR (openh264enc, STREAM, ENCODE,
+          ("Could not map input frame"), (NULL));
+      gst_video_codec_frame_unref (frame);
+      return GST_FLOW_ERROR;
+    }
     src_pic->iPicWidth = GST_VIDEO_FRAME_WIDTH (&video_frame);
     src_pic->iPicHeight = GST_VIDEO_FRAME_HEIGHT (&video_frame);
     src_pic->iStride[0] = GST_VIDEO_FRAME_COMP_STRIDE (&video_frame, 0);
@@ -954,7 +973,6 @@ gst_openh264enc_handle_frame (GstVideoEncoder * encoder,
     if (frame) {
       gst_video_frame_unmap (&video_frame);
       gst_video_codec_frame_unref (frame);
-      delete src_pic;
       GST_ELEMENT_ERROR (openh264enc, STREAM, ENCODE,
           ("Could not encode frame"), ("Openh264 returned %d", ret));
       return GST_FLOW_ERROR;
@@ -967,7 +985,6 @@ gst_openh264enc_handle_frame (GstVideoEncoder * encoder,
     if (frame) {
       gst_video_frame_unmap (&video_frame);
       gst_video_encoder_finish_frame (encoder, frame);
-      delete src_pic;
     }
 
     return GST_FLOW_OK;
@@ -976,7 +993,6 @@ gst_openh264enc_handle_frame (GstVideoEncoder * encoder,
   if (frame) {
     gst_video_frame_unmap (&video_frame);
     gst_video_codec_frame_unref (frame);
-    delete src_pic;
     src_pic = NULL;
     frame = NULL;
   }
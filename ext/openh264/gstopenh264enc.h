@@ -50,6 +50,7 @@ typedef enum _GstOpenh264encDeblockingMode
 typedef enum
 {
   GST_OPENH264_SLICE_MODE_N_SLICES = 1,  /* SM_FIXEDSLCNUM_SLICE */
+  GST_OPENH264_SLICE_MODE_MAX_SIZE = 3,  /* SM_SIZELIMITED_SLICE */
   GST_OPENH264_SLICE_MODE_AUTO = 5       /* former SM_AUTO_SLICE */
 } GstOpenh264EncSliceMode;
 
@@ -36,10 +36,12 @@ enum
 {
   PROP_0,
   PROP_MAX_THREADS,
+  PROP_FRAME_THREADS,
   PROP_LAST
 };
 
 #define GST_OPENJPEG_DEC_DEFAULT_MAX_THREADS		0
+#define GST_OPENJPEG_DEC_DEFAULT_FRAME_THREADS		1
 
 static gboolean gst_openjpeg_dec_start (GstVideoDecoder * decoder);
 static gboolean gst_openjpeg_dec_stop (GstVideoDecoder * decoder);
@@ -47,12 +49,15 @@ static gboolean gst_openjpeg_dec_set_format (GstVideoDecoder * decoder,
     GstVideoCodecState * state);
 static GstFlowReturn gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
     GstVideoCodecFrame * frame);
+static GstFlowReturn gst_openjpeg_dec_finish (GstVideoDecoder * decoder);
+static gboolean gst_openjpeg_dec_flush (GstVideoDecoder * decoder);
 static gboolean gst_openjpeg_dec_decide_allocation (GstVideoDecoder * decoder,
     GstQuery * query);
 static void gst_openjpeg_dec_set_property (GObject * object,
     guint prop_id, const GValue * value, GParamSpec * pspec);
 static void gst_openjpeg_dec_get_property (GObject * object,
     guint prop_id, GValue * value, GParamSpec * pspec);
+static void gst_openjpeg_dec_finalize (GObject * object);
 
 
 #if G_BYTE_ORDER == G_LITTLE_ENDIAN
@@ -111,9 +116,13 @@ gst_openjpeg_dec_class_init (GstOpenJPEGDecClass * klass)
       GST_DEBUG_FUNCPTR (gst_openjpeg_dec_set_format);
   video_decoder_class->handle_frame =
       GST_DEBUG_FUNCPTR (gst_openjpeg_dec_handle_frame);
+  video_decoder_class->finish = GST_DEBUG_FUNCPTR (gst_openjpeg_dec_finish);
+  video_decoder_class->drain = GST_DEBUG_FUNCPTR (gst_openjpeg_dec_finish);
+  video_decoder_class->flush = GST_DEBUG_FUNCPTR (gst_openjpeg_dec_flush);
   video_decoder_class->decide_allocation = gst_openjpeg_dec_decide_allocation;
   gobject_class->set_property = gst_openjpeg_dec_set_property;
   gobject_class->get_property = gst_openjpeg_dec_get_property;
+  gobject_class->finalize = gst_openjpeg_dec_finalize;
 
   /**
    * GstOpenJPEGDec:max-threads:
@@ -128,6 +137,25 @@ gst_openjpeg_dec_class_init (GstOpenJPEGDecClass * klass)
           0, G_MAXINT, GST_OPENJPEG_DEC_DEFAULT_MAX_THREADS,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstOpenJPEGDec:frame-threads:
+   *
+   * Number of consecutive frames decoded in parallel, each with its own
+   * OpenJPEG codec instance. This helps streams with a single tile per
+   * frame, where #GstOpenJPEGDec:max-threads has no effect, at the cost of
+   * frame-threads - 1 frames of latency. (0 = one per CPU core)
+   *
+   * When #GstOpenJPEGDec:max-threads is 0, the cores are split between the
+   * frame threads. Changes take effect when the element is next started.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_FRAME_THREADS,
+      g_param_spec_int ("frame-threads", "Frame decode threads",
+          "Number of frames to decode in parallel. (0 = auto)",
+          0, G_MAXINT, GST_OPENJPEG_DEC_DEFAULT_FRAME_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   GST_DEBUG_CATEGORY_INIT (gst_openjpeg_dec_debug, "openjpegdec", 0,
       "OpenJPEG Decoder");
 }
@@ -145,7 +173,23 @@ gst_openjpeg_dec_init (GstOpenJPEGDec * self)
   opj_set_default_decoder_parameters (&self->params);
   self->sampling = GST_JPEG2000_SAMPLING_NONE;
   self->max_threads = GST_OPENJPEG_DEC_DEFAULT_MAX_THREADS;
+  self->frame_threads = GST_OPENJPEG_DEC_DEFAULT_FRAME_THREADS;
+  self->n_frame_threads = 1;
   self->num_procs = g_get_num_processors ();
+  g_queue_init (&self->pending_jobs);
+  g_mutex_init (&self->job_lock);
+  g_cond_init (&self->job_cond);
+}
+
+static void
+gst_openjpeg_dec_finalize (GObject * object)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (object);
+
+  g_mutex_clear (&self->job_lock);
+  g_cond_clear (&self->job_cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
 static gboolean
@@ -155,6 +199,26 @@ gst_openjpeg_dec_start (GstVideoDecoder * decoder)
 
   GST_DEBUG_OBJECT (self, "Starting");
 
+  self->n_frame_threads = g_atomic_int_get (&self->frame_threads);
+  if (self->n_frame_threads == 0)
+    self->n_frame_threads = self->num_procs;
+
+  if (self->n_frame_threads > 1) {
+    GError *err = NULL;
+
+    self->frame_pool = g_thread_pool_new (gst_openjpeg_dec_decode_func, self,
+        self->n_frame_threads, FALSE, &err);
+    if (!self->frame_pool) {
+      GST_WARNING_OBJECT (self, "Failed to create frame threads: %s",
+          err->message);
+      g_clear_error (&err);
+      self->n_frame_threads = 1;
+    }
+  }
+
+  GST_DEBUG_OBJECT (self, "Decoding with %d frame threads",
+      self->n_frame_threads);
+
   return TRUE;
 }
 
@@ -165,6 +229,13 @@ gst_openjpeg_dec_stop (GstVideoDecoder * video_decoder)
 
   GST_DEBUG_OBJECT (self, "Stopping");
 
+  gst_openjpeg_dec_discard_pending (self);
+  if (self->frame_pool) {
+    g_thread_pool_free (self->frame_pool, FALSE, TRUE);
+    self->frame_pool = NULL;
+  }
+  self->n_frame_threads = 1;
+
   if (self->output_state) {
     gst_video_codec_state_unref (self->output_state);
     self->output_state = NULL;
@@ -191,6 +262,9 @@ gst_openjpeg_dec_set_property (GObject * object,
     case PROP_MAX_THREADS:
       g_atomic_int_set (&dec->max_threads, g_value_get_int (value));
       break;
+    case PROP_FRAME_THREADS:
+      g_atomic_int_set (&dec->frame_threads, g_value_get_int (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -207,6 +281,9 @@ gst_openjpeg_dec_get_property (GObject * object,
     case PROP_MAX_THREADS:
       g_value_set_int (value, g_atomic_int_get (&dec->max_threads));
       break;
+    case PROP_FRAME_THREADS:
+      g_value_set_int (value, g_atomic_int_get (&dec->frame_threads));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -257,6 +334,15 @@ gst_openjpeg_dec_set_format (GstVideoDecoder * decoder,
     gst_video_codec_state_unref (self->input_state);
   self->input_state = gst_video_codec_state_ref (state);
 
+  /* frames only leave once all frame threads are busy */
+  if (self->n_frame_threads > 1 && state->info.fps_n > 0 &&
+      state->info.fps_d > 0) {
+    GstClockTime latency = gst_util_uint64_scale (self->n_frame_threads - 1,
+        state->info.fps_d * GST_SECOND, state->info.fps_n);
+
+    gst_video_decoder_set_latency (decoder, latency, latency);
+  }
+
   return TRUE;
 }
 
@@ -1106,36 +1192,60 @@ seek_fn (OPJ_OFF_T p_nb_bytes, void *p_user_data)
   return OPJ_TRUE;
 }
 
-static GstFlowReturn
-gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
-    GstVideoCodecFrame * frame)
+typedef enum
+{
+  GST_OPENJPEG_DEC_JOB_OK,
+  GST_OPENJPEG_DEC_JOB_INIT_ERROR,
+  GST_OPENJPEG_DEC_JOB_MAP_ERROR,
+  GST_OPENJPEG_DEC_JOB_OPEN_ERROR,
+  GST_OPENJPEG_DEC_JOB_DECODE_ERROR,
+} GstOpenJPEGDecJobResult;
+
+/* one frame to decode, either directly from handle_frame() or by one of
+ * the frame threads. Everything the decoding needs is copied from the
+ * element when submitting so the job is independent of later caps */
+typedef struct
+{
+  GstVideoCodecFrame *frame;
+  OPJ_CODEC_FORMAT codec_format;
+  gboolean is_jp2c;
+  gint ncomps;
+  gint n_threads;
+
+  opj_image_t *image;
+  GstOpenJPEGDecJobResult result;
+  gboolean done;                /* protected by job_lock */
+} GstOpenJPEGDecJob;
+
+static void
+gst_openjpeg_dec_job_free (GstOpenJPEGDecJob * job)
+{
+  if (job->image)
+    opj_image_destroy (job->image);
+  if (job->frame)
+    gst_video_codec_frame_unref (job->frame);
+  g_slice_free (GstOpenJPEGDecJob, job);
+}
+
+/* Called without the stream lock from the frame threads. Only touches
+ * the job and the immutable decoder parameters */
+static void
+gst_openjpeg_dec_decode_job (GstOpenJPEGDec * self, GstOpenJPEGDecJob * job)
 {
-  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (decoder);
-  GstFlowReturn ret = GST_FLOW_OK;
-  gint64 deadline;
   GstMapInfo map;
   opj_codec_t *dec;
   opj_stream_t *stream;
   MemStream mstream;
-  opj_image_t *image;
-  GstVideoFrame vframe;
+  opj_image_t *image = NULL;
   opj_dparameters_t params;
-  gint max_threads;
-
-  GST_DEBUG_OBJECT (self, "Handling frame");
+  gint i;
 
-  deadline = gst_video_decoder_get_max_decode_time (decoder, frame);
-  if (deadline < 0) {
-    GST_LOG_OBJECT (self, "Dropping too late frame: deadline %" G_GINT64_FORMAT,
-        deadline);
-    ret = gst_video_decoder_drop_frame (decoder, frame);
-    return ret;
+  dec = opj_create_decompress (job->codec_format);
+  if (!dec) {
+    job->result = GST_OPENJPEG_DEC_JOB_INIT_ERROR;
+    return;
   }
 
-  dec = opj_create_decompress (self->codec_format);
-  if (!dec)
-    goto initialization_error;
-
   if (G_UNLIKELY (gst_debug_category_get_threshold (GST_CAT_DEFAULT) >=
           GST_LEVEL_TRACE)) {
     opj_set_info_handler (dec, gst_openjpeg_dec_opj_info, self);
@@ -1148,31 +1258,34 @@ gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
   }
 
   params = self->params;
-  if (self->ncomps)
-    params.jpwl_exp_comps = self->ncomps;
-  if (!opj_setup_decoder (dec, &params))
-    goto open_error;
+  if (job->ncomps)
+    params.jpwl_exp_comps = job->ncomps;
+  if (!opj_setup_decoder (dec, &params)) {
+    opj_destroy_codec (dec);
+    job->result = GST_OPENJPEG_DEC_JOB_OPEN_ERROR;
+    return;
+  }
 
-  max_threads = g_atomic_int_get (&self->max_threads);
-  if (max_threads == 0)
-    max_threads = self->num_procs;
-  if (!opj_codec_set_threads (dec, max_threads))
+  if (!opj_codec_set_threads (dec, job->n_threads))
     GST_WARNING_OBJECT (self, "Failed to set %d number of threads",
-        max_threads);
+        job->n_threads);
 
-  if (!gst_buffer_map (frame->input_buffer, &map, GST_MAP_READ))
-    goto map_read_error;
+  if (!gst_buffer_map (job->frame->input_buffer, &map, GST_MAP_READ)) {
+    opj_destroy_codec (dec);
+    job->result = GST_OPENJPEG_DEC_JOB_MAP_ERROR;
+    return;
+  }
 
-  if (self->is_jp2c && map.size < 8)
+  if (job->is_jp2c && map.size < 8)
     goto open_error;
 
   stream = opj_stream_create (4096, OPJ_TRUE);
   if (!stream)
     goto open_error;
 
-  mstream.data = map.data + (self->is_jp2c ? 8 : 0);
+  mstream.data = map.data + (job->is_jp2c ? 8 : 0);
   mstream.offset = 0;
-  mstream.size = map.size - (self->is_jp2c ? 8 : 0);
+  mstream.size = map.size - (job->is_jp2c ? 8 : 0);
 
   opj_stream_set_read_function (stream, read_fn);
   opj_stream_set_write_function (stream, write_fn);
@@ -1181,25 +1294,94 @@ gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
   opj_stream_set_user_data (stream, &mstream, NULL);
   opj_stream_set_user_data_length (stream, mstream.size);
 
-  image = NULL;
   if (!opj_read_header (stream, dec, &image))
     goto decode_error;
 
   if (!opj_decode (dec, stream, image))
     goto decode_error;
 
-  {
-    gint i;
+  for (i = 0; i < image->numcomps; i++) {
+    if (image->comps[i].data == NULL)
+      goto decode_error;
+  }
 
-    for (i = 0; i < image->numcomps; i++) {
-      if (image->comps[i].data == NULL)
-        goto decode_error;
-    }
+  opj_end_decompress (dec, stream);
+  opj_stream_destroy (stream);
+  opj_destroy_codec (dec);
+  gst_buffer_unmap (job->frame->input_buffer, &map);
+
+  job->image = image;
+  job->result = GST_OPENJPEG_DEC_JOB_OK;
+  return;
+
+open_error:
+  {
+    opj_destroy_codec (dec);
+    gst_buffer_unmap (job->frame->input_buffer, &map);
+    job->result = GST_OPENJPEG_DEC_JOB_OPEN_ERROR;
+    return;
+  }
+decode_error:
+  {
+    if (image)
+      opj_image_destroy (image);
+    opj_stream_destroy (stream);
+    opj_destroy_codec (dec);
+    gst_buffer_unmap (job->frame->input_buffer, &map);
+    job->result = GST_OPENJPEG_DEC_JOB_DECODE_ERROR;
+    return;
   }
+}
 
-  gst_buffer_unmap (frame->input_buffer, &map);
+static void
+gst_openjpeg_dec_decode_func (gpointer data, gpointer user_data)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (user_data);
+  GstOpenJPEGDecJob *job = data;
+
+  gst_openjpeg_dec_decode_job (self, job);
+
+  g_mutex_lock (&self->job_lock);
+  job->done = TRUE;
+  g_cond_broadcast (&self->job_cond);
+  g_mutex_unlock (&self->job_lock);
+}
+
+/* Called with the stream lock from the streaming thread, in input order */
+static GstFlowReturn
+gst_openjpeg_dec_finish_job (GstOpenJPEGDec * self, GstOpenJPEGDecJob * job)
+{
+  GstVideoDecoder *decoder = GST_VIDEO_DECODER (self);
+  GstVideoCodecFrame *frame = job->frame;
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstVideoFrame vframe;
+
+  switch (job->result) {
+    case GST_OPENJPEG_DEC_JOB_OK:
+      break;
+    case GST_OPENJPEG_DEC_JOB_INIT_ERROR:
+      GST_ELEMENT_ERROR (self, LIBRARY, INIT,
+          ("Failed to initialize OpenJPEG decoder"), (NULL));
+      gst_openjpeg_dec_job_free (job);
+      return GST_FLOW_ERROR;
+    case GST_OPENJPEG_DEC_JOB_MAP_ERROR:
+      GST_ELEMENT_ERROR (self, CORE, FAILED,
+          ("Failed to map input buffer"), (NULL));
+      gst_openjpeg_dec_job_free (job);
+      return GST_FLOW_ERROR;
+    case GST_OPENJPEG_DEC_JOB_OPEN_ERROR:
+      GST_ELEMENT_ERROR (self, LIBRARY, INIT,
+          ("Failed to open OpenJPEG stream"), (NULL));
+      gst_openjpeg_dec_job_free (job);
+      return GST_FLOW_ERROR;
+    case GST_OPENJPEG_DEC_JOB_DECODE_ERROR:
+      gst_openjpeg_dec_job_free (job);
+      GST_VIDEO_DECODER_ERROR (self, 1, STREAM, DECODE,
+          ("Failed to decode OpenJPEG stream"), (NULL), ret);
+      return ret;
+  }
 
-  ret = gst_openjpeg_dec_negotiate (self, image);
+  ret = gst_openjpeg_dec_negotiate (self, job->image);
   if (ret != GST_FLOW_OK)
     goto negotiate_error;
 
@@ -1211,93 +1393,150 @@ gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
           frame->output_buffer, GST_MAP_WRITE))
     goto map_write_error;
 
-  self->fill_frame (&vframe, image);
+  self->fill_frame (&vframe, job->image);
 
   gst_video_frame_unmap (&vframe);
 
-  opj_end_decompress (dec, stream);
-  opj_stream_destroy (stream);
-  opj_image_destroy (image);
-  opj_destroy_codec (dec);
+  job->frame = NULL;
+  gst_openjpeg_dec_job_free (job);
 
   ret = gst_video_decoder_finish_frame (decoder, frame);
 
   return ret;
 
-initialization_error:
-  {
-    gst_video_codec_frame_unref (frame);
-    GST_ELEMENT_ERROR (self, LIBRARY, INIT,
-        ("Failed to initialize OpenJPEG decoder"), (NULL));
-    return GST_FLOW_ERROR;
-  }
-map_read_error:
-  {
-    opj_destroy_codec (dec);
-    gst_video_codec_frame_unref (frame);
-
-    GST_ELEMENT_ERROR (self, CORE, FAILED,
-        ("Failed to map input buffer"), (NULL));
-    return GST_FLOW_ERROR;
-  }
-open_error:
-  {
-    opj_destroy_codec (dec);
-    gst_buffer_unmap (frame->input_buffer, &map);
-    gst_video_codec_frame_unref (frame);
-
-    GST_ELEMENT_ERROR (self, LIBRARY, INIT,
-        ("Failed to open OpenJPEG stream"), (NULL));
-    return GST_FLOW_ERROR;
-  }
-decode_error:
-  {
-    if (image)
-      opj_image_destroy (image);
-    opj_stream_destroy (stream);
-    opj_destroy_codec (dec);
-    gst_buffer_unmap (frame->input_buffer, &map);
-    gst_video_codec_frame_unref (frame);
-
-    GST_VIDEO_DECODER_ERROR (self, 1, STREAM, DECODE,
-        ("Failed to decode OpenJPEG stream"), (NULL), ret);
-    return ret;
-  }
 negotiate_error:
   {
-    opj_image_destroy (image);
-    opj_stream_destroy (stream);
-    opj_destroy_codec (dec);
-    gst_video_codec_frame_unref (frame);
-
+    gst_openjpeg_dec_job_free (job);
     GST_ELEMENT_ERROR (self, CORE, NEGOTIATION,
         ("Failed to negotiate"), (NULL));
     return ret;
   }
 allocate_error:
   {
-    opj_image_destroy (image);
-    opj_stream_destroy (stream);
-    opj_destroy_codec (dec);
-    gst_video_codec_frame_unref (frame);
-
+    gst_openjpeg_dec_job_free (job);
     GST_ELEMENT_ERROR (self, CORE, FAILED,
         ("Failed to allocate output buffer"), (NULL));
     return ret;
   }
 map_write_error:
   {
-    opj_image_destroy (image);
-    opj_stream_destroy (stream);
-    opj_destroy_codec (dec);
-    gst_video_codec_frame_unref (frame);
-
+    gst_openjpeg_dec_job_free (job);
     GST_ELEMENT_ERROR (self, CORE, FAILED,
         ("Failed to map output buffer"), (NULL));
     return GST_FLOW_ERROR;
   }
 }
 
+/* Outputs the decoded frames at the head of the pending queue, and waits
+ * for the oldest ones until at most @max_pending frames are left */
+static GstFlowReturn
+gst_openjpeg_dec_finish_pending (GstOpenJPEGDec * self, guint max_pending)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstOpenJPEGDecJob *job;
+
+  g_mutex_lock (&self->job_lock);
+  while ((job = g_queue_peek_head (&self->pending_jobs))) {
+    if (!job->done) {
+      if (g_queue_get_length (&self->pending_jobs) <= max_pending)
+        break;
+      g_cond_wait (&self->job_cond, &self->job_lock);
+      continue;
+    }
+
+    g_queue_pop_head (&self->pending_jobs);
+    g_mutex_unlock (&self->job_lock);
+    ret = gst_openjpeg_dec_finish_job (self, job);
+    g_mutex_lock (&self->job_lock);
+
+    if (ret != GST_FLOW_OK)
+      break;
+  }
+  g_mutex_unlock (&self->job_lock);
+
+  return ret;
+}
+
+/* Waits for all frame threads and drops the frames they decoded */
+static void
+gst_openjpeg_dec_discard_pending (GstOpenJPEGDec * self)
+{
+  GstOpenJPEGDecJob *job;
+
+  g_mutex_lock (&self->job_lock);
+  while ((job = g_queue_pop_head (&self->pending_jobs))) {
+    while (!job->done)
+      g_cond_wait (&self->job_cond, &self->job_lock);
+    gst_openjpeg_dec_job_free (job);
+  }
+  g_mutex_unlock (&self->job_lock);
+}
+
+static GstFlowReturn
+gst_openjpeg_dec_handle_frame (GstVideoDecoder * decoder,
+    GstVideoCodecFrame * frame)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (decoder);
+  GstFlowReturn ret = GST_FLOW_OK;
+  gint64 deadline;
+  GstOpenJPEGDecJob *job;
+  gint max_threads;
+
+  GST_DEBUG_OBJECT (self, "Handling frame");
+
+  deadline = gst_video_decoder_get_max_decode_time (decoder, frame);
+  if (deadline < 0) {
+    GST_LOG_OBJECT (self, "Dropping too late frame: deadline %" G_GINT64_FORMAT,
+        deadline);
+    ret = gst_video_decoder_drop_frame (decoder, frame);
+    return ret;
+  }
+
+  max_threads = g_atomic_int_get (&self->max_threads);
+  if (max_threads == 0)
+    max_threads = MAX (self->num_procs / self->n_frame_threads, 1);
+
+  job = g_slice_new0 (GstOpenJPEGDecJob);
+  job->frame = frame;
+  job->codec_format = self->codec_format;
+  job->is_jp2c = self->is_jp2c;
+  job->ncomps = self->ncomps;
+  job->n_threads = max_threads;
+
+  if (!self->frame_pool) {
+    gst_openjpeg_dec_decode_job (self, job);
+    return gst_openjpeg_dec_finish_job (self, job);
+  }
+
+  g_mutex_lock (&self->job_lock);
+  g_queue_push_tail (&self->pending_jobs, job);
+  g_mutex_unlock (&self->job_lock);
+  g_thread_pool_push (self->frame_pool, job, NULL);
+
+  /* keep one frame per thread in flight while waiting for the oldest */
+  return gst_openjpeg_dec_finish_pending (self, self->n_frame_threads - 1);
+}
+
+static GstFlowReturn
+gst_openjpeg_dec_finish (GstVideoDecoder * decoder)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (decoder);
+
+  GST_DEBUG_OBJECT (self, "Draining frame threads");
+
+  return gst_openjpeg_dec_finish_pending (self, 0);
+}
+
+static gboolean
+gst_openjpeg_dec_flush (GstVideoDecoder * decoder)
+{
+  GstOpenJPEGDec *self = GST_OPENJPEG_DEC (decoder);
+
+  gst_openjpeg_dec_discard_pending (self);
+
+  return TRUE;
+}
+
 static gboolean
 gst_openjpeg_dec_decide_allocation (GstVideoDecoder * decoder, GstQuery * query)
 {
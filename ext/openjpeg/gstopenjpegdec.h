@@ -58,8 +58,16 @@ struct _GstOpenJPEGDec
   GstJPEG2000Sampling sampling;
   gint ncomps;
   gint max_threads;  /* atomic */
+  gint frame_threads;  /* atomic */
   gint num_procs;
 
+  /* frame level parallelism, jobs are kept in decoding order */
+  gint n_frame_threads;
+  GThreadPool *frame_pool;
+  GQueue pending_jobs;
+  GMutex job_lock;
+  GCond job_cond;
+
   void (*fill_frame) (GstVideoFrame *frame, opj_image_t * image);
 
   opj_dparameters_t params;
@@ -231,6 +231,7 @@ gst_sctp_association_init (GstSctpAssociation * self)
   self->sctp_ass_sock = NULL;
 
   g_mutex_init (&self->association_mutex);
+  g_mutex_init (&self->packet_out_mutex);
 
   self->state = GST_SCTP_ASSOCIATION_STATE_NEW;
 
@@ -255,6 +256,9 @@ gst_sctp_association_finalize (GObject * object)
   }
   G_UNLOCK (associations_lock);
 
+  g_mutex_clear (&self->packet_out_mutex);
+  g_mutex_clear (&self->association_mutex);
+
   G_OBJECT_CLASS (gst_sctp_association_parent_class)->finalize (object);
 }
 
@@ -425,11 +429,13 @@ gst_sctp_association_set_on_packet_out (GstSctpAssociation * self,
   g_return_if_fail (GST_SCTP_IS_ASSOCIATION (self));
 
   g_mutex_lock (&self->association_mutex);
+  g_mutex_lock (&self->packet_out_mutex);
   if (self->packet_out_destroy_notify)
     self->packet_out_destroy_notify (self->packet_out_user_data);
   self->packet_out_cb = packet_out_cb;
   self->packet_out_user_data = user_data;
   self->packet_out_destroy_notify = destroy_notify;
+  g_mutex_unlock (&self->packet_out_mutex);
   g_mutex_unlock (&self->association_mutex);
 
   maybe_set_state_to_ready (self);
@@ -775,11 +781,15 @@ sctp_packet_out (void *addr, void *buffer, size_t length, guint8 tos,
 {
   GstSctpAssociation *self = GST_SCTP_ASSOCIATION (addr);
 
-  g_mutex_lock (&self->association_mutex);
+  /* This is called from usrsctp's threads for every outgoing packet, also
+   * from within usrsctp_sendv(). Only serialize against changes of the
+   * callback so that senders, state changes and the encoder's own locks
+   * don't contend on the association mutex for every packet */
+  g_mutex_lock (&self->packet_out_mutex);
   if (self->packet_out_cb) {
     self->packet_out_cb (self, buffer, length, self->packet_out_user_data);
   }
-  g_mutex_unlock (&self->association_mutex);
+  g_mutex_unlock (&self->packet_out_mutex);
 
   return 0;
 }
@@ -87,6 +87,8 @@ struct _GstSctpAssociation
   gpointer packet_received_user_data;
   GDestroyNotify packet_received_destroy_notify;
 
+  /* protects the packet out callback, taken after association_mutex */
+  GMutex packet_out_mutex;
   GstSctpAssociationPacketOutCb packet_out_cb;
   gpointer packet_out_user_data;
   GDestroyNotify packet_out_destroy_notify;
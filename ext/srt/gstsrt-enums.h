@@ -62,6 +62,23 @@ typedef enum
   GST_SRT_KEY_LENGTH_32 = 32,
 } GstSRTKeyLength;
 
+/**
+ * GstSRTCallerLagPolicy:
+ * @GST_SRT_CALLER_LAG_POLICY_DROP: drop the oldest buffers queued for the
+ *   caller
+ * @GST_SRT_CALLER_LAG_POLICY_DISCONNECT: disconnect the caller
+ *
+ * What to do with a caller of a listening sink that lags behind by more than
+ * the allowed number of buffers.
+ *
+ * Since: 1.20
+ */
+typedef enum
+{
+  GST_SRT_CALLER_LAG_POLICY_DROP,
+  GST_SRT_CALLER_LAG_POLICY_DISCONNECT,
+} GstSRTCallerLagPolicy;
+
 G_END_DECLS
 
 #endif // __GST_SRT_ENUM_H__
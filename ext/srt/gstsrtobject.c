@@ -71,6 +71,10 @@ enum
   PROP_WAIT_FOR_CONNECTION,
   PROP_STREAMID,
   PROP_AUTHENTICATION,
+  PROP_MAX_CALLER_LAG,
+  PROP_CALLER_LAG_POLICY,
+  PROP_MESSAGES_PER_BUFFER,
+  PROP_STATS_INTERVAL,
   PROP_LAST
 };
 
@@ -80,6 +84,11 @@ typedef struct
   gint poll_id;
   GSocketAddress *sockaddr;
   gboolean sent_headers;
+
+  /* sink only: position of the next data to send in the send queue */
+  guint64 seq;
+  gsize offset;
+  guint64 buffers_dropped;
 } SRTCaller;
 
 static GstStructure *gst_srt_object_accumulate_stats (GstSRTObject * srtobject,
@@ -366,6 +375,12 @@ gst_srt_object_new (GstElement * element)
   srtobject->listener_poll_id = SRT_ERROR;
   srtobject->sent_headers = FALSE;
   srtobject->wait_for_connection = GST_SRT_DEFAULT_WAIT_FOR_CONNECTION;
+  srtobject->max_caller_lag = GST_SRT_DEFAULT_MAX_CALLER_LAG;
+  srtobject->caller_lag_policy = GST_SRT_DEFAULT_CALLER_LAG_POLICY;
+  srtobject->messages_per_buffer = GST_SRT_DEFAULT_MESSAGES_PER_BUFFER;
+  srtobject->stats_interval = GST_SRT_DEFAULT_STATS_INTERVAL;
+
+  g_queue_init (&srtobject->send_queue);
 
   g_cond_init (&srtobject->sock_cond);
   return srtobject;
@@ -383,6 +398,9 @@ gst_srt_object_destroy (GstSRTObject * srtobject)
 
   g_cond_clear (&srtobject->sock_cond);
 
+  g_queue_foreach (&srtobject->send_queue, (GFunc) g_bytes_unref, NULL);
+  g_queue_clear (&srtobject->send_queue);
+
   GST_DEBUG_OBJECT (srtobject->element, "Destroying srtobject");
   gst_structure_free (srtobject->parameters);
 
@@ -437,6 +455,18 @@ gst_srt_object_set_property_helper (GstSRTObject * srtobject,
     case PROP_AUTHENTICATION:
       srtobject->authentication = g_value_get_boolean (value);
       break;
+    case PROP_MAX_CALLER_LAG:
+      srtobject->max_caller_lag = g_value_get_uint (value);
+      break;
+    case PROP_CALLER_LAG_POLICY:
+      srtobject->caller_lag_policy = g_value_get_enum (value);
+      break;
+    case PROP_MESSAGES_PER_BUFFER:
+      srtobject->messages_per_buffer = g_value_get_uint (value);
+      break;
+    case PROP_STATS_INTERVAL:
+      srtobject->stats_interval = g_value_get_uint (value);
+      break;
     default:
       goto err;
   }
@@ -544,6 +574,26 @@ gst_srt_object_get_property_helper (GstSRTObject * srtobject,
     case PROP_AUTHENTICATION:
       g_value_set_boolean (value, srtobject->authentication);
       break;
+    case PROP_MAX_CALLER_LAG:
+      GST_OBJECT_LOCK (srtobject->element);
+      g_value_set_uint (value, srtobject->max_caller_lag);
+      GST_OBJECT_UNLOCK (srtobject->element);
+      break;
+    case PROP_CALLER_LAG_POLICY:
+      GST_OBJECT_LOCK (srtobject->element);
+      g_value_set_enum (value, srtobject->caller_lag_policy);
+      GST_OBJECT_UNLOCK (srtobject->element);
+      break;
+    case PROP_MESSAGES_PER_BUFFER:
+      GST_OBJECT_LOCK (srtobject->element);
+      g_value_set_uint (value, srtobject->messages_per_buffer);
+      GST_OBJECT_UNLOCK (srtobject->element);
+      break;
+    case PROP_STATS_INTERVAL:
+      GST_OBJECT_LOCK (srtobject->element);
+      g_value_set_uint (value, srtobject->stats_interval);
+      GST_OBJECT_UNLOCK (srtobject->element);
+      break;
     default:
       return FALSE;
   }
@@ -704,6 +754,71 @@ gst_srt_object_install_properties_helper (GObjectClass * gobject_class)
           "Authentication",
           "Authenticate a connection",
           FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstSRTSink:max-caller-lag:
+   *
+   * The maximum number of buffers a caller may lag behind in listener mode
+   * before #GstSRTSink:caller-lag-policy is applied.  Callers are served
+   * without blocking, so a slow caller never delays the others.
+   * 0 means no limit.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_CALLER_LAG,
+      g_param_spec_uint ("max-caller-lag", "Max caller lag",
+          "Maximum number of buffers queued for a caller (0 = unlimited)",
+          0, G_MAXUINT, GST_SRT_DEFAULT_MAX_CALLER_LAG,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstSRTSink:caller-lag-policy:
+   *
+   * What to do with a caller lagging behind by more than
+   * #GstSRTSink:max-caller-lag buffers.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_CALLER_LAG_POLICY,
+      g_param_spec_enum ("caller-lag-policy", "Caller lag policy",
+          "What to do with lagging callers", GST_TYPE_SRT_CALLER_LAG_POLICY,
+          GST_SRT_DEFAULT_CALLER_LAG_POLICY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  gst_type_mark_as_plugin_api (GST_TYPE_SRT_CALLER_LAG_POLICY, 0);
+
+  /**
+   * GstSRTSrc:messages-per-buffer:
+   *
+   * The maximum number of SRT messages aggregated into one output buffer.
+   * Once a message has arrived, the messages already queued on the socket
+   * are read without blocking into the same buffer, as long as another
+   * maximum sized message fits in the #GstBaseSrc:blocksize. The buffer is
+   * timestamped with the arrival time of its first message.
+   * 0 means as many as fit in the buffer.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_MESSAGES_PER_BUFFER,
+      g_param_spec_uint ("messages-per-buffer", "Messages per buffer",
+          "Maximum number of SRT messages per output buffer (0 = as many as fit)",
+          0, G_MAXUINT, GST_SRT_DEFAULT_MESSAGES_PER_BUFFER,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstSRTSrc:stats-interval:
+   *
+   * Interval in milliseconds at which the #GstSRTSrc:stats are posted on
+   * the bus as an element message named "application/x-srt-statistics",
+   * with one entry per caller in listener mode. The interval is picked up
+   * the next time the connection is opened. 0 disables the messages.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS_INTERVAL,
+      g_param_spec_uint ("stats-interval", "Statistics interval",
+          "Interval in milliseconds between statistics messages "
+          "(0 = disabled)", 0, G_MAXUINT, GST_SRT_DEFAULT_STATS_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -968,6 +1083,15 @@ thread_func (gpointer data)
         flag |= SRT_EPOLL_IN;
       } else {
         flag |= SRT_EPOLL_OUT;
+
+        /* a caller whose send buffer is full must not block the others,
+         * see gst_srt_object_write_to_callers() */
+        if (srt_setsockflag (caller_sock, SRTO_SNDSYN, &bool_false,
+                sizeof (bool_false))) {
+          GST_WARNING_OBJECT (srtobject->element,
+              "Failed to make caller %d non-blocking: %s", caller_sock,
+              srt_getlasterror_str ());
+        }
       }
 
       if (srt_epoll_add_usock (caller->poll_id, caller_sock, &flag)) {
@@ -1309,6 +1433,77 @@ gst_srt_object_open_connection (GstSRTObject * srtobject,
   return ret;
 }
 
+static gboolean
+stats_timer_cb (GstClock * clock, GstClockTime time, GstClockID id,
+    gpointer user_data)
+{
+  GstSRTObject *srtobject = user_data;
+  GstStructure *stats;
+
+  GST_OBJECT_LOCK (srtobject->element);
+  if (srtobject->stats_timer != id) {
+    /* Stopped while this callback was pending */
+    GST_OBJECT_UNLOCK (srtobject->element);
+    return TRUE;
+  }
+  GST_OBJECT_UNLOCK (srtobject->element);
+
+  stats = gst_srt_object_get_stats (srtobject);
+  gst_element_post_message (srtobject->element,
+      gst_message_new_element (GST_OBJECT_CAST (srtobject->element), stats));
+
+  return TRUE;
+}
+
+static void
+stats_timer_destroy (gpointer user_data)
+{
+  GstSRTObject *srtobject = user_data;
+
+  gst_object_unref (srtobject->element);
+}
+
+static void
+gst_srt_object_start_stats_timer (GstSRTObject * srtobject)
+{
+  GstClock *clock;
+  GstClockTime interval;
+
+  GST_OBJECT_LOCK (srtobject->element);
+  if (srtobject->stats_interval == 0 || srtobject->stats_timer) {
+    GST_OBJECT_UNLOCK (srtobject->element);
+    return;
+  }
+
+  interval = srtobject->stats_interval * GST_MSECOND;
+  clock = gst_system_clock_obtain ();
+  srtobject->stats_timer = gst_clock_new_periodic_id (clock,
+      gst_clock_get_time (clock) + interval, interval);
+  gst_object_unref (clock);
+
+  /* The element owns the srtobject, keep it alive while the clock may
+   * still call us back */
+  gst_object_ref (srtobject->element);
+  gst_clock_id_wait_async (srtobject->stats_timer, stats_timer_cb,
+      srtobject, stats_timer_destroy);
+  GST_OBJECT_UNLOCK (srtobject->element);
+}
+
+static void
+gst_srt_object_stop_stats_timer (GstSRTObject * srtobject)
+{
+  GstClockID timer;
+
+  GST_OBJECT_LOCK (srtobject->element);
+  timer = g_steal_pointer (&srtobject->stats_timer);
+  GST_OBJECT_UNLOCK (srtobject->element);
+
+  if (timer) {
+    gst_clock_id_unschedule (timer);
+    gst_clock_id_unref (timer);
+  }
+}
+
 static gboolean
 gst_srt_object_open_internal (GstSRTObject * srtobject,
     GCancellable * cancellable, GError ** error)
@@ -1373,6 +1568,9 @@ gst_srt_object_open_internal (GstSRTObject * srtobject,
   srtobject->opened = ret;
   GST_OBJECT_UNLOCK (srtobject->element);
 
+  if (ret)
+    gst_srt_object_start_stats_timer (srtobject);
+
 out:
   g_clear_object (&socket_address);
 
@@ -1391,6 +1589,8 @@ gst_srt_object_open (GstSRTObject * srtobject, GCancellable * cancellable,
 void
 gst_srt_object_close (GstSRTObject * srtobject)
 {
+  gst_srt_object_stop_stats_timer (srtobject);
+
   g_mutex_lock (&srtobject->sock_lock);
 
   if (srtobject->sock != SRT_INVALID_SOCK) {
@@ -1443,6 +1643,10 @@ gst_srt_object_close (GstSRTObject * srtobject)
     g_list_free_full (callers, (GDestroyNotify) srt_caller_free);
   }
 
+  g_queue_foreach (&srtobject->send_queue, (GFunc) g_bytes_unref, NULL);
+  g_queue_clear (&srtobject->send_queue);
+  srtobject->send_queue_seq = 0;
+
   g_mutex_unlock (&srtobject->sock_lock);
 
   GST_OBJECT_LOCK (srtobject->element);
@@ -1590,6 +1794,51 @@ gst_srt_object_read (GstSRTObject * srtobject,
   return len;
 }
 
+/* Reads one more message without blocking from the socket the last
+ * gst_srt_object_read() returned data from. Returns 0 when nothing is
+ * queued or on error, which is then reported by the next blocking read. */
+gssize
+gst_srt_object_read_more (GstSRTObject * srtobject,
+    guint8 * data, gsize size, SRT_MSGCTRL * mctrl)
+{
+  GstSRTConnectionMode connection_mode = GST_SRT_CONNECTION_MODE_NONE;
+  SRTSOCKET rsock = SRT_INVALID_SOCK;
+  gssize len;
+
+  GST_OBJECT_LOCK (srtobject->element);
+  gst_structure_get_enum (srtobject->parameters, "mode",
+      GST_TYPE_SRT_CONNECTION_MODE, (gint *) & connection_mode);
+  GST_OBJECT_UNLOCK (srtobject->element);
+
+  if (connection_mode == GST_SRT_CONNECTION_MODE_LISTENER) {
+    g_mutex_lock (&srtobject->sock_lock);
+    if (srtobject->callers) {
+      SRTCaller *caller = srtobject->callers->data;
+      rsock = caller->sock;
+    }
+    g_mutex_unlock (&srtobject->sock_lock);
+  } else {
+    rsock = srtobject->sock;
+  }
+
+  if (rsock == SRT_INVALID_SOCK)
+    return 0;
+
+  /* The socket is non-blocking (SRTO_RCVSYN is false) */
+  srt_msgctrl_init (mctrl);
+  len = srt_recvmsg2 (rsock, (char *) (data), size, mctrl);
+
+  if (len == SRT_ERROR) {
+    if (srt_getlasterror (NULL) != SRT_EASYNCRCV) {
+      GST_DEBUG_OBJECT (srtobject->element,
+          "Stopped reading ahead: %s", srt_getlasterror_str ());
+    }
+    return 0;
+  }
+
+  return len;
+}
+
 void
 gst_srt_object_wakeup (GstSRTObject * srtobject, GCancellable * cancellable)
 {
@@ -1665,22 +1914,91 @@ gst_srt_object_send_headers (GstSRTObject * srtobject, SRTSOCKET sock,
   return TRUE;
 }
 
+/* Sends as much of the send queue as possible to @caller without blocking.
+ * Called with sock_lock.  Returns FALSE if the caller has to be dropped */
+static gboolean
+srt_caller_flush (GstSRTObject * srtobject, SRTCaller * caller)
+{
+  guint64 end_seq = srtobject->send_queue_seq + srtobject->send_queue.length;
+  gint payload_size, optlen = sizeof (payload_size);
+  GList *link;
+
+  if (caller->seq >= end_seq)
+    return TRUE;
+
+  if (srt_getsockflag (caller->sock, SRTO_PAYLOADSIZE, &payload_size,
+          &optlen)) {
+    GST_WARNING_OBJECT (srtobject->element, "%s", srt_getlasterror_str ());
+    return FALSE;
+  }
+
+  link = g_queue_peek_nth_link (&srtobject->send_queue,
+      caller->seq - srtobject->send_queue_seq);
+
+  for (; link; link = link->next) {
+    gsize size;
+    const guint8 *msg = g_bytes_get_data (link->data, &size);
+
+    while (caller->offset < size) {
+      gint rest = MIN (size - caller->offset, payload_size);
+      gint sent;
+
+      sent = srt_sendmsg2 (caller->sock, (char *) (msg + caller->offset),
+          rest, 0);
+      if (sent < 0) {
+        if (srt_getlasterror (NULL) == SRT_EASYNCSND) {
+          GST_LOG_OBJECT (srtobject->element, "Caller %d is busy, %"
+              G_GUINT64_FORMAT " buffers queued", caller->sock,
+              end_seq - caller->seq);
+          return TRUE;
+        }
+
+        GST_WARNING_OBJECT (srtobject->element, "Dropping caller %d: %s",
+            caller->sock, srt_getlasterror_str ());
+        return FALSE;
+      }
+      caller->offset += sent;
+    }
+
+    caller->seq++;
+    caller->offset = 0;
+  }
+
+  return TRUE;
+}
+
+/* All callers are fed from one queue of outgoing buffers, each one with its
+ * own position in it.  Callers are written to without blocking and the ones
+ * lagging behind too much are handled according to caller-lag-policy. */
 static gssize
 gst_srt_object_write_to_callers (GstSRTObject * srtobject,
     GstBufferList * headers,
     const GstMapInfo * mapinfo, GCancellable * cancellable, GError ** error)
 {
+  GstSRTCallerLagPolicy lag_policy;
+  guint64 end_seq, min_seq;
+  guint max_lag;
   GList *callers;
 
+  GST_OBJECT_LOCK (srtobject->element);
+  max_lag = srtobject->max_caller_lag;
+  lag_policy = srtobject->caller_lag_policy;
+  GST_OBJECT_UNLOCK (srtobject->element);
+
   g_mutex_lock (&srtobject->sock_lock);
+
+  if (!srtobject->callers)
+    goto done;
+
+  g_queue_push_tail (&srtobject->send_queue,
+      g_bytes_new (mapinfo->data, mapinfo->size));
+  end_seq = srtobject->send_queue_seq + srtobject->send_queue.length;
+
   callers = srtobject->callers;
   while (callers != NULL) {
-    gssize len = 0;
-    const guint8 *msg = mapinfo->data;
-    gint sent;
-    gint payload_size, optlen = 1;
-
     SRTCaller *caller = callers->data;
+    guint64 lag;
+
     callers = callers->next;
 
     if (g_cancellable_is_cancelled (cancellable)) {
@@ -1693,25 +2011,31 @@ gst_srt_object_write_to_callers (GstSRTObject * srtobject,
         goto err;
       }
       caller->sent_headers = TRUE;
+      /* new callers start with the current buffer */
+      caller->seq = end_seq - 1;
+      caller->offset = 0;
     }
 
-    if (srt_getsockflag (caller->sock, SRTO_PAYLOADSIZE, &payload_size,
-            &optlen)) {
-      GST_WARNING_OBJECT (srtobject->element, "%s", srt_getlasterror_str ());
-      goto err;
-    }
+    lag = end_seq - caller->seq;
+    if (max_lag > 0 && lag > max_lag) {
+      guint64 dropped = lag - max_lag;
 
-    while (len < mapinfo->size) {
-      gint rest = MIN (mapinfo->size - len, payload_size);
-      sent = srt_sendmsg2 (caller->sock, (char *) (msg + len), rest, 0);
-      if (sent < 0) {
-        GST_WARNING_OBJECT (srtobject->element, "Dropping caller %d: %s",
-            caller->sock, srt_getlasterror_str ());
+      if (lag_policy == GST_SRT_CALLER_LAG_POLICY_DISCONNECT) {
+        GST_WARNING_OBJECT (srtobject->element, "Disconnecting caller %d "
+            "lagging %" G_GUINT64_FORMAT " buffers behind", caller->sock, lag);
         goto err;
       }
-      len += sent;
+
+      GST_DEBUG_OBJECT (srtobject->element, "Dropping %" G_GUINT64_FORMAT
+          " buffers for caller %d", dropped, caller->sock);
+      caller->seq += dropped;
+      caller->offset = 0;
+      caller->buffers_dropped += dropped;
     }
 
+    if (!srt_caller_flush (srtobject, caller))
+      goto err;
+
     continue;
 
   err:
@@ -1720,6 +2044,21 @@ gst_srt_object_write_to_callers (GstSRTObject * srtobject,
     srt_caller_free (caller);
   }
 
+done:
+  /* release the buffers every caller is done with */
+  min_seq = srtobject->send_queue_seq + srtobject->send_queue.length;
+  for (callers = srtobject->callers; callers; callers = callers->next) {
+    SRTCaller *caller = callers->data;
+
+    if (caller->sent_headers)
+      min_seq = MIN (min_seq, caller->seq);
+  }
+
+  while (srtobject->send_queue_seq < min_seq) {
+    g_bytes_unref (g_queue_pop_head (&srtobject->send_queue));
+    srtobject->send_queue_seq++;
+  }
+
   g_mutex_unlock (&srtobject->sock_lock);
   return mapinfo->size;
 
@@ -1889,7 +2228,14 @@ get_stats_for_srtsock (SRTSOCKET srtsock, gboolean is_sender, guint64 * bytes)
           "send-rate-mbps", G_TYPE_DOUBLE, stats.mbpsSendRate,
           /* busy sending time (i.e., idle time exclusive) */
           "send-duration-us", G_TYPE_UINT64, stats.usSndDuration,
-          "negotiated-latency-ms", G_TYPE_INT, stats.msSndTsbPdDelay, NULL);
+          "negotiated-latency-ms", G_TYPE_INT, stats.msSndTsbPdDelay,
+          /* flow and congestion window, in packets */
+          "flow-window", G_TYPE_INT, stats.pktFlowWindow,
+          "congestion-window", G_TYPE_INT, stats.pktCongestionWindow,
+          /* unacknowledged data in the send buffer */
+          "send-buffer-packets", G_TYPE_INT, stats.pktSndBuf,
+          "send-buffer-bytes", G_TYPE_INT, stats.byteSndBuf,
+          "send-buffer-ms", G_TYPE_INT, stats.msSndBuf, NULL);
       *bytes += stats.byteSent;
     } else {
       gst_structure_set (s,
@@ -1902,7 +2248,14 @@ get_stats_for_srtsock (SRTSOCKET srtsock, gboolean is_sender, guint64 * bytes)
           "bytes-received", G_TYPE_UINT64, stats.byteRecvTotal,
           "bytes-received-lost", G_TYPE_UINT64, stats.byteRcvLossTotal,
           "receive-rate-mbps", G_TYPE_DOUBLE, stats.mbpsRecvRate,
-          "negotiated-latency-ms", G_TYPE_INT, stats.msRcvTsbPdDelay, NULL);
+          "negotiated-latency-ms", G_TYPE_INT, stats.msRcvTsbPdDelay,
+          /* number of too-late-to-play dropped packets and bytes */
+          "packets-received-dropped", G_TYPE_INT, stats.pktRcvDrop,
+          "bytes-received-dropped", G_TYPE_UINT64, stats.byteRcvDrop,
+          /* undelivered data in the receive buffer */
+          "receive-buffer-packets", G_TYPE_INT, stats.pktRcvBuf,
+          "receive-buffer-bytes", G_TYPE_INT, stats.byteRcvBuf,
+          "receive-buffer-ms", G_TYPE_INT, stats.msRcvBuf, NULL);
       *bytes += stats.byteRecvTotal;
     }
 
@@ -1949,6 +2302,17 @@ gst_srt_object_get_stats (GstSRTObject * srtobject)
       gst_structure_set (tmp, "caller-address", G_TYPE_SOCKET_ADDRESS,
           caller->sockaddr, NULL);
 
+      if (is_sender && caller->sent_headers) {
+        guint64 end_seq =
+            srtobject->send_queue_seq + srtobject->send_queue.length;
+
+        gst_structure_set (tmp,
+            /* buffers not yet handed to the caller's socket */
+            "buffers-queued", G_TYPE_UINT64, end_seq - caller->seq,
+            /* buffers skipped because the caller lagged behind */
+            "buffers-dropped", G_TYPE_UINT64, caller->buffers_dropped, NULL);
+      }
+
       g_value_array_append (callers_stats, NULL);
       v = g_value_array_get_nth (callers_stats, callers_stats->n_values - 1);
       g_value_init (v, GST_TYPE_STRUCTURE);
@@ -42,6 +42,10 @@ G_BEGIN_DECLS
 #define GST_SRT_DEFAULT_LATENCY 125
 #define GST_SRT_DEFAULT_MSG_SIZE 1316
 #define GST_SRT_DEFAULT_WAIT_FOR_CONNECTION (TRUE)
+#define GST_SRT_DEFAULT_MAX_CALLER_LAG 1000
+#define GST_SRT_DEFAULT_CALLER_LAG_POLICY GST_SRT_CALLER_LAG_POLICY_DROP
+#define GST_SRT_DEFAULT_MESSAGES_PER_BUFFER 1
+#define GST_SRT_DEFAULT_STATS_INTERVAL 0
 
 typedef struct _GstSRTObject GstSRTObject;
 
@@ -73,6 +77,21 @@ struct _GstSRTObject
   gboolean                     authentication;
 
   guint64                      previous_bytes;
+
+  /* Buffers not yet sent to all callers in listener mode, oldest first.
+   * Protected by sock_lock */
+  GQueue                       send_queue;
+  /* Sequence number of the head of send_queue */
+  guint64                      send_queue_seq;
+
+  guint                        max_caller_lag;
+  GstSRTCallerLagPolicy        caller_lag_policy;
+
+  guint                        messages_per_buffer;
+
+  /* Periodic statistics messages, protected by the element's object lock */
+  guint                        stats_interval;
+  GstClockID                   stats_timer;
 };
 
 GstSRTObject   *gst_srt_object_new              (GstElement *element);
@@ -103,6 +122,10 @@ gssize          gst_srt_object_read     (GstSRTObject * srtobject,
                                          GError **err,
 					 SRT_MSGCTRL *mctrl);
 
+gssize          gst_srt_object_read_more (GstSRTObject * srtobject,
+                                          guint8 *data, gsize size,
+                                          SRT_MSGCTRL *mctrl);
+
 gssize          gst_srt_object_write    (GstSRTObject * srtobject,
                                          GstBufferList * headers,
                                          const GstMapInfo * mapinfo,
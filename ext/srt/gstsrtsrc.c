@@ -151,6 +151,9 @@ gst_srt_src_fill (GstPushSrc * src, GstBuffer * outbuf)
   GstClockTimeDiff delay;
   int64_t srt_time;
   SRT_MSGCTRL mctrl;
+  gsize size;
+  guint max_messages, n_messages = 1;
+  gint32 last_pktseq;
 
   if (g_cancellable_is_cancelled (self->cancellable)) {
     ret = GST_FLOW_FLUSHING;
@@ -172,8 +175,9 @@ gst_srt_src_fill (GstPushSrc * src, GstBuffer * outbuf)
 
   base_time = gst_element_get_base_time (GST_ELEMENT (src));
 
+  size = gst_buffer_get_size (outbuf);
   recv_len = gst_srt_object_read (self->srtobject, info.data,
-      gst_buffer_get_size (outbuf), self->cancellable, &err, &mctrl);
+      size, self->cancellable, &err, &mctrl);
 
   /* Capture clock values ASAP */
   capture_time = gst_clock_get_time (clock);
@@ -186,6 +190,39 @@ gst_srt_src_fill (GstPushSrc * src, GstBuffer * outbuf)
 #endif
   gst_object_unref (clock);
 
+  GST_OBJECT_LOCK (self);
+  max_messages = self->srtobject->messages_per_buffer;
+  GST_OBJECT_UNLOCK (self);
+
+  last_pktseq = mctrl.pktseq;
+  if (recv_len > 0 && max_messages != 1) {
+
+    /* Drain what has already been queued on the socket. The timestamp is
+     * derived from the first message, so only its control data is kept. */
+    while ((max_messages == 0 || n_messages < max_messages)
+        && size - recv_len >= SRT_LIVE_MAX_PLSIZE) {
+      SRT_MSGCTRL more_mctrl;
+      gssize more_len;
+
+      more_len = gst_srt_object_read_more (self->srtobject,
+          info.data + recv_len, size - recv_len, &more_mctrl);
+      if (more_len <= 0)
+        break;
+
+      if (more_mctrl.pktseq != (last_pktseq + 1) % G_MAXINT32) {
+        GST_WARNING_OBJECT (src, "discont detected %d (expected: %d)",
+            more_mctrl.pktseq, (last_pktseq + 1) % G_MAXINT32);
+        GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_DISCONT);
+      }
+      last_pktseq = more_mctrl.pktseq;
+
+      recv_len += more_len;
+      n_messages++;
+    }
+
+    GST_LOG_OBJECT (src, "read %u messages", n_messages);
+  }
+
   gst_buffer_unmap (outbuf, &info);
 
   GST_LOG_OBJECT (src,
@@ -214,7 +251,7 @@ gst_srt_src_fill (GstPushSrc * src, GstBuffer * outbuf)
     GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_DISCONT);
   }
   /* pktseq is a 31bit field */
-  self->next_pktseq = (mctrl.pktseq + 1) % G_MAXINT32;
+  self->next_pktseq = (last_pktseq + 1) % G_MAXINT32;
 
   /* 0 means we do not have a srctime */
   if (mctrl.srctime != 0)
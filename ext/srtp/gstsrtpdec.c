@@ -207,6 +207,10 @@ static GstFlowReturn gst_srtp_dec_chain_rtp (GstPad * pad,
     GstObject * parent, GstBuffer * buf);
 static GstFlowReturn gst_srtp_dec_chain_rtcp (GstPad * pad,
     GstObject * parent, GstBuffer * buf);
+static GstFlowReturn gst_srtp_dec_chain_list_rtp (GstPad * pad,
+    GstObject * parent, GstBufferList * list);
+static GstFlowReturn gst_srtp_dec_chain_list_rtcp (GstPad * pad,
+    GstObject * parent, GstBufferList * list);
 
 static GstStateChangeReturn gst_srtp_dec_change_state (GstElement * element,
     GstStateChange transition);
@@ -379,6 +383,8 @@ gst_srtp_dec_init (GstSrtpDec * filter)
       GST_DEBUG_FUNCPTR (gst_srtp_dec_iterate_internal_links_rtp));
   gst_pad_set_chain_function (filter->rtp_sinkpad,
       GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_rtp));
+  gst_pad_set_chain_list_function (filter->rtp_sinkpad,
+      GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_list_rtp));
 
   filter->rtp_srcpad =
       gst_pad_new_from_static_template (&rtp_src_template, "rtp_src");
@@ -402,6 +408,8 @@ gst_srtp_dec_init (GstSrtpDec * filter)
       GST_DEBUG_FUNCPTR (gst_srtp_dec_iterate_internal_links_rtcp));
   gst_pad_set_chain_function (filter->rtcp_sinkpad,
       GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_rtcp));
+  gst_pad_set_chain_list_function (filter->rtcp_sinkpad,
+      GST_DEBUG_FUNCPTR (gst_srtp_dec_chain_list_rtcp));
 
   filter->rtcp_srcpad =
       gst_pad_new_from_static_template (&rtcp_src_template, "rtcp_src");
@@ -1313,21 +1321,24 @@ gst_srtp_dec_push_early_events (GstSrtpDec * filter, GstPad * pad,
 
 /*
  * This function should be called while holding the filter lock
+ *
+ * @pbuf is made writable, which decrypts in place unless the buffer is shared
  */
 static gboolean
-gst_srtp_dec_decode_buffer (GstSrtpDec * filter, GstPad * pad, GstBuffer * buf,
-    gboolean is_rtcp, guint32 ssrc)
+gst_srtp_dec_decode_buffer (GstSrtpDec * filter, GstPad * pad,
+    GstBuffer ** pbuf, gboolean is_rtcp, guint32 ssrc)
 {
+  GstBuffer *buf;
   GstMapInfo map;
   srtp_err_status_t err;
   gint size;
 
   GST_LOG_OBJECT (pad, "Received %s buffer of size %" G_GSIZE_FORMAT
-      " with SSRC = %u", is_rtcp ? "RTCP" : "RTP", gst_buffer_get_size (buf),
+      " with SSRC = %u", is_rtcp ? "RTCP" : "RTP", gst_buffer_get_size (*pbuf),
       ssrc);
 
   /* Change buffer to remove protection */
-  buf = gst_buffer_make_writable (buf);
+  buf = *pbuf = gst_buffer_make_writable (*pbuf);
 
   gst_buffer_map (buf, &map, GST_MAP_READWRITE);
   size = map.size;
@@ -1443,6 +1454,22 @@ err:
   return FALSE;
 }
 
+static GstPad *
+gst_srtp_dec_get_srcpad (GstSrtpDec * filter, gboolean is_rtcp)
+{
+  if (is_rtcp) {
+    if (!filter->rtcp_has_segment)
+      gst_srtp_dec_push_early_events (filter, filter->rtcp_srcpad,
+          filter->rtp_srcpad, TRUE);
+    return filter->rtcp_srcpad;
+  } else {
+    if (!filter->rtp_has_segment)
+      gst_srtp_dec_push_early_events (filter, filter->rtp_srcpad,
+          filter->rtcp_srcpad, FALSE);
+    return filter->rtp_srcpad;
+  }
+}
+
 static GstFlowReturn
 gst_srtp_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
     gboolean is_rtcp)
@@ -1468,7 +1495,7 @@ gst_srtp_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
     goto push_out;
   }
 
-  if (!gst_srtp_dec_decode_buffer (filter, pad, buf, is_rtcp, ssrc)) {
+  if (!gst_srtp_dec_decode_buffer (filter, pad, &buf, is_rtcp, ssrc)) {
     GST_OBJECT_UNLOCK (filter);
     goto drop_buffer;
   }
@@ -1481,17 +1508,7 @@ gst_srtp_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buf,
 
 push_out:
   /* Push buffer to source pad */
-  if (is_rtcp) {
-    otherpad = filter->rtcp_srcpad;
-    if (!filter->rtcp_has_segment)
-      gst_srtp_dec_push_early_events (filter, filter->rtcp_srcpad,
-          filter->rtp_srcpad, TRUE);
-  } else {
-    otherpad = filter->rtp_srcpad;
-    if (!filter->rtp_has_segment)
-      gst_srtp_dec_push_early_events (filter, filter->rtp_srcpad,
-          filter->rtcp_srcpad, FALSE);
-  }
+  otherpad = gst_srtp_dec_get_srcpad (filter, is_rtcp);
   ret = gst_pad_push (otherpad, buf);
 
   return ret;
@@ -1504,6 +1521,111 @@ drop_buffer:
   return ret;
 }
 
+typedef struct
+{
+  GstSrtpDec *filter;
+  GstPad *pad;
+  gboolean is_rtcp;
+  /* Buffers for the other source pad, e.g. muxed RTCP on the RTP pad */
+  GstBufferList *other_list;
+  GArray *soft_limit_ssrcs;
+} DecodeBufferItData;
+
+/*
+ * This function should be called while holding the filter lock
+ */
+static gboolean
+decode_buffer_it (GstBuffer ** buffer, guint idx, gpointer user_data)
+{
+  DecodeBufferItData *data = user_data;
+  GstSrtpDecSsrcStream *stream;
+  gboolean is_rtcp = data->is_rtcp;
+  guint32 ssrc = 0;
+
+  if (!(stream = validate_buffer (data->filter, *buffer, &ssrc, &is_rtcp))) {
+    GST_WARNING_OBJECT (data->filter, "Invalid buffer, dropping");
+    goto drop_buffer;
+  }
+
+  if (STREAM_HAS_CRYPTO (stream)) {
+    guint i;
+
+    if (!gst_srtp_dec_decode_buffer (data->filter, data->pad, buffer, is_rtcp,
+            ssrc))
+      goto drop_buffer;
+
+    if (gst_srtp_get_soft_limit_reached ()) {
+      for (i = 0; i < data->soft_limit_ssrcs->len; i++) {
+        if (g_array_index (data->soft_limit_ssrcs, guint32, i) == ssrc)
+          break;
+      }
+      if (i == data->soft_limit_ssrcs->len)
+        g_array_append_val (data->soft_limit_ssrcs, ssrc);
+    }
+  }
+
+  if (is_rtcp != data->is_rtcp) {
+    if (!data->other_list)
+      data->other_list = gst_buffer_list_new ();
+    gst_buffer_list_add (data->other_list, *buffer);
+    *buffer = NULL;
+  }
+
+  return TRUE;
+
+drop_buffer:
+  gst_buffer_unref (*buffer);
+  *buffer = NULL;
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_srtp_dec_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * buf_list, gboolean is_rtcp)
+{
+  GstSrtpDec *filter = GST_SRTP_DEC (parent);
+  DecodeBufferItData data;
+  GstFlowReturn ret = GST_FLOW_OK, other_ret = GST_FLOW_OK;
+  guint i;
+
+  GST_LOG_OBJECT (pad, "Buffer chain with list of %d",
+      gst_buffer_list_length (buf_list));
+
+  /* This only copies the list if it is shared, the buffers are still
+   * decrypted in place unless they are shared too */
+  buf_list = gst_buffer_list_make_writable (buf_list);
+
+  data.filter = filter;
+  data.pad = pad;
+  data.is_rtcp = is_rtcp;
+  data.other_list = NULL;
+  data.soft_limit_ssrcs = g_array_new (FALSE, FALSE, sizeof (guint32));
+
+  GST_OBJECT_LOCK (filter);
+  gst_buffer_list_foreach (buf_list, decode_buffer_it, &data);
+  GST_OBJECT_UNLOCK (filter);
+
+  /* If all is well, we may have reached soft limit */
+  for (i = 0; i < data.soft_limit_ssrcs->len; i++)
+    request_key_with_signal (filter,
+        g_array_index (data.soft_limit_ssrcs, guint32, i), SIGNAL_SOFT_LIMIT);
+  g_array_free (data.soft_limit_ssrcs, TRUE);
+
+  if (gst_buffer_list_length (buf_list) > 0)
+    ret = gst_pad_push_list (gst_srtp_dec_get_srcpad (filter, is_rtcp),
+        buf_list);
+  else
+    gst_buffer_list_unref (buf_list);
+
+  if (data.other_list)
+    other_ret =
+        gst_pad_push_list (gst_srtp_dec_get_srcpad (filter, !is_rtcp),
+        data.other_list);
+
+  return ret != GST_FLOW_OK ? ret : other_ret;
+}
+
 static GstFlowReturn
 gst_srtp_dec_chain_rtp (GstPad * pad, GstObject * parent, GstBuffer * buf)
 {
@@ -1516,6 +1638,20 @@ gst_srtp_dec_chain_rtcp (GstPad * pad, GstObject * parent, GstBuffer * buf)
   return gst_srtp_dec_chain (pad, parent, buf, TRUE);
 }
 
+static GstFlowReturn
+gst_srtp_dec_chain_list_rtp (GstPad * pad, GstObject * parent,
+    GstBufferList * buf_list)
+{
+  return gst_srtp_dec_chain_list (pad, parent, buf_list, FALSE);
+}
+
+static GstFlowReturn
+gst_srtp_dec_chain_list_rtcp (GstPad * pad, GstObject * parent,
+    GstBufferList * buf_list)
+{
+  return gst_srtp_dec_chain_list (pad, parent, buf_list, TRUE);
+}
+
 static GstStateChangeReturn
 gst_srtp_dec_change_state (GstElement * element, GstStateChange transition)
 {
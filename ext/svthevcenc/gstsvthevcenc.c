@@ -265,6 +265,11 @@ G_DEFINE_TYPE_WITH_CODE (GstSvtHevcEnc, gst_svthevc_enc, GST_TYPE_VIDEO_ENCODER,
     G_IMPLEMENT_INTERFACE (GST_TYPE_PRESET, NULL));
 
 #define MAX_FORMAT_COUNT 6
+
+/* how often the output thread polls the encoder while frames are in flight,
+ * SVT-HEVC only blocks for output once the end of stream was sent */
+#define OUTPUT_POLL_INTERVAL (G_TIME_SPAN_MILLISECOND)
+
 typedef struct
 {
   const GstH265Profile gst_profile;
@@ -672,6 +677,10 @@ gst_svthevc_enc_init (GstSvtHevcEnc * encoder)
   encoder->internal_pool = NULL;
   encoder->aligned_info = NULL;
 
+  g_mutex_init (&encoder->output_lock);
+  g_cond_init (&encoder->output_cond);
+  encoder->output_flow = GST_FLOW_OK;
+
   GST_PAD_SET_ACCEPT_TEMPLATE (GST_VIDEO_ENCODER_SINK_PAD (encoder));
 }
 
@@ -698,8 +707,10 @@ gst_svthevc_enc_stop (GstVideoEncoder * encoder)
 
   /* Always drain SVT-HEVC encoder before releasing SVT-HEVC.
    * Otherwise, randomly block happens when releasing SVT-HEVC. */
+  GST_VIDEO_ENCODER_STREAM_LOCK (encoder);
   gst_svthevc_enc_drain_encoder (svthevcenc, FALSE);
   gst_svthevc_enc_close_encoder (svthevcenc);
+  GST_VIDEO_ENCODER_STREAM_UNLOCK (encoder);
 
   if (svthevcenc->input_state)
     gst_video_codec_state_unref (svthevcenc->input_state);
@@ -753,6 +764,9 @@ gst_svthevc_enc_finalize (GObject * object)
 
   g_free ((gpointer) encoder->svthevc_version);
 
+  g_mutex_clear (&encoder->output_lock);
+  g_cond_clear (&encoder->output_cond);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -903,6 +917,81 @@ read_in_data (EB_H265_ENC_CONFIGURATION * config,
   headerPtr->nAllocLen = headerPtr->nFilledLen = GST_VIDEO_FRAME_SIZE (vframe);
 }
 
+static gpointer
+gst_svthevc_enc_output_loop (GstSvtHevcEnc * encoder)
+{
+  GstFlowReturn ret;
+  gboolean got_packet;
+
+  g_mutex_lock (&encoder->output_lock);
+  while (encoder->output_running) {
+    if (encoder->frames_in_flight == 0) {
+      g_cond_wait (&encoder->output_cond, &encoder->output_lock);
+      continue;
+    }
+    g_mutex_unlock (&encoder->output_lock);
+
+    GST_VIDEO_ENCODER_STREAM_LOCK (encoder);
+    ret = gst_svthevc_enc_receive_frame (encoder, &got_packet, TRUE);
+    GST_VIDEO_ENCODER_STREAM_UNLOCK (encoder);
+
+    g_mutex_lock (&encoder->output_lock);
+    if (ret != GST_FLOW_OK) {
+      GST_DEBUG_OBJECT (encoder, "output thread stopping, flow %s",
+          gst_flow_get_name (ret));
+      encoder->output_flow = ret;
+      break;
+    }
+
+    if (got_packet) {
+      if (encoder->frames_in_flight > 0)
+        encoder->frames_in_flight--;
+    } else {
+      g_cond_wait_until (&encoder->output_cond, &encoder->output_lock,
+          g_get_monotonic_time () + OUTPUT_POLL_INTERVAL);
+    }
+  }
+  g_mutex_unlock (&encoder->output_lock);
+
+  return NULL;
+}
+
+/* Retrieves the encoded frames on their own thread, so that sending input
+ * to the encoder does not wait for its lookahead */
+static void
+gst_svthevc_enc_start_output_thread (GstSvtHevcEnc * encoder)
+{
+  g_mutex_lock (&encoder->output_lock);
+  encoder->output_running = TRUE;
+  encoder->frames_in_flight = 0;
+  encoder->output_flow = GST_FLOW_OK;
+  encoder->output_thread = g_thread_new ("svthevcenc-output",
+      (GThreadFunc) gst_svthevc_enc_output_loop, encoder);
+  g_mutex_unlock (&encoder->output_lock);
+}
+
+/* Must be called with the stream lock held, which is released while waiting
+ * for the output thread to finish its last frame */
+static void
+gst_svthevc_enc_stop_output_thread (GstSvtHevcEnc * encoder)
+{
+  GThread *thread;
+
+  g_mutex_lock (&encoder->output_lock);
+  thread = encoder->output_thread;
+  encoder->output_thread = NULL;
+  encoder->output_running = FALSE;
+  g_cond_signal (&encoder->output_cond);
+  g_mutex_unlock (&encoder->output_lock);
+
+  if (!thread)
+    return;
+
+  GST_VIDEO_ENCODER_STREAM_UNLOCK (encoder);
+  g_thread_join (thread);
+  GST_VIDEO_ENCODER_STREAM_LOCK (encoder);
+}
+
 /*
  * gst_svthevc_enc_init_encoder
  * @encoder:  Encoder which should be initialized.
@@ -955,6 +1044,8 @@ gst_svthevc_enc_init_encoder (GstSvtHevcEnc * encoder)
   encoder->dts_offset = 0;
   encoder->first_frame = NULL;
 
+  gst_svthevc_enc_start_output_thread (encoder);
+
   return TRUE;
 
 failed_init_handle:
@@ -1584,23 +1675,27 @@ gst_svthevc_enc_handle_frame (GstVideoEncoder * video_enc,
 {
   GstSvtHevcEnc *encoder = GST_SVTHEVC_ENC (video_enc);
   GstFlowReturn ret = GST_FLOW_OK;
-  gboolean got_packet;
 
   if (G_UNLIKELY (encoder->svt_handle == NULL))
     goto not_inited;
 
+  g_mutex_lock (&encoder->output_lock);
+  ret = encoder->output_flow;
+  g_mutex_unlock (&encoder->output_lock);
+
+  if (ret != GST_FLOW_OK) {
+    GST_DEBUG_OBJECT (encoder, "output thread returned %s",
+        gst_flow_get_name (ret));
+    gst_video_codec_frame_unref (frame);
+    goto done;
+  }
+
+  /* the output thread collects the encoded frames */
   ret = gst_svthevc_enc_send_frame (encoder, frame);
 
   if (ret != GST_FLOW_OK)
     goto encode_fail;
 
-  do {
-    ret = gst_svthevc_enc_receive_frame (encoder, &got_packet, TRUE);
-    GST_LOG_OBJECT (encoder, "ret %d, got_packet %d", ret, got_packet);
-    if (ret != GST_FLOW_OK)
-      break;
-  } while (got_packet);
-
 done:
   return ret;
 
@@ -1698,27 +1793,31 @@ gst_svthevc_enc_send_frame (GstSvtHevcEnc * encoder, GstVideoCodecFrame * frame)
 
   headerPtr = encoder->in_buf;
 
-  /* Check that stride is a multiple of pstride, otherwise convert to
-   * desired stride from SVT-HEVC.*/
+  if (!gst_video_frame_map (&vframe, info, frame->input_buffer, GST_MAP_READ)) {
+    GST_ERROR_OBJECT (encoder, "Failed to map frame");
+    gst_video_codec_frame_unref (frame);
+    return GST_FLOW_ERROR;
+  }
+
+  /* The planes are passed as is when the strides of this buffer are a
+   * multiple of pstride, otherwise convert to desired stride from SVT-HEVC */
   for (i = 0; i < 3; i++) {
-    if (GST_VIDEO_INFO_COMP_STRIDE (info,
-            i) % GST_VIDEO_INFO_COMP_PSTRIDE (info, i)) {
+    if (GST_VIDEO_FRAME_COMP_STRIDE (&vframe,
+            i) % GST_VIDEO_FRAME_COMP_PSTRIDE (&vframe, i)) {
       GST_LOG_OBJECT (encoder, "need to convert frame");
-      if (!gst_svthevc_enc_convert_frame (encoder, frame)) {
-        if (frame)
-          gst_video_codec_frame_unref (frame);
+      gst_video_frame_unmap (&vframe);
+
+      if (!gst_svthevc_enc_convert_frame (encoder, frame) ||
+          !gst_video_frame_map (&vframe, info, frame->input_buffer,
+              GST_MAP_READ)) {
+        GST_ERROR_OBJECT (encoder, "Failed to convert frame");
+        gst_video_codec_frame_unref (frame);
+        return GST_FLOW_ERROR;
       }
       break;
     }
   }
 
-  if (!gst_video_frame_map (&vframe, info, frame->input_buffer, GST_MAP_READ)) {
-    GST_ERROR_OBJECT (encoder, "Failed to map frame");
-    if (frame)
-      gst_video_codec_frame_unref (frame);
-    return GST_FLOW_ERROR;
-  }
-
   read_in_data (&encoder->enc_params, &vframe, headerPtr);
 
   headerPtr->nFlags = 0;
@@ -1766,9 +1865,26 @@ out:
     svt_ret = EbH265EncSendPicture (encoder->svt_handle, &headerPtrLast);
     encoder->svt_eos_flag = EOS_REACHED;
   } else {
+    gboolean threaded;
+
+    g_mutex_lock (&encoder->output_lock);
+    threaded = encoder->output_thread != NULL;
+    encoder->frames_in_flight++;
+    g_mutex_unlock (&encoder->output_lock);
+
     GST_LOG_OBJECT (encoder, "encode frame");
+    /* Sending blocks while the encoder has no free input buffers, let the
+     * output thread finish frames meanwhile */
+    if (threaded)
+      GST_VIDEO_ENCODER_STREAM_UNLOCK (encoder);
     svt_ret = EbH265EncSendPicture (encoder->svt_handle, headerPtr);
+    if (threaded)
+      GST_VIDEO_ENCODER_STREAM_LOCK (encoder);
     encoder->first_buffer = FALSE;
+
+    g_mutex_lock (&encoder->output_lock);
+    g_cond_signal (&encoder->output_cond);
+    g_mutex_unlock (&encoder->output_lock);
   }
 
   GST_LOG_OBJECT (encoder, "encoder result (%d)", svt_ret);
@@ -2030,6 +2146,9 @@ gst_svthevc_enc_drain_encoder (GstSvtHevcEnc * encoder, gboolean send)
   GstFlowReturn ret = GST_FLOW_OK;
   gboolean got_packet;
 
+  /* the remaining frames are collected here */
+  gst_svthevc_enc_stop_output_thread (encoder);
+
   /* first send the remaining frames */
 
   if (G_UNLIKELY (encoder->svt_handle == NULL) ||
@@ -95,6 +95,14 @@ struct _GstSvtHevcEnc
   gboolean first_buffer;
   gboolean update_latency;
 
+  /* output retrieval thread, running while frames are being encoded */
+  GThread *output_thread;
+  GMutex output_lock;
+  GCond output_cond;
+  gboolean output_running;
+  guint frames_in_flight;
+  GstFlowReturn output_flow;
+
   /* Internally used for convert stride to multiple of pstride */
   GstBufferPool *internal_pool;
   GstVideoInfo *aligned_info;
@@ -196,6 +196,16 @@ static GstTtmlRenderRenderedImage *gst_ttml_render_stitch_images (GPtrArray *
     images, GstTtmlDirection direction);
 
 static gboolean gst_ttml_render_color_is_transparent (GstSubtitleColor * color);
+static void gst_ttml_render_region_cache_entry_free (gpointer data);
+
+/* how many rendered regions are kept around to be reused by later cues */
+#define REGION_CACHE_SIZE 32
+
+typedef struct
+{
+  GstVideoOverlayComposition *composition;
+  guint64 last_used;
+} RegionCacheEntry;
 
 GType
 gst_ttml_render_get_type (void)
@@ -294,6 +304,8 @@ gst_ttml_render_finalize (GObject * object)
     render->layout = NULL;
   }
 
+  g_hash_table_unref (render->region_cache);
+
   g_mutex_clear (&render->lock);
   g_cond_clear (&render->cond);
 
@@ -354,6 +366,8 @@ gst_ttml_render_init (GstTtmlRender * render, GstTtmlRenderClass * klass)
   render->text_linked = FALSE;
 
   render->compositions = NULL;
+  render->region_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+      g_free, gst_ttml_render_region_cache_entry_free);
   render->layout =
       pango_layout_new (GST_TTML_RENDER_GET_CLASS (render)->pango_context);
 
@@ -511,6 +525,8 @@ gst_ttml_render_setcaps (GstTtmlRender * render, GstCaps * caps)
   ret = gst_ttml_render_negotiate (render, caps);
 
   GST_TTML_RENDER_LOCK (render);
+  /* regions rendered for another frame size won't be used again */
+  g_hash_table_remove_all (render->region_cache);
   g_mutex_lock (GST_TTML_RENDER_GET_CLASS (render)->pango_lock);
   if (!gst_ttml_render_can_handle_caps (caps)) {
     GST_DEBUG_OBJECT (render, "unsupported caps %" GST_PTR_FORMAT, caps);
@@ -2755,6 +2771,127 @@ gst_ttml_render_render_text_region (GstTtmlRender * render,
 }
 
 
+static void
+gst_ttml_render_region_cache_entry_free (gpointer data)
+{
+  RegionCacheEntry *entry = (RegionCacheEntry *) data;
+
+  gst_video_overlay_composition_unref (entry->composition);
+  g_slice_free (RegionCacheEntry, entry);
+}
+
+
+static void
+gst_ttml_render_append_style_key (GString * key,
+    const GstSubtitleStyleSet * s)
+{
+  /* doubles printed with enough digits to tell them apart */
+  g_string_append_printf (key, "%d|%" G_GSIZE_FORMAT ":%s|%.17g|%.17g|%d|"
+      "%02x%02x%02x%02x|%02x%02x%02x%02x|%d|%d|%d|%d|%d|%d|"
+      "%.17g|%.17g|%.17g|%.17g|%.17g|%d|%.17g|%.17g|%.17g|%.17g|"
+      "%d|%d|%d|%d|", s->text_direction,
+      s->font_family ? strlen (s->font_family) : 0,
+      s->font_family ? s->font_family : "", s->font_size, s->line_height,
+      s->text_align, s->color.r, s->color.g, s->color.b, s->color.a,
+      s->background_color.r, s->background_color.g, s->background_color.b,
+      s->background_color.a, s->font_style, s->font_weight,
+      s->text_decoration, s->unicode_bidi, s->wrap_option, s->multi_row_align,
+      s->line_padding, s->origin_x, s->origin_y, s->extent_w, s->extent_h,
+      s->display_align, s->padding_start, s->padding_end, s->padding_before,
+      s->padding_after, s->writing_mode, s->show_background, s->overflow,
+      s->fill_line_gap);
+}
+
+
+/* Describes everything the rendering of @region depends on: the frame size,
+ * the style sets of the region, blocks and elements, and the text. */
+static gchar *
+gst_ttml_render_region_key (GstTtmlRender * render,
+    GstSubtitleRegion * region, GstBuffer * text_buf)
+{
+  GString *key = g_string_new (NULL);
+  guint i, j;
+
+  g_string_append_printf (key, "%dx%d|", render->width, render->height);
+  gst_ttml_render_append_style_key (key, region->style_set);
+
+  for (i = 0; i < gst_subtitle_region_get_block_count (region); ++i) {
+    const GstSubtitleBlock *block = gst_subtitle_region_get_block (region, i);
+
+    g_string_append (key, "B|");
+    gst_ttml_render_append_style_key (key, block->style_set);
+
+    for (j = 0; j < gst_subtitle_block_get_element_count (block); ++j) {
+      const GstSubtitleElement *element =
+          gst_subtitle_block_get_element (block, j);
+      gchar *text;
+
+      text = gst_ttml_render_get_text_from_buffer (text_buf,
+          element->text_index);
+      g_string_append_printf (key, "E%d|", element->suppress_whitespace);
+      gst_ttml_render_append_style_key (key, element->style_set);
+      g_string_append_printf (key, "%" G_GSIZE_FORMAT ":%s|",
+          text ? strlen (text) : 0, text ? text : "");
+      g_free (text);
+    }
+  }
+
+  return g_string_free (key, FALSE);
+}
+
+
+/* Returns the composition of @region, reusing the one rendered for an earlier
+ * cue with the same region, styles and text if there is one. */
+static GstVideoOverlayComposition *
+gst_ttml_render_get_region_composition (GstTtmlRender * render,
+    GstSubtitleRegion * region, GstBuffer * text_buf)
+{
+  RegionCacheEntry *entry;
+  GstVideoOverlayComposition *composition;
+  gchar *key;
+
+  key = gst_ttml_render_region_key (render, region, text_buf);
+  render->region_cache_age++;
+
+  entry = g_hash_table_lookup (render->region_cache, key);
+  if (entry) {
+    GST_CAT_LOG (ttmlrender_debug, "reusing rendered region");
+    entry->last_used = render->region_cache_age;
+    g_free (key);
+    return gst_video_overlay_composition_ref (entry->composition);
+  }
+
+  composition = gst_ttml_render_render_text_region (render, region, text_buf);
+  if (!composition) {
+    g_free (key);
+    return NULL;
+  }
+
+  /* evict the least recently used region */
+  if (g_hash_table_size (render->region_cache) >= REGION_CACHE_SIZE) {
+    GHashTableIter iter;
+    gpointer k, v, oldest_key = NULL;
+    guint64 oldest = G_MAXUINT64;
+
+    g_hash_table_iter_init (&iter, render->region_cache);
+    while (g_hash_table_iter_next (&iter, &k, &v)) {
+      if (((RegionCacheEntry *) v)->last_used < oldest) {
+        oldest = ((RegionCacheEntry *) v)->last_used;
+        oldest_key = k;
+      }
+    }
+    g_hash_table_remove (render->region_cache, oldest_key);
+  }
+
+  entry = g_slice_new (RegionCacheEntry);
+  entry->composition = gst_video_overlay_composition_ref (composition);
+  entry->last_used = render->region_cache_age;
+  g_hash_table_insert (render->region_cache, key, entry);
+
+  return composition;
+}
+
+
 static GstFlowReturn
 gst_ttml_render_video_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buffer)
@@ -2912,8 +3049,8 @@ wait_for_text_buf:
           for (i = 0; i < subtitle_meta->regions->len; ++i) {
             GstVideoOverlayComposition *composition;
             region = g_ptr_array_index (subtitle_meta->regions, i);
-            composition = gst_ttml_render_render_text_region (render, region,
-                render->text_buffer);
+            composition = gst_ttml_render_get_region_composition (render,
+                region, render->text_buffer);
             if (composition) {
               render->compositions = g_list_append (render->compositions,
                   composition);
@@ -3043,6 +3180,11 @@ gst_ttml_render_change_state (GstElement * element, GstStateChange transition)
     return ret;
 
   switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      GST_TTML_RENDER_LOCK (render);
+      g_hash_table_remove_all (render->region_cache);
+      GST_TTML_RENDER_UNLOCK (render);
+      break;
     case GST_STATE_CHANGE_READY_TO_PAUSED:
       GST_TTML_RENDER_LOCK (render);
       render->text_flushing = FALSE;
@@ -93,6 +93,10 @@ struct _GstTtmlRender {
 
     PangoLayout             *layout;
     GList * compositions;
+
+    /* rendered regions of recent cues, by region+style+text key */
+    GHashTable              *region_cache;
+    guint64                  region_cache_age;
 };
 
 struct _GstTtmlRenderClass {
@@ -35,6 +35,8 @@
 #include "vkcolorconvert.h"
 #include "vkdownload.h"
 #include "vkviewconvert.h"
+#include "vkscale.h"
+#include "vkcompositor.h"
 #include "vkdeviceprovider.h"
 
 #define GST_CAT_DEFAULT gst_vulkan_debug
@@ -75,6 +77,16 @@ plugin_init (GstPlugin * plugin)
     return FALSE;
   }
 
+  if (!gst_element_register (plugin, "vulkanscale",
+          GST_RANK_NONE, GST_TYPE_VULKAN_SCALE)) {
+    return FALSE;
+  }
+
+  if (!gst_element_register (plugin, "vulkancompositor",
+          GST_RANK_NONE, GST_TYPE_VULKAN_COMPOSITOR)) {
+    return FALSE;
+  }
+
   if (!gst_device_provider_register (plugin, "vulkandeviceprovider",
           GST_RANK_MARGINAL, GST_TYPE_VULKAN_DEVICE_PROVIDER))
     return FALSE;
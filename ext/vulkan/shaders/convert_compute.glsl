@@ -0,0 +1,64 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _CONVERT_COMPUTE_H_
+#define _CONVERT_COMPUTE_H_
+
+#include "color_convert_generic.glsl"
+#include "swizzle.glsl"
+
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+/* out_stride, out_offset and out_rows describe the planes in the output
+ * buffer, in units of 32 bit words */
+layout(set = 0, binding = 0) uniform reorder {
+  ivec4 in_reorder_idx;
+  ivec4 out_reorder_idx;
+  ivec4 out_stride;
+  ivec4 out_offset;
+  ivec4 out_rows;
+  ivec2 outSize;
+  int clobber_alpha;
+  ColorMatrices matrices;
+};
+
+layout(std430, set = 0, binding = 4) writeonly buffer outBuffer {
+  uint outData[];
+};
+
+ivec2 clamp_fetch_pos (in sampler2D tex, in ivec2 pos)
+{
+  return clamp (pos, ivec2(0), textureSize (tex, 0) - ivec2(1));
+}
+
+vec4 fetch_texel (in sampler2D tex, in ivec2 pos)
+{
+  return texelFetch (tex, clamp_fetch_pos (tex, pos), 0);
+}
+
+/* stores 4 bytes, @bytes.x being the first one in memory */
+void store_word (in int plane, in ivec2 pos, in vec4 bytes)
+{
+  if (pos.x >= out_stride[plane] || pos.y >= out_rows[plane])
+    return;
+
+  outData[out_offset[plane] + pos.y * out_stride[plane] + pos.x] =
+      packUnorm4x8 (bytes);
+}
+
+#endif
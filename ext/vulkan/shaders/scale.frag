@@ -0,0 +1,107 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#version 450 core
+
+/* these match the order and number of GstVulkanScaleMethod */
+#define METHOD_BILINEAR 0
+#define METHOD_BICUBIC 1
+#define METHOD_LANCZOS 2
+
+/* limits the number of taps per direction when downscaling by large factors */
+#define MAX_TAPS 16
+
+#define PI 3.14159265358979323846
+
+layout(location = 0) in vec2 inTexCoord;
+
+layout(set = 0, binding = 0) uniform ScaleParams {
+  vec2 in_size;
+  /* input size / output size */
+  vec2 ratio;
+  int method;
+};
+layout(set = 0, binding = 1) uniform sampler2D inTexture;
+
+layout(location = 0) out vec4 outColor;
+
+/* Catmull-Rom spline */
+float cubic (float x)
+{
+  x = abs (x);
+  if (x < 1.0)
+    return (1.5 * x - 2.5) * x * x + 1.0;
+  if (x < 2.0)
+    return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;
+  return 0.0;
+}
+
+float sinc (float x)
+{
+  if (abs (x) < 1e-5)
+    return 1.0;
+  x *= PI;
+  return sin (x) / x;
+}
+
+/* a = 3 */
+float lanczos (float x)
+{
+  if (abs (x) >= 3.0)
+    return 0.0;
+  return sinc (x) * sinc (x / 3.0);
+}
+
+float weight (float x)
+{
+  if (method == METHOD_BICUBIC)
+    return cubic (x);
+  return lanczos (x);
+}
+
+void main()
+{
+  if (method == METHOD_BILINEAR) {
+    outColor = texture (inTexture, inTexCoord);
+    return;
+  }
+
+  float support = method == METHOD_BICUBIC ? 2.0 : 3.0;
+  /* widen the kernel when downscaling to avoid aliasing */
+  vec2 radius = min (support * max (ratio, vec2 (1.0)), vec2 (MAX_TAPS / 2));
+  vec2 stretch = radius / support;
+
+  vec2 pos = inTexCoord * in_size - 0.5;
+  ivec2 first = ivec2 (floor (pos - radius)) + 1;
+  ivec2 last = ivec2 (floor (pos + radius));
+  ivec2 max_coord = ivec2 (in_size) - 1;
+
+  vec4 sum = vec4 (0.0);
+  float total = 0.0;
+  for (int y = first.y; y <= last.y; y++) {
+    float wy = weight ((float (y) - pos.y) / stretch.y);
+    for (int x = first.x; x <= last.x; x++) {
+      float w = wy * weight ((float (x) - pos.x) / stretch.x);
+      ivec2 coord = clamp (ivec2 (x, y), ivec2 (0), max_coord);
+      sum += w * texelFetch (inTexture, coord, 0);
+      total += w;
+    }
+  }
+
+  outColor = clamp (sum / total, 0.0, 1.0);
+}
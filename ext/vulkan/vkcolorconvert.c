@@ -42,13 +42,30 @@
 #include "shaders/rgb_to_ayuv.frag.h"
 #include "shaders/rgb_to_yuy2.frag.h"
 #include "shaders/rgb_to_nv12.frag.h"
+#include "shaders/swizzle.comp.h"
+#include "shaders/ayuv_to_rgb.comp.h"
+#include "shaders/yuy2_to_rgb.comp.h"
+#include "shaders/nv12_to_rgb.comp.h"
+#include "shaders/i420_to_rgb.comp.h"
+#include "shaders/rgb_to_ayuv.comp.h"
+#include "shaders/rgb_to_yuy2.comp.h"
+#include "shaders/rgb_to_nv12.comp.h"
+#include "shaders/rgb_to_i420.comp.h"
+#include "shaders/nv12_to_i420.comp.h"
+#include "shaders/i420_to_nv12.comp.h"
 
 GST_DEBUG_CATEGORY (gst_debug_vulkan_color_convert);
 #define GST_CAT_DEFAULT gst_debug_vulkan_color_convert
 
-#define N_SHADER_INFO (8*8 + 8*3*2)
+#define N_SHADER_INFO (8*8 + 8*4*2 + 2)
 static shader_info shader_infos[N_SHADER_INFO];
 
+/* must match convert_compute.glsl */
+#define COMPUTE_OUTPUT_BINDING 4
+#define COMPUTE_LOCAL_SIZE 8
+
+#define DEFAULT_USE_COMPUTE TRUE
+
 static void
 get_rgb_format_swizzle_order (GstVideoFormat format,
     gint swizzle[GST_VIDEO_MAX_COMPONENTS])
@@ -515,6 +532,7 @@ video_format_to_reorder (GstVideoFormat v_format, gint * reorder,
       reorder[3] = input ? 3 : 2;
       break;
     case GST_VIDEO_FORMAT_NV12:
+    case GST_VIDEO_FORMAT_I420:
       reorder[0] = 0;
       reorder[1] = 1;
       reorder[2] = 2;
@@ -767,7 +785,7 @@ GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE_WITH_FEATURES
         (GST_CAPS_FEATURE_MEMORY_VULKAN_IMAGE,
-            "{ BGRA, RGBA, ABGR, ARGB, BGRx, RGBx, xBGR, xRGB, AYUV, YUY2, NV12 }")));
+            "{ BGRA, RGBA, ABGR, ARGB, BGRx, RGBx, xBGR, xRGB, AYUV, YUY2, NV12, I420 }")));
 
 static GstStaticPadTemplate gst_vulkan_src_template =
 GST_STATIC_PAD_TEMPLATE ("src",
@@ -775,11 +793,12 @@ GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE_WITH_FEATURES
         (GST_CAPS_FEATURE_MEMORY_VULKAN_IMAGE,
-            "{ BGRA, RGBA, ABGR, ARGB, BGRx, RGBx, xBGR, xRGB, AYUV, YUY2, NV12 }")));
+            "{ BGRA, RGBA, ABGR, ARGB, BGRx, RGBx, xBGR, xRGB, AYUV, YUY2, NV12, I420 }")));
 
 enum
 {
   PROP_0,
+  PROP_USE_COMPUTE,
 };
 
 enum
@@ -803,6 +822,10 @@ struct yuv_info
   gsize from_frag_size;
   gchar *to_frag;
   gsize to_frag_size;
+  gchar *from_comp;
+  gsize from_comp_size;
+  gchar *to_comp;
+  gsize to_comp_size;
 };
 
 static void
@@ -814,13 +837,23 @@ fill_shader_info (void)
   };
   struct yuv_info yuvs[] = {
     {GST_VIDEO_FORMAT_AYUV, ayuv_to_rgb_frag, ayuv_to_rgb_frag_size,
-        rgb_to_ayuv_frag, rgb_to_ayuv_frag_size},
+        rgb_to_ayuv_frag, rgb_to_ayuv_frag_size,
+        ayuv_to_rgb_comp, ayuv_to_rgb_comp_size,
+        rgb_to_ayuv_comp, rgb_to_ayuv_comp_size},
     {GST_VIDEO_FORMAT_YUY2, yuy2_to_rgb_frag, yuy2_to_rgb_frag_size,
-        rgb_to_yuy2_frag, rgb_to_yuy2_frag_size},
+        rgb_to_yuy2_frag, rgb_to_yuy2_frag_size,
+        yuy2_to_rgb_comp, yuy2_to_rgb_comp_size,
+        rgb_to_yuy2_comp, rgb_to_yuy2_comp_size},
 /*    {GST_VIDEO_FORMAT_UYVY, yuy2_to_rgb_frag, yuy2_to_rgb_frag_size,
         rgb_to_yuy2_frag, rgb_to_yuy2_frag_size},*/
     {GST_VIDEO_FORMAT_NV12, nv12_to_rgb_frag, nv12_to_rgb_frag_size,
-        rgb_to_nv12_frag, rgb_to_nv12_frag_size},
+        rgb_to_nv12_frag, rgb_to_nv12_frag_size,
+        nv12_to_rgb_comp, nv12_to_rgb_comp_size,
+        rgb_to_nv12_comp, rgb_to_nv12_comp_size},
+    /* I420 is only implemented with compute shaders */
+    {GST_VIDEO_FORMAT_I420, NULL, 0, NULL, 0,
+        i420_to_rgb_comp, i420_to_rgb_comp_size,
+        rgb_to_i420_comp, rgb_to_i420_comp_size},
   };
   guint info_i = 0;
   guint i, j;
@@ -848,6 +881,8 @@ fill_shader_info (void)
           .cmd_create_uniform = swizzle_rgb_create_uniform_memory,
           .frag_code = clobber_alpha ? swizzle_and_clobber_alpha_frag : swizzle_frag,
           .frag_size = clobber_alpha ? swizzle_and_clobber_alpha_frag_size : swizzle_frag_size,
+          .comp_code = swizzle_comp,
+          .comp_size = swizzle_comp_size,
           .uniform_size = sizeof (struct RGBUpdateData),
           .notify = (GDestroyNotify) unref_memory_if_set,
           .user_data = NULL,
@@ -863,6 +898,8 @@ fill_shader_info (void)
           .cmd_create_uniform = yuv_to_rgb_create_uniform_memory,
           .frag_code = yuvs[j].to_frag,
           .frag_size = yuvs[j].to_frag_size,
+          .comp_code = yuvs[j].to_comp,
+          .comp_size = yuvs[j].to_comp_size,
           .uniform_size = sizeof(struct YUVUpdateData),
           .notify = (GDestroyNotify) unref_memory_if_set,
           .user_data = NULL,
@@ -874,27 +911,106 @@ fill_shader_info (void)
           .cmd_create_uniform = yuv_to_rgb_create_uniform_memory,
           .frag_code = yuvs[j].from_frag,
           .frag_size = yuvs[j].from_frag_size,
+          .comp_code = yuvs[j].from_comp,
+          .comp_size = yuvs[j].from_comp_size,
           .uniform_size = sizeof(struct YUVUpdateData),
           .notify = (GDestroyNotify) unref_memory_if_set,
           .user_data = NULL,
       };
     }
   }
+
+  /* planar <-> semi-planar 4:2:0 */
+  GST_TRACE ("Initializing info for NV12 -> I420");
+  shader_infos[info_i++] = (shader_info) {
+      .from = GST_VIDEO_FORMAT_NV12,
+      .to = GST_VIDEO_FORMAT_I420,
+      .comp_code = nv12_to_i420_comp,
+      .comp_size = nv12_to_i420_comp_size,
+      .notify = (GDestroyNotify) unref_memory_if_set,
+      .user_data = NULL,
+  };
+  GST_TRACE ("Initializing info for I420 -> NV12");
+  shader_infos[info_i++] = (shader_info) {
+      .from = GST_VIDEO_FORMAT_I420,
+      .to = GST_VIDEO_FORMAT_NV12,
+      .comp_code = i420_to_nv12_comp,
+      .comp_size = i420_to_nv12_comp_size,
+      .notify = (GDestroyNotify) unref_memory_if_set,
+      .user_data = NULL,
+  };
   /* *INDENT-ON* */
   GST_TRACE ("initialized %u formats", info_i);
 
   g_assert (info_i == N_SHADER_INFO);
 }
 
+static void
+gst_vulkan_color_convert_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstVulkanColorConvert *conv = GST_VULKAN_COLOR_CONVERT (object);
+
+  switch (prop_id) {
+    case PROP_USE_COMPUTE:
+      GST_OBJECT_LOCK (conv);
+      conv->use_compute = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (conv);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_vulkan_color_convert_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstVulkanColorConvert *conv = GST_VULKAN_COLOR_CONVERT (object);
+
+  switch (prop_id) {
+    case PROP_USE_COMPUTE:
+      GST_OBJECT_LOCK (conv);
+      g_value_set_boolean (value, conv->use_compute);
+      GST_OBJECT_UNLOCK (conv);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 gst_vulkan_color_convert_class_init (GstVulkanColorConvertClass * klass)
 {
+  GObjectClass *gobject_class;
   GstElementClass *gstelement_class;
   GstBaseTransformClass *gstbasetransform_class;
 
+  gobject_class = (GObjectClass *) klass;
   gstelement_class = (GstElementClass *) klass;
   gstbasetransform_class = (GstBaseTransformClass *) klass;
 
+  gobject_class->set_property = gst_vulkan_color_convert_set_property;
+  gobject_class->get_property = gst_vulkan_color_convert_get_property;
+
+  /**
+   * GstVulkanColorConvert:use-compute:
+   *
+   * Convert with compute shaders writing the output directly instead of
+   * rendering a full screen quad when the queue supports compute.  Compute
+   * is always used on queues without graphics support and for conversions
+   * only implemented with compute shaders (I420).
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_USE_COMPUTE,
+      g_param_spec_boolean ("use-compute", "Use compute",
+          "Prefer compute shaders over the graphics pipeline",
+          DEFAULT_USE_COMPUTE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
   gst_element_class_set_metadata (gstelement_class, "Vulkan Color Convert",
       "Filter/Video/Convert", "A Vulkan Color Convert",
       "Matthew Waters <matthew@centricular.com>");
@@ -919,6 +1035,7 @@ gst_vulkan_color_convert_class_init (GstVulkanColorConvertClass * klass)
 static void
 gst_vulkan_color_convert_init (GstVulkanColorConvert * conv)
 {
+  conv->use_compute = DEFAULT_USE_COMPUTE;
 }
 
 static void
@@ -971,7 +1088,43 @@ _init_supported_formats (GstVulkanDevice * device, gboolean output,
       "BGRx", "BGRA", "xRGB", "xBGR", "ARGB", "ABGR", NULL);
 
   _append_value_string_list (supported_formats, "AYUV", "YUY2", /*"UYVY", */
-      "NV12", NULL);
+      "NV12", "I420", NULL);
+}
+
+/* the planar and semi-planar 4:2:0 formats can be converted into each
+ * other directly */
+static const gchar *
+_get_yuv_counterpart (GstVideoFormat format)
+{
+  switch (format) {
+    case GST_VIDEO_FORMAT_NV12:
+      return "I420";
+    case GST_VIDEO_FORMAT_I420:
+      return "NV12";
+    default:
+      return NULL;
+  }
+}
+
+static void
+_append_yuv_counterpart (GValue * list, GstVideoFormat format)
+{
+  const gchar *counterpart = _get_yuv_counterpart (format);
+  gint i, len;
+
+  if (!counterpart)
+    return;
+
+  len = gst_value_list_get_size (list);
+  for (i = 0; i < len; i++) {
+    const GValue *val = gst_value_list_get_value (list, i);
+
+    if (G_VALUE_HOLDS_STRING (val)
+        && g_strcmp0 (g_value_get_string (val), counterpart) == 0)
+      return;
+  }
+
+  _append_value_string_list (list, counterpart, NULL);
 }
 
 /* copies the given caps */
@@ -1031,6 +1184,7 @@ gst_vulkan_color_convert_transform_format_info (GstVulkanDevice * device,
           if (GST_VIDEO_FORMAT_INFO_FLAGS (t_info) & (GST_VIDEO_FORMAT_FLAG_YUV
                   | GST_VIDEO_FORMAT_FLAG_GRAY)) {
             gst_value_list_append_value (&passthrough_formats, val);
+            _append_yuv_counterpart (&passthrough_formats, v_format);
           } else if (GST_VIDEO_FORMAT_INFO_FLAGS (t_info) &
               GST_VIDEO_FORMAT_FLAG_RGB) {
             have_rgb_formats = TRUE;
@@ -1055,7 +1209,16 @@ gst_vulkan_color_convert_transform_format_info (GstVulkanDevice * device,
       if (GST_VIDEO_FORMAT_INFO_FLAGS (t_info) & (GST_VIDEO_FORMAT_FLAG_YUV |
               GST_VIDEO_FORMAT_FLAG_GRAY)) {
         /* add passthrough structure, then the rgb conversion structure */
-        gst_structure_set_value (st, "format", format);
+        if (_get_yuv_counterpart (v_format)) {
+          GValue formats = G_VALUE_INIT;
+
+          _init_value_string_list (&formats, format_str,
+              _get_yuv_counterpart (v_format), NULL);
+          gst_structure_set_value (st, "format", &formats);
+          g_value_unset (&formats);
+        } else {
+          gst_structure_set_value (st, "format", format);
+        }
         gst_caps_append_structure_full (res, gst_structure_copy (st),
             gst_caps_features_copy (f));
         gst_structure_set_value (st, "format", &supported_rgb_formats);
@@ -1095,6 +1258,811 @@ gst_vulkan_color_convert_transform_caps (GstBaseTransform * bt,
   return caps;
 }
 
+static guint
+finfo_get_plane_pixel_stride (const GstVideoFormatInfo * finfo, guint plane)
+{
+  guint i;
+
+  for (i = 0; i < finfo->n_components; i++) {
+    if (finfo->plane[i] == plane)
+      return finfo->pixel_stride[i];
+  }
+
+  return 0;
+}
+
+struct ComputeUpdateData
+{
+  int in_reorder[4];
+  int out_reorder[4];
+  int out_stride[4];
+  int out_offset[4];
+  int out_rows[4];
+  int out_size[2];
+  int clobber_alpha;
+  /* each member is aligned on 4x previous component size boundaries */
+  int _padding;
+  struct ColorMatrices matrices;
+};
+
+static void
+calculate_compute_reorder_indexes (GstVideoFormat in_format,
+    GstVulkanImageView * in_views[GST_VIDEO_MAX_COMPONENTS],
+    GstVideoFormat out_format, int ret_in[GST_VIDEO_MAX_COMPONENTS],
+    int ret_out[GST_VIDEO_MAX_COMPONENTS])
+{
+  const GstVideoFormatInfo *in_finfo, *out_finfo;
+  int i;
+
+  in_finfo = gst_video_format_get_info (in_format);
+  out_finfo = gst_video_format_get_info (out_format);
+
+  /* the YUV input shaders know which texel holds which component */
+  if (GST_VIDEO_FORMAT_INFO_IS_RGB (in_finfo)
+      || in_format == GST_VIDEO_FORMAT_AYUV) {
+    VkFormat in_vk_formats[GST_VIDEO_MAX_COMPONENTS];
+    int in_vk_order[GST_VIDEO_MAX_COMPONENTS] = { 0, };
+    int in_reorder[GST_VIDEO_MAX_COMPONENTS] = { 0, };
+
+    for (i = 0; i < in_finfo->n_planes; i++)
+      in_vk_formats[i] = in_views[i]->image->create_info.format;
+
+    get_vulkan_format_swizzle_order (in_format, in_vk_formats, in_vk_order);
+    video_format_to_reorder (in_format, in_reorder, TRUE);
+
+    for (i = 0; i < GST_VIDEO_MAX_COMPONENTS; i++)
+      ret_in[i] = in_reorder[in_vk_order[i]];
+  } else {
+    for (i = 0; i < GST_VIDEO_MAX_COMPONENTS; i++)
+      ret_in[i] = i;
+  }
+
+  /* the shaders write raw bytes so packed 4 byte outputs only need to know
+   * which component goes into which byte.  The padding byte of the spaced
+   * RGB formats receives the alpha value. */
+  if (out_finfo->n_planes == 1 && out_finfo->pixel_stride[0] == 4) {
+    for (i = 0; i < GST_VIDEO_MAX_COMPONENTS; i++)
+      ret_out[i] = 3;
+    for (i = 0; i < out_finfo->n_components; i++)
+      ret_out[out_finfo->poffset[i]] = i;
+  } else {
+    for (i = 0; i < GST_VIDEO_MAX_COMPONENTS; i++)
+      ret_out[i] = i;
+  }
+
+  GST_TRACE ("compute in reorder: %u, %u, %u, %u", ret_in[0], ret_in[1],
+      ret_in[2], ret_in[3]);
+  GST_TRACE ("compute out reorder: %u, %u, %u, %u", ret_out[0], ret_out[1],
+      ret_out[2], ret_out[3]);
+}
+
+static GstMemory *
+compute_create_uniform_memory (GstVulkanColorConvert * conv,
+    GstVulkanImageView ** in_views)
+{
+  GstVulkanVideoFilter *vfilter = GST_VULKAN_VIDEO_FILTER (conv);
+  ComputeConvert *compute = &conv->compute;
+  const GstVideoFormatInfo *in_finfo, *out_finfo;
+  struct ComputeUpdateData data = { {0,}, };
+  ConvertInfo *conv_info;
+  GstMapInfo map_info;
+  GstMemory *uniforms;
+  int i;
+
+  uniforms =
+      gst_vulkan_buffer_memory_alloc (vfilter->device,
+      sizeof (struct ComputeUpdateData),
+      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+      VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+  calculate_compute_reorder_indexes (GST_VIDEO_INFO_FORMAT (&vfilter->in_info),
+      in_views, GST_VIDEO_INFO_FORMAT (&vfilter->out_info), data.in_reorder,
+      data.out_reorder);
+
+  for (i = 0; i < GST_VIDEO_INFO_N_PLANES (&vfilter->out_info); i++) {
+    data.out_stride[i] = compute->out_stride[i];
+    data.out_offset[i] = compute->out_offset[i];
+    data.out_rows[i] = compute->out_rows[i];
+  }
+  data.out_size[0] = GST_VIDEO_INFO_WIDTH (&vfilter->out_info);
+  data.out_size[1] = GST_VIDEO_INFO_HEIGHT (&vfilter->out_info);
+
+  in_finfo = vfilter->in_info.finfo;
+  out_finfo = vfilter->out_info.finfo;
+  data.clobber_alpha = !GST_VIDEO_FORMAT_INFO_HAS_ALPHA (in_finfo)
+      && GST_VIDEO_FORMAT_INFO_HAS_ALPHA (out_finfo);
+
+  conv_info = convert_info_new (&vfilter->in_info, &vfilter->out_info);
+  matrix_to_float (&conv_info->to_RGB_matrix, data.matrices.to_RGB);
+  matrix_to_float (&conv_info->convert_matrix, data.matrices.primaries);
+  matrix_to_float (&conv_info->to_YUV_matrix, data.matrices.to_YUV);
+  g_free (conv_info);
+
+  if (!gst_memory_map (uniforms, &map_info, GST_MAP_WRITE)) {
+    gst_memory_unref (uniforms);
+    return NULL;
+  }
+  memcpy (map_info.data, &data, sizeof (data));
+  gst_memory_unmap (uniforms, &map_info);
+
+  return uniforms;
+}
+
+static void
+compute_convert_clear (GstVulkanColorConvert * conv)
+{
+  ComputeConvert *compute = &conv->compute;
+
+  if (compute->trash_list) {
+    gst_vulkan_trash_list_wait (compute->trash_list, -1);
+    gst_vulkan_trash_list_gc (compute->trash_list);
+  }
+
+  gst_clear_mini_object ((GstMiniObject **) & compute->pipeline);
+  gst_clear_mini_object ((GstMiniObject **) & compute->pipeline_layout);
+  gst_clear_object (&compute->descriptor_cache);
+  gst_clear_mini_object ((GstMiniObject **) & compute->descriptor_set_layout);
+  gst_clear_mini_object ((GstMiniObject **) & compute->sampler);
+  gst_clear_mini_object ((GstMiniObject **) & compute->shader);
+  gst_clear_object (&compute->cmd_pool);
+
+  if (compute->uniforms)
+    gst_memory_unref (compute->uniforms);
+  compute->uniforms = NULL;
+  if (compute->output)
+    gst_memory_unref (compute->output);
+  compute->output = NULL;
+
+  compute->active = FALSE;
+}
+
+static gboolean
+compute_create_descriptor_set_layout (GstVulkanColorConvert * conv,
+    GError ** error)
+{
+  GstVulkanVideoFilter *vfilter = GST_VULKAN_VIDEO_FILTER (conv);
+  ComputeConvert *compute = &conv->compute;
+  VkDescriptorSetLayoutBinding bindings[GST_VIDEO_MAX_PLANES + 2] = { {0,} };
+  VkDescriptorSetLayoutCreateInfo layout_info;
+  VkDescriptorSetLayout descriptor_set_layout;
+  int descriptor_n = 0;
+  VkResult err;
+  int i;
+
+  /* *INDENT-OFF* */
+  bindings[descriptor_n++] = (VkDescriptorSetLayoutBinding) {
+      .binding = 0,
+      .descriptorCount = 1,
+      .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+      .pImmutableSamplers = NULL,
+      .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT
+  };
+  for (i = 0; i < GST_VIDEO_INFO_N_PLANES (&vfilter->in_info); i++) {
+    bindings[descriptor_n++] = (VkDescriptorSetLayoutBinding) {
+        .binding = i + 1,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .pImmutableSamplers = NULL,
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT
+    };
+  }
+  bindings[descriptor_n++] = (VkDescriptorSetLayoutBinding) {
+      .binding = COMPUTE_OUTPUT_BINDING,
+      .descriptorCount = 1,
+      .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      .pImmutableSamplers = NULL,
+      .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT
+  };
+
+  layout_info = (VkDescriptorSetLayoutCreateInfo) {
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+      .pNext = NULL,
+      .bindingCount = descriptor_n,
+      .pBindings = bindings
+  };
+  /* *INDENT-ON* */
+
+  err =
+      vkCreateDescriptorSetLayout (vfilter->device->device, &layout_info,
+      NULL, &descriptor_set_layout);
+  if (gst_vulkan_error_to_g_error (err, error,
+          "vkCreateDescriptorSetLayout") < 0) {
+    return FALSE;
+  }
+
+  compute->descriptor_set_layout =
+      gst_vulkan_handle_new_wrapped (vfilter->device,
+      GST_VULKAN_HANDLE_TYPE_DESCRIPTOR_SET_LAYOUT,
+      (GstVulkanHandleTypedef) descriptor_set_layout,
+      gst_vulkan_handle_free_descriptor_set_layout, NULL);
+
+  return TRUE;
+}
+
+static gboolean
+compute_create_descriptor_pool (GstVulkanColorConvert * conv, GError ** error)
+{
+  GstVulkanVideoFilter *vfilter = GST_VULKAN_VIDEO_FILTER (conv);
+  ComputeConvert *compute = &conv->compute;
+  VkDescriptorPoolCreateInfo pool_info;
+  gsize max_sets = 32;          /* FIXME: don't hardcode this! */
+  VkDescriptorPoolSize pool_sizes[3];
+  GstVulkanDescriptorPool *ret;
+  VkDescriptorPool pool;
+  VkResult err;
+
+  /* *INDENT-OFF* */
+  pool_sizes[0] = (VkDescriptorPoolSize) {
+      .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+      .descriptorCount = max_sets * GST_VIDEO_INFO_N_PLANES (&vfilter->in_info),
+  };
+  pool_sizes[1] = (VkDescriptorPoolSize) {
+      .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+      .descriptorCount = max_sets
+  };
+  pool_sizes[2] = (VkDescriptorPoolSize) {
+      .type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      .descriptorCount = max_sets
+  };
+
+  pool_info = (VkDescriptorPoolCreateInfo) {
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+      .pNext = NULL,
+      .flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT,
+      .poolSizeCount = G_N_ELEMENTS (pool_sizes),
+      .pPoolSizes = pool_sizes,
+      .maxSets = max_sets
+  };
+  /* *INDENT-ON* */
+
+  err = vkCreateDescriptorPool (vfilter->device->device, &pool_info, NULL,
+      &pool);
+  if (gst_vulkan_error_to_g_error (err, error, "vkCreateDescriptorPool") < 0)
+    return FALSE;
+
+  ret = gst_vulkan_descriptor_pool_new_wrapped (vfilter->device, pool,
+      max_sets);
+  compute->descriptor_cache =
+      gst_vulkan_descriptor_cache_new (ret, 1, &compute->descriptor_set_layout);
+  gst_object_unref (ret);
+
+  return TRUE;
+}
+
+static gboolean
+compute_create_pipeline (GstVulkanColorConvert * conv, GError ** error)
+{
+  GstVulkanVideoFilter *vfilter = GST_VULKAN_VIDEO_FILTER (conv);
+  ComputeConvert *compute = &conv->compute;
+  VkPipelineLayoutCreateInfo pipeline_layout_info;
+  VkComputePipelineCreateInfo pipeline_info;
+  VkPipelineLayout pipeline_layout;
+  VkPipeline pipeline;
+  VkResult err;
+
+  /* *INDENT-OFF* */
+  pipeline_layout_info = (VkPipelineLayoutCreateInfo) {
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+      .pNext = NULL,
+      .setLayoutCount = 1,
+      .pSetLayouts = (VkDescriptorSetLayout *) &compute->descriptor_set_layout->handle,
+      .pushConstantRangeCount = 0,
+      .pPushConstantRanges = NULL,
+  };
+  /* *INDENT-ON* */
+
+  err = vkCreatePipelineLayout (vfilter->device->device, &pipeline_layout_info,
+      NULL, &pipeline_layout);
+  if (gst_vulkan_error_to_g_error (err, error, "vkCreatePipelineLayout") < 0)
+    return FALSE;
+
+  compute->pipeline_layout = gst_vulkan_handle_new_wrapped (vfilter->device,
+      GST_VULKAN_HANDLE_TYPE_PIPELINE_LAYOUT,
+      (GstVulkanHandleTypedef) pipeline_layout,
+      gst_vulkan_handle_free_pipeline_layout, NULL);
+
+  /* *INDENT-OFF* */
+  pipeline_info = (VkComputePipelineCreateInfo) {
+      .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+      .pNext = NULL,
+      .stage = {
+          .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+          .pNext = NULL,
+          .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+          .module = (VkShaderModule) compute->shader->handle,
+          .pName = "main"
+      },
+      .layout = (VkPipelineLayout) compute->pipeline_layout->handle,
+  };
+  /* *INDENT-ON* */
+
+  err = vkCreateComputePipelines (vfilter->device->device,
+      gst_vulkan_device_get_pipeline_cache (vfilter->device), 1,
+      &pipeline_info, NULL, &pipeline);
+  if (gst_vulkan_error_to_g_error (err, error, "vkCreateComputePipelines") < 0)
+    return FALSE;
+
+  compute->pipeline = gst_vulkan_handle_new_wrapped (vfilter->device,
+      GST_VULKAN_HANDLE_TYPE_PIPELINE, (GstVulkanHandleTypedef) pipeline,
+      gst_vulkan_handle_free_pipeline, NULL);
+
+  return TRUE;
+}
+
+static gboolean
+compute_create_sampler (GstVulkanColorConvert * conv, GError ** error)
+{
+  GstVulkanVideoFilter *vfilter = GST_VULKAN_VIDEO_FILTER (conv);
+  /* the shaders only ever use texelFetch() */
+  /* *INDENT-OFF* */
+  VkSamplerCreateInfo sampler_info = {
+      .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+      .magFilter = VK_FILTER_NEAREST,
+      .minFilter = VK_FILTER_NEAREST,
+      .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+      .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+      .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+      .anisotropyEnable = VK_FALSE,
+      .maxAnisotropy = 1,
+      .borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
+      .unnormalizedCoordinates = VK_FALSE,
+      .compareEnable = VK_FALSE,
+      .compareOp = VK_COMPARE_OP_ALWAYS,
+      .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+      .mipLodBias = 0.0f,
+      .minLod = 0.0f,
+      .maxLod = 0.0f
+  };
+  /* *INDENT-ON* */
+  VkSampler sampler;
+  VkResult err;
+
+  err = vkCreateSampler (vfilter->device->device, &sampler_info, NULL,
+      &sampler);
+  if (gst_vulkan_error_to_g_error (err, error, "vkCreateSampler") < 0)
+    return FALSE;
+
+  conv->compute.sampler = gst_vulkan_handle_new_wrapped (vfilter->device,
+      GST_VULKAN_HANDLE_TYPE_SAMPLER, (GstVulkanHandleTypedef) sampler,
+      gst_vulkan_handle_free_sampler, NULL);
+
+  return TRUE;
+}
+
+/* The output is written into a tightly packed buffer with each row of each
+ * plane padded to a 32 bit word and then copied into the output images */
+static gboolean
+compute_create_output (GstVulkanColorConvert * conv, GError ** error)
+{
+  GstVulkanVideoFilter *vfilter = GST_VULKAN_VIDEO_FILTER (conv);
+  ComputeConvert *compute = &conv->compute;
+  GstVideoInfo *out_info = &vfilter->out_info;
+  guint offset = 0;
+  int i;
+
+  for (i = 0; i < GST_VIDEO_INFO_N_PLANES (out_info); i++) {
+    guint pstride = finfo_get_plane_pixel_stride (out_info->finfo, i);
+    guint row_bytes = GST_VIDEO_INFO_COMP_WIDTH (out_info, i) * pstride;
+
+    compute->out_stride[i] = GST_ROUND_UP_4 (row_bytes) / 4;
+    compute->out_rows[i] = GST_VIDEO_INFO_COMP_HEIGHT (out_info, i);
+    compute->out_offset[i] = offset;
+    offset += compute->out_stride[i] * compute->out_rows[i];
+  }
+
+  switch (GST_VIDEO_INFO_FORMAT (out_info)) {
+    case GST_VIDEO_FORMAT_YUY2:
+      compute->block_width = 2;
+      compute->block_height = 1;
+      break;
+    case GST_VIDEO_FORMAT_NV12:
+      compute->block_width = 4;
+      compute->block_height = 2;
+      break;
+    case GST_VIDEO_FORMAT_I420:
+      compute->block_width = 8;
+      compute->block_height = 2;
+      break;
+    default:
+      compute->block_width = 1;
+      compute->block_height = 1;
+      break;
+  }
+
+  compute->output = gst_vulkan_buffer_memory_alloc (vfilter->device,
+      offset * 4, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  if (!compute->output) {
+    g_set_error_literal (error, GST_VULKAN_ERROR, GST_VULKAN_FAILED,
+        "Failed to allocate the compute output buffer");
+    return FALSE;
+  }
+
+  GST_DEBUG_OBJECT (conv, "compute output buffer of %u bytes, %ux%u pixels "
+      "per invocation", offset * 4, compute->block_width,
+      compute->block_height);
+
+  return TRUE;
+}
+
+static gboolean
+compute_convert_setup (GstVulkanColorConvert * conv, GError ** error)
+{
+  GstVulkanVideoFilter *vfilter = GST_VULKAN_VIDEO_FILTER (conv);
+  ComputeConvert *compute = &conv->compute;
+
+  if (!(compute->shader = gst_vulkan_create_shader (vfilter->device,
+              conv->current_shader->comp_code, conv->current_shader->comp_size,
+              error)))
+    goto error;
+  if (!compute_create_sampler (conv, error))
+    goto error;
+  if (!compute_create_descriptor_set_layout (conv, error))
+    goto error;
+  if (!compute_create_descriptor_pool (conv, error))
+    goto error;
+  if (!compute_create_pipeline (conv, error))
+    goto error;
+  if (!compute_create_output (conv, error))
+    goto error;
+  if (!(compute->cmd_pool =
+          gst_vulkan_queue_create_command_pool (vfilter->queue, error)))
+    goto error;
+
+  compute->active = TRUE;
+
+  return TRUE;
+
+error:
+  compute_convert_clear (conv);
+  return FALSE;
+}
+
+static GstVulkanDescriptorSet *
+compute_get_and_update_descriptor_set (GstVulkanColorConvert * conv,
+    GstVulkanImageView ** views, GError ** error)
+{
+  GstVulkanVideoFilter *vfilter = GST_VULKAN_VIDEO_FILTER (conv);
+  ComputeConvert *compute = &conv->compute;
+  VkWriteDescriptorSet writes[GST_VIDEO_MAX_PLANES + 2];
+  VkDescriptorImageInfo image_info[GST_VIDEO_MAX_PLANES];
+  VkDescriptorBufferInfo uniform_info, output_info;
+  GstVulkanDescriptorSet *set;
+  int write_n = 0;
+  int i;
+
+  if (!(set =
+          gst_vulkan_descriptor_cache_acquire (compute->descriptor_cache,
+              error)))
+    return NULL;
+
+  /* *INDENT-OFF* */
+  uniform_info = (VkDescriptorBufferInfo) {
+      .buffer = ((GstVulkanBufferMemory *) compute->uniforms)->buffer,
+      .offset = 0,
+      .range = sizeof (struct ComputeUpdateData)
+  };
+  writes[write_n++] = (VkWriteDescriptorSet) {
+      .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      .pNext = NULL,
+      .dstSet = set->set,
+      .dstBinding = 0,
+      .dstArrayElement = 0,
+      .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+      .descriptorCount = 1,
+      .pBufferInfo = &uniform_info
+  };
+
+  for (i = 0; i < GST_VIDEO_INFO_N_PLANES (&vfilter->in_info); i++) {
+    image_info[i] = (VkDescriptorImageInfo) {
+        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        .imageView = views[i]->view,
+        .sampler = (VkSampler) compute->sampler->handle
+    };
+    writes[write_n++] = (VkWriteDescriptorSet) {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .pNext = NULL,
+        .dstSet = set->set,
+        .dstBinding = i + 1,
+        .dstArrayElement = 0,
+        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .descriptorCount = 1,
+        .pImageInfo = &image_info[i]
+    };
+  }
+
+  output_info = (VkDescriptorBufferInfo) {
+      .buffer = ((GstVulkanBufferMemory *) compute->output)->buffer,
+      .offset = 0,
+      .range = VK_WHOLE_SIZE
+  };
+  writes[write_n++] = (VkWriteDescriptorSet) {
+      .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      .pNext = NULL,
+      .dstSet = set->set,
+      .dstBinding = COMPUTE_OUTPUT_BINDING,
+      .dstArrayElement = 0,
+      .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+      .descriptorCount = 1,
+      .pBufferInfo = &output_info
+  };
+  /* *INDENT-ON* */
+
+  vkUpdateDescriptorSets (vfilter->device->device, write_n, writes, 0, NULL);
+
+  return set;
+}
+
+static gboolean
+compute_convert_transform (GstVulkanColorConvert * conv, GstBuffer * inbuf,
+    GstBuffer * outbuf, GError ** error)
+{
+  GstVulkanVideoFilter *vfilter = GST_VULKAN_VIDEO_FILTER (conv);
+  ComputeConvert *compute = &conv->compute;
+  GstVulkanImageView *in_img_views[GST_VIDEO_MAX_PLANES] = { NULL, };
+  GstVulkanImageMemory *in_img_mems[GST_VIDEO_MAX_PLANES] = { NULL, };
+  GstVulkanImageMemory *out_img_mems[GST_VIDEO_MAX_PLANES] = { NULL, };
+  GstVulkanBufferMemory *out_buf_mem;
+  GstVulkanCommandBuffer *cmd_buf = NULL;
+  GstVulkanDescriptorSet *set;
+  GstVulkanFence *fence = NULL;
+  VkResult err;
+  int i;
+
+  fence = gst_vulkan_queue_create_fence (vfilter->queue, error);
+  if (!fence)
+    goto error;
+
+  for (i = 0; i < GST_VIDEO_INFO_N_PLANES (&vfilter->in_info); i++) {
+    GstMemory *img_mem = gst_buffer_peek_memory (inbuf, i);
+    if (!gst_is_vulkan_image_memory (img_mem)) {
+      g_set_error_literal (error, GST_VULKAN_ERROR, GST_VULKAN_FAILED,
+          "Input memory must be a GstVulkanImageMemory");
+      goto error;
+    }
+    in_img_mems[i] = (GstVulkanImageMemory *) img_mem;
+    in_img_views[i] = gst_vulkan_get_or_create_image_view (in_img_mems[i]);
+    gst_vulkan_trash_list_add (compute->trash_list,
+        gst_vulkan_trash_list_acquire (compute->trash_list, fence,
+            gst_vulkan_trash_mini_object_unref,
+            (GstMiniObject *) in_img_views[i]));
+  }
+
+  for (i = 0; i < GST_VIDEO_INFO_N_PLANES (&vfilter->out_info); i++) {
+    GstMemory *img_mem = gst_buffer_peek_memory (outbuf, i);
+    if (!gst_is_vulkan_image_memory (img_mem)) {
+      g_set_error_literal (error, GST_VULKAN_ERROR, GST_VULKAN_FAILED,
+          "Output memory must be a GstVulkanImageMemory");
+      goto error;
+    }
+    out_img_mems[i] = (GstVulkanImageMemory *) img_mem;
+  }
+
+  if (!compute->uniforms) {
+    if (!(compute->uniforms = compute_create_uniform_memory (conv,
+                in_img_views))) {
+      g_set_error_literal (error, GST_VULKAN_ERROR, GST_VULKAN_FAILED,
+          "Failed to create the compute uniform buffer");
+      goto error;
+    }
+  }
+
+  if (!(set = compute_get_and_update_descriptor_set (conv, in_img_views,
+              error)))
+    goto error;
+  gst_vulkan_trash_list_add (compute->trash_list,
+      gst_vulkan_trash_list_acquire (compute->trash_list, fence,
+          gst_vulkan_trash_mini_object_unref, (GstMiniObject *) set));
+
+  if (!(cmd_buf = gst_vulkan_command_pool_create (compute->cmd_pool, error)))
+    goto error;
+
+  {
+    VkCommandBufferBeginInfo cmd_buf_info = { 0, };
+
+    /* *INDENT-OFF* */
+    cmd_buf_info = (VkCommandBufferBeginInfo) {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext = NULL,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        .pInheritanceInfo = NULL
+    };
+    /* *INDENT-ON* */
+
+    gst_vulkan_command_buffer_lock (cmd_buf);
+    err = vkBeginCommandBuffer (cmd_buf->cmd, &cmd_buf_info);
+    if (gst_vulkan_error_to_g_error (err, error, "vkBeginCommandBuffer") < 0)
+      goto unlock_error;
+  }
+
+  out_buf_mem = (GstVulkanBufferMemory *) compute->output;
+
+  for (i = 0; i < GST_VIDEO_INFO_N_PLANES (&vfilter->in_info); i++) {
+    /* *INDENT-OFF* */
+    VkImageMemoryBarrier in_image_memory_barrier = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .pNext = NULL,
+        .srcAccessMask = in_img_mems[i]->barrier.parent.access_flags,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+        .oldLayout = in_img_mems[i]->barrier.image_layout,
+        .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        /* FIXME: implement exclusive transfers */
+        .srcQueueFamilyIndex = 0,
+        .dstQueueFamilyIndex = 0,
+        .image = in_img_mems[i]->image,
+        .subresourceRange = in_img_mems[i]->barrier.subresource_range
+    };
+    /* *INDENT-ON* */
+
+    vkCmdPipelineBarrier (cmd_buf->cmd,
+        in_img_mems[i]->barrier.parent.pipeline_stages,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, NULL, 0, NULL, 1,
+        &in_image_memory_barrier);
+
+    in_img_mems[i]->barrier.parent.pipeline_stages =
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    in_img_mems[i]->barrier.parent.access_flags =
+        in_image_memory_barrier.dstAccessMask;
+    in_img_mems[i]->barrier.image_layout = in_image_memory_barrier.newLayout;
+  }
+
+  {
+    /* the previous frame may still be copying out of the output buffer */
+    /* *INDENT-OFF* */
+    VkBufferMemoryBarrier buffer_memory_barrier = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .pNext = NULL,
+        .srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        /* FIXME: implement exclusive transfers */
+        .srcQueueFamilyIndex = 0,
+        .dstQueueFamilyIndex = 0,
+        .buffer = out_buf_mem->buffer,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE
+    };
+    /* *INDENT-ON* */
+
+    vkCmdPipelineBarrier (cmd_buf->cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, NULL, 1,
+        &buffer_memory_barrier, 0, NULL);
+  }
+
+  vkCmdBindPipeline (cmd_buf->cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+      (VkPipeline) compute->pipeline->handle);
+  vkCmdBindDescriptorSets (cmd_buf->cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+      (VkPipelineLayout) compute->pipeline_layout->handle, 0, 1, &set->set, 0,
+      NULL);
+  {
+    guint n_blocks_x, n_blocks_y;
+
+    n_blocks_x = (GST_VIDEO_INFO_WIDTH (&vfilter->out_info) +
+        compute->block_width - 1) / compute->block_width;
+    n_blocks_y = (GST_VIDEO_INFO_HEIGHT (&vfilter->out_info) +
+        compute->block_height - 1) / compute->block_height;
+
+    vkCmdDispatch (cmd_buf->cmd,
+        (n_blocks_x + COMPUTE_LOCAL_SIZE - 1) / COMPUTE_LOCAL_SIZE,
+        (n_blocks_y + COMPUTE_LOCAL_SIZE - 1) / COMPUTE_LOCAL_SIZE, 1);
+  }
+
+  {
+    /* *INDENT-OFF* */
+    VkBufferMemoryBarrier buffer_memory_barrier = {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .pNext = NULL,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+        /* FIXME: implement exclusive transfers */
+        .srcQueueFamilyIndex = 0,
+        .dstQueueFamilyIndex = 0,
+        .buffer = out_buf_mem->buffer,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE
+    };
+    /* *INDENT-ON* */
+
+    vkCmdPipelineBarrier (cmd_buf->cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 1, &buffer_memory_barrier,
+        0, NULL);
+  }
+
+  for (i = 0; i < GST_VIDEO_INFO_N_PLANES (&vfilter->out_info); i++) {
+    guint pstride = finfo_get_plane_pixel_stride (vfilter->out_info.finfo, i);
+    VkBufferImageCopy region;
+    /* *INDENT-OFF* */
+    VkImageMemoryBarrier out_image_memory_barrier = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .pNext = NULL,
+        .srcAccessMask = out_img_mems[i]->barrier.parent.access_flags,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .oldLayout = out_img_mems[i]->barrier.image_layout,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        /* FIXME: implement exclusive transfers */
+        .srcQueueFamilyIndex = 0,
+        .dstQueueFamilyIndex = 0,
+        .image = out_img_mems[i]->image,
+        .subresourceRange = out_img_mems[i]->barrier.subresource_range
+    };
+
+    region = (VkBufferImageCopy) {
+        .bufferOffset = compute->out_offset[i] * 4,
+        .bufferRowLength = compute->out_stride[i] * 4 / pstride,
+        .bufferImageHeight = compute->out_rows[i],
+        .imageSubresource = {
+            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+            .mipLevel = 0,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+        },
+        .imageOffset = { .x = 0, .y = 0, .z = 0, },
+        .imageExtent = {
+            .width = GST_VIDEO_INFO_COMP_WIDTH (&vfilter->out_info, i),
+            .height = GST_VIDEO_INFO_COMP_HEIGHT (&vfilter->out_info, i),
+            .depth = 1,
+        }
+    };
+    /* *INDENT-ON* */
+
+    vkCmdPipelineBarrier (cmd_buf->cmd,
+        out_img_mems[i]->barrier.parent.pipeline_stages,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1,
+        &out_image_memory_barrier);
+
+    out_img_mems[i]->barrier.parent.pipeline_stages =
+        VK_PIPELINE_STAGE_TRANSFER_BIT;
+    out_img_mems[i]->barrier.parent.access_flags =
+        out_image_memory_barrier.dstAccessMask;
+    out_img_mems[i]->barrier.image_layout = out_image_memory_barrier.newLayout;
+
+    vkCmdCopyBufferToImage (cmd_buf->cmd, out_buf_mem->buffer,
+        out_img_mems[i]->image, out_img_mems[i]->barrier.image_layout, 1,
+        &region);
+  }
+
+  err = vkEndCommandBuffer (cmd_buf->cmd);
+  gst_vulkan_command_buffer_unlock (cmd_buf);
+  if (gst_vulkan_error_to_g_error (err, error, "vkEndCommandBuffer") < 0)
+    goto error;
+
+  {
+    /* *INDENT-OFF* */
+    VkSubmitInfo submit_info = {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext = NULL,
+        .waitSemaphoreCount = 0,
+        .pWaitSemaphores = NULL,
+        .pWaitDstStageMask = NULL,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &cmd_buf->cmd,
+        .signalSemaphoreCount = 0,
+        .pSignalSemaphores = NULL,
+    };
+    /* *INDENT-ON* */
+
+    if (!gst_vulkan_queue_submit (vfilter->queue, &submit_info, fence, error))
+      goto error;
+  }
+
+  gst_vulkan_trash_list_add (compute->trash_list,
+      gst_vulkan_trash_list_acquire (compute->trash_list, fence,
+          gst_vulkan_trash_mini_object_unref, GST_MINI_OBJECT_CAST (cmd_buf)));
+  gst_vulkan_trash_list_gc (compute->trash_list);
+
+  gst_vulkan_fence_unref (fence);
+
+  return TRUE;
+
+unlock_error:
+  gst_vulkan_command_buffer_unlock (cmd_buf);
+error:
+  if (cmd_buf)
+    gst_vulkan_command_buffer_unref (cmd_buf);
+  gst_clear_mini_object ((GstMiniObject **) & fence);
+  return FALSE;
+}
+
 static gboolean
 gst_vulkan_color_convert_start (GstBaseTransform * bt)
 {
@@ -1105,6 +2073,7 @@ gst_vulkan_color_convert_start (GstBaseTransform * bt)
     return FALSE;
 
   conv->quad = gst_vulkan_full_screen_quad_new (vfilter->queue);
+  conv->compute.trash_list = gst_vulkan_trash_fence_list_new ();
 
   return TRUE;
 }
@@ -1116,6 +2085,9 @@ gst_vulkan_color_convert_set_caps (GstBaseTransform * bt, GstCaps * in_caps,
   GstVulkanVideoFilter *vfilter = GST_VULKAN_VIDEO_FILTER (bt);
   GstVulkanColorConvert *conv = GST_VULKAN_COLOR_CONVERT (bt);
   GstVulkanHandle *vert, *frag;
+  VkQueueFlags queue_flags;
+  gboolean use_compute, can_compute, can_render;
+  GError *error = NULL;
   int i;
 
   if (!GST_BASE_TRANSFORM_CLASS (parent_class)->set_caps (bt, in_caps,
@@ -1130,6 +2102,7 @@ gst_vulkan_color_convert_set_caps (GstBaseTransform * bt, GstCaps * in_caps,
     conv->current_shader->notify (conv->current_shader);
     conv->current_shader = NULL;
   }
+  compute_convert_clear (conv);
 
   for (i = 0; i < G_N_ELEMENTS (shader_infos); i++) {
     if (shader_infos[i].from != GST_VIDEO_INFO_FORMAT (&vfilter->in_info))
@@ -1151,6 +2124,38 @@ gst_vulkan_color_convert_set_caps (GstBaseTransform * bt, GstCaps * in_caps,
     return FALSE;
   }
 
+  queue_flags =
+      vfilter->device->physical_device->queue_family_props[vfilter->
+      queue->family].queueFlags;
+  can_compute = conv->current_shader->comp_code != NULL
+      && (queue_flags & VK_QUEUE_COMPUTE_BIT) != 0;
+  can_render = conv->current_shader->frag_code != NULL
+      && (queue_flags & VK_QUEUE_GRAPHICS_BIT) != 0;
+
+  GST_OBJECT_LOCK (conv);
+  use_compute = conv->use_compute;
+  GST_OBJECT_UNLOCK (conv);
+
+  if (can_compute && (use_compute || !can_render)) {
+    GST_INFO_OBJECT (conv, "converting with a compute shader");
+    if (!compute_convert_setup (conv, &error)) {
+      GST_ERROR_OBJECT (conv, "Failed to set up the compute conversion: %s",
+          error->message);
+      g_clear_error (&error);
+      return FALSE;
+    }
+    return TRUE;
+  }
+
+  if (!can_render) {
+    GST_ERROR_OBJECT (conv, "No conversion from %s to %s available on this "
+        "queue", gst_video_format_to_string (GST_VIDEO_INFO_FORMAT
+            (&vfilter->in_info)),
+        gst_video_format_to_string (GST_VIDEO_INFO_FORMAT
+            (&vfilter->out_info)));
+    return FALSE;
+  }
+
   if (!(vert =
           gst_vulkan_create_shader (vfilter->device, identity_vert,
               identity_vert_size, NULL))) {
@@ -1186,6 +2191,8 @@ gst_vulkan_color_convert_stop (GstBaseTransform * bt)
     conv->current_shader = NULL;
   }
 
+  compute_convert_clear (conv);
+  gst_clear_object (&conv->compute.trash_list);
   gst_clear_object (&conv->quad);
 
   return GST_BASE_TRANSFORM_CLASS (parent_class)->stop (bt);
@@ -1208,7 +2215,13 @@ gst_vulkan_color_convert_transform (GstBaseTransform * bt, GstBuffer * inbuf,
   VkResult err;
   int i;
 
-  fence = gst_vulkan_device_create_fence (vfilter->device, &error);
+  if (conv->compute.active) {
+    if (!compute_convert_transform (conv, inbuf, outbuf, &error))
+      goto error;
+    return GST_FLOW_OK;
+  }
+
+  fence = gst_vulkan_queue_create_fence (vfilter->queue, &error);
   if (!fence)
     goto error;
 
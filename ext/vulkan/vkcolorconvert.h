@@ -49,11 +49,41 @@ struct _shader_info
   CommandCreateUniformMemory cmd_create_uniform;
   gchar *frag_code;
   gsize frag_size;
+  gchar *comp_code;
+  gsize comp_size;
   gsize uniform_size;
   GDestroyNotify notify;
   gpointer user_data;
 };
 
+typedef struct _ComputeConvert ComputeConvert;
+
+struct _ComputeConvert
+{
+  gboolean                          active;
+
+  GstVulkanHandle                  *shader;
+  GstVulkanHandle                  *descriptor_set_layout;
+  GstVulkanHandle                  *pipeline_layout;
+  GstVulkanHandle                  *pipeline;
+  GstVulkanHandle                  *sampler;
+  GstVulkanDescriptorCache         *descriptor_cache;
+  GstVulkanCommandPool             *cmd_pool;
+  GstVulkanTrashList               *trash_list;
+
+  GstMemory                        *uniforms;
+  GstMemory                        *output;
+
+  /* layout of the output planes in @output, in 32 bit words */
+  guint                             out_stride[GST_VIDEO_MAX_PLANES];
+  guint                             out_offset[GST_VIDEO_MAX_PLANES];
+  guint                             out_rows[GST_VIDEO_MAX_PLANES];
+
+  /* pixels written by each shader invocation */
+  guint                             block_width;
+  guint                             block_height;
+};
+
 struct _GstVulkanColorConvert
 {
   GstVulkanVideoFilter              parent;
@@ -61,6 +91,9 @@ struct _GstVulkanColorConvert
   GstVulkanFullScreenQuad          *quad;
 
   shader_info                      *current_shader;
+
+  gboolean                          use_compute;
+  ComputeConvert                    compute;
 };
 
 struct _GstVulkanColorConvertClass
@@ -0,0 +1,1187 @@
+/*
+ * GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-vulkancompositor
+ * @title: vulkancompositor
+ *
+ * vulkancompositor blends several Vulkan images into one output image
+ * without leaving the GPU. Each sink pad has its own position, size and
+ * alpha, and the pictures are stacked following their zorder.
+ *
+ * ## Example launch line
+ * |[
+ * gst-launch-1.0 vulkancompositor name=c sink_1::xpos=320 sink_1::alpha=0.5 ! vulkansink \
+ *     videotestsrc ! video/x-raw,width=320,height=240 ! vulkanupload ! c. \
+ *     videotestsrc pattern=ball ! video/x-raw,width=320,height=240 ! vulkanupload ! c.
+ * ]|
+ *
+ * Since: 1.20
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "vkcompositor.h"
+#include "gstvulkan-plugins-enumtypes.h"
+
+#include "shaders/identity.vert.h"
+#include "shaders/compositor.frag.h"
+
+GST_DEBUG_CATEGORY (gst_debug_vulkan_compositor);
+#define GST_CAT_DEFAULT gst_debug_vulkan_compositor
+
+/* matches the vertex layout used by GstVulkanFullScreenQuad */
+struct Vertex
+{
+  float x, y, z;
+  float s, t;
+};
+
+/* std140 layout of the uniform block in compositor.frag */
+struct CompositorUpdate
+{
+  float alpha;
+};
+
+#define IMAGE_FORMATS " { BGRA, RGBA }"
+
+static GstStaticPadTemplate gst_vulkan_compositor_sink_template =
+GST_STATIC_PAD_TEMPLATE ("sink_%u",
+    GST_PAD_SINK,
+    GST_PAD_REQUEST,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE_WITH_FEATURES
+        (GST_CAPS_FEATURE_MEMORY_VULKAN_IMAGE,
+            IMAGE_FORMATS)));
+
+static GstStaticPadTemplate gst_vulkan_compositor_src_template =
+GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE_WITH_FEATURES
+        (GST_CAPS_FEATURE_MEMORY_VULKAN_IMAGE,
+            IMAGE_FORMATS)));
+
+/* sink pads */
+
+enum
+{
+  PROP_PAD_0,
+  PROP_PAD_XPOS,
+  PROP_PAD_YPOS,
+  PROP_PAD_WIDTH,
+  PROP_PAD_HEIGHT,
+  PROP_PAD_ALPHA,
+};
+
+#define DEFAULT_PAD_XPOS   0
+#define DEFAULT_PAD_YPOS   0
+#define DEFAULT_PAD_WIDTH  0
+#define DEFAULT_PAD_HEIGHT 0
+#define DEFAULT_PAD_ALPHA  1.0
+
+G_DEFINE_TYPE (GstVulkanCompositorPad, gst_vulkan_compositor_pad,
+    GST_TYPE_VIDEO_AGGREGATOR_PAD);
+
+static void
+gst_vulkan_compositor_pad_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstVulkanCompositorPad *pad = GST_VULKAN_COMPOSITOR_PAD (object);
+
+  GST_OBJECT_LOCK (pad);
+  switch (prop_id) {
+    case PROP_PAD_XPOS:
+      pad->xpos = g_value_get_int (value);
+      break;
+    case PROP_PAD_YPOS:
+      pad->ypos = g_value_get_int (value);
+      break;
+    case PROP_PAD_WIDTH:
+      pad->width = g_value_get_int (value);
+      break;
+    case PROP_PAD_HEIGHT:
+      pad->height = g_value_get_int (value);
+      break;
+    case PROP_PAD_ALPHA:
+      pad->alpha = g_value_get_double (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (pad);
+}
+
+static void
+gst_vulkan_compositor_pad_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstVulkanCompositorPad *pad = GST_VULKAN_COMPOSITOR_PAD (object);
+
+  GST_OBJECT_LOCK (pad);
+  switch (prop_id) {
+    case PROP_PAD_XPOS:
+      g_value_set_int (value, pad->xpos);
+      break;
+    case PROP_PAD_YPOS:
+      g_value_set_int (value, pad->ypos);
+      break;
+    case PROP_PAD_WIDTH:
+      g_value_set_int (value, pad->width);
+      break;
+    case PROP_PAD_HEIGHT:
+      g_value_set_int (value, pad->height);
+      break;
+    case PROP_PAD_ALPHA:
+      g_value_set_double (value, pad->alpha);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (pad);
+}
+
+/* call with the pad's object lock held */
+static void
+gst_vulkan_compositor_pad_get_output_size (GstVulkanCompositorPad * cpad,
+    gint out_par_n, gint out_par_d, gint * width, gint * height)
+{
+  GstVideoAggregatorPad *vagg_pad = GST_VIDEO_AGGREGATOR_PAD (cpad);
+  gint pad_width, pad_height;
+  guint dar_n, dar_d;
+
+  if (!vagg_pad->info.finfo
+      || vagg_pad->info.finfo->format == GST_VIDEO_FORMAT_UNKNOWN) {
+    GST_DEBUG_OBJECT (cpad, "Have no caps yet");
+    *width = 0;
+    *height = 0;
+    return;
+  }
+
+  pad_width = cpad->width <= 0 ?
+      GST_VIDEO_INFO_WIDTH (&vagg_pad->info) : cpad->width;
+  pad_height = cpad->height <= 0 ?
+      GST_VIDEO_INFO_HEIGHT (&vagg_pad->info) : cpad->height;
+
+  if (!gst_video_calculate_display_ratio (&dar_n, &dar_d, pad_width, pad_height,
+          GST_VIDEO_INFO_PAR_N (&vagg_pad->info),
+          GST_VIDEO_INFO_PAR_D (&vagg_pad->info), out_par_n, out_par_d)) {
+    GST_WARNING_OBJECT (cpad, "Cannot calculate display aspect ratio");
+    *width = *height = 0;
+    return;
+  }
+
+  /* Pick either height or width, whichever is an integer multiple of the
+   * display aspect ratio. However, prefer preserving the height to account
+   * for interlaced video. */
+  if (pad_height % dar_n == 0) {
+    pad_width = gst_util_uint64_scale_int (pad_height, dar_n, dar_d);
+  } else if (pad_width % dar_d == 0) {
+    pad_height = gst_util_uint64_scale_int (pad_width, dar_d, dar_n);
+  } else {
+    pad_width = gst_util_uint64_scale_int (pad_height, dar_n, dar_d);
+  }
+
+  *width = pad_width;
+  *height = pad_height;
+}
+
+/* The input images are sampled as they are, so there's no need to map
+ * them. */
+static gboolean
+gst_vulkan_compositor_pad_prepare_frame (GstVideoAggregatorPad * pad,
+    GstVideoAggregator * vagg, GstBuffer * buffer,
+    GstVideoFrame * prepared_frame)
+{
+  GstVulkanCompositor *self = GST_VULKAN_COMPOSITOR (vagg);
+  GstMemory *mem = gst_buffer_peek_memory (buffer, 0);
+
+  if (!gst_is_vulkan_image_memory (mem)) {
+    GST_ERROR_OBJECT (pad, "Input memory must be a GstVulkanImageMemory");
+    return FALSE;
+  }
+  if (((GstVulkanImageMemory *) mem)->device != self->device) {
+    GST_ERROR_OBJECT (pad, "Input image is from a different Vulkan device");
+    return FALSE;
+  }
+
+  prepared_frame->info = pad->info;
+  prepared_frame->buffer = gst_buffer_ref (buffer);
+
+  return TRUE;
+}
+
+static void
+gst_vulkan_compositor_pad_clean_frame (GstVideoAggregatorPad * pad,
+    GstVideoAggregator * vagg, GstVideoFrame * prepared_frame)
+{
+  gst_clear_buffer (&prepared_frame->buffer);
+  memset (prepared_frame, 0, sizeof (GstVideoFrame));
+}
+
+static void
+gst_vulkan_compositor_pad_reset (GstVulkanCompositorPad * pad)
+{
+  gst_clear_object (&pad->quad);
+  if (pad->vertices)
+    gst_memory_unref (pad->vertices);
+  pad->vertices = NULL;
+  if (pad->uniforms)
+    gst_memory_unref (pad->uniforms);
+  pad->uniforms = NULL;
+}
+
+static void
+gst_vulkan_compositor_pad_finalize (GObject * object)
+{
+  gst_vulkan_compositor_pad_reset (GST_VULKAN_COMPOSITOR_PAD (object));
+
+  G_OBJECT_CLASS (gst_vulkan_compositor_pad_parent_class)->finalize (object);
+}
+
+static void
+gst_vulkan_compositor_pad_class_init (GstVulkanCompositorPadClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstVideoAggregatorPadClass *vaggpad_class =
+      GST_VIDEO_AGGREGATOR_PAD_CLASS (klass);
+
+  gobject_class->set_property = gst_vulkan_compositor_pad_set_property;
+  gobject_class->get_property = gst_vulkan_compositor_pad_get_property;
+  gobject_class->finalize = gst_vulkan_compositor_pad_finalize;
+
+  g_object_class_install_property (gobject_class, PROP_PAD_XPOS,
+      g_param_spec_int ("xpos", "X Position", "X position of the picture",
+          G_MININT, G_MAXINT, DEFAULT_PAD_XPOS,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_YPOS,
+      g_param_spec_int ("ypos", "Y Position", "Y position of the picture",
+          G_MININT, G_MAXINT, DEFAULT_PAD_YPOS,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_WIDTH,
+      g_param_spec_int ("width", "Width",
+          "Width of the picture (0: input width)", 0, G_MAXINT,
+          DEFAULT_PAD_WIDTH,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_HEIGHT,
+      g_param_spec_int ("height", "Height",
+          "Height of the picture (0: input height)", 0, G_MAXINT,
+          DEFAULT_PAD_HEIGHT,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_ALPHA,
+      g_param_spec_double ("alpha", "Alpha", "Alpha of the picture", 0.0, 1.0,
+          DEFAULT_PAD_ALPHA,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  vaggpad_class->prepare_frame =
+      GST_DEBUG_FUNCPTR (gst_vulkan_compositor_pad_prepare_frame);
+  vaggpad_class->clean_frame =
+      GST_DEBUG_FUNCPTR (gst_vulkan_compositor_pad_clean_frame);
+}
+
+static void
+gst_vulkan_compositor_pad_init (GstVulkanCompositorPad * pad)
+{
+  pad->xpos = DEFAULT_PAD_XPOS;
+  pad->ypos = DEFAULT_PAD_YPOS;
+  pad->width = DEFAULT_PAD_WIDTH;
+  pad->height = DEFAULT_PAD_HEIGHT;
+  pad->alpha = DEFAULT_PAD_ALPHA;
+}
+
+static GstMemory *
+_create_host_buffer (GstVulkanDevice * device, gconstpointer data, gsize size,
+    VkBufferUsageFlags usage, GError ** error)
+{
+  GstMemory *mem;
+  GstMapInfo map_info;
+
+  mem = gst_vulkan_buffer_memory_alloc (device, size, usage,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+      VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+  if (!gst_memory_map (mem, &map_info, GST_MAP_WRITE)) {
+    g_set_error_literal (error, GST_VULKAN_ERROR, VK_ERROR_MEMORY_MAP_FAILED,
+        "Failed to map memory");
+    gst_memory_unref (mem);
+    return NULL;
+  }
+  memcpy (map_info.data, data, size);
+  gst_memory_unmap (mem, &map_info);
+
+  return mem;
+}
+
+/* Positions the quad on @rect of the output. New memory is allocated every
+ * time as the previous vertices may still be in use by the GPU. */
+static gboolean
+gst_vulkan_compositor_pad_update_vertices (GstVulkanCompositorPad * cpad,
+    GstVulkanDevice * device, GstVideoRectangle * rect, GstVideoInfo * out_info,
+    GError ** error)
+{
+  gint out_width = GST_VIDEO_INFO_WIDTH (out_info);
+  gint out_height = GST_VIDEO_INFO_HEIGHT (out_info);
+  struct Vertex vertices[4];
+  gfloat x0, y0, x1, y1;
+
+  if (cpad->vertices && cpad->vertex_out_width == out_width
+      && cpad->vertex_out_height == out_height
+      && memcmp (&cpad->vertex_rect, rect, sizeof (*rect)) == 0)
+    return TRUE;
+
+  x0 = 2.0f * rect->x / out_width - 1.0f;
+  y0 = 2.0f * rect->y / out_height - 1.0f;
+  x1 = 2.0f * (rect->x + rect->w) / out_width - 1.0f;
+  y1 = 2.0f * (rect->y + rect->h) / out_height - 1.0f;
+
+  /* *INDENT-OFF* */
+  vertices[0] = (struct Vertex) { x0, y0, 0.0f, 0.0f, 0.0f };
+  vertices[1] = (struct Vertex) { x1, y0, 0.0f, 1.0f, 0.0f };
+  vertices[2] = (struct Vertex) { x1, y1, 0.0f, 1.0f, 1.0f };
+  vertices[3] = (struct Vertex) { x0, y1, 0.0f, 0.0f, 1.0f };
+  /* *INDENT-ON* */
+
+  if (cpad->vertices)
+    gst_memory_unref (cpad->vertices);
+  cpad->vertices = _create_host_buffer (device, vertices, sizeof (vertices),
+      VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, error);
+  if (!cpad->vertices)
+    return FALSE;
+
+  cpad->vertex_rect = *rect;
+  cpad->vertex_out_width = out_width;
+  cpad->vertex_out_height = out_height;
+
+  return gst_vulkan_full_screen_quad_set_vertex_buffer (cpad->quad,
+      cpad->vertices, error);
+}
+
+static gboolean
+gst_vulkan_compositor_pad_update_uniforms (GstVulkanCompositorPad * cpad,
+    GstVulkanDevice * device, gdouble alpha, GError ** error)
+{
+  if (!cpad->uniforms || cpad->uniform_alpha != alpha) {
+    struct CompositorUpdate data;
+
+    data.alpha = alpha;
+
+    if (cpad->uniforms)
+      gst_memory_unref (cpad->uniforms);
+    cpad->uniforms = _create_host_buffer (device, &data, sizeof (data),
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, error);
+    if (!cpad->uniforms)
+      return FALSE;
+    cpad->uniform_alpha = alpha;
+  }
+
+  return gst_vulkan_full_screen_quad_set_uniform_buffer (cpad->quad,
+      cpad->uniforms, error);
+}
+
+static gboolean
+gst_vulkan_compositor_pad_draw (GstVulkanCompositorPad * cpad,
+    GstVulkanCompositor * self, GstBuffer * inbuf, GstBuffer * outbuf,
+    GError ** error)
+{
+  GstVideoAggregatorPad *vagg_pad = GST_VIDEO_AGGREGATOR_PAD (cpad);
+  GstVideoInfo *out_info = &GST_VIDEO_AGGREGATOR (self)->info;
+  GstVideoRectangle rect;
+  gboolean need_info;
+  gdouble alpha;
+
+  GST_OBJECT_LOCK (cpad);
+  gst_vulkan_compositor_pad_get_output_size (cpad,
+      GST_VIDEO_INFO_PAR_N (out_info), GST_VIDEO_INFO_PAR_D (out_info),
+      &rect.w, &rect.h);
+  rect.x = cpad->xpos;
+  rect.y = cpad->ypos;
+  alpha = cpad->alpha;
+  GST_OBJECT_UNLOCK (cpad);
+
+  if (rect.w <= 0 || rect.h <= 0 || alpha <= 0.0)
+    return TRUE;
+
+  /* completely outside of the output */
+  if (rect.x >= GST_VIDEO_INFO_WIDTH (out_info)
+      || rect.y >= GST_VIDEO_INFO_HEIGHT (out_info)
+      || rect.x + rect.w <= 0 || rect.y + rect.h <= 0)
+    return TRUE;
+
+  if (!cpad->quad) {
+    cpad->quad = gst_vulkan_full_screen_quad_new (self->queue);
+    gst_vulkan_full_screen_quad_set_shaders (cpad->quad, self->vert,
+        self->frag);
+    /* every pad is drawn over the previous ones */
+    gst_vulkan_full_screen_quad_enable_blend (cpad->quad, TRUE);
+    gst_vulkan_full_screen_quad_enable_clear (cpad->quad, FALSE);
+    need_info = TRUE;
+  } else {
+    need_info = !gst_video_info_is_equal (&cpad->quad->in_info,
+        &vagg_pad->info)
+        || !gst_video_info_is_equal (&cpad->quad->out_info, out_info);
+  }
+
+  if (need_info) {
+    if (!gst_vulkan_full_screen_quad_set_info (cpad->quad, &vagg_pad->info,
+            out_info)) {
+      g_set_error_literal (error, GST_VULKAN_ERROR, GST_VULKAN_FAILED,
+          "Failed to configure the video info");
+      return FALSE;
+    }
+  }
+
+  if (!gst_vulkan_compositor_pad_update_vertices (cpad, self->device, &rect,
+          out_info, error))
+    return FALSE;
+  if (!gst_vulkan_compositor_pad_update_uniforms (cpad, self->device, alpha,
+          error))
+    return FALSE;
+
+  if (!gst_vulkan_full_screen_quad_set_input_buffer (cpad->quad, inbuf, error))
+    return FALSE;
+  if (!gst_vulkan_full_screen_quad_set_output_buffer (cpad->quad, outbuf,
+          error))
+    return FALSE;
+
+  return gst_vulkan_full_screen_quad_draw (cpad->quad, error);
+}
+
+/* element */
+
+enum
+{
+  PROP_0,
+  PROP_BACKGROUND,
+};
+
+#define DEFAULT_BACKGROUND GST_VULKAN_COMPOSITOR_BACKGROUND_BLACK
+
+static void gst_vulkan_compositor_child_proxy_init (gpointer g_iface,
+    gpointer iface_data);
+
+#define gst_vulkan_compositor_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstVulkanCompositor, gst_vulkan_compositor,
+    GST_TYPE_VIDEO_AGGREGATOR,
+    G_IMPLEMENT_INTERFACE (GST_TYPE_CHILD_PROXY,
+        gst_vulkan_compositor_child_proxy_init);
+    GST_DEBUG_CATEGORY_INIT (gst_debug_vulkan_compositor,
+        "vulkancompositor", 0, "Vulkan Compositor"));
+
+static void
+gst_vulkan_compositor_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstVulkanCompositor *self = GST_VULKAN_COMPOSITOR (object);
+
+  switch (prop_id) {
+    case PROP_BACKGROUND:
+      GST_OBJECT_LOCK (self);
+      self->background = g_value_get_enum (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_vulkan_compositor_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstVulkanCompositor *self = GST_VULKAN_COMPOSITOR (object);
+
+  switch (prop_id) {
+    case PROP_BACKGROUND:
+      GST_OBJECT_LOCK (self);
+      g_value_set_enum (value, self->background);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_vulkan_compositor_set_context (GstElement * element, GstContext * context)
+{
+  GstVulkanCompositor *self = GST_VULKAN_COMPOSITOR (element);
+
+  gst_vulkan_handle_set_context (element, context, NULL, &self->instance);
+
+  GST_ELEMENT_CLASS (parent_class)->set_context (element, context);
+}
+
+static GstPad *
+gst_vulkan_compositor_request_new_pad (GstElement * element,
+    GstPadTemplate * templ, const gchar * name, const GstCaps * caps)
+{
+  GstPad *pad;
+
+  pad = GST_ELEMENT_CLASS (parent_class)->request_new_pad (element,
+      templ, name, caps);
+  if (!pad) {
+    GST_DEBUG_OBJECT (element, "could not create/add pad");
+    return NULL;
+  }
+
+  gst_child_proxy_child_added (GST_CHILD_PROXY (element), G_OBJECT (pad),
+      GST_OBJECT_NAME (pad));
+
+  GST_DEBUG_OBJECT (element, "Created new pad %s:%s", GST_DEBUG_PAD_NAME (pad));
+
+  return pad;
+}
+
+static void
+gst_vulkan_compositor_release_pad (GstElement * element, GstPad * pad)
+{
+  GST_DEBUG_OBJECT (element, "Releasing pad %s:%s", GST_DEBUG_PAD_NAME (pad));
+
+  gst_child_proxy_child_removed (GST_CHILD_PROXY (element), G_OBJECT (pad),
+      GST_OBJECT_NAME (pad));
+
+  GST_ELEMENT_CLASS (parent_class)->release_pad (element, pad);
+}
+
+static gboolean
+_handle_context_query (GstVulkanCompositor * self, GstQuery * query)
+{
+  if (gst_vulkan_handle_context_query (GST_ELEMENT (self), query, NULL,
+          self->instance, self->device))
+    return TRUE;
+
+  if (gst_vulkan_queue_handle_context_query (GST_ELEMENT (self), query,
+          self->queue))
+    return TRUE;
+
+  return FALSE;
+}
+
+static gboolean
+gst_vulkan_compositor_sink_query (GstAggregator * aggregator,
+    GstAggregatorPad * pad, GstQuery * query)
+{
+  GstVulkanCompositor *self = GST_VULKAN_COMPOSITOR (aggregator);
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CONTEXT:
+      if (_handle_context_query (self, query))
+        return TRUE;
+      break;
+    case GST_QUERY_CAPS:{
+      GstCaps *filter, *caps;
+
+      /* every input is scaled and blended by the GPU, so any of the
+       * template caps is fine, regardless other pads */
+      gst_query_parse_caps (query, &filter);
+      caps = gst_pad_get_pad_template_caps (GST_PAD (pad));
+      if (filter) {
+        GstCaps *tmp = gst_caps_intersect_full (filter, caps,
+            GST_CAPS_INTERSECT_FIRST);
+        gst_caps_unref (caps);
+        caps = tmp;
+      }
+      gst_query_set_caps_result (query, caps);
+      gst_caps_unref (caps);
+      return TRUE;
+    }
+    case GST_QUERY_ACCEPT_CAPS:{
+      GstCaps *caps, *templ;
+
+      gst_query_parse_accept_caps (query, &caps);
+      templ = gst_pad_get_pad_template_caps (GST_PAD (pad));
+      gst_query_set_accept_caps_result (query,
+          gst_caps_can_intersect (caps, templ));
+      gst_caps_unref (templ);
+      return TRUE;
+    }
+    default:
+      break;
+  }
+
+  return GST_AGGREGATOR_CLASS (parent_class)->sink_query (aggregator, pad,
+      query);
+}
+
+static gboolean
+gst_vulkan_compositor_src_query (GstAggregator * aggregator, GstQuery * query)
+{
+  GstVulkanCompositor *self = GST_VULKAN_COMPOSITOR (aggregator);
+
+  if (GST_QUERY_TYPE (query) == GST_QUERY_CONTEXT
+      && _handle_context_query (self, query))
+    return TRUE;
+
+  return GST_AGGREGATOR_CLASS (parent_class)->src_query (aggregator, query);
+}
+
+static gboolean
+_choose_queue (GstVulkanDevice * device, GstVulkanQueue * queue,
+    GstVulkanQueue ** ret)
+{
+  guint flags =
+      device->physical_device->queue_family_props[queue->family].queueFlags;
+
+  if ((flags & VK_QUEUE_GRAPHICS_BIT) != 0) {
+    *ret = gst_object_ref (queue);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+static GstVulkanQueue *
+_find_graphics_queue (GstVulkanCompositor * self)
+{
+  GstVulkanQueue *queue = NULL;
+
+  gst_vulkan_device_foreach_queue (self->device,
+      (GstVulkanDeviceForEachQueueFunc) _choose_queue, &queue);
+
+  return queue;
+}
+
+static gboolean
+gst_vulkan_compositor_start (GstAggregator * aggregator)
+{
+  GstVulkanCompositor *self = GST_VULKAN_COMPOSITOR (aggregator);
+  GError *error = NULL;
+
+  if (!gst_vulkan_ensure_element_data (GST_ELEMENT (self), NULL,
+          &self->instance)) {
+    GST_ELEMENT_ERROR (self, RESOURCE, NOT_FOUND,
+        ("Failed to retrieve vulkan instance"), (NULL));
+    return FALSE;
+  }
+  if (!gst_vulkan_device_run_context_query (GST_ELEMENT (self),
+          &self->device)) {
+    GST_DEBUG_OBJECT (self, "No device retrieved from peer elements");
+    if (!(self->device =
+            gst_vulkan_instance_create_device (self->instance, &error))) {
+      GST_ELEMENT_ERROR (self, RESOURCE, NOT_FOUND,
+          ("Failed to create vulkan device"), ("%s", error->message));
+      g_clear_error (&error);
+      return FALSE;
+    }
+  }
+
+  if (gst_vulkan_queue_run_context_query (GST_ELEMENT (self), &self->queue)) {
+    guint flags = self->device->physical_device->
+        queue_family_props[self->queue->family].queueFlags;
+
+    /* drawing requires a graphics queue */
+    if (self->queue->device != self->device
+        || (flags & VK_QUEUE_GRAPHICS_BIT) == 0)
+      gst_clear_object (&self->queue);
+  } else {
+    GST_DEBUG_OBJECT (self, "No queue retrieved from peer elements");
+  }
+  if (!self->queue)
+    self->queue = _find_graphics_queue (self);
+  if (!self->queue) {
+    GST_ELEMENT_ERROR (self, RESOURCE, NOT_FOUND,
+        ("Failed to find a graphics queue"), (NULL));
+    return FALSE;
+  }
+
+  if (!(self->vert = gst_vulkan_create_shader (self->device, identity_vert,
+              identity_vert_size, &error)))
+    goto error;
+  if (!(self->frag = gst_vulkan_create_shader (self->device, compositor_frag,
+              compositor_frag_size, &error)))
+    goto error;
+
+  self->trash_list = gst_vulkan_trash_fence_list_new ();
+
+  return GST_AGGREGATOR_CLASS (parent_class)->start (aggregator);
+
+error:
+  GST_ELEMENT_ERROR (self, RESOURCE, NOT_FOUND, ("%s", error->message), (NULL));
+  g_clear_error (&error);
+  return FALSE;
+}
+
+static gboolean
+gst_vulkan_compositor_stop (GstAggregator * aggregator)
+{
+  GstVulkanCompositor *self = GST_VULKAN_COMPOSITOR (aggregator);
+  GList *l;
+
+  GST_OBJECT_LOCK (self);
+  for (l = GST_ELEMENT (self)->sinkpads; l; l = l->next)
+    gst_vulkan_compositor_pad_reset (GST_VULKAN_COMPOSITOR_PAD (l->data));
+  GST_OBJECT_UNLOCK (self);
+
+  if (self->trash_list) {
+    gst_vulkan_trash_list_wait (self->trash_list, -1);
+    gst_vulkan_trash_list_gc (self->trash_list);
+    gst_clear_object (&self->trash_list);
+  }
+
+  gst_clear_object (&self->cmd_pool);
+  if (self->vert)
+    gst_vulkan_handle_unref (self->vert);
+  self->vert = NULL;
+  if (self->frag)
+    gst_vulkan_handle_unref (self->frag);
+  self->frag = NULL;
+
+  gst_clear_object (&self->queue);
+  gst_clear_object (&self->device);
+  gst_clear_object (&self->instance);
+
+  return GST_AGGREGATOR_CLASS (parent_class)->stop (aggregator);
+}
+
+static GstCaps *
+gst_vulkan_compositor_fixate_src_caps (GstAggregator * aggregator,
+    GstCaps * caps)
+{
+  GstVideoAggregator *vagg = GST_VIDEO_AGGREGATOR (aggregator);
+  GList *l;
+  gint best_width = -1, best_height = -1;
+  gint best_fps_n = -1, best_fps_d = -1;
+  gint par_n, par_d;
+  gdouble best_fps = 0.;
+  GstCaps *ret;
+  GstStructure *s;
+
+  ret = gst_caps_make_writable (caps);
+
+  /* we need this to calculate how large to make the output frame */
+  s = gst_caps_get_structure (ret, 0);
+  if (gst_structure_has_field (s, "pixel-aspect-ratio")) {
+    gst_structure_fixate_field_nearest_fraction (s, "pixel-aspect-ratio", 1, 1);
+    gst_structure_get_fraction (s, "pixel-aspect-ratio", &par_n, &par_d);
+  } else {
+    par_n = par_d = 1;
+  }
+
+  GST_OBJECT_LOCK (vagg);
+  for (l = GST_ELEMENT (vagg)->sinkpads; l; l = l->next) {
+    GstVideoAggregatorPad *vaggpad = l->data;
+    GstVulkanCompositorPad *cpad = GST_VULKAN_COMPOSITOR_PAD (vaggpad);
+    gint this_width, this_height;
+    gint width, height;
+    gint fps_n, fps_d;
+    gdouble cur_fps;
+
+    fps_n = GST_VIDEO_INFO_FPS_N (&vaggpad->info);
+    fps_d = GST_VIDEO_INFO_FPS_D (&vaggpad->info);
+
+    GST_OBJECT_LOCK (cpad);
+    gst_vulkan_compositor_pad_get_output_size (cpad, par_n, par_d, &width,
+        &height);
+    this_width = width + MAX (cpad->xpos, 0);
+    this_height = height + MAX (cpad->ypos, 0);
+    GST_OBJECT_UNLOCK (cpad);
+
+    if (width == 0 || height == 0)
+      continue;
+
+    if (best_width < this_width)
+      best_width = this_width;
+    if (best_height < this_height)
+      best_height = this_height;
+
+    if (fps_d == 0)
+      cur_fps = 0.0;
+    else
+      gst_util_fraction_to_double (fps_n, fps_d, &cur_fps);
+
+    if (best_fps < cur_fps) {
+      best_fps = cur_fps;
+      best_fps_n = fps_n;
+      best_fps_d = fps_d;
+    }
+  }
+  GST_OBJECT_UNLOCK (vagg);
+
+  if (best_fps_n <= 0 || best_fps_d <= 0 || best_fps == 0.0) {
+    best_fps_n = 25;
+    best_fps_d = 1;
+    best_fps = 25.0;
+  }
+
+  gst_structure_fixate_field_nearest_int (s, "width", best_width);
+  gst_structure_fixate_field_nearest_int (s, "height", best_height);
+  gst_structure_fixate_field_nearest_fraction (s, "framerate", best_fps_n,
+      best_fps_d);
+  ret = gst_caps_fixate (ret);
+
+  GST_LOG_OBJECT (aggregator, "Fixated caps %" GST_PTR_FORMAT, ret);
+
+  return ret;
+}
+
+static gboolean
+gst_vulkan_compositor_decide_allocation (GstAggregator * aggregator,
+    GstQuery * query)
+{
+  GstVulkanCompositor *self = GST_VULKAN_COMPOSITOR (aggregator);
+  GstBufferPool *pool = NULL;
+  GstStructure *config;
+  GstCaps *caps;
+  guint min, max, size;
+  gboolean update_pool;
+
+  gst_query_parse_allocation (query, &caps, NULL);
+  if (!caps)
+    return FALSE;
+
+  if (gst_query_get_n_allocation_pools (query) > 0) {
+    gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min, &max);
+
+    update_pool = TRUE;
+  } else {
+    GstVideoInfo vinfo;
+
+    gst_video_info_init (&vinfo);
+    gst_video_info_from_caps (&vinfo, caps);
+    size = vinfo.size;
+    min = max = 0;
+    update_pool = FALSE;
+  }
+
+  if (!pool || !GST_IS_VULKAN_IMAGE_BUFFER_POOL (pool)) {
+    if (pool)
+      gst_object_unref (pool);
+    pool = gst_vulkan_image_buffer_pool_new (self->device);
+  }
+
+  config = gst_buffer_pool_get_config (pool);
+
+  gst_buffer_pool_config_set_params (config, caps, size, min, max);
+  gst_buffer_pool_config_add_option (config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+
+  gst_buffer_pool_set_config (pool, config);
+
+  if (update_pool)
+    gst_query_set_nth_allocation_pool (query, 0, pool, size, min, max);
+  else
+    gst_query_add_allocation_pool (query, pool, size, min, max);
+
+  gst_object_unref (pool);
+
+  return TRUE;
+}
+
+/* fills the whole output with the background colour, the pads are then
+ * blended on top of it */
+static gboolean
+_clear_output (GstVulkanCompositor * self, GstBuffer * outbuf,
+    GError ** error)
+{
+  GstVulkanCommandBuffer *cmd_buf = NULL;
+  GstVulkanFence *fence = NULL;
+  VkClearColorValue colour;
+  VkResult err;
+  guint i;
+
+  GST_OBJECT_LOCK (self);
+  switch (self->background) {
+    case GST_VULKAN_COMPOSITOR_BACKGROUND_WHITE:
+      /* *INDENT-OFF* */
+      colour = (VkClearColorValue) {{ 1.0f, 1.0f, 1.0f, 1.0f }};
+      /* *INDENT-ON* */
+      break;
+    case GST_VULKAN_COMPOSITOR_BACKGROUND_TRANSPARENT:
+      /* *INDENT-OFF* */
+      colour = (VkClearColorValue) {{ 0.0f, 0.0f, 0.0f, 0.0f }};
+      /* *INDENT-ON* */
+      break;
+    case GST_VULKAN_COMPOSITOR_BACKGROUND_BLACK:
+    default:
+      /* *INDENT-OFF* */
+      colour = (VkClearColorValue) {{ 0.0f, 0.0f, 0.0f, 1.0f }};
+      /* *INDENT-ON* */
+      break;
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  if (!self->cmd_pool)
+    if (!(self->cmd_pool =
+            gst_vulkan_queue_create_command_pool (self->queue, error)))
+      return FALSE;
+
+  if (!(fence = gst_vulkan_queue_create_fence (self->queue, error)))
+    return FALSE;
+
+  if (!(cmd_buf = gst_vulkan_command_pool_create (self->cmd_pool, error)))
+    goto error;
+
+  {
+    VkCommandBufferBeginInfo cmd_buf_info = { 0, };
+
+    /* *INDENT-OFF* */
+    cmd_buf_info = (VkCommandBufferBeginInfo) {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext = NULL,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        .pInheritanceInfo = NULL
+    };
+    /* *INDENT-ON* */
+
+    gst_vulkan_command_buffer_lock (cmd_buf);
+    err = vkBeginCommandBuffer (cmd_buf->cmd, &cmd_buf_info);
+    if (gst_vulkan_error_to_g_error (err, error, "vkBeginCommandBuffer") < 0)
+      goto unlock_error;
+  }
+
+  for (i = 0; i < gst_buffer_n_memory (outbuf); i++) {
+    GstMemory *mem = gst_buffer_peek_memory (outbuf, i);
+    GstVulkanImageMemory *img_mem;
+
+    if (!gst_is_vulkan_image_memory (mem)) {
+      g_set_error_literal (error, GST_VULKAN_ERROR, GST_VULKAN_FAILED,
+          "Output memory must be a GstVulkanImageMemory");
+      goto unlock_error;
+    }
+    img_mem = (GstVulkanImageMemory *) mem;
+
+    {
+      /* *INDENT-OFF* */
+      VkImageMemoryBarrier image_memory_barrier = {
+          .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+          .pNext = NULL,
+          .srcAccessMask = img_mem->barrier.parent.access_flags,
+          .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+          /* the previous contents are discarded */
+          .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+          .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+          /* FIXME: implement exclusive transfers */
+          .srcQueueFamilyIndex = 0,
+          .dstQueueFamilyIndex = 0,
+          .image = img_mem->image,
+          .subresourceRange = img_mem->barrier.subresource_range
+      };
+      /* *INDENT-ON* */
+
+      vkCmdPipelineBarrier (cmd_buf->cmd,
+          img_mem->barrier.parent.pipeline_stages,
+          VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1,
+          &image_memory_barrier);
+
+      img_mem->barrier.parent.pipeline_stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+      img_mem->barrier.parent.access_flags = image_memory_barrier.dstAccessMask;
+      img_mem->barrier.image_layout = image_memory_barrier.newLayout;
+    }
+
+    vkCmdClearColorImage (cmd_buf->cmd, img_mem->image,
+        img_mem->barrier.image_layout, &colour, 1,
+        &img_mem->barrier.subresource_range);
+  }
+
+  err = vkEndCommandBuffer (cmd_buf->cmd);
+  gst_vulkan_command_buffer_unlock (cmd_buf);
+  if (gst_vulkan_error_to_g_error (err, error, "vkEndCommandBuffer") < 0)
+    goto error;
+
+  {
+    /* *INDENT-OFF* */
+    VkSubmitInfo submit_info = {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext = NULL,
+        .waitSemaphoreCount = 0,
+        .pWaitSemaphores = NULL,
+        .pWaitDstStageMask = NULL,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &cmd_buf->cmd,
+        .signalSemaphoreCount = 0,
+        .pSignalSemaphores = NULL,
+    };
+    /* *INDENT-ON* */
+
+    if (!gst_vulkan_queue_submit (self->queue, &submit_info, fence, error))
+      goto error;
+  }
+
+  gst_vulkan_trash_list_add (self->trash_list,
+      gst_vulkan_trash_list_acquire (self->trash_list, fence,
+          gst_vulkan_trash_mini_object_unref, GST_MINI_OBJECT_CAST (cmd_buf)));
+  gst_vulkan_fence_unref (fence);
+
+  return TRUE;
+
+unlock_error:
+  gst_vulkan_command_buffer_unlock (cmd_buf);
+
+error:
+  gst_clear_mini_object ((GstMiniObject **) & cmd_buf);
+  gst_clear_mini_object ((GstMiniObject **) & fence);
+  return FALSE;
+}
+
+static GstFlowReturn
+gst_vulkan_compositor_aggregate_frames (GstVideoAggregator * vagg,
+    GstBuffer * outbuf)
+{
+  GstVulkanCompositor *self = GST_VULKAN_COMPOSITOR (vagg);
+  GList *pads = NULL, *l;
+  GError *error = NULL;
+
+  gst_vulkan_trash_list_gc (self->trash_list);
+
+  if (!_clear_output (self, outbuf, &error))
+    goto error;
+
+  /* sink pads are sorted by zorder */
+  GST_OBJECT_LOCK (self);
+  for (l = GST_ELEMENT (self)->sinkpads; l; l = l->next)
+    pads = g_list_prepend (pads, gst_object_ref (l->data));
+  GST_OBJECT_UNLOCK (self);
+  pads = g_list_reverse (pads);
+
+  for (l = pads; l; l = l->next) {
+    GstVideoAggregatorPad *pad = l->data;
+    GstVideoFrame *prepared_frame =
+        gst_video_aggregator_pad_get_prepared_frame (pad);
+
+    if (!prepared_frame || !prepared_frame->buffer)
+      continue;
+
+    if (!gst_vulkan_compositor_pad_draw (GST_VULKAN_COMPOSITOR_PAD (pad),
+            self, prepared_frame->buffer, outbuf, &error))
+      break;
+  }
+  g_list_free_full (pads, gst_object_unref);
+
+  if (error)
+    goto error;
+
+  return GST_FLOW_OK;
+
+error:
+  GST_ELEMENT_ERROR (self, LIBRARY, FAILED, ("%s", error->message), (NULL));
+  g_clear_error (&error);
+  return GST_FLOW_ERROR;
+}
+
+static GObject *
+gst_vulkan_compositor_child_proxy_get_child_by_index (GstChildProxy * proxy,
+    guint index)
+{
+  GstVulkanCompositor *self = GST_VULKAN_COMPOSITOR (proxy);
+  GObject *obj = NULL;
+
+  GST_OBJECT_LOCK (self);
+  obj = g_list_nth_data (GST_ELEMENT_CAST (self)->sinkpads, index);
+  if (obj)
+    gst_object_ref (obj);
+  GST_OBJECT_UNLOCK (self);
+
+  return obj;
+}
+
+static guint
+gst_vulkan_compositor_child_proxy_get_children_count (GstChildProxy * proxy)
+{
+  GstVulkanCompositor *self = GST_VULKAN_COMPOSITOR (proxy);
+  guint count;
+
+  GST_OBJECT_LOCK (self);
+  count = GST_ELEMENT_CAST (self)->numsinkpads;
+  GST_OBJECT_UNLOCK (self);
+
+  return count;
+}
+
+static void
+gst_vulkan_compositor_child_proxy_init (gpointer g_iface, gpointer iface_data)
+{
+  GstChildProxyInterface *iface = g_iface;
+
+  iface->get_child_by_index =
+      gst_vulkan_compositor_child_proxy_get_child_by_index;
+  iface->get_children_count =
+      gst_vulkan_compositor_child_proxy_get_children_count;
+}
+
+static void
+gst_vulkan_compositor_class_init (GstVulkanCompositorClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *gstelement_class = GST_ELEMENT_CLASS (klass);
+  GstAggregatorClass *agg_class = GST_AGGREGATOR_CLASS (klass);
+  GstVideoAggregatorClass *vagg_class = GST_VIDEO_AGGREGATOR_CLASS (klass);
+
+  gobject_class->set_property = gst_vulkan_compositor_set_property;
+  gobject_class->get_property = gst_vulkan_compositor_get_property;
+
+  /**
+   * GstVulkanCompositor:background:
+   *
+   * The colour the output is cleared to before blending the inputs.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_BACKGROUND,
+      g_param_spec_enum ("background", "Background", "Background type",
+          GST_TYPE_VULKAN_COMPOSITOR_BACKGROUND, DEFAULT_BACKGROUND,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
+          G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_set_metadata (gstelement_class, "Vulkan Compositor",
+      "Filter/Editor/Video/Compositor", "Composites Vulkan images",
+      "GStreamer developers");
+
+  gst_element_class_add_static_pad_template_with_gtype (gstelement_class,
+      &gst_vulkan_compositor_sink_template, GST_TYPE_VULKAN_COMPOSITOR_PAD);
+  gst_element_class_add_static_pad_template_with_gtype (gstelement_class,
+      &gst_vulkan_compositor_src_template, GST_TYPE_AGGREGATOR_PAD);
+
+  gstelement_class->set_context =
+      GST_DEBUG_FUNCPTR (gst_vulkan_compositor_set_context);
+  gstelement_class->request_new_pad =
+      GST_DEBUG_FUNCPTR (gst_vulkan_compositor_request_new_pad);
+  gstelement_class->release_pad =
+      GST_DEBUG_FUNCPTR (gst_vulkan_compositor_release_pad);
+
+  agg_class->start = GST_DEBUG_FUNCPTR (gst_vulkan_compositor_start);
+  agg_class->stop = GST_DEBUG_FUNCPTR (gst_vulkan_compositor_stop);
+  agg_class->sink_query = GST_DEBUG_FUNCPTR (gst_vulkan_compositor_sink_query);
+  agg_class->src_query = GST_DEBUG_FUNCPTR (gst_vulkan_compositor_src_query);
+  agg_class->fixate_src_caps =
+      GST_DEBUG_FUNCPTR (gst_vulkan_compositor_fixate_src_caps);
+  agg_class->decide_allocation =
+      GST_DEBUG_FUNCPTR (gst_vulkan_compositor_decide_allocation);
+
+  vagg_class->aggregate_frames =
+      GST_DEBUG_FUNCPTR (gst_vulkan_compositor_aggregate_frames);
+
+  gst_type_mark_as_plugin_api (GST_TYPE_VULKAN_COMPOSITOR_PAD, 0);
+  gst_type_mark_as_plugin_api (GST_TYPE_VULKAN_COMPOSITOR_BACKGROUND, 0);
+}
+
+static void
+gst_vulkan_compositor_init (GstVulkanCompositor * self)
+{
+  self->background = DEFAULT_BACKGROUND;
+}
@@ -0,0 +1,108 @@
+/*
+ * GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _VK_COMPOSITOR_H_
+#define _VK_COMPOSITOR_H_
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <gst/video/gstvideoaggregator.h>
+#include <gst/vulkan/vulkan.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_VULKAN_COMPOSITOR            (gst_vulkan_compositor_get_type())
+#define GST_VULKAN_COMPOSITOR(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_VULKAN_COMPOSITOR,GstVulkanCompositor))
+#define GST_VULKAN_COMPOSITOR_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_VULKAN_COMPOSITOR,GstVulkanCompositorClass))
+#define GST_IS_VULKAN_COMPOSITOR(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_VULKAN_COMPOSITOR))
+#define GST_IS_VULKAN_COMPOSITOR_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_VULKAN_COMPOSITOR))
+
+#define GST_TYPE_VULKAN_COMPOSITOR_PAD        (gst_vulkan_compositor_pad_get_type())
+#define GST_VULKAN_COMPOSITOR_PAD(obj)        (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_VULKAN_COMPOSITOR_PAD,GstVulkanCompositorPad))
+#define GST_IS_VULKAN_COMPOSITOR_PAD(obj)     (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_VULKAN_COMPOSITOR_PAD))
+
+typedef struct _GstVulkanCompositor GstVulkanCompositor;
+typedef struct _GstVulkanCompositorClass GstVulkanCompositorClass;
+typedef struct _GstVulkanCompositorPad GstVulkanCompositorPad;
+typedef struct _GstVulkanCompositorPadClass GstVulkanCompositorPadClass;
+
+typedef enum
+{
+  GST_VULKAN_COMPOSITOR_BACKGROUND_BLACK,
+  GST_VULKAN_COMPOSITOR_BACKGROUND_WHITE,
+  GST_VULKAN_COMPOSITOR_BACKGROUND_TRANSPARENT,
+} GstVulkanCompositorBackground;
+
+struct _GstVulkanCompositorPad
+{
+  GstVideoAggregatorPad             parent;
+
+  /* properties */
+  gint                              xpos;
+  gint                              ypos;
+  gint                              width;
+  gint                              height;
+  gdouble                           alpha;
+
+  GstVulkanFullScreenQuad          *quad;
+
+  /* the output rectangle and alpha the current vertices and uniforms were
+   * generated for */
+  GstMemory                        *vertices;
+  GstVideoRectangle                 vertex_rect;
+  gint                              vertex_out_width;
+  gint                              vertex_out_height;
+  GstMemory                        *uniforms;
+  gdouble                           uniform_alpha;
+};
+
+struct _GstVulkanCompositorPadClass
+{
+  GstVideoAggregatorPadClass parent_class;
+};
+
+struct _GstVulkanCompositor
+{
+  GstVideoAggregator                parent;
+
+  GstVulkanInstance                *instance;
+  GstVulkanDevice                  *device;
+  GstVulkanQueue                   *queue;
+
+  GstVulkanHandle                  *vert;
+  GstVulkanHandle                  *frag;
+
+  GstVulkanCommandPool             *cmd_pool;
+  GstVulkanTrashList               *trash_list;
+
+  /* properties */
+  GstVulkanCompositorBackground     background;
+};
+
+struct _GstVulkanCompositorClass
+{
+  GstVideoAggregatorClass parent_class;
+};
+
+GType gst_vulkan_compositor_get_type(void);
+GType gst_vulkan_compositor_pad_get_type(void);
+
+G_END_DECLS
+
+#endif
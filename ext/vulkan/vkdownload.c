@@ -36,6 +36,88 @@
 GST_DEBUG_CATEGORY (gst_debug_vulkan_download);
 #define GST_CAT_DEFAULT gst_debug_vulkan_download
 
+#define DEFAULT_MAX_IN_FLIGHT 2
+
+#define TRANSFER_STAGES (VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT | \
+    VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_HOST_BIT)
+#define TRANSFER_ACCESS (VK_ACCESS_TRANSFER_READ_BIT | \
+    VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_READ_BIT | \
+    VK_ACCESS_HOST_WRITE_BIT)
+
+static GstVulkanQueue *
+_get_transfer_queue (GstVulkanDownload * download)
+{
+  return download->transfer_queue ? download->transfer_queue : download->queue;
+}
+
+/* A transfer only queue cannot reference the stages of previous graphics
+ * accesses.  Those are ordered by the semaphores between the queues
+ * instead. */
+static void
+_transfer_src_barrier (GstVulkanDownload * download,
+    VkPipelineStageFlags * stages, VkAccessFlags * access)
+{
+  if (!download->transfer_queue)
+    return;
+
+  *stages &= TRANSFER_STAGES;
+  if (*stages == 0)
+    *stages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+  *access &= TRANSFER_ACCESS;
+}
+
+/* bounds the number of transfers not yet completed by the GPU */
+static void
+_track_in_flight (GstVulkanDownload * download, GstVulkanFence * fence)
+{
+  GstVulkanFence *oldest;
+  guint max_in_flight;
+
+  GST_OBJECT_LOCK (download);
+  max_in_flight = download->max_in_flight;
+  GST_OBJECT_UNLOCK (download);
+
+  g_queue_push_tail (&download->in_flight, gst_vulkan_fence_ref (fence));
+
+  while ((oldest = g_queue_peek_head (&download->in_flight))) {
+    if (max_in_flight > 0
+        && g_queue_get_length (&download->in_flight) > max_in_flight) {
+      GST_TRACE_OBJECT (download, "waiting for transfer fence %p", oldest);
+      if (!gst_vulkan_fence_wait (oldest, G_MAXUINT64))
+        GST_WARNING_OBJECT (download, "Failed to wait for a transfer");
+    } else if (!gst_vulkan_fence_is_signaled (oldest)) {
+      break;
+    }
+
+    g_queue_pop_head (&download->in_flight);
+    gst_vulkan_fence_unref (oldest);
+  }
+}
+
+/* everything producing the downloaded images is submitted to the graphics
+ * queue */
+static gboolean
+_submit_transfer (GstVulkanDownload * download, VkSubmitInfo * submit_info,
+    GstVulkanFence * fence, GError ** error)
+{
+  GstVulkanQueue *queue = _get_transfer_queue (download);
+
+  if (download->transfer_queue
+      && !gst_vulkan_queue_add_dependency (download->transfer_queue,
+          download->queue, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT)) {
+    g_set_error_literal (error, GST_VULKAN_ERROR, VK_ERROR_FEATURE_NOT_PRESENT,
+        "Failed to synchronise the transfer queue with the graphics queue");
+    return FALSE;
+  }
+
+  if (!gst_vulkan_queue_submit (queue, submit_info, fence, error))
+    return FALSE;
+
+  _track_in_flight (download, fence);
+
+  return TRUE;
+}
+
 static GstCaps *
 _set_caps_features_with_passthrough (const GstCaps * caps,
     const gchar * feature_name, GstCapsFeatures * passthrough)
@@ -151,8 +233,8 @@ _image_to_raw_perform (gpointer impl, GstBuffer * inbuf, GstBuffer ** outbuf)
 
   if (!raw->cmd_pool) {
     if (!(raw->cmd_pool =
-            gst_vulkan_queue_create_command_pool (raw->download->queue,
-                &error))) {
+            gst_vulkan_queue_create_command_pool (_get_transfer_queue
+                (raw->download), &error))) {
       goto error;
     }
   }
@@ -204,6 +286,7 @@ _image_to_raw_perform (gpointer impl, GstBuffer * inbuf, GstBuffer ** outbuf)
     GstVulkanImageMemory *img_mem;
     VkImageMemoryBarrier image_memory_barrier;
     VkBufferMemoryBarrier buffer_memory_barrier;
+    VkPipelineStageFlags src_stages;
 
     in_mem = gst_buffer_peek_memory (inbuf, i);
     if (!gst_is_vulkan_image_memory (in_mem)) {
@@ -267,13 +350,16 @@ _image_to_raw_perform (gpointer impl, GstBuffer * inbuf, GstBuffer ** outbuf)
     };
     /* *INDENT-ON* */
 
-    vkCmdPipelineBarrier (cmd_buf->cmd,
-        buf_mem->barrier.parent.pipeline_stages | img_mem->barrier.
-        parent.pipeline_stages, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 1,
-        &buffer_memory_barrier, 1, &image_memory_barrier);
+    src_stages = buf_mem->barrier.parent.pipeline_stages |
+        img_mem->barrier.parent.pipeline_stages;
+    _transfer_src_barrier (raw->download, &src_stages,
+        &buffer_memory_barrier.srcAccessMask);
+    _transfer_src_barrier (raw->download, &src_stages,
+        &image_memory_barrier.srcAccessMask);
 
-    buf_mem->barrier.parent.pipeline_stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    buf_mem->barrier.parent.access_flags = buffer_memory_barrier.dstAccessMask;
+    vkCmdPipelineBarrier (cmd_buf->cmd, src_stages,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 1, &buffer_memory_barrier,
+        1, &image_memory_barrier);
 
     img_mem->barrier.parent.pipeline_stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
     img_mem->barrier.parent.access_flags = image_memory_barrier.dstAccessMask;
@@ -281,6 +367,16 @@ _image_to_raw_perform (gpointer impl, GstBuffer * inbuf, GstBuffer ** outbuf)
 
     vkCmdCopyImageToBuffer (cmd_buf->cmd, img_mem->image,
         img_mem->barrier.image_layout, buf_mem->buffer, 1, &region);
+
+    /* make the copy visible to the host once the fence is signalled */
+    buffer_memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    buffer_memory_barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier (cmd_buf->cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_HOST_BIT, 0, 0, NULL, 1, &buffer_memory_barrier, 0,
+        NULL);
+
+    buf_mem->barrier.parent.pipeline_stages = VK_PIPELINE_STAGE_HOST_BIT;
+    buf_mem->barrier.parent.access_flags = buffer_memory_barrier.dstAccessMask;
   }
 
   err = vkEndCommandBuffer (cmd_buf->cmd);
@@ -307,29 +403,35 @@ _image_to_raw_perform (gpointer impl, GstBuffer * inbuf, GstBuffer ** outbuf)
     };
     /* *INDENT-ON* */
 
-    fence = gst_vulkan_device_create_fence (raw->download->device, &error);
+    fence = gst_vulkan_queue_create_fence (_get_transfer_queue
+        (raw->download), &error);
     if (!fence)
       goto error;
 
-    gst_vulkan_queue_submit_lock (raw->download->queue);
-    err =
-        vkQueueSubmit (raw->download->queue->queue, 1, &submit_info,
-        GST_VULKAN_FENCE_FENCE (fence));
-    gst_vulkan_queue_submit_unlock (raw->download->queue);
-    if (gst_vulkan_error_to_g_error (err, &error, "vkQueueSubmit") < 0)
+    if (!_submit_transfer (raw->download, &submit_info, fence, &error)) {
+      gst_vulkan_fence_unref (fence);
       goto error;
+    }
+
+    /* mapping the output waits for the copy instead of stalling here */
+    for (i = 0; i < gst_buffer_n_memory (*outbuf); i++) {
+      GstMemory *out_mem = gst_buffer_peek_memory (*outbuf, i);
+
+      gst_vulkan_buffer_memory_set_pending_fence ((GstVulkanBufferMemory *)
+          out_mem, fence);
+    }
 
     gst_vulkan_trash_list_add (raw->trash_list,
         gst_vulkan_trash_list_acquire (raw->trash_list, fence,
             gst_vulkan_trash_mini_object_unref,
             GST_MINI_OBJECT_CAST (cmd_buf)));
+    gst_vulkan_trash_list_add (raw->trash_list,
+        gst_vulkan_trash_list_acquire (raw->trash_list, fence,
+            gst_vulkan_trash_mini_object_unref,
+            GST_MINI_OBJECT_CAST (gst_buffer_ref (inbuf))));
     gst_vulkan_fence_unref (fence);
   }
 
-  /* XXX: STALL!
-   * Need to have the buffer gst_memory_map() wait for this fence before
-   * allowing access */
-  gst_vulkan_trash_list_wait (raw->trash_list, -1);
   gst_vulkan_trash_list_gc (raw->trash_list);
 
   ret = GST_FLOW_OK;
@@ -432,6 +534,10 @@ _get_output_template_caps (void)
 }
 
 static void gst_vulkan_download_finalize (GObject * object);
+static void gst_vulkan_download_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * param_spec);
+static void gst_vulkan_download_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * param_spec);
 
 static gboolean gst_vulkan_download_query (GstBaseTransform * bt,
     GstPadDirection direction, GstQuery * query);
@@ -456,6 +562,7 @@ static GstFlowReturn gst_vulkan_download_prepare_output_buffer (GstBaseTransform
 enum
 {
   PROP_0,
+  PROP_MAX_IN_FLIGHT,
 };
 
 enum
@@ -482,6 +589,25 @@ gst_vulkan_download_class_init (GstVulkanDownloadClass * klass)
   gstelement_class = (GstElementClass *) klass;
   gstbasetransform_class = (GstBaseTransformClass *) klass;
 
+  gobject_class->set_property = gst_vulkan_download_set_property;
+  gobject_class->get_property = gst_vulkan_download_get_property;
+
+  /**
+   * GstVulkanDownload:max-in-flight:
+   *
+   * The maximum number of transfers submitted to the GPU that have not
+   * completed yet before waiting for the oldest one.  Transfers use a
+   * dedicated transfer queue when the device has one and mapping the output
+   * waits for its transfer to complete.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_IN_FLIGHT,
+      g_param_spec_uint ("max-in-flight", "Maximum in flight",
+          "Maximum number of uncompleted transfers (0 = unlimited)", 0,
+          G_MAXUINT, DEFAULT_MAX_IN_FLIGHT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_metadata (gstelement_class, "Vulkan Downloader",
       "Filter/Video", "A Vulkan data downloader",
       "Matthew Waters <matthew@centricular.com>");
@@ -521,6 +647,9 @@ gst_vulkan_download_init (GstVulkanDownload * vk_download)
 {
   guint i, n;
 
+  vk_download->max_in_flight = DEFAULT_MAX_IN_FLIGHT;
+  g_queue_init (&vk_download->in_flight);
+
   n = G_N_ELEMENTS (download_methods);
   vk_download->download_impls = g_malloc (sizeof (gpointer) * n);
   for (i = 0; i < n; i++) {
@@ -547,6 +676,42 @@ gst_vulkan_download_finalize (GObject * object)
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gst_vulkan_download_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstVulkanDownload *vk_download = GST_VULKAN_DOWNLOAD (object);
+
+  switch (prop_id) {
+    case PROP_MAX_IN_FLIGHT:
+      GST_OBJECT_LOCK (vk_download);
+      vk_download->max_in_flight = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (vk_download);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_vulkan_download_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstVulkanDownload *vk_download = GST_VULKAN_DOWNLOAD (object);
+
+  switch (prop_id) {
+    case PROP_MAX_IN_FLIGHT:
+      GST_OBJECT_LOCK (vk_download);
+      g_value_set_uint (value, vk_download->max_in_flight);
+      GST_OBJECT_UNLOCK (vk_download);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static gboolean
 gst_vulkan_download_query (GstBaseTransform * bt, GstPadDirection direction,
     GstQuery * query)
@@ -620,6 +785,49 @@ _find_graphics_queue (GstVulkanDownload * download)
   return data.queue;
 }
 
+static gboolean
+_choose_transfer_queue (GstVulkanDevice * device, GstVulkanQueue * queue,
+    struct choose_data *data)
+{
+  guint flags =
+      device->physical_device->queue_family_props[queue->family].queueFlags;
+
+  if ((flags & VK_QUEUE_TRANSFER_BIT) != 0
+      && (flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) == 0) {
+    data->queue = gst_object_ref (queue);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* Copies on a dedicated transfer queue overlap with the rendering on the
+ * graphics queue.  The queues are synchronised with timeline semaphores. */
+static GstVulkanQueue *
+_find_transfer_queue (GstVulkanDownload * download)
+{
+  struct choose_data data;
+
+#if defined (VK_KHR_timeline_semaphore)
+  if (!gst_vulkan_device_is_extension_enabled (download->device,
+          VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME))
+    return NULL;
+#else
+  return NULL;
+#endif
+
+  data.download = download;
+  data.queue = NULL;
+
+  gst_vulkan_device_foreach_queue (download->device,
+      (GstVulkanDeviceForEachQueueFunc) _choose_transfer_queue, &data);
+
+  if (data.queue && data.queue->device != download->queue->device)
+    gst_clear_object (&data.queue);
+
+  return data.queue;
+}
+
 static GstStateChangeReturn
 gst_vulkan_download_change_state (GstElement * element,
     GstStateChange transition)
@@ -667,6 +875,10 @@ gst_vulkan_download_change_state (GstElement * element,
             ("Failed to create/retrieve vulkan queue"), (NULL));
         return GST_STATE_CHANGE_FAILURE;
       }
+      vk_download->transfer_queue = _find_transfer_queue (vk_download);
+      if (vk_download->transfer_queue)
+        GST_INFO_OBJECT (vk_download, "transferring with %" GST_PTR_FORMAT,
+            vk_download->transfer_queue);
       break;
     case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
       break;
@@ -682,6 +894,9 @@ gst_vulkan_download_change_state (GstElement * element,
     case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
+      while (!g_queue_is_empty (&vk_download->in_flight))
+        gst_vulkan_fence_unref (g_queue_pop_head (&vk_download->in_flight));
+      gst_clear_object (&vk_download->transfer_queue);
       if (vk_download->queue)
         gst_object_unref (vk_download->queue);
       vk_download->queue = NULL;
@@ -0,0 +1,469 @@
+/*
+ * GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-vulkanscale
+ * @title: vulkanscale
+ *
+ * vulkanscale resizes Vulkan images using bilinear, bicubic or Lanczos
+ * filtering on the GPU.
+ *
+ * ## Example launch line
+ * |[
+ * gst-launch-1.0 videotestsrc ! vulkanupload ! vulkanscale method=lanczos ! video/x-raw(memory:VulkanImage),width=1920,height=1080 ! vulkansink
+ * ]|
+ *
+ * Since: 1.20
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "vkscale.h"
+#include "gstvulkan-plugins-enumtypes.h"
+
+#include "shaders/identity.vert.h"
+#include "shaders/scale.frag.h"
+
+GST_DEBUG_CATEGORY (gst_debug_vulkan_scale);
+#define GST_CAT_DEFAULT gst_debug_vulkan_scale
+
+/* std140 layout of the uniform block in scale.frag */
+struct ScaleUpdate
+{
+  float in_size[2];
+  float ratio[2];
+  gint method;
+};
+
+static void gst_vulkan_scale_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_vulkan_scale_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+
+static gboolean gst_vulkan_scale_start (GstBaseTransform * bt);
+static gboolean gst_vulkan_scale_stop (GstBaseTransform * bt);
+
+static GstCaps *gst_vulkan_scale_transform_caps (GstBaseTransform * bt,
+    GstPadDirection direction, GstCaps * caps, GstCaps * filter);
+static GstCaps *gst_vulkan_scale_fixate_caps (GstBaseTransform * bt,
+    GstPadDirection direction, GstCaps * caps, GstCaps * othercaps);
+static GstFlowReturn gst_vulkan_scale_transform (GstBaseTransform * bt,
+    GstBuffer * inbuf, GstBuffer * outbuf);
+static gboolean gst_vulkan_scale_set_caps (GstBaseTransform * bt,
+    GstCaps * in_caps, GstCaps * out_caps);
+
+#define IMAGE_FORMATS " { BGRA, RGBA }"
+
+static GstStaticPadTemplate gst_vulkan_sink_template =
+GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE_WITH_FEATURES
+        (GST_CAPS_FEATURE_MEMORY_VULKAN_IMAGE,
+            IMAGE_FORMATS)));
+
+static GstStaticPadTemplate gst_vulkan_src_template =
+GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE_WITH_FEATURES
+        (GST_CAPS_FEATURE_MEMORY_VULKAN_IMAGE,
+            IMAGE_FORMATS)));
+
+enum
+{
+  PROP_0,
+  PROP_METHOD,
+};
+
+#define DEFAULT_METHOD GST_VULKAN_SCALE_METHOD_BILINEAR
+
+#define gst_vulkan_scale_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstVulkanScale, gst_vulkan_scale,
+    GST_TYPE_VULKAN_VIDEO_FILTER,
+    GST_DEBUG_CATEGORY_INIT (gst_debug_vulkan_scale,
+        "vulkanscale", 0, "Vulkan Scale"));
+
+static void
+gst_vulkan_scale_class_init (GstVulkanScaleClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstElementClass *gstelement_class;
+  GstBaseTransformClass *gstbasetransform_class;
+
+  gobject_class = (GObjectClass *) klass;
+  gstelement_class = (GstElementClass *) klass;
+  gstbasetransform_class = (GstBaseTransformClass *) klass;
+
+  gobject_class->set_property = gst_vulkan_scale_set_property;
+  gobject_class->get_property = gst_vulkan_scale_get_property;
+
+  /**
+   * GstVulkanScale:method:
+   *
+   * The filter used for resampling the input image.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_METHOD,
+      g_param_spec_enum ("method", "Method",
+          "The scaling method to use",
+          GST_TYPE_VULKAN_SCALE_METHOD, DEFAULT_METHOD,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
+          G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_set_metadata (gstelement_class, "Vulkan Scale",
+      "Filter/Converter/Video/Scaler", "Resizes video using Vulkan",
+      "GStreamer developers");
+
+  gst_type_mark_as_plugin_api (GST_TYPE_VULKAN_SCALE_METHOD, 0);
+  gst_element_class_add_static_pad_template (gstelement_class,
+      &gst_vulkan_sink_template);
+  gst_element_class_add_static_pad_template (gstelement_class,
+      &gst_vulkan_src_template);
+
+  gstbasetransform_class->start = GST_DEBUG_FUNCPTR (gst_vulkan_scale_start);
+  gstbasetransform_class->stop = GST_DEBUG_FUNCPTR (gst_vulkan_scale_stop);
+  gstbasetransform_class->transform_caps = gst_vulkan_scale_transform_caps;
+  gstbasetransform_class->fixate_caps = gst_vulkan_scale_fixate_caps;
+  gstbasetransform_class->set_caps = gst_vulkan_scale_set_caps;
+  gstbasetransform_class->transform = gst_vulkan_scale_transform;
+}
+
+static void
+gst_vulkan_scale_init (GstVulkanScale * scale)
+{
+  scale->method = DEFAULT_METHOD;
+}
+
+static void
+gst_vulkan_scale_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstVulkanScale *scale = GST_VULKAN_SCALE (object);
+
+  switch (prop_id) {
+    case PROP_METHOD:
+      GST_OBJECT_LOCK (scale);
+      scale->method = g_value_get_enum (value);
+      /* regenerated with the new method on the next frame */
+      if (scale->uniform)
+        gst_memory_unref (scale->uniform);
+      scale->uniform = NULL;
+      GST_OBJECT_UNLOCK (scale);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_vulkan_scale_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstVulkanScale *scale = GST_VULKAN_SCALE (object);
+
+  switch (prop_id) {
+    case PROP_METHOD:
+      GST_OBJECT_LOCK (scale);
+      g_value_set_enum (value, scale->method);
+      GST_OBJECT_UNLOCK (scale);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static GstCaps *
+gst_vulkan_scale_transform_caps (GstBaseTransform * bt,
+    GstPadDirection direction, GstCaps * caps, GstCaps * filter)
+{
+  GstCaps *ret;
+  GstStructure *structure;
+  GstCapsFeatures *features;
+  gint i, n;
+
+  ret = gst_caps_new_empty ();
+  n = gst_caps_get_size (caps);
+  for (i = 0; i < n; i++) {
+    structure = gst_caps_get_structure (caps, i);
+    features = gst_caps_get_features (caps, i);
+
+    /* If this is already expressed by the existing caps
+     * skip this structure */
+    if (i > 0 && gst_caps_is_subset_structure_full (ret, structure, features))
+      continue;
+
+    structure = gst_structure_copy (structure);
+    gst_structure_set (structure, "width", GST_TYPE_INT_RANGE, 1, G_MAXINT,
+        "height", GST_TYPE_INT_RANGE, 1, G_MAXINT, NULL);
+
+    /* if pixel aspect ratio, make a range of it */
+    if (gst_structure_has_field (structure, "pixel-aspect-ratio")) {
+      gst_structure_set (structure, "pixel-aspect-ratio",
+          GST_TYPE_FRACTION_RANGE, 1, G_MAXINT, G_MAXINT, 1, NULL);
+    }
+
+    gst_caps_append_structure_full (ret, structure,
+        gst_caps_features_copy (features));
+  }
+
+  if (filter) {
+    GstCaps *intersection;
+
+    intersection =
+        gst_caps_intersect_full (filter, ret, GST_CAPS_INTERSECT_FIRST);
+    gst_caps_unref (ret);
+    ret = intersection;
+  }
+
+  GST_DEBUG_OBJECT (bt, "transformed %" GST_PTR_FORMAT " into %"
+      GST_PTR_FORMAT, caps, ret);
+
+  return ret;
+}
+
+static GstCaps *
+gst_vulkan_scale_fixate_caps (GstBaseTransform * bt,
+    GstPadDirection direction, GstCaps * caps, GstCaps * othercaps)
+{
+  GstStructure *ins, *outs;
+  const GValue *to_par;
+  gint from_w, from_h, from_par_n = 1, from_par_d = 1;
+  gint to_par_n, to_par_d, from_dar_n, from_dar_d;
+  gint w = 0, h = 0;
+
+  othercaps = gst_caps_truncate (othercaps);
+  othercaps = gst_caps_make_writable (othercaps);
+
+  ins = gst_caps_get_structure (caps, 0);
+  outs = gst_caps_get_structure (othercaps, 0);
+
+  if (!gst_structure_get_int (ins, "width", &from_w)
+      || !gst_structure_get_int (ins, "height", &from_h))
+    goto done;
+
+  gst_structure_get_fraction (ins, "pixel-aspect-ratio", &from_par_n,
+      &from_par_d);
+
+  /* prefer keeping the pixel aspect ratio */
+  to_par = gst_structure_get_value (outs, "pixel-aspect-ratio");
+  if (to_par && !gst_value_is_fixed (to_par))
+    gst_structure_fixate_field_nearest_fraction (outs, "pixel-aspect-ratio",
+        from_par_n, from_par_d);
+  if (!gst_structure_get_fraction (outs, "pixel-aspect-ratio", &to_par_n,
+          &to_par_d)) {
+    to_par_n = from_par_n;
+    to_par_d = from_par_d;
+  }
+
+  if (!gst_util_fraction_multiply (from_w, from_h, from_par_n, from_par_d,
+          &from_dar_n, &from_dar_d)) {
+    GST_WARNING_OBJECT (bt, "overflow calculating the display aspect ratio");
+    goto done;
+  }
+
+  gst_structure_get_int (outs, "width", &w);
+  gst_structure_get_int (outs, "height", &h);
+
+  /* calculate whatever is not fixed yet such that the display aspect ratio
+   * is kept, preferring to keep the height */
+  if (w && h) {
+    goto done;
+  } else if (w) {
+    h = (gint) gst_util_uint64_scale (w, (guint64) to_par_n * from_dar_d,
+        (guint64) to_par_d * from_dar_n);
+  } else {
+    if (!h)
+      h = from_h;
+    w = (gint) gst_util_uint64_scale (h, (guint64) to_par_d * from_dar_n,
+        (guint64) to_par_n * from_dar_d);
+  }
+
+  gst_structure_fixate_field_nearest_int (outs, "width", MAX (w, 1));
+  gst_structure_fixate_field_nearest_int (outs, "height", MAX (h, 1));
+
+done:
+  othercaps = gst_caps_fixate (othercaps);
+
+  GST_DEBUG_OBJECT (bt, "fixated othercaps to %" GST_PTR_FORMAT, othercaps);
+
+  return othercaps;
+}
+
+static gboolean
+gst_vulkan_scale_start (GstBaseTransform * bt)
+{
+  GstVulkanScale *scale = GST_VULKAN_SCALE (bt);
+  GstVulkanVideoFilter *vfilter = GST_VULKAN_VIDEO_FILTER (scale);
+  GstVulkanHandle *vert, *frag;
+  GError *error = NULL;
+
+  if (!GST_BASE_TRANSFORM_CLASS (parent_class)->start (bt))
+    return FALSE;
+
+  scale->quad = gst_vulkan_full_screen_quad_new (vfilter->queue);
+
+  if (!(vert = gst_vulkan_create_shader (vfilter->device, identity_vert,
+              identity_vert_size, &error)))
+    goto error;
+  if (!(frag = gst_vulkan_create_shader (vfilter->device, scale_frag,
+              scale_frag_size, &error))) {
+    gst_vulkan_handle_unref (vert);
+    goto error;
+  }
+  gst_vulkan_full_screen_quad_set_shaders (scale->quad, vert, frag);
+
+  gst_vulkan_handle_unref (vert);
+  gst_vulkan_handle_unref (frag);
+
+  return TRUE;
+
+error:
+  GST_ELEMENT_ERROR (bt, RESOURCE, NOT_FOUND, ("%s", error->message), (NULL));
+  g_clear_error (&error);
+  return FALSE;
+}
+
+static gboolean
+gst_vulkan_scale_stop (GstBaseTransform * bt)
+{
+  GstVulkanScale *scale = GST_VULKAN_SCALE (bt);
+
+  gst_clear_object (&scale->quad);
+  GST_OBJECT_LOCK (scale);
+  if (scale->uniform)
+    gst_memory_unref (scale->uniform);
+  scale->uniform = NULL;
+  GST_OBJECT_UNLOCK (scale);
+
+  return GST_BASE_TRANSFORM_CLASS (parent_class)->stop (bt);
+}
+
+static gboolean
+gst_vulkan_scale_set_caps (GstBaseTransform * bt, GstCaps * in_caps,
+    GstCaps * out_caps)
+{
+  GstVulkanVideoFilter *vfilter = GST_VULKAN_VIDEO_FILTER (bt);
+  GstVulkanScale *scale = GST_VULKAN_SCALE (bt);
+
+  if (!GST_BASE_TRANSFORM_CLASS (parent_class)->set_caps (bt, in_caps,
+          out_caps))
+    return FALSE;
+
+  if (!gst_vulkan_full_screen_quad_set_info (scale->quad, &vfilter->in_info,
+          &vfilter->out_info))
+    return FALSE;
+
+  GST_OBJECT_LOCK (scale);
+  if (scale->uniform)
+    gst_memory_unref (scale->uniform);
+  scale->uniform = NULL;
+  GST_OBJECT_UNLOCK (scale);
+
+  gst_base_transform_set_passthrough (bt,
+      GST_VIDEO_INFO_WIDTH (&vfilter->in_info) ==
+      GST_VIDEO_INFO_WIDTH (&vfilter->out_info)
+      && GST_VIDEO_INFO_HEIGHT (&vfilter->in_info) ==
+      GST_VIDEO_INFO_HEIGHT (&vfilter->out_info));
+
+  return TRUE;
+}
+
+/* call with the object lock held */
+static GstMemory *
+get_uniforms (GstVulkanScale * scale, GError ** error)
+{
+  GstVulkanVideoFilter *vfilter = GST_VULKAN_VIDEO_FILTER (scale);
+
+  if (!scale->uniform) {
+    struct ScaleUpdate data;
+    GstMapInfo map_info;
+
+    data.in_size[0] = GST_VIDEO_INFO_WIDTH (&vfilter->in_info);
+    data.in_size[1] = GST_VIDEO_INFO_HEIGHT (&vfilter->in_info);
+    data.ratio[0] = data.in_size[0] / GST_VIDEO_INFO_WIDTH (&vfilter->out_info);
+    data.ratio[1] =
+        data.in_size[1] / GST_VIDEO_INFO_HEIGHT (&vfilter->out_info);
+    data.method = scale->method;
+
+    scale->uniform =
+        gst_vulkan_buffer_memory_alloc (vfilter->device, sizeof (data),
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    if (!gst_memory_map (scale->uniform, &map_info, GST_MAP_WRITE)) {
+      g_set_error_literal (error, GST_VULKAN_ERROR, VK_ERROR_MEMORY_MAP_FAILED,
+          "Failed to map memory");
+      gst_memory_unref (scale->uniform);
+      scale->uniform = NULL;
+      return NULL;
+    }
+    memcpy (map_info.data, &data, sizeof (data));
+    gst_memory_unmap (scale->uniform, &map_info);
+  }
+
+  return gst_memory_ref (scale->uniform);
+}
+
+static GstFlowReturn
+gst_vulkan_scale_transform (GstBaseTransform * bt, GstBuffer * inbuf,
+    GstBuffer * outbuf)
+{
+  GstVulkanScale *scale = GST_VULKAN_SCALE (bt);
+  GstMemory *uniforms;
+  GError *error = NULL;
+
+  GST_OBJECT_LOCK (scale);
+  uniforms = get_uniforms (scale, &error);
+  GST_OBJECT_UNLOCK (scale);
+  if (!uniforms)
+    goto error;
+
+  if (!gst_vulkan_full_screen_quad_set_uniform_buffer (scale->quad, uniforms,
+          &error)) {
+    gst_memory_unref (uniforms);
+    goto error;
+  }
+  gst_memory_unref (uniforms);
+
+  if (!gst_vulkan_full_screen_quad_set_input_buffer (scale->quad, inbuf,
+          &error))
+    goto error;
+  if (!gst_vulkan_full_screen_quad_set_output_buffer (scale->quad, outbuf,
+          &error))
+    goto error;
+
+  if (!gst_vulkan_full_screen_quad_draw (scale->quad, &error))
+    goto error;
+
+  return GST_FLOW_OK;
+
+error:
+  GST_ELEMENT_ERROR (bt, LIBRARY, FAILED, ("%s", error->message), (NULL));
+  g_clear_error (&error);
+  return GST_FLOW_ERROR;
+}
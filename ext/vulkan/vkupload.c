@@ -23,6 +23,9 @@
  * @title: vulkanupload
  *
  * vulkanupload uploads data into Vulkan memory objects.
+ *
+ * On Linux, dmabuf backed buffers are imported as Vulkan images without a
+ * copy when the device supports VK_EXT_external_memory_dma_buf.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -33,9 +36,99 @@
 
 #include "vkupload.h"
 
+#if defined (G_OS_UNIX) && defined (VK_KHR_external_memory_fd) && \
+    defined (VK_EXT_external_memory_dma_buf)
+#define HAVE_VULKAN_DMABUF 1
+#include <errno.h>
+#include <unistd.h>
+#include <gst/allocators/allocators.h>
+#else
+#define HAVE_VULKAN_DMABUF 0
+#endif
+
 GST_DEBUG_CATEGORY (gst_debug_vulkan_upload);
 #define GST_CAT_DEFAULT gst_debug_vulkan_upload
 
+#define DEFAULT_MAX_IN_FLIGHT 2
+
+#define TRANSFER_STAGES (VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT | \
+    VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_HOST_BIT)
+#define TRANSFER_ACCESS (VK_ACCESS_TRANSFER_READ_BIT | \
+    VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_READ_BIT | \
+    VK_ACCESS_HOST_WRITE_BIT)
+
+static GstVulkanQueue *
+_get_transfer_queue (GstVulkanUpload * upload)
+{
+  return upload->transfer_queue ? upload->transfer_queue : upload->queue;
+}
+
+/* A transfer only queue cannot reference the stages of previous graphics
+ * accesses.  Those are ordered by the semaphores between the queues
+ * instead. */
+static void
+_transfer_src_barrier (GstVulkanUpload * upload, VkPipelineStageFlags * stages,
+    VkAccessFlags * access)
+{
+  if (!upload->transfer_queue)
+    return;
+
+  *stages &= TRANSFER_STAGES;
+  if (*stages == 0)
+    *stages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+  *access &= TRANSFER_ACCESS;
+}
+
+/* bounds the number of transfers not yet completed by the GPU */
+static void
+_track_in_flight (GstVulkanUpload * upload, GstVulkanFence * fence)
+{
+  GstVulkanFence *oldest;
+  guint max_in_flight;
+
+  GST_OBJECT_LOCK (upload);
+  max_in_flight = upload->max_in_flight;
+  GST_OBJECT_UNLOCK (upload);
+
+  g_queue_push_tail (&upload->in_flight, gst_vulkan_fence_ref (fence));
+
+  while ((oldest = g_queue_peek_head (&upload->in_flight))) {
+    if (max_in_flight > 0
+        && g_queue_get_length (&upload->in_flight) > max_in_flight) {
+      GST_TRACE_OBJECT (upload, "waiting for transfer fence %p", oldest);
+      if (!gst_vulkan_fence_wait (oldest, G_MAXUINT64))
+        GST_WARNING_OBJECT (upload, "Failed to wait for a transfer");
+    } else if (!gst_vulkan_fence_is_signaled (oldest)) {
+      break;
+    }
+
+    g_queue_pop_head (&upload->in_flight);
+    gst_vulkan_fence_unref (oldest);
+  }
+}
+
+/* everything using the uploaded images is submitted to the graphics queue */
+static gboolean
+_submit_transfer (GstVulkanUpload * upload, VkSubmitInfo * submit_info,
+    GstVulkanFence * fence, GError ** error)
+{
+  GstVulkanQueue *queue = _get_transfer_queue (upload);
+
+  if (!gst_vulkan_queue_submit (queue, submit_info, fence, error))
+    return FALSE;
+
+  if (upload->transfer_queue && !gst_vulkan_queue_add_dependency (upload->queue,
+          upload->transfer_queue, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT)) {
+    g_set_error_literal (error, GST_VULKAN_ERROR, VK_ERROR_FEATURE_NOT_PRESENT,
+        "Failed to synchronise the graphics queue with the transfer queue");
+    return FALSE;
+  }
+
+  _track_in_flight (upload, fence);
+
+  return TRUE;
+}
+
 static GstCaps *
 _set_caps_features_with_passthrough (const GstCaps * caps,
     const gchar * feature_name, GstCapsFeatures * passthrough)
@@ -444,8 +537,8 @@ _buffer_to_image_perform (gpointer impl, GstBuffer * inbuf, GstBuffer ** outbuf)
 
   if (!raw->cmd_pool) {
     if (!(raw->cmd_pool =
-            gst_vulkan_queue_create_command_pool (raw->upload->queue,
-                &error))) {
+            gst_vulkan_queue_create_command_pool (_get_transfer_queue
+                (raw->upload), &error))) {
       goto error;
     }
   }
@@ -497,6 +590,7 @@ _buffer_to_image_perform (gpointer impl, GstBuffer * inbuf, GstBuffer ** outbuf)
     GstVulkanImageMemory *img_mem;
     VkImageMemoryBarrier image_memory_barrier;
     VkBufferMemoryBarrier buffer_memory_barrier;
+    VkPipelineStageFlags src_stages;
 
     in_mem = gst_buffer_peek_memory (inbuf, i);
     if (!gst_is_vulkan_buffer_memory (in_mem)) {
@@ -559,10 +653,16 @@ _buffer_to_image_perform (gpointer impl, GstBuffer * inbuf, GstBuffer ** outbuf)
     };
     /* *INDENT-ON* */
 
-    vkCmdPipelineBarrier (cmd_buf->cmd,
-        buf_mem->barrier.parent.pipeline_stages | img_mem->barrier.
-        parent.pipeline_stages, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 1,
-        &buffer_memory_barrier, 1, &image_memory_barrier);
+    src_stages = buf_mem->barrier.parent.pipeline_stages |
+        img_mem->barrier.parent.pipeline_stages;
+    _transfer_src_barrier (raw->upload, &src_stages,
+        &buffer_memory_barrier.srcAccessMask);
+    _transfer_src_barrier (raw->upload, &src_stages,
+        &image_memory_barrier.srcAccessMask);
+
+    vkCmdPipelineBarrier (cmd_buf->cmd, src_stages,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 1, &buffer_memory_barrier,
+        1, &image_memory_barrier);
 
     buf_mem->barrier.parent.pipeline_stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
     buf_mem->barrier.parent.access_flags = buffer_memory_barrier.dstAccessMask;
@@ -599,15 +699,15 @@ _buffer_to_image_perform (gpointer impl, GstBuffer * inbuf, GstBuffer ** outbuf)
     };
     /* *INDENT-ON* */
 
-    fence = gst_vulkan_device_create_fence (raw->upload->device, &error);
+    fence = gst_vulkan_queue_create_fence (_get_transfer_queue (raw->upload),
+        &error);
     if (!fence)
       goto error;
 
-    err =
-        vkQueueSubmit (raw->upload->queue->queue, 1, &submit_info,
-        GST_VULKAN_FENCE_FENCE (fence));
-    if (gst_vulkan_error_to_g_error (err, &error, "vkQueueSubmit") < 0)
+    if (!_submit_transfer (raw->upload, &submit_info, fence, &error)) {
+      gst_vulkan_fence_unref (fence);
       goto error;
+    }
 
     gst_vulkan_trash_list_add (raw->trash_list,
         gst_vulkan_trash_list_acquire (raw->trash_list, fence,
@@ -773,8 +873,8 @@ _raw_to_image_perform (gpointer impl, GstBuffer * inbuf, GstBuffer ** outbuf)
 
   if (!raw->cmd_pool) {
     if (!(raw->cmd_pool =
-            gst_vulkan_queue_create_command_pool (raw->upload->queue,
-                &error))) {
+            gst_vulkan_queue_create_command_pool (_get_transfer_queue
+                (raw->upload), &error))) {
       goto error;
     }
   }
@@ -826,6 +926,7 @@ _raw_to_image_perform (gpointer impl, GstBuffer * inbuf, GstBuffer ** outbuf)
     GstVulkanImageMemory *img_mem;
     VkImageMemoryBarrier image_memory_barrier;
     VkBufferMemoryBarrier buffer_memory_barrier;
+    VkPipelineStageFlags src_stages;
 
     in_mem = gst_buffer_peek_memory (inbuf, i);
     if (gst_is_vulkan_buffer_memory (in_mem)) {
@@ -944,10 +1045,16 @@ _raw_to_image_perform (gpointer impl, GstBuffer * inbuf, GstBuffer ** outbuf)
     };
     /* *INDENT-ON* */
 
-    vkCmdPipelineBarrier (cmd_buf->cmd,
-        buf_mem->barrier.parent.pipeline_stages | img_mem->barrier.
-        parent.pipeline_stages, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 1,
-        &buffer_memory_barrier, 1, &image_memory_barrier);
+    src_stages = buf_mem->barrier.parent.pipeline_stages |
+        img_mem->barrier.parent.pipeline_stages;
+    _transfer_src_barrier (raw->upload, &src_stages,
+        &buffer_memory_barrier.srcAccessMask);
+    _transfer_src_barrier (raw->upload, &src_stages,
+        &image_memory_barrier.srcAccessMask);
+
+    vkCmdPipelineBarrier (cmd_buf->cmd, src_stages,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 1, &buffer_memory_barrier,
+        1, &image_memory_barrier);
 
     buf_mem->barrier.parent.pipeline_stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
     buf_mem->barrier.parent.access_flags = buffer_memory_barrier.dstAccessMask;
@@ -984,17 +1091,15 @@ _raw_to_image_perform (gpointer impl, GstBuffer * inbuf, GstBuffer ** outbuf)
     };
     /* *INDENT-ON* */
 
-    fence = gst_vulkan_device_create_fence (raw->upload->device, &error);
+    fence = gst_vulkan_queue_create_fence (_get_transfer_queue (raw->upload),
+        &error);
     if (!fence)
       goto error;
 
-    gst_vulkan_queue_submit_lock (raw->upload->queue);
-    err =
-        vkQueueSubmit (raw->upload->queue->queue, 1, &submit_info,
-        GST_VULKAN_FENCE_FENCE (fence));
-    gst_vulkan_queue_submit_unlock (raw->upload->queue);
-    if (gst_vulkan_error_to_g_error (err, &error, "vkQueueSubmit") < 0)
+    if (!_submit_transfer (raw->upload, &submit_info, fence, &error)) {
+      gst_vulkan_fence_unref (fence);
       goto error;
+    }
 
     gst_vulkan_trash_list_add (raw->trash_list,
         gst_vulkan_trash_list_acquire (raw->trash_list, fence,
@@ -1080,8 +1185,393 @@ static const struct UploadMethod raw_to_image_upload = {
   _raw_to_image_free,
 };
 
+#if HAVE_VULKAN_DMABUF
+struct DmabufToImageUpload
+{
+  GstVulkanUpload *upload;
+
+  GstVideoInfo in_info;
+  GstVideoInfo out_info;
+
+  PFN_vkGetMemoryFdPropertiesKHR get_memory_fd_properties;
+  gboolean have_modifiers;
+};
+
+struct DmabufImage
+{
+  GstVulkanDevice *device;
+  VkImage image;
+  VkDeviceMemory memory;
+  /* keeps the dmabuf alive as long as the image may be used */
+  GstBuffer *buffer;
+};
+
+static void
+_dmabuf_image_free (struct DmabufImage *img)
+{
+  if (img->image)
+    vkDestroyImage (img->device->device, img->image, NULL);
+  if (img->memory)
+    vkFreeMemory (img->device->device, img->memory, NULL);
+  gst_clear_buffer (&img->buffer);
+  gst_object_unref (img->device);
+
+  g_free (img);
+}
+
+static gpointer
+_dmabuf_to_image_new_impl (GstVulkanUpload * upload)
+{
+  struct DmabufToImageUpload *raw = g_new0 (struct DmabufToImageUpload, 1);
+
+  raw->upload = upload;
+
+  return raw;
+}
+
+static GstCaps *
+_dmabuf_to_image_transform_caps (gpointer impl, GstPadDirection direction,
+    GstCaps * caps)
+{
+  struct DmabufToImageUpload *raw = impl;
+  GstVulkanDevice *device = raw->upload->device;
+  GstCaps *ret;
+
+  if (direction == GST_PAD_SINK) {
+    ret =
+        _set_caps_features_with_passthrough (caps,
+        GST_CAPS_FEATURE_MEMORY_VULKAN_IMAGE, NULL);
+  } else {
+    /* don't advertise dmabufs that can never be imported */
+    if (device && !gst_vulkan_device_is_extension_enabled (device,
+            VK_EXT_EXTERNAL_MEMORY_DMA_BUF_EXTENSION_NAME))
+      return NULL;
+
+    ret =
+        _set_caps_features_with_passthrough (caps,
+        GST_CAPS_FEATURE_MEMORY_DMABUF, NULL);
+  }
+
+  return ret;
+}
+
+static gboolean
+_dmabuf_to_image_set_caps (gpointer impl, GstCaps * in_caps, GstCaps * out_caps)
+{
+  struct DmabufToImageUpload *raw = impl;
+  GstVulkanDevice *device = raw->upload->device;
+
+  if (!gst_video_info_from_caps (&raw->in_info, in_caps))
+    return FALSE;
+
+  if (!gst_video_info_from_caps (&raw->out_info, out_caps))
+    return FALSE;
+
+  if (!gst_vulkan_device_is_extension_enabled (device,
+          VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME)
+      || !gst_vulkan_device_is_extension_enabled (device,
+          VK_EXT_EXTERNAL_MEMORY_DMA_BUF_EXTENSION_NAME)) {
+    GST_DEBUG_OBJECT (raw->upload, "device cannot import dmabufs");
+    return FALSE;
+  }
+
+  raw->get_memory_fd_properties =
+      gst_vulkan_device_get_proc_address (device, "vkGetMemoryFdPropertiesKHR");
+  if (!raw->get_memory_fd_properties) {
+    GST_WARNING_OBJECT (raw->upload,
+        "Failed to retrieve vkGetMemoryFdPropertiesKHR");
+    return FALSE;
+  }
+
+#if defined (VK_EXT_image_drm_format_modifier)
+  raw->have_modifiers = gst_vulkan_device_is_extension_enabled (device,
+      VK_EXT_IMAGE_DRM_FORMAT_MODIFIER_EXTENSION_NAME);
+#endif
+
+  return TRUE;
+}
+
+static void
+_dmabuf_to_image_propose_allocation (gpointer impl, GstQuery * decide_query,
+    GstQuery * query)
+{
+  /* the strides and offsets of the producer are used as is */
+  gst_query_add_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
+}
+
+/* Imports one plane of @inbuf into a VkImage.  The caps do not carry a
+ * DRM format modifier so the dmabuf is assumed to be linear. */
+static GstMemory *
+_dmabuf_import_plane (struct DmabufToImageUpload *raw, GstBuffer * inbuf,
+    guint plane, GError ** error)
+{
+  GstVulkanDevice *device = raw->upload->device;
+  VkMemoryFdPropertiesKHR fd_props = { 0, };
+  VkExternalMemoryImageCreateInfo ext_info;
+  VkImportMemoryFdInfoKHR import_info;
+  VkMemoryAllocateInfo alloc_info;
+  VkMemoryRequirements requirements;
+  VkImageCreateInfo image_info;
+  VkImageTiling tiling = VK_IMAGE_TILING_LINEAR;
+  VkDeviceSize bind_offset = 0;
+#if defined (VK_EXT_image_drm_format_modifier)
+  VkImageDrmFormatModifierExplicitCreateInfoEXT modifier_info;
+  VkSubresourceLayout plane_layout;
+#endif
+  struct DmabufImage *img;
+  GstVideoMeta *meta;
+  VkFormat vk_format;
+  GstMemory *mem;
+  guint mem_idx, length;
+  gsize offset, skip;
+  gint stride, fd;
+  guint32 type_idx;
+  VkResult err;
+
+  meta = gst_buffer_get_video_meta (inbuf);
+  if (meta) {
+    offset = meta->offset[plane];
+    stride = meta->stride[plane];
+  } else {
+    offset = GST_VIDEO_INFO_PLANE_OFFSET (&raw->in_info, plane);
+    stride = GST_VIDEO_INFO_PLANE_STRIDE (&raw->in_info, plane);
+  }
+
+  if (!gst_buffer_find_memory (inbuf, offset, 1, &mem_idx, &length, &skip)) {
+    g_set_error (error, GST_VULKAN_ERROR, VK_ERROR_FORMAT_NOT_SUPPORTED,
+        "Could not find the memory of plane %u", plane);
+    return NULL;
+  }
+
+  mem = gst_buffer_peek_memory (inbuf, mem_idx);
+  if (!gst_is_dmabuf_memory (mem)) {
+    g_set_error_literal (error, GST_VULKAN_ERROR, VK_ERROR_FORMAT_NOT_SUPPORTED,
+        "Input memory is not a dmabuf");
+    return NULL;
+  }
+  offset = mem->offset + skip;
+
+  vk_format = gst_vulkan_format_from_video_info (&raw->out_info, plane);
+
+  img = g_new0 (struct DmabufImage, 1);
+  img->device = gst_object_ref (device);
+  img->buffer = gst_buffer_ref (inbuf);
+
+  /* *INDENT-OFF* */
+  ext_info = (VkExternalMemoryImageCreateInfo) {
+      .sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO,
+      .pNext = NULL,
+      .handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT,
+  };
+  /* *INDENT-ON* */
+
+#if defined (VK_EXT_image_drm_format_modifier)
+  if (raw->have_modifiers) {
+    /* the layout of the producer is passed explicitly */
+    /* *INDENT-OFF* */
+    plane_layout = (VkSubresourceLayout) {
+        .offset = offset,
+        .size = 0,
+        .rowPitch = stride,
+        .arrayPitch = 0,
+        .depthPitch = 0,
+    };
+    modifier_info = (VkImageDrmFormatModifierExplicitCreateInfoEXT) {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_DRM_FORMAT_MODIFIER_EXPLICIT_CREATE_INFO_EXT,
+        .pNext = NULL,
+        .drmFormatModifier = 0 /* DRM_FORMAT_MOD_LINEAR */,
+        .drmFormatModifierPlaneCount = 1,
+        .pPlaneLayouts = &plane_layout,
+    };
+    /* *INDENT-ON* */
+    ext_info.pNext = &modifier_info;
+    tiling = VK_IMAGE_TILING_DRM_FORMAT_MODIFIER_EXT;
+  } else
+#endif
+  {
+    bind_offset = offset;
+  }
+
+  /* *INDENT-OFF* */
+  image_info = (VkImageCreateInfo) {
+      .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+      .pNext = &ext_info,
+      .flags = 0,
+      .imageType = VK_IMAGE_TYPE_2D,
+      .format = vk_format,
+      .extent = (VkExtent3D) {
+          GST_VIDEO_INFO_COMP_WIDTH (&raw->out_info, plane),
+          GST_VIDEO_INFO_COMP_HEIGHT (&raw->out_info, plane),
+          1
+      },
+      .mipLevels = 1,
+      .arrayLayers = 1,
+      .samples = VK_SAMPLE_COUNT_1_BIT,
+      .tiling = tiling,
+      .usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+      .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+      .queueFamilyIndexCount = 0,
+      .pQueueFamilyIndices = NULL,
+      /* the contents written by the producer are kept by the first
+       * layout transition */
+      .initialLayout = VK_IMAGE_LAYOUT_PREINITIALIZED,
+  };
+  /* *INDENT-ON* */
+
+  err = vkCreateImage (device->device, &image_info, NULL, &img->image);
+  if (gst_vulkan_error_to_g_error (err, error, "vkCreateImage") < 0)
+    goto error;
+
+  if (tiling == VK_IMAGE_TILING_LINEAR) {
+    VkImageSubresource subresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0 };
+    VkSubresourceLayout layout;
+
+    vkGetImageSubresourceLayout (device->device, img->image, &subresource,
+        &layout);
+    if (layout.offset != 0 || layout.rowPitch != stride) {
+      g_set_error (error, GST_VULKAN_ERROR, VK_ERROR_FORMAT_NOT_SUPPORTED,
+          "Plane %u stride %i does not match the linear image row pitch %"
+          G_GUINT64_FORMAT, plane, stride, (guint64) layout.rowPitch);
+      goto error;
+    }
+  }
+
+  vkGetImageMemoryRequirements (device->device, img->image, &requirements);
+  if (bind_offset % requirements.alignment != 0) {
+    g_set_error (error, GST_VULKAN_ERROR, VK_ERROR_FORMAT_NOT_SUPPORTED,
+        "Plane %u offset %" G_GSIZE_FORMAT " is not suitably aligned", plane,
+        offset);
+    goto error;
+  }
+
+  /* the import takes ownership of the fd */
+  fd = dup (gst_dmabuf_memory_get_fd (mem));
+  if (fd < 0) {
+    g_set_error (error, GST_VULKAN_ERROR, VK_ERROR_INVALID_EXTERNAL_HANDLE,
+        "Failed to duplicate the dmabuf fd: %s", g_strerror (errno));
+    goto error;
+  }
+
+  fd_props.sType = VK_STRUCTURE_TYPE_MEMORY_FD_PROPERTIES_KHR;
+  err = raw->get_memory_fd_properties (device->device,
+      VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT, fd, &fd_props);
+  if (gst_vulkan_error_to_g_error (err, error, "vkGetMemoryFdPropertiesKHR") < 0) {
+    close (fd);
+    goto error;
+  }
+
+  if (!gst_vulkan_memory_find_memory_type_index_with_type_properties (device,
+          requirements.memoryTypeBits & fd_props.memoryTypeBits, 0,
+          &type_idx)) {
+    g_set_error_literal (error, GST_VULKAN_ERROR, VK_ERROR_FORMAT_NOT_SUPPORTED,
+        "No memory type to import the dmabuf into");
+    close (fd);
+    goto error;
+  }
+
+  /* *INDENT-OFF* */
+  import_info = (VkImportMemoryFdInfoKHR) {
+      .sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_FD_INFO_KHR,
+      .pNext = NULL,
+      .handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT,
+      .fd = fd,
+  };
+  alloc_info = (VkMemoryAllocateInfo) {
+      .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+      .pNext = &import_info,
+      .allocationSize = MAX (mem->offset + mem->maxsize,
+          bind_offset + requirements.size),
+      .memoryTypeIndex = type_idx,
+  };
+  /* *INDENT-ON* */
+
+  err = vkAllocateMemory (device->device, &alloc_info, NULL, &img->memory);
+  if (gst_vulkan_error_to_g_error (err, error, "vkAllocateMemory") < 0) {
+    close (fd);
+    goto error;
+  }
+
+  err = vkBindImageMemory (device->device, img->image, img->memory,
+      bind_offset);
+  if (gst_vulkan_error_to_g_error (err, error, "vkBindImageMemory") < 0)
+    goto error;
+
+  mem = gst_vulkan_image_memory_wrapped (device, img->image, vk_format,
+      GST_VIDEO_INFO_COMP_WIDTH (&raw->out_info, plane),
+      GST_VIDEO_INFO_COMP_HEIGHT (&raw->out_info, plane), tiling,
+      image_info.usage, img, (GDestroyNotify) _dmabuf_image_free);
+  if (!mem) {
+    /* @img has already been freed through the destroy notify */
+    g_set_error_literal (error, GST_VULKAN_ERROR, VK_ERROR_FORMAT_NOT_SUPPORTED,
+        "Failed to wrap the imported image");
+    return NULL;
+  }
+  ((GstVulkanImageMemory *) mem)->barrier.image_layout =
+      VK_IMAGE_LAYOUT_PREINITIALIZED;
+
+  return mem;
+
+error:
+  _dmabuf_image_free (img);
+  return NULL;
+}
+
+static GstFlowReturn
+_dmabuf_to_image_perform (gpointer impl, GstBuffer * inbuf, GstBuffer ** outbuf)
+{
+  struct DmabufToImageUpload *raw = impl;
+  GError *error = NULL;
+  guint i;
+
+  *outbuf = gst_buffer_new ();
+
+  for (i = 0; i < GST_VIDEO_INFO_N_PLANES (&raw->out_info); i++) {
+    GstMemory *mem;
+
+    if (!(mem = _dmabuf_import_plane (raw, inbuf, i, &error))) {
+      GST_WARNING_OBJECT (raw->upload, "Failed to import dmabuf: %s",
+          error->message);
+      g_clear_error (&error);
+      gst_buffer_unref (*outbuf);
+      *outbuf = NULL;
+      return GST_FLOW_ERROR;
+    }
+
+    gst_buffer_append_memory (*outbuf, mem);
+  }
+
+  return GST_FLOW_OK;
+}
+
+static void
+_dmabuf_to_image_free (gpointer impl)
+{
+  g_free (impl);
+}
+
+static GstStaticCaps _dmabuf_to_image_in_templ =
+GST_STATIC_CAPS ("video/x-raw(" GST_CAPS_FEATURE_MEMORY_DMABUF ")");
+static GstStaticCaps _dmabuf_to_image_out_templ =
+GST_STATIC_CAPS ("video/x-raw(" GST_CAPS_FEATURE_MEMORY_VULKAN_IMAGE ")");
+
+static const struct UploadMethod dmabuf_to_image_upload = {
+  "DmabufToVulkanImage",
+  &_dmabuf_to_image_in_templ,
+  &_dmabuf_to_image_out_templ,
+  _dmabuf_to_image_new_impl,
+  _dmabuf_to_image_transform_caps,
+  _dmabuf_to_image_set_caps,
+  _dmabuf_to_image_propose_allocation,
+  _dmabuf_to_image_perform,
+  _dmabuf_to_image_free,
+};
+#endif
+
 static const struct UploadMethod *upload_methods[] = {
   &buffer_upload,
+#if HAVE_VULKAN_DMABUF
+  &dmabuf_to_image_upload,
+#endif
   &raw_to_buffer_upload,
   &raw_to_image_upload,
   &buffer_to_image_upload,
@@ -1150,6 +1640,7 @@ static GstFlowReturn gst_vulkan_upload_prepare_output_buffer (GstBaseTransform *
 enum
 {
   PROP_0,
+  PROP_MAX_IN_FLIGHT,
 };
 
 enum
@@ -1179,6 +1670,21 @@ gst_vulkan_upload_class_init (GstVulkanUploadClass * klass)
   gobject_class->set_property = gst_vulkan_upload_set_property;
   gobject_class->get_property = gst_vulkan_upload_get_property;
 
+  /**
+   * GstVulkanUpload:max-in-flight:
+   *
+   * The maximum number of transfers submitted to the GPU that have not
+   * completed yet before waiting for the oldest one.  Transfers use a
+   * dedicated transfer queue when the device has one.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_IN_FLIGHT,
+      g_param_spec_uint ("max-in-flight", "Maximum in flight",
+          "Maximum number of uncompleted transfers (0 = unlimited)", 0,
+          G_MAXUINT, DEFAULT_MAX_IN_FLIGHT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_metadata (gstelement_class, "Vulkan Uploader",
       "Filter/Video", "A Vulkan data uploader",
       "Matthew Waters <matthew@centricular.com>");
@@ -1218,6 +1724,9 @@ gst_vulkan_upload_init (GstVulkanUpload * vk_upload)
 {
   guint i, n;
 
+  vk_upload->max_in_flight = DEFAULT_MAX_IN_FLIGHT;
+  g_queue_init (&vk_upload->in_flight);
+
   n = G_N_ELEMENTS (upload_methods);
   vk_upload->upload_impls = g_malloc (sizeof (gpointer) * n);
   for (i = 0; i < n; i++) {
@@ -1247,9 +1756,14 @@ static void
 gst_vulkan_upload_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
 {
-//  GstVulkanUpload *vk_upload = GST_VULKAN_UPLOAD (object);
+  GstVulkanUpload *vk_upload = GST_VULKAN_UPLOAD (object);
 
   switch (prop_id) {
+    case PROP_MAX_IN_FLIGHT:
+      GST_OBJECT_LOCK (vk_upload);
+      vk_upload->max_in_flight = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (vk_upload);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1260,9 +1774,14 @@ static void
 gst_vulkan_upload_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
 {
-//  GstVulkanUpload *vk_upload = GST_VULKAN_UPLOAD (object);
+  GstVulkanUpload *vk_upload = GST_VULKAN_UPLOAD (object);
 
   switch (prop_id) {
+    case PROP_MAX_IN_FLIGHT:
+      GST_OBJECT_LOCK (vk_upload);
+      g_value_set_uint (value, vk_upload->max_in_flight);
+      GST_OBJECT_UNLOCK (vk_upload);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1341,6 +1860,49 @@ _find_graphics_queue (GstVulkanUpload * upload)
   return data.queue;
 }
 
+static gboolean
+_choose_transfer_queue (GstVulkanDevice * device, GstVulkanQueue * queue,
+    struct choose_data *data)
+{
+  guint flags =
+      device->physical_device->queue_family_props[queue->family].queueFlags;
+
+  if ((flags & VK_QUEUE_TRANSFER_BIT) != 0
+      && (flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) == 0) {
+    data->queue = gst_object_ref (queue);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* Copies on a dedicated transfer queue overlap with the rendering on the
+ * graphics queue.  The queues are synchronised with timeline semaphores. */
+static GstVulkanQueue *
+_find_transfer_queue (GstVulkanUpload * upload)
+{
+  struct choose_data data;
+
+#if defined (VK_KHR_timeline_semaphore)
+  if (!gst_vulkan_device_is_extension_enabled (upload->device,
+          VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME))
+    return NULL;
+#else
+  return NULL;
+#endif
+
+  data.upload = upload;
+  data.queue = NULL;
+
+  gst_vulkan_device_foreach_queue (upload->device,
+      (GstVulkanDeviceForEachQueueFunc) _choose_transfer_queue, &data);
+
+  if (data.queue && data.queue->device != upload->queue->device)
+    gst_clear_object (&data.queue);
+
+  return data.queue;
+}
+
 static GstStateChangeReturn
 gst_vulkan_upload_change_state (GstElement * element, GstStateChange transition)
 {
@@ -1385,6 +1947,10 @@ gst_vulkan_upload_change_state (GstElement * element, GstStateChange transition)
             ("Failed to create/retrieve vulkan queue"), (NULL));
         return GST_STATE_CHANGE_FAILURE;
       }
+      vk_upload->transfer_queue = _find_transfer_queue (vk_upload);
+      if (vk_upload->transfer_queue)
+        GST_INFO_OBJECT (vk_upload, "transferring with %" GST_PTR_FORMAT,
+            vk_upload->transfer_queue);
       break;
     case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
       break;
@@ -1400,6 +1966,9 @@ gst_vulkan_upload_change_state (GstElement * element, GstStateChange transition)
     case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
+      while (!g_queue_is_empty (&vk_upload->in_flight))
+        gst_vulkan_fence_unref (g_queue_pop_head (&vk_upload->in_flight));
+      gst_clear_object (&vk_upload->transfer_queue);
       if (vk_upload->queue)
         gst_object_unref (vk_upload->queue);
       vk_upload->queue = NULL;
@@ -66,6 +66,12 @@ struct _GstVulkanUpload
   GstVulkanInstance     *instance;
   GstVulkanDevice       *device;
   GstVulkanQueue        *queue;
+  /* dedicated transfer queue, NULL when transferring on @queue */
+  GstVulkanQueue        *transfer_queue;
+
+  /* GstVulkanFence of each transfer not known to be complete */
+  GQueue                in_flight;
+  guint                 max_in_flight;
 
   GstCaps               *in_caps;
   GstCaps               *out_caps;
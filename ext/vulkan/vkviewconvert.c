@@ -1918,7 +1918,7 @@ gst_vulkan_view_convert_transform (GstBaseTransform * bt, GstBuffer * inbuf,
           &error))
     goto error;
 
-  fence = gst_vulkan_device_create_fence (vfilter->device, &error);
+  fence = gst_vulkan_queue_create_fence (vfilter->queue, &error);
   if (!fence)
     goto error;
 
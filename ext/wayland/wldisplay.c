@@ -27,6 +27,8 @@
 #include "wlvideoformat.h"
 
 #include <errno.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 GST_DEBUG_CATEGORY_EXTERN (gstwayland_debug);
 #define GST_CAT_DEFAULT gstwayland_debug
@@ -47,6 +49,12 @@ gst_wl_display_init (GstWlDisplay * self)
 {
   self->shm_formats = g_array_new (FALSE, FALSE, sizeof (uint32_t));
   self->dmabuf_formats = g_array_new (FALSE, FALSE, sizeof (uint32_t));
+  self->dmabuf_modifiers =
+      g_array_new (FALSE, FALSE, sizeof (GstWlDmabufModifier));
+  self->dmabuf_scanout_formats = g_array_new (FALSE, FALSE, sizeof (uint32_t));
+#ifdef ZWP_LINUX_DMABUF_V1_GET_DEFAULT_FEEDBACK_SINCE_VERSION
+  self->tranche_indices = g_array_new (FALSE, FALSE, sizeof (uint16_t));
+#endif
   self->wl_fd_poll = gst_poll_new (TRUE);
   self->buffers = g_hash_table_new (g_direct_hash, g_direct_equal);
   g_mutex_init (&self->buffers_mutex);
@@ -80,6 +88,13 @@ gst_wl_display_finalize (GObject * gobject)
 
   g_array_unref (self->shm_formats);
   g_array_unref (self->dmabuf_formats);
+  g_array_unref (self->dmabuf_modifiers);
+  g_array_unref (self->dmabuf_scanout_formats);
+#ifdef ZWP_LINUX_DMABUF_V1_GET_DEFAULT_FEEDBACK_SINCE_VERSION
+  g_array_unref (self->tranche_indices);
+  if (self->format_table)
+    munmap (self->format_table, self->format_table_size);
+#endif
   gst_poll_free (self->wl_fd_poll);
   g_hash_table_unref (self->buffers);
   g_mutex_clear (&self->buffers_mutex);
@@ -90,6 +105,11 @@ gst_wl_display_finalize (GObject * gobject)
   if (self->shm)
     wl_shm_destroy (self->shm);
 
+#ifdef ZWP_LINUX_DMABUF_V1_GET_DEFAULT_FEEDBACK_SINCE_VERSION
+  if (self->dmabuf_feedback)
+    zwp_linux_dmabuf_feedback_v1_destroy (self->dmabuf_feedback);
+#endif
+
   if (self->dmabuf)
     zwp_linux_dmabuf_v1_destroy (self->dmabuf);
 
@@ -137,19 +157,223 @@ static const struct wl_shm_listener shm_listener = {
   shm_format
 };
 
+static gboolean
+array_contains_format (GArray * formats, uint32_t format)
+{
+  guint i;
+
+  for (i = 0; i < formats->len; i++) {
+    if (g_array_index (formats, uint32_t, i) == format)
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+static void
+add_dmabuf_format (GstWlDisplay * self, uint32_t format, gboolean scanout)
+{
+  if (gst_wl_dmabuf_format_to_video_format (format) == GST_VIDEO_FORMAT_UNKNOWN)
+    return;
+
+  if (!array_contains_format (self->dmabuf_formats, format))
+    g_array_append_val (self->dmabuf_formats, format);
+
+  if (scanout && !array_contains_format (self->dmabuf_scanout_formats, format))
+    g_array_append_val (self->dmabuf_scanout_formats, format);
+}
+
+static void
+add_dmabuf_modifier (GstWlDisplay * self, uint32_t format, guint64 modifier,
+    gboolean scanout)
+{
+  GstWlDmabufModifier entry = { format, modifier };
+  guint i;
+
+  if (gst_wl_dmabuf_format_to_video_format (format) == GST_VIDEO_FORMAT_UNKNOWN)
+    return;
+
+  add_dmabuf_format (self, format, scanout);
+
+  for (i = 0; i < self->dmabuf_modifiers->len; i++) {
+    GstWlDmabufModifier *m =
+        &g_array_index (self->dmabuf_modifiers, GstWlDmabufModifier, i);
+
+    if (m->format == format && m->modifier == modifier)
+      return;
+  }
+
+  g_array_append_val (self->dmabuf_modifiers, entry);
+}
+
 static void
 dmabuf_format (void *data, struct zwp_linux_dmabuf_v1 *zwp_linux_dmabuf,
     uint32_t format)
 {
   GstWlDisplay *self = data;
 
-  if (gst_wl_dmabuf_format_to_video_format (format) != GST_VIDEO_FORMAT_UNKNOWN)
-    g_array_append_val (self->dmabuf_formats, format);
+  add_dmabuf_format (self, format, FALSE);
+}
+
+static void
+dmabuf_modifier (void *data, struct zwp_linux_dmabuf_v1 *zwp_linux_dmabuf,
+    uint32_t format, uint32_t modifier_hi, uint32_t modifier_lo)
+{
+  GstWlDisplay *self = data;
+
+  add_dmabuf_modifier (self, format,
+      ((guint64) modifier_hi << 32) | modifier_lo, FALSE);
 }
 
 static const struct zwp_linux_dmabuf_v1_listener dmabuf_listener = {
   dmabuf_format,
+  dmabuf_modifier,
+};
+
+#ifdef ZWP_LINUX_DMABUF_V1_GET_DEFAULT_FEEDBACK_SINCE_VERSION
+/* the format table entries sent with the dmabuf feedback */
+typedef struct
+{
+  uint32_t format;
+  uint32_t padding;
+  uint64_t modifier;
+} DmabufFeedbackFormat;
+
+static void
+dmabuf_feedback_done (void *data,
+    struct zwp_linux_dmabuf_feedback_v1 *feedback)
+{
+  GstWlDisplay *self = data;
+  GArray *formats;
+  guint i;
+
+  if (self->feedback_done) {
+    GST_INFO ("ignoring updated dmabuf feedback");
+    return;
+  }
+  self->feedback_done = TRUE;
+
+  /* move the formats that can be scanned out directly to the front, they
+   * are the ones to prefer during negotiation */
+  formats = g_array_new (FALSE, FALSE, sizeof (uint32_t));
+  g_array_append_vals (formats, self->dmabuf_scanout_formats->data,
+      self->dmabuf_scanout_formats->len);
+  for (i = 0; i < self->dmabuf_formats->len; i++) {
+    uint32_t format = g_array_index (self->dmabuf_formats, uint32_t, i);
+
+    if (!array_contains_format (formats, format))
+      g_array_append_val (formats, format);
+  }
+  g_array_unref (self->dmabuf_formats);
+  self->dmabuf_formats = formats;
+
+  GST_DEBUG ("dmabuf feedback: %u formats, %u with direct scanout, %u "
+      "modifiers", self->dmabuf_formats->len,
+      self->dmabuf_scanout_formats->len, self->dmabuf_modifiers->len);
+
+  if (self->format_table) {
+    munmap (self->format_table, self->format_table_size);
+    self->format_table = NULL;
+    self->format_table_size = 0;
+  }
+}
+
+static void
+dmabuf_feedback_format_table (void *data,
+    struct zwp_linux_dmabuf_feedback_v1 *feedback, int32_t fd, uint32_t size)
+{
+  GstWlDisplay *self = data;
+  gpointer table;
+
+  if (self->feedback_done) {
+    close (fd);
+    return;
+  }
+
+  table = mmap (NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+
+  if (table == MAP_FAILED) {
+    GST_WARNING ("failed to map dmabuf feedback format table: %s",
+        g_strerror (errno));
+    return;
+  }
+
+  if (self->format_table)
+    munmap (self->format_table, self->format_table_size);
+  self->format_table = table;
+  self->format_table_size = size;
+}
+
+static void
+dmabuf_feedback_main_device (void *data,
+    struct zwp_linux_dmabuf_feedback_v1 *feedback, struct wl_array *device)
+{
+}
+
+static void
+dmabuf_feedback_tranche_done (void *data,
+    struct zwp_linux_dmabuf_feedback_v1 *feedback)
+{
+  GstWlDisplay *self = data;
+  DmabufFeedbackFormat *table = self->format_table;
+  gsize n_entries = self->format_table_size / sizeof (DmabufFeedbackFormat);
+  gboolean scanout;
+  guint i;
+
+  scanout = (self->tranche_flags &
+      ZWP_LINUX_DMABUF_FEEDBACK_V1_TRANCHE_FLAGS_SCANOUT) != 0;
+
+  if (table && !self->feedback_done) {
+    for (i = 0; i < self->tranche_indices->len; i++) {
+      uint16_t idx = g_array_index (self->tranche_indices, uint16_t, i);
+
+      if (idx < n_entries)
+        add_dmabuf_modifier (self, table[idx].format, table[idx].modifier,
+            scanout);
+    }
+  }
+
+  g_array_set_size (self->tranche_indices, 0);
+  self->tranche_flags = 0;
+}
+
+static void
+dmabuf_feedback_tranche_target_device (void *data,
+    struct zwp_linux_dmabuf_feedback_v1 *feedback, struct wl_array *device)
+{
+}
+
+static void
+dmabuf_feedback_tranche_formats (void *data,
+    struct zwp_linux_dmabuf_feedback_v1 *feedback, struct wl_array *indices)
+{
+  GstWlDisplay *self = data;
+
+  g_array_append_vals (self->tranche_indices, indices->data,
+      indices->size / sizeof (uint16_t));
+}
+
+static void
+dmabuf_feedback_tranche_flags (void *data,
+    struct zwp_linux_dmabuf_feedback_v1 *feedback, uint32_t flags)
+{
+  GstWlDisplay *self = data;
+
+  self->tranche_flags = flags;
+}
+
+static const struct zwp_linux_dmabuf_feedback_v1_listener
+    dmabuf_feedback_listener = {
+  dmabuf_feedback_done,
+  dmabuf_feedback_format_table,
+  dmabuf_feedback_main_device,
+  dmabuf_feedback_tranche_done,
+  dmabuf_feedback_tranche_target_device,
+  dmabuf_feedback_tranche_formats,
+  dmabuf_feedback_tranche_flags,
 };
+#endif
 
 gboolean
 gst_wl_display_check_format_for_shm (GstWlDisplay * display,
@@ -195,6 +419,45 @@ gst_wl_display_check_format_for_dmabuf (GstWlDisplay * display,
   return FALSE;
 }
 
+/* Buffers don't carry their modifier here, so this can only choose between
+ * an explicit linear layout and letting the compositor find out the layout
+ * of the buffer itself, based on what was advertised for the format */
+guint64
+gst_wl_display_get_dmabuf_modifier (GstWlDisplay * display,
+    GstVideoFormat format)
+{
+  gboolean has_linear = FALSE, has_implicit = FALSE;
+  guint i, n_modifiers = 0;
+  guint32 dmabuf_fmt;
+
+  dmabuf_fmt = gst_video_format_to_wl_dmabuf_format (format);
+
+  for (i = 0; i < display->dmabuf_modifiers->len; i++) {
+    GstWlDmabufModifier *m =
+        &g_array_index (display->dmabuf_modifiers, GstWlDmabufModifier, i);
+
+    if (m->format != dmabuf_fmt)
+      continue;
+
+    n_modifiers++;
+    if (m->modifier == DRM_FORMAT_MOD_LINEAR)
+      has_linear = TRUE;
+    else if (m->modifier == DRM_FORMAT_MOD_INVALID)
+      has_implicit = TRUE;
+  }
+
+  if (n_modifiers == 0 || has_linear)
+    return DRM_FORMAT_MOD_LINEAR;
+
+  if (has_implicit)
+    return DRM_FORMAT_MOD_INVALID;
+
+  GST_DEBUG_OBJECT (display, "no linear modifier advertised for %s",
+      gst_video_format_to_string (format));
+
+  return DRM_FORMAT_MOD_LINEAR;
+}
+
 static void
 handle_xdg_wm_base_ping (void *user_data, struct xdg_wm_base *xdg_wm_base,
     uint32_t serial)
@@ -234,9 +497,25 @@ registry_handle_global (void *data, struct wl_registry *registry,
     self->viewporter =
         wl_registry_bind (registry, id, &wp_viewporter_interface, 1);
   } else if (g_strcmp0 (interface, "zwp_linux_dmabuf_v1") == 0) {
-    self->dmabuf =
-        wl_registry_bind (registry, id, &zwp_linux_dmabuf_v1_interface, 1);
+#ifdef ZWP_LINUX_DMABUF_V1_GET_DEFAULT_FEEDBACK_SINCE_VERSION
+    guint max_version = 4;
+#else
+    guint max_version = 3;
+#endif
+
+    self->dmabuf = wl_registry_bind (registry, id,
+        &zwp_linux_dmabuf_v1_interface, MIN (version, max_version));
     zwp_linux_dmabuf_v1_add_listener (self->dmabuf, &dmabuf_listener, self);
+
+    /* from version 4 on, formats and modifiers are only sent as feedback */
+#ifdef ZWP_LINUX_DMABUF_V1_GET_DEFAULT_FEEDBACK_SINCE_VERSION
+    if (version >= 4) {
+      self->dmabuf_feedback =
+          zwp_linux_dmabuf_v1_get_default_feedback (self->dmabuf);
+      zwp_linux_dmabuf_feedback_v1_add_listener (self->dmabuf_feedback,
+          &dmabuf_feedback_listener, self);
+    }
+#endif
   }
 }
 
@@ -41,6 +41,12 @@ G_BEGIN_DECLS
 typedef struct _GstWlDisplay GstWlDisplay;
 typedef struct _GstWlDisplayClass GstWlDisplayClass;
 
+typedef struct
+{
+  guint32 format;
+  guint64 modifier;
+} GstWlDmabufModifier;
+
 struct _GstWlDisplay
 {
   GObject parent_instance;
@@ -61,13 +67,26 @@ struct _GstWlDisplay
   struct wp_viewporter *viewporter;
   struct zwp_linux_dmabuf_v1 *dmabuf;
   GArray *shm_formats;
+  /* preferred formats first, the ones usable for direct scanout when the
+   * compositor sends dmabuf feedback */
   GArray *dmabuf_formats;
+  GArray *dmabuf_modifiers;
+  GArray *dmabuf_scanout_formats;
 
   /* private */
   gboolean own_display;
   GThread *thread;
   GstPoll *wl_fd_poll;
 
+#ifdef ZWP_LINUX_DMABUF_V1_GET_DEFAULT_FEEDBACK_SINCE_VERSION
+  struct zwp_linux_dmabuf_feedback_v1 *dmabuf_feedback;
+  gpointer format_table;
+  gsize format_table_size;
+  GArray *tranche_indices;
+  guint32 tranche_flags;
+  gboolean feedback_done;
+#endif
+
   GMutex buffers_mutex;
   GHashTable *buffers;
   gboolean shutting_down;
@@ -94,6 +113,8 @@ gboolean gst_wl_display_check_format_for_shm (GstWlDisplay * display,
     GstVideoFormat format);
 gboolean gst_wl_display_check_format_for_dmabuf (GstWlDisplay * display,
     GstVideoFormat format);
+guint64 gst_wl_display_get_dmabuf_modifier (GstWlDisplay * display,
+    GstVideoFormat format);
 
 G_END_DECLS
 
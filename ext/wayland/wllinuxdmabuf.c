@@ -77,6 +77,7 @@ gst_wl_linux_dmabuf_construct_wl_buffer (GstBuffer * buf,
   guint i, width, height;
   guint nplanes, flags = 0;
   struct zwp_linux_buffer_params_v1 *params;
+  guint64 modifier;
   gint64 timeout;
   ConstructBufferData data;
 
@@ -93,6 +94,8 @@ gst_wl_linux_dmabuf_construct_wl_buffer (GstBuffer * buf,
   width = GST_VIDEO_INFO_WIDTH (info);
   height = GST_VIDEO_INFO_HEIGHT (info);
   nplanes = GST_VIDEO_INFO_N_PLANES (info);
+  modifier = gst_wl_display_get_dmabuf_modifier (display,
+      GST_VIDEO_INFO_FORMAT (info));
 
   GST_DEBUG_OBJECT (display, "Creating wl_buffer from DMABuf of size %"
       G_GSSIZE_FORMAT " (%d x %d), format %s", info->size, width, height,
@@ -111,7 +114,7 @@ gst_wl_linux_dmabuf_construct_wl_buffer (GstBuffer * buf,
       GstMemory *m = gst_buffer_peek_memory (buf, mem_idx);
       gint fd = gst_dmabuf_memory_get_fd (m);
       zwp_linux_buffer_params_v1_add (params, fd, i, m->offset + skip,
-          stride, 0, 0);
+          stride, modifier >> 32, modifier & G_MAXUINT32);
     } else {
       GST_ERROR_OBJECT (mem->allocator, "memory does not seem to contain "
           "enough data for the specified format");
@@ -37,13 +37,17 @@ enum
   PROP_LOSSLESS,
   PROP_QUALITY,
   PROP_SPEED,
-  PROP_PRESET
+  PROP_PRESET,
+  PROP_N_THREADS,
+  PROP_MULTI_THREADED
 };
 
 #define DEFAULT_LOSSLESS FALSE
 #define DEFAULT_QUALITY 90
 #define DEFAULT_SPEED 4
 #define DEFAULT_PRESET WEBP_PRESET_PHOTO
+#define DEFAULT_N_THREADS 1
+#define DEFAULT_MULTI_THREADED FALSE
 
 static void gst_webp_enc_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
@@ -55,8 +59,11 @@ static gboolean gst_webp_enc_set_format (GstVideoEncoder * encoder,
     GstVideoCodecState * state);
 static GstFlowReturn gst_webp_enc_handle_frame (GstVideoEncoder * encoder,
     GstVideoCodecFrame * frame);
+static GstFlowReturn gst_webp_enc_finish (GstVideoEncoder * encoder);
+static gboolean gst_webp_enc_flush (GstVideoEncoder * encoder);
 static gboolean gst_webp_enc_propose_allocation (GstVideoEncoder * encoder,
     GstQuery * query);
+static void gst_webp_enc_finalize (GObject * object);
 
 static GstStaticPadTemplate webp_enc_sink_factory =
 GST_STATIC_PAD_TEMPLATE ("sink",
@@ -123,6 +130,7 @@ gst_webp_enc_class_init (GstWebpEncClass * klass)
 
   gobject_class->set_property = gst_webp_enc_set_property;
   gobject_class->get_property = gst_webp_enc_get_property;
+  gobject_class->finalize = gst_webp_enc_finalize;
   gst_element_class_add_static_pad_template (element_class,
       &webp_enc_sink_factory);
   gst_element_class_add_static_pad_template (element_class,
@@ -135,6 +143,8 @@ gst_webp_enc_class_init (GstWebpEncClass * klass)
   venc_class->stop = gst_webp_enc_stop;
   venc_class->set_format = gst_webp_enc_set_format;
   venc_class->handle_frame = gst_webp_enc_handle_frame;
+  venc_class->finish = gst_webp_enc_finish;
+  venc_class->flush = gst_webp_enc_flush;
   venc_class->propose_allocation = gst_webp_enc_propose_allocation;
 
   g_object_class_install_property (gobject_class, PROP_LOSSLESS,
@@ -155,6 +165,36 @@ gst_webp_enc_class_init (GstWebpEncClass * klass)
           GST_WEBP_ENC_PRESET_TYPE, DEFAULT_PRESET,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstWebpEnc:n-threads:
+   *
+   * Number of frames encoded in parallel. Frames are still output in
+   * order, after up to n-threads - 1 frames of delay. (0 = one per CPU
+   * core)
+   *
+   * Changes take effect when the element is next started.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Number of frames to encode in parallel (0 = auto)",
+          0, G_MAXINT, DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstWebpEnc:multi-threaded:
+   *
+   * Let libwebp use an additional thread inside of each frame encoding
+   * (the #WebPConfig thread_level).
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_MULTI_THREADED,
+      g_param_spec_boolean ("multi-threaded", "Multi-threaded",
+          "Use multiple threads for encoding a single frame",
+          DEFAULT_MULTI_THREADED, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   GST_DEBUG_CATEGORY_INIT (webpenc_debug, "webpenc", 0,
       "WEBP encoding element");
 
@@ -170,9 +210,26 @@ gst_webp_enc_init (GstWebpEnc * webpenc)
   webpenc->quality = DEFAULT_QUALITY;
   webpenc->speed = DEFAULT_SPEED;
   webpenc->preset = DEFAULT_PRESET;
+  webpenc->n_threads = DEFAULT_N_THREADS;
+  webpenc->multi_threaded = DEFAULT_MULTI_THREADED;
 
   webpenc->use_argb = FALSE;
   webpenc->rgb_format = GST_VIDEO_FORMAT_UNKNOWN;
+
+  g_queue_init (&webpenc->pending_jobs);
+  g_mutex_init (&webpenc->job_lock);
+  g_cond_init (&webpenc->job_cond);
+}
+
+static void
+gst_webp_enc_finalize (GObject * object)
+{
+  GstWebpEnc *webpenc = GST_WEBP_ENC (object);
+
+  g_mutex_clear (&webpenc->job_lock);
+  g_cond_clear (&webpenc->job_cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
 static gboolean
@@ -214,101 +271,233 @@ gst_webp_enc_set_format (GstVideoEncoder * encoder, GstVideoCodecState * state)
   return TRUE;
 }
 
-static gboolean
-gst_webp_set_picture_params (GstWebpEnc * enc)
+/* one frame being encoded, either directly from handle_frame() or by one
+ * of the worker threads, with its own picture and output memory */
+typedef struct
 {
-  GstVideoInfo *info;
-  gboolean ret = TRUE;
+  GstVideoCodecFrame *frame;
+  GstVideoFrame vframe;
+  WebPPicture picture;
+  WebPMemoryWriter writer;
+  gboolean encoded;
+  gboolean done;                /* protected by job_lock */
+} GstWebpEncJob;
 
-  info = &enc->input_state->info;
+static void
+gst_webp_enc_job_free (GstWebpEncJob * job)
+{
+  free (job->writer.mem);
+  if (job->frame)
+    gst_video_codec_frame_unref (job->frame);
+  g_slice_free (GstWebpEncJob, job);
+}
 
-  if (!WebPPictureInit (&enc->webp_picture)) {
-    ret = FALSE;
-    goto failed_pic_init;
+static gboolean
+gst_webp_set_picture_params (GstWebpEnc * enc, GstWebpEncJob * job)
+{
+  GstVideoInfo *info = &job->vframe.info;
+  WebPPicture *picture = &job->picture;
+
+  if (!WebPPictureInit (picture)) {
+    GST_ERROR_OBJECT (enc, "Failed to Initialize WebPPicture !");
+    return FALSE;
   }
 
-  enc->webp_picture.use_argb = enc->use_argb;
+  /* lossy encoding works on YUV anyway, so RGB input is converted
+   * straight to that instead of going through an ARGB copy */
+  picture->use_argb = enc->use_argb && enc->lossless;
   if (!enc->use_argb)
-    enc->webp_picture.colorspace = enc->webp_color_space;
+    picture->colorspace = enc->webp_color_space;
 
-  enc->webp_picture.width = GST_VIDEO_INFO_WIDTH (info);
-  enc->webp_picture.height = GST_VIDEO_INFO_HEIGHT (info);
+  picture->width = GST_VIDEO_INFO_WIDTH (info);
+  picture->height = GST_VIDEO_INFO_HEIGHT (info);
 
-  WebPMemoryWriterInit (&enc->webp_writer);
-  enc->webp_picture.writer = WebPMemoryWrite;
-  enc->webp_picture.custom_ptr = &enc->webp_writer;
+  WebPMemoryWriterInit (&job->writer);
+  picture->writer = WebPMemoryWrite;
+  picture->custom_ptr = &job->writer;
 
-  return ret;
-
-failed_pic_init:
-  {
-    GST_ERROR_OBJECT (enc, "Failed to Initialize WebPPicture !");
-    return ret;
-  }
+  return TRUE;
 }
 
-static GstFlowReturn
-gst_webp_enc_handle_frame (GstVideoEncoder * encoder,
-    GstVideoCodecFrame * frame)
+/* Called without the stream lock from the worker threads. Only reads the
+ * configuration, which doesn't change while the element is started */
+static void
+gst_webp_enc_encode_job (GstWebpEnc * enc, GstWebpEncJob * job)
 {
-  GstWebpEnc *enc = GST_WEBP_ENC (encoder);
-  GstBuffer *out_buffer = NULL;
-  GstVideoFrame vframe;
+  GstVideoFrame *vframe = &job->vframe;
+  WebPPicture *picture = &job->picture;
 
-  GST_LOG_OBJECT (enc, "got new frame");
-
-  gst_webp_set_picture_params (enc);
+  job->encoded = FALSE;
 
-  if (!gst_video_frame_map (&vframe, &enc->input_state->info,
-          frame->input_buffer, GST_MAP_READ))
-    return GST_FLOW_ERROR;
+  if (!gst_webp_set_picture_params (enc, job))
+    goto done;
 
   if (!enc->use_argb) {
-    enc->webp_picture.y = GST_VIDEO_FRAME_COMP_DATA (&vframe, 0);
-    enc->webp_picture.u = GST_VIDEO_FRAME_COMP_DATA (&vframe, 1);
-    enc->webp_picture.v = GST_VIDEO_FRAME_COMP_DATA (&vframe, 2);
-
-    enc->webp_picture.y_stride = GST_VIDEO_FRAME_COMP_STRIDE (&vframe, 0);
-    enc->webp_picture.uv_stride = GST_VIDEO_FRAME_COMP_STRIDE (&vframe, 1);
+    /* the planes are used as they are in the mapped frame */
+    picture->y = GST_VIDEO_FRAME_COMP_DATA (vframe, 0);
+    picture->u = GST_VIDEO_FRAME_COMP_DATA (vframe, 1);
+    picture->v = GST_VIDEO_FRAME_COMP_DATA (vframe, 2);
 
+    picture->y_stride = GST_VIDEO_FRAME_COMP_STRIDE (vframe, 0);
+    picture->uv_stride = GST_VIDEO_FRAME_COMP_STRIDE (vframe, 1);
   } else {
     switch (enc->rgb_format) {
       case GST_VIDEO_FORMAT_RGB:
-        WebPPictureImportRGB (&enc->webp_picture,
-            GST_VIDEO_FRAME_COMP_DATA (&vframe, 0),
-            GST_VIDEO_FRAME_COMP_STRIDE (&vframe, 0));
+        WebPPictureImportRGB (picture,
+            GST_VIDEO_FRAME_COMP_DATA (vframe, 0),
+            GST_VIDEO_FRAME_COMP_STRIDE (vframe, 0));
         break;
       case GST_VIDEO_FORMAT_RGBA:
-        WebPPictureImportRGBA (&enc->webp_picture,
-            GST_VIDEO_FRAME_COMP_DATA (&vframe, 0),
-            GST_VIDEO_FRAME_COMP_STRIDE (&vframe, 0));
+        WebPPictureImportRGBA (picture,
+            GST_VIDEO_FRAME_COMP_DATA (vframe, 0),
+            GST_VIDEO_FRAME_COMP_STRIDE (vframe, 0));
         break;
       default:
         break;
     }
   }
 
-  if (WebPEncode (&enc->webp_config, &enc->webp_picture)) {
-    WebPPictureFree (&enc->webp_picture);
+  if (WebPEncode (&enc->webp_config, picture))
+    job->encoded = TRUE;
+  else
+    GST_ERROR_OBJECT (enc, "Failed to encode WebPPicture: %d",
+        picture->error_code);
+
+  WebPPictureFree (picture);
+
+done:
+  gst_video_frame_unmap (vframe);
+}
+
+static void
+gst_webp_enc_encode_func (gpointer data, gpointer user_data)
+{
+  GstWebpEnc *enc = GST_WEBP_ENC (user_data);
+  GstWebpEncJob *job = data;
+
+  gst_webp_enc_encode_job (enc, job);
+
+  g_mutex_lock (&enc->job_lock);
+  job->done = TRUE;
+  g_cond_broadcast (&enc->job_cond);
+  g_mutex_unlock (&enc->job_lock);
+}
+
+/* Called with the stream lock from the streaming thread, in input order */
+static GstFlowReturn
+gst_webp_enc_finish_job (GstWebpEnc * enc, GstWebpEncJob * job)
+{
+  GstVideoCodecFrame *frame = job->frame;
+
+  if (!job->encoded) {
+    gst_webp_enc_job_free (job);
+    return GST_FLOW_ERROR;
+  }
+
+  /* hand the memory written by libwebp downstream without copying it */
+  frame->output_buffer = gst_buffer_new_wrapped_full (0, job->writer.mem,
+      job->writer.size, 0, job->writer.size, job->writer.mem, free);
+  job->writer.mem = NULL;
+  job->frame = NULL;
+  gst_webp_enc_job_free (job);
 
-    out_buffer = gst_buffer_new_allocate (NULL, enc->webp_writer.size, NULL);
-    if (!out_buffer) {
-      GST_ERROR_OBJECT (enc, "Failed to create output buffer");
-      gst_video_frame_unmap (&vframe);
-      return GST_FLOW_ERROR;
+  return gst_video_encoder_finish_frame (GST_VIDEO_ENCODER (enc), frame);
+}
+
+/* Outputs the encoded frames at the head of the pending queue, and waits
+ * for the oldest ones until at most @max_pending frames are left */
+static GstFlowReturn
+gst_webp_enc_finish_pending (GstWebpEnc * enc, guint max_pending)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstWebpEncJob *job;
+
+  g_mutex_lock (&enc->job_lock);
+  while ((job = g_queue_peek_head (&enc->pending_jobs))) {
+    if (!job->done) {
+      if (g_queue_get_length (&enc->pending_jobs) <= max_pending)
+        break;
+      g_cond_wait (&enc->job_cond, &enc->job_lock);
+      continue;
     }
-    gst_buffer_fill (out_buffer, 0, enc->webp_writer.mem,
-        enc->webp_writer.size);
-    free (enc->webp_writer.mem);
-  } else {
-    GST_ERROR_OBJECT (enc, "Failed to encode WebPPicture");
-    gst_video_frame_unmap (&vframe);
+
+    g_queue_pop_head (&enc->pending_jobs);
+    g_mutex_unlock (&enc->job_lock);
+    ret = gst_webp_enc_finish_job (enc, job);
+    g_mutex_lock (&enc->job_lock);
+
+    if (ret != GST_FLOW_OK)
+      break;
+  }
+  g_mutex_unlock (&enc->job_lock);
+
+  return ret;
+}
+
+/* Waits for all worker threads and drops the frames they encoded */
+static void
+gst_webp_enc_discard_pending (GstWebpEnc * enc)
+{
+  GstWebpEncJob *job;
+
+  g_mutex_lock (&enc->job_lock);
+  while ((job = g_queue_pop_head (&enc->pending_jobs))) {
+    while (!job->done)
+      g_cond_wait (&enc->job_cond, &enc->job_lock);
+    gst_webp_enc_job_free (job);
+  }
+  g_mutex_unlock (&enc->job_lock);
+}
+
+static GstFlowReturn
+gst_webp_enc_handle_frame (GstVideoEncoder * encoder,
+    GstVideoCodecFrame * frame)
+{
+  GstWebpEnc *enc = GST_WEBP_ENC (encoder);
+  GstWebpEncJob *job;
+
+  GST_LOG_OBJECT (enc, "got new frame");
+
+  job = g_slice_new0 (GstWebpEncJob);
+
+  if (!gst_video_frame_map (&job->vframe, &enc->input_state->info,
+          frame->input_buffer, GST_MAP_READ)) {
+    g_slice_free (GstWebpEncJob, job);
+    gst_video_codec_frame_unref (frame);
     return GST_FLOW_ERROR;
   }
+  job->frame = frame;
+
+  if (!enc->pool) {
+    gst_webp_enc_encode_job (enc, job);
+    return gst_webp_enc_finish_job (enc, job);
+  }
 
-  gst_video_frame_unmap (&vframe);
-  frame->output_buffer = out_buffer;
-  return gst_video_encoder_finish_frame (encoder, frame);
+  g_mutex_lock (&enc->job_lock);
+  g_queue_push_tail (&enc->pending_jobs, job);
+  g_mutex_unlock (&enc->job_lock);
+  g_thread_pool_push (enc->pool, job, NULL);
+
+  /* keep one frame per thread in flight while waiting for the oldest */
+  return gst_webp_enc_finish_pending (enc, enc->n_pool_threads - 1);
+}
+
+static GstFlowReturn
+gst_webp_enc_finish (GstVideoEncoder * encoder)
+{
+  GstWebpEnc *enc = GST_WEBP_ENC (encoder);
+
+  return gst_webp_enc_finish_pending (enc, 0);
+}
+
+static gboolean
+gst_webp_enc_flush (GstVideoEncoder * encoder)
+{
+  GstWebpEnc *enc = GST_WEBP_ENC (encoder);
+
+  gst_webp_enc_discard_pending (enc);
+
+  return TRUE;
 }
 
 static gboolean
@@ -339,6 +528,12 @@ gst_webp_enc_set_property (GObject * object, guint prop_id,
     case PROP_PRESET:
       webpenc->preset = g_value_get_enum (value);
       break;
+    case PROP_N_THREADS:
+      webpenc->n_threads = g_value_get_uint (value);
+      break;
+    case PROP_MULTI_THREADED:
+      webpenc->multi_threaded = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -365,6 +560,12 @@ gst_webp_enc_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_PRESET:
       g_value_set_enum (value, webpenc->preset);
       break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, webpenc->n_threads);
+      break;
+    case PROP_MULTI_THREADED:
+      g_value_set_boolean (value, webpenc->multi_threaded);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -383,10 +584,29 @@ gst_webp_enc_start (GstVideoEncoder * benc)
 
   enc->webp_config.lossless = enc->lossless;
   enc->webp_config.method = enc->speed;
+  enc->webp_config.thread_level = enc->multi_threaded;
   if (!WebPValidateConfig (&enc->webp_config)) {
     GST_ERROR_OBJECT (enc, "Failed to Validate the WebPConfig");
     return FALSE;
   }
+
+  enc->n_pool_threads = enc->n_threads;
+  if (enc->n_pool_threads == 0)
+    enc->n_pool_threads = g_get_num_processors ();
+
+  if (enc->n_pool_threads > 1) {
+    GError *err = NULL;
+
+    enc->pool = g_thread_pool_new (gst_webp_enc_encode_func, enc,
+        enc->n_pool_threads, FALSE, &err);
+    if (!enc->pool) {
+      GST_WARNING_OBJECT (enc, "Failed to create encoding threads: %s",
+          err->message);
+      g_clear_error (&err);
+      enc->n_pool_threads = 1;
+    }
+  }
+
   return TRUE;
 }
 
@@ -394,8 +614,16 @@ static gboolean
 gst_webp_enc_stop (GstVideoEncoder * benc)
 {
   GstWebpEnc *enc = GST_WEBP_ENC (benc);
+
+  gst_webp_enc_discard_pending (enc);
+  if (enc->pool) {
+    g_thread_pool_free (enc->pool, FALSE, TRUE);
+    enc->pool = NULL;
+  }
+
   if (enc->input_state)
     gst_video_codec_state_unref (enc->input_state);
+  enc->input_state = NULL;
   return TRUE;
 }
 
@@ -54,14 +54,21 @@ struct _GstWebpEnc
   gfloat quality;
   guint speed;
   gint preset;
+  guint n_threads;
+  gboolean multi_threaded;
 
   gboolean use_argb;
   GstVideoFormat rgb_format;
 
   WebPEncCSP webp_color_space;
   struct WebPConfig webp_config;
-  struct WebPPicture webp_picture;
-  WebPMemoryWriter webp_writer;
+
+  /* frame level parallelism, jobs are kept in input order */
+  guint n_pool_threads;
+  GThreadPool *pool;
+  GQueue pending_jobs;
+  GMutex job_lock;
+  GCond job_cond;
 };
 
 struct _GstWebpEncClass
@@ -361,6 +361,7 @@ enum
   ADD_TURN_SERVER_SIGNAL,
   CREATE_DATA_CHANNEL_SIGNAL,
   ON_DATA_CHANNEL_SIGNAL,
+  ON_STATS_SIGNAL,
   LAST_SIGNAL,
 };
 
@@ -382,7 +383,10 @@ enum
   PROP_BUNDLE_POLICY,
   PROP_ICE_TRANSPORT_POLICY,
   PROP_ICE_AGENT,
-  PROP_LATENCY
+  PROP_LATENCY,
+  PROP_STATS_MAX_AGE,
+  PROP_STATS_INTERVAL,
+  PROP_STATS_TYPES,
 };
 
 static guint gst_webrtc_bin_signals[LAST_SIGNAL] = { 0 };
@@ -727,6 +731,65 @@ _gst_pc_thread (GstWebRTCBin * webrtc)
   return NULL;
 }
 
+static GstStructure *_create_stats (GstWebRTCBin * webrtc, GstPad * pad);
+
+static gboolean
+_push_stats_cb (GstWebRTCBin * webrtc)
+{
+  GstStructure *s;
+
+  PC_LOCK (webrtc);
+  /* the source may have been replaced while we were waiting for the lock */
+  if (g_source_is_destroyed (g_main_current_source ())
+      || webrtc->priv->is_closed) {
+    PC_UNLOCK (webrtc);
+    return G_SOURCE_REMOVE;
+  }
+
+  s = _create_stats (webrtc, NULL);
+  gst_webrtc_bin_filter_stats (s, webrtc->priv->stats_types);
+  PC_UNLOCK (webrtc);
+
+  g_signal_emit (webrtc, gst_webrtc_bin_signals[ON_STATS_SIGNAL], 0, s);
+  gst_structure_free (s);
+
+  return G_SOURCE_CONTINUE;
+}
+
+/* (re)creates the periodic stats source on the pc thread according to the
+ * current stats-interval, call with the pc lock held */
+static void
+_update_stats_source (GstWebRTCBin * webrtc)
+{
+  GMainContext *ctx = NULL;
+
+  if (webrtc->priv->stats_source) {
+    g_source_destroy (webrtc->priv->stats_source);
+    g_source_unref (webrtc->priv->stats_source);
+    webrtc->priv->stats_source = NULL;
+  }
+
+  GST_OBJECT_LOCK (webrtc);
+  if (!webrtc->priv->is_closed && webrtc->priv->main_context)
+    ctx = g_main_context_ref (webrtc->priv->main_context);
+  GST_OBJECT_UNLOCK (webrtc);
+
+  if (!ctx)
+    return;
+
+  if (webrtc->priv->stats_interval > 0) {
+    GST_DEBUG_OBJECT (webrtc, "notifying stats every %u ms",
+        webrtc->priv->stats_interval);
+    webrtc->priv->stats_source =
+        g_timeout_source_new (webrtc->priv->stats_interval);
+    g_source_set_callback (webrtc->priv->stats_source,
+        (GSourceFunc) _push_stats_cb, webrtc, NULL);
+    g_source_attach (webrtc->priv->stats_source, ctx);
+  }
+
+  g_main_context_unref (ctx);
+}
+
 static void
 _start_thread (GstWebRTCBin * webrtc)
 {
@@ -741,6 +804,7 @@ _start_thread (GstWebRTCBin * webrtc)
   while (!webrtc->priv->loop)
     PC_COND_WAIT (webrtc);
   webrtc->priv->is_closed = FALSE;
+  _update_stats_source (webrtc);
   PC_UNLOCK (webrtc);
 }
 
@@ -752,6 +816,7 @@ _stop_thread (GstWebRTCBin * webrtc)
   GST_OBJECT_UNLOCK (webrtc);
 
   PC_LOCK (webrtc);
+  _update_stats_source (webrtc);
   g_main_loop_quit (webrtc->priv->loop);
   while (webrtc->priv->loop)
     PC_COND_WAIT (webrtc);
@@ -2422,6 +2487,180 @@ _media_add_ssrcs (GstSDPMedia * media, GstCaps * caps, GstWebRTCBin * webrtc,
         (GstStructureForeachFunc) _media_add_rtx_ssrc, &data);
 }
 
+/* Simulcast (RFC 8853) layers are described by the application with
+ * "rid-<id>" caps fields on the codec preferences or the sink pad caps.
+ * The value is the rest of the a=rid line (RFC 8851), i.e. "send" optionally
+ * followed by restrictions such as "send pt=96;max-width=640".  All layers
+ * are pushed into the same sink pad as separate SSRCs carrying the RID and
+ * MID RTP header extensions which are negotiated through "extmap-<N>"
+ * fields. */
+typedef struct
+{
+  GstSDPMedia *media;
+  GString *send_rids;
+  GString *recv_rids;
+} RidData;
+
+static void
+_append_simulcast_rid (GString * rids, const gchar * rid)
+{
+  if (rids->len > 0)
+    g_string_append_c (rids, ';');
+  g_string_append (rids, rid);
+}
+
+static void
+_media_add_simulcast (GstSDPMedia * media, RidData * data)
+{
+  GString *simulcast;
+
+  if (data->send_rids->len == 0 && data->recv_rids->len == 0)
+    return;
+
+  simulcast = g_string_new (NULL);
+  if (data->send_rids->len > 0)
+    g_string_append_printf (simulcast, "send %s", data->send_rids->str);
+  if (data->recv_rids->len > 0)
+    g_string_append_printf (simulcast, "%srecv %s",
+        simulcast->len > 0 ? " " : "", data->recv_rids->str);
+
+  gst_sdp_media_add_attribute (media, "simulcast", simulcast->str);
+  g_string_free (simulcast, TRUE);
+}
+
+static gboolean
+_media_add_rid (GQuark field_id, const GValue * value, RidData * data)
+{
+  const gchar *field_name = g_quark_to_string (field_id);
+  const gchar *rid, *val;
+  gchar *str;
+
+  if (!g_str_has_prefix (field_name, "rid-"))
+    return TRUE;
+
+  rid = &field_name[strlen ("rid-")];
+  if (!G_VALUE_HOLDS_STRING (value) || !(val = g_value_get_string (value))
+      || *rid == '\0') {
+    GST_WARNING ("Ignoring invalid simulcast field %s", field_name);
+    return TRUE;
+  }
+
+  if (g_str_has_prefix (val, "send"))
+    _append_simulcast_rid (data->send_rids, rid);
+  else if (g_str_has_prefix (val, "recv"))
+    _append_simulcast_rid (data->recv_rids, rid);
+  else {
+    GST_WARNING ("Ignoring simulcast field %s with unknown direction \"%s\"",
+        field_name, val);
+    return TRUE;
+  }
+
+  str = g_strdup_printf ("%s %s", rid, val);
+  gst_sdp_media_add_attribute (data->media, "rid", str);
+  g_free (str);
+
+  return TRUE;
+}
+
+static void
+_media_add_rids_from_caps (GstSDPMedia * media, const GstCaps * caps)
+{
+  RidData data;
+
+  if (gst_caps_get_size (caps) == 0)
+    return;
+
+  data.media = media;
+  data.send_rids = g_string_new (NULL);
+  data.recv_rids = g_string_new (NULL);
+
+  /* the layers are per media and not per format so only look at the first
+   * structure */
+  gst_structure_foreach (gst_caps_get_structure (caps, 0),
+      (GstStructureForeachFunc) _media_add_rid, &data);
+  _media_add_simulcast (media, &data);
+
+  g_string_free (data.send_rids, TRUE);
+  g_string_free (data.recv_rids, TRUE);
+}
+
+/* Accept the simulcast layers of the offer, reversing their direction.  Only
+ * directions that are compatible with @answer_dir are kept. */
+static void
+_media_add_rids_from_offer (GstSDPMedia * media,
+    const GstSDPMedia * offer_media,
+    GstWebRTCRTPTransceiverDirection answer_dir)
+{
+  gboolean can_send, can_recv;
+  RidData data;
+  guint i;
+
+  can_send = answer_dir == GST_WEBRTC_RTP_TRANSCEIVER_DIRECTION_SENDRECV
+      || answer_dir == GST_WEBRTC_RTP_TRANSCEIVER_DIRECTION_SENDONLY;
+  can_recv = answer_dir == GST_WEBRTC_RTP_TRANSCEIVER_DIRECTION_SENDRECV
+      || answer_dir == GST_WEBRTC_RTP_TRANSCEIVER_DIRECTION_RECVONLY;
+
+  data.media = media;
+  data.send_rids = g_string_new (NULL);
+  data.recv_rids = g_string_new (NULL);
+
+  for (i = 0; i < gst_sdp_media_attributes_len (offer_media); i++) {
+    const GstSDPAttribute *attr = gst_sdp_media_get_attribute (offer_media, i);
+    gchar **split;
+    gchar *str;
+
+    if (g_strcmp0 (attr->key, "rid") != 0 || !attr->value)
+      continue;
+
+    split = g_strsplit (attr->value, " ", 3);
+    if (!split[0] || !split[1]) {
+      GST_WARNING ("Ignoring invalid rid attribute \"%s\"", attr->value);
+      g_strfreev (split);
+      continue;
+    }
+
+    /* the remote sending a layer means we receive it and vice versa */
+    if (g_strcmp0 (split[1], "send") == 0 && can_recv) {
+      _append_simulcast_rid (data.recv_rids, split[0]);
+      str = g_strdup_printf ("%s recv%s%s", split[0], split[2] ? " " : "",
+          split[2] ? split[2] : "");
+    } else if (g_strcmp0 (split[1], "recv") == 0 && can_send) {
+      _append_simulcast_rid (data.send_rids, split[0]);
+      str = g_strdup_printf ("%s send%s%s", split[0], split[2] ? " " : "",
+          split[2] ? split[2] : "");
+    } else {
+      GST_DEBUG ("Not accepting simulcast layer \"%s\"", attr->value);
+      g_strfreev (split);
+      continue;
+    }
+
+    gst_sdp_media_add_attribute (media, "rid", str);
+    g_free (str);
+    g_strfreev (split);
+  }
+
+  _media_add_simulcast (media, &data);
+
+  g_string_free (data.send_rids, TRUE);
+  g_string_free (data.recv_rids, TRUE);
+}
+
+static gboolean
+_remove_rid_field (GQuark field_id, GValue * value, gpointer user_data)
+{
+  return !g_str_has_prefix (g_quark_to_string (field_id), "rid-");
+}
+
+static void
+_caps_remove_rid_fields (GstCaps * caps)
+{
+  guint i;
+
+  for (i = 0; i < gst_caps_get_size (caps); i++)
+    gst_structure_filter_and_map_in_place (gst_caps_get_structure (caps, i),
+        _remove_rid_field, NULL);
+}
+
 static void
 _add_fingerprint_to_media (GstWebRTCDTLSTransport * transport,
     GstSDPMedia * media)
@@ -2543,6 +2782,8 @@ sdp_media_from_transceiver (GstWebRTCBin * webrtc, GstSDPMedia * media,
     const GstStructure *s = gst_caps_get_structure (caps, i);
 
     gst_caps_append_structure (format, gst_structure_copy (s));
+    /* simulcast layers are added as a=rid lines separately */
+    _caps_remove_rid_fields (format);
 
     GST_DEBUG_OBJECT (webrtc, "Adding %u-th caps %" GST_PTR_FORMAT
         " to %u-th media", i, format, media_idx);
@@ -2585,6 +2826,9 @@ sdp_media_from_transceiver (GstWebRTCBin * webrtc, GstSDPMedia * media,
 
   _media_add_ssrcs (media, caps, webrtc, WEBRTC_TRANSCEIVER (trans));
 
+  if (type == GST_WEBRTC_SDP_TYPE_OFFER)
+    _media_add_rids_from_caps (media, caps);
+
   /* Some identifier; we also add the media name to it so it's identifiable */
   if (trans->mid) {
     gst_sdp_media_add_attribute (media, "mid", trans->mid);
@@ -2815,6 +3059,8 @@ _create_offer_task (GstWebRTCBin * webrtc, const GstStructure * options,
   gst_sdp_message_set_session_name (ret, "-");
   gst_sdp_message_add_time (ret, "0", "0", NULL);
   gst_sdp_message_add_attribute (ret, "ice-options", "trickle");
+  if (gst_webrtc_ice_get_is_lite (webrtc->priv->ice))
+    gst_sdp_message_add_attribute (ret, "ice-lite", NULL);
 
   if (webrtc->bundle_policy == GST_WEBRTC_BUNDLE_POLICY_MAX_BUNDLE) {
     bundled_mids = g_string_new ("BUNDLE");
@@ -3264,6 +3510,8 @@ _create_answer_task (GstWebRTCBin * webrtc, const GstStructure * options,
       gst_sdp_message_add_attribute (ret, attr->key, attr->value);
     }
   }
+  if (gst_webrtc_ice_get_is_lite (webrtc->priv->ice))
+    gst_sdp_message_add_attribute (ret, "ice-lite", NULL);
 
   for (i = 0; i < gst_sdp_message_medias_len (pending_remote->sdp); i++) {
     GstSDPMedia *media = NULL;
@@ -3503,6 +3751,10 @@ _create_answer_task (GstWebRTCBin * webrtc, const GstStructure * options,
         }
       }
 
+      /* the simulcast layers in the answer are taken from the offer */
+      answer_caps = gst_caps_make_writable (answer_caps);
+      _caps_remove_rid_fields (answer_caps);
+
       gst_sdp_media_set_media_from_caps (answer_caps, media);
 
       _get_rtx_target_pt_and_ssrc_from_caps (answer_caps, &target_pt,
@@ -3535,6 +3787,8 @@ _create_answer_task (GstWebRTCBin * webrtc, const GstStructure * options,
       }
       _media_replace_direction (media, answer_dir);
 
+      _media_add_rids_from_offer (media, offer_media, answer_dir);
+
       if (!trans->stream) {
         TransportStream *item;
 
@@ -4867,6 +5121,12 @@ _set_description_task (GstWebRTCBin * webrtc, struct set_description *sd)
         && webrtc->current_remote_description
         && _message_has_attribute_key (webrtc->current_remote_description->sdp,
         "ice-lite");
+    /* but an ice-lite agent is always controlled by a full peer */
+    if (gst_webrtc_ice_get_is_lite (webrtc->priv->ice)
+        && !(webrtc->current_remote_description
+            && _message_has_attribute_key (webrtc->
+                current_remote_description->sdp, "ice-lite")))
+      ice_controller = FALSE;
 
     GST_DEBUG_OBJECT (webrtc, "we are in ice controlling mode: %s",
         ice_controller ? "true" : "false");
@@ -5159,45 +5419,69 @@ bad_input:
 }
 
 static void
-_add_ice_candidate_task (GstWebRTCBin * webrtc, IceCandidateItem * item)
+_add_pending_ice_candidates_task (GstWebRTCBin * webrtc, gpointer unused)
 {
-  if (!webrtc->current_local_description || !webrtc->current_remote_description) {
-    IceCandidateItem new;
-    new.mlineindex = item->mlineindex;
-    new.candidate = g_steal_pointer (&item->candidate);
+  GArray *items;
+  guint i;
 
-    ICE_LOCK (webrtc);
-    g_array_append_val (webrtc->priv->pending_remote_ice_candidates, new);
+  /* Without both descriptions the candidates stay pending and are added
+   * once the descriptions have been set */
+  if (!webrtc->current_local_description || !webrtc->current_remote_description)
+    return;
+
+  ICE_LOCK (webrtc);
+  if (webrtc->priv->pending_remote_ice_candidates->len == 0) {
     ICE_UNLOCK (webrtc);
-  } else {
-    _add_ice_candidate (webrtc, item, FALSE);
+    return;
   }
-}
+  /* Take the array so that candidates can keep on trickling in without
+   * waiting for the ICE agent */
+  items = webrtc->priv->pending_remote_ice_candidates;
+  webrtc->priv->pending_remote_ice_candidates =
+      g_array_new (FALSE, TRUE, sizeof (IceCandidateItem));
+  g_array_set_clear_func (webrtc->priv->pending_remote_ice_candidates,
+      (GDestroyNotify) _clear_ice_candidate_item);
+  ICE_UNLOCK (webrtc);
 
-static void
-_free_ice_candidate_item (IceCandidateItem * item)
-{
-  _clear_ice_candidate_item (item);
-  g_free (item);
+  GST_TRACE_OBJECT (webrtc, "adding %u pending remote ICE candidates",
+      items->len);
+
+  for (i = 0; i < items->len; i++) {
+    IceCandidateItem *item = &g_array_index (items, IceCandidateItem, i);
+
+    _add_ice_candidate (webrtc, item, FALSE);
+  }
+  g_array_free (items, TRUE);
 }
 
 static void
 gst_webrtc_bin_add_ice_candidate (GstWebRTCBin * webrtc, guint mline,
     const gchar * attr)
 {
-  IceCandidateItem *item;
+  IceCandidateItem item;
+  gboolean queue_task = FALSE;
 
-  item = g_new0 (IceCandidateItem, 1);
-  item->mlineindex = mline;
+  item.mlineindex = mline;
+  item.candidate = NULL;
   if (attr && attr[0] != 0) {
     if (!g_ascii_strncasecmp (attr, "a=candidate:", 12))
-      item->candidate = g_strdup (attr);
+      item.candidate = g_strdup (attr);
     else if (!g_ascii_strncasecmp (attr, "candidate:", 10))
-      item->candidate = g_strdup_printf ("a=%s", attr);
+      item.candidate = g_strdup_printf ("a=%s", attr);
   }
-  gst_webrtc_bin_enqueue_task (webrtc,
-      (GstWebRTCBinFunc) _add_ice_candidate_task, item,
-      (GDestroyNotify) _free_ice_candidate_item, NULL);
+
+  ICE_LOCK (webrtc);
+  g_array_append_val (webrtc->priv->pending_remote_ice_candidates, item);
+
+  /* Like for the local candidates, only the first pending candidate queues
+   * a task, which then adds all candidates trickled in until it runs */
+  if (webrtc->priv->pending_remote_ice_candidates->len == 1)
+    queue_task = TRUE;
+  ICE_UNLOCK (webrtc);
+
+  if (queue_task)
+    gst_webrtc_bin_enqueue_task (webrtc,
+        (GstWebRTCBinFunc) _add_pending_ice_candidates_task, NULL, NULL, NULL);
 }
 
 static void
@@ -5301,6 +5585,33 @@ _free_get_stats (struct get_stats *stats)
   g_free (stats);
 }
 
+/* Returns the stats for @pad or the whole peerconnection.  The latter are
+ * reused for up to stats-max-age milliseconds.  Call with the pc lock held */
+static GstStructure *
+_create_stats (GstWebRTCBin * webrtc, GstPad * pad)
+{
+  gint64 now = g_get_monotonic_time ();
+  GstStructure *s;
+
+  if (pad || webrtc->priv->stats_max_age == 0)
+    return gst_webrtc_bin_create_stats (webrtc, pad);
+
+  if (webrtc->priv->last_stats && now - webrtc->priv->last_stats_time <
+      (gint64) webrtc->priv->stats_max_age * G_TIME_SPAN_MILLISECOND) {
+    GST_TRACE_OBJECT (webrtc, "reusing stats from %" G_GINT64_FORMAT " us ago",
+        now - webrtc->priv->last_stats_time);
+    return gst_structure_copy (webrtc->priv->last_stats);
+  }
+
+  s = gst_webrtc_bin_create_stats (webrtc, NULL);
+  if (webrtc->priv->last_stats)
+    gst_structure_free (webrtc->priv->last_stats);
+  webrtc->priv->last_stats = gst_structure_copy (s);
+  webrtc->priv->last_stats_time = now;
+
+  return s;
+}
+
 /* https://www.w3.org/TR/webrtc/#dom-rtcpeerconnection-getstats() */
 static void
 _get_stats_task (GstWebRTCBin * webrtc, struct get_stats *stats)
@@ -5308,8 +5619,7 @@ _get_stats_task (GstWebRTCBin * webrtc, struct get_stats *stats)
   /* Our selector is the pad,
    * https://www.w3.org/TR/webrtc/#dfn-stats-selection-algorithm
    */
-  gst_promise_reply (stats->promise, gst_webrtc_bin_create_stats (webrtc,
-          stats->pad));
+  gst_promise_reply (stats->promise, _create_stats (webrtc, stats->pad));
 }
 
 static void
@@ -5321,6 +5631,28 @@ gst_webrtc_bin_get_stats (GstWebRTCBin * webrtc, GstPad * pad,
   g_return_if_fail (promise != NULL);
   g_return_if_fail (pad == NULL || GST_IS_WEBRTC_BIN_PAD (pad));
 
+  /* Stats are not part of the operations chain, so don't wait behind
+   * queued negotiation tasks if nothing is currently holding the pc lock.
+   * Never block on the lock here as the caller might be a streaming thread
+   * that the pc thread is waiting for. */
+  if (g_thread_self () != webrtc->priv->thread
+      && g_mutex_trylock (PC_GET_LOCK (webrtc))) {
+    gboolean is_closed;
+
+    GST_OBJECT_LOCK (webrtc);
+    is_closed = webrtc->priv->is_closed;
+    GST_OBJECT_UNLOCK (webrtc);
+
+    if (!is_closed) {
+      GstStructure *s = _create_stats (webrtc, pad);
+
+      PC_UNLOCK (webrtc);
+      gst_promise_reply (promise, s);
+      return;
+    }
+    PC_UNLOCK (webrtc);
+  }
+
   stats = g_new0 (struct get_stats, 1);
   stats->promise = gst_promise_ref (promise);
   /* FIXME: check that pad exists in element */
@@ -6023,6 +6355,29 @@ on_rtpbin_sender_ssrc_active (GstElement * rtpbin, guint session_id, guint ssrc,
       ssrc);
 }
 
+static GstElement *
+on_rtpbin_request_jitterbuffer (GstElement * rtpbin, guint session_id,
+    GstWebRTCBin * webrtc)
+{
+  WebRTCTransceiver *trans;
+  GstElement *ret = NULL;
+
+  trans = (WebRTCTransceiver *) _find_transceiver (webrtc, &session_id,
+      (FindTransceiverFunc) transceiver_match_for_mline);
+
+  /* NULL makes rtpbin use its default rtpjitterbuffer */
+  if (trans && trans->forward_rtp) {
+    GST_DEBUG_OBJECT (webrtc, "Forwarding RTP packets of session %u without "
+        "jitterbuffer", session_id);
+    ret = gst_element_factory_make ("identity", NULL);
+    if (!ret)
+      GST_WARNING_OBJECT (webrtc, "Could not create identity element, "
+          "falling back to the default jitterbuffer");
+  }
+
+  return ret;
+}
+
 static void
 on_rtpbin_new_jitterbuffer (GstElement * rtpbin, GstElement * jitterbuffer,
     guint session_id, guint ssrc, GstWebRTCBin * webrtc)
@@ -6033,6 +6388,13 @@ on_rtpbin_new_jitterbuffer (GstElement * rtpbin, GstElement * jitterbuffer,
   trans = (WebRTCTransceiver *) _find_transceiver (webrtc, &session_id,
       (FindTransceiverFunc) transceiver_match_for_mline);
 
+  if (trans && trans->forward_rtp
+      && !g_object_class_find_property (G_OBJECT_GET_CLASS (jitterbuffer),
+          "do-retransmission")) {
+    /* not a jitterbuffer, see on_rtpbin_request_jitterbuffer() */
+    return;
+  }
+
   if (trans) {
     /* We don't set do-retransmission on rtpbin as we want per-session control */
     g_object_set (jitterbuffer, "do-retransmission",
@@ -6087,6 +6449,8 @@ _create_rtpbin (GstWebRTCBin * webrtc)
       G_CALLBACK (on_rtpbin_request_aux_receiver), webrtc);
   g_signal_connect (rtpbin, "new-storage",
       G_CALLBACK (on_rtpbin_new_storage), webrtc);
+  g_signal_connect (rtpbin, "request-jitterbuffer",
+      G_CALLBACK (on_rtpbin_request_jitterbuffer), webrtc);
   g_signal_connect (rtpbin, "request-fec-decoder",
       G_CALLBACK (on_rtpbin_request_fec_decoder), webrtc);
   g_signal_connect (rtpbin, "request-fec-encoder",
@@ -6317,6 +6681,26 @@ gst_webrtc_bin_set_property (GObject * object, guint prop_id,
       webrtc->priv->jb_latency = g_value_get_uint (value);
       _update_rtpstorage_latency (webrtc);
       break;
+    case PROP_STATS_MAX_AGE:
+      PC_LOCK (webrtc);
+      webrtc->priv->stats_max_age = g_value_get_uint (value);
+      if (webrtc->priv->last_stats)
+        gst_structure_free (webrtc->priv->last_stats);
+      webrtc->priv->last_stats = NULL;
+      PC_UNLOCK (webrtc);
+      break;
+    case PROP_STATS_INTERVAL:
+      PC_LOCK (webrtc);
+      webrtc->priv->stats_interval = g_value_get_uint (value);
+      _update_stats_source (webrtc);
+      PC_UNLOCK (webrtc);
+      break;
+    case PROP_STATS_TYPES:
+      PC_LOCK (webrtc);
+      g_strfreev (webrtc->priv->stats_types);
+      webrtc->priv->stats_types = g_value_dup_boxed (value);
+      PC_UNLOCK (webrtc);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -6391,6 +6775,15 @@ gst_webrtc_bin_get_property (GObject * object, guint prop_id,
     case PROP_LATENCY:
       g_value_set_uint (value, webrtc->priv->jb_latency);
       break;
+    case PROP_STATS_MAX_AGE:
+      g_value_set_uint (value, webrtc->priv->stats_max_age);
+      break;
+    case PROP_STATS_INTERVAL:
+      g_value_set_uint (value, webrtc->priv->stats_interval);
+      break;
+    case PROP_STATS_TYPES:
+      g_value_set_boxed (value, webrtc->priv->stats_types);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -6480,6 +6873,13 @@ gst_webrtc_bin_finalize (GObject * object)
         (GDestroyNotify) gst_object_unref);
   webrtc->priv->pending_sink_transceivers = NULL;
 
+  if (webrtc->priv->last_stats)
+    gst_structure_free (webrtc->priv->last_stats);
+  webrtc->priv->last_stats = NULL;
+
+  g_strfreev (webrtc->priv->stats_types);
+  webrtc->priv->stats_types = NULL;
+
   if (webrtc->current_local_description)
     gst_webrtc_session_description_free (webrtc->current_local_description);
   webrtc->current_local_description = NULL;
@@ -6670,6 +7070,52 @@ gst_webrtc_bin_class_init (GstWebRTCBinClass * klass)
           "Default duration to buffer in the jitterbuffers (in ms)",
           0, G_MAXUINT, 200, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstWebRTCBin:stats-max-age:
+   *
+   * Maximum age (in ms) of the peerconnection statistics returned by
+   * #GstWebRTCBin::get-stats without a pad.  Within that time the previously
+   * collected statistics are returned instead of querying all the sessions
+   * and transports again.  0 always collects new statistics.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class,
+      PROP_STATS_MAX_AGE,
+      g_param_spec_uint ("stats-max-age", "Stats Max Age",
+          "Maximum age of cached peerconnection statistics (in ms, 0 = disabled)",
+          0, G_MAXUINT, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstWebRTCBin:stats-interval:
+   *
+   * Interval (in ms) at which #GstWebRTCBin::on-stats is emitted.  0 disables
+   * the periodic statistics notification.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class,
+      PROP_STATS_INTERVAL,
+      g_param_spec_uint ("stats-interval", "Stats Interval",
+          "Interval at which the on-stats signal is emitted (in ms, 0 = disabled)",
+          0, G_MAXUINT, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstWebRTCBin:stats-types:
+   *
+   * The #GstWebRTCStatsType nicks (e.g. "inbound-rtp") to include in the
+   * statistics emitted by #GstWebRTCBin::on-stats.  %NULL includes all of
+   * them.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class,
+      PROP_STATS_TYPES,
+      g_param_spec_boxed ("stats-types", "Stats Types",
+          "Types of statistics to include in the on-stats signal "
+          "(NULL = all)", G_TYPE_STRV,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /**
    * GstWebRTCBin::create-offer:
    * @object: the #webrtcbin
@@ -6846,6 +7292,22 @@ gst_webrtc_bin_class_init (GstWebRTCBinClass * klass)
       G_SIGNAL_RUN_LAST, 0, NULL, NULL, NULL,
       G_TYPE_NONE, 1, GST_TYPE_WEBRTC_DATA_CHANNEL);
 
+  /**
+   * GstWebRTCBin::on-stats:
+   * @object: the #GstWebRTCBin
+   * @stats: the statistics, in the same format as returned by
+   *   #GstWebRTCBin::get-stats and restricted to #GstWebRTCBin:stats-types
+   *
+   * Emitted every #GstWebRTCBin:stats-interval milliseconds from the
+   * peerconnection thread.
+   *
+   * Since: 1.20
+   */
+  gst_webrtc_bin_signals[ON_STATS_SIGNAL] =
+      g_signal_new ("on-stats", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST, 0, NULL, NULL, NULL,
+      G_TYPE_NONE, 1, GST_TYPE_STRUCTURE | G_SIGNAL_TYPE_STATIC_SCOPE);
+
   /**
    * GstWebRTCBin::add-transceiver:
    * @object: the #webrtcbin
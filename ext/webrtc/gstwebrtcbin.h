@@ -141,6 +141,15 @@ struct _GstWebRTCBinPrivate
   GstWebRTCSessionDescription *last_generated_answer;
 
   gboolean tos_attached;
+
+  /* stats caching and periodic stats notification, protected by the pc
+   * lock */
+  guint stats_max_age;
+  GstStructure *last_stats;
+  gint64 last_stats_time;
+  guint stats_interval;
+  gchar **stats_types;
+  GSource *stats_source;
 };
 
 typedef void (*GstWebRTCBinFunc) (GstWebRTCBin * webrtc, gpointer data);
@@ -58,6 +58,7 @@ enum
   PROP_ICE_UDP,
   PROP_MIN_RTP_PORT,
   PROP_MAX_RTP_PORT,
+  PROP_ICE_LITE,
 };
 
 static guint gst_webrtc_ice_signals[LAST_SIGNAL] = { 0 };
@@ -77,6 +78,8 @@ struct _GstWebRTCICEPrivate
   GstWebRTCIceOnCandidateFunc on_candidate;
   gpointer on_candidate_data;
   GDestroyNotify on_candidate_notify;
+
+  gboolean ice_lite;
 };
 
 #define gst_webrtc_ice_parent_class parent_class
@@ -428,12 +431,16 @@ gst_webrtc_ice_add_stream (GstWebRTCICE * ice, guint session_id)
     return 0;
   }
 
-  if (ice->stun_server) {
+  /* an ICE-lite agent only ever offers host candidates */
+  if (ice->stun_server && !ice->priv->ice_lite) {
     _add_stun_server (ice, ice->stun_server);
   }
 
   item = _create_nice_stream_item (ice, session_id);
 
+  if (ice->priv->ice_lite)
+    return item->stream;
+
   if (ice->turn_server) {
     _add_turn_server (ice, item, ice->turn_server);
   }
@@ -978,6 +985,62 @@ gst_webrtc_ice_get_turn_server (GstWebRTCICE * ice)
     return NULL;
 }
 
+static NiceAgent *
+_create_nice_agent (GstWebRTCICE * ice, gboolean ice_lite)
+{
+  NiceAgentOption options = 0;
+  NiceAgent *agent;
+
+  options |= NICE_AGENT_OPTION_ICE_TRICKLE;
+  options |= NICE_AGENT_OPTION_REGULAR_NOMINATION;
+  if (ice_lite)
+    options |= NICE_AGENT_OPTION_LITE_MODE;
+
+  agent = nice_agent_new_full (ice->priv->main_context,
+      NICE_COMPATIBILITY_RFC5245, options);
+  g_signal_connect (agent, "new-candidate-full",
+      G_CALLBACK (_on_new_candidate), ice);
+
+  return agent;
+}
+
+static void
+_set_ice_lite (GstWebRTCICE * ice, gboolean ice_lite)
+{
+  NiceAgent *agent;
+  gboolean ice_tcp, ice_udp, force_relay;
+
+  if (ice->priv->ice_lite == ice_lite)
+    return;
+
+  /* the lite mode can only be chosen when creating the agent */
+  if (ice->priv->nice_stream_map->len > 0) {
+    g_warning ("Cannot change ice-lite after streams have been added");
+    return;
+  }
+
+  GST_DEBUG_OBJECT (ice, "%s ICE-lite mode", ice_lite ? "Enabling" :
+      "Disabling");
+
+  g_object_get (ice->priv->nice_agent, "ice-tcp", &ice_tcp, "ice-udp",
+      &ice_udp, "force-relay", &force_relay, NULL);
+
+  agent = _create_nice_agent (ice, ice_lite);
+  g_object_set (agent, "ice-tcp", ice_tcp, "ice-udp", ice_udp, "force-relay",
+      force_relay, NULL);
+
+  g_signal_handlers_disconnect_by_data (ice->priv->nice_agent, ice);
+  g_object_unref (ice->priv->nice_agent);
+  ice->priv->nice_agent = agent;
+  ice->priv->ice_lite = ice_lite;
+}
+
+gboolean
+gst_webrtc_ice_get_is_lite (GstWebRTCICE * ice)
+{
+  return ice->priv->ice_lite;
+}
+
 static void
 gst_webrtc_ice_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -1008,6 +1071,10 @@ gst_webrtc_ice_set_property (GObject * object, guint prop_id,
             " min-rtp-port %u", ice->max_rtp_port, ice->min_rtp_port);
       break;
 
+    case PROP_ICE_LITE:
+      _set_ice_lite (ice, g_value_get_boolean (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1041,6 +1108,10 @@ gst_webrtc_ice_get_property (GObject * object, guint prop_id,
       g_value_set_uint (value, ice->max_rtp_port);
       break;
 
+    case PROP_ICE_LITE:
+      g_value_set_boolean (value, ice->priv->ice_lite);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1082,17 +1153,10 @@ static void
 gst_webrtc_ice_constructed (GObject * object)
 {
   GstWebRTCICE *ice = GST_WEBRTC_ICE (object);
-  NiceAgentOption options = 0;
 
   _start_thread (ice);
 
-  options |= NICE_AGENT_OPTION_ICE_TRICKLE;
-  options |= NICE_AGENT_OPTION_REGULAR_NOMINATION;
-
-  ice->priv->nice_agent = nice_agent_new_full (ice->priv->main_context,
-      NICE_COMPATIBILITY_RFC5245, options);
-  g_signal_connect (ice->priv->nice_agent, "new-candidate-full",
-      G_CALLBACK (_on_new_candidate), ice);
+  ice->priv->nice_agent = _create_nice_agent (ice, ice->priv->ice_lite);
 
   G_OBJECT_CLASS (parent_class)->constructed (object);
 }
@@ -1158,6 +1222,23 @@ gst_webrtc_ice_class_init (GstWebRTCICEClass * klass)
           0, 65535, 65535,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstWebRTCICE:ice-lite:
+   *
+   * Whether to act as an ICE-lite agent (RFC 8445 section 2.5), as is
+   * typical for servers with a public IP address.  Only host candidates are
+   * gathered, no STUN or TURN servers are used and connectivity checks are
+   * only answered.  Must be set before any stream is added and before setting
+   * any other property.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class,
+      PROP_ICE_LITE,
+      g_param_spec_boolean ("ice-lite", "ICE lite",
+          "Whether to act as an ICE-lite agent",
+          FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /**
    * GstWebRTCICE::add-local-ip-address:
    * @object: the #GstWebRTCICE
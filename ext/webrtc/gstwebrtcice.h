@@ -88,6 +88,7 @@ gboolean                    gst_webrtc_ice_add_turn_server          (GstWebRTCIC
 void                        gst_webrtc_ice_set_is_controller        (GstWebRTCICE * ice,
                                                                      gboolean controller);
 gboolean                    gst_webrtc_ice_get_is_controller        (GstWebRTCICE * ice);
+gboolean                    gst_webrtc_ice_get_is_lite              (GstWebRTCICE * ice);
 void                        gst_webrtc_ice_set_force_relay          (GstWebRTCICE * ice,
                                                                      gboolean force_relay);
 void                        gst_webrtc_ice_set_stun_server          (GstWebRTCICE * ice,
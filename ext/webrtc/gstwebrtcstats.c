@@ -46,6 +46,15 @@ _init_debug (void)
   }
 }
 
+/* state shared by all pads of one gst_webrtc_bin_create_stats() call so
+ * that sections common to several pads are only computed once */
+typedef struct
+{
+  GstStructure *s;
+  /* session id -> GValueArray of rtpsession source stats */
+  GHashTable *source_stats;
+} StatsContext;
+
 static double
 monotonic_time_as_double_milliseconds (void)
 {
@@ -678,14 +687,48 @@ _get_stats_from_dtls_transport (GstWebRTCBin * webrtc,
   return id;
 }
 
+static GValueArray *
+_get_source_stats (GstWebRTCBin * webrtc, TransportStream * stream,
+    StatsContext * ctx)
+{
+  GValueArray *source_stats;
+  GObject *rtp_session;
+  GstStructure *rtp_stats;
+
+  /* with bundling all pads share the same rtp session, only retrieve its
+   * (potentially large) stats once */
+  source_stats = g_hash_table_lookup (ctx->source_stats,
+      GUINT_TO_POINTER (stream->session_id));
+  if (source_stats)
+    return source_stats;
+
+  g_signal_emit_by_name (webrtc->rtpbin, "get-internal-session",
+      stream->session_id, &rtp_session);
+  g_object_get (rtp_session, "stats", &rtp_stats, NULL);
+
+  gst_structure_get (rtp_stats, "source-stats", G_TYPE_VALUE_ARRAY,
+      &source_stats, NULL);
+
+  GST_DEBUG_OBJECT (webrtc, "retrieved rtp stream stats from transport %"
+      GST_PTR_FORMAT " rtp session %" GST_PTR_FORMAT " with %u rtp sources",
+      stream, rtp_session, source_stats->n_values);
+
+  g_hash_table_insert (ctx->source_stats,
+      GUINT_TO_POINTER (stream->session_id), source_stats);
+
+  g_object_unref (rtp_session);
+  gst_structure_free (rtp_stats);
+
+  return source_stats;
+}
+
 static void
 _get_stats_from_transport_channel (GstWebRTCBin * webrtc,
     TransportStream * stream, const gchar * codec_id, guint ssrc,
-    guint clock_rate, GstStructure * s)
+    guint clock_rate, StatsContext * ctx)
 {
+  GstStructure *s = ctx->s;
   GstWebRTCDTLSTransport *transport;
-  GObject *rtp_session;
-  GstStructure *rtp_stats;
   GValueArray *source_stats;
   gchar *transport_id;
   double ts;
@@ -697,19 +740,14 @@ _get_stats_from_transport_channel (GstWebRTCBin * webrtc,
   if (!transport)
     return;
 
-  g_signal_emit_by_name (webrtc->rtpbin, "get-internal-session",
-      stream->session_id, &rtp_session);
-  g_object_get (rtp_session, "stats", &rtp_stats, NULL);
-
-  gst_structure_get (rtp_stats, "source-stats", G_TYPE_VALUE_ARRAY,
-      &source_stats, NULL);
-
-  GST_DEBUG_OBJECT (webrtc, "retrieving rtp stream stats from transport %"
-      GST_PTR_FORMAT " rtp session %" GST_PTR_FORMAT " with %u rtp sources, "
-      "transport %" GST_PTR_FORMAT, stream, rtp_session, source_stats->n_values,
-      transport);
+  source_stats = _get_source_stats (webrtc, stream, ctx);
 
-  transport_id = _get_stats_from_dtls_transport (webrtc, transport, s);
+  transport_id = g_strdup_printf ("transport-stats_%s",
+      GST_OBJECT_NAME (transport));
+  if (!gst_structure_has_field (s, transport_id)) {
+    g_free (transport_id);
+    transport_id = _get_stats_from_dtls_transport (webrtc, transport, s);
+  }
 
   /* construct stats objects */
   for (i = 0; i < source_stats->n_values; i++) {
@@ -731,9 +769,6 @@ _get_stats_from_transport_channel (GstWebRTCBin * webrtc,
           clock_rate, codec_id, transport_id, s);
   }
 
-  g_object_unref (rtp_session);
-  gst_structure_free (rtp_stats);
-  g_value_array_free (source_stats);
   g_free (transport_id);
 }
 
@@ -791,8 +826,9 @@ _get_codec_stats_from_pad (GstWebRTCBin * webrtc, GstPad * pad,
 }
 
 static gboolean
-_get_stats_from_pad (GstWebRTCBin * webrtc, GstPad * pad, GstStructure * s)
+_get_stats_from_pad (GstWebRTCBin * webrtc, GstPad * pad, StatsContext * ctx)
 {
+  GstStructure *s = ctx->s;
   GstWebRTCBinPad *wpad = GST_WEBRTC_BIN_PAD (pad);
   TransportStream *stream;
   gchar *codec_id;
@@ -808,7 +844,7 @@ _get_stats_from_pad (GstWebRTCBin * webrtc, GstPad * pad, GstStructure * s)
     goto out;
 
   _get_stats_from_transport_channel (webrtc, stream, codec_id, ssrc,
-      clock_rate, s);
+      clock_rate, ctx);
 
 out:
   g_free (codec_id);
@@ -821,13 +857,13 @@ gst_webrtc_bin_create_stats (GstWebRTCBin * webrtc, GstPad * pad)
   GstStructure *s = gst_structure_new_empty ("application/x-webrtc-stats");
   double ts = monotonic_time_as_double_milliseconds ();
   GstStructure *pc_stats;
+  StatsContext ctx;
 
   _init_debug ();
 
   gst_structure_set (s, "timestamp", G_TYPE_DOUBLE, ts, NULL);
 
   /* FIXME: better unique IDs */
-  /* FIXME: rate limitting stat updates? */
   /* FIXME: all stats need to be kept forever */
 
   GST_DEBUG_OBJECT (webrtc, "updating stats at time %f", ts);
@@ -839,13 +875,54 @@ gst_webrtc_bin_create_stats (GstWebRTCBin * webrtc, GstPad * pad)
     gst_structure_free (pc_stats);
   }
 
+  ctx.s = s;
+  ctx.source_stats = g_hash_table_new_full (NULL, NULL, NULL,
+      (GDestroyNotify) g_value_array_free);
+
   if (pad)
-    _get_stats_from_pad (webrtc, pad, s);
+    _get_stats_from_pad (webrtc, pad, &ctx);
   else
     gst_element_foreach_pad (GST_ELEMENT (webrtc),
-        (GstElementForeachPadFunc) _get_stats_from_pad, s);
+        (GstElementForeachPadFunc) _get_stats_from_pad, &ctx);
+
+  g_hash_table_unref (ctx.source_stats);
 
   gst_structure_remove_field (s, "timestamp");
 
   return s;
 }
+
+static gboolean
+_filter_stats_type (GQuark field_id, GValue * value, gchar ** types)
+{
+  const GstStructure *stats;
+  GstWebRTCStatsType type;
+  gchar *name;
+  gboolean ret;
+
+  if (!GST_VALUE_HOLDS_STRUCTURE (value))
+    return TRUE;
+
+  stats = gst_value_get_structure (value);
+  if (!gst_structure_get_enum (stats, "type", GST_TYPE_WEBRTC_STATS_TYPE,
+          (gint *) & type))
+    return TRUE;
+
+  name = _enum_value_to_string (GST_TYPE_WEBRTC_STATS_TYPE, type);
+  ret = name && g_strv_contains ((const gchar * const *) types, name);
+  g_free (name);
+
+  return ret;
+}
+
+/* Removes all the stats from @stats whose type nick is not contained in
+ * @types, e.g. "inbound-rtp".  A %NULL @types keeps everything. */
+void
+gst_webrtc_bin_filter_stats (GstStructure * stats, gchar ** types)
+{
+  if (!types)
+    return;
+
+  gst_structure_filter_and_map_in_place (stats,
+      (GstStructureFilterMapFunc) _filter_stats_type, types);
+}
@@ -715,16 +715,14 @@ _is_within_max_message_size (WebRTCDataChannel * channel, gsize size)
   return size <= channel->sctp_transport->max_message_size;
 }
 
-static void
-webrtc_data_channel_send_data (GstWebRTCDataChannel * base_channel,
-    GBytes * bytes)
+/* Wraps @bytes without copying, returns NULL if it is too large */
+static GstBuffer *
+_create_data_buffer (WebRTCDataChannel * channel, GBytes * bytes)
 {
-  WebRTCDataChannel *channel = WEBRTC_DATA_CHANNEL (base_channel);
   GstSctpSendMetaPartiallyReliability reliability;
   guint rel_param;
   guint32 ppid;
   GstBuffer *buffer;
-  GstFlowReturn ret;
 
   if (!bytes) {
     buffer = gst_buffer_new ();
@@ -734,7 +732,7 @@ webrtc_data_channel_send_data (GstWebRTCDataChannel * base_channel,
     guint8 *data;
 
     data = (guint8 *) g_bytes_get_data (bytes, &size);
-    g_return_if_fail (data != NULL);
+    g_return_val_if_fail (data != NULL, NULL);
     if (!_is_within_max_message_size (channel, size)) {
       GError *error = NULL;
       g_set_error (&error, GST_WEBRTC_BIN_ERROR,
@@ -743,7 +741,7 @@ webrtc_data_channel_send_data (GstWebRTCDataChannel * base_channel,
       _channel_store_error (channel, error);
       _channel_enqueue_task (channel, (ChannelTask) _close_procedure, NULL,
           NULL);
-      return;
+      return NULL;
     }
 
     buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY, data, size,
@@ -755,6 +753,21 @@ webrtc_data_channel_send_data (GstWebRTCDataChannel * base_channel,
   gst_sctp_buffer_add_send_meta (buffer, ppid, channel->parent.ordered,
       reliability, rel_param);
 
+  return buffer;
+}
+
+static void
+webrtc_data_channel_send_data (GstWebRTCDataChannel * base_channel,
+    GBytes * bytes)
+{
+  WebRTCDataChannel *channel = WEBRTC_DATA_CHANNEL (base_channel);
+  GstBuffer *buffer;
+  GstFlowReturn ret;
+
+  buffer = _create_data_buffer (channel, bytes);
+  if (!buffer)
+    return;
+
   GST_LOG_OBJECT (channel, "Sending data using buffer %" GST_PTR_FORMAT,
       buffer);
 
@@ -773,6 +786,50 @@ webrtc_data_channel_send_data (GstWebRTCDataChannel * base_channel,
   }
 }
 
+static void
+webrtc_data_channel_send_data_list (GstWebRTCDataChannel * base_channel,
+    GPtrArray * data)
+{
+  WebRTCDataChannel *channel = WEBRTC_DATA_CHANNEL (base_channel);
+  GstBufferList *list;
+  GstFlowReturn ret;
+  guint i;
+
+  if (data->len == 0)
+    return;
+
+  list = gst_buffer_list_new_sized (data->len);
+  for (i = 0; i < data->len; i++) {
+    GstBuffer *buffer = _create_data_buffer (channel,
+        g_ptr_array_index (data, i));
+
+    /* The channel is being closed, drop the whole list */
+    if (!buffer) {
+      gst_buffer_list_unref (list);
+      return;
+    }
+    gst_buffer_list_add (list, buffer);
+  }
+
+  GST_LOG_OBJECT (channel, "Sending %u data messages", data->len);
+
+  /* Push all messages at once, sctpenc still sends each one as a separate
+   * SCTP message with its own ppid and reliability settings */
+  GST_WEBRTC_DATA_CHANNEL_LOCK (channel);
+  channel->parent.buffered_amount += gst_buffer_list_calculate_size (list);
+  GST_WEBRTC_DATA_CHANNEL_UNLOCK (channel);
+
+  ret = gst_app_src_push_buffer_list (GST_APP_SRC (channel->appsrc), list);
+
+  if (ret != GST_FLOW_OK) {
+    GError *error = NULL;
+    g_set_error (&error, GST_WEBRTC_BIN_ERROR,
+        GST_WEBRTC_BIN_ERROR_DATA_CHANNEL_FAILURE, "Failed to send data");
+    _channel_store_error (channel, error);
+    _channel_enqueue_task (channel, (ChannelTask) _close_procedure, NULL, NULL);
+  }
+}
+
 static void
 webrtc_data_channel_send_string (GstWebRTCDataChannel * base_channel,
     const gchar * str)
@@ -966,6 +1023,7 @@ webrtc_data_channel_class_init (WebRTCDataChannelClass * klass)
 
   channel_class->send_data = webrtc_data_channel_send_data;
   channel_class->send_string = webrtc_data_channel_send_string;
+  channel_class->send_data_list = webrtc_data_channel_send_data_list;
   channel_class->close = webrtc_data_channel_close;
 }
 
@@ -37,6 +37,7 @@ G_DEFINE_TYPE_WITH_CODE (WebRTCTransceiver, webrtc_transceiver,
 #define DEFAULT_FEC_TYPE GST_WEBRTC_FEC_TYPE_NONE
 #define DEFAULT_DO_NACK FALSE
 #define DEFAULT_FEC_PERCENTAGE 100
+#define DEFAULT_FORWARD_RTP FALSE
 
 enum
 {
@@ -45,6 +46,7 @@ enum
   PROP_FEC_TYPE,
   PROP_FEC_PERCENTAGE,
   PROP_DO_NACK,
+  PROP_FORWARD_RTP,
 };
 
 void
@@ -111,6 +113,9 @@ webrtc_transceiver_set_property (GObject * object, guint prop_id,
     case PROP_FEC_PERCENTAGE:
       trans->fec_percentage = g_value_get_uint (value);
       break;
+    case PROP_FORWARD_RTP:
+      trans->forward_rtp = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -135,6 +140,9 @@ webrtc_transceiver_get_property (GObject * object, guint prop_id,
     case PROP_FEC_PERCENTAGE:
       g_value_set_uint (value, trans->fec_percentage);
       break;
+    case PROP_FORWARD_RTP:
+      g_value_set_boolean (value, trans->forward_rtp);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -203,6 +211,16 @@ webrtc_transceiver_class_init (WebRTCTransceiverClass * klass)
           "The amount of Forward Error Correction to apply",
           0, 100, DEFAULT_FEC_PERCENTAGE,
           G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /* received packets are output as soon as they are decrypted, without
+   * reordering or retransmission requests, for relaying them to other peers.
+   * Needs to be set before the first packet is received. */
+  g_object_class_install_property (gobject_class,
+      PROP_FORWARD_RTP,
+      g_param_spec_boolean ("forward-rtp", "Forward RTP",
+          "Output received RTP packets without jitterbuffering",
+          DEFAULT_FORWARD_RTP,
+          G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
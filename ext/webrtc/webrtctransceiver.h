@@ -46,6 +46,7 @@ struct _WebRTCTransceiver
   GstWebRTCFECType         fec_type;
   guint                    fec_percentage;
   gboolean                 do_nack;
+  gboolean                 forward_rtp;
 
   GstCaps                  *last_configured_caps;
 };
@@ -328,8 +328,10 @@ webrtc_error_to_string (gint err)
   return str;
 }
 
+/* takes @n_periods periods of 10ms at once, so that they are processed and
+ * pushed as one buffer */
 static GstBuffer *
-gst_webrtc_dsp_take_buffer (GstWebrtcDsp * self)
+gst_webrtc_dsp_take_buffer (GstWebrtcDsp * self, guint n_periods)
 {
   GstBuffer *buffer;
   GstClockTime timestamp;
@@ -346,17 +348,18 @@ gst_webrtc_dsp_take_buffer (GstWebrtcDsp * self)
   timestamp += gst_util_uint64_scale_int (distance, GST_SECOND, self->info.rate);
 
   if (self->interleaved) {
-    buffer = gst_adapter_take_buffer (self->adapter, self->period_size);
+    buffer = gst_adapter_take_buffer (self->adapter,
+        n_periods * self->period_size);
     at_discont = (gst_adapter_pts_at_discont (self->adapter) == timestamp);
   } else {
     buffer = gst_planar_audio_adapter_take_buffer (self->padapter,
-        self->period_samples, GST_MAP_READWRITE);
+        n_periods * self->period_samples, GST_MAP_READWRITE);
     at_discont =
         (gst_planar_audio_adapter_pts_at_discont (self->padapter) == timestamp);
   }
 
   GST_BUFFER_PTS (buffer) = timestamp;
-  GST_BUFFER_DURATION (buffer) = 10 * GST_MSECOND;
+  GST_BUFFER_DURATION (buffer) = n_periods * 10 * GST_MSECOND;
 
   if (at_discont && distance == 0) {
     GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
@@ -459,13 +462,22 @@ gst_webrtc_vad_post_message (GstWebrtcDsp *self, GstClockTime timestamp,
       gst_message_new_element (GST_OBJECT (self), s));
 }
 
+/* Processes all the periods of @buffer in place. The reverse stream is
+ * analyzed before each period, as the echo canceller expects. Non-interleaved
+ * periods are passed to webrtc as pointers into the buffer, interleaved
+ * ones go through a single AudioFrame reused for every period. */
 static GstFlowReturn
 gst_webrtc_dsp_process_stream (GstWebrtcDsp * self,
-    GstBuffer * buffer)
+    GstBuffer * buffer, guint n_periods)
 {
   GstAudioBuffer abuf;
   webrtc::AudioProcessing * apm = self->apm;
-  gint err;
+  webrtc::AudioFrame frame;
+  webrtc::StreamConfig config (self->info.rate, self->info.channels, false);
+  GstFlowReturn ret = GST_FLOW_OK;
+  float **data = NULL;
+  guint i;
+  gint c, err;
 
   if (!gst_audio_buffer_map (&abuf, &self->info, buffer,
           (GstMapFlags) GST_MAP_READWRITE)) {
@@ -474,39 +486,53 @@ gst_webrtc_dsp_process_stream (GstWebrtcDsp * self,
   }
 
   if (self->interleaved) {
-    webrtc::AudioFrame frame;
     frame.num_channels_ = self->info.channels;
     frame.sample_rate_hz_ = self->info.rate;
     frame.samples_per_channel_ = self->period_samples;
-
-    memcpy (frame.data_, abuf.planes[0], self->period_size);
-    err = apm->ProcessStream (&frame);
-    if (err >= 0)
-      memcpy (abuf.planes[0], frame.data_, self->period_size);
   } else {
-    float * const * data = (float * const *) abuf.planes;
-    webrtc::StreamConfig config (self->info.rate, self->info.channels, false);
-
-    err = apm->ProcessStream (data, config, config, data);
+    data = g_newa (float *, self->info.channels);
   }
 
-  if (err < 0) {
-    GST_WARNING_OBJECT (self, "Failed to filter the audio: %s.",
-        webrtc_error_to_string (err));
-  } else {
-    if (self->voice_detection) {
-      gboolean stream_has_voice = apm->voice_detection ()->stream_has_voice ();
+  for (i = 0; i < n_periods; i++) {
+    GstClockTime timestamp = GST_BUFFER_PTS (buffer) + i * 10 * GST_MSECOND;
 
-      if (stream_has_voice != self->stream_has_voice)
-        gst_webrtc_vad_post_message (self, GST_BUFFER_PTS (buffer), stream_has_voice);
+    ret = gst_webrtc_dsp_analyze_reverse_stream (self, timestamp);
+    if (ret != GST_FLOW_OK)
+      break;
+
+    if (self->interleaved) {
+      guint8 *period = (guint8 *) abuf.planes[0] + i * self->period_size;
 
-      self->stream_has_voice = stream_has_voice;
+      memcpy (frame.data_, period, self->period_size);
+      err = apm->ProcessStream (&frame);
+      if (err >= 0)
+        memcpy (period, frame.data_, self->period_size);
+    } else {
+      for (c = 0; c < self->info.channels; c++)
+        data[c] = (float *) abuf.planes[c] + i * self->period_samples;
+
+      err = apm->ProcessStream (data, config, config, data);
+    }
+
+    if (err < 0) {
+      GST_WARNING_OBJECT (self, "Failed to filter the audio: %s.",
+          webrtc_error_to_string (err));
+    } else {
+      if (self->voice_detection) {
+        gboolean stream_has_voice =
+            apm->voice_detection ()->stream_has_voice ();
+
+        if (stream_has_voice != self->stream_has_voice)
+          gst_webrtc_vad_post_message (self, timestamp, stream_has_voice);
+
+        self->stream_has_voice = stream_has_voice;
+      }
     }
   }
 
   gst_audio_buffer_unmap (&abuf);
 
-  return GST_FLOW_OK;
+  return ret;
 }
 
 static GstFlowReturn
@@ -540,27 +566,23 @@ static GstFlowReturn
 gst_webrtc_dsp_generate_output (GstBaseTransform * btrans, GstBuffer ** outbuf)
 {
   GstWebrtcDsp *self = GST_WEBRTC_DSP (btrans);
-  GstFlowReturn ret;
-  gboolean not_enough;
+  guint n_periods;
 
+  /* all the complete periods available are processed in one go */
   if (self->interleaved)
-    not_enough = gst_adapter_available (self->adapter) < self->period_size;
+    n_periods = gst_adapter_available (self->adapter) / self->period_size;
   else
-    not_enough = gst_planar_audio_adapter_available (self->padapter) <
+    n_periods = gst_planar_audio_adapter_available (self->padapter) /
         self->period_samples;
 
-  if (not_enough) {
+  if (n_periods == 0) {
     *outbuf = NULL;
     return GST_FLOW_OK;
   }
 
-  *outbuf = gst_webrtc_dsp_take_buffer (self);
-  ret = gst_webrtc_dsp_analyze_reverse_stream (self, GST_BUFFER_PTS (*outbuf));
+  *outbuf = gst_webrtc_dsp_take_buffer (self, n_periods);
 
-  if (ret == GST_FLOW_OK)
-    ret = gst_webrtc_dsp_process_stream (self, *outbuf);
-
-  return ret;
+  return gst_webrtc_dsp_process_stream (self, *outbuf, n_periods);
 }
 
 static gboolean
@@ -26,6 +26,16 @@
  *
  * This element encodes raw video into H265 compressed data.
  *
+ * When adaptive quantization is enabled, #GstVideoRegionOfInterestMeta on
+ * the input buffers with a `roi/x265` parameter structure containing an
+ * integer `delta-qp` field are applied as quantizer offsets to the blocks
+ * they cover.
+ *
+ * Several encoders running on the same machine each create their own x265
+ * thread pools, so they should be given partitions of the machine with
+ * #GstX265Enc:pools and #GstX265Enc:frame-threads to avoid oversubscribing
+ * it.
+ *
  **/
 
 #ifdef HAVE_CONFIG_H
@@ -60,7 +70,9 @@ enum
   PROP_X265_LOG_LEVEL,
   PROP_SPEED_PRESET,
   PROP_TUNE,
-  PROP_KEY_INT_MAX
+  PROP_KEY_INT_MAX,
+  PROP_POOLS,
+  PROP_FRAME_THREADS
 };
 
 #define PROP_BITRATE_DEFAULT            (2 * 1024)
@@ -70,6 +82,12 @@ enum
 #define PROP_SPEED_PRESET_DEFAULT        6      /* Medium */
 #define PROP_TUNE_DEFAULT                2      /* SSIM   */
 #define PROP_KEY_INT_MAX_DEFAULT         0      /* x265 lib default */
+#define PROP_POOLS_DEFAULT               NULL   /* x265 lib default */
+#define PROP_FRAME_THREADS_DEFAULT       0      /* x265 lib default */
+
+/* x265 copies the input planes into its own frames, which are aligned to
+ * this many bytes */
+#define X265_ENC_STRIDE_ALIGN            64
 
 #define GST_X265_ENC_LOG_LEVEL_TYPE (gst_x265_enc_log_level_get_type())
 static GType
@@ -522,6 +540,35 @@ gst_x265_enc_class_init (GstX265EncClass * klass)
           "Maximal distance between two key-frames (0 = x265 default / 250)",
           0, G_MAXINT32, PROP_KEY_INT_MAX_DEFAULT, G_PARAM_READWRITE));
 
+  /**
+   * GstX265Enc:pools:
+   *
+   * x265 thread pools to create, as a comma separated list of the number of
+   * threads on each NUMA node, with `+` for all of the threads of a node and
+   * `-` for none. For example `-,+` only uses the second node and `8` uses
+   * 8 threads of the first node. See the x265 `pools` option.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_POOLS,
+      g_param_spec_string ("pools", "Pools",
+          "Thread pools per NUMA node, as in the x265 pools option "
+          "(NULL = x265 default / all cores)", PROP_POOLS_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstX265Enc:frame-threads:
+   *
+   * Number of frames encoded concurrently.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_FRAME_THREADS,
+      g_param_spec_uint ("frame-threads", "Frame threads",
+          "Number of concurrently encoded frames (0 = x265 default / auto)",
+          0, 16, PROP_FRAME_THREADS_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (element_class,
       "x265enc", "Codec/Encoder/Video", "H265 Encoder",
       "Thijs Vermeir <thijs.vermeir@barco.com>");
@@ -566,6 +613,8 @@ gst_x265_enc_init (GstX265Enc * encoder)
   encoder->speed_preset = PROP_SPEED_PRESET_DEFAULT;
   encoder->tune = PROP_TUNE_DEFAULT;
   encoder->keyintmax = PROP_KEY_INT_MAX_DEFAULT;
+  encoder->pools = g_strdup (PROP_POOLS_DEFAULT);
+  encoder->frame_threads = PROP_FRAME_THREADS_DEFAULT;
   encoder->api = &default_vtable;
 
   encoder->api->param_default (&encoder->x265param);
@@ -693,6 +742,7 @@ gst_x265_enc_finalize (GObject * object)
   gst_x265_enc_close_encoder (encoder);
 
   g_string_free (encoder->option_string_prop, TRUE);
+  g_free (encoder->pools);
 
   if (encoder->peer_profiles)
     g_ptr_array_free (encoder->peer_profiles, FALSE);
@@ -962,6 +1012,16 @@ gst_x265_enc_init_encoder_locked (GstX265Enc * encoder)
   }
 #endif
 
+  if (encoder->pools) {
+    GST_DEBUG_OBJECT (encoder, "Using pools: %s", encoder->pools);
+    if (encoder->api->param_parse (&encoder->x265param, "pools",
+            encoder->pools) < 0)
+      GST_WARNING_OBJECT (encoder, "Invalid pools: %s", encoder->pools);
+  }
+
+  if (encoder->frame_threads > 0)
+    encoder->x265param.frameNumThreads = encoder->frame_threads;
+
   /* apply option-string property */
   if (encoder->option_string_prop && encoder->option_string_prop->len) {
     GST_DEBUG_OBJECT (encoder, "Applying option-string: %s",
@@ -1434,12 +1494,119 @@ gst_x265_enc_finish (GstVideoEncoder * encoder)
 static gboolean
 gst_x265_enc_propose_allocation (GstVideoEncoder * encoder, GstQuery * query)
 {
+  GstCaps *caps;
+  gboolean need_pool;
+  GstVideoInfo info;
+
   gst_query_add_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
 
+  gst_query_parse_allocation (query, &caps, &need_pool);
+
+  /* Propose a pool with the alignment of the x265 frames to make its copy of
+   * the input as cheap as possible */
+  if (need_pool && caps && gst_video_info_from_caps (&info, caps) &&
+      gst_query_get_n_allocation_pools (query) == 0) {
+    GstBufferPool *pool;
+    GstStructure *config;
+    GstVideoAlignment align;
+    GstAllocationParams params;
+    guint i, size;
+
+    gst_video_alignment_reset (&align);
+    for (i = 0; i < GST_VIDEO_MAX_PLANES; i++)
+      align.stride_align[i] = X265_ENC_STRIDE_ALIGN - 1;
+    gst_video_info_align (&info, &align);
+
+    gst_allocation_params_init (&params);
+    params.align = X265_ENC_STRIDE_ALIGN - 1;
+
+    pool = gst_video_buffer_pool_new ();
+    config = gst_buffer_pool_get_config (pool);
+    gst_buffer_pool_config_set_params (config, caps, info.size, 0, 0);
+    gst_buffer_pool_config_set_allocator (config, NULL, &params);
+    gst_buffer_pool_config_add_option (config,
+        GST_BUFFER_POOL_OPTION_VIDEO_META);
+    gst_buffer_pool_config_add_option (config,
+        GST_BUFFER_POOL_OPTION_VIDEO_ALIGNMENT);
+    gst_buffer_pool_config_set_video_alignment (config, &align);
+
+    if (gst_buffer_pool_set_config (pool, config)) {
+      config = gst_buffer_pool_get_config (pool);
+      gst_buffer_pool_config_get_params (config, NULL, &size, NULL, NULL);
+      gst_structure_free (config);
+
+      gst_query_add_allocation_pool (query, pool, size, 0, 0);
+      gst_query_add_allocation_param (query, NULL, &params);
+    } else {
+      GST_WARNING_OBJECT (encoder, "Failed to configure aligned pool");
+    }
+    gst_object_unref (pool);
+  }
+
   return GST_VIDEO_ENCODER_CLASS (parent_class)->propose_allocation (encoder,
       query);
 }
 
+#if (X265_BUILD >= 68)
+/* Returns the quant offsets of each x265 quantization group from the ROI
+ * metas of the frame, or NULL if there are none to apply */
+static float *
+gst_x265_enc_get_roi_quant_offsets (GstX265Enc * encoder,
+    GstVideoCodecFrame * frame)
+{
+  GstVideoInfo *info = &encoder->input_state->info;
+  GstVideoRegionOfInterestMeta *roi;
+  gpointer state = NULL;
+  float *offsets = NULL;
+  guint block_size, stride, rows;
+
+  if (!gst_buffer_get_meta (frame->input_buffer,
+          GST_VIDEO_REGION_OF_INTEREST_META_API_TYPE))
+    return NULL;
+
+  if (encoder->x265param.rc.aqMode == X265_AQ_NONE) {
+    GST_LOG_OBJECT (encoder, "Ignoring ROI, adaptive quantization disabled");
+    return NULL;
+  }
+
+  /* x265 takes one offset per 16x16 block, or 8x8 with a qg-size of 8 */
+  block_size = encoder->x265param.rc.qgSize == 8 ? 8 : 16;
+  stride = GST_ROUND_UP_16 (GST_VIDEO_INFO_WIDTH (info)) / block_size;
+  rows = GST_ROUND_UP_16 (GST_VIDEO_INFO_HEIGHT (info)) / block_size;
+
+  while ((roi = (GstVideoRegionOfInterestMeta *)
+          gst_buffer_iterate_meta_filtered (frame->input_buffer, &state,
+              GST_VIDEO_REGION_OF_INTEREST_META_API_TYPE))) {
+    GstStructure *s;
+    gint delta_qp;
+    guint x, y, x0, y0, x1, y1;
+
+    s = gst_video_region_of_interest_meta_get_param (roi, "roi/x265");
+    if (!s || !gst_structure_get_int (s, "delta-qp", &delta_qp))
+      continue;
+
+    GST_LOG_OBJECT (encoder, "Input buffer ROI: type=%s id=%d (%d, %d) %dx%d "
+        "delta-qp %d", g_quark_to_string (roi->roi_type), roi->id, roi->x,
+        roi->y, roi->w, roi->h, delta_qp);
+
+    x0 = MIN (roi->x / block_size, stride);
+    y0 = MIN (roi->y / block_size, rows);
+    x1 = MIN ((roi->x + roi->w + block_size - 1) / block_size, stride);
+    y1 = MIN ((roi->y + roi->h + block_size - 1) / block_size, rows);
+
+    if (!offsets)
+      offsets = g_new0 (float, stride * rows);
+
+    for (y = y0; y < y1; y++) {
+      for (x = x0; x < x1; x++)
+        offsets[y * stride + x] = CLAMP (delta_qp, -51, 51);
+    }
+  }
+
+  return offsets;
+}
+#endif
+
 /* chain function
  * this function does the actual processing
  */
@@ -1455,6 +1622,7 @@ gst_x265_enc_handle_frame (GstVideoEncoder * video_enc,
   FrameData *fdata;
   gint nplanes = 0;
   const x265_api *api = encoder->api;
+  float *quant_offsets = NULL;
 
   g_assert (api != NULL);
 
@@ -1480,9 +1648,16 @@ gst_x265_enc_handle_frame (GstVideoEncoder * video_enc,
   pic_in.dts = frame->dts;
   pic_in.bitDepth = info->finfo->depth[0];
   pic_in.userData = GINT_TO_POINTER (frame->system_frame_number);
+#if (X265_BUILD >= 68)
+  quant_offsets = gst_x265_enc_get_roi_quant_offsets (encoder, frame);
+  pic_in.quantOffsets = quant_offsets;
+#endif
 
   ret = gst_x265_enc_encode_frame (encoder, &pic_in, frame, &i_nal, TRUE);
 
+  /* x265 copied the offsets along with the picture */
+  g_free (quant_offsets);
+
   /* input buffer is released later on */
   return ret;
 
@@ -1677,6 +1852,13 @@ gst_x265_enc_set_property (GObject * object, guint prop_id,
     case PROP_KEY_INT_MAX:
       encoder->keyintmax = g_value_get_int (value);
       break;
+    case PROP_POOLS:
+      g_free (encoder->pools);
+      encoder->pools = g_value_dup_string (value);
+      break;
+    case PROP_FRAME_THREADS:
+      encoder->frame_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1724,6 +1906,12 @@ gst_x265_enc_get_property (GObject * object, guint prop_id,
     case PROP_KEY_INT_MAX:
       g_value_set_int (value, encoder->keyintmax);
       break;
+    case PROP_POOLS:
+      g_value_set_string (value, encoder->pools);
+      break;
+    case PROP_FRAME_THREADS:
+      g_value_set_uint (value, encoder->frame_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -63,6 +63,8 @@ struct _GstX265Enc
   gint tune;
   gint speed_preset;
   gint keyintmax;
+  gchar *pools;
+  guint frame_threads;
   GString *option_string_prop;  /* option-string property */
   /*GString *option_string; *//* used by set prop */
 
@@ -119,6 +119,7 @@ that the demux object and its streams are not changed by anybody else.
 #endif
 
 #include "gstadaptivedemux.h"
+#include "gstadaptivedemuxabr-private.h"
 #include "gst/gst-i18n-plugin.h"
 #include <gst/base/gstadapter.h>
 
@@ -129,6 +130,9 @@ GST_DEBUG_CATEGORY (adaptivedemux_debug);
 #define DEFAULT_FAILED_COUNT 3
 #define DEFAULT_CONNECTION_SPEED 0
 #define DEFAULT_BITRATE_LIMIT 0.8f
+#define DEFAULT_PREFETCH_DEPTH 0
+#define DEFAULT_ABR_POLICY GST_ADAPTIVE_DEMUX_ABR_POLICY_AVERAGE
+#define MAX_PREFETCH_DEPTH 16
 #define SRC_QUEUE_MAX_BYTES 20 * 1024 * 1024    /* For safety. Large enough to hold a segment. */
 #define NUM_LOOKBACK_FRAGMENTS 3
 
@@ -157,6 +161,8 @@ enum
   PROP_0,
   PROP_CONNECTION_SPEED,
   PROP_BITRATE_LIMIT,
+  PROP_PREFETCH_DEPTH,
+  PROP_ABR_POLICY,
   PROP_LAST
 };
 
@@ -207,8 +213,33 @@ struct _GstAdaptiveDemuxPrivate
   GMutex segment_lock;
 
   GstClockTime qos_earliest_time;
+
+  /* Download of upcoming fragments ahead of time */
+  guint prefetch_depth;         /* protected by manifest_lock */
+  GThreadPool *prefetch_pool;
+  GMutex prefetch_lock;
+  GCond prefetch_cond;          /* protected by prefetch_lock */
+
+  GstAdaptiveDemuxAbrPolicy abr_policy; /* protected by manifest_lock */
 };
 
+/* A fragment being fetched ahead of time. Owned by the stream's
+ * prefetch_queue and by the prefetch_pool thread downloading it */
+typedef struct _GstAdaptiveDemuxPrefetch
+{
+  gint ref_count;               /* ATOMIC */
+  GstUriDownloader *downloader;
+  gchar *uri;
+  gint64 range_start;
+  gint64 range_end;
+
+  /* protected by prefetch_lock */
+  gboolean done;
+  GstBuffer *buffer;
+  GstClockTime start_time;
+  GstClockTime download_time;
+} GstAdaptiveDemuxPrefetch;
+
 typedef struct _GstAdaptiveDemuxTimer
 {
   volatile gint ref_count;
@@ -292,6 +323,10 @@ gst_adaptive_demux_stream_fragment_download_finish (GstAdaptiveDemuxStream *
 static GstFlowReturn
 gst_adaptive_demux_stream_data_received_default (GstAdaptiveDemux * demux,
     GstAdaptiveDemuxStream * stream, GstBuffer * buffer);
+static void gst_adaptive_demux_prefetch_func (gpointer data,
+    gpointer user_data);
+static void gst_adaptive_demux_stream_clear_prefetch (GstAdaptiveDemuxStream *
+    stream);
 static GstFlowReturn
 gst_adaptive_demux_stream_finish_fragment_default (GstAdaptiveDemux * demux,
     GstAdaptiveDemuxStream * stream);
@@ -345,6 +380,35 @@ gst_adaptive_demux_get_instance_private (GstAdaptiveDemux * self)
   return (G_STRUCT_MEMBER_P (self, private_offset));
 }
 
+#define GST_TYPE_ADAPTIVE_DEMUX_ABR_POLICY (gst_adaptive_demux_abr_policy_get_type ())
+static GType
+gst_adaptive_demux_abr_policy_get_type (void)
+{
+  static GType abr_policy_type = 0;
+
+  if (!abr_policy_type) {
+    static const GEnumValue abr_policy_values[] = {
+      {GST_ADAPTIVE_DEMUX_ABR_POLICY_AVERAGE,
+          "Average of the last fragments download rates", "average"},
+      {GST_ADAPTIVE_DEMUX_ABR_POLICY_HARMONIC_MEAN,
+          "Harmonic mean of the last throughput samples", "harmonic-mean"},
+      {GST_ADAPTIVE_DEMUX_ABR_POLICY_EWMA,
+          "Lowest of a fast and a slow moving average of the throughput",
+          "ewma"},
+      {GST_ADAPTIVE_DEMUX_ABR_POLICY_BUFFER_BASED,
+            "Harmonic mean of the throughput, scaled down when the buffer "
+            "runs low", "buffer-based"},
+      {0, NULL, NULL},
+    };
+
+    abr_policy_type =
+        g_enum_register_static ("GstAdaptiveDemuxAbrPolicy",
+        abr_policy_values);
+  }
+
+  return abr_policy_type;
+}
+
 static void
 gst_adaptive_demux_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -363,6 +427,12 @@ gst_adaptive_demux_set_property (GObject * object, guint prop_id,
     case PROP_BITRATE_LIMIT:
       demux->bitrate_limit = g_value_get_float (value);
       break;
+    case PROP_PREFETCH_DEPTH:
+      demux->priv->prefetch_depth = g_value_get_uint (value);
+      break;
+    case PROP_ABR_POLICY:
+      demux->priv->abr_policy = g_value_get_enum (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -387,6 +457,12 @@ gst_adaptive_demux_get_property (GObject * object, guint prop_id,
     case PROP_BITRATE_LIMIT:
       g_value_set_float (value, demux->bitrate_limit);
       break;
+    case PROP_PREFETCH_DEPTH:
+      g_value_set_uint (value, demux->priv->prefetch_depth);
+      break;
+    case PROP_ABR_POLICY:
+      g_value_set_enum (value, demux->priv->abr_policy);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -432,6 +508,38 @@ gst_adaptive_demux_class_init (GstAdaptiveDemuxClass * klass)
           0, 1, DEFAULT_BITRATE_LIMIT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstAdaptiveDemux:prefetch-depth:
+   *
+   * Number of upcoming fragments of each stream that are downloaded
+   * concurrently with the current one and kept in memory until needed.
+   * Only used by subclasses implementing
+   * #GstAdaptiveDemuxClass.stream_peek_fragment().
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_PREFETCH_DEPTH,
+      g_param_spec_uint ("prefetch-depth", "Prefetch depth",
+          "Number of upcoming fragments to download ahead of time per stream "
+          "(0 = disabled)", 0, MAX_PREFETCH_DEPTH, DEFAULT_PREFETCH_DEPTH,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAdaptiveDemux:abr-policy:
+   *
+   * How the available bandwidth is estimated before selecting the bitrate
+   * of the next fragment. Except for "average", the estimators work on
+   * throughput samples taken during the downloads rather than on whole
+   * fragments. "connection-speed" overrides any of them.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_ABR_POLICY,
+      g_param_spec_enum ("abr-policy", "ABR policy",
+          "Bandwidth estimation used for selecting the bitrate",
+          GST_TYPE_ADAPTIVE_DEMUX_ABR_POLICY, DEFAULT_ABR_POLICY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state = gst_adaptive_demux_change_state;
 
   gstbin_class->handle_message = gst_adaptive_demux_handle_message;
@@ -509,6 +617,12 @@ gst_adaptive_demux_init (GstAdaptiveDemux * demux,
   g_cond_init (&demux->priv->preroll_cond);
   g_mutex_init (&demux->priv->preroll_lock);
 
+  g_cond_init (&demux->priv->prefetch_cond);
+  g_mutex_init (&demux->priv->prefetch_lock);
+  demux->priv->prefetch_pool =
+      g_thread_pool_new (gst_adaptive_demux_prefetch_func, demux, -1, FALSE,
+      NULL);
+
   pad_template =
       gst_element_class_get_pad_template (GST_ELEMENT_CLASS (klass), "sink");
   g_return_if_fail (pad_template != NULL);
@@ -522,6 +636,8 @@ gst_adaptive_demux_init (GstAdaptiveDemux * demux,
   /* Properties */
   demux->bitrate_limit = DEFAULT_BITRATE_LIMIT;
   demux->connection_speed = DEFAULT_CONNECTION_SPEED;
+  demux->priv->prefetch_depth = DEFAULT_PREFETCH_DEPTH;
+  demux->priv->abr_policy = DEFAULT_ABR_POLICY;
 
   gst_element_add_pad (GST_ELEMENT (demux), demux->sinkpad);
 }
@@ -554,6 +670,12 @@ gst_adaptive_demux_finalize (GObject * object)
   g_cond_clear (&demux->priv->preroll_cond);
   g_mutex_clear (&demux->priv->preroll_lock);
 
+  /* all streams are gone, so the remaining prefetches were cancelled and
+   * will finish right away */
+  g_thread_pool_free (priv->prefetch_pool, FALSE, TRUE);
+  g_cond_clear (&demux->priv->prefetch_cond);
+  g_mutex_clear (&demux->priv->prefetch_lock);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -1284,6 +1406,10 @@ gst_adaptive_demux_expose_streams (GstAdaptiveDemux * demux)
       stream->replaced = TRUE;
       g_cond_signal (&stream->fragment_download_cond);
       g_mutex_unlock (&stream->fragment_download_lock);
+
+      g_mutex_lock (&demux->priv->prefetch_lock);
+      g_cond_broadcast (&demux->priv->prefetch_cond);
+      g_mutex_unlock (&demux->priv->prefetch_lock);
     }
     gst_event_unref (eos);
 
@@ -1323,6 +1449,7 @@ gst_adaptive_demux_stream_new (GstAdaptiveDemux * demux, GstPad * pad)
   stream->demux = demux;
   stream->fragment_bitrates =
       g_malloc0 (sizeof (guint64) * NUM_LOOKBACK_FRAGMENTS);
+  stream->abr = gst_adaptive_demux_abr_new ();
   gst_pad_set_element_private (pad, stream);
   stream->qos_earliest_time = GST_CLOCK_TIME_NONE;
 
@@ -1387,6 +1514,10 @@ gst_adaptive_demux_stream_free (GstAdaptiveDemuxStream * stream)
       stream->cancelled = TRUE;
       g_cond_signal (&stream->fragment_download_cond);
       g_mutex_unlock (&stream->fragment_download_lock);
+
+      g_mutex_lock (&demux->priv->prefetch_lock);
+      g_cond_broadcast (&demux->priv->prefetch_cond);
+      g_mutex_unlock (&demux->priv->prefetch_lock);
     }
     GST_LOG_OBJECT (demux, "Waiting for task to finish");
 
@@ -1404,6 +1535,7 @@ gst_adaptive_demux_stream_free (GstAdaptiveDemuxStream * stream)
   }
 
   gst_adaptive_demux_stream_fragment_clear (&stream->fragment);
+  gst_adaptive_demux_stream_clear_prefetch (stream);
 
   if (stream->pending_segment) {
     gst_event_unref (stream->pending_segment);
@@ -1439,6 +1571,7 @@ gst_adaptive_demux_stream_free (GstAdaptiveDemuxStream * stream)
   g_cond_clear (&stream->fragment_download_cond);
   g_mutex_clear (&stream->fragment_download_lock);
   g_free (stream->fragment_bitrates);
+  gst_adaptive_demux_abr_free (stream->abr);
 
   if (stream->pad) {
     gst_object_unref (stream->pad);
@@ -2153,6 +2286,9 @@ gst_adaptive_demux_stop_tasks (GstAdaptiveDemux * demux, gboolean stop_updates)
   g_mutex_lock (&demux->priv->preroll_lock);
   g_cond_broadcast (&demux->priv->preroll_cond);
   g_mutex_unlock (&demux->priv->preroll_lock);
+  g_mutex_lock (&demux->priv->prefetch_lock);
+  g_cond_broadcast (&demux->priv->prefetch_cond);
+  g_mutex_unlock (&demux->priv->prefetch_lock);
   GST_MANIFEST_LOCK (demux);
 
   g_mutex_lock (&demux->priv->manifest_update_lock);
@@ -2272,6 +2408,41 @@ _update_average_bitrate (GstAdaptiveDemux * demux,
   return stream->moving_bitrate / stream->moving_index;
 }
 
+/* must be called with manifest_lock taken.
+ * Returns how much data is queued downstream of @stream, in running time,
+ * or GST_CLOCK_TIME_NONE if it can't be known */
+static GstClockTime
+gst_adaptive_demux_stream_get_buffer_level (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
+{
+  GstClock *clock;
+  GstClockTime position, now, base_time;
+
+  if (GST_STATE (demux) != GST_STATE_PLAYING)
+    return GST_CLOCK_TIME_NONE;
+
+  GST_ADAPTIVE_DEMUX_SEGMENT_LOCK (demux);
+  position = gst_segment_to_running_time (&stream->segment, GST_FORMAT_TIME,
+      stream->segment.position);
+  GST_ADAPTIVE_DEMUX_SEGMENT_UNLOCK (demux);
+  if (!GST_CLOCK_TIME_IS_VALID (position))
+    return GST_CLOCK_TIME_NONE;
+
+  clock = gst_element_get_clock (GST_ELEMENT_CAST (demux));
+  if (clock == NULL)
+    return GST_CLOCK_TIME_NONE;
+
+  now = gst_clock_get_time (clock);
+  base_time = gst_element_get_base_time (GST_ELEMENT_CAST (demux));
+  gst_object_unref (clock);
+
+  if (now < base_time)
+    return GST_CLOCK_TIME_NONE;
+  now -= base_time;
+
+  return position > now ? position - now : 0;
+}
+
 /* must be called with manifest_lock taken */
 static guint64
 gst_adaptive_demux_stream_update_current_bitrate (GstAdaptiveDemux * demux,
@@ -2291,16 +2462,38 @@ gst_adaptive_demux_stream_update_current_bitrate (GstAdaptiveDemux * demux,
   GST_DEBUG_OBJECT (demux, "Download bitrate is : %" G_GUINT64_FORMAT " bps",
       fragment_bitrate);
 
-  average_bitrate = _update_average_bitrate (demux, stream, fragment_bitrate);
-
   GST_INFO_OBJECT (GST_ADAPTIVE_DEMUX_STREAM_PAD (stream),
       "last fragment bitrate was %" G_GUINT64_FORMAT, fragment_bitrate);
-  GST_INFO_OBJECT (GST_ADAPTIVE_DEMUX_STREAM_PAD (stream),
-      "Last %u fragments average bitrate is %" G_GUINT64_FORMAT,
-      NUM_LOOKBACK_FRAGMENTS, average_bitrate);
 
-  /* Conservative approach, make sure we don't upgrade too fast */
-  stream->current_download_rate = MIN (average_bitrate, fragment_bitrate);
+  if (demux->priv->abr_policy == GST_ADAPTIVE_DEMUX_ABR_POLICY_AVERAGE) {
+    average_bitrate =
+        _update_average_bitrate (demux, stream, fragment_bitrate);
+
+    GST_INFO_OBJECT (GST_ADAPTIVE_DEMUX_STREAM_PAD (stream),
+        "Last %u fragments average bitrate is %" G_GUINT64_FORMAT,
+        NUM_LOOKBACK_FRAGMENTS, average_bitrate);
+
+    /* Conservative approach, make sure we don't upgrade too fast */
+    stream->current_download_rate = MIN (average_bitrate, fragment_bitrate);
+  } else {
+    GstClockTime buffer_level = GST_CLOCK_TIME_NONE;
+    guint64 bandwidth;
+
+    if (demux->priv->abr_policy == GST_ADAPTIVE_DEMUX_ABR_POLICY_BUFFER_BASED)
+      buffer_level = gst_adaptive_demux_stream_get_buffer_level (demux, stream);
+
+    bandwidth = gst_adaptive_demux_abr_get_bandwidth (stream->abr,
+        demux->priv->abr_policy, buffer_level);
+
+    GST_INFO_OBJECT (GST_ADAPTIVE_DEMUX_STREAM_PAD (stream),
+        "Estimated bandwidth is %" G_GUINT64_FORMAT, bandwidth);
+
+    /* Not enough samples yet */
+    if (bandwidth == 0)
+      bandwidth = fragment_bitrate;
+
+    stream->current_download_rate = bandwidth;
+  }
 
   stream->current_download_rate *= demux->bitrate_limit;
   GST_DEBUG_OBJECT (demux, "Bitrate after bitrate limit (%0.2f): %"
@@ -2863,6 +3056,8 @@ _uri_handler_probe (GstPad * pad, GstPadProbeInfo * info,
           GST_TIME_ARGS (stream->last_latency));
     }
     stream->fragment_bytes_downloaded += gst_buffer_get_size (buf);
+    gst_adaptive_demux_abr_add_bytes (stream->abr, gst_buffer_get_size (buf),
+        gst_adaptive_demux_get_monotonic_time (stream->demux));
     GST_LOG_OBJECT (pad,
         "Received buffer, size %" G_GSIZE_FORMAT " total %" G_GUINT64_FORMAT,
         gst_buffer_get_size (buf), stream->fragment_bytes_downloaded);
@@ -2874,9 +3069,13 @@ _uri_handler_probe (GstPad * pad, GstPadProbeInfo * info,
     switch (GST_EVENT_TYPE (ev)) {
       case GST_EVENT_SEGMENT:
         stream->fragment_bytes_downloaded = 0;
+        /* drop what's left from an interrupted download */
+        gst_adaptive_demux_abr_end_download (stream->abr, 0);
         break;
       case GST_EVENT_EOS:
       {
+        gst_adaptive_demux_abr_end_download (stream->abr,
+            gst_adaptive_demux_get_monotonic_time (stream->demux));
         stream->last_download_time =
             gst_adaptive_demux_get_monotonic_time (stream->demux) -
             (stream->download_start_time * GST_USECOND);
@@ -3385,6 +3584,217 @@ gst_adaptive_demux_stream_download_header_fragment (GstAdaptiveDemuxStream *
   return ret;
 }
 
+static GstAdaptiveDemuxPrefetch *
+gst_adaptive_demux_prefetch_ref (GstAdaptiveDemuxPrefetch * prefetch)
+{
+  g_atomic_int_inc (&prefetch->ref_count);
+  return prefetch;
+}
+
+static void
+gst_adaptive_demux_prefetch_unref (GstAdaptiveDemuxPrefetch * prefetch)
+{
+  if (g_atomic_int_dec_and_test (&prefetch->ref_count)) {
+    g_object_unref (prefetch->downloader);
+    g_free (prefetch->uri);
+    if (prefetch->buffer)
+      gst_buffer_unref (prefetch->buffer);
+    g_slice_free (GstAdaptiveDemuxPrefetch, prefetch);
+  }
+}
+
+/* runs on a prefetch_pool thread, without any of the demuxer locks */
+static void
+gst_adaptive_demux_prefetch_func (gpointer data, gpointer user_data)
+{
+  GstAdaptiveDemuxPrefetch *prefetch = data;
+  GstAdaptiveDemux *demux = user_data;
+  GstFragment *download;
+  GstClockTime start_time;
+  GError *err = NULL;
+
+  start_time = gst_adaptive_demux_get_monotonic_time (demux);
+  download = gst_uri_downloader_fetch_uri_with_range (prefetch->downloader,
+      prefetch->uri, NULL, FALSE, FALSE, TRUE, prefetch->range_start,
+      prefetch->range_end, &err);
+
+  g_mutex_lock (&demux->priv->prefetch_lock);
+  if (download) {
+    prefetch->buffer = gst_fragment_get_buffer (download);
+    prefetch->start_time = start_time;
+    prefetch->download_time =
+        gst_adaptive_demux_get_monotonic_time (demux) - start_time;
+  } else {
+    GST_DEBUG_OBJECT (demux, "Failed to prefetch %s: %s", prefetch->uri,
+        err ? err->message : "cancelled");
+  }
+  prefetch->done = TRUE;
+  g_cond_broadcast (&demux->priv->prefetch_cond);
+  g_mutex_unlock (&demux->priv->prefetch_lock);
+
+  if (download)
+    g_object_unref (download);
+  g_clear_error (&err);
+  gst_adaptive_demux_prefetch_unref (prefetch);
+}
+
+/* must be called with manifest_lock taken */
+static void
+gst_adaptive_demux_stream_clear_prefetch (GstAdaptiveDemuxStream * stream)
+{
+  GstAdaptiveDemuxPrefetch *prefetch;
+
+  while ((prefetch = g_queue_pop_head (&stream->prefetch_queue))) {
+    gst_uri_downloader_cancel (prefetch->downloader);
+    gst_adaptive_demux_prefetch_unref (prefetch);
+  }
+}
+
+/* must be called with manifest_lock taken.
+ * Starts downloading the fragments following the current one, up to
+ * prefetch-depth of them, if the subclass can tell which they are */
+static void
+gst_adaptive_demux_stream_schedule_prefetch (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream)
+{
+  GstAdaptiveDemuxClass *klass = GST_ADAPTIVE_DEMUX_GET_CLASS (demux);
+  guint n;
+
+  if (!klass->stream_peek_fragment)
+    return;
+
+  for (n = stream->prefetch_queue.length + 1;
+      n <= demux->priv->prefetch_depth; n++) {
+    GstAdaptiveDemuxPrefetch *prefetch;
+    gchar *uri = NULL;
+    gint64 range_start = 0, range_end = -1;
+
+    if (!klass->stream_peek_fragment (stream, n, &uri, &range_start,
+            &range_end))
+      break;
+
+    GST_DEBUG_OBJECT (stream->pad, "Prefetching fragment %u ahead: %s", n,
+        uri);
+
+    prefetch = g_slice_new0 (GstAdaptiveDemuxPrefetch);
+    prefetch->ref_count = 1;
+    prefetch->downloader = gst_uri_downloader_new ();
+    gst_uri_downloader_set_parent (prefetch->downloader,
+        GST_ELEMENT_CAST (demux));
+    prefetch->uri = uri;
+    prefetch->range_start = range_start;
+    prefetch->range_end = range_end;
+
+    g_queue_push_tail (&stream->prefetch_queue, prefetch);
+    g_thread_pool_push (demux->priv->prefetch_pool,
+        gst_adaptive_demux_prefetch_ref (prefetch), NULL);
+  }
+}
+
+/* must be called with manifest_lock taken.
+ * Returns the prefetch of the current fragment if there is one. Otherwise
+ * the pending prefetches are stale (after a seek or a bitrate switch) and
+ * are all dropped */
+static GstAdaptiveDemuxPrefetch *
+gst_adaptive_demux_stream_take_prefetch (GstAdaptiveDemuxStream * stream)
+{
+  GstAdaptiveDemuxPrefetch *prefetch;
+
+  prefetch = g_queue_peek_head (&stream->prefetch_queue);
+  if (prefetch == NULL)
+    return NULL;
+
+  if (g_strcmp0 (prefetch->uri, stream->fragment.uri) == 0 &&
+      prefetch->range_start == stream->fragment.range_start &&
+      prefetch->range_end == stream->fragment.range_end)
+    return g_queue_pop_head (&stream->prefetch_queue);
+
+  GST_DEBUG_OBJECT (stream->pad, "Dropping %u stale prefetched fragments",
+      stream->prefetch_queue.length);
+  gst_adaptive_demux_stream_clear_prefetch (stream);
+
+  return NULL;
+}
+
+/* must be called with manifest_lock taken.
+ * Can temporarily release manifest_lock
+ *
+ * Waits for @prefetch and feeds its data through the same path as data
+ * coming from the source element. Returns FALSE if the prefetch failed and
+ * the fragment has to be downloaded normally. */
+static gboolean
+gst_adaptive_demux_stream_push_prefetch (GstAdaptiveDemux * demux,
+    GstAdaptiveDemuxStream * stream, GstAdaptiveDemuxPrefetch * prefetch,
+    GstFlowReturn * ret)
+{
+  GstBuffer *buffer;
+  gboolean cancelled = FALSE;
+
+  GST_MANIFEST_UNLOCK (demux);
+  g_mutex_lock (&demux->priv->prefetch_lock);
+  while (!prefetch->done) {
+    g_mutex_lock (&stream->fragment_download_lock);
+    cancelled = stream->cancelled;
+    g_mutex_unlock (&stream->fragment_download_lock);
+    if (cancelled)
+      break;
+    g_cond_wait (&demux->priv->prefetch_cond, &demux->priv->prefetch_lock);
+  }
+  buffer = prefetch->buffer;
+  prefetch->buffer = NULL;
+  g_mutex_unlock (&demux->priv->prefetch_lock);
+  GST_MANIFEST_LOCK (demux);
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  if (G_UNLIKELY (cancelled || stream->cancelled)) {
+    g_mutex_unlock (&stream->fragment_download_lock);
+    gst_uri_downloader_cancel (prefetch->downloader);
+    if (buffer)
+      gst_buffer_unref (buffer);
+    *ret = stream->last_ret = GST_FLOW_FLUSHING;
+    return TRUE;
+  }
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  if (buffer == NULL || stream->internal_pad == NULL) {
+    GST_DEBUG_OBJECT (stream->pad, "Prefetch of %s failed", prefetch->uri);
+    if (buffer)
+      gst_buffer_unref (buffer);
+    return FALSE;
+  }
+
+  GST_DEBUG_OBJECT (stream->pad, "Using prefetched fragment %s",
+      prefetch->uri);
+
+  /* Account for the time the prefetch actually took, so that the bitrate
+   * estimation sees the real network throughput */
+  stream->download_start_time = GST_TIME_AS_USECONDS (prefetch->start_time);
+  stream->fragment_bytes_downloaded = gst_buffer_get_size (buffer);
+  stream->last_latency = GST_CLOCK_TIME_NONE;
+  stream->last_download_time = MAX (prefetch->download_time, 1);
+  stream->last_bitrate =
+      gst_util_uint64_scale (stream->fragment_bytes_downloaded,
+      8 * GST_SECOND, stream->last_download_time);
+  gst_adaptive_demux_abr_add_sample (stream->abr,
+      stream->fragment_bytes_downloaded, stream->last_download_time);
+
+  g_mutex_lock (&stream->fragment_download_lock);
+  stream->download_finished = FALSE;
+  stream->downloading_first_buffer = TRUE;
+  g_mutex_unlock (&stream->fragment_download_lock);
+
+  *ret = _src_chain (stream->internal_pad, GST_OBJECT_CAST (demux), buffer);
+  if (*ret == GST_FLOW_OK) {
+    /* Behaves like the EOS event from the source element */
+    gst_adaptive_demux_eos_handling (stream);
+  } else if (*ret != GST_FLOW_EOS) {
+    gst_adaptive_demux_stream_fragment_download_finish (stream, *ret, NULL);
+  }
+  *ret = stream->last_ret;
+
+  return TRUE;
+}
+
 /* must be called with manifest_lock taken.
  * Can temporarily release manifest_lock
  */
@@ -3503,9 +3913,24 @@ again:
         chunk_end = MIN (chunk_end, range_end);
     }
   } else {
-    ret =
-        gst_adaptive_demux_stream_download_uri (demux, stream, url,
-        stream->fragment.range_start, stream->fragment.range_end, &http_status);
+    GstAdaptiveDemuxPrefetch *prefetch;
+    gboolean prefetched = FALSE;
+
+    prefetch = gst_adaptive_demux_stream_take_prefetch (stream);
+    gst_adaptive_demux_stream_schedule_prefetch (demux, stream);
+
+    if (prefetch) {
+      prefetched = gst_adaptive_demux_stream_push_prefetch (demux, stream,
+          prefetch, &ret);
+      gst_adaptive_demux_prefetch_unref (prefetch);
+    }
+
+    if (!prefetched) {
+      ret =
+          gst_adaptive_demux_stream_download_uri (demux, stream, url,
+          stream->fragment.range_start, stream->fragment.range_end,
+          &http_status);
+    }
     GST_DEBUG_OBJECT (stream->pad, "Fragment download result: %d (%d) %s",
         stream->last_ret, http_status, gst_flow_get_name (stream->last_ret));
   }
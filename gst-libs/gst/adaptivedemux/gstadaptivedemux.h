@@ -195,6 +195,12 @@ struct _GstAdaptiveDemuxStream
   gboolean eos;
 
   gboolean do_block; /* TRUE if stream should block on preroll */
+
+  /* upcoming fragments being downloaded ahead of time (private) */
+  GQueue prefetch_queue;
+
+  /* throughput estimation (private) */
+  struct _GstAdaptiveDemuxAbr *abr;
 };
 
 /**
@@ -482,6 +488,28 @@ struct _GstAdaptiveDemuxClass
    * Return: %TRUE if the playlist needs to be refreshed periodically by the demuxer.
    */
   gboolean (*requires_periodical_playlist_update) (GstAdaptiveDemux * demux);
+
+  /**
+   * stream_peek_fragment:
+   * @stream: #GstAdaptiveDemuxStream
+   * @n: how many fragments after the current one to look at
+   * @uri: (out): location for the URI of that fragment
+   * @range_start: (out): location for the start of its byte range
+   * @range_end: (out): location for the (inclusive) end of its byte range,
+   *   or -1
+   *
+   * Optional. Gives the location of the fragment @n positions after the one
+   * set by stream_update_fragment_info() in playback direction, without
+   * advancing the stream. Used to download upcoming fragments ahead of time
+   * when #GstAdaptiveDemux:prefetch-depth is not 0.
+   *
+   * Returns: %TRUE if that fragment is known
+   *
+   * Since: 1.20
+   */
+  gboolean (*stream_peek_fragment) (GstAdaptiveDemuxStream * stream, guint n,
+                                    gchar ** uri, gint64 * range_start,
+                                    gint64 * range_end);
 };
 
 GST_ADAPTIVE_DEMUX_API
@@ -0,0 +1,58 @@
+/*
+ * GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_ADAPTIVE_DEMUX_ABR_PRIVATE_H__
+#define __GST_ADAPTIVE_DEMUX_ABR_PRIVATE_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+  GST_ADAPTIVE_DEMUX_ABR_POLICY_AVERAGE,
+  GST_ADAPTIVE_DEMUX_ABR_POLICY_HARMONIC_MEAN,
+  GST_ADAPTIVE_DEMUX_ABR_POLICY_EWMA,
+  GST_ADAPTIVE_DEMUX_ABR_POLICY_BUFFER_BASED,
+} GstAdaptiveDemuxAbrPolicy;
+
+typedef struct _GstAdaptiveDemuxAbr GstAdaptiveDemuxAbr;
+
+GstAdaptiveDemuxAbr * gst_adaptive_demux_abr_new           (void);
+
+void                  gst_adaptive_demux_abr_free          (GstAdaptiveDemuxAbr * abr);
+
+void                  gst_adaptive_demux_abr_add_bytes     (GstAdaptiveDemuxAbr * abr,
+                                                            guint64 bytes,
+                                                            GstClockTime now);
+
+void                  gst_adaptive_demux_abr_end_download  (GstAdaptiveDemuxAbr * abr,
+                                                            GstClockTime now);
+
+void                  gst_adaptive_demux_abr_add_sample    (GstAdaptiveDemuxAbr * abr,
+                                                            guint64 bytes,
+                                                            GstClockTime duration);
+
+guint64               gst_adaptive_demux_abr_get_bandwidth (GstAdaptiveDemuxAbr * abr,
+                                                            GstAdaptiveDemuxAbrPolicy policy,
+                                                            GstClockTime buffer_level);
+
+G_END_DECLS
+
+#endif /* __GST_ADAPTIVE_DEMUX_ABR_PRIVATE_H__ */
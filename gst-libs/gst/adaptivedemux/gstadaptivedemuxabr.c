@@ -0,0 +1,244 @@
+/*
+ * GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+
+#include "gstadaptivedemuxabr-private.h"
+
+GST_DEBUG_CATEGORY_EXTERN (adaptivedemux_debug);
+#define GST_CAT_DEFAULT adaptivedemux_debug
+
+/* Data is accumulated for at least this long before being used as a
+ * throughput sample, single network reads are too noisy on their own */
+#define MIN_SAMPLE_DURATION (50 * GST_MSECOND)
+
+/* Number of samples the harmonic mean is computed over */
+#define HARMONIC_WINDOW 20
+
+/* Half-lives of the fast and slow moving averages, in seconds */
+#define EWMA_FAST_HALF_LIFE 2.0
+#define EWMA_SLOW_HALF_LIFE 5.0
+
+/* The buffer-based policy uses BUFFER_MIN_FACTOR of the throughput estimate
+ * below BUFFER_RESERVOIR of buffered data, all of it above BUFFER_CUSHION,
+ * and scales linearly in between */
+#define BUFFER_RESERVOIR (5 * GST_SECOND)
+#define BUFFER_CUSHION (20 * GST_SECOND)
+#define BUFFER_MIN_FACTOR 0.25
+
+typedef struct
+{
+  gdouble half_life;
+  gdouble estimate;
+  gdouble total_weight;
+} GstAdaptiveDemuxEwma;
+
+struct _GstAdaptiveDemuxAbr
+{
+  GMutex lock;
+
+  /* data received since the last sample */
+  GstClockTime pending_start;
+  guint64 pending_bytes;
+
+  /* last samples, in bits per second */
+  gdouble samples[HARMONIC_WINDOW];
+  guint n_samples;
+  guint next_sample;
+
+  GstAdaptiveDemuxEwma fast;
+  GstAdaptiveDemuxEwma slow;
+};
+
+static void
+ewma_add (GstAdaptiveDemuxEwma * ewma, gdouble weight, gdouble value)
+{
+  gdouble alpha = pow (0.5, weight / ewma->half_life);
+
+  ewma->estimate = value * (1.0 - alpha) + alpha * ewma->estimate;
+  ewma->total_weight += weight;
+}
+
+static gdouble
+ewma_get (GstAdaptiveDemuxEwma * ewma)
+{
+  /* the estimate starts from 0, correct for that while there's only
+   * little data */
+  gdouble zero_factor = 1.0 - pow (0.5, ewma->total_weight / ewma->half_life);
+
+  if (zero_factor <= 0.0)
+    return 0.0;
+
+  return ewma->estimate / zero_factor;
+}
+
+GstAdaptiveDemuxAbr *
+gst_adaptive_demux_abr_new (void)
+{
+  GstAdaptiveDemuxAbr *abr = g_new0 (GstAdaptiveDemuxAbr, 1);
+
+  g_mutex_init (&abr->lock);
+  abr->pending_start = GST_CLOCK_TIME_NONE;
+  abr->fast.half_life = EWMA_FAST_HALF_LIFE;
+  abr->slow.half_life = EWMA_SLOW_HALF_LIFE;
+
+  return abr;
+}
+
+void
+gst_adaptive_demux_abr_free (GstAdaptiveDemuxAbr * abr)
+{
+  g_mutex_clear (&abr->lock);
+  g_free (abr);
+}
+
+/* must be called with the abr lock taken */
+static void
+gst_adaptive_demux_abr_push_sample (GstAdaptiveDemuxAbr * abr, guint64 bytes,
+    GstClockTime duration)
+{
+  gdouble seconds, rate;
+
+  if (bytes == 0 || duration == 0)
+    return;
+
+  seconds = (gdouble) duration / GST_SECOND;
+  rate = bytes * 8 / seconds;
+
+  GST_LOG ("Throughput sample of %" G_GUINT64_FORMAT " bytes in %"
+      GST_TIME_FORMAT ": %.0f bps", bytes, GST_TIME_ARGS (duration), rate);
+
+  abr->samples[abr->next_sample] = rate;
+  abr->next_sample = (abr->next_sample + 1) % HARMONIC_WINDOW;
+  abr->n_samples = MIN (abr->n_samples + 1, HARMONIC_WINDOW);
+
+  ewma_add (&abr->fast, seconds, rate);
+  ewma_add (&abr->slow, seconds, rate);
+}
+
+/* Accounts @bytes received from the network at @now. The first call of each
+ * download only records the arrival time of the first byte, so that the
+ * request latency isn't counted as transfer time. */
+void
+gst_adaptive_demux_abr_add_bytes (GstAdaptiveDemuxAbr * abr, guint64 bytes,
+    GstClockTime now)
+{
+  g_mutex_lock (&abr->lock);
+  if (!GST_CLOCK_TIME_IS_VALID (abr->pending_start)) {
+    abr->pending_start = now;
+    abr->pending_bytes = 0;
+  } else {
+    abr->pending_bytes += bytes;
+    if (now >= abr->pending_start + MIN_SAMPLE_DURATION) {
+      gst_adaptive_demux_abr_push_sample (abr, abr->pending_bytes,
+          now - abr->pending_start);
+      abr->pending_start = now;
+      abr->pending_bytes = 0;
+    }
+  }
+  g_mutex_unlock (&abr->lock);
+}
+
+/* Flushes the data received since the last sample at the end of a download.
+ * Leftovers too short to be meaningful are dropped. */
+void
+gst_adaptive_demux_abr_end_download (GstAdaptiveDemuxAbr * abr,
+    GstClockTime now)
+{
+  g_mutex_lock (&abr->lock);
+  if (GST_CLOCK_TIME_IS_VALID (abr->pending_start) &&
+      now >= abr->pending_start + MIN_SAMPLE_DURATION / 4) {
+    gst_adaptive_demux_abr_push_sample (abr, abr->pending_bytes,
+        now - abr->pending_start);
+  }
+  abr->pending_start = GST_CLOCK_TIME_NONE;
+  abr->pending_bytes = 0;
+  g_mutex_unlock (&abr->lock);
+}
+
+/* Adds a sample for a whole download that was measured elsewhere */
+void
+gst_adaptive_demux_abr_add_sample (GstAdaptiveDemuxAbr * abr, guint64 bytes,
+    GstClockTime duration)
+{
+  g_mutex_lock (&abr->lock);
+  gst_adaptive_demux_abr_push_sample (abr, bytes, duration);
+  g_mutex_unlock (&abr->lock);
+}
+
+/* Returns the bandwidth estimate of @policy in bits per second, or 0 if
+ * there isn't enough data yet. @buffer_level is only used by the
+ * buffer-based policy and can be GST_CLOCK_TIME_NONE if unknown. */
+guint64
+gst_adaptive_demux_abr_get_bandwidth (GstAdaptiveDemuxAbr * abr,
+    GstAdaptiveDemuxAbrPolicy policy, GstClockTime buffer_level)
+{
+  gdouble bandwidth = 0.0;
+
+  g_mutex_lock (&abr->lock);
+  switch (policy) {
+    case GST_ADAPTIVE_DEMUX_ABR_POLICY_HARMONIC_MEAN:
+    case GST_ADAPTIVE_DEMUX_ABR_POLICY_BUFFER_BASED:{
+      gdouble inv_sum = 0.0;
+      guint i;
+
+      if (abr->n_samples == 0)
+        break;
+
+      for (i = 0; i < abr->n_samples; i++)
+        inv_sum += 1.0 / abr->samples[i];
+      bandwidth = abr->n_samples / inv_sum;
+
+      if (policy == GST_ADAPTIVE_DEMUX_ABR_POLICY_BUFFER_BASED &&
+          GST_CLOCK_TIME_IS_VALID (buffer_level)) {
+        gdouble factor;
+
+        if (buffer_level <= BUFFER_RESERVOIR)
+          factor = BUFFER_MIN_FACTOR;
+        else if (buffer_level >= BUFFER_CUSHION)
+          factor = 1.0;
+        else
+          factor = BUFFER_MIN_FACTOR + (1.0 - BUFFER_MIN_FACTOR) *
+              (buffer_level - BUFFER_RESERVOIR) /
+              (gdouble) (BUFFER_CUSHION - BUFFER_RESERVOIR);
+
+        GST_LOG ("Buffer level %" GST_TIME_FORMAT ", using %.2f of %.0f bps",
+            GST_TIME_ARGS (buffer_level), factor, bandwidth);
+        bandwidth *= factor;
+      }
+      break;
+    }
+    case GST_ADAPTIVE_DEMUX_ABR_POLICY_EWMA:
+      /* the slow average keeps short peaks from upgrading too eagerly, the
+       * fast one reacts quickly to drops */
+      bandwidth = MIN (ewma_get (&abr->fast), ewma_get (&abr->slow));
+      break;
+    default:
+      g_assert_not_reached ();
+      break;
+  }
+  g_mutex_unlock (&abr->lock);
+
+  return (guint64) bandwidth;
+}
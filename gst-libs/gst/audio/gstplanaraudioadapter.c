@@ -33,6 +33,9 @@
 
 #include "gstplanaraudioadapter.h"
 
+#include <gst/audio/audio.h>
+#include <string.h>
+
 GST_DEBUG_CATEGORY_STATIC (gst_planar_audio_adapter_debug);
 #define GST_CAT_DEFAULT gst_planar_audio_adapter_debug
 
@@ -319,6 +322,68 @@ gst_planar_audio_adapter_flush (GstPlanarAudioAdapter * adapter, gsize to_flush)
   gst_planar_audio_adapter_flush_unchecked (adapter, to_flush);
 }
 
+/* upper bound of the number of memories needed for concatenating the planes
+ * of the first @nsamples */
+static guint
+gst_planar_audio_adapter_count_memories (GstPlanarAudioAdapter * adapter,
+    gsize nsamples)
+{
+  GSList *cur_node;
+  gsize need = nsamples + adapter->skip;
+  guint n_mem = 0;
+
+  for (cur_node = adapter->buflist; cur_node && need > 0;
+      cur_node = g_slist_next (cur_node)) {
+    GstBuffer *cur = cur_node->data;
+    gsize samples = gst_buffer_get_audio_meta (cur)->samples;
+
+    n_mem += gst_buffer_n_memory (cur);
+    need -= MIN (need, samples);
+  }
+
+  return n_mem * adapter->info.channels;
+}
+
+static GstBuffer *
+gst_planar_audio_adapter_copy_buffer (GstPlanarAudioAdapter * adapter,
+    gsize nsamples)
+{
+  GstBuffer *buffer;
+  GstAudioBuffer dest;
+  GSList *cur_node = adapter->buflist;
+  gsize cur_skip = adapter->skip;
+  gsize offset = 0;
+  gint c, bps;
+
+  bps = adapter->info.finfo->width / 8;
+
+  buffer = gst_buffer_new_allocate (NULL, nsamples * adapter->info.bpf, NULL);
+  gst_buffer_add_audio_meta (buffer, &adapter->info, nsamples, NULL);
+  gst_audio_buffer_map (&dest, &adapter->info, buffer, GST_MAP_WRITE);
+
+  while (offset < nsamples) {
+    GstBuffer *cur = cur_node->data;
+    GstAudioBuffer src;
+    gsize take_from_cur;
+
+    gst_audio_buffer_map (&src, &adapter->info, cur, GST_MAP_READ);
+    take_from_cur = MIN (src.n_samples - cur_skip, nsamples - offset);
+    for (c = 0; c < adapter->info.channels; c++) {
+      memcpy ((guint8 *) dest.planes[c] + offset * bps,
+          (guint8 *) src.planes[c] + cur_skip * bps, take_from_cur * bps);
+    }
+    gst_audio_buffer_unmap (&src);
+
+    offset += take_from_cur;
+    cur_skip = 0;
+    cur_node = g_slist_next (cur_node);
+  }
+
+  gst_audio_buffer_unmap (&dest);
+
+  return buffer;
+}
+
 /**
  * gst_planar_audio_adapter_get_buffer:
  * @adapter: a #GstPlanarAudioAdapter
@@ -387,13 +452,23 @@ gst_planar_audio_adapter_get_buffer (GstPlanarAudioAdapter * adapter,
     buffer = gst_buffer_copy_region (cur, GST_BUFFER_COPY_ALL, 0, -1);
     gst_audio_buffer_truncate (buffer, adapter->info.bpf, skip, nsamples);
 
+  } else if (gst_planar_audio_adapter_count_memories (adapter, nsamples) >
+      gst_buffer_get_max_memory ()) {
+    /* a buffer can't hold that many memories, they would be merged over
+     * and over while appending them. Copy the planes once instead. */
+    GST_LOG_OBJECT (adapter, "providing buffer of %" G_GSIZE_FORMAT " samples"
+        " via copy", nsamples);
+
+    buffer = gst_planar_audio_adapter_copy_buffer (adapter, nsamples);
+
   } else {
     gint c, bps;
     GstAudioMeta *meta;
 
     /* construct a buffer with concatenated memory chunks from the appropriate
      * places. These memories will be copied into a single memory chunk
-     * as soon as the buffer is mapped */
+     * as soon as the buffer is mapped, unless they are adjacent parts of
+     * the same memory */
     GST_LOG_OBJECT (adapter, "providing buffer of %" G_GSIZE_FORMAT " samples"
         " via memory concatenation", nsamples);
 
@@ -439,7 +514,10 @@ gst_planar_audio_adapter_get_buffer (GstPlanarAudioAdapter * adapter,
  * Returns a #GstBuffer containing the first @nsamples bytes of the
  * @adapter. The returned bytes will be flushed from the adapter.
  *
- * See gst_planar_audio_adapter_get_buffer() for more details.
+ * See gst_planar_audio_adapter_get_buffer() for more details. In addition,
+ * when taking all the remaining samples of a buffer that was pushed and is
+ * not referenced anywhere else, that buffer is returned without copying even
+ * if @flags contains %GST_MAP_WRITE.
  *
  * Caller owns a reference to the returned buffer. gst_buffer_unref() after
  * usage.
@@ -456,6 +534,28 @@ gst_planar_audio_adapter_take_buffer (GstPlanarAudioAdapter * adapter,
 {
   GstBuffer *buffer;
 
+  g_return_val_if_fail (GST_IS_PLANAR_AUDIO_ADAPTER (adapter), NULL);
+
+  if ((flags & GST_MAP_WRITE) && adapter->skip > 0 &&
+      nsamples <= adapter->samples) {
+    GstBuffer *cur = adapter->buflist->data;
+    gsize hsamples = gst_buffer_get_audio_meta (cur)->samples;
+    gsize skip = adapter->skip;
+
+    /* taking the rest of a head buffer nobody else holds: hand it out with
+     * its audio meta pointing at the remaining samples, it is writable
+     * without copying once the adapter dropped it */
+    if (hsamples == skip + nsamples && gst_buffer_is_writable (cur)) {
+      GST_LOG_OBJECT (adapter, "providing buffer of %" G_GSIZE_FORMAT
+          " samples as rest of head buffer", nsamples);
+
+      buffer = gst_buffer_ref (cur);
+      gst_planar_audio_adapter_flush_unchecked (adapter, nsamples);
+      return gst_audio_buffer_truncate (buffer, adapter->info.bpf, skip,
+          nsamples);
+    }
+  }
+
   buffer = gst_planar_audio_adapter_get_buffer (adapter, nsamples, flags);
   if (buffer)
     gst_planar_audio_adapter_flush_unchecked (adapter, nsamples);
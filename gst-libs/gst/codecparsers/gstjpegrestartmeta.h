@@ -0,0 +1,82 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_JPEG_RESTART_META_H__
+#define __GST_JPEG_RESTART_META_H__
+
+#ifndef GST_USE_UNSTABLE_API
+#warning "The JPEG parsing library is unstable API and may change in future."
+#warning "You can define GST_USE_UNSTABLE_API to avoid this warning."
+#endif
+
+#include <gst/gst.h>
+#include <gst/codecparsers/codecparsers-prelude.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstJpegRestartMeta GstJpegRestartMeta;
+
+GST_CODEC_PARSERS_API
+GType gst_jpeg_restart_meta_api_get_type (void);
+#define GST_JPEG_RESTART_META_API_TYPE  (gst_jpeg_restart_meta_api_get_type())
+#define GST_JPEG_RESTART_META_INFO  (gst_jpeg_restart_meta_get_info())
+GST_CODEC_PARSERS_API
+const GstMetaInfo * gst_jpeg_restart_meta_get_info (void);
+
+/**
+ * GstJpegRestartMeta:
+ * @meta: parent #GstMeta
+ * @restart_interval: the number of MCUs per restart interval, as signalled
+ *   by the DRI marker
+ * @n_intervals: the number of entries in @offsets and @sizes
+ * @offsets: byte offset of the entropy-coded data of each restart interval,
+ *   relative to the start of the buffer
+ * @sizes: size in bytes of the entropy-coded data of each restart interval,
+ *   not including the terminating RSTn marker
+ *
+ * Extra buffer metadata listing the restart intervals of a single-scan
+ * JPEG image.
+ *
+ * Restart intervals reset the DC predictors and can be entropy decoded
+ * independently, so decoders can use this to dispatch the intervals to
+ * several threads without scanning the entropy-coded segment themselves.
+ *
+ * Since: 1.20
+ */
+struct _GstJpegRestartMeta {
+  GstMeta  meta;
+
+  guint    restart_interval;
+  guint    n_intervals;
+  guint32 *offsets;
+  guint32 *sizes;
+};
+
+#define gst_buffer_get_jpeg_restart_meta(b) ((GstJpegRestartMeta*)gst_buffer_get_meta((b),GST_JPEG_RESTART_META_API_TYPE))
+
+GST_CODEC_PARSERS_API
+GstJpegRestartMeta *
+gst_buffer_add_jpeg_restart_meta (GstBuffer * buffer,
+                                  guint restart_interval,
+                                  guint n_intervals,
+                                  const guint32 * offsets,
+                                  const guint32 * sizes);
+
+G_END_DECLS
+
+#endif /* __GST_JPEG_RESTART_META_H__ */
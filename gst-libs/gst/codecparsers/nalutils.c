@@ -38,6 +38,14 @@
 #include "nalutils.h"
 #include <string.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define HAVE_NAL_SCAN_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define HAVE_NAL_SCAN_NEON 1
+#endif
+
 /* Compute Ceil(Log2(v)) */
 /* Derived from branchless code for integer log2(v) from:
    <http://graphics.stanford.edu/~seander/bithacks.html#IntegerLog> */
@@ -64,6 +72,11 @@ ceil_log2 (guint32 v)
 
 /****** Nal parser ******/
 
+/* Number of bytes searched for emulation prevention bytes at once. Headers
+ * are usually read from the start of large NAL units only, so the search
+ * is kept close to the read position instead of covering the whole NAL. */
+#define NAL_READER_EPB_SCAN_SIZE 128
+
 void
 nal_reader_init (NalReader * nr, const guint8 * data, guint size)
 {
@@ -73,12 +86,32 @@ nal_reader_init (NalReader * nr, const guint8 * data, guint size)
 
   nr->byte = 0;
   nr->bits_in_cache = 0;
-  /* fill with something other than 0 to detect emulation prevention bytes */
   nr->first_byte = 0xff;
-  nr->epb_cache = 0xff;
+  nr->epb_next = G_MAXUINT;
+  nr->epb_checked = 0;
   nr->cache = 0xff;
 }
 
+/* Finds the next emulation_prevention_three_byte at or after byte position
+ * @from. 0x000003 sequences never overlap, so starting the search two bytes
+ * earlier catches those that straddle the previously searched range. */
+static void
+nal_reader_scan_epb (NalReader * nr, guint from)
+{
+  guint start = from >= 2 ? from - 2 : 0;
+  guint end = MIN (nr->size, from + NAL_READER_EPB_SCAN_SIZE);
+  gint off;
+
+  off = scan_for_emulation_prevention_bytes (nr->data + start, end - start);
+  if (off >= 0) {
+    nr->epb_next = start + off + 2;
+    nr->epb_checked = nr->epb_next + 1;
+  } else {
+    nr->epb_next = G_MAXUINT;
+    nr->epb_checked = end;
+  }
+}
+
 gboolean
 nal_reader_read (NalReader * nr, guint nbits)
 {
@@ -95,14 +128,18 @@ nal_reader_read (NalReader * nr, guint nbits)
     if (G_UNLIKELY (nr->byte >= nr->size))
       return FALSE;
 
-    byte = nr->data[nr->byte++];
-    nr->epb_cache = (nr->epb_cache << 8) | byte;
+    if (G_UNLIKELY (nr->byte >= nr->epb_checked))
+      nal_reader_scan_epb (nr, nr->byte);
 
-    /* check if the byte is a emulation_prevention_three_byte */
-    if ((nr->epb_cache & 0xffffff) == 0x3) {
+    /* skip the emulation_prevention_three_byte */
+    if (G_UNLIKELY (nr->byte == nr->epb_next)) {
+      nr->byte++;
       nr->n_epb++;
+      nal_reader_scan_epb (nr, nr->byte);
       goto next_byte;
     }
+
+    byte = nr->data[nr->byte++];
     nr->cache = (nr->cache << 8) | nr->first_byte;
     nr->first_byte = byte;
     nr->bits_in_cache += 8;
@@ -295,15 +332,108 @@ nal_reader_has_more_data (NalReader * nr)
 
 /***********  end of nal parser ***************/
 
+#if defined(HAVE_NAL_SCAN_NEON)
+static inline guint
+nal_scan_ctz64 (guint64 v)
+{
+#if defined(__GNUC__)
+  return __builtin_ctzll (v);
+#else
+  guint n = 0;
+
+  while (!(v & 1)) {
+    v >>= 1;
+    n++;
+  }
+  return n;
+#endif
+}
+#endif
+
+/* Returns the offset of the first 0x00 0x00 @last sequence that lies fully
+ * within @size bytes of @data, or -1.
+ *
+ * The vector loops compare 16 windows at a time using three overlapping
+ * unaligned loads. SSE2 and NEON are part of the x86-64 and AArch64 base
+ * ISAs, so they are picked at build time and need no runtime check. The
+ * scalar loop handles the tail and other architectures and skips up to
+ * three bytes at a time based on the last byte of the window. */
+static inline gint
+nal_scan_for_00_00_xx (const guint8 * data, guint size, guint8 last)
+{
+  guint i = 0;
+
+#if defined(HAVE_NAL_SCAN_SSE2)
+  if (size >= 18) {
+    const __m128i zero = _mm_setzero_si128 ();
+    const __m128i third = _mm_set1_epi8 ((gchar) last);
+
+    for (; i <= size - 18; i += 16) {
+      __m128i v0 = _mm_loadu_si128 ((const __m128i *) (data + i));
+      __m128i v1 = _mm_loadu_si128 ((const __m128i *) (data + i + 1));
+      __m128i v2 = _mm_loadu_si128 ((const __m128i *) (data + i + 2));
+      __m128i m = _mm_and_si128 (_mm_and_si128 (_mm_cmpeq_epi8 (v0, zero),
+              _mm_cmpeq_epi8 (v1, zero)), _mm_cmpeq_epi8 (v2, third));
+      gint mask = _mm_movemask_epi8 (m);
+
+      if (mask)
+        return i + g_bit_nth_lsf ((gulong) mask, -1);
+    }
+  }
+#elif defined(HAVE_NAL_SCAN_NEON)
+  if (size >= 18) {
+    const uint8x16_t zero = vdupq_n_u8 (0);
+    const uint8x16_t third = vdupq_n_u8 (last);
+
+    for (; i <= size - 18; i += 16) {
+      uint8x16_t v0 = vld1q_u8 (data + i);
+      uint8x16_t v1 = vld1q_u8 (data + i + 1);
+      uint8x16_t v2 = vld1q_u8 (data + i + 2);
+      uint8x16_t m = vandq_u8 (vandq_u8 (vceqq_u8 (v0, zero),
+              vceqq_u8 (v1, zero)), vceqq_u8 (v2, third));
+      /* Narrow to 4 bits per lane to get a scalar mask */
+      guint64 mask =
+          vget_lane_u64 (vreinterpret_u64_u8 (vshrn_n_u16 (vreinterpretq_u16_u8
+                  (m), 4)), 0);
+
+      if (mask)
+        return i + nal_scan_ctz64 (mask) / 4;
+    }
+  }
+#endif
+
+  while (i + 2 < size) {
+    guint8 b = data[i + 2];
+
+    if (b != 0x00 && b != last) {
+      /* No window starting at i, i + 1 or i + 2 can match */
+      i += 3;
+    } else if (data[i + 1] != 0x00) {
+      i += 2;
+    } else if (data[i] != 0x00 || b != last) {
+      i++;
+    } else {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
 gint
 scan_for_start_codes (const guint8 * data, guint size)
 {
-  GstByteReader br;
-  gst_byte_reader_init (&br, data, size);
-
   /* NALU not empty, so we can at least expect 1 (even 2) bytes following sc */
-  return gst_byte_reader_masked_scan_uint32 (&br, 0xffffff00, 0x00000100,
-      0, size);
+  if (size < 4)
+    return -1;
+
+  return nal_scan_for_00_00_xx (data, size - 1, 0x01);
+}
+
+gint
+scan_for_emulation_prevention_bytes (const guint8 * data, guint size)
+{
+  return nal_scan_for_00_00_xx (data, size, 0x03);
 }
 
 void
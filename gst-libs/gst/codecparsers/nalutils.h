@@ -51,7 +51,8 @@ typedef struct
   guint byte;                   /* Byte position */
   guint bits_in_cache;          /* bitpos in the cache of next bit */
   guint8 first_byte;
-  guint32 epb_cache;            /* cache 3 bytes to check emulation prevention bytes */
+  guint epb_next;               /* Byte position of the next known emulation prevention byte */
+  guint epb_checked;            /* Emulation prevention bytes before this position are known */
   guint64 cache;                /* cached bytes */
 } NalReader;
 
@@ -196,6 +197,9 @@ gboolean nal_reader_get_se (NalReader * nr, gint32 * val);
 G_GNUC_INTERNAL
 gint scan_for_start_codes (const guint8 * data, guint size);
 
+G_GNUC_INTERNAL
+gint scan_for_emulation_prevention_bytes (const guint8 * data, guint size);
+
 G_GNUC_INTERNAL
 void nal_writer_init (NalWriter * nw, guint nal_prefix_size, gboolean packetized);
 
@@ -30,10 +30,18 @@
 #endif
 
 #include "gstav1decoder.h"
+#include "gstcodecpicturepool.h"
+#include "gstcodecstats.h"
 
 GST_DEBUG_CATEGORY (gst_av1_decoder_debug);
 #define GST_CAT_DEFAULT gst_av1_decoder_debug
 
+enum
+{
+  PROP_0,
+  PROP_STATS,
+};
+
 struct _GstAV1DecoderPrivate
 {
   gint max_width;
@@ -43,6 +51,16 @@ struct _GstAV1DecoderPrivate
   GstAV1Dpb *dpb;
   GstAV1Picture *current_picture;
   GstVideoCodecFrame *current_frame;
+
+  /* GstAV1Tile of current picture, batched if subclass implements
+   * decode_tiles */
+  GArray *tiles;
+
+  /* recycled picture objects */
+  GstCodecPicturePool *picture_pool;
+
+  /* time spent per stage */
+  GstCodecStats *stats;
 };
 
 #define parent_class gst_av1_decoder_parent_class
@@ -52,6 +70,10 @@ G_DEFINE_ABSTRACT_TYPE_WITH_CODE (GstAV1Decoder, gst_av1_decoder,
     GST_DEBUG_CATEGORY_INIT (gst_av1_decoder_debug, "av1decoder", 0,
         "AV1 Video Decoder"));
 
+static void gst_av1_decoder_finalize (GObject * object);
+static void gst_av1_decoder_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+
 static gboolean gst_av1_decoder_start (GstVideoDecoder * decoder);
 static gboolean gst_av1_decoder_stop (GstVideoDecoder * decoder);
 static gboolean gst_av1_decoder_set_format (GstVideoDecoder * decoder,
@@ -68,8 +90,28 @@ static GstAV1Picture *gst_av1_decoder_duplicate_picture_default (GstAV1Decoder *
 static void
 gst_av1_decoder_class_init (GstAV1DecoderClass * klass)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
   GstVideoDecoderClass *decoder_class = GST_VIDEO_DECODER_CLASS (klass);
 
+  object_class->finalize = GST_DEBUG_FUNCPTR (gst_av1_decoder_finalize);
+  object_class->get_property = gst_av1_decoder_get_property;
+
+  /**
+   * GstAV1Decoder:stats:
+   *
+   * Time spent by the decoder since it was started, split between the
+   * baseclass ("parse") and the subclass methods ("new-picture",
+   * "start-picture", "decode" for decode_tile() or decode_tiles(),
+   * "end-picture" and "output"). See #GstH264Decoder:stats for the
+   * structure layout.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (object_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Time spent parsing, in each subclass method and outputting",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   decoder_class->start = GST_DEBUG_FUNCPTR (gst_av1_decoder_start);
   decoder_class->stop = GST_DEBUG_FUNCPTR (gst_av1_decoder_stop);
   decoder_class->set_format = GST_DEBUG_FUNCPTR (gst_av1_decoder_set_format);
@@ -89,6 +131,39 @@ gst_av1_decoder_init (GstAV1Decoder * self)
   gst_video_decoder_set_packetized (GST_VIDEO_DECODER (self), TRUE);
 
   self->priv = gst_av1_decoder_get_instance_private (self);
+  self->priv->tiles = g_array_new (FALSE, FALSE, sizeof (GstAV1Tile));
+  self->priv->picture_pool =
+      gst_codec_picture_pool_new (sizeof (GstAV1Picture));
+  self->priv->stats = gst_codec_stats_new (GST_OBJECT (self));
+}
+
+static void
+gst_av1_decoder_finalize (GObject * object)
+{
+  GstAV1Decoder *self = GST_AV1_DECODER (object);
+
+  g_array_unref (self->priv->tiles);
+  gst_codec_picture_pool_unref (self->priv->picture_pool);
+  gst_codec_stats_free (self->priv->stats);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_av1_decoder_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstAV1Decoder *self = GST_AV1_DECODER (object);
+
+  switch (prop_id) {
+    case PROP_STATS:
+      g_value_take_boxed (value,
+          gst_codec_stats_get_structure (self->priv->stats));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
 }
 
 static void
@@ -101,6 +176,7 @@ gst_av1_decoder_reset (GstAV1Decoder * self)
   gst_av1_picture_clear (&priv->current_picture);
   priv->current_frame = NULL;
   priv->profile = GST_AV1_PROFILE_UNDEFINED;
+  g_array_set_size (priv->tiles, 0);
 
   if (priv->dpb)
     gst_av1_dpb_clear (priv->dpb);
@@ -119,6 +195,8 @@ gst_av1_decoder_start (GstVideoDecoder * decoder)
 
   gst_av1_decoder_reset (self);
 
+  gst_codec_stats_reset (priv->stats);
+
   return TRUE;
 }
 
@@ -193,7 +271,7 @@ gst_av1_decoder_duplicate_picture_default (GstAV1Decoder * decoder,
 {
   GstAV1Picture *new_picture;
 
-  new_picture = gst_av1_picture_new ();
+  new_picture = gst_av1_picture_new_from_pool (decoder->priv->picture_pool);
 
   return new_picture;
 }
@@ -298,6 +376,8 @@ gst_av1_decoder_decode_tile_group (GstAV1Decoder * self,
   GstAV1DecoderClass *klass = GST_AV1_DECODER_GET_CLASS (self);
   GstAV1Picture *picture = priv->current_picture;
   GstAV1Tile tile;
+  GstClockTime begin;
+  gboolean ok;
 
   if (!picture) {
     GST_ERROR_OBJECT (self, "No picture has created for current frame");
@@ -312,8 +392,19 @@ gst_av1_decoder_decode_tile_group (GstAV1Decoder * self,
   tile.obu = *obu;
   tile.tile_group = *tile_group;
 
+  if (klass->decode_tiles) {
+    GST_LOG_OBJECT (self, "Queue tile group %d - %d", tile_group->tg_start,
+        tile_group->tg_end);
+    g_array_append_val (priv->tiles, tile);
+    return TRUE;
+  }
+
   g_assert (klass->decode_tile);
-  if (!klass->decode_tile (self, picture, &tile)) {
+  begin = gst_codec_stats_stage_begin (priv->stats);
+  ok = klass->decode_tile (self, picture, &tile);
+  gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_DECODE, begin);
+
+  if (!ok) {
     GST_ERROR_OBJECT (self, "Decode tile error");
     return FALSE;
   }
@@ -321,6 +412,31 @@ gst_av1_decoder_decode_tile_group (GstAV1Decoder * self,
   return TRUE;
 }
 
+static gboolean
+gst_av1_decoder_submit_tiles (GstAV1Decoder * self)
+{
+  GstAV1DecoderPrivate *priv = self->priv;
+  GstAV1DecoderClass *klass = GST_AV1_DECODER_GET_CLASS (self);
+  GstClockTime begin;
+  gboolean ret;
+
+  if (!klass->decode_tiles || priv->tiles->len == 0)
+    return TRUE;
+
+  GST_LOG_OBJECT (self, "Submit %d tile groups", priv->tiles->len);
+
+  begin = gst_codec_stats_stage_begin (priv->stats);
+  ret = klass->decode_tiles (self, priv->current_picture,
+      (GstAV1Tile *) priv->tiles->data, priv->tiles->len);
+  gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_DECODE, begin);
+  g_array_set_size (priv->tiles, 0);
+
+  if (!ret)
+    GST_ERROR_OBJECT (self, "Decode tiles error");
+
+  return ret;
+}
+
 static gboolean
 gst_av1_decoder_decode_frame_header (GstAV1Decoder * self,
     GstAV1FrameHeaderOBU * frame_header)
@@ -328,6 +444,8 @@ gst_av1_decoder_decode_frame_header (GstAV1Decoder * self,
   GstAV1DecoderPrivate *priv = self->priv;
   GstAV1DecoderClass *klass = GST_AV1_DECODER_GET_CLASS (self);
   GstAV1Picture *picture = NULL;
+  GstClockTime begin;
+  gboolean ok;
 
   g_assert (priv->current_frame);
 
@@ -363,7 +481,7 @@ gst_av1_decoder_decode_frame_header (GstAV1Decoder * self,
     picture->frame_hdr = *frame_header;
     priv->current_picture = picture;
   } else {
-    picture = gst_av1_picture_new ();
+    picture = gst_av1_picture_new_from_pool (priv->picture_pool);
     picture->frame_hdr = *frame_header;
     picture->display_frame_id = frame_header->display_frame_id;
     picture->show_frame = frame_header->show_frame;
@@ -376,7 +494,12 @@ gst_av1_decoder_decode_frame_header (GstAV1Decoder * self,
           GST_VIDEO_CODEC_FRAME_FLAG_DECODE_ONLY);
 
     if (klass->new_picture) {
-      if (!klass->new_picture (self, priv->current_frame, picture)) {
+      begin = gst_codec_stats_stage_begin (priv->stats);
+      ok = klass->new_picture (self, priv->current_frame, picture);
+      gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_NEW_PICTURE,
+          begin);
+
+      if (!ok) {
         GST_ERROR_OBJECT (self, "new picture error");
         return FALSE;
       }
@@ -384,7 +507,12 @@ gst_av1_decoder_decode_frame_header (GstAV1Decoder * self,
     priv->current_picture = picture;
 
     if (klass->start_picture) {
-      if (!klass->start_picture (self, picture, priv->dpb)) {
+      begin = gst_codec_stats_stage_begin (priv->stats);
+      ok = klass->start_picture (self, picture, priv->dpb);
+      gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_START_PICTURE,
+          begin);
+
+      if (!ok) {
         GST_ERROR_OBJECT (self, "start picture error");
         return FALSE;
       }
@@ -534,10 +662,14 @@ gst_av1_decoder_handle_frame (GstVideoDecoder * decoder,
   guint32 total_consumed, consumed;
   GstAV1OBU obu;
   GstAV1ParserResult res;
+  GstClockTime begin;
+  gboolean ok;
 
   GST_LOG_OBJECT (self, "handle frame id %d, buf %" GST_PTR_FORMAT,
       frame->system_frame_number, in_buf);
 
+  gst_codec_stats_frame_begin (priv->stats);
+
   priv->current_frame = frame;
   g_assert (!priv->current_picture);
 
@@ -545,6 +677,7 @@ gst_av1_decoder_handle_frame (GstVideoDecoder * decoder,
     priv->current_frame = NULL;
     GST_ERROR_OBJECT (self, "can not map input buffer");
     ret = GST_FLOW_ERROR;
+    gst_codec_stats_frame_end (priv->stats);
     return ret;
   }
 
@@ -572,8 +705,18 @@ gst_av1_decoder_handle_frame (GstVideoDecoder * decoder,
   }
 
   if (!priv->current_picture->frame_hdr.show_existing_frame) {
+    if (!gst_av1_decoder_submit_tiles (self)) {
+      ret = GST_FLOW_ERROR;
+      goto out;
+    }
+
     if (klass->end_picture) {
-      if (!klass->end_picture (self, priv->current_picture)) {
+      begin = gst_codec_stats_stage_begin (priv->stats);
+      ok = klass->end_picture (self, priv->current_picture);
+      gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_END_PICTURE,
+          begin);
+
+      if (!ok) {
         ret = GST_FLOW_ERROR;
         GST_ERROR_OBJECT (self, "end picture error");
         goto out;
@@ -584,6 +727,8 @@ gst_av1_decoder_handle_frame (GstVideoDecoder * decoder,
   gst_av1_decoder_update_state (self);
 
 out:
+  /* queued tiles point to the input buffer */
+  g_array_set_size (priv->tiles, 0);
   gst_buffer_unmap (in_buf, &map);
 
   if (ret == GST_FLOW_OK) {
@@ -591,7 +736,9 @@ out:
         priv->current_picture->frame_hdr.show_existing_frame) {
       g_assert (klass->output_picture);
       /* transfer ownership of frame and picture */
+      begin = gst_codec_stats_stage_begin (priv->stats);
       ret = klass->output_picture (self, frame, priv->current_picture);
+      gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_OUTPUT, begin);
     } else {
       GST_LOG_OBJECT (self, "Decode only picture %p", priv->current_picture);
       GST_VIDEO_CODEC_FRAME_SET_DECODE_ONLY (frame);
@@ -610,5 +757,6 @@ out:
 
   priv->current_picture = NULL;
   priv->current_frame = NULL;
+  gst_codec_stats_frame_end (priv->stats);
   return ret;
 }
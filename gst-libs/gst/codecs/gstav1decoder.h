@@ -125,7 +125,8 @@ struct _GstAV1DecoderClass
    * @tile: (transfer none): a #GstAV1Tile
    *
    * Provides the tile data with tile group header and required raw
-   * bitstream for subclass to decode it.
+   * bitstream for subclass to decode it. Not called if decode_tiles is
+   * implemented.
    *
    * Since: 1.20
    */
@@ -159,6 +160,28 @@ struct _GstAV1DecoderClass
                                         GstVideoCodecFrame * frame,
                                         GstAV1Picture * picture);
 
+  /**
+   * GstAV1DecoderClass::decode_tiles:
+   * @decoder: a #GstAV1Decoder
+   * @picture: (transfer none): a #GstAV1Picture
+   * @tiles: (array length=num_tiles) (transfer none): the #GstAV1Tile of
+   *   all tile groups of @picture, in bitstream order
+   * @num_tiles: the number of @tiles
+   *
+   * Optional. If implemented, the tile groups of a picture are collected
+   * and provided at once right before end_picture, instead of calling
+   * decode_tile per tile group. This allows subclass to submit a frame
+   * with many tile groups to the accelerator in one call.
+   *
+   * The tile data point into the input buffer of the current frame.
+   *
+   * Since: 1.20
+   */
+  gboolean        (*decode_tiles)      (GstAV1Decoder * decoder,
+                                        GstAV1Picture * picture,
+                                        GstAV1Tile * tiles,
+                                        guint num_tiles);
+
   /*< private >*/
   gpointer padding[GST_PADDING_LARGE];
 };
@@ -22,6 +22,7 @@
 #endif
 
 #include "gstav1picture.h"
+#include "gstcodecpicturepool.h"
 
 GST_DEBUG_CATEGORY_EXTERN (gst_av1_decoder_debug);
 #define GST_CAT_DEFAULT gst_av1_decoder_debug
@@ -29,16 +30,40 @@ GST_DEBUG_CATEGORY_EXTERN (gst_av1_decoder_debug);
 GST_DEFINE_MINI_OBJECT_TYPE (GstAV1Picture, gst_av1_picture);
 
 static void
-_gst_av1_picture_free (GstAV1Picture * picture)
+_gst_av1_picture_clear_internal (GstAV1Picture * picture)
 {
   GST_TRACE ("Free picture %p", picture);
 
   if (picture->notify)
     picture->notify (picture->user_data);
+}
+
+static void
+_gst_av1_picture_free (GstAV1Picture * picture)
+{
+  _gst_av1_picture_clear_internal (picture);
 
   g_free (picture);
 }
 
+static void
+_gst_av1_picture_free_pooled (GstAV1Picture * picture)
+{
+  _gst_av1_picture_clear_internal (picture);
+
+  gst_codec_picture_pool_release (picture);
+}
+
+static void
+_gst_av1_picture_init (GstAV1Picture * pic,
+    GstMiniObjectFreeFunction free_func)
+{
+  gst_mini_object_init (GST_MINI_OBJECT_CAST (pic), 0,
+      GST_TYPE_AV1_PICTURE, NULL, NULL, free_func);
+
+  GST_TRACE ("New picture %p", pic);
+}
+
 /**
  * gst_av1_picture_new:
  *
@@ -54,12 +79,20 @@ gst_av1_picture_new (void)
   GstAV1Picture *pic;
 
   pic = g_new0 (GstAV1Picture, 1);
-
-  gst_mini_object_init (GST_MINI_OBJECT_CAST (pic), 0,
-      GST_TYPE_AV1_PICTURE, NULL, NULL,
+  _gst_av1_picture_init (pic,
       (GstMiniObjectFreeFunction) _gst_av1_picture_free);
 
-  GST_TRACE ("New picture %p", pic);
+  return pic;
+}
+
+GstAV1Picture *
+gst_av1_picture_new_from_pool (GstCodecPicturePool * pool)
+{
+  GstAV1Picture *pic;
+
+  pic = gst_codec_picture_pool_acquire (pool);
+  _gst_av1_picture_init (pic,
+      (GstMiniObjectFreeFunction) _gst_av1_picture_free_pooled);
 
   return pic;
 }
@@ -0,0 +1,151 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gstcodecpicturepool.h"
+#include <string.h>
+
+/* Upper bound of idle pictures kept around. A DPB never holds more than
+ * 16 frames (32 fields), so anything beyond is returned to the allocator */
+#define GST_CODEC_PICTURE_POOL_MAX_IDLE 32
+
+/* Each pooled picture is preceded by a header pointing back to its pool,
+ * so that the public picture structs don't need an extra field. Keep the
+ * header size a multiple of 16 so the picture itself stays well aligned */
+typedef struct
+{
+  GstCodecPicturePool *pool;
+} GstCodecPictureHeader;
+
+#define HEADER_SIZE GST_ROUND_UP_16 (sizeof (GstCodecPictureHeader))
+#define HEADER_FROM_PICTURE(p) \
+    ((GstCodecPictureHeader *) (((guint8 *) (p)) - HEADER_SIZE))
+#define PICTURE_FROM_HEADER(h) ((gpointer) (((guint8 *) (h)) + HEADER_SIZE))
+
+struct _GstCodecPicturePool
+{
+  gint refcount;
+  gsize picture_size;
+
+  /* idle GstCodecPictureHeader */
+  GstAtomicQueue *idle;
+};
+
+GstCodecPicturePool *
+gst_codec_picture_pool_new (gsize picture_size)
+{
+  GstCodecPicturePool *pool;
+
+  g_return_val_if_fail (picture_size > 0, NULL);
+
+  pool = g_new0 (GstCodecPicturePool, 1);
+  pool->refcount = 1;
+  pool->picture_size = picture_size;
+  pool->idle = gst_atomic_queue_new (GST_CODEC_PICTURE_POOL_MAX_IDLE);
+
+  return pool;
+}
+
+GstCodecPicturePool *
+gst_codec_picture_pool_ref (GstCodecPicturePool * pool)
+{
+  g_return_val_if_fail (pool != NULL, NULL);
+
+  g_atomic_int_inc (&pool->refcount);
+
+  return pool;
+}
+
+void
+gst_codec_picture_pool_unref (GstCodecPicturePool * pool)
+{
+  GstCodecPictureHeader *header;
+
+  g_return_if_fail (pool != NULL);
+
+  if (!g_atomic_int_dec_and_test (&pool->refcount))
+    return;
+
+  while ((header = gst_atomic_queue_pop (pool->idle)) != NULL)
+    g_free (header);
+
+  gst_atomic_queue_unref (pool->idle);
+  g_free (pool);
+}
+
+/*
+ * gst_codec_picture_pool_acquire:
+ * @pool: a #GstCodecPicturePool
+ *
+ * Returns: zero-filled memory of the picture size @pool was created with,
+ * to be returned with gst_codec_picture_pool_release() from the picture's
+ * free function. The picture keeps @pool alive until then.
+ */
+gpointer
+gst_codec_picture_pool_acquire (GstCodecPicturePool * pool)
+{
+  GstCodecPictureHeader *header;
+  gpointer picture;
+
+  g_return_val_if_fail (pool != NULL, NULL);
+
+  header = gst_atomic_queue_pop (pool->idle);
+  if (header) {
+    picture = PICTURE_FROM_HEADER (header);
+    memset (picture, 0, pool->picture_size);
+  } else {
+    header = g_malloc0 (HEADER_SIZE + pool->picture_size);
+    picture = PICTURE_FROM_HEADER (header);
+  }
+
+  header->pool = gst_codec_picture_pool_ref (pool);
+
+  return picture;
+}
+
+/*
+ * gst_codec_picture_pool_release:
+ * @picture: a picture returned by gst_codec_picture_pool_acquire()
+ *
+ * Puts @picture back to its pool, or frees it if the pool holds enough
+ * idle pictures already.
+ */
+void
+gst_codec_picture_pool_release (gpointer picture)
+{
+  GstCodecPictureHeader *header;
+  GstCodecPicturePool *pool;
+
+  g_return_if_fail (picture != NULL);
+
+  header = HEADER_FROM_PICTURE (picture);
+  pool = header->pool;
+  header->pool = NULL;
+
+  /* The queue length is only a hint when pictures are released from
+   * several threads, which is fine for a cache bound */
+  if (gst_atomic_queue_length (pool->idle) < GST_CODEC_PICTURE_POOL_MAX_IDLE)
+    gst_atomic_queue_push (pool->idle, header);
+  else
+    g_free (header);
+
+  gst_codec_picture_pool_unref (pool);
+}
@@ -0,0 +1,72 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_CODEC_PICTURE_POOL_H__
+#define __GST_CODEC_PICTURE_POOL_H__
+
+#include <gst/gst.h>
+#include <gst/codecs/gsth264picture.h>
+#include <gst/codecs/gsth265picture.h>
+#include <gst/codecs/gstvp8picture.h>
+#include <gst/codecs/gstvp9picture.h>
+#include <gst/codecs/gstmpeg2picture.h>
+#include <gst/codecs/gstav1picture.h>
+
+G_BEGIN_DECLS
+
+/* Internal helper used by the stateless decoder baseclasses to recycle
+ * picture mini objects instead of allocating one per decoded frame.
+ * Not part of the public API */
+typedef struct _GstCodecPicturePool GstCodecPicturePool;
+
+G_GNUC_INTERNAL
+GstCodecPicturePool * gst_codec_picture_pool_new (gsize picture_size);
+
+G_GNUC_INTERNAL
+GstCodecPicturePool * gst_codec_picture_pool_ref (GstCodecPicturePool * pool);
+
+G_GNUC_INTERNAL
+void                  gst_codec_picture_pool_unref (GstCodecPicturePool * pool);
+
+G_GNUC_INTERNAL
+gpointer              gst_codec_picture_pool_acquire (GstCodecPicturePool * pool);
+
+G_GNUC_INTERNAL
+void                  gst_codec_picture_pool_release (gpointer picture);
+
+G_GNUC_INTERNAL
+GstH264Picture *      gst_h264_picture_new_from_pool (GstCodecPicturePool * pool);
+
+G_GNUC_INTERNAL
+GstH265Picture *      gst_h265_picture_new_from_pool (GstCodecPicturePool * pool);
+
+G_GNUC_INTERNAL
+GstVp8Picture *       gst_vp8_picture_new_from_pool (GstCodecPicturePool * pool);
+
+G_GNUC_INTERNAL
+GstVp9Picture *       gst_vp9_picture_new_from_pool (GstCodecPicturePool * pool);
+
+G_GNUC_INTERNAL
+GstMpeg2Picture *     gst_mpeg2_picture_new_from_pool (GstCodecPicturePool * pool);
+
+G_GNUC_INTERNAL
+GstAV1Picture *       gst_av1_picture_new_from_pool (GstCodecPicturePool * pool);
+
+G_END_DECLS
+
+#endif /* __GST_CODEC_PICTURE_POOL_H__ */
@@ -0,0 +1,191 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:gstcodecslicebuffer
+ * @title: GstCodecSliceBuffer
+ * @short_description: Contiguous per picture slice data storage
+ *
+ * Decoder APIs taking the whole bitstream of a picture at once, along with
+ * the offset of each slice, can accumulate the slices passed to
+ * decode_slice() in a #GstCodecSliceBuffer and submit them in one go from
+ * end_picture(). The storage is kept across pictures, so once it has grown
+ * to the size of the biggest picture no further allocation happens.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include "gstcodecslicebuffer.h"
+
+struct _GstCodecSliceBuffer
+{
+  GByteArray *data;
+  GArray *offsets;
+};
+
+static const guint8 start_code[] = { 0x00, 0x00, 0x01 };
+
+/**
+ * gst_codec_slice_buffer_new: (skip)
+ *
+ * Create new #GstCodecSliceBuffer
+ *
+ * Returns: a new #GstCodecSliceBuffer
+ *
+ * Since: 1.20
+ */
+GstCodecSliceBuffer *
+gst_codec_slice_buffer_new (void)
+{
+  GstCodecSliceBuffer *buffer;
+
+  buffer = g_new0 (GstCodecSliceBuffer, 1);
+  buffer->data = g_byte_array_new ();
+  buffer->offsets = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  return buffer;
+}
+
+/**
+ * gst_codec_slice_buffer_free:
+ * @buffer: a #GstCodecSliceBuffer to free
+ *
+ * Free the @buffer
+ *
+ * Since: 1.20
+ */
+void
+gst_codec_slice_buffer_free (GstCodecSliceBuffer * buffer)
+{
+  g_return_if_fail (buffer != NULL);
+
+  g_byte_array_unref (buffer->data);
+  g_array_unref (buffer->offsets);
+  g_free (buffer);
+}
+
+/**
+ * gst_codec_slice_buffer_reset:
+ * @buffer: a #GstCodecSliceBuffer
+ *
+ * Drop all slices stored in @buffer, usually from start_picture(). The
+ * allocated storage is kept for the next picture.
+ *
+ * Since: 1.20
+ */
+void
+gst_codec_slice_buffer_reset (GstCodecSliceBuffer * buffer)
+{
+  g_return_if_fail (buffer != NULL);
+
+  g_byte_array_set_size (buffer->data, 0);
+  g_array_set_size (buffer->offsets, 0);
+}
+
+/**
+ * gst_codec_slice_buffer_add_slice:
+ * @buffer: a #GstCodecSliceBuffer
+ * @data: (array length=size): the slice data
+ * @size: the size of @data
+ * @add_start_code: whether to prepend a 0x000001 start code to @data
+ *
+ * Append a slice to @buffer.
+ *
+ * Returns: the offset of the slice, including its start code, in the data
+ * returned by gst_codec_slice_buffer_get_data()
+ *
+ * Since: 1.20
+ */
+guint
+gst_codec_slice_buffer_add_slice (GstCodecSliceBuffer * buffer,
+    const guint8 * data, gsize size, gboolean add_start_code)
+{
+  guint offset;
+  gsize prefix_size;
+
+  g_return_val_if_fail (buffer != NULL, 0);
+  g_return_val_if_fail (data != NULL || size == 0, 0);
+
+  offset = buffer->data->len;
+  prefix_size = add_start_code ? sizeof (start_code) : 0;
+
+  /* GByteArray grows to the next power of two, and shrinking it keeps the
+   * allocation, so this only reallocates while the pictures get bigger */
+  g_byte_array_set_size (buffer->data, offset + prefix_size + size);
+
+  if (add_start_code)
+    memcpy (buffer->data->data + offset, start_code, prefix_size);
+  memcpy (buffer->data->data + offset + prefix_size, data, size);
+
+  g_array_append_val (buffer->offsets, offset);
+
+  return offset;
+}
+
+/**
+ * gst_codec_slice_buffer_get_data:
+ * @buffer: a #GstCodecSliceBuffer
+ * @size: (out) (optional): the size of the stored data
+ *
+ * Retrieve the data of all the slices added since the last
+ * gst_codec_slice_buffer_reset(). The returned pointer is only valid until
+ * the next slice is added.
+ *
+ * Returns: (transfer none) (nullable): the slice data
+ *
+ * Since: 1.20
+ */
+guint8 *
+gst_codec_slice_buffer_get_data (GstCodecSliceBuffer * buffer, gsize * size)
+{
+  g_return_val_if_fail (buffer != NULL, NULL);
+
+  if (size)
+    *size = buffer->data->len;
+
+  return buffer->data->data;
+}
+
+/**
+ * gst_codec_slice_buffer_get_offsets:
+ * @buffer: a #GstCodecSliceBuffer
+ * @num_slices: (out) (optional): the number of slices
+ *
+ * Retrieve the offset of each slice in the data returned by
+ * gst_codec_slice_buffer_get_data(). The returned pointer is only valid
+ * until the next slice is added.
+ *
+ * Returns: (transfer none) (nullable): the slice offsets
+ *
+ * Since: 1.20
+ */
+const guint *
+gst_codec_slice_buffer_get_offsets (GstCodecSliceBuffer * buffer,
+    guint * num_slices)
+{
+  g_return_val_if_fail (buffer != NULL, NULL);
+
+  if (num_slices)
+    *num_slices = buffer->offsets->len;
+
+  return (const guint *) buffer->offsets->data;
+}
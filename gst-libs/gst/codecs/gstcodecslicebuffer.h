@@ -0,0 +1,62 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_CODEC_SLICE_BUFFER_H__
+#define __GST_CODEC_SLICE_BUFFER_H__
+
+#include <gst/codecs/codecs-prelude.h>
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/**
+ * GstCodecSliceBuffer:
+ *
+ * An opaque structure gathering the slice data of one picture into a single
+ * contiguous buffer, along with the offset of each slice in it.
+ *
+ * Since: 1.20
+ */
+typedef struct _GstCodecSliceBuffer GstCodecSliceBuffer;
+
+GST_CODECS_API
+GstCodecSliceBuffer * gst_codec_slice_buffer_new (void);
+
+GST_CODECS_API
+void          gst_codec_slice_buffer_free        (GstCodecSliceBuffer * buffer);
+
+GST_CODECS_API
+void          gst_codec_slice_buffer_reset       (GstCodecSliceBuffer * buffer);
+
+GST_CODECS_API
+guint         gst_codec_slice_buffer_add_slice   (GstCodecSliceBuffer * buffer,
+                                                  const guint8 * data,
+                                                  gsize size,
+                                                  gboolean add_start_code);
+
+GST_CODECS_API
+guint8 *      gst_codec_slice_buffer_get_data    (GstCodecSliceBuffer * buffer,
+                                                  gsize * size);
+
+GST_CODECS_API
+const guint * gst_codec_slice_buffer_get_offsets (GstCodecSliceBuffer * buffer,
+                                                  guint * num_slices);
+
+G_END_DECLS
+
+#endif /* __GST_CODEC_SLICE_BUFFER_H__ */
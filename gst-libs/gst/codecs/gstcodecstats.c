@@ -0,0 +1,212 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gstcodecstats.h"
+#include <string.h>
+
+GST_DEBUG_CATEGORY_STATIC (gst_codec_stats_debug);
+#define GST_CAT_DEFAULT gst_codec_stats_debug
+
+static const gchar *stage_names[GST_CODEC_STATS_NUM_STAGES] = {
+  "parse",
+  "new-picture",
+  "start-picture",
+  "decode",
+  "end-picture",
+  "output",
+};
+
+typedef struct
+{
+  guint64 calls;
+  GstClockTime total;
+  GstClockTime max;
+} GstCodecStatsEntry;
+
+struct _GstCodecStats
+{
+  /* Without ref */
+  GstObject *decoder;
+
+  GMutex lock;
+  guint64 frames;
+  GstCodecStatsEntry entries[GST_CODEC_STATS_NUM_STAGES];
+
+  /* Frame being handled, only accessed from the streaming thread */
+  GstClockTime frame_begin;
+  GstClockTime frame[GST_CODEC_STATS_NUM_STAGES];
+};
+
+GstCodecStats *
+gst_codec_stats_new (GstObject * decoder)
+{
+  static gsize cat_once = 0;
+  GstCodecStats *stats;
+
+  if (g_once_init_enter (&cat_once)) {
+    GST_DEBUG_CATEGORY_INIT (gst_codec_stats_debug, "codecstats", 0,
+        "Per-frame timing of the stateless decoder baseclasses");
+    g_once_init_leave (&cat_once, 1);
+  }
+
+  stats = g_new0 (GstCodecStats, 1);
+  stats->decoder = decoder;
+  g_mutex_init (&stats->lock);
+  stats->frame_begin = GST_CLOCK_TIME_NONE;
+
+  return stats;
+}
+
+void
+gst_codec_stats_free (GstCodecStats * stats)
+{
+  g_mutex_clear (&stats->lock);
+  g_free (stats);
+}
+
+void
+gst_codec_stats_reset (GstCodecStats * stats)
+{
+  g_mutex_lock (&stats->lock);
+  stats->frames = 0;
+  memset (stats->entries, 0, sizeof (stats->entries));
+  g_mutex_unlock (&stats->lock);
+
+  stats->frame_begin = GST_CLOCK_TIME_NONE;
+}
+
+static void
+gst_codec_stats_add (GstCodecStats * stats, GstCodecStatsStage stage,
+    GstClockTime elapsed)
+{
+  GstCodecStatsEntry *entry = &stats->entries[stage];
+
+  entry->calls++;
+  entry->total += elapsed;
+  entry->max = MAX (entry->max, elapsed);
+}
+
+/* Marks the beginning of an input frame. The time spent until
+ * gst_codec_stats_frame_end() which isn't accounted to any subclass
+ * method is the parse time, that is, bitstream parsing and the DPB
+ * management done by the baseclass */
+void
+gst_codec_stats_frame_begin (GstCodecStats * stats)
+{
+  memset (stats->frame, 0, sizeof (stats->frame));
+  stats->frame_begin = gst_util_get_timestamp ();
+}
+
+void
+gst_codec_stats_frame_end (GstCodecStats * stats)
+{
+  GstClockTime total, accounted = 0;
+  guint i;
+
+  if (!GST_CLOCK_TIME_IS_VALID (stats->frame_begin))
+    return;
+
+  total = gst_util_get_timestamp () - stats->frame_begin;
+  stats->frame_begin = GST_CLOCK_TIME_NONE;
+
+  for (i = GST_CODEC_STATS_PARSE + 1; i < GST_CODEC_STATS_NUM_STAGES; i++)
+    accounted += stats->frame[i];
+
+  stats->frame[GST_CODEC_STATS_PARSE] =
+      total > accounted ? total - accounted : 0;
+
+  g_mutex_lock (&stats->lock);
+  stats->frames++;
+  gst_codec_stats_add (stats, GST_CODEC_STATS_PARSE,
+      stats->frame[GST_CODEC_STATS_PARSE]);
+  g_mutex_unlock (&stats->lock);
+
+  GST_CAT_LOG_OBJECT (gst_codec_stats_debug, stats->decoder,
+      "frame %" G_GUINT64_FORMAT ": parse %" GST_TIME_FORMAT
+      ", new %" GST_TIME_FORMAT ", start %" GST_TIME_FORMAT ", decode %" GST_TIME_FORMAT
+      ", end %" GST_TIME_FORMAT ", output %" GST_TIME_FORMAT,
+      stats->frames, GST_TIME_ARGS (stats->frame[GST_CODEC_STATS_PARSE]),
+      GST_TIME_ARGS (stats->frame[GST_CODEC_STATS_NEW_PICTURE]),
+      GST_TIME_ARGS (stats->frame[GST_CODEC_STATS_START_PICTURE]),
+      GST_TIME_ARGS (stats->frame[GST_CODEC_STATS_DECODE]),
+      GST_TIME_ARGS (stats->frame[GST_CODEC_STATS_END_PICTURE]),
+      GST_TIME_ARGS (stats->frame[GST_CODEC_STATS_OUTPUT]));
+}
+
+GstClockTime
+gst_codec_stats_stage_begin (GstCodecStats * stats)
+{
+  return gst_util_get_timestamp ();
+}
+
+/* Accounts the time since @begin, as returned by
+ * gst_codec_stats_stage_begin(), to @stage */
+void
+gst_codec_stats_stage_end (GstCodecStats * stats, GstCodecStatsStage stage,
+    GstClockTime begin)
+{
+  GstClockTime elapsed = gst_util_get_timestamp () - begin;
+
+  g_return_if_fail (stage > GST_CODEC_STATS_PARSE &&
+      stage < GST_CODEC_STATS_NUM_STAGES);
+
+  g_mutex_lock (&stats->lock);
+  gst_codec_stats_add (stats, stage, elapsed);
+  g_mutex_unlock (&stats->lock);
+
+  /* Output can also happen while draining, outside of any frame */
+  if (GST_CLOCK_TIME_IS_VALID (stats->frame_begin))
+    stats->frame[stage] += elapsed;
+}
+
+/* Returns a "application/x-codec-decoder-stats" structure with the number
+ * of frames handled and, for each stage, the number of calls and the total
+ * and maximum time spent in nanoseconds */
+GstStructure *
+gst_codec_stats_get_structure (GstCodecStats * stats)
+{
+  GstStructure *s;
+  guint i;
+
+  s = gst_structure_new_empty ("application/x-codec-decoder-stats");
+
+  g_mutex_lock (&stats->lock);
+  gst_structure_set (s, "frames", G_TYPE_UINT64, stats->frames, NULL);
+
+  for (i = 0; i < GST_CODEC_STATS_NUM_STAGES; i++) {
+    GstCodecStatsEntry *entry = &stats->entries[i];
+    gchar *calls = g_strconcat (stage_names[i], "-calls", NULL);
+    gchar *total = g_strconcat (stage_names[i], "-time", NULL);
+    gchar *max = g_strconcat (stage_names[i], "-max-time", NULL);
+
+    gst_structure_set (s, calls, G_TYPE_UINT64, entry->calls,
+        total, G_TYPE_UINT64, entry->total,
+        max, G_TYPE_UINT64, entry->max, NULL);
+
+    g_free (calls);
+    g_free (total);
+    g_free (max);
+  }
+  g_mutex_unlock (&stats->lock);
+
+  return s;
+}
@@ -0,0 +1,69 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_CODEC_STATS_H__
+#define __GST_CODEC_STATS_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* Internal helper used by the stateless decoder baseclasses to measure
+ * where the time of each frame goes. Not part of the public API */
+typedef enum
+{
+  GST_CODEC_STATS_PARSE,
+  GST_CODEC_STATS_NEW_PICTURE,
+  GST_CODEC_STATS_START_PICTURE,
+  GST_CODEC_STATS_DECODE,
+  GST_CODEC_STATS_END_PICTURE,
+  GST_CODEC_STATS_OUTPUT,
+  GST_CODEC_STATS_NUM_STAGES,
+} GstCodecStatsStage;
+
+typedef struct _GstCodecStats GstCodecStats;
+
+G_GNUC_INTERNAL
+GstCodecStats * gst_codec_stats_new (GstObject * decoder);
+
+G_GNUC_INTERNAL
+void            gst_codec_stats_free (GstCodecStats * stats);
+
+G_GNUC_INTERNAL
+void            gst_codec_stats_reset (GstCodecStats * stats);
+
+G_GNUC_INTERNAL
+void            gst_codec_stats_frame_begin (GstCodecStats * stats);
+
+G_GNUC_INTERNAL
+void            gst_codec_stats_frame_end (GstCodecStats * stats);
+
+G_GNUC_INTERNAL
+GstClockTime    gst_codec_stats_stage_begin (GstCodecStats * stats);
+
+G_GNUC_INTERNAL
+void            gst_codec_stats_stage_end (GstCodecStats * stats,
+                                           GstCodecStatsStage stage,
+                                           GstClockTime begin);
+
+G_GNUC_INTERNAL
+GstStructure *  gst_codec_stats_get_structure (GstCodecStats * stats);
+
+G_END_DECLS
+
+#endif /* __GST_CODEC_STATS_H__ */
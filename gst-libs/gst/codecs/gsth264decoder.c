@@ -60,10 +60,21 @@
 
 #include <gst/base/base.h>
 #include "gsth264decoder.h"
+#include "gstcodecpicturepool.h"
+#include "gstcodecstats.h"
 
 GST_DEBUG_CATEGORY (gst_h264_decoder_debug);
 #define GST_CAT_DEFAULT gst_h264_decoder_debug
 
+#define DEFAULT_LOW_LATENCY FALSE
+
+enum
+{
+  PROP_0,
+  PROP_LOW_LATENCY,
+  PROP_STATS,
+};
+
 typedef enum
 {
   GST_H264_DECODER_FORMAT_NONE,
@@ -95,6 +106,15 @@ struct _GstH264DecoderPrivate
   /* used for low-latency vs. high throughput mode decision */
   gboolean is_live;
 
+  /* properties */
+  gboolean low_latency;
+
+  /* zero reordering is assumed because of low-latency, until a picture
+   * shows up out of order */
+  gboolean reorder_inferred;
+  gboolean reorder_seen;
+  gint last_decoded_poc;
+
   /* sps/pps of the current slice */
   const GstH264SPS *active_sps;
   const GstH264PPS *active_pps;
@@ -148,6 +168,15 @@ struct _GstH264DecoderPrivate
 
   /* For delayed output */
   GstQueueArray *output_queue;
+
+  /* recycled picture objects */
+  GstCodecPicturePool *picture_pool;
+
+  /* time spent per stage */
+  GstCodecStats *stats;
+
+  /* highest number of frames held at once since the last new_sequence() */
+  guint max_pictures_in_use;
 };
 
 typedef struct
@@ -167,6 +196,10 @@ G_DEFINE_ABSTRACT_TYPE_WITH_CODE (GstH264Decoder, gst_h264_decoder,
         "H.264 Video Decoder"));
 
 static void gst_h264_decoder_finalize (GObject * object);
+static void gst_h264_decoder_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_h264_decoder_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 
 static gboolean gst_h264_decoder_start (GstVideoDecoder * decoder);
 static gboolean gst_h264_decoder_stop (GstVideoDecoder * decoder);
@@ -191,6 +224,11 @@ static gboolean gst_h264_decoder_calculate_poc (GstH264Decoder * self,
 static gboolean gst_h264_decoder_init_gap_picture (GstH264Decoder * self,
     GstH264Picture * picture, gint frame_num);
 static gboolean gst_h264_decoder_drain_internal (GstH264Decoder * self);
+static guint gst_h264_decoder_get_max_num_reorder_frames (GstH264Decoder *
+    self);
+static void gst_h264_decoder_check_reorder (GstH264Decoder * self,
+    GstH264Picture * picture);
+static void gst_h264_decoder_update_pictures_in_use (GstH264Decoder * self);
 static gboolean gst_h264_decoder_finish_current_picture (GstH264Decoder * self);
 static gboolean gst_h264_decoder_finish_picture (GstH264Decoder * self,
     GstH264Picture * picture);
@@ -215,6 +253,54 @@ gst_h264_decoder_class_init (GstH264DecoderClass * klass)
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
   object_class->finalize = GST_DEBUG_FUNCPTR (gst_h264_decoder_finalize);
+  object_class->set_property = gst_h264_decoder_set_property;
+  object_class->get_property = gst_h264_decoder_get_property;
+
+  /**
+   * GstH264Decoder:low-latency:
+   *
+   * Output pictures as soon as they are decoded when the stream does not
+   * signal its reordering depth in the VUI, instead of holding up to the
+   * whole DPB. Zero reordering is assumed for streams with
+   * pic_order_cnt_type 2 or upstream caps with the constrained-baseline
+   * profile, in which case the DPB size reported to subclass is also
+   * reduced to the number of reference frames. Otherwise it is assumed
+   * until a picture is decoded out of order.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (object_class, PROP_LOW_LATENCY,
+      g_param_spec_boolean ("low-latency", "Low Latency",
+          "Output pictures without waiting for reordering if the stream "
+          "is known or observed to not reorder pictures",
+          DEFAULT_LOW_LATENCY, G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstH264Decoder:stats:
+   *
+   * Time spent by the decoder since it was started, as a
+   * "application/x-codec-decoder-stats" structure. It holds the number of
+   * input frames handled in "frames" and, for each of the "parse",
+   * "new-picture", "start-picture", "decode", "end-picture" and "output"
+   * stages, the number of calls as "<stage>-calls" and the total and
+   * longest time in nanoseconds as "<stage>-time" and "<stage>-max-time",
+   * all as #guint64.
+   *
+   * "parse" is the time spent in the baseclass itself (bitstream parsing
+   * and DPB management), the other stages are the time spent in the
+   * corresponding subclass methods, "decode" being decode_slice() and
+   * "output" output_picture(). Comparing them tells whether a pipeline is
+   * limited by parsing, by submitting work to the hardware or by waiting
+   * for decoded pictures. Per-frame values are logged in the "codecstats"
+   * debug category at LOG level.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (object_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Time spent parsing, in each subclass method and outputting",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
   decoder_class->start = GST_DEBUG_FUNCPTR (gst_h264_decoder_start);
   decoder_class->stop = GST_DEBUG_FUNCPTR (gst_h264_decoder_stop);
@@ -235,6 +321,8 @@ gst_h264_decoder_init (GstH264Decoder * self)
 
   self->priv = priv = gst_h264_decoder_get_instance_private (self);
 
+  priv->low_latency = DEFAULT_LOW_LATENCY;
+
   priv->ref_pic_list_p0 = g_array_sized_new (FALSE, TRUE,
       sizeof (GstH264Picture *), 32);
   g_array_set_clear_func (priv->ref_pic_list_p0,
@@ -274,6 +362,10 @@ gst_h264_decoder_init (GstH264Decoder * self)
       gst_queue_array_new_for_struct (sizeof (GstH264DecoderOutputFrame), 1);
   gst_queue_array_set_clear_func (priv->output_queue,
       (GDestroyNotify) gst_h264_decoder_clear_output_frame);
+
+  priv->picture_pool =
+      gst_codec_picture_pool_new (sizeof (GstH264Picture));
+  priv->stats = gst_codec_stats_new (GST_OBJECT (self));
 }
 
 static void
@@ -291,10 +383,49 @@ gst_h264_decoder_finalize (GObject * object)
   g_array_unref (priv->ref_pic_list0);
   g_array_unref (priv->ref_pic_list1);
   gst_queue_array_free (priv->output_queue);
+  gst_codec_picture_pool_unref (priv->picture_pool);
+  gst_codec_stats_free (priv->stats);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gst_h264_decoder_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstH264Decoder *self = GST_H264_DECODER (object);
+  GstH264DecoderPrivate *priv = self->priv;
+
+  switch (prop_id) {
+    case PROP_LOW_LATENCY:
+      priv->low_latency = g_value_get_boolean (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_h264_decoder_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstH264Decoder *self = GST_H264_DECODER (object);
+  GstH264DecoderPrivate *priv = self->priv;
+
+  switch (prop_id) {
+    case PROP_LOW_LATENCY:
+      g_value_set_boolean (value, priv->low_latency);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_codec_stats_get_structure (priv->stats));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 gst_h264_decoder_reset (GstH264Decoder * self)
 {
@@ -308,6 +439,9 @@ gst_h264_decoder_reset (GstH264Decoder * self)
   priv->width = 0;
   priv->height = 0;
   priv->nal_length_size = 4;
+  priv->reorder_inferred = FALSE;
+  priv->reorder_seen = FALSE;
+  priv->last_decoded_poc = G_MININT32;
 }
 
 static gboolean
@@ -321,6 +455,8 @@ gst_h264_decoder_start (GstVideoDecoder * decoder)
   priv->parser = gst_h264_nal_parser_new ();
   priv->dpb = gst_h264_dpb_new ();
 
+  gst_codec_stats_reset (priv->stats);
+
   return TRUE;
 }
 
@@ -421,6 +557,8 @@ gst_h264_decoder_handle_frame (GstVideoDecoder * decoder,
       GST_TIME_FORMAT, GST_TIME_ARGS (GST_BUFFER_PTS (in_buf)),
       GST_TIME_ARGS (GST_BUFFER_DTS (in_buf)));
 
+  gst_codec_stats_frame_begin (priv->stats);
+
   priv->current_frame = frame;
   priv->last_ret = GST_FLOW_OK;
 
@@ -463,6 +601,7 @@ gst_h264_decoder_handle_frame (GstVideoDecoder * decoder,
 
     gst_h264_picture_clear (&priv->current_picture);
     priv->current_frame = NULL;
+    gst_codec_stats_frame_end (priv->stats);
 
     return priv->last_ret;
   }
@@ -470,6 +609,7 @@ gst_h264_decoder_handle_frame (GstVideoDecoder * decoder,
   gst_h264_decoder_finish_current_picture (self);
   gst_video_codec_frame_unref (frame);
   priv->current_frame = NULL;
+  gst_codec_stats_frame_end (priv->stats);
 
   return priv->last_ret;
 }
@@ -757,7 +897,8 @@ gst_h264_decoder_handle_frame_num_gap (GstH264Decoder * self, gint frame_num)
   unused_short_term_frame_num =
       (priv->prev_ref_frame_num + 1) % priv->max_frame_num;
   while (unused_short_term_frame_num != frame_num) {
-    GstH264Picture *picture = gst_h264_picture_new ();
+    GstH264Picture *picture =
+        gst_h264_picture_new_from_pool (priv->picture_pool);
 
     if (!gst_h264_decoder_init_gap_picture (self, picture,
             unused_short_term_frame_num))
@@ -783,8 +924,8 @@ gst_h264_decoder_handle_frame_num_gap (GstH264Decoder * self, gint frame_num)
     } else {
       gst_h264_dpb_add (priv->dpb, picture);
     }
-    while (gst_h264_dpb_needs_bump (priv->dpb, priv->max_num_reorder_frames,
-            FALSE)) {
+    while (gst_h264_dpb_needs_bump (priv->dpb,
+            gst_h264_decoder_get_max_num_reorder_frames (self), FALSE)) {
       GstH264Picture *to_output;
 
       to_output = gst_h264_dpb_bump (priv->dpb, FALSE);
@@ -881,9 +1022,14 @@ gst_h264_decoder_start_current_picture (GstH264Decoder * self)
     gst_h264_decoder_prepare_ref_pic_lists (self, current_picture);
 
   klass = GST_H264_DECODER_GET_CLASS (self);
-  if (klass->start_picture)
+  if (klass->start_picture) {
+    GstClockTime begin = gst_codec_stats_stage_begin (priv->stats);
+
     ret = klass->start_picture (self, priv->current_picture,
         &priv->current_slice, priv->dpb);
+    gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_START_PICTURE,
+        begin);
+  }
 
   if (!ret) {
     GST_ERROR_OBJECT (self, "subclass does not want to start picture");
@@ -897,6 +1043,7 @@ static GstH264Picture *
 gst_h264_decoder_new_field_picture (GstH264Decoder * self,
     GstH264Picture * picture)
 {
+  GstH264DecoderPrivate *priv = self->priv;
   GstH264DecoderClass *klass = GST_H264_DECODER_GET_CLASS (self);
   GstH264Picture *new_picture;
 
@@ -905,14 +1052,22 @@ gst_h264_decoder_new_field_picture (GstH264Decoder * self,
     return NULL;
   }
 
-  new_picture = gst_h264_picture_new ();
+  new_picture = gst_h264_picture_new_from_pool (priv->picture_pool);
   /* don't confuse subclass by non-existing picture */
-  if (!picture->nonexisting &&
-      !klass->new_field_picture (self, picture, new_picture)) {
-    GST_ERROR_OBJECT (self, "Subclass couldn't handle new field picture");
-    gst_h264_picture_unref (new_picture);
+  if (!picture->nonexisting) {
+    GstClockTime begin = gst_codec_stats_stage_begin (priv->stats);
+    gboolean ret;
 
-    return NULL;
+    ret = klass->new_field_picture (self, picture, new_picture);
+    gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_NEW_PICTURE,
+        begin);
+
+    if (!ret) {
+      GST_ERROR_OBJECT (self, "Subclass couldn't handle new field picture");
+      gst_h264_picture_unref (new_picture);
+
+      return NULL;
+    }
   }
 
   new_picture->other_field = picture;
@@ -1050,10 +1205,15 @@ gst_h264_decoder_parse_slice (GstH264Decoder * self, GstH264NalUnit * nalu)
         return FALSE;
       }
     } else {
-      picture = gst_h264_picture_new ();
+      picture = gst_h264_picture_new_from_pool (priv->picture_pool);
+
+      if (klass->new_picture) {
+        GstClockTime begin = gst_codec_stats_stage_begin (priv->stats);
 
-      if (klass->new_picture)
         ret = klass->new_picture (self, priv->current_frame, picture);
+        gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_NEW_PICTURE,
+            begin);
+      }
 
       if (!ret) {
         GST_ERROR_OBJECT (self, "subclass does not want accept new picture");
@@ -1528,9 +1688,12 @@ gst_h264_decoder_drain_output_queue (GstH264Decoder * self, guint num)
   while (gst_queue_array_get_length (priv->output_queue) > num) {
     GstH264DecoderOutputFrame *output_frame = (GstH264DecoderOutputFrame *)
         gst_queue_array_pop_head_struct (priv->output_queue);
+    GstClockTime begin = gst_codec_stats_stage_begin (priv->stats);
+
     priv->last_ret =
         klass->output_picture (self, output_frame->frame,
         output_frame->picture);
+    gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_OUTPUT, begin);
   }
 }
 
@@ -1587,7 +1750,13 @@ gst_h264_decoder_finish_current_picture (GstH264Decoder * self)
   klass = GST_H264_DECODER_GET_CLASS (self);
 
   if (klass->end_picture) {
-    if (!klass->end_picture (self, priv->current_picture)) {
+    GstClockTime begin = gst_codec_stats_stage_begin (priv->stats);
+
+    ret = klass->end_picture (self, priv->current_picture);
+    gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_END_PICTURE,
+        begin);
+
+    if (!ret) {
       GST_WARNING_OBJECT (self,
           "end picture failed, marking picture %p non-existing "
           "(frame_num %d, poc %d)", priv->current_picture,
@@ -1861,7 +2030,11 @@ gst_h264_decoder_finish_picture (GstH264Decoder * self,
       picture, picture->frame_num, picture->pic_order_cnt,
       gst_h264_dpb_get_size (priv->dpb));
 
-  while (gst_h264_dpb_needs_bump (priv->dpb, priv->max_num_reorder_frames,
+  gst_h264_decoder_update_pictures_in_use (self);
+  gst_h264_decoder_check_reorder (self, picture);
+
+  while (gst_h264_dpb_needs_bump (priv->dpb,
+          gst_h264_decoder_get_max_num_reorder_frames (self),
           priv->is_live)) {
     GstH264Picture *to_output;
 
@@ -1878,12 +2051,99 @@ gst_h264_decoder_finish_picture (GstH264Decoder * self,
   return TRUE;
 }
 
+/* Whether the stream is known to be output in decoding order, used by
+ * low-latency mode when the VUI doesn't tell */
+static gboolean
+gst_h264_decoder_is_zero_reorder_stream (GstH264Decoder * self,
+    const GstH264SPS * sps)
+{
+  GstStructure *s;
+  const gchar *profile;
+
+  /* 8.2.1.3: output order is the same as decoding order */
+  if (sps->pic_order_cnt_type == 2)
+    return TRUE;
+
+  /* Real-time senders signal this in caps, there are no B slices */
+  if (!self->input_state || !self->input_state->caps)
+    return FALSE;
+
+  s = gst_caps_get_structure (self->input_state->caps, 0);
+  profile = gst_structure_get_string (s, "profile");
+
+  return g_strcmp0 (profile, "constrained-baseline") == 0;
+}
+
+static guint
+gst_h264_decoder_get_max_num_reorder_frames (GstH264Decoder * self)
+{
+  GstH264DecoderPrivate *priv = self->priv;
+
+  if (priv->reorder_inferred)
+    return 0;
+
+  return priv->max_num_reorder_frames;
+}
+
+/* Counts frames holding a buffer, that is, all DPB entries but second
+ * fields and non-existing frames, plus the frames waiting in the output
+ * queue, and records the peak */
+static void
+gst_h264_decoder_update_pictures_in_use (GstH264Decoder * self)
+{
+  GstH264DecoderPrivate *priv = self->priv;
+  GArray *dpb = gst_h264_dpb_get_pictures_all (priv->dpb);
+  guint num = gst_queue_array_get_length (priv->output_queue);
+  guint i;
+
+  for (i = 0; i < dpb->len; i++) {
+    GstH264Picture *picture = g_array_index (dpb, GstH264Picture *, i);
+
+    if (!picture->second_field && !picture->nonexisting)
+      num++;
+  }
+
+  g_array_unref (dpb);
+
+  if (num > priv->max_pictures_in_use) {
+    GST_DEBUG_OBJECT (self, "%u frames in use", num);
+    priv->max_pictures_in_use = num;
+  }
+}
+
+/* Leaves inferred zero reordering as soon as a frame is decoded with a lower
+ * POC than the previous one within the same POC period */
+static void
+gst_h264_decoder_check_reorder (GstH264Decoder * self, GstH264Picture * picture)
+{
+  GstH264DecoderPrivate *priv = self->priv;
+
+  if (!priv->reorder_inferred || picture->second_field)
+    return;
+
+  if (picture->idr || picture->mem_mgmt_5 ||
+      priv->last_decoded_poc == G_MININT32 ||
+      picture->pic_order_cnt >= priv->last_decoded_poc) {
+    priv->last_decoded_poc = picture->pic_order_cnt;
+    return;
+  }
+
+  GST_INFO_OBJECT (self, "Picture with poc %d decoded after poc %d, "
+      "stream reorders pictures, leaving low-latency output",
+      picture->pic_order_cnt, priv->last_decoded_poc);
+
+  priv->reorder_inferred = FALSE;
+  priv->reorder_seen = TRUE;
+}
+
 static gboolean
 gst_h264_decoder_update_max_num_reorder_frames (GstH264Decoder * self,
     GstH264SPS * sps)
 {
   GstH264DecoderPrivate *priv = self->priv;
 
+  priv->reorder_inferred = FALSE;
+
   if (sps->vui_parameters_present_flag
       && sps->vui_parameters.bitstream_restriction_flag) {
     priv->max_num_reorder_frames = sps->vui_parameters.num_reorder_frames;
@@ -1922,6 +2182,17 @@ gst_h264_decoder_update_max_num_reorder_frames (GstH264Decoder * self,
     priv->max_num_reorder_frames = gst_h264_dpb_get_max_num_frames (priv->dpb);
   }
 
+  if (priv->low_latency && priv->max_num_reorder_frames > 0) {
+    if (gst_h264_decoder_is_zero_reorder_stream (self, sps)) {
+      GST_DEBUG_OBJECT (self, "Stream does not reorder pictures");
+      priv->max_num_reorder_frames = 0;
+    } else if (!priv->reorder_seen) {
+      GST_DEBUG_OBJECT (self, "Assume zero reordering for low-latency");
+      priv->reorder_inferred = TRUE;
+      priv->last_decoded_poc = G_MININT32;
+    }
+  }
+
   return TRUE;
 }
 
@@ -2114,6 +2385,15 @@ gst_h264_decoder_process_sps (GstH264Decoder * self, GstH264SPS * sps)
     max_dpb_size = GST_H264_DPB_MAX_SIZE;
   }
 
+  /* Without reordering, pictures leave the DPB as soon as they are decoded
+   * and only reference frames need to be kept, plus the current picture */
+  if (priv->low_latency && !(sps->vui_parameters_present_flag &&
+          sps->vui_parameters.bitstream_restriction_flag) &&
+      gst_h264_decoder_is_zero_reorder_stream (self, sps)) {
+    max_dpb_size = MIN (max_dpb_size, MAX (sps->num_ref_frames, 1) + 1);
+    GST_DEBUG_OBJECT (self, "Low-latency DPB size %d", max_dpb_size);
+  }
+
   /* Safety, so that subclass don't need bound checking */
   g_return_val_if_fail (max_dpb_size <= GST_H264_DPB_MAX_SIZE, FALSE);
 
@@ -2149,6 +2429,7 @@ gst_h264_decoder_process_sps (GstH264Decoder * self, GstH264SPS * sps)
 
     priv->width = sps->width;
     priv->height = sps->height;
+    priv->max_pictures_in_use = 0;
 
     gst_h264_decoder_set_latency (self, sps, max_dpb_size);
     gst_h264_dpb_set_max_num_frames (priv->dpb, max_dpb_size);
@@ -2182,6 +2463,7 @@ gst_h264_decoder_decode_slice (GstH264Decoder * self)
   GstH264Picture *picture = priv->current_picture;
   GArray *ref_pic_list0 = NULL;
   GArray *ref_pic_list1 = NULL;
+  GstClockTime begin;
   gboolean ret = FALSE;
 
   if (!picture) {
@@ -2204,8 +2486,10 @@ gst_h264_decoder_decode_slice (GstH264Decoder * self)
 
   g_assert (klass->decode_slice);
 
+  begin = gst_codec_stats_stage_begin (priv->stats);
   ret = klass->decode_slice (self, picture, slice, ref_pic_list0,
       ref_pic_list1);
+  gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_DECODE, begin);
   if (!ret) {
     GST_WARNING_OBJECT (self,
         "Subclass didn't want to decode picture %p (frame_num %d, poc %d)",
@@ -2964,3 +3248,27 @@ gst_h264_decoder_get_picture (GstH264Decoder * decoder,
 {
   return gst_h264_dpb_get_picture (decoder->priv->dpb, system_frame_number);
 }
+
+/**
+ * gst_h264_decoder_get_max_pictures_in_use:
+ * @decoder: a #GstH264Decoder
+ *
+ * Retrieve the highest number of frames @decoder has held at once since
+ * the last #GstH264DecoderClass.new_sequence() call, counting reference
+ * frames, frames waiting for output and the frame being decoded.
+ * Unlike the DPB size given to #GstH264DecoderClass.new_sequence(), which
+ * covers the worst case allowed by the stream, this is what the stream
+ * actually needed so far. Subclasses can use it to size their output pool
+ * from a small start.
+ *
+ * Returns: the number of frames, or 0 if nothing was decoded yet
+ *
+ * Since: 1.20
+ */
+guint
+gst_h264_decoder_get_max_pictures_in_use (GstH264Decoder * decoder)
+{
+  g_return_val_if_fail (GST_IS_H264_DECODER (decoder), 0);
+
+  return decoder->priv->max_pictures_in_use;
+}
@@ -207,6 +207,9 @@ GST_CODECS_API
 GstH264Picture * gst_h264_decoder_get_picture   (GstH264Decoder * decoder,
                                                  guint32 system_frame_number);
 
+GST_CODECS_API
+guint gst_h264_decoder_get_max_pictures_in_use  (GstH264Decoder * decoder);
+
 G_END_DECLS
 
 #endif /* __GST_H264_DECODER_H__ */
@@ -22,6 +22,7 @@
 #endif
 
 #include "gsth264picture.h"
+#include "gstcodecpicturepool.h"
 #include <stdlib.h>
 
 GST_DEBUG_CATEGORY_EXTERN (gst_h264_decoder_debug);
@@ -30,14 +31,40 @@ GST_DEBUG_CATEGORY_EXTERN (gst_h264_decoder_debug);
 GST_DEFINE_MINI_OBJECT_TYPE (GstH264Picture, gst_h264_picture);
 
 static void
-_gst_h264_picture_free (GstH264Picture * picture)
+_gst_h264_picture_clear_internal (GstH264Picture * picture)
 {
   if (picture->notify)
     picture->notify (picture->user_data);
+}
+
+static void
+_gst_h264_picture_free (GstH264Picture * picture)
+{
+  _gst_h264_picture_clear_internal (picture);
 
   g_free (picture);
 }
 
+static void
+_gst_h264_picture_free_pooled (GstH264Picture * picture)
+{
+  _gst_h264_picture_clear_internal (picture);
+
+  gst_codec_picture_pool_release (picture);
+}
+
+static void
+_gst_h264_picture_init (GstH264Picture * pic,
+    GstMiniObjectFreeFunction free_func)
+{
+  pic->top_field_order_cnt = G_MAXINT32;
+  pic->bottom_field_order_cnt = G_MAXINT32;
+  pic->field = GST_H264_PICTURE_FIELD_FRAME;
+
+  gst_mini_object_init (GST_MINI_OBJECT_CAST (pic), 0,
+      GST_TYPE_H264_PICTURE, NULL, NULL, free_func);
+}
+
 /**
  * gst_h264_picture_new:
  *
@@ -51,14 +78,20 @@ gst_h264_picture_new (void)
   GstH264Picture *pic;
 
   pic = g_new0 (GstH264Picture, 1);
+  _gst_h264_picture_init (pic,
+      (GstMiniObjectFreeFunction) _gst_h264_picture_free);
 
-  pic->top_field_order_cnt = G_MAXINT32;
-  pic->bottom_field_order_cnt = G_MAXINT32;
-  pic->field = GST_H264_PICTURE_FIELD_FRAME;
+  return pic;
+}
 
-  gst_mini_object_init (GST_MINI_OBJECT_CAST (pic), 0,
-      GST_TYPE_H264_PICTURE, NULL, NULL,
-      (GstMiniObjectFreeFunction) _gst_h264_picture_free);
+GstH264Picture *
+gst_h264_picture_new_from_pool (GstCodecPicturePool * pool)
+{
+  GstH264Picture *pic;
+
+  pic = gst_codec_picture_pool_acquire (pool);
+  _gst_h264_picture_init (pic,
+      (GstMiniObjectFreeFunction) _gst_h264_picture_free_pooled);
 
   return pic;
 }
@@ -111,13 +144,33 @@ struct _GstH264Dpb
   gint32 last_output_poc;
 
   gboolean interlaced;
+
+  /* Lookup index, borrowing the pictures of pic_list. short_refs is sorted
+   * by ascending pic_num and long_refs by ascending long_term_pic_num, in
+   * pic_list order for equal keys. Both are rebuilt on demand after
+   * anything which can change the reference marking or picture numbers */
+  GArray *short_refs;
+  GArray *long_refs;
+  gboolean ref_index_valid;
+
+  /* cached result of gst_h264_dpb_get_lowest_output_needed_picture(),
+   * -2 if not computed yet */
+  gint lowest_output_index;
 };
 
+static inline void
+gst_h264_dpb_invalidate (GstH264Dpb * dpb)
+{
+  dpb->ref_index_valid = FALSE;
+  dpb->lowest_output_index = -2;
+}
+
 static void
 gst_h264_dpb_init (GstH264Dpb * dpb)
 {
   dpb->num_output_needed = 0;
   dpb->last_output_poc = G_MININT32;
+  gst_h264_dpb_invalidate (dpb);
 }
 
 /**
@@ -141,6 +194,11 @@ gst_h264_dpb_new (void)
   g_array_set_clear_func (dpb->pic_list,
       (GDestroyNotify) gst_h264_picture_clear);
 
+  dpb->short_refs = g_array_sized_new (FALSE, FALSE,
+      sizeof (GstH264Picture *), GST_H264_DPB_MAX_SIZE);
+  dpb->long_refs = g_array_sized_new (FALSE, FALSE,
+      sizeof (GstH264Picture *), GST_H264_DPB_MAX_SIZE);
+
   return dpb;
 }
 
@@ -221,6 +279,8 @@ gst_h264_dpb_free (GstH264Dpb * dpb)
 
   gst_h264_dpb_clear (dpb);
   g_array_unref (dpb->pic_list);
+  g_array_unref (dpb->short_refs);
+  g_array_unref (dpb->long_refs);
   g_free (dpb);
 }
 
@@ -277,6 +337,7 @@ gst_h264_dpb_add (GstH264Dpb * dpb, GstH264Picture * picture)
   }
 
   g_array_append_val (dpb->pic_list, picture);
+  gst_h264_dpb_invalidate (dpb);
 }
 
 /**
@@ -303,6 +364,7 @@ gst_h264_dpb_delete_unused (GstH264Dpb * dpb)
           ("remove picture %p (frame num: %d, poc: %d, field: %d) from dpb",
           picture, picture->frame_num, picture->pic_order_cnt, picture->field);
       g_array_remove_index (dpb->pic_list, i);
+      gst_h264_dpb_invalidate (dpb);
       i--;
     }
   }
@@ -358,6 +420,109 @@ gst_h264_dpb_mark_all_non_ref (GstH264Dpb * dpb)
 
     gst_h264_picture_set_reference (picture, GST_H264_PICTURE_REF_NONE, FALSE);
   }
+
+  gst_h264_dpb_invalidate (dpb);
+}
+
+static void
+gst_h264_dpb_insert_sorted (GArray * array, GstH264Picture * picture,
+    gboolean long_term)
+{
+  gint key = long_term ? picture->long_term_pic_num : picture->pic_num;
+  gint i;
+
+  /* insertion sort, the DPB holds a handful of pictures at most. Going
+   * backwards and stopping at the first key not greater keeps pictures
+   * with equal keys in pic_list order */
+  for (i = array->len; i > 0; i--) {
+    GstH264Picture *prev = g_array_index (array, GstH264Picture *, i - 1);
+    gint prev_key = long_term ? prev->long_term_pic_num : prev->pic_num;
+
+    if (prev_key <= key)
+      break;
+  }
+
+  g_array_insert_val (array, i, picture);
+}
+
+static void
+gst_h264_dpb_build_ref_index (GstH264Dpb * dpb)
+{
+  gint i;
+
+  g_array_set_size (dpb->short_refs, 0);
+  g_array_set_size (dpb->long_refs, 0);
+
+  for (i = 0; i < dpb->pic_list->len; i++) {
+    GstH264Picture *picture =
+        g_array_index (dpb->pic_list, GstH264Picture *, i);
+
+    if (GST_H264_PICTURE_IS_SHORT_TERM_REF (picture))
+      gst_h264_dpb_insert_sorted (dpb->short_refs, picture, FALSE);
+    else if (GST_H264_PICTURE_IS_LONG_TERM_REF (picture))
+      gst_h264_dpb_insert_sorted (dpb->long_refs, picture, TRUE);
+  }
+
+  dpb->ref_index_valid = TRUE;
+}
+
+/* binary search for the first picture with a matching key */
+static GstH264Picture *
+gst_h264_dpb_lookup_ref (GstH264Dpb * dpb, gint key, gboolean long_term)
+{
+  GArray *array;
+  GstH264Picture *picture;
+  guint lo, hi;
+
+  if (!dpb->ref_index_valid)
+    gst_h264_dpb_build_ref_index (dpb);
+
+  array = long_term ? dpb->long_refs : dpb->short_refs;
+  lo = 0;
+  hi = array->len;
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+    GstH264Picture *tmp = g_array_index (array, GstH264Picture *, mid);
+
+    if ((long_term ? tmp->long_term_pic_num : tmp->pic_num) < key)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  if (lo >= array->len)
+    return NULL;
+
+  picture = g_array_index (array, GstH264Picture *, lo);
+  if (long_term) {
+    if (!GST_H264_PICTURE_IS_LONG_TERM_REF (picture) ||
+        picture->long_term_pic_num != key)
+      return NULL;
+  } else if (!GST_H264_PICTURE_IS_SHORT_TERM_REF (picture) ||
+      picture->pic_num != key) {
+    return NULL;
+  }
+
+  return picture;
+}
+
+static GstH264Picture *
+gst_h264_dpb_find_ref (GstH264Dpb * dpb, gint key, gboolean long_term)
+{
+  GstH264Picture *picture;
+  gboolean was_valid = dpb->ref_index_valid;
+
+  picture = gst_h264_dpb_lookup_ref (dpb, key, long_term);
+
+  /* The marking of a picture can be changed with
+   * gst_h264_picture_set_reference(), which the DPB doesn't know about.
+   * Retry with a fresh index to never miss a picture because of that */
+  if (!picture && was_valid) {
+    dpb->ref_index_valid = FALSE;
+    picture = gst_h264_dpb_lookup_ref (dpb, key, long_term);
+  }
+
+  return picture;
 }
 
 /**
@@ -372,18 +537,13 @@ gst_h264_dpb_mark_all_non_ref (GstH264Dpb * dpb)
 GstH264Picture *
 gst_h264_dpb_get_short_ref_by_pic_num (GstH264Dpb * dpb, gint pic_num)
 {
-  gint i;
+  GstH264Picture *picture;
 
   g_return_val_if_fail (dpb != NULL, NULL);
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
-    GstH264Picture *picture =
-        g_array_index (dpb->pic_list, GstH264Picture *, i);
-
-    if (GST_H264_PICTURE_IS_SHORT_TERM_REF (picture)
-        && picture->pic_num == pic_num)
-      return picture;
-  }
+  picture = gst_h264_dpb_find_ref (dpb, pic_num, FALSE);
+  if (picture)
+    return picture;
 
   GST_WARNING ("No short term reference picture for %d", pic_num);
 
@@ -405,18 +565,13 @@ GstH264Picture *
 gst_h264_dpb_get_long_ref_by_long_term_pic_num (GstH264Dpb * dpb,
     gint long_term_pic_num)
 {
-  gint i;
+  GstH264Picture *picture;
 
   g_return_val_if_fail (dpb != NULL, NULL);
 
-  for (i = 0; i < dpb->pic_list->len; i++) {
-    GstH264Picture *picture =
-        g_array_index (dpb->pic_list, GstH264Picture *, i);
-
-    if (GST_H264_PICTURE_IS_LONG_TERM_REF (picture) &&
-        picture->long_term_pic_num == long_term_pic_num)
-      return picture;
-  }
+  picture = gst_h264_dpb_find_ref (dpb, long_term_pic_num, TRUE);
+  if (picture)
+    return picture;
 
   GST_WARNING ("No long term reference picture for %d", long_term_pic_num);
 
@@ -539,6 +694,9 @@ gst_h264_dpb_get_pictures_all (GstH264Dpb * dpb)
 {
   g_return_val_if_fail (dpb != NULL, NULL);
 
+  /* the caller may update picture numbers or marking through the array */
+  gst_h264_dpb_invalidate (dpb);
+
   return g_array_ref (dpb->pic_list);
 }
 
@@ -625,6 +783,14 @@ gst_h264_dpb_get_lowest_output_needed_picture (GstH264Dpb * dpb,
 
   *picture = NULL;
 
+  if (dpb->lowest_output_index >= -1) {
+    index = dpb->lowest_output_index;
+    if (index >= 0)
+      *picture = gst_h264_picture_ref (g_array_index (dpb->pic_list,
+              GstH264Picture *, index));
+    return index;
+  }
+
   for (i = 0; i < dpb->pic_list->len; i++) {
     GstH264Picture *picture =
         g_array_index (dpb->pic_list, GstH264Picture *, i);
@@ -651,6 +817,8 @@ gst_h264_dpb_get_lowest_output_needed_picture (GstH264Dpb * dpb,
   if (lowest)
     *picture = gst_h264_picture_ref (lowest);
 
+  dpb->lowest_output_index = index;
+
   return index;
 }
 
@@ -769,6 +937,7 @@ gst_h264_dpb_bump (GstH264Dpb * dpb, gboolean drain)
     return NULL;
 
   picture->needed_for_output = FALSE;
+  gst_h264_dpb_invalidate (dpb);
 
   dpb->num_output_needed--;
   g_assert (dpb->num_output_needed >= 0);
@@ -1026,6 +1195,8 @@ gst_h264_dpb_perform_memory_management_control_operation (GstH264Dpb * dpb,
       return FALSE;
   }
 
+  gst_h264_dpb_invalidate (dpb);
+
   return TRUE;
 }
 
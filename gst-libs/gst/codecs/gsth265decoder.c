@@ -30,11 +30,23 @@
 #include <config.h>
 #endif
 
+#include <gst/base/base.h>
 #include "gsth265decoder.h"
+#include "gstcodecpicturepool.h"
+#include "gstcodecstats.h"
 
 GST_DEBUG_CATEGORY (gst_h265_decoder_debug);
 #define GST_CAT_DEFAULT gst_h265_decoder_debug
 
+#define DEFAULT_LOW_LATENCY FALSE
+
+enum
+{
+  PROP_0,
+  PROP_LOW_LATENCY,
+  PROP_STATS,
+};
+
 typedef enum
 {
   GST_H265_DECODER_FORMAT_NONE,
@@ -64,6 +76,15 @@ struct _GstH265DecoderPrivate
   GstH265Parser *parser;
   GstH265Dpb *dpb;
   GstFlowReturn last_ret;
+  /* used for low-latency vs. high throughput mode decision */
+  gboolean is_live;
+
+  /* properties */
+  gboolean low_latency;
+
+  /* set once a picture shows up out of order in low-latency mode */
+  gboolean reorder_seen;
+  gint last_decoded_poc;
 
   /* 0: frame or field-pair interlaced stream
    * 1: alternating, single field interlaced stream.
@@ -118,8 +139,30 @@ struct _GstH265DecoderPrivate
   GArray *ref_pic_list_tmp;
   GArray *ref_pic_list0;
   GArray *ref_pic_list1;
+
+  /* For delayed output */
+  guint preferred_output_delay;
+  GstQueueArray *output_queue;
+
+  /* recycled picture objects */
+  GstCodecPicturePool *picture_pool;
+
+  /* time spent per stage */
+  GstCodecStats *stats;
+
+  /* highest number of pictures held at once since the last new_sequence() */
+  guint max_pictures_in_use;
 };
 
+typedef struct
+{
+  /* Holds ref */
+  GstVideoCodecFrame *frame;
+  GstH265Picture *picture;
+  /* Without ref */
+  GstH265Decoder *self;
+} GstH265DecoderOutputFrame;
+
 #define parent_class gst_h265_decoder_parent_class
 G_DEFINE_ABSTRACT_TYPE_WITH_CODE (GstH265Decoder, gst_h265_decoder,
     GST_TYPE_VIDEO_DECODER,
@@ -128,6 +171,10 @@ G_DEFINE_ABSTRACT_TYPE_WITH_CODE (GstH265Decoder, gst_h265_decoder,
         "H.265 Video Decoder"));
 
 static void gst_h265_decoder_finalize (GObject * object);
+static void gst_h265_decoder_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_h265_decoder_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 
 static gboolean gst_h265_decoder_start (GstVideoDecoder * decoder);
 static gboolean gst_h265_decoder_stop (GstVideoDecoder * decoder);
@@ -144,6 +191,8 @@ static void gst_h265_decoder_clear_ref_pic_sets (GstH265Decoder * self);
 static void gst_h265_decoder_clear_dpb (GstH265Decoder * self, gboolean flush);
 static gboolean gst_h265_decoder_drain_internal (GstH265Decoder * self);
 static gboolean gst_h265_decoder_start_current_picture (GstH265Decoder * self);
+static void
+gst_h265_decoder_clear_output_frame (GstH265DecoderOutputFrame * output_frame);
 
 static void
 gst_h265_decoder_class_init (GstH265DecoderClass * klass)
@@ -152,6 +201,42 @@ gst_h265_decoder_class_init (GstH265DecoderClass * klass)
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
   object_class->finalize = GST_DEBUG_FUNCPTR (gst_h265_decoder_finalize);
+  object_class->set_property = gst_h265_decoder_set_property;
+  object_class->get_property = gst_h265_decoder_get_property;
+
+  /**
+   * GstH265Decoder:low-latency:
+   *
+   * Output pictures as soon as they are decoded, ignoring the reordering
+   * depth signalled by the SPS until a picture is decoded out of order.
+   * Meant for streams known to be encoded without reordering, such as
+   * conferencing or screen sharing, whose encoder signals a conservative
+   * sps_max_num_reorder_pics. The DPB size reported to subclass is also
+   * limited to sps_max_dec_pic_buffering.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (object_class, PROP_LOW_LATENCY,
+      g_param_spec_boolean ("low-latency", "Low Latency",
+          "Output pictures without waiting for reordering until the stream "
+          "is observed to reorder pictures",
+          DEFAULT_LOW_LATENCY, G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstH265Decoder:stats:
+   *
+   * Time spent by the decoder since it was started, split between the
+   * baseclass ("parse") and the subclass methods ("new-picture",
+   * "start-picture", "decode" for decode_slice(), "end-picture" and
+   * "output"). See #GstH264Decoder:stats for the structure layout.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (object_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Time spent parsing, in each subclass method and outputting",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
   decoder_class->start = GST_DEBUG_FUNCPTR (gst_h265_decoder_start);
   decoder_class->stop = GST_DEBUG_FUNCPTR (gst_h265_decoder_stop);
@@ -172,12 +257,23 @@ gst_h265_decoder_init (GstH265Decoder * self)
 
   self->priv = priv = gst_h265_decoder_get_instance_private (self);
 
+  priv->low_latency = DEFAULT_LOW_LATENCY;
+
   priv->ref_pic_list_tmp = g_array_sized_new (FALSE, TRUE,
       sizeof (GstH265Picture *), 32);
   priv->ref_pic_list0 = g_array_sized_new (FALSE, TRUE,
       sizeof (GstH265Picture *), 32);
   priv->ref_pic_list1 = g_array_sized_new (FALSE, TRUE,
       sizeof (GstH265Picture *), 32);
+
+  priv->output_queue =
+      gst_queue_array_new_for_struct (sizeof (GstH265DecoderOutputFrame), 1);
+  gst_queue_array_set_clear_func (priv->output_queue,
+      (GDestroyNotify) gst_h265_decoder_clear_output_frame);
+
+  priv->picture_pool =
+      gst_codec_picture_pool_new (sizeof (GstH265Picture));
+  priv->stats = gst_codec_stats_new (GST_OBJECT (self));
 }
 
 static void
@@ -189,10 +285,65 @@ gst_h265_decoder_finalize (GObject * object)
   g_array_unref (priv->ref_pic_list_tmp);
   g_array_unref (priv->ref_pic_list0);
   g_array_unref (priv->ref_pic_list1);
+  gst_queue_array_free (priv->output_queue);
+  gst_codec_picture_pool_unref (priv->picture_pool);
+  gst_codec_stats_free (priv->stats);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gst_h265_decoder_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstH265Decoder *self = GST_H265_DECODER (object);
+  GstH265DecoderPrivate *priv = self->priv;
+
+  switch (prop_id) {
+    case PROP_LOW_LATENCY:
+      priv->low_latency = g_value_get_boolean (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_h265_decoder_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstH265Decoder *self = GST_H265_DECODER (object);
+  GstH265DecoderPrivate *priv = self->priv;
+
+  switch (prop_id) {
+    case PROP_LOW_LATENCY:
+      g_value_set_boolean (value, priv->low_latency);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_codec_stats_get_structure (priv->stats));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_h265_decoder_clear_output_frame (GstH265DecoderOutputFrame * output_frame)
+{
+  if (!output_frame)
+    return;
+
+  if (output_frame->frame) {
+    gst_video_decoder_release_frame (GST_VIDEO_DECODER (output_frame->self),
+        output_frame->frame);
+    output_frame->frame = NULL;
+  }
+
+  gst_h265_picture_clear (&output_frame->picture);
+}
+
 static gboolean
 gst_h265_decoder_start (GstVideoDecoder * decoder)
 {
@@ -203,6 +354,10 @@ gst_h265_decoder_start (GstVideoDecoder * decoder)
   priv->dpb = gst_h265_dpb_new ();
   priv->new_bitstream = TRUE;
   priv->prev_nal_is_eos = FALSE;
+  priv->reorder_seen = FALSE;
+  priv->last_decoded_poc = G_MININT32;
+
+  gst_codec_stats_reset (priv->stats);
 
   return TRUE;
 }
@@ -254,6 +409,86 @@ gst_h265_decoder_parse_vps (GstH265Decoder * self, GstH265NalUnit * nalu)
   return ret;
 }
 
+static void
+gst_h265_decoder_drain_output_queue (GstH265Decoder * self, guint num)
+{
+  GstH265DecoderPrivate *priv = self->priv;
+  GstH265DecoderClass *klass = GST_H265_DECODER_GET_CLASS (self);
+
+  g_assert (klass->output_picture);
+
+  while (gst_queue_array_get_length (priv->output_queue) > num) {
+    GstH265DecoderOutputFrame *output_frame = (GstH265DecoderOutputFrame *)
+        gst_queue_array_pop_head_struct (priv->output_queue);
+    GstClockTime begin = gst_codec_stats_stage_begin (priv->stats);
+
+    priv->last_ret =
+        klass->output_picture (self, output_frame->frame,
+        output_frame->picture);
+    gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_OUTPUT, begin);
+  }
+}
+
+static guint
+gst_h265_decoder_get_max_num_reorder_pics (GstH265Decoder * self,
+    const GstH265SPS * sps)
+{
+  GstH265DecoderPrivate *priv = self->priv;
+
+  if (priv->low_latency && !priv->reorder_seen)
+    return 0;
+
+  return sps->max_num_reorder_pics[sps->max_sub_layers_minus1];
+}
+
+static void
+gst_h265_decoder_set_latency (GstH265Decoder * self, const GstH265SPS * sps,
+    gint max_dpb_size)
+{
+  GstH265DecoderPrivate *priv = self->priv;
+  GstCaps *caps;
+  GstClockTime min, max;
+  GstStructure *structure;
+  gint fps_d = 1, fps_n = 0;
+  guint32 num_reorder_pics;
+
+  caps = gst_pad_get_current_caps (GST_VIDEO_DECODER_SRC_PAD (self));
+  if (!caps)
+    return;
+
+  structure = gst_caps_get_structure (caps, 0);
+  if (gst_structure_get_fraction (structure, "framerate", &fps_n, &fps_d)) {
+    if (fps_n == 0) {
+      /* variable framerate: see if we have a max-framerate */
+      gst_structure_get_fraction (structure, "max-framerate", &fps_n, &fps_d);
+    }
+  }
+  gst_caps_unref (caps);
+
+  /* if no fps or variable, then 25/1 */
+  if (fps_n == 0) {
+    fps_n = 25;
+    fps_d = 1;
+  }
+
+  num_reorder_pics = gst_h265_decoder_get_max_num_reorder_pics (self, sps);
+  if (num_reorder_pics > max_dpb_size)
+    num_reorder_pics = priv->is_live ? 0 : 1;
+
+  /* Consider output delay wanted by subclass */
+  num_reorder_pics += priv->preferred_output_delay;
+
+  min = gst_util_uint64_scale_int (num_reorder_pics * GST_SECOND, fps_d,
+      fps_n);
+  max = gst_util_uint64_scale_int ((max_dpb_size + priv->preferred_output_delay)
+      * GST_SECOND, fps_d, fps_n);
+
+  GST_LOG_OBJECT (self,
+      "latency min %" G_GUINT64_FORMAT " max %" G_GUINT64_FORMAT, min, max);
+
+  gst_video_decoder_set_latency (GST_VIDEO_DECODER (self), min, max);
+}
+
 static gboolean
 gst_h265_decoder_process_sps (GstH265Decoder * self, GstH265SPS * sps)
 {
@@ -281,6 +516,13 @@ gst_h265_decoder_process_sps (GstH265Decoder * self, GstH265SPS * sps)
 
   max_dpb_size = MIN (max_dpb_size, 16);
 
+  /* Pictures don't wait for reordering, so what the stream signals as
+   * required is enough */
+  if (priv->low_latency) {
+    max_dpb_size = MIN (max_dpb_size,
+        sps->max_dec_pic_buffering_minus1[sps->max_sub_layers_minus1] + 1);
+  }
+
   if (sps->vui_parameters_present_flag)
     field_seq_flag = sps->vui_params.field_seq_flag;
 
@@ -306,7 +548,18 @@ gst_h265_decoder_process_sps (GstH265Decoder * self, GstH265SPS * sps)
 
     g_assert (klass->new_sequence);
 
-    if (!klass->new_sequence (self, sps, max_dpb_size)) {
+    /* Pictures held for delayed output belong to the previous sequence */
+    gst_h265_decoder_drain_output_queue (self, 0);
+
+    if (klass->get_preferred_output_delay) {
+      priv->preferred_output_delay =
+          klass->get_preferred_output_delay (self, priv->is_live);
+    } else {
+      priv->preferred_output_delay = 0;
+    }
+
+    if (!klass->new_sequence (self, sps,
+            max_dpb_size + priv->preferred_output_delay)) {
       GST_ERROR_OBJECT (self, "subclass does not want accept new sequence");
       return FALSE;
     }
@@ -316,8 +569,10 @@ gst_h265_decoder_process_sps (GstH265Decoder * self, GstH265SPS * sps)
     priv->field_seq_flag = field_seq_flag;
     priv->progressive_source_flag = progressive_source_flag;
     priv->interlaced_source_flag = interlaced_source_flag;
+    priv->max_pictures_in_use = 0;
 
     gst_h265_dpb_set_max_num_pics (priv->dpb, max_dpb_size);
+    gst_h265_decoder_set_latency (self, sps, max_dpb_size);
   }
 
   if (sps->max_latency_increase_plus1[sps->max_sub_layers_minus1]) {
@@ -548,6 +803,7 @@ gst_h265_decoder_decode_slice (GstH265Decoder * self)
   GstH265Picture *picture = priv->current_picture;
   GArray *l0 = NULL;
   GArray *l1 = NULL;
+  GstClockTime begin;
   gboolean ret;
 
   if (!picture) {
@@ -563,7 +819,9 @@ gst_h265_decoder_decode_slice (GstH265Decoder * self)
     gst_h265_decoder_process_ref_pic_lists (self, picture, slice, &l0, &l1);
   }
 
+  begin = gst_codec_stats_stage_begin (priv->stats);
   ret = klass->decode_slice (self, picture, slice, l0, l1);
+  gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_DECODE, begin);
 
   if (priv->process_ref_pic_lists) {
     g_array_set_size (l0, 0);
@@ -633,7 +891,7 @@ gst_h265_decoder_parse_slice (GstH265Decoder * self, GstH265NalUnit * nalu,
     GstH265Picture *picture;
     gboolean ret = TRUE;
 
-    picture = gst_h265_picture_new ();
+    picture = gst_h265_picture_new_from_pool (priv->picture_pool);
     picture->pts = pts;
     /* This allows accessing the frame from the picture. */
     picture->system_frame_number = priv->current_frame->system_frame_number;
@@ -641,8 +899,13 @@ gst_h265_decoder_parse_slice (GstH265Decoder * self, GstH265NalUnit * nalu,
     priv->current_picture = picture;
     g_assert (priv->current_frame);
 
-    if (klass->new_picture)
+    if (klass->new_picture) {
+      GstClockTime begin = gst_codec_stats_stage_begin (priv->stats);
+
       ret = klass->new_picture (self, priv->current_frame, picture);
+      gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_NEW_PICTURE,
+          begin);
+    }
 
     if (!ret) {
       GST_ERROR_OBJECT (self, "subclass does not want accept new picture");
@@ -845,6 +1108,7 @@ gst_h265_decoder_set_format (GstVideoDecoder * decoder,
 {
   GstH265Decoder *self = GST_H265_DECODER (decoder);
   GstH265DecoderPrivate *priv = self->priv;
+  GstQuery *query;
 
   GST_DEBUG_OBJECT (decoder, "Set format");
 
@@ -909,6 +1173,16 @@ gst_h265_decoder_set_format (GstVideoDecoder * decoder,
     priv->align = align;
   }
 
+  /* in case live streaming, we will run on low-latency mode */
+  priv->is_live = FALSE;
+  query = gst_query_new_latency ();
+  if (gst_pad_peer_query (GST_VIDEO_DECODER_SINK_PAD (self), query))
+    gst_query_parse_latency (query, &priv->is_live, NULL, NULL);
+  gst_query_unref (query);
+
+  if (priv->is_live)
+    GST_DEBUG_OBJECT (self, "Live source, will run on low-latency mode");
+
   if (priv->codec_data) {
     GstMapInfo map;
 
@@ -1422,8 +1696,8 @@ gst_h265_decoder_do_output_picture (GstH265Decoder * self,
     GstH265Picture * picture)
 {
   GstH265DecoderPrivate *priv = self->priv;
-  GstH265DecoderClass *klass;
   GstVideoCodecFrame *frame = NULL;
+  GstH265DecoderOutputFrame output_frame;
 
   GST_LOG_OBJECT (self, "Output picture %p (poc %d)", picture,
       picture->pic_order_cnt);
@@ -1449,10 +1723,12 @@ gst_h265_decoder_do_output_picture (GstH265Decoder * self,
     return;
   }
 
-  klass = GST_H265_DECODER_GET_CLASS (self);
+  output_frame.frame = frame;
+  output_frame.picture = picture;
+  output_frame.self = self;
+  gst_queue_array_push_tail_struct (priv->output_queue, &output_frame);
 
-  g_assert (klass->output_picture);
-  priv->last_ret = klass->output_picture (self, frame, picture);
+  gst_h265_decoder_drain_output_queue (self, priv->preferred_output_delay);
 }
 
 static void
@@ -1475,6 +1751,7 @@ gst_h265_decoder_clear_dpb (GstH265Decoder * self, gboolean flush)
     }
   }
 
+  gst_queue_array_clear (priv->output_queue);
   gst_h265_dpb_clear (priv->dpb);
   priv->last_output_poc = 0;
 }
@@ -1488,6 +1765,8 @@ gst_h265_decoder_drain_internal (GstH265Decoder * self)
   while ((picture = gst_h265_dpb_bump (priv->dpb, TRUE)) != NULL)
     gst_h265_decoder_do_output_picture (self, picture);
 
+  gst_h265_decoder_drain_output_queue (self, 0);
+
   gst_h265_dpb_clear (priv->dpb);
   priv->last_output_poc = 0;
 
@@ -1525,7 +1804,7 @@ gst_h265_decoder_dpb_init (GstH265Decoder * self, const GstH265Slice * slice,
   } else {
     gst_h265_dpb_delete_unused (priv->dpb);
     while (gst_h265_dpb_needs_bump (priv->dpb,
-            sps->max_num_reorder_pics[sps->max_sub_layers_minus1],
+            gst_h265_decoder_get_max_num_reorder_pics (self, sps),
             priv->SpsMaxLatencyPictures,
             sps->max_dec_pic_buffering_minus1[sps->max_sub_layers_minus1] +
             1)) {
@@ -1544,6 +1823,44 @@ gst_h265_decoder_dpb_init (GstH265Decoder * self, const GstH265Slice * slice,
   return TRUE;
 }
 
+/* Records the peak of pictures in the DPB plus the ones waiting in the
+ * output queue */
+static void
+gst_h265_decoder_update_pictures_in_use (GstH265Decoder * self)
+{
+  GstH265DecoderPrivate *priv = self->priv;
+  guint num;
+
+  num = gst_h265_dpb_get_size (priv->dpb) +
+      gst_queue_array_get_length (priv->output_queue);
+
+  if (num > priv->max_pictures_in_use) {
+    GST_DEBUG_OBJECT (self, "%u pictures in use", num);
+    priv->max_pictures_in_use = num;
+  }
+}
+
+/* Leaves low-latency output as soon as a picture is decoded with a lower
+ * POC than the previous one since the last IRAP */
+static void
+gst_h265_decoder_check_reorder (GstH265Decoder * self, GstH265Picture * picture)
+{
+  GstH265DecoderPrivate *priv = self->priv;
+
+  if ((picture->RapPicFlag && picture->NoRaslOutputFlag) ||
+      priv->last_decoded_poc == G_MININT32 ||
+      picture->pic_order_cnt >= priv->last_decoded_poc) {
+    priv->last_decoded_poc = picture->pic_order_cnt;
+    return;
+  }
+
+  GST_INFO_OBJECT (self, "Picture with poc %d decoded after poc %d, "
+      "stream reorders pictures, leaving low-latency output",
+      picture->pic_order_cnt, priv->last_decoded_poc);
+
+  priv->reorder_seen = TRUE;
+}
+
 static gboolean
 gst_h265_decoder_start_current_picture (GstH265Decoder * self)
 {
@@ -1573,9 +1890,14 @@ gst_h265_decoder_start_current_picture (GstH265Decoder * self)
   gst_h265_decoder_dpb_init (self, &priv->current_slice, priv->current_picture);
 
   klass = GST_H265_DECODER_GET_CLASS (self);
-  if (klass->start_picture)
+  if (klass->start_picture) {
+    GstClockTime begin = gst_codec_stats_stage_begin (priv->stats);
+
     ret = klass->start_picture (self, priv->current_picture,
         &priv->current_slice, priv->dpb);
+    gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_START_PICTURE,
+        begin);
+  }
 
   if (!ret) {
     GST_ERROR_OBJECT (self, "subclass does not want to start picture");
@@ -1607,15 +1929,19 @@ gst_h265_decoder_finish_picture (GstH265Decoder * self,
     gst_video_decoder_release_frame (decoder, frame);
   }
 
+  if (priv->low_latency && !priv->reorder_seen && picture->output_flag)
+    gst_h265_decoder_check_reorder (self, picture);
+
   /* gst_h265_dpb_add() will take care of pic_latency_cnt increment and
    * reference picture marking for this picture */
   gst_h265_dpb_add (priv->dpb, picture);
+  gst_h265_decoder_update_pictures_in_use (self);
 
   /* NOTE: As per C.5.2.2, bumping by sps_max_dec_pic_buffering_minus1 is
    * applied only for the output and removal of pictures from the DPB before
    * the decoding of the current picture. So pass zero here */
   while (gst_h265_dpb_needs_bump (priv->dpb,
-          sps->max_num_reorder_pics[sps->max_sub_layers_minus1],
+          gst_h265_decoder_get_max_num_reorder_pics (self, sps),
           priv->SpsMaxLatencyPictures, 0)) {
     GstH265Picture *to_output = gst_h265_dpb_bump (priv->dpb, FALSE);
 
@@ -1650,8 +1976,13 @@ gst_h265_decoder_finish_current_picture (GstH265Decoder * self)
 
   klass = GST_H265_DECODER_GET_CLASS (self);
 
-  if (klass->end_picture)
+  if (klass->end_picture) {
+    GstClockTime begin = gst_codec_stats_stage_begin (priv->stats);
+
     ret = klass->end_picture (self, priv->current_picture);
+    gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_END_PICTURE,
+        begin);
+  }
 
   /* finish picture takes ownership of the picture */
   ret = gst_h265_decoder_finish_picture (self, priv->current_picture);
@@ -1704,6 +2035,8 @@ gst_h265_decoder_handle_frame (GstVideoDecoder * decoder,
     return GST_FLOW_ERROR;
   }
 
+  gst_codec_stats_frame_begin (priv->stats);
+
   if (priv->in_format == GST_H265_DECODER_FORMAT_HVC1 ||
       priv->in_format == GST_H265_DECODER_FORMAT_HEV1) {
     pres = gst_h265_parser_identify_nalu_hevc (priv->parser,
@@ -1745,12 +2078,14 @@ gst_h265_decoder_handle_frame (GstVideoDecoder * decoder,
     gst_video_decoder_drop_frame (decoder, frame);
 
     gst_h265_picture_clear (&priv->current_picture);
+    gst_codec_stats_frame_end (priv->stats);
 
     return priv->last_ret;
   }
 
   gst_h265_decoder_finish_current_picture (self);
   gst_video_codec_frame_unref (frame);
+  gst_codec_stats_frame_end (priv->stats);
 
   return priv->last_ret;
 }
@@ -1789,3 +2124,27 @@ gst_h265_decoder_get_picture (GstH265Decoder * decoder,
 {
   return gst_h265_dpb_get_picture (decoder->priv->dpb, system_frame_number);
 }
+
+/**
+ * gst_h265_decoder_get_max_pictures_in_use:
+ * @decoder: a #GstH265Decoder
+ *
+ * Retrieve the highest number of pictures @decoder has held at once since
+ * the last #GstH265DecoderClass.new_sequence() call, counting reference
+ * pictures, pictures waiting for output and the picture being decoded.
+ * Unlike the DPB size given to #GstH265DecoderClass.new_sequence(), which
+ * covers the worst case allowed by the stream, this is what the stream
+ * actually needed so far. Subclasses can use it to size their output pool
+ * from a small start.
+ *
+ * Returns: the number of pictures, or 0 if nothing was decoded yet
+ *
+ * Since: 1.20
+ */
+guint
+gst_h265_decoder_get_max_pictures_in_use (GstH265Decoder * decoder)
+{
+  g_return_val_if_fail (GST_IS_H265_DECODER (decoder), 0);
+
+  return decoder->priv->max_pictures_in_use;
+}
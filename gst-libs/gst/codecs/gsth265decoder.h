@@ -130,6 +130,22 @@ struct _GstH265DecoderClass
                                      GstVideoCodecFrame * frame,
                                      GstH265Picture * picture);
 
+  /**
+   * GstH265DecoderClass::get_preferred_output_delay:
+   * @decoder: a #GstH265Decoder
+   * @live: whether upstream is live or not
+   *
+   * Optional. Called by baseclass to query whether delaying output is
+   * preferred by subclass or not. The max_dpb_size passed to new_sequence
+   * includes this delay.
+   *
+   * Returns: the number of perferred delayed output frame
+   *
+   * Since: 1.20
+   */
+  guint (*get_preferred_output_delay)   (GstH265Decoder * decoder,
+                                         gboolean live);
+
   /*< private >*/
   gpointer padding[GST_PADDING_LARGE];
 };
@@ -147,6 +163,9 @@ GST_CODECS_API
 GstH265Picture * gst_h265_decoder_get_picture   (GstH265Decoder * decoder,
                                                  guint32 system_frame_number);
 
+GST_CODECS_API
+guint gst_h265_decoder_get_max_pictures_in_use  (GstH265Decoder * decoder);
+
 G_END_DECLS
 
 #endif /* __GST_H265_DECODER_H__ */
@@ -22,6 +22,7 @@
 #endif
 
 #include "gsth265picture.h"
+#include "gstcodecpicturepool.h"
 
 GST_DEBUG_CATEGORY_EXTERN (gst_h265_decoder_debug);
 #define GST_CAT_DEFAULT gst_h265_decoder_debug
@@ -29,14 +30,43 @@ GST_DEBUG_CATEGORY_EXTERN (gst_h265_decoder_debug);
 GST_DEFINE_MINI_OBJECT_TYPE (GstH265Picture, gst_h265_picture);
 
 static void
-_gst_h265_picture_free (GstH265Picture * picture)
+_gst_h265_picture_clear_internal (GstH265Picture * picture)
 {
   if (picture->notify)
     picture->notify (picture->user_data);
+}
+
+static void
+_gst_h265_picture_free (GstH265Picture * picture)
+{
+  _gst_h265_picture_clear_internal (picture);
 
   g_free (picture);
 }
 
+static void
+_gst_h265_picture_free_pooled (GstH265Picture * picture)
+{
+  _gst_h265_picture_clear_internal (picture);
+
+  gst_codec_picture_pool_release (picture);
+}
+
+static void
+_gst_h265_picture_init (GstH265Picture * pic,
+    GstMiniObjectFreeFunction free_func)
+{
+  pic->pts = GST_CLOCK_TIME_NONE;
+  pic->pic_struct = GST_H265_SEI_PIC_STRUCT_FRAME;
+  /* 0: interlaced, 1: progressive, 2: unspecified, 3: reserved, can be
+   * interpreted as 2 */
+  pic->source_scan_type = 2;
+  pic->duplicate_flag = 0;
+
+  gst_mini_object_init (GST_MINI_OBJECT_CAST (pic), 0,
+      GST_TYPE_H265_PICTURE, NULL, NULL, free_func);
+}
+
 /**
  * gst_h265_picture_new:
  *
@@ -50,17 +80,20 @@ gst_h265_picture_new (void)
   GstH265Picture *pic;
 
   pic = g_new0 (GstH265Picture, 1);
+  _gst_h265_picture_init (pic,
+      (GstMiniObjectFreeFunction) _gst_h265_picture_free);
 
-  pic->pts = GST_CLOCK_TIME_NONE;
-  pic->pic_struct = GST_H265_SEI_PIC_STRUCT_FRAME;
-  /* 0: interlaced, 1: progressive, 2: unspecified, 3: reserved, can be
-   * interpreted as 2 */
-  pic->source_scan_type = 2;
-  pic->duplicate_flag = 0;
+  return pic;
+}
 
-  gst_mini_object_init (GST_MINI_OBJECT_CAST (pic), 0,
-      GST_TYPE_H265_PICTURE, NULL, NULL,
-      (GstMiniObjectFreeFunction) _gst_h265_picture_free);
+GstH265Picture *
+gst_h265_picture_new_from_pool (GstCodecPicturePool * pool)
+{
+  GstH265Picture *pic;
+
+  pic = gst_codec_picture_pool_acquire (pool);
+  _gst_h265_picture_init (pic,
+      (GstMiniObjectFreeFunction) _gst_h265_picture_free_pooled);
 
   return pic;
 }
@@ -30,10 +30,18 @@
 #endif
 
 #include "gstmpeg2decoder.h"
+#include "gstcodecpicturepool.h"
+#include "gstcodecstats.h"
 
 GST_DEBUG_CATEGORY (gst_mpeg2_decoder_debug);
 #define GST_CAT_DEFAULT gst_mpeg2_decoder_debug
 
+enum
+{
+  PROP_0,
+  PROP_STATS,
+};
+
 /* ------------------------------------------------------------------------- */
 /* --- PTS Generator                                                     --- */
 /* ------------------------------------------------------------------------- */
@@ -258,6 +266,16 @@ struct _GstMpeg2DecoderPrivate
   GstMpeg2Picture *current_picture;
   GstVideoCodecFrame *current_frame;
   GstMpeg2Picture *first_field;
+
+  /* GstMpeg2Slice of current field, batched if subclass implements
+   * decode_slices */
+  GArray *slices;
+
+  /* recycled picture objects */
+  GstCodecPicturePool *picture_pool;
+
+  /* time spent per stage */
+  GstCodecStats *stats;
 };
 
 #define parent_class gst_mpeg2_decoder_parent_class
@@ -267,6 +285,10 @@ G_DEFINE_ABSTRACT_TYPE_WITH_CODE (GstMpeg2Decoder, gst_mpeg2_decoder,
     GST_DEBUG_CATEGORY_INIT (gst_mpeg2_decoder_debug, "mpeg2decoder", 0,
         "MPEG2 Video Decoder"));
 
+static void gst_mpeg2_decoder_finalize (GObject * object);
+static void gst_mpeg2_decoder_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+
 static gboolean gst_mpeg2_decoder_start (GstVideoDecoder * decoder);
 static gboolean gst_mpeg2_decoder_stop (GstVideoDecoder * decoder);
 static gboolean gst_mpeg2_decoder_set_format (GstVideoDecoder * decoder,
@@ -282,8 +304,28 @@ static gboolean gst_mpeg2_decoder_do_output_picture (GstMpeg2Decoder * self,
 static void
 gst_mpeg2_decoder_class_init (GstMpeg2DecoderClass * klass)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
   GstVideoDecoderClass *decoder_class = GST_VIDEO_DECODER_CLASS (klass);
 
+  object_class->finalize = GST_DEBUG_FUNCPTR (gst_mpeg2_decoder_finalize);
+  object_class->get_property = gst_mpeg2_decoder_get_property;
+
+  /**
+   * GstMpeg2Decoder:stats:
+   *
+   * Time spent by the decoder since it was started, split between the
+   * baseclass ("parse") and the subclass methods ("new-picture" including
+   * new_field_picture(), "start-picture", "decode" for decode_slice(),
+   * "end-picture" and "output"). See #GstH264Decoder:stats for the
+   * structure layout.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (object_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Time spent parsing, in each subclass method and outputting",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   decoder_class->start = GST_DEBUG_FUNCPTR (gst_mpeg2_decoder_start);
   decoder_class->stop = GST_DEBUG_FUNCPTR (gst_mpeg2_decoder_stop);
   decoder_class->set_format = GST_DEBUG_FUNCPTR (gst_mpeg2_decoder_set_format);
@@ -308,6 +350,39 @@ gst_mpeg2_decoder_init (GstMpeg2Decoder * self)
   self->priv->quant_matrix = QUANT_MATRIX_EXT_INIT;
   self->priv->pic_hdr = PIC_HDR_INIT;
   self->priv->pic_ext = PIC_HDR_EXT_INIT;
+  self->priv->picture_pool =
+      gst_codec_picture_pool_new (sizeof (GstMpeg2Picture));
+  self->priv->stats = gst_codec_stats_new (GST_OBJECT (self));
+  self->priv->slices = g_array_new (FALSE, FALSE, sizeof (GstMpeg2Slice));
+}
+
+static void
+gst_mpeg2_decoder_finalize (GObject * object)
+{
+  GstMpeg2Decoder *self = GST_MPEG2_DECODER (object);
+
+  gst_codec_picture_pool_unref (self->priv->picture_pool);
+  gst_codec_stats_free (self->priv->stats);
+  g_array_unref (self->priv->slices);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_mpeg2_decoder_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstMpeg2Decoder *self = GST_MPEG2_DECODER (object);
+
+  switch (prop_id) {
+    case PROP_STATS:
+      g_value_take_boxed (value,
+          gst_codec_stats_get_structure (self->priv->stats));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
 }
 
 static gboolean
@@ -321,6 +396,8 @@ gst_mpeg2_decoder_start (GstVideoDecoder * decoder)
   priv->profile = -1;
   priv->progressive = TRUE;
 
+  gst_codec_stats_reset (priv->stats);
+
   return TRUE;
 }
 
@@ -384,6 +461,7 @@ gst_mpeg2_decoder_flush (GstVideoDecoder * decoder)
   GstMpeg2DecoderPrivate *priv = self->priv;
 
   gst_mpeg2_dpb_clear (priv->dpb);
+  g_array_set_size (priv->slices, 0);
   priv->state &= GST_MPEG2_DECODER_STATE_VALID_SEQ_HEADERS;
   priv->pic_hdr = PIC_HDR_INIT;
   priv->pic_ext = PIC_HDR_EXT_INIT;
@@ -724,6 +802,7 @@ gst_mpeg2_decoder_start_current_picture (GstMpeg2Decoder * decoder,
   GstMpeg2DecoderPrivate *priv = decoder->priv;
   GstMpeg2DecoderClass *klass = GST_MPEG2_DECODER_GET_CLASS (decoder);
   GstMpeg2Picture *prev_picture, *next_picture;
+  GstClockTime begin;
   gboolean ret;
 
   if (!klass->start_picture)
@@ -738,8 +817,10 @@ gst_mpeg2_decoder_start_current_picture (GstMpeg2Decoder * decoder,
         GST_VIDEO_CODEC_FRAME_FLAG_DECODE_ONLY);
   }
 
+  begin = gst_codec_stats_stage_begin (priv->stats);
   ret = klass->start_picture (decoder, priv->current_picture, slice,
       prev_picture, next_picture);
+  gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_START_PICTURE, begin);
 
   if (!ret) {
     GST_ERROR_OBJECT (decoder, "subclass does not want to start picture");
@@ -773,9 +854,14 @@ gst_mpeg2_decoder_ensure_current_picture (GstMpeg2Decoder * decoder,
       gst_mpeg2_picture_clear (&priv->first_field);
     }
 
-    picture = gst_mpeg2_picture_new ();
-    if (klass->new_picture)
+    picture = gst_mpeg2_picture_new_from_pool (priv->picture_pool);
+    if (klass->new_picture) {
+      GstClockTime begin = gst_codec_stats_stage_begin (priv->stats);
+
       ret = klass->new_picture (decoder, priv->current_frame, picture);
+      gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_NEW_PICTURE,
+          begin);
+    }
 
     if (!ret) {
       GST_ERROR_OBJECT (decoder, "subclass does not want accept new picture");
@@ -786,9 +872,14 @@ gst_mpeg2_decoder_ensure_current_picture (GstMpeg2Decoder * decoder,
     picture->structure = GST_MPEG_VIDEO_PICTURE_STRUCTURE_FRAME;
   } else {
     if (!priv->first_field) {
-      picture = gst_mpeg2_picture_new ();
-      if (klass->new_picture)
+      picture = gst_mpeg2_picture_new_from_pool (priv->picture_pool);
+      if (klass->new_picture) {
+        GstClockTime begin = gst_codec_stats_stage_begin (priv->stats);
+
         ret = klass->new_picture (decoder, priv->current_frame, picture);
+        gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_NEW_PICTURE,
+            begin);
+      }
 
       if (!ret) {
         GST_ERROR_OBJECT (decoder, "subclass does not want accept new picture");
@@ -796,10 +887,15 @@ gst_mpeg2_decoder_ensure_current_picture (GstMpeg2Decoder * decoder,
         return FALSE;
       }
     } else {
-      picture = gst_mpeg2_picture_new ();
+      picture = gst_mpeg2_picture_new_from_pool (priv->picture_pool);
+
+      if (klass->new_field_picture) {
+        GstClockTime begin = gst_codec_stats_stage_begin (priv->stats);
 
-      if (klass->new_field_picture)
         ret = klass->new_field_picture (decoder, priv->first_field, picture);
+        gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_NEW_PICTURE,
+            begin);
+      }
 
       if (!ret) {
         GST_ERROR_OBJECT (decoder,
@@ -844,17 +940,54 @@ gst_mpeg2_decoder_ensure_current_picture (GstMpeg2Decoder * decoder,
   return TRUE;
 }
 
+static gboolean
+gst_mpeg2_decoder_submit_slices (GstMpeg2Decoder * decoder)
+{
+  GstMpeg2DecoderPrivate *priv = decoder->priv;
+  GstMpeg2DecoderClass *klass = GST_MPEG2_DECODER_GET_CLASS (decoder);
+  GstClockTime begin;
+  gboolean ret;
+
+  if (!klass->decode_slices || priv->slices->len == 0)
+    return TRUE;
+
+  g_assert (priv->current_picture);
+
+  GST_LOG_OBJECT (decoder, "Submit %d slices", priv->slices->len);
+
+  begin = gst_codec_stats_stage_begin (priv->stats);
+  ret = klass->decode_slices (decoder, priv->current_picture,
+      (GstMpeg2Slice *) priv->slices->data, priv->slices->len);
+  gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_DECODE, begin);
+  g_array_set_size (priv->slices, 0);
+
+  if (!ret) {
+    GST_ERROR_OBJECT (decoder,
+        "Subclass didn't want to decode picture %p (frame_num %d, poc %d)",
+        priv->current_picture, priv->current_picture->system_frame_number,
+        priv->current_picture->pic_order_cnt);
+  }
+
+  return ret;
+}
+
 static gboolean
 gst_mpeg2_decoder_finish_current_field (GstMpeg2Decoder * decoder)
 {
   GstMpeg2DecoderPrivate *priv = decoder->priv;
   GstMpeg2DecoderClass *klass = GST_MPEG2_DECODER_GET_CLASS (decoder);
+  GstClockTime begin;
   gboolean ret;
 
   if (priv->current_picture == NULL)
     return TRUE;
 
+  if (!gst_mpeg2_decoder_submit_slices (decoder))
+    return FALSE;
+
+  begin = gst_codec_stats_stage_begin (priv->stats);
   ret = klass->end_picture (decoder, priv->current_picture);
+  gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_END_PICTURE, begin);
   if (!ret) {
     GST_ERROR_OBJECT (decoder, "subclass end_picture failed");
     return FALSE;
@@ -882,11 +1015,17 @@ gst_mpeg2_decoder_finish_current_picture (GstMpeg2Decoder * decoder)
 {
   GstMpeg2DecoderPrivate *priv = decoder->priv;
   GstMpeg2DecoderClass *klass = GST_MPEG2_DECODER_GET_CLASS (decoder);
+  GstClockTime begin;
   gboolean ret;
 
   g_assert (priv->current_picture != NULL);
 
+  if (!gst_mpeg2_decoder_submit_slices (decoder))
+    return FALSE;
+
+  begin = gst_codec_stats_stage_begin (priv->stats);
   ret = klass->end_picture (decoder, priv->current_picture);
+  gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_END_PICTURE, begin);
   if (!ret) {
     GST_ERROR_OBJECT (decoder, "subclass end_picture failed");
     return FALSE;
@@ -910,6 +1049,7 @@ gst_mpeg2_decoder_handle_slice (GstMpeg2Decoder * decoder,
   GstMpegVideoSliceHdr slice_hdr;
   GstMpeg2DecoderClass *klass = GST_MPEG2_DECODER_GET_CLASS (decoder);
   GstMpeg2Slice slice;
+  GstClockTime begin;
   gboolean ret;
 
   if (!_is_valid_state (decoder, GST_MPEG2_DECODER_STATE_VALID_PIC_HEADERS)) {
@@ -940,8 +1080,16 @@ gst_mpeg2_decoder_handle_slice (GstMpeg2Decoder * decoder,
     return FALSE;
   }
 
+  if (klass->decode_slices) {
+    g_array_append_val (priv->slices, slice);
+    priv->state |= GST_MPEG2_DECODER_STATE_GOT_SLICE;
+    return TRUE;
+  }
+
   g_assert (klass->decode_slice);
+  begin = gst_codec_stats_stage_begin (priv->stats);
   ret = klass->decode_slice (decoder, priv->current_picture, &slice);
+  gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_DECODE, begin);
   if (!ret) {
     GST_ERROR_OBJECT (decoder,
         "Subclass didn't want to decode picture %p (frame_num %d, poc %d)",
@@ -1030,8 +1178,10 @@ static GstFlowReturn
 gst_mpeg2_decoder_do_output_picture (GstMpeg2Decoder * decoder,
     GstMpeg2Picture * to_output)
 {
+  GstMpeg2DecoderPrivate *priv = decoder->priv;
   GstMpeg2DecoderClass *klass = GST_MPEG2_DECODER_GET_CLASS (decoder);
   GstVideoCodecFrame *frame = NULL;
+  GstClockTime begin;
   GstFlowReturn ret = GST_FLOW_OK;
 
   frame =
@@ -1051,7 +1201,9 @@ gst_mpeg2_decoder_do_output_picture (GstMpeg2Decoder * decoder,
       "), from DPB",
       to_output, to_output->system_frame_number, to_output->pic_order_cnt,
       GST_TIME_ARGS (frame->pts));
+  begin = gst_codec_stats_stage_begin (priv->stats);
   ret = klass->output_picture (decoder, frame, to_output);
+  gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_OUTPUT, begin);
 
   return ret;
 }
@@ -1110,6 +1262,8 @@ gst_mpeg2_decoder_handle_frame (GstVideoDecoder * decoder,
       GST_TIME_ARGS (GST_BUFFER_PTS (in_buf)),
       GST_TIME_ARGS (GST_BUFFER_DTS (in_buf)), frame->system_frame_number);
 
+  gst_codec_stats_frame_begin (priv->stats);
+
   priv->state &= ~GST_MPEG2_DECODER_STATE_GOT_SLICE;
 
   priv->current_frame = frame;
@@ -1142,6 +1296,12 @@ gst_mpeg2_decoder_handle_frame (GstVideoDecoder * decoder,
     offset = packet.offset;
   }
 
+  /* queued slices point to the input buffer */
+  if (priv->current_picture && !gst_mpeg2_decoder_submit_slices (self)) {
+    gst_buffer_unmap (in_buf, &map_info);
+    goto failed;
+  }
+
   gst_buffer_unmap (in_buf, &map_info);
 
   if (!priv->current_picture) {
@@ -1159,6 +1319,7 @@ gst_mpeg2_decoder_handle_frame (GstVideoDecoder * decoder,
   gst_mpeg2_picture_clear (&priv->first_field);
   gst_video_codec_frame_unref (priv->current_frame);
   priv->current_frame = NULL;
+  gst_codec_stats_frame_end (priv->stats);
   return ret;
 
 failed:
@@ -1167,9 +1328,11 @@ failed:
         ("failed to handle the frame %d", frame->system_frame_number), (NULL),
         ret);
     gst_video_decoder_drop_frame (decoder, frame);
+    g_array_set_size (priv->slices, 0);
     gst_mpeg2_picture_clear (&priv->current_picture);
     gst_mpeg2_picture_clear (&priv->first_field);
     priv->current_frame = NULL;
+    gst_codec_stats_frame_end (priv->stats);
     return ret;
   }
 }
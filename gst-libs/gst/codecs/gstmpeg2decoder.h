@@ -142,7 +142,7 @@ struct _GstMpeg2DecoderClass
    * @slice: (transfer none): a #GstMpeg2Slice
    *
    * Provides per slice data with parsed slice header and required raw bitstream
-   * for subclass to decode it.
+   * for subclass to decode it. Not called if decode_slices is implemented.
    *
    * Since: 1.20
    */
@@ -178,6 +178,26 @@ struct _GstMpeg2DecoderClass
                                      GstVideoCodecFrame * frame,
                                      GstMpeg2Picture * picture);
 
+  /**
+   * GstMpeg2DecoderClass::decode_slices:
+   * @decoder: a #GstMpeg2Decoder
+   * @picture: (transfer none): a #GstMpeg2Picture
+   * @slices: (array length=num_slices) (transfer none): all #GstMpeg2Slice
+   *   of @picture, in bitstream order
+   * @num_slices: the number of @slices
+   *
+   * Optional. Alternative to decode_slice, called once per field or frame
+   * picture right before end_picture with all of its slices, so that they
+   * can be submitted at once. The slices of a picture are consecutive in the
+   * same input buffer.
+   *
+   * Since: 1.20
+   */
+  gboolean      (*decode_slices)    (GstMpeg2Decoder * decoder,
+                                     GstMpeg2Picture * picture,
+                                     GstMpeg2Slice * slices,
+                                     guint num_slices);
+
   /*< private >*/
   gpointer padding[GST_PADDING_LARGE];
 };
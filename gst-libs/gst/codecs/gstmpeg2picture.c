@@ -23,6 +23,7 @@
 #endif
 
 #include "gstmpeg2picture.h"
+#include "gstcodecpicturepool.h"
 
 GST_DEBUG_CATEGORY_EXTERN (gst_mpeg2_decoder_debug);
 #define GST_CAT_DEFAULT gst_mpeg2_decoder_debug
@@ -30,7 +31,7 @@ GST_DEBUG_CATEGORY_EXTERN (gst_mpeg2_decoder_debug);
 GST_DEFINE_MINI_OBJECT_TYPE (GstMpeg2Picture, gst_mpeg2_picture);
 
 static void
-_gst_mpeg2_picture_free (GstMpeg2Picture * picture)
+_gst_mpeg2_picture_clear_internal (GstMpeg2Picture * picture)
 {
   GST_TRACE ("Free picture %p", picture);
 
@@ -39,10 +40,37 @@ _gst_mpeg2_picture_free (GstMpeg2Picture * picture)
 
   if (picture->notify)
     picture->notify (picture->user_data);
+}
+
+static void
+_gst_mpeg2_picture_free (GstMpeg2Picture * picture)
+{
+  _gst_mpeg2_picture_clear_internal (picture);
 
   g_free (picture);
 }
 
+static void
+_gst_mpeg2_picture_free_pooled (GstMpeg2Picture * picture)
+{
+  _gst_mpeg2_picture_clear_internal (picture);
+
+  gst_codec_picture_pool_release (picture);
+}
+
+static void
+_gst_mpeg2_picture_init (GstMpeg2Picture * pic,
+    GstMiniObjectFreeFunction free_func)
+{
+  pic->pic_order_cnt = G_MAXINT32;
+  pic->structure = GST_MPEG_VIDEO_PICTURE_STRUCTURE_FRAME;
+
+  gst_mini_object_init (GST_MINI_OBJECT_CAST (pic), 0,
+      GST_TYPE_MPEG2_PICTURE, NULL, NULL, free_func);
+
+  GST_TRACE ("New picture %p", pic);
+}
+
 /**
  * gst_mpeg2_picture_new:
  *
@@ -58,15 +86,20 @@ gst_mpeg2_picture_new (void)
   GstMpeg2Picture *pic;
 
   pic = g_new0 (GstMpeg2Picture, 1);
+  _gst_mpeg2_picture_init (pic,
+      (GstMiniObjectFreeFunction) _gst_mpeg2_picture_free);
 
-  pic->pic_order_cnt = G_MAXINT32;
-  pic->structure = GST_MPEG_VIDEO_PICTURE_STRUCTURE_FRAME;
+  return pic;
+}
 
-  gst_mini_object_init (GST_MINI_OBJECT_CAST (pic), 0,
-      GST_TYPE_MPEG2_PICTURE, NULL, NULL,
-      (GstMiniObjectFreeFunction) _gst_mpeg2_picture_free);
+GstMpeg2Picture *
+gst_mpeg2_picture_new_from_pool (GstCodecPicturePool * pool)
+{
+  GstMpeg2Picture *pic;
 
-  GST_TRACE ("New picture %p", pic);
+  pic = gst_codec_picture_pool_acquire (pool);
+  _gst_mpeg2_picture_init (pic,
+      (GstMiniObjectFreeFunction) _gst_mpeg2_picture_free_pooled);
 
   return pic;
 }
@@ -30,10 +30,18 @@
 #endif
 
 #include "gstvp8decoder.h"
+#include "gstcodecpicturepool.h"
+#include "gstcodecstats.h"
 
 GST_DEBUG_CATEGORY (gst_vp8_decoder_debug);
 #define GST_CAT_DEFAULT gst_vp8_decoder_debug
 
+enum
+{
+  PROP_0,
+  PROP_STATS,
+};
+
 struct _GstVp8DecoderPrivate
 {
   gint width;
@@ -42,6 +50,12 @@ struct _GstVp8DecoderPrivate
   gboolean had_sequence;
   GstVp8Parser parser;
   gboolean wait_keyframe;
+
+  /* recycled picture objects */
+  GstCodecPicturePool *picture_pool;
+
+  /* time spent per stage */
+  GstCodecStats *stats;
 };
 
 #define parent_class gst_vp8_decoder_parent_class
@@ -51,6 +65,10 @@ G_DEFINE_ABSTRACT_TYPE_WITH_CODE (GstVp8Decoder, gst_vp8_decoder,
     GST_DEBUG_CATEGORY_INIT (gst_vp8_decoder_debug, "vp8decoder", 0,
         "VP8 Video Decoder"));
 
+static void gst_vp8_decoder_finalize (GObject * object);
+static void gst_vp8_decoder_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+
 static gboolean gst_vp8_decoder_start (GstVideoDecoder * decoder);
 static gboolean gst_vp8_decoder_stop (GstVideoDecoder * decoder);
 static gboolean gst_vp8_decoder_set_format (GstVideoDecoder * decoder,
@@ -64,8 +82,27 @@ static GstFlowReturn gst_vp8_decoder_handle_frame (GstVideoDecoder * decoder,
 static void
 gst_vp8_decoder_class_init (GstVp8DecoderClass * klass)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
   GstVideoDecoderClass *decoder_class = GST_VIDEO_DECODER_CLASS (klass);
 
+  object_class->finalize = GST_DEBUG_FUNCPTR (gst_vp8_decoder_finalize);
+  object_class->get_property = gst_vp8_decoder_get_property;
+
+  /**
+   * GstVp8Decoder:stats:
+   *
+   * Time spent by the decoder since it was started, split between the
+   * baseclass ("parse") and the subclass methods ("new-picture",
+   * "start-picture", "decode" for decode_picture(), "end-picture" and
+   * "output"). See #GstH264Decoder:stats for the structure layout.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (object_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Time spent parsing, in each subclass method and outputting",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   decoder_class->start = GST_DEBUG_FUNCPTR (gst_vp8_decoder_start);
   decoder_class->stop = GST_DEBUG_FUNCPTR (gst_vp8_decoder_stop);
   decoder_class->set_format = GST_DEBUG_FUNCPTR (gst_vp8_decoder_set_format);
@@ -82,6 +119,37 @@ gst_vp8_decoder_init (GstVp8Decoder * self)
   gst_video_decoder_set_packetized (GST_VIDEO_DECODER (self), TRUE);
 
   self->priv = gst_vp8_decoder_get_instance_private (self);
+  self->priv->picture_pool =
+      gst_codec_picture_pool_new (sizeof (GstVp8Picture));
+  self->priv->stats = gst_codec_stats_new (GST_OBJECT (self));
+}
+
+static void
+gst_vp8_decoder_finalize (GObject * object)
+{
+  GstVp8Decoder *self = GST_VP8_DECODER (object);
+
+  gst_codec_picture_pool_unref (self->priv->picture_pool);
+  gst_codec_stats_free (self->priv->stats);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_vp8_decoder_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstVp8Decoder *self = GST_VP8_DECODER (object);
+
+  switch (prop_id) {
+    case PROP_STATS:
+      g_value_take_boxed (value,
+          gst_codec_stats_get_structure (self->priv->stats));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
 }
 
 static gboolean
@@ -93,6 +161,8 @@ gst_vp8_decoder_start (GstVideoDecoder * decoder)
   gst_vp8_parser_init (&priv->parser);
   priv->wait_keyframe = TRUE;
 
+  gst_codec_stats_reset (priv->stats);
+
   return TRUE;
 }
 
@@ -284,12 +354,16 @@ gst_vp8_decoder_handle_frame (GstVideoDecoder * decoder,
   GstVp8ParserResult pres;
   GstVp8Picture *picture = NULL;
   GstFlowReturn ret = GST_FLOW_OK;
+  GstClockTime begin;
+  gboolean ok;
 
   GST_LOG_OBJECT (self,
       "handle frame, PTS: %" GST_TIME_FORMAT ", DTS: %"
       GST_TIME_FORMAT, GST_TIME_ARGS (GST_BUFFER_PTS (in_buf)),
       GST_TIME_ARGS (GST_BUFFER_DTS (in_buf)));
 
+  gst_codec_stats_frame_begin (priv->stats);
+
   if (!gst_buffer_map (in_buf, &map, GST_MAP_READ)) {
     GST_ERROR_OBJECT (self, "Cannot map buffer");
 
@@ -313,6 +387,7 @@ gst_vp8_decoder_handle_frame (GstVideoDecoder * decoder,
       gst_buffer_unmap (in_buf, &map);
       gst_video_decoder_drop_frame (decoder, frame);
 
+      gst_codec_stats_frame_end (priv->stats);
       return GST_FLOW_OK;
     }
   }
@@ -325,7 +400,7 @@ gst_vp8_decoder_handle_frame (GstVideoDecoder * decoder,
     goto unmap_and_error;
   }
 
-  picture = gst_vp8_picture_new ();
+  picture = gst_vp8_picture_new_from_pool (priv->picture_pool);
   picture->frame_hdr = frame_hdr;
   picture->pts = GST_BUFFER_PTS (in_buf);
   picture->data = map.data;
@@ -333,28 +408,45 @@ gst_vp8_decoder_handle_frame (GstVideoDecoder * decoder,
   picture->system_frame_number = frame->system_frame_number;
 
   if (klass->new_picture) {
-    if (!klass->new_picture (self, frame, picture)) {
+    begin = gst_codec_stats_stage_begin (priv->stats);
+    ok = klass->new_picture (self, frame, picture);
+    gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_NEW_PICTURE, begin);
+
+    if (!ok) {
       GST_ERROR_OBJECT (self, "subclass cannot handle new picture");
       goto unmap_and_error;
     }
   }
 
   if (klass->start_picture) {
-    if (!klass->start_picture (self, picture)) {
+    begin = gst_codec_stats_stage_begin (priv->stats);
+    ok = klass->start_picture (self, picture);
+    gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_START_PICTURE,
+        begin);
+
+    if (!ok) {
       GST_ERROR_OBJECT (self, "subclass cannot handle start picture");
       goto unmap_and_error;
     }
   }
 
   if (klass->decode_picture) {
-    if (!klass->decode_picture (self, picture, &priv->parser)) {
+    begin = gst_codec_stats_stage_begin (priv->stats);
+    ok = klass->decode_picture (self, picture, &priv->parser);
+    gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_DECODE, begin);
+
+    if (!ok) {
       GST_ERROR_OBJECT (self, "subclass cannot decode current picture");
       goto unmap_and_error;
     }
   }
 
   if (klass->end_picture) {
-    if (!klass->end_picture (self, picture)) {
+    begin = gst_codec_stats_stage_begin (priv->stats);
+    ok = klass->end_picture (self, picture);
+    gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_END_PICTURE, begin);
+
+    if (!ok) {
       GST_ERROR_OBJECT (self, "subclass cannot handle end picture");
       goto unmap_and_error;
     }
@@ -373,9 +465,12 @@ gst_vp8_decoder_handle_frame (GstVideoDecoder * decoder,
     ret = gst_video_decoder_finish_frame (GST_VIDEO_DECODER (self), frame);
   } else {
     g_assert (klass->output_picture);
+    begin = gst_codec_stats_stage_begin (priv->stats);
     ret = klass->output_picture (self, frame, picture);
+    gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_OUTPUT, begin);
   }
 
+  gst_codec_stats_frame_end (priv->stats);
   return ret;
 
 unmap_and_error:
@@ -393,6 +488,7 @@ error:
     GST_VIDEO_DECODER_ERROR (self, 1, STREAM, DECODE,
         ("Failed to decode data"), (NULL), ret);
 
+    gst_codec_stats_frame_end (priv->stats);
     return ret;
   }
 }
@@ -22,6 +22,7 @@
 #endif
 
 #include "gstvp8picture.h"
+#include "gstcodecpicturepool.h"
 
 GST_DEBUG_CATEGORY_EXTERN (gst_vp8_decoder_debug);
 #define GST_CAT_DEFAULT gst_vp8_decoder_debug
@@ -29,16 +30,42 @@ GST_DEBUG_CATEGORY_EXTERN (gst_vp8_decoder_debug);
 GST_DEFINE_MINI_OBJECT_TYPE (GstVp8Picture, gst_vp8_picture);
 
 static void
-_gst_vp8_picture_free (GstVp8Picture * picture)
+_gst_vp8_picture_clear_internal (GstVp8Picture * picture)
 {
   GST_TRACE ("Free picture %p", picture);
 
   if (picture->notify)
     picture->notify (picture->user_data);
+}
+
+static void
+_gst_vp8_picture_free (GstVp8Picture * picture)
+{
+  _gst_vp8_picture_clear_internal (picture);
 
   g_free (picture);
 }
 
+static void
+_gst_vp8_picture_free_pooled (GstVp8Picture * picture)
+{
+  _gst_vp8_picture_clear_internal (picture);
+
+  gst_codec_picture_pool_release (picture);
+}
+
+static void
+_gst_vp8_picture_init (GstVp8Picture * pic,
+    GstMiniObjectFreeFunction free_func)
+{
+  pic->pts = GST_CLOCK_TIME_NONE;
+
+  gst_mini_object_init (GST_MINI_OBJECT_CAST (pic), 0,
+      GST_TYPE_VP8_PICTURE, NULL, NULL, free_func);
+
+  GST_TRACE ("New picture %p", pic);
+}
+
 /**
  * gst_vp8_picture_new:
  *
@@ -52,13 +79,20 @@ gst_vp8_picture_new (void)
   GstVp8Picture *pic;
 
   pic = g_new0 (GstVp8Picture, 1);
-  pic->pts = GST_CLOCK_TIME_NONE;
-
-  gst_mini_object_init (GST_MINI_OBJECT_CAST (pic), 0,
-      GST_TYPE_VP8_PICTURE, NULL, NULL,
+  _gst_vp8_picture_init (pic,
       (GstMiniObjectFreeFunction) _gst_vp8_picture_free);
 
-  GST_TRACE ("New picture %p", pic);
+  return pic;
+}
+
+GstVp8Picture *
+gst_vp8_picture_new_from_pool (GstCodecPicturePool * pool)
+{
+  GstVp8Picture *pic;
+
+  pic = gst_codec_picture_pool_acquire (pool);
+  _gst_vp8_picture_init (pic,
+      (GstMiniObjectFreeFunction) _gst_vp8_picture_free_pooled);
 
   return pic;
 }
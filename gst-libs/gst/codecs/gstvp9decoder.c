@@ -58,11 +58,20 @@
 #include <config.h>
 #endif
 
+#include <gst/base/base.h>
 #include "gstvp9decoder.h"
+#include "gstcodecpicturepool.h"
+#include "gstcodecstats.h"
 
 GST_DEBUG_CATEGORY (gst_vp9_decoder_debug);
 #define GST_CAT_DEFAULT gst_vp9_decoder_debug
 
+enum
+{
+  PROP_0,
+  PROP_STATS,
+};
+
 struct _GstVp9DecoderPrivate
 {
   gint width;
@@ -75,8 +84,31 @@ struct _GstVp9DecoderPrivate
   GstVp9Dpb *dpb;
 
   gboolean wait_keyframe;
+
+  /* recycled picture objects */
+  GstCodecPicturePool *picture_pool;
+
+  /* time spent per stage */
+  GstCodecStats *stats;
+
+  /* highest number of pictures held at once since the last new_sequence() */
+  guint max_pictures_in_use;
+
+  gboolean is_live;
+  guint preferred_output_delay;
+  GstQueueArray *output_queue;
+  GstFlowReturn last_ret;
 };
 
+typedef struct
+{
+  /* Holds ref */
+  GstVideoCodecFrame *frame;
+  GstVp9Picture *picture;
+  /* Without ref */
+  GstVp9Decoder *self;
+} GstVp9DecoderOutputFrame;
+
 #define parent_class gst_vp9_decoder_parent_class
 G_DEFINE_ABSTRACT_TYPE_WITH_CODE (GstVp9Decoder, gst_vp9_decoder,
     GST_TYPE_VIDEO_DECODER,
@@ -84,6 +116,10 @@ G_DEFINE_ABSTRACT_TYPE_WITH_CODE (GstVp9Decoder, gst_vp9_decoder,
     GST_DEBUG_CATEGORY_INIT (gst_vp9_decoder_debug, "vp9decoder", 0,
         "VP9 Video Decoder"));
 
+static void gst_vp9_decoder_finalize (GObject * object);
+static void gst_vp9_decoder_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+
 static gboolean gst_vp9_decoder_start (GstVideoDecoder * decoder);
 static gboolean gst_vp9_decoder_stop (GstVideoDecoder * decoder);
 static gboolean gst_vp9_decoder_set_format (GstVideoDecoder * decoder,
@@ -96,12 +132,33 @@ static GstFlowReturn gst_vp9_decoder_handle_frame (GstVideoDecoder * decoder,
 
 static GstVp9Picture *gst_vp9_decoder_duplicate_picture_default (GstVp9Decoder *
     decoder, GstVp9Picture * picture);
+static void
+gst_vp9_decoder_clear_output_frame (GstVp9DecoderOutputFrame * output_frame);
 
 static void
 gst_vp9_decoder_class_init (GstVp9DecoderClass * klass)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
   GstVideoDecoderClass *decoder_class = GST_VIDEO_DECODER_CLASS (klass);
 
+  object_class->finalize = GST_DEBUG_FUNCPTR (gst_vp9_decoder_finalize);
+  object_class->get_property = gst_vp9_decoder_get_property;
+
+  /**
+   * GstVp9Decoder:stats:
+   *
+   * Time spent by the decoder since it was started, split between the
+   * baseclass ("parse") and the subclass methods ("new-picture",
+   * "start-picture", "decode" for decode_picture(), "end-picture" and
+   * "output"). See #GstH264Decoder:stats for the structure layout.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (object_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Time spent parsing, in each subclass method and outputting",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   decoder_class->start = GST_DEBUG_FUNCPTR (gst_vp9_decoder_start);
   decoder_class->stop = GST_DEBUG_FUNCPTR (gst_vp9_decoder_stop);
   decoder_class->set_format = GST_DEBUG_FUNCPTR (gst_vp9_decoder_set_format);
@@ -121,6 +178,43 @@ gst_vp9_decoder_init (GstVp9Decoder * self)
   gst_video_decoder_set_packetized (GST_VIDEO_DECODER (self), TRUE);
 
   self->priv = gst_vp9_decoder_get_instance_private (self);
+  self->priv->picture_pool =
+      gst_codec_picture_pool_new (sizeof (GstVp9Picture));
+  self->priv->stats = gst_codec_stats_new (GST_OBJECT (self));
+
+  self->priv->output_queue =
+      gst_queue_array_new_for_struct (sizeof (GstVp9DecoderOutputFrame), 1);
+  gst_queue_array_set_clear_func (self->priv->output_queue,
+      (GDestroyNotify) gst_vp9_decoder_clear_output_frame);
+}
+
+static void
+gst_vp9_decoder_finalize (GObject * object)
+{
+  GstVp9Decoder *self = GST_VP9_DECODER (object);
+
+  gst_codec_picture_pool_unref (self->priv->picture_pool);
+  gst_codec_stats_free (self->priv->stats);
+  gst_queue_array_free (self->priv->output_queue);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_vp9_decoder_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstVp9Decoder *self = GST_VP9_DECODER (object);
+
+  switch (prop_id) {
+    case PROP_STATS:
+      g_value_take_boxed (value,
+          gst_codec_stats_get_structure (self->priv->stats));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
 }
 
 static gboolean
@@ -132,6 +226,9 @@ gst_vp9_decoder_start (GstVideoDecoder * decoder)
   priv->parser = gst_vp9_parser_new ();
   priv->dpb = gst_vp9_dpb_new ();
   priv->wait_keyframe = TRUE;
+  priv->last_ret = GST_FLOW_OK;
+
+  gst_codec_stats_reset (priv->stats);
 
   return TRUE;
 }
@@ -157,9 +254,99 @@ gst_vp9_decoder_stop (GstVideoDecoder * decoder)
     priv->dpb = NULL;
   }
 
+  gst_queue_array_clear (priv->output_queue);
+
   return TRUE;
 }
 
+static void
+gst_vp9_decoder_clear_output_frame (GstVp9DecoderOutputFrame * output_frame)
+{
+  if (!output_frame)
+    return;
+
+  if (output_frame->frame) {
+    gst_video_decoder_release_frame (GST_VIDEO_DECODER (output_frame->self),
+        output_frame->frame);
+    output_frame->frame = NULL;
+  }
+
+  gst_vp9_picture_clear (&output_frame->picture);
+}
+
+static void
+gst_vp9_decoder_drain_output_queue (GstVp9Decoder * self, guint num)
+{
+  GstVp9DecoderPrivate *priv = self->priv;
+  GstVp9DecoderClass *klass = GST_VP9_DECODER_GET_CLASS (self);
+
+  while (gst_queue_array_get_length (priv->output_queue) > num) {
+    GstVp9DecoderOutputFrame *output_frame = (GstVp9DecoderOutputFrame *)
+        gst_queue_array_pop_head_struct (priv->output_queue);
+    GstVp9Picture *picture = output_frame->picture;
+    GstFlowReturn ret;
+
+    if (!picture->frame_hdr.show_frame) {
+      GST_LOG_OBJECT (self, "Decode only picture %p", picture);
+      GST_VIDEO_CODEC_FRAME_SET_DECODE_ONLY (output_frame->frame);
+
+      gst_vp9_picture_unref (picture);
+
+      ret = gst_video_decoder_finish_frame (GST_VIDEO_DECODER (self),
+          output_frame->frame);
+    } else {
+      GstClockTime begin = gst_codec_stats_stage_begin (priv->stats);
+
+      g_assert (klass->output_picture);
+      ret = klass->output_picture (self, output_frame->frame, picture);
+      gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_OUTPUT, begin);
+    }
+
+    /* keep the first error, the caller returns it upstream */
+    if (priv->last_ret == GST_FLOW_OK)
+      priv->last_ret = ret;
+  }
+}
+
+/* Whether the frame following @frame_hdr can be decoded before @frame_hdr is
+ * finished, i.e. does not depend on its backward probability adaptation.
+ * That is the case in error resilient and frame parallel decoding mode, or
+ * if the adapted context is not stored */
+static gboolean
+gst_vp9_decoder_is_frame_parallel (const GstVp9FrameHdr * frame_hdr)
+{
+  return frame_hdr->error_resilient_mode ||
+      frame_hdr->frame_parallel_decoding_mode ||
+      !frame_hdr->refresh_frame_context;
+}
+
+static void
+gst_vp9_decoder_set_latency (GstVp9Decoder * self)
+{
+  GstVp9DecoderPrivate *priv = self->priv;
+  GstClockTime latency;
+  gint fps_n = 0;
+  gint fps_d = 1;
+
+  if (self->input_state) {
+    fps_n = GST_VIDEO_INFO_FPS_N (&self->input_state->info);
+    fps_d = GST_VIDEO_INFO_FPS_D (&self->input_state->info);
+  }
+
+  /* if no fps or variable, then 25/1 */
+  if (fps_n == 0) {
+    fps_n = 25;
+    fps_d = 1;
+  }
+
+  latency = gst_util_uint64_scale_int (priv->preferred_output_delay *
+      GST_SECOND, fps_d, fps_n);
+
+  GST_LOG_OBJECT (self, "latency %" GST_TIME_FORMAT, GST_TIME_ARGS (latency));
+
+  gst_video_decoder_set_latency (GST_VIDEO_DECODER (self), latency, latency);
+}
+
 static gboolean
 gst_vp9_decoder_check_codec_change (GstVp9Decoder * self,
     const GstVp9FrameHdr * frame_hdr)
@@ -185,22 +372,75 @@ gst_vp9_decoder_check_codec_change (GstVp9Decoder * self,
   if (changed || !priv->had_sequence) {
     GstVp9DecoderClass *klass = GST_VP9_DECODER_GET_CLASS (self);
 
+    /* pictures of the previous sequence can't wait for the next ones */
+    gst_vp9_decoder_drain_output_queue (self, 0);
+
+    if (klass->get_preferred_output_delay) {
+      priv->preferred_output_delay =
+          klass->get_preferred_output_delay (self, priv->is_live);
+    } else {
+      priv->preferred_output_delay = 0;
+    }
+
     priv->had_sequence = TRUE;
+    priv->max_pictures_in_use = 0;
     if (klass->new_sequence)
       priv->had_sequence = klass->new_sequence (self, priv->parser, frame_hdr);
 
     ret = priv->had_sequence;
+
+    if (ret)
+      gst_vp9_decoder_set_latency (self);
   }
 
   return ret;
 }
 
+/* Records the peak of distinct pictures referenced by the DPB slots, plus
+ * @picture if it is not a reference */
+static void
+gst_vp9_decoder_update_pictures_in_use (GstVp9Decoder * self,
+    GstVp9Picture * picture)
+{
+  GstVp9DecoderPrivate *priv = self->priv;
+  gboolean is_ref = FALSE;
+  guint num = 0;
+  guint i, j;
+
+  for (i = 0; i < GST_VP9_REF_FRAMES; i++) {
+    GstVp9Picture *ref = priv->dpb->pic_list[i];
+
+    if (!ref)
+      continue;
+
+    if (ref == picture)
+      is_ref = TRUE;
+
+    for (j = 0; j < i; j++) {
+      if (priv->dpb->pic_list[j] == ref)
+        break;
+    }
+
+    if (j == i)
+      num++;
+  }
+
+  if (!is_ref)
+    num++;
+
+  if (num > priv->max_pictures_in_use) {
+    GST_DEBUG_OBJECT (self, "%u pictures in use", num);
+    priv->max_pictures_in_use = num;
+  }
+}
+
 static gboolean
 gst_vp9_decoder_set_format (GstVideoDecoder * decoder,
     GstVideoCodecState * state)
 {
   GstVp9Decoder *self = GST_VP9_DECODER (decoder);
   GstVp9DecoderPrivate *priv = self->priv;
+  GstQuery *query;
 
   GST_DEBUG_OBJECT (decoder, "Set format");
 
@@ -212,6 +452,12 @@ gst_vp9_decoder_set_format (GstVideoDecoder * decoder,
   priv->width = GST_VIDEO_INFO_WIDTH (&state->info);
   priv->height = GST_VIDEO_INFO_HEIGHT (&state->info);
 
+  priv->is_live = FALSE;
+  query = gst_query_new_latency ();
+  if (gst_pad_peer_query (GST_VIDEO_DECODER_SINK_PAD (self), query))
+    gst_query_parse_latency (query, &priv->is_live, NULL, NULL);
+  gst_query_unref (query);
+
   return TRUE;
 }
 
@@ -223,17 +469,33 @@ gst_vp9_decoder_reset (GstVp9Decoder * self)
   if (priv->dpb)
     gst_vp9_dpb_clear (priv->dpb);
 
+  gst_queue_array_clear (priv->output_queue);
+
   priv->wait_keyframe = TRUE;
 }
 
+static GstFlowReturn
+gst_vp9_decoder_drain_internal (GstVp9Decoder * self)
+{
+  GstVp9DecoderPrivate *priv = self->priv;
+  GstFlowReturn ret;
+
+  priv->last_ret = GST_FLOW_OK;
+  gst_vp9_decoder_drain_output_queue (self, 0);
+  ret = priv->last_ret;
+  priv->last_ret = GST_FLOW_OK;
+
+  gst_vp9_decoder_reset (self);
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_vp9_decoder_finish (GstVideoDecoder * decoder)
 {
   GST_DEBUG_OBJECT (decoder, "finish");
 
-  gst_vp9_decoder_reset (GST_VP9_DECODER (decoder));
-
-  return GST_FLOW_OK;
+  return gst_vp9_decoder_drain_internal (GST_VP9_DECODER (decoder));
 }
 
 static gboolean
@@ -251,9 +513,7 @@ gst_vp9_decoder_drain (GstVideoDecoder * decoder)
 {
   GST_DEBUG_OBJECT (decoder, "drain");
 
-  gst_vp9_decoder_reset (GST_VP9_DECODER (decoder));
-
-  return GST_FLOW_OK;
+  return gst_vp9_decoder_drain_internal (GST_VP9_DECODER (decoder));
 }
 
 static GstVp9Picture *
@@ -262,7 +522,7 @@ gst_vp9_decoder_duplicate_picture_default (GstVp9Decoder * decoder,
 {
   GstVp9Picture *new_picture;
 
-  new_picture = gst_vp9_picture_new ();
+  new_picture = gst_vp9_picture_new_from_pool (decoder->priv->picture_pool);
   new_picture->frame_hdr = picture->frame_hdr;
 
   return new_picture;
@@ -280,10 +540,17 @@ gst_vp9_decoder_handle_frame (GstVideoDecoder * decoder,
   GstVp9Picture *picture = NULL;
   GstVp9ParserResult pres;
   GstMapInfo map;
+  GstVp9DecoderOutputFrame output_frame;
   GstFlowReturn ret = GST_FLOW_OK;
+  GstClockTime begin;
+  gboolean ok;
 
   GST_LOG_OBJECT (self, "handle frame %" GST_PTR_FORMAT, in_buf);
 
+  priv->last_ret = GST_FLOW_OK;
+
+  gst_codec_stats_frame_begin (priv->stats);
+
   if (!gst_buffer_map (in_buf, &map, GST_MAP_READ)) {
     GST_ERROR_OBJECT (self, "Cannot map input buffer");
     goto error;
@@ -303,6 +570,7 @@ gst_vp9_decoder_handle_frame (GstVideoDecoder * decoder,
 
     gst_video_decoder_release_frame (decoder, frame);;
 
+    gst_codec_stats_frame_end (priv->stats);
     return GST_FLOW_OK;
   }
 
@@ -338,7 +606,7 @@ gst_vp9_decoder_handle_frame (GstVideoDecoder * decoder,
       goto unmap_and_error;
     }
   } else {
-    picture = gst_vp9_picture_new ();
+    picture = gst_vp9_picture_new_from_pool (priv->picture_pool);
     picture->frame_hdr = frame_hdr;
 
     picture->data = map.data;
@@ -352,28 +620,47 @@ gst_vp9_decoder_handle_frame (GstVideoDecoder * decoder,
         sizeof (priv->parser->segmentation));
 
     if (klass->new_picture) {
-      if (!klass->new_picture (self, frame, picture)) {
+      begin = gst_codec_stats_stage_begin (priv->stats);
+      ok = klass->new_picture (self, frame, picture);
+      gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_NEW_PICTURE,
+          begin);
+
+      if (!ok) {
         GST_ERROR_OBJECT (self, "new picture error");
         goto unmap_and_error;
       }
     }
 
     if (klass->start_picture) {
-      if (!klass->start_picture (self, picture)) {
+      begin = gst_codec_stats_stage_begin (priv->stats);
+      ok = klass->start_picture (self, picture);
+      gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_START_PICTURE,
+          begin);
+
+      if (!ok) {
         GST_ERROR_OBJECT (self, "start picture error");
         goto unmap_and_error;
       }
     }
 
     if (klass->decode_picture) {
-      if (!klass->decode_picture (self, picture, priv->dpb)) {
+      begin = gst_codec_stats_stage_begin (priv->stats);
+      ok = klass->decode_picture (self, picture, priv->dpb);
+      gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_DECODE, begin);
+
+      if (!ok) {
         GST_ERROR_OBJECT (self, "decode picture error");
         goto unmap_and_error;
       }
     }
 
     if (klass->end_picture) {
-      if (!klass->end_picture (self, picture)) {
+      begin = gst_codec_stats_stage_begin (priv->stats);
+      ok = klass->end_picture (self, picture);
+      gst_codec_stats_stage_end (priv->stats, GST_CODEC_STATS_END_PICTURE,
+          begin);
+
+      if (!ok) {
         GST_ERROR_OBJECT (self, "end picture error");
         goto unmap_and_error;
       }
@@ -384,22 +671,30 @@ gst_vp9_decoder_handle_frame (GstVideoDecoder * decoder,
      * (i.e., not a reference frame), gst_vp9_dpb_add() will take care of
      * the case as well */
     gst_vp9_dpb_add (priv->dpb, gst_vp9_picture_ref (picture));
+    gst_vp9_decoder_update_pictures_in_use (self, picture);
   }
 
   gst_buffer_unmap (in_buf, &map);
 
-  if (!picture->frame_hdr.show_frame) {
-    GST_LOG_OBJECT (self, "Decode only picture %p", picture);
-    GST_VIDEO_CODEC_FRAME_SET_DECODE_ONLY (frame);
-
-    gst_vp9_picture_unref (picture);
-
-    ret = gst_video_decoder_finish_frame (GST_VIDEO_DECODER (self), frame);
-  } else {
-    g_assert (klass->output_picture);
-    ret = klass->output_picture (self, frame, picture);
-  }
-
+  /* Decode only frames are queued as well so that frames are finished in
+   * decoding order */
+  output_frame.frame = frame;
+  output_frame.picture = picture;
+  output_frame.self = self;
+  gst_queue_array_push_tail_struct (priv->output_queue, &output_frame);
+
+  /* Only hold frames back while the next frame can be decoded without the
+   * backward adaptation of this one. Otherwise the subclass may have to wait
+   * for this frame anyway, so delaying its output would only add latency */
+  if (gst_vp9_decoder_is_frame_parallel (&picture->frame_hdr))
+    gst_vp9_decoder_drain_output_queue (self, priv->preferred_output_delay);
+  else
+    gst_vp9_decoder_drain_output_queue (self, 0);
+
+  ret = priv->last_ret;
+  priv->last_ret = GST_FLOW_OK;
+
+  gst_codec_stats_frame_end (priv->stats);
   return ret;
 
 unmap_and_error:
@@ -417,6 +712,30 @@ error:
     GST_VIDEO_DECODER_ERROR (self, 1, STREAM, DECODE,
         ("Failed to decode data"), (NULL), ret);
 
+    gst_codec_stats_frame_end (priv->stats);
     return ret;
   }
 }
+
+/**
+ * gst_vp9_decoder_get_max_pictures_in_use:
+ * @decoder: a #GstVp9Decoder
+ *
+ * Retrieve the highest number of distinct pictures @decoder has held at
+ * once since the last #GstVp9DecoderClass.new_sequence() call, counting
+ * the pictures referenced by the eight reference slots and the picture
+ * being decoded. Streams often point several slots at the same picture,
+ * so this is usually well below %GST_VP9_REF_FRAMES + 1. Subclasses can
+ * use it to size their output pool from a small start.
+ *
+ * Returns: the number of pictures, or 0 if nothing was decoded yet
+ *
+ * Since: 1.20
+ */
+guint
+gst_vp9_decoder_get_max_pictures_in_use (GstVp9Decoder * decoder)
+{
+  g_return_val_if_fail (GST_IS_VP9_DECODER (decoder), 0);
+
+  return decoder->priv->max_pictures_in_use;
+}
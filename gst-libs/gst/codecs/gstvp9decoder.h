@@ -127,6 +127,26 @@ struct _GstVp9DecoderClass
                                         GstVideoCodecFrame * frame,
                                         GstVp9Picture * picture);
 
+  /**
+   * GstVp9DecoderClass::get_preferred_output_delay:
+   * @decoder: a #GstVp9Decoder
+   * @live: whether upstream is live or not
+   *
+   * Optional. Called by baseclass before new_sequence() to query the number
+   * of decoded frames the subclass would like to be held back before
+   * output_picture() is called for them, so that the next frames can be
+   * submitted to the hardware before waiting for the previous one.
+   * Frames are only held back while the stream allows decoding a frame
+   * before the previous one is finished, that is in error resilient or
+   * frame parallel decoding mode.
+   *
+   * Returns: the number of preferred delayed output frames
+   *
+   * Since: 1.20
+   */
+  guint           (*get_preferred_output_delay) (GstVp9Decoder * decoder,
+                                                 gboolean live);
+
   /*< private >*/
   gpointer padding[GST_PADDING_LARGE];
 };
@@ -136,6 +156,9 @@ G_DEFINE_AUTOPTR_CLEANUP_FUNC(GstVp9Decoder, gst_object_unref)
 GST_CODECS_API
 GType gst_vp9_decoder_get_type (void);
 
+GST_CODECS_API
+guint gst_vp9_decoder_get_max_pictures_in_use (GstVp9Decoder * decoder);
+
 G_END_DECLS
 
 #endif /* __GST_VP9_DECODER_H__ */
@@ -22,6 +22,7 @@
 #endif
 
 #include "gstvp9picture.h"
+#include "gstcodecpicturepool.h"
 
 GST_DEBUG_CATEGORY_EXTERN (gst_vp9_decoder_debug);
 #define GST_CAT_DEFAULT gst_vp9_decoder_debug
@@ -29,16 +30,40 @@ GST_DEBUG_CATEGORY_EXTERN (gst_vp9_decoder_debug);
 GST_DEFINE_MINI_OBJECT_TYPE (GstVp9Picture, gst_vp9_picture);
 
 static void
-_gst_vp9_picture_free (GstVp9Picture * picture)
+_gst_vp9_picture_clear_internal (GstVp9Picture * picture)
 {
   GST_TRACE ("Free picture %p", picture);
 
   if (picture->notify)
     picture->notify (picture->user_data);
+}
+
+static void
+_gst_vp9_picture_free (GstVp9Picture * picture)
+{
+  _gst_vp9_picture_clear_internal (picture);
 
   g_free (picture);
 }
 
+static void
+_gst_vp9_picture_free_pooled (GstVp9Picture * picture)
+{
+  _gst_vp9_picture_clear_internal (picture);
+
+  gst_codec_picture_pool_release (picture);
+}
+
+static void
+_gst_vp9_picture_init (GstVp9Picture * pic,
+    GstMiniObjectFreeFunction free_func)
+{
+  gst_mini_object_init (GST_MINI_OBJECT_CAST (pic), 0,
+      GST_TYPE_VP9_PICTURE, NULL, NULL, free_func);
+
+  GST_TRACE ("New picture %p", pic);
+}
+
 /**
  * gst_vp9_picture_new:
  *
@@ -52,12 +77,20 @@ gst_vp9_picture_new (void)
   GstVp9Picture *pic;
 
   pic = g_new0 (GstVp9Picture, 1);
-
-  gst_mini_object_init (GST_MINI_OBJECT_CAST (pic), 0,
-      GST_TYPE_VP9_PICTURE, NULL, NULL,
+  _gst_vp9_picture_init (pic,
       (GstMiniObjectFreeFunction) _gst_vp9_picture_free);
 
-  GST_TRACE ("New picture %p", pic);
+  return pic;
+}
+
+GstVp9Picture *
+gst_vp9_picture_new_from_pool (GstCodecPicturePool * pool)
+{
+  GstVp9Picture *pic;
+
+  pic = gst_codec_picture_pool_acquire (pool);
+  _gst_vp9_picture_init (pic,
+      (GstMiniObjectFreeFunction) _gst_vp9_picture_free_pooled);
 
   return pic;
 }
@@ -37,6 +37,13 @@
  * returns or it could be called later from another thread. The signature of
  * this callback GstInsertBinCallback().
  *
+ * Each operation blocks the stream around the position it changes and waits
+ * for data to flow before the next one is applied. When several elements
+ * have to be added or removed at once, the operations can be grouped between
+ * gst_insert_bin_begin_transaction() and gst_insert_bin_commit_transaction().
+ * The stream is then blocked a single time where it enters the bin and all
+ * operations are applied in order while it is blocked.
+ *
  * Since: 1.2
  */
 
@@ -70,6 +77,8 @@ enum
   SIG_INSERT_BEFORE,
   SIG_INSERT_AFTER,
   SIG_REMOVE,
+  SIG_BEGIN_TRANSACTION,
+  SIG_COMMIT_TRANSACTION,
   LAST_SIGNAL
 };
 
@@ -86,12 +95,17 @@ struct _GstInsertBinPrivate
   GstPad *sinkpad;
 
   GQueue change_queue;
+
+  /* the batch collecting operations while a transaction is open */
+  struct ChangeData *transaction;
+  guint transaction_depth;
 };
 
 typedef enum
 {
   GST_INSERT_BIN_ACTION_ADD,
-  GST_INSERT_BIN_ACTION_REMOVE
+  GST_INSERT_BIN_ACTION_REMOVE,
+  GST_INSERT_BIN_ACTION_BATCH
 } GstInsertBinAction;
 
 
@@ -111,6 +125,12 @@ struct ChangeData
 
   GstInsertBinCallback callback;
   gpointer user_data;
+
+  /* GST_INSERT_BIN_ACTION_BATCH only */
+  GQueue batch;
+  GstClockTime timeout;
+  GstClockID timeout_id;
+  GstPad *block_pad;
 };
 
 static void gst_insert_bin_dispose (GObject * object);
@@ -119,6 +139,8 @@ static void gst_insert_bin_dispose (GObject * object);
 static void gst_insert_bin_do_change (GstInsertBin * self, GstPad * pad);
 static GstPadProbeReturn pad_blocked_cb (GstPad * pad, GstPadProbeInfo * info,
     gpointer user_data);
+static void gst_insert_bin_block_batch_unlock (GstInsertBin * self,
+    struct ChangeData *batch);
 
 G_DEFINE_TYPE_WITH_PRIVATE (GstInsertBin, gst_insert_bin, GST_TYPE_BIN);
 
@@ -244,14 +266,59 @@ gst_insert_bin_class_init (GstInsertBinClass * klass)
       G_CALLBACK (gst_insert_bin_remove),
       NULL, NULL, NULL,
       G_TYPE_NONE, 3, GST_TYPE_ELEMENT, G_TYPE_POINTER, G_TYPE_POINTER);
+
+  /**
+   * GstInsertBin::begin-transaction:
+   * @user_data2: The user data of the signal (ignored)
+   *
+   * This action signal starts grouping operations so that they get applied
+   * under a single block of the stream.
+   *
+   * Same as gst_insert_bin_begin_transaction()
+   *
+   * Since: 1.20
+   */
+  signals[SIG_BEGIN_TRANSACTION] =
+      g_signal_new_class_handler ("begin-transaction",
+      G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_CALLBACK (gst_insert_bin_begin_transaction),
+      NULL, NULL, NULL, G_TYPE_NONE, 0);
+
+  /**
+   * GstInsertBin::commit-transaction:
+   * @timeout: how long to wait for the stream to block, or
+   *  %GST_CLOCK_TIME_NONE
+   * @user_data2: The user data of the signal (ignored)
+   *
+   * This action signal applies all operations requested since the matching
+   * #GstInsertBin::begin-transaction.
+   *
+   * Same as gst_insert_bin_commit_transaction()
+   *
+   * Since: 1.20
+   */
+  signals[SIG_COMMIT_TRANSACTION] =
+      g_signal_new_class_handler ("commit-transaction",
+      G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_CALLBACK (gst_insert_bin_commit_transaction),
+      NULL, NULL, NULL, G_TYPE_NONE, 1, G_TYPE_UINT64);
 }
 
 static void
 change_data_free (struct ChangeData *data)
 {
-  gst_object_unref (data->element);
+  if (data->element)
+    gst_object_unref (data->element);
   if (data->sibling)
     gst_object_unref (data->sibling);
+  if (data->timeout_id) {
+    gst_clock_id_unschedule (data->timeout_id);
+    gst_clock_id_unref (data->timeout_id);
+  }
+  if (data->block_pad)
+    gst_object_unref (data->block_pad);
   g_slice_free (struct ChangeData, data);
 }
 
@@ -260,6 +327,11 @@ static void
 gst_insert_bin_change_data_complete (GstInsertBin * self,
     struct ChangeData *data, gboolean success)
 {
+  struct ChangeData *change;
+
+  while ((change = g_queue_pop_head (&data->batch)))
+    gst_insert_bin_change_data_complete (self, change, success);
+
   if (data->callback)
     data->callback (self, data->element, success, data->user_data);
 
@@ -297,6 +369,12 @@ gst_insert_bin_dispose (GObject * object)
   while ((data = g_queue_pop_head (&self->priv->change_queue)))
     gst_insert_bin_change_data_complete (self, data, FALSE);
 
+  if (self->priv->transaction) {
+    gst_insert_bin_change_data_complete (self, self->priv->transaction, FALSE);
+    self->priv->transaction = NULL;
+    self->priv->transaction_depth = 0;
+  }
+
   gst_ghost_pad_set_target (GST_GHOST_PAD (self->priv->srcpad), NULL);
   gst_ghost_pad_set_target (GST_GHOST_PAD (self->priv->sinkpad), NULL);
 
@@ -385,6 +463,11 @@ again:
     return;
   }
 
+  if (data->action == GST_INSERT_BIN_ACTION_BATCH) {
+    gst_insert_bin_block_batch_unlock (self, data);
+    return;
+  }
+
   if (data->action == GST_INSERT_BIN_ACTION_ADD &&
       !validate_element (self, data->element))
     goto error;
@@ -494,10 +577,13 @@ gst_insert_bin_do_change (GstInsertBin * self, GstPad * pad)
     goto next;
   }
 
-  while ((data = g_queue_pop_head (&self->priv->change_queue)) != NULL) {
+  /* Batches are applied separately once the whole bin is blocked */
+  while ((data = g_queue_peek_head (&self->priv->change_queue)) != NULL &&
+      data->action != GST_INSERT_BIN_ACTION_BATCH) {
     GstPad *peer = NULL;
     GstPad *other_peer = NULL;
 
+    g_queue_pop_head (&self->priv->change_queue);
     GST_OBJECT_UNLOCK (self);
 
 
@@ -788,13 +874,288 @@ pad_blocked_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
   return GST_PAD_PROBE_REMOVE;
 }
 
+static gboolean
+is_internal_pad_of (GstPad * pad, GstPad * ghost)
+{
+  GstPad *internal;
+  gboolean ret;
+
+  internal = (GstPad *) gst_proxy_pad_get_internal (GST_PROXY_PAD (ghost));
+  ret = (pad == internal);
+  gst_object_unref (internal);
+
+  return ret;
+}
+
+/* The ends of the chain are the internal pads of our ghost pads, those are
+ * linked by changing the target of the ghost pad instead */
+static gboolean
+gst_insert_bin_link_pads (GstInsertBin * self, GstPad * srcpad,
+    GstPad * sinkpad)
+{
+  if (is_internal_pad_of (sinkpad, self->priv->srcpad))
+    return gst_ghost_pad_set_target (GST_GHOST_PAD (self->priv->srcpad),
+        srcpad);
+  else if (is_internal_pad_of (srcpad, self->priv->sinkpad))
+    return gst_ghost_pad_set_target (GST_GHOST_PAD (self->priv->sinkpad),
+        sinkpad);
+  else
+    return GST_PAD_LINK_SUCCESSFUL (gst_pad_link (srcpad, sinkpad));
+}
+
+static GstPadProbeReturn
+drop_eos_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) != GST_EVENT_EOS)
+    return GST_PAD_PROBE_PASS;
+
+  return GST_PAD_PROBE_DROP;
+}
+
+/* Applies a single operation of a batch, nothing flows through the bin
+ * while this is called so the links can be changed directly */
+static gboolean
+gst_insert_bin_apply_batched_change (GstInsertBin * self,
+    struct ChangeData *data)
+{
+  GstPad *element_srcpad = NULL, *element_sinkpad = NULL;
+  GstPad *srcpad = NULL, *sinkpad = NULL;
+  gboolean ret = FALSE;
+
+  element_srcpad = get_single_pad (data->element, GST_PAD_SRC);
+  element_sinkpad = get_single_pad (data->element, GST_PAD_SINK);
+  if (element_srcpad == NULL || element_sinkpad == NULL) {
+    GST_WARNING_OBJECT (self, "Can not get element src or sink pad");
+    goto done;
+  }
+
+  if (data->action == GST_INSERT_BIN_ACTION_ADD) {
+    if (!validate_element (self, data->element))
+      goto done;
+
+    /* Find the link the element has to be inserted into */
+    if (data->direction == DIRECTION_BEFORE) {
+      if (data->sibling)
+        sinkpad = get_single_pad (data->sibling, GST_PAD_SINK);
+      else
+        sinkpad = (GstPad *)
+            gst_proxy_pad_get_internal (GST_PROXY_PAD (self->priv->srcpad));
+      if (sinkpad)
+        srcpad = gst_pad_get_peer (sinkpad);
+    } else {
+      if (data->sibling)
+        srcpad = get_single_pad (data->sibling, GST_PAD_SRC);
+      else
+        srcpad = (GstPad *)
+            gst_proxy_pad_get_internal (GST_PROXY_PAD (self->priv->sinkpad));
+      if (srcpad)
+        sinkpad = gst_pad_get_peer (srcpad);
+    }
+
+    if (srcpad == NULL || sinkpad == NULL) {
+      GST_WARNING_OBJECT (self, "Can not find where to insert the element");
+      goto done;
+    }
+
+    if (!gst_bin_add (GST_BIN (self), data->element)) {
+      GST_WARNING_OBJECT (self, "Can not add element to bin");
+      goto done;
+    }
+
+    gst_pad_unlink (srcpad, sinkpad);
+    if (!gst_insert_bin_link_pads (self, srcpad, element_sinkpad) ||
+        !gst_insert_bin_link_pads (self, element_srcpad, sinkpad)) {
+      GST_WARNING_OBJECT (self, "Can not link element between %s:%s and"
+          " %s:%s", GST_DEBUG_PAD_NAME (srcpad), GST_DEBUG_PAD_NAME (sinkpad));
+      gst_pad_unlink (srcpad, element_sinkpad);
+      gst_pad_unlink (element_srcpad, sinkpad);
+      gst_bin_remove (GST_BIN (self), data->element);
+      gst_insert_bin_link_pads (self, srcpad, sinkpad);
+      goto done;
+    }
+
+    if (!gst_element_sync_state_with_parent (data->element)) {
+      GST_WARNING_OBJECT (self, "Can not sync element's state with parent");
+      goto done;
+    }
+  } else {
+    GstObject *parent;
+
+    parent = gst_object_get_parent (GST_OBJECT (data->element));
+    if (parent)
+      gst_object_unref (parent);
+
+    if (parent != GST_OBJECT_CAST (self)) {
+      GST_WARNING_OBJECT (self, "Element is not in the bin anymore");
+      goto done;
+    }
+
+    srcpad = gst_pad_get_peer (element_sinkpad);
+    sinkpad = gst_pad_get_peer (element_srcpad);
+    if (srcpad == NULL || sinkpad == NULL) {
+      GST_WARNING_OBJECT (self, "Element is not linked");
+      goto done;
+    }
+
+    /* Drain the element before removing it, the stream is blocked upstream
+     * of it so the EOS can not get mixed with data */
+    if (GST_PAD_MODE (srcpad) == GST_PAD_MODE_PUSH) {
+      gulong probe_id;
+
+      probe_id = gst_pad_add_probe (element_srcpad,
+          GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, drop_eos_cb, NULL, NULL);
+      gst_pad_send_event (element_sinkpad, gst_event_new_eos ());
+      gst_pad_remove_probe (element_srcpad, probe_id);
+    }
+
+    gst_pad_unlink (srcpad, element_sinkpad);
+    gst_pad_unlink (element_srcpad, sinkpad);
+
+    gst_element_set_locked_state (data->element, TRUE);
+    gst_element_set_state (data->element, GST_STATE_NULL);
+    if (!gst_bin_remove (GST_BIN (self), data->element)) {
+      GST_WARNING_OBJECT (self, "Element removal rejected");
+      goto done;
+    }
+    gst_element_set_locked_state (data->element, FALSE);
+
+    if (!gst_insert_bin_link_pads (self, srcpad, sinkpad)) {
+      GST_ERROR_OBJECT (self, "Could not re-link after the element's"
+          " removal");
+      goto done;
+    }
+  }
+
+  ret = TRUE;
+
+done:
+  if (element_srcpad)
+    gst_object_unref (element_srcpad);
+  if (element_sinkpad)
+    gst_object_unref (element_sinkpad);
+  if (srcpad)
+    gst_object_unref (srcpad);
+  if (sinkpad)
+    gst_object_unref (sinkpad);
+
+  return ret;
+}
+
+static GstPadProbeReturn
+batch_blocked_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  GstInsertBin *self = GST_INSERT_BIN (user_data);
+  struct ChangeData *batch, *data;
+
+  GST_OBJECT_LOCK (self);
+  batch = g_queue_peek_head (&self->priv->change_queue);
+  /* The batch this probe was installed for may have timed out already */
+  if (batch == NULL || batch->action != GST_INSERT_BIN_ACTION_BATCH ||
+      batch->block_pad != pad) {
+    GST_OBJECT_UNLOCK (self);
+    return GST_PAD_PROBE_REMOVE;
+  }
+  g_queue_pop_head (&self->priv->change_queue);
+  GST_OBJECT_UNLOCK (self);
+
+  if (batch->timeout_id)
+    gst_clock_id_unschedule (batch->timeout_id);
+
+  GST_DEBUG_OBJECT (self, "Stream blocked, applying %u changes",
+      batch->batch.length);
+
+  while ((data = g_queue_pop_head (&batch->batch)))
+    gst_insert_bin_change_data_complete (self, data,
+        gst_insert_bin_apply_batched_change (self, data));
+
+  change_data_free (batch);
+
+  GST_OBJECT_LOCK (self);
+  gst_insert_bin_block_pad_unlock (self);
+
+  return GST_PAD_PROBE_REMOVE;
+}
+
+static gboolean
+batch_timeout_cb (GstClock * clock, GstClockTime time, GstClockID id,
+    gpointer user_data)
+{
+  GstInsertBin *self = GST_INSERT_BIN (user_data);
+  struct ChangeData *batch;
+
+  GST_OBJECT_LOCK (self);
+  batch = g_queue_peek_head (&self->priv->change_queue);
+  if (batch == NULL || batch->action != GST_INSERT_BIN_ACTION_BATCH ||
+      batch->timeout_id != id) {
+    GST_OBJECT_UNLOCK (self);
+    return TRUE;
+  }
+  g_queue_pop_head (&self->priv->change_queue);
+  GST_OBJECT_UNLOCK (self);
+
+  GST_WARNING_OBJECT (self, "Stream did not block in %" GST_TIME_FORMAT
+      ", dropping %u changes", GST_TIME_ARGS (batch->timeout),
+      batch->batch.length);
+
+  /* The probe is left in place, it is removed again the next time it
+   * is called */
+  gst_insert_bin_change_data_complete (self, batch, FALSE);
+
+  GST_OBJECT_LOCK (self);
+  gst_insert_bin_block_pad_unlock (self);
+
+  return TRUE;
+}
+
+/* Called with the object lock, which is released */
+static void
+gst_insert_bin_block_batch_unlock (GstInsertBin * self,
+    struct ChangeData *batch)
+{
+  GstPad *pad;
+  GstPadProbeType probetype;
+
+  /* Block where the data enters the bin, then nothing flows through any of
+   * the elements while the links are changed */
+  pad = (GstPad *)
+      gst_proxy_pad_get_internal (GST_PROXY_PAD (self->priv->sinkpad));
+  if (!is_right_direction_for_block (pad)) {
+    gst_object_unref (pad);
+    pad = (GstPad *)
+        gst_proxy_pad_get_internal (GST_PROXY_PAD (self->priv->srcpad));
+  }
+
+  if (GST_PAD_IS_SRC (pad))
+    probetype = GST_PAD_PROBE_TYPE_BLOCK_DOWNSTREAM;
+  else
+    probetype = GST_PAD_PROBE_TYPE_BLOCK_UPSTREAM;
+
+  batch->block_pad = gst_object_ref (pad);
+
+  if (GST_CLOCK_TIME_IS_VALID (batch->timeout)) {
+    GstClock *clock = gst_system_clock_obtain ();
+
+    /* Like the pad probes this doesn't hold a reference, the timeout is
+     * unscheduled when the batch is freed at the latest in dispose */
+    batch->timeout_id = gst_clock_new_single_shot_id (clock,
+        gst_clock_get_time (clock) + batch->timeout);
+    gst_clock_id_wait_async (batch->timeout_id, batch_timeout_cb, self, NULL);
+    gst_object_unref (clock);
+  }
+
+  GST_OBJECT_UNLOCK (self);
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_IDLE | probetype,
+      batch_blocked_cb, self, NULL);
+  gst_object_unref (pad);
+}
+
 static void
 gst_insert_bin_add_operation (GstInsertBin * self,
     GstElement * element, GstInsertBinAction action, GstElement * sibling,
     GstInsertBinDirection direction, GstInsertBinCallback callback,
     gpointer user_data)
 {
-  struct ChangeData *data = g_slice_new (struct ChangeData);
+  struct ChangeData *data = g_slice_new0 (struct ChangeData);
   gboolean block_pad;
 
   data->element = element;
@@ -807,6 +1168,12 @@ gst_insert_bin_add_operation (GstInsertBin * self,
   data->user_data = user_data;
 
   GST_OBJECT_LOCK (self);
+  if (self->priv->transaction) {
+    g_queue_push_tail (&self->priv->transaction->batch, data);
+    GST_OBJECT_UNLOCK (self);
+    return;
+  }
+
   block_pad = g_queue_is_empty (&self->priv->change_queue);
   g_queue_push_tail (&self->priv->change_queue, data);
 
@@ -816,6 +1183,47 @@ gst_insert_bin_add_operation (GstInsertBin * self,
     GST_OBJECT_UNLOCK (self);
 }
 
+/* Called with the object lock, removes and returns the pending addition of
+ * @element from @queue if there is one */
+static struct ChangeData *
+take_pending_add (GQueue * queue, GstElement * element)
+{
+  GList *item;
+
+  for (item = queue->head; item; item = item->next) {
+    struct ChangeData *data = item->data;
+
+    if (data->element == element) {
+      if (data->action != GST_INSERT_BIN_ACTION_ADD)
+        return NULL;
+      g_queue_delete_link (queue, item);
+      return data;
+    }
+  }
+
+  return NULL;
+}
+
+static gboolean
+is_pending_add_in_transaction (GstInsertBin * self, GstElement * element)
+{
+  gboolean pending = FALSE;
+  GList *item;
+
+  GST_OBJECT_LOCK (self);
+  if (self->priv->transaction) {
+    for (item = self->priv->transaction->batch.head; item; item = item->next) {
+      struct ChangeData *data = item->data;
+
+      if (data->element == element)
+        pending = (data->action == GST_INSERT_BIN_ACTION_ADD);
+    }
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  return pending;
+}
+
 static void
 gst_insert_bin_add (GstInsertBin * self, GstElement * element,
     GstElement * sibling, GstInsertBinDirection direction,
@@ -833,7 +1241,8 @@ gst_insert_bin_add (GstInsertBin * self, GstElement * element,
     is_parent = (GST_OBJECT_PARENT (sibling) == GST_OBJECT_CAST (self));
     GST_OBJECT_UNLOCK (sibling);
 
-    if (!is_parent)
+    /* In a transaction the sibling may be added earlier in the same batch */
+    if (!is_parent && !is_pending_add_in_transaction (self, sibling))
       goto reject;
   }
 
@@ -987,20 +1396,13 @@ gst_insert_bin_remove (GstInsertBin * self, GstElement * element,
       return;
     }
   } else {
-    GList *item;
     struct ChangeData *data = NULL;
 
     GST_OBJECT_LOCK (self);
-    for (item = self->priv->change_queue.head; item; item = item->next) {
-      data = item->data;
-
-      if (data->element == element) {
-        if (data->action == GST_INSERT_BIN_ACTION_ADD)
-          g_queue_delete_link (&self->priv->change_queue, item);
-        break;
-      }
-      data = NULL;
-    }
+    if (self->priv->transaction)
+      data = take_pending_add (&self->priv->transaction->batch, element);
+    if (!data)
+      data = take_pending_add (&self->priv->change_queue, element);
     GST_OBJECT_UNLOCK (self);
 
     if (data) {
@@ -1022,6 +1424,99 @@ gst_insert_bin_remove (GstInsertBin * self, GstElement * element,
       NULL, FALSE, callback, user_data);
 }
 
+/**
+ * gst_insert_bin_begin_transaction:
+ * @self: a #GstInsertBin
+ *
+ * Starts a transaction. All operations requested until the matching
+ * gst_insert_bin_commit_transaction() are collected and then applied
+ * together, in the order they were requested, while the stream is blocked
+ * a single time where it enters the bin. Siblings passed to
+ * gst_insert_bin_insert_before() and gst_insert_bin_insert_after() can be
+ * elements added earlier in the same transaction.
+ *
+ * Transactions can be nested, the operations are applied when the outermost
+ * one is committed.
+ *
+ * As the elements are only drained when they are removed, elements with
+ * their own streaming thread, like queue, may still be processing data when
+ * the stream is blocked. Use the individual operations for those.
+ *
+ * Same as the #GstInsertBin::begin-transaction signal.
+ *
+ * Since: 1.20
+ */
+void
+gst_insert_bin_begin_transaction (GstInsertBin * self)
+{
+  g_return_if_fail (GST_IS_INSERT_BIN (self));
+
+  GST_OBJECT_LOCK (self);
+  if (self->priv->transaction_depth++ == 0) {
+    self->priv->transaction = g_slice_new0 (struct ChangeData);
+    self->priv->transaction->action = GST_INSERT_BIN_ACTION_BATCH;
+  }
+  GST_OBJECT_UNLOCK (self);
+}
+
+/**
+ * gst_insert_bin_commit_transaction:
+ * @self: a #GstInsertBin
+ * @timeout: how long to wait for the stream to block, or
+ *  %GST_CLOCK_TIME_NONE to wait as long as needed
+ *
+ * Ends the transaction started with gst_insert_bin_begin_transaction().
+ *
+ * If the stream has not blocked after @timeout, for example because a
+ * downstream element is waiting, none of the operations are applied and all
+ * their callbacks are called with a %FALSE success.
+ *
+ * Same as the #GstInsertBin::commit-transaction signal.
+ *
+ * Since: 1.20
+ */
+void
+gst_insert_bin_commit_transaction (GstInsertBin * self, GstClockTime timeout)
+{
+  struct ChangeData *batch;
+  gboolean block_pad;
+
+  g_return_if_fail (GST_IS_INSERT_BIN (self));
+
+  GST_OBJECT_LOCK (self);
+  if (self->priv->transaction_depth == 0) {
+    GST_OBJECT_UNLOCK (self);
+    g_critical ("No transaction to commit on %s", GST_OBJECT_NAME (self));
+    return;
+  }
+
+  if (--self->priv->transaction_depth > 0) {
+    GST_OBJECT_UNLOCK (self);
+    return;
+  }
+
+  batch = self->priv->transaction;
+  self->priv->transaction = NULL;
+
+  if (g_queue_is_empty (&batch->batch)) {
+    GST_OBJECT_UNLOCK (self);
+    change_data_free (batch);
+    return;
+  }
+
+  GST_DEBUG_OBJECT (self, "Committing %u changes with timeout %"
+      GST_TIME_FORMAT, batch->batch.length, GST_TIME_ARGS (timeout));
+
+  batch->timeout = timeout;
+  block_pad = g_queue_is_empty (&self->priv->change_queue);
+  g_queue_push_tail (&self->priv->change_queue, batch);
+
+  if (block_pad)
+    gst_insert_bin_block_pad_unlock (self);
+  else
+    GST_OBJECT_UNLOCK (self);
+}
+
 /**
  * gst_insert_bin_new:
  * @name: (allow-none): The name of the new #GstInsertBin element (or %NULL)
@@ -120,6 +120,13 @@ GST_INSERT_BIN_API
 void gst_insert_bin_remove (GstInsertBin * self, GstElement * element,
     GstInsertBinCallback callback, gpointer user_data);
 
+GST_INSERT_BIN_API
+void gst_insert_bin_begin_transaction (GstInsertBin * self);
+
+GST_INSERT_BIN_API
+void gst_insert_bin_commit_transaction (GstInsertBin * self,
+    GstClockTime timeout);
+
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GstInsertBin, gst_object_unref)
 
@@ -559,6 +559,121 @@ gst_isoff_moof_box_free (GstMoofBox * moof)
   g_free (moof);
 }
 
+/* gst_isoff_moof_box_get_samples:
+ * @moof: a parsed moof box
+ * @moof_offset: byte offset of the moof box in the stream
+ *
+ * Resolves offset, size, timing and flags of all samples of all track
+ * fragment runs of @moof, falling back to the tfhd defaults for values
+ * that are not part of the run.
+ *
+ * Returns: #GArray of #GstIsoffSample in decode order, or %NULL if the
+ * sample sizes are only given by the trex box of the moov
+ */
+GArray *
+gst_isoff_moof_box_get_samples (GstMoofBox * moof, guint64 moof_offset)
+{
+  GArray *samples;
+  guint64 prev_traf_end = moof_offset;
+  guint i;
+
+  g_return_val_if_fail (moof != NULL, NULL);
+
+  INITIALIZE_DEBUG_CATEGORY;
+  samples = g_array_new (FALSE, FALSE, sizeof (GstIsoffSample));
+
+  for (i = 0; i < moof->traf->len; i++) {
+    GstTrafBox *traf = &g_array_index (moof->traf, GstTrafBox, i);
+    GstTfhdBox *tfhd = &traf->tfhd;
+    guint64 traf_offset, prev_trun_end;
+    guint64 decode_time = traf->tfdt.decode_time;
+    guint j;
+
+    if (tfhd->flags & GST_TFHD_FLAGS_BASE_DATA_OFFSET_PRESENT)
+      traf_offset = tfhd->base_data_offset;
+    else if (tfhd->flags & GST_TFHD_FLAGS_DEFAULT_BASE_IS_MOOF)
+      traf_offset = moof_offset;
+    else
+      traf_offset = prev_traf_end;
+
+    prev_trun_end = traf_offset;
+
+    for (j = 0; j < traf->trun->len; j++) {
+      GstTrunBox *trun = &g_array_index (traf->trun, GstTrunBox, j);
+      guint64 offset;
+      guint k;
+
+      if (trun->flags & GST_TRUN_FLAGS_DATA_OFFSET_PRESENT)
+        offset = traf_offset + trun->data_offset;
+      else
+        offset = prev_trun_end;
+
+      for (k = 0; k < trun->samples->len; k++) {
+        GstTrunSample *trun_sample =
+            &g_array_index (trun->samples, GstTrunSample, k);
+        GstIsoffSample sample = { 0, };
+
+        sample.track_id = tfhd->track_id;
+        sample.offset = offset;
+
+        if (trun->flags & GST_TRUN_FLAGS_SAMPLE_SIZE_PRESENT) {
+          sample.size = trun_sample->sample_size;
+        } else if (tfhd->flags & GST_TFHD_FLAGS_DEFAULT_SAMPLE_SIZE_PRESENT) {
+          sample.size = tfhd->default_sample_size;
+        } else {
+          GST_DEBUG ("Sample size given by trex");
+          g_array_free (samples, TRUE);
+          return NULL;
+        }
+
+        if (trun->flags & GST_TRUN_FLAGS_SAMPLE_DURATION_PRESENT)
+          sample.duration = trun_sample->sample_duration;
+        else if (tfhd->flags & GST_TFHD_FLAGS_DEFAULT_SAMPLE_DURATION_PRESENT)
+          sample.duration = tfhd->default_sample_duration;
+
+        if (trun->flags & GST_TRUN_FLAGS_SAMPLE_FLAGS_PRESENT) {
+          sample.flags = trun_sample->sample_flags;
+          sample.has_flags = TRUE;
+        } else if ((trun->flags & GST_TRUN_FLAGS_FIRST_SAMPLE_FLAGS_PRESENT)
+            && k == 0) {
+          sample.flags = trun->first_sample_flags;
+          sample.has_flags = TRUE;
+        } else if (tfhd->flags & GST_TFHD_FLAGS_DEFAULT_SAMPLE_FLAGS_PRESENT) {
+          sample.flags = tfhd->default_sample_flags;
+          sample.has_flags = TRUE;
+        }
+
+        if (trun->flags &
+            GST_TRUN_FLAGS_SAMPLE_COMPOSITION_TIME_OFFSETS_PRESENT) {
+          if (trun->version == 0)
+            sample.composition_time_offset =
+                trun_sample->sample_composition_time_offset.u;
+          else
+            sample.composition_time_offset =
+                trun_sample->sample_composition_time_offset.s;
+        }
+
+        /* Without a duration the decode times of all following samples are
+         * unknown */
+        sample.decode_time = decode_time;
+        if (decode_time != GST_CLOCK_TIME_NONE)
+          decode_time =
+              sample.duration ? decode_time +
+              sample.duration : GST_CLOCK_TIME_NONE;
+
+        offset += sample.size;
+        g_array_append_val (samples, sample);
+      }
+
+      prev_trun_end = offset;
+    }
+
+    prev_traf_end = prev_trun_end;
+  }
+
+  return samples;
+}
+
 static gboolean
 gst_isoff_mdhd_box_parse (GstMdhdBox * mdhd, GstByteReader * reader)
 {
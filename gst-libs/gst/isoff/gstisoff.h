@@ -196,6 +196,29 @@ GstMoofBox * gst_isoff_moof_box_parse (GstByteReader *reader);
 GST_ISOFF_API
 void gst_isoff_moof_box_free (GstMoofBox *moof);
 
+/* A sample of a movie fragment with all values resolved */
+typedef struct _GstIsoffSample
+{
+  guint32 track_id;
+
+  /* absolute byte offset of the sample data */
+  guint64 offset;
+  guint32 size;
+
+  /* in track timescale, GST_CLOCK_TIME_NONE without tfdt */
+  guint64 decode_time;
+  /* 0 if only given by the trex box */
+  guint32 duration;
+  gint64 composition_time_offset;
+
+  /* FALSE if the flags are only given by the trex box */
+  gboolean has_flags;
+  guint32 flags;
+} GstIsoffSample;
+
+GST_ISOFF_API
+GArray * gst_isoff_moof_box_get_samples (GstMoofBox *moof, guint64 moof_offset);
+
 typedef struct _GstTkhdBox
 {
   guint32 track_id;
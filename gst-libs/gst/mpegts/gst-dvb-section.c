@@ -309,6 +309,122 @@ gst_mpegts_section_get_eit (GstMpegtsSection * section)
   return (const GstMpegtsEIT *) section->cached_parsed;
 }
 
+/**
+ * gst_mpegts_section_eit_event_iter_init:
+ * @section: a #GstMpegtsSection of type %GST_MPEGTS_SECTION_EIT
+ * @iter: (out caller-allocates): a #GstMpegtsEITEventIter to initialize
+ *
+ * Initializes @iter to walk the events of @section with
+ * gst_mpegts_eit_event_iter_next(), directly on the section data. This is
+ * cheaper than gst_mpegts_section_get_eit() when only a few fields of the
+ * events are needed, as nothing gets allocated or copied.
+ *
+ * Returns: %TRUE if @iter could be initialized, %FALSE if the section is
+ * too small or corrupted.
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_mpegts_section_eit_event_iter_init (GstMpegtsSection * section,
+    GstMpegtsEITEventIter * iter)
+{
+  g_return_val_if_fail (section->section_type == GST_MPEGTS_SECTION_EIT,
+      FALSE);
+  g_return_val_if_fail (section->data, FALSE);
+  g_return_val_if_fail (iter != NULL, FALSE);
+
+  iter->data = iter->end = NULL;
+
+  if (section->section_length < 18) {
+    GST_WARNING ("PID:0x%04x table_id:0x%02x, section too small (Got %d)",
+        section->pid, section->table_id, section->section_length);
+    return FALSE;
+  }
+
+  /* a cached parsed table means the CRC was already checked */
+  if (!section->cached_parsed && !section->short_section
+      && _calc_crc32 (section->data, section->section_length) != 0) {
+    GST_WARNING ("PID:0x%04x table_id:0x%02x, Bad CRC on section", section->pid,
+        section->table_id);
+    return FALSE;
+  }
+
+  iter->data = section->data + 14;
+  iter->end = section->data + section->section_length - 4;
+
+  return TRUE;
+}
+
+/**
+ * gst_mpegts_eit_event_iter_next:
+ * @iter: a #GstMpegtsEITEventIter
+ * @event_id: (out) (optional): the event identifier
+ * @duration: (out) (optional): the duration of the event in seconds
+ * @running_status: (out) (optional): the running status of the event
+ * @free_CA_mode: (out) (optional): %TRUE if the event is scrambled
+ * @descriptors: (out caller-allocates) (optional): a
+ * #GstMpegtsDescriptorIter initialized on the descriptors of the event
+ *
+ * Goes to the next event of the EIT section @iter was initialized with.
+ * @descriptors points into the section data, the section has to stay
+ * alive while it is used.
+ *
+ * Returns: %TRUE if there was a valid event, %FALSE at the end of the
+ * events or if the remaining data is corrupted.
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_mpegts_eit_event_iter_next (GstMpegtsEITEventIter * iter,
+    guint16 * event_id, guint32 * duration,
+    GstMpegtsRunningStatus * running_status, gboolean * free_CA_mode,
+    GstMpegtsDescriptorIter * descriptors)
+{
+  const guint8 *data, *duration_ptr;
+  guint16 descriptors_loop_length;
+
+  g_return_val_if_fail (iter != NULL, FALSE);
+
+  data = iter->data;
+  if (data == NULL || data >= iter->end)
+    return FALSE;
+
+  /* 12 is the minimum entry size */
+  if (iter->end - data < 12)
+    goto invalid;
+
+  descriptors_loop_length = GST_READ_UINT16_BE (data + 10) & 0x0FFF;
+  if (iter->end - data - 12 < descriptors_loop_length)
+    goto invalid;
+
+  if (event_id)
+    *event_id = GST_READ_UINT16_BE (data);
+  if (duration) {
+    duration_ptr = data + 7;
+    *duration = (((duration_ptr[0] & 0xF0) >> 4) * 10 +
+        (duration_ptr[0] & 0x0F)) * 60 * 60 +
+        (((duration_ptr[1] & 0xF0) >> 4) * 10 +
+        (duration_ptr[1] & 0x0F)) * 60 +
+        ((duration_ptr[2] & 0xF0) >> 4) * 10 + (duration_ptr[2] & 0x0F);
+  }
+  if (running_status)
+    *running_status = data[10] >> 5;
+  if (free_CA_mode)
+    *free_CA_mode = (data[10] >> 4) & 0x01;
+  if (descriptors)
+    gst_mpegts_descriptor_iter_init (descriptors, data + 12,
+        descriptors_loop_length);
+
+  iter->data = data + 12 + descriptors_loop_length;
+
+  return TRUE;
+
+invalid:
+  GST_WARNING ("invalid EIT entry length %d", (gint) (iter->end - data));
+  iter->data = iter->end;
+  return FALSE;
+}
+
 /* Bouquet Association Table */
 static GstMpegtsBATStream *
 _gst_mpegts_bat_stream_copy (GstMpegtsBATStream * bat)
@@ -404,6 +404,35 @@ GType gst_mpegts_eit_event_get_type (void);
 GST_MPEGTS_API
 const GstMpegtsEIT *gst_mpegts_section_get_eit (GstMpegtsSection *section);
 
+/**
+ * GstMpegtsEITEventIter:
+ *
+ * Iterator over the events of an EIT section, see
+ * gst_mpegts_section_eit_event_iter_init().
+ *
+ * Since: 1.20
+ */
+typedef struct
+{
+  /*< private >*/
+  const guint8 *data;
+  const guint8 *end;
+
+  gpointer _gst_reserved[GST_PADDING];
+} GstMpegtsEITEventIter;
+
+GST_MPEGTS_API
+gboolean gst_mpegts_section_eit_event_iter_init (GstMpegtsSection *section,
+						 GstMpegtsEITEventIter *iter);
+
+GST_MPEGTS_API
+gboolean gst_mpegts_eit_event_iter_next (GstMpegtsEITEventIter *iter,
+					 guint16 *event_id,
+					 guint32 *duration,
+					 GstMpegtsRunningStatus *running_status,
+					 gboolean *free_CA_mode,
+					 GstMpegtsDescriptorIter *descriptors);
+
 /* TDT */
 
 GST_MPEGTS_API
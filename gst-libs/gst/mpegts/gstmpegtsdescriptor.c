@@ -806,6 +806,79 @@ gst_mpegts_parse_descriptors (guint8 * buffer, gsize buf_len)
   return res;
 }
 
+/**
+ * gst_mpegts_descriptor_iter_init:
+ * @iter: (out caller-allocates): a #GstMpegtsDescriptorIter to initialize
+ * @buffer: (transfer none) (array length=buf_len): descriptors to iterate
+ * @buf_len: Size of @buffer
+ *
+ * Initializes @iter to walk the descriptor loop contained in @buffer with
+ * gst_mpegts_descriptor_iter_next(). Contrary to
+ * gst_mpegts_parse_descriptors() this neither allocates nor copies
+ * anything, @buffer has to stay valid while @iter is used.
+ *
+ * Since: 1.20
+ */
+void
+gst_mpegts_descriptor_iter_init (GstMpegtsDescriptorIter * iter,
+    const guint8 * buffer, gsize buf_len)
+{
+  g_return_if_fail (iter != NULL);
+  g_return_if_fail (buffer != NULL || buf_len == 0);
+
+  iter->data = buffer;
+  iter->end = buffer + buf_len;
+}
+
+/**
+ * gst_mpegts_descriptor_iter_next:
+ * @iter: a #GstMpegtsDescriptorIter
+ * @descriptor: (out caller-allocates): the next descriptor
+ *
+ * Fills @descriptor with the next descriptor of the loop. The data of
+ * @descriptor points into the buffer @iter was initialized with, it must
+ * not be freed with gst_mpegts_descriptor_free() and can be passed to the
+ * descriptor parsing functions as is.
+ *
+ * Returns: %TRUE if @descriptor was filled, %FALSE at the end of the loop
+ * or if the remaining data doesn't contain a valid descriptor.
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_mpegts_descriptor_iter_next (GstMpegtsDescriptorIter * iter,
+    GstMpegtsDescriptor * descriptor)
+{
+  const guint8 *data;
+  guint8 length;
+
+  g_return_val_if_fail (iter != NULL, FALSE);
+  g_return_val_if_fail (descriptor != NULL, FALSE);
+
+  data = iter->data;
+  if (data == NULL || data >= iter->end)
+    return FALSE;
+
+  if (iter->end - data < 2 || iter->end - data - 2 < data[1]) {
+    GST_WARNING ("invalid descriptor at %p, %d bytes left", data,
+        (gint) (iter->end - data));
+    iter->data = iter->end;
+    return FALSE;
+  }
+
+  length = data[1];
+  descriptor->tag = data[0];
+  descriptor->tag_extension = 0;
+  if (G_UNLIKELY (descriptor->tag == 0x7f && length > 0))
+    descriptor->tag_extension = data[2];
+  descriptor->length = length;
+  descriptor->data = (guint8 *) data;
+
+  iter->data = data + 2 + length;
+
+  return TRUE;
+}
+
 /**
  * gst_mpegts_find_descriptor:
  * @descriptors: (element-type GstMpegtsDescriptor) (transfer none): an array
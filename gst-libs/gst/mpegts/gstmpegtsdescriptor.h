@@ -205,6 +205,32 @@ void       gst_mpegts_descriptor_free (GstMpegtsDescriptor *desc);
 GST_MPEGTS_API
 GPtrArray *gst_mpegts_parse_descriptors (guint8 * buffer, gsize buf_len);
 
+/**
+ * GstMpegtsDescriptorIter:
+ *
+ * Iterator over the descriptors of a raw descriptor loop, see
+ * gst_mpegts_descriptor_iter_init().
+ *
+ * Since: 1.20
+ */
+typedef struct
+{
+  /*< private >*/
+  const guint8 *data;
+  const guint8 *end;
+
+  gpointer _gst_reserved[GST_PADDING];
+} GstMpegtsDescriptorIter;
+
+GST_MPEGTS_API
+void       gst_mpegts_descriptor_iter_init (GstMpegtsDescriptorIter *iter,
+					    const guint8 *buffer,
+					    gsize buf_len);
+
+GST_MPEGTS_API
+gboolean   gst_mpegts_descriptor_iter_next (GstMpegtsDescriptorIter *iter,
+					    GstMpegtsDescriptor *descriptor);
+
 GST_MPEGTS_API
 const GstMpegtsDescriptor * gst_mpegts_find_descriptor (GPtrArray *descriptors,
 							guint8 tag);
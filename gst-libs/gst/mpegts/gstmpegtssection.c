@@ -151,16 +151,49 @@ static const guint32 crc_tab[256] = {
   0xbcb4666d, 0xb8757bda, 0xb5365d03, 0xb1f740b4
 };
 
+/* Tables for processing 8 bytes at a time ("slice-by-8"). crc_tab8[k][i] is
+ * the CRC of byte i followed by k zero bytes, crc_tab8[0] being crc_tab */
+static guint32 crc_tab8[8][256];
+
+static gpointer
+_init_crc_tab8 (gpointer data)
+{
+  guint i, k;
+
+  for (i = 0; i < 256; i++)
+    crc_tab8[0][i] = crc_tab[i];
+
+  for (k = 1; k < 8; k++) {
+    for (i = 0; i < 256; i++)
+      crc_tab8[k][i] =
+          (crc_tab8[k - 1][i] << 8) ^ crc_tab[crc_tab8[k - 1][i] >> 24];
+  }
+
+  return NULL;
+}
+
 /* _calc_crc32 relicensed to LGPL from fluendo ts demuxer */
 guint32
 _calc_crc32 (const guint8 * data, guint datalen)
 {
-  gint i;
+  static GOnce once = G_ONCE_INIT;
   guint32 crc = 0xffffffff;
 
-  for (i = 0; i < datalen; i++) {
-    crc = (crc << 8) ^ crc_tab[((crc >> 24) ^ *data++) & 0xff];
+  g_once (&once, _init_crc_tab8, NULL);
+
+  while (datalen >= 8) {
+    crc ^= GST_READ_UINT32_BE (data);
+    crc = crc_tab8[7][crc >> 24] ^ crc_tab8[6][(crc >> 16) & 0xff] ^
+        crc_tab8[5][(crc >> 8) & 0xff] ^ crc_tab8[4][crc & 0xff] ^
+        crc_tab8[3][data[4]] ^ crc_tab8[2][data[5]] ^
+        crc_tab8[1][data[6]] ^ crc_tab8[0][data[7]];
+    data += 8;
+    datalen -= 8;
   }
+
+  while (datalen--)
+    crc = (crc << 8) ^ crc_tab[((crc >> 24) ^ *data++) & 0xff];
+
   return crc;
 }
 
@@ -0,0 +1,283 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* A memory holding a video frame both in host memory and as a cv::UMat,
+ * which OpenCV may keep on an OpenCL device. Each copy is only synchronized
+ * from the other one when it is accessed, so a chain of OpenCV elements
+ * working on UMats never goes through host memory, while any other element
+ * mapping the memory transparently gets the up to date pixels. */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+
+#include "gstopencvumatmemory.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_opencv_umat_memory_debug);
+#define GST_CAT_DEFAULT gst_opencv_umat_memory_debug
+
+typedef struct
+{
+  GstMemory mem;
+
+  GMutex lock;
+  /* the frame in host memory, laid out as described by info */
+  guint8 *data;
+  GstVideoInfo info;
+  cv::UMat *umat;
+  /* which of the two copies are up to date */
+  gboolean host_valid;
+  gboolean device_valid;
+} GstOpencvUMatMemory;
+
+typedef struct
+{
+  GstAllocator parent;
+} GstOpencvUMatAllocator;
+
+typedef struct
+{
+  GstAllocatorClass parent_class;
+} GstOpencvUMatAllocatorClass;
+
+GType gst_opencv_umat_allocator_get_type (void);
+G_DEFINE_TYPE (GstOpencvUMatAllocator, gst_opencv_umat_allocator,
+    GST_TYPE_ALLOCATOR);
+
+static GstAllocator *_umat_allocator;
+
+static inline cv::Mat
+gst_opencv_umat_memory_host_mat (GstOpencvUMatMemory * mem)
+{
+  return cv::Mat (GST_VIDEO_INFO_HEIGHT (&mem->info),
+      GST_VIDEO_INFO_WIDTH (&mem->info), mem->umat->type (), mem->data,
+      GST_VIDEO_INFO_PLANE_STRIDE (&mem->info, 0));
+}
+
+static gpointer
+gst_opencv_umat_memory_map (GstMemory * gmem, gsize maxsize, GstMapFlags flags)
+{
+  GstOpencvUMatMemory *mem = (GstOpencvUMatMemory *) gmem;
+
+  g_mutex_lock (&mem->lock);
+  if (!mem->host_valid) {
+    cv::Mat host = gst_opencv_umat_memory_host_mat (mem);
+
+    GST_LOG ("downloading %p", mem);
+    mem->umat->copyTo (host);
+    mem->host_valid = TRUE;
+  }
+  if (flags & GST_MAP_WRITE)
+    mem->device_valid = FALSE;
+  g_mutex_unlock (&mem->lock);
+
+  return mem->data;
+}
+
+static void
+gst_opencv_umat_memory_unmap (GstMemory * gmem)
+{
+}
+
+static GstMemory *
+gst_opencv_umat_memory_copy (GstMemory * gmem, gssize offset, gssize size)
+{
+  GstMemory *copy;
+  GstMapInfo in, out;
+
+  if (size == -1)
+    size = gmem->size > (gsize) offset ? gmem->size - offset : 0;
+
+  copy = gst_allocator_alloc (NULL, size, NULL);
+
+  if (gst_memory_map (gmem, &in, GST_MAP_READ)) {
+    if (gst_memory_map (copy, &out, GST_MAP_WRITE)) {
+      memcpy (out.data, in.data + offset, size);
+      gst_memory_unmap (copy, &out);
+    }
+    gst_memory_unmap (gmem, &in);
+  }
+
+  return copy;
+}
+
+static GstMemory *
+gst_opencv_umat_memory_share (GstMemory * gmem, gssize offset, gssize size)
+{
+  return NULL;
+}
+
+static GstMemory *
+gst_opencv_umat_allocator_alloc (GstAllocator * allocator, gsize size,
+    GstAllocationParams * params)
+{
+  g_warning ("use gst_opencv_umat_memory_new () to allocate from this "
+      "allocator");
+
+  return NULL;
+}
+
+static void
+gst_opencv_umat_allocator_free (GstAllocator * allocator, GstMemory * gmem)
+{
+  GstOpencvUMatMemory *mem = (GstOpencvUMatMemory *) gmem;
+
+  delete mem->umat;
+  g_free (mem->data);
+  g_mutex_clear (&mem->lock);
+  g_slice_free (GstOpencvUMatMemory, mem);
+}
+
+static void
+gst_opencv_umat_allocator_class_init (GstOpencvUMatAllocatorClass * klass)
+{
+  GstAllocatorClass *allocator_class = (GstAllocatorClass *) klass;
+
+  allocator_class->alloc = gst_opencv_umat_allocator_alloc;
+  allocator_class->free = gst_opencv_umat_allocator_free;
+}
+
+static void
+gst_opencv_umat_allocator_init (GstOpencvUMatAllocator * allocator)
+{
+  GstAllocator *alloc = GST_ALLOCATOR_CAST (allocator);
+
+  alloc->mem_type = GST_OPENCV_UMAT_MEMORY_TYPE;
+  alloc->mem_map = gst_opencv_umat_memory_map;
+  alloc->mem_unmap = gst_opencv_umat_memory_unmap;
+  alloc->mem_copy = gst_opencv_umat_memory_copy;
+  alloc->mem_share = gst_opencv_umat_memory_share;
+
+  GST_OBJECT_FLAG_SET (allocator, GST_ALLOCATOR_FLAG_CUSTOM_ALLOC);
+}
+
+static GstAllocator *
+gst_opencv_umat_allocator_get (void)
+{
+  static gsize _init = 0;
+
+  if (g_once_init_enter (&_init)) {
+    GST_DEBUG_CATEGORY_INIT (gst_opencv_umat_memory_debug, "opencvumatmemory",
+        0, "OpenCV UMat memory");
+
+    _umat_allocator = (GstAllocator *)
+        g_object_new (gst_opencv_umat_allocator_get_type (), NULL);
+    gst_object_ref_sink (_umat_allocator);
+    GST_OBJECT_FLAG_SET (_umat_allocator, GST_OBJECT_FLAG_MAY_BE_LEAKED);
+
+    g_once_init_leave (&_init, 1);
+  }
+
+  return _umat_allocator;
+}
+
+static GstOpencvUMatMemory *
+gst_opencv_umat_memory_alloc (const GstVideoInfo * info, int cv_type)
+{
+  GstOpencvUMatMemory *mem = g_slice_new0 (GstOpencvUMatMemory);
+  gsize size = GST_VIDEO_INFO_SIZE (info);
+
+  gst_memory_init (GST_MEMORY_CAST (mem), GST_MEMORY_FLAG_NO_SHARE,
+      gst_opencv_umat_allocator_get (), NULL, size, 0, 0, size);
+
+  g_mutex_init (&mem->lock);
+  mem->info = *info;
+  mem->data = (guint8 *) g_malloc (size);
+  mem->umat = new cv::UMat (GST_VIDEO_INFO_HEIGHT (info),
+      GST_VIDEO_INFO_WIDTH (info), cv_type);
+
+  return mem;
+}
+
+/* a new memory for a frame of @info, whose content is to be written to its
+ * UMat */
+GstMemory *
+gst_opencv_umat_memory_new (const GstVideoInfo * info, int cv_type)
+{
+  GstOpencvUMatMemory *mem = gst_opencv_umat_memory_alloc (info, cv_type);
+
+  mem->device_valid = TRUE;
+
+  return GST_MEMORY_CAST (mem);
+}
+
+/* a new memory holding a copy of @frame; it is uploaded to the UMat on first
+ * use */
+GstMemory *
+gst_opencv_umat_memory_new_from_frame (GstVideoFrame * frame, int cv_type)
+{
+  GstOpencvUMatMemory *mem;
+  GstVideoInfo info;
+  const guint8 *src = (const guint8 *) GST_VIDEO_FRAME_PLANE_DATA (frame, 0);
+  gint frame_stride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
+  gint stride, y;
+
+  /* the frame may have a custom layout, the memory uses the default one */
+  gst_video_info_set_format (&info, GST_VIDEO_FRAME_FORMAT (frame),
+      GST_VIDEO_FRAME_WIDTH (frame), GST_VIDEO_FRAME_HEIGHT (frame));
+  mem = gst_opencv_umat_memory_alloc (&info, cv_type);
+  stride = GST_VIDEO_INFO_PLANE_STRIDE (&info, 0);
+
+  for (y = 0; y < GST_VIDEO_FRAME_HEIGHT (frame); y++)
+    memcpy (mem->data + y * stride, src + y * frame_stride,
+        MIN (stride, frame_stride));
+
+  mem->host_valid = TRUE;
+
+  return GST_MEMORY_CAST (mem);
+}
+
+/* whether @mem is a UMat memory holding a frame of @info */
+gboolean
+gst_is_opencv_umat_memory (GstMemory * mem, const GstVideoInfo * info,
+    int cv_type)
+{
+  GstOpencvUMatMemory *umem = (GstOpencvUMatMemory *) mem;
+
+  if (!gst_memory_is_type (mem, GST_OPENCV_UMAT_MEMORY_TYPE))
+    return FALSE;
+
+  return GST_VIDEO_INFO_WIDTH (&umem->info) == GST_VIDEO_INFO_WIDTH (info) &&
+      GST_VIDEO_INFO_HEIGHT (&umem->info) == GST_VIDEO_INFO_HEIGHT (info) &&
+      umem->umat->type () == cv_type && mem->offset == 0;
+}
+
+/* the UMat of @mem, uploaded from host memory first if that is where the
+ * latest content is. With GST_MAP_WRITE, the host copy is then considered
+ * outdated. */
+cv::UMat &
+gst_opencv_umat_memory_get_umat (GstMemory * gmem, GstMapFlags flags)
+{
+  GstOpencvUMatMemory *mem = (GstOpencvUMatMemory *) gmem;
+
+  g_mutex_lock (&mem->lock);
+  if (!mem->device_valid) {
+    cv::Mat host = gst_opencv_umat_memory_host_mat (mem);
+
+    GST_LOG ("uploading %p", mem);
+    host.copyTo (*mem->umat);
+    mem->device_valid = TRUE;
+  }
+  if (flags & GST_MAP_WRITE)
+    mem->host_valid = FALSE;
+  g_mutex_unlock (&mem->lock);
+
+  return *mem->umat;
+}
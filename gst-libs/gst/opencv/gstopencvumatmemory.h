@@ -0,0 +1,49 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_OPENCV_UMAT_MEMORY_H__
+#define __GST_OPENCV_UMAT_MEMORY_H__
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include <opencv2/core.hpp>
+
+G_BEGIN_DECLS
+
+#define GST_OPENCV_UMAT_MEMORY_TYPE "OpencvUMat"
+
+G_GNUC_INTERNAL
+GstMemory * gst_opencv_umat_memory_new            (const GstVideoInfo * info,
+                                                   int cv_type);
+
+G_GNUC_INTERNAL
+GstMemory * gst_opencv_umat_memory_new_from_frame (GstVideoFrame * frame,
+                                                   int cv_type);
+
+G_GNUC_INTERNAL
+gboolean    gst_is_opencv_umat_memory             (GstMemory * mem,
+                                                   const GstVideoInfo * info,
+                                                   int cv_type);
+
+G_GNUC_INTERNAL
+cv::UMat &  gst_opencv_umat_memory_get_umat       (GstMemory * mem,
+                                                   GstMapFlags flags);
+
+G_END_DECLS
+
+#endif /* __GST_OPENCV_UMAT_MEMORY_H__ */
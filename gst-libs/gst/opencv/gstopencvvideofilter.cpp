@@ -50,6 +50,7 @@
 
 #include "gstopencvvideofilter.h"
 #include "gstopencvutils.h"
+#include "gstopencvumatmemory.h"
 #include <opencv2/core.hpp>
 
 GST_DEBUG_CATEGORY_STATIC (gst_opencv_video_filter_debug);
@@ -64,9 +65,12 @@ enum
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_USE_OPENCL
 };
 
+#define DEFAULT_USE_OPENCL FALSE
+
 #define parent_class gst_opencv_video_filter_parent_class
 G_DEFINE_ABSTRACT_TYPE (GstOpencvVideoFilter, gst_opencv_video_filter,
     GST_TYPE_VIDEO_FILTER);
@@ -85,6 +89,13 @@ static gboolean gst_opencv_video_filter_set_info (GstVideoFilter * trans,
     GstCaps * incaps, GstVideoInfo * in_info, GstCaps * outcaps,
     GstVideoInfo * out_info);
 
+static GstFlowReturn gst_opencv_video_filter_prepare_output_buffer
+    (GstBaseTransform * trans, GstBuffer * inbuf, GstBuffer ** outbuf);
+static GstFlowReturn gst_opencv_video_filter_transform (GstBaseTransform *
+    trans, GstBuffer * inbuf, GstBuffer * outbuf);
+static GstFlowReturn gst_opencv_video_filter_transform_ip (GstBaseTransform *
+    trans, GstBuffer * buf);
+
 /* Clean up */
 static void
 gst_opencv_video_filter_finalize (GObject * obj)
@@ -101,9 +112,11 @@ static void
 gst_opencv_video_filter_class_init (GstOpencvVideoFilterClass * klass)
 {
   GObjectClass *gobject_class;
+  GstBaseTransformClass *trans_class;
   GstVideoFilterClass *vfilter_class;
 
   gobject_class = (GObjectClass *) klass;
+  trans_class = (GstBaseTransformClass *) klass;
   vfilter_class = (GstVideoFilterClass *) klass;
 
   GST_DEBUG_CATEGORY_INIT (gst_opencv_video_filter_debug,
@@ -114,6 +127,28 @@ gst_opencv_video_filter_class_init (GstOpencvVideoFilterClass * klass)
   gobject_class->set_property = gst_opencv_video_filter_set_property;
   gobject_class->get_property = gst_opencv_video_filter_get_property;
 
+  /**
+   * GstOpencvVideoFilter:use-opencl:
+   *
+   * Process the frames as cv::UMat, letting OpenCV run the element on an
+   * OpenCL device when one is available. The frames are kept on the device
+   * between consecutive elements using this mode, and only copied back to
+   * host memory when something else accesses them. Elements without UMat
+   * support ignore this property.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_USE_OPENCL,
+      g_param_spec_boolean ("use-opencl", "Use OpenCL",
+          "Process frames as cv::UMat, with OpenCL acceleration when "
+          "available", DEFAULT_USE_OPENCL,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+  trans_class->prepare_output_buffer =
+      gst_opencv_video_filter_prepare_output_buffer;
+  trans_class->transform = gst_opencv_video_filter_transform;
+  trans_class->transform_ip = gst_opencv_video_filter_transform_ip;
+
   vfilter_class->transform_frame = gst_opencv_video_filter_transform_frame;
   vfilter_class->transform_frame_ip =
       gst_opencv_video_filter_transform_frame_ip;
@@ -123,6 +158,184 @@ gst_opencv_video_filter_class_init (GstOpencvVideoFilterClass * klass)
 static void
 gst_opencv_video_filter_init (GstOpencvVideoFilter * transform)
 {
+  transform->use_opencl = DEFAULT_USE_OPENCL;
+}
+
+/* whether the current buffer goes through the UMat functions */
+static gboolean
+gst_opencv_video_filter_use_umat (GstOpencvVideoFilter * transform,
+    gboolean in_place)
+{
+  GstOpencvVideoFilterClass *fclass =
+      GST_OPENCV_VIDEO_FILTER_GET_CLASS (transform);
+
+  if (!g_atomic_int_get (&transform->use_opencl) ||
+      !GST_VIDEO_FILTER (transform)->negotiated ||
+      gst_base_transform_is_passthrough (GST_BASE_TRANSFORM (transform)))
+    return FALSE;
+
+  return in_place ? fclass->cv_trans_ip_umat_func != NULL :
+      fclass->cv_trans_umat_func != NULL;
+}
+
+/* the UMat memory holding the frame of @buf, which is either already one or
+ * a new one uploaded from it */
+static GstMemory *
+gst_opencv_video_filter_get_umat_memory (GstOpencvVideoFilter * transform,
+    GstBuffer * buf, GstVideoInfo * info, int cv_type)
+{
+  GstVideoFrame frame;
+  GstMemory *mem;
+
+  if (gst_buffer_n_memory (buf) == 1) {
+    mem = gst_buffer_peek_memory (buf, 0);
+    if (gst_is_opencv_umat_memory (mem, info, cv_type))
+      return gst_memory_ref (mem);
+  }
+
+  if (!gst_video_frame_map (&frame, info, buf, GST_MAP_READ))
+    return NULL;
+  mem = gst_opencv_umat_memory_new_from_frame (&frame, cv_type);
+  gst_video_frame_unmap (&frame);
+
+  return mem;
+}
+
+/* makes @mem the only memory of @buf, it has the default layout for the
+ * negotiated caps */
+static void
+gst_opencv_video_filter_set_umat_memory (GstBuffer * buf, GstMemory * mem,
+    GstVideoInfo * info)
+{
+  GstVideoMeta *vmeta;
+
+  if (gst_buffer_n_memory (buf) == 1 && gst_buffer_peek_memory (buf, 0) == mem)
+    return;
+
+  gst_buffer_replace_all_memory (buf, gst_memory_ref (mem));
+
+  vmeta = gst_buffer_get_video_meta (buf);
+  if (vmeta) {
+    guint i;
+
+    for (i = 0; i < vmeta->n_planes; i++) {
+      vmeta->offset[i] = GST_VIDEO_INFO_PLANE_OFFSET (info, i);
+      vmeta->stride[i] = GST_VIDEO_INFO_PLANE_STRIDE (info, i);
+    }
+  }
+}
+
+static GstFlowReturn
+gst_opencv_video_filter_prepare_output_buffer (GstBaseTransform * trans,
+    GstBuffer * inbuf, GstBuffer ** outbuf)
+{
+  GstOpencvVideoFilter *transform = GST_OPENCV_VIDEO_FILTER (trans);
+  GstBaseTransformClass *bclass = GST_BASE_TRANSFORM_GET_CLASS (trans);
+
+  if (gst_base_transform_is_in_place (trans) ||
+      !gst_opencv_video_filter_use_umat (transform, FALSE))
+    return GST_BASE_TRANSFORM_CLASS (parent_class)->prepare_output_buffer
+        (trans, inbuf, outbuf);
+
+  /* the output is written to the UMat, don't allocate host memory that
+   * would be thrown away */
+  *outbuf = gst_buffer_new ();
+  gst_buffer_append_memory (*outbuf,
+      gst_opencv_umat_memory_new (&GST_VIDEO_FILTER (trans)->out_info,
+          transform->out_cv_type));
+
+  if (bclass->copy_metadata &&
+      !bclass->copy_metadata (trans, inbuf, *outbuf)) {
+    GST_ELEMENT_WARNING (trans, STREAM, NOT_IMPLEMENTED,
+        ("could not copy metadata"), (NULL));
+  }
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_opencv_video_filter_transform (GstBaseTransform * trans,
+    GstBuffer * inbuf, GstBuffer * outbuf)
+{
+  GstOpencvVideoFilter *transform = GST_OPENCV_VIDEO_FILTER (trans);
+  GstVideoFilter *vfilter = GST_VIDEO_FILTER (trans);
+  GstOpencvVideoFilterClass *fclass =
+      GST_OPENCV_VIDEO_FILTER_GET_CLASS (transform);
+  GstMemory *in_mem, *out_mem;
+  GstFlowReturn ret;
+
+  if (!gst_opencv_video_filter_use_umat (transform, FALSE))
+    return GST_BASE_TRANSFORM_CLASS (parent_class)->transform (trans, inbuf,
+        outbuf);
+
+  in_mem = gst_opencv_video_filter_get_umat_memory (transform, inbuf,
+      &vfilter->in_info, transform->in_cv_type);
+  if (!in_mem)
+    goto invalid_buffer;
+
+  if (gst_buffer_n_memory (outbuf) == 1 &&
+      gst_is_opencv_umat_memory (gst_buffer_peek_memory (outbuf, 0),
+          &vfilter->out_info, transform->out_cv_type)) {
+    out_mem = gst_memory_ref (gst_buffer_peek_memory (outbuf, 0));
+  } else {
+    out_mem = gst_opencv_umat_memory_new (&vfilter->out_info,
+        transform->out_cv_type);
+    gst_opencv_video_filter_set_umat_memory (outbuf, out_mem,
+        &vfilter->out_info);
+  }
+
+  ret = fclass->cv_trans_umat_func (transform, inbuf,
+      gst_opencv_umat_memory_get_umat (in_mem, GST_MAP_READ), outbuf,
+      gst_opencv_umat_memory_get_umat (out_mem, GST_MAP_WRITE));
+
+  gst_memory_unref (in_mem);
+  gst_memory_unref (out_mem);
+
+  return ret;
+
+invalid_buffer:
+  {
+    GST_ELEMENT_WARNING (trans, CORE, NOT_IMPLEMENTED, (NULL),
+        ("invalid video buffer received"));
+    return GST_FLOW_OK;
+  }
+}
+
+static GstFlowReturn
+gst_opencv_video_filter_transform_ip (GstBaseTransform * trans,
+    GstBuffer * buf)
+{
+  GstOpencvVideoFilter *transform = GST_OPENCV_VIDEO_FILTER (trans);
+  GstVideoFilter *vfilter = GST_VIDEO_FILTER (trans);
+  GstOpencvVideoFilterClass *fclass =
+      GST_OPENCV_VIDEO_FILTER_GET_CLASS (transform);
+  GstMemory *mem;
+  GstFlowReturn ret;
+
+  if (!gst_opencv_video_filter_use_umat (transform, TRUE))
+    return GST_BASE_TRANSFORM_CLASS (parent_class)->transform_ip (trans, buf);
+
+  mem = gst_opencv_video_filter_get_umat_memory (transform, buf,
+      &vfilter->in_info, transform->in_cv_type);
+  if (!mem)
+    goto invalid_buffer;
+
+  /* the buffer now carries its frame in the UMat memory */
+  gst_opencv_video_filter_set_umat_memory (buf, mem, &vfilter->in_info);
+
+  ret = fclass->cv_trans_ip_umat_func (transform, buf,
+      gst_opencv_umat_memory_get_umat (mem, GST_MAP_READWRITE));
+
+  gst_memory_unref (mem);
+
+  return ret;
+
+invalid_buffer:
+  {
+    GST_ELEMENT_WARNING (trans, CORE, NOT_IMPLEMENTED, (NULL),
+        ("invalid video buffer received"));
+    return GST_FLOW_OK;
+  }
 }
 
 static GstFlowReturn
@@ -207,6 +420,8 @@ gst_opencv_video_filter_set_info (GstVideoFilter * trans, GstCaps * incaps,
 
   transform->cvImage.create (cv::Size (in_width, in_height), in_cv_type);
   transform->out_cvImage.create (cv::Size (out_width, out_height), out_cv_type);
+  transform->in_cv_type = in_cv_type;
+  transform->out_cv_type = out_cv_type;
 
   gst_base_transform_set_in_place (GST_BASE_TRANSFORM (transform),
       transform->in_place);
@@ -217,7 +432,12 @@ static void
 gst_opencv_video_filter_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
 {
+  GstOpencvVideoFilter *transform = GST_OPENCV_VIDEO_FILTER (object);
+
   switch (prop_id) {
+    case PROP_USE_OPENCL:
+      g_atomic_int_set (&transform->use_opencl, g_value_get_boolean (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -228,7 +448,12 @@ static void
 gst_opencv_video_filter_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
 {
+  GstOpencvVideoFilter *transform = GST_OPENCV_VIDEO_FILTER (object);
+
   switch (prop_id) {
+    case PROP_USE_OPENCL:
+      g_value_set_boolean (value, g_atomic_int_get (&transform->use_opencl));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -79,6 +79,12 @@ typedef GstFlowReturn (*GstOpencvVideoFilterTransformFunc)
     (GstOpencvVideoFilter * transform, GstBuffer * buffer, cv::Mat img,
     GstBuffer * outbuf, cv::Mat outimg);
 
+typedef GstFlowReturn (*GstOpencvVideoFilterTransformIPUMatFunc)
+    (GstOpencvVideoFilter * transform, GstBuffer * buffer, cv::UMat & img);
+typedef GstFlowReturn (*GstOpencvVideoFilterTransformUMatFunc)
+    (GstOpencvVideoFilter * transform, GstBuffer * buffer, cv::UMat & img,
+    GstBuffer * outbuf, cv::UMat & outimg);
+
 typedef gboolean (*GstOpencvVideoFilterSetCaps)
     (GstOpencvVideoFilter * transform, gint in_width, gint in_height,
     int in_cv_type, gint out_width, gint out_height,
@@ -92,6 +98,10 @@ struct _GstOpencvVideoFilter
 
   cv::Mat cvImage;
   cv::Mat out_cvImage;
+
+  gboolean use_opencl;
+  int in_cv_type;
+  int out_cv_type;
 };
 
 struct _GstOpencvVideoFilterClass
@@ -102,6 +112,10 @@ struct _GstOpencvVideoFilterClass
   GstOpencvVideoFilterTransformIPFunc cv_trans_ip_func;
 
   GstOpencvVideoFilterSetCaps cv_set_caps;
+
+  /* optional, used instead of the above with the use-opencl property */
+  GstOpencvVideoFilterTransformUMatFunc cv_trans_umat_func;
+  GstOpencvVideoFilterTransformIPUMatFunc cv_trans_ip_umat_func;
 };
 
 GST_OPENCV_API
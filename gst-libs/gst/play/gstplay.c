@@ -52,6 +52,7 @@
 #include "gstplay-video-renderer-private.h"
 #include "gstplay-media-info-private.h"
 #include "gstplay-message-private.h"
+#include "gstplay-video-overlay-video-renderer.h"
 
 #include <gst/gst.h>
 #include <gst/video/video.h>
@@ -190,6 +191,14 @@ struct _GstPlay
   gchar *audio_sid;
   gchar *subtitle_sid;
   gulong stream_notify_id;
+
+  /* Second pipeline prerolling the URI given to gst_play_preload_uri(),
+   * only accessed from the main context */
+  GstElement *preload_playbin;
+  GstStateChangeReturn preload_ret;
+  /* Protected by lock */
+  gchar *preload_uri;
+  GList *preload_video_sinks;
 };
 
 struct _GstPlayClass
@@ -213,6 +222,8 @@ static void gst_play_constructed (GObject * object);
 static gpointer gst_play_main (gpointer data);
 
 static void gst_play_seek_internal_locked (GstPlay * self);
+static void gst_play_clear_preload (GstPlay * self);
+static gboolean gst_play_swap_preload (GstPlay * self);
 static void gst_play_stop_internal (GstPlay * self, gboolean transient);
 static gboolean gst_play_pause_internal (gpointer user_data);
 static gboolean gst_play_play_internal (gpointer user_data);
@@ -478,6 +489,7 @@ gst_play_finalize (GObject * object)
   g_free (self->uri);
   g_free (self->redirect_uri);
   g_free (self->suburi);
+  g_free (self->preload_uri);
   g_free (self->video_sid);
   g_free (self->audio_sid);
   g_free (self->subtitle_sid);
@@ -520,18 +532,24 @@ gst_play_set_uri_internal (gpointer user_data)
 {
   GstPlay *self = user_data;
 
+  gboolean swapped;
+
   gst_play_stop_internal (self, FALSE);
 
+  swapped = gst_play_swap_preload (self);
+
   g_mutex_lock (&self->lock);
 
   GST_DEBUG_OBJECT (self, "Changing URI to '%s'", GST_STR_NULL (self->uri));
 
-  g_object_set (self->playbin, "uri", self->uri, NULL);
+  if (!swapped)
+    g_object_set (self->playbin, "uri", self->uri, NULL);
 
   api_bus_post_message (self, GST_PLAY_MESSAGE_URI_LOADED,
       GST_PLAY_MESSAGE_DATA_URI, G_TYPE_STRING, self->uri, NULL);
 
-  g_object_set (self->playbin, "suburi", NULL, NULL);
+  if (!swapped)
+    g_object_set (self->playbin, "suburi", NULL, NULL);
 
   g_mutex_unlock (&self->lock);
 
@@ -2458,60 +2476,37 @@ source_setup_cb (GstElement * playbin, GstElement * source, GstPlay * self)
   }
 }
 
-static gpointer
-gst_play_main (gpointer data)
+static GstElement *
+gst_play_make_playbin (GstPlay * self)
 {
-  GstPlay *self = GST_PLAY (data);
-  GstBus *bus;
-  GSource *source;
-  GstElement *scaletempo;
-  const gchar *env;
+  GstElement *playbin, *scaletempo;
 
-  GST_TRACE_OBJECT (self, "Starting main thread");
-
-  g_main_context_push_thread_default (self->context);
-
-  source = g_idle_source_new ();
-  g_source_set_callback (source, (GSourceFunc) main_loop_running_cb, self,
-      NULL);
-  g_source_attach (source, self->context);
-  g_source_unref (source);
-
-  env = g_getenv ("GST_PLAY_USE_PLAYBIN3");
-  if (env && g_str_has_prefix (env, "1"))
-    self->use_playbin3 = TRUE;
-
-  if (self->use_playbin3) {
-    GST_DEBUG_OBJECT (self, "playbin3 enabled");
-    self->playbin = gst_element_factory_make ("playbin3", "playbin3");
-  } else {
-    self->playbin = gst_element_factory_make ("playbin", "playbin");
-  }
-
-  if (!self->playbin) {
-    g_error ("GstPlay: 'playbin' element not found, please check your setup");
-    g_assert_not_reached ();
-  }
-
-  gst_object_ref_sink (self->playbin);
+  if (self->use_playbin3)
+    playbin = gst_element_factory_make ("playbin3", "playbin3");
+  else
+    playbin = gst_element_factory_make ("playbin", "playbin");
 
-  if (self->video_renderer) {
-    GstElement *video_sink =
-        gst_play_video_renderer_create_video_sink (self->video_renderer,
-        self);
+  if (!playbin)
+    return NULL;
 
-    if (video_sink)
-      g_object_set (self->playbin, "video-sink", video_sink, NULL);
-  }
+  gst_object_ref_sink (playbin);
 
   scaletempo = gst_element_factory_make ("scaletempo", NULL);
   if (scaletempo) {
-    g_object_set (self->playbin, "audio-filter", scaletempo, NULL);
-  } else {
+    g_object_set (playbin, "audio-filter", scaletempo, NULL);
+  } else if (!self->playbin) {
     g_warning ("GstPlay: scaletempo element not available. Audio pitch "
         "will not be preserved during trick modes");
   }
 
+  return playbin;
+}
+
+static void
+gst_play_connect_pipeline (GstPlay * self)
+{
+  GstBus *bus;
+
   self->bus = bus = gst_element_get_bus (self->playbin);
   gst_bus_add_signal_watch (bus);
 
@@ -2563,6 +2558,247 @@ gst_play_main (gpointer data)
       G_CALLBACK (mute_notify_cb), self);
   g_signal_connect (self->playbin, "source-setup",
       G_CALLBACK (source_setup_cb), self);
+}
+
+static void
+gst_play_disconnect_pipeline (GstPlay * self)
+{
+  if (!self->bus)
+    return;
+
+  gst_bus_remove_signal_watch (self->bus);
+  g_signal_handlers_disconnect_by_data (self->bus, self);
+  g_signal_handlers_disconnect_by_data (self->playbin, self);
+  gst_clear_object (&self->bus);
+}
+
+static void
+preload_element_setup_cb (G_GNUC_UNUSED GstElement * playbin,
+    GstElement * element, GstPlay * self)
+{
+  if (!GST_IS_VIDEO_SINK (element))
+    return;
+
+  /* Keep the preroll frame of the next URI off the screen until it is
+   * swapped in, the video sinks of both pipelines usually render into the
+   * same window */
+  g_object_set (element, "show-preroll-frame", FALSE, NULL);
+
+  g_mutex_lock (&self->lock);
+  self->preload_video_sinks = g_list_prepend (self->preload_video_sinks,
+      gst_object_ref (element));
+  g_mutex_unlock (&self->lock);
+}
+
+static void
+gst_play_clear_preload (GstPlay * self)
+{
+  if (self->preload_playbin) {
+    GST_DEBUG_OBJECT (self, "Discarding preloaded pipeline");
+    gst_element_set_state (self->preload_playbin, GST_STATE_NULL);
+    gst_clear_object (&self->preload_playbin);
+  }
+
+  g_mutex_lock (&self->lock);
+  g_list_free_full (self->preload_video_sinks, gst_object_unref);
+  self->preload_video_sinks = NULL;
+  g_mutex_unlock (&self->lock);
+}
+
+static gboolean
+gst_play_preload_uri_internal (gpointer user_data)
+{
+  GstPlay *self = GST_PLAY (user_data);
+  GstElement *playbin, *video_sink = NULL;
+  gchar *uri;
+  guint flags;
+
+  gst_play_clear_preload (self);
+
+  g_mutex_lock (&self->lock);
+  uri = g_strdup (self->preload_uri);
+  g_mutex_unlock (&self->lock);
+
+  if (!uri)
+    return G_SOURCE_REMOVE;
+
+  GST_DEBUG_OBJECT (self, "Preloading URI '%s'", uri);
+
+  playbin = gst_play_make_playbin (self);
+  if (!playbin) {
+    GST_WARNING_OBJECT (self, "Failed to create preload pipeline");
+    g_free (uri);
+    return G_SOURCE_REMOVE;
+  }
+
+  g_object_get (self->playbin, "flags", &flags, "video-sink", &video_sink,
+      NULL);
+  g_object_set (playbin, "flags", flags, "uri", uri, NULL);
+  g_free (uri);
+
+  /* An element can only be in one pipeline at a time, so the preloaded
+   * pipeline gets its own instance of the configured video sink */
+  if (video_sink) {
+    GstElementFactory *factory = gst_element_get_factory (video_sink);
+    GstElement *sink = NULL;
+
+    if (factory)
+      sink = gst_element_factory_create (factory, NULL);
+    if (sink)
+      g_object_set (playbin, "video-sink", sink, NULL);
+    gst_object_unref (video_sink);
+  }
+
+  if (GST_IS_PLAY_VIDEO_OVERLAY_VIDEO_RENDERER (self->video_renderer)) {
+    gpointer window_handle =
+        gst_play_video_overlay_video_renderer_get_window_handle
+        (GST_PLAY_VIDEO_OVERLAY_VIDEO_RENDERER (self->video_renderer));
+
+    if (window_handle)
+      gst_video_overlay_set_window_handle (GST_VIDEO_OVERLAY (playbin),
+          (guintptr) window_handle);
+  }
+
+  g_signal_connect (playbin, "source-setup",
+      G_CALLBACK (source_setup_cb), self);
+  g_signal_connect (playbin, "element-setup",
+      G_CALLBACK (preload_element_setup_cb), self);
+
+  /* Nobody watches the bus of this pipeline yet: its messages queue up and
+   * are dispatched once it is swapped in, as if it had been started from
+   * gst_play_pause() */
+  self->preload_ret = gst_element_set_state (playbin, GST_STATE_PAUSED);
+  if (self->preload_ret == GST_STATE_CHANGE_FAILURE) {
+    GST_WARNING_OBJECT (self, "Failed to preload URI");
+    gst_element_set_state (playbin, GST_STATE_NULL);
+    gst_object_unref (playbin);
+    return G_SOURCE_REMOVE;
+  }
+
+  self->preload_playbin = playbin;
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Must be called from the main context with the current pipeline stopped.
+ * Returns TRUE if the preloaded pipeline was prerolling self->uri and has
+ * replaced the current one */
+static gboolean
+gst_play_swap_preload (GstPlay * self)
+{
+  GstElement *old_playbin, *video_sink = NULL;
+  GstState state;
+  gchar *uri = NULL;
+  gboolean match;
+  gdouble volume;
+  gboolean mute;
+  gint64 av_offset, text_offset;
+  GList *l;
+
+  if (!self->preload_playbin)
+    return FALSE;
+
+  g_object_get (self->preload_playbin, "uri", &uri, NULL);
+  g_mutex_lock (&self->lock);
+  match = g_strcmp0 (uri, self->uri) == 0;
+  g_mutex_unlock (&self->lock);
+  g_free (uri);
+
+  if (!match || gst_element_get_state (self->preload_playbin, &state, NULL,
+          0) == GST_STATE_CHANGE_FAILURE) {
+    gst_play_clear_preload (self);
+    return FALSE;
+  }
+
+  GST_DEBUG_OBJECT (self, "Switching to preloaded pipeline (state %s)",
+      gst_element_state_get_name (state));
+
+  old_playbin = self->playbin;
+
+  g_object_get (old_playbin, "volume", &volume, "mute", &mute,
+      "av-offset", &av_offset, "text-offset", &text_offset,
+      "video-sink", &video_sink, NULL);
+  if (video_sink) {
+    GstPad *video_sink_pad = gst_element_get_static_pad (video_sink, "sink");
+
+    if (video_sink_pad) {
+      g_signal_handlers_disconnect_by_func (video_sink_pad, notify_caps_cb,
+          self);
+      gst_object_unref (video_sink_pad);
+    }
+    gst_object_unref (video_sink);
+  }
+
+  gst_play_disconnect_pipeline (self);
+  gst_element_set_state (old_playbin, GST_STATE_NULL);
+  gst_object_unref (old_playbin);
+
+  self->playbin = self->preload_playbin;
+  self->preload_playbin = NULL;
+  g_signal_handlers_disconnect_by_data (self->playbin, self);
+
+  g_object_set (self->playbin, "volume", volume, "mute", mute,
+      "av-offset", av_offset, "text-offset", text_offset, NULL);
+
+  g_mutex_lock (&self->lock);
+  for (l = self->preload_video_sinks; l; l = l->next)
+    g_object_set (l->data, "show-preroll-frame", TRUE, NULL);
+  g_list_free_full (self->preload_video_sinks, gst_object_unref);
+  self->preload_video_sinks = NULL;
+  g_mutex_unlock (&self->lock);
+
+  gst_play_connect_pipeline (self);
+
+  if (self->preload_ret == GST_STATE_CHANGE_NO_PREROLL)
+    self->is_live = TRUE;
+
+  /* Point the overlay at the new pipeline */
+  if (GST_IS_PLAY_VIDEO_OVERLAY_VIDEO_RENDERER (self->video_renderer))
+    gst_play_video_renderer_create_video_sink (self->video_renderer, self);
+
+  return TRUE;
+}
+
+static gpointer
+gst_play_main (gpointer data)
+{
+  GstPlay *self = GST_PLAY (data);
+  GSource *source;
+  const gchar *env;
+
+  GST_TRACE_OBJECT (self, "Starting main thread");
+
+  g_main_context_push_thread_default (self->context);
+
+  source = g_idle_source_new ();
+  g_source_set_callback (source, (GSourceFunc) main_loop_running_cb, self,
+      NULL);
+  g_source_attach (source, self->context);
+  g_source_unref (source);
+
+  env = g_getenv ("GST_PLAY_USE_PLAYBIN3");
+  if (env && g_str_has_prefix (env, "1"))
+    self->use_playbin3 = TRUE;
+
+  if (self->use_playbin3)
+    GST_DEBUG_OBJECT (self, "playbin3 enabled");
+
+  self->playbin = gst_play_make_playbin (self);
+  if (!self->playbin) {
+    g_error ("GstPlay: 'playbin' element not found, please check your setup");
+    g_assert_not_reached ();
+  }
+
+  if (self->video_renderer) {
+    GstElement *video_sink =
+        gst_play_video_renderer_create_video_sink (self->video_renderer,
+        self);
+
+    if (video_sink)
+      g_object_set (self->playbin, "video-sink", video_sink, NULL);
+  }
+
+  gst_play_connect_pipeline (self);
 
   self->target_state = GST_STATE_NULL;
   self->current_state = GST_STATE_NULL;
@@ -2576,8 +2812,8 @@ gst_play_main (gpointer data)
   g_main_loop_run (self->loop);
   GST_TRACE_OBJECT (self, "Stopped main loop");
 
-  gst_bus_remove_signal_watch (bus);
-  gst_object_unref (bus);
+  gst_play_disconnect_pipeline (self);
+  gst_play_clear_preload (self);
 
   remove_tick_source (self);
   remove_ready_timeout_source (self);
@@ -3130,6 +3366,37 @@ gst_play_set_uri (GstPlay * self, const gchar * val)
   g_object_set (self, "uri", val, NULL);
 }
 
+/**
+ * gst_play_preload_uri:
+ * @play: #GstPlay instance
+ * @uri: (allow-none): URI to preload, or %NULL to discard a preloaded URI
+ *
+ * Starts prerolling @uri in a second pipeline while the current stream
+ * keeps playing. If @uri is then passed to gst_play_set_uri(), the
+ * preloaded pipeline replaces the current one instead of starting from
+ * scratch, which makes switching between streams almost instantaneous.
+ *
+ * The preloaded pipeline uses its own instance of the video sink and
+ * becomes the one returned by gst_play_get_pipeline() once swapped in.
+ * Setting any other URI discards it.
+ *
+ * Since: 1.20
+ */
+void
+gst_play_preload_uri (GstPlay * self, const gchar * val)
+{
+  g_return_if_fail (GST_IS_PLAY (self));
+
+  g_mutex_lock (&self->lock);
+  g_free (self->preload_uri);
+  self->preload_uri = g_strdup (val);
+  GST_DEBUG_OBJECT (self, "Set preload uri=%s", GST_STR_NULL (val));
+  g_mutex_unlock (&self->lock);
+
+  g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+      gst_play_preload_uri_internal, self, NULL);
+}
+
 /**
  * gst_play_set_subtitle_uri:
  * @play: #GstPlay instance
@@ -231,6 +231,10 @@ GST_PLAY_API
 void         gst_play_set_uri                       (GstPlay    * play,
                                                      const gchar  * uri);
 
+GST_PLAY_API
+void         gst_play_preload_uri                   (GstPlay    * play,
+                                                     const gchar  * uri);
+
 GST_PLAY_API
 gchar *      gst_play_get_subtitle_uri              (GstPlay    * play);
 
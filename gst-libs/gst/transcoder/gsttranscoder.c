@@ -30,6 +30,8 @@
 #include "gsttranscoder.h"
 #include "gsttranscoder-private.h"
 
+#include <glib/gstdio.h>
+
 static GOnce once = G_ONCE_INIT;
 
 GST_DEBUG_CATEGORY_STATIC (gst_transcoder_debug);
@@ -40,6 +42,10 @@ GST_DEBUG_CATEGORY_STATIC (gst_transcoder_debug);
 #define DEFAULT_DURATION GST_CLOCK_TIME_NONE
 #define DEFAULT_POSITION_UPDATE_INTERVAL_MS 100
 #define DEFAULT_AVOID_REENCODING   FALSE
+#define DEFAULT_PARALLEL_SEGMENTS 1
+/* Inputs are not split into time ranges shorter than this */
+#define MIN_SEGMENT_DURATION (10 * GST_SECOND)
+#define DISCOVERER_TIMEOUT (30 * GST_SECOND)
 
 GQuark
 gst_transcoder_error_quark (void)
@@ -63,6 +69,7 @@ enum
   PROP_PIPELINE,
   PROP_POSITION_UPDATE_INTERVAL,
   PROP_AVOID_REENCODING,
+  PROP_PARALLEL_SEGMENTS,
   PROP_LAST
 };
 
@@ -95,6 +102,14 @@ struct _GstTranscoder
   GstBus *api_bus;
   GstTranscoderSignalAdapter *signal_adapter;
   GstTranscoderSignalAdapter *sync_signal_adapter;
+
+  /* Parallel mode, only accessed from the main context except for
+   * segment_pipelines which is protected by the object lock */
+  guint parallel_segments;
+  GPtrArray *segment_pipelines;
+  guint segments_running;
+  GstElement *concat_pipeline;
+  gchar *segments_dir;
 };
 
 struct _GstTranscoderClass
@@ -119,6 +134,8 @@ static gpointer gst_transcoder_main (gpointer data);
 
 static gboolean gst_transcoder_set_position_update_interval_internal (gpointer
     user_data);
+static gboolean gst_transcoder_get_parallel_position (GstTranscoder * self,
+    gint64 * position);
 
 
 /**
@@ -156,6 +173,7 @@ gst_transcoder_init (GstTranscoder * self)
   self->wanted_cpu_usage = 100;
 
   self->position_update_interval_ms = DEFAULT_POSITION_UPDATE_INTERVAL_MS;
+  self->parallel_segments = DEFAULT_PARALLEL_SEGMENTS;
 
   GST_TRACE_OBJECT (self, "Initialized");
 }
@@ -216,6 +234,23 @@ gst_transcoder_class_init (GstTranscoderClass * klass)
       "Whether to re-encode portions of compatible video streams that lay on segment boundaries",
       DEFAULT_AVOID_REENCODING, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+  /**
+   * GstTranscoder:parallel-segments:
+   *
+   * Number of time ranges the input is split into, each of them being
+   * transcoded by its own #uritranscodebin concurrently with the others.
+   * The encoded ranges are then concatenated into the destination. Only
+   * seekable inputs of known duration are split, others are transcoded in
+   * one go.
+   *
+   * Since: 1.20
+   */
+  param_specs[PROP_PARALLEL_SEGMENTS] =
+      g_param_spec_uint ("parallel-segments", "Parallel segments",
+      "Number of time ranges to transcode in parallel (1 = disabled)",
+      1, 1024, DEFAULT_PARALLEL_SEGMENTS,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
   g_object_class_install_properties (gobject_class, PROP_LAST, param_specs);
 }
 
@@ -259,6 +294,7 @@ gst_transcoder_finalize (GObject * object)
 
   g_free (self->source_uri);
   g_free (self->dest_uri);
+  g_free (self->segments_dir);
   g_cond_clear (&self->cond);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
@@ -328,6 +364,11 @@ gst_transcoder_set_property (GObject * object, guint prop_id,
       g_object_set (self->transcodebin, "avoid-reencoding",
           g_value_get_boolean (value), NULL);
       break;
+    case PROP_PARALLEL_SEGMENTS:
+      GST_OBJECT_LOCK (self);
+      self->parallel_segments = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -356,7 +397,7 @@ gst_transcoder_get_property (GObject * object, guint prop_id,
 
       if (self->is_eos)
         position = self->last_duration;
-      else
+      else if (!gst_transcoder_get_parallel_position (self, &position))
         gst_element_query_position (self->transcodebin, GST_FORMAT_TIME,
             &position);
       g_value_set_uint64 (value, position);
@@ -367,8 +408,9 @@ gst_transcoder_get_property (GObject * object, guint prop_id,
     case PROP_DURATION:{
       gint64 duration = 0;
 
-      gst_element_query_duration (self->transcodebin, GST_FORMAT_TIME,
-          &duration);
+      if (!gst_element_query_duration (self->transcodebin, GST_FORMAT_TIME,
+              &duration))
+        duration = self->last_duration;
       g_value_set_uint64 (value, duration);
       GST_TRACE_OBJECT (self, "Returning duration=%" GST_TIME_FORMAT,
           GST_TIME_ARGS (g_value_get_uint64 (value)));
@@ -397,6 +439,11 @@ gst_transcoder_get_property (GObject * object, guint prop_id,
       g_value_set_boolean (value, avoid_reencoding);
       break;
     }
+    case PROP_PARALLEL_SEGMENTS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->parallel_segments);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -454,7 +501,8 @@ tick_cb (gpointer user_data)
   if (self->target_state < GST_STATE_PAUSED)
     return G_SOURCE_CONTINUE;
 
-  if (!gst_element_query_position (self->transcodebin, GST_FORMAT_TIME,
+  if (!gst_transcoder_get_parallel_position (self, &position) &&
+      !gst_element_query_position (self->transcodebin, GST_FORMAT_TIME,
           &position)) {
     GST_LOG_OBJECT (self, "Could not query position");
     return G_SOURCE_CONTINUE;
@@ -779,6 +827,384 @@ element_cb (G_GNUC_UNUSED GstBus * bus, GstMessage * msg, gpointer user_data)
 }
 
 
+static void
+gst_transcoder_start (GstTranscoder * self)
+{
+  GstStateChangeReturn state_ret;
+
+  self->target_state = GST_STATE_PLAYING;
+  state_ret = gst_element_set_state (self->transcodebin, GST_STATE_PLAYING);
+
+  if (state_ret == GST_STATE_CHANGE_FAILURE) {
+    GError *err = g_error_new (GST_TRANSCODER_ERROR,
+        GST_TRANSCODER_ERROR_FAILED, "Could not start transcoding");
+    api_bus_post_message (self, GST_TRANSCODER_MESSAGE_ERROR,
+        GST_TRANSCODER_MESSAGE_DATA_ERROR, G_TYPE_ERROR, err, NULL);
+    g_error_free (err);
+  } else if (state_ret == GST_STATE_CHANGE_NO_PREROLL) {
+    self->is_live = TRUE;
+    GST_DEBUG_OBJECT (self, "Pipeline is live");
+  }
+}
+
+#define SEGMENT_DONE_KEY "gst-transcoder-segment-done"
+
+static void segment_message_cb (GstBus * bus, GstMessage * msg,
+    GstTranscoder * self);
+
+static gboolean
+gst_transcoder_get_parallel_position (GstTranscoder * self, gint64 * position)
+{
+  GPtrArray *pipelines = NULL;
+  GstClockTime total = 0;
+  guint i;
+
+  GST_OBJECT_LOCK (self);
+  if (self->segment_pipelines)
+    pipelines = g_ptr_array_ref (self->segment_pipelines);
+  GST_OBJECT_UNLOCK (self);
+
+  if (!pipelines) {
+    if (!self->concat_pipeline)
+      return FALSE;
+
+    /* All the ranges have been encoded, only concatenating them is left */
+    *position = self->last_duration;
+    return TRUE;
+  }
+
+  for (i = 0; i < pipelines->len; i++) {
+    GstElement *pipeline = g_ptr_array_index (pipelines, i);
+    GstClockTime start, stop;
+    gint64 pos;
+
+    g_object_get (pipeline, "start-time", &start, "stop-time", &stop, NULL);
+    if (!GST_CLOCK_TIME_IS_VALID (stop))
+      stop = self->last_duration;
+
+    if (g_object_get_data (G_OBJECT (pipeline), SEGMENT_DONE_KEY))
+      pos = stop;
+    else if (!gst_element_query_position (pipeline, GST_FORMAT_TIME, &pos))
+      pos = start;
+
+    pos = CLAMP (pos, (gint64) start, (gint64) stop);
+    total += pos - start;
+  }
+  g_ptr_array_unref (pipelines);
+
+  *position = total;
+
+  return TRUE;
+}
+
+static void
+gst_transcoder_release_pipeline (GstElement * pipeline)
+{
+  GstBus *bus = gst_element_get_bus (pipeline);
+
+  gst_bus_remove_signal_watch (bus);
+  g_signal_handlers_disconnect_matched (bus, G_SIGNAL_MATCH_FUNC, 0, 0, NULL,
+      segment_message_cb, NULL);
+  gst_object_unref (bus);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+}
+
+static void
+gst_transcoder_clear_segments (GstTranscoder * self)
+{
+  GPtrArray *pipelines;
+
+  GST_OBJECT_LOCK (self);
+  pipelines = self->segment_pipelines;
+  self->segment_pipelines = NULL;
+  GST_OBJECT_UNLOCK (self);
+
+  if (pipelines)
+    g_ptr_array_unref (pipelines);
+  self->segments_running = 0;
+}
+
+static void
+gst_transcoder_clear_parallel (GstTranscoder * self)
+{
+  gst_transcoder_clear_segments (self);
+
+  if (self->concat_pipeline) {
+    gst_transcoder_release_pipeline (self->concat_pipeline);
+    self->concat_pipeline = NULL;
+  }
+
+  if (self->segments_dir) {
+    GDir *dir = g_dir_open (self->segments_dir, 0, NULL);
+
+    if (dir) {
+      const gchar *name;
+
+      while ((name = g_dir_read_name (dir))) {
+        gchar *path = g_build_filename (self->segments_dir, name, NULL);
+
+        g_unlink (path);
+        g_free (path);
+      }
+      g_dir_close (dir);
+    }
+    g_rmdir (self->segments_dir);
+    g_clear_pointer (&self->segments_dir, g_free);
+  }
+}
+
+static void
+gst_transcoder_post_error (GstTranscoder * self, const gchar * message)
+{
+  GError *err = g_error_new_literal (GST_TRANSCODER_ERROR,
+      GST_TRANSCODER_ERROR_FAILED, message);
+
+  api_bus_post_message (self, GST_TRANSCODER_MESSAGE_ERROR,
+      GST_TRANSCODER_MESSAGE_DATA_ERROR, G_TYPE_ERROR, err, NULL);
+  g_error_free (err);
+}
+
+static void
+concat_pad_added_cb (G_GNUC_UNUSED GstElement * src, GstPad * pad,
+    GstElement * encodebin)
+{
+  GstCaps *caps = gst_pad_query_caps (pad, NULL);
+  GstPad *sinkpad = NULL;
+
+  /* The ranges are already encoded in the target formats, so encodebin
+   * only parses and muxes them */
+  g_signal_emit_by_name (encodebin, "request-pad", caps, &sinkpad);
+  if (!sinkpad || GST_PAD_LINK_FAILED (gst_pad_link (pad, sinkpad)))
+    GST_ERROR_OBJECT (encodebin, "Could not link %" GST_PTR_FORMAT
+        " with caps %" GST_PTR_FORMAT, pad, caps);
+
+  if (sinkpad)
+    gst_object_unref (sinkpad);
+  gst_caps_unref (caps);
+}
+
+static gboolean
+gst_transcoder_start_concat (GstTranscoder * self)
+{
+  GstElement *pipeline, *src, *encodebin, *sink;
+  gchar *location;
+  GstBus *bus;
+
+  GST_DEBUG_OBJECT (self, "All ranges encoded, concatenating them");
+
+  pipeline = gst_pipeline_new ("gst-transcoder-concat");
+  src = gst_element_factory_make ("splitmuxsrc", NULL);
+  encodebin = gst_element_factory_make ("encodebin", NULL);
+  sink = gst_element_make_from_uri (GST_URI_SINK, self->dest_uri, NULL, NULL);
+
+  if (!src || !encodebin || !sink) {
+    gst_clear_object (&src);
+    gst_clear_object (&encodebin);
+    gst_clear_object (&sink);
+    gst_object_unref (pipeline);
+    return FALSE;
+  }
+
+  location = g_build_filename (self->segments_dir, "part-*", NULL);
+  g_object_set (src, "location", location, NULL);
+  g_free (location);
+  g_object_set (encodebin, "profile", self->profile, NULL);
+
+  gst_bin_add_many (GST_BIN (pipeline), src, encodebin, sink, NULL);
+  if (!gst_element_link (encodebin, sink)) {
+    gst_object_unref (pipeline);
+    return FALSE;
+  }
+  g_signal_connect (src, "pad-added", G_CALLBACK (concat_pad_added_cb),
+      encodebin);
+
+  bus = gst_element_get_bus (pipeline);
+  gst_bus_add_signal_watch (bus);
+  g_signal_connect (bus, "message", G_CALLBACK (segment_message_cb), self);
+  gst_object_unref (bus);
+
+  self->concat_pipeline = pipeline;
+
+  return gst_element_set_state (pipeline,
+      GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE;
+}
+
+static void
+segment_message_cb (GstBus * bus, GstMessage * msg, GstTranscoder * self)
+{
+  switch (GST_MESSAGE_TYPE (msg)) {
+    case GST_MESSAGE_ERROR:
+      error_cb (bus, msg, self);
+      remove_tick_source (self);
+      gst_transcoder_clear_parallel (self);
+      notify_state_changed (self, GST_TRANSCODER_STATE_STOPPED);
+      break;
+    case GST_MESSAGE_WARNING:
+      warning_cb (bus, msg, self);
+      break;
+    case GST_MESSAGE_EOS:
+      if (GST_MESSAGE_SRC (msg) == GST_OBJECT (self->concat_pipeline)) {
+        GST_DEBUG_OBJECT (self, "End of stream");
+
+        tick_cb (self);
+        remove_tick_source (self);
+        gst_transcoder_clear_parallel (self);
+        self->is_eos = TRUE;
+        notify_state_changed (self, GST_TRANSCODER_STATE_STOPPED);
+        api_bus_post_message (self, GST_TRANSCODER_MESSAGE_DONE, NULL, NULL);
+        break;
+      }
+
+      g_object_set_data (G_OBJECT (GST_MESSAGE_SRC (msg)), SEGMENT_DONE_KEY,
+          GINT_TO_POINTER (TRUE));
+      GST_DEBUG_OBJECT (self, "%" GST_PTR_FORMAT " done, %u ranges left",
+          GST_MESSAGE_SRC (msg), self->segments_running - 1);
+
+      if (--self->segments_running > 0)
+        break;
+
+      tick_cb (self);
+      gst_transcoder_clear_segments (self);
+      if (!gst_transcoder_start_concat (self)) {
+        gst_transcoder_post_error (self, "Could not concatenate the ranges");
+        remove_tick_source (self);
+        gst_transcoder_clear_parallel (self);
+        notify_state_changed (self, GST_TRANSCODER_STATE_STOPPED);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+static gboolean
+gst_transcoder_start_segments (GstTranscoder * self, GstClockTime duration,
+    guint n_segments)
+{
+  GError *err = NULL;
+  gboolean avoid_reencoding;
+  guint cpu_usage, i;
+
+  self->segments_dir = g_dir_make_tmp ("gst-transcoder-XXXXXX", &err);
+  if (!self->segments_dir) {
+    GST_ERROR_OBJECT (self, "Could not create temporary directory: %s",
+        err->message);
+    g_clear_error (&err);
+    return FALSE;
+  }
+
+  g_object_get (self->transcodebin, "avoid-reencoding", &avoid_reencoding,
+      NULL);
+  GST_OBJECT_LOCK (self);
+  cpu_usage = self->wanted_cpu_usage;
+  self->segment_pipelines =
+      g_ptr_array_new_with_free_func ((GDestroyNotify)
+      gst_transcoder_release_pipeline);
+  GST_OBJECT_UNLOCK (self);
+
+  self->last_duration = duration;
+  for (i = 0; i < n_segments; i++) {
+    GstClockTime start, stop = GST_CLOCK_TIME_NONE;
+    GstElement *pipeline;
+    gchar *name, *path, *uri;
+    GstBus *bus;
+
+    pipeline = gst_element_factory_make ("uritranscodebin", NULL);
+    if (!pipeline)
+      return FALSE;
+
+    start = gst_util_uint64_scale (duration, i, n_segments);
+    if (i < n_segments - 1)
+      stop = gst_util_uint64_scale (duration, i + 1, n_segments);
+
+    name = g_strdup_printf ("part-%05u", i);
+    path = g_build_filename (self->segments_dir, name, NULL);
+    uri = gst_filename_to_uri (path, NULL);
+    g_object_set (pipeline, "source-uri", self->source_uri, "dest-uri", uri,
+        "profile", self->profile, "avoid-reencoding", avoid_reencoding,
+        "cpu-usage", cpu_usage, "start-time", start, "stop-time", stop, NULL);
+    g_free (uri);
+    g_free (path);
+    g_free (name);
+
+    bus = gst_element_get_bus (pipeline);
+    gst_bus_add_signal_watch (bus);
+    g_signal_connect (bus, "message", G_CALLBACK (segment_message_cb), self);
+    gst_object_unref (bus);
+
+    GST_OBJECT_LOCK (self);
+    g_ptr_array_add (self->segment_pipelines, pipeline);
+    GST_OBJECT_UNLOCK (self);
+  }
+
+  self->segments_running = n_segments;
+  for (i = 0; i < n_segments; i++) {
+    if (gst_element_set_state (g_ptr_array_index (self->segment_pipelines, i),
+            GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+static gboolean
+gst_transcoder_run_parallel_internal (gpointer user_data)
+{
+  GstTranscoder *self = GST_TRANSCODER (user_data);
+  GstClockTime duration = GST_CLOCK_TIME_NONE;
+  gboolean seekable = FALSE;
+  GstDiscoverer *discoverer;
+  guint n_segments;
+
+  discoverer = gst_discoverer_new (DISCOVERER_TIMEOUT, NULL);
+  if (discoverer) {
+    GstDiscovererInfo *info =
+        gst_discoverer_discover_uri (discoverer, self->source_uri, NULL);
+
+    if (info) {
+      duration = gst_discoverer_info_get_duration (info);
+      seekable = gst_discoverer_info_get_seekable (info);
+      gst_discoverer_info_unref (info);
+    }
+    g_object_unref (discoverer);
+  }
+
+  GST_OBJECT_LOCK (self);
+  n_segments = self->parallel_segments;
+  GST_OBJECT_UNLOCK (self);
+
+  if (GST_CLOCK_TIME_IS_VALID (duration))
+    n_segments = MIN (n_segments, duration / MIN_SEGMENT_DURATION);
+
+  if (!seekable || !GST_CLOCK_TIME_IS_VALID (duration) || n_segments < 2) {
+    GST_INFO_OBJECT (self, "Input can't be split (seekable: %d, duration: %"
+        GST_TIME_FORMAT "), transcoding it in one go", seekable,
+        GST_TIME_ARGS (duration));
+    gst_transcoder_start (self);
+    return G_SOURCE_REMOVE;
+  }
+
+  GST_INFO_OBJECT (self, "Transcoding %" GST_TIME_FORMAT " in %u ranges",
+      GST_TIME_ARGS (duration), n_segments);
+
+  self->target_state = GST_STATE_PLAYING;
+  if (!gst_transcoder_start_segments (self, duration, n_segments)) {
+    gst_transcoder_post_error (self, "Could not start transcoding");
+    gst_transcoder_clear_parallel (self);
+    return G_SOURCE_REMOVE;
+  }
+
+  api_bus_post_message (self, GST_TRANSCODER_MESSAGE_DURATION_CHANGED,
+      GST_TRANSCODER_MESSAGE_DATA_DURATION, GST_TYPE_CLOCK_TIME, duration,
+      NULL);
+  notify_state_changed (self, GST_TRANSCODER_STATE_PLAYING);
+  add_tick_source (self);
+
+  return G_SOURCE_REMOVE;
+}
+
 static gpointer
 gst_transcoder_main (gpointer data)
 {
@@ -831,6 +1257,7 @@ gst_transcoder_main (gpointer data)
   gst_object_unref (bus);
 
   remove_tick_source (self);
+  gst_transcoder_clear_parallel (self);
 
   g_main_context_pop_thread_default (self->context);
 
@@ -1007,7 +1434,7 @@ gst_transcoder_run (GstTranscoder * self, GError ** error)
 void
 gst_transcoder_run_async (GstTranscoder * self)
 {
-  GstStateChangeReturn state_ret;
+  guint parallel_segments;
 
   g_return_if_fail (GST_IS_TRANSCODER (self));
 
@@ -1024,23 +1451,18 @@ gst_transcoder_run_async (GstTranscoder * self)
     return;
   }
 
-  self->target_state = GST_STATE_PLAYING;
-  state_ret = gst_element_set_state (self->transcodebin, GST_STATE_PLAYING);
-
-  if (state_ret == GST_STATE_CHANGE_FAILURE) {
-    GError *err = g_error_new (GST_TRANSCODER_ERROR,
-        GST_TRANSCODER_ERROR_FAILED, "Could not start transcoding");
-    api_bus_post_message (self, GST_TRANSCODER_MESSAGE_ERROR,
-        GST_TRANSCODER_MESSAGE_DATA_ERROR, G_TYPE_ERROR, err, NULL);
-    g_error_free (err);
+  GST_OBJECT_LOCK (self);
+  parallel_segments = self->parallel_segments;
+  GST_OBJECT_UNLOCK (self);
 
+  /* Discovering the input to split it would block the caller */
+  if (parallel_segments > 1) {
+    g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT,
+        gst_transcoder_run_parallel_internal, self, NULL);
     return;
-  } else if (state_ret == GST_STATE_CHANGE_NO_PREROLL) {
-    self->is_live = TRUE;
-    GST_DEBUG_OBJECT (self, "Pipeline is live");
   }
 
-  return;
+  gst_transcoder_start (self);
 }
 
 static gboolean
@@ -1231,6 +1653,46 @@ gst_transcoder_set_avoid_reencoding (GstTranscoder * self,
   g_object_set (self->transcodebin, "avoid-reencoding", avoid_reencoding, NULL);
 }
 
+/**
+ * gst_transcoder_get_parallel_segments:
+ * @self: The #GstTranscoder to check the number of parallel segments of
+ *
+ * Returns: The number of time ranges the input gets split into to be
+ * transcoded in parallel, 1 if parallel transcoding is disabled.
+ *
+ * Since: 1.20
+ */
+guint
+gst_transcoder_get_parallel_segments (GstTranscoder * self)
+{
+  guint val;
+
+  g_return_val_if_fail (GST_IS_TRANSCODER (self), DEFAULT_PARALLEL_SEGMENTS);
+
+  g_object_get (self, "parallel-segments", &val, NULL);
+
+  return val;
+}
+
+/**
+ * gst_transcoder_set_parallel_segments:
+ * @self: The #GstTranscoder to set the number of parallel segments on
+ * @segments: Number of time ranges to split the input into, 1 to disable
+ * parallel transcoding
+ *
+ * See #GstTranscoder:parallel-segments. This must be called before
+ * gst_transcoder_run() or gst_transcoder_run_async().
+ *
+ * Since: 1.20
+ */
+void
+gst_transcoder_set_parallel_segments (GstTranscoder * self, guint segments)
+{
+  g_return_if_fail (GST_IS_TRANSCODER (self));
+
+  g_object_set (self, "parallel-segments", segments, NULL);
+}
+
 /**
  * gst_transcoder_error_get_name:
  * @error: a #GstTranscoderError
@@ -163,6 +163,13 @@ GST_TRANSCODER_API
 void gst_transcoder_set_avoid_reencoding                  (GstTranscoder * self,
                                                            gboolean avoid_reencoding);
 
+GST_TRANSCODER_API
+guint gst_transcoder_get_parallel_segments                (GstTranscoder * self);
+
+GST_TRANSCODER_API
+void gst_transcoder_set_parallel_segments                 (GstTranscoder * self,
+                                                           guint segments);
+
 #include "gsttranscoder-signal-adapter.h"
 
 GST_TRANSCODER_API
@@ -48,6 +48,13 @@ struct _GstUriDownloaderPrivate
   gboolean cancelled;
 };
 
+/* Persistent contexts shared by the source elements of all downloaders in
+ * the process, indexed by context type. This is how souphttpsrc shares its
+ * session, so all playlist and key fetches go through the same connection
+ * pool and reuse kept-alive connections to a host. */
+static GMutex shared_contexts_lock;
+static GHashTable *shared_contexts;
+
 static void gst_uri_downloader_finalize (GObject * object);
 static void gst_uri_downloader_dispose (GObject * object);
 
@@ -55,6 +62,8 @@ static GstFlowReturn gst_uri_downloader_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buf);
 static gboolean gst_uri_downloader_sink_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
+static gboolean gst_uri_downloader_sink_query (GstPad * pad, GstObject * parent,
+    GstQuery * query);
 static GstBusSyncReply gst_uri_downloader_bus_handler (GstBus * bus,
     GstMessage * message, gpointer data);
 
@@ -100,6 +109,8 @@ gst_uri_downloader_init (GstUriDownloader * downloader)
       GST_DEBUG_FUNCPTR (gst_uri_downloader_chain));
   gst_pad_set_event_function (downloader->priv->pad,
       GST_DEBUG_FUNCPTR (gst_uri_downloader_sink_event));
+  gst_pad_set_query_function (downloader->priv->pad,
+      GST_DEBUG_FUNCPTR (gst_uri_downloader_sink_query));
   gst_pad_set_element_private (downloader->priv->pad, downloader);
   gst_pad_set_active (downloader->priv->pad, TRUE);
 
@@ -175,6 +186,93 @@ gst_uri_downloader_set_parent (GstUriDownloader * downloader,
   g_weak_ref_set (&downloader->priv->parent, parent);
 }
 
+static GstContext *
+gst_uri_downloader_get_shared_context (const gchar * context_type)
+{
+  GstContext *context = NULL;
+
+  g_mutex_lock (&shared_contexts_lock);
+  if (shared_contexts)
+    context = g_hash_table_lookup (shared_contexts, context_type);
+  if (context)
+    gst_context_ref (context);
+  g_mutex_unlock (&shared_contexts_lock);
+
+  return context;
+}
+
+static void
+gst_uri_downloader_add_shared_context (GstUriDownloader * downloader,
+    GstContext * context)
+{
+  const gchar *context_type = gst_context_get_context_type (context);
+
+  if (!gst_context_is_persistent (context))
+    return;
+
+  g_mutex_lock (&shared_contexts_lock);
+  if (!shared_contexts) {
+    shared_contexts = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify) gst_context_unref);
+  }
+  /* Keep the first one, every later source is handed that same context */
+  if (!g_hash_table_contains (shared_contexts, context_type)) {
+    GST_DEBUG_OBJECT (downloader, "Sharing context %s", context_type);
+    g_hash_table_insert (shared_contexts, g_strdup (context_type),
+        gst_context_ref (context));
+  }
+  g_mutex_unlock (&shared_contexts_lock);
+}
+
+/* Looks up a context for the source element, preferring the one of the
+ * pipeline over the process-wide one */
+static GstContext *
+gst_uri_downloader_find_context (GstUriDownloader * downloader,
+    const gchar * context_type)
+{
+  GstElement *parent = g_weak_ref_get (&downloader->priv->parent);
+  GstContext *context = NULL;
+
+  if (parent) {
+    context = gst_element_get_context (parent, context_type);
+    gst_object_unref (parent);
+  }
+
+  if (!context)
+    context = gst_uri_downloader_get_shared_context (context_type);
+
+  return context;
+}
+
+static gboolean
+gst_uri_downloader_sink_query (GstPad * pad, GstObject * parent,
+    GstQuery * query)
+{
+  GstUriDownloader *downloader;
+
+  downloader = GST_URI_DOWNLOADER (gst_pad_get_element_private (pad));
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CONTEXT:{
+      const gchar *context_type;
+      GstContext *context;
+
+      gst_query_parse_context_type (query, &context_type);
+      context = gst_uri_downloader_find_context (downloader, context_type);
+      if (context) {
+        gst_query_set_context (query, context);
+        gst_context_unref (context);
+        return TRUE;
+      }
+      break;
+    }
+    default:
+      break;
+  }
+
+  return gst_pad_query_default (pad, parent, query);
+}
+
 static gboolean
 gst_uri_downloader_sink_event (GstPad * pad, GstObject * parent,
     GstEvent * event)
@@ -280,25 +378,32 @@ gst_uri_downloader_bus_handler (GstBus * bus,
   } else if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_NEED_CONTEXT) {
     GstElement *parent = g_weak_ref_get (&downloader->priv->parent);
 
-    /* post the same need-context as if it was from the parent and then
-     * get it to our internal element that requested it */
-    if (parent && GST_IS_ELEMENT (GST_MESSAGE_SRC (message))) {
+    if (GST_IS_ELEMENT (GST_MESSAGE_SRC (message))) {
       const gchar *context_type;
-      GstContext *context;
+      GstContext *context = NULL;
       GstElement *msg_src = GST_ELEMENT_CAST (GST_MESSAGE_SRC (message));
 
       gst_message_parse_context_type (message, &context_type);
-      context = gst_element_get_context (parent, context_type);
-
-      /* No context, request one */
-      if (!context) {
-        GstMessage *need_context_msg =
-            gst_message_new_need_context (GST_OBJECT_CAST (parent),
-            context_type);
-        gst_element_post_message (parent, need_context_msg);
+
+      /* post the same need-context as if it was from the parent and then
+       * get it to our internal element that requested it */
+      if (parent) {
         context = gst_element_get_context (parent, context_type);
+
+        /* No context, request one */
+        if (!context) {
+          GstMessage *need_context_msg =
+              gst_message_new_need_context (GST_OBJECT_CAST (parent),
+              context_type);
+          gst_element_post_message (parent, need_context_msg);
+          context = gst_element_get_context (parent, context_type);
+        }
       }
 
+      /* Otherwise use the one shared by all downloaders */
+      if (!context)
+        context = gst_uri_downloader_get_shared_context (context_type);
+
       if (context) {
         gst_element_set_context (msg_src, context);
         gst_context_unref (context);
@@ -306,6 +411,12 @@ gst_uri_downloader_bus_handler (GstBus * bus,
     }
     if (parent)
       gst_object_unref (parent);
+  } else if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_HAVE_CONTEXT) {
+    GstContext *context;
+
+    gst_message_parse_have_context (message, &context);
+    gst_uri_downloader_add_shared_context (downloader, context);
+    gst_context_unref (context);
   }
 
   gst_message_unref (message);
@@ -23,6 +23,7 @@
 #endif
 
 #include "gstvkbuffermemory.h"
+#include "gstvkdevice-private.h"
 
 /**
  * SECTION:vkbuffermemory
@@ -38,10 +39,11 @@
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFUALT);
 
 static GstAllocator *_vulkan_buffer_memory_allocator;
+static GQuark _pending_fence_quark;
 
 static gboolean
-_create_info_from_args (VkBufferCreateInfo * info, gsize size,
-    VkBufferUsageFlags usage)
+_create_info_from_args (VkBufferCreateInfo * info, GstVulkanDevice * device,
+    gsize size, VkBufferUsageFlags usage)
 {
   /* FIXME: validate these */
   /* *INDENT-OFF* */
@@ -57,6 +59,20 @@ _create_info_from_args (VkBufferCreateInfo * info, gsize size,
   };
   /* *INDENT-ON* */
 
+  if (device) {
+    const guint32 *families;
+    guint n_families;
+
+    /* shared with the transfer queue without queue family ownership
+     * transfers */
+    families = gst_vulkan_device_get_queue_family_indices (device, &n_families);
+    if (n_families > 1) {
+      info->sharingMode = VK_SHARING_MODE_CONCURRENT;
+      info->queueFamilyIndexCount = n_families;
+      info->pQueueFamilyIndices = families;
+    }
+  }
+
   return TRUE;
 }
 
@@ -109,7 +125,7 @@ _vk_buffer_mem_new_alloc (GstAllocator * allocator, GstMemory * parent,
   VkBuffer buffer;
   VkResult err;
 
-  if (!_create_info_from_args (&buffer_info, size, usage)) {
+  if (!_create_info_from_args (&buffer_info, device, size, usage)) {
     GST_CAT_ERROR (GST_CAT_VULKAN_BUFFER_MEMORY, "Incorrect buffer parameters");
     goto error;
   }
@@ -190,8 +206,23 @@ _vk_buffer_mem_map_full (GstVulkanBufferMemory * mem, GstMapInfo * info,
     gsize size)
 {
   GstMapInfo *vk_map_info;
+  GstVulkanFence *fence;
+
+  /* wait for any outstanding GPU access before touching the contents */
+  g_mutex_lock (&mem->lock);
+  fence = gst_mini_object_get_qdata (GST_MINI_OBJECT_CAST (mem),
+      _pending_fence_quark);
+  if (fence)
+    gst_vulkan_fence_ref (fence);
+  g_mutex_unlock (&mem->lock);
+
+  if (fence) {
+    if (!gst_vulkan_fence_wait (fence, G_MAXUINT64))
+      GST_CAT_WARNING (GST_CAT_VULKAN_BUFFER_MEMORY, "Failed to wait for "
+          "pending GPU access of buffer memory:%p", mem);
+    gst_vulkan_fence_unref (fence);
+  }
 
-  /* FIXME: possible barrier needed */
   g_mutex_lock (&mem->lock);
 
   if (!mem->vk_mem) {
@@ -297,6 +328,30 @@ gst_vulkan_buffer_memory_alloc (GstVulkanDevice * device, gsize size,
   return (GstMemory *) mem;
 }
 
+/**
+ * gst_vulkan_buffer_memory_set_pending_fence:
+ * @mem: a #GstVulkanBufferMemory
+ * @fence: (nullable): a submitted #GstVulkanFence
+ *
+ * Marks @mem as being accessed by GPU work that completes when @fence is
+ * signalled.  Mapping @mem will wait for @fence which allows the producer
+ * to hand @mem downstream without waiting itself.
+ *
+ * Since: 1.20
+ */
+void
+gst_vulkan_buffer_memory_set_pending_fence (GstVulkanBufferMemory * mem,
+    GstVulkanFence * fence)
+{
+  g_return_if_fail (gst_is_vulkan_buffer_memory ((GstMemory *) mem));
+
+  g_mutex_lock (&mem->lock);
+  gst_mini_object_set_qdata (GST_MINI_OBJECT_CAST (mem), _pending_fence_quark,
+      fence ? gst_vulkan_fence_ref (fence) : NULL,
+      (GDestroyNotify) gst_vulkan_fence_unref);
+  g_mutex_unlock (&mem->lock);
+}
+
 /**
  * gst_vulkan_buffer_memory_wrapped:
  * @device: a #GstVulkanDevice
@@ -369,6 +424,9 @@ gst_vulkan_buffer_memory_init_once (void)
     GST_DEBUG_CATEGORY_INIT (GST_CAT_VULKAN_BUFFER_MEMORY, "vulkanbuffermemory",
         0, "Vulkan Buffer Memory");
 
+    _pending_fence_quark =
+        g_quark_from_static_string ("GstVulkanBufferMemoryPendingFence");
+
     _vulkan_buffer_memory_allocator =
         g_object_new (gst_vulkan_buffer_memory_allocator_get_type (), NULL);
     gst_object_ref_sink (_vulkan_buffer_memory_allocator);
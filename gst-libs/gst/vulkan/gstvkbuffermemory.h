@@ -157,6 +157,10 @@ GstMemory *     gst_vulkan_buffer_memory_wrapped         (GstVulkanDevice * devi
                                                          gpointer user_data,
                                                          GDestroyNotify notify);
 
+GST_VULKAN_API
+void            gst_vulkan_buffer_memory_set_pending_fence (GstVulkanBufferMemory * mem,
+                                                         GstVulkanFence * fence);
+
 G_END_DECLS
 
 #endif /* __GST_VULKAN_BUFFER_MEMORY_H__ */
@@ -33,6 +33,8 @@
  */
 
 #define GST_VULKAN_COMMAND_POOL_LARGE_OUTSTANDING 1024
+/* upper bound of command buffers allocated at once when the pool grows */
+#define GST_VULKAN_COMMAND_POOL_MAX_BATCH 8
 
 #define GET_PRIV(pool) gst_vulkan_command_pool_get_instance_private (pool)
 
@@ -41,11 +43,14 @@ GST_DEBUG_CATEGORY (GST_CAT_DEFAULT);
 
 struct _GstVulkanCommandPoolPrivate
 {
-  GQueue *available;
+  /* recycled command buffers, acquired and released without taking
+   * @rec_mutex */
+  GstAtomicQueue *available;
 
   GRecMutex rec_mutex;
 
-  gsize outstanding;
+  gint outstanding;
+  guint n_allocated;
 };
 
 #define parent_class gst_vulkan_command_pool_parent_class
@@ -62,7 +67,7 @@ gst_vulkan_command_pool_init (GstVulkanCommandPool * pool)
   GstVulkanCommandPoolPrivate *priv = GET_PRIV (pool);
 
   g_rec_mutex_init (&priv->rec_mutex);
-  priv->available = g_queue_new ();
+  priv->available = gst_atomic_queue_new (GST_VULKAN_COMMAND_POOL_MAX_BATCH);
 }
 
 static void
@@ -84,13 +89,16 @@ gst_vulkan_command_pool_finalize (GObject * object)
 {
   GstVulkanCommandPool *pool = GST_VULKAN_COMMAND_POOL (object);
   GstVulkanCommandPoolPrivate *priv = GET_PRIV (pool);
+  GstVulkanCommandBuffer *cmd;
 
   gst_vulkan_command_pool_lock (pool);
-  g_queue_free_full (priv->available, (GDestroyNotify) do_free_buffer);
+  while ((cmd = gst_atomic_queue_pop (priv->available)))
+    do_free_buffer (cmd);
+  gst_atomic_queue_unref (priv->available);
   priv->available = NULL;
   gst_vulkan_command_pool_unlock (pool);
 
-  if (priv->outstanding > 0)
+  if (g_atomic_int_get (&priv->outstanding) > 0)
     g_critical
         ("Destroying a Vulkan command pool that has outstanding buffers!");
 
@@ -121,30 +129,46 @@ gst_vulkan_command_pool_get_queue (GstVulkanCommandPool * pool)
   return pool->queue ? gst_object_ref (pool->queue) : NULL;
 }
 
+/* The pool grows by the number of command buffers already allocated, up to
+ * GST_VULKAN_COMMAND_POOL_MAX_BATCH at a time.  The buffers that are not
+ * returned are added to the available ones. */
 static GstVulkanCommandBuffer *
 command_alloc (GstVulkanCommandPool * pool, GError ** error)
 {
-  VkResult err;
+  GstVulkanCommandPoolPrivate *priv = GET_PRIV (pool);
+  VkCommandBuffer cmds[GST_VULKAN_COMMAND_POOL_MAX_BATCH];
   VkCommandBufferAllocateInfo cmd_info = { 0, };
-  GstVulkanCommandBuffer *buf;
-  VkCommandBuffer cmd;
+  GstVulkanCommandBuffer *buf = NULL;
+  VkResult err;
+  guint i, n;
+
+  gst_vulkan_command_pool_lock (pool);
+  n = CLAMP (priv->n_allocated, 1, GST_VULKAN_COMMAND_POOL_MAX_BATCH);
 
   cmd_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
   cmd_info.pNext = NULL;
   cmd_info.commandPool = pool->pool;
   cmd_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-  cmd_info.commandBufferCount = 1;
+  cmd_info.commandBufferCount = n;
 
-  gst_vulkan_command_pool_lock (pool);
-  err = vkAllocateCommandBuffers (pool->queue->device->device, &cmd_info, &cmd);
+  err = vkAllocateCommandBuffers (pool->queue->device->device, &cmd_info, cmds);
+  if (err == VK_SUCCESS)
+    priv->n_allocated += n;
   gst_vulkan_command_pool_unlock (pool);
   if (gst_vulkan_error_to_g_error (err, error, "vkCreateCommandBuffer") < 0)
     return NULL;
 
-  buf =
-      gst_vulkan_command_buffer_new_wrapped (cmd,
-      VK_COMMAND_BUFFER_LEVEL_PRIMARY);
-  GST_LOG_OBJECT (pool, "created cmd buffer %p", buf);
+  for (i = 0; i < n; i++) {
+    GstVulkanCommandBuffer *cmd =
+        gst_vulkan_command_buffer_new_wrapped (cmds[i],
+        VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+    GST_LOG_OBJECT (pool, "created cmd buffer %p", cmd);
+
+    if (!buf)
+      buf = cmd;
+    else
+      gst_atomic_queue_push (priv->available, cmd);
+  }
 
   return buf;
 }
@@ -178,11 +202,8 @@ gst_vulkan_command_pool_create (GstVulkanCommandPool * pool, GError ** error)
 
   priv = GET_PRIV (pool);
 
-  if (gst_vulkan_command_pool_can_reset (pool)) {
-    gst_vulkan_command_pool_lock (pool);
-    cmd = g_queue_pop_head (priv->available);
-    gst_vulkan_command_pool_unlock (pool);
-  }
+  if (gst_vulkan_command_pool_can_reset (pool))
+    cmd = gst_atomic_queue_pop (priv->available);
   if (!cmd)
     cmd = command_alloc (pool, error);
   if (!cmd)
@@ -190,13 +211,11 @@ gst_vulkan_command_pool_create (GstVulkanCommandPool * pool, GError ** error)
 
   cmd->pool = gst_object_ref (pool);
 
-  gst_vulkan_command_pool_lock (pool);
-  priv->outstanding++;
-  if (priv->outstanding > GST_VULKAN_COMMAND_POOL_LARGE_OUTSTANDING)
+  if (g_atomic_int_add (&priv->outstanding,
+          1) >= GST_VULKAN_COMMAND_POOL_LARGE_OUTSTANDING)
     g_critical ("%s: There are a large number of command buffers outstanding! "
         "This usually means there is a reference counting issue somewhere.",
         GST_OBJECT_NAME (pool));
-  gst_vulkan_command_pool_unlock (pool);
   return cmd;
 }
 
@@ -214,19 +233,23 @@ gst_vulkan_command_pool_release_buffer (GstVulkanCommandPool * pool,
   priv = GET_PRIV (pool);
   can_reset = gst_vulkan_command_pool_can_reset (pool);
 
-  gst_vulkan_command_pool_lock (pool);
-  if (can_reset) {
-    vkResetCommandBuffer (buffer->cmd, 0);
-    g_queue_push_tail (priv->available, buffer);
-    GST_TRACE_OBJECT (pool, "reset command buffer %p", buffer);
-  }
+  /* the buffer may be acquired by another thread as soon as it is
+   * available, the reference to us is dropped afterwards */
+  buffer->pool = NULL;
+
   /* TODO: if this is a secondary command buffer, all primary command buffers
    * that reference this command buffer will be invalid */
-  priv->outstanding--;
-  gst_vulkan_command_pool_unlock (pool);
+  g_atomic_int_add (&priv->outstanding, -1);
+  if (can_reset) {
+    /* The pool is created with VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT
+     * so the next vkBeginCommandBuffer() implicitly resets the buffer under
+     * the pool lock. */
+    gst_atomic_queue_push (priv->available, buffer);
+    GST_TRACE_OBJECT (pool, "recycled command buffer %p", buffer);
+  }
 
   /* decrease the refcount that the buffer had to us */
-  gst_clear_object (&buffer->pool);
+  gst_object_unref (pool);
 
   if (!can_reset)
     gst_vulkan_command_buffer_unref (buffer);
@@ -131,11 +131,16 @@ gst_vulkan_descriptor_cache_release_impl (GstVulkanHandlePool * pool,
     gpointer handle)
 {
   GstVulkanDescriptorSet *set = handle;
+  GstVulkanDescriptorCache *cache;
+
+  /* the set may be acquired by another thread as soon as it is released */
+  cache = set->cache;
+  set->cache = NULL;
 
   GST_VULKAN_HANDLE_POOL_CLASS (parent_class)->release (pool, handle);
 
   /* decrease the refcount that the set had to us */
-  gst_clear_object (&set->cache);
+  gst_clear_object (&cache);
 }
 
 static void
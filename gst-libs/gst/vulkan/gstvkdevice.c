@@ -23,6 +23,7 @@
 #endif
 
 #include "gstvkdevice.h"
+#include "gstvkdevice-private.h"
 #include "gstvkdebug.h"
 
 #include <string.h>
@@ -51,6 +52,10 @@ enum
 
 static void gst_vulkan_device_dispose (GObject * object);
 static void gst_vulkan_device_finalize (GObject * object);
+static gboolean gst_vulkan_device_is_extension_enabled_unlocked (GstVulkanDevice
+    * device, const gchar * name, guint * index);
+
+#define MAX_QUEUE_FAMILIES 2
 
 struct _GstVulkanDevicePrivate
 {
@@ -58,10 +63,18 @@ struct _GstVulkanDevicePrivate
   GPtrArray *enabled_extensions;
 
   gboolean opened;
-  guint queue_family_id;
-  guint n_queues;
+  /* the graphics family first, then a dedicated transfer family if any */
+  guint n_queue_families;
+  guint32 queue_family_ids[MAX_QUEUE_FAMILIES];
+  guint n_queues[MAX_QUEUE_FAMILIES];
+  /* the first queue of each family, shared between all users so that
+   * submissions are serialised and can depend on each other */
+  GWeakRef queues[MAX_QUEUE_FAMILIES];
 
   GstVulkanFenceCache *fence_cache;
+
+  VkPipelineCache pipeline_cache;
+  gchar *pipeline_cache_path;
 };
 
 static void
@@ -167,9 +180,13 @@ static void
 gst_vulkan_device_init (GstVulkanDevice * device)
 {
   GstVulkanDevicePrivate *priv = GET_PRIV (device);
+  guint i;
 
   priv->enabled_layers = g_ptr_array_new_with_free_func (g_free);
   priv->enabled_extensions = g_ptr_array_new_with_free_func (g_free);
+
+  for (i = 0; i < MAX_QUEUE_FAMILIES; i++)
+    g_weak_ref_init (&priv->queues[i], NULL);
 }
 
 static void
@@ -182,6 +199,26 @@ gst_vulkan_device_constructed (GObject * object)
   /* by default allow vkswapper to work for rendering to an output window.
    * Ignore the failure if the extension does not exist. */
   gst_vulkan_device_enable_extension (device, VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+#if defined (VK_KHR_timeline_semaphore)
+  /* used by gst_vulkan_queue_create_fence() when available */
+  gst_vulkan_device_enable_extension (device,
+      VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+#endif
+#if defined (VK_KHR_external_memory_fd) && defined (VK_EXT_external_memory_dma_buf)
+  /* allows vulkanupload to import dmabufs without a copy */
+  gst_vulkan_device_enable_extension (device,
+      VK_KHR_EXTERNAL_MEMORY_EXTENSION_NAME);
+  gst_vulkan_device_enable_extension (device,
+      VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME);
+  gst_vulkan_device_enable_extension (device,
+      VK_EXT_EXTERNAL_MEMORY_DMA_BUF_EXTENSION_NAME);
+#endif
+#if defined (VK_EXT_image_drm_format_modifier)
+  gst_vulkan_device_enable_extension (device,
+      VK_KHR_IMAGE_FORMAT_LIST_EXTENSION_NAME);
+  gst_vulkan_device_enable_extension (device,
+      VK_EXT_IMAGE_DRM_FORMAT_MODIFIER_EXTENSION_NAME);
+#endif
 
   G_OBJECT_CLASS (parent_class)->constructed (object);
 }
@@ -226,16 +263,178 @@ gst_vulkan_device_dispose (GObject * object)
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
 
+static gchar *
+_get_pipeline_cache_path (GstVulkanDevice * device)
+{
+  const VkPhysicalDeviceProperties *props = &device->physical_device->properties;
+  const gchar *env = g_getenv ("GST_VULKAN_PIPELINE_CACHE_DIR");
+  GString *filename;
+  gchar *cache_dir, *ret;
+  guint i;
+
+  if (env) {
+    /* an empty value disables the on disk cache */
+    if (!env[0])
+      return NULL;
+    cache_dir = g_strdup (env);
+  } else {
+    cache_dir = g_build_filename (g_get_user_cache_dir (), "gstreamer-1.0",
+        "vulkan-pipelines", NULL);
+  }
+
+  /* the pipeline cache UUID changes with anything affecting the validity of
+   * the cached data, e.g. driver updates */
+  filename = g_string_new (NULL);
+  g_string_append_printf (filename, "%04x-%04x-", props->vendorID,
+      props->deviceID);
+  for (i = 0; i < VK_UUID_SIZE; i++)
+    g_string_append_printf (filename, "%02x", props->pipelineCacheUUID[i]);
+  g_string_append (filename, ".bin");
+
+  ret = g_build_filename (cache_dir, filename->str, NULL);
+  g_string_free (filename, TRUE);
+  g_free (cache_dir);
+
+  return ret;
+}
+
+/* drivers are supposed to ignore incompatible data but don't trust them
+ * with files that might have been truncated or written by another driver */
+static gboolean
+_pipeline_cache_data_is_valid (GstVulkanDevice * device, const guint8 * data,
+    gsize size)
+{
+  const VkPhysicalDeviceProperties *props = &device->physical_device->properties;
+  guint32 header_size, header_version, vendor_id, device_id;
+
+  if (size < 16 + VK_UUID_SIZE)
+    return FALSE;
+
+  memcpy (&header_size, &data[0], 4);
+  memcpy (&header_version, &data[4], 4);
+  memcpy (&vendor_id, &data[8], 4);
+  memcpy (&device_id, &data[12], 4);
+
+  return header_size >= 16 + VK_UUID_SIZE && header_size <= size
+      && header_version == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+      && vendor_id == props->vendorID && device_id == props->deviceID
+      && memcmp (&data[16], props->pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+static void
+_create_pipeline_cache (GstVulkanDevice * device)
+{
+  GstVulkanDevicePrivate *priv = GET_PRIV (device);
+  VkPipelineCacheCreateInfo cache_info = { 0, };
+  GError *error = NULL;
+  gchar *data = NULL;
+  gsize size = 0;
+  VkResult err;
+
+  priv->pipeline_cache_path = _get_pipeline_cache_path (device);
+
+  if (priv->pipeline_cache_path) {
+    if (g_file_get_contents (priv->pipeline_cache_path, &data, &size, NULL)) {
+      if (!_pipeline_cache_data_is_valid (device, (guint8 *) data, size)) {
+        GST_INFO_OBJECT (device, "Ignoring incompatible pipeline cache %s",
+            priv->pipeline_cache_path);
+        g_clear_pointer (&data, g_free);
+        size = 0;
+      } else {
+        GST_DEBUG_OBJECT (device, "Loaded %" G_GSIZE_FORMAT " bytes of "
+            "pipeline cache from %s", size, priv->pipeline_cache_path);
+      }
+    }
+  }
+
+  cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  cache_info.pNext = NULL;
+  cache_info.flags = 0;
+  cache_info.initialDataSize = size;
+  cache_info.pInitialData = data;
+
+  err = vkCreatePipelineCache (device->device, &cache_info, NULL,
+      &priv->pipeline_cache);
+  if (err != VK_SUCCESS && data) {
+    GST_WARNING_OBJECT (device, "Failed to create a pipeline cache from %s, "
+        "starting with an empty cache", priv->pipeline_cache_path);
+    cache_info.initialDataSize = 0;
+    cache_info.pInitialData = NULL;
+    err = vkCreatePipelineCache (device->device, &cache_info, NULL,
+        &priv->pipeline_cache);
+  }
+  if (gst_vulkan_error_to_g_error (err, &error, "vkCreatePipelineCache") < 0) {
+    /* not fatal, pipelines are then created without a cache */
+    GST_WARNING_OBJECT (device, "%s", error->message);
+    g_clear_error (&error);
+    priv->pipeline_cache = VK_NULL_HANDLE;
+  }
+
+  g_free (data);
+}
+
+static void
+_save_pipeline_cache (GstVulkanDevice * device)
+{
+  GstVulkanDevicePrivate *priv = GET_PRIV (device);
+  GError *error = NULL;
+  gchar *data, *dir;
+  size_t size = 0;
+  VkResult err;
+
+  if (!priv->pipeline_cache || !priv->pipeline_cache_path)
+    return;
+
+  err = vkGetPipelineCacheData (device->device, priv->pipeline_cache, &size,
+      NULL);
+  if (err != VK_SUCCESS || size == 0)
+    return;
+
+  data = g_malloc (size);
+  err = vkGetPipelineCacheData (device->device, priv->pipeline_cache, &size,
+      data);
+  if (err != VK_SUCCESS) {
+    g_free (data);
+    return;
+  }
+
+  dir = g_path_get_dirname (priv->pipeline_cache_path);
+  g_mkdir_with_parents (dir, 0755);
+  g_free (dir);
+
+  /* written atomically so concurrent processes never see partial data */
+  if (!g_file_set_contents (priv->pipeline_cache_path, data, size, &error)) {
+    GST_WARNING_OBJECT (device, "Failed to save the pipeline cache: %s",
+        error->message);
+    g_clear_error (&error);
+  } else {
+    GST_DEBUG_OBJECT (device, "Saved %" G_GSIZE_FORMAT " bytes of pipeline "
+        "cache to %s", (gsize) size, priv->pipeline_cache_path);
+  }
+
+  g_free (data);
+}
+
 static void
 gst_vulkan_device_finalize (GObject * object)
 {
   GstVulkanDevice *device = GST_VULKAN_DEVICE (object);
   GstVulkanDevicePrivate *priv = GET_PRIV (device);
+  guint i;
+
+  for (i = 0; i < MAX_QUEUE_FAMILIES; i++)
+    g_weak_ref_clear (&priv->queues[i]);
 
   if (device->device) {
     vkDeviceWaitIdle (device->device);
+    if (priv->pipeline_cache) {
+      _save_pipeline_cache (device);
+      vkDestroyPipelineCache (device->device, priv->pipeline_cache, NULL);
+    }
+    priv->pipeline_cache = VK_NULL_HANDLE;
     vkDestroyDevice (device->device, NULL);
   }
+  g_clear_pointer (&priv->pipeline_cache_path, g_free);
   device->device = VK_NULL_HANDLE;
 
   gst_clear_object (&device->physical_device);
@@ -291,8 +490,25 @@ gst_vulkan_device_open (GstVulkanDevice * device, GError ** error)
         "Failed to find a compatible queue family");
     goto error;
   }
-  priv->queue_family_id = i;
-  priv->n_queues = 1;
+  priv->queue_family_ids[0] = i;
+  priv->n_queues[0] = 1;
+  priv->n_queue_families = 1;
+
+  /* A family that can only transfer is usually backed by a dedicated DMA
+   * engine that runs concurrently with graphics and compute work */
+  for (i = 0; i < device->physical_device->n_queue_families; i++) {
+    VkQueueFlags flags =
+        device->physical_device->queue_family_props[i].queueFlags;
+
+    if ((flags & VK_QUEUE_TRANSFER_BIT) != 0
+        && (flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) == 0) {
+      GST_DEBUG_OBJECT (device, "using queue family %u for transfers", i);
+      priv->queue_family_ids[priv->n_queue_families] = i;
+      priv->n_queues[priv->n_queue_families] = 1;
+      priv->n_queue_families++;
+      break;
+    }
+  }
 
   GST_INFO_OBJECT (device, "Creating a device from physical %" GST_PTR_FORMAT
       " with %u layers and %u extensions", device->physical_device,
@@ -306,20 +522,36 @@ gst_vulkan_device_open (GstVulkanDevice * device, GError ** error)
         (gchar *) g_ptr_array_index (priv->enabled_extensions, i));
 
   {
-    VkDeviceQueueCreateInfo queue_info = { 0, };
+    VkDeviceQueueCreateInfo queue_info[MAX_QUEUE_FAMILIES] = { {0,}, };
     VkDeviceCreateInfo device_info = { 0, };
     gfloat queue_priority = 0.5;
+#if defined (VK_KHR_timeline_semaphore)
+    VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timeline_features = { 0, };
+#endif
 
-    queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-    queue_info.pNext = NULL;
-    queue_info.queueFamilyIndex = priv->queue_family_id;
-    queue_info.queueCount = priv->n_queues;
-    queue_info.pQueuePriorities = &queue_priority;
+    for (i = 0; i < priv->n_queue_families; i++) {
+      queue_info[i].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+      queue_info[i].pNext = NULL;
+      queue_info[i].queueFamilyIndex = priv->queue_family_ids[i];
+      queue_info[i].queueCount = priv->n_queues[i];
+      queue_info[i].pQueuePriorities = &queue_priority;
+    }
 
     device_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     device_info.pNext = NULL;
-    device_info.queueCreateInfoCount = 1;
-    device_info.pQueueCreateInfos = &queue_info;
+#if defined (VK_KHR_timeline_semaphore)
+    /* the feature is mandatory for implementations exposing the extension */
+    if (gst_vulkan_device_is_extension_enabled_unlocked (device,
+            VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME, NULL)) {
+      timeline_features.sType =
+          VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+      timeline_features.pNext = NULL;
+      timeline_features.timelineSemaphore = VK_TRUE;
+      device_info.pNext = &timeline_features;
+    }
+#endif
+    device_info.queueCreateInfoCount = priv->n_queue_families;
+    device_info.pQueueCreateInfos = queue_info;
     device_info.enabledLayerCount = priv->enabled_layers->len;
     device_info.ppEnabledLayerNames =
         (const char *const *) priv->enabled_layers->pdata;
@@ -338,6 +570,8 @@ gst_vulkan_device_open (GstVulkanDevice * device, GError ** error)
   /* avoid reference loops between us and the fence cache */
   gst_object_unref (device);
 
+  _create_pipeline_cache (device);
+
   priv->opened = TRUE;
   GST_OBJECT_UNLOCK (device);
   return TRUE;
@@ -355,7 +589,10 @@ error:
  * @queue_family: a queue family to retrieve
  * @queue_i: index of the family to retrieve
  *
- * Returns: (transfer full): a new #GstVulkanQueue
+ * All callers retrieving the same queue share the returned #GstVulkanQueue
+ * while it is alive.
+ *
+ * Returns: (transfer full): the #GstVulkanQueue
  *
  * Since: 1.18
  */
@@ -365,22 +602,32 @@ gst_vulkan_device_get_queue (GstVulkanDevice * device, guint32 queue_family,
 {
   GstVulkanDevicePrivate *priv = GET_PRIV (device);
   GstVulkanQueue *ret;
+  guint i;
 
   g_return_val_if_fail (GST_IS_VULKAN_DEVICE (device), NULL);
   g_return_val_if_fail (device->device != NULL, NULL);
   g_return_val_if_fail (priv->opened, NULL);
-  g_return_val_if_fail (queue_family < priv->n_queues, NULL);
-  g_return_val_if_fail (queue_i <
-      device->physical_device->queue_family_props[queue_family].queueCount,
-      NULL);
 
-  ret = g_object_new (GST_TYPE_VULKAN_QUEUE, NULL);
-  gst_object_ref_sink (ret);
-  ret->device = gst_object_ref (device);
-  ret->family = queue_family;
-  ret->index = queue_i;
+  for (i = 0; i < priv->n_queue_families; i++) {
+    if (priv->queue_family_ids[i] == queue_family)
+      break;
+  }
+  g_return_val_if_fail (i < priv->n_queue_families, NULL);
+  g_return_val_if_fail (queue_i < priv->n_queues[i], NULL);
 
-  vkGetDeviceQueue (device->device, queue_family, queue_i, &ret->queue);
+  GST_OBJECT_LOCK (device);
+  ret = g_weak_ref_get (&priv->queues[i]);
+  if (!ret) {
+    ret = g_object_new (GST_TYPE_VULKAN_QUEUE, NULL);
+    gst_object_ref_sink (ret);
+    ret->device = gst_object_ref (device);
+    ret->family = queue_family;
+    ret->index = queue_i;
+
+    vkGetDeviceQueue (device->device, queue_family, queue_i, &ret->queue);
+    g_weak_ref_set (&priv->queues[i], ret);
+  }
+  GST_OBJECT_UNLOCK (device);
 
   return ret;
 }
@@ -401,22 +648,37 @@ gst_vulkan_device_foreach_queue (GstVulkanDevice * device,
 {
   GstVulkanDevicePrivate *priv = GET_PRIV (device);
   gboolean done = FALSE;
-  guint i;
+  guint i, j;
 
-  for (i = 0; i < priv->n_queues; i++) {
-    GstVulkanQueue *queue =
-        gst_vulkan_device_get_queue (device, priv->queue_family_id, i);
+  for (i = 0; i < priv->n_queue_families && !done; i++) {
+    for (j = 0; j < priv->n_queues[i]; j++) {
+      GstVulkanQueue *queue =
+          gst_vulkan_device_get_queue (device, priv->queue_family_ids[i], j);
 
-    if (!func (device, queue, user_data))
-      done = TRUE;
+      if (!func (device, queue, user_data))
+        done = TRUE;
 
-    gst_object_unref (queue);
+      gst_object_unref (queue);
 
-    if (done)
-      break;
+      if (done)
+        break;
+    }
   }
 }
 
+/* the queue families that resources may be shared between */
+const guint32 *
+gst_vulkan_device_get_queue_family_indices (GstVulkanDevice * device,
+    guint * n_families)
+{
+  GstVulkanDevicePrivate *priv = GET_PRIV (device);
+
+  g_return_val_if_fail (priv->opened, NULL);
+
+  *n_families = priv->n_queue_families;
+  return priv->queue_family_ids;
+}
+
 /**
  * gst_vulkan_device_get_proc_address:
  * @device: a #GstVulkanDevice
@@ -644,6 +906,32 @@ gst_vulkan_device_create_fence (GstVulkanDevice * device, GError ** error)
   return gst_vulkan_fence_cache_acquire (priv->fence_cache, error);
 }
 
+/**
+ * gst_vulkan_device_get_pipeline_cache:
+ * @device: a #GstVulkanDevice
+ *
+ * The returned `VkPipelineCache` is shared by every user of @device and
+ * should be passed to all pipeline creation functions.  Unless disabled by
+ * setting the `GST_VULKAN_PIPELINE_CACHE_DIR` environment variable to an
+ * empty string, its content is loaded from and saved to a file in the user
+ * cache directory (or `GST_VULKAN_PIPELINE_CACHE_DIR`) identified by the
+ * pipeline cache UUID of the physical device.
+ *
+ * Returns: the `VkPipelineCache` of @device or %VK_NULL_HANDLE
+ *
+ * Since: 1.20
+ */
+VkPipelineCache
+gst_vulkan_device_get_pipeline_cache (GstVulkanDevice * device)
+{
+  GstVulkanDevicePrivate *priv;
+
+  g_return_val_if_fail (GST_IS_VULKAN_DEVICE (device), VK_NULL_HANDLE);
+  priv = GET_PRIV (device);
+
+  return priv->pipeline_cache;
+}
+
 /* reimplement a specfic case of g_ptr_array_find_with_equal_func as that
  * requires Glib 2.54 */
 static gboolean
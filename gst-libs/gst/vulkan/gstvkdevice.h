@@ -141,6 +141,8 @@ gboolean            gst_vulkan_device_run_context_query     (GstElement * elemen
 GST_VULKAN_API
 GstVulkanFence *    gst_vulkan_device_create_fence          (GstVulkanDevice * device,
                                                              GError ** error);
+GST_VULKAN_API
+VkPipelineCache     gst_vulkan_device_get_pipeline_cache    (GstVulkanDevice * device);
 
 G_END_DECLS
 
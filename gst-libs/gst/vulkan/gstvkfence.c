@@ -23,7 +23,10 @@
 #endif
 
 #include "gstvkfence.h"
+#include "gstvkfence-private.h"
 #include "gstvkdevice.h"
+#include "gstvkqueue.h"
+#include "gstvkqueue-private.h"
 
 /**
  * SECTION:vkfence
@@ -32,6 +35,11 @@
  * @see_also: #GstVulkanDevice
  *
  * A #GstVulkanFence encapsulates a VkFence
+ *
+ * Fences returned by gst_vulkan_queue_create_fence() on devices supporting
+ * `VK_KHR_timeline_semaphore` do not contain a `VkFence` and instead refer
+ * to a value of the timeline semaphore of the queue they are submitted to
+ * with gst_vulkan_queue_submit().
  */
 
 GST_DEBUG_CATEGORY (gst_debug_vulkan_fence);
@@ -39,6 +47,17 @@ GST_DEBUG_CATEGORY (gst_debug_vulkan_fence);
 
 #define gst_vulkan_fence_cache_release(c,f) gst_vulkan_handle_pool_release(GST_VULKAN_HANDLE_POOL (c), f)
 
+typedef struct _GstVulkanFenceImpl GstVulkanFenceImpl;
+
+struct _GstVulkanFenceImpl
+{
+  GstVulkanFence parent;
+
+  /* set for timeline fences, @timeline_value is 0 until submission */
+  GstVulkanQueue *timeline_queue;
+  guint64 timeline_value;
+};
+
 static void
 _init_debug (void)
 {
@@ -79,6 +98,7 @@ gst_vulkan_fence_free (GstVulkanFence * fence)
   if (fence->fence)
     vkDestroyFence (fence->device->device, fence->fence, NULL);
 
+  gst_clear_object (&((GstVulkanFenceImpl *) fence)->timeline_queue);
   gst_clear_object (&fence->device);
 
   g_free (fence);
@@ -104,7 +124,7 @@ gst_vulkan_fence_new (GstVulkanDevice * device, GError ** error)
 
   g_return_val_if_fail (GST_IS_VULKAN_DEVICE (device), FALSE);
 
-  fence = g_new0 (GstVulkanFence, 1);
+  fence = (GstVulkanFence *) g_new0 (GstVulkanFenceImpl, 1);
   GST_TRACE ("Creating fence %p with device %" GST_PTR_FORMAT, fence, device);
   fence->device = gst_object_ref (device);
 
@@ -142,7 +162,7 @@ gst_vulkan_fence_new_always_signalled (GstVulkanDevice * device)
 
   _init_debug ();
 
-  fence = g_new0 (GstVulkanFence, 1);
+  fence = (GstVulkanFence *) g_new0 (GstVulkanFenceImpl, 1);
   GST_TRACE ("Creating always-signalled fence %p with device %" GST_PTR_FORMAT,
       fence, device);
   fence->device = gst_object_ref (device);
@@ -154,6 +174,56 @@ gst_vulkan_fence_new_always_signalled (GstVulkanDevice * device)
   return fence;
 }
 
+GstVulkanFence *
+gst_vulkan_fence_new_timeline (GstVulkanQueue * queue)
+{
+  GstVulkanFenceImpl *impl;
+  GstVulkanFence *fence;
+
+  g_return_val_if_fail (GST_IS_VULKAN_QUEUE (queue), NULL);
+
+  _init_debug ();
+
+  impl = g_new0 (GstVulkanFenceImpl, 1);
+  fence = (GstVulkanFence *) impl;
+  GST_TRACE ("Creating timeline fence %p with queue %" GST_PTR_FORMAT, fence,
+      queue);
+  fence->device = gst_object_ref (queue->device);
+  fence->fence = VK_NULL_HANDLE;
+  impl->timeline_queue = gst_object_ref (queue);
+  impl->timeline_value = 0;
+
+  gst_mini_object_init (GST_MINI_OBJECT_CAST (fence), 0, GST_TYPE_VULKAN_FENCE,
+      NULL, NULL, (GstMiniObjectFreeFunction) gst_vulkan_fence_free);
+
+  return fence;
+}
+
+GstVulkanQueue *
+gst_vulkan_fence_get_timeline_queue (GstVulkanFence * fence)
+{
+  return ((GstVulkanFenceImpl *) fence)->timeline_queue;
+}
+
+guint64
+gst_vulkan_fence_get_timeline_value (GstVulkanFence * fence)
+{
+  return ((GstVulkanFenceImpl *) fence)->timeline_value;
+}
+
+void
+gst_vulkan_fence_set_timeline_value (GstVulkanFence * fence, guint64 value)
+{
+  GstVulkanFenceImpl *impl = (GstVulkanFenceImpl *) fence;
+
+  g_return_if_fail (impl->timeline_queue != NULL);
+  g_return_if_fail (impl->timeline_value == 0);
+
+  GST_TRACE ("timeline fence %p signals value %" G_GUINT64_FORMAT, fence,
+      value);
+  impl->timeline_value = value;
+}
+
 /**
  * gst_vulkan_fence_is_signaled:
  * @fence: a #GstVulkanFence
@@ -165,14 +235,68 @@ gst_vulkan_fence_new_always_signalled (GstVulkanDevice * device)
 gboolean
 gst_vulkan_fence_is_signaled (GstVulkanFence * fence)
 {
+  GstVulkanFenceImpl *impl = (GstVulkanFenceImpl *) fence;
+
   g_return_val_if_fail (fence != NULL, FALSE);
 
+  if (impl->timeline_queue) {
+    guint64 value;
+
+    /* not submitted yet */
+    if (impl->timeline_value == 0)
+      return FALSE;
+
+    if (!gst_vulkan_queue_get_timeline_value (impl->timeline_queue, &value))
+      return FALSE;
+
+    return value >= impl->timeline_value;
+  }
+
   if (!fence->fence)
     return TRUE;
 
   return vkGetFenceStatus (fence->device->device, fence->fence) == VK_SUCCESS;
 }
 
+/**
+ * gst_vulkan_fence_wait:
+ * @fence: a #GstVulkanFence
+ * @timeout: the maximum time to wait in nanoseconds
+ *
+ * Waits on the host for @fence to become signalled.  @fence must have been
+ * submitted.
+ *
+ * Returns: whether @fence was signalled before @timeout expired
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_vulkan_fence_wait (GstVulkanFence * fence, guint64 timeout)
+{
+  GstVulkanFenceImpl *impl = (GstVulkanFenceImpl *) fence;
+  VkResult err;
+
+  g_return_val_if_fail (fence != NULL, FALSE);
+
+  if (impl->timeline_queue) {
+    if (impl->timeline_value == 0) {
+      GST_WARNING ("fence %p has not been submitted", fence);
+      return FALSE;
+    }
+
+    return gst_vulkan_queue_wait_timeline_value (impl->timeline_queue,
+        impl->timeline_value, timeout);
+  }
+
+  if (!fence->fence)
+    return TRUE;
+
+  err = vkWaitForFences (fence->device->device, 1, &fence->fence, TRUE,
+      timeout);
+
+  return err == VK_SUCCESS;
+}
+
 void
 gst_vulkan_fence_reset (GstVulkanFence * fence)
 {
@@ -236,15 +360,18 @@ gst_vulkan_fence_cache_release_impl (GstVulkanHandlePool * pool,
     gpointer handle)
 {
   GstVulkanFence *fence = handle;
+  GstVulkanFenceCache *cache;
 
   gst_vulkan_fence_reset (fence);
 
+  /* the fence may be acquired by another thread as soon as it is released */
+  cache = fence->cache;
+  fence->cache = NULL;
+  gst_clear_object (&fence->device);
+
   GST_VULKAN_HANDLE_POOL_CLASS (parent_class)->release (pool, handle);
 
-  if (fence) {
-    gst_clear_object (&fence->cache);
-    gst_clear_object (&fence->device);
-  }
+  gst_clear_object (&cache);
 }
 
 static void
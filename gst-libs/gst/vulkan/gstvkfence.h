@@ -80,6 +80,9 @@ GstVulkanFence *    gst_vulkan_fence_new_always_signalled (GstVulkanDevice *devi
 
 GST_VULKAN_API
 gboolean            gst_vulkan_fence_is_signaled    (GstVulkanFence * fence);
+GST_VULKAN_API
+gboolean            gst_vulkan_fence_wait           (GstVulkanFence * fence,
+                                                     guint64 timeout);
 
 static inline GstVulkanFence *
 gst_vulkan_fence_ref (GstVulkanFence * fence)
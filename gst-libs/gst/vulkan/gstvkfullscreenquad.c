@@ -57,6 +57,16 @@ struct _GstVulkanFullScreenQuadPrivate
 
   GstVulkanHandle *vert;
   GstVulkanHandle *frag;
+
+  gboolean blend;
+  VkBlendFactor src_blend_factor;
+  VkBlendFactor src_alpha_blend_factor;
+  VkBlendFactor dst_blend_factor;
+  VkBlendFactor dst_alpha_blend_factor;
+  VkBlendOp colour_blend_op;
+  VkBlendOp alpha_blend_op;
+
+  gboolean enable_clear;
 };
 
 G_DEFINE_TYPE_WITH_CODE (GstVulkanFullScreenQuad, gst_vulkan_full_screen_quad,
@@ -278,6 +288,7 @@ create_pipeline_layout (GstVulkanFullScreenQuad * self, GError ** error)
 static gboolean
 create_render_pass (GstVulkanFullScreenQuad * self, GError ** error)
 {
+  GstVulkanFullScreenQuadPrivate *priv = GET_PRIV (self);
   VkAttachmentDescription color_attachments[GST_VIDEO_MAX_PLANES];
   VkAttachmentReference color_attachment_refs[GST_VIDEO_MAX_PLANES];
   VkRenderPassCreateInfo render_pass_info;
@@ -291,12 +302,13 @@ create_render_pass (GstVulkanFullScreenQuad * self, GError ** error)
     color_attachments[i] = (VkAttachmentDescription) {
         .format = gst_vulkan_format_from_video_info (&self->out_info, i),
         .samples = VK_SAMPLE_COUNT_1_BIT,
-        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .loadOp = priv->enable_clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD,
         .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
         .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
         .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
         /* FIXME: share this between elements to avoid pipeline barriers */
-        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        /* the existing contents are only preserved when not clearing */
+        .initialLayout = priv->enable_clear ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
         .finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
     };
 
@@ -357,6 +369,7 @@ create_pipeline (GstVulkanFullScreenQuad * self, GError ** error)
   VkGraphicsPipelineCreateInfo pipeline_create_info;
   VkPipeline pipeline;
   VkResult err;
+  int i;
 
   if (!priv->vert || !priv->frag) {
     g_set_error_literal (error, GST_VULKAN_ERROR,
@@ -466,22 +479,18 @@ create_pipeline (GstVulkanFullScreenQuad * self, GError ** error)
       .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT
   };
 
-  color_blend_attachments[0] = (VkPipelineColorBlendAttachmentState) {
-      .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
-      .blendEnable = VK_FALSE
-  };
-  color_blend_attachments[1] = (VkPipelineColorBlendAttachmentState) {
-      .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
-      .blendEnable = VK_FALSE
-  };
-  color_blend_attachments[2] = (VkPipelineColorBlendAttachmentState) {
-      .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
-      .blendEnable = VK_FALSE
-  };
-  color_blend_attachments[3] = (VkPipelineColorBlendAttachmentState) {
-      .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
-      .blendEnable = VK_FALSE
-  };
+  for (i = 0; i < GST_VIDEO_MAX_PLANES; i++) {
+    color_blend_attachments[i] = (VkPipelineColorBlendAttachmentState) {
+        .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
+        .blendEnable = priv->blend ? VK_TRUE : VK_FALSE,
+        .srcColorBlendFactor = priv->src_blend_factor,
+        .dstColorBlendFactor = priv->dst_blend_factor,
+        .colorBlendOp = priv->colour_blend_op,
+        .srcAlphaBlendFactor = priv->src_alpha_blend_factor,
+        .dstAlphaBlendFactor = priv->dst_alpha_blend_factor,
+        .alphaBlendOp = priv->alpha_blend_op,
+    };
+  }
 
   color_blending = (VkPipelineColorBlendStateCreateInfo) {
       .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
@@ -512,7 +521,8 @@ create_pipeline (GstVulkanFullScreenQuad * self, GError ** error)
   /* *INDENT-ON* */
 
   err =
-      vkCreateGraphicsPipelines (self->queue->device->device, VK_NULL_HANDLE, 1,
+      vkCreateGraphicsPipelines (self->queue->device->device,
+      gst_vulkan_device_get_pipeline_cache (self->queue->device), 1,
       &pipeline_create_info, NULL, &pipeline);
   if (gst_vulkan_error_to_g_error (err, error, "vkCreateGraphicsPipelines") < 0) {
     return FALSE;
@@ -768,7 +778,17 @@ destroy_pipeline (GstVulkanFullScreenQuad * self)
 void
 gst_vulkan_full_screen_quad_init (GstVulkanFullScreenQuad * self)
 {
+  GstVulkanFullScreenQuadPrivate *priv = GET_PRIV (self);
+
   self->trash_list = gst_vulkan_trash_fence_list_new ();
+
+  priv->src_blend_factor = VK_BLEND_FACTOR_SRC_ALPHA;
+  priv->src_alpha_blend_factor = VK_BLEND_FACTOR_ONE;
+  priv->dst_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+  priv->dst_alpha_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+  priv->colour_blend_op = VK_BLEND_OP_ADD;
+  priv->alpha_blend_op = VK_BLEND_OP_ADD;
+  priv->enable_clear = TRUE;
 }
 
 /**
@@ -1037,6 +1057,128 @@ gst_vulkan_full_screen_quad_set_vertex_buffer (GstVulkanFullScreenQuad * self,
   return TRUE;
 }
 
+/**
+ * gst_vulkan_full_screen_quad_enable_blend:
+ * @self: the #GstVulkanFullScreenQuad
+ * @enable_blend: whether to enable blending
+ *
+ * Enables blending of the input image to the output image.
+ *
+ * See also: gst_vulkan_full_screen_quad_set_blend_operation() and
+ * gst_vulkan_full_screen_quad_set_blend_factors().
+ *
+ * Since: 1.20
+ */
+void
+gst_vulkan_full_screen_quad_enable_blend (GstVulkanFullScreenQuad * self,
+    gboolean enable_blend)
+{
+  GstVulkanFullScreenQuadPrivate *priv;
+
+  g_return_if_fail (GST_IS_VULKAN_FULL_SCREEN_QUAD (self));
+
+  priv = GET_PRIV (self);
+
+  if (priv->blend != !!enable_blend)
+    destroy_pipeline (self);
+
+  priv->blend = !!enable_blend;
+}
+
+/**
+ * gst_vulkan_full_screen_quad_set_blend_factors:
+ * @self: the #GstVulkanFullScreenQuad
+ * @src_blend_factor: the `VkBlendFactor` for the source RGB components
+ * @dst_blend_factor: the `VkBlendFactor` for the destination RGB components
+ * @src_alpha_blend_factor: the `VkBlendFactor` for the source alpha component
+ * @dst_alpha_blend_factor: the `VkBlendFactor` for the destination alpha
+ *                          component
+ *
+ * The defaults implement "over" compositing of non-premultiplied input.
+ *
+ * Since: 1.20
+ */
+void
+gst_vulkan_full_screen_quad_set_blend_factors (GstVulkanFullScreenQuad * self,
+    VkBlendFactor src_blend_factor, VkBlendFactor dst_blend_factor,
+    VkBlendFactor src_alpha_blend_factor, VkBlendFactor dst_alpha_blend_factor)
+{
+  GstVulkanFullScreenQuadPrivate *priv;
+
+  g_return_if_fail (GST_IS_VULKAN_FULL_SCREEN_QUAD (self));
+
+  priv = GET_PRIV (self);
+
+  if (priv->src_blend_factor == src_blend_factor
+      && priv->dst_blend_factor == dst_blend_factor
+      && priv->src_alpha_blend_factor == src_alpha_blend_factor
+      && priv->dst_alpha_blend_factor == dst_alpha_blend_factor)
+    return;
+
+  priv->src_blend_factor = src_blend_factor;
+  priv->dst_blend_factor = dst_blend_factor;
+  priv->src_alpha_blend_factor = src_alpha_blend_factor;
+  priv->dst_alpha_blend_factor = dst_alpha_blend_factor;
+
+  destroy_pipeline (self);
+}
+
+/**
+ * gst_vulkan_full_screen_quad_set_blend_operation:
+ * @self: the #GstVulkanFullScreenQuad
+ * @colour_blend_op: the `VkBlendOp` to use for the RGB components
+ * @alpha_blend_op: the `VkBlendOp` to use for the alpha component
+ *
+ * Since: 1.20
+ */
+void
+gst_vulkan_full_screen_quad_set_blend_operation (GstVulkanFullScreenQuad *
+    self, VkBlendOp colour_blend_op, VkBlendOp alpha_blend_op)
+{
+  GstVulkanFullScreenQuadPrivate *priv;
+
+  g_return_if_fail (GST_IS_VULKAN_FULL_SCREEN_QUAD (self));
+
+  priv = GET_PRIV (self);
+
+  if (priv->colour_blend_op == colour_blend_op
+      && priv->alpha_blend_op == alpha_blend_op)
+    return;
+
+  priv->colour_blend_op = colour_blend_op;
+  priv->alpha_blend_op = alpha_blend_op;
+
+  destroy_pipeline (self);
+}
+
+/**
+ * gst_vulkan_full_screen_quad_enable_clear:
+ * @self: the #GstVulkanFullScreenQuad
+ * @enable_clear: whether to clear the output image before drawing
+ *
+ * By default, the output image is cleared to opaque black before drawing.
+ * Disabling the clear preserves the existing contents of the output image
+ * outside of the drawn area which allows multiple #GstVulkanFullScreenQuad's
+ * to draw into the same output buffer.
+ *
+ * Since: 1.20
+ */
+void
+gst_vulkan_full_screen_quad_enable_clear (GstVulkanFullScreenQuad * self,
+    gboolean enable_clear)
+{
+  GstVulkanFullScreenQuadPrivate *priv;
+
+  g_return_if_fail (GST_IS_VULKAN_FULL_SCREEN_QUAD (self));
+
+  priv = GET_PRIV (self);
+
+  if (priv->enable_clear != !!enable_clear)
+    destroy_pipeline (self);
+
+  priv->enable_clear = !!enable_clear;
+}
+
 static GstVulkanImageMemory *
 peek_image_from_buffer (GstBuffer * buffer, guint i)
 {
@@ -1124,7 +1266,7 @@ gst_vulkan_full_screen_quad_draw (GstVulkanFullScreenQuad * self,
 
   g_return_val_if_fail (GST_IS_VULKAN_FULL_SCREEN_QUAD (self), FALSE);
 
-  fence = gst_vulkan_device_create_fence (self->queue->device, error);
+  fence = gst_vulkan_queue_create_fence (self->queue, error);
   if (!fence)
     goto error;
 
@@ -1282,6 +1424,7 @@ gst_vulkan_full_screen_quad_fill_command_buffer (GstVulkanFullScreenQuad * self,
   GstVulkanFullScreenQuadPrivate *priv;
   GstVulkanImageView *in_views[GST_VIDEO_MAX_PLANES] = { NULL, };
   GstVulkanImageView *out_views[GST_VIDEO_MAX_PLANES] = { NULL, };
+  VkAccessFlags out_access;
   int i;
 
   g_return_val_if_fail (GST_IS_VULKAN_FULL_SCREEN_QUAD (self), FALSE);
@@ -1290,6 +1433,11 @@ gst_vulkan_full_screen_quad_fill_command_buffer (GstVulkanFullScreenQuad * self,
 
   priv = GET_PRIV (self);
 
+  out_access = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+  /* blending and loading both read the previous contents of the output */
+  if (priv->blend || !priv->enable_clear)
+    out_access |= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT;
+
   for (i = 0; i < GST_VIDEO_INFO_N_PLANES (&self->in_info); i++) {
     GstVulkanImageMemory *img_mem = peek_image_from_buffer (priv->inbuf, i);
     if (!gst_is_vulkan_image_memory ((GstMemory *) img_mem)) {
@@ -1352,7 +1500,7 @@ gst_vulkan_full_screen_quad_fill_command_buffer (GstVulkanFullScreenQuad * self,
         .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
         .pNext = NULL,
         .srcAccessMask = out_views[i]->image->barrier.parent.access_flags,
-        .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+        .dstAccessMask = out_access,
         .oldLayout = out_views[i]->image->barrier.image_layout,
         .newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
         /* FIXME: implement exclusive transfers */
@@ -1435,8 +1583,6 @@ gboolean
 gst_vulkan_full_screen_quad_submit (GstVulkanFullScreenQuad * self,
     GstVulkanCommandBuffer * cmd, GstVulkanFence * fence, GError ** error)
 {
-  VkResult err;
-
   g_return_val_if_fail (GST_IS_VULKAN_FULL_SCREEN_QUAD (self), FALSE);
   g_return_val_if_fail (cmd != NULL, FALSE);
   g_return_val_if_fail (fence != NULL, FALSE);
@@ -1456,12 +1602,7 @@ gst_vulkan_full_screen_quad_submit (GstVulkanFullScreenQuad * self,
     };
     /* *INDENT-ON* */
 
-    gst_vulkan_queue_submit_lock (self->queue);
-    err =
-        vkQueueSubmit (self->queue->queue, 1, &submit_info,
-        GST_VULKAN_FENCE_FENCE (fence));
-    gst_vulkan_queue_submit_unlock (self->queue);
-    if (gst_vulkan_error_to_g_error (err, error, "vkQueueSubmit") < 0)
+    if (!gst_vulkan_queue_submit (self->queue, &submit_info, fence, error))
       goto error;
   }
 
@@ -113,6 +113,15 @@ gboolean            gst_vulkan_full_screen_quad_set_vertex_buffer   (GstVulkanFu
 GST_VULKAN_API
 gboolean            gst_vulkan_full_screen_quad_set_index_buffer    (GstVulkanFullScreenQuad * self, GstMemory * indices, gsize n_indices, GError ** error);
 
+GST_VULKAN_API
+void                gst_vulkan_full_screen_quad_enable_blend        (GstVulkanFullScreenQuad * self, gboolean enable_blend);
+GST_VULKAN_API
+void                gst_vulkan_full_screen_quad_set_blend_factors   (GstVulkanFullScreenQuad * self, VkBlendFactor src_blend_factor, VkBlendFactor dst_blend_factor, VkBlendFactor src_alpha_blend_factor, VkBlendFactor dst_alpha_blend_factor);
+GST_VULKAN_API
+void                gst_vulkan_full_screen_quad_set_blend_operation (GstVulkanFullScreenQuad * self, VkBlendOp colour_blend_op, VkBlendOp alpha_blend_op);
+GST_VULKAN_API
+void                gst_vulkan_full_screen_quad_enable_clear        (GstVulkanFullScreenQuad * self, gboolean enable_clear);
+
 GST_VULKAN_API
 gboolean            gst_vulkan_full_screen_quad_set_input_buffer    (GstVulkanFullScreenQuad * self, GstBuffer * buffer, GError ** error);
 GST_VULKAN_API
@@ -36,12 +36,25 @@
 
 #define GST_VULKAN_HANDLE_POOL_LARGE_OUTSTANDING 1024
 
+#define GET_PRIV(pool) gst_vulkan_handle_pool_get_instance_private (pool)
+
 #define GST_CAT_DEFAULT gst_debug_vulkan_handle_pool
 GST_DEBUG_CATEGORY (GST_CAT_DEFAULT);
 
+/* Acquiring and releasing handles happens for every frame from the
+ * streaming threads of all the elements sharing a pool.  The available
+ * handles are kept in a lock-free queue instead of the object lock
+ * protected arrays of the public structure. */
+struct _GstVulkanHandlePoolPrivate
+{
+  GstAtomicQueue *available;
+  gint outstanding;
+};
+
 #define parent_class gst_vulkan_handle_pool_parent_class
 G_DEFINE_ABSTRACT_TYPE_WITH_CODE (GstVulkanHandlePool, gst_vulkan_handle_pool,
-    GST_TYPE_OBJECT, GST_DEBUG_CATEGORY_INIT (GST_CAT_DEFAULT,
+    GST_TYPE_OBJECT, G_ADD_PRIVATE (GstVulkanHandlePool);
+    GST_DEBUG_CATEGORY_INIT (GST_CAT_DEFAULT,
         "vulkanhandlepool", 0, "Vulkan handle pool"));
 
 static gpointer
@@ -55,26 +68,27 @@ static gpointer
 gst_vulkan_handle_pool_default_acquire (GstVulkanHandlePool * pool,
     GError ** error)
 {
+  GstVulkanHandlePoolPrivate *priv = GET_PRIV (pool);
   gpointer ret;
 
-  GST_OBJECT_LOCK (pool);
-  if (pool->available->len > 0) {
-    ret = g_ptr_array_remove_index_fast (pool->available, 0);
-  } else {
+  if (!(ret = gst_atomic_queue_pop (priv->available)))
     ret = gst_vulkan_handle_pool_alloc (pool, error);
-  }
 
   if (ret) {
+#if defined(GST_ENABLE_EXTRA_CHECKS)
+    GST_OBJECT_LOCK (pool);
     g_ptr_array_add (pool->outstanding, ret);
+    GST_OBJECT_UNLOCK (pool);
 
-#if defined(GST_ENABLE_EXTRA_CHECKS)
-    if (pool->outstanding->len > GST_VULKAN_HANDLE_POOL_LARGE_OUTSTANDING)
+    if (g_atomic_int_add (&priv->outstanding,
+            1) >= GST_VULKAN_HANDLE_POOL_LARGE_OUTSTANDING)
       g_critical ("%s: There are a large number of handles outstanding! "
           "This usually means there is a reference counting issue somewhere.",
           GST_OBJECT_NAME (pool));
+#else
+    g_atomic_int_inc (&priv->outstanding);
 #endif
   }
-  GST_OBJECT_UNLOCK (pool);
 
   return ret;
 }
@@ -83,6 +97,9 @@ static void
 gst_vulkan_handle_pool_default_release (GstVulkanHandlePool * pool,
     gpointer handle)
 {
+  GstVulkanHandlePoolPrivate *priv = GET_PRIV (pool);
+
+#if defined(GST_ENABLE_EXTRA_CHECKS)
   GST_OBJECT_LOCK (pool);
   if (!g_ptr_array_remove_fast (pool->outstanding, handle)) {
     g_warning ("%s: Attempt was made to release a handle (%p) that does not "
@@ -90,9 +107,11 @@ gst_vulkan_handle_pool_default_release (GstVulkanHandlePool * pool,
     GST_OBJECT_UNLOCK (pool);
     return;
   }
-
-  g_ptr_array_add (pool->available, handle);
   GST_OBJECT_UNLOCK (pool);
+#endif
+
+  g_atomic_int_add (&priv->outstanding, -1);
+  gst_atomic_queue_push (priv->available, handle);
 }
 
 static void
@@ -112,13 +131,21 @@ static void
 gst_vulkan_handle_pool_dispose (GObject * object)
 {
   GstVulkanHandlePool *pool = GST_VULKAN_HANDLE_POOL (object);
+  GstVulkanHandlePoolPrivate *priv = GET_PRIV (pool);
+  gpointer handle;
 
-  if (pool->outstanding) {
-    g_warn_if_fail (pool->outstanding->len <= 0);
+  g_warn_if_fail (g_atomic_int_get (&priv->outstanding) <= 0);
+  if (pool->outstanding)
     g_ptr_array_unref (pool->outstanding);
-  }
   pool->outstanding = NULL;
 
+  if (priv->available) {
+    while ((handle = gst_atomic_queue_pop (priv->available)))
+      do_free_handle (handle, pool);
+    gst_atomic_queue_unref (priv->available);
+  }
+  priv->available = NULL;
+
   if (pool->available) {
     g_ptr_array_foreach (pool->available, (GFunc) do_free_handle, pool);
     g_ptr_array_unref (pool->available);
@@ -141,6 +168,10 @@ gst_vulkan_handle_pool_finalize (GObject * object)
 static void
 gst_vulkan_handle_pool_init (GstVulkanHandlePool * handle)
 {
+  GstVulkanHandlePoolPrivate *priv = GET_PRIV (handle);
+
+  priv->available = gst_atomic_queue_new (16);
+
   handle->outstanding = g_ptr_array_new ();
   handle->available = g_ptr_array_new ();
 }
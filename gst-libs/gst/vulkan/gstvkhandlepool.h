@@ -47,8 +47,10 @@ GType gst_vulkan_handle_pool_get_type (void);
  * GstVulkanHandlePool:
  * @parent: the parent #GstObject
  * @device: the #GstVulkanDevice handles are allocated from
- * @outstanding: the collection of outstanding handles
- * @available: the collection of allocated and available handles
+ * @outstanding: the collection of outstanding handles.  Only tracked when
+ *     built with extra checks since 1.20.
+ * @available: the collection of allocated and available handles.  Unused
+ *     since 1.20, available handles are kept in a private lock-free queue.
  *
  * Since: 1.18
  */
@@ -23,6 +23,7 @@
 #endif
 
 #include "gstvkimagememory.h"
+#include "gstvkdevice-private.h"
 
 /**
  * SECTION:vkimagememory
@@ -127,8 +128,9 @@ gst_vulkan_format_from_video_info (GstVideoInfo * v_info, guint plane)
 }
 
 static gboolean
-_create_info_from_args (VkImageCreateInfo * info, VkFormat format, gsize width,
-    gsize height, VkImageTiling tiling, VkImageUsageFlags usage)
+_create_info_from_args (VkImageCreateInfo * info, GstVulkanDevice * device,
+    VkFormat format, gsize width, gsize height, VkImageTiling tiling,
+    VkImageUsageFlags usage)
 {
   /* FIXME: validate these */
 
@@ -152,6 +154,20 @@ _create_info_from_args (VkImageCreateInfo * info, VkFormat format, gsize width,
   };
   /* *INDENT-ON* */
 
+  if (device) {
+    const guint32 *families;
+    guint n_families;
+
+    /* shared with the transfer queue without queue family ownership
+     * transfers */
+    families = gst_vulkan_device_get_queue_family_indices (device, &n_families);
+    if (n_families > 1) {
+      info->sharingMode = VK_SHARING_MODE_CONCURRENT;
+      info->queueFamilyIndexCount = n_families;
+      info->pQueueFamilyIndices = families;
+    }
+  }
+
   return TRUE;
 }
 
@@ -221,8 +237,8 @@ _vk_image_mem_new_alloc (GstAllocator * allocator, GstMemory * parent,
   VkResult err;
 
   gpu = gst_vulkan_device_get_physical_device (device);
-  if (!_create_info_from_args (&image_info, format, width, height, tiling,
-          usage)) {
+  if (!_create_info_from_args (&image_info, device, format, width, height,
+          tiling, usage)) {
     GST_CAT_ERROR (GST_CAT_VULKAN_IMAGE_MEMORY, "Incorrect image parameters");
     goto error;
   }
@@ -307,8 +323,8 @@ _vk_image_mem_new_wrapped (GstAllocator * allocator, GstMemory * parent,
       mem->requirements.size, user_data, notify);
   mem->wrapped = TRUE;
 
-  if (!_create_info_from_args (&mem->create_info, format, width, height, tiling,
-          usage)) {
+  if (!_create_info_from_args (&mem->create_info, NULL, format, width, height,
+          tiling, usage)) {
     GST_CAT_ERROR (GST_CAT_VULKAN_IMAGE_MEMORY, "Incorrect image parameters");
     goto error;
   }
@@ -23,6 +23,10 @@
 #endif
 
 #include "gstvkqueue.h"
+#include "gstvkqueue-private.h"
+#include "gstvkfence-private.h"
+
+#include <string.h>
 
 /**
  * SECTION:vkqueue
@@ -52,8 +56,36 @@ _init_debug (void)
 struct _GstVulkanQueuePrivate
 {
   GMutex submit_lock;
+
+  /* timeline semaphore signalled by each submission, created on first use */
+  gboolean timeline_checked;
+  VkSemaphore timeline;
+  /* last value submitted, protected by submit_lock */
+  guint64 timeline_value;
+#if defined (VK_KHR_timeline_semaphore)
+  PFN_vkGetSemaphoreCounterValueKHR GetSemaphoreCounterValue;
+  PFN_vkWaitSemaphoresKHR WaitSemaphores;
+#endif
+
+  /* struct PendingWait, added by gst_vulkan_queue_add_dependency() and
+   * consumed by the next submission, protected by submit_lock */
+  GPtrArray *pending_waits;
 };
 
+struct PendingWait
+{
+  GWeakRef queue;
+  guint64 value;
+  VkPipelineStageFlags stages;
+};
+
+static void
+_pending_wait_free (struct PendingWait *wait)
+{
+  g_weak_ref_clear (&wait->queue);
+  g_free (wait);
+}
+
 #define parent_class gst_vulkan_queue_parent_class
 G_DEFINE_TYPE_WITH_CODE (GstVulkanQueue, gst_vulkan_queue, GST_TYPE_OBJECT,
     G_ADD_PRIVATE (GstVulkanQueue); _init_debug ());
@@ -68,6 +100,8 @@ gst_vulkan_queue_init (GstVulkanQueue * queue)
   GstVulkanQueuePrivate *priv = GET_PRIV (queue);
 
   g_mutex_init (&priv->submit_lock);
+  priv->pending_waits =
+      g_ptr_array_new_with_free_func ((GDestroyNotify) _pending_wait_free);
 }
 
 static void
@@ -84,6 +118,19 @@ gst_vulkan_queue_dispose (GObject * object)
   GstVulkanQueue *queue = GST_VULKAN_QUEUE (object);
   GstVulkanQueuePrivate *priv = GET_PRIV (queue);
 
+  if (priv->timeline) {
+    /* other queues may still wait on submissions from this queue */
+    if (priv->timeline_value > 0)
+      gst_vulkan_queue_wait_timeline_value (queue, priv->timeline_value,
+          G_MAXUINT64);
+    vkDestroySemaphore (queue->device->device, priv->timeline, NULL);
+    priv->timeline = VK_NULL_HANDLE;
+  }
+
+  if (priv->pending_waits)
+    g_ptr_array_unref (priv->pending_waits);
+  priv->pending_waits = NULL;
+
   if (queue->device)
     gst_object_unref (queue->device);
   queue->device = NULL;
@@ -339,3 +386,355 @@ gst_vulkan_queue_submit_unlock (GstVulkanQueue * queue)
 
   g_mutex_unlock (&priv->submit_lock);
 }
+
+static gboolean
+_ensure_timeline (GstVulkanQueue * queue)
+{
+  GstVulkanQueuePrivate *priv = GET_PRIV (queue);
+  gboolean ret;
+
+  GST_OBJECT_LOCK (queue);
+  if (!priv->timeline_checked) {
+    priv->timeline_checked = TRUE;
+#if defined (VK_KHR_timeline_semaphore)
+    if (gst_vulkan_device_is_extension_enabled (queue->device,
+            VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME)) {
+      VkSemaphoreTypeCreateInfoKHR type_info = { 0, };
+      VkSemaphoreCreateInfo semaphore_info = { 0, };
+      VkResult err;
+
+      priv->GetSemaphoreCounterValue =
+          gst_vulkan_device_get_proc_address (queue->device,
+          "vkGetSemaphoreCounterValueKHR");
+      priv->WaitSemaphores =
+          gst_vulkan_device_get_proc_address (queue->device,
+          "vkWaitSemaphoresKHR");
+
+      type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+      type_info.pNext = NULL;
+      type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+      type_info.initialValue = 0;
+
+      semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+      semaphore_info.pNext = &type_info;
+      semaphore_info.flags = 0;
+
+      if (priv->GetSemaphoreCounterValue && priv->WaitSemaphores) {
+        err = vkCreateSemaphore (queue->device->device, &semaphore_info, NULL,
+            &priv->timeline);
+        if (err != VK_SUCCESS)
+          priv->timeline = VK_NULL_HANDLE;
+      }
+
+      if (priv->timeline)
+        GST_DEBUG_OBJECT (queue, "using a timeline semaphore for submissions");
+      else
+        GST_WARNING_OBJECT (queue, "Failed to create a timeline semaphore, "
+            "falling back to fences");
+    }
+#endif
+  }
+  ret = priv->timeline != VK_NULL_HANDLE;
+  GST_OBJECT_UNLOCK (queue);
+
+  return ret;
+}
+
+/**
+ * gst_vulkan_queue_create_fence:
+ * @queue: a #GstVulkanQueue
+ * @error: a #GError to fill on failure
+ *
+ * Creates a #GstVulkanFence for a submission to @queue with
+ * gst_vulkan_queue_submit().
+ *
+ * If the device supports `VK_KHR_timeline_semaphore`, no `VkFence` is
+ * allocated and the returned fence is signalled when the timeline semaphore
+ * of @queue reaches the value assigned on submission.  Otherwise this is
+ * equivalent to gst_vulkan_device_create_fence().
+ *
+ * Returns: (transfer full): a new #GstVulkanFence or %NULL
+ *
+ * Since: 1.20
+ */
+GstVulkanFence *
+gst_vulkan_queue_create_fence (GstVulkanQueue * queue, GError ** error)
+{
+  g_return_val_if_fail (GST_IS_VULKAN_QUEUE (queue), NULL);
+
+  if (_ensure_timeline (queue))
+    return gst_vulkan_fence_new_timeline (queue);
+
+  return gst_vulkan_device_create_fence (queue->device, error);
+}
+
+#if defined (VK_KHR_timeline_semaphore)
+/* call with submit_lock held */
+static VkResult
+_submit_timeline_unlocked (GstVulkanQueue * queue,
+    const VkSubmitInfo * submit_info, GstVulkanFence * fence)
+{
+  GstVulkanQueuePrivate *priv = GET_PRIV (queue);
+  VkTimelineSemaphoreSubmitInfoKHR timeline_info = { 0, };
+  VkSubmitInfo info = *submit_info;
+  guint n_wait = submit_info->waitSemaphoreCount;
+  guint n_signal = submit_info->signalSemaphoreCount;
+  guint n_pending = priv->pending_waits->len;
+  gboolean timeline_fence;
+  VkSemaphore *wait_semaphores, *signal_semaphores;
+  VkPipelineStageFlags *wait_stages;
+  guint64 *wait_values, *signal_values;
+  GstVulkanQueue **dependencies;
+  guint n_dependencies = 0;
+  guint64 value = 0;
+  VkResult err;
+  guint i;
+
+  timeline_fence = fence && gst_vulkan_fence_get_timeline_queue (fence);
+
+  wait_semaphores = g_newa (VkSemaphore, n_wait + n_pending + 1);
+  wait_stages = g_newa (VkPipelineStageFlags, n_wait + n_pending + 1);
+  wait_values = g_newa (guint64, n_wait + n_pending + 1);
+  signal_semaphores = g_newa (VkSemaphore, n_signal + 1);
+  signal_values = g_newa (guint64, n_signal + 1);
+  dependencies = g_newa (GstVulkanQueue *, n_pending + 1);
+
+  if (n_wait > 0) {
+    memcpy (wait_semaphores, submit_info->pWaitSemaphores,
+        n_wait * sizeof (VkSemaphore));
+    memcpy (wait_stages, submit_info->pWaitDstStageMask,
+        n_wait * sizeof (VkPipelineStageFlags));
+  }
+  if (n_signal > 0)
+    memcpy (signal_semaphores, submit_info->pSignalSemaphores,
+        n_signal * sizeof (VkSemaphore));
+  /* binary semaphores ignore their values */
+  memset (wait_values, 0, (n_wait + n_pending + 1) * sizeof (guint64));
+  memset (signal_values, 0, (n_signal + 1) * sizeof (guint64));
+
+  for (i = 0; i < n_pending; i++) {
+    struct PendingWait *wait = g_ptr_array_index (priv->pending_waits, i);
+    GstVulkanQueue *dependency = g_weak_ref_get (&wait->queue);
+
+    /* a disposed queue waits for its own submissions */
+    if (!dependency)
+      continue;
+
+    dependencies[n_dependencies] = dependency;
+    wait_semaphores[n_wait] = GET_PRIV (dependency)->timeline;
+    wait_stages[n_wait] = wait->stages;
+    wait_values[n_wait] = wait->value;
+    n_dependencies++;
+    n_wait++;
+  }
+
+  if (timeline_fence) {
+    /* values must be strictly increasing in submission order so they can
+     * only be assigned here */
+    value = priv->timeline_value + 1;
+    signal_semaphores[n_signal] = priv->timeline;
+    signal_values[n_signal] = value;
+    n_signal++;
+  }
+
+  timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+  timeline_info.pNext = submit_info->pNext;
+  timeline_info.waitSemaphoreValueCount = n_wait;
+  timeline_info.pWaitSemaphoreValues = wait_values;
+  timeline_info.signalSemaphoreValueCount = n_signal;
+  timeline_info.pSignalSemaphoreValues = signal_values;
+
+  info.pNext = &timeline_info;
+  info.waitSemaphoreCount = n_wait;
+  info.pWaitSemaphores = wait_semaphores;
+  info.pWaitDstStageMask = wait_stages;
+  info.signalSemaphoreCount = n_signal;
+  info.pSignalSemaphores = signal_semaphores;
+
+  err = vkQueueSubmit (queue->queue, 1, &info, fence && !timeline_fence ?
+      GST_VULKAN_FENCE_FENCE (fence) : VK_NULL_HANDLE);
+  if (err == VK_SUCCESS) {
+    g_ptr_array_set_size (priv->pending_waits, 0);
+    if (timeline_fence) {
+      priv->timeline_value = value;
+      gst_vulkan_fence_set_timeline_value (fence, value);
+    }
+  }
+
+  for (i = 0; i < n_dependencies; i++)
+    gst_object_unref (dependencies[i]);
+
+  return err;
+}
+#endif
+
+/**
+ * gst_vulkan_queue_submit:
+ * @queue: a #GstVulkanQueue
+ * @submit_info: the `VkSubmitInfo` to submit
+ * @fence: (nullable): a #GstVulkanFence to signal on completion
+ * @error: a #GError to fill on failure
+ *
+ * Submits @submit_info to @queue taking the submission lock.  @fence must be
+ * unsignalled and come from gst_vulkan_queue_create_fence() for @queue or
+ * from gst_vulkan_device_create_fence().
+ *
+ * Returns: whether the submission succeeded
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_vulkan_queue_submit (GstVulkanQueue * queue,
+    const VkSubmitInfo * submit_info, GstVulkanFence * fence, GError ** error)
+{
+  GstVulkanQueuePrivate *priv;
+  gboolean timeline_fence;
+  VkResult err;
+
+  g_return_val_if_fail (GST_IS_VULKAN_QUEUE (queue), FALSE);
+  g_return_val_if_fail (submit_info != NULL, FALSE);
+
+  priv = GET_PRIV (queue);
+
+  timeline_fence = fence && gst_vulkan_fence_get_timeline_queue (fence);
+  g_return_val_if_fail (!timeline_fence
+      || gst_vulkan_fence_get_timeline_queue (fence) == queue, FALSE);
+
+  g_mutex_lock (&priv->submit_lock);
+  if (timeline_fence || priv->pending_waits->len > 0) {
+#if defined (VK_KHR_timeline_semaphore)
+    err = _submit_timeline_unlocked (queue, submit_info, fence);
+#else
+    g_assert_not_reached ();
+    err = VK_ERROR_FEATURE_NOT_PRESENT;
+#endif
+  } else {
+    err = vkQueueSubmit (queue->queue, 1, submit_info,
+        fence ? GST_VULKAN_FENCE_FENCE (fence) : VK_NULL_HANDLE);
+  }
+  g_mutex_unlock (&priv->submit_lock);
+
+  return gst_vulkan_error_to_g_error (err, error, "vkQueueSubmit") >= 0;
+}
+
+/**
+ * gst_vulkan_queue_add_dependency:
+ * @queue: a #GstVulkanQueue
+ * @dependency: the #GstVulkanQueue to wait for
+ * @wait_stages: the pipeline stages of @queue that wait for @dependency
+ *
+ * Makes the next gst_vulkan_queue_submit() to @queue wait on the GPU for all
+ * the work submitted to @dependency so far.  This allows resources to be
+ * handed between queues, e.g. between a graphics and a transfer queue,
+ * without waiting on the host.
+ *
+ * Requires `VK_KHR_timeline_semaphore` support from the device.
+ *
+ * Returns: whether the dependency could be added
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_vulkan_queue_add_dependency (GstVulkanQueue * queue,
+    GstVulkanQueue * dependency, VkPipelineStageFlags wait_stages)
+{
+  GstVulkanQueuePrivate *priv, *dep_priv;
+  struct PendingWait *wait = NULL;
+  guint64 value;
+  guint i;
+
+  g_return_val_if_fail (GST_IS_VULKAN_QUEUE (queue), FALSE);
+  g_return_val_if_fail (GST_IS_VULKAN_QUEUE (dependency), FALSE);
+  g_return_val_if_fail (queue->device == dependency->device, FALSE);
+
+  /* submissions to the same queue are already ordered */
+  if (queue == dependency)
+    return TRUE;
+
+  if (!_ensure_timeline (dependency))
+    return FALSE;
+
+  priv = GET_PRIV (queue);
+  dep_priv = GET_PRIV (dependency);
+
+  g_mutex_lock (&dep_priv->submit_lock);
+  value = dep_priv->timeline_value;
+  g_mutex_unlock (&dep_priv->submit_lock);
+
+  /* nothing to wait for */
+  if (value == 0)
+    return TRUE;
+
+  g_mutex_lock (&priv->submit_lock);
+  for (i = 0; i < priv->pending_waits->len; i++) {
+    struct PendingWait *other = g_ptr_array_index (priv->pending_waits, i);
+    GstVulkanQueue *other_queue = g_weak_ref_get (&other->queue);
+
+    if (other_queue)
+      gst_object_unref (other_queue);
+    if (other_queue == dependency) {
+      wait = other;
+      break;
+    }
+  }
+  if (!wait) {
+    wait = g_new0 (struct PendingWait, 1);
+    g_weak_ref_init (&wait->queue, dependency);
+    g_ptr_array_add (priv->pending_waits, wait);
+  }
+  wait->value = MAX (wait->value, value);
+  wait->stages |= wait_stages;
+  g_mutex_unlock (&priv->submit_lock);
+
+  GST_TRACE_OBJECT (queue, "next submission waits for %" GST_PTR_FORMAT
+      " to reach %" G_GUINT64_FORMAT, dependency, value);
+
+  return TRUE;
+}
+
+gboolean
+gst_vulkan_queue_get_timeline_value (GstVulkanQueue * queue, guint64 * value)
+{
+#if defined (VK_KHR_timeline_semaphore)
+  GstVulkanQueuePrivate *priv = GET_PRIV (queue);
+  uint64_t counter;
+
+  if (!priv->timeline)
+    return FALSE;
+
+  if (priv->GetSemaphoreCounterValue (queue->device->device, priv->timeline,
+          &counter) != VK_SUCCESS)
+    return FALSE;
+
+  *value = counter;
+  return TRUE;
+#else
+  return FALSE;
+#endif
+}
+
+gboolean
+gst_vulkan_queue_wait_timeline_value (GstVulkanQueue * queue, guint64 value,
+    guint64 timeout)
+{
+#if defined (VK_KHR_timeline_semaphore)
+  GstVulkanQueuePrivate *priv = GET_PRIV (queue);
+  VkSemaphoreWaitInfoKHR wait_info = { 0, };
+  uint64_t wait_value = value;
+
+  if (!priv->timeline)
+    return FALSE;
+
+  wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+  wait_info.pNext = NULL;
+  wait_info.flags = 0;
+  wait_info.semaphoreCount = 1;
+  wait_info.pSemaphores = &priv->timeline;
+  wait_info.pValues = &wait_value;
+
+  return priv->WaitSemaphores (queue->device->device, &wait_info,
+      timeout) == VK_SUCCESS;
+#else
+  return FALSE;
+#endif
+}
@@ -85,6 +85,19 @@ GST_VULKAN_API
 GstVulkanCommandPool *  gst_vulkan_queue_create_command_pool    (GstVulkanQueue * queue,
                                                                  GError ** error);
 
+GST_VULKAN_API
+GstVulkanFence *    gst_vulkan_queue_create_fence               (GstVulkanQueue * queue,
+                                                                 GError ** error);
+GST_VULKAN_API
+gboolean            gst_vulkan_queue_submit                     (GstVulkanQueue * queue,
+                                                                 const VkSubmitInfo * submit_info,
+                                                                 GstVulkanFence * fence,
+                                                                 GError ** error);
+GST_VULKAN_API
+gboolean            gst_vulkan_queue_add_dependency             (GstVulkanQueue * queue,
+                                                                 GstVulkanQueue * dependency,
+                                                                 VkPipelineStageFlags wait_stages);
+
 GST_VULKAN_API
 void                gst_vulkan_queue_submit_lock                (GstVulkanQueue * queue);
 GST_VULKAN_API
@@ -1289,16 +1289,11 @@ reacquire:
     };
     /* *INDENT-ON* */
 
-    fence = gst_vulkan_device_create_fence (swapper->device, error);
+    fence = gst_vulkan_queue_create_fence (swapper->queue, error);
     if (!fence)
       goto error;
 
-    gst_vulkan_queue_submit_lock (swapper->queue);
-    err =
-        vkQueueSubmit (swapper->queue->queue, 1, &submit_info,
-        GST_VULKAN_FENCE_FENCE (fence));
-    gst_vulkan_queue_submit_unlock (swapper->queue);
-    if (gst_vulkan_error_to_g_error (err, error, "vkQueueSubmit") < 0)
+    if (!gst_vulkan_queue_submit (swapper->queue, &submit_info, fence, error))
       goto error;
 
     gst_vulkan_trash_list_add (priv->trash_list,
@@ -1349,16 +1344,11 @@ reacquire:
     };
     /* *INDENT-ON* */
 
-    fence = gst_vulkan_device_create_fence (swapper->device, error);
+    fence = gst_vulkan_queue_create_fence (swapper->queue, error);
     if (!fence)
       goto error;
 
-    gst_vulkan_queue_submit_lock (swapper->queue);
-    err =
-        vkQueueSubmit (swapper->queue->queue, 1, &submit_info,
-        GST_VULKAN_FENCE_FENCE (fence));
-    gst_vulkan_queue_submit_unlock (swapper->queue);
-    if (gst_vulkan_error_to_g_error (err, error, "vkQueueSubmit") < 0)
+    if (!gst_vulkan_queue_submit (swapper->queue, &submit_info, fence, error))
       goto error;
 
     gst_vulkan_trash_list_add (priv->trash_list,
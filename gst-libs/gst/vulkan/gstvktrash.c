@@ -24,6 +24,8 @@
 
 #include "gstvktrash.h"
 #include "gstvkhandle.h"
+#include "gstvkfence-private.h"
+#include "gstvkqueue-private.h"
 
 /**
  * SECTION:vktrash
@@ -451,25 +453,70 @@ gst_vulkan_trash_fence_list_wait (GstVulkanTrashList * trash_list,
   if (n > 0) {
     VkFence *fences;
     GstVulkanDevice *device = NULL;
+    /* the last value of each timeline, waiting on it covers all the
+     * previous ones */
+    GstVulkanQueue **timelines;
+    guint64 *timeline_values;
+    guint n_fences = 0, n_timelines = 0, j;
     GList *l = NULL;
 
     fences = g_new0 (VkFence, n);
+    timelines = g_new0 (GstVulkanQueue *, n);
+    timeline_values = g_new0 (guint64, n);
     for (i = 0, l = fence_list->list; i < n; i++, l = g_list_next (l)) {
       GstVulkanTrash *trash = l->data;
+      GstVulkanQueue *queue;
 
       if (device == NULL)
         device = trash->fence->device;
 
-      fences[i] = trash->fence->fence;
-
       /* only support waiting on fences from the same device */
       g_assert (device == trash->fence->device);
+
+      if ((queue = gst_vulkan_fence_get_timeline_queue (trash->fence))) {
+        guint64 value = gst_vulkan_fence_get_timeline_value (trash->fence);
+
+        if (value == 0) {
+          GST_WARNING_OBJECT (trash_list, "Cannot wait on unsubmitted fence %"
+              GST_PTR_FORMAT, trash->fence);
+          err = VK_TIMEOUT;
+          continue;
+        }
+
+        for (j = 0; j < n_timelines; j++) {
+          if (timelines[j] == queue)
+            break;
+        }
+        if (j == n_timelines) {
+          timelines[n_timelines++] = queue;
+          timeline_values[j] = value;
+        } else {
+          timeline_values[j] = MAX (timeline_values[j], value);
+        }
+      } else if (trash->fence->fence) {
+        fences[n_fences++] = trash->fence->fence;
+      }
     }
 
-    GST_TRACE_OBJECT (trash_list, "Waiting on %d fences with timeout %"
-        GST_TIME_FORMAT, n, GST_TIME_ARGS (timeout));
-    err = vkWaitForFences (device->device, n, fences, TRUE, timeout);
+    GST_TRACE_OBJECT (trash_list, "Waiting on %d fences and %d timelines "
+        "with timeout %" GST_TIME_FORMAT, n_fences, n_timelines,
+        GST_TIME_ARGS (timeout));
+    if (n_fences > 0) {
+      VkResult wait_err;
+
+      wait_err = vkWaitForFences (device->device, n_fences, fences, TRUE,
+          timeout);
+      if (wait_err != VK_SUCCESS)
+        err = wait_err;
+    }
+    for (j = 0; j < n_timelines; j++) {
+      if (!gst_vulkan_queue_wait_timeline_value (timelines[j],
+              timeline_values[j], timeout))
+        err = VK_TIMEOUT;
+    }
     g_free (fences);
+    g_free (timelines);
+    g_free (timeline_values);
 
     gst_vulkan_trash_fence_list_gc (trash_list);
   }
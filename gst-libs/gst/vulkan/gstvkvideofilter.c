@@ -163,6 +163,7 @@ struct choose_data
 {
   GstVulkanVideoFilter *upload;
   GstVulkanQueue *queue;
+  GstVulkanQueue *compute_queue;
 };
 
 static gboolean
@@ -179,6 +180,9 @@ _choose_queue (GstVulkanDevice * device, GstVulkanQueue * queue,
     return FALSE;
   }
 
+  if ((flags & VK_QUEUE_COMPUTE_BIT) != 0 && !data->compute_queue)
+    data->compute_queue = gst_object_ref (queue);
+
   return TRUE;
 }
 
@@ -189,10 +193,17 @@ _find_graphics_queue (GstVulkanVideoFilter * upload)
 
   data.upload = upload;
   data.queue = NULL;
+  data.compute_queue = NULL;
 
   gst_vulkan_device_foreach_queue (upload->device,
       (GstVulkanDeviceForEachQueueFunc) _choose_queue, &data);
 
+  /* devices without any graphics queue can still be used by the filters
+   * only requiring compute */
+  if (!data.queue)
+    data.queue = g_steal_pointer (&data.compute_queue);
+  gst_clear_object (&data.compute_queue);
+
   return data.queue;
 }
 
@@ -87,6 +87,7 @@ typedef struct _GstVulkanHandle GstVulkanHandle;
 
 typedef struct _GstVulkanHandlePool GstVulkanHandlePool;
 typedef struct _GstVulkanHandlePoolClass GstVulkanHandlePoolClass;
+typedef struct _GstVulkanHandlePoolPrivate GstVulkanHandlePoolPrivate;
 
 typedef struct _GstVulkanImageMemory GstVulkanImageMemory;
 typedef struct _GstVulkanImageMemoryAllocator GstVulkanImageMemoryAllocator;
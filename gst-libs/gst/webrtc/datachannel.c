@@ -54,6 +54,7 @@ enum
   SIGNAL_SEND_DATA,
   SIGNAL_SEND_STRING,
   SIGNAL_CLOSE,
+  SIGNAL_SEND_DATA_LIST,
   LAST_SIGNAL,
 };
 
@@ -360,6 +361,21 @@ gst_webrtc_data_channel_class_init (GstWebRTCDataChannelClass * klass)
       G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
       G_CALLBACK (gst_webrtc_data_channel_close), NULL, NULL, NULL,
       G_TYPE_NONE, 0);
+
+  /**
+   * GstWebRTCDataChannel::send-data-list:
+   * @object: the #GstWebRTCDataChannel
+   * @data: (element-type GBytes): a #GPtrArray of #GBytes
+   *
+   * Send each #GBytes of @data as a separate data message
+   *
+   * Since: 1.20
+   */
+  gst_webrtc_data_channel_signals[SIGNAL_SEND_DATA_LIST] =
+      g_signal_new_class_handler ("send-data-list", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_CALLBACK (gst_webrtc_data_channel_send_data_list), NULL, NULL, NULL,
+      G_TYPE_NONE, 1, G_TYPE_PTR_ARRAY);
 }
 
 static void
@@ -541,6 +557,37 @@ gst_webrtc_data_channel_send_string (GstWebRTCDataChannel * channel,
   klass->send_string (channel, str);
 }
 
+/**
+ * gst_webrtc_data_channel_send_data_list:
+ * @channel: a #GstWebRTCDataChannel
+ * @data: (element-type GBytes): a #GPtrArray of #GBytes
+ *
+ * Send each #GBytes of @data as a separate data message over @channel.
+ * Unlike calling gst_webrtc_data_channel_send_data() for every message this
+ * allows the implementation to hand all messages to the transport at once.
+ *
+ * Since: 1.20
+ */
+void
+gst_webrtc_data_channel_send_data_list (GstWebRTCDataChannel * channel,
+    GPtrArray * data)
+{
+  GstWebRTCDataChannelClass *klass;
+  guint i;
+
+  g_return_if_fail (GST_IS_WEBRTC_DATA_CHANNEL (channel));
+  g_return_if_fail (data != NULL);
+
+  klass = GST_WEBRTC_DATA_CHANNEL_GET_CLASS (channel);
+  if (klass->send_data_list) {
+    klass->send_data_list (channel, data);
+    return;
+  }
+
+  for (i = 0; i < data->len; i++)
+    klass->send_data (channel, g_ptr_array_index (data, i));
+}
+
 /**
  * gst_webrtc_data_channel_close:
  * @channel: a #GstWebRTCDataChannel
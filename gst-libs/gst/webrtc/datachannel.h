@@ -77,8 +77,9 @@ struct _GstWebRTCDataChannelClass
   void              (*send_data)   (GstWebRTCDataChannel * channel, GBytes *data);
   void              (*send_string) (GstWebRTCDataChannel * channel, const gchar *str);
   void              (*close)       (GstWebRTCDataChannel * channel);
+  void              (*send_data_list) (GstWebRTCDataChannel * channel, GPtrArray *data);
 
-  gpointer           _padding[GST_PADDING];
+  gpointer           _padding[GST_PADDING - 1];
 };
 
 GST_WEBRTC_API
@@ -105,6 +106,9 @@ void gst_webrtc_data_channel_send_data (GstWebRTCDataChannel * channel, GBytes *
 GST_WEBRTC_API
 void gst_webrtc_data_channel_send_string (GstWebRTCDataChannel * channel, const gchar * str);
 
+GST_WEBRTC_API
+void gst_webrtc_data_channel_send_data_list (GstWebRTCDataChannel * channel, GPtrArray * data);
+
 GST_WEBRTC_API
 void gst_webrtc_data_channel_close (GstWebRTCDataChannel * channel);
 
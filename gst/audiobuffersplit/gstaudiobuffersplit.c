@@ -31,14 +31,14 @@ static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS (GST_AUDIO_CAPS_MAKE (GST_AUDIO_FORMATS_ALL)
-        ", layout = (string) interleaved")
+        ", layout = (string) { interleaved, non-interleaved }")
     );
 
 static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS (GST_AUDIO_CAPS_MAKE (GST_AUDIO_FORMATS_ALL)
-        ", layout = (string) interleaved")
+        ", layout = (string) { interleaved, non-interleaved }")
     );
 
 enum
@@ -191,6 +191,7 @@ gst_audio_buffer_split_init (GstAudioBufferSplit * self)
   self->output_buffer_size = 0;
 
   self->adapter = gst_adapter_new ();
+  g_queue_init (&self->planar_queue);
 
   self->stream_align =
       gst_audio_stream_align_new (48000, DEFAULT_ALIGNMENT_THRESHOLD,
@@ -203,6 +204,7 @@ gst_audio_buffer_split_finalize (GObject * object)
   GstAudioBufferSplit *self = GST_AUDIO_BUFFER_SPLIT (object);
 
   if (self->adapter) {
+    gst_audio_buffer_split_clear (self);
     gst_object_unref (self->adapter);
     self->adapter = NULL;
   }
@@ -376,7 +378,7 @@ gst_audio_buffer_split_change_state (GstElement * element,
 
   switch (transition) {
     case GST_STATE_CHANGE_PAUSED_TO_READY:
-      gst_adapter_clear (self->adapter);
+      gst_audio_buffer_split_clear (self);
       GST_OBJECT_LOCK (self);
       gst_audio_stream_align_mark_discont (self->stream_align);
       GST_OBJECT_UNLOCK (self);
@@ -388,6 +390,161 @@ gst_audio_buffer_split_change_state (GstElement * element,
   return state_ret;
 }
 
+static gboolean
+gst_audio_buffer_split_is_planar (GstAudioBufferSplit * self)
+{
+  return self->info.finfo &&
+      GST_AUDIO_INFO_LAYOUT (&self->info) == GST_AUDIO_LAYOUT_NON_INTERLEAVED;
+}
+
+/* the size of non-interleaved buffers is not enough for knowing how many
+ * samples they contain once they were truncated */
+static guint
+gst_audio_buffer_split_get_n_samples (GstBuffer * buffer, gint bpf)
+{
+  GstAudioMeta *meta = gst_buffer_get_audio_meta (buffer);
+
+  if (meta && meta->info.layout == GST_AUDIO_LAYOUT_NON_INTERLEAVED)
+    return meta->samples;
+
+  return gst_buffer_get_size (buffer) / bpf;
+}
+
+/* Non-interleaved buffers can't be split at byte offsets like the adapter
+ * does, so they are queued as they are and split by samples instead. Sizes
+ * are still in bytes of all planes to be handled like the adapter. */
+
+static void
+gst_audio_buffer_split_push (GstAudioBufferSplit * self, GstBuffer * buffer)
+{
+  if (gst_audio_buffer_split_is_planar (self)) {
+    gint bpf = GST_AUDIO_INFO_BPF (&self->info);
+
+    self->planar_avail +=
+        gst_audio_buffer_split_get_n_samples (buffer, bpf) * bpf;
+    g_queue_push_tail (&self->planar_queue, buffer);
+  } else {
+    gst_audio_buffer_split_push (self, buffer);
+  }
+}
+
+static guint
+gst_audio_buffer_split_available (GstAudioBufferSplit * self)
+{
+  if (gst_audio_buffer_split_is_planar (self))
+    return self->planar_avail;
+
+  return gst_adapter_available (self->adapter);
+}
+
+static void
+gst_audio_buffer_split_clear (GstAudioBufferSplit * self)
+{
+  gst_audio_buffer_split_clear (self);
+  g_queue_clear_full (&self->planar_queue, (GDestroyNotify) gst_buffer_unref);
+  self->planar_skip = 0;
+  self->planar_avail = 0;
+}
+
+static GstBuffer *
+gst_audio_buffer_split_take_planar (GstAudioBufferSplit * self, gint size)
+{
+  GstAudioInfo *info = &self->info;
+  gint bpf = GST_AUDIO_INFO_BPF (info);
+  gint bps = GST_AUDIO_INFO_BPS (info);
+  guint n_samples = size / bpf, offset = 0;
+  GstBuffer *head, *buffer;
+  GstAudioBuffer dest;
+  guint head_samples;
+  gint i;
+
+  head = g_queue_peek_head (&self->planar_queue);
+  head_samples = gst_audio_buffer_split_get_n_samples (head, bpf);
+  self->planar_avail -= size;
+
+  /* inside of one input buffer, only the audio meta has to be changed */
+  if (head_samples - self->planar_skip >= n_samples) {
+    buffer = gst_audio_buffer_truncate (gst_buffer_ref (head), bpf,
+        self->planar_skip, n_samples);
+    self->planar_skip += n_samples;
+    if (self->planar_skip == head_samples) {
+      gst_buffer_unref (g_queue_pop_head (&self->planar_queue));
+      self->planar_skip = 0;
+    }
+    return buffer;
+  }
+
+  /* otherwise the samples of every plane are copied next to each other,
+   * still without interleaving */
+  buffer = gst_buffer_new_allocate (NULL, size, NULL);
+  gst_buffer_copy_into (buffer, head, GST_BUFFER_COPY_METADATA, 0, -1);
+  gst_buffer_add_audio_meta (buffer, info, n_samples, NULL);
+  gst_audio_buffer_map (&dest, info, buffer, GST_MAP_WRITE);
+
+  while (offset < n_samples) {
+    GstAudioBuffer src;
+    guint n;
+
+    head = g_queue_peek_head (&self->planar_queue);
+    head_samples = gst_audio_buffer_split_get_n_samples (head, bpf);
+    n = MIN (head_samples - self->planar_skip, n_samples - offset);
+
+    gst_audio_buffer_map (&src, info, head, GST_MAP_READ);
+    for (i = 0; i < GST_AUDIO_BUFFER_N_PLANES (&dest); i++) {
+      memcpy ((guint8 *) dest.planes[i] + offset * bps,
+          (guint8 *) src.planes[i] + self->planar_skip * bps, n * bps);
+    }
+    gst_audio_buffer_unmap (&src);
+
+    offset += n;
+    self->planar_skip += n;
+    if (self->planar_skip == head_samples) {
+      gst_buffer_unref (g_queue_pop_head (&self->planar_queue));
+      self->planar_skip = 0;
+    }
+  }
+
+  gst_audio_buffer_unmap (&dest);
+
+  return buffer;
+}
+
+/* Takes @size bytes without copying, sharing the memories of the input
+ * buffers. Only if one of the memories would not contain whole frames,
+ * which happens if upstream doesn't push whole frames per memory, the
+ * data is copied to a single memory. */
+static GstBuffer *
+gst_audio_buffer_split_take (GstAudioBufferSplit * self, gint size)
+{
+  gint bpf = GST_AUDIO_INFO_BPF (&self->info);
+  GstBuffer *buffer, *merged;
+  GstMapInfo map;
+  guint i, n_mem;
+  gboolean aligned = TRUE;
+
+  if (gst_audio_buffer_split_is_planar (self))
+    return gst_audio_buffer_split_take_planar (self, size);
+
+  buffer = gst_adapter_take_buffer_fast (self->adapter, size);
+
+  n_mem = gst_buffer_n_memory (buffer);
+  for (i = 0; i < n_mem && aligned; i++)
+    aligned = gst_buffer_peek_memory (buffer, i)->size % bpf == 0;
+
+  if (aligned)
+    return buffer;
+
+  GST_LOG_OBJECT (self, "memories not frame aligned, copying");
+  merged = gst_buffer_new_allocate (NULL, size, NULL);
+  gst_buffer_copy_into (merged, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
+  gst_buffer_map (merged, &map, GST_MAP_WRITE);
+  gst_buffer_extract (buffer, 0, map.data, size);
+  gst_buffer_unmap (merged, &map);
+  gst_buffer_unref (buffer);
+
+  return merged;
+}
+
 static GstFlowReturn
 gst_audio_buffer_split_output (GstAudioBufferSplit * self, gboolean force,
     gint rate, gint bpf, guint samples_per_buffer)
@@ -405,13 +562,13 @@ gst_audio_buffer_split_output (GstAudioBufferSplit * self, gboolean force,
       self->output_buffer_duration_d)
     size += bpf;
 
-  while ((avail = gst_adapter_available (self->adapter)) >= size || (force
+  while ((avail = gst_audio_buffer_split_available (self)) >= size || (force
           && avail > 0)) {
     GstBuffer *buffer;
     GstClockTime resync_time_diff;
 
     size = MIN (size, avail);
-    buffer = gst_adapter_take_buffer (self->adapter, size);
+    buffer = gst_audio_buffer_split_take (self, size);
     buffer = gst_buffer_make_writable (buffer);
 
     /* After a reset we have to set the discont flag */
@@ -480,7 +637,7 @@ gst_audio_buffer_split_handle_discont (GstAudioBufferSplit * self,
 {
   gboolean discont;
   GstFlowReturn ret = GST_FLOW_OK;
-  guint avail = gst_adapter_available (self->adapter);
+  guint avail = gst_audio_buffer_split_available (self);
   guint avail_samples = avail / bpf;
   guint64 new_offset;
   GstClockTime input_rt, current_rt;
@@ -491,7 +648,8 @@ gst_audio_buffer_split_handle_discont (GstAudioBufferSplit * self,
       gst_segment_to_running_time (&self->in_segment, GST_FORMAT_TIME,
       GST_BUFFER_PTS (buffer));
   input_duration =
-      (gst_buffer_get_size (buffer) / bpf) / ABS (self->in_segment.rate);
+      gst_audio_buffer_split_get_n_samples (buffer,
+      bpf) / ABS (self->in_segment.rate);
 
   GST_OBJECT_LOCK (self);
 
@@ -591,8 +749,11 @@ gst_audio_buffer_split_handle_discont (GstAudioBufferSplit * self,
             gst_buffer_map (silence, &map, GST_MAP_WRITE);
             gst_audio_format_info_fill_silence (info, map.data, map.size);
             gst_buffer_unmap (silence, &map);
+            if (gst_audio_buffer_split_is_planar (self))
+              gst_buffer_add_audio_meta (silence, &self->info, n_samples,
+                  NULL);
 
-            gst_adapter_push (self->adapter, silence);
+            gst_audio_buffer_split_push (self, silence);
             ret =
                 gst_audio_buffer_split_output (self, FALSE, rate, bpf,
                 samples_per_buffer);
@@ -629,7 +790,7 @@ gst_audio_buffer_split_handle_discont (GstAudioBufferSplit * self,
         GST_TIME_ARGS (current_rt_end), GST_TIME_ARGS (input_rt));
 
     if (self->strict_buffer_size) {
-      gst_adapter_clear (self->adapter);
+      gst_audio_buffer_split_clear (self);
       ret = GST_FLOW_OK;
     } else {
       ret =
@@ -674,7 +835,7 @@ gst_audio_buffer_split_clip_buffer_start_for_gapless (GstAudioBufferSplit *
   if (!self->gapless || self->drop_samples == 0)
     return buffer;
 
-  nsamples = gst_buffer_get_size (buffer) / bpf;
+  nsamples = gst_audio_buffer_split_get_n_samples (buffer, bpf);
 
   GST_DEBUG_OBJECT (self, "Have to drop %" G_GUINT64_FORMAT
       " samples, got %u samples", self->drop_samples, nsamples);
@@ -726,7 +887,7 @@ gst_audio_buffer_split_sink_chain (GstPad * pad, GstObject * parent,
               GST_FORMAT_TIME, GST_BUFFER_PTS (buffer))),
       GST_TIME_ARGS (GST_BUFFER_PTS (buffer)),
       GST_TIME_ARGS (GST_BUFFER_DURATION (buffer)),
-      (guint) (gst_buffer_get_size (buffer) / bpf));
+      gst_audio_buffer_split_get_n_samples (buffer, bpf));
 
   if (format == GST_AUDIO_FORMAT_UNKNOWN || samples_per_buffer == 0) {
     gst_buffer_unref (buffer);
@@ -753,7 +914,7 @@ gst_audio_buffer_split_sink_chain (GstPad * pad, GstObject * parent,
   if (!buffer)
     return GST_FLOW_OK;
 
-  gst_adapter_push (self->adapter, buffer);
+  gst_audio_buffer_split_push (self, buffer);
 
   return gst_audio_buffer_split_output (self, FALSE, rate, bpf,
       samples_per_buffer);
@@ -779,7 +940,7 @@ gst_audio_buffer_split_sink_event (GstPad * pad, GstObject * parent,
 
         if (!gst_audio_info_is_equal (&info, &self->info)) {
           if (self->strict_buffer_size) {
-            gst_adapter_clear (self->adapter);
+            gst_audio_buffer_split_clear (self);
           } else {
             GstAudioFormat format;
             gint rate, bpf, samples_per_buffer;
@@ -823,7 +984,7 @@ gst_audio_buffer_split_sink_event (GstPad * pad, GstObject * parent,
       GST_OBJECT_UNLOCK (self);
       self->current_offset = -1;
       self->accumulated_error = 0;
-      gst_adapter_clear (self->adapter);
+      gst_audio_buffer_split_clear (self);
       ret = gst_pad_event_default (pad, parent, event);
       break;
     case GST_EVENT_SEGMENT:
@@ -843,7 +1004,7 @@ gst_audio_buffer_split_sink_event (GstPad * pad, GstObject * parent,
       break;
     case GST_EVENT_EOS:
       if (self->strict_buffer_size) {
-        gst_adapter_clear (self->adapter);
+        gst_audio_buffer_split_clear (self);
       } else {
         GstAudioFormat format;
         gint rate, bpf, samples_per_buffer;
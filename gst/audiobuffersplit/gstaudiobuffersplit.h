@@ -54,6 +54,11 @@ struct _GstAudioBufferSplit {
   GstAudioInfo info;
 
   GstAdapter *adapter;
+  /* non-interleaved input, with the samples of the first buffer already
+   * output and the bytes of all planes queued */
+  GQueue planar_queue;
+  guint planar_skip;
+  guint planar_avail;
 
   GstAudioStreamAlign *stream_align;
   GstClockTime resync_pts, resync_rt;
@@ -217,6 +217,31 @@ gst_audio_channel_mix_setup (GstAudioFilter * filter, const GstAudioInfo * info)
   return TRUE;
 }
 
+/* Adding and removing 1.5 * 2^23 rounds a float of magnitude below 2^22 to
+ * the nearest integer the way rint() does, without a libm call keeping the
+ * compiler from vectorizing the loop over the frames */
+#define ROUND_MAGIC 12582912.0f
+
+static void
+gst_audio_channel_mix_process_float (gint16 * data, gint n, gfloat ll,
+    gfloat lr, gfloat rl, gfloat rr)
+{
+  gint i;
+
+  for (i = 0; i < n; i++) {
+    gfloat l = data[2 * i + 0];
+    gfloat r = data[2 * i + 1];
+    gfloat out_l = ll * l + rl * r;
+    gfloat out_r = lr * l + rr * r;
+
+    /* the bounds are integers, so clamping before rounding is the same */
+    out_l = CLAMP (out_l, -32768.0f, 32767.0f);
+    out_r = CLAMP (out_r, -32768.0f, 32767.0f);
+    data[2 * i + 0] = (gint16) ((out_l + ROUND_MAGIC) - ROUND_MAGIC);
+    data[2 * i + 1] = (gint16) ((out_r + ROUND_MAGIC) - ROUND_MAGIC);
+  }
+}
+
 static GstFlowReturn
 gst_audio_channel_mix_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
 {
@@ -237,11 +262,18 @@ gst_audio_channel_mix_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
 
   n = gst_buffer_get_size (buf) >> 2;
   data = (gint16 *) map.data;
-  for (i = 0; i < n; i++) {
-    l = data[2 * i + 0];
-    r = data[2 * i + 1];
-    data[2 * i + 0] = CLAMP (rint (ll * l + rl * r), -32768, 32767);
-    data[2 * i + 1] = CLAMP (rint (lr * l + rr * r), -32768, 32767);
+  if (fabs (ll) <= G_MAXINT16 && fabs (lr) <= G_MAXINT16 &&
+      fabs (rl) <= G_MAXINT16 && fabs (rr) <= G_MAXINT16) {
+    /* single precision is exact enough for 16 bit samples and any sensible
+     * gain, and twice as many samples fit in a vector register */
+    gst_audio_channel_mix_process_float (data, n, ll, lr, rl, rr);
+  } else {
+    for (i = 0; i < n; i++) {
+      l = data[2 * i + 0];
+      r = data[2 * i + 1];
+      data[2 * i + 0] = CLAMP (rint (ll * l + rl * r), -32768, 32767);
+      data[2 * i + 1] = CLAMP (rint (lr * l + rr * r), -32768, 32767);
+    }
   }
 
   gst_buffer_unmap (buf, &map);
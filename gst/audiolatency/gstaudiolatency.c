@@ -26,8 +26,11 @@
  * outputting period ticks on the source pad and measuring how long they take to
  * arrive on the sink pad.
  *
- * The ticks have a period of 1 second, so this element can only measure
- * latencies smaller than that.
+ * The ticks have a period of #GstAudioLatency:tick-interval, 1 second by
+ * default, so this element can only measure latencies smaller than that.
+ * Lowering the interval increases the measurement rate, and lowering
+ * #GstAudioLatency:samplesperbuffer increases the resolution of each
+ * measurement.
  *
  * ## Example pipeline
  * |[
@@ -49,6 +52,22 @@
  * "average-latency" fields in the GstStructure.
  *
  * The average latency is a running average of the last 5 measurements.
+ *
+ * When #GstAudioLatency:summary-interval is non-zero, a "latency-summary"
+ * element message is posted every that many measurements with statistics
+ * over them, all in microseconds:
+ *
+ * * #guint `count`: the number of measurements.
+ * * #gint64 `min-latency`, `max-latency`, `mean-latency`: their range and
+ *   mean.
+ * * #gint64 `stddev`: their standard deviation.
+ * * #gint64 `jitter`: the mean absolute difference between consecutive
+ *   measurements.
+ * * #gint64 `p50-latency`, `p90-latency`, `p95-latency`, `p99-latency`: the
+ *   percentiles of the measurements.
+ * * #GstValueArray of #guint `histogram`: the number of measurements in each
+ *   bucket of `histogram-bucket-width`, starting at `histogram-start`. The
+ *   buckets are widened if it would need more than 256 of them.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -56,6 +75,7 @@
 #endif
 
 #include "gstaudiolatency.h"
+#include "gstvideolatency.h"
 
 #define AUDIOLATENCY_CAPS "audio/x-raw, " \
     "format = (string) F32LE, " \
@@ -82,12 +102,20 @@ static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
 G_DEFINE_TYPE (GstAudioLatency, gst_audiolatency, GST_TYPE_BIN);
 
 #define DEFAULT_PRINT_LATENCY   FALSE
+#define DEFAULT_SAMPLES_PER_BUFFER 240
+#define DEFAULT_TICK_INTERVAL   GST_SECOND
+#define DEFAULT_SUMMARY_INTERVAL 0
+#define DEFAULT_HISTOGRAM_BUCKET_WIDTH 1000
 enum
 {
   PROP_0,
   PROP_PRINT_LATENCY,
   PROP_LAST_LATENCY,
-  PROP_AVERAGE_LATENCY
+  PROP_AVERAGE_LATENCY,
+  PROP_SAMPLESPERBUFFER,
+  PROP_TICK_INTERVAL,
+  PROP_SUMMARY_INTERVAL,
+  PROP_HISTOGRAM_BUCKET_WIDTH
 };
 
 static gint64 gst_audiolatency_get_latency (GstAudioLatency * self);
@@ -113,6 +141,22 @@ gst_audiolatency_get_property (GObject * object,
     case PROP_AVERAGE_LATENCY:
       g_value_set_int64 (value, gst_audiolatency_get_average_latency (self));
       break;
+    case PROP_SAMPLESPERBUFFER:
+      g_value_set_int (value, self->samplesperbuffer);
+      break;
+    case PROP_TICK_INTERVAL:
+      g_value_set_uint64 (value, self->tick_interval);
+      break;
+    case PROP_SUMMARY_INTERVAL:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->summary_interval);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_HISTOGRAM_BUCKET_WIDTH:
+      GST_OBJECT_LOCK (self);
+      g_value_set_int64 (value, self->histogram_bucket_width);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -129,12 +173,41 @@ gst_audiolatency_set_property (GObject * object,
     case PROP_PRINT_LATENCY:
       self->print_latency = g_value_get_boolean (value);
       break;
+    case PROP_SAMPLESPERBUFFER:
+      self->samplesperbuffer = g_value_get_int (value);
+      g_object_set (self->audiosrc, "samplesperbuffer", self->samplesperbuffer,
+          NULL);
+      break;
+    case PROP_TICK_INTERVAL:
+      self->tick_interval = g_value_get_uint64 (value);
+      g_object_set (self->audiosrc, "tick-interval", self->tick_interval, NULL);
+      break;
+    case PROP_SUMMARY_INTERVAL:
+      GST_OBJECT_LOCK (self);
+      self->summary_interval = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_HISTOGRAM_BUCKET_WIDTH:
+      GST_OBJECT_LOCK (self);
+      self->histogram_bucket_width = g_value_get_int64 (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+static void
+gst_audiolatency_finalize (GObject * object)
+{
+  GstAudioLatency *self = GST_AUDIOLATENCY (object);
+
+  gst_latency_stats_clear (&self->stats);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gst_audiolatency_class_init (GstAudioLatencyClass * klass)
 {
@@ -143,6 +216,7 @@ gst_audiolatency_class_init (GstAudioLatencyClass * klass)
 
   gobject_class->get_property = gst_audiolatency_get_property;
   gobject_class->set_property = gst_audiolatency_set_property;
+  gobject_class->finalize = gst_audiolatency_finalize;
 
   g_object_class_install_property (gobject_class, PROP_PRINT_LATENCY,
       g_param_spec_boolean ("print-latency", "Print latencies",
@@ -159,6 +233,61 @@ gst_audiolatency_class_init (GstAudioLatencyClass * klass)
           "The running average latency, in microseconds", 0,
           G_USEC_PER_SEC, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstAudioLatency:samplesperbuffer:
+   *
+   * Number of samples in each outgoing buffer. Smaller buffers give a finer
+   * resolution to the measurements.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_SAMPLESPERBUFFER,
+      g_param_spec_int ("samplesperbuffer", "Samples per buffer",
+          "Number of samples in each outgoing buffer",
+          1, G_MAXINT, DEFAULT_SAMPLES_PER_BUFFER,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAudioLatency:tick-interval:
+   *
+   * Interval between the ticks, which is the measurement period. Only
+   * latencies smaller than this can be measured.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_TICK_INTERVAL,
+      g_param_spec_uint64 ("tick-interval", "Tick interval",
+          "Interval between the ticks, in nanoseconds", 10 * GST_MSECOND,
+          GST_SECOND, DEFAULT_TICK_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAudioLatency:summary-interval:
+   *
+   * Number of measurements after which a "latency-summary" element message
+   * is posted, or 0 to not post any.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_SUMMARY_INTERVAL,
+      g_param_spec_uint ("summary-interval", "Summary interval",
+          "Number of measurements between latency summaries (0 = disabled)",
+          0, G_MAXUINT, DEFAULT_SUMMARY_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAudioLatency:histogram-bucket-width:
+   *
+   * Width of the histogram buckets of the latency summaries.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_HISTOGRAM_BUCKET_WIDTH,
+      g_param_spec_int64 ("histogram-bucket-width", "Histogram bucket width",
+          "Width of the latency summary histogram buckets, in microseconds",
+          1, G_USEC_PER_SEC, DEFAULT_HISTOGRAM_BUCKET_WIDTH,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (gstelement_class, &src_template);
   gst_element_class_add_static_pad_template (gstelement_class, &sink_template);
 
@@ -177,6 +306,11 @@ gst_audiolatency_init (GstAudioLatency * self)
   self->send_pts = 0;
   self->recv_pts = 0;
   self->print_latency = DEFAULT_PRINT_LATENCY;
+  self->samplesperbuffer = DEFAULT_SAMPLES_PER_BUFFER;
+  self->tick_interval = DEFAULT_TICK_INTERVAL;
+  self->summary_interval = DEFAULT_SUMMARY_INTERVAL;
+  self->histogram_bucket_width = DEFAULT_HISTOGRAM_BUCKET_WIDTH;
+  gst_latency_stats_init (&self->stats);
 
   /* Setup sinkpad */
   self->sinkpad = gst_pad_new_from_static_template (&sink_template, "sink");
@@ -186,7 +320,8 @@ gst_audiolatency_init (GstAudioLatency * self)
 
   /* Setup srcpad */
   self->audiosrc = gst_element_factory_make ("audiotestsrc", NULL);
-  g_object_set (self->audiosrc, "wave", 8, "samplesperbuffer", 240, NULL);
+  g_object_set (self->audiosrc, "wave", 8, "samplesperbuffer",
+      self->samplesperbuffer, "tick-interval", self->tick_interval, NULL);
   gst_bin_add (GST_BIN (self), self->audiosrc);
 
   templ = gst_static_pad_template_get (&src_template);
@@ -206,42 +341,21 @@ static gint64
 gst_audiolatency_get_latency (GstAudioLatency * self)
 {
   gint64 last_latency;
-  gint last_latency_idx;
 
   GST_OBJECT_LOCK (self);
-  /* Decrement index, with wrap-around */
-  last_latency_idx = self->next_latency_idx - 1;
-  if (last_latency_idx < 0)
-    last_latency_idx = GST_AUDIOLATENCY_NUM_LATENCIES - 1;
-
-  last_latency = self->latencies[last_latency_idx];
+  last_latency = gst_latency_stats_get_last (&self->stats);
   GST_OBJECT_UNLOCK (self);
 
   return last_latency;
 }
 
-static gint64
-gst_audiolatency_get_average_latency_unlocked (GstAudioLatency * self)
-{
-  int ii, n = 0;
-  gint64 average = 0;
-
-  for (ii = 0; ii < GST_AUDIOLATENCY_NUM_LATENCIES; ii++) {
-    if (G_LIKELY (self->latencies[ii] > 0))
-      n += 1;
-    average += self->latencies[ii];
-  }
-
-  return average / MAX (n, 1);
-}
-
 static gint64
 gst_audiolatency_get_average_latency (GstAudioLatency * self)
 {
   gint64 average;
 
   GST_OBJECT_LOCK (self);
-  average = gst_audiolatency_get_average_latency_unlocked (self);
+  average = gst_latency_stats_get_average (&self->stats);
   GST_OBJECT_UNLOCK (self);
 
   return average;
@@ -250,21 +364,34 @@ gst_audiolatency_get_average_latency (GstAudioLatency * self)
 static void
 gst_audiolatency_set_latency (GstAudioLatency * self, gint64 latency)
 {
+  GstStructure *summary = NULL;
   gint64 avg_latency;
 
   GST_OBJECT_LOCK (self);
-  self->latencies[self->next_latency_idx] = latency;
-
-  /* Increment index, with wrap-around */
-  self->next_latency_idx += 1;
-  if (self->next_latency_idx > GST_AUDIOLATENCY_NUM_LATENCIES - 1)
-    self->next_latency_idx = 0;
-
-  avg_latency = gst_audiolatency_get_average_latency_unlocked (self);
+  gst_latency_stats_add (&self->stats, latency);
+  avg_latency = gst_latency_stats_get_average (&self->stats);
 
   if (self->print_latency)
     g_print ("last latency: %" G_GINT64_FORMAT "ms, running average: %"
         G_GINT64_FORMAT "ms\n", latency / 1000, avg_latency / 1000);
+
+  if (self->summary_interval > 0 &&
+      gst_latency_stats_get_n_window (&self->stats) >= self->summary_interval)
+    summary = gst_latency_stats_take_summary (&self->stats,
+        self->histogram_bucket_width);
+  else if (self->summary_interval == 0)
+    gst_latency_stats_reset_window (&self->stats);
+
+  if (summary && self->print_latency) {
+    gint64 p50 = 0, p99 = 0, jitter = 0;
+
+    gst_structure_get_int64 (summary, "p50-latency", &p50);
+    gst_structure_get_int64 (summary, "p99-latency", &p99);
+    gst_structure_get_int64 (summary, "jitter", &jitter);
+    g_print ("summary of %u measurements: p50: %" G_GINT64_FORMAT "us, p99: %"
+        G_GINT64_FORMAT "us, jitter: %" G_GINT64_FORMAT "us\n",
+        self->summary_interval, p50, p99, jitter);
+  }
   GST_OBJECT_UNLOCK (self);
 
   /* Post an element message about it */
@@ -272,6 +399,23 @@ gst_audiolatency_set_latency (GstAudioLatency * self, gint64 latency)
       gst_message_new_element (GST_OBJECT (self),
           gst_structure_new ("latency", "last-latency", G_TYPE_INT64, latency,
               "average-latency", G_TYPE_INT64, avg_latency, NULL)));
+
+  if (summary)
+    gst_element_post_message (GST_ELEMENT (self),
+        gst_message_new_element (GST_OBJECT (self), summary));
+}
+
+/* Time in microseconds after a tick during which no other tick can arrive */
+static gint64
+gst_audiolatency_get_skip_time (GstAudioLatency * self)
+{
+  guint64 tick_interval;
+
+  GST_OBJECT_LOCK (self);
+  tick_interval = self->tick_interval;
+  GST_OBJECT_UNLOCK (self);
+
+  return gst_util_uint64_scale_int (tick_interval, 95, 100 * GST_USECOND);
 }
 
 static gint64
@@ -355,9 +499,10 @@ gst_audiolatency_src_probe (GstPad * pad, GstPadProbeInfo * info,
   GST_TRACE ("audiotestsrc pushed out a buffer");
 
   pts = g_get_monotonic_time ();
-  /* Ticks are once a second, so once we send something, we can skip
-   * checking ~1sec of buffers till the next one. */
-  if (self->send_pts > 0 && pts - self->send_pts <= 950 * 1000)
+  /* Ticks are once per interval, so once we send something, we can skip
+   * checking most of the buffers till the next one. */
+  if (self->send_pts > 0 &&
+      pts - self->send_pts <= gst_audiolatency_get_skip_time (self))
     goto out;
 
   /* Check if buffer contains a waveform */
@@ -396,10 +541,11 @@ gst_audiolatency_sink_chain (GstPad * pad, GstObject * parent,
   GST_TRACE_OBJECT (pad, "Got buffer %p", buffer);
 
   pts = g_get_monotonic_time ();
-  /* Ticks are once a second, so once we receive something, we can skip
-   * checking ~1sec of buffers till the next one. This way we also don't count
-   * the same tick twice for latency measurement. */
-  if (self->recv_pts > 0 && pts - self->recv_pts <= 950 * 1000)
+  /* Ticks are once per interval, so once we receive something, we can skip
+   * checking most of the buffers till the next one. This way we also don't
+   * count the same tick twice for latency measurement. */
+  if (self->recv_pts > 0 &&
+      pts - self->recv_pts <= gst_audiolatency_get_skip_time (self))
     goto out;
 
   offset = buffer_has_wave (buffer, pad);
@@ -425,12 +571,16 @@ plugin_init (GstPlugin * plugin)
   GST_DEBUG_CATEGORY_INIT (gst_audiolatency_debug, "audiolatency", 0,
       "audiolatency");
 
-  return gst_element_register (plugin, "audiolatency", GST_RANK_PRIMARY,
-      GST_TYPE_AUDIOLATENCY);
+  if (!gst_element_register (plugin, "audiolatency", GST_RANK_PRIMARY,
+          GST_TYPE_AUDIOLATENCY))
+    return FALSE;
+
+  return gst_element_register (plugin, "videolatency", GST_RANK_PRIMARY,
+      GST_TYPE_VIDEOLATENCY);
 }
 
 GST_PLUGIN_DEFINE (GST_VERSION_MAJOR,
     GST_VERSION_MINOR,
     audiolatency,
-    "A plugin to measure audio latency",
+    "A plugin to measure audio and video latency",
     plugin_init, VERSION, "LGPL", GST_PACKAGE_NAME, GST_PACKAGE_ORIGIN)
@@ -23,6 +23,8 @@
 
 #include <gst/gst.h>
 
+#include "gstlatencystats.h"
+
 G_BEGIN_DECLS
 #define GST_TYPE_AUDIOLATENCY \
   (gst_audiolatency_get_type ())
@@ -37,8 +39,6 @@ G_BEGIN_DECLS
 typedef struct _GstAudioLatency GstAudioLatency;
 typedef struct _GstAudioLatencyClass GstAudioLatencyClass;
 
-#define GST_AUDIOLATENCY_NUM_LATENCIES 5
-
 struct _GstAudioLatency
 {
   GstBin parent;
@@ -51,11 +51,14 @@ struct _GstAudioLatency
   /* measurements */
   gint64 send_pts;
   gint64 recv_pts;
-  gint next_latency_idx;
-  gint latencies[GST_AUDIOLATENCY_NUM_LATENCIES];
+  GstLatencyStats stats;
 
   /* properties */
   gboolean print_latency;
+  gint samplesperbuffer;
+  guint64 tick_interval;
+  guint summary_interval;
+  gint64 histogram_bucket_width;
 };
 
 struct _GstAudioLatencyClass
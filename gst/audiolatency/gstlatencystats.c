@@ -0,0 +1,202 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gstlatencystats.h"
+
+void
+gst_latency_stats_init (GstLatencyStats * stats)
+{
+  memset (stats->latencies, 0, sizeof (stats->latencies));
+  stats->next_latency_idx = 0;
+  stats->window = g_array_new (FALSE, FALSE, sizeof (gint64));
+}
+
+void
+gst_latency_stats_clear (GstLatencyStats * stats)
+{
+  g_clear_pointer (&stats->window, g_array_unref);
+}
+
+void
+gst_latency_stats_reset (GstLatencyStats * stats)
+{
+  memset (stats->latencies, 0, sizeof (stats->latencies));
+  stats->next_latency_idx = 0;
+  gst_latency_stats_reset_window (stats);
+}
+
+void
+gst_latency_stats_reset_window (GstLatencyStats * stats)
+{
+  g_array_set_size (stats->window, 0);
+}
+
+void
+gst_latency_stats_add (GstLatencyStats * stats, gint64 latency)
+{
+  stats->latencies[stats->next_latency_idx] = latency;
+
+  /* Increment index, with wrap-around */
+  stats->next_latency_idx += 1;
+  if (stats->next_latency_idx > GST_LATENCY_STATS_NUM_AVERAGE - 1)
+    stats->next_latency_idx = 0;
+
+  g_array_append_val (stats->window, latency);
+}
+
+gint64
+gst_latency_stats_get_last (const GstLatencyStats * stats)
+{
+  gint last_latency_idx;
+
+  /* Decrement index, with wrap-around */
+  last_latency_idx = stats->next_latency_idx - 1;
+  if (last_latency_idx < 0)
+    last_latency_idx = GST_LATENCY_STATS_NUM_AVERAGE - 1;
+
+  return stats->latencies[last_latency_idx];
+}
+
+gint64
+gst_latency_stats_get_average (const GstLatencyStats * stats)
+{
+  int ii, n = 0;
+  gint64 average = 0;
+
+  for (ii = 0; ii < GST_LATENCY_STATS_NUM_AVERAGE; ii++) {
+    if (G_LIKELY (stats->latencies[ii] > 0))
+      n += 1;
+    average += stats->latencies[ii];
+  }
+
+  return average / MAX (n, 1);
+}
+
+guint
+gst_latency_stats_get_n_window (const GstLatencyStats * stats)
+{
+  return stats->window->len;
+}
+
+static gint
+compare_latency (gconstpointer a, gconstpointer b)
+{
+  gint64 la = *(const gint64 *) a;
+  gint64 lb = *(const gint64 *) b;
+
+  return (la > lb) - (la < lb);
+}
+
+/* nearest-rank percentile of the n sorted values */
+static gint64
+percentile (const gint64 * sorted, guint n, guint p)
+{
+  guint64 rank = ((guint64) p * n + 99) / 100;
+
+  return sorted[MAX (rank, 1) - 1];
+}
+
+/* Builds a "latency-summary" structure of all the measurements since the
+ * last summary, and starts a new window. Returns %NULL if there were no
+ * measurements. */
+GstStructure *
+gst_latency_stats_take_summary (GstLatencyStats * stats, gint64 bucket_width)
+{
+  GstStructure *s;
+  GValue histogram = G_VALUE_INIT;
+  GValue count = G_VALUE_INIT;
+  gint64 *values, *sorted, min, max, start, jitter = 0;
+  gdouble mean = 0.0, variance = 0.0;
+  guint *buckets;
+  guint ii, n, n_buckets;
+
+  n = stats->window->len;
+  if (n == 0)
+    return NULL;
+
+  values = (gint64 *) stats->window->data;
+
+  /* Mean and variance in a single pass (Welford), and jitter as the mean
+   * absolute difference between consecutive measurements */
+  for (ii = 0; ii < n; ii++) {
+    gdouble delta = values[ii] - mean;
+
+    mean += delta / (ii + 1);
+    variance += delta * (values[ii] - mean);
+    if (ii > 0)
+      jitter += ABS (values[ii] - values[ii - 1]);
+  }
+  variance /= n;
+  if (n > 1)
+    jitter /= n - 1;
+
+  sorted = g_memdup (values, n * sizeof (gint64));
+  qsort (sorted, n, sizeof (gint64), compare_latency);
+  min = sorted[0];
+  max = sorted[n - 1];
+
+  /* Widen the buckets if needed to keep the histogram reasonably sized */
+  bucket_width = MAX (bucket_width, 1);
+  if ((max - min) / bucket_width >= GST_LATENCY_STATS_MAX_BUCKETS)
+    bucket_width = (max - min) / GST_LATENCY_STATS_MAX_BUCKETS + 1;
+  start = min - min % bucket_width;
+  if (start > min)
+    start -= bucket_width;
+  n_buckets = (max - start) / bucket_width + 1;
+
+  buckets = g_newa (guint, n_buckets);
+  memset (buckets, 0, n_buckets * sizeof (guint));
+  for (ii = 0; ii < n; ii++)
+    buckets[(sorted[ii] - start) / bucket_width]++;
+
+  g_value_init (&histogram, GST_TYPE_ARRAY);
+  g_value_init (&count, G_TYPE_UINT);
+  for (ii = 0; ii < n_buckets; ii++) {
+    g_value_set_uint (&count, buckets[ii]);
+    gst_value_array_append_value (&histogram, &count);
+  }
+  g_value_unset (&count);
+
+  s = gst_structure_new ("latency-summary",
+      "count", G_TYPE_UINT, n,
+      "min-latency", G_TYPE_INT64, min,
+      "max-latency", G_TYPE_INT64, max,
+      "mean-latency", G_TYPE_INT64, (gint64) (mean + 0.5),
+      "stddev", G_TYPE_INT64, (gint64) (sqrt (variance) + 0.5),
+      "jitter", G_TYPE_INT64, jitter,
+      "p50-latency", G_TYPE_INT64, percentile (sorted, n, 50),
+      "p90-latency", G_TYPE_INT64, percentile (sorted, n, 90),
+      "p95-latency", G_TYPE_INT64, percentile (sorted, n, 95),
+      "p99-latency", G_TYPE_INT64, percentile (sorted, n, 99),
+      "histogram-start", G_TYPE_INT64, start,
+      "histogram-bucket-width", G_TYPE_INT64, bucket_width, NULL);
+  gst_structure_take_value (s, "histogram", &histogram);
+
+  g_free (sorted);
+  gst_latency_stats_reset_window (stats);
+
+  return s;
+}
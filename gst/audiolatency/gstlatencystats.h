@@ -0,0 +1,65 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_LATENCY_STATS_H__
+#define __GST_LATENCY_STATS_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_LATENCY_STATS_NUM_AVERAGE 5
+#define GST_LATENCY_STATS_MAX_BUCKETS 256
+
+typedef struct _GstLatencyStats GstLatencyStats;
+
+/* Latency measurements in microseconds. Not thread-safe, callers protect it
+ * with their object lock. */
+struct _GstLatencyStats
+{
+  /* the last measurements, for the running average */
+  gint next_latency_idx;
+  gint64 latencies[GST_LATENCY_STATS_NUM_AVERAGE];
+
+  /* all measurements since the last summary */
+  GArray *window;
+};
+
+void           gst_latency_stats_init         (GstLatencyStats * stats);
+
+void           gst_latency_stats_clear        (GstLatencyStats * stats);
+
+void           gst_latency_stats_reset        (GstLatencyStats * stats);
+
+void           gst_latency_stats_reset_window (GstLatencyStats * stats);
+
+void           gst_latency_stats_add          (GstLatencyStats * stats,
+                                               gint64 latency);
+
+gint64         gst_latency_stats_get_last     (const GstLatencyStats * stats);
+
+gint64         gst_latency_stats_get_average  (const GstLatencyStats * stats);
+
+guint          gst_latency_stats_get_n_window (const GstLatencyStats * stats);
+
+GstStructure * gst_latency_stats_take_summary (GstLatencyStats * stats,
+                                               gint64 bucket_width);
+
+G_END_DECLS
+
+#endif /* __GST_LATENCY_STATS_H__ */
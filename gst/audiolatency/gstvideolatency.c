@@ -0,0 +1,535 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-videolatency
+ * @title: videolatency
+ *
+ * The video counterpart of audiolatency. Measures the video latency between
+ * the source pad and the sink pad by outputting black frames carrying a
+ * simplevideomark pattern with a sequence number, and measuring how long
+ * they take to be found by simplevideomarkdetect on the sink pad.
+ *
+ * A mark is output every #GstVideoLatency:mark-interval frames, which sets
+ * the measurement rate. Latencies of more than 1024 marks can't be
+ * measured.
+ *
+ * ## Example pipeline
+ * |[
+ * gst-launch-1.0 -v v4l2src ! videoconvert ! videolatency print-latency=true pattern-width=64 pattern-height=64 ! videoconvert ! autovideosink
+ * ]| Continuously print the glass-to-glass latency of the display and the
+ * camera capturing it
+ *
+ * In this case, the camera must be pointed at the bottom left corner of the
+ * displayed video, and the pattern must be large enough for its squares to
+ * be told apart in the captured frames.
+ *
+ * The "latency" element message and the "latency-summary" element message
+ * posted every #GstVideoLatency:summary-interval measurements have the same
+ * fields as the ones of audiolatency, all in microseconds.
+ *
+ * Since: 1.20
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <gst/video/video.h>
+
+#include "gstvideolatency.h"
+
+#define VIDEOLATENCY_CAPS \
+    GST_VIDEO_CAPS_MAKE( \
+        "{ I420, YV12, Y41B, Y42B, Y444, YUY2, UYVY, AYUV, YVYU }")
+
+GST_DEBUG_CATEGORY_STATIC (gst_videolatency_debug);
+#define GST_CAT_DEFAULT gst_videolatency_debug
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (VIDEOLATENCY_CAPS)
+    );
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (VIDEOLATENCY_CAPS)
+    );
+
+#define gst_videolatency_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstVideoLatency, gst_videolatency, GST_TYPE_BIN,
+    GST_DEBUG_CATEGORY_INIT (gst_videolatency_debug, "videolatency", 0,
+        "videolatency"));
+
+#define DEFAULT_PRINT_LATENCY   FALSE
+#define DEFAULT_MARK_INTERVAL   1
+#define DEFAULT_PATTERN_WIDTH   4
+#define DEFAULT_PATTERN_HEIGHT  16
+#define DEFAULT_SUMMARY_INTERVAL 0
+#define DEFAULT_HISTOGRAM_BUCKET_WIDTH 1000
+enum
+{
+  PROP_0,
+  PROP_PRINT_LATENCY,
+  PROP_LAST_LATENCY,
+  PROP_AVERAGE_LATENCY,
+  PROP_MARK_INTERVAL,
+  PROP_PATTERN_WIDTH,
+  PROP_PATTERN_HEIGHT,
+  PROP_SUMMARY_INTERVAL,
+  PROP_HISTOGRAM_BUCKET_WIDTH
+};
+
+static void gst_videolatency_reset (GstVideoLatency * self);
+static GstStateChangeReturn gst_videolatency_change_state (GstElement *
+    element, GstStateChange transition);
+static void gst_videolatency_handle_message (GstBin * bin,
+    GstMessage * message);
+static GstPadProbeReturn gst_videolatency_mark_probe (GstPad * pad,
+    GstPadProbeInfo * info, gpointer user_data);
+static GstPadProbeReturn gst_videolatency_src_probe (GstPad * pad,
+    GstPadProbeInfo * info, gpointer user_data);
+
+static void
+gst_videolatency_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec)
+{
+  GstVideoLatency *self = GST_VIDEOLATENCY (object);
+
+  GST_OBJECT_LOCK (self);
+  switch (prop_id) {
+    case PROP_PRINT_LATENCY:
+      g_value_set_boolean (value, self->print_latency);
+      break;
+    case PROP_LAST_LATENCY:
+      g_value_set_int64 (value, gst_latency_stats_get_last (&self->stats));
+      break;
+    case PROP_AVERAGE_LATENCY:
+      g_value_set_int64 (value, gst_latency_stats_get_average (&self->stats));
+      break;
+    case PROP_MARK_INTERVAL:
+      g_value_set_uint (value, self->mark_interval);
+      break;
+    case PROP_PATTERN_WIDTH:
+      g_value_set_int (value, self->pattern_width);
+      break;
+    case PROP_PATTERN_HEIGHT:
+      g_value_set_int (value, self->pattern_height);
+      break;
+    case PROP_SUMMARY_INTERVAL:
+      g_value_set_uint (value, self->summary_interval);
+      break;
+    case PROP_HISTOGRAM_BUCKET_WIDTH:
+      g_value_set_int64 (value, self->histogram_bucket_width);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (self);
+}
+
+static void
+gst_videolatency_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec)
+{
+  GstVideoLatency *self = GST_VIDEOLATENCY (object);
+
+  switch (prop_id) {
+    case PROP_PRINT_LATENCY:
+      GST_OBJECT_LOCK (self);
+      self->print_latency = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_MARK_INTERVAL:
+      GST_OBJECT_LOCK (self);
+      self->mark_interval = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_PATTERN_WIDTH:
+      self->pattern_width = g_value_get_int (value);
+      if (self->mark && self->detect) {
+        g_object_set (self->mark, "pattern-width", self->pattern_width, NULL);
+        g_object_set (self->detect, "pattern-width", self->pattern_width,
+            NULL);
+      }
+      break;
+    case PROP_PATTERN_HEIGHT:
+      self->pattern_height = g_value_get_int (value);
+      if (self->mark && self->detect) {
+        g_object_set (self->mark, "pattern-height", self->pattern_height,
+            NULL);
+        g_object_set (self->detect, "pattern-height", self->pattern_height,
+            NULL);
+      }
+      break;
+    case PROP_SUMMARY_INTERVAL:
+      GST_OBJECT_LOCK (self);
+      self->summary_interval = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_HISTOGRAM_BUCKET_WIDTH:
+      GST_OBJECT_LOCK (self);
+      self->histogram_bucket_width = g_value_get_int64 (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_videolatency_finalize (GObject * object)
+{
+  GstVideoLatency *self = GST_VIDEOLATENCY (object);
+
+  gst_latency_stats_clear (&self->stats);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_videolatency_class_init (GstVideoLatencyClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+  GstElementClass *gstelement_class = (GstElementClass *) klass;
+  GstBinClass *gstbin_class = (GstBinClass *) klass;
+
+  gobject_class->get_property = gst_videolatency_get_property;
+  gobject_class->set_property = gst_videolatency_set_property;
+  gobject_class->finalize = gst_videolatency_finalize;
+
+  g_object_class_install_property (gobject_class, PROP_PRINT_LATENCY,
+      g_param_spec_boolean ("print-latency", "Print latencies",
+          "Print the measured latencies on stdout",
+          DEFAULT_PRINT_LATENCY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_LAST_LATENCY,
+      g_param_spec_int64 ("last-latency", "Last measured latency",
+          "The last latency that was measured, in microseconds", 0,
+          G_MAXINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_AVERAGE_LATENCY,
+      g_param_spec_int64 ("average-latency", "Running average latency",
+          "The running average latency, in microseconds", 0,
+          G_MAXINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MARK_INTERVAL,
+      g_param_spec_uint ("mark-interval", "Mark interval",
+          "Number of frames between two marked frames", 1, G_MAXUINT,
+          DEFAULT_MARK_INTERVAL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PATTERN_WIDTH,
+      g_param_spec_int ("pattern-width", "Pattern width",
+          "The width of the pattern markers", 1, G_MAXINT,
+          DEFAULT_PATTERN_WIDTH, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PATTERN_HEIGHT,
+      g_param_spec_int ("pattern-height", "Pattern height",
+          "The height of the pattern markers", 1, G_MAXINT,
+          DEFAULT_PATTERN_HEIGHT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_SUMMARY_INTERVAL,
+      g_param_spec_uint ("summary-interval", "Summary interval",
+          "Number of measurements between latency summaries (0 = disabled)",
+          0, G_MAXUINT, DEFAULT_SUMMARY_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_HISTOGRAM_BUCKET_WIDTH,
+      g_param_spec_int64 ("histogram-bucket-width", "Histogram bucket width",
+          "Width of the latency summary histogram buckets, in microseconds",
+          1, G_USEC_PER_SEC, DEFAULT_HISTOGRAM_BUCKET_WIDTH,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_add_static_pad_template (gstelement_class, &src_template);
+  gst_element_class_add_static_pad_template (gstelement_class, &sink_template);
+
+  gst_element_class_set_static_metadata (gstelement_class, "VideoLatency",
+      "Video/Util",
+      "Measures the video latency between the source and the sink",
+      "GStreamer developers");
+
+  gstelement_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_videolatency_change_state);
+  gstbin_class->handle_message =
+      GST_DEBUG_FUNCPTR (gst_videolatency_handle_message);
+}
+
+static void
+gst_videolatency_init (GstVideoLatency * self)
+{
+  GstPad *pad;
+  GstPadTemplate *templ;
+
+  self->print_latency = DEFAULT_PRINT_LATENCY;
+  self->mark_interval = DEFAULT_MARK_INTERVAL;
+  self->pattern_width = DEFAULT_PATTERN_WIDTH;
+  self->pattern_height = DEFAULT_PATTERN_HEIGHT;
+  self->summary_interval = DEFAULT_SUMMARY_INTERVAL;
+  self->histogram_bucket_width = DEFAULT_HISTOGRAM_BUCKET_WIDTH;
+  gst_latency_stats_init (&self->stats);
+  gst_videolatency_reset (self);
+
+  self->videosrc = gst_element_factory_make ("videotestsrc", NULL);
+  self->mark = gst_element_factory_make ("simplevideomark", NULL);
+  self->detect = gst_element_factory_make ("simplevideomarkdetect", NULL);
+  self->fakesink = gst_element_factory_make ("fakesink", NULL);
+
+  if (!self->videosrc || !self->mark || !self->detect || !self->fakesink) {
+    /* Error out when going to READY */
+    GST_ERROR_OBJECT (self, "Missing videotestsrc, simplevideomark, "
+        "simplevideomarkdetect or fakesink");
+    gst_clear_object (&self->videosrc);
+    gst_clear_object (&self->mark);
+    gst_clear_object (&self->detect);
+    gst_clear_object (&self->fakesink);
+
+    templ = gst_static_pad_template_get (&sink_template);
+    self->sinkpad = gst_ghost_pad_new_no_target_from_template ("sink", templ);
+    gst_element_add_pad (GST_ELEMENT (self), self->sinkpad);
+    gst_object_unref (templ);
+
+    templ = gst_static_pad_template_get (&src_template);
+    self->srcpad = gst_ghost_pad_new_no_target_from_template ("src", templ);
+    gst_element_add_pad (GST_ELEMENT (self), self->srcpad);
+    gst_object_unref (templ);
+    return;
+  }
+
+  /* Setup sinkpad */
+  g_object_set (self->detect, "message", TRUE,
+      "pattern-data-count", GST_VIDEOLATENCY_MARK_BITS, NULL);
+  g_object_set (self->fakesink, "sync", FALSE, "async", FALSE, NULL);
+  gst_bin_add_many (GST_BIN (self), self->detect, self->fakesink, NULL);
+  gst_element_link (self->detect, self->fakesink);
+
+  templ = gst_static_pad_template_get (&sink_template);
+  pad = gst_element_get_static_pad (self->detect, "sink");
+  self->sinkpad = gst_ghost_pad_new_from_template ("sink", pad, templ);
+  gst_element_add_pad (GST_ELEMENT (self), self->sinkpad);
+  gst_object_unref (pad);
+  gst_object_unref (templ);
+
+  /* Setup srcpad, with black frames that can't be mistaken for a mark */
+  g_object_set (self->videosrc, "is-live", TRUE, "pattern", 2, NULL);
+  g_object_set (self->mark, "enabled", FALSE,
+      "pattern-data-count", GST_VIDEOLATENCY_MARK_BITS, NULL);
+  gst_bin_add_many (GST_BIN (self), self->videosrc, self->mark, NULL);
+  gst_element_link (self->videosrc, self->mark);
+
+  pad = gst_element_get_static_pad (self->videosrc, "src");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+      (GstPadProbeCallback) gst_videolatency_mark_probe, self, NULL);
+  gst_object_unref (pad);
+
+  templ = gst_static_pad_template_get (&src_template);
+  pad = gst_element_get_static_pad (self->mark, "src");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+      (GstPadProbeCallback) gst_videolatency_src_probe, self, NULL);
+
+  self->srcpad = gst_ghost_pad_new_from_template ("src", pad, templ);
+  gst_element_add_pad (GST_ELEMENT (self), self->srcpad);
+  gst_object_unref (pad);
+  gst_object_unref (templ);
+
+  GST_LOG_OBJECT (self, "Initialized videolatency");
+}
+
+static void
+gst_videolatency_reset (GstVideoLatency * self)
+{
+  GST_OBJECT_LOCK (self);
+  self->n_frames = 0;
+  self->pending_mark = -1;
+  self->next_mark = 0;
+  memset (self->send_pts, 0, sizeof (self->send_pts));
+  gst_latency_stats_reset (&self->stats);
+  GST_OBJECT_UNLOCK (self);
+}
+
+static GstStateChangeReturn
+gst_videolatency_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstVideoLatency *self = GST_VIDEOLATENCY (element);
+
+  switch (transition) {
+    case GST_STATE_CHANGE_NULL_TO_READY:
+      if (!self->detect) {
+        GST_ELEMENT_ERROR (self, CORE, MISSING_PLUGIN, (NULL),
+            ("Missing videotestsrc, simplevideomark, simplevideomarkdetect "
+                "or fakesink"));
+        return GST_STATE_CHANGE_FAILURE;
+      }
+      break;
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      gst_videolatency_reset (self);
+      break;
+    default:
+      break;
+  }
+
+  return GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+}
+
+static void
+gst_videolatency_set_latency (GstVideoLatency * self, gint64 latency)
+{
+  GstStructure *summary = NULL;
+  gint64 avg_latency;
+
+  GST_OBJECT_LOCK (self);
+  gst_latency_stats_add (&self->stats, latency);
+  avg_latency = gst_latency_stats_get_average (&self->stats);
+
+  if (self->print_latency)
+    g_print ("last latency: %" G_GINT64_FORMAT "ms, running average: %"
+        G_GINT64_FORMAT "ms\n", latency / 1000, avg_latency / 1000);
+
+  if (self->summary_interval > 0 &&
+      gst_latency_stats_get_n_window (&self->stats) >= self->summary_interval)
+    summary = gst_latency_stats_take_summary (&self->stats,
+        self->histogram_bucket_width);
+  else if (self->summary_interval == 0)
+    gst_latency_stats_reset_window (&self->stats);
+
+  if (summary && self->print_latency) {
+    gint64 p50 = 0, p99 = 0, jitter = 0;
+
+    gst_structure_get_int64 (summary, "p50-latency", &p50);
+    gst_structure_get_int64 (summary, "p99-latency", &p99);
+    gst_structure_get_int64 (summary, "jitter", &jitter);
+    g_print ("summary of %u measurements: p50: %" G_GINT64_FORMAT "us, p99: %"
+        G_GINT64_FORMAT "us, jitter: %" G_GINT64_FORMAT "us\n",
+        self->summary_interval, p50, p99, jitter);
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  /* Post an element message about it */
+  gst_element_post_message (GST_ELEMENT (self),
+      gst_message_new_element (GST_OBJECT (self),
+          gst_structure_new ("latency", "last-latency", G_TYPE_INT64, latency,
+              "average-latency", G_TYPE_INT64, avg_latency, NULL)));
+
+  if (summary)
+    gst_element_post_message (GST_ELEMENT (self),
+        gst_message_new_element (GST_OBJECT (self), summary));
+}
+
+/* Decides whether the next frame of videotestsrc gets marked */
+static GstPadProbeReturn
+gst_videolatency_mark_probe (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstVideoLatency *self = user_data;
+  gboolean enabled = FALSE;
+  guint mark = 0;
+
+  if (!(info->type & GST_PAD_PROBE_TYPE_BUFFER))
+    goto out;
+
+  GST_OBJECT_LOCK (self);
+  self->pending_mark = -1;
+  if (GST_STATE (self) == GST_STATE_PLAYING &&
+      self->n_frames++ % self->mark_interval == 0) {
+    mark = self->next_mark;
+    self->next_mark = (mark + 1) % GST_VIDEOLATENCY_NUM_MARKS;
+    self->pending_mark = mark;
+    enabled = TRUE;
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  /* simplevideomark reads these from this same streaming thread when it
+   * processes the buffer */
+  g_object_set (self->mark, "enabled", enabled, "pattern-data",
+      (guint64) mark, NULL);
+
+out:
+  return GST_PAD_PROBE_OK;
+}
+
+/* Records when a marked frame leaves the element */
+static GstPadProbeReturn
+gst_videolatency_src_probe (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstVideoLatency *self = user_data;
+
+  if (!(info->type & GST_PAD_PROBE_TYPE_BUFFER))
+    goto out;
+
+  GST_OBJECT_LOCK (self);
+  if (self->pending_mark >= 0) {
+    self->send_pts[self->pending_mark] = g_get_monotonic_time ();
+    GST_TRACE_OBJECT (self, "sent mark %d", self->pending_mark);
+    self->pending_mark = -1;
+  }
+  GST_OBJECT_UNLOCK (self);
+
+out:
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+gst_videolatency_handle_message (GstBin * bin, GstMessage * message)
+{
+  GstVideoLatency *self = GST_VIDEOLATENCY (bin);
+  const GstStructure *s;
+  gboolean have_pattern = FALSE;
+  guint64 data = 0;
+  gint64 send_pts, recv_pts;
+
+  if (GST_MESSAGE_TYPE (message) != GST_MESSAGE_ELEMENT ||
+      GST_MESSAGE_SRC (message) != GST_OBJECT_CAST (self->detect) ||
+      !gst_message_has_name (message, "GstSimpleVideoMarkDetect")) {
+    GST_BIN_CLASS (parent_class)->handle_message (bin, message);
+    return;
+  }
+
+  /* Posted synchronously from the sink streaming thread, right after the
+   * frame was analyzed */
+  recv_pts = g_get_monotonic_time ();
+
+  s = gst_message_get_structure (message);
+  gst_structure_get_boolean (s, "have-pattern", &have_pattern);
+  gst_structure_get_uint64 (s, "data", &data);
+  gst_message_unref (message);
+
+  if (!have_pattern)
+    return;
+
+  /* Each mark is only measured once, even if it is found in several
+   * consecutive frames */
+  GST_OBJECT_LOCK (self);
+  data %= GST_VIDEOLATENCY_NUM_MARKS;
+  send_pts = self->send_pts[data];
+  self->send_pts[data] = 0;
+  GST_OBJECT_UNLOCK (self);
+
+  if (send_pts == 0 || recv_pts < send_pts)
+    return;
+
+  GST_INFO_OBJECT (self, "recv mark %" G_GUINT64_FORMAT ", latency: %"
+      G_GINT64_FORMAT "ms", data, (recv_pts - send_pts) / 1000);
+
+  gst_videolatency_set_latency (self, recv_pts - send_pts);
+}
@@ -0,0 +1,81 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_VIDEOLATENCY_H__
+#define __GST_VIDEOLATENCY_H__
+
+#include <gst/gst.h>
+
+#include "gstlatencystats.h"
+
+G_BEGIN_DECLS
+#define GST_TYPE_VIDEOLATENCY \
+  (gst_videolatency_get_type ())
+#define GST_VIDEOLATENCY(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_VIDEOLATENCY, GstVideoLatency))
+#define GST_VIDEOLATENCY_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST ((klass), GST_TYPE_VIDEOLATENCY, GstVideoLatencyClass))
+#define GST_IS_VIDEOLATENCY(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_VIDEOLATENCY))
+#define GST_IS_VIDEOLATENCY_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE ((klass), GST_TYPE_VIDEOLATENCY))
+typedef struct _GstVideoLatency GstVideoLatency;
+typedef struct _GstVideoLatencyClass GstVideoLatencyClass;
+
+/* number of data bits carried by each mark */
+#define GST_VIDEOLATENCY_MARK_BITS 10
+#define GST_VIDEOLATENCY_NUM_MARKS (1 << GST_VIDEOLATENCY_MARK_BITS)
+
+struct _GstVideoLatency
+{
+  GstBin parent;
+
+  GstPad *sinkpad;
+  GstPad *srcpad;
+  /* videotestsrc ! simplevideomark */
+  GstElement *videosrc;
+  GstElement *mark;
+  /* simplevideomarkdetect ! fakesink */
+  GstElement *detect;
+  GstElement *fakesink;
+
+  /* measurements */
+  guint64 n_frames;
+  gint pending_mark;
+  guint next_mark;
+  gint64 send_pts[GST_VIDEOLATENCY_NUM_MARKS];
+  GstLatencyStats stats;
+
+  /* properties */
+  gboolean print_latency;
+  guint mark_interval;
+  gint pattern_width;
+  gint pattern_height;
+  guint summary_interval;
+  gint64 histogram_bucket_width;
+};
+
+struct _GstVideoLatencyClass
+{
+  GstBinClass parent_class;
+};
+
+GType gst_videolatency_get_type (void);
+
+G_END_DECLS
+#endif /* __GST_VIDEOLATENCY_H__ */
@@ -151,6 +151,258 @@ static GstStateChangeReturn gst_audio_mix_matrix_change_state (GstElement *
 G_DEFINE_TYPE (GstAudioMixMatrix, gst_audio_mix_matrix,
     GST_TYPE_BASE_TRANSFORM);
 
+/* a matrix with at most this fraction of non-zero coefficients is applied
+ * by only going through its non-zero coefficients */
+#define SPARSE_DENSITY_THRESHOLD 0.25
+
+typedef void (*GstAudioMixMatrixProcessFunc) (const GstAudioMixMatrixConv *
+    conv, gconstpointer in, gpointer out, guint n_samples);
+
+struct _GstAudioMixMatrixConv
+{
+  GstAudioFormat format;
+  guint in_channels;
+  guint out_channels;
+  /* fixed point shift of the integer coefficients */
+  gint shift;
+
+  /* dense: coefficients of each input channel for all output channels, so
+   * that the innermost loop goes over contiguous outputs and accumulators.
+   * Input channels not used by any output are skipped. */
+  gpointer dense;
+  gboolean *in_used;
+
+  /* sparse: the non-zero coefficients of output channel o and their input
+   * channels are at sparse_offset[o] to sparse_offset[o + 1] */
+  guint *sparse_offset;
+  guint *sparse_in;
+  gpointer sparse;
+
+  /* one accumulator per output channel */
+  gpointer acc;
+
+  GstAudioMixMatrixProcessFunc process;
+};
+
+#define STORE_FLOAT(v, shift) (v)
+#define STORE_INT(type, v, shift) ((type) ((v) >> (shift)))
+#define STORE_S16(v, shift) STORE_INT (gint16, v, shift)
+#define STORE_S32(v, shift) STORE_INT (gint32, v, shift)
+
+#define DEFINE_PROCESS_FUNCS(name, type, ctype, acctype, store)               \
+static void                                                                   \
+process_dense_##name (const GstAudioMixMatrixConv * conv, gconstpointer src,  \
+    gpointer dest, guint n_samples)                                           \
+{                                                                             \
+  const type *in = src;                                                       \
+  type *out = dest;                                                           \
+  const ctype *coeffs = conv->dense;                                          \
+  acctype *acc = conv->acc;                                                   \
+  guint in_channels = conv->in_channels;                                      \
+  guint out_channels = conv->out_channels;                                    \
+  guint sample, i, o;                                                         \
+                                                                              \
+  for (sample = 0; sample < n_samples; sample++) {                            \
+    for (o = 0; o < out_channels; o++)                                        \
+      acc[o] = 0;                                                             \
+    for (i = 0; i < in_channels; i++) {                                       \
+      const ctype *col = coeffs + i * out_channels;                           \
+      acctype v = in[i];                                                      \
+                                                                              \
+      if (!conv->in_used[i])                                                  \
+        continue;                                                             \
+      for (o = 0; o < out_channels; o++)                                      \
+        acc[o] += v * col[o];                                                 \
+    }                                                                         \
+    for (o = 0; o < out_channels; o++)                                        \
+      out[o] = store (acc[o], conv->shift);                                   \
+    in += in_channels;                                                        \
+    out += out_channels;                                                      \
+  }                                                                           \
+}                                                                             \
+                                                                              \
+static void                                                                   \
+process_sparse_##name (const GstAudioMixMatrixConv * conv, gconstpointer src, \
+    gpointer dest, guint n_samples)                                           \
+{                                                                             \
+  const type *in = src;                                                       \
+  type *out = dest;                                                           \
+  const ctype *coeffs = conv->sparse;                                         \
+  const guint *offset = conv->sparse_offset;                                  \
+  const guint *in_index = conv->sparse_in;                                    \
+  guint in_channels = conv->in_channels;                                      \
+  guint out_channels = conv->out_channels;                                    \
+  guint sample, k, o;                                                         \
+                                                                              \
+  for (sample = 0; sample < n_samples; sample++) {                            \
+    for (o = 0; o < out_channels; o++) {                                      \
+      acctype acc = 0;                                                        \
+                                                                              \
+      for (k = offset[o]; k < offset[o + 1]; k++)                             \
+        acc += (acctype) in[in_index[k]] * coeffs[k];                         \
+      out[o] = store (acc, conv->shift);                                      \
+    }                                                                         \
+    in += in_channels;                                                        \
+    out += out_channels;                                                      \
+  }                                                                           \
+}
+
+DEFINE_PROCESS_FUNCS (f32, gfloat, gfloat, gfloat, STORE_FLOAT)
+DEFINE_PROCESS_FUNCS (f64, gdouble, gdouble, gdouble, STORE_FLOAT)
+DEFINE_PROCESS_FUNCS (s16, gint16, gint32, gint32, STORE_S16)
+DEFINE_PROCESS_FUNCS (s32, gint32, gint64, gint64, STORE_S32)
+
+static void
+gst_audio_mix_matrix_conv_free (GstAudioMixMatrixConv * conv)
+{
+  g_free (conv->dense);
+  g_free (conv->in_used);
+  g_free (conv->sparse_offset);
+  g_free (conv->sparse_in);
+  g_free (conv->sparse);
+  g_free (conv->acc);
+  g_free (conv);
+}
+
+static void
+gst_audio_mix_matrix_conv_set_coeff (GstAudioMixMatrixConv * conv,
+    gpointer coeffs, guint index, gdouble value)
+{
+  switch (conv->format) {
+    case GST_AUDIO_FORMAT_F32LE:
+    case GST_AUDIO_FORMAT_F32BE:
+      ((gfloat *) coeffs)[index] = value;
+      break;
+    case GST_AUDIO_FORMAT_F64LE:
+    case GST_AUDIO_FORMAT_F64BE:
+      ((gdouble *) coeffs)[index] = value;
+      break;
+    case GST_AUDIO_FORMAT_S16LE:
+    case GST_AUDIO_FORMAT_S16BE:
+      ((gint32 *) coeffs)[index] = (gint32) (value * (1 << conv->shift));
+      break;
+    case GST_AUDIO_FORMAT_S32LE:
+    case GST_AUDIO_FORMAT_S32BE:
+      ((gint64 *) coeffs)[index] =
+          (gint64) (value * ((gint64) 1 << conv->shift));
+      break;
+    default:
+      g_assert_not_reached ();
+  }
+}
+
+/* Converts @matrix to the coefficients applied to @format samples, and
+ * picks the dense or the sparse kernel depending on how many of them are
+ * zero */
+static GstAudioMixMatrixConv *
+gst_audio_mix_matrix_conv_new (const gdouble * matrix, guint in_channels,
+    guint out_channels, GstAudioFormat format)
+{
+  GstAudioMixMatrixConv *conv;
+  gsize coeff_size;
+  guint in, out, n_taps = 0, k;
+
+  conv = g_new0 (GstAudioMixMatrixConv, 1);
+  conv->format = format;
+  conv->in_channels = in_channels;
+  conv->out_channels = out_channels;
+
+  switch (format) {
+    case GST_AUDIO_FORMAT_F32LE:
+    case GST_AUDIO_FORMAT_F32BE:
+      coeff_size = sizeof (gfloat);
+      break;
+    case GST_AUDIO_FORMAT_F64LE:
+    case GST_AUDIO_FORMAT_F64BE:
+      coeff_size = sizeof (gdouble);
+      break;
+    case GST_AUDIO_FORMAT_S16LE:
+    case GST_AUDIO_FORMAT_S16BE:
+      coeff_size = sizeof (gint32);
+      /* converted bits - input bits - sign - bits needed for channel */
+      conv->shift = 32 - 16 - 1 - ceil (log (in_channels) / log (2));
+      break;
+    case GST_AUDIO_FORMAT_S32LE:
+    case GST_AUDIO_FORMAT_S32BE:
+      coeff_size = sizeof (gint64);
+      /* converted bits - input bits - sign - bits needed for channel */
+      conv->shift = 64 - 32 - 1 - (gint) (log (in_channels) / log (2));
+      break;
+    default:
+      g_free (conv);
+      return NULL;
+  }
+
+  for (k = 0; k < in_channels * out_channels; k++) {
+    if (matrix[k] != 0)
+      n_taps++;
+  }
+
+  /* the accumulators have the size of the coefficients */
+  conv->acc = g_malloc0 (coeff_size * out_channels);
+
+  if (n_taps <= SPARSE_DENSITY_THRESHOLD * in_channels * out_channels) {
+    conv->sparse_offset = g_new (guint, out_channels + 1);
+    conv->sparse_in = g_new (guint, MAX (n_taps, 1));
+    conv->sparse = g_malloc (coeff_size * MAX (n_taps, 1));
+
+    k = 0;
+    for (out = 0; out < out_channels; out++) {
+      conv->sparse_offset[out] = k;
+      for (in = 0; in < in_channels; in++) {
+        gdouble value = matrix[out * in_channels + in];
+
+        if (value == 0)
+          continue;
+        conv->sparse_in[k] = in;
+        gst_audio_mix_matrix_conv_set_coeff (conv, conv->sparse, k, value);
+        k++;
+      }
+    }
+    conv->sparse_offset[out_channels] = k;
+  } else {
+    conv->dense = g_malloc0 (coeff_size * in_channels * out_channels);
+    conv->in_used = g_new0 (gboolean, in_channels);
+
+    for (in = 0; in < in_channels; in++) {
+      for (out = 0; out < out_channels; out++) {
+        gdouble value = matrix[out * in_channels + in];
+
+        gst_audio_mix_matrix_conv_set_coeff (conv, conv->dense,
+            in * out_channels + out, value);
+        if (value != 0)
+          conv->in_used[in] = TRUE;
+      }
+    }
+  }
+
+  switch (format) {
+    case GST_AUDIO_FORMAT_F32LE:
+    case GST_AUDIO_FORMAT_F32BE:
+      conv->process = conv->dense ? process_dense_f32 : process_sparse_f32;
+      break;
+    case GST_AUDIO_FORMAT_F64LE:
+    case GST_AUDIO_FORMAT_F64BE:
+      conv->process = conv->dense ? process_dense_f64 : process_sparse_f64;
+      break;
+    case GST_AUDIO_FORMAT_S16LE:
+    case GST_AUDIO_FORMAT_S16BE:
+      conv->process = conv->dense ? process_dense_s16 : process_sparse_s16;
+      break;
+    case GST_AUDIO_FORMAT_S32LE:
+    case GST_AUDIO_FORMAT_S32BE:
+      conv->process = conv->dense ? process_dense_s32 : process_sparse_s32;
+      break;
+    default:
+      g_assert_not_reached ();
+  }
+
+  GST_DEBUG ("%u non-zero coefficients out of %u, using %s kernel", n_taps,
+      in_channels * out_channels, conv->dense ? "dense" : "sparse");
+
+  return conv;
+}
+
 static void
 gst_audio_mix_matrix_class_init (GstAudioMixMatrixClass * klass)
 {
@@ -227,8 +479,8 @@ gst_audio_mix_matrix_init (GstAudioMixMatrix * self)
   self->out_channels = 0;
   self->matrix = NULL;
   self->channel_mask = 0;
-  self->s16_conv_matrix = NULL;
-  self->s32_conv_matrix = NULL;
+  self->conv = NULL;
+  self->matrix_changed = FALSE;
   self->mode = GST_AUDIO_MIX_MATRIX_MODE_MANUAL;
 }
 
@@ -242,43 +494,12 @@ gst_audio_mix_matrix_dispose (GObject * object)
     self->matrix = NULL;
   }
 
-  G_OBJECT_CLASS (gst_audio_mix_matrix_parent_class)->dispose (object);
-}
-
-static void
-gst_audio_mix_matrix_convert_s16_matrix (GstAudioMixMatrix * self)
-{
-  gint i;
-
-  /* converted bits - input bits - sign - bits needed for channel */
-  self->shift_bytes = 32 - 16 - 1 - ceil (log (self->in_channels) / log (2));
-
-  if (self->s16_conv_matrix)
-    g_free (self->s16_conv_matrix);
-  self->s16_conv_matrix =
-      g_new (gint32, self->in_channels * self->out_channels);
-  for (i = 0; i < self->in_channels * self->out_channels; i++) {
-    self->s16_conv_matrix[i] =
-        (gint32) ((self->matrix[i]) * (1 << self->shift_bytes));
+  if (self->conv) {
+    gst_audio_mix_matrix_conv_free (self->conv);
+    self->conv = NULL;
   }
-}
 
-static void
-gst_audio_mix_matrix_convert_s32_matrix (GstAudioMixMatrix * self)
-{
-  gint i;
-
-  /* converted bits - input bits - sign - bits needed for channel */
-  self->shift_bytes = 64 - 32 - 1 - (gint) (log (self->in_channels) / log (2));
-
-  if (self->s32_conv_matrix)
-    g_free (self->s32_conv_matrix);
-  self->s32_conv_matrix =
-      g_new (gint64, self->in_channels * self->out_channels);
-  for (i = 0; i < self->in_channels * self->out_channels; i++) {
-    self->s32_conv_matrix[i] =
-        (gint64) ((self->matrix[i]) * (1 << self->shift_bytes));
-  }
+  G_OBJECT_CLASS (gst_audio_mix_matrix_parent_class)->dispose (object);
 }
 
 
@@ -290,42 +511,56 @@ gst_audio_mix_matrix_set_property (GObject * object, guint prop_id,
 
   switch (prop_id) {
     case PROP_IN_CHANNELS:
+      GST_OBJECT_LOCK (self);
       self->in_channels = g_value_get_uint (value);
-      if (self->matrix) {
-        gst_audio_mix_matrix_convert_s16_matrix (self);
-        gst_audio_mix_matrix_convert_s32_matrix (self);
-      }
+      self->matrix_changed = TRUE;
+      GST_OBJECT_UNLOCK (self);
+      gst_base_transform_reconfigure_src (GST_BASE_TRANSFORM (self));
       break;
     case PROP_OUT_CHANNELS:
+      GST_OBJECT_LOCK (self);
       self->out_channels = g_value_get_uint (value);
-      if (self->matrix) {
-        gst_audio_mix_matrix_convert_s16_matrix (self);
-        gst_audio_mix_matrix_convert_s32_matrix (self);
-      }
+      self->matrix_changed = TRUE;
+      GST_OBJECT_UNLOCK (self);
+      gst_base_transform_reconfigure_src (GST_BASE_TRANSFORM (self));
       break;
     case PROP_MATRIX:{
       gint in, out;
+      gdouble *matrix;
 
-      if (self->matrix)
-        g_free (self->matrix);
-      self->matrix = g_new (gdouble, self->in_channels * self->out_channels);
+      matrix = g_new (gdouble, self->in_channels * self->out_channels);
 
-      g_return_if_fail (gst_value_array_get_size (value) == self->out_channels);
+      if (gst_value_array_get_size (value) != self->out_channels)
+        goto wrong_matrix;
       for (out = 0; out < self->out_channels; out++) {
         const GValue *row = gst_value_array_get_value (value, out);
-        g_return_if_fail (gst_value_array_get_size (row) == self->in_channels);
+        if (gst_value_array_get_size (row) != self->in_channels)
+          goto wrong_matrix;
         for (in = 0; in < self->in_channels; in++) {
           const GValue *itm;
           gdouble coefficient;
 
           itm = gst_value_array_get_value (row, in);
-          g_return_if_fail (G_VALUE_HOLDS_DOUBLE (itm));
+          if (!G_VALUE_HOLDS_DOUBLE (itm))
+            goto wrong_matrix;
           coefficient = g_value_get_double (itm);
-          self->matrix[out * self->in_channels + in] = coefficient;
+          matrix[out * self->in_channels + in] = coefficient;
         }
       }
-      gst_audio_mix_matrix_convert_s16_matrix (self);
-      gst_audio_mix_matrix_convert_s32_matrix (self);
+
+      /* picked up by the streaming thread with the next buffer, a new
+       * matrix of the same size doesn't need a renegotiation */
+      GST_OBJECT_LOCK (self);
+      g_free (self->matrix);
+      self->matrix = matrix;
+      self->matrix_changed = TRUE;
+      GST_OBJECT_UNLOCK (self);
+      break;
+
+    wrong_matrix:
+      g_critical ("matrix does not have %u rows of %u coefficients",
+          self->out_channels, self->in_channels);
+      g_free (matrix);
       break;
     }
     case PROP_CHANNEL_MASK:
@@ -397,14 +632,9 @@ gst_audio_mix_matrix_change_state (GstElement * element,
       (element, transition);
 
   if (transition == GST_STATE_CHANGE_PAUSED_TO_READY) {
-    if (self->s16_conv_matrix) {
-      g_free (self->s16_conv_matrix);
-      self->s16_conv_matrix = NULL;
-    }
-
-    if (self->s32_conv_matrix) {
-      g_free (self->s32_conv_matrix);
-      self->s32_conv_matrix = NULL;
+    if (self->conv) {
+      gst_audio_mix_matrix_conv_free (self->conv);
+      self->conv = NULL;
     }
   }
 
@@ -418,10 +648,28 @@ gst_audio_mix_matrix_transform (GstBaseTransform * vfilter,
 {
   GstMapInfo inmap, outmap;
   GstAudioMixMatrix *self = GST_AUDIO_MIX_MATRIX (vfilter);
-  gint in, out, sample;
-  guint inchannels = self->in_channels;
-  guint outchannels = self->out_channels;
-  gdouble *matrix = self->matrix;
+  GstAudioMixMatrixConv *conv;
+  guint n_samples;
+
+  GST_OBJECT_LOCK (self);
+  if (self->matrix_changed && self->conv) {
+    if (self->matrix && self->in_channels == self->conv->in_channels &&
+        self->out_channels == self->conv->out_channels) {
+      GST_DEBUG_OBJECT (self, "applying new matrix");
+      conv = gst_audio_mix_matrix_conv_new (self->matrix, self->in_channels,
+          self->out_channels, self->format);
+      gst_audio_mix_matrix_conv_free (self->conv);
+      self->conv = conv;
+    } else {
+      GST_DEBUG_OBJECT (self, "channels changed, waiting for new caps");
+    }
+    self->matrix_changed = FALSE;
+  }
+  conv = self->conv;
+  GST_OBJECT_UNLOCK (self);
+
+  if (!conv)
+    return GST_FLOW_NOT_NEGOTIATED;
 
   if (!gst_buffer_map (inbuf, &inmap, GST_MAP_READ)) {
     return GST_FLOW_ERROR;
@@ -431,103 +679,9 @@ gst_audio_mix_matrix_transform (GstBaseTransform * vfilter,
     return GST_FLOW_ERROR;
   }
 
-  switch (self->format) {
-    case GST_AUDIO_FORMAT_F32LE:
-    case GST_AUDIO_FORMAT_F32BE:{
-      const gfloat *inarray;
-      gfloat *outarray;
-      guint n_samples = outmap.size / (sizeof (gfloat) * outchannels);
-
-      inarray = (gfloat *) inmap.data;
-      outarray = (gfloat *) outmap.data;
-
-      for (sample = 0; sample < n_samples; sample++) {
-        for (out = 0; out < outchannels; out++) {
-          gfloat outval = 0;
-          for (in = 0; in < inchannels; in++) {
-            outval +=
-                inarray[sample * inchannels +
-                in] * matrix[out * inchannels + in];
-          }
-          outarray[sample * outchannels + out] = outval;
-        }
-      }
-      break;
-    }
-    case GST_AUDIO_FORMAT_F64LE:
-    case GST_AUDIO_FORMAT_F64BE:{
-      const gdouble *inarray;
-      gdouble *outarray;
-      guint n_samples = outmap.size / (sizeof (gdouble) * outchannels);
-
-      inarray = (gdouble *) inmap.data;
-      outarray = (gdouble *) outmap.data;
-
-      for (sample = 0; sample < n_samples; sample++) {
-        for (out = 0; out < outchannels; out++) {
-          gdouble outval = 0;
-          for (in = 0; in < inchannels; in++) {
-            outval +=
-                inarray[sample * inchannels +
-                in] * matrix[out * inchannels + in];
-          }
-          outarray[sample * outchannels + out] = outval;
-        }
-      }
-      break;
-    }
-    case GST_AUDIO_FORMAT_S16LE:
-    case GST_AUDIO_FORMAT_S16BE:{
-      const gint16 *inarray;
-      gint16 *outarray;
-      guint n_samples = outmap.size / (sizeof (gint16) * outchannels);
-      guint n = self->shift_bytes;
-      gint32 *conv_matrix = self->s16_conv_matrix;
-
-      inarray = (gint16 *) inmap.data;
-      outarray = (gint16 *) outmap.data;
-
-      for (sample = 0; sample < n_samples; sample++) {
-        for (out = 0; out < outchannels; out++) {
-          gint32 outval = 0;
-          for (in = 0; in < inchannels; in++) {
-            outval += (gint32) (inarray[sample * inchannels + in] *
-                conv_matrix[out * inchannels + in]);
-          }
-          outarray[sample * outchannels + out] = (gint16) (outval >> n);
-        }
-      }
-      break;
-    }
-    case GST_AUDIO_FORMAT_S32LE:
-    case GST_AUDIO_FORMAT_S32BE:{
-      const gint32 *inarray;
-      gint32 *outarray;
-      guint n_samples = outmap.size / (sizeof (gint32) * outchannels);
-      guint n = self->shift_bytes;
-      gint64 *conv_matrix = self->s32_conv_matrix;
-
-      inarray = (gint32 *) inmap.data;
-      outarray = (gint32 *) outmap.data;
-
-      for (sample = 0; sample < n_samples; sample++) {
-        for (out = 0; out < outchannels; out++) {
-          gint64 outval = 0;
-          for (in = 0; in < inchannels; in++) {
-            outval += (gint64) (inarray[sample * inchannels + in] *
-                conv_matrix[out * inchannels + in]);
-          }
-          outarray[sample * outchannels + out] = (gint32) (outval >> n);
-        }
-      }
-      break;
-    }
-    default:
-      gst_buffer_unmap (inbuf, &inmap);
-      gst_buffer_unmap (outbuf, &outmap);
-      return GST_FLOW_NOT_SUPPORTED;
-
-  }
+  n_samples = outmap.size / (GST_AUDIO_FORMAT_INFO_WIDTH
+      (gst_audio_format_get_info (conv->format)) / 8 * conv->out_channels);
+  conv->process (conv, inmap.data, outmap.data, n_samples);
 
   gst_buffer_unmap (inbuf, &inmap);
   gst_buffer_unmap (outbuf, &outmap);
@@ -561,6 +715,7 @@ gst_audio_mix_matrix_set_caps (GstBaseTransform * trans, GstCaps * incaps,
   if (!gst_audio_info_from_caps (&out_info, outcaps))
     return FALSE;
 
+  GST_OBJECT_LOCK (self);
   self->format = info.finfo->format;
 
   if (self->mode == GST_AUDIO_MIX_MATRIX_MODE_FIRST_CHANNELS) {
@@ -569,6 +724,7 @@ gst_audio_mix_matrix_set_caps (GstBaseTransform * trans, GstCaps * incaps,
     self->in_channels = info.channels;
     self->out_channels = out_info.channels;
 
+    g_free (self->matrix);
     self->matrix = g_new (gdouble, self->in_channels * self->out_channels);
 
     for (out = 0; out < self->out_channels; out++) {
@@ -578,27 +734,21 @@ gst_audio_mix_matrix_set_caps (GstBaseTransform * trans, GstCaps * incaps,
     }
   } else if (!self->matrix || info.channels != self->in_channels ||
       out_info.channels != self->out_channels) {
+    GST_OBJECT_UNLOCK (self);
     GST_ELEMENT_ERROR (self, LIBRARY, SETTINGS,
         ("Erroneous matrix detected"),
         ("Please enter a matrix with the correct input and output channels"));
     return FALSE;
   }
 
-  switch (self->format) {
-    case GST_AUDIO_FORMAT_S16LE:
-    case GST_AUDIO_FORMAT_S16BE:{
-      gst_audio_mix_matrix_convert_s16_matrix (self);
-      break;
-    }
-    case GST_AUDIO_FORMAT_S32LE:
-    case GST_AUDIO_FORMAT_S32BE:{
-      gst_audio_mix_matrix_convert_s32_matrix (self);
-      break;
-    }
-    default:
-      break;
-  }
-  return TRUE;
+  if (self->conv)
+    gst_audio_mix_matrix_conv_free (self->conv);
+  self->conv = gst_audio_mix_matrix_conv_new (self->matrix, self->in_channels,
+      self->out_channels, self->format);
+  self->matrix_changed = FALSE;
+  GST_OBJECT_UNLOCK (self);
+
+  return self->conv != NULL;
 }
 
 static GstCaps *
@@ -36,6 +36,7 @@
 
 typedef struct _GstAudioMixMatrix GstAudioMixMatrix;
 typedef struct _GstAudioMixMatrixClass GstAudioMixMatrixClass;
+typedef struct _GstAudioMixMatrixConv GstAudioMixMatrixConv;
 
 typedef enum _GstAudioMixMatrixMode
 {
@@ -58,9 +59,11 @@ struct _GstAudioMixMatrix
   gdouble *matrix;
   guint64 channel_mask;
   GstAudioMixMatrixMode mode;
-  gint32 *s16_conv_matrix;
-  gint64 *s32_conv_matrix;
-  gint shift_bytes;
+
+  /* matrix converted for the negotiated format, only used by the streaming
+   * thread, and whether it has to be converted again */
+  GstAudioMixMatrixConv *conv;
+  gboolean matrix_changed;
 
   GstAudioFormat format;
 };
@@ -20,7 +20,36 @@
  */
  
 /* FIXME: add versions that don't ignore alpha */
- 
+
+/* adds the four bytes of _c to the ones of _p, saturating at 255, without
+ * splitting the pixel into its components: the low seven bits of each byte
+ * are added in parallel and the carries out of the top bit are turned into
+ * an all-ones mask for the bytes that overflowed */
+static inline guint32
+add_pixel_sat (guint32 _p, guint32 _c)
+{
+  guint32 _s, _o;
+
+  _s = ((_p & 0x7f7f7f7f) + (_c & 0x7f7f7f7f)) ^ ((_p ^ _c) & 0x80808080);
+  _o = ((_p & _c) | ((_p | _c) & ~_s)) & 0x80808080;
+
+  return _s | ((_o >> 7) * 0xff);
+}
+
+static inline void
+add_pixel (guint32 * _p, guint32 _c)
+{
+  *_p = add_pixel_sat (*_p, _c);
+}
+
+/* scales the color components of _c by _f/256, _f being between 0 and 256 */
+static inline guint32
+scale_pixel (guint32 _c, guint _f)
+{
+  return ((((_c & 0x00ff00ff) * _f) >> 8) & 0x00ff00ff) |
+      ((((_c & 0x0000ff00) * _f) >> 8) & 0x0000ff00);
+}
+
 #define draw_dot(_vd, _x, _y, _st, _c) G_STMT_START {                          \
   _vd[(_y * _st) + _x] = _c;                                                   \
 } G_STMT_END
@@ -29,59 +58,60 @@
   _vd[(_y * _st) + _x] |= _c;                                                  \
 } G_STMT_END
 
+/* _f is the coverage of the pixel in 1/256 units */
 #define draw_dot_aa(_vd, _x, _y, _st, _c, _f)  G_STMT_START {                  \
-  guint32 _oc, _c1, _c2, _c3;                                                  \
+  guint32 *_op = &_vd[(_y * _st) + _x];                                        \
                                                                                \
-  _oc = _vd[(_y * _st) + _x];                                                  \
-  _c3 = (_oc & 0xff) + ((_c & 0xff) * _f);                                     \
-  _c3 = MIN(_c3, 255);                                                         \
-  _c2 = ((_oc & 0xff00) >> 8) + (((_c & 0xff00) >> 8) * _f);                   \
-  _c2 = MIN(_c2, 255);                                                         \
-  _c1 = ((_oc & 0xff0000) >> 16) + (((_c & 0xff0000) >> 16) * _f);             \
-  _c1 = MIN(_c1, 255);                                                         \
-  _vd[(_y * _st) + _x] = (_c1 << 16) | (_c2 << 8) | _c3;                       \
+  *_op = add_pixel_sat (*_op, scale_pixel (_c, _f)) & 0x00ffffff;              \
 } G_STMT_END
 
+/* the lines are walked along their major axis with the position of the
+ * minor axis kept in 16.16 fixed point */
 #define draw_line(_vd, _x1, _x2, _y1, _y2, _st, _c) G_STMT_START {             \
-  guint _i, _j, _x, _y;                                                        \
-  gint _dx = _x2 - _x1, _dy = _y2 - _y1;                                       \
-  gfloat _f;                                                                   \
+  gint _i, _j, _rx, _ry, _sx, _sy;                                             \
+  gint _dx = (gint) (_x2) - (gint) (_x1), _dy = (gint) (_y2) - (gint) (_y1);   \
+  guint _x, _y;                                                                \
                                                                                \
-  _j = abs (_dx) > abs (_dy) ? abs (_dx) : abs (_dy);                          \
-  for (_i = 0; _i < _j; _i++) {                                                \
-    _f = (gfloat) _i / (gfloat) _j;                                            \
-    _x = _x1 + _dx * _f;                                                       \
-    _y = _y1 + _dy * _f;                                                       \
-    draw_dot (_vd, _x, _y, _st, _c);                                           \
+  _j = MAX (ABS (_dx), ABS (_dy));                                             \
+  if (_j > 0) {                                                                \
+    _sx = (_dx * 65536) / _j;                                                  \
+    _sy = (_dy * 65536) / _j;                                                  \
+    _rx = (gint) (_x1) * 65536;                                                \
+    _ry = (gint) (_y1) * 65536;                                                \
+    for (_i = 0; _i < _j; _i++) {                                              \
+      _x = _rx >> 16;                                                          \
+      _y = _ry >> 16;                                                          \
+      draw_dot (_vd, _x, _y, _st, _c);                                         \
+      _rx += _sx;                                                              \
+      _ry += _sy;                                                              \
+    }                                                                          \
   }                                                                            \
 } G_STMT_END
 
 #define draw_line_aa(_vd, _x1, _x2, _y1, _y2, _st, _c) G_STMT_START {          \
-  guint _i, _j, _x, _y;                                                        \
-  gint _dx = _x2 - _x1, _dy = _y2 - _y1;                                       \
-  gfloat _f, _rx, _ry, _fx, _fy;                                               \
-                                                                               \
-  _j = abs (_dx) > abs (_dy) ? abs (_dx) : abs (_dy);                          \
-  for (_i = 0; _i < _j; _i++) {                                                \
-    _f = (gfloat) _i / (gfloat) _j;                                            \
-    _rx = _x1 + _dx * _f;                                                      \
-    _ry = _y1 + _dy * _f;                                                      \
-    _x = (guint)_rx;                                                           \
-    _y = (guint)_ry;                                                           \
-    _fx = _rx - (gfloat)_x;                                                    \
-    _fy = _ry - (gfloat)_y;                                                    \
+  gint _i, _j, _rx, _ry, _sx, _sy;                                             \
+  gint _dx = (gint) (_x2) - (gint) (_x1), _dy = (gint) (_y2) - (gint) (_y1);   \
+  guint _x, _y, _fx, _fy;                                                      \
                                                                                \
-    _f = ((1.0 - _fx) + (1.0 - _fy)) / 2.0;                                    \
-    draw_dot_aa (_vd, _x, _y, _st, _c, _f);                                    \
+  _j = MAX (ABS (_dx), ABS (_dy));                                             \
+  if (_j > 0) {                                                                \
+    _sx = (_dx * 65536) / _j;                                                  \
+    _sy = (_dy * 65536) / _j;                                                  \
+    _rx = (gint) (_x1) * 65536;                                                \
+    _ry = (gint) (_y1) * 65536;                                                \
+    for (_i = 0; _i < _j; _i++) {                                              \
+      _x = _rx >> 16;                                                          \
+      _y = _ry >> 16;                                                          \
+      _fx = (_rx >> 8) & 0xff;                                                 \
+      _fy = (_ry >> 8) & 0xff;                                                 \
                                                                                \
-    _f = (_fx + (1.0 - _fy)) / 2.0;                                            \
-    draw_dot_aa (_vd, (_x + 1), _y, _st, _c, _f);                              \
+      draw_dot_aa (_vd, _x, _y, _st, _c, (512 - _fx - _fy) >> 1);              \
+      draw_dot_aa (_vd, (_x + 1), _y, _st, _c, (256 + _fx - _fy) >> 1);        \
+      draw_dot_aa (_vd, _x, (_y + 1), _st, _c, (256 - _fx + _fy) >> 1);        \
+      draw_dot_aa (_vd, (_x + 1), (_y + 1), _st, _c, (_fx + _fy) >> 1);        \
                                                                                \
-    _f = ((1.0 - _fx) + _fy) / 2.0;                                            \
-    draw_dot_aa (_vd, _x, (_y + 1), _st, _c, _f);                              \
-                                                                               \
-    _f = (_fx + _fy) / 2.0;                                                    \
-    draw_dot_aa (_vd, (_x + 1), (_y + 1), _st, _c, _f);                        \
+      _rx += _sx;                                                              \
+      _ry += _sy;                                                              \
+    }                                                                          \
   }                                                                            \
 } G_STMT_END
-
@@ -32,6 +32,13 @@
  * The list of element it will look into can be specified in the
  * #GstAutoConvert:factories property, otherwise it will look at all available
  * elements.
+ *
+ * The element picked for a given pair of sink and downstream caps is
+ * remembered, so that switching back to caps seen recently does not walk the
+ * factory list again. Elements that have been instantiated stay in the bin
+ * and are reused as is when selected again. The #GstAutoConvert:prewarm
+ * property can be used to instantiate the most likely candidates in the
+ * background when going to READY, before the first caps arrive.
  */
 
 
@@ -82,14 +89,30 @@ enum
 enum
 {
   PROP_0,
-  PROP_FACTORIES
+  PROP_FACTORIES,
+  PROP_PREWARM
 };
 
+#define DEFAULT_PREWARM 0
+
+/* number of caps to factory decisions that are remembered */
+#define CACHE_SIZE 8
+
+typedef struct
+{
+  GstCaps *sink_caps;
+  GstCaps *src_caps;
+  GstElementFactory *factory;
+} CacheEntry;
+
 static void gst_auto_convert_set_property (GObject * object,
     guint prop_id, const GValue * value, GParamSpec * pspec);
 static void gst_auto_convert_get_property (GObject * object,
     guint prop_id, GValue * value, GParamSpec * pspec);
 static void gst_auto_convert_dispose (GObject * object);
+static void gst_auto_convert_finalize (GObject * object);
+static GstStateChangeReturn gst_auto_convert_change_state (GstElement *
+    element, GstStateChange transition);
 
 static GstElement *gst_auto_convert_get_subelement (GstAutoConvert *
     autoconvert);
@@ -169,6 +192,7 @@ gst_auto_convert_class_init (GstAutoConvertClass * klass)
       "Olivier Crete <olivier.crete@collabora.com>");
 
   gobject_class->dispose = GST_DEBUG_FUNCPTR (gst_auto_convert_dispose);
+  gobject_class->finalize = GST_DEBUG_FUNCPTR (gst_auto_convert_finalize);
 
   gobject_class->set_property = gst_auto_convert_set_property;
   gobject_class->get_property = gst_auto_convert_get_property;
@@ -180,6 +204,24 @@ gst_auto_convert_class_init (GstAutoConvertClass * klass)
           " ownership of the list (NULL means it will go through all possible"
           " elements), can only be set once",
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAutoConvert:prewarm:
+   *
+   * Number of candidate elements, in rank order and matching the caps of
+   * the peers, to instantiate in the background when going from NULL to
+   * READY, so that the first negotiation does not have to.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_PREWARM,
+      g_param_spec_uint ("prewarm", "Prewarm",
+          "Number of candidate elements to instantiate in the background"
+          " when going to READY", 0, G_MAXUINT, DEFAULT_PREWARM,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gstelement_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_auto_convert_change_state);
 }
 
 static void
@@ -209,6 +251,19 @@ gst_auto_convert_init (GstAutoConvert * autoconvert)
 
   gst_element_add_pad (GST_ELEMENT (autoconvert), autoconvert->sinkpad);
   gst_element_add_pad (GST_ELEMENT (autoconvert), autoconvert->srcpad);
+
+  g_mutex_init (&autoconvert->make_lock);
+  autoconvert->prewarm = DEFAULT_PREWARM;
+}
+
+static void
+cache_entry_free (CacheEntry * entry)
+{
+  gst_caps_unref (entry->sink_caps);
+  if (entry->src_caps)
+    gst_caps_unref (entry->src_caps);
+  gst_object_unref (entry->factory);
+  g_slice_free (CacheEntry, entry);
 }
 
 static void
@@ -220,6 +275,11 @@ gst_auto_convert_dispose (GObject * object)
   g_clear_object (&autoconvert->current_internal_sinkpad);
   g_clear_object (&autoconvert->current_internal_srcpad);
 
+  GST_AUTOCONVERT_LOCK (autoconvert);
+  g_list_free_full (autoconvert->cache, (GDestroyNotify) cache_entry_free);
+  autoconvert->cache = NULL;
+  GST_AUTOCONVERT_UNLOCK (autoconvert);
+
   for (;;) {
     GList *factories = g_atomic_pointer_get (&autoconvert->factories);
 
@@ -233,6 +293,16 @@ gst_auto_convert_dispose (GObject * object)
   G_OBJECT_CLASS (gst_auto_convert_parent_class)->dispose (object);
 }
 
+static void
+gst_auto_convert_finalize (GObject * object)
+{
+  GstAutoConvert *autoconvert = GST_AUTO_CONVERT (object);
+
+  g_mutex_clear (&autoconvert->make_lock);
+
+  G_OBJECT_CLASS (gst_auto_convert_parent_class)->finalize (object);
+}
+
 static void
 gst_auto_convert_set_property (GObject * object,
     guint prop_id, const GValue * value, GParamSpec * pspec)
@@ -257,6 +327,11 @@ gst_auto_convert_set_property (GObject * object,
             " have been set or auto-discovered");
       }
       break;
+    case PROP_PREWARM:
+      GST_AUTOCONVERT_LOCK (autoconvert);
+      autoconvert->prewarm = g_value_get_uint (value);
+      GST_AUTOCONVERT_UNLOCK (autoconvert);
+      break;
   }
 }
 
@@ -274,6 +349,11 @@ gst_auto_convert_get_property (GObject * object,
       g_value_set_pointer (value,
           g_atomic_pointer_get (&autoconvert->factories));
       break;
+    case PROP_PREWARM:
+      GST_AUTOCONVERT_LOCK (autoconvert);
+      g_value_set_uint (value, autoconvert->prewarm);
+      GST_AUTOCONVERT_UNLOCK (autoconvert);
+      break;
   }
 }
 
@@ -557,12 +637,15 @@ gst_auto_convert_get_or_make_element_from_factory (GstAutoConvert * autoconvert,
   if (!loaded_factory)
     return NULL;
 
+  /* prewarming may be creating elements from another thread */
+  g_mutex_lock (&autoconvert->make_lock);
   element = gst_auto_convert_get_element_by_type (autoconvert,
       gst_element_factory_get_element_type (loaded_factory));
 
   if (!element) {
     element = gst_auto_convert_add_element (autoconvert, loaded_factory);
   }
+  g_mutex_unlock (&autoconvert->make_lock);
 
   gst_object_unref (loaded_factory);
 
@@ -699,6 +782,79 @@ gst_auto_convert_iterate_internal_links (GstPad * pad, GstObject * parent)
   return it;
 }
 
+static GstElementFactory *
+gst_auto_convert_cache_lookup (GstAutoConvert * autoconvert, GstCaps * caps,
+    GstCaps * other_caps)
+{
+  GstElementFactory *factory = NULL;
+  GList *l;
+
+  GST_AUTOCONVERT_LOCK (autoconvert);
+  for (l = autoconvert->cache; l; l = l->next) {
+    CacheEntry *entry = l->data;
+
+    if (!gst_caps_is_equal (entry->sink_caps, caps))
+      continue;
+    if (entry->src_caps != other_caps && (!entry->src_caps || !other_caps ||
+            !gst_caps_is_equal (entry->src_caps, other_caps)))
+      continue;
+
+    /* move to the front to keep the most recently used entries */
+    autoconvert->cache = g_list_remove_link (autoconvert->cache, l);
+    autoconvert->cache = g_list_concat (l, autoconvert->cache);
+    factory = gst_object_ref (entry->factory);
+    break;
+  }
+  GST_AUTOCONVERT_UNLOCK (autoconvert);
+
+  return factory;
+}
+
+static void
+gst_auto_convert_cache_remove (GstAutoConvert * autoconvert,
+    GstElementFactory * factory)
+{
+  GList *l, *next;
+
+  GST_AUTOCONVERT_LOCK (autoconvert);
+  for (l = autoconvert->cache; l; l = next) {
+    CacheEntry *entry = l->data;
+
+    next = l->next;
+    if (entry->factory == factory) {
+      cache_entry_free (entry);
+      autoconvert->cache = g_list_delete_link (autoconvert->cache, l);
+    }
+  }
+  GST_AUTOCONVERT_UNLOCK (autoconvert);
+}
+
+static void
+gst_auto_convert_cache_add (GstAutoConvert * autoconvert, GstCaps * caps,
+    GstCaps * other_caps, GstElement * element)
+{
+  GstElementFactory *factory = gst_element_get_factory (element);
+  CacheEntry *entry;
+  GList *last;
+
+  if (!factory)
+    return;
+
+  entry = g_slice_new (CacheEntry);
+  entry->sink_caps = gst_caps_ref (caps);
+  entry->src_caps = other_caps ? gst_caps_ref (other_caps) : NULL;
+  entry->factory = gst_object_ref (factory);
+
+  GST_AUTOCONVERT_LOCK (autoconvert);
+  autoconvert->cache = g_list_prepend (autoconvert->cache, entry);
+  if (g_list_length (autoconvert->cache) > CACHE_SIZE) {
+    last = g_list_last (autoconvert->cache);
+    cache_entry_free (last->data);
+    autoconvert->cache = g_list_delete_link (autoconvert->cache, last);
+  }
+  GST_AUTOCONVERT_UNLOCK (autoconvert);
+}
+
 /*
  * If there is already an internal element, it will try to call set_caps on it
  *
@@ -713,6 +869,7 @@ gst_auto_convert_sink_setcaps (GstAutoConvert * autoconvert, GstCaps * caps)
   GList *elem;
   GstCaps *other_caps = NULL;
   GList *factories;
+  GstElementFactory *cached_factory;
   GstCaps *current_caps;
 
   g_return_val_if_fail (autoconvert != NULL, FALSE);
@@ -749,6 +906,29 @@ gst_auto_convert_sink_setcaps (GstAutoConvert * autoconvert, GstCaps * caps)
 
   other_caps = gst_pad_peer_query_caps (autoconvert->srcpad, NULL);
 
+  /* try the element that was picked the last time we saw these caps */
+  cached_factory =
+      gst_auto_convert_cache_lookup (autoconvert, caps, other_caps);
+  if (cached_factory) {
+    GstElement *element;
+
+    GST_DEBUG_OBJECT (autoconvert, "Trying cached factory %s",
+        gst_plugin_feature_get_name (GST_PLUGIN_FEATURE (cached_factory)));
+
+    element = gst_auto_convert_get_or_make_element_from_factory (autoconvert,
+        cached_factory);
+    if (element && gst_auto_convert_activate_element (autoconvert, element,
+            caps)) {
+      gst_object_unref (cached_factory);
+      goto get_out;
+    }
+
+    if (element)
+      gst_object_unref (element);
+    gst_auto_convert_cache_remove (autoconvert, cached_factory);
+    gst_object_unref (cached_factory);
+  }
+
   factories = g_atomic_pointer_get (&autoconvert->factories);
 
   if (!factories)
@@ -786,10 +966,13 @@ gst_auto_convert_sink_setcaps (GstAutoConvert * autoconvert, GstCaps * caps)
       continue;
 
     /* And make it the current child */
-    if (gst_auto_convert_activate_element (autoconvert, element, caps))
+    if (gst_auto_convert_activate_element (autoconvert, element, caps)) {
+      gst_auto_convert_cache_add (autoconvert, caps, other_caps,
+          autoconvert->current_subelement);
       break;
-    else
+    } else {
       gst_object_unref (element);
+    }
   }
 
 get_out:
@@ -903,6 +1086,83 @@ gst_auto_convert_load_factories (GstAutoConvert * autoconvert)
   return g_atomic_pointer_get (&autoconvert->factories);
 }
 
+static void
+gst_auto_convert_prewarm (GstElement * element, gpointer user_data)
+{
+  GstAutoConvert *autoconvert = GST_AUTO_CONVERT (element);
+  GstCaps *sink_caps, *src_caps;
+  GList *elem, *factories;
+  guint n_elements = 0, prewarm;
+
+  GST_AUTOCONVERT_LOCK (autoconvert);
+  prewarm = autoconvert->prewarm;
+  GST_AUTOCONVERT_UNLOCK (autoconvert);
+
+  sink_caps = gst_pad_peer_query_caps (autoconvert->sinkpad, NULL);
+  src_caps = gst_pad_peer_query_caps (autoconvert->srcpad, NULL);
+
+  factories = g_atomic_pointer_get (&autoconvert->factories);
+  if (!factories)
+    factories = gst_auto_convert_load_factories (autoconvert);
+
+  for (elem = factories; elem && n_elements < prewarm;
+      elem = g_list_next (elem)) {
+    GstElementFactory *factory = GST_ELEMENT_FACTORY (elem->data);
+    GstElement *subelement;
+
+    if (GST_STATE_TARGET (autoconvert) < GST_STATE_READY)
+      break;
+
+    if (sink_caps && !factory_can_intersect (autoconvert, factory,
+            GST_PAD_SINK, sink_caps))
+      continue;
+    if (src_caps && !factory_can_intersect (autoconvert, factory,
+            GST_PAD_SRC, src_caps))
+      continue;
+
+    subelement = gst_auto_convert_get_or_make_element_from_factory
+        (autoconvert, factory);
+    if (!subelement)
+      continue;
+
+    GST_DEBUG_OBJECT (autoconvert, "Prewarmed %s",
+        GST_OBJECT_NAME (subelement));
+    gst_object_unref (subelement);
+    n_elements++;
+  }
+
+  if (sink_caps)
+    gst_caps_unref (sink_caps);
+  if (src_caps)
+    gst_caps_unref (src_caps);
+}
+
+static GstStateChangeReturn
+gst_auto_convert_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstAutoConvert *autoconvert = GST_AUTO_CONVERT (element);
+  GstStateChangeReturn ret;
+  guint prewarm;
+
+  ret =
+      GST_ELEMENT_CLASS (gst_auto_convert_parent_class)->change_state
+      (element, transition);
+  if (ret == GST_STATE_CHANGE_FAILURE)
+    return ret;
+
+  if (transition == GST_STATE_CHANGE_NULL_TO_READY) {
+    GST_AUTOCONVERT_LOCK (autoconvert);
+    prewarm = autoconvert->prewarm;
+    GST_AUTOCONVERT_UNLOCK (autoconvert);
+
+    if (prewarm > 0)
+      gst_element_call_async (element, gst_auto_convert_prewarm, NULL, NULL);
+  }
+
+  return ret;
+}
+
 /* In this case, we should almost always have an internal element, because
  * set_caps() should have been called first
  */
@@ -53,6 +53,16 @@ struct _GstAutoConvert
   GstElement *current_subelement;
   GstPad *current_internal_srcpad;
   GstPad *current_internal_sinkpad;
+
+  /* Recent caps to factory decisions, most recent first
+   * Protected by the object lock
+   */
+  GList *cache;
+
+  /* Serializes looking up and creating sub-elements */
+  GMutex make_lock;
+
+  guint prewarm;
 };
 
 struct _GstAutoConvertClass
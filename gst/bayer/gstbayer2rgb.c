@@ -26,6 +26,12 @@
  * @title: bayer2rgb
  *
  * Decodes raw camera bayer (fourcc BA81) to RGB.
+ *
+ * Since 1.20, Bayer input with 10, 12, 14 or 16 bits per sample in either
+ * byte order is supported as well. Those are demosaiced with their full
+ * precision when producing ARGB64 and reduced to 8 bits otherwise. The
+ * frames can also be split in slices of lines processed in parallel, see
+ * #GstBayer2RGB:n-threads.
  */
 
 /*
@@ -122,7 +128,17 @@ struct _GstBayer2RGB
   int r_off;                    /* offset for red */
   int g_off;                    /* offset for green */
   int b_off;                    /* offset for blue */
+  int a_off;                    /* offset for alpha */
   int format;
+  int bits;                     /* bits per input sample */
+  gboolean big_endian;          /* byte order of samples of more than 8 bits */
+  int out_bits;                 /* bits per output component */
+
+  guint n_threads;
+  GThreadPool *pool;
+  GMutex jobs_lock;
+  GCond jobs_cond;
+  guint jobs_pending;
 };
 
 struct _GstBayer2RGBClass
@@ -131,14 +147,26 @@ struct _GstBayer2RGBClass
 };
 
 #define	SRC_CAPS                                 \
-  GST_VIDEO_CAPS_MAKE ("{ RGBx, xRGB, BGRx, xBGR, RGBA, ARGB, BGRA, ABGR }")
+  GST_VIDEO_CAPS_MAKE ("{ RGBx, xRGB, BGRx, xBGR, RGBA, ARGB, BGRA, ABGR, " \
+      "ARGB64 }")
+
+#define BAYER_FORMATS(bits) \
+  "bggr" bits "le,bggr" bits "be,grbg" bits "le,grbg" bits "be," \
+  "gbrg" bits "le,gbrg" bits "be,rggb" bits "le,rggb" bits "be"
 
-#define SINK_CAPS "video/x-bayer,format=(string){bggr,grbg,gbrg,rggb}," \
+#define SINK_CAPS "video/x-bayer,format=(string){bggr,grbg,gbrg,rggb," \
+  BAYER_FORMATS ("10") "," BAYER_FORMATS ("12") "," \
+  BAYER_FORMATS ("14") "," BAYER_FORMATS ("16") "}," \
   "width=(int)[1,MAX],height=(int)[1,MAX],framerate=(fraction)[0/1,MAX]"
 
+#define DEFAULT_N_THREADS 1
+
+#define MIN_ROWS_PER_JOB 16
+
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_N_THREADS
 };
 
 GType gst_bayer2rgb_get_type (void);
@@ -160,6 +188,7 @@ static GstCaps *gst_bayer2rgb_transform_caps (GstBaseTransform * base,
     GstPadDirection direction, GstCaps * caps, GstCaps * filter);
 static gboolean gst_bayer2rgb_get_unit_size (GstBaseTransform * base,
     GstCaps * caps, gsize * size);
+static void gst_bayer2rgb_finalize (GObject * object);
 
 
 static void
@@ -173,6 +202,20 @@ gst_bayer2rgb_class_init (GstBayer2RGBClass * klass)
 
   gobject_class->set_property = gst_bayer2rgb_set_property;
   gobject_class->get_property = gst_bayer2rgb_get_property;
+  gobject_class->finalize = gst_bayer2rgb_finalize;
+
+  /**
+   * GstBayer2RGB:n-threads:
+   *
+   * Maximum number of threads demosaicing slices of the frame, 0 means one
+   * thread per CPU.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use", 0, G_MAXUINT,
+          DEFAULT_N_THREADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_set_static_metadata (gstelement_class,
       "Bayer to RGB decoder for cameras", "Filter/Converter/Video",
@@ -204,15 +247,37 @@ gst_bayer2rgb_init (GstBayer2RGB * filter)
 {
   gst_bayer2rgb_reset (filter);
   gst_base_transform_set_in_place (GST_BASE_TRANSFORM (filter), TRUE);
+
+  filter->n_threads = DEFAULT_N_THREADS;
+  g_mutex_init (&filter->jobs_lock);
+  g_cond_init (&filter->jobs_cond);
+}
+
+static void
+gst_bayer2rgb_finalize (GObject * object)
+{
+  GstBayer2RGB *filter = GST_BAYER2RGB (object);
+
+  if (filter->pool)
+    g_thread_pool_free (filter->pool, FALSE, TRUE);
+  g_mutex_clear (&filter->jobs_lock);
+  g_cond_clear (&filter->jobs_cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
-/* No properties are implemented, so only a warning is produced */
 static void
 gst_bayer2rgb_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
 {
+  GstBayer2RGB *filter = GST_BAYER2RGB (object);
 
   switch (prop_id) {
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      filter->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -223,14 +288,66 @@ static void
 gst_bayer2rgb_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
 {
+  GstBayer2RGB *filter = GST_BAYER2RGB (object);
 
   switch (prop_id) {
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      g_value_set_uint (value, filter->n_threads);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+/* returns the number of bits per sample of a video/x-bayer format, or 0 if
+ * the format is not supported */
+static int
+gst_bayer2rgb_parse_format (const char *format, int *pattern,
+    gboolean * big_endian)
+{
+  gchar *end;
+  guint64 bits;
+
+  if (format == NULL)
+    return 0;
+
+  if (g_str_has_prefix (format, "bggr")) {
+    *pattern = GST_BAYER_2_RGB_FORMAT_BGGR;
+  } else if (g_str_has_prefix (format, "gbrg")) {
+    *pattern = GST_BAYER_2_RGB_FORMAT_GBRG;
+  } else if (g_str_has_prefix (format, "grbg")) {
+    *pattern = GST_BAYER_2_RGB_FORMAT_GRBG;
+  } else if (g_str_has_prefix (format, "rggb")) {
+    *pattern = GST_BAYER_2_RGB_FORMAT_RGGB;
+  } else {
+    return 0;
+  }
+
+  *big_endian = FALSE;
+  if (format[4] == '\0')
+    return 8;
+
+  bits = g_ascii_strtoull (format + 4, &end, 10);
+  if (bits <= 8 || bits > 16)
+    return 0;
+
+  if (g_str_equal (end, "be"))
+    *big_endian = TRUE;
+  else if (!g_str_equal (end, "le"))
+    return 0;
+
+  return bits;
+}
+
+static int
+gst_bayer2rgb_get_stride (int width, int bits)
+{
+  return bits > 8 ? GST_ROUND_UP_4 (width * 2) : GST_ROUND_UP_4 (width);
+}
+
 static gboolean
 gst_bayer2rgb_set_caps (GstBaseTransform * base, GstCaps * incaps,
     GstCaps * outcaps)
@@ -249,23 +366,30 @@ gst_bayer2rgb_set_caps (GstBaseTransform * base, GstCaps * incaps,
   gst_structure_get_int (structure, "height", &bayer2rgb->height);
 
   format = gst_structure_get_string (structure, "format");
-  if (g_str_equal (format, "bggr")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_BGGR;
-  } else if (g_str_equal (format, "gbrg")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_GBRG;
-  } else if (g_str_equal (format, "grbg")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_GRBG;
-  } else if (g_str_equal (format, "rggb")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_RGGB;
-  } else {
+  bayer2rgb->bits = gst_bayer2rgb_parse_format (format, &bayer2rgb->format,
+      &bayer2rgb->big_endian);
+  if (bayer2rgb->bits == 0)
     return FALSE;
-  }
 
   /* To cater for different RGB formats, we need to set params for later */
-  gst_video_info_from_caps (&info, outcaps);
+  if (!gst_video_info_from_caps (&info, outcaps))
+    return FALSE;
+  bayer2rgb->out_bits = GST_VIDEO_INFO_COMP_DEPTH (&info, 0);
   bayer2rgb->r_off = GST_VIDEO_INFO_COMP_OFFSET (&info, 0);
   bayer2rgb->g_off = GST_VIDEO_INFO_COMP_OFFSET (&info, 1);
   bayer2rgb->b_off = GST_VIDEO_INFO_COMP_OFFSET (&info, 2);
+  if (bayer2rgb->out_bits > 8) {
+    /* offsets of 16 bit output are used in samples */
+    bayer2rgb->r_off /= 2;
+    bayer2rgb->g_off /= 2;
+    bayer2rgb->b_off /= 2;
+  }
+  bayer2rgb->a_off = 6 - bayer2rgb->r_off - bayer2rgb->g_off -
+      bayer2rgb->b_off;
+
+  GST_DEBUG_OBJECT (bayer2rgb, "%d bits %s endian input, %d bits output",
+      bayer2rgb->bits, bayer2rgb->big_endian ? "big" : "little",
+      bayer2rgb->out_bits);
 
   bayer2rgb->info = info;
 
@@ -280,6 +404,10 @@ gst_bayer2rgb_reset (GstBayer2RGB * filter)
   filter->r_off = 0;
   filter->g_off = 0;
   filter->b_off = 0;
+  filter->a_off = 0;
+  filter->bits = 8;
+  filter->big_endian = FALSE;
+  filter->out_bits = 8;
   gst_video_info_init (&filter->info);
 }
 
@@ -334,11 +462,24 @@ gst_bayer2rgb_get_unit_size (GstBaseTransform * base, GstCaps * caps,
     name = gst_structure_get_name (structure);
     /* Our name must be either video/x-bayer video/x-raw */
     if (strcmp (name, "video/x-raw")) {
-      *size = GST_ROUND_UP_4 (width) * height;
+      int pattern, bits;
+      gboolean big_endian;
+
+      bits =
+          gst_bayer2rgb_parse_format (gst_structure_get_string (structure,
+              "format"), &pattern, &big_endian);
+      if (bits == 0)
+        bits = 8;
+      *size = gst_bayer2rgb_get_stride (width, bits) * height;
       return TRUE;
     } else {
-      /* For output, calculate according to format (always 32 bits) */
-      *size = width * height * 4;
+      /* For output, calculate according to format (32 or 64 bits) */
+      GstVideoInfo info;
+
+      if (gst_video_info_from_caps (&info, caps))
+        *size = GST_VIDEO_INFO_SIZE (&info);
+      else
+        *size = width * height * 4;
       return TRUE;
     }
 
@@ -381,13 +522,242 @@ typedef void (*process_func) (guint8 * d0, const guint8 * s0, const guint8 * s1,
     const guint8 * s2, const guint8 * s3, const guint8 * s4, const guint8 * s5,
     int n);
 
+typedef struct _GstBayer2RGBJob GstBayer2RGBJob;
+
+typedef void (*process16_func) (const GstBayer2RGBJob * job, guint16 * d0,
+    const guint16 * s0, const guint16 * s1, const guint16 * s2,
+    const guint16 * s3, const guint16 * s4, const guint16 * s5, int n);
+
+struct _GstBayer2RGBJob
+{
+  GstBayer2RGB *bayer2rgb;
+  guint8 *dest;
+  int dest_stride;
+  const guint8 *src;
+  int src_stride;
+  int y_start, y_end;
+
+  /* 8 bit output */
+  process_func merge[2];
+  /* 16 bit output, with the offsets in samples */
+  process16_func merge16[2];
+  int r_off, g_off, b_off, a_off;
+};
+
+/* samples with more than 8 bits, reduced to 8 bits for 8 bit output */
+static void
+gst_bayer2rgb_unpack_line (guint8 * dest, const guint8 * src, int n, int bits,
+    gboolean big_endian)
+{
+  const int shift = bits - 8;
+  int i;
+
+  if (big_endian) {
+    for (i = 0; i < n; i++)
+      dest[i] = (GST_READ_UINT16_BE (src + 2 * i) >> shift) & 0xff;
+  } else {
+    for (i = 0; i < n; i++)
+      dest[i] = (GST_READ_UINT16_LE (src + 2 * i) >> shift) & 0xff;
+  }
+}
+
+/* samples of any depth, scaled to the full 16 bit range */
+static void
+gst_bayer2rgb_unpack_line16 (guint16 * dest, const guint8 * src, int n,
+    int bits, gboolean big_endian)
+{
+  const int shift = 16 - bits;
+  const guint mask = (1 << bits) - 1;
+  int i;
+
+  if (bits == 8) {
+    for (i = 0; i < n; i++)
+      dest[i] = src[i] * 257;
+  } else if (big_endian) {
+    for (i = 0; i < n; i++) {
+      guint v = GST_READ_UINT16_BE (src + 2 * i) & mask;
+      dest[i] = (v << shift) | (v >> (bits - shift));
+    }
+  } else {
+    for (i = 0; i < n; i++) {
+      guint v = GST_READ_UINT16_LE (src + 2 * i) & mask;
+      dest[i] = (v << shift) | (v >> (bits - shift));
+    }
+  }
+}
+
+/* same as gst_bayer2rgb_split_and_upsample_horiz() on 16 bit samples */
+static void
+gst_bayer2rgb_split_and_upsample_horiz16 (guint16 * dest0, guint16 * dest1,
+    const guint16 * src, int n)
+{
+  int i;
+
+  dest0[0] = src[0];
+  dest1[0] = src[1];
+
+  for (i = 1; i < n - 1; i++) {
+    guint avg = (src[i - 1] + src[i + 1] + 1) >> 1;
+
+    dest0[i] = (i & 1) ? avg : src[i];
+    dest1[i] = (i & 1) ? src[i] : avg;
+  }
+
+  i = n - 1;
+  if ((i & 1) == 0) {
+    dest0[i] = src[i];
+    dest1[i] = src[i - 1];
+  } else {
+    dest0[i] = src[i - 1];
+    dest1[i] = src[i];
+  }
+}
+
+/* same interpolation as bayer_orc_merge_bg_*() */
+static void
+gst_bayer2rgb_merge_bg16 (const GstBayer2RGBJob * job, guint16 * d,
+    const guint16 * g0, const guint16 * r0, const guint16 * b1,
+    const guint16 * g1, const guint16 * g2, const guint16 * r2, int n)
+{
+  int i;
+
+  for (i = 0; i < n; i++) {
+    guint g = (((g0[i] + g2[i] + 1) >> 1) + g1[i] + 1) >> 1;
+
+    d[job->r_off] = (r0[i] + r2[i] + 1) >> 1;
+    d[job->g_off] = (i & 1) ? g1[i] : g;
+    d[job->b_off] = b1[i];
+    d[job->a_off] = 0xffff;
+    d += 4;
+  }
+}
+
+/* same interpolation as bayer_orc_merge_gr_*() */
+static void
+gst_bayer2rgb_merge_gr16 (const GstBayer2RGBJob * job, guint16 * d,
+    const guint16 * b0, const guint16 * g0, const guint16 * g1,
+    const guint16 * r1, const guint16 * b2, const guint16 * g2, int n)
+{
+  int i;
+
+  for (i = 0; i < n; i++) {
+    guint g = (((g0[i] + g2[i] + 1) >> 1) + g1[i] + 1) >> 1;
+
+    d[job->r_off] = r1[i];
+    d[job->g_off] = (i & 1) ? g : g1[i];
+    d[job->b_off] = (b0[i] + b2[i] + 1) >> 1;
+    d[job->a_off] = 0xffff;
+    d += 4;
+  }
+}
+
+/* lines outside of the frame are mirrored, which keeps the Bayer pattern */
+static inline int
+gst_bayer2rgb_mirror_line (GstBayer2RGB * bayer2rgb, int j)
+{
+  if (j < 0)
+    j = -j;
+  if (j >= bayer2rgb->height)
+    j = 2 * (bayer2rgb->height - 1) - j;
+
+  return CLAMP (j, 0, bayer2rgb->height - 1);
+}
+
+static void
+gst_bayer2rgb_split_line (const GstBayer2RGBJob * job, guint8 * dest0,
+    guint8 * dest1, int j, guint8 * scratch)
+{
+  GstBayer2RGB *bayer2rgb = job->bayer2rgb;
+  const guint8 *src;
+
+  j = gst_bayer2rgb_mirror_line (bayer2rgb, j);
+  src = job->src + j * job->src_stride;
+
+  if (bayer2rgb->out_bits > 8) {
+    gst_bayer2rgb_unpack_line16 ((guint16 *) scratch, src, bayer2rgb->width,
+        bayer2rgb->bits, bayer2rgb->big_endian);
+    gst_bayer2rgb_split_and_upsample_horiz16 ((guint16 *) dest0,
+        (guint16 *) dest1, (const guint16 *) scratch, bayer2rgb->width);
+  } else {
+    if (bayer2rgb->bits > 8) {
+      gst_bayer2rgb_unpack_line (scratch, src, bayer2rgb->width,
+          bayer2rgb->bits, bayer2rgb->big_endian);
+      src = scratch;
+    }
+    gst_bayer2rgb_split_and_upsample_horiz (dest0, dest1, src,
+        bayer2rgb->width);
+  }
+}
+
+/* Each output line j needs the input lines j - 1, j and j + 1. Every slice
+ * keeps its own window of three split lines, starting with the line above
+ * the slice, so slices are independent of each other. */
+static void
+gst_bayer2rgb_process_rows (GstBayer2RGBJob * job)
+{
+  GstBayer2RGB *bayer2rgb = job->bayer2rgb;
+  const int line_size =
+      bayer2rgb->width * (bayer2rgb->out_bits > 8 ? 2 : 1);
+  int j;
+  guint8 *tmp, *scratch;
+
+  tmp = g_malloc ((2 * 4 + 1) * line_size);
+  scratch = tmp + 2 * 4 * line_size;
+#define LINE(x) (tmp + ((x)&7) * line_size)
+
+  j = job->y_start - 1;
+  gst_bayer2rgb_split_line (job, LINE (j * 2 + 0), LINE (j * 2 + 1), j,
+      scratch);
+  j = job->y_start;
+  gst_bayer2rgb_split_line (job, LINE (j * 2 + 0), LINE (j * 2 + 1), j,
+      scratch);
+
+  for (j = job->y_start; j < job->y_end; j++) {
+    gst_bayer2rgb_split_line (job, LINE ((j + 1) * 2 + 0),
+        LINE ((j + 1) * 2 + 1), j + 1, scratch);
+
+    if (bayer2rgb->out_bits > 8) {
+      guint16 *d = (guint16 *) (job->dest + j * job->dest_stride);
+
+      job->merge16[j & 1] (job, d,
+          (guint16 *) LINE (j * 2 - 2), (guint16 *) LINE (j * 2 - 1),
+          (guint16 *) LINE (j * 2 + 0), (guint16 *) LINE (j * 2 + 1),
+          (guint16 *) LINE (j * 2 + 2), (guint16 *) LINE (j * 2 + 3),
+          bayer2rgb->width);
+    } else {
+      job->merge[j & 1] (job->dest + j * job->dest_stride,
+          LINE (j * 2 - 2), LINE (j * 2 - 1),
+          LINE (j * 2 + 0), LINE (j * 2 + 1),
+          LINE (j * 2 + 2), LINE (j * 2 + 3), bayer2rgb->width >> 1);
+    }
+  }
+#undef LINE
+
+  g_free (tmp);
+}
+
+static void
+gst_bayer2rgb_process_job (gpointer data, gpointer user_data)
+{
+  GstBayer2RGBJob *job = data;
+  GstBayer2RGB *bayer2rgb = job->bayer2rgb;
+
+  gst_bayer2rgb_process_rows (job);
+
+  g_mutex_lock (&bayer2rgb->jobs_lock);
+  if (--bayer2rgb->jobs_pending == 0)
+    g_cond_signal (&bayer2rgb->jobs_cond);
+  g_mutex_unlock (&bayer2rgb->jobs_lock);
+}
+
 static void
 gst_bayer2rgb_process (GstBayer2RGB * bayer2rgb, uint8_t * dest,
     int dest_stride, uint8_t * src, int src_stride)
 {
-  int j;
-  guint8 *tmp;
-  process_func merge[2] = { NULL, NULL };
+  GstBayer2RGBJob job = { NULL, };
+  GstBayer2RGBJob *jobs;
+  guint n_jobs, i;
+  int rows;
   int r_off, g_off, b_off;
 
   /* We exploit some symmetry in the functions here.  The base functions
@@ -404,51 +774,81 @@ gst_bayer2rgb_process (GstBayer2RGB * bayer2rgb, uint8_t * dest,
   }
 
   if (r_off == 2 && g_off == 1 && b_off == 0) {
-    merge[0] = bayer_orc_merge_bg_bgra;
-    merge[1] = bayer_orc_merge_gr_bgra;
+    job.merge[0] = bayer_orc_merge_bg_bgra;
+    job.merge[1] = bayer_orc_merge_gr_bgra;
   } else if (r_off == 3 && g_off == 2 && b_off == 1) {
-    merge[0] = bayer_orc_merge_bg_abgr;
-    merge[1] = bayer_orc_merge_gr_abgr;
+    job.merge[0] = bayer_orc_merge_bg_abgr;
+    job.merge[1] = bayer_orc_merge_gr_abgr;
   } else if (r_off == 1 && g_off == 2 && b_off == 3) {
-    merge[0] = bayer_orc_merge_bg_argb;
-    merge[1] = bayer_orc_merge_gr_argb;
+    job.merge[0] = bayer_orc_merge_bg_argb;
+    job.merge[1] = bayer_orc_merge_gr_argb;
   } else if (r_off == 0 && g_off == 1 && b_off == 2) {
-    merge[0] = bayer_orc_merge_bg_rgba;
-    merge[1] = bayer_orc_merge_gr_rgba;
+    job.merge[0] = bayer_orc_merge_bg_rgba;
+    job.merge[1] = bayer_orc_merge_gr_rgba;
   }
+  job.merge16[0] = gst_bayer2rgb_merge_bg16;
+  job.merge16[1] = gst_bayer2rgb_merge_gr16;
   if (bayer2rgb->format == GST_BAYER_2_RGB_FORMAT_GRBG ||
       bayer2rgb->format == GST_BAYER_2_RGB_FORMAT_GBRG) {
-    process_func tmp = merge[0];
-    merge[0] = merge[1];
-    merge[1] = tmp;
+    process_func tmp = job.merge[0];
+    process16_func tmp16 = job.merge16[0];
+
+    job.merge[0] = job.merge[1];
+    job.merge[1] = tmp;
+    job.merge16[0] = job.merge16[1];
+    job.merge16[1] = tmp16;
   }
 
-  tmp = g_malloc (2 * 4 * bayer2rgb->width);
-#define LINE(x) (tmp + ((x)&7) * bayer2rgb->width)
+  job.bayer2rgb = bayer2rgb;
+  job.dest = dest;
+  job.dest_stride = dest_stride;
+  job.src = src;
+  job.src_stride = src_stride;
+  job.r_off = r_off;
+  job.g_off = g_off;
+  job.b_off = b_off;
+  job.a_off = bayer2rgb->a_off;
+
+  GST_OBJECT_LOCK (bayer2rgb);
+  n_jobs = bayer2rgb->n_threads;
+  GST_OBJECT_UNLOCK (bayer2rgb);
+  if (n_jobs == 0)
+    n_jobs = g_get_num_processors ();
+  n_jobs = CLAMP (bayer2rgb->height / MIN_ROWS_PER_JOB, 1, n_jobs);
+
+  if (n_jobs == 1) {
+    job.y_start = 0;
+    job.y_end = bayer2rgb->height;
+    gst_bayer2rgb_process_rows (&job);
+    return;
+  }
 
-  gst_bayer2rgb_split_and_upsample_horiz (LINE (3 * 2 + 0), LINE (3 * 2 + 1),
-      src + 1 * src_stride, bayer2rgb->width);
-  j = 0;
-  gst_bayer2rgb_split_and_upsample_horiz (LINE (j * 2 + 0), LINE (j * 2 + 1),
-      src + j * src_stride, bayer2rgb->width);
+  if (bayer2rgb->pool == NULL) {
+    bayer2rgb->pool = g_thread_pool_new (gst_bayer2rgb_process_job, NULL,
+        -1, FALSE, NULL);
+  }
 
-  for (j = 0; j < bayer2rgb->height; j++) {
-    if (j < bayer2rgb->height - 1) {
-      gst_bayer2rgb_split_and_upsample_horiz (LINE ((j + 1) * 2 + 0),
-          LINE ((j + 1) * 2 + 1), src + (j + 1) * src_stride, bayer2rgb->width);
-    }
+  jobs = g_newa (GstBayer2RGBJob, n_jobs);
+  rows = (bayer2rgb->height + n_jobs - 1) / n_jobs;
 
-    merge[j & 1] (dest + j * dest_stride,
-        LINE (j * 2 - 2), LINE (j * 2 - 1),
-        LINE (j * 2 + 0), LINE (j * 2 + 1),
-        LINE (j * 2 + 2), LINE (j * 2 + 3), bayer2rgb->width >> 1);
+  for (i = 0; i < n_jobs; i++) {
+    jobs[i] = job;
+    jobs[i].y_start = MIN (i * rows, bayer2rgb->height);
+    jobs[i].y_end = MIN ((i + 1) * rows, bayer2rgb->height);
   }
 
-  g_free (tmp);
-}
-
+  bayer2rgb->jobs_pending = n_jobs - 1;
+  for (i = 1; i < n_jobs; i++)
+    g_thread_pool_push (bayer2rgb->pool, &jobs[i], NULL);
 
+  /* do the first slice from the streaming thread */
+  gst_bayer2rgb_process_rows (&jobs[0]);
 
+  g_mutex_lock (&bayer2rgb->jobs_lock);
+  while (bayer2rgb->jobs_pending > 0)
+    g_cond_wait (&bayer2rgb->jobs_cond, &bayer2rgb->jobs_lock);
+  g_mutex_unlock (&bayer2rgb->jobs_lock);
+}
 
 static GstFlowReturn
 gst_bayer2rgb_transform (GstBaseTransform * base, GstBuffer * inbuf,
@@ -471,7 +871,7 @@ gst_bayer2rgb_transform (GstBaseTransform * base, GstBuffer * inbuf,
 
   output = GST_VIDEO_FRAME_PLANE_DATA (&frame, 0);
   gst_bayer2rgb_process (filter, output, frame.info.stride[0],
-      map.data, GST_ROUND_UP_4 (filter->width));
+      map.data, gst_bayer2rgb_get_stride (filter->width, filter->bits));
 
   gst_video_frame_unmap (&frame);
   gst_buffer_unmap (inbuf, &map);
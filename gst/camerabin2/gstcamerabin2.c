@@ -208,7 +208,8 @@ enum
   PROP_IMAGE_ENCODING_PROFILE,
   PROP_IDLE,
   PROP_FLAGS,
-  PROP_AUDIO_FILTER
+  PROP_AUDIO_FILTER,
+  PROP_BURST_COUNT
 };
 
 enum
@@ -227,6 +228,7 @@ static guint camerabin_signals[LAST_SIGNAL];
 #define DEFAULT_MUTE_AUDIO FALSE
 #define DEFAULT_IDLE TRUE
 #define DEFAULT_FLAGS 0
+#define DEFAULT_BURST_COUNT 1
 
 #define DEFAULT_AUDIO_SRC "autoaudiosrc"
 
@@ -332,11 +334,26 @@ gst_camera_bin_new_event_file_location (const gchar * location)
           NULL));
 }
 
+/* number of images the camera source produces for one image capture */
+static gint
+gst_camera_bin_get_burst_count (GstCameraBin2 * camerabin)
+{
+  gint burst_count = 1;
+
+  if (camerabin->mode == MODE_IMAGE && camerabin->src
+      && g_object_class_find_property (G_OBJECT_GET_CLASS (camerabin->src),
+          "burst-count"))
+    g_object_get (camerabin->src, "burst-count", &burst_count, NULL);
+
+  return MAX (burst_count, 1);
+}
+
 static void
 gst_camera_bin_start_capture (GstCameraBin2 * camerabin)
 {
   const GstTagList *taglist;
   gint capture_index = camerabin->capture_index;
+  gint n_captures, i;
   gchar *location = NULL;
   GST_DEBUG_OBJECT (camerabin, "Received start-capture");
 
@@ -362,31 +379,42 @@ gst_camera_bin_start_capture (GstCameraBin2 * camerabin)
     camerabin->video_state = GST_CAMERA_BIN_VIDEO_STARTING;
   }
 
-  GST_CAMERA_BIN2_PROCESSING_INC (camerabin);
+  /* a burst produces one image, with its own location, per frame */
+  n_captures = gst_camera_bin_get_burst_count (camerabin);
+  if (n_captures > 1)
+    GST_DEBUG_OBJECT (camerabin, "Starting a burst of %d images", n_captures);
 
-  if (camerabin->location)
-    location = g_strdup_printf (camerabin->location, capture_index);
+  for (i = 0; i < n_captures; i++) {
+    GST_CAMERA_BIN2_PROCESSING_INC (camerabin);
 
-  if (camerabin->mode == MODE_IMAGE) {
-    /* store the next capture buffer filename */
-    g_mutex_lock (&camerabin->image_capture_mutex);
-    camerabin->image_location_list =
-        g_slist_append (camerabin->image_location_list, g_strdup (location));
-    g_mutex_unlock (&camerabin->image_capture_mutex);
-  }
+    location = NULL;
+    if (camerabin->location)
+      location = g_strdup_printf (camerabin->location, capture_index + i);
 
-  if (camerabin->post_previews) {
-    /* Count processing of preview images too */
-    GST_CAMERA_BIN2_PROCESSING_INC (camerabin);
-    /* store the next preview filename */
-    g_mutex_lock (&camerabin->preview_list_mutex);
-    camerabin->preview_location_list =
-        g_slist_append (camerabin->preview_location_list, location);
-    g_mutex_unlock (&camerabin->preview_list_mutex);
-  } else {
-    g_free (location);
+    if (camerabin->mode == MODE_IMAGE) {
+      /* store the next capture buffer filename */
+      g_mutex_lock (&camerabin->image_capture_mutex);
+      camerabin->image_location_list =
+          g_slist_append (camerabin->image_location_list, g_strdup (location));
+      g_mutex_unlock (&camerabin->image_capture_mutex);
+    }
+
+    if (camerabin->post_previews) {
+      /* Count processing of preview images too */
+      GST_CAMERA_BIN2_PROCESSING_INC (camerabin);
+      /* store the next preview filename */
+      g_mutex_lock (&camerabin->preview_list_mutex);
+      camerabin->preview_location_list =
+          g_slist_append (camerabin->preview_location_list, location);
+      g_mutex_unlock (&camerabin->preview_list_mutex);
+    } else {
+      g_free (location);
+    }
   }
 
+  /* the ready-for-capture notification accounts for the first one */
+  camerabin->capture_index += n_captures - 1;
+
   g_signal_emit_by_name (camerabin->src, "start-capture", NULL);
   if (camerabin->mode == MODE_VIDEO) {
     camerabin->audio_send_newseg = TRUE;
@@ -410,9 +438,11 @@ gst_camera_bin_start_capture (GstCameraBin2 * camerabin)
     /* Store image tags in a list and push them later, this prevents
        start_capture() from blocking in pad_push_event call */
     g_mutex_lock (&camerabin->image_capture_mutex);
-    camerabin->image_tags_list =
-        g_slist_append (camerabin->image_tags_list,
-        taglist ? gst_tag_list_copy (taglist) : NULL);
+    for (i = 0; i < n_captures; i++) {
+      camerabin->image_tags_list =
+          g_slist_append (camerabin->image_tags_list,
+          taglist ? gst_tag_list_copy (taglist) : NULL);
+    }
     g_mutex_unlock (&camerabin->image_capture_mutex);
   } else if (taglist) {
     GstPad *active_pad;
@@ -822,6 +852,23 @@ gst_camera_bin_class_init (GstCameraBin2Class * klass)
           GST_TYPE_CAM_FLAGS, DEFAULT_FLAGS,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstCameraBin2:burst-count:
+   *
+   * Number of images taken by each image capture. Bursts are captured
+   * from the viewfinder stream without interrupting it, each frame still
+   * gets its own location, tags, preview and image-done message. The
+   * camera-source has to support it, this is forwarded to its
+   * burst-count property.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (object_class, PROP_BURST_COUNT,
+      g_param_spec_int ("burst-count", "Burst count",
+          "Number of images taken by each image capture (if supported by "
+          "the camera-source)", 1, G_MAXINT, DEFAULT_BURST_COUNT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /**
    * GstCameraBin2::capture-start:
    * @camera: the camera bin element
@@ -859,6 +906,7 @@ gst_camera_bin_init (GstCameraBin2 * camera)
   camera->zoom = DEFAULT_ZOOM;
   camera->max_zoom = MAX_ZOOM;
   camera->flags = DEFAULT_FLAGS;
+  camera->burst_count = DEFAULT_BURST_COUNT;
   g_mutex_init (&camera->preview_list_mutex);
   g_mutex_init (&camera->image_capture_mutex);
   g_mutex_init (&camera->video_capture_mutex);
@@ -1732,6 +1780,10 @@ gst_camera_bin_create_elements (GstCameraBin2 * camera)
           "preview-caps", camera->preview_caps, "preview-filter",
           camera->preview_filter, NULL);
     }
+    if (g_object_class_find_property (G_OBJECT_GET_CLASS (camera->src),
+            "burst-count")) {
+      g_object_set (camera->src, "burst-count", camera->burst_count, NULL);
+    }
     g_signal_connect (G_OBJECT (camera->src), "notify::zoom",
         (GCallback) gst_camera_bin_src_notify_zoom_cb, camera);
     g_object_set (camera->src, "zoom", camera->zoom, NULL);
@@ -2206,6 +2258,13 @@ gst_camera_bin_set_property (GObject * object, guint prop_id,
     case PROP_FLAGS:
       camera->flags = g_value_get_flags (value);
       break;
+    case PROP_BURST_COUNT:
+      camera->burst_count = g_value_get_int (value);
+      if (camera->src
+          && g_object_class_find_property (G_OBJECT_GET_CLASS (camera->src),
+              "burst-count"))
+        g_object_set (camera->src, "burst-count", camera->burst_count, NULL);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2385,6 +2444,9 @@ gst_camera_bin_get_property (GObject * object, guint prop_id,
     case PROP_FLAGS:
       g_value_set_flags (value, camera->flags);
       break;
+    case PROP_BURST_COUNT:
+      g_value_set_int (value, camera->burst_count);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
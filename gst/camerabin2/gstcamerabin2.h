@@ -147,6 +147,7 @@ struct _GstCameraBin2
   gfloat zoom;
   gfloat max_zoom;
   GstCamFlags flags;
+  gint burst_count;
 
   gboolean elements_created;
 };
@@ -43,9 +43,12 @@ enum
 {
   PROP_0,
   PROP_VIDEO_SRC,
-  PROP_VIDEO_SRC_FILTER
+  PROP_VIDEO_SRC_FILTER,
+  PROP_BURST_COUNT
 };
 
+#define DEFAULT_BURST_COUNT 1
+
 GST_DEBUG_CATEGORY (wrapper_camera_bin_src_debug);
 #define GST_CAT_DEFAULT wrapper_camera_bin_src_debug
 
@@ -91,6 +94,18 @@ gst_wrapper_camera_bin_src_dispose (GObject * object)
     gst_object_unref (self->video_tee_vf_pad);
     self->video_tee_vf_pad = NULL;
   }
+  if (self->burst_tee_sink) {
+    gst_object_unref (self->burst_tee_sink);
+    self->burst_tee_sink = NULL;
+  }
+  if (self->burst_tee_vf_pad) {
+    gst_object_unref (self->burst_tee_vf_pad);
+    self->burst_tee_vf_pad = NULL;
+  }
+  if (self->burst_tee_img_pad) {
+    gst_object_unref (self->burst_tee_img_pad);
+    self->burst_tee_img_pad = NULL;
+  }
   if (self->app_vid_src) {
     gst_object_unref (self->app_vid_src);
     self->app_vid_src = NULL;
@@ -147,6 +162,11 @@ gst_wrapper_camera_bin_src_set_property (GObject * object,
           gst_object_ref (self->app_vid_filter);
       }
       break;
+    case PROP_BURST_COUNT:
+      g_mutex_lock (&GST_BASE_CAMERA_SRC_CAST (self)->capturing_mutex);
+      self->burst_count = g_value_get_int (value);
+      g_mutex_unlock (&GST_BASE_CAMERA_SRC_CAST (self)->capturing_mutex);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (self, prop_id, pspec);
       break;
@@ -172,6 +192,11 @@ gst_wrapper_camera_bin_src_get_property (GObject * object,
       else
         g_value_set_object (value, self->app_vid_filter);
       break;
+    case PROP_BURST_COUNT:
+      g_mutex_lock (&GST_BASE_CAMERA_SRC_CAST (self)->capturing_mutex);
+      g_value_set_int (value, self->burst_count);
+      g_mutex_unlock (&GST_BASE_CAMERA_SRC_CAST (self)->capturing_mutex);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (self, prop_id, pspec);
       break;
@@ -280,7 +305,16 @@ gst_wrapper_camera_bin_src_imgsrc_probe (GstPad * pad, GstPadProbeInfo * info,
     gst_caps_unref (caps);
     gst_sample_unref (sample);
 
-    if (self->image_capture_count == 0) {
+    if (self->image_capture_count == 0 && self->burst_active) {
+      /* Burst done, stop teeing frames to the image pad. The viewfinder
+       * caps were never touched, so there is nothing to restore */
+      GST_DEBUG_OBJECT (self, "Finishing image burst");
+      self->burst_active = FALSE;
+      gst_ghost_pad_set_target (GST_GHOST_PAD (self->imgsrc), NULL);
+      gst_pad_unlink (self->src_pad, self->burst_tee_sink);
+      gst_ghost_pad_set_target (GST_GHOST_PAD (self->vfsrc), self->src_pad);
+      gst_base_camera_src_finish_capture (camerasrc);
+    } else if (self->image_capture_count == 0) {
       GstCaps *anycaps = gst_caps_new_any ();
 
       /* Get back to viewfinder */
@@ -538,6 +572,7 @@ gst_wrapper_camera_bin_src_construct_pipeline (GstBaseCameraSrc * bcamsrc)
   GstElement *src_csp;
   GstElement *capsfilter;
   GstElement *video_recording_tee;
+  GstElement *image_burst_tee;
   gboolean ret = FALSE;
   GstPad *tee_pad;
 
@@ -603,6 +638,16 @@ gst_wrapper_camera_bin_src_construct_pipeline (GstBaseCameraSrc * bcamsrc)
     gst_ghost_pad_set_target (GST_GHOST_PAD (self->vidsrc), tee_pad);
     gst_object_unref (tee_pad);
 
+    /* and another one used for image bursts, duplicating the viewfinder
+     * buffers to the imgsrc pad without any copy or renegotiation */
+    image_burst_tee = gst_element_factory_make ("tee", "image_burst_tee");
+    gst_bin_add (GST_BIN_CAST (self), image_burst_tee);
+    self->burst_tee_vf_pad =
+        gst_element_get_request_pad (image_burst_tee, "src_%u");
+    self->burst_tee_img_pad =
+        gst_element_get_request_pad (image_burst_tee, "src_%u");
+    self->burst_tee_sink = gst_element_get_static_pad (image_burst_tee, "sink");
+
     /* viewfinder pad */
     self->src_pad = gst_element_get_static_pad (self->digitalzoom, "src");
     gst_ghost_pad_set_target (GST_GHOST_PAD (self->vfsrc), self->src_pad);
@@ -794,6 +839,27 @@ start_image_capture (GstPad * pad, GstPadProbeInfo * info, gpointer udata)
   return GST_PAD_PROBE_REMOVE;
 }
 
+static GstPadProbeReturn
+start_image_burst (GstPad * pad, GstPadProbeInfo * info, gpointer udata)
+{
+  GstWrapperCameraBinSrc *self = udata;
+
+  GST_DEBUG_OBJECT (self, "Starting burst of %d images",
+      self->image_capture_count);
+
+  /* keep the viewfinder running at its current caps and tee the same
+   * buffers to the imgsrc pad until the burst is over */
+  gst_wrapper_camera_bin_src_set_output (self, self->vfsrc, NULL);
+  gst_pad_link (self->src_pad, self->burst_tee_sink);
+  gst_ghost_pad_set_target (GST_GHOST_PAD (self->vfsrc),
+      self->burst_tee_vf_pad);
+  gst_ghost_pad_set_target (GST_GHOST_PAD (self->imgsrc),
+      self->burst_tee_img_pad);
+
+  self->image_capture_probe = 0;
+  return GST_PAD_PROBE_REMOVE;
+}
+
 static GstPadProbeReturn
 start_video_capture (GstPad * pad, GstPadProbeInfo * info, gpointer udata)
 {
@@ -1013,7 +1079,14 @@ gst_wrapper_camera_bin_src_start_capture (GstBaseCameraSrc * camerasrc)
   pad = gst_element_get_static_pad (src->src_vid_src, "src");
 
   /* TODO should we access this directly? Maybe a macro is better? */
-  if (src->mode == MODE_IMAGE) {
+  if (src->mode == MODE_IMAGE && src->burst_count > 1) {
+    src->image_capture_count = src->burst_count;
+    src->burst_active = TRUE;
+
+    src->image_capture_probe =
+        gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_IDLE, start_image_burst,
+        src, NULL);
+  } else if (src->mode == MODE_IMAGE) {
     src->image_capture_count = 1;
 
     src->image_capture_probe =
@@ -1110,6 +1183,24 @@ gst_wrapper_camera_bin_src_class_init (GstWrapperCameraBinSrcClass * klass)
           "Optional video source filter element",
           GST_TYPE_ELEMENT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstWrapperCameraBinSrc:burst-count:
+   *
+   * Number of consecutive frames captured for each image capture request.
+   * When larger than 1, the frames are taken from the viewfinder stream at
+   * the viewfinder caps: the same buffers are shared between the
+   * viewfinder and the imgsrc pad, the viewfinder keeps running and no
+   * image capture caps renegotiation or #GstPhotography preparation
+   * happens for the shots.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_BURST_COUNT,
+      g_param_spec_int ("burst-count", "Burst count",
+          "Number of viewfinder frames captured per image capture request",
+          1, G_MAXINT, DEFAULT_BURST_COUNT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state = gst_wrapper_camera_bin_src_change_state;
 
   gstbasecamerasrc_class->construct_pipeline =
@@ -1163,6 +1254,7 @@ gst_wrapper_camera_bin_src_init (GstWrapperCameraBinSrc * self)
 
   /* TODO where are variables reset? */
   self->image_capture_count = 0;
+  self->burst_count = DEFAULT_BURST_COUNT;
   self->video_rec_status = GST_VIDEO_RECORDING_STATUS_DONE;
   self->video_renegotiate = TRUE;
   self->image_renegotiate = TRUE;
@@ -73,6 +73,8 @@ struct _GstWrapperCameraBinSrc
 
   /* image capture controls */
   gint image_capture_count;
+  gint burst_count;
+  gboolean burst_active;
 
   /* source elements */
   GstElement *src_vid_src;
@@ -87,6 +89,10 @@ struct _GstWrapperCameraBinSrc
   GstPad *video_tee_vf_pad;
   GstPad *video_tee_sink;
 
+  GstPad *burst_tee_vf_pad;
+  GstPad *burst_tee_img_pad;
+  GstPad *burst_tee_sink;
+
   gboolean elements_created;
 
   gulong src_event_probe_id;
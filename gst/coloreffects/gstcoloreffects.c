@@ -28,6 +28,15 @@
  * gst-launch-1.0 -v videotestsrc ! coloreffects preset=heat ! videoconvert !
  *     autovideosink
  * ]| This pipeline shows the effect of coloreffects on a test stream.
+ * |[
+ * gst-launch-1.0 -v videotestsrc ! video/x-raw,format=I420 !
+ *     coloreffects lut-file=grade.cube n-threads=0 ! autovideosink
+ * ]| This pipeline applies a 3D LUT from a .cube file, using all CPUs.
+ *
+ * Since 1.20 a 3D LUT can be loaded from a .cube file with the
+ * #GstColorEffects:lut-file property. It is applied to the RGB, AYUV and
+ * 4:2:0 formats directly, without conversion: for Y'CbCr formats the LUT is
+ * resampled once onto a Y'CbCr grid using the colorimetry of the stream.
  *
  */
 
@@ -39,6 +48,14 @@
 #include "gstcoloreffects.h"
 
 #define DEFAULT_PROP_PRESET GST_COLOR_EFFECTS_PRESET_NONE
+#define DEFAULT_PROP_LUT_FILE NULL
+#define DEFAULT_PROP_INTERPOLATION GST_COLOR_LUT_INTERPOLATION_TETRAHEDRAL
+#define DEFAULT_PROP_N_THREADS 1
+
+/* grid size used to apply the presets to the 4:2:0 formats */
+#define PRESET_LUT_SIZE 65
+
+#define MIN_ROWS_PER_JOB 16
 
 GST_DEBUG_CATEGORY_STATIC (coloreffects_debug);
 #define GST_CAT_DEFAULT (coloreffects_debug)
@@ -46,14 +63,18 @@ GST_DEBUG_CATEGORY_STATIC (coloreffects_debug);
 enum
 {
   PROP_0,
-  PROP_PRESET
+  PROP_PRESET,
+  PROP_LUT_FILE,
+  PROP_INTERPOLATION,
+  PROP_N_THREADS
 };
 
 #define gst_color_effects_parent_class parent_class
 G_DEFINE_TYPE (GstColorEffects, gst_color_effects, GST_TYPE_VIDEO_FILTER);
 
 #define CAPS_STR GST_VIDEO_CAPS_MAKE ("{ " \
-    "ARGB, BGRA, ABGR, RGBA, xRGB, BGRx, xBGR, RGBx, RGB, BGR, AYUV }")
+    "ARGB, BGRA, ABGR, RGBA, xRGB, BGRx, xBGR, RGBx, RGB, BGR, AYUV, " \
+    "I420, YV12, NV12, NV21 }")
 
 static GstStaticPadTemplate gst_color_effects_src_template =
 GST_STATIC_PAD_TEMPLATE ("src",
@@ -93,6 +114,29 @@ gst_color_effects_preset_get_type (void)
   return preset_type;
 }
 
+#define GST_TYPE_COLOR_EFFECTS_INTERPOLATION \
+  (gst_color_effects_interpolation_get_type())
+static GType
+gst_color_effects_interpolation_get_type (void)
+{
+  static GType interpolation_type = 0;
+
+  static const GEnumValue interpolations[] = {
+    {GST_COLOR_LUT_INTERPOLATION_TRILINEAR, "Trilinear interpolation",
+        "trilinear"},
+    {GST_COLOR_LUT_INTERPOLATION_TETRAHEDRAL, "Tetrahedral interpolation",
+        "tetrahedral"},
+    {0, NULL, NULL},
+  };
+
+  if (!interpolation_type) {
+    interpolation_type =
+        g_enum_register_static ("GstColorEffectsInterpolation",
+        interpolations);
+  }
+  return interpolation_type;
+}
+
 /*
  * Currently hardcoded tables, in the future may be nice to load them
  * from a file or just leave these as default presets and add a
@@ -300,10 +344,10 @@ static const gint cog_rgb_to_ycbcr_matrix_8bit_sdtv[] = {
 
 static void
 gst_color_effects_transform_rgb (GstColorEffects * filter,
-    GstVideoFrame * frame)
+    GstVideoFrame * frame, gint y_start, gint y_end)
 {
   gint i, j;
-  gint width, height;
+  gint width;
   gint pixel_stride, row_stride, row_wrap;
   guint32 r, g, b;
   guint32 luma;
@@ -316,15 +360,16 @@ gst_color_effects_transform_rgb (GstColorEffects * filter,
   offsets[2] = GST_VIDEO_FRAME_COMP_POFFSET (frame, 2);
 
   width = GST_VIDEO_FRAME_WIDTH (frame);
-  height = GST_VIDEO_FRAME_HEIGHT (frame);
 
   row_stride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
   pixel_stride = GST_VIDEO_FRAME_COMP_PSTRIDE (frame, 0);
   row_wrap = row_stride - pixel_stride * width;
 
+  data += y_start * row_stride;
+
   /* transform */
 
-  for (i = 0; i < height; i++) {
+  for (i = y_start; i < y_end; i++) {
     for (j = 0; j < width; j++) {
       r = data[offsets[0]];
       g = data[offsets[1]];
@@ -358,10 +403,10 @@ gst_color_effects_transform_rgb (GstColorEffects * filter,
 
 static void
 gst_color_effects_transform_ayuv (GstColorEffects * filter,
-    GstVideoFrame * frame)
+    GstVideoFrame * frame, gint y_start, gint y_end)
 {
   gint i, j;
-  gint width, height;
+  gint width;
   gint pixel_stride, row_stride, row_wrap;
   gint r, g, b;
   gint y, u, v;
@@ -374,13 +419,14 @@ gst_color_effects_transform_ayuv (GstColorEffects * filter,
   offsets[2] = GST_VIDEO_FRAME_COMP_POFFSET (frame, 2);
 
   width = GST_VIDEO_FRAME_WIDTH (frame);
-  height = GST_VIDEO_FRAME_HEIGHT (frame);
 
   row_stride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
   pixel_stride = GST_VIDEO_FRAME_COMP_PSTRIDE (frame, 0);
   row_wrap = row_stride - pixel_stride * width;
 
-  for (i = 0; i < height; i++) {
+  data += y_start * row_stride;
+
+  for (i = y_start; i < y_end; i++) {
     for (j = 0; j < width; j++) {
       y = data[offsets[0]];
       u = data[offsets[1]];
@@ -432,6 +478,264 @@ gst_color_effects_transform_ayuv (GstColorEffects * filter,
   }
 }
 
+static void
+gst_color_effects_transform_lut_packed (GstColorEffects * filter,
+    GstVideoFrame * frame, gint y_start, gint y_end)
+{
+  gint i;
+  gint width, pixel_stride, row_stride;
+  gint offsets[3];
+  guint8 *data;
+
+  data = GST_VIDEO_FRAME_PLANE_DATA (frame, 0);
+  offsets[0] = GST_VIDEO_FRAME_COMP_POFFSET (frame, 0);
+  offsets[1] = GST_VIDEO_FRAME_COMP_POFFSET (frame, 1);
+  offsets[2] = GST_VIDEO_FRAME_COMP_POFFSET (frame, 2);
+
+  width = GST_VIDEO_FRAME_WIDTH (frame);
+  row_stride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
+  pixel_stride = GST_VIDEO_FRAME_COMP_PSTRIDE (frame, 0);
+
+  for (i = y_start; i < y_end; i++) {
+    gst_color_lut_table_apply_packed (filter->lut_table,
+        filter->interpolation, data + i * row_stride, pixel_stride, offsets,
+        width);
+  }
+}
+
+/* y_start is always even */
+static void
+gst_color_effects_transform_lut_420 (GstColorEffects * filter,
+    GstVideoFrame * frame, gint y_start, gint y_end)
+{
+  gint i;
+  gint width, height;
+  gint y_stride, u_stride, v_stride, uv_pstride;
+  guint8 *y_data, *u_data, *v_data;
+
+  y_data = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
+  u_data = GST_VIDEO_FRAME_COMP_DATA (frame, 1);
+  v_data = GST_VIDEO_FRAME_COMP_DATA (frame, 2);
+  y_stride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
+  u_stride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 1);
+  v_stride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 2);
+  uv_pstride = GST_VIDEO_FRAME_COMP_PSTRIDE (frame, 1);
+
+  width = GST_VIDEO_FRAME_WIDTH (frame);
+  height = GST_VIDEO_FRAME_HEIGHT (frame);
+
+  for (i = y_start; i < y_end; i += 2) {
+    guint8 *y0 = y_data + i * y_stride;
+    guint8 *y1 = i + 1 < height ? y0 + y_stride : NULL;
+
+    gst_color_lut_table_apply_420 (filter->lut_table, filter->interpolation,
+        y0, y1, u_data + (i >> 1) * u_stride, v_data + (i >> 1) * v_stride,
+        uv_pstride, width);
+  }
+}
+
+typedef struct
+{
+  GstColorEffects *filter;
+  GstVideoFrame *frame;
+  void (*process) (GstColorEffects * filter, GstVideoFrame * frame,
+      gint y_start, gint y_end);
+  gint y_start, y_end;
+} GstColorEffectsJob;
+
+static void
+gst_color_effects_job (gpointer data, gpointer user_data)
+{
+  GstColorEffectsJob *job = data;
+  GstColorEffects *filter = job->filter;
+
+  job->process (filter, job->frame, job->y_start, job->y_end);
+
+  g_mutex_lock (&filter->jobs_lock);
+  if (--filter->jobs_pending == 0)
+    g_cond_signal (&filter->jobs_cond);
+  g_mutex_unlock (&filter->jobs_lock);
+}
+
+/* splits the frame in slices of lines processed in parallel, must be called
+ * with the object lock */
+static void
+gst_color_effects_process (GstColorEffects * filter, GstVideoFrame * frame,
+    void (*process) (GstColorEffects * filter, GstVideoFrame * frame,
+        gint y_start, gint y_end))
+{
+  GstColorEffectsJob *jobs;
+  guint n_jobs, i;
+  gint rows;
+
+  n_jobs = filter->n_threads;
+  if (n_jobs == 0)
+    n_jobs = g_get_num_processors ();
+  n_jobs = CLAMP (filter->height / MIN_ROWS_PER_JOB, 1, n_jobs);
+
+  if (n_jobs == 1) {
+    process (filter, frame, 0, filter->height);
+    return;
+  }
+
+  if (filter->pool == NULL) {
+    filter->pool = g_thread_pool_new (gst_color_effects_job, NULL, -1, FALSE,
+        NULL);
+  }
+
+  jobs = g_newa (GstColorEffectsJob, n_jobs);
+  /* keep slices on chroma line boundaries for the 4:2:0 formats */
+  rows = (filter->height + n_jobs - 1) / n_jobs;
+  rows = GST_ROUND_UP_2 (rows);
+
+  for (i = 0; i < n_jobs; i++) {
+    jobs[i].filter = filter;
+    jobs[i].frame = frame;
+    jobs[i].process = process;
+    jobs[i].y_start = MIN (i * rows, filter->height);
+    jobs[i].y_end = MIN ((i + 1) * rows, filter->height);
+  }
+
+  filter->jobs_pending = n_jobs - 1;
+  for (i = 1; i < n_jobs; i++)
+    g_thread_pool_push (filter->pool, &jobs[i], NULL);
+
+  /* do the first slice from the streaming thread */
+  process (filter, frame, jobs[0].y_start, jobs[0].y_end);
+
+  g_mutex_lock (&filter->jobs_lock);
+  while (filter->jobs_pending > 0)
+    g_cond_wait (&filter->jobs_cond, &filter->jobs_lock);
+  g_mutex_unlock (&filter->jobs_lock);
+}
+
+typedef struct
+{
+  const GstColorLut *lut;
+  const guint8 *table;
+  gboolean map_luma;
+
+  /* set when the grid is indexed by Y'CbCr instead of R'G'B' */
+  gboolean yuv;
+  gdouble Kr, Kb;
+  gint offset[GST_VIDEO_MAX_COMPONENTS];
+  gint scale[GST_VIDEO_MAX_COMPONENTS];
+} GstColorEffectsSampler;
+
+static void
+gst_color_effects_sample (const gfloat in[3], gfloat out[3],
+    gpointer user_data)
+{
+  const GstColorEffectsSampler *sampler = user_data;
+  gfloat rgb[3];
+  gint c;
+
+  if (sampler->yuv) {
+    gdouble y, pb, pr, r, g, b;
+
+    y = (in[0] - sampler->offset[0]) / sampler->scale[0];
+    pb = (in[1] - sampler->offset[1]) / sampler->scale[1];
+    pr = (in[2] - sampler->offset[2]) / sampler->scale[2];
+
+    r = y + 2.0 * (1.0 - sampler->Kr) * pr;
+    b = y + 2.0 * (1.0 - sampler->Kb) * pb;
+    g = (y - sampler->Kr * r - sampler->Kb * b) /
+        (1.0 - sampler->Kr - sampler->Kb);
+
+    rgb[0] = CLAMP (r, 0.0, 1.0) * 255.0;
+    rgb[1] = CLAMP (g, 0.0, 1.0) * 255.0;
+    rgb[2] = CLAMP (b, 0.0, 1.0) * 255.0;
+  } else {
+    rgb[0] = in[0];
+    rgb[1] = in[1];
+    rgb[2] = in[2];
+  }
+
+  if (sampler->lut) {
+    gst_color_lut_sample (sampler->lut, rgb, out);
+  } else {
+    guint r = rgb[0] + 0.5f, g = rgb[1] + 0.5f, b = rgb[2] + 0.5f;
+
+    if (sampler->map_luma) {
+      /* same as gst_color_effects_transform_rgb() */
+      guint32 luma = ((r << 8) * 54) + ((g << 8) * 183) + ((b << 8) * 19);
+
+      luma = (luma >> 16) * 3;
+      for (c = 0; c < 3; c++)
+        out[c] = sampler->table[luma + c];
+    } else {
+      out[0] = sampler->table[r * 3];
+      out[1] = sampler->table[g * 3 + 1];
+      out[2] = sampler->table[b * 3 + 2];
+    }
+  }
+
+  if (sampler->yuv) {
+    gdouble r = out[0] / 255.0, g = out[1] / 255.0, b = out[2] / 255.0;
+    gdouble y, pb, pr;
+
+    y = sampler->Kr * r + (1.0 - sampler->Kr - sampler->Kb) * g +
+        sampler->Kb * b;
+    pb = (b - y) / (2.0 * (1.0 - sampler->Kb));
+    pr = (r - y) / (2.0 * (1.0 - sampler->Kr));
+
+    out[0] = sampler->offset[0] + y * sampler->scale[0];
+    out[1] = sampler->offset[1] + pb * sampler->scale[1];
+    out[2] = sampler->offset[2] + pr * sampler->scale[2];
+  }
+}
+
+/* (re)builds the grid applied to the frames, must be called with the object
+ * lock */
+static gboolean
+gst_color_effects_update_lut (GstColorEffects * filter, GError ** error)
+{
+  GstColorEffectsSampler sampler = { NULL, };
+  guint size;
+
+  gst_color_lut_table_free (filter->lut_table);
+  filter->lut_table = NULL;
+
+  if (filter->lut_file && !filter->lut) {
+    GST_DEBUG_OBJECT (filter, "loading 3D LUT from %s", filter->lut_file);
+    filter->lut = gst_color_lut_new_from_cube_file (filter->lut_file, error);
+    if (!filter->lut)
+      return FALSE;
+  }
+
+  if (filter->lut) {
+    sampler.lut = filter->lut;
+    size = filter->lut->size;
+  } else if (filter->table && !filter->process) {
+    /* preset on a format the 1D tables can't be applied to */
+    sampler.table = filter->table;
+    sampler.map_luma = filter->map_luma;
+    size = PRESET_LUT_SIZE;
+  } else {
+    filter->lut_dirty = FALSE;
+    return TRUE;
+  }
+
+  if (GST_VIDEO_INFO_IS_YUV (&filter->info)) {
+    sampler.yuv = TRUE;
+    if (!gst_video_color_matrix_get_Kr_Kb (filter->info.colorimetry.matrix,
+            &sampler.Kr, &sampler.Kb)) {
+      gst_video_color_matrix_get_Kr_Kb (GST_VIDEO_COLOR_MATRIX_BT601,
+          &sampler.Kr, &sampler.Kb);
+    }
+    gst_video_color_range_offsets (filter->info.colorimetry.range,
+        filter->info.finfo, sampler.offset, sampler.scale);
+  }
+
+  GST_DEBUG_OBJECT (filter, "building %u^3 %s grid", size,
+      sampler.yuv ? "Y'CbCr" : "R'G'B'");
+  filter->lut_table = gst_color_lut_table_new (size,
+      gst_color_effects_sample, &sampler);
+  filter->lut_dirty = FALSE;
+
+  return TRUE;
+}
+
 static gboolean
 gst_color_effects_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
     GstVideoInfo * in_info, GstCaps * outcaps, GstVideoInfo * out_info)
@@ -442,7 +746,9 @@ gst_color_effects_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
       "in %" GST_PTR_FORMAT " out %" GST_PTR_FORMAT, incaps, outcaps);
 
   filter->process = NULL;
+  filter->lut_process = NULL;
 
+  filter->info = *in_info;
   filter->format = GST_VIDEO_INFO_FORMAT (in_info);
   filter->width = GST_VIDEO_INFO_WIDTH (in_info);
   filter->height = GST_VIDEO_INFO_HEIGHT (in_info);
@@ -452,6 +758,7 @@ gst_color_effects_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
   switch (filter->format) {
     case GST_VIDEO_FORMAT_AYUV:
       filter->process = gst_color_effects_transform_ayuv;
+      filter->lut_process = gst_color_effects_transform_lut_packed;
       break;
     case GST_VIDEO_FORMAT_ARGB:
     case GST_VIDEO_FORMAT_ABGR:
@@ -464,14 +771,24 @@ gst_color_effects_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
     case GST_VIDEO_FORMAT_RGB:
     case GST_VIDEO_FORMAT_BGR:
       filter->process = gst_color_effects_transform_rgb;
+      filter->lut_process = gst_color_effects_transform_lut_packed;
+      break;
+    case GST_VIDEO_FORMAT_I420:
+    case GST_VIDEO_FORMAT_YV12:
+    case GST_VIDEO_FORMAT_NV12:
+    case GST_VIDEO_FORMAT_NV21:
+      filter->lut_process = gst_color_effects_transform_lut_420;
       break;
     default:
       break;
   }
 
+  /* the grid depends on the format and colorimetry */
+  filter->lut_dirty = TRUE;
+
   GST_OBJECT_UNLOCK (filter);
 
-  return filter->process != NULL;
+  return filter->lut_process != NULL;
 }
 
 static GstFlowReturn
@@ -479,16 +796,22 @@ gst_color_effects_transform_frame_ip (GstVideoFilter * vfilter,
     GstVideoFrame * out)
 {
   GstColorEffects *filter = GST_COLOR_EFFECTS (vfilter);
+  GError *err = NULL;
 
-  if (!filter->process)
+  if (!filter->lut_process)
     goto not_negotiated;
 
-  /* do nothing if there is no table ("none" preset) */
-  if (filter->table == NULL)
-    return GST_FLOW_OK;
-
   GST_OBJECT_LOCK (filter);
-  filter->process (filter, out);
+
+  if (filter->lut_dirty && !gst_color_effects_update_lut (filter, &err))
+    goto lut_error;
+
+  if (filter->lut_table)
+    gst_color_effects_process (filter, out, filter->lut_process);
+  else if (filter->table)
+    gst_color_effects_process (filter, out, filter->process);
+  /* else do nothing, there is no table ("none" preset) */
+
   GST_OBJECT_UNLOCK (filter);
 
   return GST_FLOW_OK;
@@ -496,6 +819,15 @@ gst_color_effects_transform_frame_ip (GstVideoFilter * vfilter,
 not_negotiated:
   GST_ERROR_OBJECT (filter, "Not negotiated yet");
   return GST_FLOW_NOT_NEGOTIATED;
+
+lut_error:
+  {
+    GST_OBJECT_UNLOCK (filter);
+    GST_ELEMENT_ERROR (filter, RESOURCE, OPEN_READ,
+        ("Could not load 3D LUT"), ("%s", err->message));
+    g_clear_error (&err);
+    return GST_FLOW_ERROR;
+  }
 }
 
 static void
@@ -537,6 +869,26 @@ gst_color_effects_set_property (GObject * object, guint prop_id,
           g_assert_not_reached ();
 
       }
+      filter->lut_dirty = TRUE;
+      GST_OBJECT_UNLOCK (filter);
+      break;
+    case PROP_LUT_FILE:
+      GST_OBJECT_LOCK (filter);
+      g_free (filter->lut_file);
+      filter->lut_file = g_value_dup_string (value);
+      gst_color_lut_free (filter->lut);
+      filter->lut = NULL;
+      filter->lut_dirty = TRUE;
+      GST_OBJECT_UNLOCK (filter);
+      break;
+    case PROP_INTERPOLATION:
+      GST_OBJECT_LOCK (filter);
+      filter->interpolation = g_value_get_enum (value);
+      GST_OBJECT_UNLOCK (filter);
+      break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      filter->n_threads = g_value_get_uint (value);
       GST_OBJECT_UNLOCK (filter);
       break;
     default:
@@ -557,12 +909,44 @@ gst_color_effects_get_property (GObject * object, guint prop_id, GValue * value,
       g_value_set_enum (value, filter->preset);
       GST_OBJECT_UNLOCK (filter);
       break;
+    case PROP_LUT_FILE:
+      GST_OBJECT_LOCK (filter);
+      g_value_set_string (value, filter->lut_file);
+      GST_OBJECT_UNLOCK (filter);
+      break;
+    case PROP_INTERPOLATION:
+      GST_OBJECT_LOCK (filter);
+      g_value_set_enum (value, filter->interpolation);
+      GST_OBJECT_UNLOCK (filter);
+      break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      g_value_set_uint (value, filter->n_threads);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+static void
+gst_color_effects_finalize (GObject * object)
+{
+  GstColorEffects *filter = GST_COLOR_EFFECTS (object);
+
+  if (filter->pool)
+    g_thread_pool_free (filter->pool, FALSE, TRUE);
+  g_mutex_clear (&filter->jobs_lock);
+  g_cond_clear (&filter->jobs_cond);
+
+  g_free (filter->lut_file);
+  gst_color_lut_free (filter->lut);
+  gst_color_lut_table_free (filter->lut_table);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gst_color_effects_class_init (GstColorEffectsClass * klass)
 {
@@ -575,12 +959,52 @@ gst_color_effects_class_init (GstColorEffectsClass * klass)
 
   gobject_class->set_property = gst_color_effects_set_property;
   gobject_class->get_property = gst_color_effects_get_property;
+  gobject_class->finalize = gst_color_effects_finalize;
 
   g_object_class_install_property (gobject_class, PROP_PRESET,
       g_param_spec_enum ("preset", "Preset", "Color effect preset to use",
           GST_TYPE_COLOR_EFFECTS_PRESET, DEFAULT_PROP_PRESET,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstColorEffects:lut-file:
+   *
+   * Path to a .cube file containing a 3D LUT to apply instead of the preset.
+   * The file is loaded when the next frame is processed.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_LUT_FILE,
+      g_param_spec_string ("lut-file", "LUT file",
+          "Path to a .cube 3D LUT to apply instead of the preset",
+          DEFAULT_PROP_LUT_FILE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstColorEffects:interpolation:
+   *
+   * Interpolation used between the points of the 3D LUT grid.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_INTERPOLATION,
+      g_param_spec_enum ("interpolation", "Interpolation",
+          "Interpolation used to apply the 3D LUT",
+          GST_TYPE_COLOR_EFFECTS_INTERPOLATION, DEFAULT_PROP_INTERPOLATION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstColorEffects:n-threads:
+   *
+   * Maximum number of threads processing slices of the frame, 0 means one
+   * thread per CPU.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use", 0, G_MAXUINT,
+          DEFAULT_PROP_N_THREADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   vfilter_class->set_info = GST_DEBUG_FUNCPTR (gst_color_effects_set_info);
   vfilter_class->transform_frame_ip =
       GST_DEBUG_FUNCPTR (gst_color_effects_transform_frame_ip);
@@ -596,6 +1020,7 @@ gst_color_effects_class_init (GstColorEffectsClass * klass)
       &gst_color_effects_src_template);
 
   gst_type_mark_as_plugin_api (GST_TYPE_COLOR_EFFECTS_PRESET, 0);
+  gst_type_mark_as_plugin_api (GST_TYPE_COLOR_EFFECTS_INTERPOLATION, 0);
 }
 
 static void
@@ -604,4 +1029,9 @@ gst_color_effects_init (GstColorEffects * filter)
   filter->preset = GST_COLOR_EFFECTS_PRESET_NONE;
   filter->table = NULL;
   filter->map_luma = TRUE;
+  filter->lut_file = DEFAULT_PROP_LUT_FILE;
+  filter->interpolation = DEFAULT_PROP_INTERPOLATION;
+  filter->n_threads = DEFAULT_PROP_N_THREADS;
+  g_mutex_init (&filter->jobs_lock);
+  g_cond_init (&filter->jobs_cond);
 }
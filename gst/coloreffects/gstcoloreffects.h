@@ -24,6 +24,8 @@
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
 
+#include "gstcolorlut.h"
+
 G_BEGIN_DECLS
 #define GST_TYPE_COLOR_EFFECTS \
   (gst_color_effects_get_type())
@@ -73,12 +75,33 @@ struct _GstColorEffects
   const guint8 *table;
   gboolean map_luma;
 
+  /* 3D LUT loaded from lut_file, overriding the preset */
+  gchar *lut_file;
+  GstColorLut *lut;
+  GstColorLutInterpolation interpolation;
+
+  /* grid applied to the frames, built from the 3D LUT or, for formats the
+   * preset tables can't be applied to directly, from the preset */
+  GstColorLutTable *lut_table;
+  gboolean lut_dirty;
+
   /* video format */
   GstVideoFormat format;
+  GstVideoInfo info;
   gint width;
   gint height;
 
-  void (*process) (GstColorEffects * filter, GstVideoFrame * frame);
+  void (*process) (GstColorEffects * filter, GstVideoFrame * frame,
+      gint y_start, gint y_end);
+  void (*lut_process) (GstColorEffects * filter, GstVideoFrame * frame,
+      gint y_start, gint y_end);
+
+  /* worker threads processing slices of lines */
+  guint n_threads;
+  GThreadPool *pool;
+  GMutex jobs_lock;
+  GCond jobs_cond;
+  guint jobs_pending;
 };
 
 struct _GstColorEffectsClass
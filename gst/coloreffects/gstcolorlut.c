@@ -0,0 +1,474 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "gstcolorlut.h"
+
+#define MAX_LUT_SIZE 256
+
+static gboolean
+parse_floats (const gchar * str, gfloat * values, guint n_values)
+{
+  guint i;
+
+  for (i = 0; i < n_values; i++) {
+    gchar *end;
+
+    values[i] = g_ascii_strtod (str, &end);
+    if (end == str)
+      return FALSE;
+    str = end;
+  }
+
+  while (g_ascii_isspace (*str))
+    str++;
+
+  return *str == '\0';
+}
+
+/* Parses an Adobe/Resolve .cube file. Only 3D LUTs are supported, unknown
+ * keywords are ignored. */
+GstColorLut *
+gst_color_lut_new_from_cube_file (const gchar * filename, GError ** error)
+{
+  GstColorLut *lut;
+  gchar *contents;
+  gchar **lines;
+  guint i, n_entries = 0, n_values = 0;
+
+  if (!g_file_get_contents (filename, &contents, NULL, error))
+    return NULL;
+
+  lut = g_new0 (GstColorLut, 1);
+  lut->domain_max[0] = lut->domain_max[1] = lut->domain_max[2] = 1.0f;
+
+  lines = g_strsplit (contents, "\n", -1);
+  g_free (contents);
+
+  for (i = 0; lines[i]; i++) {
+    gchar *line = g_strstrip (lines[i]);
+
+    if (line[0] == '\0' || line[0] == '#')
+      continue;
+
+    if (g_ascii_isdigit (line[0]) || line[0] == '-' || line[0] == '+'
+        || line[0] == '.') {
+      if (lut->data == NULL)
+        goto no_size;
+      if (n_values == n_entries)
+        goto too_many_entries;
+      if (!parse_floats (line, &lut->data[n_values * 3], 3))
+        goto invalid_line;
+      n_values++;
+    } else if (g_str_has_prefix (line, "LUT_3D_SIZE")) {
+      gchar *end;
+      guint64 size;
+
+      if (lut->data != NULL)
+        goto invalid_line;
+
+      size = g_ascii_strtoull (line + strlen ("LUT_3D_SIZE"), &end, 10);
+      if (size < 2 || size > MAX_LUT_SIZE)
+        goto invalid_line;
+
+      lut->size = size;
+      n_entries = lut->size * lut->size * lut->size;
+      lut->data = g_new (gfloat, n_entries * 3);
+    } else if (g_str_has_prefix (line, "LUT_1D_SIZE")) {
+      goto not_3d;
+    } else if (g_str_has_prefix (line, "DOMAIN_MIN")) {
+      if (!parse_floats (line + strlen ("DOMAIN_MIN"), lut->domain_min, 3))
+        goto invalid_line;
+    } else if (g_str_has_prefix (line, "DOMAIN_MAX")) {
+      if (!parse_floats (line + strlen ("DOMAIN_MAX"), lut->domain_max, 3))
+        goto invalid_line;
+    } else if (g_str_has_prefix (line, "LUT_3D_INPUT_RANGE")) {
+      gfloat range[2];
+
+      if (!parse_floats (line + strlen ("LUT_3D_INPUT_RANGE"), range, 2))
+        goto invalid_line;
+      lut->domain_min[0] = lut->domain_min[1] = lut->domain_min[2] = range[0];
+      lut->domain_max[0] = lut->domain_max[1] = lut->domain_max[2] = range[1];
+    }
+  }
+
+  if (lut->data == NULL)
+    goto no_size;
+  if (n_values != n_entries)
+    goto not_enough_entries;
+
+  for (i = 0; i < 3; i++) {
+    if (!(lut->domain_max[i] > lut->domain_min[i]))
+      goto invalid_domain;
+  }
+
+  g_strfreev (lines);
+
+  return lut;
+
+  /* ERRORS */
+no_size:
+  {
+    g_set_error (error, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_READ,
+        "%s: no LUT_3D_SIZE before the table data", filename);
+    goto error;
+  }
+not_3d:
+  {
+    g_set_error (error, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_READ,
+        "%s: 1D LUTs are not supported", filename);
+    goto error;
+  }
+too_many_entries:
+  {
+    g_set_error (error, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_READ,
+        "%s: more than %u table entries", filename, n_entries);
+    goto error;
+  }
+not_enough_entries:
+  {
+    g_set_error (error, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_READ,
+        "%s: %u table entries instead of %u", filename, n_values, n_entries);
+    goto error;
+  }
+invalid_line:
+  {
+    g_set_error (error, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_READ,
+        "%s:%u: invalid line '%s'", filename, i + 1, lines[i]);
+    goto error;
+  }
+invalid_domain:
+  {
+    g_set_error (error, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_READ,
+        "%s: invalid input domain", filename);
+    goto error;
+  }
+error:
+  {
+    g_strfreev (lines);
+    gst_color_lut_free (lut);
+    return NULL;
+  }
+}
+
+void
+gst_color_lut_free (GstColorLut * lut)
+{
+  if (lut == NULL)
+    return;
+
+  g_free (lut->data);
+  g_free (lut);
+}
+
+/* trilinear lookup of @rgb, in the 0..255 range, into @lut */
+void
+gst_color_lut_sample (const GstColorLut * lut, const gfloat rgb[3],
+    gfloat out[3])
+{
+  const gfloat *c000;
+  guint idx[3], stride[3];
+  gfloat frac[3];
+  guint c, i;
+
+  stride[0] = 3;
+  stride[1] = 3 * lut->size;
+  stride[2] = 3 * lut->size * lut->size;
+
+  for (c = 0; c < 3; c++) {
+    gfloat pos = (rgb[c] / 255.0f - lut->domain_min[c]) /
+        (lut->domain_max[c] - lut->domain_min[c]);
+
+    pos = CLAMP (pos, 0.0f, 1.0f) * (lut->size - 1);
+    idx[c] = MIN ((guint) pos, lut->size - 2);
+    frac[c] = pos - idx[c];
+  }
+
+  c000 = lut->data + idx[0] * stride[0] + idx[1] * stride[1] +
+      idx[2] * stride[2];
+
+  for (i = 0; i < 3; i++) {
+    const gfloat *p = c000 + i;
+    gfloat c00, c01, c10, c11, c0, c1;
+
+    c00 = p[0] + (p[stride[0]] - p[0]) * frac[0];
+    c01 = p[stride[2]] + (p[stride[2] + stride[0]] - p[stride[2]]) * frac[0];
+    c10 = p[stride[1]] + (p[stride[1] + stride[0]] - p[stride[1]]) * frac[0];
+    c11 = p[stride[1] + stride[2]] +
+        (p[stride[1] + stride[2] + stride[0]] -
+        p[stride[1] + stride[2]]) * frac[0];
+    c0 = c00 + (c10 - c00) * frac[1];
+    c1 = c01 + (c11 - c01) * frac[1];
+
+    out[i] = (c0 + (c1 - c0) * frac[2]) * 255.0f;
+  }
+}
+
+GstColorLutTable *
+gst_color_lut_table_new (guint size, GstColorLutSampleFunc func,
+    gpointer user_data)
+{
+  GstColorLutTable *table;
+  guint16 *data;
+  guint x, i0, i1, i2, c;
+
+  g_return_val_if_fail (size >= 2 && size <= MAX_LUT_SIZE, NULL);
+
+  table = g_new0 (GstColorLutTable, 1);
+  table->size = size;
+  table->data = data = g_new (guint16, size * size * size * 3);
+  table->step[0] = size * size * 3;
+  table->step[1] = size * 3;
+  table->step[2] = 3;
+
+  for (x = 0; x < 256; x++) {
+    guint pos = x * (size - 1) * 256 / 255;
+    guint idx = pos >> 8;
+    guint frac = pos & 0xff;
+
+    /* keep the upper grid point inside the table */
+    if (idx >= size - 1) {
+      idx = size - 2;
+      frac = 256;
+    }
+
+    for (c = 0; c < 3; c++)
+      table->offset[c][x] = idx * table->step[c];
+    table->frac[x] = frac;
+  }
+
+  for (i0 = 0; i0 < size; i0++) {
+    for (i1 = 0; i1 < size; i1++) {
+      for (i2 = 0; i2 < size; i2++) {
+        gfloat in[3], out[3];
+
+        in[0] = i0 * 255.0f / (size - 1);
+        in[1] = i1 * 255.0f / (size - 1);
+        in[2] = i2 * 255.0f / (size - 1);
+
+        func (in, out, user_data);
+
+        for (c = 0; c < 3; c++)
+          *data++ = CLAMP (out[c], 0.0f, 255.0f) * 256.0f + 0.5f;
+      }
+    }
+  }
+
+  return table;
+}
+
+void
+gst_color_lut_table_free (GstColorLutTable * table)
+{
+  if (table == NULL)
+    return;
+
+  g_free (table->data);
+  g_free (table);
+}
+
+/* The lookups below are written without data dependent branches: the grid
+ * cell and weights of a pixel are computed once in fixed point and then
+ * applied to each output component. */
+
+typedef struct
+{
+  guint32 offset[4];
+  gint weight[4];
+} LutTetrahedron;
+
+/* the tetrahedron containing the pixel goes from the lower to the upper
+ * corner of the grid cell, stepping along the components in order of
+ * decreasing distance to the lower corner */
+static inline void
+lut_tetrahedral_setup (const GstColorLutTable * table, guint x0, guint x1,
+    guint x2, LutTetrahedron * t)
+{
+  const gint f0 = table->frac[x0];
+  const gint f1 = table->frac[x1];
+  const gint f2 = table->frac[x2];
+  const guint32 s0 = table->step[0];
+  const guint32 s1 = table->step[1];
+  const guint32 s2 = table->step[2];
+  const gboolean ge01 = f0 >= f1;
+  const gboolean ge12 = f1 >= f2;
+  const gboolean ge02 = f0 >= f2;
+  const gint fmax = MAX (MAX (f0, f1), f2);
+  const gint fmin = MIN (MIN (f0, f1), f2);
+  const gint fmid = f0 + f1 + f2 - fmax - fmin;
+  guint32 first, last;
+
+  /* component with the largest and smallest distance */
+  first = (ge01 && ge02) ? s0 : (!ge01 && ge12) ? s1 : s2;
+  last = (!ge01 && !ge02) ? s0 : (ge01 && !ge12) ? s1 : s2;
+
+  t->offset[0] = table->offset[0][x0] + table->offset[1][x1] +
+      table->offset[2][x2];
+  t->offset[1] = t->offset[0] + first;
+  t->offset[2] = t->offset[0] + s0 + s1 + s2 - last;
+  t->offset[3] = t->offset[0] + s0 + s1 + s2;
+
+  t->weight[0] = 256 - fmax;
+  t->weight[1] = fmax - fmid;
+  t->weight[2] = fmid - fmin;
+  t->weight[3] = fmin;
+}
+
+static inline guint8
+lut_tetrahedral_eval (const GstColorLutTable * table,
+    const LutTetrahedron * t, guint c)
+{
+  const guint16 *d = table->data + c;
+
+  return (d[t->offset[0]] * t->weight[0] + d[t->offset[1]] * t->weight[1] +
+      d[t->offset[2]] * t->weight[2] + d[t->offset[3]] * t->weight[3] +
+      (1 << 15)) >> 16;
+}
+
+typedef struct
+{
+  guint32 offset;
+  gint frac[3];
+} LutCube;
+
+static inline void
+lut_trilinear_setup (const GstColorLutTable * table, guint x0, guint x1,
+    guint x2, LutCube * t)
+{
+  t->offset = table->offset[0][x0] + table->offset[1][x1] +
+      table->offset[2][x2];
+  t->frac[0] = table->frac[x0];
+  t->frac[1] = table->frac[x1];
+  t->frac[2] = table->frac[x2];
+}
+
+#define LERP(a,b,f) (((a) * (256 - (f)) + (b) * (f) + 128) >> 8)
+
+static inline guint8
+lut_trilinear_eval (const GstColorLutTable * table, const LutCube * t,
+    guint c)
+{
+  const guint16 *d = table->data + t->offset + c;
+  const guint32 s0 = table->step[0];
+  const guint32 s1 = table->step[1];
+  const guint32 s2 = table->step[2];
+  gint c00, c01, c10, c11, c0, c1;
+
+  c00 = LERP (d[0], d[s2], t->frac[2]);
+  c01 = LERP (d[s1], d[s1 + s2], t->frac[2]);
+  c10 = LERP (d[s0], d[s0 + s2], t->frac[2]);
+  c11 = LERP (d[s0 + s1], d[s0 + s1 + s2], t->frac[2]);
+  c0 = LERP (c00, c01, t->frac[1]);
+  c1 = LERP (c10, c11, t->frac[1]);
+
+  return (LERP (c0, c1, t->frac[0]) + 128) >> 8;
+}
+
+#undef LERP
+
+#define APPLY_PACKED(type,setup,eval) G_STMT_START {                    \
+  gint i;                                                               \
+  for (i = 0; i < width; i++) {                                         \
+    type t;                                                             \
+    setup (table, data[offsets[0]], data[offsets[1]], data[offsets[2]], \
+        &t);                                                            \
+    data[offsets[0]] = eval (table, &t, 0);                             \
+    data[offsets[1]] = eval (table, &t, 1);                             \
+    data[offsets[2]] = eval (table, &t, 2);                             \
+    data += pstride;                                                    \
+  }                                                                     \
+} G_STMT_END
+
+/* applies @table in place to a line of @width pixels with @pstride bytes
+ * per pixel and the three components at @offsets */
+void
+gst_color_lut_table_apply_packed (const GstColorLutTable * table,
+    GstColorLutInterpolation method, guint8 * data, gint pstride,
+    const gint offsets[3], gint width)
+{
+  switch (method) {
+    case GST_COLOR_LUT_INTERPOLATION_TRILINEAR:
+      APPLY_PACKED (LutCube, lut_trilinear_setup, lut_trilinear_eval);
+      break;
+    case GST_COLOR_LUT_INTERPOLATION_TETRAHEDRAL:
+      APPLY_PACKED (LutTetrahedron, lut_tetrahedral_setup,
+          lut_tetrahedral_eval);
+      break;
+  }
+}
+
+#undef APPLY_PACKED
+
+/* each chroma sample is shared by up to 2x2 luma samples: the luma output
+ * is looked up with the chroma of the pixel, the chroma output with the
+ * average luma of the pixels sharing it */
+#define APPLY_420(type,setup,eval) G_STMT_START {                       \
+  gint i;                                                               \
+  for (i = 0; i < width; i += 2) {                                      \
+    const gint n = MIN (width - i, 2);                                  \
+    const guint cu = *u, cv = *v;                                       \
+    guint sum = 0, count = 0;                                           \
+    gint k;                                                             \
+    type t;                                                             \
+    for (k = 0; k < n; k++) {                                           \
+      sum += y0[i + k];                                                 \
+      setup (table, y0[i + k], cu, cv, &t);                             \
+      y0[i + k] = eval (table, &t, 0);                                  \
+    }                                                                   \
+    count += n;                                                         \
+    if (y1) {                                                           \
+      for (k = 0; k < n; k++) {                                         \
+        sum += y1[i + k];                                               \
+        setup (table, y1[i + k], cu, cv, &t);                           \
+        y1[i + k] = eval (table, &t, 0);                                \
+      }                                                                 \
+      count += n;                                                       \
+    }                                                                   \
+    setup (table, (sum + (count >> 1)) / count, cu, cv, &t);            \
+    *u = eval (table, &t, 1);                                           \
+    *v = eval (table, &t, 2);                                           \
+    u += uv_pstride;                                                    \
+    v += uv_pstride;                                                    \
+  }                                                                     \
+} G_STMT_END
+
+/* applies @table, built for Y'CbCr, in place to two luma lines @y0 and @y1
+ * (NULL for the last line of a frame with an odd height) and the chroma
+ * line @u, @v they share. @uv_pstride is the distance between two chroma
+ * samples, i.e. 1 for I420 and 2 for NV12 */
+void
+gst_color_lut_table_apply_420 (const GstColorLutTable * table,
+    GstColorLutInterpolation method, guint8 * y0, guint8 * y1, guint8 * u,
+    guint8 * v, gint uv_pstride, gint width)
+{
+  switch (method) {
+    case GST_COLOR_LUT_INTERPOLATION_TRILINEAR:
+      APPLY_420 (LutCube, lut_trilinear_setup, lut_trilinear_eval);
+      break;
+    case GST_COLOR_LUT_INTERPOLATION_TETRAHEDRAL:
+      APPLY_420 (LutTetrahedron, lut_tetrahedral_setup, lut_tetrahedral_eval);
+      break;
+  }
+}
+
+#undef APPLY_420
@@ -0,0 +1,94 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_COLOR_LUT_H__
+#define __GST_COLOR_LUT_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstColorLut GstColorLut;
+typedef struct _GstColorLutTable GstColorLutTable;
+
+typedef enum
+{
+  GST_COLOR_LUT_INTERPOLATION_TRILINEAR,
+  GST_COLOR_LUT_INTERPOLATION_TETRAHEDRAL,
+} GstColorLutInterpolation;
+
+/* a 3D LUT as loaded from a .cube file: size^3 normalized RGB triplets with
+ * red changing fastest, then green, then blue */
+struct _GstColorLut
+{
+  guint size;
+  gfloat *data;
+  gfloat domain_min[3];
+  gfloat domain_max[3];
+};
+
+/* maps the three color components of @in to @out, both with values in the
+ * 0..255 range */
+typedef void (*GstColorLutSampleFunc) (const gfloat in[3], gfloat out[3],
+    gpointer user_data);
+
+/* the fixed point grid actually applied to the video frames, indexed by
+ * the components of the video format it was built for */
+struct _GstColorLutTable
+{
+  guint size;
+  /* size^3 output triplets in 8.8 fixed point */
+  guint16 *data;
+  /* per component, offset in data of the grid point below an 8 bit value */
+  guint32 offset[3][256];
+  /* distance to that grid point in 1/256 of a grid step */
+  guint16 frac[256];
+  /* offset in data of the next grid point of each component */
+  guint32 step[3];
+};
+
+GstColorLut *      gst_color_lut_new_from_cube_file (const gchar * filename,
+                                                     GError ** error);
+
+void               gst_color_lut_sample (const GstColorLut * lut,
+                                         const gfloat rgb[3], gfloat out[3]);
+
+void               gst_color_lut_free (GstColorLut * lut);
+
+GstColorLutTable * gst_color_lut_table_new (guint size,
+                                            GstColorLutSampleFunc func,
+                                            gpointer user_data);
+
+void               gst_color_lut_table_free (GstColorLutTable * table);
+
+void               gst_color_lut_table_apply_packed (
+                       const GstColorLutTable * table,
+                       GstColorLutInterpolation method,
+                       guint8 * data, gint pstride,
+                       const gint offsets[3], gint width);
+
+void               gst_color_lut_table_apply_420 (
+                       const GstColorLutTable * table,
+                       GstColorLutInterpolation method,
+                       guint8 * y0, guint8 * y1,
+                       guint8 * u, guint8 * v,
+                       gint uv_pstride, gint width);
+
+G_END_DECLS
+
+#endif /* __GST_COLOR_LUT_H__ */
@@ -29,8 +29,29 @@
  * gst-launch-1.0 videotestsrc ! fpsdisplaysink text-overlay=false
  * gst-launch-1.0 filesrc location=video.avi ! decodebin name=d ! queue ! fpsdisplaysink d. ! queue ! fakesink sync=true
  * gst-launch-1.0 playbin uri=file:///path/to/video.avi video-sink="fpsdisplaysink" audio-sink=fakesink
+ * gst-launch-1.0 -m videotestsrc ! fpsdisplaysink stats-mode=true video-sink=fakevideosink
  * ]|
  *
+ * With #GstFPSDisplaySink:stats-mode enabled no text is rendered or
+ * formatted. Instead, every #GstFPSDisplaySink:fps-update-interval an
+ * element message named `fpsdisplaysink-stats` is posted on the bus with
+ * the following fields:
+ *
+ * * `frames-rendered` and `frames-dropped` (#guint64): totals since start
+ * * `interval` (#guint64): length of the reported interval in nanoseconds
+ * * `fps`, `drop-rate` and `average-fps` (#gdouble)
+ * * `inter-arrival-samples`, `inter-arrival-min`, `inter-arrival-max` and
+ *   `inter-arrival-average` (#guint64): wall clock time in nanoseconds
+ *   between consecutive buffers reaching the video sink
+ * * `inter-arrival-histogram` (#GstValueArray of #guint): bucket 0 counts
+ *   inter-arrival times below 1 microsecond, bucket n the ones between
+ *   2^(n-1) and 2^n microseconds, the last bucket everything above
+ * * `jitter-samples`, `jitter-min`, `jitter-max` and `jitter-average`
+ *   (#gint64): render jitter in nanoseconds as reported by the video sink
+ *   QoS events, negative values meaning early
+ *
+ * All but the totals only cover the reported interval.
+ *
  */
 /* FIXME:
  * - can we avoid plugging the textoverlay?
@@ -54,6 +75,7 @@
 #define DEFAULT_FONT "Sans 15"
 #define DEFAULT_SILENT FALSE
 #define DEFAULT_LAST_MESSAGE NULL
+#define DEFAULT_STATS_MODE FALSE
 
 /* generic templates */
 static GstStaticPadTemplate fps_display_sink_template =
@@ -87,7 +109,8 @@ enum
   PROP_FRAMES_DROPPED,
   PROP_FRAMES_RENDERED,
   PROP_SILENT,
-  PROP_LAST_MESSAGE
+  PROP_LAST_MESSAGE,
+  PROP_STATS_MODE
       /* FILL ME */
 };
 
@@ -183,6 +206,21 @@ fps_display_sink_class_init (GstFPSDisplaySinkClass * klass)
           DEFAULT_SIGNAL_FPS_MEASUREMENTS,
           G_PARAM_STATIC_STRINGS | G_PARAM_READWRITE));
 
+  /**
+   * GstFPSDisplaySink:stats-mode:
+   *
+   * Skip the text rendering and post a `fpsdisplaysink-stats` element
+   * message with frame counts, render jitter and inter-arrival statistics
+   * every #GstFPSDisplaySink:fps-update-interval instead. Should be set on
+   * NULL state.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_klass, PROP_STATS_MODE,
+      g_param_spec_boolean ("stats-mode", "Stats mode",
+          "Post statistics element messages instead of rendering text",
+          DEFAULT_STATS_MODE, G_PARAM_STATIC_STRINGS | G_PARAM_READWRITE));
+
   pspec_last_message = g_param_spec_string ("last-message", "Last Message",
       "The message describing current status", DEFAULT_LAST_MESSAGE,
       G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
@@ -233,10 +271,19 @@ on_video_sink_data_flow (GstPad * pad, GstPadProbeInfo * info,
     if (G_UNLIKELY (!GST_CLOCK_TIME_IS_VALID (self->start_ts))) {
       self->interval_ts = self->last_ts = self->start_ts = ts;
     }
+    if (self->stats_mode)
+      gst_video_sink_stats_add_arrival (&self->stats, ts);
     if (GST_CLOCK_DIFF (self->interval_ts, ts) > self->fps_update_interval) {
       display_current_fps (self);
       self->interval_ts = ts;
     }
+  } else if (self->stats_mode && GST_IS_EVENT (mini_obj)
+      && GST_EVENT_TYPE (mini_obj) == GST_EVENT_QOS) {
+    GstClockTimeDiff jitter;
+
+    gst_event_parse_qos (GST_EVENT_CAST (mini_obj), NULL, NULL, &jitter,
+        NULL);
+    gst_video_sink_stats_add_jitter (&self->stats, jitter);
   }
 
   return GST_PAD_PROBE_OK;
@@ -336,6 +383,7 @@ fps_display_sink_init (GstFPSDisplaySink * self,
   self->min_fps = -1;
   self->silent = DEFAULT_SILENT;
   self->last_message = g_strdup (DEFAULT_LAST_MESSAGE);
+  self->stats_mode = DEFAULT_STATS_MODE;
 
   self->ghost_pad = gst_ghost_pad_new_no_target ("sink", GST_PAD_SINK);
   gst_element_add_pad (GST_ELEMENT (self), self->ghost_pad);
@@ -384,6 +432,23 @@ display_current_fps (gpointer data)
         average_fps);
   }
 
+  if (self->stats_mode) {
+    GstStructure *s;
+
+    s = gst_structure_new ("fpsdisplaysink-stats",
+        "frames-rendered", G_TYPE_UINT64, frames_rendered,
+        "frames-dropped", G_TYPE_UINT64, frames_dropped,
+        "interval", G_TYPE_UINT64, current_ts - self->last_ts,
+        "fps", G_TYPE_DOUBLE, rr, "drop-rate", G_TYPE_DOUBLE, dr,
+        "average-fps", G_TYPE_DOUBLE, average_fps, NULL);
+    gst_video_sink_stats_fill_structure (&self->stats, s);
+    gst_video_sink_stats_reset (&self->stats);
+
+    gst_element_post_message (GST_ELEMENT (self),
+        gst_message_new_element (GST_OBJECT (self), s));
+    goto done;
+  }
+
   /* Display on a single line to make it easier to read and import
    * into, for example, excel..  note: it would be nice to show
    * timestamp too.. need to check if there is a sane way to log
@@ -414,6 +479,7 @@ display_current_fps (gpointer data)
     g_object_notify_by_pspec ((GObject *) self, pspec_last_message);
   }
 
+done:
   self->last_frames_rendered = frames_rendered;
   self->last_frames_dropped = frames_dropped;
   self->last_ts = current_ts;
@@ -436,10 +502,12 @@ fps_display_sink_start (GstFPSDisplaySink * self)
 
   /* init time stamps */
   self->last_ts = self->start_ts = self->interval_ts = GST_CLOCK_TIME_NONE;
+  gst_video_sink_stats_init (&self->stats);
 
-  GST_DEBUG_OBJECT (self, "Use text-overlay? %d", self->use_text_overlay);
+  GST_DEBUG_OBJECT (self, "Use text-overlay? %d, stats-mode? %d",
+      self->use_text_overlay, self->stats_mode);
 
-  if (self->use_text_overlay) {
+  if (self->use_text_overlay && !self->stats_mode) {
     if (!self->text_overlay) {
       self->text_overlay =
           gst_element_factory_make ("textoverlay", "fps-display-text-overlay");
@@ -460,7 +528,7 @@ fps_display_sink_start (GstFPSDisplaySink * self)
     target_pad = gst_element_get_static_pad (self->text_overlay, "video_sink");
   }
 no_text_overlay:
-  if (!self->use_text_overlay) {
+  if (!self->use_text_overlay || self->stats_mode) {
     if (self->text_overlay) {
       gst_element_unlink (self->text_overlay, self->video_sink);
       gst_bin_remove (GST_BIN (self), self->text_overlay);
@@ -570,6 +638,9 @@ fps_display_sink_set_property (GObject * object, guint prop_id,
     case PROP_SILENT:
       self->silent = g_value_get_boolean (value);
       break;
+    case PROP_STATS_MODE:
+      self->stats_mode = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -618,6 +689,9 @@ fps_display_sink_get_property (GObject * object, guint prop_id,
       g_value_set_string (value, self->last_message);
       GST_OBJECT_UNLOCK (self);
       break;
+    case PROP_STATS_MODE:
+      g_value_set_boolean (value, self->stats_mode);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
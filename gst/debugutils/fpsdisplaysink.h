@@ -22,6 +22,8 @@
 
 #include <gst/gst.h>
 
+#include "gstvideosinkstats.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_FPS_DISPLAY_SINK \
@@ -58,6 +60,7 @@ struct _GstFPSDisplaySink
   GstClockTime last_ts;
   GstClockTime interval_ts;
   guint data_probe_id;
+  GstVideoSinkStats stats;
 
   /* properties */
   gboolean sync;
@@ -68,6 +71,7 @@ struct _GstFPSDisplaySink
   gdouble min_fps;
   gboolean silent;
   gchar *last_message;
+  gboolean stats_mode;
 };
 
 struct _GstFPSDisplaySinkClass
@@ -24,6 +24,7 @@
 #include "config.h"
 #endif
 #include <string.h>
+#include <math.h>
 
 #include <gst/gst.h>
 #include <gst/base/gstcollectpads.h>
@@ -91,7 +92,9 @@ enum
   PROP_OFFSET_TS,
   PROP_METHOD,
   PROP_THRESHOLD,
-  PROP_UPPER
+  PROP_UPPER,
+  PROP_EARLY_EXIT,
+  PROP_N_THREADS
 };
 
 #define DEFAULT_META             GST_BUFFER_COPY_ALL
@@ -99,6 +102,35 @@ enum
 #define DEFAULT_METHOD           GST_COMPARE_METHOD_MEM
 #define DEFAULT_THRESHOLD        0
 #define DEFAULT_UPPER            TRUE
+#define DEFAULT_EARLY_EXIT       FALSE
+#define DEFAULT_N_THREADS        1
+
+/* largest difference between two bytes as computed by the max method */
+#define MAX_DELTA 255
+#define MAX_CHUNK_SIZE 4096
+
+#define SSIM_WINDOW 16
+#define SSIM_BLOCK (SSIM_WINDOW / 2)
+#define MIN_WINDOW_ROWS_PER_JOB 4
+
+typedef struct
+{
+  gint sum1, sum2, ssum1, ssum2, acov;
+  gint count;
+} GstCompareSsimSums;
+
+/* computes the SSIM of the windows of rows @start to @end of a component */
+typedef struct
+{
+  GstCompare *comp;
+  const guint8 *data1;
+  const guint8 *data2;
+  gint width, height, step, stride;
+  gint start, end;
+
+  gdouble ssim_sum;
+  gint count;
+} GstCompareSsimJob;
 
 static void gst_compare_set_property (GObject * object,
     guint prop_id, const GValue * value, GParamSpec * pspec);
@@ -125,6 +157,11 @@ gst_compare_finalize (GObject * object)
 
   gst_object_unref (comp->cpads);
 
+  if (comp->pool)
+    g_thread_pool_free (comp->pool, FALSE, TRUE);
+  g_mutex_clear (&comp->jobs_lock);
+  g_cond_clear (&comp->jobs_cond);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -168,6 +205,31 @@ gst_compare_class_init (GstCompareClass * klass)
       g_param_spec_boolean ("upper", "Threshold Upper Bound",
           "Whether threshold value is upper bound or lower bound for difference measure",
           DEFAULT_UPPER, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstCompare:early-exit:
+   *
+   * Stop comparing the content of a buffer as soon as it is known to fail an
+   * upper bound threshold. The delta reported in the message is then only a
+   * lower bound of the actual difference.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_EARLY_EXIT,
+      g_param_spec_boolean ("early-exit", "Early Exit",
+          "Stop comparing once the upper bound threshold is exceeded",
+          DEFAULT_EARLY_EXIT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstCompare:n-threads:
+   *
+   * Maximum number of threads used by the ssim method, 0 means one thread
+   * per processor.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of Threads",
+          "Maximum number of threads to use", 0, G_MAXUINT,
+          DEFAULT_N_THREADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_add_static_pad_template (gstelement_class, &src_factory);
   gst_element_class_add_static_pad_template (gstelement_class, &sink_factory);
@@ -212,6 +274,11 @@ gst_compare_init (GstCompare * comp)
   comp->method = DEFAULT_METHOD;
   comp->threshold = DEFAULT_THRESHOLD;
   comp->upper = DEFAULT_UPPER;
+  comp->early_exit = DEFAULT_EARLY_EXIT;
+  comp->n_threads = DEFAULT_N_THREADS;
+
+  g_mutex_init (&comp->jobs_lock);
+  g_cond_init (&comp->jobs_cond);
 
   gst_compare_reset (comp);
 }
@@ -320,9 +387,10 @@ gst_compare_mem (GstCompare * comp, GstBuffer * buf1, GstCaps * caps1,
 
 static gint
 gst_compare_max (GstCompare * comp, GstBuffer * buf1, GstCaps * caps1,
-    GstBuffer * buf2, GstCaps * caps2)
+    GstBuffer * buf2, GstCaps * caps2, gint limit)
 {
-  gint i, delta = 0;
+  gsize i, j;
+  gint delta = 0;
   gint8 *data1, *data2;
   GstMapInfo map1, map2;
 
@@ -332,28 +400,46 @@ gst_compare_max (GstCompare * comp, GstBuffer * buf1, GstCaps * caps1,
   data1 = (gint8 *) map1.data;
   data2 = (gint8 *) map2.data;
 
-  /* primitive loop */
-  for (i = 0; i < map1.size; i++) {
-    gint diff = ABS (*data1 - *data2);
-    if (diff > 0)
-      GST_LOG_OBJECT (comp, "diff at %d = %d", i, diff);
-    delta = MAX (delta, ABS (*data1 - *data2));
-    data1++;
-    data2++;
+#ifndef GST_DISABLE_GST_DEBUG
+  if (gst_debug_category_get_threshold (GST_CAT_DEFAULT) >= GST_LEVEL_LOG) {
+    /* primitive loop */
+    for (i = 0; i < map1.size; i++) {
+      gint diff = ABS (*data1 - *data2);
+      if (diff > 0)
+        GST_LOG_OBJECT (comp, "diff at %" G_GSIZE_FORMAT " = %d", i, diff);
+      delta = MAX (delta, diff);
+      data1++;
+      data2++;
+    }
+    goto done;
+  }
+#endif
+
+  /* process in chunks with a branch-free inner loop the compiler can
+   * vectorize, stopping once @limit is reached */
+  for (i = 0; i < map1.size && delta < limit; i += MAX_CHUNK_SIZE) {
+    gsize n = MIN (MAX_CHUNK_SIZE, map1.size - i);
+    gint chunk = 0;
+
+    for (j = 0; j < n; j++) {
+      gint diff = ABS (data1[i + j] - data2[i + j]);
+      chunk = MAX (chunk, diff);
+    }
+    delta = MAX (delta, chunk);
   }
 
+#ifndef GST_DISABLE_GST_DEBUG
+done:
+#endif
   gst_buffer_unmap (buf1, &map1);
   gst_buffer_unmap (buf2, &map2);
 
   return delta;
 }
 
-static double
-gst_compare_ssim_window (GstCompare * comp, guint8 * data1, guint8 * data2,
-    gint width, gint height, gint step, gint stride)
+static gdouble
+gst_compare_ssim_window (const GstCompareSsimSums * s)
 {
-  gint count = 0, i, j;
-  gint sum1 = 0, sum2 = 0, ssum1 = 0, ssum2 = 0, acov = 0;
   gdouble avg1, avg2, var1, var2, cov;
 
   const gdouble k1 = 0.01;
@@ -362,66 +448,155 @@ gst_compare_ssim_window (GstCompare * comp, guint8 * data1, guint8 * data2,
   const gdouble c1 = (k1 * L) * (k1 * L);
   const gdouble c2 = (k2 * L) * (k2 * L);
 
-  /* For empty images, return maximum similarity */
-  if (height <= 0 || width <= 0)
-    return 1.0;
-
-  /* plain and simple; no fancy optimizations */
-  for (i = 0; i < height; i++) {
-    for (j = 0; j < width; j++) {
-      sum1 += *data1;
-      sum2 += *data2;
-      ssum1 += *data1 * *data1;
-      ssum2 += *data2 * *data2;
-      acov += *data1 * *data2;
-      count++;
-      data1 += step;
-      data2 += step;
-    }
-    data1 -= j * step;
-    data2 -= j * step;
-    data1 += stride;
-    data2 += stride;
-  }
-
-  avg1 = sum1 / count;
-  avg2 = sum2 / count;
-  var1 = ssum1 / count - avg1 * avg1;
-  var2 = ssum2 / count - avg2 * avg2;
-  cov = acov / count - avg1 * avg2;
+  avg1 = s->sum1 / s->count;
+  avg2 = s->sum2 / s->count;
+  var1 = s->ssum1 / s->count - avg1 * avg1;
+  var2 = s->ssum2 / s->count - avg2 * avg2;
+  cov = s->acov / s->count - avg1 * avg2;
 
   return (2 * avg1 * avg2 + c1) * (2 * cov + c2) /
       ((avg1 * avg1 + avg2 * avg2 + c1) * (var1 + var2 + c2));
 }
 
-/* @width etc are for the particular component */
-static gdouble
-gst_compare_ssim_component (GstCompare * comp, guint8 * data1, guint8 * data2,
-    gint width, gint height, gint step, gint stride)
+static inline void
+gst_compare_ssim_sums_add (GstCompareSsimSums * s, const GstCompareSsimSums * a)
+{
+  s->sum1 += a->sum1;
+  s->sum2 += a->sum2;
+  s->ssum1 += a->ssum1;
+  s->ssum2 += a->ssum2;
+  s->acov += a->acov;
+  s->count += a->count;
+}
+
+/* computes the sums of the @n_blocks blocks of block row @row, clipped to
+ * the component size */
+static void
+gst_compare_ssim_block_row (const GstCompareSsimJob * job, gint row,
+    GstCompareSsimSums * blocks, gint n_blocks)
 {
-  const gint window = 16;
-  gdouble ssim_sum = 0;
-  gint count = 0, i, j;
+  gint y, y_end = MIN ((row + 1) * SSIM_BLOCK, job->height);
+
+  memset (blocks, 0, n_blocks * sizeof (GstCompareSsimSums));
+
+  for (y = row * SSIM_BLOCK; y < y_end; y++) {
+    const guint8 *data1 = job->data1 + y * job->stride;
+    const guint8 *data2 = job->data2 + y * job->stride;
+    gint b, x = 0;
+
+    for (b = 0; b < n_blocks; b++) {
+      gint x_start = x, x_end = MIN (x + SSIM_BLOCK, job->width);
+      gint sum1 = 0, sum2 = 0, ssum1 = 0, ssum2 = 0, acov = 0;
+
+      for (; x < x_end; x++) {
+        gint p1 = data1[x * job->step];
+        gint p2 = data2[x * job->step];
+
+        sum1 += p1;
+        sum2 += p2;
+        ssum1 += p1 * p1;
+        ssum2 += p2 * p2;
+        acov += p1 * p2;
+      }
+
+      blocks[b].sum1 += sum1;
+      blocks[b].sum2 += sum2;
+      blocks[b].ssum1 += ssum1;
+      blocks[b].ssum2 += ssum2;
+      blocks[b].acov += acov;
+      blocks[b].count += x_end - x_start;
+    }
+  }
+}
+
+/* The windows overlap by half their size, so each window is the sum of
+ * 2x2 half-size blocks. The block sums are computed once per block row and
+ * shared by the two window rows using them. */
+static void
+gst_compare_ssim_rows (GstCompareSsimJob * job)
+{
+  gint n_cols = (job->width - 1) / SSIM_BLOCK;
+  GstCompareSsimSums *blocks, *prev, *cur, *tmp;
+  gint i, j;
+
+  job->ssim_sum = 0;
+  job->count = 0;
+
+  if (job->start >= job->end || n_cols <= 0)
+    return;
+
+  blocks = g_new (GstCompareSsimSums, 2 * (n_cols + 1));
+  prev = blocks;
+  cur = blocks + n_cols + 1;
+
+  gst_compare_ssim_block_row (job, job->start, prev, n_cols + 1);
 
-  for (j = 0; j + (window / 2) < height; j += (window / 2)) {
-    for (i = 0; i + (window / 2) < width; i += (window / 2)) {
+  for (j = job->start; j < job->end; j++) {
+    gst_compare_ssim_block_row (job, j + 1, cur, n_cols + 1);
+
+    for (i = 0; i < n_cols; i++) {
+      GstCompareSsimSums s = prev[i];
       gdouble ssim;
 
-      ssim = gst_compare_ssim_window (comp, data1 + step * i + j * stride,
-          data2 + step * i + j * stride,
-          MIN (window, width - i), MIN (window, height - j), step, stride);
-      GST_LOG_OBJECT (comp, "ssim for %dx%d at (%d, %d) = %f", window, window,
-          i, j, ssim);
-      ssim_sum += ssim;
-      count++;
+      gst_compare_ssim_sums_add (&s, &prev[i + 1]);
+      gst_compare_ssim_sums_add (&s, &cur[i]);
+      gst_compare_ssim_sums_add (&s, &cur[i + 1]);
+
+      ssim = gst_compare_ssim_window (&s);
+      GST_LOG_OBJECT (job->comp, "ssim for %dx%d at (%d, %d) = %f",
+          SSIM_WINDOW, SSIM_WINDOW, i * SSIM_BLOCK, j * SSIM_BLOCK, ssim);
+      job->ssim_sum += ssim;
+      job->count++;
     }
+
+    tmp = prev;
+    prev = cur;
+    cur = tmp;
   }
 
-  /* For empty images, return maximum similarity */
-  if (count == 0)
-    return 1.0;
+  g_free (blocks);
+}
+
+static void
+gst_compare_ssim_job (gpointer data, gpointer user_data)
+{
+  GstCompareSsimJob *job = data;
+  GstCompare *comp = job->comp;
+
+  gst_compare_ssim_rows (job);
 
-  return (ssim_sum / count);
+  g_mutex_lock (&comp->jobs_lock);
+  if (--comp->jobs_pending == 0)
+    g_cond_signal (&comp->jobs_cond);
+  g_mutex_unlock (&comp->jobs_lock);
+}
+
+/* runs @n_jobs jobs, the first one from the streaming thread, and waits for
+ * all of them to be done */
+static void
+gst_compare_run_jobs (GstCompare * comp, GstCompareSsimJob * jobs,
+    guint n_jobs)
+{
+  guint i;
+
+  if (n_jobs > 1) {
+    if (comp->pool == NULL)
+      comp->pool =
+          g_thread_pool_new (gst_compare_ssim_job, NULL, -1, FALSE, NULL);
+
+    comp->jobs_pending = n_jobs - 1;
+    for (i = 1; i < n_jobs; i++)
+      g_thread_pool_push (comp->pool, &jobs[i], NULL);
+  }
+
+  gst_compare_ssim_rows (&jobs[0]);
+
+  if (n_jobs > 1) {
+    g_mutex_lock (&comp->jobs_lock);
+    while (comp->jobs_pending > 0)
+      g_cond_wait (&comp->jobs_cond, &comp->jobs_lock);
+    g_mutex_unlock (&comp->jobs_lock);
+  }
 }
 
 static gdouble
@@ -430,8 +605,10 @@ gst_compare_ssim (GstCompare * comp, GstBuffer * buf1, GstCaps * caps1,
 {
   GstVideoInfo info1, info2;
   GstVideoFrame frame1, frame2;
+  GstCompareSsimJob *jobs;
+  guint n_jobs = 0, comp_jobs[4] = { 0, }, n_threads, k;
   gint i, comps;
-  gdouble cssim[4], ssim, c[4] = { 1.0, 0.0, 0.0, 0.0 };
+  gdouble cssim[4] = { 0, }, ssim, c[4] = { 1.0, 0.0, 0.0, 0.0 };
 
   if (!caps1)
     goto invalid_input;
@@ -461,24 +638,56 @@ gst_compare_ssim (GstCompare * comp, GstBuffer * buf1, GstCaps * caps1,
     c[i] /= (GST_VIDEO_INFO_IS_YUV (&info1) && (comps > 1)) ?
         2 * (comps - 1) : comps;
 
+  /* only support most common formats */
+  for (i = 0; i < comps; i++) {
+    if (GST_VIDEO_INFO_COMP_DEPTH (&info1, i) != 8)
+      goto unsupported_input;
+  }
+
   gst_video_frame_map (&frame1, &info1, buf1, GST_MAP_READ);
   gst_video_frame_map (&frame2, &info2, buf2, GST_MAP_READ);
 
+  n_threads = comp->n_threads;
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+
+  /* split the window rows of all components across the threads */
+  jobs = g_newa (GstCompareSsimJob, comps * n_threads);
   for (i = 0; i < comps; i++) {
-    gint cw, ch, step, stride;
+    gint ch = GST_VIDEO_FRAME_COMP_HEIGHT (&frame1, i);
+    gint n_rows = ch > 0 ? (ch - 1) / SSIM_BLOCK : 0;
+    guint n = CLAMP (n_rows / MIN_WINDOW_ROWS_PER_JOB, 1, n_threads);
+    gint rows = (n_rows + n - 1) / n;
+
+    for (k = 0; k < n; k++) {
+      GstCompareSsimJob *job = &jobs[n_jobs++];
+
+      job->comp = comp;
+      job->data1 = GST_VIDEO_FRAME_COMP_DATA (&frame1, i);
+      job->data2 = GST_VIDEO_FRAME_COMP_DATA (&frame2, i);
+      job->width = GST_VIDEO_FRAME_COMP_WIDTH (&frame1, i);
+      job->height = ch;
+      job->step = GST_VIDEO_FRAME_COMP_PSTRIDE (&frame1, i);
+      job->stride = GST_VIDEO_FRAME_COMP_STRIDE (&frame1, i);
+      job->start = MIN (k * rows, n_rows);
+      job->end = MIN ((k + 1) * rows, n_rows);
+    }
+    comp_jobs[i] = n;
+  }
 
-    /* only support most common formats */
-    if (GST_VIDEO_INFO_COMP_DEPTH (&info1, i) != 8)
-      goto unsupported_input;
-    cw = GST_VIDEO_FRAME_COMP_WIDTH (&frame1, i);
-    ch = GST_VIDEO_FRAME_COMP_HEIGHT (&frame1, i);
-    step = GST_VIDEO_FRAME_COMP_PSTRIDE (&frame1, i);
-    stride = GST_VIDEO_FRAME_COMP_STRIDE (&frame1, i);
-
-    GST_LOG_OBJECT (comp, "component %d", i);
-    cssim[i] = gst_compare_ssim_component (comp,
-        GST_VIDEO_FRAME_COMP_DATA (&frame1, i),
-        GST_VIDEO_FRAME_COMP_DATA (&frame2, i), cw, ch, step, stride);
+  gst_compare_run_jobs (comp, jobs, n_jobs);
+
+  for (i = 0, n_jobs = 0; i < comps; i++) {
+    gdouble ssim_sum = 0;
+    gint count = 0;
+
+    for (k = 0; k < comp_jobs[i]; k++, n_jobs++) {
+      ssim_sum += jobs[n_jobs].ssim_sum;
+      count += jobs[n_jobs].count;
+    }
+
+    /* For empty images, return maximum similarity */
+    cssim[i] = count ? ssim_sum / count : 1.0;
     GST_LOG_OBJECT (comp, "ssim[%d] = %f", i, cssim[i]);
   }
 
@@ -509,6 +718,33 @@ unsupported_input:
   }
 }
 
+/* whether a content delta in the [@min, @max] range can fail the threshold
+ * check at all */
+static gboolean
+gst_compare_can_fail (GstCompare * comp, gdouble min, gdouble max)
+{
+  if (comp->upper)
+    return max > comp->threshold;
+  else
+    return min < comp->threshold;
+}
+
+/* the delta from which the result of the max method is known: it can stop
+ * once it's known to pass a lower bound threshold, and once it fails an
+ * upper bound one if the exact delta isn't wanted */
+static gint
+gst_compare_max_limit (GstCompare * comp)
+{
+  gdouble limit = MAX_DELTA;
+
+  if (!comp->upper)
+    limit = ceil (comp->threshold);
+  else if (comp->early_exit)
+    limit = floor (comp->threshold) + 1;
+
+  return MIN (limit, MAX_DELTA);
+}
+
 static void
 gst_compare_buffers (GstCompare * comp, GstBuffer * buf1, GstCaps * caps1,
     GstBuffer * buf2, GstCaps * caps2)
@@ -526,6 +762,13 @@ gst_compare_buffers (GstCompare * comp, GstBuffer * buf1, GstCaps * caps1,
   /* but at least size should match */
   if (size1 != size2) {
     delta = comp->threshold + 1;
+  } else if (comp->method == GST_COMPARE_METHOD_MEM &&
+      !gst_compare_can_fail (comp, 0, 1)) {
+    /* the result can't fail the threshold check, skip the comparison */
+    delta = comp->upper ? 0 : 1;
+  } else if (comp->method == GST_COMPARE_METHOD_MAX &&
+      !gst_compare_can_fail (comp, 0, MAX_DELTA)) {
+    delta = comp->upper ? 0 : MAX_DELTA;
   } else {
     GstMapInfo map1, map2;
 
@@ -540,7 +783,8 @@ gst_compare_buffers (GstCompare * comp, GstBuffer * buf1, GstCaps * caps1,
         delta = gst_compare_mem (comp, buf1, caps1, buf2, caps2);
         break;
       case GST_COMPARE_METHOD_MAX:
-        delta = gst_compare_max (comp, buf1, caps1, buf2, caps2);
+        delta = gst_compare_max (comp, buf1, caps1, buf2, caps2,
+            gst_compare_max_limit (comp));
         break;
       case GST_COMPARE_METHOD_SSIM:
         delta = gst_compare_ssim (comp, buf1, caps1, buf2, caps2);
@@ -629,6 +873,12 @@ gst_compare_set_property (GObject * object, guint prop_id,
     case PROP_UPPER:
       comp->upper = g_value_get_boolean (value);
       break;
+    case PROP_EARLY_EXIT:
+      comp->early_exit = g_value_get_boolean (value);
+      break;
+    case PROP_N_THREADS:
+      comp->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -657,6 +907,12 @@ gst_compare_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_UPPER:
       g_value_set_boolean (value, comp->upper);
       break;
+    case PROP_EARLY_EXIT:
+      g_value_set_boolean (value, comp->early_exit);
+      break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, comp->n_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -62,6 +62,13 @@ struct _GstCompare {
   gint method;
   gdouble threshold;
   gboolean upper;
+  gboolean early_exit;
+  guint n_threads;
+
+  GThreadPool *pool;
+  GMutex jobs_lock;
+  GCond jobs_cond;
+  guint jobs_pending;
 };
 
 struct _GstCompareClass {
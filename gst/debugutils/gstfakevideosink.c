@@ -32,8 +32,14 @@
  * |[
  * gst-launch-1.0 videotestsrc ! fakevideosink
  * gst-launch-1.0 videotestsrc ! fpsdisplaysink text-overlay=false video-sink=fakevideosink
+ * gst-launch-1.0 -m videotestsrc ! fakevideosink stats-interval=1000
  * ]|
  *
+ * When #GstFakeVideoSink:stats-interval is set, a `fakevideosink-stats`
+ * element message is posted on the bus at that interval. It carries the
+ * same fields as the `fpsdisplaysink-stats` message of fpsdisplaysink
+ * except for the frame rates.
+ *
  * Since 1.14
  */
 
@@ -72,10 +78,12 @@ enum
 {
   PROP_0,
   PROP_ALLOCATION_META_FLAGS,
+  PROP_STATS_INTERVAL,
   PROP_LAST
 };
 
 #define ALLOCATION_META_DEFAULT_FLAGS GST_ALLOCATION_FLAG_CROP_META | GST_ALLOCATION_FLAG_OVERLAY_COMPOSITION_META
+#define DEFAULT_STATS_INTERVAL 0
 
 static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
@@ -123,6 +131,64 @@ gst_fake_video_sink_query (GstPad * pad, GstObject * parent, GstQuery * query)
   return TRUE;
 }
 
+static void
+gst_fake_video_sink_post_stats (GstFakeVideoSink * self, GstClockTime ts)
+{
+  GstStructure *s;
+
+  s = gst_structure_new ("fakevideosink-stats",
+      "frames-rendered", G_TYPE_UINT64,
+      (guint64) g_atomic_int_get (&self->frames_rendered),
+      "frames-dropped", G_TYPE_UINT64,
+      (guint64) g_atomic_int_get (&self->frames_dropped),
+      "interval", G_TYPE_UINT64, ts - self->interval_ts, NULL);
+  gst_video_sink_stats_fill_structure (&self->stats, s);
+  gst_video_sink_stats_reset (&self->stats);
+
+  gst_element_post_message (GST_ELEMENT (self),
+      gst_message_new_element (GST_OBJECT (self), s));
+}
+
+static GstPadProbeReturn
+gst_fake_video_sink_stats_probe (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstFakeVideoSink *self = GST_FAKE_VIDEO_SINK (user_data);
+  GstMiniObject *mini_obj = GST_PAD_PROBE_INFO_DATA (info);
+  GstClockTime interval;
+
+  GST_OBJECT_LOCK (self);
+  interval = self->stats_interval;
+  GST_OBJECT_UNLOCK (self);
+
+  if (interval == 0)
+    return GST_PAD_PROBE_OK;
+
+  if (GST_IS_BUFFER (mini_obj)) {
+    GstClockTime ts = gst_util_get_timestamp ();
+
+    /* corrected from the QoS messages if the buffer gets dropped */
+    g_atomic_int_inc (&self->frames_rendered);
+
+    gst_video_sink_stats_add_arrival (&self->stats, ts);
+    if (!GST_CLOCK_TIME_IS_VALID (self->interval_ts)) {
+      self->interval_ts = ts;
+    } else if (ts - self->interval_ts >= interval) {
+      gst_fake_video_sink_post_stats (self, ts);
+      self->interval_ts = ts;
+    }
+  } else if (GST_IS_EVENT (mini_obj)
+      && GST_EVENT_TYPE (mini_obj) == GST_EVENT_QOS) {
+    GstClockTimeDiff jitter;
+
+    gst_event_parse_qos (GST_EVENT_CAST (mini_obj), NULL, NULL, &jitter,
+        NULL);
+    gst_video_sink_stats_add_jitter (&self->stats, jitter);
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
 /* TODO complete the types and make this an utility */
 static void
 gst_fake_video_sink_proxy_properties (GstFakeVideoSink * self,
@@ -153,6 +219,20 @@ gst_fake_video_sink_proxy_properties (GstFakeVideoSink * self,
             ALLOCATION_META_DEFAULT_FLAGS,
             G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+    /**
+     * GstFakeVideoSink:stats-interval
+     *
+     * Interval in milliseconds at which a `fakevideosink-stats` element
+     * message with frame counts, render jitter and inter-arrival statistics
+     * is posted. 0 disables the statistics.
+     *
+     * Since: 1.20
+     */
+    g_object_class_install_property (object_class, PROP_STATS_INTERVAL,
+        g_param_spec_uint ("stats-interval", "Stats interval",
+            "Interval in ms between statistics messages (0 = disabled)",
+            0, G_MAXUINT, DEFAULT_STATS_INTERVAL,
+            G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
     for (i = 0; i < n_properties; i++) {
       guint property_id = i + PROP_LAST;
@@ -238,6 +318,9 @@ gst_fake_video_sink_init (GstFakeVideoSink * self)
   child = gst_element_factory_make ("fakesink", "sink");
 
   self->allocation_meta_flags = ALLOCATION_META_DEFAULT_FLAGS;
+  self->stats_interval = DEFAULT_STATS_INTERVAL;
+  self->interval_ts = GST_CLOCK_TIME_NONE;
+  gst_video_sink_stats_init (&self->stats);
 
   if (child) {
     GstPad *sink_pad = gst_element_get_static_pad (child, "sink");
@@ -253,6 +336,9 @@ gst_fake_video_sink_init (GstFakeVideoSink * self)
     ghost_pad = gst_ghost_pad_new_from_template ("sink", sink_pad, template);
     gst_object_unref (template);
     gst_element_add_pad (GST_ELEMENT (self), ghost_pad);
+    gst_pad_add_probe (sink_pad, GST_PAD_PROBE_TYPE_BUFFER |
+        GST_PAD_PROBE_TYPE_EVENT_UPSTREAM, gst_fake_video_sink_stats_probe,
+        self, NULL);
     gst_object_unref (sink_pad);
 
     gst_pad_set_query_function (ghost_pad, gst_fake_video_sink_query);
@@ -278,6 +364,11 @@ gst_fake_video_sink_get_property (GObject * object, guint property_id,
       g_value_set_flags (value, self->allocation_meta_flags);
       GST_OBJECT_UNLOCK (self);
       break;
+    case PROP_STATS_INTERVAL:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint (value, self->stats_interval / GST_MSECOND);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       g_object_get_property (G_OBJECT (self->child), pspec->name, value);
       break;
@@ -296,21 +387,72 @@ gst_fake_video_sink_set_property (GObject * object, guint property_id,
       self->allocation_meta_flags = g_value_get_flags (value);
       GST_OBJECT_UNLOCK (self);
       break;
+    case PROP_STATS_INTERVAL:
+      GST_OBJECT_LOCK (self);
+      self->stats_interval = GST_MSECOND * (GstClockTime)
+          g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       g_object_set_property (G_OBJECT (self->child), pspec->name, value);
       break;
   }
 }
 
+static void
+gst_fake_video_sink_handle_message (GstBin * bin, GstMessage * message)
+{
+  GstFakeVideoSink *self = GST_FAKE_VIDEO_SINK (bin);
+
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_QOS) {
+    GstFormat format;
+    guint64 rendered, dropped;
+
+    gst_message_parse_qos_stats (message, &format, &rendered, &dropped);
+    if (format != GST_FORMAT_UNDEFINED) {
+      if (rendered != -1)
+        g_atomic_int_set (&self->frames_rendered, rendered);
+
+      if (dropped != -1)
+        g_atomic_int_set (&self->frames_dropped, dropped);
+    }
+  }
+
+  GST_BIN_CLASS (gst_fake_video_sink_parent_class)->handle_message (bin,
+      message);
+}
+
+static GstStateChangeReturn
+gst_fake_video_sink_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstFakeVideoSink *self = GST_FAKE_VIDEO_SINK (element);
+
+  if (transition == GST_STATE_CHANGE_READY_TO_PAUSED) {
+    g_atomic_int_set (&self->frames_rendered, 0);
+    g_atomic_int_set (&self->frames_dropped, 0);
+    self->interval_ts = GST_CLOCK_TIME_NONE;
+    gst_video_sink_stats_init (&self->stats);
+  }
+
+  return
+      GST_ELEMENT_CLASS (gst_fake_video_sink_parent_class)->change_state
+      (element, transition);
+}
+
 static void
 gst_fake_video_sink_class_init (GstFakeVideoSinkClass * klass)
 {
   GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GstBinClass *bin_class = GST_BIN_CLASS (klass);
 
   object_class->get_property = gst_fake_video_sink_get_property;
   object_class->set_property = gst_fake_video_sink_set_property;
 
+  element_class->change_state = gst_fake_video_sink_change_state;
+  bin_class->handle_message = gst_fake_video_sink_handle_message;
+
   gst_element_class_add_static_pad_template (element_class, &sink_factory);
   gst_element_class_set_static_metadata (element_class, "Fake Video Sink",
       "Video/Sink", "Fake video display that allows zero-copy",
@@ -24,6 +24,8 @@
 
 #include <gst/gst.h>
 
+#include "gstvideosinkstats.h"
+
 /**
  * GstFakeVideoSinkAllocationMetaFlags:
  * @GST_ALLOCATION_FLAG_CROP_META: Expose the crop meta as supported
@@ -65,6 +67,11 @@ struct _GstFakeVideoSink
     GstBin parent;
     GstElement *child;
     GstFakeVideoSinkAllocationMetaFlags allocation_meta_flags;
+
+    GstClockTime stats_interval;
+    gint frames_rendered, frames_dropped; /* ATOMIC */
+    GstClockTime interval_ts;
+    GstVideoSinkStats stats;
 };
 
 struct _GstFakeVideoSinkClass
@@ -0,0 +1,119 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstvideosinkstats.h"
+
+#include <string.h>
+
+void
+gst_video_sink_stats_init (GstVideoSinkStats * stats)
+{
+  stats->last_arrival = GST_CLOCK_TIME_NONE;
+  gst_video_sink_stats_reset (stats);
+}
+
+/* starts a new interval, keeping the last arrival time so that the first
+ * buffer of the interval still gets its inter-arrival time accounted */
+void
+gst_video_sink_stats_reset (GstVideoSinkStats * stats)
+{
+  stats->arrivals = 0;
+  stats->arrival_min = GST_CLOCK_TIME_NONE;
+  stats->arrival_max = 0;
+  stats->arrival_sum = 0;
+  memset (stats->histogram, 0, sizeof (stats->histogram));
+
+  stats->jitters = 0;
+  stats->jitter_min = G_MAXINT64;
+  stats->jitter_max = G_MININT64;
+  stats->jitter_sum = 0;
+}
+
+void
+gst_video_sink_stats_add_arrival (GstVideoSinkStats * stats, GstClockTime ts)
+{
+  GstClockTime delta;
+  guint bucket;
+
+  if (GST_CLOCK_TIME_IS_VALID (stats->last_arrival)
+      && ts >= stats->last_arrival) {
+    delta = ts - stats->last_arrival;
+
+    stats->arrivals++;
+    stats->arrival_sum += delta;
+    if (delta < stats->arrival_min)
+      stats->arrival_min = delta;
+    if (delta > stats->arrival_max)
+      stats->arrival_max = delta;
+
+    bucket = g_bit_storage (delta / GST_USECOND);
+    if (delta < GST_USECOND)
+      bucket = 0;
+    bucket = MIN (bucket, GST_VIDEO_SINK_STATS_HISTOGRAM_SIZE - 1);
+    stats->histogram[bucket]++;
+  }
+
+  stats->last_arrival = ts;
+}
+
+void
+gst_video_sink_stats_add_jitter (GstVideoSinkStats * stats,
+    GstClockTimeDiff jitter)
+{
+  stats->jitters++;
+  stats->jitter_sum += jitter;
+  if (jitter < stats->jitter_min)
+    stats->jitter_min = jitter;
+  if (jitter > stats->jitter_max)
+    stats->jitter_max = jitter;
+}
+
+void
+gst_video_sink_stats_fill_structure (const GstVideoSinkStats * stats,
+    GstStructure * s)
+{
+  GValue histogram = G_VALUE_INIT;
+  GValue bucket = G_VALUE_INIT;
+  guint i;
+
+  gst_structure_set (s,
+      "inter-arrival-samples", G_TYPE_UINT64, stats->arrivals,
+      "inter-arrival-min", G_TYPE_UINT64,
+      stats->arrivals ? stats->arrival_min : 0,
+      "inter-arrival-max", G_TYPE_UINT64, stats->arrival_max,
+      "inter-arrival-average", G_TYPE_UINT64,
+      stats->arrivals ? stats->arrival_sum / stats->arrivals : 0,
+      "jitter-samples", G_TYPE_UINT64, stats->jitters,
+      "jitter-min", G_TYPE_INT64, stats->jitters ? stats->jitter_min : 0,
+      "jitter-max", G_TYPE_INT64, stats->jitters ? stats->jitter_max : 0,
+      "jitter-average", G_TYPE_INT64,
+      stats->jitters ? stats->jitter_sum / (gint64) stats->jitters : 0, NULL);
+
+  gst_value_array_init (&histogram, GST_VIDEO_SINK_STATS_HISTOGRAM_SIZE);
+  g_value_init (&bucket, G_TYPE_UINT);
+  for (i = 0; i < GST_VIDEO_SINK_STATS_HISTOGRAM_SIZE; i++) {
+    g_value_set_uint (&bucket, stats->histogram[i]);
+    gst_value_array_append_value (&histogram, &bucket);
+  }
+  g_value_unset (&bucket);
+  gst_structure_take_value (s, "inter-arrival-histogram", &histogram);
+}
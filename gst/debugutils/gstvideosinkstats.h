@@ -0,0 +1,66 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _GST_VIDEO_SINK_STATS_H_
+#define _GST_VIDEO_SINK_STATS_H_
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* bucket 0 counts inter-arrival times below 1us, bucket n the ones in
+ * [2^(n-1), 2^n) us and the last bucket everything above */
+#define GST_VIDEO_SINK_STATS_HISTOGRAM_SIZE 24
+
+typedef struct _GstVideoSinkStats GstVideoSinkStats;
+
+/* Per interval timing statistics of the buffers reaching a video sink.
+ * Everything in here is only touched from the streaming thread: buffers
+ * arrive there and the sinks send their QoS events from there too. */
+struct _GstVideoSinkStats
+{
+  GstClockTime last_arrival;
+
+  guint64 arrivals;
+  GstClockTime arrival_min;
+  GstClockTime arrival_max;
+  GstClockTime arrival_sum;
+  guint histogram[GST_VIDEO_SINK_STATS_HISTOGRAM_SIZE];
+
+  guint64 jitters;
+  GstClockTimeDiff jitter_min;
+  GstClockTimeDiff jitter_max;
+  GstClockTimeDiff jitter_sum;
+};
+
+void gst_video_sink_stats_init (GstVideoSinkStats * stats);
+
+void gst_video_sink_stats_reset (GstVideoSinkStats * stats);
+
+void gst_video_sink_stats_add_arrival (GstVideoSinkStats * stats,
+    GstClockTime ts);
+
+void gst_video_sink_stats_add_jitter (GstVideoSinkStats * stats,
+    GstClockTimeDiff jitter);
+
+void gst_video_sink_stats_fill_structure (const GstVideoSinkStats * stats,
+    GstStructure * s);
+
+G_END_DECLS
+
+#endif
@@ -33,6 +33,14 @@
  * This element is currently intended for transcoding pipelines,
  * although may be useful in other contexts.
  *
+ * All watchdog instances of a process share a single timer thread, so
+ * using one watchdog per stream is cheap even with many streams. The
+ * error message posted when a watchdog triggers carries a
+ * `watchdog-stall` details structure with the time since the last buffer,
+ * the PTS of that buffer and a snapshot of the fill level of every queue
+ * and queue2 of the pipeline in its `queue-levels` array. The same
+ * information is also part of the debug string.
+ *
  * ## Example launch line
  * |[
  * gst-launch-1.0 -v fakesrc ! watchdog ! fakesink
@@ -78,6 +86,28 @@ enum
   PROP_TIMEOUT
 };
 
+/* The timer shared by all watchdogs is a hashed timer wheel: a watchdog
+ * is queued in the slot of the tick its deadline falls in. Feeding only
+ * moves the deadline and the entry is requeued lazily once its slot comes
+ * up, so the common case per buffer is an assignment under the timer
+ * lock. */
+#define WATCHDOG_TICK (10 * G_TIME_SPAN_MILLISECOND)
+#define WATCHDOG_WHEEL_SIZE 256
+
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+
+  GQueue slots[WATCHDOG_WHEEL_SIZE];
+  guint n_scheduled;
+  /* last processed tick and the one the thread sleeps until */
+  gint64 tick;
+  gint64 wakeup_tick;
+} GstWatchdogTimer;
+
+static void gst_watchdog_trigger (GstWatchdog * watchdog);
+
 /* class initialization */
 
 G_DEFINE_TYPE_WITH_CODE (GstWatchdog, gst_watchdog, GST_TYPE_BASE_TRANSFORM,
@@ -127,6 +157,10 @@ gst_watchdog_class_init (GstWatchdogClass * klass)
 static void
 gst_watchdog_init (GstWatchdog * watchdog)
 {
+  watchdog->timer_link.data = watchdog;
+  watchdog->timer_tick = -1;
+  watchdog->last_buffer_time = -1;
+  watchdog->last_buffer_pts = GST_CLOCK_TIME_NONE;
 }
 
 static void
@@ -168,50 +202,305 @@ gst_watchdog_get_property (GObject * object, guint property_id,
   }
 }
 
+static gint64
+gst_watchdog_timer_next_tick (GstWatchdogTimer * timer)
+{
+  gint64 tick;
+
+  for (tick = timer->tick + 1; tick < timer->tick + WATCHDOG_WHEEL_SIZE;
+      tick++) {
+    if (!g_queue_is_empty (&timer->slots[tick % WATCHDOG_WHEEL_SIZE]))
+      break;
+  }
+
+  return tick;
+}
+
+/* Call with the timer lock taken, returns the expired watchdogs */
+static GList *
+gst_watchdog_timer_advance (GstWatchdogTimer * timer, gint64 now)
+{
+  GList *expired = NULL;
+  gint64 now_tick = now / WATCHDOG_TICK;
+
+  /* one revolution visits every slot, skip the rest if we fell behind */
+  if (now_tick - timer->tick > WATCHDOG_WHEEL_SIZE)
+    timer->tick = now_tick - WATCHDOG_WHEEL_SIZE;
+
+  while (timer->tick < now_tick) {
+    GQueue *slot;
+    GList *l, *next;
+
+    timer->tick++;
+    slot = &timer->slots[timer->tick % WATCHDOG_WHEEL_SIZE];
+
+    for (l = slot->head; l; l = next) {
+      GstWatchdog *watchdog = l->data;
+      gint64 tick;
+
+      next = l->next;
+
+      /* queued for a later revolution */
+      if (watchdog->timer_tick > timer->tick)
+        continue;
+
+      g_queue_unlink (slot, l);
+
+      if (watchdog->deadline <= now) {
+        watchdog->timer_tick = -1;
+        timer->n_scheduled--;
+        expired = g_list_prepend (expired, gst_object_ref (watchdog));
+        continue;
+      }
+
+      /* fed since it was queued, requeue at the new deadline */
+      tick = (watchdog->deadline + WATCHDOG_TICK - 1) / WATCHDOG_TICK;
+      watchdog->timer_tick = tick;
+      g_queue_push_tail_link (&timer->slots[tick % WATCHDOG_WHEEL_SIZE], l);
+    }
+  }
+
+  return expired;
+}
+
 static gpointer
-gst_watchdog_thread (gpointer user_data)
+gst_watchdog_timer_thread (gpointer user_data)
 {
-  GstWatchdog *watchdog = GST_WATCHDOG (user_data);
+  GstWatchdogTimer *timer = user_data;
 
-  GST_DEBUG_OBJECT (watchdog, "thread starting");
+  GST_DEBUG ("shared timer thread starting");
 
-  g_main_loop_run (watchdog->main_loop);
+  g_mutex_lock (&timer->lock);
+  while (TRUE) {
+    GList *expired;
 
-  GST_DEBUG_OBJECT (watchdog, "thread exiting");
+    expired = gst_watchdog_timer_advance (timer, g_get_monotonic_time ());
+    if (expired) {
+      g_mutex_unlock (&timer->lock);
+      g_list_foreach (expired, (GFunc) gst_watchdog_trigger, NULL);
+      g_list_free_full (expired, gst_object_unref);
+      g_mutex_lock (&timer->lock);
+      continue;
+    }
+
+    if (timer->n_scheduled == 0) {
+      timer->wakeup_tick = G_MAXINT64;
+      g_cond_wait (&timer->cond, &timer->lock);
+    } else {
+      timer->wakeup_tick = gst_watchdog_timer_next_tick (timer);
+      g_cond_wait_until (&timer->cond, &timer->lock,
+          timer->wakeup_tick * WATCHDOG_TICK);
+    }
+  }
+  g_mutex_unlock (&timer->lock);
 
   return NULL;
 }
 
-static gboolean
-gst_watchdog_trigger (gpointer ptr)
+/* The timer thread is created on first use and then kept around for the
+ * lifetime of the process; it sleeps when no watchdog is scheduled. */
+static GstWatchdogTimer *
+gst_watchdog_timer_get (void)
 {
-  GstWatchdog *watchdog = GST_WATCHDOG (ptr);
+  static gsize timer = 0;
 
-  GST_DEBUG_OBJECT (watchdog, "watchdog triggered");
+  if (g_once_init_enter (&timer)) {
+    GstWatchdogTimer *t = g_new0 (GstWatchdogTimer, 1);
+    guint i;
+
+    g_mutex_init (&t->lock);
+    g_cond_init (&t->cond);
+    for (i = 0; i < WATCHDOG_WHEEL_SIZE; i++)
+      g_queue_init (&t->slots[i]);
+    t->tick = g_get_monotonic_time () / WATCHDOG_TICK;
+    t->wakeup_tick = G_MAXINT64;
+
+    g_thread_unref (g_thread_new ("watchdog", gst_watchdog_timer_thread, t));
 
-  GST_ELEMENT_ERROR (watchdog, STREAM, FAILED, ("Watchdog triggered"),
-      ("Watchdog triggered"));
+    g_once_init_leave (&timer, (gsize) t);
+  }
 
-  return FALSE;
+  return (GstWatchdogTimer *) timer;
 }
 
-static gboolean
-gst_watchdog_quit_mainloop (gpointer ptr)
+static void
+gst_watchdog_schedule (GstWatchdog * watchdog, gint64 deadline)
+{
+  GstWatchdogTimer *timer = gst_watchdog_timer_get ();
+  gint64 tick;
+
+  g_mutex_lock (&timer->lock);
+  watchdog->deadline = deadline;
+
+  tick = (deadline + WATCHDOG_TICK - 1) / WATCHDOG_TICK;
+  if (tick <= timer->tick)
+    tick = timer->tick + 1;
+
+  /* a later deadline is picked up when the current slot comes up */
+  if (watchdog->timer_tick < 0 || tick < watchdog->timer_tick) {
+    if (watchdog->timer_tick < 0)
+      timer->n_scheduled++;
+    else
+      g_queue_unlink (&timer->slots[watchdog->timer_tick %
+              WATCHDOG_WHEEL_SIZE], &watchdog->timer_link);
+
+    watchdog->timer_tick = tick;
+    g_queue_push_tail_link (&timer->slots[tick % WATCHDOG_WHEEL_SIZE],
+        &watchdog->timer_link);
+
+    if (tick < timer->wakeup_tick)
+      g_cond_signal (&timer->cond);
+  }
+  g_mutex_unlock (&timer->lock);
+}
+
+static void
+gst_watchdog_unschedule (GstWatchdog * watchdog)
 {
-  GstWatchdog *watchdog = GST_WATCHDOG (ptr);
+  GstWatchdogTimer *timer = gst_watchdog_timer_get ();
+
+  g_mutex_lock (&timer->lock);
+  if (watchdog->timer_tick >= 0) {
+    g_queue_unlink (&timer->slots[watchdog->timer_tick % WATCHDOG_WHEEL_SIZE],
+        &watchdog->timer_link);
+    watchdog->timer_tick = -1;
+    timer->n_scheduled--;
+  }
+  g_mutex_unlock (&timer->lock);
+}
+
+static guint64
+gst_watchdog_get_level (GObject * object, const gchar * name)
+{
+  GParamSpec *pspec;
+  GValue value = G_VALUE_INIT;
+  GValue level = G_VALUE_INIT;
+  guint64 ret = 0;
+
+  pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (object), name);
+  if (!pspec)
+    return 0;
+
+  g_value_init (&value, pspec->value_type);
+  g_value_init (&level, G_TYPE_UINT64);
+  g_object_get_property (object, name, &value);
+  if (g_value_transform (&value, &level))
+    ret = g_value_get_uint64 (&level);
+  g_value_unset (&level);
+  g_value_unset (&value);
+
+  return ret;
+}
+
+typedef struct
+{
+  GString *debug;
+  GValue levels;
+} QueueLevels;
+
+static void
+gst_watchdog_add_queue_level (const GValue * item, QueueLevels * levels)
+{
+  GstElement *element = g_value_get_object (item);
+  GValue value = G_VALUE_INIT;
+  GstStructure *s;
+  guint64 buffers, bytes, time;
+
+  if (!g_object_class_find_property (G_OBJECT_GET_CLASS (element),
+          "current-level-buffers"))
+    return;
+
+  buffers = gst_watchdog_get_level (G_OBJECT (element),
+      "current-level-buffers");
+  bytes = gst_watchdog_get_level (G_OBJECT (element), "current-level-bytes");
+  time = gst_watchdog_get_level (G_OBJECT (element), "current-level-time");
+
+  g_string_append_printf (levels->debug, "\n%s: %" G_GUINT64_FORMAT
+      " buffers, %" G_GUINT64_FORMAT " bytes, %" GST_TIME_FORMAT,
+      GST_ELEMENT_NAME (element), buffers, bytes, GST_TIME_ARGS (time));
+
+  s = gst_structure_new ("queue-level",
+      "name", G_TYPE_STRING, GST_ELEMENT_NAME (element),
+      "buffers", G_TYPE_UINT64, buffers,
+      "bytes", G_TYPE_UINT64, bytes, "time", G_TYPE_UINT64, time, NULL);
+  g_value_init (&value, GST_TYPE_STRUCTURE);
+  g_value_take_boxed (&value, s);
+  gst_value_array_append_and_take_value (&levels->levels, &value);
+}
+
+static void
+gst_watchdog_trigger (GstWatchdog * watchdog)
+{
+  GstObject *top, *parent;
+  GstStructure *details;
+  QueueLevels levels = { NULL, G_VALUE_INIT };
+  gint64 last_buffer_time;
+  GstClockTime last_buffer_pts;
+  gint timeout;
+
+  GST_DEBUG_OBJECT (watchdog, "watchdog triggered");
 
-  GST_DEBUG_OBJECT (watchdog, "watchdog quit");
+  GST_OBJECT_LOCK (watchdog);
+  timeout = watchdog->timeout;
+  last_buffer_time = watchdog->last_buffer_time;
+  last_buffer_pts = watchdog->last_buffer_pts;
+  GST_OBJECT_UNLOCK (watchdog);
+
+  levels.debug = g_string_new ("Watchdog triggered");
+  details = gst_structure_new ("watchdog-stall",
+      "timeout", G_TYPE_UINT64, timeout * GST_MSECOND, NULL);
 
-  g_main_loop_quit (watchdog->main_loop);
+  if (last_buffer_time >= 0) {
+    GstClockTime stalled_for =
+        (g_get_monotonic_time () - last_buffer_time) * GST_USECOND;
+
+    g_string_append_printf (levels.debug, ", no buffer for %"
+        GST_TIME_FORMAT ", last buffer PTS %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (stalled_for), GST_TIME_ARGS (last_buffer_pts));
+    gst_structure_set (details, "stalled-for", G_TYPE_UINT64, stalled_for,
+        "last-buffer-pts", G_TYPE_UINT64, last_buffer_pts, NULL);
+  } else {
+    g_string_append (levels.debug, ", no buffer received yet");
+  }
+
+  /* snapshot the queue levels of the whole pipeline to help telling where
+   * data got stuck */
+  top = gst_object_ref (watchdog);
+  while ((parent = gst_object_get_parent (top))) {
+    gst_object_unref (top);
+    top = parent;
+  }
+
+  gst_value_array_init (&levels.levels, 0);
+  if (GST_IS_BIN (top)) {
+    GstIterator *it = gst_bin_iterate_recurse (GST_BIN (top));
+
+    /* a partial snapshot is fine if the pipeline changes meanwhile */
+    gst_iterator_foreach (it, (GstIteratorForeachFunction)
+        gst_watchdog_add_queue_level, &levels);
+    gst_iterator_free (it);
+  }
+  gst_object_unref (top);
+  gst_structure_take_value (details, "queue-levels", &levels.levels);
 
-  return FALSE;
+  gst_element_message_full_with_details (GST_ELEMENT (watchdog),
+      GST_MESSAGE_ERROR, GST_STREAM_ERROR, GST_STREAM_ERROR_FAILED,
+      g_strdup ("Watchdog triggered"), g_string_free (levels.debug, FALSE),
+      __FILE__, GST_FUNCTION, __LINE__, details);
 }
 
 /*  Call with OBJECT_LOCK taken */
 static void
 gst_watchdog_feed (GstWatchdog * watchdog, gpointer mini_object, gboolean force)
 {
-  if (watchdog->source) {
+  gint64 now = g_get_monotonic_time ();
+
+  if (mini_object && GST_IS_BUFFER (mini_object)) {
+    watchdog->last_buffer_time = now;
+    watchdog->last_buffer_pts = GST_BUFFER_PTS (mini_object);
+  }
+
+  if (watchdog->scheduled) {
     if (watchdog->waiting_for_flush_start) {
       if (mini_object && GST_IS_EVENT (mini_object) &&
           GST_EVENT_TYPE (mini_object) == GST_EVENT_FLUSH_START) {
@@ -238,24 +527,25 @@ gst_watchdog_feed (GstWatchdog * watchdog, gpointer mini_object, gboolean force)
         force = TRUE;
       }
     }
-    g_source_destroy (watchdog->source);
-    g_source_unref (watchdog->source);
-    watchdog->source = NULL;
-
   }
 
   if (watchdog->timeout == 0) {
     GST_LOG_OBJECT (watchdog, "Timeout is 0 => nothing to do");
-  } else if (watchdog->main_context == NULL) {
-    GST_LOG_OBJECT (watchdog, "No maincontext => nothing to do");
+  } else if (!watchdog->started) {
+    GST_LOG_OBJECT (watchdog, "Not started => nothing to do");
   } else if ((GST_STATE (watchdog) != GST_STATE_PLAYING) && force == FALSE) {
     GST_LOG_OBJECT (watchdog,
         "Not in playing and force is FALSE => Nothing to do");
   } else {
-    watchdog->source = g_timeout_source_new (watchdog->timeout);
-    g_source_set_callback (watchdog->source, gst_watchdog_trigger,
-        gst_object_ref (watchdog), gst_object_unref);
-    g_source_attach (watchdog->source, watchdog->main_context);
+    gst_watchdog_schedule (watchdog,
+        now + watchdog->timeout * G_TIME_SPAN_MILLISECOND);
+    watchdog->scheduled = TRUE;
+    return;
+  }
+
+  if (watchdog->scheduled) {
+    gst_watchdog_unschedule (watchdog);
+    watchdog->scheduled = FALSE;
   }
 }
 
@@ -267,9 +557,9 @@ gst_watchdog_start (GstBaseTransform * trans)
   GST_DEBUG_OBJECT (watchdog, "start");
   GST_OBJECT_LOCK (watchdog);
 
-  watchdog->main_context = g_main_context_new ();
-  watchdog->main_loop = g_main_loop_new (watchdog->main_context, TRUE);
-  watchdog->thread = g_thread_new ("watchdog", gst_watchdog_thread, watchdog);
+  watchdog->started = TRUE;
+  watchdog->last_buffer_time = -1;
+  watchdog->last_buffer_pts = GST_CLOCK_TIME_NONE;
 
   GST_OBJECT_UNLOCK (watchdog);
   return TRUE;
@@ -279,33 +569,15 @@ static gboolean
 gst_watchdog_stop (GstBaseTransform * trans)
 {
   GstWatchdog *watchdog = GST_WATCHDOG (trans);
-  GSource *quit_source;
 
   GST_DEBUG_OBJECT (watchdog, "stop");
   GST_OBJECT_LOCK (watchdog);
 
-  if (watchdog->source) {
-    g_source_destroy (watchdog->source);
-    g_source_unref (watchdog->source);
-    watchdog->source = NULL;
+  if (watchdog->scheduled) {
+    gst_watchdog_unschedule (watchdog);
+    watchdog->scheduled = FALSE;
   }
-
-  /* dispatch an idle event that trigger g_main_loop_quit to avoid race
-   * between g_main_loop_run and g_main_loop_quit */
-  quit_source = g_idle_source_new ();
-  g_source_set_callback (quit_source, gst_watchdog_quit_mainloop, watchdog,
-      NULL);
-  g_source_attach (quit_source, watchdog->main_context);
-  g_source_unref (quit_source);
-
-  g_thread_join (watchdog->thread);
-  watchdog->thread = NULL;
-
-  g_main_loop_unref (watchdog->main_loop);
-  watchdog->main_loop = NULL;
-
-  g_main_context_unref (watchdog->main_context);
-  watchdog->main_context = NULL;
+  watchdog->started = FALSE;
 
   GST_OBJECT_UNLOCK (watchdog);
   return TRUE;
@@ -405,10 +677,9 @@ gst_watchdog_change_state (GstElement * element, GstStateChange transition)
     case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
       /* Disable the timer */
       GST_OBJECT_LOCK (watchdog);
-      if (watchdog->source) {
-        g_source_destroy (watchdog->source);
-        g_source_unref (watchdog->source);
-        watchdog->source = NULL;
+      if (watchdog->scheduled) {
+        gst_watchdog_unschedule (watchdog);
+        watchdog->scheduled = FALSE;
       }
       GST_OBJECT_UNLOCK (watchdog);
       break;
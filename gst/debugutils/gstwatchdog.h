@@ -41,10 +41,15 @@ struct _GstWatchdog
   /* properties */
   int timeout;
 
-  GMainContext *main_context;
-  GMainLoop *main_loop;
-  GThread *thread;
-  GSource *source;
+  gboolean started;
+  gboolean scheduled;
+  gint64 last_buffer_time;
+  GstClockTime last_buffer_pts;
+
+  /* protected by the lock of the shared timer */
+  GList timer_link;
+  gint64 timer_tick;
+  gint64 deadline;
 
   gboolean waiting_for_a_buffer;
   gboolean waiting_for_flush_start;
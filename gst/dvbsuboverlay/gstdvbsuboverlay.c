@@ -898,14 +898,74 @@ gst_dvbsub_overlay_chain_text (GstPad * pad, GstObject * parent,
   return GST_FLOW_OK;
 }
 
+static gboolean
+gst_dvbsub_overlay_rect_equal (const DVBSubtitleRect * a,
+    const DVBSubtitleRect * b)
+{
+  gint k;
+
+  if (a->w != b->w || a->h != b->h ||
+      a->pict.palette_bits_count != b->pict.palette_bits_count)
+    return FALSE;
+
+  if (memcmp (a->pict.palette, b->pict.palette,
+          (1 << a->pict.palette_bits_count) * sizeof (guint32)) != 0)
+    return FALSE;
+
+  for (k = 0; k < a->h; k++) {
+    if (memcmp (a->pict.data + k * a->pict.rowstride,
+            b->pict.data + k * b->pict.rowstride, a->w) != 0)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* Looks for a rectangle of @prev_comp, created from the regions of
+ * @prev_subs, showing the same picture as @srect at the same position, so
+ * that it can be reused as-is along with its cached conversions */
+static GstVideoOverlayRectangle *
+gst_dvbsub_overlay_find_rect (DVBSubtitles * prev_subs,
+    GstVideoOverlayComposition * prev_comp, const DVBSubtitleRect * srect,
+    gint rx, gint ry, guint rw, guint rh)
+{
+  guint j;
+
+  if (prev_subs == NULL || prev_comp == NULL ||
+      gst_video_overlay_composition_n_rectangles (prev_comp) !=
+      prev_subs->num_rects)
+    return NULL;
+
+  for (j = 0; j < prev_subs->num_rects; j++) {
+    GstVideoOverlayRectangle *rect;
+    gint x, y;
+    guint w, h;
+
+    rect = gst_video_overlay_composition_get_rectangle (prev_comp, j);
+    gst_video_overlay_rectangle_get_render_rectangle (rect, &x, &y, &w, &h);
+    if (x != rx || y != ry || w != rw || h != rh)
+      continue;
+
+    if (gst_dvbsub_overlay_rect_equal (&prev_subs->rects[j], srect))
+      return rect;
+  }
+
+  return NULL;
+}
+
+/* Converts the regions of @subs, reusing the unchanged rectangles of the
+ * previous page @prev_subs, with its composition @prev_comp. When nothing
+ * changed at all @prev_comp itself is returned, which lets downstream keep
+ * whatever it derived from it. */
 static GstVideoOverlayComposition *
 gst_dvbsub_overlay_subs_to_comp (GstDVBSubOverlay * overlay,
-    DVBSubtitles * subs)
+    DVBSubtitles * subs, DVBSubtitles * prev_subs,
+    GstVideoOverlayComposition * prev_comp)
 {
   GstVideoOverlayComposition *comp = NULL;
   GstVideoOverlayRectangle *rect;
   gint width, height, dw, dh, wx, wy;
-  gint i;
+  gint i, n_reused = 0;
 
   g_return_val_if_fail (subs != NULL && subs->num_rects > 0, NULL);
 
@@ -943,6 +1003,25 @@ gst_dvbsub_overlay_subs_to_comp (GstDVBSubOverlay * overlay,
     GST_LOG_OBJECT (overlay, "rectangle %d: %dx%d @ (%d, %d)", i,
         srect->w, srect->h, srect->x, srect->y);
 
+    /* this is assuming the subtitle rectangle coordinates are relative
+     * to the window (if there is one) within a display of specified dimension.
+     * Coordinate wrt the latter is then scaled to the actual dimension of
+     * the video we are dealing with here. */
+    rx = gst_util_uint64_scale (wx + srect->x, width, dw);
+    ry = gst_util_uint64_scale (wy + srect->y, height, dh);
+    rw = gst_util_uint64_scale (srect->w, width, dw);
+    rh = gst_util_uint64_scale (srect->h, height, dh);
+
+    rect = gst_dvbsub_overlay_find_rect (prev_subs, prev_comp, srect,
+        rx, ry, rw, rh);
+    if (rect) {
+      GST_LOG_OBJECT (overlay, "rectangle %d unchanged", i);
+      gst_video_overlay_rectangle_ref (rect);
+      if (rect == gst_video_overlay_composition_get_rectangle (prev_comp, i))
+        n_reused++;
+      goto add_rect;
+    }
+
     w = srect->w;
     h = srect->h;
 
@@ -965,15 +1044,6 @@ gst_dvbsub_overlay_subs_to_comp (GstDVBSubOverlay * overlay,
     }
     gst_buffer_unmap (buf, &map);
 
-    /* this is assuming the subtitle rectangle coordinates are relative
-     * to the window (if there is one) within a display of specified dimension.
-     * Coordinate wrt the latter is then scaled to the actual dimension of
-     * the video we are dealing with here. */
-    rx = gst_util_uint64_scale (wx + srect->x, width, dw);
-    ry = gst_util_uint64_scale (wy + srect->y, height, dh);
-    rw = gst_util_uint64_scale (srect->w, width, dw);
-    rh = gst_util_uint64_scale (srect->h, height, dh);
-
     GST_LOG_OBJECT (overlay, "rectangle %d rendered: %dx%d @ (%d, %d)", i,
         rw, rh, rx, ry);
 
@@ -981,13 +1051,22 @@ gst_dvbsub_overlay_subs_to_comp (GstDVBSubOverlay * overlay,
         GST_VIDEO_OVERLAY_COMPOSITION_FORMAT_YUV, w, h);
     rect = gst_video_overlay_rectangle_new_raw (buf, rx, ry, rw, rh, 0);
     g_assert (rect);
+    gst_buffer_unref (buf);
+
+  add_rect:
     if (comp) {
       gst_video_overlay_composition_add_rectangle (comp, rect);
     } else {
       comp = gst_video_overlay_composition_new (rect);
     }
     gst_video_overlay_rectangle_unref (rect);
-    gst_buffer_unref (buf);
+  }
+
+  if (n_reused == subs->num_rects &&
+      gst_video_overlay_composition_n_rectangles (prev_comp) == n_reused) {
+    GST_LOG_OBJECT (overlay, "page unchanged, keeping composition");
+    gst_video_overlay_composition_unref (comp);
+    comp = gst_video_overlay_composition_ref (prev_comp);
   }
 
   return comp;
@@ -1057,6 +1136,7 @@ gst_dvbsub_overlay_chain_video (GstPad * pad, GstObject * parent,
   g_mutex_lock (&overlay->dvbsub_mutex);
   if (!g_queue_is_empty (overlay->pending_subtitles)) {
     DVBSubtitles *tmp, *candidate = NULL;
+    GstVideoOverlayComposition *comp;
 
     while (!g_queue_is_empty (overlay->pending_subtitles)) {
       tmp = g_queue_peek_head (overlay->pending_subtitles);
@@ -1095,12 +1175,13 @@ gst_dvbsub_overlay_chain_video (GstPad * pad, GstObject * parent,
           GST_TIME_FORMAT ") - it has %u regions",
           GST_TIME_ARGS (vid_running_time), GST_TIME_ARGS (candidate->pts),
           candidate->num_rects);
+      comp = gst_dvbsub_overlay_subs_to_comp (overlay, candidate,
+          overlay->current_subtitle, overlay->current_comp);
       dvb_subtitles_free (overlay->current_subtitle);
       overlay->current_subtitle = candidate;
       if (overlay->current_comp)
         gst_video_overlay_composition_unref (overlay->current_comp);
-      overlay->current_comp =
-          gst_dvbsub_overlay_subs_to_comp (overlay, overlay->current_subtitle);
+      overlay->current_comp = comp;
     }
   }
 
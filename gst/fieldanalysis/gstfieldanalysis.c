@@ -82,6 +82,10 @@ GST_DEBUG_CATEGORY_STATIC (gst_field_analysis_debug);
 #define DEFAULT_BLOCK_HEIGHT 16
 #define DEFAULT_BLOCK_THRESH 80
 #define DEFAULT_IGNORED_LINES 2
+#define DEFAULT_N_THREADS 1
+#define DEFAULT_LINE_STEP 1
+
+#define MIN_LINES_PER_JOB 16
 
 enum
 {
@@ -96,7 +100,9 @@ enum
   PROP_BLOCK_WIDTH,
   PROP_BLOCK_HEIGHT,
   PROP_BLOCK_THRESH,
-  PROP_IGNORED_LINES
+  PROP_IGNORED_LINES,
+  PROP_N_THREADS,
+  PROP_LINE_STEP
 };
 
 static GstStaticPadTemplate sink_factory =
@@ -274,6 +280,34 @@ gst_field_analysis_class_init (GstFieldAnalysisClass * klass)
           "Ignore this many lines from the top and bottom for windowed comb detection",
           2, G_MAXUINT64, DEFAULT_IGNORED_LINES,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstFieldAnalysis:n-threads:
+   *
+   * Maximum number of threads used to compute the field and frame metrics,
+   * each thread handling a slice of the lines of a field. 0 means one thread
+   * per CPU.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use", 0, G_MAXUINT,
+          DEFAULT_N_THREADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstFieldAnalysis:line-step:
+   *
+   * Only compute the field and 5-tap frame metrics on every Nth line of each
+   * field. The result is scaled to the whole field so the thresholds keep
+   * their meaning, trading accuracy for speed on large frames. The windowed
+   * comb detection is not affected.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_LINE_STEP,
+      g_param_spec_uint ("line-step", "Line step",
+          "Compute the metrics on every Nth line of each field only",
+          1, G_MAXUINT16, DEFAULT_LINE_STEP,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_field_analysis_change_state);
@@ -361,6 +395,10 @@ gst_field_analysis_init (GstFieldAnalysis * filter)
   filter->block_height = DEFAULT_BLOCK_HEIGHT;
   filter->block_thresh = DEFAULT_BLOCK_THRESH;
   filter->ignored_lines = DEFAULT_IGNORED_LINES;
+  filter->n_threads = DEFAULT_N_THREADS;
+  filter->line_step = DEFAULT_LINE_STEP;
+  g_mutex_init (&filter->jobs_lock);
+  g_cond_init (&filter->jobs_cond);
 }
 
 static void
@@ -448,6 +486,16 @@ gst_field_analysis_set_property (GObject * object, guint prop_id,
     case PROP_IGNORED_LINES:
       filter->ignored_lines = g_value_get_uint64 (value);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      filter->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (filter);
+      break;
+    case PROP_LINE_STEP:
+      GST_OBJECT_LOCK (filter);
+      filter->line_step = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -522,6 +570,16 @@ gst_field_analysis_get_property (GObject * object, guint prop_id,
     case PROP_IGNORED_LINES:
       g_value_set_uint64 (value, filter->ignored_lines);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (filter);
+      g_value_set_uint (value, filter->n_threads);
+      GST_OBJECT_UNLOCK (filter);
+      break;
+    case PROP_LINE_STEP:
+      GST_OBJECT_LOCK (filter);
+      g_value_set_uint (value, filter->line_step);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -805,121 +863,233 @@ gst_field_analysis_sink_event (GstPad * pad, GstObject * parent,
 }
 
 
+/* the same and opposite parity metrics are computed over the lines of one
+ * field: f1 is the first line of the field of interest and f2 the first line
+ * of the field it is compared to, with stride1/stride2 being the distance
+ * between two lines of the same field */
+typedef struct
+{
+  const guint8 *f1, *f2;
+  gint stride1, stride2;
+  gint width, incr;
+  guint32 noise_floor;
+  gint nlines;
+  gint line_step;
+} FieldAnalysisMetric;
+
+typedef guint64 (*FieldAnalysisRowsFunc) (const FieldAnalysisMetric * metric,
+    gint j_start, gint j_end);
+
+typedef struct
+{
+  GstFieldAnalysis *filter;
+  const FieldAnalysisMetric *metric;
+  FieldAnalysisRowsFunc func;
+  gint j_start, j_end;
+  guint64 sum;
+} FieldAnalysisJob;
+
+/* first line >= j_start that is sampled with the given line step, so that the
+ * sampled lines do not depend on how the field has been sliced */
+static inline gint
+field_analysis_first_line (const FieldAnalysisMetric * metric, gint j_start)
+{
+  return j_start + (metric->line_step - j_start % metric->line_step) %
+      metric->line_step;
+}
+
+static void
+field_analysis_metric_init (FieldAnalysisMetric * metric,
+    GstFieldAnalysis * filter, GstVideoFrame * frame1, gint offset1,
+    GstVideoFrame * frame2, gint offset2, guint32 noise_floor)
+{
+  metric->f1 = (guint8 *) GST_VIDEO_FRAME_COMP_DATA (frame1, 0) +
+      GST_VIDEO_FRAME_COMP_OFFSET (frame1, 0) + offset1;
+  metric->f2 = (guint8 *) GST_VIDEO_FRAME_COMP_DATA (frame2, 0) +
+      GST_VIDEO_FRAME_COMP_OFFSET (frame2, 0) + offset2;
+  metric->stride1 = GST_VIDEO_FRAME_COMP_STRIDE (frame1, 0) << 1;
+  metric->stride2 = GST_VIDEO_FRAME_COMP_STRIDE (frame2, 0) << 1;
+  metric->width = GST_VIDEO_FRAME_WIDTH (frame1);
+  metric->incr = GST_VIDEO_FRAME_COMP_PSTRIDE (frame1, 0);
+  metric->noise_floor = noise_floor;
+  metric->nlines = GST_VIDEO_FRAME_HEIGHT (frame1) >> 1;
+  metric->line_step = filter->line_step;
+}
+
+static void
+gst_field_analysis_metric_job (gpointer data, gpointer user_data)
+{
+  FieldAnalysisJob *job = data;
+  GstFieldAnalysis *filter = job->filter;
+
+  job->sum = job->func (job->metric, job->j_start, job->j_end);
+
+  g_mutex_lock (&filter->jobs_lock);
+  if (--filter->jobs_pending == 0)
+    g_cond_signal (&filter->jobs_cond);
+  g_mutex_unlock (&filter->jobs_lock);
+}
+
+/* runs func over all lines of the field, split in slices of lines across the
+ * worker threads, and returns the sum of the per-slice results. When only a
+ * subset of the lines is sampled the sum is scaled to the whole field so that
+ * the thresholds remain valid.
+ *
+ * must be called with the object lock */
 static gfloat
-same_parity_sad (GstFieldAnalysis * filter, FieldAnalysisFields (*history)[2])
+gst_field_analysis_run_metric (GstFieldAnalysis * filter,
+    const FieldAnalysisMetric * metric, FieldAnalysisRowsFunc func)
 {
-  gint j;
-  gfloat sum;
-  guint8 *f1j, *f2j;
+  FieldAnalysisJob *jobs;
+  guint n_jobs, i;
+  gint rows, nsampled;
+  guint64 sum;
 
-  const gint width = GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame);
-  const gint height = GST_VIDEO_FRAME_HEIGHT (&(*history)[0].frame);
-  const gint stride0x2 =
-      GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0) << 1;
-  const gint stride1x2 =
-      GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame, 0) << 1;
-  const guint32 noise_floor = filter->noise_floor;
-
-  f1j =
-      GST_VIDEO_FRAME_COMP_DATA (&(*history)[0].frame,
-      0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[0].frame,
-      0) +
-      (*history)[0].parity * GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame,
-      0);
-  f2j =
-      GST_VIDEO_FRAME_COMP_DATA (&(*history)[1].frame,
-      0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[1].frame,
-      0) +
-      (*history)[1].parity * GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame,
-      0);
+  if (metric->nlines <= 0)
+    return 0.0f;
+
+  n_jobs = filter->n_threads;
+  if (n_jobs == 0)
+    n_jobs = g_get_num_processors ();
+  n_jobs = CLAMP (metric->nlines / MIN_LINES_PER_JOB, 1, n_jobs);
+
+  if (n_jobs == 1) {
+    sum = func (metric, 0, metric->nlines);
+  } else {
+    if (filter->pool == NULL) {
+      filter->pool = g_thread_pool_new (gst_field_analysis_metric_job, NULL,
+          -1, FALSE, NULL);
+    }
+
+    jobs = g_newa (FieldAnalysisJob, n_jobs);
+    rows = (metric->nlines + n_jobs - 1) / n_jobs;
 
-  sum = 0.0f;
-  for (j = 0; j < (height >> 1); j++) {
+    for (i = 0; i < n_jobs; i++) {
+      jobs[i].filter = filter;
+      jobs[i].metric = metric;
+      jobs[i].func = func;
+      jobs[i].j_start = MIN (i * rows, metric->nlines);
+      jobs[i].j_end = MIN ((i + 1) * rows, metric->nlines);
+      jobs[i].sum = 0;
+    }
+
+    filter->jobs_pending = n_jobs - 1;
+    for (i = 1; i < n_jobs; i++)
+      g_thread_pool_push (filter->pool, &jobs[i], NULL);
+
+    /* do the first slice from the streaming thread */
+    sum = func (metric, jobs[0].j_start, jobs[0].j_end);
+
+    g_mutex_lock (&filter->jobs_lock);
+    while (filter->jobs_pending > 0)
+      g_cond_wait (&filter->jobs_cond, &filter->jobs_lock);
+    g_mutex_unlock (&filter->jobs_lock);
+
+    for (i = 1; i < n_jobs; i++)
+      sum += jobs[i].sum;
+  }
+
+  nsampled = (metric->nlines + metric->line_step - 1) / metric->line_step;
+  if (nsampled == metric->nlines)
+    return (gfloat) sum;
+
+  return (gfloat) ((gdouble) sum * metric->nlines / nsampled);
+}
+
+static guint64
+same_parity_sad_rows (const FieldAnalysisMetric * metric, gint j_start,
+    gint j_end)
+{
+  gint j;
+  guint64 sum = 0;
+
+  for (j = field_analysis_first_line (metric, j_start); j < j_end;
+      j += metric->line_step) {
     guint32 tempsum = 0;
-    fieldanalysis_orc_same_parity_sad_planar_yuv (&tempsum, f1j, f2j,
-        noise_floor, width);
+    fieldanalysis_orc_same_parity_sad_planar_yuv (&tempsum,
+        metric->f1 + j * metric->stride1, metric->f2 + j * metric->stride2,
+        metric->noise_floor, metric->width);
     sum += tempsum;
-    f1j += stride0x2;
-    f2j += stride1x2;
   }
 
-  return sum / (0.5f * width * height);
+  return sum;
 }
 
 static gfloat
-same_parity_ssd (GstFieldAnalysis * filter, FieldAnalysisFields (*history)[2])
+same_parity_sad (GstFieldAnalysis * filter, FieldAnalysisFields (*history)[2])
 {
-  gint j;
+  FieldAnalysisMetric metric;
   gfloat sum;
-  guint8 *f1j, *f2j;
 
   const gint width = GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame);
   const gint height = GST_VIDEO_FRAME_HEIGHT (&(*history)[0].frame);
-  const gint stride0x2 =
-      GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0) << 1;
-  const gint stride1x2 =
-      GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame, 0) << 1;
-  /* noise floor needs to be squared for SSD */
-  const guint32 noise_floor = filter->noise_floor * filter->noise_floor;
 
-  f1j =
-      GST_VIDEO_FRAME_COMP_DATA (&(*history)[0].frame,
-      0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[0].frame,
-      0) +
+  field_analysis_metric_init (&metric, filter, &(*history)[0].frame,
       (*history)[0].parity * GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame,
-      0);
-  f2j =
-      GST_VIDEO_FRAME_COMP_DATA (&(*history)[1].frame,
-      0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[1].frame,
-      0) +
+          0), &(*history)[1].frame,
       (*history)[1].parity * GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame,
-      0);
+          0), filter->noise_floor);
+
+  sum = gst_field_analysis_run_metric (filter, &metric, same_parity_sad_rows);
+
+  return sum / (0.5f * width * height);
+}
+
+static guint64
+same_parity_ssd_rows (const FieldAnalysisMetric * metric, gint j_start,
+    gint j_end)
+{
+  gint j;
+  guint64 sum = 0;
 
-  sum = 0.0f;
-  for (j = 0; j < (height >> 1); j++) {
+  for (j = field_analysis_first_line (metric, j_start); j < j_end;
+      j += metric->line_step) {
     guint32 tempsum = 0;
-    fieldanalysis_orc_same_parity_ssd_planar_yuv (&tempsum, f1j, f2j,
-        noise_floor, width);
+    fieldanalysis_orc_same_parity_ssd_planar_yuv (&tempsum,
+        metric->f1 + j * metric->stride1, metric->f2 + j * metric->stride2,
+        metric->noise_floor, metric->width);
     sum += tempsum;
-    f1j += stride0x2;
-    f2j += stride1x2;
   }
 
-  return sum / (0.5f * width * height); /* field is half height */
+  return sum;
 }
 
-/* horizontal [1,4,1] diff between fields - is this a good idea or should the
- * current sample be emphasised more or less? */
 static gfloat
-same_parity_3_tap (GstFieldAnalysis * filter, FieldAnalysisFields (*history)[2])
+same_parity_ssd (GstFieldAnalysis * filter, FieldAnalysisFields (*history)[2])
 {
-  gint i, j;
+  FieldAnalysisMetric metric;
   gfloat sum;
-  guint8 *f1j, *f2j;
 
   const gint width = GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame);
   const gint height = GST_VIDEO_FRAME_HEIGHT (&(*history)[0].frame);
-  const gint stride0x2 =
-      GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0) << 1;
-  const gint stride1x2 =
-      GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame, 0) << 1;
-  const gint incr = GST_VIDEO_FRAME_COMP_PSTRIDE (&(*history)[0].frame, 0);
-  /* noise floor needs to be *6 for [1,4,1] */
-  const guint32 noise_floor = filter->noise_floor * 6;
 
-  f1j = GST_VIDEO_FRAME_COMP_DATA (&(*history)[0].frame, 0) +
-      GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[0].frame, 0) +
+  /* noise floor needs to be squared for SSD */
+  field_analysis_metric_init (&metric, filter, &(*history)[0].frame,
       (*history)[0].parity * GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame,
-      0);
-  f2j =
-      GST_VIDEO_FRAME_COMP_DATA (&(*history)[1].frame,
-      0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[1].frame,
-      0) +
+          0), &(*history)[1].frame,
       (*history)[1].parity * GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame,
-      0);
+          0), filter->noise_floor * filter->noise_floor);
+
+  sum = gst_field_analysis_run_metric (filter, &metric, same_parity_ssd_rows);
+
+  return sum / (0.5f * width * height); /* field is half height */
+}
+
+static guint64
+same_parity_3_tap_rows (const FieldAnalysisMetric * metric, gint j_start,
+    gint j_end)
+{
+  gint i, j;
+  guint64 sum = 0;
 
-  sum = 0.0f;
-  for (j = 0; j < (height >> 1); j++) {
+  const gint incr = metric->incr;
+  const gint width = metric->width;
+  const guint32 noise_floor = metric->noise_floor;
+
+  for (j = field_analysis_first_line (metric, j_start); j < j_end;
+      j += metric->line_step) {
+    const guint8 *f1j = metric->f1 + j * metric->stride1;
+    const guint8 *f2j = metric->f2 + j * metric->stride2;
     guint32 tempsum = 0;
     guint32 diff;
 
@@ -940,14 +1110,76 @@ same_parity_3_tap (GstFieldAnalysis * filter, FieldAnalysisFields (*history)[2])
         - ((f2j[i - incr] << 1) + (f2j[i] << 2)));
     if (diff > noise_floor)
       sum += diff;
-
-    f1j += stride0x2;
-    f2j += stride1x2;
   }
 
+  return sum;
+}
+
+/* horizontal [1,4,1] diff between fields - is this a good idea or should the
+ * current sample be emphasised more or less? */
+static gfloat
+same_parity_3_tap (GstFieldAnalysis * filter, FieldAnalysisFields (*history)[2])
+{
+  FieldAnalysisMetric metric;
+  gfloat sum;
+
+  const gint width = GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame);
+  const gint height = GST_VIDEO_FRAME_HEIGHT (&(*history)[0].frame);
+
+  /* noise floor needs to be *6 for [1,4,1] */
+  field_analysis_metric_init (&metric, filter, &(*history)[0].frame,
+      (*history)[0].parity * GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame,
+          0), &(*history)[1].frame,
+      (*history)[1].parity * GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame,
+          0), filter->noise_floor * 6);
+
+  sum = gst_field_analysis_run_metric (filter, &metric,
+      same_parity_3_tap_rows);
+
   return sum / ((6.0f / 2.0f) * width * height);        /* 1 + 4 + 1 = 6; field is half height */
 }
 
+/* fj is line j of the field of interest (metric->f1) and fjp1 is line j of
+ * the opposite parity field (metric->f2), i.e. one line down from fj in the
+ * combined frame. fjm2 is two lines up from fj, fjp2 two lines down. The
+ * first and last lines of the field are mirrored. */
+static guint64
+opposite_parity_5_tap_rows (const FieldAnalysisMetric * metric, gint j_start,
+    gint j_end)
+{
+  gint j;
+  guint64 sum = 0;
+  const guint8 *fjm2, *fjm1, *fj, *fjp1, *fjp2;
+
+  for (j = field_analysis_first_line (metric, j_start); j < j_end;
+      j += metric->line_step) {
+    guint32 tempsum = 0;
+
+    fj = metric->f1 + j * metric->stride1;
+    fjp1 = metric->f2 + j * metric->stride2;
+
+    if (j == 0) {
+      fjp2 = fj + metric->stride1;
+      fieldanalysis_orc_opposite_parity_5_tap_planar_yuv (&tempsum, fjp2,
+          fjp1, fj, fjp1, fjp2, metric->noise_floor, metric->width);
+    } else if (j == metric->nlines - 1) {
+      fjm2 = fj - metric->stride1;
+      fjm1 = fjp1 - metric->stride2;
+      fieldanalysis_orc_opposite_parity_5_tap_planar_yuv (&tempsum, fjm2,
+          fjm1, fj, fjm1, fjm2, metric->noise_floor, metric->width);
+    } else {
+      fjm2 = fj - metric->stride1;
+      fjm1 = fjp1 - metric->stride2;
+      fjp2 = fj + metric->stride1;
+      fieldanalysis_orc_opposite_parity_5_tap_planar_yuv (&tempsum, fjm2,
+          fjm1, fj, fjp1, fjp2, metric->noise_floor, metric->width);
+    }
+    sum += tempsum;
+  }
+
+  return sum;
+}
+
 /* vertical [1,-3,4,-3,1] - same as is used in FieldDiff from TIVTC,
  * tritical's AVISynth IVTC filter */
 /* 0th field's parity defines operation */
@@ -955,83 +1187,28 @@ static gfloat
 opposite_parity_5_tap (GstFieldAnalysis * filter,
     FieldAnalysisFields (*history)[2])
 {
-  gint j;
+  FieldAnalysisMetric metric;
   gfloat sum;
-  guint8 *fjm2, *fjm1, *fj, *fjp1, *fjp2;
-  guint32 tempsum;
 
   const gint width = GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame);
   const gint height = GST_VIDEO_FRAME_HEIGHT (&(*history)[0].frame);
-  const gint stride0x2 =
-      GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0) << 1;
-  const gint stride1x2 =
-      GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame, 0) << 1;
   /* noise floor needs to be *6 for [1,-3,4,-3,1] */
   const guint32 noise_floor = filter->noise_floor * 6;
 
-  sum = 0.0f;
-
-  /* fj is line j of the combined frame made from the top field even lines of
-   *   field 0 and the bottom field odd lines from field 1
-   * fjp1 is one line down from fj
-   * fjm2 is two lines up from fj
-   * fj with j == 0 is the 0th line of the top field
-   * fj with j == 1 is the 0th line of the bottom field or the 1st field of
-   *   the frame*/
-
-  /* unroll first line as it is a special case */
+  /* the combined frame is made from the top field even lines of field 0 and
+   * the bottom field odd lines from field 1 */
   if ((*history)[0].parity == TOP_FIELD) {
-    fj = GST_VIDEO_FRAME_COMP_DATA (&(*history)[0].frame,
-        0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[0].frame, 0);
-    fjp1 =
-        GST_VIDEO_FRAME_COMP_DATA (&(*history)[1].frame,
-        0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[1].frame,
-        0) + GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame, 0);
-    fjp2 = fj + stride0x2;
+    field_analysis_metric_init (&metric, filter, &(*history)[0].frame, 0,
+        &(*history)[1].frame,
+        GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame, 0), noise_floor);
   } else {
-    fj = GST_VIDEO_FRAME_COMP_DATA (&(*history)[1].frame,
-        0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[1].frame, 0);
-    fjp1 =
-        GST_VIDEO_FRAME_COMP_DATA (&(*history)[0].frame,
-        0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[0].frame,
-        0) + GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0);
-    fjp2 = fj + stride1x2;
+    field_analysis_metric_init (&metric, filter, &(*history)[1].frame, 0,
+        &(*history)[0].frame,
+        GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0), noise_floor);
   }
 
-  tempsum = 0;
-  fieldanalysis_orc_opposite_parity_5_tap_planar_yuv (&tempsum, fjp2, fjp1, fj,
-      fjp1, fjp2, noise_floor, width);
-  sum += tempsum;
-
-  for (j = 1; j < (height >> 1) - 1; j++) {
-    /* shift everything down a line in the field of interest (means += stridex2) */
-    fjm2 = fj;
-    fjm1 = fjp1;
-    fj = fjp2;
-    if ((*history)[0].parity == TOP_FIELD) {
-      fjp1 += stride1x2;
-      fjp2 += stride0x2;
-    } else {
-      fjp1 += stride0x2;
-      fjp2 += stride1x2;
-    }
-
-    tempsum = 0;
-    fieldanalysis_orc_opposite_parity_5_tap_planar_yuv (&tempsum, fjm2, fjm1,
-        fj, fjp1, fjp2, noise_floor, width);
-    sum += tempsum;
-  }
-
-  /* unroll the last line as it is a special case */
-  /* shift everything down a line in the field of interest (means += stridex2) */
-  fjm2 = fj;
-  fjm1 = fjp1;
-  fj = fjp2;
-
-  tempsum = 0;
-  fieldanalysis_orc_opposite_parity_5_tap_planar_yuv (&tempsum, fjm2, fjm1, fj,
-      fjm1, fjm2, noise_floor, width);
-  sum += tempsum;
+  sum = gst_field_analysis_run_metric (filter, &metric,
+      opposite_parity_5_tap_rows);
 
   return sum / ((6.0f / 2.0f) * width * height);        /* 1 + 4 + 1 == 3 + 3 == 6; field is half height */
 }
@@ -1835,6 +2012,11 @@ gst_field_analysis_finalize (GObject * object)
 
   gst_field_analysis_reset (filter);
 
+  if (filter->pool)
+    g_thread_pool_free (filter->pool, FALSE, TRUE);
+  g_mutex_clear (&filter->jobs_lock);
+  g_cond_clear (&filter->jobs_cond);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -135,6 +135,14 @@ struct _GstFieldAnalysis
   guint64 block_width, block_height; /* width/height of window used for comb clusted detection */
   guint64 block_thresh;
   guint64 ignored_lines;
+  guint n_threads; /* maximum number of threads computing the metrics */
+  guint line_step; /* compute the metrics on every line_step-th line only */
+
+  /* worker threads computing the metrics on slices of lines */
+  GThreadPool *pool;
+  GMutex jobs_lock;
+  GCond jobs_cond;
+  guint jobs_pending;
 };
 
 struct _GstFieldAnalysisClass
@@ -208,86 +208,118 @@ freeverb_allpass_getfeedback(freeverb_allpass* allpass)
   _input_1 = output; \
 }
 
-/* comb filter */
+#define numcombs 8
+#define numallpasses 4
+#define	fixedgain 0.015f
 
-typedef struct _freeverb_comb
+/* comb filters
+ *
+ * The left and right combs all share their feedback and damping, so they
+ * are kept in one bank with the state of each comb in a separate array:
+ * the filter update of all combs of a sample is then independent across
+ * the array elements and done with vector instructions by the compiler.
+ * The left combs come first, followed by the right combs. */
+
+typedef struct _freeverb_comb_bank
 {
   gfloat feedback;
-  gfloat filterstore;
   gfloat damp1;
   gfloat damp2;
-  gfloat *buffer;
-  gint bufsize;
-  gint bufidx;
-} freeverb_comb;
+  gfloat filterstore[2 * numcombs];
+  gfloat *buffer[2 * numcombs];
+  gint bufsize[2 * numcombs];
+  gint bufidx[2 * numcombs];
+} freeverb_comb_bank;
 
 static void
-freeverb_comb_setbuffer (freeverb_comb * comb, gint size)
+freeverb_comb_setbuffer (freeverb_comb_bank * bank, gint comb, gint size)
 {
-  comb->filterstore = 0;
-  comb->bufidx = 0;
-  comb->buffer = g_new (gfloat, size);
-  comb->bufsize = size;
+  bank->filterstore[comb] = 0;
+  bank->bufidx[comb] = 0;
+  bank->buffer[comb] = g_new (gfloat, size);
+  bank->bufsize[comb] = size;
 }
 
 static void
-freeverb_comb_release (freeverb_comb * comb)
+freeverb_comb_release (freeverb_comb_bank * bank)
 {
-  g_free (comb->buffer);
+  gint i;
+
+  for (i = 0; i < 2 * numcombs; i++) {
+    g_free (bank->buffer[i]);
+    bank->buffer[i] = NULL;
+  }
 }
 
 static void
-freeverb_comb_init (freeverb_comb * comb)
+freeverb_comb_init (freeverb_comb_bank * bank)
 {
-  gint i, len = comb->bufsize;
-  gfloat *buf = comb->buffer;
+  gint i, j;
 
-  for (i = 0; i < len; i++) {
-    buf[i] = (gfloat) DC_OFFSET;        /* This is not 100 % correct. */
+  for (j = 0; j < 2 * numcombs; j++) {
+    gint len = bank->bufsize[j];
+    gfloat *buf = bank->buffer[j];
+
+    for (i = 0; i < len; i++) {
+      buf[i] = (gfloat) DC_OFFSET;      /* This is not 100 % correct. */
+    }
   }
 }
 
 static void
-freeverb_comb_setdamp (freeverb_comb * comb, gfloat val)
+freeverb_comb_setdamp (freeverb_comb_bank * bank, gfloat val)
 {
-  comb->damp1 = val;
-  comb->damp2 = 1 - val;
+  bank->damp1 = val;
+  bank->damp2 = 1 - val;
 }
 
-/*
-static gfloat
-freeverb_comb_getdamp(freeverb_comb* comb)
-{
-  return comb->damp1;
-}*/
-
 static void
-freeverb_comb_setfeedback (freeverb_comb * comb, gfloat val)
+freeverb_comb_setfeedback (freeverb_comb_bank * bank, gfloat val)
 {
-  comb->feedback = val;
+  bank->feedback = val;
 }
 
-/*
-static gfloat
-freeverb_comb_getfeedback(freeverb_comb* comb)
-{
-  return comb->feedback;
-}*/
+/* runs one sample through all combs, accumulating the output of the left
+ * combs in @output_l and of the right combs in @output_r */
+static inline void
+freeverb_comb_process (freeverb_comb_bank * bank, gfloat input_l,
+    gfloat input_r, gfloat * output_l, gfloat * output_r)
+{
+  gfloat tmp[2 * numcombs];
+  gfloat input[2 * numcombs];
+  gfloat feedback = bank->feedback;
+  gfloat damp1 = bank->damp1;
+  gfloat damp2 = bank->damp2;
+  gfloat out_l = *output_l, out_r = *output_r;
+  gint i;
 
-#define freeverb_comb_process(_comb, _input_1, _output) \
-{ \
-  gfloat _tmp = _comb.buffer[_comb.bufidx]; \
-  _comb.filterstore = (_tmp * _comb.damp2) + (_comb.filterstore * _comb.damp1); \
-  _comb.buffer[_comb.bufidx] = _input_1 + (_comb.filterstore * _comb.feedback); \
-  if (++_comb.bufidx >= _comb.bufsize) { \
-    _comb.bufidx = 0; \
-  } \
-  _output += _tmp; \
-}
+  for (i = 0; i < 2 * numcombs; i++)
+    tmp[i] = bank->buffer[i][bank->bufidx[i]];
 
-#define numcombs 8
-#define numallpasses 4
-#define	fixedgain 0.015f
+  for (i = 0; i < numcombs; i++) {
+    input[i] = input_l;
+    input[numcombs + i] = input_r;
+  }
+
+  for (i = 0; i < 2 * numcombs; i++) {
+    bank->filterstore[i] = (tmp[i] * damp2) + (bank->filterstore[i] * damp1);
+    input[i] += bank->filterstore[i] * feedback;
+  }
+
+  for (i = 0; i < 2 * numcombs; i++) {
+    bank->buffer[i][bank->bufidx[i]] = input[i];
+    bank->bufidx[i] =
+        bank->bufidx[i] + 1 >= bank->bufsize[i] ? 0 : bank->bufidx[i] + 1;
+  }
+
+  /* same summation order as one comb after the other */
+  for (i = 0; i < numcombs; i++) {
+    out_l += tmp[i];
+    out_r += tmp[numcombs + i];
+  }
+  *output_l = out_l;
+  *output_r = out_r;
+}
 #define scalewet 1.0f
 #define scaledry 1.0f
 #define scaledamp 1.0f
@@ -337,8 +369,7 @@ struct _GstFreeverbPrivate
      with its subsequent error-checking messiness
    */
   /* Comb filters */
-  freeverb_comb combL[numcombs];
-  freeverb_comb combR[numcombs];
+  freeverb_comb_bank combs;
   /* Allpass filters */
   freeverb_allpass allpassL[numallpasses];
   freeverb_allpass allpassR[numallpasses];
@@ -354,10 +385,7 @@ freeverb_revmodel_init (GstFreeverb * filter)
   GstFreeverbPrivate *priv = filter->priv;
   gint i;
 
-  for (i = 0; i < numcombs; i++) {
-    freeverb_comb_init (&priv->combL[i]);
-    freeverb_comb_init (&priv->combR[i]);
-  }
+  freeverb_comb_init (&priv->combs);
   for (i = 0; i < numallpasses; i++) {
     freeverb_allpass_init (&priv->allpassL[i]);
     freeverb_allpass_init (&priv->allpassR[i]);
@@ -370,10 +398,7 @@ freeverb_revmodel_free (GstFreeverb * filter)
   GstFreeverbPrivate *priv = filter->priv;
   gint i;
 
-  for (i = 0; i < numcombs; i++) {
-    freeverb_comb_release (&priv->combL[i]);
-    freeverb_comb_release (&priv->combR[i]);
-  }
+  freeverb_comb_release (&priv->combs);
   for (i = 0; i < numallpasses; i++) {
     freeverb_allpass_release (&priv->allpassL[i]);
     freeverb_allpass_release (&priv->allpassR[i]);
@@ -488,22 +513,30 @@ gst_freeverb_init_rev_model (GstFreeverb * filter)
 
   priv->gain = fixedgain;
 
-  freeverb_comb_setbuffer (&priv->combL[0], combtuningL1 * srfactor);
-  freeverb_comb_setbuffer (&priv->combR[0], combtuningR1 * srfactor);
-  freeverb_comb_setbuffer (&priv->combL[1], combtuningL2 * srfactor);
-  freeverb_comb_setbuffer (&priv->combR[1], combtuningR2 * srfactor);
-  freeverb_comb_setbuffer (&priv->combL[2], combtuningL3 * srfactor);
-  freeverb_comb_setbuffer (&priv->combR[2], combtuningR3 * srfactor);
-  freeverb_comb_setbuffer (&priv->combL[3], combtuningL4 * srfactor);
-  freeverb_comb_setbuffer (&priv->combR[3], combtuningR4 * srfactor);
-  freeverb_comb_setbuffer (&priv->combL[4], combtuningL5 * srfactor);
-  freeverb_comb_setbuffer (&priv->combR[4], combtuningR5 * srfactor);
-  freeverb_comb_setbuffer (&priv->combL[5], combtuningL6 * srfactor);
-  freeverb_comb_setbuffer (&priv->combR[5], combtuningR6 * srfactor);
-  freeverb_comb_setbuffer (&priv->combL[6], combtuningL7 * srfactor);
-  freeverb_comb_setbuffer (&priv->combR[6], combtuningR7 * srfactor);
-  freeverb_comb_setbuffer (&priv->combL[7], combtuningL8 * srfactor);
-  freeverb_comb_setbuffer (&priv->combR[7], combtuningR8 * srfactor);
+  freeverb_comb_setbuffer (&priv->combs, 0, combtuningL1 * srfactor);
+  freeverb_comb_setbuffer (&priv->combs, numcombs + 0,
+      combtuningR1 * srfactor);
+  freeverb_comb_setbuffer (&priv->combs, 1, combtuningL2 * srfactor);
+  freeverb_comb_setbuffer (&priv->combs, numcombs + 1,
+      combtuningR2 * srfactor);
+  freeverb_comb_setbuffer (&priv->combs, 2, combtuningL3 * srfactor);
+  freeverb_comb_setbuffer (&priv->combs, numcombs + 2,
+      combtuningR3 * srfactor);
+  freeverb_comb_setbuffer (&priv->combs, 3, combtuningL4 * srfactor);
+  freeverb_comb_setbuffer (&priv->combs, numcombs + 3,
+      combtuningR4 * srfactor);
+  freeverb_comb_setbuffer (&priv->combs, 4, combtuningL5 * srfactor);
+  freeverb_comb_setbuffer (&priv->combs, numcombs + 4,
+      combtuningR5 * srfactor);
+  freeverb_comb_setbuffer (&priv->combs, 5, combtuningL6 * srfactor);
+  freeverb_comb_setbuffer (&priv->combs, numcombs + 5,
+      combtuningR6 * srfactor);
+  freeverb_comb_setbuffer (&priv->combs, 6, combtuningL7 * srfactor);
+  freeverb_comb_setbuffer (&priv->combs, numcombs + 6,
+      combtuningR7 * srfactor);
+  freeverb_comb_setbuffer (&priv->combs, 7, combtuningL8 * srfactor);
+  freeverb_comb_setbuffer (&priv->combs, numcombs + 7,
+      combtuningR8 * srfactor);
   freeverb_allpass_setbuffer (&priv->allpassL[0], allpasstuningL1 * srfactor);
   freeverb_allpass_setbuffer (&priv->allpassR[0], allpasstuningR1 * srfactor);
   freeverb_allpass_setbuffer (&priv->allpassL[1], allpasstuningL2 * srfactor);
@@ -533,24 +566,17 @@ gst_freeverb_set_property (GObject * object, guint prop_id,
 {
   GstFreeverb *filter = GST_FREEVERB (object);
   GstFreeverbPrivate *priv = filter->priv;
-  gint i;
 
   switch (prop_id) {
     case PROP_ROOM_SIZE:
       filter->room_size = g_value_get_float (value);
       priv->roomsize = (filter->room_size * scaleroom) + offsetroom;
-      for (i = 0; i < numcombs; i++) {
-        freeverb_comb_setfeedback (&priv->combL[i], priv->roomsize);
-        freeverb_comb_setfeedback (&priv->combR[i], priv->roomsize);
-      }
+      freeverb_comb_setfeedback (&priv->combs, priv->roomsize);
       break;
     case PROP_DAMPING:
       filter->damping = g_value_get_float (value);
       priv->damp = filter->damping * scaledamp;
-      for (i = 0; i < numcombs; i++) {
-        freeverb_comb_setdamp (&priv->combL[i], priv->damp);
-        freeverb_comb_setdamp (&priv->combR[i], priv->damp);
-      }
+      freeverb_comb_setdamp (&priv->combs, priv->damp);
       break;
     case PROP_PAN_WIDTH:
       filter->pan_width = g_value_get_float (value);
@@ -706,10 +732,7 @@ gst_freeverb_transform_m2s_int (GstFreeverb * filter,
     input_1 = (2.0f * input_2 + DC_OFFSET) * priv->gain;
 
     /* Accumulate comb filters in parallel */
-    for (i = 0; i < numcombs; i++) {
-      freeverb_comb_process (priv->combL[i], input_1, out_l1);
-      freeverb_comb_process (priv->combR[i], input_1, out_r1);
-    }
+    freeverb_comb_process (&priv->combs, input_1, input_1, &out_l1, &out_r1);
     /* Feed through allpasses in series */
     for (i = 0; i < numallpasses; i++) {
       freeverb_allpass_process (priv->allpassL[i], out_l1);
@@ -753,10 +776,7 @@ gst_freeverb_transform_s2s_int (GstFreeverb * filter,
     input_1r = (input_2r + DC_OFFSET) * priv->gain;
 
     /* Accumulate comb filters in parallel */
-    for (i = 0; i < numcombs; i++) {
-      freeverb_comb_process (priv->combL[i], input_1l, out_l1);
-      freeverb_comb_process (priv->combR[i], input_1r, out_r1);
-    }
+    freeverb_comb_process (&priv->combs, input_1l, input_1r, &out_l1, &out_r1);
     /* Feed through allpasses in series */
     for (i = 0; i < numallpasses; i++) {
       freeverb_allpass_process (priv->allpassL[i], out_l1);
@@ -802,10 +822,7 @@ gst_freeverb_transform_m2s_float (GstFreeverb * filter,
     input_1 = (2.0f * input_2 + DC_OFFSET) * priv->gain;
 
     /* Accumulate comb filters in parallel */
-    for (i = 0; i < numcombs; i++) {
-      freeverb_comb_process (priv->combL[i], input_1, out_l1);
-      freeverb_comb_process (priv->combR[i], input_1, out_r1);
-    }
+    freeverb_comb_process (&priv->combs, input_1, input_1, &out_l1, &out_r1);
     /* Feed through allpasses in series */
     for (i = 0; i < numallpasses; i++) {
       freeverb_allpass_process (priv->allpassL[i], out_l1);
@@ -847,10 +864,7 @@ gst_freeverb_transform_s2s_float (GstFreeverb * filter,
     input_1r = (input_2r + DC_OFFSET) * priv->gain;
 
     /* Accumulate comb filters in parallel */
-    for (i = 0; i < numcombs; i++) {
-      freeverb_comb_process (priv->combL[i], input_1l, out_l1);
-      freeverb_comb_process (priv->combR[i], input_1r, out_r1);
-    }
+    freeverb_comb_process (&priv->combs, input_1l, input_1r, &out_l1, &out_r1);
     /* Feed through allpasses in series */
     for (i = 0; i < numallpasses; i++) {
       freeverb_allpass_process (priv->allpassL[i], out_l1);
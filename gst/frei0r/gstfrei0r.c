@@ -56,7 +56,8 @@ gst_frei0r_caps_from_color_model (gint color_model)
   return NULL;
 }
 
-void
+/* returns the first property id not used by the plugin's parameters */
+guint
 gst_frei0r_klass_install_properties (GObjectClass * gobject_class,
     GstFrei0rFuncTable * ftable, GstFrei0rProperty * properties,
     gint n_properties)
@@ -225,6 +226,8 @@ gst_frei0r_klass_install_properties (GObjectClass * gobject_class,
   }
 
   ftable->destruct (instance);
+
+  return count;
 }
 
 GstFrei0rPropertyValue *
@@ -467,6 +470,215 @@ gst_frei0r_set_property (f0r_instance_t * instance, GstFrei0rFuncTable * ftable,
   return TRUE;
 }
 
+/* Plugins computing each output pixel only from the input pixels at the same
+ * position, which can be run on slices of the frames. frei0r has no way of
+ * telling this so it's a list of plugin names */
+static const gchar *const slice_safe_plugins[] = {
+  /* filters */
+  "3 point color balance", "B", "Brightness", "bw0r", "Color Distance",
+  "coloradj_RGB", "colorize", "colortap", "Contrast0r", "G", "Gamma",
+  "Hueshift0r", "Invert0r", "Luminance", "posterize",
+  "Premultiply or Unpremultiply", "primaries", "R", "Saturat0r",
+  "sigmoidaltransfer", "SOP/Sat", "spillsupress", "Threshold0r", "Tint0r",
+  "Transparency", "White Balance", "White Balance (LMS space)",
+  /* mixers */
+  "addition", "addition_alpha", "alphaatop", "alphain", "alphaout",
+  "alphaover", "alphaxor", "blend", "burn", "color_only", "Composition",
+  "darken", "difference", "divide", "dodge", "grain_extract", "grain_merge",
+  "hardlight", "hue", "lighten", "multiply", "overlay", "saturation",
+  "screen", "softlight", "subtract", "value", "xfade0r",
+  NULL
+};
+
+gboolean
+gst_frei0r_plugin_is_slice_safe (const f0r_plugin_info_t * info,
+    const gchar * element_name)
+{
+  const gchar *env;
+  gboolean ret = FALSE;
+
+  if (g_strv_contains (slice_safe_plugins, info->name))
+    return TRUE;
+
+  /* other elements can be listed, separated by commas */
+  env = g_getenv ("GST_FREI0R_SLICE_SAFE");
+  if (env && *env) {
+    gchar **names = g_strsplit (env, ",", -1);
+
+    ret = g_strv_contains ((const gchar * const *) names, element_name);
+    g_strfreev (names);
+  }
+
+  return ret;
+}
+
+/* minimum height of the slices */
+#define MIN_ROWS_PER_SLICE 16
+
+typedef struct
+{
+  GstFrei0rInstances *instances;
+  GstFrei0rFuncTable *ftable;
+  guint idx;
+  gdouble time;
+  const guint32 *inframe1, *inframe2, *inframe3;
+  guint32 *outframe;
+} GstFrei0rSliceJob;
+
+#define SLICE_START(instances, i) \
+  ((i) * (instances)->height / (instances)->n_instances)
+
+GstFrei0rInstances *
+gst_frei0r_instances_new (GstFrei0rFuncTable * ftable,
+    GstFrei0rProperty * properties, gint n_properties,
+    GstFrei0rPropertyValue * property_cache, gint width, gint height,
+    guint n_slices)
+{
+  GstFrei0rInstances *instances;
+  guint i;
+
+  instances = g_new0 (GstFrei0rInstances, 1);
+  instances->width = width;
+  instances->height = height;
+  instances->n_instances = CLAMP (height / MIN_ROWS_PER_SLICE, 1, n_slices);
+  instances->instances = g_new0 (f0r_instance_t *, instances->n_instances);
+  g_mutex_init (&instances->lock);
+  g_cond_init (&instances->cond);
+
+  for (i = 0; i < instances->n_instances; i++) {
+    gint rows = SLICE_START (instances, i + 1) - SLICE_START (instances, i);
+
+    instances->instances[i] = gst_frei0r_instance_construct (ftable,
+        properties, n_properties, property_cache, width, rows);
+    if (!instances->instances[i]) {
+      gst_frei0r_instances_free (instances, ftable);
+      return NULL;
+    }
+  }
+
+  GST_DEBUG ("Created %u instances for %dx%d frames",
+      instances->n_instances, width, height);
+
+  return instances;
+}
+
+void
+gst_frei0r_instances_free (GstFrei0rInstances * instances,
+    GstFrei0rFuncTable * ftable)
+{
+  guint i;
+
+  if (instances->pool)
+    g_thread_pool_free (instances->pool, FALSE, TRUE);
+  g_mutex_clear (&instances->lock);
+  g_cond_clear (&instances->cond);
+
+  for (i = 0; i < instances->n_instances; i++) {
+    if (instances->instances[i])
+      ftable->destruct (instances->instances[i]);
+  }
+  g_free (instances->instances);
+  g_free (instances);
+}
+
+/* applies the cached value of a property, already set on the first instance
+ * by gst_frei0r_set_property(), to the other ones */
+void
+gst_frei0r_instances_sync_property (GstFrei0rInstances * instances,
+    GstFrei0rFuncTable * ftable, GstFrei0rProperty * properties,
+    gint n_properties, GstFrei0rPropertyValue * property_cache, guint prop_id)
+{
+  guint i;
+  gint j;
+
+  for (j = 0; j < n_properties; j++) {
+    if (properties[j].prop_id <= prop_id &&
+        properties[j].prop_id + properties[j].n_prop_ids > prop_id)
+      break;
+  }
+
+  if (j == n_properties)
+    return;
+
+  for (i = 1; i < instances->n_instances; i++)
+    ftable->set_param_value (instances->instances[i],
+        &property_cache[properties[j].prop_idx].data, properties[j].prop_idx);
+}
+
+static void
+gst_frei0r_instances_update_slice (GstFrei0rSliceJob * job)
+{
+  GstFrei0rInstances *instances = job->instances;
+  gsize offset = (gsize) SLICE_START (instances, job->idx) * instances->width;
+  f0r_instance_t *instance = instances->instances[job->idx];
+
+  if (job->ftable->update2)
+    job->ftable->update2 (instance, job->time, job->inframe1 + offset,
+        job->inframe2 ? job->inframe2 + offset : NULL,
+        job->inframe3 ? job->inframe3 + offset : NULL,
+        job->outframe + offset);
+  else
+    job->ftable->update (instance, job->time, job->inframe1 + offset,
+        job->outframe + offset);
+}
+
+static void
+gst_frei0r_instances_job (gpointer data, gpointer user_data)
+{
+  GstFrei0rSliceJob *job = data;
+  GstFrei0rInstances *instances = job->instances;
+
+  gst_frei0r_instances_update_slice (job);
+
+  g_mutex_lock (&instances->lock);
+  if (--instances->pending == 0)
+    g_cond_signal (&instances->cond);
+  g_mutex_unlock (&instances->lock);
+}
+
+/* runs all instances on their slice of the frames and waits for them */
+void
+gst_frei0r_instances_update (GstFrei0rInstances * instances,
+    GstFrei0rFuncTable * ftable, gdouble time, const guint32 * inframe1,
+    const guint32 * inframe2, const guint32 * inframe3, guint32 * outframe)
+{
+  GstFrei0rSliceJob *jobs;
+  guint i;
+
+  jobs = g_newa (GstFrei0rSliceJob, instances->n_instances);
+  for (i = 0; i < instances->n_instances; i++) {
+    jobs[i].instances = instances;
+    jobs[i].ftable = ftable;
+    jobs[i].idx = i;
+    jobs[i].time = time;
+    jobs[i].inframe1 = inframe1;
+    jobs[i].inframe2 = inframe2;
+    jobs[i].inframe3 = inframe3;
+    jobs[i].outframe = outframe;
+  }
+
+  if (instances->n_instances == 1) {
+    gst_frei0r_instances_update_slice (&jobs[0]);
+    return;
+  }
+
+  if (instances->pool == NULL)
+    instances->pool = g_thread_pool_new (gst_frei0r_instances_job, NULL, -1,
+        FALSE, NULL);
+
+  instances->pending = instances->n_instances - 1;
+  for (i = 1; i < instances->n_instances; i++)
+    g_thread_pool_push (instances->pool, &jobs[i], NULL);
+
+  /* do the first slice from the calling thread */
+  gst_frei0r_instances_update_slice (&jobs[0]);
+
+  g_mutex_lock (&instances->lock);
+  while (instances->pending > 0)
+    g_cond_wait (&instances->cond, &instances->lock);
+  g_mutex_unlock (&instances->lock);
+}
+
 static gboolean
 register_plugin (GstPlugin * plugin, const gchar * vendor,
     const gchar * filename)
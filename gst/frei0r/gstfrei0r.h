@@ -29,6 +29,7 @@ G_BEGIN_DECLS
 typedef struct _GstFrei0rFuncTable GstFrei0rFuncTable;
 typedef struct _GstFrei0rProperty GstFrei0rProperty;
 typedef struct _GstFrei0rPropertyValue GstFrei0rPropertyValue;
+typedef struct _GstFrei0rInstances GstFrei0rInstances;
 
 struct _GstFrei0rPropertyValue {
   union {
@@ -75,13 +76,26 @@ struct _GstFrei0rFuncTable {
 		   guint32* outframe);
 };
 
+/* One or more instances of a plugin, each processing a horizontal slice of
+ * the frames from its own thread */
+struct _GstFrei0rInstances {
+  f0r_instance_t **instances;
+  guint n_instances;
+  gint width, height;
+
+  GThreadPool *pool;
+  GMutex lock;
+  GCond cond;
+  guint pending;
+};
+
 typedef enum {
   GST_FREI0R_PLUGIN_REGISTER_RETURN_OK,
   GST_FREI0R_PLUGIN_REGISTER_RETURN_FAILED,
   GST_FREI0R_PLUGIN_REGISTER_RETURN_ALREADY_REGISTERED
 } GstFrei0rPluginRegisterReturn;
 
-void gst_frei0r_klass_install_properties (GObjectClass *gobject_class, GstFrei0rFuncTable *ftable, GstFrei0rProperty *properties, gint n_properties);
+guint gst_frei0r_klass_install_properties (GObjectClass *gobject_class, GstFrei0rFuncTable *ftable, GstFrei0rProperty *properties, gint n_properties);
 
 f0r_instance_t * gst_frei0r_instance_construct (GstFrei0rFuncTable *ftable, GstFrei0rProperty *properties, gint n_properties, GstFrei0rPropertyValue *property_cache, gint width, gint height);
 
@@ -92,6 +106,13 @@ GstCaps * gst_frei0r_caps_from_color_model (gint color_model);
 gboolean gst_frei0r_get_property (f0r_instance_t *instance, GstFrei0rFuncTable *ftable, GstFrei0rProperty *properties, gint n_properties, GstFrei0rPropertyValue *property_cache, guint prop_id, GValue *value);
 gboolean gst_frei0r_set_property (f0r_instance_t *instance, GstFrei0rFuncTable *ftable, GstFrei0rProperty *properties, gint n_properties, GstFrei0rPropertyValue *property_cache, guint prop_id, const GValue *value);
 
+gboolean gst_frei0r_plugin_is_slice_safe (const f0r_plugin_info_t *info, const gchar *element_name);
+
+GstFrei0rInstances * gst_frei0r_instances_new (GstFrei0rFuncTable *ftable, GstFrei0rProperty *properties, gint n_properties, GstFrei0rPropertyValue *property_cache, gint width, gint height, guint n_slices);
+void gst_frei0r_instances_free (GstFrei0rInstances *instances, GstFrei0rFuncTable *ftable);
+void gst_frei0r_instances_sync_property (GstFrei0rInstances *instances, GstFrei0rFuncTable *ftable, GstFrei0rProperty *properties, gint n_properties, GstFrei0rPropertyValue *property_cache, guint prop_id);
+void gst_frei0r_instances_update (GstFrei0rInstances *instances, GstFrei0rFuncTable *ftable, gdouble time, const guint32 *inframe1, const guint32 *inframe2, const guint32 *inframe3, guint32 *outframe);
+
 G_END_DECLS
 
 #endif /* __GST_FREI0R_H__ */
@@ -54,9 +54,9 @@ gst_frei0r_filter_set_caps (GstBaseTransform * trans, GstCaps * incaps,
   self->width = info.width;
   self->height = info.height;
 
-  if (self->f0r_instance && destroy_f0r_instance) {
-    klass->ftable->destruct (self->f0r_instance);
-    self->f0r_instance = NULL;
+  if (self->f0r_instances && destroy_f0r_instance) {
+    gst_frei0r_instances_free (self->f0r_instances, klass->ftable);
+    self->f0r_instances = NULL;
   }
 
   return TRUE;
@@ -68,9 +68,9 @@ gst_frei0r_filter_stop (GstBaseTransform * trans)
   GstFrei0rFilter *self = GST_FREI0R_FILTER (trans);
   GstFrei0rFilterClass *klass = GST_FREI0R_FILTER_GET_CLASS (trans);
 
-  if (self->f0r_instance) {
-    klass->ftable->destruct (self->f0r_instance);
-    self->f0r_instance = NULL;
+  if (self->f0r_instances) {
+    gst_frei0r_instances_free (self->f0r_instances, klass->ftable);
+    self->f0r_instances = NULL;
   }
 
   self->width = self->height = 0;
@@ -104,15 +104,23 @@ gst_frei0r_filter_transform (GstBaseTransform * trans, GstBuffer * inbuf,
   GstFrei0rFilterClass *klass = GST_FREI0R_FILTER_GET_CLASS (trans);
   gdouble time;
   GstMapInfo inmap, outmap;
+  guint n_threads;
 
   if (G_UNLIKELY (self->width <= 0 || self->height <= 0))
     return GST_FLOW_NOT_NEGOTIATED;
 
-  if (G_UNLIKELY (!self->f0r_instance)) {
-    self->f0r_instance =
-        gst_frei0r_instance_construct (klass->ftable, klass->properties,
-        klass->n_properties, self->property_cache, self->width, self->height);
-    if (G_UNLIKELY (!self->f0r_instance))
+  if (G_UNLIKELY (!self->f0r_instances)) {
+    GST_OBJECT_LOCK (self);
+    n_threads = self->n_threads;
+    GST_OBJECT_UNLOCK (self);
+    if (n_threads == 0)
+      n_threads = g_get_num_processors ();
+
+    self->f0r_instances =
+        gst_frei0r_instances_new (klass->ftable, klass->properties,
+        klass->n_properties, self->property_cache, self->width, self->height,
+        n_threads);
+    if (G_UNLIKELY (!self->f0r_instances))
       return GST_FLOW_ERROR;
   }
 
@@ -123,12 +131,8 @@ gst_frei0r_filter_transform (GstBaseTransform * trans, GstBuffer * inbuf,
   gst_buffer_map (inbuf, &inmap, GST_MAP_READ);
   gst_buffer_map (outbuf, &outmap, GST_MAP_WRITE);
 
-  if (klass->ftable->update2)
-    klass->ftable->update2 (self->f0r_instance, time,
-        (const guint32 *) inmap.data, NULL, NULL, (guint32 *) outmap.data);
-  else
-    klass->ftable->update (self->f0r_instance, time,
-        (const guint32 *) inmap.data, (guint32 *) outmap.data);
+  gst_frei0r_instances_update (self->f0r_instances, klass->ftable, time,
+      (const guint32 *) inmap.data, NULL, NULL, (guint32 *) outmap.data);
 
   gst_buffer_unmap (outbuf, &outmap);
   gst_buffer_unmap (inbuf, &inmap);
@@ -144,9 +148,9 @@ gst_frei0r_filter_finalize (GObject * object)
   GstFrei0rFilter *self = GST_FREI0R_FILTER (object);
   GstFrei0rFilterClass *klass = GST_FREI0R_FILTER_GET_CLASS (object);
 
-  if (self->f0r_instance) {
-    klass->ftable->destruct (self->f0r_instance);
-    self->f0r_instance = NULL;
+  if (self->f0r_instances) {
+    gst_frei0r_instances_free (self->f0r_instances, klass->ftable);
+    self->f0r_instances = NULL;
   }
 
   if (self->property_cache)
@@ -165,7 +169,10 @@ gst_frei0r_filter_get_property (GObject * object, guint prop_id, GValue * value,
   GstFrei0rFilterClass *klass = GST_FREI0R_FILTER_GET_CLASS (object);
 
   GST_OBJECT_LOCK (self);
-  if (!gst_frei0r_get_property (self->f0r_instance, klass->ftable,
+  if (klass->n_threads_prop_id && prop_id == klass->n_threads_prop_id)
+    g_value_set_uint (value, self->n_threads);
+  else if (!gst_frei0r_get_property (self->f0r_instances ?
+          self->f0r_instances->instances[0] : NULL, klass->ftable,
           klass->properties, klass->n_properties, self->property_cache, prop_id,
           value))
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -180,10 +187,20 @@ gst_frei0r_filter_set_property (GObject * object, guint prop_id,
   GstFrei0rFilterClass *klass = GST_FREI0R_FILTER_GET_CLASS (object);
 
   GST_OBJECT_LOCK (self);
-  if (!gst_frei0r_set_property (self->f0r_instance, klass->ftable,
+  if (klass->n_threads_prop_id && prop_id == klass->n_threads_prop_id) {
+    /* used when the instances are created, on the first frame or after a
+     * frame size change */
+    self->n_threads = g_value_get_uint (value);
+  } else if (!gst_frei0r_set_property (self->f0r_instances ?
+          self->f0r_instances->instances[0] : NULL, klass->ftable,
           klass->properties, klass->n_properties, self->property_cache, prop_id,
-          value))
+          value)) {
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+  } else if (self->f0r_instances) {
+    gst_frei0r_instances_sync_property (self->f0r_instances, klass->ftable,
+        klass->properties, klass->n_properties, self->property_cache,
+        prop_id);
+  }
   GST_OBJECT_UNLOCK (self);
 }
 
@@ -198,6 +215,7 @@ gst_frei0r_filter_class_init (GstFrei0rFilterClass * klass,
   const gchar *desc;
   GstCaps *caps;
   gchar *author;
+  guint prop_id;
 
   klass->ftable = &class_data->ftable;
   klass->info = &class_data->info;
@@ -209,9 +227,20 @@ gst_frei0r_filter_class_init (GstFrei0rFilterClass * klass,
   klass->n_properties = klass->info->num_params;
   klass->properties = g_new0 (GstFrei0rProperty, klass->n_properties);
 
-  gst_frei0r_klass_install_properties (gobject_class, klass->ftable,
+  prop_id = gst_frei0r_klass_install_properties (gobject_class, klass->ftable,
       klass->properties, klass->n_properties);
 
+  /* plugins known to work on slices of the frames can be run from several
+   * threads, each with its own instance. 0 means one thread per CPU */
+  if (gst_frei0r_plugin_is_slice_safe (klass->info,
+          g_type_name (G_TYPE_FROM_CLASS (klass)))) {
+    klass->n_threads_prop_id = prop_id;
+    g_object_class_install_property (gobject_class, prop_id,
+        g_param_spec_uint ("n-threads", "Threads",
+            "Maximum number of threads to use", 0, G_MAXUINT, 1,
+            G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  }
+
   author =
       g_strdup_printf
       ("Sebastian Dröge <sebastian.droege@collabora.co.uk>, %s",
@@ -246,6 +275,7 @@ gst_frei0r_filter_init (GstFrei0rFilter * self, GstFrei0rFilterClass * klass)
 {
   self->property_cache =
       gst_frei0r_property_cache_init (klass->properties, klass->n_properties);
+  self->n_threads = 1;
   gst_pad_use_fixed_caps (GST_BASE_TRANSFORM_SINK_PAD (self));
   gst_pad_use_fixed_caps (GST_BASE_TRANSFORM_SRC_PAD (self));
 }
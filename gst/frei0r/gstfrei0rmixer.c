@@ -41,9 +41,9 @@ gst_frei0r_mixer_reset (GstFrei0rMixer * self)
   GstFrei0rMixerClass *klass = GST_FREI0R_MIXER_GET_CLASS (self);
   GstEvent **p_ev;
 
-  if (self->f0r_instance) {
-    klass->ftable->destruct (self->f0r_instance);
-    self->f0r_instance = NULL;
+  if (self->f0r_instances) {
+    gst_frei0r_instances_free (self->f0r_instances, klass->ftable);
+    self->f0r_instances = NULL;
   }
 
   if (self->property_cache)
@@ -84,7 +84,10 @@ gst_frei0r_mixer_get_property (GObject * object, guint prop_id, GValue * value,
   GstFrei0rMixerClass *klass = GST_FREI0R_MIXER_GET_CLASS (object);
 
   GST_OBJECT_LOCK (self);
-  if (!gst_frei0r_get_property (self->f0r_instance, klass->ftable,
+  if (klass->n_threads_prop_id && prop_id == klass->n_threads_prop_id)
+    g_value_set_uint (value, self->n_threads);
+  else if (!gst_frei0r_get_property (self->f0r_instances ?
+          self->f0r_instances->instances[0] : NULL, klass->ftable,
           klass->properties, klass->n_properties, self->property_cache, prop_id,
           value))
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -99,10 +102,19 @@ gst_frei0r_mixer_set_property (GObject * object, guint prop_id,
   GstFrei0rMixerClass *klass = GST_FREI0R_MIXER_GET_CLASS (object);
 
   GST_OBJECT_LOCK (self);
-  if (!gst_frei0r_set_property (self->f0r_instance, klass->ftable,
+  if (klass->n_threads_prop_id && prop_id == klass->n_threads_prop_id) {
+    /* used when the instances are created, when starting */
+    self->n_threads = g_value_get_uint (value);
+  } else if (!gst_frei0r_set_property (self->f0r_instances ?
+          self->f0r_instances->instances[0] : NULL, klass->ftable,
           klass->properties, klass->n_properties, self->property_cache, prop_id,
-          value))
+          value)) {
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+  } else if (self->f0r_instances) {
+    gst_frei0r_instances_sync_property (self->f0r_instances, klass->ftable,
+        klass->properties, klass->n_properties, self->property_cache,
+        prop_id);
+  }
   GST_OBJECT_UNLOCK (self);
 }
 
@@ -519,15 +531,22 @@ gst_frei0r_mixer_collected (GstCollectPads * pads, GstFrei0rMixer * self)
   GstSegment *segment = NULL;
   GstAllocationParams alloc_params = { 0, 31, 0, 0 };
   GstMapInfo outmap, inmap0, inmap1, inmap2;
+  guint n_threads;
 
   if (G_UNLIKELY (self->info.width <= 0 || self->info.height <= 0))
     return GST_FLOW_NOT_NEGOTIATED;
 
-  if (G_UNLIKELY (!self->f0r_instance)) {
-    self->f0r_instance = gst_frei0r_instance_construct (klass->ftable,
+  if (G_UNLIKELY (!self->f0r_instances)) {
+    GST_OBJECT_LOCK (self);
+    n_threads = self->n_threads;
+    GST_OBJECT_UNLOCK (self);
+    if (n_threads == 0)
+      n_threads = g_get_num_processors ();
+
+    self->f0r_instances = gst_frei0r_instances_new (klass->ftable,
         klass->properties, klass->n_properties, self->property_cache,
-        self->info.width, self->info.height);
-    if (G_UNLIKELY (!self->f0r_instance))
+        self->info.width, self->info.height, n_threads);
+    if (G_UNLIKELY (!self->f0r_instances))
       return GST_FLOW_ERROR;
   }
 
@@ -576,7 +595,7 @@ gst_frei0r_mixer_collected (GstCollectPads * pads, GstFrei0rMixer * self)
   time = ((gdouble) GST_BUFFER_PTS (outbuf)) / GST_SECOND;
 
   GST_OBJECT_LOCK (self);
-  klass->ftable->update2 (self->f0r_instance, time,
+  gst_frei0r_instances_update (self->f0r_instances, klass->ftable, time,
       (const guint32 *) inmap0.data, (const guint32 *) inmap1.data,
       (inbuf2) ? (const guint32 *) inmap2.data : NULL, (guint32 *) outmap.data);
   GST_OBJECT_UNLOCK (self);
@@ -622,6 +641,7 @@ gst_frei0r_mixer_class_init (GstFrei0rMixerClass * klass,
   const gchar *desc;
   GstCaps *caps;
   gchar *author;
+  guint prop_id;
 
   klass->ftable = &class_data->ftable;
   klass->info = &class_data->info;
@@ -633,9 +653,20 @@ gst_frei0r_mixer_class_init (GstFrei0rMixerClass * klass,
   klass->n_properties = klass->info->num_params;
   klass->properties = g_new0 (GstFrei0rProperty, klass->n_properties);
 
-  gst_frei0r_klass_install_properties (gobject_class, klass->ftable,
+  prop_id = gst_frei0r_klass_install_properties (gobject_class, klass->ftable,
       klass->properties, klass->n_properties);
 
+  /* plugins known to work on slices of the frames can be run from several
+   * threads, each with its own instance. 0 means one thread per CPU */
+  if (gst_frei0r_plugin_is_slice_safe (klass->info,
+          g_type_name (G_TYPE_FROM_CLASS (klass)))) {
+    klass->n_threads_prop_id = prop_id;
+    g_object_class_install_property (gobject_class, prop_id,
+        g_param_spec_uint ("n-threads", "Threads",
+            "Maximum number of threads to use", 0, G_MAXUINT, 1,
+            G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  }
+
   author =
       g_strdup_printf
       ("Sebastian Dröge <sebastian.droege@collabora.co.uk>, %s",
@@ -681,6 +712,7 @@ gst_frei0r_mixer_init (GstFrei0rMixer * self, GstFrei0rMixerClass * klass)
 {
   self->property_cache =
       gst_frei0r_property_cache_init (klass->properties, klass->n_properties);
+  self->n_threads = 1;
   gst_video_info_init (&self->info);
 
   self->collect = gst_collect_pads_new ();
@@ -53,8 +53,10 @@ struct _GstFrei0rMixer {
 
   GstPadEventFunction collect_event;
 
-  f0r_instance_t *f0r_instance;
+  GstFrei0rInstances *f0r_instances;
   GstFrei0rPropertyValue *property_cache;
+
+  guint n_threads;
 };
 
 struct _GstFrei0rMixerClass {
@@ -65,6 +67,9 @@ struct _GstFrei0rMixerClass {
 
   GstFrei0rProperty *properties;
   gint n_properties;
+
+  /* 0 if the plugin can't process slices of the frames */
+  guint n_threads_prop_id;
 };
 
 GstFrei0rPluginRegisterReturn gst_frei0r_mixer_register (GstPlugin *plugin, const gchar * vendor, const f0r_plugin_info_t *info, const GstFrei0rFuncTable *ftable);
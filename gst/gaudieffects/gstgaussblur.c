@@ -51,6 +51,12 @@
  *
  * Gaussianblur blurs the video stream in realtime.
  *
+ * The filter is computed in fixed point, as one horizontal and one vertical
+ * pass. For sigma values larger than 6 the Gaussian kernel is approximated
+ * by three successive box filters, the cost of which does not depend on the
+ * sigma. Both passes can be split across several threads with
+ * #GstGaussianBlur:n-threads.
+ *
  * ## Example launch line
  * |[
  * gst-launch-1.0 -v videotestsrc ! gaussianblur ! videoconvert ! autovideosink
@@ -111,17 +117,44 @@ GST_STATIC_PAD_TEMPLATE ("src",
 enum
 {
   PROP_0,
-  PROP_SIGMA
+  PROP_SIGMA,
+  PROP_N_THREADS
 };
 
+typedef void (*GstGaussianBlurFunc) (GstGaussianBlur * gb,
+    GstVideoFrame * in_frame, GstVideoFrame * out_frame, gint start,
+    gint end);
+
+typedef struct
+{
+  GstGaussianBlur *gb;
+  GstGaussianBlurFunc func;
+  GstVideoFrame *in_frame;
+  GstVideoFrame *out_frame;
+  gint start, end;
+} GstGaussianBlurJob;
+
 static gboolean make_gaussian_kernel (GstGaussianBlur * gb, float sigma);
-static void gaussian_smooth (GstGaussianBlur * gb, guint8 * image,
-    guint8 * out_image);
+static void gaussian_smooth (GstGaussianBlur * gb, GstVideoFrame * in_frame,
+    GstVideoFrame * out_frame, guint n_threads);
 
 #define gst_gaussianblur_parent_class parent_class
 G_DEFINE_TYPE (GstGaussianBlur, gst_gaussianblur, GST_TYPE_VIDEO_FILTER);
 
 #define DEFAULT_SIGMA 1.2
+#define DEFAULT_N_THREADS 1
+
+/* fractional bits of the kernel coefficients and of the horizontally
+ * filtered pixels */
+#define KERNEL_SHIFT 14
+#define TEMP_SHIFT 4
+#define FIXED_ROUND(v, shift) (((v) + (1 << ((shift) - 1))) >> (shift))
+
+/* larger kernels are approximated by box filters */
+#define MAX_DIRECT_WINDOWSIZE 31
+
+/* minimum number of lines, or columns, processed by a thread */
+#define MIN_LINES_PER_JOB 16
 
 /* Initialize the gaussianblur's class. */
 static void
@@ -152,6 +185,19 @@ gst_gaussianblur_class_init (GstGaussianBlurClass * klass)
           -20.0, 20.0, DEFAULT_SIGMA,
           G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstGaussianBlur:n-threads:
+   *
+   * Maximum number of threads the horizontal and vertical passes are split
+   * across, 0 means one thread per CPU.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use", 0, G_MAXUINT,
+          DEFAULT_N_THREADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   vfilter_class->transform_frame =
       GST_DEBUG_FUNCPTR (gst_gaussianblur_transform_frame);
   vfilter_class->set_info = GST_DEBUG_FUNCPTR (gst_gaussianblur_set_info);
@@ -170,7 +216,14 @@ gst_gaussianblur_set_info (GstVideoFilter * filter, GstCaps * incaps,
   /* get stride */
   gb->stride = GST_VIDEO_INFO_COMP_STRIDE (in_info, 0);
   n_elems = gb->stride * gb->height;
-  gb->tempim = g_malloc (sizeof (gfloat) * n_elems);
+  g_free (gb->tempim);
+  gb->tempim = g_new (gint16, n_elems);
+
+  /* only needed for large sigma values, allocated on first use */
+  g_free (gb->smoothedim[0]);
+  gb->smoothedim[0] = NULL;
+  g_free (gb->smoothedim[1]);
+  gb->smoothedim[1] = NULL;
 
   return TRUE;
 }
@@ -180,6 +233,10 @@ gst_gaussianblur_init (GstGaussianBlur * gb)
 {
   gb->sigma = (gfloat) DEFAULT_SIGMA;
   gb->cur_sigma = -1.0;
+  gb->n_threads = DEFAULT_N_THREADS;
+
+  g_mutex_init (&gb->jobs_lock);
+  g_cond_init (&gb->jobs_cond);
 }
 
 static void
@@ -187,16 +244,25 @@ gst_gaussianblur_finalize (GObject * object)
 {
   GstGaussianBlur *gb = GST_GAUSSIANBLUR (object);
 
+  if (gb->pool)
+    g_thread_pool_free (gb->pool, FALSE, TRUE);
+  g_mutex_clear (&gb->jobs_lock);
+  g_cond_clear (&gb->jobs_cond);
+
   g_free (gb->tempim);
   gb->tempim = NULL;
 
-  g_free (gb->smoothedim);
-  gb->smoothedim = NULL;
+  g_free (gb->smoothedim[0]);
+  gb->smoothedim[0] = NULL;
+  g_free (gb->smoothedim[1]);
+  gb->smoothedim[1] = NULL;
 
   g_free (gb->kernel);
   gb->kernel = NULL;
   g_free (gb->kernel_sum);
   gb->kernel_sum = NULL;
+  g_free (gb->box_recip);
+  gb->box_recip = NULL;
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -209,7 +275,7 @@ gst_gaussianblur_transform_frame (GstVideoFilter * vfilter,
   GstClockTime timestamp;
   gint64 stream_time;
   gfloat sigma;
-  guint8 *src, *dest;
+  guint n_threads;
 
   /* GstController: update the properties */
   timestamp = GST_BUFFER_TIMESTAMP (in_frame->buffer);
@@ -225,6 +291,7 @@ gst_gaussianblur_transform_frame (GstVideoFilter * vfilter,
 
   GST_OBJECT_LOCK (filter);
   sigma = filter->sigma;
+  n_threads = filter->n_threads;
   GST_OBJECT_UNLOCK (filter);
 
   if (filter->cur_sigma != sigma) {
@@ -232,6 +299,8 @@ gst_gaussianblur_transform_frame (GstVideoFilter * vfilter,
     filter->kernel = NULL;
     g_free (filter->kernel_sum);
     filter->kernel_sum = NULL;
+    g_free (filter->box_recip);
+    filter->box_recip = NULL;
     filter->cur_sigma = sigma;
   }
   if (filter->kernel == NULL &&
@@ -241,115 +310,413 @@ gst_gaussianblur_transform_frame (GstVideoFilter * vfilter,
     return GST_FLOW_ERROR;
   }
 
+  if (n_threads == 0)
+    n_threads = g_get_num_processors ();
+
   /*
    * Perform gaussian smoothing on the image using the input standard
    * deviation.
    */
-  src = GST_VIDEO_FRAME_COMP_DATA (in_frame, 0);
-  dest = GST_VIDEO_FRAME_COMP_DATA (out_frame, 0);
-  gst_video_frame_copy (out_frame, in_frame);
-  if (filter->sigma != 0.0)
-    gaussian_smooth (filter, src, dest);
+  if (sigma != 0.0)
+    gaussian_smooth (filter, in_frame, out_frame, n_threads);
+  else
+    gst_video_frame_copy (out_frame, in_frame);
 
   return GST_FLOW_OK;
 }
 
+/* Filters a column close to the left or right edge of the row, where only
+ * part of the kernel applies */
 static void
-blur_row_x (GstGaussianBlur * gb, guint8 * in_row, gfloat * out_row)
+blur_edge_x (GstGaussianBlur * gb, const guint8 * in_row, gint16 * out_row,
+    gint c)
 {
-  int c, cc, center;
-  float dot[4], sum;
+  int cc, center;
+  gint32 dot[4], sum;
   int k, kmin, kmax;
 
   center = gb->windowsize / 2;
 
-  for (c = 0; c < gb->width; c++) {
-    /* Calculate min */
-    cc = center - c;
-    kmin = MAX (0, cc);
-    cc = kmin - cc;
-    /* Calc max */
-    kmax = MIN (gb->windowsize, gb->width - cc);
-    cc *= 4;
+  /* Calculate min */
+  cc = center - c;
+  kmin = MAX (0, cc);
+  cc = kmin - cc;
+  /* Calc max */
+  kmax = MIN (gb->windowsize, gb->width - cc + kmin);
+  cc *= 4;
+
+  dot[0] = dot[1] = dot[2] = dot[3] = 0;
+  /* Calculate sum for range */
+  sum = gb->kernel_sum[kmax - 1];
+  sum -= kmin ? gb->kernel_sum[kmin - 1] : 0;
+
+  for (k = kmin; k < kmax; k++) {
+    gint32 coeff = gb->kernel[k];
+    dot[0] += in_row[cc++] * coeff;
+    dot[1] += in_row[cc++] * coeff;
+    dot[2] += in_row[cc++] * coeff;
+    dot[3] += in_row[cc++] * coeff;
+  }
 
-    dot[0] = dot[1] = dot[2] = dot[3] = 0.0;
-    /* Calculate sum for range */
-    sum = gb->kernel_sum[kmax - 1];
-    sum -= kmin ? gb->kernel_sum[kmin - 1] : 0.0;
-
-    for (k = kmin; k < kmax; k++) {
-      float coeff = gb->kernel[k];
-      dot[0] += (float) in_row[cc++] * coeff;
-      dot[1] += (float) in_row[cc++] * coeff;
-      dot[2] += (float) in_row[cc++] * coeff;
-      dot[3] += (float) in_row[cc++] * coeff;
+  for (k = 0; k < 4; k++)
+    out_row[c * 4 + k] = (dot[k] * (1 << TEMP_SHIFT) + sum / 2) / sum;
+}
+
+static void
+blur_row_x (GstGaussianBlur * gb, const guint8 * in_row, gint16 * out_row,
+    gint32 * acc)
+{
+  const gint center = gb->windowsize / 2;
+  gint c, i, k, n, left, right;
+
+  /* pixels for which the whole kernel falls inside the row, accumulate one
+   * coefficient at a time over all of them so the loops vectorize */
+  n = (gb->width - 2 * center) * 4;
+  if (n > 0) {
+    for (i = 0; i < n; i++)
+      acc[i] = 0;
+
+    for (k = 0; k < gb->windowsize; k++) {
+      const gint32 coeff = gb->kernel[k];
+      const guint8 *in = in_row + k * 4;
+
+      for (i = 0; i < n; i++)
+        acc[i] += in[i] * coeff;
     }
 
-    out_row[c * 4] = dot[0] / sum;
-    out_row[c * 4 + 1] = dot[1] / sum;
-    out_row[c * 4 + 2] = dot[2] / sum;
-    out_row[c * 4 + 3] = dot[3] / sum;
+    for (i = 0; i < n; i++)
+      out_row[center * 4 + i] = FIXED_ROUND (acc[i], KERNEL_SHIFT - TEMP_SHIFT);
   }
+
+  left = MIN (center, gb->width);
+  right = MAX (left, gb->width - center);
+  for (c = 0; c < left; c++)
+    blur_edge_x (gb, in_row, out_row, c);
+  for (c = right; c < gb->width; c++)
+    blur_edge_x (gb, in_row, out_row, c);
 }
 
+/* One box filter pass over a line of 4 component pixels, pixels outside of
+ * the line are left out of the average */
 static void
-gaussian_smooth (GstGaussianBlur * gb, guint8 * image, guint8 * out_image)
+box_blur_line (const gint16 * src, gint16 * dest, gint width, gint radius,
+    const gint32 * recip)
 {
-  int r, c, rr, center;
-  float dot[4], sum;
-  int k, kmin, kmax;
-  guint8 *in_row = image;
-  float *tmp_out_row = gb->tempim;
-  float *tmp_in_pos;
-  gint y_avail = 0;
+  gint32 sum[4] = { 0, };
+  gint x, i, count;
+
+  count = MIN (radius + 1, width);
+  for (x = 0; x < count; x++) {
+    for (i = 0; i < 4; i++)
+      sum[i] += src[x * 4 + i];
+  }
+
+  for (x = 0; x < width; x++) {
+    for (i = 0; i < 4; i++)
+      dest[x * 4 + i] = FIXED_ROUND ((gint64) sum[i] * recip[count], 16);
+
+    if (x + radius + 1 < width) {
+      for (i = 0; i < 4; i++)
+        sum[i] += src[(x + radius + 1) * 4 + i];
+      count++;
+    }
+    if (x - radius >= 0) {
+      for (i = 0; i < 4; i++)
+        sum[i] -= src[(x - radius) * 4 + i];
+      count--;
+    }
+  }
+}
+
+static void
+box_blur_row_x (GstGaussianBlur * gb, const guint8 * in_row, gint16 * out_row,
+    gint16 * line0, gint16 * line1)
+{
+  const gint n = gb->width * 4;
+  gint i;
+
+  for (i = 0; i < n; i++)
+    line0[i] = in_row[i] << TEMP_SHIFT;
+
+  box_blur_line (line0, line1, gb->width, gb->box_radius[0], gb->box_recip);
+  box_blur_line (line1, line0, gb->width, gb->box_radius[1], gb->box_recip);
+  box_blur_line (line0, out_row, gb->width, gb->box_radius[2], gb->box_recip);
+
+  if (gb->cur_sigma < 0) {
+    for (i = 0; i < n; i++)
+      out_row[i] = 2 * (in_row[i] << TEMP_SHIFT) - out_row[i];
+  }
+}
+
+/* horizontal pass, from the input frame to tempim */
+static void
+blur_rows_x (GstGaussianBlur * gb, GstVideoFrame * in_frame,
+    GstVideoFrame * out_frame, gint y_start, gint y_end)
+{
+  const guint8 *in_row;
+  gint16 *tmp_out_row;
+  gint in_stride, r;
+  gpointer scratch;
+
+  in_stride = GST_VIDEO_FRAME_PLANE_STRIDE (in_frame, 0);
+  in_row = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
+  in_row += y_start * in_stride;
+  tmp_out_row = gb->tempim + y_start * gb->stride;
+
+  if (gb->box_radius[0] > 0) {
+    gint16 *line0, *line1;
+
+    scratch = g_new (gint16, gb->width * 4 * 2);
+    line0 = scratch;
+    line1 = line0 + gb->width * 4;
+
+    for (r = y_start; r < y_end; r++) {
+      box_blur_row_x (gb, in_row, tmp_out_row, line0, line1);
+      in_row += in_stride;
+      tmp_out_row += gb->stride;
+    }
+  } else {
+    scratch = g_new (gint32, gb->width * 4);
+
+    for (r = y_start; r < y_end; r++) {
+      blur_row_x (gb, in_row, tmp_out_row, scratch);
+      in_row += in_stride;
+      tmp_out_row += gb->stride;
+    }
+  }
+
+  g_free (scratch);
+}
+
+/* vertical pass applying the kernel, from tempim to the output frame */
+static void
+blur_rows_y (GstGaussianBlur * gb, GstVideoFrame * in_frame,
+    GstVideoFrame * out_frame, gint y_start, gint y_end)
+{
+  const gint n = gb->width * 4;
+  int r, rr, center;
+  gint32 sum;
+  int i, k, kmin, kmax;
+  gint32 *acc;
   guint8 *out_row;
+  gint out_stride;
+
+  out_stride = GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0);
+  acc = g_new (gint32, n);
 
-  /* Apply the gaussian kernel */
   center = gb->windowsize / 2;
 
-  /* Blur in the y - direction. */
-  for (r = 0; r < gb->height; r++) {
+  for (r = y_start; r < y_end; r++) {
+    const gint16 *tmp;
+
     /* Calculate input row range */
     rr = center - r;
     kmin = MAX (0, rr);
     rr = kmin - rr;
     /* Calc max */
-    kmax = MIN (gb->windowsize, gb->height - rr);
+    kmax = MIN (gb->windowsize, gb->height - rr + kmin);
 
     /* Precalculate sum for range */
     sum = gb->kernel_sum[kmax - 1];
-    sum -= kmin ? gb->kernel_sum[kmin - 1] : 0.0;
+    sum -= kmin ? gb->kernel_sum[kmin - 1] : 0;
 
-    /* Blur more input rows (x direction blur) */
-    while (y_avail <= (r + center) && y_avail < gb->height) {
-      blur_row_x (gb, in_row, tmp_out_row);
-      in_row += gb->stride;
-      tmp_out_row += gb->stride;
-      y_avail++;
+    for (i = 0; i < n; i++)
+      acc[i] = 0;
+
+    tmp = gb->tempim + rr * gb->stride;
+    for (k = kmin; k < kmax; k++, tmp += gb->stride) {
+      const gint32 kern = gb->kernel[k];
+
+      for (i = 0; i < n; i++)
+        acc[i] += tmp[i] * kern;
+    }
+
+    out_row = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
+    out_row += r * out_stride;
+
+    if (sum == 1 << KERNEL_SHIFT) {
+      for (i = 0; i < n; i++) {
+        gint v = FIXED_ROUND (acc[i], KERNEL_SHIFT + TEMP_SHIFT);
+        out_row[i] = CLAMP (v, 0, 255);
+      }
+    } else {
+      for (i = 0; i < n; i++) {
+        gint v = FIXED_ROUND (acc[i] / sum, TEMP_SHIFT);
+        out_row[i] = CLAMP (v, 0, 255);
+      }
+    }
+  }
+
+  g_free (acc);
+}
+
+/* One box filter pass over @n interleaved columns of @height samples, with
+ * running sums for all of them */
+static void
+box_blur_columns (const gint16 * src, gint16 * dest, gint stride, gint n,
+    gint height, gint radius, const gint32 * recip, gint32 * sum)
+{
+  gint y, i, count;
+
+  for (i = 0; i < n; i++)
+    sum[i] = 0;
+
+  count = MIN (radius + 1, height);
+  for (y = 0; y < count; y++) {
+    const gint16 *s = src + y * stride;
+
+    for (i = 0; i < n; i++)
+      sum[i] += s[i];
+  }
+
+  for (y = 0; y < height; y++) {
+    const gint64 mul = recip[count];
+    gint16 *d = dest + y * stride;
+
+    for (i = 0; i < n; i++)
+      d[i] = FIXED_ROUND (sum[i] * mul, 16);
+
+    if (y + radius + 1 < height) {
+      const gint16 *s = src + (y + radius + 1) * stride;
+
+      for (i = 0; i < n; i++)
+        sum[i] += s[i];
+      count++;
     }
+    if (y - radius >= 0) {
+      const gint16 *s = src + (y - radius) * stride;
 
-    tmp_in_pos = gb->tempim + (rr * gb->stride);
-    out_row = out_image + r * gb->stride;
+      for (i = 0; i < n; i++)
+        sum[i] -= s[i];
+      count--;
+    }
+  }
+}
 
-    for (c = 0; c < gb->width; c++) {
-      float *tmp = tmp_in_pos;
+/* vertical pass with box filters, from tempim to the output frame. Split
+ * by columns as each pass needs the whole output of the previous one */
+static void
+box_blur_columns_y (GstGaussianBlur * gb, GstVideoFrame * in_frame,
+    GstVideoFrame * out_frame, gint x_start, gint x_end)
+{
+  const gint n = (x_end - x_start) * 4;
+  const gint16 *tmp = gb->tempim + x_start * 4;
+  gint16 *s0 = gb->smoothedim[0] + x_start * 4;
+  gint16 *s1 = gb->smoothedim[1] + x_start * 4;
+  guint8 *out_row;
+  gint out_stride, r, i;
+  gint32 *sum;
+
+  sum = g_new (gint32, n);
+  box_blur_columns (tmp, s0, gb->stride, n, gb->height, gb->box_radius[0],
+      gb->box_recip, sum);
+  box_blur_columns (s0, s1, gb->stride, n, gb->height, gb->box_radius[1],
+      gb->box_recip, sum);
+  box_blur_columns (s1, s0, gb->stride, n, gb->height, gb->box_radius[2],
+      gb->box_recip, sum);
+  g_free (sum);
+
+  out_stride = GST_VIDEO_FRAME_PLANE_STRIDE (out_frame, 0);
+  out_row = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
+  out_row += x_start * 4;
 
-      dot[0] = dot[1] = dot[2] = dot[3] = 0.0;
-      for (k = kmin; k < kmax; k++, tmp += gb->stride) {
-        float kern = gb->kernel[k];
-        dot[0] += tmp[0] * kern;
-        dot[1] += tmp[1] * kern;
-        dot[2] += tmp[2] * kern;
-        dot[3] += tmp[3] * kern;
+  for (r = 0; r < gb->height; r++) {
+    if (gb->cur_sigma < 0) {
+      for (i = 0; i < n; i++) {
+        gint v = FIXED_ROUND (2 * tmp[i] - s0[i], TEMP_SHIFT);
+        out_row[i] = CLAMP (v, 0, 255);
       }
+    } else {
+      for (i = 0; i < n; i++) {
+        gint v = FIXED_ROUND (s0[i], TEMP_SHIFT);
+        out_row[i] = CLAMP (v, 0, 255);
+      }
+    }
+    tmp += gb->stride;
+    s0 += gb->stride;
+    out_row += out_stride;
+  }
+}
+
+static void
+gst_gaussianblur_job (gpointer data, gpointer user_data)
+{
+  GstGaussianBlurJob *job = data;
+  GstGaussianBlur *gb = job->gb;
+
+  job->func (gb, job->in_frame, job->out_frame, job->start, job->end);
+
+  g_mutex_lock (&gb->jobs_lock);
+  if (--gb->jobs_pending == 0)
+    g_cond_signal (&gb->jobs_cond);
+  g_mutex_unlock (&gb->jobs_lock);
+}
+
+/* splits the @n_lines lines or columns of a pass across the threads and
+ * waits for all of them to be done */
+static void
+gst_gaussianblur_run (GstGaussianBlur * gb, GstGaussianBlurFunc func,
+    GstVideoFrame * in_frame, GstVideoFrame * out_frame, gint n_lines,
+    guint n_threads)
+{
+  GstGaussianBlurJob *jobs;
+  guint n_jobs, i;
+  gint lines;
+
+  n_jobs = CLAMP (n_lines / MIN_LINES_PER_JOB, 1, n_threads);
+
+  if (n_jobs == 1) {
+    func (gb, in_frame, out_frame, 0, n_lines);
+    return;
+  }
+
+  if (gb->pool == NULL)
+    gb->pool = g_thread_pool_new (gst_gaussianblur_job, NULL, -1, FALSE, NULL);
+
+  jobs = g_newa (GstGaussianBlurJob, n_jobs);
+  lines = (n_lines + n_jobs - 1) / n_jobs;
+
+  for (i = 0; i < n_jobs; i++) {
+    jobs[i].gb = gb;
+    jobs[i].func = func;
+    jobs[i].in_frame = in_frame;
+    jobs[i].out_frame = out_frame;
+    jobs[i].start = MIN (i * lines, n_lines);
+    jobs[i].end = MIN ((i + 1) * lines, n_lines);
+  }
+
+  gb->jobs_pending = n_jobs - 1;
+  for (i = 1; i < n_jobs; i++)
+    g_thread_pool_push (gb->pool, &jobs[i], NULL);
 
-      *out_row++ = (guint8) CLAMP ((dot[0] / sum + 0.5), 0, 255);
-      *out_row++ = (guint8) CLAMP ((dot[1] / sum + 0.5), 0, 255);
-      *out_row++ = (guint8) CLAMP ((dot[2] / sum + 0.5), 0, 255);
-      *out_row++ = (guint8) CLAMP ((dot[3] / sum + 0.5), 0, 255);
+  /* do the first part from the streaming thread */
+  func (gb, in_frame, out_frame, jobs[0].start, jobs[0].end);
 
-      tmp_in_pos += 4;
+  g_mutex_lock (&gb->jobs_lock);
+  while (gb->jobs_pending > 0)
+    g_cond_wait (&gb->jobs_cond, &gb->jobs_lock);
+  g_mutex_unlock (&gb->jobs_lock);
+}
+
+static void
+gaussian_smooth (GstGaussianBlur * gb, GstVideoFrame * in_frame,
+    GstVideoFrame * out_frame, guint n_threads)
+{
+  /* Blur in the x - direction. */
+  gst_gaussianblur_run (gb, blur_rows_x, in_frame, out_frame, gb->height,
+      n_threads);
+
+  /* Blur in the y - direction. */
+  if (gb->box_radius[0] > 0) {
+    if (gb->smoothedim[0] == NULL) {
+      gb->smoothedim[0] = g_new (gint16, gb->stride * gb->height);
+      gb->smoothedim[1] = g_new (gint16, gb->stride * gb->height);
     }
+    gst_gaussianblur_run (gb, box_blur_columns_y, in_frame, out_frame,
+        gb->width, n_threads);
+  } else {
+    gst_gaussianblur_run (gb, blur_rows_y, in_frame, out_frame, gb->height,
+        n_threads);
   }
 }
 
@@ -360,60 +727,95 @@ static gboolean
 make_gaussian_kernel (GstGaussianBlur * gb, float sigma)
 {
   int i, center, left, right;
-  float sum, sum2;
+  float sum;
+  gint32 sum2;
+  float *kernel;
   const float fe = -0.5 / (sigma * sigma);
   const float dx = 1.0 / (sigma * sqrt (2 * G_PI));
 
   center = ceil (2.5 * fabs (sigma));
   gb->windowsize = (int) (1 + 2 * center);
 
-  gb->kernel = g_new (float, gb->windowsize);
-  gb->kernel_sum = g_new (float, gb->windowsize);
+  gb->kernel = g_new (gint32, gb->windowsize);
+  gb->kernel_sum = g_new (gint32, gb->windowsize);
   if (gb->kernel == NULL || gb->kernel_sum == NULL)
     return FALSE;
 
+  gb->box_radius[0] = gb->box_radius[1] = gb->box_radius[2] = 0;
+
   if (gb->windowsize == 1) {
-    gb->kernel[0] = 1.0;
-    gb->kernel_sum[0] = 1.0;
+    gb->kernel[0] = 1 << KERNEL_SHIFT;
+    gb->kernel_sum[0] = 1 << KERNEL_SHIFT;
     return TRUE;
   }
 
+  kernel = g_newa (float, gb->windowsize);
+
   /* Center co-efficient */
-  sum = gb->kernel[center] = dx;
+  sum = kernel[center] = dx;
 
   /* Other coefficients */
   left = center - 1;
   right = center + 1;
   for (i = 1; i <= center; i++, left--, right++) {
     float fx = dx * pow (G_E, fe * i * i);
-    gb->kernel[right] = gb->kernel[left] = fx;
+    kernel[right] = kernel[left] = fx;
     sum += 2 * fx;
   }
 
   if (sigma < 0) {
     sum = -sum;
-    gb->kernel[center] += 2.0 * sum;
+    kernel[center] += 2.0 * sum;
   }
 
-  for (i = 0; i < gb->windowsize; i++)
-    gb->kernel[i] /= sum;
+  /* convert to fixed point, putting the rounding error in the center so
+   * the coefficients add up to exactly 1 */
+  sum2 = 0;
+  for (i = 0; i < gb->windowsize; i++) {
+    gb->kernel[i] = floor (kernel[i] / sum * (1 << KERNEL_SHIFT) + 0.5);
+    sum2 += gb->kernel[i];
+  }
+  gb->kernel[center] += (1 << KERNEL_SHIFT) - sum2;
 
-  sum2 = 0.0;
+  sum2 = 0;
   for (i = 0; i < gb->windowsize; i++) {
     sum2 += gb->kernel[i];
     gb->kernel_sum[i] = sum2;
   }
 
+  if (gb->windowsize > MAX_DIRECT_WINDOWSIZE) {
+    float s2 = sigma * sigma;
+    int wl, m;
+
+    /* sizes of the three box filters whose succession has the closest
+     * standard deviation, from Kovesi's "Fast Almost-Gaussian Filtering" */
+    wl = floor (sqrt (4.0 * s2 + 1.0));
+    if (wl % 2 == 0)
+      wl--;
+    m = floor ((12.0 * s2 - 3 * wl * wl - 12 * wl - 9) / (-4 * wl - 4) + 0.5);
+    m = CLAMP (m, 0, 3);
+
+    for (i = 0; i < 3; i++)
+      gb->box_radius[i] = (i < m ? wl : wl + 2) / 2;
+
+    gb->box_recip = g_new (gint32, wl + 3);
+    for (i = 1; i <= wl + 2; i++)
+      gb->box_recip[i] = ((1 << 16) + i / 2) / i;
+
+    GST_DEBUG_OBJECT (gb, "approximating sigma %f with box radii %d %d %d",
+        sigma, gb->box_radius[0], gb->box_radius[1], gb->box_radius[2]);
+  }
+
 #if 0
   g_print ("Sigma %f: ", sigma);
   for (i = 0; i < gb->windowsize; i++)
-    g_print ("%f ", gb->kernel[i]);
+    g_print ("%d ", gb->kernel[i]);
   g_print ("\n");
   g_print ("sums: ");
   for (i = 0; i < gb->windowsize; i++)
-    g_print ("%f ", gb->kernel_sum[i]);
+    g_print ("%d ", gb->kernel_sum[i]);
   g_print ("\n");
-  g_print ("sum %f sum2 %f\n", sum, sum2);
+  g_print ("sum %f sum2 %d\n", sum, sum2);
 #endif
 
   return TRUE;
@@ -430,6 +832,11 @@ gst_gaussianblur_set_property (GObject * object,
       gb->sigma = g_value_get_double (value);
       GST_OBJECT_UNLOCK (object);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (object);
+      gb->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (object);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -447,6 +854,11 @@ gst_gaussianblur_get_property (GObject * object,
       g_value_set_double (value, gb->sigma);
       GST_OBJECT_UNLOCK (gb);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (gb);
+      g_value_set_uint (value, gb->n_threads);
+      GST_OBJECT_UNLOCK (gb);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -69,10 +69,26 @@ struct _GstGaussianBlur
   float cur_sigma, sigma;
   int windowsize;
 
-  float *kernel;
-  float *kernel_sum;
-  float *tempim;
-  gint16 *smoothedim;
+  /* kernel coefficients and their running sum, in 2.14 fixed point */
+  gint32 *kernel;
+  gint32 *kernel_sum;
+
+  /* radii of the three box filters used instead of the kernel for large
+   * sigma values, 0 when the kernel is applied directly */
+  gint box_radius[3];
+  /* 1 / n in 16.16 fixed point, for n up to the largest box size */
+  gint32 *box_recip;
+
+  /* horizontally filtered frame, in 12.4 fixed point */
+  gint16 *tempim;
+  /* intermediate results of the vertical box filters */
+  gint16 *smoothedim[2];
+
+  guint n_threads;
+  GThreadPool *pool;
+  GMutex jobs_lock;
+  GCond jobs_cond;
+  guint jobs_pending;
 };
 
 struct _GstGaussianBlurClass
@@ -148,6 +148,7 @@ gst_dp_payload_buffer (GstBuffer * buffer, GstDPHeaderFlag flags)
   guint16 flags_mask;
   guint16 header_crc = 0, crc = 0;
   gsize buffer_size;
+  guint n_mems, i;
 
   mem = gst_allocator_alloc (NULL, GST_DP_HEADER_LENGTH, NULL);
   gst_memory_map (mem, &map, GST_MAP_READWRITE);
@@ -220,8 +221,20 @@ gst_dp_payload_buffer (GstBuffer * buffer, GstDPHeaderFlag flags)
   /* header */
   gst_buffer_append_memory (ret_buf, mem);
 
-  /* buffer data */
-  return gst_buffer_append (ret_buf, gst_buffer_ref (buffer));
+  /* buffer data, we only reference the memories of the payload so that the
+   * header and the payload stay separate memories. Only if they don't all
+   * fit into the buffer the payload memories have to be merged */
+  n_mems = gst_buffer_n_memory (buffer);
+  if (n_mems < gst_buffer_get_max_memory ()) {
+    for (i = 0; i < n_mems; i++)
+      gst_buffer_append_memory (ret_buf,
+          gst_memory_ref (gst_buffer_peek_memory (buffer, i)));
+  } else {
+    GST_LOG ("merging %u payload memories", n_mems);
+    gst_buffer_append_memory (ret_buf, gst_buffer_get_all_memory (buffer));
+  }
+
+  return ret_buf;
 }
 
 GstBuffer *
@@ -508,14 +521,39 @@ gst_dp_buffer_from_header (guint header_length, const guint8 * header,
       gst_buffer_new_allocate (allocator,
       (guint) GST_DP_HEADER_PAYLOAD_LENGTH (header), allocation_params);
 
+  gst_dp_buffer_set_header_fields (buffer, header_length, header);
+
+  return buffer;
+}
+
+/**
+ * gst_dp_buffer_set_header_fields:
+ * @buffer: a writable #GstBuffer
+ * @header_length: the length of the packet header
+ * @header: the byte array of the packet header
+ *
+ * Sets the timestamps, offsets and flags of @buffer from the given header.
+ *
+ * Use this function if the buffer already contains the packet payload, for
+ * example because it was taken from an adapter without copying.
+ *
+ * This function does not check the header passed to it, use
+ * gst_dp_validate_header() first if the header data is unchecked.
+ */
+void
+gst_dp_buffer_set_header_fields (GstBuffer * buffer, guint header_length,
+    const guint8 * header)
+{
+  g_return_if_fail (gst_buffer_is_writable (buffer));
+  g_return_if_fail (header != NULL);
+  g_return_if_fail (header_length >= GST_DP_HEADER_LENGTH);
+
   GST_BUFFER_TIMESTAMP (buffer) = GST_DP_HEADER_TIMESTAMP (header);
   GST_BUFFER_DTS (buffer) = GST_DP_HEADER_DTS (header);
   GST_BUFFER_DURATION (buffer) = GST_DP_HEADER_DURATION (header);
   GST_BUFFER_OFFSET (buffer) = GST_DP_HEADER_OFFSET (header);
   GST_BUFFER_OFFSET_END (buffer) = GST_DP_HEADER_OFFSET_END (header);
   GST_BUFFER_FLAGS (buffer) = GST_DP_HEADER_BUFFER_FLAGS (header);
-
-  return buffer;
 }
 
 /**
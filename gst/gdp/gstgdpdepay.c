@@ -87,6 +87,7 @@ static void gst_gdp_depay_set_property (GObject * object, guint prop_id,
 static void gst_gdp_depay_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 static void gst_gdp_depay_decide_allocation (GstGDPDepay * depay);
+static GstBuffer *gst_gdp_depay_take_payload (GstGDPDepay * depay);
 
 static void
 gst_gdp_depay_class_init (GstGDPDepayClass * klass)
@@ -144,6 +145,7 @@ gst_gdp_depay_init (GstGDPDepay * gdpdepay)
 
   gdpdepay->allocator = NULL;
   gst_allocation_params_init (&gdpdepay->allocation_params);
+  gdpdepay->zero_copy = TRUE;
 }
 
 static void
@@ -362,21 +364,35 @@ gst_gdp_depay_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
           goto no_caps;
 
         GST_LOG_OBJECT (this, "reading GDP buffer from adapter");
-        buf =
-            gst_dp_buffer_from_header (GST_DP_HEADER_LENGTH, this->header,
-            this->allocator, &this->allocation_params);
-        if (!buf)
-          goto buffer_failed;
+        buf = NULL;
 
-        /* now take the payload if there is any */
-        if (this->payload_length > 0) {
-          GstMapInfo map;
+        /* if the payload is contiguous in the adapter we can push it as a
+         * sub-buffer of the input without copying */
+        if (this->zero_copy && this->payload_length > 0 &&
+            gst_adapter_available_fast (this->adapter) >= this->payload_length)
+          buf = gst_gdp_depay_take_payload (this);
 
-          gst_buffer_map (buf, &map, GST_MAP_WRITE);
-          gst_adapter_copy (this->adapter, map.data, 0, this->payload_length);
-          gst_buffer_unmap (buf, &map);
-
-          gst_adapter_flush (this->adapter, this->payload_length);
+        if (buf) {
+          gst_dp_buffer_set_header_fields (buf, GST_DP_HEADER_LENGTH,
+              this->header);
+        } else {
+          buf =
+              gst_dp_buffer_from_header (GST_DP_HEADER_LENGTH, this->header,
+              this->allocator, &this->allocation_params);
+          if (!buf)
+            goto buffer_failed;
+
+          /* now take the payload if there is any */
+          if (this->payload_length > 0) {
+            GstMapInfo map;
+
+            gst_buffer_map (buf, &map, GST_MAP_WRITE);
+            gst_adapter_copy (this->adapter, map.data, 0,
+                this->payload_length);
+            gst_buffer_unmap (buf, &map);
+
+            gst_adapter_flush (this->adapter, this->payload_length);
+          }
         }
 
         if (GST_BUFFER_TIMESTAMP (buf) > -this->ts_offset)
@@ -538,6 +554,7 @@ gst_gdp_depay_change_state (GstElement * element, GstStateChange transition)
         gst_object_unref (this->allocator);
       this->allocator = NULL;
       gst_allocation_params_init (&this->allocation_params);
+      this->zero_copy = TRUE;
       break;
     default:
       break;
@@ -545,6 +562,31 @@ gst_gdp_depay_change_state (GstElement * element, GstStateChange transition)
   return ret;
 }
 
+/* Takes the payload out of the adapter as a sub-buffer if that satisfies the
+ * alignment that downstream asked for, returns NULL and leaves the adapter
+ * untouched otherwise */
+static GstBuffer *
+gst_gdp_depay_take_payload (GstGDPDepay * this)
+{
+  gsize align = this->allocation_params.align;
+
+  if (align) {
+    const guint8 *data;
+    gboolean aligned;
+
+    data = gst_adapter_map (this->adapter, this->payload_length);
+    aligned = ((guintptr) data & align) == 0;
+    gst_adapter_unmap (this->adapter);
+
+    if (!aligned) {
+      GST_LOG_OBJECT (this, "payload not aligned, copying");
+      return NULL;
+    }
+  }
+
+  return gst_adapter_take_buffer (this->adapter, this->payload_length);
+}
+
 static void
 gst_gdp_depay_decide_allocation (GstGDPDepay * gdpdepay)
 {
@@ -583,6 +625,14 @@ gst_gdp_depay_decide_allocation (GstGDPDepay * gdpdepay)
   gdpdepay->allocator = allocator;
   gdpdepay->allocation_params = params;
 
+  /* sub-buffers of the input are system memory, so we can only use them if
+   * downstream doesn't need memory from a special allocator or extra
+   * prefix or padding */
+  gdpdepay->zero_copy = (allocator == NULL ||
+      !GST_OBJECT_FLAG_IS_SET (allocator, GST_ALLOCATOR_FLAG_CUSTOM_ALLOC)) &&
+      params.prefix == 0 && params.padding == 0;
+  GST_DEBUG_OBJECT (gdpdepay, "zero-copy payloads: %d", gdpdepay->zero_copy);
+
   gst_caps_unref (caps);
   gst_query_unref (query);
 }
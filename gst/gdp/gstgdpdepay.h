@@ -71,6 +71,8 @@ struct _GstGDPDepay
 
   GstAllocator *allocator;
   GstAllocationParams allocation_params;
+  /* whether payloads may be pushed as sub-buffers of the input */
+  gboolean zero_copy;
 };
 
 struct _GstGDPDepayClass
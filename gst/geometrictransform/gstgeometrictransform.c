@@ -49,7 +49,8 @@ static GstVideoFilterClass *parent_class = NULL;
 enum
 {
   PROP_0,
-  PROP_OFF_EDGE_PIXELS
+  PROP_OFF_EDGE_PIXELS,
+  PROP_N_THREADS
 };
 
 #define GST_GT_OFF_EDGES_PIXELS_METHOD_TYPE ( \
@@ -75,6 +76,56 @@ gst_geometric_transform_off_edges_pixels_method_get_type (void)
 }
 
 #define DEFAULT_OFF_EDGE_PIXELS GST_GT_OFF_EDGES_PIXELS_IGNORE
+#define DEFAULT_N_THREADS 1
+
+/* don't bother other threads with less rows than this */
+#define MIN_ROWS_PER_JOB 16
+
+typedef struct
+{
+  GstGeometricTransform *gt;
+  const guint8 *in_data;
+  guint8 *out_data;
+  gint y_start;
+  gint y_end;
+} GstGeometricTransformJob;
+
+/* Resolves the off edge pixels handling and returns the input byte offset
+ * for the given input coordinates, or -1 if the pixel must be ignored */
+static gint32
+gst_geometric_transform_map_offset (GstGeometricTransform * gt,
+    gdouble in_x, gdouble in_y)
+{
+  gint trunc_x, trunc_y;
+
+  switch (gt->off_edge_pixels) {
+    case GST_GT_OFF_EDGES_PIXELS_CLAMP:
+      in_x = CLAMP (in_x, 0, gt->width - 1);
+      in_y = CLAMP (in_y, 0, gt->height - 1);
+      break;
+
+    case GST_GT_OFF_EDGES_PIXELS_WRAP:
+      in_x = gst_gm_mod_float (in_x, gt->width);
+      in_y = gst_gm_mod_float (in_y, gt->height);
+      if (in_x < 0)
+        in_x += gt->width;
+      if (in_y < 0)
+        in_y += gt->height;
+      break;
+
+    default:
+      break;
+  }
+
+  trunc_x = (gint) in_x;
+  trunc_y = (gint) in_y;
+  /* only map to valid pixels */
+  if (trunc_x < 0 || trunc_x >= gt->width || trunc_y < 0 ||
+      trunc_y >= gt->height)
+    return -1;
+
+  return trunc_y * gt->row_stride + trunc_x * gt->pixel_stride;
+}
 
 /* must be called with the object lock */
 static gboolean
@@ -84,7 +135,7 @@ gst_geometric_transform_generate_map (GstGeometricTransform * gt)
   gdouble in_x, in_y;
   gboolean ret = TRUE;
   GstGeometricTransformClass *klass;
-  gdouble *ptr;
+  gint32 *ptr;
 
   GST_INFO_OBJECT (gt, "Generating new transform map");
 
@@ -98,9 +149,10 @@ gst_geometric_transform_generate_map (GstGeometricTransform * gt)
   g_return_val_if_fail (klass->map_func, FALSE);
 
   /*
-   * (x,y) pairs of the inverse mapping
+   * input offsets of the inverse mapping, with the off edge pixels
+   * already resolved
    */
-  gt->map = g_malloc0 (sizeof (gdouble) * gt->width * gt->height * 2);
+  gt->map = g_malloc0 (sizeof (gint32) * gt->width * gt->height);
   ptr = gt->map;
 
   for (y = 0; y < gt->height; y++) {
@@ -111,9 +163,7 @@ gst_geometric_transform_generate_map (GstGeometricTransform * gt)
         goto end;
       }
 
-      ptr[0] = in_x;
-      ptr[1] = in_y;
-      ptr += 2;
+      *ptr++ = gst_geometric_transform_map_offset (gt, in_x, in_y);
     }
   }
 
@@ -135,6 +185,8 @@ gst_geometric_transform_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
   gboolean ret = TRUE;
   gint old_width;
   gint old_height;
+  gint old_row_stride;
+  gint old_pixel_stride;
   GstGeometricTransformClass *klass;
 
   gt = GST_GEOMETRIC_TRANSFORM_CAST (vfilter);
@@ -142,16 +194,30 @@ gst_geometric_transform_set_info (GstVideoFilter * vfilter, GstCaps * incaps,
 
   old_width = gt->width;
   old_height = gt->height;
+  old_row_stride = gt->row_stride;
+  old_pixel_stride = gt->pixel_stride;
 
   gt->width = in_info->width;
   gt->height = in_info->height;
   gt->row_stride = in_info->stride[0];
   gt->pixel_stride = GST_VIDEO_INFO_COMP_PSTRIDE (in_info, 0);
 
-  /* regenerate the map */
+  if (GST_VIDEO_INFO_FORMAT (in_info) == GST_VIDEO_FORMAT_AYUV) {
+    /* in AYUV black is not just all zeros:
+     * 0x10 is black for Y,
+     * 0x80 is black for Cr and Cb */
+    GST_WRITE_UINT32_BE (gt->black, 0xff108080);
+  } else {
+    memset (gt->black, 0, sizeof (gt->black));
+  }
+
+  /* regenerate the map, it contains byte offsets so it also depends on
+   * the strides */
   GST_OBJECT_LOCK (gt);
   if (gt->map == NULL || old_width == 0 || old_height == 0
-      || gt->width != old_width || gt->height != old_height) {
+      || gt->width != old_width || gt->height != old_height
+      || gt->row_stride != old_row_stride
+      || gt->pixel_stride != old_pixel_stride) {
     if (klass->prepare_func)
       if (!klass->prepare_func (gt)) {
         GST_OBJECT_UNLOCK (gt);
@@ -168,42 +234,129 @@ static void
 gst_geometric_transform_do_map (GstGeometricTransform * gt, guint8 * in_data,
     guint8 * out_data, gint x, gint y, gdouble in_x, gdouble in_y)
 {
-  gint in_offset;
+  gint32 in_offset;
   gint out_offset;
 
   out_offset = y * gt->row_stride + x * gt->pixel_stride;
+  in_offset = gst_geometric_transform_map_offset (gt, in_x, in_y);
 
-  /* operate on out of edge pixels */
-  switch (gt->off_edge_pixels) {
-    case GST_GT_OFF_EDGES_PIXELS_CLAMP:
-      in_x = CLAMP (in_x, 0, gt->width - 1);
-      in_y = CLAMP (in_y, 0, gt->height - 1);
-      break;
+  /* only set the values if the values are valid */
+  if (in_offset >= 0)
+    memcpy (out_data + out_offset, in_data + in_offset, gt->pixel_stride);
+}
 
-    case GST_GT_OFF_EDGES_PIXELS_WRAP:
-      in_x = gst_gm_mod_float (in_x, gt->width);
-      in_y = gst_gm_mod_float (in_y, gt->height);
-      if (in_x < 0)
-        in_x += gt->width;
-      if (in_y < 0)
-        in_y += gt->height;
-      break;
+#define REMAP_ROW(size) G_STMT_START {                \
+  guint8 black[size];                                 \
+                                                      \
+  memcpy (black, gt->black, size);                    \
+  for (x = 0; x < gt->width; x++) {                   \
+    if (map[x] >= 0)                                  \
+      memcpy (out, in_data + map[x], size);           \
+    else                                              \
+      memcpy (out, black, size);                      \
+    out += size;                                      \
+  }                                                   \
+} G_STMT_END
+
+/* Applies the precalculated map to the rows [y_start, y_end). Having a
+ * constant pixel size in each loop lets the compiler turn the copies into
+ * plain loads and stores. */
+static void
+gst_geometric_transform_remap_rows (GstGeometricTransform * gt,
+    const guint8 * in_data, guint8 * out_data, gint y_start, gint y_end)
+{
+  const gint32 *map = gt->map + y_start * gt->width;
+  gint x, y;
 
-    default:
-      break;
+  for (y = y_start; y < y_end; y++) {
+    guint8 *out = out_data + y * gt->row_stride;
+
+    switch (gt->pixel_stride) {
+      case 1:
+        REMAP_ROW (1);
+        break;
+      case 2:
+        REMAP_ROW (2);
+        break;
+      case 3:
+        REMAP_ROW (3);
+        break;
+      case 4:
+        REMAP_ROW (4);
+        break;
+      default:
+        g_assert_not_reached ();
+        break;
+    }
+
+    map += gt->width;
   }
+}
 
-  {
-    gint trunc_x = (gint) in_x;
-    gint trunc_y = (gint) in_y;
-    /* only set the values if the values are valid */
-    if (trunc_x >= 0 && trunc_x < gt->width && trunc_y >= 0 &&
-        trunc_y < gt->height) {
-      in_offset = trunc_y * gt->row_stride + trunc_x * gt->pixel_stride;
+#undef REMAP_ROW
 
-      memcpy (out_data + out_offset, in_data + in_offset, gt->pixel_stride);
-    }
+static void
+gst_geometric_transform_remap_job (gpointer data, gpointer user_data)
+{
+  GstGeometricTransformJob *job = data;
+  GstGeometricTransform *gt = job->gt;
+
+  gst_geometric_transform_remap_rows (gt, job->in_data, job->out_data,
+      job->y_start, job->y_end);
+
+  g_mutex_lock (&gt->jobs_lock);
+  if (--gt->jobs_pending == 0)
+    g_cond_signal (&gt->jobs_cond);
+  g_mutex_unlock (&gt->jobs_lock);
+}
+
+/* must be called with the object lock */
+static void
+gst_geometric_transform_remap (GstGeometricTransform * gt,
+    const guint8 * in_data, guint8 * out_data)
+{
+  GstGeometricTransformJob *jobs;
+  guint n_jobs, i;
+  gint rows;
+
+  n_jobs = gt->n_threads;
+  if (n_jobs == 0)
+    n_jobs = g_get_num_processors ();
+  n_jobs = CLAMP (gt->height / MIN_ROWS_PER_JOB, 1, n_jobs);
+
+  if (n_jobs == 1) {
+    gst_geometric_transform_remap_rows (gt, in_data, out_data, 0, gt->height);
+    return;
   }
+
+  if (gt->pool == NULL) {
+    gt->pool = g_thread_pool_new (gst_geometric_transform_remap_job, NULL,
+        -1, FALSE, NULL);
+  }
+
+  jobs = g_newa (GstGeometricTransformJob, n_jobs);
+  rows = (gt->height + n_jobs - 1) / n_jobs;
+
+  for (i = 0; i < n_jobs; i++) {
+    jobs[i].gt = gt;
+    jobs[i].in_data = in_data;
+    jobs[i].out_data = out_data;
+    jobs[i].y_start = MIN (i * rows, gt->height);
+    jobs[i].y_end = MIN ((i + 1) * rows, gt->height);
+  }
+
+  gt->jobs_pending = n_jobs - 1;
+  for (i = 1; i < n_jobs; i++)
+    g_thread_pool_push (gt->pool, &jobs[i], NULL);
+
+  /* do the first part from the streaming thread */
+  gst_geometric_transform_remap_rows (gt, in_data, out_data,
+      jobs[0].y_start, jobs[0].y_end);
+
+  g_mutex_lock (&gt->jobs_lock);
+  while (gt->jobs_pending > 0)
+    g_cond_wait (&gt->jobs_cond, &gt->jobs_lock);
+  g_mutex_unlock (&gt->jobs_lock);
 }
 
 static void
@@ -231,7 +384,6 @@ gst_geometric_transform_transform_frame (GstVideoFilter * vfilter,
   GstGeometricTransformClass *klass;
   gint x, y, i;
   GstFlowReturn ret = GST_FLOW_OK;
-  gdouble *ptr;
   guint8 *in_data;
   guint8 *out_data;
 
@@ -241,14 +393,18 @@ gst_geometric_transform_transform_frame (GstVideoFilter * vfilter,
   in_data = GST_VIDEO_FRAME_PLANE_DATA (in_frame, 0);
   out_data = GST_VIDEO_FRAME_PLANE_DATA (out_frame, 0);
 
-  if (GST_VIDEO_FRAME_FORMAT (out_frame) == GST_VIDEO_FORMAT_AYUV) {
-    /* in AYUV black is not just all zeros:
-     * 0x10 is black for Y,
-     * 0x80 is black for Cr and Cb */
-    for (i = 0; i < out_frame->map[0].size; i += 4)
-      GST_WRITE_UINT32_BE (out_data + i, 0xff108080);
-  } else {
-    memset (out_data, 0, out_frame->map[0].size);
+  /* with a precalculated map every output pixel is written, including the
+   * black ones */
+  if (!gt->precalc_map) {
+    if (GST_VIDEO_FRAME_FORMAT (out_frame) == GST_VIDEO_FORMAT_AYUV) {
+      /* in AYUV black is not just all zeros:
+       * 0x10 is black for Y,
+       * 0x80 is black for Cr and Cb */
+      for (i = 0; i < out_frame->map[0].size; i += 4)
+        GST_WRITE_UINT32_BE (out_data + i, 0xff108080);
+    } else {
+      memset (out_data, 0, out_frame->map[0].size);
+    }
   }
 
   GST_OBJECT_LOCK (gt);
@@ -261,16 +417,11 @@ gst_geometric_transform_transform_frame (GstVideoFilter * vfilter,
         }
       gst_geometric_transform_generate_map (gt);
     }
-    g_return_val_if_fail (gt->map, GST_FLOW_ERROR);
-    ptr = gt->map;
-    for (y = 0; y < gt->height; y++) {
-      for (x = 0; x < gt->width; x++) {
-        /* do the mapping */
-        gst_geometric_transform_do_map (gt, in_data, out_data, x, y, ptr[0],
-            ptr[1]);
-        ptr += 2;
-      }
+    if (gt->map == NULL) {
+      ret = GST_FLOW_ERROR;
+      goto end;
     }
+    gst_geometric_transform_remap (gt, in_data, out_data);
   } else {
     for (y = 0; y < gt->height; y++) {
       for (x = 0; x < gt->width; x++) {
@@ -304,6 +455,13 @@ gst_geometric_transform_set_property (GObject * object, guint prop_id,
     case PROP_OFF_EDGE_PIXELS:
       GST_OBJECT_LOCK (gt);
       gt->off_edge_pixels = g_value_get_enum (value);
+      /* the edge handling is baked into the map */
+      gt->needs_remap = TRUE;
+      GST_OBJECT_UNLOCK (gt);
+      break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (gt);
+      gt->n_threads = g_value_get_uint (value);
       GST_OBJECT_UNLOCK (gt);
       break;
     default:
@@ -324,12 +482,29 @@ gst_geometric_transform_get_property (GObject * object, guint prop_id,
     case PROP_OFF_EDGE_PIXELS:
       g_value_set_enum (value, gt->off_edge_pixels);
       break;
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (gt);
+      g_value_set_uint (value, gt->n_threads);
+      GST_OBJECT_UNLOCK (gt);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+static void
+gst_geometric_transform_finalize (GObject * object)
+{
+  GstGeometricTransform *gt = GST_GEOMETRIC_TRANSFORM_CAST (object);
+
+  if (gt->pool)
+    g_thread_pool_free (gt->pool, FALSE, TRUE);
+  g_mutex_clear (&gt->jobs_lock);
+  g_cond_clear (&gt->jobs_cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
 
 static gboolean
 gst_geometric_transform_stop (GstBaseTransform * trans)
@@ -373,6 +548,7 @@ gst_geometric_transform_class_init (gpointer klass, gpointer class_data)
 
   obj_class->set_property = gst_geometric_transform_set_property;
   obj_class->get_property = gst_geometric_transform_get_property;
+  obj_class->finalize = gst_geometric_transform_finalize;
 
   trans_class->stop = GST_DEBUG_FUNCPTR (gst_geometric_transform_stop);
   trans_class->before_transform =
@@ -389,6 +565,19 @@ gst_geometric_transform_class_init (gpointer klass, gpointer class_data)
           GST_GT_OFF_EDGES_PIXELS_METHOD_TYPE, DEFAULT_OFF_EDGE_PIXELS,
           GST_PARAM_CONTROLLABLE | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstGeometricTransform:n-threads:
+   *
+   * Maximum number of threads used to apply the precalculated map,
+   * 0 means one thread per CPU.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (obj_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use", 0, G_MAXUINT,
+          DEFAULT_N_THREADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_type_mark_as_plugin_api (GST_GT_OFF_EDGES_PIXELS_METHOD_TYPE, 0);
   gst_type_mark_as_plugin_api (GST_TYPE_GEOMETRIC_TRANSFORM, 0);
 }
@@ -399,6 +588,9 @@ gst_geometric_transform_init (GTypeInstance * instance, gpointer g_class)
   GstGeometricTransform *gt = GST_GEOMETRIC_TRANSFORM_CAST (instance);
 
   gt->off_edge_pixels = DEFAULT_OFF_EDGE_PIXELS;
+  gt->n_threads = DEFAULT_N_THREADS;
+  g_mutex_init (&gt->jobs_lock);
+  g_cond_init (&gt->jobs_cond);
   gt->precalc_map = TRUE;
   gt->needs_remap = TRUE;
 }
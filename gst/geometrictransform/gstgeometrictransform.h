@@ -99,8 +99,18 @@ struct _GstGeometricTransform {
 
   /* properties */
   gint off_edge_pixels;
-
-  gdouble *map;
+  guint n_threads;
+
+  /* input byte offset of the source pixel of each output pixel,
+   * or -1 if the output pixel stays black */
+  gint32 *map;
+  guint8 black[4];
+
+  /* workers for applying the map */
+  GThreadPool *pool;
+  GMutex jobs_lock;
+  GCond jobs_cond;
+  guint jobs_pending;
 };
 
 struct _GstGeometricTransformClass {
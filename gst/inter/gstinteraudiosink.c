@@ -226,7 +226,7 @@ gst_inter_audio_sink_stop (GstBaseSink * sink)
   GST_DEBUG_OBJECT (interaudiosink, "stop");
 
   g_mutex_lock (&interaudiosink->surface->mutex);
-  gst_adapter_clear (interaudiosink->surface->audio_adapter);
+  gst_inter_surface_audio_setup (interaudiosink->surface, 0, 0, 0);
   memset (&interaudiosink->surface->audio_info, 0, sizeof (GstAudioInfo));
   g_mutex_unlock (&interaudiosink->surface->mutex);
 
@@ -252,8 +252,9 @@ gst_inter_audio_sink_set_caps (GstBaseSink * sink, GstCaps * caps)
   g_mutex_lock (&interaudiosink->surface->mutex);
   interaudiosink->surface->audio_info = info;
   interaudiosink->info = info;
-  /* TODO: Ideally we would drain the source here */
-  gst_adapter_clear (interaudiosink->surface->audio_adapter);
+  /* TODO: Ideally we would drain the source here. The ring is set up for
+   * the new format on the next buffer */
+  gst_inter_surface_audio_setup (interaudiosink->surface, 0, 0, 0);
   g_mutex_unlock (&interaudiosink->surface->mutex);
 
   return TRUE;
@@ -270,10 +271,9 @@ gst_inter_audio_sink_event (GstBaseSink * sink, GstEvent * event)
       guint n;
 
       if ((n = gst_adapter_available (interaudiosink->input_adapter)) > 0) {
-        g_mutex_lock (&interaudiosink->surface->mutex);
-        tmp = gst_adapter_take_buffer (interaudiosink->input_adapter, n);
-        gst_adapter_push (interaudiosink->surface->audio_adapter, tmp);
-        g_mutex_unlock (&interaudiosink->surface->mutex);
+        tmp = gst_adapter_take_buffer_fast (interaudiosink->input_adapter, n);
+        gst_inter_surface_audio_write (interaudiosink->surface, tmp);
+        gst_buffer_unref (tmp);
       }
       break;
     }
@@ -288,7 +288,8 @@ static GstFlowReturn
 gst_inter_audio_sink_render (GstBaseSink * sink, GstBuffer * buffer)
 {
   GstInterAudioSink *interaudiosink = GST_INTER_AUDIO_SINK (sink);
-  guint n, bpf;
+  GstInterSurface *surface = interaudiosink->surface;
+  guint n, bpf, n_segments;
   guint64 period_time, buffer_time;
   guint64 period_samples, buffer_samples;
 
@@ -317,14 +318,20 @@ gst_inter_audio_sink_render (GstBaseSink * sink, GstBuffer * buffer)
       gst_util_uint64_scale (period_time, interaudiosink->info.rate,
       GST_SECOND);
 
-  n = gst_adapter_available (interaudiosink->surface->audio_adapter) / bpf;
-  while (n > buffer_samples) {
-    GST_DEBUG_OBJECT (interaudiosink, "flushing %" GST_TIME_FORMAT,
-        GST_TIME_ARGS (period_time));
-    gst_adapter_flush (interaudiosink->surface->audio_adapter,
-        period_samples * bpf);
-    n -= period_samples;
+  period_samples = MAX (period_samples, 1);
+
+  /* One segment per period, with room for buffer-time worth of samples
+   * plus the segment that is currently being written */
+  n_segments = gst_util_uint64_scale_ceil (buffer_samples, 1,
+      period_samples) + 1;
+  if (surface->audio_bpf != bpf ||
+      surface->audio_segment_samples != period_samples ||
+      surface->audio_n_segments != n_segments) {
+    GST_DEBUG_OBJECT (interaudiosink, "setting up ring of %u segments of %"
+        G_GUINT64_FORMAT " samples", n_segments, period_samples);
+    gst_inter_surface_audio_setup (surface, bpf, period_samples, n_segments);
   }
+  g_mutex_unlock (&surface->mutex);
 
   n = gst_adapter_available (interaudiosink->input_adapter);
   if (period_samples * bpf > gst_buffer_get_size (buffer) + n) {
@@ -333,13 +340,12 @@ gst_inter_audio_sink_render (GstBaseSink * sink, GstBuffer * buffer)
     GstBuffer *tmp;
 
     if (n > 0) {
-      tmp = gst_adapter_take_buffer (interaudiosink->input_adapter, n);
-      gst_adapter_push (interaudiosink->surface->audio_adapter, tmp);
+      tmp = gst_adapter_take_buffer_fast (interaudiosink->input_adapter, n);
+      gst_inter_surface_audio_write (surface, tmp);
+      gst_buffer_unref (tmp);
     }
-    gst_adapter_push (interaudiosink->surface->audio_adapter,
-        gst_buffer_ref (buffer));
+    gst_inter_surface_audio_write (surface, buffer);
   }
-  g_mutex_unlock (&interaudiosink->surface->mutex);
 
   return GST_FLOW_OK;
 }
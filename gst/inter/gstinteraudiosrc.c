@@ -287,6 +287,9 @@ gst_inter_audio_src_start (GstBaseSrc * src)
   interaudiosrc->surface->audio_buffer_time = interaudiosrc->buffer_time;
   interaudiosrc->surface->audio_latency_time = interaudiosrc->latency_time;
   interaudiosrc->surface->audio_period_time = interaudiosrc->period_time;
+  /* Start with the samples the sink writes from now on */
+  interaudiosrc->read_pos = interaudiosrc->surface->audio_write_pos;
+  interaudiosrc->generation = interaudiosrc->surface->audio_generation;
   g_mutex_unlock (&interaudiosrc->surface->mutex);
 
   return TRUE;
@@ -335,11 +338,11 @@ gst_inter_audio_src_create (GstBaseSrc * src, guint64 offset, guint size,
     GstBuffer ** buf)
 {
   GstInterAudioSrc *interaudiosrc = GST_INTER_AUDIO_SRC (src);
+  GstInterSurface *surface = interaudiosrc->surface;
   GstCaps *caps;
   GstBuffer *buffer;
   guint n, bpf;
-  guint64 period_time;
-  guint64 period_samples;
+  guint64 period_samples, buffer_samples, oldest;
 
   GST_DEBUG_OBJECT (interaudiosrc, "create");
 
@@ -358,26 +361,39 @@ gst_inter_audio_src_create (GstBaseSrc * src, guint64 offset, guint size,
     }
   }
 
-  bpf = interaudiosrc->surface->audio_info.bpf;
-  period_time = interaudiosrc->surface->audio_period_time;
-  period_samples =
-      gst_util_uint64_scale (period_time, interaudiosrc->info.rate, GST_SECOND);
+  period_samples = gst_util_uint64_scale (interaudiosrc->period_time,
+      interaudiosrc->info.rate, GST_SECOND);
+  buffer_samples = gst_util_uint64_scale (interaudiosrc->buffer_time,
+      interaudiosrc->info.rate, GST_SECOND);
 
-  if (bpf > 0)
-    n = gst_adapter_available (interaudiosrc->surface->audio_adapter) / bpf;
-  else
-    n = 0;
+  if (interaudiosrc->generation != surface->audio_generation) {
+    /* The sink set up a new ring */
+    interaudiosrc->read_pos = 0;
+    interaudiosrc->generation = surface->audio_generation;
+  }
 
-  if (n > period_samples)
-    n = period_samples;
-  if (n > 0) {
-    buffer = gst_adapter_take_buffer (interaudiosrc->surface->audio_adapter,
-        n * bpf);
+  /* Don't fall behind more than buffer-time, and not behind what the sink
+   * already overwrote */
+  oldest = gst_inter_surface_audio_get_oldest (surface);
+  if (surface->audio_write_pos > buffer_samples)
+    oldest = MAX (oldest, surface->audio_write_pos - buffer_samples);
+  if (interaudiosrc->read_pos < oldest) {
+    GST_DEBUG_OBJECT (interaudiosrc, "dropping %" G_GUINT64_FORMAT
+        " samples", oldest - interaudiosrc->read_pos);
+    interaudiosrc->read_pos = oldest;
+  }
+
+  /* Shares the samples of the ring, so there is no copy */
+  buffer = gst_inter_surface_audio_read (surface, &interaudiosrc->read_pos,
+      period_samples);
+  if (buffer) {
+    n = gst_buffer_get_size (buffer) / surface->audio_bpf;
   } else {
+    n = 0;
     buffer = gst_buffer_new ();
     GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_GAP);
   }
-  g_mutex_unlock (&interaudiosrc->surface->mutex);
+  g_mutex_unlock (&surface->mutex);
 
   if (caps) {
     gboolean ret = gst_base_src_set_caps (src, caps);
@@ -46,6 +46,10 @@ struct _GstInterAudioSrc
   GstClockTime timestamp_offset;
   GstAudioInfo info;
   guint64 buffer_time, latency_time, period_time;
+
+  /* position in the ring of the surface */
+  guint64 read_pos;
+  guint generation;
 };
 
 struct _GstInterAudioSrcClass
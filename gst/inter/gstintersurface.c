@@ -48,10 +48,10 @@ gst_inter_surface_get (const char *name)
   surface->ref_count = 1;
   surface->name = g_strdup (name);
   g_mutex_init (&surface->mutex);
-  surface->audio_adapter = gst_adapter_new ();
   surface->audio_buffer_time = DEFAULT_AUDIO_BUFFER_TIME;
   surface->audio_latency_time = DEFAULT_AUDIO_LATENCY_TIME;
   surface->audio_period_time = DEFAULT_AUDIO_PERIOD_TIME;
+  surface->video_queue_size = 1;
 
   list = g_list_append (list, surface);
   g_mutex_unlock (&mutex);
@@ -78,11 +78,232 @@ gst_inter_surface_unref (GstInterSurface * surface)
     }
 
     g_mutex_clear (&surface->mutex);
-    gst_buffer_replace (&surface->video_buffer, NULL);
+    gst_inter_surface_clear_video (surface);
     gst_buffer_replace (&surface->sub_buffer, NULL);
-    gst_object_unref (surface->audio_adapter);
+    gst_inter_surface_audio_setup (surface, 0, 0, 0);
     g_free (surface->name);
     g_free (surface);
   }
   g_mutex_unlock (&mutex);
 }
+
+/* Only called by the producer. The old buffer is only unreffed once no
+ * consumer is in the middle of taking a reference to it */
+static void
+gst_inter_surface_slot_replace (GstInterSurfaceSlot * slot,
+    GstBuffer * buffer, guint seq)
+{
+  GstBuffer *old = slot->buffer;
+
+  if (old == NULL && buffer == NULL)
+    return;
+
+  g_atomic_int_set (&slot->seq, 0);
+  g_atomic_pointer_set (&slot->buffer, buffer);
+  if (buffer)
+    g_atomic_int_set (&slot->seq, (gint) (seq + 1));
+
+  while (g_atomic_int_get (&slot->readers) > 0)
+    g_thread_yield ();
+
+  if (old)
+    gst_buffer_unref (old);
+}
+
+void
+gst_inter_surface_push_video (GstInterSurface * surface, GstBuffer * buffer)
+{
+  guint seq = surface->video_write_seq;
+  guint depth = g_atomic_int_get (&surface->video_queue_size);
+
+  gst_inter_surface_slot_replace (&surface->video_slots[seq &
+          (GST_INTER_SURFACE_VIDEO_SLOTS - 1)], gst_buffer_ref (buffer), seq);
+
+  /* Don't keep more buffers alive than the configured queue size */
+  if (depth < GST_INTER_SURFACE_VIDEO_SLOTS)
+    gst_inter_surface_slot_replace (&surface->video_slots[(seq - depth) &
+            (GST_INTER_SURFACE_VIDEO_SLOTS - 1)], NULL, 0);
+
+  g_atomic_int_set ((gint *) & surface->video_write_seq, (gint) (seq + 1));
+}
+
+void
+gst_inter_surface_clear_video (GstInterSurface * surface)
+{
+  guint i;
+
+  for (i = 0; i < GST_INTER_SURFACE_VIDEO_SLOTS; i++)
+    gst_inter_surface_slot_replace (&surface->video_slots[i], NULL, 0);
+}
+
+/* Returns the sequence number the next buffer will get */
+guint
+gst_inter_surface_get_video_write_seq (GstInterSurface * surface)
+{
+  return (guint) g_atomic_int_get ((gint *) & surface->video_write_seq);
+}
+
+/* Returns a reference to the buffer with the sequence number, or NULL if
+ * it was not pushed yet or was already dropped */
+GstBuffer *
+gst_inter_surface_get_video (GstInterSurface * surface, guint seq)
+{
+  GstInterSurfaceSlot *slot =
+      &surface->video_slots[seq & (GST_INTER_SURFACE_VIDEO_SLOTS - 1)];
+  GstBuffer *buffer = NULL;
+
+  /* Stored as 0 in the slot, which marks it as empty */
+  if (seq + 1 == 0)
+    return NULL;
+
+  g_atomic_int_inc (&slot->readers);
+  if ((guint) g_atomic_int_get (&slot->seq) == seq + 1) {
+    buffer = g_atomic_pointer_get (&slot->buffer);
+    /* Only valid if it wasn't replaced while we were looking */
+    if (buffer && (guint) g_atomic_int_get (&slot->seq) == seq + 1)
+      gst_buffer_ref (buffer);
+    else
+      buffer = NULL;
+  }
+  g_atomic_int_dec_and_test (&slot->readers);
+
+  return buffer;
+}
+
+static void
+gst_inter_surface_audio_segment_alloc (GstInterSurfaceAudioSegment * segment,
+    gsize size)
+{
+  segment->data = g_malloc (size);
+  segment->memory = gst_memory_new_wrapped (0, segment->data, size, 0, size,
+      segment->data, g_free);
+}
+
+/* Called with the surface lock. Throws away the current ring and sets up a
+ * new one, or none if any of the parameters is 0. Memory that is still
+ * used downstream of a source stays alive until it is released there */
+void
+gst_inter_surface_audio_setup (GstInterSurface * surface, guint bpf,
+    guint64 segment_samples, guint n_segments)
+{
+  guint i;
+
+  for (i = 0; i < surface->audio_n_segments; i++)
+    gst_memory_unref (surface->audio_segments[i].memory);
+  g_free (surface->audio_segments);
+  surface->audio_segments = NULL;
+  surface->audio_n_segments = 0;
+
+  if (bpf > 0 && segment_samples > 0 && n_segments > 0) {
+    surface->audio_segments =
+        g_new0 (GstInterSurfaceAudioSegment, n_segments);
+    for (i = 0; i < n_segments; i++)
+      gst_inter_surface_audio_segment_alloc (&surface->audio_segments[i],
+          segment_samples * bpf);
+    surface->audio_n_segments = n_segments;
+  }
+
+  surface->audio_bpf = bpf;
+  surface->audio_segment_samples = segment_samples;
+  surface->audio_write_pos = 0;
+  surface->audio_reserve_pos = 0;
+  surface->audio_generation++;
+}
+
+/* Only called by the sink, without the surface lock. The samples are
+ * copied into the ring without holding the lock, sources don't look at the
+ * part of the ring that is being written to */
+void
+gst_inter_surface_audio_write (GstInterSurface * surface, GstBuffer * buffer)
+{
+  gsize offset = 0, size = gst_buffer_get_size (buffer);
+
+  g_mutex_lock (&surface->mutex);
+  while (surface->audio_n_segments > 0 &&
+      size - offset >= surface->audio_bpf) {
+    GstInterSurfaceAudioSegment *segment;
+    guint bpf = surface->audio_bpf;
+    guint64 segment_samples = surface->audio_segment_samples;
+    guint64 pos = surface->audio_write_pos;
+    gsize segment_size = segment_samples * bpf;
+    gsize segment_offset = (pos % segment_samples) * bpf;
+    gsize len;
+
+    len = MIN (size - offset, segment_size - segment_offset);
+    len -= len % bpf;
+
+    segment = &surface->audio_segments[(pos / segment_samples) %
+        surface->audio_n_segments];
+
+    /* Somebody downstream of a source still has part of this segment, so
+     * carry on in a copy instead of overwriting it */
+    if (GST_MINI_OBJECT_REFCOUNT_VALUE (segment->memory) > 1) {
+      GstMemory *old = segment->memory;
+      guint8 *old_data = segment->data;
+
+      gst_inter_surface_audio_segment_alloc (segment, segment_size);
+      memcpy (segment->data, old_data, segment_size);
+      gst_memory_unref (old);
+    }
+
+    surface->audio_reserve_pos = pos + len / bpf;
+    g_mutex_unlock (&surface->mutex);
+
+    gst_buffer_extract (buffer, offset, segment->data + segment_offset, len);
+    offset += len;
+
+    g_mutex_lock (&surface->mutex);
+    surface->audio_write_pos = surface->audio_reserve_pos;
+  }
+  g_mutex_unlock (&surface->mutex);
+}
+
+/* Called with the surface lock. Returns the position of the oldest sample
+ * that is still in the ring */
+guint64
+gst_inter_surface_audio_get_oldest (GstInterSurface * surface)
+{
+  guint64 capacity =
+      surface->audio_segment_samples * surface->audio_n_segments;
+
+  if (surface->audio_reserve_pos < capacity)
+    return 0;
+
+  return surface->audio_reserve_pos - capacity;
+}
+
+/* Called with the surface lock. Returns up to @max_samples samples starting
+ * at @read_pos without copying them, or NULL if there are none */
+GstBuffer *
+gst_inter_surface_audio_read (GstInterSurface * surface, guint64 * read_pos,
+    guint64 max_samples)
+{
+  guint64 pos, n, segment_samples = surface->audio_segment_samples;
+  GstBuffer *buffer;
+
+  pos = MAX (*read_pos, gst_inter_surface_audio_get_oldest (surface));
+  if (surface->audio_n_segments == 0 || pos >= surface->audio_write_pos)
+    return NULL;
+
+  n = MIN (surface->audio_write_pos - pos, max_samples);
+  if (n == 0)
+    return NULL;
+
+  buffer = gst_buffer_new ();
+  while (n > 0) {
+    GstInterSurfaceAudioSegment *segment;
+    guint64 len = MIN (n, segment_samples - pos % segment_samples);
+
+    segment = &surface->audio_segments[(pos / segment_samples) %
+        surface->audio_n_segments];
+    gst_buffer_append_memory (buffer, gst_memory_share (segment->memory,
+            (pos % segment_samples) * surface->audio_bpf,
+            len * surface->audio_bpf));
+
+    pos += len;
+    n -= len;
+  }
+  *read_pos = pos;
+
+  return buffer;
+}
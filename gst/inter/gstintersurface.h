@@ -27,6 +27,26 @@
 G_BEGIN_DECLS
 
 typedef struct _GstInterSurface GstInterSurface;
+typedef struct _GstInterSurfaceSlot GstInterSurfaceSlot;
+typedef struct _GstInterSurfaceAudioSegment GstInterSurfaceAudioSegment;
+
+/* Must be a power of two */
+#define GST_INTER_SURFACE_VIDEO_SLOTS 32
+
+struct _GstInterSurfaceSlot
+{
+  /* sequence number of the buffer plus one, 0 while empty or being
+   * replaced */
+  gint seq;
+  gint readers;
+  GstBuffer *buffer;
+};
+
+struct _GstInterSurfaceAudioSegment
+{
+  GstMemory *memory;
+  guint8 *data;
+};
 
 struct _GstInterSurface
 {
@@ -37,7 +57,13 @@ struct _GstInterSurface
 
   /* video */
   GstVideoInfo video_info;
-  int video_buffer_count;
+  gint video_info_cookie;
+
+  /* Written by the one intervideosink without taking the mutex, each
+   * intervideosrc keeps track of where it is itself */
+  GstInterSurfaceSlot video_slots[GST_INTER_SURFACE_VIDEO_SLOTS];
+  guint video_write_seq;
+  gint video_queue_size;
 
   /* audio */
   GstAudioInfo audio_info;
@@ -45,9 +71,19 @@ struct _GstInterSurface
   guint64 audio_latency_time;
   guint64 audio_period_time;
 
-  GstBuffer *video_buffer;
+  /* Ring of preallocated audio segments, written by the one interaudiosink.
+   * Sources keep their own read position and take shared sub-memories of
+   * the segments with the mutex held. Positions are in samples since the
+   * last setup of the ring */
+  GstInterSurfaceAudioSegment *audio_segments;
+  guint audio_n_segments;
+  guint audio_bpf;
+  guint64 audio_segment_samples;
+  guint64 audio_write_pos;
+  guint64 audio_reserve_pos;
+  guint audio_generation;
+
   GstBuffer *sub_buffer;
-  GstAdapter *audio_adapter;
 };
 
 #define DEFAULT_AUDIO_BUFFER_TIME  (GST_SECOND)
@@ -58,6 +94,21 @@ struct _GstInterSurface
 GstInterSurface * gst_inter_surface_get (const char *name);
 void gst_inter_surface_unref (GstInterSurface *surface);
 
+void gst_inter_surface_push_video (GstInterSurface *surface,
+    GstBuffer *buffer);
+void gst_inter_surface_clear_video (GstInterSurface *surface);
+guint gst_inter_surface_get_video_write_seq (GstInterSurface *surface);
+GstBuffer * gst_inter_surface_get_video (GstInterSurface *surface,
+    guint seq);
+
+void gst_inter_surface_audio_setup (GstInterSurface *surface, guint bpf,
+    guint64 segment_samples, guint n_segments);
+void gst_inter_surface_audio_write (GstInterSurface *surface,
+    GstBuffer *buffer);
+guint64 gst_inter_surface_audio_get_oldest (GstInterSurface *surface);
+GstBuffer * gst_inter_surface_audio_read (GstInterSurface *surface,
+    guint64 *read_pos, guint64 max_samples);
+
 
 G_END_DECLS
 
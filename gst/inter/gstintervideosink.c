@@ -66,10 +66,12 @@ static GstFlowReturn gst_inter_video_sink_show_frame (GstVideoSink * sink,
 enum
 {
   PROP_0,
-  PROP_CHANNEL
+  PROP_CHANNEL,
+  PROP_QUEUE_SIZE
 };
 
 #define DEFAULT_CHANNEL ("default")
+#define DEFAULT_QUEUE_SIZE 1
 
 /* pad templates */
 static GstStaticPadTemplate gst_inter_video_sink_sink_template =
@@ -118,12 +120,29 @@ gst_inter_video_sink_class_init (GstInterVideoSinkClass * klass)
       g_param_spec_string ("channel", "Channel",
           "Channel name to match inter src and sink elements",
           DEFAULT_CHANNEL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstInterVideoSink:queue-size:
+   *
+   * Number of frames kept around for the intervideosrc elements, which
+   * only matters for the ones in FIFO mode. Setting it is only allowed
+   * in the NULL and READY states.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_QUEUE_SIZE,
+      g_param_spec_uint ("queue-size", "Queue Size",
+          "Number of frames kept for the inter sources",
+          1, GST_INTER_SURFACE_VIDEO_SLOTS, DEFAULT_QUEUE_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
 }
 
 static void
 gst_inter_video_sink_init (GstInterVideoSink * intervideosink)
 {
   intervideosink->channel = g_strdup (DEFAULT_CHANNEL);
+  intervideosink->queue_size = DEFAULT_QUEUE_SIZE;
 }
 
 void
@@ -137,6 +156,9 @@ gst_inter_video_sink_set_property (GObject * object, guint property_id,
       g_free (intervideosink->channel);
       intervideosink->channel = g_value_dup_string (value);
       break;
+    case PROP_QUEUE_SIZE:
+      intervideosink->queue_size = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -153,6 +175,9 @@ gst_inter_video_sink_get_property (GObject * object, guint property_id,
     case PROP_CHANNEL:
       g_value_set_string (value, intervideosink->channel);
       break;
+    case PROP_QUEUE_SIZE:
+      g_value_set_uint (value, intervideosink->queue_size);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -199,6 +224,9 @@ gst_inter_video_sink_start (GstBaseSink * sink)
   intervideosink->surface = gst_inter_surface_get (intervideosink->channel);
   g_mutex_lock (&intervideosink->surface->mutex);
   memset (&intervideosink->surface->video_info, 0, sizeof (GstVideoInfo));
+  g_atomic_int_inc (&intervideosink->surface->video_info_cookie);
+  g_atomic_int_set (&intervideosink->surface->video_queue_size,
+      intervideosink->queue_size);
   g_mutex_unlock (&intervideosink->surface->mutex);
 
   return TRUE;
@@ -209,12 +237,10 @@ gst_inter_video_sink_stop (GstBaseSink * sink)
 {
   GstInterVideoSink *intervideosink = GST_INTER_VIDEO_SINK (sink);
 
+  gst_inter_surface_clear_video (intervideosink->surface);
   g_mutex_lock (&intervideosink->surface->mutex);
-  if (intervideosink->surface->video_buffer) {
-    gst_buffer_unref (intervideosink->surface->video_buffer);
-  }
-  intervideosink->surface->video_buffer = NULL;
   memset (&intervideosink->surface->video_info, 0, sizeof (GstVideoInfo));
+  g_atomic_int_inc (&intervideosink->surface->video_info_cookie);
   g_mutex_unlock (&intervideosink->surface->mutex);
 
   gst_inter_surface_unref (intervideosink->surface);
@@ -237,6 +263,7 @@ gst_inter_video_sink_set_caps (GstBaseSink * sink, GstCaps * caps)
   g_mutex_lock (&intervideosink->surface->mutex);
   intervideosink->surface->video_info = info;
   intervideosink->info = info;
+  g_atomic_int_inc (&intervideosink->surface->video_info_cookie);
   g_mutex_unlock (&intervideosink->surface->mutex);
 
   return TRUE;
@@ -250,13 +277,7 @@ gst_inter_video_sink_show_frame (GstVideoSink * sink, GstBuffer * buffer)
   GST_DEBUG_OBJECT (intervideosink, "render ts %" GST_TIME_FORMAT,
       GST_TIME_ARGS (GST_BUFFER_PTS (buffer)));
 
-  g_mutex_lock (&intervideosink->surface->mutex);
-  if (intervideosink->surface->video_buffer) {
-    gst_buffer_unref (intervideosink->surface->video_buffer);
-  }
-  intervideosink->surface->video_buffer = gst_buffer_ref (buffer);
-  intervideosink->surface->video_buffer_count = 0;
-  g_mutex_unlock (&intervideosink->surface->mutex);
+  gst_inter_surface_push_video (intervideosink->surface, buffer);
 
   return GST_FLOW_OK;
 }
@@ -71,11 +71,32 @@ enum
 {
   PROP_0,
   PROP_CHANNEL,
-  PROP_TIMEOUT
+  PROP_TIMEOUT,
+  PROP_MODE
 };
 
 #define DEFAULT_CHANNEL ("default")
 #define DEFAULT_TIMEOUT (GST_SECOND)
+#define DEFAULT_MODE GST_INTER_VIDEO_SRC_MODE_LATEST
+
+#define GST_TYPE_INTER_VIDEO_SRC_MODE (gst_inter_video_src_mode_get_type ())
+static GType
+gst_inter_video_src_mode_get_type (void)
+{
+  static GType mode_type = 0;
+  static const GEnumValue modes[] = {
+    {GST_INTER_VIDEO_SRC_MODE_LATEST, "Output the most recent frame",
+        "latest"},
+    {GST_INTER_VIDEO_SRC_MODE_FIFO, "Output every queued frame in order",
+        "fifo"},
+    {0, NULL, NULL},
+  };
+
+  if (!mode_type) {
+    mode_type = g_enum_register_static ("GstInterVideoSrcMode", modes);
+  }
+  return mode_type;
+}
 
 /* pad templates */
 static GstStaticPadTemplate gst_inter_video_src_src_template =
@@ -130,6 +151,25 @@ gst_inter_video_src_class_init (GstInterVideoSrcClass * klass)
           "Timeout after which to start outputting black frames",
           0, G_MAXUINT64, DEFAULT_TIMEOUT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstInterVideoSrc:mode:
+   *
+   * Whether to always output the latest frame of the intervideosink,
+   * dropping any frame that was not picked up in time, or to output the
+   * frames in order from the queue of the sink (see
+   * #GstInterVideoSink:queue-size). In FIFO mode frames are only dropped
+   * when this source falls behind by more than the queue size.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_MODE,
+      g_param_spec_enum ("mode", "Mode",
+          "How frames are taken from the inter sink",
+          GST_TYPE_INTER_VIDEO_SRC_MODE, DEFAULT_MODE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_type_mark_as_plugin_api (GST_TYPE_INTER_VIDEO_SRC_MODE, 0);
 }
 
 static void
@@ -140,6 +180,7 @@ gst_inter_video_src_init (GstInterVideoSrc * intervideosrc)
 
   intervideosrc->channel = g_strdup (DEFAULT_CHANNEL);
   intervideosrc->timeout = DEFAULT_TIMEOUT;
+  intervideosrc->mode = DEFAULT_MODE;
 }
 
 void
@@ -156,6 +197,9 @@ gst_inter_video_src_set_property (GObject * object, guint property_id,
     case PROP_TIMEOUT:
       intervideosrc->timeout = g_value_get_uint64 (value);
       break;
+    case PROP_MODE:
+      intervideosrc->mode = g_value_get_enum (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -175,6 +219,9 @@ gst_inter_video_src_get_property (GObject * object, guint property_id,
     case PROP_TIMEOUT:
       g_value_set_uint64 (value, intervideosrc->timeout);
       break;
+    case PROP_MODE:
+      g_value_set_enum (value, intervideosrc->mode);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -262,6 +309,7 @@ gst_inter_video_src_set_caps (GstBaseSrc * base, GstCaps * caps)
   gst_video_frame_unmap (&dest_frame);
   gst_buffer_unref (src);
   intervideosrc->black_frame = dest;
+  intervideosrc->check_info = TRUE;
 
   return TRUE;
 }
@@ -276,6 +324,13 @@ gst_inter_video_src_start (GstBaseSrc * src)
   intervideosrc->surface = gst_inter_surface_get (intervideosrc->channel);
   intervideosrc->timestamp_offset = 0;
   intervideosrc->n_frames = 0;
+  intervideosrc->repeat_count = 0;
+  /* Pick up the current frame of the sink, if any */
+  intervideosrc->read_seq =
+      gst_inter_surface_get_video_write_seq (intervideosrc->surface) - 1;
+  /* Force a look at the video info of the sink */
+  intervideosrc->info_cookie =
+      g_atomic_int_get (&intervideosrc->surface->video_info_cookie) - 1;
 
   return TRUE;
 }
@@ -290,6 +345,7 @@ gst_inter_video_src_stop (GstBaseSrc * src)
   gst_inter_surface_unref (intervideosrc->surface);
   intervideosrc->surface = NULL;
   gst_buffer_replace (&intervideosrc->black_frame, NULL);
+  gst_buffer_replace (&intervideosrc->video_buffer, NULL);
 
   return TRUE;
 }
@@ -319,6 +375,71 @@ gst_inter_video_src_get_times (GstBaseSrc * src, GstBuffer * buffer,
   }
 }
 
+/* Called with the surface lock. Returns the new caps if the video info of
+ * the sink differs from ours */
+static GstCaps *
+gst_inter_video_src_check_info (GstInterVideoSrc * intervideosrc)
+{
+  GstCaps *caps = NULL;
+  GstVideoInfo tmp_info = intervideosrc->surface->video_info;
+
+  /* We negotiate the framerate ourselves */
+  tmp_info.fps_n = intervideosrc->info.fps_n;
+  tmp_info.fps_d = intervideosrc->info.fps_d;
+  if (intervideosrc->info.flags & GST_VIDEO_FLAG_VARIABLE_FPS)
+    tmp_info.flags |= GST_VIDEO_FLAG_VARIABLE_FPS;
+  else
+    tmp_info.flags &= ~GST_VIDEO_FLAG_VARIABLE_FPS;
+
+  if (!gst_video_info_is_equal (&tmp_info, &intervideosrc->info)) {
+    caps = gst_video_info_to_caps (&tmp_info);
+    intervideosrc->timestamp_offset +=
+        gst_util_uint64_scale (GST_SECOND * intervideosrc->n_frames,
+        GST_VIDEO_INFO_FPS_D (&intervideosrc->info),
+        GST_VIDEO_INFO_FPS_N (&intervideosrc->info));
+    intervideosrc->n_frames = 0;
+  }
+
+  return caps;
+}
+
+/* Takes the next frame from the surface ring according to the mode.
+ * There is only a single producer per channel, so all this needs is the
+ * write sequence number of the sink. */
+static void
+gst_inter_video_src_update_frame (GstInterVideoSrc * intervideosrc)
+{
+  GstInterSurface *surface = intervideosrc->surface;
+  guint write_seq, want;
+  GstBuffer *buffer;
+
+  write_seq = gst_inter_surface_get_video_write_seq (surface);
+  if (write_seq == intervideosrc->read_seq)
+    return;
+
+  if (intervideosrc->mode == GST_INTER_VIDEO_SRC_MODE_FIFO) {
+    guint depth = g_atomic_int_get (&surface->video_queue_size);
+
+    if (write_seq - intervideosrc->read_seq > depth) {
+      GST_DEBUG_OBJECT (intervideosrc, "Fell behind, dropping %u frames",
+          write_seq - intervideosrc->read_seq - depth);
+      intervideosrc->read_seq = write_seq - depth;
+    }
+    want = intervideosrc->read_seq;
+  } else {
+    want = write_seq - 1;
+  }
+
+  /* NULL if the frame was overwritten or cleared meanwhile */
+  buffer = gst_inter_surface_get_video (surface, want);
+  if (buffer) {
+    gst_buffer_replace (&intervideosrc->video_buffer, NULL);
+    intervideosrc->video_buffer = buffer;
+    intervideosrc->repeat_count = 0;
+  }
+  intervideosrc->read_seq = want + 1;
+}
+
 static GstFlowReturn
 gst_inter_video_src_create (GstBaseSrc * src, guint64 offset, guint size,
     GstBuffer ** buf)
@@ -328,6 +449,7 @@ gst_inter_video_src_create (GstBaseSrc * src, guint64 offset, guint size,
   GstBuffer *buffer;
   guint64 frames;
   gboolean is_gap = FALSE;
+  gint cookie;
 
   GST_DEBUG_OBJECT (intervideosrc, "create");
 
@@ -338,47 +460,40 @@ gst_inter_video_src_create (GstBaseSrc * src, guint64 offset, guint size,
       GST_VIDEO_INFO_FPS_N (&intervideosrc->info),
       GST_VIDEO_INFO_FPS_D (&intervideosrc->info) * GST_SECOND);
 
-  g_mutex_lock (&intervideosrc->surface->mutex);
-  if (intervideosrc->surface->video_info.finfo) {
-    GstVideoInfo tmp_info = intervideosrc->surface->video_info;
-
-    /* We negotiate the framerate ourselves */
-    tmp_info.fps_n = intervideosrc->info.fps_n;
-    tmp_info.fps_d = intervideosrc->info.fps_d;
-    if (intervideosrc->info.flags & GST_VIDEO_FLAG_VARIABLE_FPS)
-      tmp_info.flags |= GST_VIDEO_FLAG_VARIABLE_FPS;
+  /* The video info only changes on caps changes of the sink, so only take
+   * the lock when those or our own caps changed */
+  cookie = g_atomic_int_get (&intervideosrc->surface->video_info_cookie);
+  if (cookie != intervideosrc->info_cookie || intervideosrc->check_info) {
+    g_mutex_lock (&intervideosrc->surface->mutex);
+    cookie = g_atomic_int_get (&intervideosrc->surface->video_info_cookie);
+    if (intervideosrc->surface->video_info.finfo)
+      caps = gst_inter_video_src_check_info (intervideosrc);
     else
-      tmp_info.flags &= ~GST_VIDEO_FLAG_VARIABLE_FPS;
-
-    if (!gst_video_info_is_equal (&tmp_info, &intervideosrc->info)) {
-      caps = gst_video_info_to_caps (&tmp_info);
-      intervideosrc->timestamp_offset +=
-          gst_util_uint64_scale (GST_SECOND * intervideosrc->n_frames,
-          GST_VIDEO_INFO_FPS_D (&intervideosrc->info),
-          GST_VIDEO_INFO_FPS_N (&intervideosrc->info));
-      intervideosrc->n_frames = 0;
-    }
+      gst_buffer_replace (&intervideosrc->video_buffer, NULL);
+    g_mutex_unlock (&intervideosrc->surface->mutex);
+
+    intervideosrc->info_cookie = cookie;
+    intervideosrc->check_info = FALSE;
   }
 
-  if (intervideosrc->surface->video_buffer) {
+  gst_inter_video_src_update_frame (intervideosrc);
+
+  if (intervideosrc->video_buffer) {
     /* We have a buffer to push */
-    buffer = gst_buffer_ref (intervideosrc->surface->video_buffer);
+    buffer = gst_buffer_ref (intervideosrc->video_buffer);
 
     /* Can only be true if timeout > 0 */
-    if (intervideosrc->surface->video_buffer_count == frames) {
-      gst_buffer_unref (intervideosrc->surface->video_buffer);
-      intervideosrc->surface->video_buffer = NULL;
-    }
+    if (intervideosrc->repeat_count == frames)
+      gst_buffer_replace (&intervideosrc->video_buffer, NULL);
   }
 
-  if (intervideosrc->surface->video_buffer_count != 0 &&
-      intervideosrc->surface->video_buffer_count != (frames + 1)) {
+  if (intervideosrc->repeat_count != 0 &&
+      intervideosrc->repeat_count != (frames + 1)) {
     /* This is a repeat of the stored buffer or of a black frame */
     is_gap = TRUE;
   }
 
-  intervideosrc->surface->video_buffer_count++;
-  g_mutex_unlock (&intervideosrc->surface->mutex);
+  intervideosrc->repeat_count++;
 
   if (caps) {
     gboolean ret;
@@ -410,6 +525,7 @@ gst_inter_video_src_create (GstBaseSrc * src, guint64 offset, guint size,
       if (buffer)
         gst_buffer_unref (buffer);
       gst_caps_unref (caps);
+      intervideosrc->check_info = TRUE;
       return GST_FLOW_NOT_NEGOTIATED;
     }
     gst_caps_unref (caps);
@@ -436,6 +552,7 @@ gst_inter_video_src_create (GstBaseSrc * src, guint64 offset, guint size,
       if (buffer)
         gst_buffer_unref (buffer);
       gst_caps_unref (negotiated_caps);
+      intervideosrc->check_info = TRUE;
       return GST_FLOW_NOT_NEGOTIATED;
     }
     gst_caps_unref (negotiated_caps);
@@ -32,6 +32,19 @@ G_BEGIN_DECLS
 #define GST_IS_INTER_VIDEO_SRC(obj)   (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_INTER_VIDEO_SRC))
 #define GST_IS_INTER_VIDEO_SRC_CLASS(obj)   (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_INTER_VIDEO_SRC))
 
+/**
+ * GstInterVideoSrcMode:
+ * @GST_INTER_VIDEO_SRC_MODE_LATEST: always output the most recent frame
+ * @GST_INTER_VIDEO_SRC_MODE_FIFO: output every queued frame in order
+ *
+ * Since: 1.20
+ */
+typedef enum
+{
+  GST_INTER_VIDEO_SRC_MODE_LATEST,
+  GST_INTER_VIDEO_SRC_MODE_FIFO,
+} GstInterVideoSrcMode;
+
 typedef struct _GstInterVideoSrc GstInterVideoSrc;
 typedef struct _GstInterVideoSrcClass GstInterVideoSrcClass;
 
@@ -43,11 +56,19 @@ struct _GstInterVideoSrc
 
   char *channel;
   guint64 timeout;
+  GstInterVideoSrcMode mode;
 
   GstVideoInfo info;
   GstBuffer *black_frame;
   int n_frames;
   GstClockTime timestamp_offset;
+
+  /* current frame taken from the surface and how often it was pushed */
+  GstBuffer *video_buffer;
+  guint64 repeat_count;
+  guint read_seq;
+  gint info_cookie;
+  gboolean check_info;
 };
 
 struct _GstInterVideoSrcClass
@@ -0,0 +1,165 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+/* Comb metric kernels and row splitting shared by ivtc and combdetect */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstcomb.h"
+
+/* don't hand out jobs of less rows than this */
+#define MIN_ROWS_PER_JOB 16
+
+typedef struct
+{
+  GstCombWorkers *workers;
+  GstCombRowsFunc func;
+  gpointer user_data;
+  int y_start;
+  int y_end;
+} GstCombJob;
+
+void
+gst_comb_workers_init (GstCombWorkers * workers)
+{
+  workers->pool = NULL;
+  g_mutex_init (&workers->lock);
+  g_cond_init (&workers->cond);
+  workers->pending = 0;
+}
+
+void
+gst_comb_workers_clear (GstCombWorkers * workers)
+{
+  if (workers->pool)
+    g_thread_pool_free (workers->pool, FALSE, TRUE);
+  workers->pool = NULL;
+  g_mutex_clear (&workers->lock);
+  g_cond_clear (&workers->cond);
+}
+
+static void
+gst_comb_workers_job (gpointer data, gpointer user_data)
+{
+  GstCombJob *job = data;
+  GstCombWorkers *workers = job->workers;
+
+  job->func (job->user_data, job->y_start, job->y_end);
+
+  g_mutex_lock (&workers->lock);
+  if (--workers->pending == 0)
+    g_cond_signal (&workers->cond);
+  g_mutex_unlock (&workers->lock);
+}
+
+/* Calls func on the rows [y_start, y_end), split in bands across up to
+ * n_threads threads, 0 meaning one per CPU. Returns once all rows are
+ * done. */
+void
+gst_comb_workers_run (GstCombWorkers * workers, guint n_threads,
+    int y_start, int y_end, GstCombRowsFunc func, gpointer user_data)
+{
+  GstCombJob *jobs;
+  guint n_jobs, i;
+  int rows;
+
+  if (y_end <= y_start)
+    return;
+
+  n_jobs = n_threads;
+  if (n_jobs == 0)
+    n_jobs = g_get_num_processors ();
+  n_jobs = CLAMP ((y_end - y_start) / MIN_ROWS_PER_JOB, 1, n_jobs);
+
+  if (n_jobs == 1) {
+    func (user_data, y_start, y_end);
+    return;
+  }
+
+  if (workers->pool == NULL) {
+    workers->pool = g_thread_pool_new (gst_comb_workers_job, NULL, -1,
+        FALSE, NULL);
+  }
+
+  jobs = g_newa (GstCombJob, n_jobs);
+  rows = (y_end - y_start + n_jobs - 1) / n_jobs;
+
+  for (i = 0; i < n_jobs; i++) {
+    jobs[i].workers = workers;
+    jobs[i].func = func;
+    jobs[i].user_data = user_data;
+    jobs[i].y_start = MIN (y_start + i * rows, y_end);
+    jobs[i].y_end = MIN (y_start + (i + 1) * rows, y_end);
+  }
+
+  workers->pending = n_jobs - 1;
+  for (i = 1; i < n_jobs; i++)
+    g_thread_pool_push (workers->pool, &jobs[i], NULL);
+
+  func (user_data, jobs[0].y_start, jobs[0].y_end);
+
+  g_mutex_lock (&workers->lock);
+  while (workers->pending > 0)
+    g_cond_wait (&workers->cond, &workers->lock);
+  g_mutex_unlock (&workers->lock);
+}
+
+/* Sets mask[i] to 1 where line sticks out of the range spanned by the
+ * lines above and below it by more than 5, 0 elsewhere. Written without
+ * branches so that the compiler can vectorize it. */
+void
+gst_comb_mask_line (guint8 * mask, const guint8 * above,
+    const guint8 * line, const guint8 * below, int width)
+{
+  int i;
+
+  for (i = 0; i < width; i++) {
+    int lo = MIN (above[i], below[i]) - 5;
+    int hi = MAX (above[i], below[i]) + 5;
+
+    mask[i] = (line[i] < lo) | (line[i] > hi);
+  }
+}
+
+/* Grows the runs of combed pixels with one masked line. A run continues
+ * from the pixel to the left and from the pixel above, and a pixel only
+ * counts as combed once its run is longer than 100. The mask is replaced
+ * by the combed pixels and their number is returned. */
+int
+gst_comb_accumulate_line (int *runs, guint8 * mask, int width)
+{
+  int i;
+  int left = 0;
+  int score = 0;
+
+  for (i = 0; i < width; i++) {
+    int run = 0;
+
+    if (mask[i])
+      run = MIN (runs[i] + left + 1, 1000);
+
+    runs[i] = run;
+    left = run;
+    mask[i] = run > 100;
+    score += mask[i];
+  }
+
+  return score;
+}
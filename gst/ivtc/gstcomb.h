@@ -0,0 +1,49 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#ifndef _GST_COMB_H_
+#define _GST_COMB_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef void (*GstCombRowsFunc) (gpointer user_data, int y_start, int y_end);
+
+typedef struct _GstCombWorkers GstCombWorkers;
+
+struct _GstCombWorkers
+{
+  GThreadPool *pool;
+  GMutex lock;
+  GCond cond;
+  guint pending;
+};
+
+void gst_comb_workers_init (GstCombWorkers * workers);
+void gst_comb_workers_clear (GstCombWorkers * workers);
+void gst_comb_workers_run (GstCombWorkers * workers, guint n_threads,
+    int y_start, int y_end, GstCombRowsFunc func, gpointer user_data);
+
+void gst_comb_mask_line (guint8 * mask, const guint8 * above,
+    const guint8 * line, const guint8 * below, int width);
+int gst_comb_accumulate_line (int *runs, guint8 * mask, int width);
+
+G_END_DECLS
+
+#endif
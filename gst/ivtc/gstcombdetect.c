@@ -49,6 +49,12 @@ GST_DEBUG_CATEGORY_STATIC (gst_comb_detect_debug_category);
 /* prototypes */
 
 
+static void gst_comb_detect_set_property (GObject * object,
+    guint property_id, const GValue * value, GParamSpec * pspec);
+static void gst_comb_detect_get_property (GObject * object,
+    guint property_id, GValue * value, GParamSpec * pspec);
+static void gst_comb_detect_finalize (GObject * object);
+static gboolean gst_comb_detect_stop (GstBaseTransform * trans);
 static GstCaps *gst_comb_detect_transform_caps (GstBaseTransform * trans,
     GstPadDirection direction, GstCaps * caps, GstCaps * filter);
 static gboolean gst_comb_detect_set_info (GstVideoFilter * filter,
@@ -59,9 +65,12 @@ static GstFlowReturn gst_comb_detect_transform_frame (GstVideoFilter * filter,
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_N_THREADS
 };
 
+#define DEFAULT_N_THREADS 1
+
 /* pad templates */
 
 /* Yeah, the max width is hard-coded 2048. */
@@ -97,6 +106,7 @@ G_DEFINE_TYPE_WITH_CODE (GstCombDetect, gst_comb_detect, GST_TYPE_VIDEO_FILTER,
 static void
 gst_comb_detect_class_init (GstCombDetectClass * klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   GstBaseTransformClass *base_transform_class =
       GST_BASE_TRANSFORM_CLASS (klass);
   GstVideoFilterClass *video_filter_class = GST_VIDEO_FILTER_CLASS (klass);
@@ -117,12 +127,90 @@ gst_comb_detect_class_init (GstCombDetectClass * klass)
   video_filter_class->set_info = GST_DEBUG_FUNCPTR (gst_comb_detect_set_info);
   video_filter_class->transform_frame =
       GST_DEBUG_FUNCPTR (gst_comb_detect_transform_frame);
-
+  base_transform_class->stop = GST_DEBUG_FUNCPTR (gst_comb_detect_stop);
+
+  gobject_class->set_property = gst_comb_detect_set_property;
+  gobject_class->get_property = gst_comb_detect_get_property;
+  gobject_class->finalize = gst_comb_detect_finalize;
+
+  /**
+   * GstCombDetect:n-threads:
+   *
+   * Maximum number of threads used for the comb metric, 0 means one
+   * thread per CPU.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use", 0, G_MAXUINT,
+          DEFAULT_N_THREADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
 gst_comb_detect_init (GstCombDetect * combdetect)
 {
+  combdetect->n_threads = DEFAULT_N_THREADS;
+  gst_comb_workers_init (&combdetect->workers);
+}
+
+static void
+gst_comb_detect_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstCombDetect *combdetect = GST_COMB_DETECT (object);
+
+  switch (property_id) {
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (combdetect);
+      combdetect->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (combdetect);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_comb_detect_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstCombDetect *combdetect = GST_COMB_DETECT (object);
+
+  switch (property_id) {
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (combdetect);
+      g_value_set_uint (value, combdetect->n_threads);
+      GST_OBJECT_UNLOCK (combdetect);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_comb_detect_finalize (GObject * object)
+{
+  GstCombDetect *combdetect = GST_COMB_DETECT (object);
+
+  gst_comb_workers_clear (&combdetect->workers);
+  g_free (combdetect->mask);
+
+  G_OBJECT_CLASS (gst_comb_detect_parent_class)->finalize (object);
+}
+
+static gboolean
+gst_comb_detect_stop (GstBaseTransform * trans)
+{
+  GstCombDetect *combdetect = GST_COMB_DETECT (trans);
+
+  g_free (combdetect->mask);
+  combdetect->mask = NULL;
+  combdetect->mask_size = 0;
+
+  return TRUE;
 }
 
 
@@ -187,19 +275,47 @@ gst_comb_detect_set_info (GstVideoFilter * filter,
   return TRUE;
 }
 
+#define GET_LINE(frame,comp,line) (((unsigned char *)(frame)->data[k]) + \
+      (line) * GST_VIDEO_FRAME_COMP_STRIDE((frame), (comp)))
+
+typedef struct
+{
+  GstVideoFrame *frame;
+  guint8 *mask;
+  int width;
+} GstCombDetectJob;
+
+static void
+comb_mask_rows (gpointer user_data, int y_start, int y_end)
+{
+  GstCombDetectJob *job = user_data;
+  int j;
+  int k = 0;
+
+  for (j = y_start; j < y_end; j++) {
+    gst_comb_mask_line (job->mask + j * job->width,
+        GET_LINE (job->frame, 0, j - 1), GET_LINE (job->frame, 0, j),
+        GET_LINE (job->frame, 0, j + 1), job->width);
+  }
+}
+
 static GstFlowReturn
 gst_comb_detect_transform_frame (GstVideoFilter * filter,
     GstVideoFrame * inframe, GstVideoFrame * outframe)
 {
-  static int z;
+  GstCombDetect *combdetect = GST_COMB_DETECT (filter);
+  GstCombDetectJob job;
+  guint n_threads;
+  int z;
   int k;
   int height;
   int width;
 
-#define GET_LINE(frame,comp,line) (((unsigned char *)(frame)->data[k]) + \
-      (line) * GST_VIDEO_FRAME_COMP_STRIDE((frame), (comp)))
+  GST_OBJECT_LOCK (combdetect);
+  n_threads = combdetect->n_threads;
+  GST_OBJECT_UNLOCK (combdetect);
 
-  z++;
+  z = ++combdetect->z;
 
   for (k = 1; k < 3; k++) {
     int i;
@@ -218,6 +334,19 @@ gst_comb_detect_transform_frame (GstVideoFilter * filter,
     height = GST_VIDEO_FRAME_COMP_HEIGHT (outframe, 0);
     width = GST_VIDEO_FRAME_COMP_WIDTH (outframe, 0);
 
+    if (combdetect->mask_size < width * height) {
+      g_free (combdetect->mask);
+      combdetect->mask_size = width * height;
+      combdetect->mask = g_malloc (combdetect->mask_size);
+    }
+
+    job.frame = inframe;
+    job.mask = combdetect->mask;
+    job.width = width;
+
+    gst_comb_workers_run (&combdetect->workers, n_threads, 2, height - 2,
+        comb_mask_rows, &job);
+
     memset (thisline, 0, sizeof (thisline));
 
     k = 0;
@@ -231,25 +360,14 @@ gst_comb_detect_transform_frame (GstVideoFilter * filter,
         }
       } else {
         guint8 *dest = GET_LINE (outframe, 0, j);
-        guint8 *src1 = GET_LINE (inframe, 0, j - 1);
         guint8 *src2 = GET_LINE (inframe, 0, j);
-        guint8 *src3 = GET_LINE (inframe, 0, j + 1);
+        guint8 *mask = combdetect->mask + j * width;
+
+        score += gst_comb_accumulate_line (thisline, mask, width);
 
         for (i = 0; i < width; i++) {
-          if (src2[i] < MIN (src1[i], src3[i]) - 5 ||
-              src2[i] > MAX (src1[i], src3[i]) + 5) {
-            if (i > 0) {
-              thisline[i] += thisline[i - 1];
-            }
-            thisline[i]++;
-            if (thisline[i] > 1000)
-              thisline[i] = 1000;
-          } else {
-            thisline[i] = 0;
-          }
-          if (thisline[i] > 100) {
+          if (mask[i]) {
             dest[i] = ((i + j + z) & 0x4) ? 235 : 16;
-            score++;
           } else {
             dest[i] = src2[i];
           }
@@ -23,6 +23,8 @@
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
 
+#include "gstcomb.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_COMB_DETECT   (gst_comb_detect_get_type())
@@ -39,6 +41,15 @@ struct _GstCombDetect
   GstVideoFilter base_combdetect;
 
   GstVideoInfo vinfo;
+
+  guint n_threads;
+  GstCombWorkers workers;
+
+  /* comb mask of the luma plane */
+  guint8 *mask;
+  gsize mask_size;
+
+  int z;
 };
 
 struct _GstCombDetectClass
@@ -59,6 +59,12 @@ GST_DEBUG_CATEGORY_STATIC (gst_ivtc_debug_category);
 /* prototypes */
 
 
+static void gst_ivtc_set_property (GObject * object,
+    guint property_id, const GValue * value, GParamSpec * pspec);
+static void gst_ivtc_get_property (GObject * object,
+    guint property_id, GValue * value, GParamSpec * pspec);
+static void gst_ivtc_finalize (GObject * object);
+static gboolean gst_ivtc_stop (GstBaseTransform * trans);
 static GstCaps *gst_ivtc_transform_caps (GstBaseTransform * trans,
     GstPadDirection direction, GstCaps * caps, GstCaps * filter);
 static GstCaps *gst_ivtc_fixate_caps (GstBaseTransform * trans,
@@ -73,13 +79,17 @@ static void gst_ivtc_flush (GstIvtc * ivtc);
 static void gst_ivtc_retire_fields (GstIvtc * ivtc, int n_fields);
 static void gst_ivtc_construct_frame (GstIvtc * itvc, GstBuffer * outbuf);
 
-static int get_comb_score (GstVideoFrame * top, GstVideoFrame * bottom);
+static int get_comb_score (GstIvtc * ivtc, GstVideoFrame * top,
+    GstVideoFrame * bottom, guint n_threads);
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_N_THREADS
 };
 
+#define DEFAULT_N_THREADS 1
+
 /* pad templates */
 
 #define MAX_WIDTH 2048
@@ -114,6 +124,7 @@ G_DEFINE_TYPE_WITH_CODE (GstIvtc, gst_ivtc, GST_TYPE_BASE_TRANSFORM,
 static void
 gst_ivtc_class_init (GstIvtcClass * klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   GstBaseTransformClass *base_transform_class =
       GST_BASE_TRANSFORM_CLASS (klass);
 
@@ -134,11 +145,92 @@ gst_ivtc_class_init (GstIvtcClass * klass)
   base_transform_class->set_caps = GST_DEBUG_FUNCPTR (gst_ivtc_set_caps);
   base_transform_class->sink_event = GST_DEBUG_FUNCPTR (gst_ivtc_sink_event);
   base_transform_class->transform = GST_DEBUG_FUNCPTR (gst_ivtc_transform);
+  base_transform_class->stop = GST_DEBUG_FUNCPTR (gst_ivtc_stop);
+
+  gobject_class->set_property = gst_ivtc_set_property;
+  gobject_class->get_property = gst_ivtc_get_property;
+  gobject_class->finalize = gst_ivtc_finalize;
+
+  /**
+   * GstIvtc:n-threads:
+   *
+   * Maximum number of threads used for the comb metric and the field
+   * interpolation, 0 means one thread per CPU.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use", 0, G_MAXUINT,
+          DEFAULT_N_THREADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
 gst_ivtc_init (GstIvtc * ivtc)
 {
+  ivtc->n_threads = DEFAULT_N_THREADS;
+  gst_comb_workers_init (&ivtc->workers);
+}
+
+static void
+gst_ivtc_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstIvtc *ivtc = GST_IVTC (object);
+
+  switch (property_id) {
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (ivtc);
+      ivtc->n_threads = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (ivtc);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_ivtc_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstIvtc *ivtc = GST_IVTC (object);
+
+  switch (property_id) {
+    case PROP_N_THREADS:
+      GST_OBJECT_LOCK (ivtc);
+      g_value_set_uint (value, ivtc->n_threads);
+      GST_OBJECT_UNLOCK (ivtc);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_ivtc_finalize (GObject * object)
+{
+  GstIvtc *ivtc = GST_IVTC (object);
+
+  gst_comb_workers_clear (&ivtc->workers);
+  g_free (ivtc->mask);
+
+  G_OBJECT_CLASS (gst_ivtc_parent_class)->finalize (object);
+}
+
+static gboolean
+gst_ivtc_stop (GstBaseTransform * trans)
+{
+  GstIvtc *ivtc = GST_IVTC (trans);
+
+  gst_ivtc_flush (ivtc);
+
+  g_free (ivtc->mask);
+  ivtc->mask = NULL;
+  ivtc->mask_size = 0;
+
+  return TRUE;
 }
 
 static GstCaps *
@@ -307,7 +399,7 @@ add_field (GstIvtc * ivtc, GstBuffer * buffer, int parity, int index)
 }
 
 static int
-similarity (GstIvtc * ivtc, int i1, int i2)
+similarity (GstIvtc * ivtc, int i1, int i2, guint n_threads)
 {
   GstIvtcField *f1, *f2;
   int score;
@@ -319,9 +411,9 @@ similarity (GstIvtc * ivtc, int i1, int i2)
   f2 = &ivtc->fields[i2];
 
   if (f1->parity == TOP_FIELD) {
-    score = get_comb_score (&f1->frame, &f2->frame);
+    score = get_comb_score (ivtc, &f1->frame, &f2->frame, n_threads);
   } else {
-    score = get_comb_score (&f2->frame, &f1->frame);
+    score = get_comb_score (ivtc, &f2->frame, &f1->frame, n_threads);
   }
 
   GST_DEBUG ("score %d", score);
@@ -384,110 +476,122 @@ reconstruct_line (guint8 * line1, guint8 * line2, int i, int a, int b, int c,
 }
 
 
+typedef struct
+{
+  GstVideoFrame *dest_frame;
+  GstIvtcField *field;
+  int k;
+} GstIvtcReconstructJob;
+
 static void
-reconstruct_single (GstIvtc * ivtc, GstVideoFrame * dest_frame, int i1)
+reconstruct_single_rows (gpointer user_data, int y_start, int y_end)
 {
+  GstIvtcReconstructJob *job = user_data;
+  GstVideoFrame *dest_frame = job->dest_frame;
+  GstIvtcField *field = job->field;
+  int k = job->k;
   int j;
-  int k;
   int height;
   int width;
-  GstIvtcField *field = &ivtc->fields[i1];
 
-  for (k = 0; k < 1; k++) {
-    height = GST_VIDEO_FRAME_COMP_HEIGHT (dest_frame, k);
-    width = GST_VIDEO_FRAME_COMP_WIDTH (dest_frame, k);
-    for (j = 0; j < height; j++) {
-      if ((j & 1) == field->parity) {
+  height = GST_VIDEO_FRAME_COMP_HEIGHT (dest_frame, k);
+  width = GST_VIDEO_FRAME_COMP_WIDTH (dest_frame, k);
+  for (j = y_start; j < y_end; j++) {
+    if ((j & 1) == field->parity) {
+      memcpy (GET_LINE (dest_frame, k, j),
+          GET_LINE (&field->frame, k, j), width);
+    } else {
+      if (j == 0 || j == height - 1) {
         memcpy (GET_LINE (dest_frame, k, j),
-            GET_LINE (&field->frame, k, j), width);
-      } else {
-        if (j == 0 || j == height - 1) {
-          memcpy (GET_LINE (dest_frame, k, j),
-              GET_LINE (&field->frame, k, (j ^ 1)), width);
-        } else {
-          guint8 *dest = GET_LINE (dest_frame, k, j);
-          guint8 *line1 = GET_LINE (&field->frame, k, j - 1);
-          guint8 *line2 = GET_LINE (&field->frame, k, j + 1);
-          int i;
+            GET_LINE (&field->frame, k, (j ^ 1)), width);
+      } else if (k == 0) {
+        guint8 *dest = GET_LINE (dest_frame, k, j);
+        guint8 *line1 = GET_LINE (&field->frame, k, j - 1);
+        guint8 *line2 = GET_LINE (&field->frame, k, j + 1);
+        int i;
 
 #define MARGIN 3
-          for (i = MARGIN; i < width - MARGIN; i++) {
-            int dx, dy;
+        for (i = MARGIN; i < width - MARGIN; i++) {
+          int dx, dy;
 
-            dx = -line1[i - 1] - line2[i - 1] + line1[i + 1] + line2[i + 1];
-            dx *= 2;
+          dx = -line1[i - 1] - line2[i - 1] + line1[i + 1] + line2[i + 1];
+          dx *= 2;
 
-            dy = -line1[i - 1] - 2 * line1[i] - line1[i + 1]
-                + line2[i - 1] + 2 * line2[i] + line2[i + 1];
-            if (dy < 0) {
-              dy = -dy;
-              dx = -dx;
-            }
+          dy = -line1[i - 1] - 2 * line1[i] - line1[i + 1]
+              + line2[i - 1] + 2 * line2[i] + line2[i + 1];
+          if (dy < 0) {
+            dy = -dy;
+            dx = -dx;
+          }
 
-            if (dx == 0 && dy == 0) {
-              dest[i] = (line1[i] + line2[i] + 1) >> 1;
-            } else if (dx < 0) {
-              if (dx < -2 * dy) {
-                dest[i] = reconstruct_line (line1, line2, i, 0, 0, 0, 16);
-              } else if (dx < -dy) {
-                dest[i] = reconstruct_line (line1, line2, i, 0, 0, 8, 8);
-              } else if (2 * dx < -dy) {
-                dest[i] = reconstruct_line (line1, line2, i, 0, 4, 8, 4);
-              } else if (3 * dx < -dy) {
-                dest[i] = reconstruct_line (line1, line2, i, 1, 7, 7, 1);
-              } else {
-                dest[i] = reconstruct_line (line1, line2, i, 4, 8, 4, 0);
-              }
+          if (dx == 0 && dy == 0) {
+            dest[i] = (line1[i] + line2[i] + 1) >> 1;
+          } else if (dx < 0) {
+            if (dx < -2 * dy) {
+              dest[i] = reconstruct_line (line1, line2, i, 0, 0, 0, 16);
+            } else if (dx < -dy) {
+              dest[i] = reconstruct_line (line1, line2, i, 0, 0, 8, 8);
+            } else if (2 * dx < -dy) {
+              dest[i] = reconstruct_line (line1, line2, i, 0, 4, 8, 4);
+            } else if (3 * dx < -dy) {
+              dest[i] = reconstruct_line (line1, line2, i, 1, 7, 7, 1);
+            } else {
+              dest[i] = reconstruct_line (line1, line2, i, 4, 8, 4, 0);
+            }
+          } else {
+            if (dx > 2 * dy) {
+              dest[i] = reconstruct_line (line2, line1, i, 0, 0, 0, 16);
+            } else if (dx > dy) {
+              dest[i] = reconstruct_line (line2, line1, i, 0, 0, 8, 8);
+            } else if (2 * dx > dy) {
+              dest[i] = reconstruct_line (line2, line1, i, 0, 4, 8, 4);
+            } else if (3 * dx > dy) {
+              dest[i] = reconstruct_line (line2, line1, i, 1, 7, 7, 1);
             } else {
-              if (dx > 2 * dy) {
-                dest[i] = reconstruct_line (line2, line1, i, 0, 0, 0, 16);
-              } else if (dx > dy) {
-                dest[i] = reconstruct_line (line2, line1, i, 0, 0, 8, 8);
-              } else if (2 * dx > dy) {
-                dest[i] = reconstruct_line (line2, line1, i, 0, 4, 8, 4);
-              } else if (3 * dx > dy) {
-                dest[i] = reconstruct_line (line2, line1, i, 1, 7, 7, 1);
-              } else {
-                dest[i] = reconstruct_line (line2, line1, i, 4, 8, 4, 0);
-              }
+              dest[i] = reconstruct_line (line2, line1, i, 4, 8, 4, 0);
             }
           }
+        }
 
-          for (i = 0; i < MARGIN; i++) {
-            dest[i] = (line1[i] + line2[i] + 1) >> 1;
-          }
-          for (i = width - MARGIN; i < width; i++) {
-            dest[i] = (line1[i] + line2[i] + 1) >> 1;
-          }
+        for (i = 0; i < MARGIN; i++) {
+          dest[i] = (line1[i] + line2[i] + 1) >> 1;
+        }
+        for (i = width - MARGIN; i < width; i++) {
+          dest[i] = (line1[i] + line2[i] + 1) >> 1;
         }
-      }
-    }
-  }
-  for (k = 1; k < 3; k++) {
-    height = GST_VIDEO_FRAME_COMP_HEIGHT (dest_frame, k);
-    width = GST_VIDEO_FRAME_COMP_WIDTH (dest_frame, k);
-    for (j = 0; j < height; j++) {
-      if ((j & 1) == field->parity) {
-        memcpy (GET_LINE (dest_frame, k, j),
-            GET_LINE (&field->frame, k, j), width);
       } else {
-        if (j == 0 || j == height - 1) {
-          memcpy (GET_LINE (dest_frame, k, j),
-              GET_LINE (&field->frame, k, (j ^ 1)), width);
-        } else {
-          guint8 *dest = GET_LINE (dest_frame, k, j);
-          guint8 *line1 = GET_LINE (&field->frame, k, j - 1);
-          guint8 *line2 = GET_LINE (&field->frame, k, j + 1);
-          int i;
-          for (i = 0; i < width; i++) {
-            dest[i] = (line1[i] + line2[i] + 1) >> 1;
-          }
+        guint8 *dest = GET_LINE (dest_frame, k, j);
+        guint8 *line1 = GET_LINE (&field->frame, k, j - 1);
+        guint8 *line2 = GET_LINE (&field->frame, k, j + 1);
+        int i;
+        for (i = 0; i < width; i++) {
+          dest[i] = (line1[i] + line2[i] + 1) >> 1;
         }
       }
     }
   }
 }
 
+static void
+reconstruct_single (GstIvtc * ivtc, GstVideoFrame * dest_frame, int i1,
+    guint n_threads)
+{
+  GstIvtcReconstructJob job;
+  int k;
+
+  job.dest_frame = dest_frame;
+  job.field = &ivtc->fields[i1];
+
+  /* every line only depends on the source field, so the rows can be
+   * interpolated in parallel */
+  for (k = 0; k < 3; k++) {
+    job.k = k;
+    gst_comb_workers_run (&ivtc->workers, n_threads, 0,
+        GST_VIDEO_FRAME_COMP_HEIGHT (dest_frame, k), reconstruct_single_rows,
+        &job);
+  }
+}
+
 static void
 gst_ivtc_retire_fields (GstIvtc * ivtc, int n_fields)
 {
@@ -568,6 +672,11 @@ gst_ivtc_construct_frame (GstIvtc * ivtc, GstBuffer * outbuf)
   GstVideoFrame dest_frame;
   int n_retire;
   gboolean forward_ok;
+  guint n_threads;
+
+  GST_OBJECT_LOCK (ivtc);
+  n_threads = ivtc->n_threads;
+  GST_OBJECT_UNLOCK (ivtc);
 
   anchor_index = 1;
   if (ivtc->fields[anchor_index].ts < ivtc->current_ts) {
@@ -576,8 +685,8 @@ gst_ivtc_construct_frame (GstIvtc * ivtc, GstBuffer * outbuf)
     forward_ok = FALSE;
   }
 
-  prev_score = similarity (ivtc, anchor_index - 1, anchor_index);
-  next_score = similarity (ivtc, anchor_index, anchor_index + 1);
+  prev_score = similarity (ivtc, anchor_index - 1, anchor_index, n_threads);
+  next_score = similarity (ivtc, anchor_index, anchor_index + 1, n_threads);
 
   gst_video_frame_map (&dest_frame, &ivtc->src_video_info, outbuf,
       GST_MAP_WRITE);
@@ -608,7 +717,7 @@ gst_ivtc_construct_frame (GstIvtc * ivtc, GstBuffer * outbuf)
     if (prev_score < THRESHOLD * 2 || next_score < THRESHOLD * 2) {
       GST_INFO ("borderline single (%d, %d)", prev_score, next_score);
     }
-    reconstruct_single (ivtc, &dest_frame, anchor_index);
+    reconstruct_single (ivtc, &dest_frame, anchor_index, n_threads);
     n_retire = anchor_index + 1;
   }
 
@@ -629,47 +738,65 @@ gst_ivtc_construct_frame (GstIvtc * ivtc, GstBuffer * outbuf)
 
 }
 
+typedef struct
+{
+  GstVideoFrame *top;
+  GstVideoFrame *bottom;
+  guint8 *mask;
+  int width;
+} GstIvtcCombJob;
+
+static void
+comb_mask_rows (gpointer user_data, int y_start, int y_end)
+{
+  GstIvtcCombJob *job = user_data;
+  int j;
+  int k = 0;
+
+  for (j = y_start; j < y_end; j++) {
+    gst_comb_mask_line (job->mask + j * job->width,
+        GET_LINE_IL (job->top, job->bottom, 0, j - 1),
+        GET_LINE_IL (job->top, job->bottom, 0, j),
+        GET_LINE_IL (job->top, job->bottom, 0, j + 1), job->width);
+  }
+}
+
 static int
-get_comb_score (GstVideoFrame * top, GstVideoFrame * bottom)
+get_comb_score (GstIvtc * ivtc, GstVideoFrame * top, GstVideoFrame * bottom,
+    guint n_threads)
 {
+  GstIvtcCombJob job;
   int j;
   int thisline[MAX_WIDTH];
   int score = 0;
   int height;
   int width;
-  int k;
 
   height = GST_VIDEO_FRAME_COMP_HEIGHT (top, 0);
   width = GST_VIDEO_FRAME_COMP_WIDTH (top, 0);
 
-  memset (thisline, 0, sizeof (thisline));
+  if (ivtc->mask_size < width * height) {
+    g_free (ivtc->mask);
+    ivtc->mask_size = width * height;
+    ivtc->mask = g_malloc (ivtc->mask_size);
+  }
+
+  job.top = top;
+  job.bottom = bottom;
+  job.mask = ivtc->mask;
+  job.width = width;
 
-  k = 0;
   /* remove a few lines from top and bottom, as they sometimes contain
    * artifacts */
-  for (j = 2; j < height - 2; j++) {
-    guint8 *src1 = GET_LINE_IL (top, bottom, 0, j - 1);
-    guint8 *src2 = GET_LINE_IL (top, bottom, 0, j);
-    guint8 *src3 = GET_LINE_IL (top, bottom, 0, j + 1);
-    int i;
-
-    for (i = 0; i < width; i++) {
-      if (src2[i] < MIN (src1[i], src3[i]) - 5 ||
-          src2[i] > MAX (src1[i], src3[i]) + 5) {
-        if (i > 0) {
-          thisline[i] += thisline[i - 1];
-        }
-        thisline[i]++;
-        if (thisline[i] > 1000)
-          thisline[i] = 1000;
-      } else {
-        thisline[i] = 0;
-      }
-      if (thisline[i] > 100) {
-        score++;
-      }
-    }
-  }
+  gst_comb_workers_run (&ivtc->workers, n_threads, 2, height - 2,
+      comb_mask_rows, &job);
+
+  /* the runs carry over from one line to the next, so this part stays
+   * sequential */
+  memset (thisline, 0, sizeof (thisline));
+  for (j = 2; j < height - 2; j++)
+    score += gst_comb_accumulate_line (thisline, ivtc->mask + j * width,
+        width);
 
   GST_DEBUG ("score %d", score);
 
@@ -677,7 +804,6 @@ get_comb_score (GstVideoFrame * top, GstVideoFrame * bottom)
 }
 
 
-
 static gboolean
 plugin_init (GstPlugin * plugin)
 {
@@ -23,6 +23,8 @@
 #include <gst/base/gstbasetransform.h>
 #include <gst/video/video.h>
 
+#include "gstcomb.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_IVTC   (gst_ivtc_get_type())
@@ -58,6 +60,13 @@ struct _GstIvtc
 
   int n_fields;
   GstIvtcField fields[GST_IVTC_MAX_FIELDS];
+
+  guint n_threads;
+  GstCombWorkers workers;
+
+  /* comb mask of a pair of fields */
+  guint8 *mask;
+  gsize mask_size;
 };
 
 struct _GstIvtcClass
@@ -31,6 +31,11 @@
  * image header searching for image properties such as width and height
  * among others. Jpegparse can also extract metadata (e.g. xmp).
  *
+ * If downstream advertises #GstJpegRestartMeta in the allocation query,
+ * jpegparse indexes the restart intervals of single-scan images and attaches
+ * their offsets to the output buffers, so decoders can process the intervals
+ * in parallel without rescanning the entropy-coded segment.
+ *
  * ## Example launch line
  * |[
  * gst-launch-1.0 -v souphttpsrc location=... ! jpegparse ! matroskamux ! filesink location=...
@@ -51,6 +56,7 @@
 #include <string.h>
 #include <gst/base/gstbytereader.h>
 #include <gst/tag/tag.h>
+#include <gst/codecparsers/gstjpegrestartmeta.h>
 
 #include "gstjpegparse.h"
 
@@ -86,6 +92,8 @@ static gboolean gst_jpeg_parse_start (GstBaseParse * parse);
 static gboolean gst_jpeg_parse_stop (GstBaseParse * parse);
 static GstFlowReturn gst_jpeg_parse_pre_push_frame (GstBaseParse * bparse,
     GstBaseParseFrame * frame);
+static gboolean gst_jpeg_parse_sink_query (GstBaseParse * bparse,
+    GstQuery * query);
 
 #define gst_jpeg_parse_parent_class parent_class
 G_DEFINE_TYPE (GstJpegParse, gst_jpeg_parse, GST_TYPE_BASE_PARSE);
@@ -105,6 +113,7 @@ gst_jpeg_parse_class_init (GstJpegParseClass * klass)
   gstbaseparse_class->sink_event = gst_jpeg_parse_sink_event;
   gstbaseparse_class->handle_frame = gst_jpeg_parse_handle_frame;
   gstbaseparse_class->pre_push_frame = gst_jpeg_parse_pre_push_frame;
+  gstbaseparse_class->sink_query = gst_jpeg_parse_sink_query;
 
   gst_element_class_add_static_pad_template (gstelement_class,
       &gst_jpeg_parse_src_pad_template);
@@ -713,6 +722,147 @@ gst_jpeg_parse_set_new_caps (GstJpegParse * parse, gboolean header_ok)
 
 }
 
+/*
+ * gst_jpeg_parse_index_restart_intervals:
+ * @parse: the parser
+ * @data: a complete image, from SOI to EOI
+ * @size: size of @data
+ * @restart_interval: (out): the restart interval signalled by DRI
+ * @offsets: array of guint32 the interval offsets are appended to
+ * @sizes: array of guint32 the interval sizes are appended to
+ *
+ * Walks the markers of the image and splits the entropy-coded segment of
+ * its scan on the RSTn markers.
+ *
+ * Returns: TRUE if the image has a single scan with restart intervals.
+ */
+static gboolean
+gst_jpeg_parse_index_restart_intervals (GstJpegParse * parse,
+    const guint8 * data, gsize size, guint * restart_interval,
+    GArray * offsets, GArray * sizes)
+{
+  gsize pos = 2;
+  guint n_scans = 0;
+
+  *restart_interval = 0;
+
+  while (pos + 1 < size) {
+    guint8 marker;
+    guint16 len;
+
+    if (data[pos] != 0xff)
+      goto lost_sync;
+
+    marker = data[pos + 1];
+    if (marker == 0xff) {
+      /* fill byte */
+      pos++;
+      continue;
+    }
+    pos += 2;
+
+    if (marker == EOI)
+      break;
+    if (marker >= RST0 && marker <= RST7)
+      continue;
+
+    if (pos + 2 > size)
+      goto lost_sync;
+    len = GST_READ_UINT16_BE (data + pos);
+    if (len < 2 || pos + len > size)
+      goto lost_sync;
+
+    if (marker == DRI && len >= 4) {
+      *restart_interval = GST_READ_UINT16_BE (data + pos + 2);
+    } else if (marker == SOS) {
+      gsize start, p;
+
+      /* the intervals of progressive or multi-scan images are only
+       * meaningful together with their scan, don't bother */
+      if (++n_scans > 1) {
+        GST_LOG_OBJECT (parse, "multiple scans, not indexing");
+        return FALSE;
+      }
+
+      start = p = pos + len;
+      while (1) {
+        const guint8 *ff;
+        guint32 val;
+
+        ff = memchr (data + p, 0xff, size - p);
+        if (!ff || ff + 1 >= data + size)
+          goto lost_sync;
+
+        p = ff - data;
+        marker = ff[1];
+        if (marker == 0x00 || marker == 0xff) {
+          /* stuffed byte or fill byte before a marker */
+          p++;
+          continue;
+        }
+
+        val = start;
+        g_array_append_val (offsets, val);
+        val = p - start;
+        g_array_append_val (sizes, val);
+
+        if (marker < RST0 || marker > RST7)
+          break;
+
+        start = p = p + 2;
+      }
+      pos = p;
+      continue;
+    }
+
+    pos += len;
+  }
+
+  return n_scans == 1 && *restart_interval > 0;
+
+lost_sync:
+  {
+    GST_DEBUG_OBJECT (parse, "lost sync at offset %" G_GSIZE_FORMAT
+        ", not indexing restart intervals", pos);
+    return FALSE;
+  }
+}
+
+static void
+gst_jpeg_parse_add_restart_meta (GstJpegParse * parse,
+    GstBaseParseFrame * frame)
+{
+  GstMapInfo map;
+  GArray *offsets, *sizes;
+  guint restart_interval;
+  gboolean indexed;
+
+  if (!gst_buffer_map (frame->buffer, &map, GST_MAP_READ))
+    return;
+
+  offsets = g_array_new (FALSE, FALSE, sizeof (guint32));
+  sizes = g_array_new (FALSE, FALSE, sizeof (guint32));
+
+  indexed = gst_jpeg_parse_index_restart_intervals (parse, map.data, map.size,
+      &restart_interval, offsets, sizes);
+
+  gst_buffer_unmap (frame->buffer, &map);
+
+  if (indexed) {
+    GstBuffer *buf;
+
+    GST_LOG_OBJECT (parse, "adding restart meta, %u intervals of %u MCUs",
+        offsets->len, restart_interval);
+
+    buf = frame->buffer = gst_buffer_make_writable (frame->buffer);
+    gst_buffer_add_jpeg_restart_meta (buf, restart_interval, offsets->len,
+        (guint32 *) offsets->data, (guint32 *) sizes->data);
+  }
+
+  g_array_free (offsets, TRUE);
+  g_array_free (sizes, TRUE);
+}
+
 static GstFlowReturn
 gst_jpeg_parse_pre_push_frame (GstBaseParse * bparse, GstBaseParseFrame * frame)
 {
@@ -734,6 +884,9 @@ gst_jpeg_parse_pre_push_frame (GstBaseParse * bparse, GstBaseParseFrame * frame)
 
   GST_BUFFER_DURATION (outbuf) = parse->duration;
 
+  if (parse->send_restart_meta)
+    gst_jpeg_parse_add_restart_meta (parse, frame);
+
   return GST_FLOW_OK;
 }
 
@@ -854,6 +1007,26 @@ gst_jpeg_parse_sink_event (GstBaseParse * bparse, GstEvent * event)
   return res;
 }
 
+static gboolean
+gst_jpeg_parse_sink_query (GstBaseParse * bparse, GstQuery * query)
+{
+  GstJpegParse *parse = GST_JPEG_PARSE_CAST (bparse);
+  gboolean res;
+
+  res = GST_BASE_PARSE_CLASS (parent_class)->sink_query (bparse, query);
+
+  if (res && GST_QUERY_TYPE (query) == GST_QUERY_ALLOCATION) {
+    parse->send_restart_meta =
+        gst_query_find_allocation_meta (query, GST_JPEG_RESTART_META_API_TYPE,
+        NULL);
+
+    GST_DEBUG_OBJECT (parse, "Downstream can handle GstJpegRestartMeta : %d",
+        parse->send_restart_meta);
+  }
+
+  return res;
+}
+
 static gboolean
 gst_jpeg_parse_start (GstBaseParse * bparse)
 {
@@ -879,6 +1052,8 @@ gst_jpeg_parse_start (GstBaseParse * bparse)
 
   parse->tags = NULL;
 
+  parse->send_restart_meta = FALSE;
+
   return TRUE;
 }
 
@@ -79,6 +79,9 @@ struct _GstJpegParse {
 
   /* tags */
   GstTagList *tags;
+
+  /* TRUE if downstream wants GstJpegRestartMeta */
+  gboolean send_restart_meta;
 };
 
 struct _GstJpegParseClass {
@@ -64,6 +64,11 @@
 
 #define DURATION_SCAN_LIMIT         4 * 1024 * 1024
 
+/* Minimum SCR distance between two entries of the seek index */
+#define INDEX_INTERVAL (CLOCK_FREQ / 10)
+/* Seeks go directly to an index entry at most this far before the target */
+#define INDEX_MAX_SEEK_DISTANCE (CLOCK_FREQ / 2)
+
 typedef enum
 {
   SCAN_SCR,
@@ -300,6 +305,7 @@ gst_ps_demux_init (GstPsDemux * demux)
   demux->adapter = gst_adapter_new ();
   demux->rev_adapter = gst_adapter_new ();
   demux->flowcombiner = gst_flow_combiner_new ();
+  demux->index = g_array_new (FALSE, FALSE, sizeof (GstPsDemuxIndexEntry));
 
   gst_ps_demux_reset (demux);
 
@@ -316,6 +322,7 @@ gst_ps_demux_finalize (GstPsDemux * demux)
   gst_flow_combiner_free (demux->flowcombiner);
   g_object_unref (demux->adapter);
   g_object_unref (demux->rev_adapter);
+  g_array_free (demux->index, TRUE);
 
   G_OBJECT_CLASS (parent_class)->finalize (G_OBJECT (demux));
 }
@@ -389,6 +396,9 @@ gst_ps_demux_reset (GstPsDemux * demux)
   demux->scr_rate_d = G_MAXUINT64;
   demux->first_pts = G_MAXUINT64;
   demux->last_pts = G_MAXUINT64;
+  GST_OBJECT_LOCK (demux);
+  g_array_set_size (demux->index, 0);
+  GST_OBJECT_UNLOCK (demux);
   demux->mux_rate = G_MAXUINT64;
   demux->next_pts = G_MAXUINT64;
   demux->next_dts = G_MAXUINT64;
@@ -1125,6 +1135,76 @@ gst_ps_demux_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
   return res;
 }
 
+/* Remembers that the pack at @offset has @scr. Entries closer than
+ * INDEX_INTERVAL to their neighbours are skipped to bound the size of the
+ * index, and so are entries that would break the ordering by SCR, like
+ * after SCR discontinuities */
+static void
+gst_ps_demux_index_add (GstPsDemux * demux, guint64 scr, guint64 offset)
+{
+  GstPsDemuxIndexEntry *entries, entry;
+  guint lo = 0, hi;
+
+  GST_OBJECT_LOCK (demux);
+  entries = (GstPsDemuxIndexEntry *) demux->index->data;
+  hi = demux->index->len;
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    if (entries[mid].offset < offset)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  if (lo > 0 && (scr <= entries[lo - 1].scr ||
+          scr - entries[lo - 1].scr < INDEX_INTERVAL))
+    goto done;
+  if (lo < demux->index->len && (scr >= entries[lo].scr ||
+          entries[lo].scr - scr < INDEX_INTERVAL))
+    goto done;
+
+  GST_LOG_OBJECT (demux, "Indexing SCR %" G_GUINT64_FORMAT " at offset %"
+      G_GUINT64_FORMAT, scr, offset);
+
+  entry.scr = scr;
+  entry.offset = offset;
+  g_array_insert_val (demux->index, lo, entry);
+
+done:
+  GST_OBJECT_UNLOCK (demux);
+}
+
+/* Looks up the last index entry with an SCR of at most @scr and the first
+ * one after it. The SCR of missing entries is set to G_MAXUINT64 */
+static void
+gst_ps_demux_index_lookup (GstPsDemux * demux, guint64 scr,
+    GstPsDemuxIndexEntry * prev, GstPsDemuxIndexEntry * next)
+{
+  GstPsDemuxIndexEntry *entries;
+  guint lo = 0, hi;
+
+  prev->scr = next->scr = G_MAXUINT64;
+
+  GST_OBJECT_LOCK (demux);
+  entries = (GstPsDemuxIndexEntry *) demux->index->data;
+  hi = demux->index->len;
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    if (entries[mid].scr <= scr)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  if (lo > 0)
+    *prev = entries[lo - 1];
+  if (lo < demux->index->len)
+    *next = entries[lo];
+  GST_OBJECT_UNLOCK (demux);
+}
+
 static gboolean
 gst_ps_demux_handle_seek_push (GstPsDemux * demux, GstEvent * event)
 {
@@ -1173,6 +1253,20 @@ gst_ps_demux_handle_seek_push (GstPsDemux * demux, GstEvent * event)
   bstart = GSTTIME_TO_BYTES ((guint64) start);
   bstop = GSTTIME_TO_BYTES ((guint64) stop);
 
+  /* Packs we have seen before give the exact offset */
+  if (start_type == GST_SEEK_TYPE_SET && start >= 0 &&
+      demux->base_time != G_MAXUINT64) {
+    GstPsDemuxIndexEntry prev, next;
+    guint64 scr = GSTTIME_TO_MPEGTIME (start + demux->base_time);
+
+    gst_ps_demux_index_lookup (demux, scr, &prev, &next);
+    if (prev.scr != G_MAXUINT64 && scr - prev.scr <= INDEX_MAX_SEEK_DISTANCE) {
+      GST_DEBUG_OBJECT (demux, "using indexed pack at offset %"
+          G_GUINT64_FORMAT, prev.offset);
+      bstart = prev.offset;
+    }
+  }
+
   GST_DEBUG_OBJECT (demux, "in bytes bstart %" G_GINT64_FORMAT " bstop %"
       G_GINT64_FORMAT, bstart, bstop);
   bevent = gst_event_new_seek (rate, GST_FORMAT_BYTES, flags, start_type,
@@ -1213,9 +1307,9 @@ find_offset (GstPsDemux * demux, guint64 scr,
       MIN (gst_util_uint64_scale (scr - min_scr, scr_rate_n,
           scr_rate_d), demux->sink_segment.stop);
 
-  if (!gst_ps_demux_scan_forward_ts (demux, &offset, SCAN_SCR, &fscr, 0)) {
-    gst_ps_demux_scan_backward_ts (demux, &offset, SCAN_SCR, &fscr, 0);
-  }
+  if (gst_ps_demux_scan_forward_ts (demux, &offset, SCAN_SCR, &fscr, 0) ||
+      gst_ps_demux_scan_backward_ts (demux, &offset, SCAN_SCR, &fscr, 0))
+    gst_ps_demux_index_add (demux, fscr, offset);
 
   if (fscr == scr || fscr == min_scr || fscr == max_scr) {
     return offset;
@@ -1236,6 +1330,8 @@ gst_ps_demux_do_seek (GstPsDemux * demux, GstSegment * seeksegment)
   gboolean found;
   guint64 fscr, offset;
   guint64 scr = GSTTIME_TO_MPEGTIME (seeksegment->position + demux->base_time);
+  guint64 min_scr, min_scr_offset, max_scr, max_scr_offset;
+  GstPsDemuxIndexEntry prev, next;
 
   /* In some clips the PTS values are completely unaligned with SCR values.
    * To improve the seek in that situation we apply a factor considering the
@@ -1250,9 +1346,31 @@ gst_ps_demux_do_seek (GstPsDemux * demux, GstSegment * seeksegment)
   GST_INFO_OBJECT (demux, "sink segment configured %" GST_SEGMENT_FORMAT
       ", trying to go at SCR: %" G_GUINT64_FORMAT, &demux->sink_segment, scr);
 
-  offset =
-      find_offset (demux, scr, demux->first_scr, demux->first_scr_offset,
-      demux->last_scr, demux->last_scr_offset, 0);
+  /* Go directly to a pack shortly before the target if we have seen one
+   * already, and otherwise narrow down the search with the index */
+  gst_ps_demux_index_lookup (demux, scr, &prev, &next);
+  if (prev.scr != G_MAXUINT64 && scr - prev.scr <= INDEX_MAX_SEEK_DISTANCE) {
+    offset = prev.offset;
+    fscr = prev.scr;
+    GST_INFO_OBJECT (demux, "seeking to indexed pack");
+    goto done;
+  }
+
+  min_scr = demux->first_scr;
+  min_scr_offset = demux->first_scr_offset;
+  max_scr = demux->last_scr;
+  max_scr_offset = demux->last_scr_offset;
+  if (prev.scr != G_MAXUINT64 && prev.scr > min_scr) {
+    min_scr = prev.scr;
+    min_scr_offset = prev.offset;
+  }
+  if (next.scr != G_MAXUINT64 && next.scr < max_scr) {
+    max_scr = next.scr;
+    max_scr_offset = next.offset;
+  }
+
+  offset = find_offset (demux, scr, min_scr, min_scr_offset, max_scr,
+      max_scr_offset, 0);
 
   if (offset == (guint64) - 1) {
     return FALSE;
@@ -1272,6 +1390,10 @@ gst_ps_demux_do_seek (GstPsDemux * demux, GstSegment * seeksegment)
     found = gst_ps_demux_scan_backward_ts (demux, &offset, SCAN_SCR, &fscr, 0);
   }
 
+  if (found)
+    gst_ps_demux_index_add (demux, fscr, offset);
+
+done:
   GST_INFO_OBJECT (demux, "doing seek at offset %" G_GUINT64_FORMAT
       " SCR: %" G_GUINT64_FORMAT " %" GST_TIME_FORMAT,
       offset, fscr, GST_TIME_ARGS (MPEGTIME_TO_GSTTIME (fscr)));
@@ -1796,6 +1918,9 @@ gst_ps_demux_parse_pack_start (GstPsDemux * demux)
     data += 8;
   }
 
+  if (demux->adapter_offset != G_MAXUINT64)
+    gst_ps_demux_index_add (demux, scr, demux->adapter_offset);
+
   if (demux->ignore_scr) {
     /* update only first/current_scr with raw scr value to start streaming
      * after parsing 2 seconds long data with no-more-pad */
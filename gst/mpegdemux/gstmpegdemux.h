@@ -102,6 +102,12 @@ struct _GstPsStream
   GstTagList *pending_tags;
 };
 
+typedef struct
+{
+  guint64 scr;
+  guint64 offset;
+} GstPsDemuxIndexEntry;
+
 struct _GstPsDemux
 {
   GstElement parent;
@@ -137,6 +143,10 @@ struct _GstPsDemux
   guint64 first_pts;
   guint64 last_pts;
 
+  /* GstPsDemuxIndexEntry of packs seen while playing and seeking, sorted by
+   * both offset and SCR. Protected by the object lock */
+  GArray *index;
+
   gint16 psm[GST_PS_DEMUX_MAX_PSM];
 
   GstSegment sink_segment;
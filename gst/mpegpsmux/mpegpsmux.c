@@ -95,7 +95,7 @@ static void gst_mpegpsmux_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 
 static void mpegpsmux_finalize (GObject * object);
-static gboolean new_packet_cb (guint8 * data, guint len, void *user_data);
+static gboolean new_packet_cb (GstBuffer * buf, void *user_data);
 
 static gboolean mpegpsdemux_prepare_srcpad (MpegPsMux * mux);
 static GstFlowReturn mpegpsmux_collected (GstCollectPads * pads,
@@ -550,10 +550,16 @@ mpegpsmux_collected (GstCollectPads * pads, MpegPsMux * mux)
     keyunit = !GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
 
     if (keyunit && best->stream_id == mux->video_stream_id
-        && mux->gop_list != NULL) {
-      ret = mpegpsmux_push_gop_list (mux);
-      if (ret != GST_FLOW_OK)
-        goto done;
+        && mux->aggregate_gops) {
+      /* The pending pack belongs to the previous GOP */
+      if (!psmux_flush (mux->psmux))
+        goto write_fail;
+
+      if (mux->gop_list != NULL) {
+        ret = mpegpsmux_push_gop_list (mux);
+        if (ret != GST_FLOW_OK)
+          goto done;
+      }
     }
 
     /* give the buffer to libpsmux for processing */
@@ -569,16 +575,23 @@ mpegpsmux_collected (GstCollectPads * pads, MpegPsMux * mux)
         goto write_fail;
       }
     }
+
+    /* Output the packets of each input buffer together so that timestamps
+     * stay accurate, GOPs are only output at their end anyway */
+    if (!mux->aggregate_gops && !psmux_flush (mux->psmux))
+      goto write_fail;
+
     mux->last_ts = best->last_ts;
   } else {
     /* FIXME: Drain all remaining streams */
     /* At EOS */
-    if (mux->gop_list != NULL)
-      mpegpsmux_push_gop_list (mux);
-
     if (!psmux_write_end_code (mux->psmux)) {
       GST_WARNING_OBJECT (mux, "Writing MPEG PS Program end code failed.");
     }
+
+    if (mux->gop_list != NULL)
+      mpegpsmux_push_gop_list (mux);
+
     gst_pad_push_event (mux->srcpad, gst_event_new_eos ());
 
     ret = GST_FLOW_EOS;
@@ -660,19 +673,16 @@ mpegpsmux_release_pad (GstElement * element, GstPad * pad)
 }
 
 static gboolean
-new_packet_cb (guint8 * data, guint len, void *user_data)
+new_packet_cb (GstBuffer * buf, void *user_data)
 {
-  /* Called when the PsMux has prepared a packet for output. Return FALSE
+  /* Called when the PsMux has prepared a pack for output. Return FALSE
    * on error */
 
   MpegPsMux *mux = (MpegPsMux *) user_data;
-  GstBuffer *buf;
   GstFlowReturn ret;
 
-  GST_LOG_OBJECT (mux, "Outputting a packet of length %d", len);
-
-  data = g_memdup (data, len);
-  buf = gst_buffer_new_wrapped (data, len);
+  GST_LOG_OBJECT (mux, "Outputting %" G_GSIZE_FORMAT " bytes",
+      gst_buffer_get_size (buf));
 
   GST_BUFFER_TIMESTAMP (buf) = mux->last_ts;
 
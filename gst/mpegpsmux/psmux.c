@@ -101,6 +101,10 @@ psmux_new (void)
  *
  * Set the callback function and user data to be called when @mux has output to
  * produce. @user_data will be passed as user data in @func.
+ *
+ * Output is coalesced: @func is called once per pack, or more often if a pack
+ * doesn't fit into the maximum number of memories of a #GstBuffer. The PES
+ * payload in the output shares the memory of the input buffers.
  */
 void
 psmux_set_write_func (PsMux * mux, PsMuxWriteFunc func, void *user_data)
@@ -115,7 +119,39 @@ gboolean
 psmux_write_end_code (PsMux * mux)
 {
   guint8 end_code[4] = { 0, 0, 1, PSMUX_PROGRAM_END };
-  return mux->write_func (end_code, 4, mux->write_func_data);
+
+  memcpy (mux->packet_buf, end_code, 4);
+  mux->packet_bytes_written = 4;
+  if (!psmux_packet_out (mux))
+    return FALSE;
+
+  return psmux_flush (mux);
+}
+
+/**
+ * psmux_flush:
+ * @mux: a #PsMux
+ *
+ * Pass the output that is pending in @mux to the write function, for example
+ * before starting a new GOP.
+ *
+ * Returns: FALSE if the write function failed.
+ */
+gboolean
+psmux_flush (PsMux * mux)
+{
+  GstBuffer *buf = mux->pending;
+
+  if (buf == NULL)
+    return TRUE;
+  mux->pending = NULL;
+
+  if (G_UNLIKELY (mux->write_func == NULL)) {
+    gst_buffer_unref (buf);
+    return TRUE;
+  }
+
+  return mux->write_func (buf, mux->write_func_data);
 }
 
 
@@ -147,6 +183,9 @@ psmux_free (PsMux * mux)
   if (mux->psm != NULL)
     gst_buffer_unref (mux->psm);
 
+  if (mux->pending != NULL)
+    gst_buffer_unref (mux->pending);
+
   g_slice_free (PsMux, mux);
 }
 
@@ -202,23 +241,40 @@ psmux_create_stream (PsMux * mux, PsMuxStreamType stream_type)
   return stream;
 }
 
+/* Takes ownership of @buf and appends it to the pending output. The pending
+ * output is flushed first if it would otherwise need more memories than a
+ * buffer can hold, so that they don't get merged into a copy */
 static gboolean
-psmux_packet_out (PsMux * mux)
+psmux_append_buffer (PsMux * mux, GstBuffer * buf)
 {
-  gboolean res;
-  if (G_UNLIKELY (mux->write_func == NULL))
-    return TRUE;
+  gboolean res = TRUE;
 
-  res = mux->write_func (mux->packet_buf, mux->packet_bytes_written,
-      mux->write_func_data);
+  if (mux->pending && gst_buffer_n_memory (mux->pending) +
+      gst_buffer_n_memory (buf) > gst_buffer_get_max_memory ())
+    res = psmux_flush (mux);
+
+  mux->bit_size += gst_buffer_get_size (buf);
+
+  if (mux->pending == NULL)
+    mux->pending = gst_buffer_make_writable (buf);
+  else
+    mux->pending = gst_buffer_append (mux->pending, buf);
 
-  if (res) {
-    mux->bit_size += mux->packet_bytes_written;
-  }
-  mux->packet_bytes_written = 0;
   return res;
 }
 
+static gboolean
+psmux_packet_out (PsMux * mux)
+{
+  GstBuffer *buf;
+
+  buf = gst_buffer_new_wrapped (g_memdup (mux->packet_buf,
+          mux->packet_bytes_written), mux->packet_bytes_written);
+  mux->packet_bytes_written = 0;
+
+  return psmux_append_buffer (mux, buf);
+}
+
 /**
  * psmux_write_stream_packet:
  * @mux: a #PsMux
@@ -231,6 +287,7 @@ psmux_packet_out (PsMux * mux)
 gboolean
 psmux_write_stream_packet (PsMux * mux, PsMuxStream * stream)
 {
+  GstBuffer *packet;
   gboolean res;
 
   g_return_val_if_fail (mux != NULL, FALSE);
@@ -263,6 +320,10 @@ psmux_write_stream_packet (PsMux * mux, PsMuxStream * stream)
       mux->bit_pts = mux->pts;
     }
 
+    /* Output the previous pack as a whole */
+    if (!psmux_flush (mux))
+      return FALSE;
+
     psmux_write_pack_header (mux);
     mux->pack_hdr_pts = mux->pts;
   }
@@ -280,13 +341,12 @@ psmux_write_stream_packet (PsMux * mux, PsMuxStream * stream)
   }
 
   /* Write the packet */
-  if (!(mux->packet_bytes_written =
-          psmux_stream_get_data (stream, mux->packet_buf,
+  if (!(packet = psmux_stream_get_packet (stream,
               mux->pes_max_payload + PSMUX_PES_MAX_HDR_LEN))) {
     return FALSE;
   }
 
-  res = psmux_packet_out (mux);
+  res = psmux_append_buffer (mux, packet);
   if (!res) {
     GST_DEBUG_OBJECT (mux, "packet write false");
     return FALSE;
@@ -396,16 +456,9 @@ psmux_ensure_system_header (PsMux * mux)
 static gboolean
 psmux_write_system_header (PsMux * mux)
 {
-  GstMapInfo map;
-
   psmux_ensure_system_header (mux);
 
-  gst_buffer_map (mux->sys_header, &map, GST_MAP_READ);
-  memcpy (mux->packet_buf, map.data, map.size);
-  mux->packet_bytes_written = map.size;
-  gst_buffer_unmap (mux->sys_header, &map);
-
-  return psmux_packet_out (mux);
+  return psmux_append_buffer (mux, gst_buffer_ref (mux->sys_header));
 }
 
 static void
@@ -480,16 +533,9 @@ psmux_ensure_program_stream_map (PsMux * mux)
 static gboolean
 psmux_write_program_stream_map (PsMux * mux)
 {
-  GstMapInfo map;
-
   psmux_ensure_program_stream_map (mux);
 
-  gst_buffer_map (mux->psm, &map, GST_MAP_READ);
-  memcpy (mux->packet_buf, map.data, map.size);
-  mux->packet_bytes_written = map.size;
-  gst_buffer_unmap (mux->psm, &map);
-
-  return psmux_packet_out (mux);
+  return psmux_append_buffer (mux, gst_buffer_ref (mux->psm));
 }
 
 GList *
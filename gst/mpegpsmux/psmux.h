@@ -54,7 +54,7 @@ G_BEGIN_DECLS
 
 #define PSMUX_MAX_ES_INFO_LENGTH ((1 << 12) - 1)
 
-typedef gboolean (*PsMuxWriteFunc) (guint8 *data, guint len, void *user_data);
+typedef gboolean (*PsMuxWriteFunc) (GstBuffer *buf, void *user_data);
 
 struct PsMux {
   GList *streams;    /* PsMuxStream* array of all streams */
@@ -83,6 +83,7 @@ struct PsMux {
 
   guint8 packet_buf[PSMUX_MAX_PACKET_LEN];
   guint packet_bytes_written; /* # of bytes written in the buf */
+  GstBuffer *pending; /* output not passed to write_func yet */
   PsMuxWriteFunc write_func;
   void *write_func_data;
 
@@ -112,6 +113,7 @@ PsMuxStream *	psmux_create_stream 		(PsMux *mux, PsMuxStreamType stream_type);
 /* writing stuff */
 gboolean 	psmux_write_stream_packet 	(PsMux *mux, PsMuxStream *stream); 
 gboolean	psmux_write_end_code		(PsMux *mux);
+gboolean	psmux_flush			(PsMux *mux);
 
 GList *		psmux_get_stream_headers	(PsMux *mux);
 
@@ -260,24 +260,25 @@ psmux_stream_bytes_in_buffer (PsMuxStream * stream)
 }
 
 /**
- * psmux_stream_get_data:
+ * psmux_stream_get_packet:
  * @stream: a #PsMuxStream
- * @buf: a buffer to hold the result
- * @len: the length of @buf
+ * @len: the maximum length of the packet
  *
- * Write a PES packet to @buf, up to @len bytes
+ * Create a PES packet of up to @len bytes. The payload of the packet shares
+ * the memory of the buffers added to @stream.
  *
- * Returns: number of bytes having been written, 0 if error
+ * Returns: the packet, or NULL on error
  */
-guint
-psmux_stream_get_data (PsMuxStream * stream, guint8 * buf, guint len)
+GstBuffer *
+psmux_stream_get_packet (PsMuxStream * stream, guint len)
 {
+  GstBuffer *packet;
+  GstMapInfo map;
   guint8 pes_hdr_length;
   guint w;
 
-  g_return_val_if_fail (stream != NULL, FALSE);
-  g_return_val_if_fail (buf != NULL, FALSE);
-  g_return_val_if_fail (len >= PSMUX_PES_MAX_HDR_LEN, FALSE);
+  g_return_val_if_fail (stream != NULL, NULL);
+  g_return_val_if_fail (len >= PSMUX_PES_MAX_HDR_LEN, NULL);
 
   stream->cur_pes_payload_size =
       MIN (psmux_stream_bytes_in_buffer (stream), len - PSMUX_PES_MAX_HDR_LEN);
@@ -306,41 +307,37 @@ psmux_stream_get_data (PsMuxStream * stream, guint8 * buf, guint len)
   /* write pes header */
   GST_LOG ("Writing PES header of length %u and payload %d",
       pes_hdr_length, stream->cur_pes_payload_size);
-  psmux_stream_write_pes_header (stream, buf);
+  packet = gst_buffer_new_allocate (NULL, pes_hdr_length, NULL);
+  gst_buffer_map (packet, &map, GST_MAP_WRITE);
+  psmux_stream_write_pes_header (stream, map.data);
+  gst_buffer_unmap (packet, &map);
 
-  buf += pes_hdr_length;
   w = stream->cur_pes_payload_size;     /* number of bytes of payload to write */
 
   while (w > 0) {
     guint32 avail;
-    guint8 *cur;
 
     if (stream->cur_buffer == NULL) {
       /* Start next packet */
-      if (stream->buffers == NULL)
-        return FALSE;
+      if (stream->buffers == NULL) {
+        gst_buffer_unref (packet);
+        return NULL;
+      }
       stream->cur_buffer = (PsMuxStreamBuffer *) (stream->buffers->data);
       stream->cur_buffer_consumed = 0;
     }
 
-    /* Take as much as we can from the current buffer */
+    /* Take as much as we can from the current buffer, without copying */
     avail = stream->cur_buffer->map.size - stream->cur_buffer_consumed;
-    cur = stream->cur_buffer->map.data + stream->cur_buffer_consumed;
-    if (avail < w) {
-      memcpy (buf, cur, avail);
-      psmux_stream_consume (stream, avail);
-
-      buf += avail;
-      w -= avail;
-    } else {
-      memcpy (buf, cur, w);
-      psmux_stream_consume (stream, w);
-
-      w = 0;
-    }
+    avail = MIN (avail, w);
+    gst_buffer_copy_into (packet, stream->cur_buffer->buf,
+        GST_BUFFER_COPY_MEMORY, stream->cur_buffer_consumed, avail);
+    psmux_stream_consume (stream, avail);
+
+    w -= avail;
   }
 
-  return pes_hdr_length + stream->cur_pes_payload_size;
+  return packet;
 }
 
 static guint8
@@ -149,7 +149,7 @@ gint 		psmux_stream_bytes_in_buffer 	(PsMuxStream *stream);
 gint 		psmux_stream_bytes_avail 	(PsMuxStream *stream);
 
 /* write PES data */
-guint	 	psmux_stream_get_data 		(PsMuxStream *stream, guint8 *buf, guint len);
+GstBuffer *	psmux_stream_get_packet 	(PsMuxStream *stream, guint len);
 
 /* write corresponding descriptors of the stream */
 void 		psmux_stream_get_es_descrs 	(PsMuxStream *stream, guint8 *buf, guint16 *len);
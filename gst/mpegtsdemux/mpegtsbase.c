@@ -66,6 +66,7 @@ enum
   PROP_0,
   PROP_PARSE_PRIVATE_SECTIONS,
   PROP_IGNORE_PCR,
+  PROP_POSTED_TABLE_IDS,
   /* FILL ME */
 };
 
@@ -158,6 +159,24 @@ mpegts_base_class_init (MpegTSBaseClass * klass)
           "Ignore PCR stream for timing", DEFAULT_IGNORE_PCR,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstMpegtsBase:posted-table-ids:
+   *
+   * Table IDs of the sections posted on the bus as
+   * #GST_MESSAGE_ELEMENT messages. An empty array (the default) posts
+   * all of them. Every section is still handled internally: restricting
+   * this avoids the cost of the bus messages for tables the application
+   * doesn't care about, e.g. the EIT schedule sections of a DVB mux.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_POSTED_TABLE_IDS,
+      gst_param_spec_array ("posted-table-ids", "Posted table IDs",
+          "Table IDs of the sections to post on the bus (empty for all)",
+          g_param_spec_uint ("table-id", "Table ID", "Table ID", 0, 0xff, 0,
+              G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS),
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   klass->sink_query = GST_DEBUG_FUNCPTR (mpegts_base_default_sink_query);
 
   gst_type_mark_as_plugin_api (GST_TYPE_MPEGTS_BASE, 0);
@@ -176,6 +195,20 @@ mpegts_base_set_property (GObject * object, guint prop_id,
     case PROP_IGNORE_PCR:
       base->ignore_pcr = g_value_get_boolean (value);
       break;
+    case PROP_POSTED_TABLE_IDS:{
+      guint i, n = gst_value_array_get_size (value);
+
+      GST_OBJECT_LOCK (base);
+      memset (base->posted_table_ids, 0, sizeof (base->posted_table_ids));
+      for (i = 0; i < n; i++) {
+        guint table_id =
+            g_value_get_uint (gst_value_array_get_value (value, i)) & 0xff;
+        base->posted_table_ids[table_id / 32] |= 1U << (table_id % 32);
+      }
+      base->filter_posted_sections = (n > 0);
+      GST_OBJECT_UNLOCK (base);
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -194,6 +227,22 @@ mpegts_base_get_property (GObject * object, guint prop_id,
     case PROP_IGNORE_PCR:
       g_value_set_boolean (value, base->ignore_pcr);
       break;
+    case PROP_POSTED_TABLE_IDS:{
+      GValue v = G_VALUE_INIT;
+      guint table_id;
+
+      g_value_init (&v, G_TYPE_UINT);
+      GST_OBJECT_LOCK (base);
+      for (table_id = 0; table_id < 256; table_id++) {
+        if (base->posted_table_ids[table_id / 32] & (1U << (table_id % 32))) {
+          g_value_set_uint (&v, table_id);
+          gst_value_array_append_value (value, &v);
+        }
+      }
+      GST_OBJECT_UNLOCK (base);
+      g_value_unset (&v);
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -208,6 +257,7 @@ mpegts_base_reset (MpegTSBase * base)
   mpegts_packetizer_clear (base->packetizer);
   memset (base->is_pes, 0, 1024);
   memset (base->known_psi, 0, 1024);
+  memset (base->pid_filter, 0, 1024);
 
   /* FIXME : Actually these are not *always* know SI streams
    * depending on the variant of mpeg-ts being used. */
@@ -269,6 +319,7 @@ mpegts_base_init (MpegTSBase * base)
   base->parse_private_sections = FALSE;
   base->is_pes = g_new0 (guint8, 1024);
   base->known_psi = g_new0 (guint8, 1024);
+  base->pid_filter = g_new0 (guint8, 1024);
   base->program_size = sizeof (MpegTSBaseProgram);
   base->stream_size = sizeof (MpegTSBaseStream);
 
@@ -289,6 +340,7 @@ mpegts_base_dispose (GObject * object)
     base->disposed = TRUE;
     g_free (base->known_psi);
     g_free (base->is_pes);
+    g_free (base->pid_filter);
   }
 
   if (G_OBJECT_CLASS (parent_class)->dispose)
@@ -617,6 +669,34 @@ mpegts_base_program_add_stream (MpegTSBase * base,
   return bstream;
 }
 
+/* Let packets on all the PIDs of @program through the PID filter */
+void
+mpegts_base_pid_filter_add_program (MpegTSBase * base,
+    MpegTSBaseProgram * program)
+{
+  GList *tmp;
+
+  GST_DEBUG_OBJECT (base, "Adding program %d to the PID filter",
+      program->program_number);
+
+  for (tmp = program->stream_list; tmp; tmp = tmp->next) {
+    MpegTSBaseStream *stream = (MpegTSBaseStream *) tmp->data;
+    MPEGTS_BIT_SET (base->pid_filter, stream->pid);
+  }
+
+  if (program->pcr_pid != 0x1fff)
+    MPEGTS_BIT_SET (base->pid_filter, program->pcr_pid);
+}
+
+/* Only let packets on known PSI PIDs through the PID filter */
+void
+mpegts_base_pid_filter_clear (MpegTSBase * base)
+{
+  GST_DEBUG_OBJECT (base, "Clearing PID filter");
+
+  memset (base->pid_filter, 0, 1024);
+}
+
 static void
 mpegts_base_program_remove_stream (MpegTSBase * base,
     MpegTSBaseProgram * program, guint16 pid)
@@ -1203,6 +1283,21 @@ same_program:
   }
 }
 
+static gboolean
+mpegts_base_wants_posted_section (MpegTSBase * base,
+    GstMpegtsSection * section)
+{
+  gboolean res = TRUE;
+
+  GST_OBJECT_LOCK (base);
+  if (base->filter_posted_sections)
+    res = (base->posted_table_ids[section->table_id / 32] &
+        (1U << (section->table_id % 32))) != 0;
+  GST_OBJECT_UNLOCK (base);
+
+  return res;
+}
+
 static void
 mpegts_base_handle_psi (MpegTSBase * base, GstMpegtsSection * section)
 {
@@ -1235,7 +1330,9 @@ mpegts_base_handle_psi (MpegTSBase * base, GstMpegtsSection * section)
       break;
   }
 
-  /* Finally post message (if it wasn't corrupted) */
+  /* Finally post message (if it wasn't corrupted and is wanted) */
+  if (post_message)
+    post_message = mpegts_base_wants_posted_section (base, section);
   if (post_message)
     gst_element_post_message (GST_ELEMENT_CAST (base),
         gst_message_new_mpegts_section (GST_OBJECT (base), section));
@@ -1269,8 +1366,12 @@ mpegts_base_parse_atsc_mgt (MpegTSBase * base, GstMpegtsSection * section)
 static gboolean
 mpegts_base_get_tags_from_eit (MpegTSBase * base, GstMpegtsSection * section)
 {
-  const GstMpegtsEIT *eit;
-  guint i;
+  GstMpegtsEITEventIter iter;
+  GstMpegtsDescriptorIter desc_iter;
+  GstMpegtsDescriptor desc;
+  GstMpegtsRunningStatus running_status;
+  guint16 event_id;
+  guint32 duration;
   MpegTSBaseProgram *program;
 
   /* Early exit if it's not from the present/following table_id */
@@ -1279,51 +1380,54 @@ mpegts_base_get_tags_from_eit (MpegTSBase * base, GstMpegtsSection * section)
       GST_MTS_TABLE_ID_EVENT_INFORMATION_OTHER_TS_PRESENT)
     return TRUE;
 
-  eit = gst_mpegts_section_get_eit (section);
-  if (G_UNLIKELY (eit == NULL))
+  /* Only the running event is needed here, walk the section data instead
+   * of parsing the whole table. Applications still get the full table
+   * from the posted section if they ask for it. */
+  if (G_UNLIKELY (!gst_mpegts_section_eit_event_iter_init (section, &iter)))
     return FALSE;
 
   program = mpegts_base_get_program (base, section->subtable_extension);
 
-  GST_DEBUG
-      ("program_id:0x%04x, table_id:0x%02x, actual_stream:%d, present_following:%d, program:%p",
-      section->subtable_extension, section->table_id, eit->actual_stream,
-      eit->present_following, program);
-
-  if (program && eit->present_following) {
-    for (i = 0; i < eit->events->len; i++) {
-      GstMpegtsEITEvent *event = g_ptr_array_index (eit->events, i);
-      const GstMpegtsDescriptor *desc;
-
-      if (event->running_status == RUNNING_STATUS_RUNNING) {
-        program->event_id = event->event_id;
-        if ((desc =
-                gst_mpegts_find_descriptor (event->descriptors,
-                    GST_MTS_DESC_DVB_SHORT_EVENT))) {
-          gchar *name = NULL, *text = NULL;
-
-          if (gst_mpegts_descriptor_parse_dvb_short_event (desc, NULL, &name,
-                  &text)) {
-            if (!program->tags)
-              program->tags = gst_tag_list_new_empty ();
-
-            if (name) {
-              gst_tag_list_add (program->tags, GST_TAG_MERGE_APPEND,
-                  GST_TAG_TITLE, name, NULL);
-              g_free (name);
-            }
-            if (text) {
-              gst_tag_list_add (program->tags, GST_TAG_MERGE_APPEND,
-                  GST_TAG_DESCRIPTION, text, NULL);
-              g_free (text);
-            }
-            /* FIXME : Is it correct to post an event duration as a GST_TAG_DURATION ??? */
-            gst_tag_list_add (program->tags, GST_TAG_MERGE_APPEND,
-                GST_TAG_DURATION, event->duration * GST_SECOND, NULL);
-            return TRUE;
-          }
-        }
+  GST_DEBUG ("program_id:0x%04x, table_id:0x%02x, program:%p",
+      section->subtable_extension, section->table_id, program);
+
+  if (!program)
+    return TRUE;
+
+  while (gst_mpegts_eit_event_iter_next (&iter, &event_id, &duration,
+          &running_status, NULL, &desc_iter)) {
+    if (running_status != RUNNING_STATUS_RUNNING)
+      continue;
+
+    program->event_id = event_id;
+    while (gst_mpegts_descriptor_iter_next (&desc_iter, &desc)) {
+      gchar *name = NULL, *text = NULL;
+
+      if (desc.tag != GST_MTS_DESC_DVB_SHORT_EVENT)
+        continue;
+
+      /* only the first short event descriptor is used */
+      if (!gst_mpegts_descriptor_parse_dvb_short_event (&desc, NULL, &name,
+              &text))
+        break;
+
+      if (!program->tags)
+        program->tags = gst_tag_list_new_empty ();
+
+      if (name) {
+        gst_tag_list_add (program->tags, GST_TAG_MERGE_APPEND,
+            GST_TAG_TITLE, name, NULL);
+        g_free (name);
       }
+      if (text) {
+        gst_tag_list_add (program->tags, GST_TAG_MERGE_APPEND,
+            GST_TAG_DESCRIPTION, text, NULL);
+        g_free (text);
+      }
+      /* FIXME : Is it correct to post an event duration as a GST_TAG_DURATION ??? */
+      gst_tag_list_add (program->tags, GST_TAG_MERGE_APPEND,
+          GST_TAG_DURATION, duration * GST_SECOND, NULL);
+      return TRUE;
     }
   }
 
@@ -1434,6 +1538,48 @@ mpegts_base_sink_query (GstPad * pad, GstObject * parent, GstQuery * query)
   return GST_MPEGTS_BASE_GET_CLASS (base)->sink_query (base, query);
 }
 
+static inline GstFlowReturn
+mpegts_base_handle_packet (MpegTSBase * base, MpegTSBaseClass * klass,
+    MpegTSPacketizerPacket * packet)
+{
+  GstFlowReturn res = GST_FLOW_OK;
+
+  if (klass->inspect_packet)
+    klass->inspect_packet (base, packet);
+
+  /* If it's a known PES, push it */
+  if (MPEGTS_BIT_IS_SET (base->is_pes, packet->pid)) {
+    /* push the packet downstream */
+    if (base->push_data)
+      res = klass->push (base, packet, NULL);
+  } else if (packet->payload
+      && MPEGTS_BIT_IS_SET (base->known_psi, packet->pid)) {
+    /* base PSI data */
+    GList *others, *tmp;
+    GstMpegtsSection *section;
+
+    section =
+        mpegts_packetizer_push_section (base->packetizer, packet, &others);
+    if (section)
+      mpegts_base_handle_psi (base, section);
+    if (G_UNLIKELY (others)) {
+      for (tmp = others; tmp; tmp = tmp->next)
+        mpegts_base_handle_psi (base, (GstMpegtsSection *) tmp->data);
+      g_list_free (others);
+    }
+
+    /* we need to push section packet downstream */
+    if (base->push_section)
+      res = klass->push (base, packet, section);
+
+  } else if (base->push_unknown) {
+    res = klass->push (base, packet, NULL);
+  } else if (packet->payload && packet->pid != 0x1fff)
+    GST_LOG ("PID 0x%04x Saw packet on a pid we don't handle", packet->pid);
+
+  return res;
+}
+
 static GstFlowReturn
 mpegts_base_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 {
@@ -1441,7 +1587,7 @@ mpegts_base_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
   MpegTSBase *base;
   MpegTSPacketizerPacketReturn pret;
   MpegTSPacketizer2 *packetizer;
-  MpegTSPacketizerPacket packet;
+  MpegTSPacketizerPacket packets[MPEGTS_PACKETIZER_BATCH_SIZE];
   MpegTSBaseClass *klass;
 
   base = GST_MPEGTS_BASE (parent);
@@ -1470,52 +1616,41 @@ mpegts_base_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
   mpegts_packetizer_push (base->packetizer, buf);
 
   while (res == GST_FLOW_OK) {
-    pret = mpegts_packetizer_next_packet (base->packetizer, &packet);
+    MpegTSPacketizerPacketReturn rets[MPEGTS_PACKETIZER_BATCH_SIZE];
+    guint i, n_packets;
+
+    n_packets = mpegts_packetizer_next_packets (packetizer, packets, rets,
+        MPEGTS_PACKETIZER_BATCH_SIZE);
 
     /* If we don't have enough data, return */
-    if (G_UNLIKELY (pret == PACKET_NEED_MORE))
+    if (G_UNLIKELY (n_packets == 0))
       break;
 
-    if (G_UNLIKELY (pret == PACKET_BAD)) {
-      /* bad header, skip the packet */
-      GST_DEBUG_OBJECT (base, "bad packet, skipping");
-      goto next;
-    }
+    for (i = 0; i < n_packets && res == GST_FLOW_OK; i++) {
+      MpegTSPacketizerPacket *packet = &packets[i];
 
-    if (klass->inspect_packet)
-      klass->inspect_packet (base, &packet);
-
-    /* If it's a known PES, push it */
-    if (MPEGTS_BIT_IS_SET (base->is_pes, packet.pid)) {
-      /* push the packet downstream */
-      if (base->push_data)
-        res = klass->push (base, &packet, NULL);
-    } else if (packet.payload
-        && MPEGTS_BIT_IS_SET (base->known_psi, packet.pid)) {
-      /* base PSI data */
-      GList *others, *tmp;
-      GstMpegtsSection *section;
-
-      section = mpegts_packetizer_push_section (packetizer, &packet, &others);
-      if (section)
-        mpegts_base_handle_psi (base, section);
-      if (G_UNLIKELY (others)) {
-        for (tmp = others; tmp; tmp = tmp->next)
-          mpegts_base_handle_psi (base, (GstMpegtsSection *) tmp->data);
-        g_list_free (others);
+      pret = rets[i];
+      if (G_LIKELY (pret == PACKET_OK)) {
+        /* Drop packets we don't care about before parsing the adaptation
+         * field and doing any PCR handling */
+        if (base->filter_pids
+            && !MPEGTS_BIT_IS_SET (base->pid_filter, packet->pid)
+            && !MPEGTS_BIT_IS_SET (base->known_psi, packet->pid))
+          continue;
+
+        pret = mpegts_packetizer_complete_packet (packetizer, packet);
       }
 
-      /* we need to push section packet downstream */
-      if (base->push_section)
-        res = klass->push (base, &packet, section);
+      if (G_UNLIKELY (pret == PACKET_BAD)) {
+        /* bad header, skip the packet */
+        GST_DEBUG_OBJECT (base, "bad packet, skipping");
+        continue;
+      }
 
-    } else if (base->push_unknown) {
-      res = klass->push (base, &packet, NULL);
-    } else if (packet.payload && packet.pid != 0x1fff)
-      GST_LOG ("PID 0x%04x Saw packet on a pid we don't handle", packet.pid);
+      res = mpegts_base_handle_packet (base, klass, packet);
+    }
 
-  next:
-    mpegts_packetizer_clear_packet (base->packetizer, &packet);
+    mpegts_packetizer_clear_packets (packetizer, packets, i);
   }
 
   if (res == GST_FLOW_OK && klass->input_done)
@@ -133,6 +133,13 @@ struct _MpegTSBase {
   guint8 *known_psi;
   guint8 *is_pes;
 
+  /* If filter_pids is set, only packets on known PSI PIDs and on PIDs set
+   * in pid_filter are handled beyond their 4 byte header. Subclasses select
+   * the programs they are interested in with
+   * mpegts_base_pid_filter_add_program() */
+  gboolean filter_pids;
+  guint8 *pid_filter;
+
   gboolean disposed;
 
   /* size of the MpegTSBaseProgram structure, can be overridden
@@ -170,6 +177,11 @@ struct _MpegTSBase {
   /* Do not use the PCR stream for timestamp calculation. Useful for
    * streams with broken/invalid PCR streams. */
   gboolean ignore_pcr;
+
+  /* Bitmask of the table IDs to post on the bus, if filtering them.
+   * Protected by the object lock */
+  gboolean filter_posted_sections;
+  guint32 posted_table_ids[8];
 };
 
 struct _MpegTSBaseClass {
@@ -246,6 +258,9 @@ G_GNUC_INTERNAL gboolean gst_mpegtsbase_plugin_init (GstPlugin * plugin);
 
 G_GNUC_INTERNAL void mpegts_base_deactivate_and_free_program (MpegTSBase *base, MpegTSBaseProgram *program);
 
+G_GNUC_INTERNAL void mpegts_base_pid_filter_add_program (MpegTSBase *base, MpegTSBaseProgram *program);
+G_GNUC_INTERNAL void mpegts_base_pid_filter_clear (MpegTSBase *base);
+
 G_END_DECLS
 
 #endif /* GST_MPEG_TS_BASE_H */
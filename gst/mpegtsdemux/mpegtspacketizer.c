@@ -134,21 +134,15 @@ mpegts_packetizer_get_current_time (MpegTSPacketizer2 * packetizer,
       pcr_pid);
 }
 
+#define SUBTABLE_KEY(table_id, subtable_extension) \
+  GUINT_TO_POINTER (((guint) (table_id) << 16) | (subtable_extension))
+
 static inline MpegTSPacketizerStreamSubtable *
-find_subtable (GSList * subtables, guint8 table_id, guint16 subtable_extension)
+find_subtable (GHashTable * subtables, guint8 table_id,
+    guint16 subtable_extension)
 {
-  GSList *tmp;
-
-  /* FIXME: Make this an array ! */
-  for (tmp = subtables; tmp; tmp = tmp->next) {
-    MpegTSPacketizerStreamSubtable *sub =
-        (MpegTSPacketizerStreamSubtable *) tmp->data;
-    if (sub->table_id == table_id
-        && sub->subtable_extension == subtable_extension)
-      return sub;
-  }
-
-  return NULL;
+  return g_hash_table_lookup (subtables,
+      SUBTABLE_KEY (table_id, subtable_extension));
 }
 
 static gboolean
@@ -192,6 +186,13 @@ mpegts_packetizer_stream_subtable_new (guint8 table_id,
   return subtable;
 }
 
+static void
+mpegts_packetizer_stream_subtable_free (MpegTSPacketizerStreamSubtable *
+    subtable)
+{
+  g_free (subtable);
+}
+
 static MpegTSPacketizerStream *
 mpegts_packetizer_stream_new (guint16 pid)
 {
@@ -199,7 +200,8 @@ mpegts_packetizer_stream_new (guint16 pid)
 
   stream = (MpegTSPacketizerStream *) g_new0 (MpegTSPacketizerStream, 1);
   stream->continuity_counter = CONTINUITY_UNSET;
-  stream->subtables = NULL;
+  stream->subtables = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+      NULL, (GDestroyNotify) mpegts_packetizer_stream_subtable_free);
   stream->table_id = TABLE_ID_UNSET;
   stream->pid = pid;
   return stream;
@@ -216,20 +218,11 @@ mpegts_packetizer_clear_section (MpegTSPacketizerStream * stream)
   stream->section_data = NULL;
 }
 
-static void
-mpegts_packetizer_stream_subtable_free (MpegTSPacketizerStreamSubtable *
-    subtable)
-{
-  g_free (subtable);
-}
-
 static void
 mpegts_packetizer_stream_free (MpegTSPacketizerStream * stream)
 {
   mpegts_packetizer_clear_section (stream);
-  g_slist_foreach (stream->subtables,
-      (GFunc) mpegts_packetizer_stream_subtable_free, NULL);
-  g_slist_free (stream->subtables);
+  g_hash_table_unref (stream->subtables);
   g_free (stream);
 }
 
@@ -293,6 +286,7 @@ mpegts_packetizer_dispose (GObject * object)
 
     gst_adapter_clear (packetizer->adapter);
     g_object_unref (packetizer->adapter);
+    gst_buffer_replace (&packetizer->map_buffer, NULL);
     g_mutex_clear (&packetizer->group_lock);
     packetizer->disposed = TRUE;
     packetizer->offset = 0;
@@ -457,9 +451,11 @@ mpegts_packetizer_parse_adaptation_field_control (MpegTSPacketizer2 *
   return TRUE;
 }
 
-static MpegTSPacketizerPacketReturn
-mpegts_packetizer_parse_packet (MpegTSPacketizer2 * packetizer,
-    MpegTSPacketizerPacket * packet)
+/* Parses the 4 byte transport packet header only. The adaptation field
+ * (and therefore any PCR handling) is left to
+ * mpegts_packetizer_complete_packet() */
+static inline MpegTSPacketizerPacketReturn
+mpegts_packetizer_parse_packet_header (MpegTSPacketizerPacket * packet)
 {
   guint8 *data;
   guint8 tmp;
@@ -490,9 +486,16 @@ mpegts_packetizer_parse_packet (MpegTSPacketizer2 * packetizer,
   packet->afc_flags = 0;
   packet->pcr = G_MAXUINT64;
 
-  if (FLAGS_HAS_AFC (tmp)) {
+  return PACKET_OK;
+}
+
+MpegTSPacketizerPacketReturn
+mpegts_packetizer_complete_packet (MpegTSPacketizer2 * packetizer,
+    MpegTSPacketizerPacket * packet)
+{
+  if (FLAGS_HAS_AFC (packet->scram_afc_cc)) {
     if (!mpegts_packetizer_parse_adaptation_field_control (packetizer, packet))
-      return FALSE;
+      return PACKET_BAD;
   }
 
   if (FLAGS_HAS_PAYLOAD (packet->scram_afc_cc))
@@ -503,6 +506,16 @@ mpegts_packetizer_parse_packet (MpegTSPacketizer2 * packetizer,
   return PACKET_OK;
 }
 
+static MpegTSPacketizerPacketReturn
+mpegts_packetizer_parse_packet (MpegTSPacketizer2 * packetizer,
+    MpegTSPacketizerPacket * packet)
+{
+  if (mpegts_packetizer_parse_packet_header (packet) != PACKET_OK)
+    return PACKET_BAD;
+
+  return mpegts_packetizer_complete_packet (packetizer, packet);
+}
+
 static GstMpegtsSection *
 mpegts_packetizer_parse_section_header (MpegTSPacketizer2 * packetizer,
     MpegTSPacketizerStream * stream)
@@ -529,7 +542,8 @@ mpegts_packetizer_parse_section_header (MpegTSPacketizer2 * packetizer,
         stream->subtable_extension, stream->last_section_number);
     subtable->version_number = stream->version_number;
 
-    stream->subtables = g_slist_prepend (stream->subtables, subtable);
+    g_hash_table_insert (stream->subtables,
+        SUBTABLE_KEY (stream->table_id, stream->subtable_extension), subtable);
   }
 
   GST_MEMDUMP ("Full section data", stream->section_data,
@@ -585,6 +599,7 @@ mpegts_packetizer_clear (MpegTSPacketizer2 * packetizer)
   }
 
   gst_adapter_clear (packetizer->adapter);
+  gst_buffer_replace (&packetizer->map_buffer, NULL);
   packetizer->offset = 0;
   packetizer->empty = TRUE;
   packetizer->need_sync = FALSE;
@@ -626,6 +641,7 @@ mpegts_packetizer_flush (MpegTSPacketizer2 * packetizer, gboolean hard)
     }
   }
   gst_adapter_clear (packetizer->adapter);
+  gst_buffer_replace (&packetizer->map_buffer, NULL);
 
   packetizer->offset = 0;
   packetizer->empty = TRUE;
@@ -709,6 +725,7 @@ mpegts_packetizer_flush_bytes (MpegTSPacketizer2 * packetizer, gsize size)
     gst_adapter_flush (packetizer->adapter, size);
   }
 
+  gst_buffer_replace (&packetizer->map_buffer, NULL);
   packetizer->map_data = NULL;
   packetizer->map_size = 0;
   packetizer->map_offset = 0;
@@ -741,6 +758,31 @@ mpegts_packetizer_map (MpegTSPacketizer2 * packetizer, gsize size)
   return TRUE;
 }
 
+/* Returns a buffer referencing (without copying) the @size bytes at @data,
+ * which must point inside the currently mapped region of the adapter */
+GstBuffer *
+mpegts_packetizer_get_mapped_region (MpegTSPacketizer2 * packetizer,
+    const guint8 * data, gsize size)
+{
+  gsize offset;
+
+  g_return_val_if_fail (packetizer->map_data != NULL, NULL);
+  g_return_val_if_fail (data >= packetizer->map_data, NULL);
+
+  offset = data - packetizer->map_data;
+  g_return_val_if_fail (offset + size <= packetizer->map_size, NULL);
+
+  /* The mapped region always starts at the head of the adapter, which
+   * gives us the same layout as in the mapped data even if the adapter
+   * had to merge several input buffers for mapping */
+  if (packetizer->map_buffer == NULL)
+    packetizer->map_buffer =
+        gst_adapter_get_buffer_fast (packetizer->adapter, packetizer->map_size);
+
+  return gst_buffer_copy_region (packetizer->map_buffer,
+      GST_BUFFER_COPY_MEMORY, offset, size);
+}
+
 static gboolean
 mpegts_try_discover_packet_size (MpegTSPacketizer2 * packetizer)
 {
@@ -761,9 +803,17 @@ mpegts_try_discover_packet_size (MpegTSPacketizer2 * packetizer)
   data = packetizer->map_data + packetizer->map_offset;
 
   for (i = 0; i + 3 * MPEGTS_MAX_PACKETSIZE < size; i++) {
-    /* find a sync byte */
-    if (data[i] != PACKET_SYNC_BYTE)
-      continue;
+    const guint8 *sync;
+
+    /* find a sync byte. memchr() is vectorized in all libc we care about
+     * and skips over garbage much faster than a byte-by-byte loop */
+    sync = memchr (data + i, PACKET_SYNC_BYTE,
+        size - 3 * MPEGTS_MAX_PACKETSIZE - i);
+    if (sync == NULL) {
+      i = size - 3 * MPEGTS_MAX_PACKETSIZE;
+      break;
+    }
+    i = sync - data;
 
     /* check for 4 consecutive sync bytes with each possible packet size */
     for (j = 0; j < G_N_ELEMENTS (psizes); j++) {
@@ -819,8 +869,16 @@ mpegts_packetizer_sync (MpegTSPacketizer2 * packetizer)
     sync_offset = 0;
 
   for (i = sync_offset; i + 2 * packet_size < size; i++) {
-    if (data[i] == PACKET_SYNC_BYTE &&
-        data[i + packet_size] == PACKET_SYNC_BYTE &&
+    const guint8 *sync;
+
+    sync = memchr (data + i, PACKET_SYNC_BYTE, size - 2 * packet_size - i);
+    if (sync == NULL) {
+      i = size - 2 * packet_size;
+      break;
+    }
+    i = sync - data;
+
+    if (data[i + packet_size] == PACKET_SYNC_BYTE &&
         data[i + 2 * packet_size] == PACKET_SYNC_BYTE) {
       found = TRUE;
       break;
@@ -888,6 +946,107 @@ mpegts_packetizer_next_packet (MpegTSPacketizer2 * packetizer,
   }
 }
 
+/* Batched variant of mpegts_packetizer_next_packet().
+ *
+ * Parses the headers of up to @max_packets consecutive in-sync packets
+ * from the currently mapped region of the adapter, storing them in @packets
+ * and their parsing result in @rets. The adapter is only mapped once for
+ * the whole batch.
+ *
+ * Only the 4 byte packet header is parsed, callers have to call
+ * mpegts_packetizer_complete_packet() on each packet they want to process
+ * (in order), so that PCR observations are still recorded in stream order.
+ *
+ * The packets stay valid until mpegts_packetizer_clear_packets() is called.
+ *
+ * Returns: the number of packets stored in @packets, 0 if more data is
+ * needed. */
+guint
+mpegts_packetizer_next_packets (MpegTSPacketizer2 * packetizer,
+    MpegTSPacketizerPacket * packets, MpegTSPacketizerPacketReturn * rets,
+    guint max_packets)
+{
+  guint8 *packet_data;
+  guint packet_size;
+  gsize sync_offset, available;
+  guint n;
+
+  packet_size = packetizer->packet_size;
+  if (G_UNLIKELY (!packet_size)) {
+    if (!mpegts_try_discover_packet_size (packetizer))
+      return 0;
+    packet_size = packetizer->packet_size;
+  }
+
+  /* M2TS packets don't start with the sync byte, all other variants do */
+  if (packet_size == MPEGTS_M2TS_PACKETSIZE)
+    sync_offset = 4;
+  else
+    sync_offset = 0;
+
+  while (1) {
+    if (packetizer->need_sync) {
+      if (!mpegts_packetizer_sync (packetizer))
+        return 0;
+      packetizer->need_sync = FALSE;
+    }
+
+    if (!mpegts_packetizer_map (packetizer, packet_size))
+      return 0;
+
+    packet_data = &packetizer->map_data[packetizer->map_offset + sync_offset];
+    if (G_LIKELY (*packet_data == PACKET_SYNC_BYTE))
+      break;
+
+    GST_DEBUG ("lost sync");
+    packetizer->need_sync = TRUE;
+  }
+
+  available = (packetizer->map_size - packetizer->map_offset) / packet_size;
+  if (max_packets > available)
+    max_packets = available;
+
+  /* Only hand out a run of in-sync packets, losing sync is handled on the
+   * next call */
+  for (n = 0; n < max_packets; n++, packet_data += packet_size) {
+    MpegTSPacketizerPacket *packet = &packets[n];
+
+    if (G_UNLIKELY (*packet_data != PACKET_SYNC_BYTE))
+      break;
+
+    packet->data_start = packet_data;
+    packet->data_end = packet_data + 188;
+    packet->offset = packetizer->offset;
+    packetizer->offset += packet_size;
+
+    rets[n] = mpegts_packetizer_parse_packet_header (packet);
+  }
+
+  GST_LOG ("parsed %u packets from offset %" G_GUINT64_FORMAT, n,
+      packets[0].offset);
+
+  return n;
+}
+
+/* Releases the first @n_packets packets returned by
+ * mpegts_packetizer_next_packets(). Packets that were parsed but not
+ * released will be returned again by the next call */
+void
+mpegts_packetizer_clear_packets (MpegTSPacketizer2 * packetizer,
+    MpegTSPacketizerPacket * packets, guint n_packets)
+{
+  guint packet_size = packetizer->packet_size;
+
+  /* The packetizer might have been flushed while handling the packets */
+  if (packetizer->map_data == NULL || n_packets == 0)
+    return;
+
+  packetizer->offset = packets[n_packets - 1].offset + packet_size;
+  packetizer->map_offset += n_packets * packet_size;
+  if (packetizer->map_size - packetizer->map_offset < packet_size)
+    mpegts_packetizer_flush_bytes (packetizer, packetizer->map_offset);
+}
+
 MpegTSPacketizerPacketReturn
 mpegts_packetizer_process_next_packet (MpegTSPacketizer2 * packetizer)
 {
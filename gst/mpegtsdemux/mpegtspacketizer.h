@@ -50,6 +50,10 @@
 
 #define MAX_WINDOW 512
 
+/* Maximum number of packets parsed in one go by
+ * mpegts_packetizer_next_packets() */
+#define MPEGTS_PACKETIZER_BATCH_SIZE 64
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_MPEGTS_PACKETIZER \
@@ -85,7 +89,8 @@ typedef struct
   guint8  section_number;
   guint8  last_section_number;
 
-  GSList *subtables;
+  /* MpegTSPacketizerStreamSubtable hashed by table_id/subtable_extension */
+  GHashTable *subtables;
 
   /* Upstream offset of the data contained in the section */
   guint64 offset;
@@ -268,6 +273,9 @@ struct _MpegTSPacketizer2 {
   gsize map_offset;
   gsize map_size;
   gboolean need_sync;
+  /* Buffer sharing the memory of the mapped region, created on demand by
+   * mpegts_packetizer_get_mapped_region() */
+  GstBuffer *map_buffer;
 
   /* Reference offset */
   guint64 refoffset;
@@ -348,12 +356,22 @@ G_GNUC_INTERNAL void mpegts_packetizer_push (MpegTSPacketizer2 *packetizer, GstB
 G_GNUC_INTERNAL gboolean mpegts_packetizer_has_packets (MpegTSPacketizer2 *packetizer);
 G_GNUC_INTERNAL MpegTSPacketizerPacketReturn mpegts_packetizer_next_packet (MpegTSPacketizer2 *packetizer,
   MpegTSPacketizerPacket *packet);
+G_GNUC_INTERNAL guint mpegts_packetizer_next_packets (MpegTSPacketizer2 *packetizer,
+  MpegTSPacketizerPacket *packets, MpegTSPacketizerPacketReturn *rets,
+  guint max_packets);
+G_GNUC_INTERNAL MpegTSPacketizerPacketReturn
+mpegts_packetizer_complete_packet (MpegTSPacketizer2 *packetizer,
+  MpegTSPacketizerPacket *packet);
+G_GNUC_INTERNAL void mpegts_packetizer_clear_packets (MpegTSPacketizer2 *packetizer,
+  MpegTSPacketizerPacket *packets, guint n_packets);
 G_GNUC_INTERNAL MpegTSPacketizerPacketReturn
 mpegts_packetizer_process_next_packet(MpegTSPacketizer2 * packetizer);
 G_GNUC_INTERNAL void mpegts_packetizer_clear_packet (MpegTSPacketizer2 *packetizer,
 				     MpegTSPacketizerPacket *packet);
 G_GNUC_INTERNAL void mpegts_packetizer_remove_stream(MpegTSPacketizer2 *packetizer,
   gint16 pid);
+G_GNUC_INTERNAL GstBuffer *mpegts_packetizer_get_mapped_region (MpegTSPacketizer2 *packetizer,
+  const guint8 *data, gsize size);
 
 G_GNUC_INTERNAL GstMpegtsSection *mpegts_packetizer_push_section (MpegTSPacketizer2 *packetzer,
 								  MpegTSPacketizerPacket *packet, GList **remaining);
@@ -41,6 +41,10 @@
 #define RUNNING_STATUS_RUNNING 4
 #define SYNC_BYTE 0x47
 
+#define DEFAULT_PROGRAM_THREADS FALSE
+/* Maximum number of batches or events queued for a program pad thread */
+#define PROGRAM_QUEUE_SIZE 32
+
 GST_DEBUG_CATEGORY_STATIC (mpegts_parse_debug);
 #define GST_CAT_DEFAULT mpegts_parse_debug
 
@@ -67,8 +71,35 @@ struct _MpegTSParsePad
   GstFlowReturn flow_return;
 
   MpegTSParse2Adapter ts_adapter;
+
+  /* Dedicated streaming thread, if program-threads is enabled */
+  MpegTSParse2 *parse;
+  gboolean threaded;
+  /* buffers collected from the current input buffer, input thread only */
+  GArray *batch;
+  /* protects the fields below */
+  GMutex lock;
+  GCond cond;
+  GQueue queue;
+  gboolean flushing;
+  GstFlowReturn worker_flow;
 };
 
+/* A packet queued for a program pad thread */
+typedef struct
+{
+  GstBuffer *buffer;
+  /* whether the buffer goes through the pad's alignment adapter */
+  gboolean aligned;
+} MpegTSParseQueuedBuffer;
+
+/* Either a batch of packets or a serialized event */
+typedef struct
+{
+  GArray *batch;
+  GstEvent *event;
+} MpegTSParseQueueItem;
+
 static GstStaticPadTemplate src_template =
 GST_STATIC_PAD_TEMPLATE ("src", GST_PAD_SRC,
     GST_PAD_ALWAYS,
@@ -89,6 +120,7 @@ enum
   PROP_PCR_PID,
   PROP_ALIGNMENT,
   PROP_SPLIT_ON_RAI,
+  PROP_PROGRAM_THREADS,
   /* FILL ME */
 };
 
@@ -122,6 +154,12 @@ static void mpegts_parse_release_pad (GstElement * element, GstPad * pad);
 static gboolean mpegts_parse_src_pad_query (GstPad * pad, GstObject * parent,
     GstQuery * query);
 static gboolean push_event (MpegTSBase * base, GstEvent * event);
+static gboolean mpegts_parse_tspad_activate_mode (GstPad * pad,
+    GstObject * parent, GstPadMode mode, gboolean active);
+static void mpegts_parse_batch_free (GArray * batch);
+static void mpegts_parse_tspad_clear_queue (MpegTSParsePad * tspad);
+static void mpegts_parse_tspad_push_event (MpegTSParse2 * parse,
+    MpegTSParsePad * tspad, GstEvent * event);
 
 #define mpegts_parse_parent_class parent_class
 G_DEFINE_TYPE (MpegTSParse2, mpegts_parse, GST_TYPE_MPEGTS_BASE);
@@ -178,6 +216,22 @@ mpegts_parse_class_init (MpegTSParse2Class * klass)
           "so that RAI packets are at the start of a new buffer", FALSE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * tsparse:program-threads:
+   *
+   * Push the packets of each requested program pad from a streaming thread
+   * of its own, fed in batches through a bounded queue. PSI parsing and the
+   * always source pad stay on the input thread.
+   *
+   * This applies to program pads requested after it is set.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_PROGRAM_THREADS,
+      g_param_spec_boolean ("program-threads", "Program threads",
+          "Push each program pad from its own streaming thread",
+          DEFAULT_PROGRAM_THREADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   element_class = GST_ELEMENT_CLASS (klass);
   element_class->pad_removed = mpegts_parse_pad_removed;
   element_class->request_new_pad = mpegts_parse_request_new_pad;
@@ -233,6 +287,7 @@ mpegts_parse_init (MpegTSParse2 * parse)
   parse->is_eos = FALSE;
   parse->header = 0;
   parse->split_on_rai = FALSE;
+  parse->program_threads = DEFAULT_PROGRAM_THREADS;
 }
 
 static void
@@ -308,6 +363,9 @@ mpegts_parse_set_property (GObject * object, guint prop_id,
     case PROP_SPLIT_ON_RAI:
       parse->split_on_rai = g_value_get_boolean (value);
       break;
+    case PROP_PROGRAM_THREADS:
+      parse->program_threads = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -335,6 +393,9 @@ mpegts_parse_get_property (GObject * object, guint prop_id,
     case PROP_SPLIT_ON_RAI:
       g_value_set_boolean (value, parse->split_on_rai);
       break;
+    case PROP_PROGRAM_THREADS:
+      g_value_set_boolean (value, parse->program_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -470,8 +531,13 @@ push_event (MpegTSBase * base, GstEvent * event)
   for (tmp = parse->srcpads; tmp; tmp = tmp->next) {
     GstPad *pad = (GstPad *) tmp->data;
     if (pad) {
+      MpegTSParsePad *tspad = gst_pad_get_element_private (pad);
+
       gst_event_ref (event);
-      gst_pad_push_event (pad, event);
+      if (tspad->threaded)
+        mpegts_parse_tspad_push_event (parse, tspad, event);
+      else
+        gst_pad_push_event (pad, event);
     }
   }
 
@@ -500,6 +566,14 @@ mpegts_parse_create_tspad (MpegTSParse2 * parse, const gchar * pad_name)
   tspad->ts_adapter.adapter = gst_adapter_new ();
   tspad->ts_adapter.packets_in_adapter = 0;
   tspad->ts_adapter.first_is_keyframe = TRUE;
+  tspad->parse = parse;
+  g_mutex_init (&tspad->lock);
+  g_cond_init (&tspad->cond);
+  g_queue_init (&tspad->queue);
+  tspad->flushing = TRUE;
+  tspad->worker_flow = GST_FLOW_OK;
+  gst_pad_set_activatemode_function (pad,
+      GST_DEBUG_FUNCPTR (mpegts_parse_tspad_activate_mode));
   gst_pad_set_element_private (pad, tspad);
   gst_flow_combiner_add_pad (parse->flowcombiner, pad);
 
@@ -512,6 +586,12 @@ mpegts_parse_destroy_tspad (MpegTSParse2 * parse, MpegTSParsePad * tspad)
   gst_adapter_clear (tspad->ts_adapter.adapter);
   g_object_unref (tspad->ts_adapter.adapter);
 
+  mpegts_parse_batch_free (tspad->batch);
+  tspad->batch = NULL;
+  mpegts_parse_tspad_clear_queue (tspad);
+  g_mutex_clear (&tspad->lock);
+  g_cond_clear (&tspad->cond);
+
   /* free the wrapper */
   g_free (tspad);
 }
@@ -661,21 +741,25 @@ empty_adapter_into_pad (MpegTSParse2 * parse, MpegTSParse2Adapter * ts_adapter,
   return ret;
 }
 
+/* Returns the result of the last push, and whether anything was pushed at
+ * all in @pushed */
 static GstFlowReturn
-enqueue_and_maybe_push_buffer (MpegTSParse2 * parse, GstPad * pad,
-    MpegTSParse2Adapter * ts_adapter, GstBuffer * buffer)
+enqueue_buffer_into_pad (MpegTSParse2 * parse, GstPad * pad,
+    MpegTSParse2Adapter * ts_adapter, GstBuffer * buffer, gboolean * pushed)
 {
   GstFlowReturn ret = GST_FLOW_OK;
 
+  *pushed = FALSE;
+
   if (buffer != NULL) {
     if (parse->alignment == 1) {
       ret = gst_pad_push (pad, buffer);
-      ret = gst_flow_combiner_update_flow (parse->flowcombiner, ret);
+      *pushed = TRUE;
     } else {
       if (!GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT)
           && parse->split_on_rai) {
         ret = empty_adapter_into_pad (parse, ts_adapter, pad);
-        ret = gst_flow_combiner_update_flow (parse->flowcombiner, ret);
+        *pushed = TRUE;
       }
       gst_adapter_push (ts_adapter->adapter, buffer);
       ts_adapter->packets_in_adapter++;
@@ -687,7 +771,7 @@ enqueue_and_maybe_push_buffer (MpegTSParse2 * parse, GstPad * pad,
       if (ts_adapter->packets_in_adapter == parse->alignment
           && ts_adapter->packets_in_adapter > 0) {
         ret = empty_adapter_into_pad (parse, ts_adapter, pad);
-        ret = gst_flow_combiner_update_flow (parse->flowcombiner, ret);
+        *pushed = TRUE;
       }
     }
   }
@@ -695,6 +779,313 @@ enqueue_and_maybe_push_buffer (MpegTSParse2 * parse, GstPad * pad,
   return ret;
 }
 
+static GstFlowReturn
+enqueue_and_maybe_push_buffer (MpegTSParse2 * parse, GstPad * pad,
+    MpegTSParse2Adapter * ts_adapter, GstBuffer * buffer)
+{
+  GstFlowReturn ret;
+  gboolean pushed;
+
+  ret = enqueue_buffer_into_pad (parse, pad, ts_adapter, buffer, &pushed);
+  if (pushed)
+    ret = gst_flow_combiner_update_flow (parse->flowcombiner, ret);
+
+  return ret;
+}
+
+/* Program pad threads */
+
+static void
+mpegts_parse_batch_free (GArray * batch)
+{
+  guint i;
+
+  if (batch == NULL)
+    return;
+
+  for (i = 0; i < batch->len; i++) {
+    MpegTSParseQueuedBuffer *qbuf =
+        &g_array_index (batch, MpegTSParseQueuedBuffer, i);
+
+    if (qbuf->buffer)
+      gst_buffer_unref (qbuf->buffer);
+  }
+  g_array_free (batch, TRUE);
+}
+
+static void
+mpegts_parse_queue_item_free (MpegTSParseQueueItem * item)
+{
+  mpegts_parse_batch_free (item->batch);
+  if (item->event)
+    gst_event_unref (item->event);
+  g_free (item);
+}
+
+/* Must be called with the pad lock, or without a running thread */
+static void
+mpegts_parse_tspad_clear_queue (MpegTSParsePad * tspad)
+{
+  MpegTSParseQueueItem *item;
+
+  while ((item = g_queue_pop_head (&tspad->queue)))
+    mpegts_parse_queue_item_free (item);
+}
+
+/* Pushes the packets of one batch, in order. Packets that bypass the
+ * alignment adapter are pushed as buffer lists */
+static GstFlowReturn
+mpegts_parse_tspad_push_batch (MpegTSParse2 * parse, MpegTSParsePad * tspad,
+    GArray * batch)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstBufferList *list = NULL;
+  guint i;
+
+  for (i = 0; i < batch->len; i++) {
+    MpegTSParseQueuedBuffer *qbuf =
+        &g_array_index (batch, MpegTSParseQueuedBuffer, i);
+    GstBuffer *buf = qbuf->buffer;
+    GstFlowReturn res;
+    gboolean pushed;
+
+    qbuf->buffer = NULL;
+
+    if (ret != GST_FLOW_OK && ret != GST_FLOW_NOT_LINKED) {
+      gst_buffer_unref (buf);
+      continue;
+    }
+
+    if (!qbuf->aligned) {
+      if (list == NULL)
+        list = gst_buffer_list_new ();
+      gst_buffer_list_add (list, buf);
+      continue;
+    }
+
+    if (list) {
+      ret = gst_pad_push_list (tspad->pad, list);
+      list = NULL;
+      if (ret != GST_FLOW_OK && ret != GST_FLOW_NOT_LINKED) {
+        gst_buffer_unref (buf);
+        continue;
+      }
+    }
+
+    res = enqueue_buffer_into_pad (parse, tspad->pad, &tspad->ts_adapter, buf,
+        &pushed);
+    if (pushed)
+      ret = res;
+  }
+
+  if (list)
+    ret = gst_pad_push_list (tspad->pad, list);
+
+  if (parse->alignment == 0 && (ret == GST_FLOW_OK
+          || ret == GST_FLOW_NOT_LINKED)) {
+    GstFlowReturn res =
+        empty_adapter_into_pad (parse, &tspad->ts_adapter, tspad->pad);
+    if (res != GST_FLOW_OK)
+      ret = res;
+  }
+
+  return ret;
+}
+
+static void
+mpegts_parse_tspad_loop (MpegTSParsePad * tspad)
+{
+  MpegTSParseQueueItem *item;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  g_mutex_lock (&tspad->lock);
+  while (g_queue_is_empty (&tspad->queue) && !tspad->flushing)
+    g_cond_wait (&tspad->cond, &tspad->lock);
+
+  if (tspad->flushing) {
+    g_mutex_unlock (&tspad->lock);
+    GST_DEBUG_OBJECT (tspad->pad, "Pausing task, flushing");
+    gst_pad_pause_task (tspad->pad);
+    return;
+  }
+
+  item = g_queue_pop_head (&tspad->queue);
+  /* wake up the input thread if it waits for space */
+  g_cond_broadcast (&tspad->cond);
+  g_mutex_unlock (&tspad->lock);
+
+  if (item->event) {
+    gst_pad_push_event (tspad->pad, item->event);
+    item->event = NULL;
+    mpegts_parse_queue_item_free (item);
+    return;
+  }
+
+  ret = mpegts_parse_tspad_push_batch (tspad->parse, tspad, item->batch);
+  mpegts_parse_queue_item_free (item);
+
+  GST_LOG_OBJECT (tspad->pad, "Pushed batch, %s", gst_flow_get_name (ret));
+
+  /* reported back to upstream from the input thread */
+  g_mutex_lock (&tspad->lock);
+  if (!tspad->flushing)
+    tspad->worker_flow = ret;
+  g_mutex_unlock (&tspad->lock);
+}
+
+static gboolean
+mpegts_parse_tspad_activate_mode (GstPad * pad, GstObject * parent,
+    GstPadMode mode, gboolean active)
+{
+  MpegTSParsePad *tspad = gst_pad_get_element_private (pad);
+  /* request pads are activated before being added to the element */
+  MpegTSParse2 *parse = tspad->parse;
+
+  if (mode != GST_PAD_MODE_PUSH)
+    return FALSE;
+
+  if (active) {
+    tspad->threaded = parse->program_threads;
+    if (!tspad->threaded)
+      return TRUE;
+
+    g_mutex_lock (&tspad->lock);
+    tspad->flushing = FALSE;
+    tspad->worker_flow = GST_FLOW_OK;
+    g_mutex_unlock (&tspad->lock);
+
+    return gst_pad_start_task (pad, (GstTaskFunction) mpegts_parse_tspad_loop,
+        tspad, NULL);
+  }
+
+  if (!tspad->threaded)
+    return TRUE;
+
+  g_mutex_lock (&tspad->lock);
+  tspad->flushing = TRUE;
+  mpegts_parse_tspad_clear_queue (tspad);
+  g_cond_broadcast (&tspad->cond);
+  g_mutex_unlock (&tspad->lock);
+
+  return gst_pad_stop_task (pad);
+}
+
+/* Hands @item over to the pad thread, waiting for space in the queue.
+ * Returns the latest flow return of the pad thread. */
+static GstFlowReturn
+mpegts_parse_tspad_enqueue (MpegTSParsePad * tspad,
+    MpegTSParseQueueItem * item)
+{
+  GstFlowReturn ret;
+
+  g_mutex_lock (&tspad->lock);
+  while (tspad->queue.length >= PROGRAM_QUEUE_SIZE && !tspad->flushing)
+    g_cond_wait (&tspad->cond, &tspad->lock);
+
+  if (tspad->flushing) {
+    g_mutex_unlock (&tspad->lock);
+    mpegts_parse_queue_item_free (item);
+    return GST_FLOW_FLUSHING;
+  }
+
+  g_queue_push_tail (&tspad->queue, item);
+  g_cond_broadcast (&tspad->cond);
+  ret = tspad->worker_flow;
+  g_mutex_unlock (&tspad->lock);
+
+  return ret;
+}
+
+/* Queues the batch collected so far, if any */
+static GstFlowReturn
+mpegts_parse_tspad_flush_batch (MpegTSParse2 * parse, MpegTSParsePad * tspad)
+{
+  MpegTSParseQueueItem *item;
+  GstFlowReturn ret;
+
+  if (tspad->batch == NULL)
+    return GST_FLOW_OK;
+
+  item = g_new0 (MpegTSParseQueueItem, 1);
+  item->batch = tspad->batch;
+  tspad->batch = NULL;
+
+  ret = mpegts_parse_tspad_enqueue (tspad, item);
+
+  return gst_flow_combiner_update_pad_flow (parse->flowcombiner, tspad->pad,
+      ret);
+}
+
+/* Adds @buffer to the batch of the current input buffer */
+static GstFlowReturn
+mpegts_parse_tspad_queue_buffer (MpegTSParse2 * parse, MpegTSParsePad * tspad,
+    GstBuffer * buffer, gboolean aligned)
+{
+  MpegTSParseQueuedBuffer qbuf = { buffer, aligned };
+  GstFlowReturn ret;
+
+  if (tspad->batch == NULL)
+    tspad->batch = g_array_new (FALSE, FALSE, sizeof (MpegTSParseQueuedBuffer));
+  g_array_append_val (tspad->batch, qbuf);
+
+  g_mutex_lock (&tspad->lock);
+  ret = tspad->flushing ? GST_FLOW_FLUSHING : tspad->worker_flow;
+  g_mutex_unlock (&tspad->lock);
+
+  return gst_flow_combiner_update_pad_flow (parse->flowcombiner, tspad->pad,
+      ret);
+}
+
+static void
+mpegts_parse_tspad_push_event (MpegTSParse2 * parse, MpegTSParsePad * tspad,
+    GstEvent * event)
+{
+  MpegTSParseQueueItem *item;
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_FLUSH_START:
+      g_mutex_lock (&tspad->lock);
+      tspad->flushing = TRUE;
+      mpegts_parse_tspad_clear_queue (tspad);
+      g_cond_broadcast (&tspad->cond);
+      g_mutex_unlock (&tspad->lock);
+
+      /* unblocks the pad thread if it is pushing downstream */
+      gst_pad_push_event (tspad->pad, event);
+      gst_pad_pause_task (tspad->pad);
+      break;
+    case GST_EVENT_FLUSH_STOP:
+      mpegts_parse_batch_free (tspad->batch);
+      tspad->batch = NULL;
+
+      g_mutex_lock (&tspad->lock);
+      mpegts_parse_tspad_clear_queue (tspad);
+      gst_adapter_clear (tspad->ts_adapter.adapter);
+      tspad->ts_adapter.packets_in_adapter = 0;
+      tspad->flushing = FALSE;
+      tspad->worker_flow = GST_FLOW_OK;
+      g_mutex_unlock (&tspad->lock);
+
+      gst_pad_push_event (tspad->pad, event);
+      gst_pad_start_task (tspad->pad,
+          (GstTaskFunction) mpegts_parse_tspad_loop, tspad, NULL);
+      break;
+    default:
+      if (!GST_EVENT_IS_SERIALIZED (event)) {
+        gst_pad_push_event (tspad->pad, event);
+        break;
+      }
+
+      /* keep the event ordered with the data */
+      mpegts_parse_tspad_flush_batch (parse, tspad);
+
+      item = g_new0 (MpegTSParseQueueItem, 1);
+      item->event = event;
+      mpegts_parse_tspad_enqueue (tspad, item);
+      break;
+  }
+}
+
 static GstFlowReturn
 mpegts_parse_tspad_push_section (MpegTSParse2 * parse, MpegTSParsePad * tspad,
     GstMpegtsSection * section, MpegTSPacketizerPacket * packet,
@@ -725,9 +1116,13 @@ mpegts_parse_tspad_push_section (MpegTSParse2 * parse, MpegTSParsePad * tspad,
       tspad->program_number, section->table_id);
 
   if (to_push) {
-    ret =
-        enqueue_and_maybe_push_buffer (parse, tspad->pad,
-        &tspad->ts_adapter, gst_buffer_ref (buf));
+    if (tspad->threaded)
+      ret = mpegts_parse_tspad_queue_buffer (parse, tspad,
+          gst_buffer_ref (buf), TRUE);
+    else
+      ret =
+          enqueue_and_maybe_push_buffer (parse, tspad->pad,
+          &tspad->ts_adapter, gst_buffer_ref (buf));
   }
 
   GST_LOG_OBJECT (parse, "Returning %s", gst_flow_get_name (ret));
@@ -753,8 +1148,13 @@ mpegts_parse_tspad_push (MpegTSParse2 * parse, MpegTSParsePad * tspad,
     if (packet->pid == bp->pmt_pid || bp->streams == NULL
         || bp->streams[packet->pid]) {
       /* push if there's no filter or if the pid is in the filter */
-      ret = gst_pad_push (tspad->pad, gst_buffer_ref (buf));
-      ret = gst_flow_combiner_update_flow (parse->flowcombiner, ret);
+      if (tspad->threaded) {
+        ret = mpegts_parse_tspad_queue_buffer (parse, tspad,
+            gst_buffer_ref (buf), FALSE);
+      } else {
+        ret = gst_pad_push (tspad->pad, gst_buffer_ref (buf));
+        ret = gst_flow_combiner_update_flow (parse->flowcombiner, ret);
+      }
     }
   }
   GST_DEBUG_OBJECT (parse, "Returning %s", gst_flow_get_name (ret));
@@ -1101,16 +1501,33 @@ empty_pad (GstPad * pad, MpegTSParse2 * parse)
 {
   MpegTSParsePad *tspad = (MpegTSParsePad *) gst_pad_get_element_private (pad);
   GstFlowReturn ret;
+
+  /* the pad thread empties the adapter after each batch */
+  if (tspad->threaded)
+    return;
+
   ret = empty_adapter_into_pad (parse, &tspad->ts_adapter, tspad->pad);
   ret = gst_flow_combiner_update_flow (parse->flowcombiner, ret);
 }
 
+static void
+flush_pad_batch (GstPad * pad, MpegTSParse2 * parse)
+{
+  MpegTSParsePad *tspad = (MpegTSParsePad *) gst_pad_get_element_private (pad);
+
+  if (tspad->threaded)
+    mpegts_parse_tspad_flush_batch (parse, tspad);
+}
+
 static GstFlowReturn
 mpegts_parse_input_done (MpegTSBase * base)
 {
   MpegTSParse2 *parse = GST_MPEGTS_PARSE (base);
   GstFlowReturn ret = GST_FLOW_OK;
 
+  /* Hand the packets of this input buffer over to the program threads */
+  g_list_foreach (parse->srcpads, (GFunc) flush_pad_batch, parse);
+
   if (!prepare_src_pad (base, parse))
     return GST_FLOW_OK;
 
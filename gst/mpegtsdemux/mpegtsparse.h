@@ -86,6 +86,7 @@ struct _MpegTSParse2 {
   MpegTSParse2Adapter ts_adapter;
   guint alignment;
   gboolean split_on_rai;
+  gboolean program_threads;
   gboolean is_eos;
   guint32 header;
 };
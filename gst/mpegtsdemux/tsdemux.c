@@ -31,6 +31,7 @@
 #include "config.h"
 #endif
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -82,6 +83,11 @@
  * up to this size */
 #define MAX_PES_PAYLOAD (32 * 1024 * 1024)
 
+/* Each shared TS payload ends up in its own GstMemory, and a GstBuffer
+ * can't hold more than 16 of them without merging (copying) them */
+#define MAX_SHARED_PACKETS 16
+#define DEFAULT_MAX_SHARED_PACKETS 0
+
 GST_DEBUG_CATEGORY_STATIC (ts_demux_debug);
 #define GST_CAT_DEFAULT ts_demux_debug
 
@@ -117,6 +123,20 @@ typedef struct
   guint64 pts, dts;
 } PendingBuffer;
 
+/* Keyframe index entry */
+typedef struct
+{
+  /* Offset of the first packet of the keyframe PES */
+  guint64 offset;
+  /* Timestamp of the keyframe, as used by mpegts_packetizer_ts_to_offset() */
+  GstClockTime ts;
+  /* TRUE if there is no other keyframe between the previous entry and this
+   * one, i.e. both were recorded without skipping any data in between */
+  gboolean contiguous;
+} TSDemuxIndexEntry;
+
+#define INDEX_FILE_HEADER "tsdemux-index 1\n"
+
 typedef struct _TSDemuxStream TSDemuxStream;
 
 typedef struct _TSDemuxH264ParsingInfos TSDemuxH264ParsingInfos;
@@ -183,6 +203,10 @@ struct _TSDemuxStream
   /* Size of ->data */
   guint allocated_size;
 
+  /* Data being reconstructed by referencing the input memory instead of
+   * copying it into ->data (see the "max-shared-packets" property) */
+  GstBuffer *shared_payload;
+
   /* Current PTS/DTS for this stream (in running time) */
   GstClockTime pts;
   GstClockTime dts;
@@ -297,6 +321,8 @@ enum
   PROP_PROGRAM_NUMBER,
   PROP_EMIT_STATS,
   PROP_LATENCY,
+  PROP_MAX_SHARED_PACKETS,
+  PROP_INDEX_LOCATION,
   /* FILL ME */
 };
 
@@ -364,6 +390,13 @@ gst_ts_demux_dispose (GObject * object)
 
   gst_flow_combiner_free (demux->flowcombiner);
 
+  if (demux->index) {
+    g_array_free (demux->index, TRUE);
+    demux->index = NULL;
+  }
+  g_free (demux->index_location);
+  demux->index_location = NULL;
+
   GST_CALL_PARENT (G_OBJECT_CLASS, dispose, (object));
 }
 
@@ -395,6 +428,41 @@ gst_ts_demux_class_init (GstTSDemuxClass * klass)
           G_MAXINT, DEFAULT_LATENCY,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstTSDemux:max-shared-packets:
+   *
+   * PES payloads spanning up to this number of TS packets are output as
+   * buffers referencing the memory of the input buffers instead of being
+   * copied. Bigger payloads, and payloads that need to be inspected by the
+   * demuxer, are still copied. 0 disables sharing.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_SHARED_PACKETS,
+      g_param_spec_uint ("max-shared-packets", "Maximum shared packets",
+          "Maximum number of TS packets a PES payload can span to be output "
+          "without copying (0 = always copy)", 0, MAX_SHARED_PACKETS,
+          DEFAULT_MAX_SHARED_PACKETS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstTSDemux:index-location:
+   *
+   * Location of a sidecar file in which the keyframe index built while
+   * demuxing in pull mode is stored when going back to READY, and from which
+   * it is loaded when starting. This allows seeking to known keyframes
+   * directly instead of estimating their offset from the bitrate.
+   *
+   * The index is only valid for the stream it was built from.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_INDEX_LOCATION,
+      g_param_spec_string ("index-location", "Index location",
+          "Location of the file in which to store and load the keyframe index "
+          "(NULL = don't store the index)", NULL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   element_class = GST_ELEMENT_CLASS (klass);
   gst_element_class_add_pad_template (element_class,
       gst_static_pad_template_get (&video_template));
@@ -428,6 +496,193 @@ gst_ts_demux_class_init (GstTSDemuxClass * klass)
   ts_class->drain = GST_DEBUG_FUNCPTR (gst_ts_demux_drain);
 }
 
+/* Returns the position of the first entry with an offset >= @offset */
+static guint
+gst_ts_demux_index_find_position (GstTSDemux * demux, guint64 offset)
+{
+  guint lo = 0, hi = demux->index->len;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    if (g_array_index (demux->index, TSDemuxIndexEntry, mid).offset < offset)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+static void
+gst_ts_demux_index_add (GstTSDemux * demux, GstClockTime ts, guint64 offset)
+{
+  TSDemuxIndexEntry *entry;
+  guint pos;
+
+  pos = gst_ts_demux_index_find_position (demux, offset);
+  if (pos == demux->index->len
+      || g_array_index (demux->index, TSDemuxIndexEntry, pos).offset != offset) {
+    TSDemuxIndexEntry new_entry = { offset, ts, FALSE };
+
+    GST_LOG_OBJECT (demux, "Adding keyframe %" GST_TIME_FORMAT " at offset %"
+        G_GUINT64_FORMAT " to index", GST_TIME_ARGS (ts), offset);
+    g_array_insert_val (demux->index, pos, new_entry);
+    demux->index_dirty = TRUE;
+  }
+
+  entry = &g_array_index (demux->index, TSDemuxIndexEntry, pos);
+  if (!entry->contiguous && demux->index_last != -1
+      && demux->index_last == (gint) pos - 1) {
+    entry->contiguous = TRUE;
+    demux->index_dirty = TRUE;
+  }
+  demux->index_last = pos;
+}
+
+/* Returns the last keyframe at or before @ts if the index is known to be
+ * complete around @ts, else NULL */
+static const TSDemuxIndexEntry *
+gst_ts_demux_index_lookup (GstTSDemux * demux, GstClockTime ts)
+{
+  const TSDemuxIndexEntry *next;
+  guint lo = 0, hi = demux->index->len;
+
+  /* Keyframe timestamps increase with their offset, look for the first
+   * entry after @ts */
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    if (g_array_index (demux->index, TSDemuxIndexEntry, mid).ts <= ts)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  if (lo == 0 || lo == demux->index->len)
+    return NULL;
+
+  /* If data between the two keyframes was skipped, there might be another
+   * keyframe we don't know about in there */
+  next = &g_array_index (demux->index, TSDemuxIndexEntry, lo);
+  if (!next->contiguous)
+    return NULL;
+
+  return &g_array_index (demux->index, TSDemuxIndexEntry, lo - 1);
+}
+
+/* Returns the last keyframe before @offset, or NULL */
+static const TSDemuxIndexEntry *
+gst_ts_demux_index_find_before (GstTSDemux * demux, guint64 offset)
+{
+  guint pos = gst_ts_demux_index_find_position (demux, offset);
+
+  if (pos == 0)
+    return NULL;
+
+  return &g_array_index (demux->index, TSDemuxIndexEntry, pos - 1);
+}
+
+static void
+gst_ts_demux_index_save (GstTSDemux * demux)
+{
+  GString *str;
+  GError *err = NULL;
+  guint i;
+
+  str = g_string_new (INDEX_FILE_HEADER);
+  for (i = 0; i < demux->index->len; i++) {
+    TSDemuxIndexEntry *entry =
+        &g_array_index (demux->index, TSDemuxIndexEntry, i);
+    g_string_append_printf (str, "%" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT
+        " %d\n", entry->offset, entry->ts, entry->contiguous ? 1 : 0);
+  }
+
+  if (!g_file_set_contents (demux->index_location, str->str, str->len, &err)) {
+    GST_WARNING_OBJECT (demux, "Could not write index to %s: %s",
+        demux->index_location, err->message);
+    g_clear_error (&err);
+  } else {
+    GST_DEBUG_OBJECT (demux, "Wrote %u index entries to %s", demux->index->len,
+        demux->index_location);
+    demux->index_dirty = FALSE;
+  }
+
+  g_string_free (str, TRUE);
+}
+
+static void
+gst_ts_demux_index_load (GstTSDemux * demux)
+{
+  gchar *contents, **lines;
+  GError *err = NULL;
+  guint i;
+
+  if (!g_file_get_contents (demux->index_location, &contents, NULL, &err)) {
+    GST_DEBUG_OBJECT (demux, "No index loaded from %s: %s",
+        demux->index_location, err->message);
+    g_clear_error (&err);
+    return;
+  }
+
+  if (!g_str_has_prefix (contents, INDEX_FILE_HEADER)) {
+    GST_WARNING_OBJECT (demux, "%s is not a tsdemux index",
+        demux->index_location);
+    g_free (contents);
+    return;
+  }
+
+  lines = g_strsplit (contents + strlen (INDEX_FILE_HEADER), "\n", -1);
+  for (i = 0; lines[i]; i++) {
+    TSDemuxIndexEntry entry;
+    guint64 offset, ts;
+    gint contiguous;
+
+    if (sscanf (lines[i], "%" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT " %d",
+            &offset, &ts, &contiguous) != 3)
+      continue;
+
+    /* Only accept correctly sorted entries */
+    if (demux->index->len && offset <= g_array_index (demux->index,
+            TSDemuxIndexEntry, demux->index->len - 1).offset)
+      continue;
+
+    entry.offset = offset;
+    entry.ts = ts;
+    entry.contiguous = contiguous != 0;
+    g_array_append_val (demux->index, entry);
+  }
+  g_strfreev (lines);
+  g_free (contents);
+
+  GST_DEBUG_OBJECT (demux, "Loaded %u index entries from %s",
+      demux->index->len, demux->index_location);
+}
+
+static void
+gst_ts_demux_index_record (GstTSDemux * demux, TSDemuxStream * stream,
+    guint64 offset)
+{
+  MpegTSBase *base = (MpegTSBase *) demux;
+  MpegTSBaseStream *bs = (MpegTSBaseStream *) stream;
+  GstClockTime ts;
+
+  /* Offsets are only meaningful to us in pull mode */
+  if (base->mode != BASE_MODE_STREAMING
+      || stream->state != PENDING_PACKET_BUFFER)
+    return;
+
+  if (!(gst_stream_get_stream_type (bs->stream_object) &
+          GST_STREAM_TYPE_VIDEO))
+    return;
+
+  ts = GST_CLOCK_TIME_IS_VALID (stream->pts) ? stream->pts : stream->dts;
+  if (!GST_CLOCK_TIME_IS_VALID (ts))
+    return;
+
+  gst_ts_demux_index_add (demux, ts, offset);
+}
+
 static void
 gst_ts_demux_reset (MpegTSBase * base)
 {
@@ -449,6 +704,19 @@ gst_ts_demux_reset (MpegTSBase * base)
     demux->previous_program = NULL;
   }
 
+  mpegts_base_pid_filter_clear (base);
+
+  /* reset gets called from the base class init, before our own init */
+  if (demux->index) {
+    if (demux->index_dirty && demux->index_location)
+      gst_ts_demux_index_save (demux);
+    g_array_set_size (demux->index, 0);
+    demux->index_last = -1;
+    demux->index_dirty = FALSE;
+    if (demux->index_location)
+      gst_ts_demux_index_load (demux);
+  }
+
   demux->have_group_id = FALSE;
   demux->group_id = G_MAXUINT;
 
@@ -465,11 +733,15 @@ gst_ts_demux_init (GstTSDemux * demux)
   base->parse_private_sections = TRUE;
   /* We are not interested in sections (all handled by mpegtsbase) */
   base->push_section = FALSE;
+  base->filter_pids = TRUE;
 
   demux->flowcombiner = gst_flow_combiner_new ();
   demux->requested_program_number = -1;
   demux->program_number = -1;
   demux->latency = DEFAULT_LATENCY;
+  demux->max_shared_packets = DEFAULT_MAX_SHARED_PACKETS;
+  demux->index = g_array_new (FALSE, FALSE, sizeof (TSDemuxIndexEntry));
+  demux->index_last = -1;
   gst_ts_demux_reset (base);
 }
 
@@ -492,6 +764,13 @@ gst_ts_demux_set_property (GObject * object, guint prop_id,
     case PROP_LATENCY:
       demux->latency = g_value_get_int (value);
       break;
+    case PROP_MAX_SHARED_PACKETS:
+      demux->max_shared_packets = g_value_get_uint (value);
+      break;
+    case PROP_INDEX_LOCATION:
+      g_free (demux->index_location);
+      demux->index_location = g_value_dup_string (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -513,6 +792,12 @@ gst_ts_demux_get_property (GObject * object, guint prop_id,
     case PROP_LATENCY:
       g_value_set_int (value, demux->latency);
       break;
+    case PROP_MAX_SHARED_PACKETS:
+      g_value_set_uint (value, demux->max_shared_packets);
+      break;
+    case PROP_INDEX_LOCATION:
+      g_value_set_string (value, demux->index_location);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -905,14 +1190,23 @@ gst_ts_demux_do_seek (MpegTSBase * base, GstEvent * event)
   /* If the position actually changed, update == TRUE */
   if (update) {
     GstClockTime target = seeksegment.start;
+    const TSDemuxIndexEntry *entry;
     if (target >= SEEK_TIMESTAMP_OFFSET)
       target -= SEEK_TIMESTAMP_OFFSET;
     else
       target = 0;
 
-    start_offset =
-        mpegts_packetizer_ts_to_offset (base->packetizer, target,
-        demux->program->pcr_pid);
+    entry = gst_ts_demux_index_lookup (demux, seeksegment.start);
+    if (entry) {
+      GST_DEBUG_OBJECT (demux, "Seeking to indexed keyframe %" GST_TIME_FORMAT
+          " at offset %" G_GUINT64_FORMAT, GST_TIME_ARGS (entry->ts),
+          entry->offset);
+      start_offset = entry->offset;
+    } else {
+      start_offset =
+          mpegts_packetizer_ts_to_offset (base->packetizer, target,
+          demux->program->pcr_pid);
+    }
     if (G_UNLIKELY (start_offset == -1)) {
       GST_WARNING ("Couldn't convert start position to an offset");
       goto done;
@@ -1985,6 +2279,7 @@ gst_ts_demux_stream_flush (TSDemuxStream * stream, GstTSDemux * tsdemux,
 
   g_free (stream->data);
   stream->data = NULL;
+  gst_buffer_replace (&stream->shared_payload, NULL);
   stream->state = PENDING_PACKET_EMPTY;
   stream->expected_size = 0;
   stream->allocated_size = 0;
@@ -2054,6 +2349,12 @@ gst_ts_demux_update_program (MpegTSBase * base, MpegTSBaseProgram * program)
   GList *tmp;
 
   GST_DEBUG ("Updating program %d", program->program_number);
+
+  if (program == demux->program) {
+    mpegts_base_pid_filter_clear (base);
+    mpegts_base_pid_filter_add_program (base, program);
+  }
+
   /* Emit collection message */
   gst_element_post_message ((GstElement *) base,
       gst_message_new_stream_collection ((GstObject *) base,
@@ -2094,6 +2395,10 @@ gst_ts_demux_program_started (MpegTSBase * base, MpegTSBaseProgram * program)
     demux->program_number = program->program_number;
     demux->program = program;
 
+    /* We only ever output one program, ignore all others */
+    mpegts_base_pid_filter_clear (base);
+    mpegts_base_pid_filter_add_program (base, program);
+
     /* Increment the program_generation counter */
     demux->program_generation = (demux->program_generation + 1) & 0xf;
 
@@ -2174,6 +2479,7 @@ gst_ts_demux_program_stopped (MpegTSBase * base, MpegTSBaseProgram * program)
   if (demux->program == program) {
     demux->program = NULL;
     demux->program_number = -1;
+    mpegts_base_pid_filter_clear (base);
   }
 }
 
@@ -2384,6 +2690,72 @@ check_pending_buffers (GstTSDemux * demux)
   return TRUE;
 }
 
+/* Whether the payload of the PES being collected can reference the input
+ * memory instead of being copied. That's not possible if the demuxer needs
+ * to inspect or rewrite the payload before pushing it */
+static inline gboolean
+gst_ts_demux_stream_can_share_payload (GstTSDemux * demux,
+    TSDemuxStream * stream)
+{
+  MpegTSBaseStream *bs = (MpegTSBaseStream *) stream;
+
+  if (demux->max_shared_packets == 0 || stream->needs_keyframe)
+    return FALSE;
+
+  switch (bs->stream_type) {
+    case GST_MPEGTS_STREAM_TYPE_VIDEO_JP2K:
+    case GST_MPEGTS_STREAM_TYPE_AUDIO_AAC_ADTS:
+      return FALSE;
+    case GST_MPEGTS_STREAM_TYPE_PRIVATE_PES_PACKETS:
+      return bs->registration_id != DRF_ID_OPUS;
+    default:
+      return TRUE;
+  }
+}
+
+/* Copy the shared payload into ->data, from which collection then goes on */
+static void
+gst_ts_demux_stream_unshare_payload (TSDemuxStream * stream)
+{
+  g_assert (stream->data == NULL);
+
+  stream->allocated_size =
+      MAX (8192, MAX (stream->expected_size, stream->current_size));
+  stream->data = g_malloc (stream->allocated_size);
+  gst_buffer_extract (stream->shared_payload, 0, stream->data,
+      stream->current_size);
+  gst_buffer_unref (stream->shared_payload);
+  stream->shared_payload = NULL;
+}
+
+/* Append @size bytes at @data (which point into the current packet) to the
+ * shared payload. Returns FALSE if that would make the payload span too many
+ * packets, in which case nothing is appended */
+static gboolean
+gst_ts_demux_stream_share_payload (GstTSDemux * demux, TSDemuxStream * stream,
+    guint8 * data, guint size)
+{
+  GstBuffer *region;
+
+  region =
+      mpegts_packetizer_get_mapped_region (MPEG_TS_BASE_PACKETIZER (demux),
+      data, size);
+  if (G_UNLIKELY (region == NULL))
+    return FALSE;
+
+  if (gst_buffer_n_memory (stream->shared_payload) +
+      gst_buffer_n_memory (region) > demux->max_shared_packets) {
+    GST_LOG ("PES payload spans too many packets, copying it");
+    gst_buffer_unref (region);
+    return FALSE;
+  }
+
+  stream->shared_payload = gst_buffer_append (stream->shared_payload, region);
+  stream->current_size += size;
+
+  return TRUE;
+}
+
 static void
 gst_ts_demux_parse_pes_header (GstTSDemux * demux, TSDemuxStream * stream,
     guint8 * data, guint32 length, guint64 bufferoffset)
@@ -2449,6 +2821,21 @@ gst_ts_demux_parse_pes_header (GstTSDemux * demux, TSDemuxStream * stream,
     stream->allocated_size = MAX (8192, length);
 
   g_assert (stream->data == NULL);
+  g_assert (stream->shared_payload == NULL);
+
+  if (gst_ts_demux_stream_can_share_payload (demux, stream)) {
+    stream->shared_payload = gst_buffer_new ();
+    stream->current_size = 0;
+    stream->state = PENDING_PACKET_BUFFER;
+    if (length && !gst_ts_demux_stream_share_payload (demux, stream, data,
+            length)) {
+      gst_ts_demux_stream_unshare_payload (stream);
+      memcpy (stream->data, data, length);
+      stream->current_size = length;
+    }
+    return;
+  }
+
   stream->data = g_malloc (stream->allocated_size);
   memcpy (stream->data, data, length);
   stream->current_size = length;
@@ -2493,6 +2880,7 @@ gst_ts_demux_queue_data (GstTSDemux * demux, TSDemuxStream * stream,
           g_free (stream->data);
           stream->data = NULL;
         }
+        gst_buffer_replace (&stream->shared_payload, NULL);
         stream->state = PENDING_PACKET_HEADER;
       } else {
         GST_WARNING ("CONTINUITY: Mismatch packet %d, stream %d",
@@ -2525,6 +2913,11 @@ gst_ts_demux_queue_data (GstTSDemux * demux, TSDemuxStream * stream,
     case PENDING_PACKET_BUFFER:
     {
       GST_LOG ("BUFFER: appending data");
+      if (stream->shared_payload) {
+        if (gst_ts_demux_stream_share_payload (demux, stream, data, size))
+          break;
+        gst_ts_demux_stream_unshare_payload (stream);
+      }
       if (G_UNLIKELY (stream->current_size + size > stream->allocated_size)) {
         GST_LOG ("resizing buffer");
         do {
@@ -2543,6 +2936,7 @@ gst_ts_demux_queue_data (GstTSDemux * demux, TSDemuxStream * stream,
         g_free (stream->data);
         stream->data = NULL;
       }
+      gst_buffer_replace (&stream->shared_payload, NULL);
       stream->continuity_counter = CONTINUITY_UNSET;
       break;
     }
@@ -3060,7 +3454,7 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
       "stream:%p, pid:0x%04x stream_type:%d state:%d", stream, bs->pid,
       bs->stream_type, stream->state);
 
-  if (G_UNLIKELY (stream->data == NULL)) {
+  if (G_UNLIKELY (stream->data == NULL && stream->shared_payload == NULL)) {
     GST_LOG ("stream->data == NULL");
     goto beach;
   }
@@ -3081,6 +3475,11 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
     goto beach;
   }
 
+  /* We might have started looking for a keyframe since this PES started */
+  if (stream->shared_payload
+      && !gst_ts_demux_stream_can_share_payload (demux, stream))
+    gst_ts_demux_stream_unshare_payload (stream);
+
   if (stream->needs_keyframe) {
     MpegTSBase *base = (MpegTSBase *) demux;
 
@@ -3117,10 +3516,19 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
       stream->seeked_dts = stream->dts;
       stream->needs_keyframe = FALSE;
     } else {
-      base->seek_offset = demux->last_seek_offset - 200 * base->packetsize;
-      if (demux->last_seek_offset < 200 * base->packetsize)
-        base->seek_offset = 0;
+      const TSDemuxIndexEntry *entry;
+
+      /* Go straight to the previous known keyframe if we have one */
+      entry = gst_ts_demux_index_find_before (demux, demux->last_seek_offset);
+      if (entry) {
+        base->seek_offset = entry->offset;
+      } else {
+        base->seek_offset = demux->last_seek_offset - 200 * base->packetsize;
+        if (demux->last_seek_offset < 200 * base->packetsize)
+          base->seek_offset = 0;
+      }
       demux->last_seek_offset = base->seek_offset;
+      demux->index_last = -1;
       mpegts_packetizer_flush (base->packetizer, FALSE);
       base->mode = BASE_MODE_SEEKING;
 
@@ -3155,6 +3563,9 @@ gst_ts_demux_push_pending_data (GstTSDemux * demux, TSDemuxStream * stream,
         res = GST_FLOW_ERROR;
         goto beach;
       }
+    } else if (stream->shared_payload) {
+      buffer = stream->shared_payload;
+      stream->shared_payload = NULL;
     } else {
       buffer = gst_buffer_new_wrapped (stream->data, stream->current_size);
     }
@@ -3305,6 +3716,7 @@ beach:
   /* Reset the PES payload collection, but don't clear the state,
    * we might want to keep collecting this PES */
   GST_LOG ("Cleared PES data. returning %s", gst_flow_get_name (res));
+  gst_buffer_replace (&stream->shared_payload, NULL);
   if (stream->expected_size) {
     if (stream->current_size > stream->expected_size)
       stream->expected_size = 0;
@@ -3341,6 +3753,11 @@ gst_ts_demux_handle_packet (GstTSDemux * demux, TSDemuxStream * stream,
     gst_ts_demux_queue_data (demux, stream, packet);
     GST_LOG ("current_size:%d, expected_size:%d",
         stream->current_size, stream->expected_size);
+
+    /* Record keyframes flagged as random access points in the index */
+    if (G_UNLIKELY (packet->payload_unit_start_indicator &&
+            (packet->afc_flags & MPEGTS_AFC_RANDOM_ACCESS_FLAG)))
+      gst_ts_demux_index_record (demux, stream, packet->offset);
     /* Finally check if the data we queued completes a packet, or got too
      * large and needs output now */
     if ((stream->expected_size && stream->current_size >= stream->expected_size)
@@ -3365,6 +3782,7 @@ gst_ts_demux_flush (MpegTSBase * base, gboolean hard)
   GstTSDemux *demux = GST_TS_DEMUX_CAST (base);
 
   gst_ts_demux_flush_streams (demux, hard);
+  demux->index_last = -1;
 
   if (demux->segment_event) {
     gst_event_unref (demux->segment_event);
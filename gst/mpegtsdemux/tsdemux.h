@@ -77,6 +77,7 @@ struct _GstTSDemux
   guint program_number;
   gboolean emit_statistics;
   gint latency; /* latency in ms */
+  guint max_shared_packets;
 
   /*< private >*/
   gint program_generation; /* Incremented each time we switch program 0..15 */
@@ -101,6 +102,14 @@ struct _GstTSDemux
 
   /* Used when seeking for a keyframe to go backward in the stream */
   guint64 last_seek_offset;
+
+  /* Keyframe time/offset index (TSDemuxIndexEntry), sorted by offset */
+  GArray *index;
+  /* Position in index of the last recorded keyframe if nothing was skipped
+   * since, else -1 */
+  gint index_last;
+  gboolean index_dirty;
+  gchar *index_location;
 };
 
 struct _GstTSDemuxClass
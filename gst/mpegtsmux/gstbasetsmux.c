@@ -200,10 +200,15 @@ enum
   PROP_BITRATE,
   PROP_PCR_INTERVAL,
   PROP_SCTE_35_PID,
-  PROP_SCTE_35_NULL_INTERVAL
+  PROP_SCTE_35_NULL_INTERVAL,
+  PROP_PACKETS_PER_BUFFER
 };
 
 #define DEFAULT_SCTE_35_PID 0
+#define DEFAULT_PACKETS_PER_BUFFER 0
+
+/* Number of retired packet slabs kept around for reuse */
+#define MAX_RETIRED_PACKET_SLABS 8
 
 #define BASETSMUX_DEFAULT_ALIGNMENT    -1
 
@@ -308,6 +313,21 @@ steal_si_section (GstMpegtsSectionType * type, TsMuxSection * section,
   return TRUE;
 }
 
+static void
+gst_base_ts_mux_clear_packet_slabs (GstBaseTsMux * mux)
+{
+  GstMemory *slab;
+
+  if (mux->packet_slab) {
+    gst_memory_unref (mux->packet_slab);
+    mux->packet_slab = NULL;
+  }
+  mux->packet_slab_offset = 0;
+
+  while ((slab = g_queue_pop_head (&mux->packet_slabs)))
+    gst_memory_unref (slab);
+}
+
 static void
 gst_base_ts_mux_reset (GstBaseTsMux * mux, gboolean alloc)
 {
@@ -329,6 +349,8 @@ gst_base_ts_mux_reset (GstBaseTsMux * mux, gboolean alloc)
   if (mux->out_adapter)
     gst_adapter_clear (mux->out_adapter);
 
+  gst_base_ts_mux_clear_packet_slabs (mux);
+
   if (mux->tsmux) {
     if (mux->tsmux->si_sections)
       si_sections = g_hash_table_ref (mux->tsmux->si_sections);
@@ -922,9 +944,18 @@ gst_base_ts_mux_push_packets (GstBaseTsMux * mux, gboolean force)
     GstClockTime pts;
 
     pts = gst_adapter_prev_pts (mux->out_adapter, NULL);
-    buf = gst_adapter_take_buffer (mux->out_adapter, align);
+    /* Pooled packets are consecutive regions of the same slab, keep them as
+     * separate memories so they can be merged again without copying */
+    if (mux->packets_per_buffer > 0)
+      buf = gst_adapter_take_buffer_fast (mux->out_adapter, align);
+    else
+      buf = gst_adapter_take_buffer (mux->out_adapter, align);
 
     GST_BUFFER_PTS (buf) = pts;
+    if (mux->bitrate)
+      GST_BUFFER_DURATION (buf) =
+          gst_util_uint64_scale (align / packet_size *
+          GST_BASE_TS_MUX_NORMAL_PACKET_LENGTH * 8, GST_SECOND, mux->bitrate);
 
     gst_buffer_list_add (buffer_list, buf);
     av -= align;
@@ -1057,7 +1088,9 @@ new_packet_cb (GstBuffer * buf, void *user_data, gint64 new_pcr)
 
   g_assert (klass->output_packet);
 
-  gst_buffer_map (buf, &map, GST_MAP_READWRITE);
+  /* Only the header is needed, and mapping the whole packet would merge the
+   * header and a shared payload back into a copy */
+  gst_buffer_map_range (buf, 0, 1, &map, GST_MAP_READ);
 
   if (!GST_CLOCK_TIME_IS_VALID (GST_BUFFER_PTS (buf)))
     GST_BUFFER_PTS (buf) = mux->last_ts;
@@ -1233,8 +1266,9 @@ gst_base_ts_mux_aggregate_buffer (GstBaseTsMux * mux,
   GST_DEBUG_OBJECT (mux, "delta: %d", delta);
 
   stream_data = stream_data_new (buf);
-  tsmux_stream_add_data (best->stream, stream_data->map_info.data,
-      stream_data->map_info.size, stream_data, pts, dts, !delta);
+  tsmux_stream_add_buffer (best->stream, stream_data->buffer,
+      stream_data->map_info.data, stream_data->map_info.size, stream_data, pts,
+      dts, !delta);
 
   /* outgoing ts follows ts of PCR program stream */
   if (prog->pcr_stream == best->stream) {
@@ -1850,6 +1884,9 @@ gst_base_ts_mux_set_property (GObject * object, guint prop_id,
     case PROP_SCTE_35_NULL_INTERVAL:
       mux->scte35_null_interval = g_value_get_uint (value);
       break;
+    case PROP_PACKETS_PER_BUFFER:
+      mux->packets_per_buffer = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1890,6 +1927,9 @@ gst_base_ts_mux_get_property (GObject * object, guint prop_id,
     case PROP_SCTE_35_NULL_INTERVAL:
       g_value_set_uint (value, mux->scte35_null_interval);
       break;
+    case PROP_PACKETS_PER_BUFFER:
+      g_value_set_uint (value, mux->packets_per_buffer);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1908,17 +1948,82 @@ gst_base_ts_mux_default_create_ts_mux (GstBaseTsMux * mux)
   tsmux_set_si_interval (tsmux, mux->si_interval);
   tsmux_set_bitrate (tsmux, mux->bitrate);
   tsmux_set_pcr_interval (tsmux, mux->pcr_interval);
+  /* M2TS subclasses prepend a timestamp in place, which needs a single
+   * contiguous packet */
+  tsmux_set_share_payload (tsmux,
+      mux->packet_size == GST_BASE_TS_MUX_NORMAL_PACKET_LENGTH);
 
   return tsmux;
 }
 
+static GstMemory *
+gst_base_ts_mux_get_packet_slab (GstBaseTsMux * mux, gsize size)
+{
+  GList *l;
+
+  /* Reuse a retired slab once downstream released all packets carved out
+   * of it, in which case we hold the only remaining reference */
+  for (l = mux->packet_slabs.head; l; l = l->next) {
+    GstMemory *slab = l->data;
+
+    if (GST_MINI_OBJECT_REFCOUNT_VALUE (slab) == 1 && slab->size == size) {
+      g_queue_delete_link (&mux->packet_slabs, l);
+      return slab;
+    }
+  }
+
+  GST_LOG_OBJECT (mux, "allocating new packet slab of %" G_GSIZE_FORMAT
+      " bytes", size);
+
+  return gst_allocator_alloc (NULL, size, NULL);
+}
+
+static GstBuffer *
+gst_base_ts_mux_carve_packet (GstBaseTsMux * mux, guint packets_per_buffer)
+{
+  gsize slab_size = packets_per_buffer * mux->packet_size;
+  GstMemory *mem;
+  GstBuffer *buf;
+
+  if (mux->packet_slab && (mux->packet_slab->size != slab_size ||
+          mux->packet_slab_offset + mux->packet_size > slab_size)) {
+    g_queue_push_tail (&mux->packet_slabs, mux->packet_slab);
+    mux->packet_slab = NULL;
+
+    if (mux->packet_slabs.length > MAX_RETIRED_PACKET_SLABS)
+      gst_memory_unref (g_queue_pop_head (&mux->packet_slabs));
+  }
+
+  if (!mux->packet_slab) {
+    mux->packet_slab = gst_base_ts_mux_get_packet_slab (mux, slab_size);
+    mux->packet_slab_offset = 0;
+  }
+
+  mem = gst_memory_share (mux->packet_slab, mux->packet_slab_offset,
+      mux->packet_size);
+  mux->packet_slab_offset += mux->packet_size;
+
+  /* Shared memory is read-only by default, but packets never overlap so
+   * each of them can safely be written on its own */
+  GST_MINI_OBJECT_FLAG_UNSET (mem, GST_MINI_OBJECT_FLAG_LOCK_READONLY);
+
+  buf = gst_buffer_new ();
+  gst_buffer_append_memory (buf, mem);
+
+  return buf;
+}
+
 static void
 gst_base_ts_mux_default_allocate_packet (GstBaseTsMux * mux,
     GstBuffer ** buffer)
 {
   GstBuffer *buf;
+  guint packets_per_buffer = mux->packets_per_buffer;
 
-  buf = gst_buffer_new_and_alloc (mux->packet_size);
+  if (packets_per_buffer > 0)
+    buf = gst_base_ts_mux_carve_packet (mux, packets_per_buffer);
+  else
+    buf = gst_buffer_new_and_alloc (mux->packet_size);
 
   *buffer = buf;
 }
@@ -1938,6 +2043,10 @@ void
 gst_base_ts_mux_set_packet_size (GstBaseTsMux * mux, gsize size)
 {
   mux->packet_size = size;
+
+  if (mux->tsmux)
+    tsmux_set_share_payload (mux->tsmux,
+        size == GST_BASE_TS_MUX_NORMAL_PACKET_LENGTH);
 }
 
 void
@@ -2042,6 +2151,23 @@ gst_base_ts_mux_class_init (GstBaseTsMuxClass * klass)
           TSMUX_DEFAULT_SCTE_35_NULL_INTERVAL,
           (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
+  /**
+   * GstBaseTsMux:packets-per-buffer:
+   *
+   * Number of packets carved out of each pooled output buffer. Packets are
+   * then allocated from a few recycled large buffers instead of one by one.
+   * 0 allocates every packet separately.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass),
+      PROP_PACKETS_PER_BUFFER, g_param_spec_uint ("packets-per-buffer",
+          "Packets per buffer",
+          "Number of packets carved out of each pooled buffer "
+          "(0 = allocate each packet separately)", 0, 4096,
+          DEFAULT_PACKETS_PER_BUFFER,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
   gst_element_class_add_static_pad_template_with_gtype (gstelement_class,
       &gst_base_ts_mux_src_factory, GST_TYPE_AGGREGATOR_PAD);
 
@@ -2063,6 +2189,7 @@ gst_base_ts_mux_init (GstBaseTsMux * mux)
   mux->bitrate = TSMUX_DEFAULT_BITRATE;
   mux->scte35_pid = DEFAULT_SCTE_35_PID;
   mux->scte35_null_interval = TSMUX_DEFAULT_SCTE_35_NULL_INTERVAL;
+  mux->packets_per_buffer = DEFAULT_PACKETS_PER_BUFFER;
 
   mux->packet_size = GST_BASE_TS_MUX_NORMAL_PACKET_LENGTH;
   mux->automatic_alignment = 0;
@@ -176,6 +176,7 @@ struct GstBaseTsMux {
   guint pcr_interval;
   guint scte35_pid;
   guint scte35_null_interval;
+  guint packets_per_buffer;
 
   /* state */
   gboolean first;
@@ -197,6 +198,11 @@ struct GstBaseTsMux {
   /* output buffer aggregation */
   GstAdapter *out_adapter;
   GstBuffer *out_buffer;
+
+  /* pooled packet allocation */
+  GstMemory *packet_slab;
+  gsize packet_slab_offset;
+  GQueue packet_slabs;
 };
 
 /**
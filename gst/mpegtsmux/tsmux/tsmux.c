@@ -106,6 +106,10 @@
  * 1/8 second atm */
 #define TSMUX_PCR_OFFSET (TSMUX_CLOCK_FREQ / 8)
 
+/* Offset in a packet of the byte containing the last bit of the PCR base,
+ * when the PCR is written in the adaptation field */
+#define TSMUX_PCR_BYTE_OFFSET 10
+
 /* Base for all written PCR and DTS/PTS,
  * so we have some slack to go backwards */
 #define CLOCK_BASE (TSMUX_CLOCK_FREQ * 10 * 360)
@@ -800,9 +804,18 @@ tsmux_packet_out (TsMux * mux, GstBuffer * buf, gint64 pcr)
     return TRUE;
   }
 
-  if (mux->bitrate)
-    GST_BUFFER_PTS (buf) =
-        gst_util_uint64_scale (mux->n_bytes * 8, GST_SECOND, mux->bitrate);
+  if (mux->bitrate) {
+    GstClockTime pts, end;
+
+    /* Pace the output at the configured rate, so that a sink can send each
+     * packet at the time it is expected to arrive */
+    pts = gst_util_uint64_scale (mux->n_bytes * 8, GST_SECOND, mux->bitrate);
+    end = gst_util_uint64_scale ((mux->n_bytes + TSMUX_PACKET_LENGTH) * 8,
+        GST_SECOND, mux->bitrate);
+
+    GST_BUFFER_PTS (buf) = pts;
+    GST_BUFFER_DURATION (buf) = end - pts;
+  }
 
   mux->n_bytes += gst_buffer_get_size (buf);
 
@@ -1238,6 +1251,13 @@ tsmux_write_null_ts_header (guint8 * buf)
   *buf++ = 0x10;
 }
 
+static void
+tsmux_write_null_packet (guint8 * buf)
+{
+  tsmux_write_null_ts_header (buf);
+  memset (buf + TSMUX_HEADER_LENGTH, 0xff, TSMUX_PAYLOAD_LENGTH);
+}
+
 static gint64
 ts_to_pcr (gint64 ts)
 {
@@ -1248,8 +1268,10 @@ ts_to_pcr (gint64 ts)
   return (ts - TSMUX_PCR_OFFSET) * (TSMUX_SYS_CLOCK_FREQ / TSMUX_CLOCK_FREQ);
 }
 
+/* With a fixed bitrate, the PCR of a packet is derived from the position in
+ * the output of its @offset'th byte, with 27 MHz precision */
 static gint64
-get_current_pcr (TsMux * mux, gint64 cur_ts)
+get_pcr_at_offset (TsMux * mux, gint64 cur_ts, guint offset)
 {
   if (!mux->bitrate)
     return ts_to_pcr (cur_ts);
@@ -1260,22 +1282,49 @@ get_current_pcr (TsMux * mux, gint64 cur_ts)
   }
 
   return ts_to_pcr (mux->first_pcr_ts) +
-      gst_util_uint64_scale (mux->n_bytes * 8, TSMUX_SYS_CLOCK_FREQ,
-      mux->bitrate);
+      gst_util_uint64_scale_round ((mux->n_bytes + offset) * 8,
+      TSMUX_SYS_CLOCK_FREQ, mux->bitrate);
+}
+
+static gint64
+get_current_pcr (TsMux * mux, gint64 cur_ts)
+{
+  return get_pcr_at_offset (mux, cur_ts, 0);
+}
+
+/* The PCR is the time at which the byte containing the last bit of
+ * program_clock_reference_base arrives (ISO/IEC 13818-1 2.4.2.2) */
+static gint64
+get_packet_pcr (TsMux * mux, gint64 cur_ts)
+{
+  return get_pcr_at_offset (mux, cur_ts, TSMUX_PCR_BYTE_OFFSET);
+}
+
+static gboolean
+pcr_is_due (TsMux * mux, TsMuxStream * stream, gint64 cur_pcr)
+{
+  gint64 interval = mux->pcr_interval * 300;
+
+  if (stream->next_pcr != -1 && cur_pcr <= stream->next_pcr)
+    return FALSE;
+
+  /* Don't try to catch up on PCRs we missed, that would only end up
+   * in a burst of them */
+  if (stream->next_pcr == -1 || cur_pcr - stream->next_pcr > interval)
+    stream->next_pcr = cur_pcr + interval;
+  else
+    stream->next_pcr += interval;
+
+  return TRUE;
 }
 
 static gint64
 write_new_pcr (TsMux * mux, TsMuxStream * stream, gint64 cur_pcr)
 {
-  if (stream->next_pcr == -1 || cur_pcr > stream->next_pcr) {
+  if (pcr_is_due (mux, stream, cur_pcr)) {
     stream->pi.flags |=
         TSMUX_PACKET_FLAG_ADAPTATION | TSMUX_PACKET_FLAG_WRITE_PCR;
     stream->pi.pcr = cur_pcr;
-
-    if (stream->next_pcr == -1)
-      stream->next_pcr = cur_pcr + mux->pcr_interval * 300;
-    else
-      stream->next_pcr += mux->pcr_interval * 300;
   } else {
     cur_pcr = -1;
   }
@@ -1283,6 +1332,61 @@ write_new_pcr (TsMux * mux, TsMuxStream * stream, gint64 cur_pcr)
   return cur_pcr;
 }
 
+/* Write an adaptation field only packet carrying a PCR on @stream's PID */
+static gboolean
+tsmux_write_pcr_packet (TsMux * mux, TsMuxStream * stream, gint64 pcr)
+{
+  TsMuxPacketInfo pi = { 0, };
+  guint payload_len, payload_offs;
+  GstBuffer *buf = NULL;
+  GstMapInfo map;
+
+  pi.pid = stream->pi.pid;
+  pi.flags = TSMUX_PACKET_FLAG_ADAPTATION | TSMUX_PACKET_FLAG_WRITE_PCR;
+  pi.pcr = pcr;
+
+  if (!tsmux_get_buffer (mux, &buf))
+    return FALSE;
+
+  gst_buffer_map (buf, &map, GST_MAP_READ);
+  tsmux_write_ts_header (mux, map.data, &pi, &payload_len, &payload_offs, 0);
+  gst_buffer_unmap (buf, &map);
+
+  return tsmux_packet_out (mux, buf, pcr);
+}
+
+/* With a fixed bitrate, PCRs are scheduled on the output clock rather than
+ * only when the PCR stream itself has data. Insert PCR packets for every
+ * program whose PCR is due, except on @skip which is about to carry one in
+ * its own payload packet. */
+static gboolean
+rewrite_pcr (TsMux * mux, TsMuxStream * skip)
+{
+  GList *cur;
+
+  if (!mux->bitrate || mux->first_pcr_ts == G_MININT64)
+    return TRUE;
+
+  for (cur = mux->programs; cur; cur = cur->next) {
+    TsMuxProgram *program = (TsMuxProgram *) cur->data;
+    TsMuxStream *stream = program->pcr_stream;
+    gint64 cur_pcr;
+
+    if (stream == NULL || stream == skip || stream->next_pcr == -1)
+      continue;
+
+    cur_pcr = get_packet_pcr (mux, mux->first_pcr_ts);
+    if (pcr_is_due (mux, stream, cur_pcr)) {
+      TS_DEBUG ("Inserting PCR %" G_GINT64_FORMAT " on PID 0x%04x", cur_pcr,
+          stream->pi.pid);
+      if (!tsmux_write_pcr_packet (mux, stream, cur_pcr))
+        return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
 static gboolean
 rewrite_si (TsMux * mux, gint64 cur_ts)
 {
@@ -1389,72 +1493,59 @@ rewrite_si (TsMux * mux, gint64 cur_ts)
 static gboolean
 pad_stream (TsMux * mux, TsMuxStream * stream, gint64 cur_ts)
 {
-  guint64 bitrate;
-  GstBuffer *buf = NULL;
-  GstMapInfo map;
-  gboolean ret = TRUE;
-
-  if (!mux->bitrate)
-    goto done;
-
-  do {
-    if (GST_CLOCK_STIME_IS_VALID (cur_ts)) {
-      GstClockTimeDiff diff;
+  GstClockTimeDiff diff;
+  guint64 target_bytes;
 
-      if (!GST_CLOCK_STIME_IS_VALID (stream->first_ts))
-        stream->first_ts = cur_ts;
+  if (!mux->bitrate || !GST_CLOCK_STIME_IS_VALID (cur_ts))
+    return TRUE;
 
-      diff = GST_CLOCK_DIFF (stream->first_ts, cur_ts);
+  if (!GST_CLOCK_STIME_IS_VALID (stream->first_ts))
+    stream->first_ts = cur_ts;
 
-      if (diff) {
-        bitrate =
-            gst_util_uint64_scale (mux->n_bytes * 8, TSMUX_CLOCK_FREQ, diff);
+  diff = GST_CLOCK_DIFF (stream->first_ts, cur_ts);
+  if (diff <= 0)
+    return TRUE;
 
-        GST_LOG ("Transport stream bitrate: %" G_GUINT64_FORMAT, bitrate);
+  /* Amount of data that should have been output by now */
+  target_bytes =
+      gst_util_uint64_scale (mux->bitrate, diff, 8 * TSMUX_CLOCK_FREQ);
 
-        if (bitrate < mux->bitrate) {
-          gint64 new_pcr;
-          guint payload_len, payload_offs;
+  if (mux->n_bytes >= target_bytes)
+    return TRUE;
 
-          GST_LOG ("Padding transport stream");
+  GST_LOG ("Padding transport stream with %" G_GUINT64_FORMAT " bytes",
+      target_bytes - mux->n_bytes);
 
-          if (!rewrite_si (mux, cur_ts)) {
-            ret = FALSE;
-            goto done;
-          }
+  while (mux->n_bytes < target_bytes) {
+    GstBuffer *buf = NULL;
+    GstMapInfo map;
+    gint64 cur_pcr;
 
-          if (!tsmux_get_buffer (mux, &buf)) {
-            ret = FALSE;
-            goto done;
-          }
+    if (!rewrite_si (mux, cur_ts))
+      return FALSE;
 
-          gst_buffer_map (buf, &map, GST_MAP_READ);
+    if (mux->n_bytes >= target_bytes)
+      break;
 
-          if ((new_pcr =
-                  write_new_pcr (mux, stream, get_current_pcr (mux,
-                          cur_ts)) != -1))
-            tsmux_write_ts_header (mux, map.data, &stream->pi, &payload_len,
-                &payload_offs, 0);
-          else
-            tsmux_write_null_ts_header (map.data);
+    cur_pcr = get_packet_pcr (mux, cur_ts);
+    if (pcr_is_due (mux, stream, cur_pcr)) {
+      if (!tsmux_write_pcr_packet (mux, stream, cur_pcr))
+        return FALSE;
+      continue;
+    }
 
-          gst_buffer_unmap (buf, &map);
+    if (!tsmux_get_buffer (mux, &buf))
+      return FALSE;
 
-          stream->pi.flags &= TSMUX_PACKET_FLAG_PES_FULL_HEADER;
+    gst_buffer_map (buf, &map, GST_MAP_READ);
+    tsmux_write_null_packet (map.data);
+    gst_buffer_unmap (buf, &map);
 
-          if (!(ret = tsmux_packet_out (mux, buf, new_pcr)))
-            goto done;
-        }
-      } else {
-        break;
-      }
-    } else {
-      break;
-    }
-  } while (bitrate < mux->bitrate);
+    if (!tsmux_packet_out (mux, buf, -1))
+      return FALSE;
+  }
 
-done:
-  return ret;
+  return TRUE;
 }
 
 /**
@@ -1473,7 +1564,7 @@ tsmux_write_stream_packet (TsMux * mux, TsMuxStream * stream)
   TsMuxPacketInfo *pi = &stream->pi;
   gboolean res;
   gint64 new_pcr = -1;
-  GstBuffer *buf = NULL;
+  GstBuffer *buf = NULL, *payload;
   GstMapInfo map;
 
   g_return_val_if_fail (mux != NULL, FALSE);
@@ -1493,7 +1584,12 @@ tsmux_write_stream_packet (TsMux * mux, TsMuxStream * stream)
     if (!pad_stream (mux, stream, cur_ts))
       goto fail;
 
-    new_pcr = write_new_pcr (mux, stream, get_current_pcr (mux, cur_ts));
+    if (!rewrite_pcr (mux, stream))
+      goto fail;
+
+    new_pcr = write_new_pcr (mux, stream, get_packet_pcr (mux, cur_ts));
+  } else if (!rewrite_pcr (mux, NULL)) {
+    goto fail;
   }
 
   pi->packet_start_unit_indicator = tsmux_stream_at_pes_start (stream);
@@ -1516,11 +1612,19 @@ tsmux_write_stream_packet (TsMux * mux, TsMuxStream * stream)
           pi->stream_avail))
     goto fail;
 
+  if (mux->share_payload && !pi->packet_start_unit_indicator &&
+      (payload = tsmux_stream_get_payload_buffer (stream, payload_len))) {
+    gst_buffer_unmap (buf, &map);
 
-  if (!tsmux_stream_get_data (stream, map.data + payload_offs, payload_len))
-    goto fail;
+    /* Keep the header only and reference the payload where it already is */
+    gst_buffer_resize (buf, 0, payload_offs);
+    buf = gst_buffer_append (buf, payload);
+  } else {
+    if (!tsmux_stream_get_data (stream, map.data + payload_offs, payload_len))
+      goto fail;
 
-  gst_buffer_unmap (buf, &map);
+    gst_buffer_unmap (buf, &map);
+  }
 
   GST_DEBUG ("Writing PES of size %d", (int) gst_buffer_get_size (buf));
   res = tsmux_packet_out (mux, buf, new_pcr);
@@ -1719,3 +1823,20 @@ tsmux_set_bitrate (TsMux * mux, guint64 bitrate)
 {
   mux->bitrate = bitrate;
 }
+
+/**
+ * tsmux_set_share_payload:
+ * @mux: a #TsMux
+ * @share_payload: whether to share payload memory
+ *
+ * When @share_payload is %TRUE, packets of which the payload comes from a
+ * single buffer added with tsmux_stream_add_buffer() are output as the
+ * packet header followed by a share of that buffer's memory, instead of
+ * copying the payload into the packet. Output packets may then consist of
+ * several memories.
+ */
+void
+tsmux_set_share_payload (TsMux * mux, gboolean share_payload)
+{
+  mux->share_payload = share_payload;
+}
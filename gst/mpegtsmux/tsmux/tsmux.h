@@ -198,6 +198,9 @@ struct TsMux {
   guint64 bitrate;
   guint64 n_bytes;
 
+  /* output payload as shares of the input buffers where possible */
+  gboolean share_payload;
+
   /* For the per-PID continuity counter */
   guint8 pid_packet_counts[8192];
 
@@ -217,6 +220,7 @@ guint 		tsmux_get_pat_interval          (TsMux *mux);
 void 		tsmux_resend_pat                (TsMux *mux);
 guint16		tsmux_get_new_pid 		(TsMux *mux);
 void    tsmux_set_bitrate       (TsMux *mux, guint64 bitrate);
+void    tsmux_set_share_payload (TsMux *mux, gboolean share_payload);
 
 /* pid/program management */
 TsMuxProgram *	tsmux_program_new 		(TsMux *mux, gint prog_id);
@@ -110,6 +110,9 @@ struct TsMuxStreamBuffer
 
   /* user_data for release function */
   void *user_data;
+
+  /* optional buffer that data is the complete mapping of */
+  GstBuffer *buffer;
 };
 
 /**
@@ -487,6 +490,19 @@ tsmux_stream_initialize_pes_packet (TsMuxStream * stream)
   return TRUE;
 }
 
+static void
+tsmux_stream_advance_pes (TsMuxStream * stream, guint len)
+{
+  stream->pes_bytes_written += len;
+
+  if (stream->cur_pes_payload_size != 0 &&
+      stream->pes_bytes_written == stream->cur_pes_payload_size) {
+    TS_DEBUG ("Finished PES packet");
+    stream->state = TSMUX_STREAM_STATE_HEADER;
+    stream->pes_bytes_written = 0;
+  }
+}
+
 /**
  * tsmux_stream_get_data:
  * @stream: a #TsMuxStream
@@ -525,14 +541,7 @@ tsmux_stream_get_data (TsMuxStream * stream, guint8 * buf, guint len)
   if (len > (guint) _tsmux_stream_bytes_avail (stream))
     return FALSE;
 
-  stream->pes_bytes_written += len;
-
-  if (stream->cur_pes_payload_size != 0 &&
-      stream->pes_bytes_written == stream->cur_pes_payload_size) {
-    TS_DEBUG ("Finished PES packet");
-    stream->state = TSMUX_STREAM_STATE_HEADER;
-    stream->pes_bytes_written = 0;
-  }
+  tsmux_stream_advance_pes (stream, len);
 
   while (len > 0) {
     guint32 avail;
@@ -566,6 +575,55 @@ tsmux_stream_get_data (TsMuxStream * stream, guint8 * buf, guint len)
   return TRUE;
 }
 
+/**
+ * tsmux_stream_get_payload_buffer:
+ * @stream: a #TsMuxStream
+ * @len: the number of payload bytes to retrieve
+ *
+ * If the next @len payload bytes of @stream are contained in a single buffer
+ * added with tsmux_stream_add_buffer(), consume them and return them as a
+ * #GstBuffer sharing the memory of that buffer. This is only possible past
+ * the PES header.
+ *
+ * Returns: (transfer full) (nullable): a #GstBuffer with @len bytes, or %NULL
+ * if the data has to be copied with tsmux_stream_get_data() instead.
+ */
+GstBuffer *
+tsmux_stream_get_payload_buffer (TsMuxStream * stream, guint len)
+{
+  TsMuxStreamBuffer *cur;
+  GstBuffer *payload;
+
+  g_return_val_if_fail (stream != NULL, NULL);
+
+  if (stream->state != TSMUX_STREAM_STATE_PACKET || len == 0)
+    return NULL;
+
+  if (len > (guint) _tsmux_stream_bytes_avail (stream))
+    return NULL;
+
+  if (stream->cur_buffer == NULL) {
+    if (stream->buffers == NULL)
+      return NULL;
+    stream->cur_buffer = (TsMuxStreamBuffer *) (stream->buffers->data);
+    stream->cur_buffer_consumed = 0;
+  }
+
+  cur = stream->cur_buffer;
+  if (cur->buffer == NULL || cur->size - stream->cur_buffer_consumed < len)
+    return NULL;
+
+  payload = gst_buffer_copy_region (cur->buffer, GST_BUFFER_COPY_MEMORY,
+      stream->cur_buffer_consumed, len);
+  if (payload == NULL)
+    return NULL;
+
+  tsmux_stream_advance_pes (stream, len);
+  tsmux_stream_consume (stream, len);
+
+  return payload;
+}
+
 static guint8
 tsmux_stream_pes_header_length (TsMuxStream * stream)
 {
@@ -727,6 +785,30 @@ tsmux_stream_write_pes_header (TsMuxStream * stream, guint8 * data)
 void
 tsmux_stream_add_data (TsMuxStream * stream, guint8 * data, guint len,
     void *user_data, gint64 pts, gint64 dts, gboolean random_access)
+{
+  tsmux_stream_add_buffer (stream, NULL, data, len, user_data, pts, dts,
+      random_access);
+}
+
+/**
+ * tsmux_stream_add_buffer:
+ * @stream: a #TsMuxStream
+ * @buffer: (nullable): the #GstBuffer @data is mapped from
+ * @data: data to add
+ * @len: length of @data
+ * @user_data: user data to pass to release func
+ * @pts: PTS of access unit in @data
+ * @dts: DTS of access unit in @data
+ * @random_access: TRUE if random access point (keyframe)
+ *
+ * Like tsmux_stream_add_data(), but @data is the complete mapping of @buffer,
+ * which allows tsmux_stream_get_payload_buffer() to share its memory instead
+ * of copying it. @buffer must stay valid until @data is released.
+ */
+void
+tsmux_stream_add_buffer (TsMuxStream * stream, GstBuffer * buffer,
+    guint8 * data, guint len, void *user_data, gint64 pts, gint64 dts,
+    gboolean random_access)
 {
   TsMuxStreamBuffer *packet;
 
@@ -737,6 +819,7 @@ tsmux_stream_add_data (TsMuxStream * stream, guint8 * data, guint len,
   packet->size = len;
   packet->user_data = user_data;
   packet->random_access = random_access;
+  packet->buffer = buffer;
 
   packet->pts = pts;
   packet->dts = dts;
@@ -256,6 +256,10 @@ void 		tsmux_stream_set_get_es_descriptors_func 	(TsMuxStream *stream,
 void 		tsmux_stream_add_data 		(TsMuxStream *stream, guint8 *data, guint len,
        						 void *user_data, gint64 pts, gint64 dts,
                                                  gboolean random_access);
+void 		tsmux_stream_add_buffer 	(TsMuxStream *stream, GstBuffer *buffer,
+                                                 guint8 *data, guint len,
+       						 void *user_data, gint64 pts, gint64 dts,
+                                                 gboolean random_access);
 
 void 		tsmux_stream_pcr_ref 		(TsMuxStream *stream);
 void 		tsmux_stream_pcr_unref  	(TsMuxStream *stream);
@@ -269,6 +273,7 @@ gint 		tsmux_stream_bytes_in_buffer 	(TsMuxStream *stream);
 gint 		tsmux_stream_bytes_avail 	(TsMuxStream *stream);
 gboolean 	tsmux_stream_initialize_pes_packet (TsMuxStream *stream);
 gboolean 	tsmux_stream_get_data 		(TsMuxStream *stream, guint8 *buf, guint len);
+GstBuffer *	tsmux_stream_get_payload_buffer (TsMuxStream *stream, guint len);
 
 gint64 	tsmux_stream_get_pts 		(TsMuxStream *stream);
 gint64 	tsmux_stream_get_dts 		(TsMuxStream *stream);
@@ -116,9 +116,12 @@ enum
   PROP_0,
   PROP_PACKAGE,
   PROP_MAX_DRIFT,
-  PROP_STRUCTURE
+  PROP_STRUCTURE,
+  PROP_READAHEAD_SIZE
 };
 
+#define DEFAULT_READAHEAD_SIZE (4 * 1024 * 1024)
+
 static gboolean gst_mxf_demux_sink_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
 static gboolean gst_mxf_demux_src_event (GstPad * pad, GstObject * parent,
@@ -261,6 +264,9 @@ gst_mxf_demux_reset (GstMXFDemux * demux)
 
   gst_adapter_clear (demux->adapter);
 
+  gst_buffer_replace (&demux->readahead, NULL);
+  demux->readahead_offset = 0;
+
   gst_mxf_demux_remove_pads (demux);
 
   if (demux->random_index_pack) {
@@ -301,13 +307,65 @@ gst_mxf_demux_reset (GstMXFDemux * demux)
   demux->group_id = G_MAXUINT;
 }
 
+/* Serves small reads from a window of readahead-size bytes so that the
+ * key, length and value of consecutive KLV packets don't each cause a
+ * separate read upstream. Returned buffers share the memory of the
+ * window. */
+static GstFlowReturn
+gst_mxf_demux_pull_readahead (GstMXFDemux * demux, guint64 offset,
+    guint size, GstBuffer ** buffer)
+{
+  GstFlowReturn ret;
+  gsize cached;
+
+  if (demux->readahead) {
+    cached = gst_buffer_get_size (demux->readahead);
+    if (offset >= demux->readahead_offset
+        && offset + size <= demux->readahead_offset + cached)
+      goto have_data;
+  }
+
+  gst_buffer_replace (&demux->readahead, NULL);
+
+  ret = gst_pad_pull_range (demux->sinkpad, offset, demux->readahead_size,
+      &demux->readahead);
+  if (ret != GST_FLOW_OK) {
+    demux->readahead = NULL;
+    return ret;
+  }
+
+  demux->readahead_offset = offset;
+  cached = gst_buffer_get_size (demux->readahead);
+
+  GST_LOG_OBJECT (demux, "Read %" G_GSIZE_FORMAT " bytes ahead at offset %"
+      G_GUINT64_FORMAT, cached, offset);
+
+  /* Short read at the end of the file, let the caller handle it */
+  if (size > cached) {
+    *buffer = gst_buffer_ref (demux->readahead);
+    return GST_FLOW_OK;
+  }
+
+have_data:
+  *buffer = gst_buffer_copy_region (demux->readahead, GST_BUFFER_COPY_ALL,
+      offset - demux->readahead_offset, size);
+  GST_BUFFER_OFFSET (*buffer) = offset;
+  GST_BUFFER_OFFSET_END (*buffer) = offset + size;
+
+  return GST_FLOW_OK;
+}
+
 static GstFlowReturn
 gst_mxf_demux_pull_range (GstMXFDemux * demux, guint64 offset,
     guint size, GstBuffer ** buffer)
 {
   GstFlowReturn ret;
 
-  ret = gst_pad_pull_range (demux->sinkpad, offset, size, buffer);
+  /* Reads as large as the window go upstream directly */
+  if (demux->readahead_size > 0 && size < demux->readahead_size)
+    ret = gst_mxf_demux_pull_readahead (demux, offset, size, buffer);
+  else
+    ret = gst_pad_pull_range (demux->sinkpad, offset, size, buffer);
   if (G_UNLIKELY (ret != GST_FLOW_OK)) {
     GST_WARNING_OBJECT (demux,
         "failed when pulling %u bytes from offset %" G_GUINT64_FORMAT ": %s",
@@ -2811,6 +2869,56 @@ find_closest_offset (GArray * offsets, gint64 * position, gboolean keyframe)
   return -1;
 }
 
+static guint64 gst_mxf_demux_stream_offset_to_file_offset (GstMXFDemux *
+    demux, guint32 body_sid, guint64 stream_offset);
+
+/* Looks up the offset of an edit unit, or of the last keyframe before it,
+ * in the index tables of the file */
+static guint64
+find_index_table_offset (GstMXFDemux * demux,
+    GstMXFDemuxIndexTable * index_table, gint64 * position, gboolean keyframe)
+{
+  guint64 offset;
+
+  offset = find_offset (index_table->offsets, position, keyframe);
+  if (offset != -1)
+    return offset;
+
+  if (index_table->edit_unit_byte_count
+      && *position >= index_table->cbe_start_position)
+    return gst_mxf_demux_stream_offset_to_file_offset (demux,
+        index_table->body_sid,
+        *position * index_table->edit_unit_byte_count);
+
+  return -1;
+}
+
+/* Sets the position of all essence tracks after seeking to the start of
+ * edit unit @position of @etrack's index table. The essence tracks in the
+ * same edit units continue from there, all others are unknown */
+static void
+gst_mxf_demux_set_index_position (GstMXFDemux * demux,
+    GstMXFDemuxEssenceTrack * etrack, gint64 position)
+{
+  guint i;
+
+  for (i = 0; i < demux->essence_tracks->len; i++) {
+    GstMXFDemuxEssenceTrack *t =
+        &g_array_index (demux->essence_tracks, GstMXFDemuxEssenceTrack, i);
+
+    if (t == etrack || (t->body_sid == etrack->body_sid
+            && t->index_sid == etrack->index_sid && t->source_track
+            && etrack->source_track
+            && t->source_track->edit_rate.n ==
+            etrack->source_track->edit_rate.n
+            && t->source_track->edit_rate.d ==
+            etrack->source_track->edit_rate.d))
+      t->position = position;
+    else
+      t->position = -1;
+  }
+}
+
 static guint64
 gst_mxf_demux_find_essence_element (GstMXFDemux * demux,
     GstMXFDemuxEssenceTrack * etrack, gint64 * position, gboolean keyframe)
@@ -2882,6 +2990,24 @@ from_index:
   } else if (demux->random_access) {
     gint64 index_start_position = *position;
 
+    /* The index tables of the file give us the offset directly, no need
+     * to go through the essence */
+    if (index_table) {
+      gint64 tmp_position = *position;
+
+      offset = find_index_table_offset (demux, index_table, &tmp_position,
+          keyframe);
+      if (offset != -1) {
+        GST_DEBUG_OBJECT (demux,
+            "Found edit unit %" G_GINT64_FORMAT " for %" G_GINT64_FORMAT
+            " in index at offset %" G_GUINT64_FORMAT, tmp_position,
+            requested_position, offset);
+        *position = tmp_position;
+        gst_mxf_demux_set_index_position (demux, etrack, tmp_position);
+        return offset;
+      }
+    }
+
     demux->offset = demux->run_in;
 
     offset =
@@ -3176,6 +3302,14 @@ gst_mxf_demux_loop (GstPad * pad)
 
     /* First of all pull&parse the random index pack at EOF */
     gst_mxf_demux_pull_random_index_pack (demux);
+
+    /* and build the index from all index table segments of the file, the
+     * partitions are found through the footer partition if there was no
+     * random index pack */
+    if (!demux->index_table_segments_collected) {
+      collect_index_table_segments (demux);
+      demux->index_table_segments_collected = TRUE;
+    }
   }
 
   /* Now actually do something */
@@ -3665,32 +3799,128 @@ no_new_offset:
   }
 }
 
+/* Converts an offset in the essence container stream of @body_sid to a file
+ * offset without run-in, or returns -1 if no known partition contains it */
+static guint64
+gst_mxf_demux_stream_offset_to_file_offset (GstMXFDemux * demux,
+    guint32 body_sid, guint64 stream_offset)
+{
+  GstMXFDemuxPartition *offset_partition = NULL, *next_partition = NULL;
+  guint64 offset;
+  GList *m;
+
+  for (m = demux->partitions; m; m = m->next) {
+    GstMXFDemuxPartition *partition = m->data;
+
+    if (!next_partition && offset_partition)
+      next_partition = partition;
+
+    if (partition->partition.body_sid != body_sid)
+      continue;
+    if (partition->partition.body_offset > stream_offset)
+      break;
+
+    offset_partition = partition;
+    next_partition = NULL;
+  }
+
+  if (!offset_partition
+      || stream_offset < offset_partition->partition.body_offset)
+    return -1;
+
+  offset =
+      offset_partition->partition.this_partition +
+      offset_partition->essence_container_offset + (stream_offset -
+      offset_partition->partition.body_offset);
+
+  if (next_partition && offset >= next_partition->partition.this_partition) {
+    GST_ERROR_OBJECT (demux,
+        "Invalid index table segment going into next unrelated partition");
+    return -1;
+  }
+
+  return offset;
+}
+
+/* Reads the partition packs and index table segments of all partitions,
+ * either from the random index pack or by following the partitions
+ * backwards from the footer partition */
 static void
-collect_index_table_segments (GstMXFDemux * demux)
+read_all_partition_headers (GstMXFDemux * demux)
 {
-  GList *l;
-  guint i;
   guint64 old_offset = demux->offset;
   GstMXFDemuxPartition *old_partition = demux->current_partition;
+  guint i;
 
-  if (!demux->random_index_pack)
-    return;
+  if (demux->random_index_pack) {
+    for (i = 0; i < demux->random_index_pack->len; i++) {
+      MXFRandomIndexPackEntry *e =
+          &g_array_index (demux->random_index_pack, MXFRandomIndexPackEntry,
+          i);
 
-  for (i = 0; i < demux->random_index_pack->len; i++) {
-    MXFRandomIndexPackEntry *e =
-        &g_array_index (demux->random_index_pack, MXFRandomIndexPackEntry, i);
+      if (e->offset < demux->run_in) {
+        GST_ERROR_OBJECT (demux, "Invalid random index pack entry");
+        break;
+      }
 
-    if (e->offset < demux->run_in) {
-      GST_ERROR_OBJECT (demux, "Invalid random index pack entry");
-      return;
+      demux->offset = e->offset;
+      read_partition_header (demux);
     }
+  } else {
+    guint64 offset;
 
-    demux->offset = e->offset;
+    /* The header partition pack tells us where the footer partition is */
+    demux->offset = demux->run_in;
     read_partition_header (demux);
+
+    /* Our partitions are relinked when new ones are found, so take the
+     * previous partition from the partition pack itself */
+    offset = demux->footer_partition_pack_offset;
+    while (offset != 0) {
+      MXFPartitionPack partition;
+      GstBuffer *buf = NULL;
+      GstMapInfo map;
+      MXFUL key;
+      gboolean ret = FALSE;
+      guint64 prev_partition;
+
+      if (gst_mxf_demux_pull_klv_packet (demux, demux->run_in + offset, &key,
+              &buf, NULL) != GST_FLOW_OK)
+        break;
+
+      if (mxf_is_partition_pack (&key)) {
+        gst_buffer_map (buf, &map, GST_MAP_READ);
+        ret = mxf_partition_pack_parse (&key, &partition, map.data, map.size);
+        gst_buffer_unmap (buf, &map);
+      }
+      gst_buffer_unref (buf);
+
+      if (!ret)
+        break;
+
+      prev_partition = partition.prev_partition;
+      mxf_partition_pack_reset (&partition);
+
+      demux->offset = demux->run_in + offset;
+      read_partition_header (demux);
+
+      if (prev_partition >= offset)
+        break;
+      offset = prev_partition;
+    }
   }
 
   demux->offset = old_offset;
   demux->current_partition = old_partition;
+}
+
+static void
+collect_index_table_segments (GstMXFDemux * demux)
+{
+  GList *l;
+  guint i;
+
+  read_all_partition_headers (demux);
 
   for (l = demux->pending_index_table_segments; l; l = l->next) {
     MXFIndexTableSegment *segment = l->data;
@@ -3717,6 +3947,19 @@ collect_index_table_segments (GstMXFDemux * demux)
     }
 
     start = segment->index_start_position;
+
+    /* A CBE segment without duration covers all edit units from its start,
+     * look those up when needed instead of creating entries for them */
+    if (segment->n_index_entries == 0 && segment->edit_unit_byte_count
+        && segment->index_duration == 0) {
+      GST_DEBUG_OBJECT (demux, "CBE index table for body_sid %u index_sid %u "
+          "with %u bytes per edit unit from %" G_GUINT64_FORMAT, t->body_sid,
+          t->index_sid, segment->edit_unit_byte_count, start);
+      t->edit_unit_byte_count = segment->edit_unit_byte_count;
+      t->cbe_start_position = start;
+      continue;
+    }
+
     end = start + segment->index_duration;
     if (end > G_MAXINT / sizeof (GstMXFDemuxIndex)) {
       demux->index_tables = g_list_remove (demux->index_tables, t);
@@ -3728,62 +3971,45 @@ collect_index_table_segments (GstMXFDemux * demux)
     if (t->offsets->len < end)
       g_array_set_size (t->offsets, end);
 
-    for (i = 0; i < segment->n_index_entries && start + i < t->offsets->len;
-        i++) {
-      guint64 offset = segment->index_entries[i].stream_offset;
-      GList *m;
-      GstMXFDemuxPartition *offset_partition = NULL, *next_partition = NULL;
+    /* CBE segments have no entries, every edit unit has the same size and
+     * can be decoded on its own */
+    if (segment->n_index_entries == 0 && segment->edit_unit_byte_count) {
+      for (i = 0; start + i < end; i++) {
+        GstMXFDemuxIndex *index =
+            &g_array_index (t->offsets, GstMXFDemuxIndex, start + i);
+        guint64 offset = gst_mxf_demux_stream_offset_to_file_offset (demux,
+            t->body_sid, (start + i) * segment->edit_unit_byte_count);
 
-      for (m = demux->partitions; m; m = m->next) {
-        GstMXFDemuxPartition *partition = m->data;
-
-        if (!next_partition && offset_partition)
-          next_partition = partition;
-
-        if (partition->partition.body_sid != t->body_sid)
-          continue;
-        if (partition->partition.body_offset > offset)
+        if (offset == -1)
           break;
 
-        offset_partition = partition;
-        next_partition = NULL;
+        index->initialized = TRUE;
+        index->offset = offset;
+        index->pts = G_MAXUINT64;
+        index->dts = G_MAXUINT64;
+        index->keyframe = TRUE;
       }
+      continue;
+    }
 
-      if (offset_partition && offset >= offset_partition->partition.body_offset) {
-        offset =
-            offset_partition->partition.this_partition +
-            offset_partition->essence_container_offset + (offset -
-            offset_partition->partition.body_offset);
-
-        if (next_partition
-            && offset >= next_partition->partition.this_partition) {
-          GST_ERROR_OBJECT (demux,
-              "Invalid index table segment going into next unrelated partition");
-        } else {
-          GstMXFDemuxIndex *index;
-          gint8 temporal_offset = segment->index_entries[i].temporal_offset;
-          guint64 pts_i = G_MAXUINT64;
-
-          if (temporal_offset > 0 ||
-              (temporal_offset < 0 && start + i >= -(gint) temporal_offset)) {
-            pts_i = start + i + temporal_offset;
-
-            if (t->offsets->len < pts_i)
-              g_array_set_size (t->offsets, pts_i + 1);
-
-            index = &g_array_index (t->offsets, GstMXFDemuxIndex, pts_i);
-            if (!index->initialized) {
-              index->initialized = TRUE;
-              index->offset = 0;
-              index->pts = G_MAXUINT64;
-              index->dts = G_MAXUINT64;
-              index->keyframe = FALSE;
-            }
-
-            index->pts = start + i;
-          }
+    for (i = 0; i < segment->n_index_entries && start + i < t->offsets->len;
+        i++) {
+      guint64 offset = gst_mxf_demux_stream_offset_to_file_offset (demux,
+          t->body_sid, segment->index_entries[i].stream_offset);
+
+      if (offset != -1) {
+        GstMXFDemuxIndex *index;
+        gint8 temporal_offset = segment->index_entries[i].temporal_offset;
+        guint64 pts_i = G_MAXUINT64;
+
+        if (temporal_offset > 0 ||
+            (temporal_offset < 0 && start + i >= -(gint) temporal_offset)) {
+          pts_i = start + i + temporal_offset;
 
-          index = &g_array_index (t->offsets, GstMXFDemuxIndex, start + i);
+          if (t->offsets->len < pts_i)
+            g_array_set_size (t->offsets, pts_i + 1);
+
+          index = &g_array_index (t->offsets, GstMXFDemuxIndex, pts_i);
           if (!index->initialized) {
             index->initialized = TRUE;
             index->offset = 0;
@@ -3792,11 +4018,22 @@ collect_index_table_segments (GstMXFDemux * demux)
             index->keyframe = FALSE;
           }
 
-          index->offset = offset;
-          index->keyframe = ! !(segment->index_entries[i].flags & 0x80)
-              || (segment->index_entries[i].key_frame_offset == 0);
-          index->dts = pts_i;
+          index->pts = start + i;
+        }
+
+        index = &g_array_index (t->offsets, GstMXFDemuxIndex, start + i);
+        if (!index->initialized) {
+          index->initialized = TRUE;
+          index->offset = 0;
+          index->pts = G_MAXUINT64;
+          index->dts = G_MAXUINT64;
+          index->keyframe = FALSE;
         }
+
+        index->offset = offset;
+        index->keyframe = ! !(segment->index_entries[i].flags & 0x80)
+            || (segment->index_entries[i].key_frame_offset == 0);
+        index->dts = pts_i;
       }
     }
   }
@@ -4551,6 +4788,9 @@ gst_mxf_demux_set_property (GObject * object, guint prop_id,
     case PROP_MAX_DRIFT:
       demux->max_drift = g_value_get_uint64 (value);
       break;
+    case PROP_READAHEAD_SIZE:
+      demux->readahead_size = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -4570,6 +4810,9 @@ gst_mxf_demux_get_property (GObject * object, guint prop_id,
     case PROP_MAX_DRIFT:
       g_value_set_uint64 (value, demux->max_drift);
       break;
+    case PROP_READAHEAD_SIZE:
+      g_value_set_uint (value, demux->readahead_size);
+      break;
     case PROP_STRUCTURE:{
       GstStructure *s;
 
@@ -4664,6 +4907,22 @@ gst_mxf_demux_class_init (GstMXFDemuxClass * klass)
           "Structural metadata of the MXF file",
           GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstMXFDemux:readahead-size:
+   *
+   * Number of bytes read at once from upstream in pull mode. Smaller
+   * reads, like the key and length of the KLV packets and the essence of
+   * interleaved tracks, are then served from this window. Reads of at
+   * least this size bypass the window, and 0 disables it.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_READAHEAD_SIZE,
+      g_param_spec_uint ("readahead-size", "Readahead size",
+          "Number of bytes to read ahead in pull mode (0 = disabled)",
+          0, 64 * 1024 * 1024, DEFAULT_READAHEAD_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_mxf_demux_change_state);
   gstelement_class->query = GST_DEBUG_FUNCPTR (gst_mxf_demux_query);
@@ -4695,6 +4954,7 @@ gst_mxf_demux_init (GstMXFDemux * demux)
   gst_element_add_pad (GST_ELEMENT (demux), demux->sinkpad);
 
   demux->max_drift = 500 * GST_MSECOND;
+  demux->readahead_size = DEFAULT_READAHEAD_SIZE;
 
   demux->adapter = gst_adapter_new ();
   demux->flowcombiner = gst_flow_combiner_new ();
@@ -106,6 +106,11 @@ typedef struct
 
   /* offsets indexed by DTS */
   GArray *offsets;
+
+  /* Edit unit byte count and first edit unit of a CBE index table segment
+   * without duration, which covers all following edit units. 0 if none */
+  guint32 edit_unit_byte_count;
+  gint64 cbe_start_position;
 } GstMXFDemuxIndexTable;
 
 struct _GstMXFDemuxPad
@@ -205,9 +210,14 @@ struct _GstMXFDemux
 
   GstTagList *tags;
 
+  /* Readahead window of the pull mode reads, NULL if nothing is cached */
+  GstBuffer *readahead;
+  guint64 readahead_offset;
+
   /* Properties */
   gchar *requested_package_string;
   GstClockTime max_drift;
+  guint readahead_size;
 };
 
 struct _GstMXFDemuxClass
@@ -115,13 +115,20 @@ static GstStaticPadTemplate src_templ = GST_STATIC_PAD_TEMPLATE ("src",
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_PARTITION_INTERVAL
 };
 
+#define DEFAULT_PARTITION_INTERVAL 0
+
 #define gst_mxf_mux_parent_class parent_class
 G_DEFINE_TYPE (GstMXFMux, gst_mxf_mux, GST_TYPE_AGGREGATOR);
 
 static void gst_mxf_mux_finalize (GObject * object);
+static void gst_mxf_mux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_mxf_mux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 
 static GstFlowReturn gst_mxf_mux_aggregate (GstAggregator * aggregator,
     gboolean timeout);
@@ -163,6 +170,26 @@ gst_mxf_mux_class_init (GstMXFMuxClass * klass)
   gstaggregator_class = (GstAggregatorClass *) klass;
 
   gobject_class->finalize = gst_mxf_mux_finalize;
+  gobject_class->set_property = gst_mxf_mux_set_property;
+  gobject_class->get_property = gst_mxf_mux_get_property;
+
+  /**
+   * GstMXFMux:partition-interval:
+   *
+   * Start a new body partition at the first keyframe after this much time,
+   * carrying the index table segments of the essence written since the
+   * previous partition. This makes files readable and seekable while they
+   * are still being written. 0 writes a single body partition and the
+   * complete index table only in the footer.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_PARTITION_INTERVAL,
+      g_param_spec_uint64 ("partition-interval", "Partition interval",
+          "Minimum duration of body partitions in nanoseconds "
+          "(0 = single body partition)", 0, G_MAXUINT64,
+          DEFAULT_PARTITION_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gstaggregator_class->create_new_pad =
       GST_DEBUG_FUNCPTR (gst_mxf_mux_create_new_pad);
@@ -193,9 +220,44 @@ static void
 gst_mxf_mux_init (GstMXFMux * mux)
 {
   mux->index_table = g_array_new (FALSE, FALSE, sizeof (MXFIndexTableSegment));
+  mux->partitions =
+      g_array_new (FALSE, FALSE, sizeof (MXFRandomIndexPackEntry));
+  mux->partition_interval = DEFAULT_PARTITION_INTERVAL;
   gst_mxf_mux_reset (mux);
 }
 
+static void
+gst_mxf_mux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstMXFMux *mux = GST_MXF_MUX (object);
+
+  switch (prop_id) {
+    case PROP_PARTITION_INTERVAL:
+      mux->partition_interval = g_value_get_uint64 (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_mxf_mux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstMXFMux *mux = GST_MXF_MUX (object);
+
+  switch (prop_id) {
+    case PROP_PARTITION_INTERVAL:
+      g_value_set_uint64 (value, mux->partition_interval);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 gst_mxf_mux_finalize (GObject * object)
 {
@@ -219,6 +281,11 @@ gst_mxf_mux_finalize (GObject * object)
     mux->index_table = NULL;
   }
 
+  if (mux->partitions) {
+    g_array_free (mux->partitions, TRUE);
+    mux->partitions = NULL;
+  }
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -269,7 +336,11 @@ gst_mxf_mux_reset (GstMXFMux * mux)
               n).index_entries);
   g_array_set_size (mux->index_table, 0);
   mux->current_index_pos = 0;
+  mux->n_written_index_segments = 0;
   mux->last_keyframe_pos = 0;
+
+  g_array_set_size (mux->partitions, 0);
+  mux->last_partition_timestamp = 0;
 }
 
 static gboolean
@@ -1207,6 +1278,162 @@ static const guint8 _gc_essence_element_ul[] = {
   0x0d, 0x01, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00
 };
 
+#define MAX_INDEX_SEGMENT_SIZE (G_MAXUINT16 / 11)
+
+static MXFIndexTableSegment *
+gst_mxf_mux_append_index_segment (GstMXFMux * mux, GstMXFMuxPad * pad,
+    guint64 start_position)
+{
+  MXFIndexTableSegment s;
+
+  memset (&s, 0, sizeof (s));
+
+  mxf_uuid_init (&s.instance_id, mux->metadata);
+  memcpy (&s.index_edit_rate, &pad->source_track->edit_rate,
+      sizeof (s.index_edit_rate));
+  s.index_start_position = start_position;
+  s.index_duration = 0;
+  s.edit_unit_byte_count = 0;
+  s.index_sid =
+      mux->preface->content_storage->essence_container_data[0]->index_sid;
+  s.body_sid =
+      mux->preface->content_storage->essence_container_data[0]->body_sid;
+  s.slice_count = 0;
+  s.pos_table_count = 0;
+  s.n_delta_entries = 0;
+  s.delta_entries = NULL;
+  s.n_index_entries = 0;
+  s.index_entries = g_new0 (MXFIndexEntry, MAX_INDEX_SEGMENT_SIZE);
+  g_array_append_val (mux->index_table, s);
+
+  mux->current_index_pos = mux->index_table->len - 1;
+
+  return &g_array_index (mux->index_table, MXFIndexTableSegment,
+      mux->index_table->len - 1);
+}
+
+/* Returns the index entry of the edit unit at @position, appending index
+ * table segments as necessary. Segments are at most MAX_INDEX_SEGMENT_SIZE
+ * long but are cut shorter at interleaved body partitions, so they are
+ * looked up by their start position */
+static MXFIndexEntry *
+gst_mxf_mux_get_index_entry (GstMXFMux * mux, GstMXFMuxPad * pad,
+    guint64 position, MXFIndexTableSegment ** segment_out)
+{
+  MXFIndexTableSegment *segment = NULL;
+  guint i;
+
+  for (i = mux->index_table->len; i > 0; i--) {
+    segment = &g_array_index (mux->index_table, MXFIndexTableSegment, i - 1);
+    if (segment->index_start_position <= position)
+      break;
+  }
+
+  if (i == 0)
+    segment = gst_mxf_mux_append_index_segment (mux, pad, 0);
+
+  while (position - segment->index_start_position >= MAX_INDEX_SEGMENT_SIZE)
+    segment = gst_mxf_mux_append_index_segment (mux, pad,
+        segment->index_start_position + MAX_INDEX_SEGMENT_SIZE);
+
+  if (segment_out)
+    *segment_out = segment;
+
+  return &segment->index_entries[position - segment->index_start_position];
+}
+
+/* Starts a new body partition before the edit unit at the current position
+ * of @pad, carrying the index table segments of the essence written since
+ * the previous partition. This allows reading and seeking in the file while
+ * it is still being written */
+static GstFlowReturn
+gst_mxf_mux_write_interleaved_partition (GstMXFMux * mux, GstMXFMuxPad * pad)
+{
+  MXFIndexTableSegment *last;
+  MXFRandomIndexPackEntry entry;
+  GList *index_buffers = NULL, *l;
+  guint64 index_byte_count = 0;
+  GstFlowReturn ret;
+  GstBuffer *buf;
+  guint i;
+
+  if (mux->index_table->len == 0)
+    return GST_FLOW_OK;
+
+  /* Segments for later edit units might already exist because of
+   * reordering, wait until we're past them */
+  last = &g_array_index (mux->index_table, MXFIndexTableSegment,
+      mux->index_table->len - 1);
+  if (last->index_start_position + last->index_duration != pad->pos)
+    return GST_FLOW_OK;
+
+  for (i = mux->n_written_index_segments; i < mux->index_table->len; i++) {
+    MXFIndexTableSegment *segment =
+        &g_array_index (mux->index_table, MXFIndexTableSegment, i);
+
+    if (segment->index_duration == 0)
+      continue;
+
+    buf = mxf_index_table_segment_to_buffer (segment);
+    index_byte_count += gst_buffer_get_size (buf);
+    index_buffers = g_list_prepend (index_buffers, buf);
+  }
+  index_buffers = g_list_reverse (index_buffers);
+
+  GST_DEBUG_OBJECT (mux, "Starting body partition at offset %"
+      G_GUINT64_FORMAT " with %" G_GUINT64_FORMAT " bytes of index",
+      mux->offset, index_byte_count);
+
+  mux->partition.type = MXF_PARTITION_PACK_BODY;
+  mux->partition.closed = TRUE;
+  mux->partition.complete = TRUE;
+  mux->partition.prev_partition = mux->partition.this_partition;
+  mux->partition.this_partition = mux->offset;
+  mux->partition.footer_partition = 0;
+  mux->partition.header_byte_count = 0;
+  mux->partition.index_byte_count = index_byte_count;
+  mux->partition.index_sid = index_byte_count > 0 ?
+      mux->preface->content_storage->essence_container_data[0]->index_sid : 0;
+  /* body_offset continues from the previous partition */
+  mux->partition.body_sid =
+      mux->preface->content_storage->essence_container_data[0]->body_sid;
+
+  entry.offset = mux->partition.this_partition;
+  entry.body_sid = mux->partition.body_sid;
+  g_array_append_val (mux->partitions, entry);
+
+  buf = mxf_partition_pack_to_buffer (&mux->partition);
+  if ((ret = gst_mxf_mux_push (mux, buf)) != GST_FLOW_OK) {
+    GST_ERROR_OBJECT (mux, "Failed pushing body partition: %s",
+        gst_flow_get_name (ret));
+    g_list_free_full (index_buffers, (GDestroyNotify) gst_buffer_unref);
+    return ret;
+  }
+
+  for (l = index_buffers; l; l = l->next) {
+    buf = l->data;
+    l->data = NULL;
+    if ((ret = gst_mxf_mux_push (mux, buf)) != GST_FLOW_OK) {
+      GST_ERROR_OBJECT (mux, "Failed pushing index table segment: %s",
+          gst_flow_get_name (ret));
+      g_list_foreach (l->next, (GFunc) gst_mini_object_unref, NULL);
+      g_list_free (index_buffers);
+      return ret;
+    }
+  }
+  g_list_free (index_buffers);
+
+  mux->n_written_index_segments = mux->index_table->len;
+  if (last->index_duration > 0)
+    gst_mxf_mux_append_index_segment (mux, pad, pad->pos);
+  else
+    mux->n_written_index_segments--;
+
+  mux->last_partition_timestamp = pad->last_timestamp;
+
+  return GST_FLOW_OK;
+}
+
 static GstFlowReturn
 gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
 {
@@ -1270,53 +1497,21 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
   /* We currently only index the first essence stream */
   if (pad == (GstMXFMuxPad *) GST_ELEMENT_CAST (mux)->sinkpads->data) {
     MXFIndexTableSegment *segment;
-    const gint max_segment_size = G_MAXUINT16 / 11;
-
-    if (mux->index_table->len == 0 ||
-        g_array_index (mux->index_table, MXFIndexTableSegment,
-            mux->current_index_pos).index_duration >= max_segment_size) {
-
-      if (mux->index_table->len > 0)
-        mux->current_index_pos++;
-
-      if (mux->index_table->len <= mux->current_index_pos) {
-        MXFIndexTableSegment s;
-
-        memset (&segment, 0, sizeof (segment));
-
-        mxf_uuid_init (&s.instance_id, mux->metadata);
-        memcpy (&s.index_edit_rate, &pad->source_track->edit_rate,
-            sizeof (s.index_edit_rate));
-        if (mux->index_table->len > 0)
-          s.index_start_position =
-              g_array_index (mux->index_table, MXFIndexTableSegment,
-              mux->index_table->len - 1).index_start_position;
-        else
-          s.index_start_position = 0;
-        s.index_duration = 0;
-        s.edit_unit_byte_count = 0;
-        s.index_sid =
-            mux->preface->content_storage->essence_container_data[0]->index_sid;
-        s.body_sid =
-            mux->preface->content_storage->essence_container_data[0]->body_sid;
-        s.slice_count = 0;
-        s.pos_table_count = 0;
-        s.n_delta_entries = 0;
-        s.delta_entries = NULL;
-        s.n_index_entries = 0;
-        s.index_entries = g_new0 (MXFIndexEntry, max_segment_size);
-        g_array_append_val (mux->index_table, s);
+    MXFIndexEntry *entry;
+
+    if (mux->partition_interval > 0 && is_keyframe && pad->pos > 0 &&
+        pad->last_timestamp >=
+        mux->last_partition_timestamp + mux->partition_interval) {
+      ret = gst_mxf_mux_write_interleaved_partition (mux, pad);
+      if (ret != GST_FLOW_OK) {
+        gst_buffer_unref (buf);
+        return ret;
       }
     }
-    segment =
-        &g_array_index (mux->index_table, MXFIndexTableSegment,
-        mux->current_index_pos);
 
     if (dts != GST_CLOCK_TIME_NONE && pts != GST_CLOCK_TIME_NONE) {
       guint64 pts_pos;
-      guint64 pts_index_pos, pts_segment_pos;
       gint64 index_pos_diff;
-      MXFIndexTableSegment *pts_segment;
 
       pts =
           gst_segment_to_running_time (&pad->parent.segment, GST_FORMAT_TIME,
@@ -1326,75 +1521,22 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
           pad->source_track->edit_rate.d * GST_SECOND);
 
       index_pos_diff = pts_pos - pad->pos;
-      pts_index_pos = mux->current_index_pos;
-      pts_segment_pos = segment->n_index_entries;
-      if (index_pos_diff >= 0) {
-        while (pts_segment_pos + index_pos_diff >= max_segment_size) {
-          index_pos_diff -= max_segment_size - pts_segment_pos;
-          pts_segment_pos = 0;
-          pts_index_pos++;
-
-          if (pts_index_pos >= mux->index_table->len) {
-            MXFIndexTableSegment s;
-
-            memset (&segment, 0, sizeof (segment));
-
-            mxf_uuid_init (&s.instance_id, mux->metadata);
-            memcpy (&s.index_edit_rate, &pad->source_track->edit_rate,
-                sizeof (s.index_edit_rate));
-            if (mux->index_table->len > 0)
-              s.index_start_position =
-                  g_array_index (mux->index_table, MXFIndexTableSegment,
-                  mux->index_table->len - 1).index_start_position;
-            else
-              s.index_start_position = 0;
-            s.index_duration = 0;
-            s.edit_unit_byte_count = 0;
-            s.index_sid =
-                mux->preface->content_storage->
-                essence_container_data[0]->index_sid;
-            s.body_sid =
-                mux->preface->content_storage->
-                essence_container_data[0]->body_sid;
-            s.slice_count = 0;
-            s.pos_table_count = 0;
-            s.n_delta_entries = 0;
-            s.delta_entries = NULL;
-            s.n_index_entries = 0;
-            s.index_entries = g_new0 (MXFIndexEntry, max_segment_size);
-            g_array_append_val (mux->index_table, s);
-          }
-        }
-      } else {
-        while (pts_segment_pos + index_pos_diff <= 0) {
-          if (pts_index_pos == 0) {
-            pts_index_pos = G_MAXUINT64;
-            break;
-          }
-          index_pos_diff += pts_segment_pos;
-          pts_segment_pos = max_segment_size;
-          pts_index_pos--;
-        }
-      }
-      if (pts_index_pos != G_MAXUINT64) {
-        g_assert (index_pos_diff < 127 && index_pos_diff >= -127);
-        pts_segment =
-            &g_array_index (mux->index_table, MXFIndexTableSegment,
-            pts_index_pos);
-        pts_segment->index_entries[pts_segment_pos +
-            index_pos_diff].temporal_offset = -index_pos_diff;
-      }
+      g_assert (index_pos_diff < 127 && index_pos_diff >= -127);
+      entry = gst_mxf_mux_get_index_entry (mux, pad, pts_pos, NULL);
+      entry->temporal_offset = -index_pos_diff;
     }
 
-    /* Leave temporal offset initialized at 0, above code will set it as necessary */
-    ;
+    /* Leave temporal offset initialized at 0, above code will set it as
+     * necessary */
+    entry = gst_mxf_mux_get_index_entry (mux, pad, pad->pos, &segment);
+    g_assert (entry == &segment->index_entries[segment->n_index_entries]);
+
     if (is_keyframe)
       mux->last_keyframe_pos = pad->pos;
-    segment->index_entries[segment->n_index_entries].key_frame_offset =
-        MIN (pad->pos - mux->last_keyframe_pos, 127);
-    segment->index_entries[segment->n_index_entries].flags = is_keyframe ? 0x80 : 0x20; /* FIXME: Need to distinguish all the cases */
-    segment->index_entries[segment->n_index_entries].stream_offset =
-        mux->partition.body_offset;
+    entry->key_frame_offset = MIN (pad->pos - mux->last_keyframe_pos, 127);
+    /* FIXME: Need to distinguish all the cases */
+    entry->flags = is_keyframe ? 0x80 : 0x20;
+    entry->stream_offset = mux->partition.body_offset;
 
     segment->n_index_entries++;
     segment->index_duration++;
@@ -1433,6 +1575,7 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
 static GstFlowReturn
 gst_mxf_mux_write_body_partition (GstMXFMux * mux)
 {
+  MXFRandomIndexPackEntry entry;
   GstBuffer *buf;
 
   mux->partition.type = MXF_PARTITION_PACK_BODY;
@@ -1448,6 +1591,14 @@ gst_mxf_mux_write_body_partition (GstMXFMux * mux)
   mux->partition.body_sid =
       mux->preface->content_storage->essence_container_data[0]->body_sid;
 
+  g_array_set_size (mux->partitions, 0);
+  entry.offset = 0;
+  entry.body_sid = 0;
+  g_array_append_val (mux->partitions, entry);
+  entry.offset = mux->partition.this_partition;
+  entry.body_sid = mux->partition.body_sid;
+  g_array_append_val (mux->partitions, entry);
+
   buf = mxf_partition_pack_to_buffer (&mux->partition);
   return gst_mxf_mux_push (mux, buf);
 }
@@ -1567,9 +1718,9 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
 
   {
     guint64 body_partition = mux->partition.this_partition;
-    guint32 body_sid = mux->partition.body_sid;
+    guint64 first_body_partition =
+        g_array_index (mux->partitions, MXFRandomIndexPackEntry, 1).offset;
     guint64 footer_partition = mux->offset;
-    GArray *rip;
     GstFlowReturn ret;
     GstSegment segment;
     MXFRandomIndexPackEntry entry;
@@ -1610,22 +1761,14 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
     }
     g_list_free (index_entries);
 
-    rip = g_array_sized_new (FALSE, FALSE, sizeof (MXFRandomIndexPackEntry), 3);
-    entry.offset = 0;
-    entry.body_sid = 0;
-    g_array_append_val (rip, entry);
-    entry.offset = body_partition;
-    entry.body_sid = body_sid;
-    g_array_append_val (rip, entry);
     entry.offset = footer_partition;
     entry.body_sid = 0;
-    g_array_append_val (rip, entry);
+    g_array_append_val (mux->partitions, entry);
 
-    packet = mxf_random_index_pack_to_buffer (rip);
+    packet = mxf_random_index_pack_to_buffer (mux->partitions);
     if ((ret = gst_mxf_mux_push (mux, packet)) != GST_FLOW_OK) {
       GST_ERROR_OBJECT (mux, "Failed pushing random index pack");
     }
-    g_array_free (rip, TRUE);
 
     /* Rewrite header partition with updated values */
     gst_segment_init (&segment, GST_FORMAT_BYTES);
@@ -1650,7 +1793,7 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
         return ret;
       }
 
-      g_assert (mux->offset == body_partition);
+      g_assert (mux->offset == first_body_partition);
 
       mux->partition.type = MXF_PARTITION_PACK_BODY;
       mux->partition.closed = TRUE;
@@ -71,7 +71,15 @@ typedef struct _GstMXFMux {
 
   GArray *index_table;
   guint current_index_pos;
+  guint n_written_index_segments;
   guint64 last_keyframe_pos;
+
+  /* MXFRandomIndexPackEntry of all partitions written so far */
+  GArray *partitions;
+  GstClockTime last_partition_timestamp;
+
+  /* Properties */
+  GstClockTime partition_interval;
 } GstMXFMux;
 
 typedef struct _GstMXFMuxClass {
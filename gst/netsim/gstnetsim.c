@@ -98,8 +98,7 @@ static gboolean
 gst_net_sim_source_dispatch (GSource * source,
     GSourceFunc callback, gpointer user_data)
 {
-  callback (user_data);
-  return FALSE;
+  return callback (user_data);
 }
 
 GSourceFuncs gst_net_sim_source_funcs = {
@@ -109,6 +108,136 @@ GSourceFuncs gst_net_sim_source_funcs = {
   NULL                          /* finalize */
 };
 
+typedef struct
+{
+  gint64 ready_time;
+  guint64 seqnum;
+  GstBuffer *buf;
+} DelayedBuffer;
+
+/* The delayed buffers are kept in a binary min-heap on the ready time, the
+ * sequence number keeps buffers with the same ready time in arrival order. */
+static inline gboolean
+delayed_buffer_before (const DelayedBuffer * a, const DelayedBuffer * b)
+{
+  return a->ready_time < b->ready_time ||
+      (a->ready_time == b->ready_time && a->seqnum < b->seqnum);
+}
+
+static inline void
+delayed_buffer_swap (DelayedBuffer * a, DelayedBuffer * b)
+{
+  DelayedBuffer tmp = *a;
+  *a = *b;
+  *b = tmp;
+}
+
+static void
+delay_heap_push (GArray * heap, const DelayedBuffer * item)
+{
+  DelayedBuffer *d;
+  guint i, parent;
+
+  g_array_append_vals (heap, item, 1);
+  d = (DelayedBuffer *) heap->data;
+
+  for (i = heap->len - 1; i > 0; i = parent) {
+    parent = (i - 1) / 2;
+    if (!delayed_buffer_before (&d[i], &d[parent]))
+      break;
+    delayed_buffer_swap (&d[i], &d[parent]);
+  }
+}
+
+static void
+delay_heap_pop (GArray * heap, DelayedBuffer * item)
+{
+  DelayedBuffer *d = (DelayedBuffer *) heap->data;
+  guint i, len;
+
+  g_assert (heap->len > 0);
+
+  *item = d[0];
+  len = heap->len - 1;
+  d[0] = d[len];
+  g_array_set_size (heap, len);
+
+  i = 0;
+  while (TRUE) {
+    guint left = 2 * i + 1, right = left + 1, first = i;
+
+    if (left < len && delayed_buffer_before (&d[left], &d[first]))
+      first = left;
+    if (right < len && delayed_buffer_before (&d[right], &d[first]))
+      first = right;
+    if (first == i)
+      break;
+    delayed_buffer_swap (&d[i], &d[first]);
+    i = first;
+  }
+}
+
+static void
+gst_net_sim_flush_delayed (GstNetSim * netsim)
+{
+  guint i;
+
+  for (i = 0; i < netsim->delayed->len; i++)
+    gst_buffer_unref (g_array_index (netsim->delayed, DelayedBuffer, i).buf);
+  g_array_set_size (netsim->delayed, 0);
+}
+
+/* Runs on the main loop whenever the earliest delayed buffer is due, and
+ * pushes everything that is due by then in one go. */
+static gboolean
+gst_net_sim_push_delayed (GstNetSim * netsim)
+{
+  GstBufferList *list = NULL;
+  GstBuffer *first = NULL;
+  DelayedBuffer item;
+  gint64 now_time;
+
+  g_mutex_lock (&netsim->loop_mutex);
+  if (netsim->main_loop == NULL) {
+    g_mutex_unlock (&netsim->loop_mutex);
+    return G_SOURCE_REMOVE;
+  }
+
+  now_time = g_get_monotonic_time ();
+  while (netsim->delayed->len > 0 &&
+      g_array_index (netsim->delayed, DelayedBuffer, 0).ready_time <=
+      now_time) {
+    delay_heap_pop (netsim->delayed, &item);
+    if (first == NULL) {
+      first = item.buf;
+    } else {
+      if (list == NULL) {
+        list = gst_buffer_list_new ();
+        gst_buffer_list_add (list, first);
+      }
+      gst_buffer_list_add (list, item.buf);
+    }
+  }
+
+  if (netsim->delayed->len > 0)
+    g_source_set_ready_time (netsim->delay_source,
+        g_array_index (netsim->delayed, DelayedBuffer, 0).ready_time);
+  else
+    g_source_set_ready_time (netsim->delay_source, -1);
+  g_mutex_unlock (&netsim->loop_mutex);
+
+  if (list != NULL) {
+    GST_DEBUG_OBJECT (netsim, "Pushing %u delayed buffers now",
+        gst_buffer_list_length (list));
+    gst_pad_push_list (netsim->srcpad, list);
+  } else if (first != NULL) {
+    GST_DEBUG_OBJECT (netsim, "Pushing delayed buffer now");
+    gst_pad_push (netsim->srcpad, first);
+  }
+
+  return G_SOURCE_CONTINUE;
+}
+
 static void
 gst_net_sim_loop (GstNetSim * netsim)
 {
@@ -159,6 +288,13 @@ gst_net_sim_src_activatemode (GstPad * pad, GstObject * parent,
     if (netsim->main_loop == NULL) {
       GMainContext *main_context = g_main_context_new ();
       netsim->main_loop = g_main_loop_new (main_context, FALSE);
+
+      /* A single source takes care of all delayed buffers */
+      netsim->delay_source =
+          g_source_new (&gst_net_sim_source_funcs, sizeof (GSource));
+      g_source_set_callback (netsim->delay_source,
+          (GSourceFunc) gst_net_sim_push_delayed, netsim, NULL);
+      g_source_attach (netsim->delay_source, main_context);
       g_main_context_unref (main_context);
 
       GST_TRACE_OBJECT (netsim, "ACT: Starting task on srcpad");
@@ -179,6 +315,10 @@ gst_net_sim_src_activatemode (GstPad * pad, GstObject * parent,
       /* Adds an Idle Source which quits the main loop from within.
        * This removes the possibility for run/quit race conditions. */
       GST_TRACE_OBJECT (netsim, "DEACT: Stopping main loop on deactivate");
+      g_source_destroy (netsim->delay_source);
+      g_source_unref (netsim->delay_source);
+      netsim->delay_source = NULL;
+
       source = g_idle_source_new ();
       g_source_set_callback (source, _main_loop_quit_and_remove_source,
           g_main_loop_ref (netsim->main_loop),
@@ -198,6 +338,8 @@ gst_net_sim_src_activatemode (GstPad * pad, GstObject * parent,
       GST_TRACE_OBJECT (netsim, "DEACT: Stopping task on srcpad");
       result = gst_pad_stop_task (netsim->srcpad);
       GST_TRACE_OBJECT (netsim, "DEACT: Mainloop and GstTask stopped");
+
+      gst_net_sim_flush_delayed (netsim);
     }
   }
   g_mutex_unlock (&netsim->loop_mutex);
@@ -205,38 +347,6 @@ gst_net_sim_src_activatemode (GstPad * pad, GstObject * parent,
   return result;
 }
 
-typedef struct
-{
-  GstPad *pad;
-  GstBuffer *buf;
-} PushBufferCtx;
-
-static inline PushBufferCtx *
-push_buffer_ctx_new (GstPad * pad, GstBuffer * buf)
-{
-  PushBufferCtx *ctx = g_slice_new (PushBufferCtx);
-  ctx->pad = gst_object_ref (pad);
-  ctx->buf = gst_buffer_ref (buf);
-  return ctx;
-}
-
-static inline void
-push_buffer_ctx_free (PushBufferCtx * ctx)
-{
-  if (G_LIKELY (ctx != NULL)) {
-    gst_buffer_unref (ctx->buf);
-    gst_object_unref (ctx->pad);
-    g_slice_free (PushBufferCtx, ctx);
-  }
-}
-
-static gboolean
-push_buffer_ctx_push (PushBufferCtx * ctx)
-{
-  GST_DEBUG_OBJECT (ctx->pad, "Pushing buffer now");
-  gst_pad_push (ctx->pad, gst_buffer_ref (ctx->buf));
-  return FALSE;
-}
 
 static gint
 get_random_value_uniform (GRand * rand_seed, gint32 min_value, gint32 max_value)
@@ -326,17 +436,18 @@ get_random_value_gamma (GRand * rand_seed, gint32 low, gint32 high,
   return round (x + low);
 }
 
-static GstFlowReturn
+/* Returns TRUE if the buffer will be pushed later, FALSE if it should be
+ * pushed right away */
+static gboolean
 gst_net_sim_delay_buffer (GstNetSim * netsim, GstBuffer * buf)
 {
-  GstFlowReturn ret = GST_FLOW_OK;
+  gboolean delayed = FALSE;
 
   g_mutex_lock (&netsim->loop_mutex);
   if (netsim->main_loop != NULL && netsim->delay_probability > 0 &&
       g_rand_double (netsim->rand_seed) < netsim->delay_probability) {
     gint delay;
-    PushBufferCtx *ctx;
-    GSource *source;
+    DelayedBuffer item;
     gint64 ready_time, now_time;
 
     switch (netsim->delay_distribution) {
@@ -360,9 +471,6 @@ gst_net_sim_delay_buffer (GstNetSim * netsim, GstBuffer * buf)
     if (delay < 0)
       delay = 0;
 
-    ctx = push_buffer_ctx_new (netsim->srcpad, buf);
-
-    source = g_source_new (&gst_net_sim_source_funcs, sizeof (GSource));
     now_time = g_get_monotonic_time ();
     ready_time = now_time + delay * 1000;
     if (!netsim->allow_reordering && ready_time < netsim->last_ready_time)
@@ -372,17 +480,21 @@ gst_net_sim_delay_buffer (GstNetSim * netsim, GstBuffer * buf)
     GST_DEBUG_OBJECT (netsim, "Delaying packet by %" G_GINT64_FORMAT "ms",
         (ready_time - now_time) / 1000);
 
-    g_source_set_ready_time (source, ready_time);
-    g_source_set_callback (source, (GSourceFunc) push_buffer_ctx_push,
-        ctx, (GDestroyNotify) push_buffer_ctx_free);
-    g_source_attach (source, g_main_loop_get_context (netsim->main_loop));
-    g_source_unref (source);
-  } else {
-    ret = gst_pad_push (netsim->srcpad, gst_buffer_ref (buf));
+    /* Only wake up the main loop if this one is due before all others */
+    if (netsim->delayed->len == 0 ||
+        ready_time < g_array_index (netsim->delayed, DelayedBuffer,
+            0).ready_time)
+      g_source_set_ready_time (netsim->delay_source, ready_time);
+
+    item.ready_time = ready_time;
+    item.seqnum = netsim->delayed_seqnum++;
+    item.buf = gst_buffer_ref (buf);
+    delay_heap_push (netsim->delayed, &item);
+    delayed = TRUE;
   }
   g_mutex_unlock (&netsim->loop_mutex);
 
-  return ret;
+  return delayed;
 }
 
 static gint
@@ -468,14 +580,15 @@ gst_net_sim_token_bucket (GstNetSim * netsim, GstBuffer * buf)
   return TRUE;
 }
 
-static GstFlowReturn
-gst_net_sim_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+/* Drops, duplicates or delays the buffer. Returns how many copies of it are
+ * to be pushed right away */
+static guint
+gst_net_sim_process_buffer (GstNetSim * netsim, GstBuffer * buf)
 {
-  GstNetSim *netsim = GST_NET_SIM (parent);
-  GstFlowReturn ret = GST_FLOW_OK;
+  guint n_push = 0;
 
   if (!gst_net_sim_token_bucket (netsim, buf))
-    goto done;
+    return 0;
 
   if (netsim->drop_packets > 0) {
     netsim->drop_packets--;
@@ -489,17 +602,61 @@ gst_net_sim_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
       g_rand_double (netsim->rand_seed) <
       (gdouble) netsim->duplicate_probability) {
     GST_DEBUG_OBJECT (netsim, "Duplicating packet");
-    gst_net_sim_delay_buffer (netsim, buf);
-    ret = gst_net_sim_delay_buffer (netsim, buf);
+    if (!gst_net_sim_delay_buffer (netsim, buf))
+      n_push++;
+    if (!gst_net_sim_delay_buffer (netsim, buf))
+      n_push++;
   } else {
-    ret = gst_net_sim_delay_buffer (netsim, buf);
+    if (!gst_net_sim_delay_buffer (netsim, buf))
+      n_push++;
   }
 
-done:
+  return n_push;
+}
+
+static GstFlowReturn
+gst_net_sim_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+  GstNetSim *netsim = GST_NET_SIM (parent);
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint n_push;
+
+  n_push = gst_net_sim_process_buffer (netsim, buf);
+  while (n_push-- > 0)
+    ret = gst_pad_push (netsim->srcpad, gst_buffer_ref (buf));
+
   gst_buffer_unref (buf);
   return ret;
 }
 
+static GstFlowReturn
+gst_net_sim_chain_list (GstPad * pad, GstObject * parent, GstBufferList * list)
+{
+  GstNetSim *netsim = GST_NET_SIM (parent);
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstBufferList *out;
+  guint i, len, n_push;
+
+  len = gst_buffer_list_length (list);
+  out = gst_buffer_list_new_sized (len);
+
+  for (i = 0; i < len; i++) {
+    GstBuffer *buf = gst_buffer_list_get (list, i);
+
+    n_push = gst_net_sim_process_buffer (netsim, buf);
+    while (n_push-- > 0)
+      gst_buffer_list_add (out, gst_buffer_ref (buf));
+  }
+  gst_buffer_list_unref (list);
+
+  if (gst_buffer_list_length (out) > 0)
+    ret = gst_pad_push_list (netsim->srcpad, out);
+  else
+    gst_buffer_list_unref (out);
+
+  return ret;
+}
+
 
 static void
 gst_net_sim_set_property (GObject * object,
@@ -605,6 +762,9 @@ gst_net_sim_init (GstNetSim * netsim)
   g_cond_init (&netsim->start_cond);
   netsim->rand_seed = g_rand_new ();
   netsim->main_loop = NULL;
+  netsim->delay_source = NULL;
+  netsim->delayed = g_array_new (FALSE, FALSE, sizeof (DelayedBuffer));
+  netsim->delayed_seqnum = 0;
   netsim->prev_time = GST_CLOCK_TIME_NONE;
 
   GST_OBJECT_FLAG_SET (netsim->sinkpad,
@@ -612,6 +772,8 @@ gst_net_sim_init (GstNetSim * netsim)
 
   gst_pad_set_chain_function (netsim->sinkpad,
       GST_DEBUG_FUNCPTR (gst_net_sim_chain));
+  gst_pad_set_chain_list_function (netsim->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_net_sim_chain_list));
   gst_pad_set_activatemode_function (netsim->srcpad,
       GST_DEBUG_FUNCPTR (gst_net_sim_src_activatemode));
 }
@@ -621,6 +783,8 @@ gst_net_sim_finalize (GObject * object)
 {
   GstNetSim *netsim = GST_NET_SIM (object);
 
+  gst_net_sim_flush_delayed (netsim);
+  g_array_free (netsim->delayed, TRUE);
   g_rand_free (netsim->rand_seed);
   g_mutex_clear (&netsim->loop_mutex);
   g_cond_clear (&netsim->start_cond);
@@ -70,6 +70,9 @@ struct _GstNetSim
   GMutex loop_mutex;
   GCond start_cond;
   GMainLoop *main_loop;
+  GSource *delay_source;
+  GArray *delayed;
+  guint64 delayed_seqnum;
   gboolean running;
   GRand *rand_seed;
   gsize bucket_size;
@@ -26,8 +26,14 @@
  * #GstPcapParse:src-port and #GstPcapParse:dst-port to restrict which packets
  * should be included.
  *
- * The supported data format is the classical
+ * The supported data formats are the classical
  * [libpcap file format](https://wiki.wireshark.org/Development/LibpcapFileFormat)
+ * and, since 1.20, the
+ * [pcapng file format](https://wiki.wireshark.org/Development/PcapNg).
+ *
+ * With #GstPcapParse:multi-stream, the payload of each UDP or TCP flow that
+ * passes the filters is output on its own `src_%u` pad instead, so that
+ * several streams can be extracted from a capture in one pass.
  *
  * ## Example pipelines
  * |[
@@ -35,6 +41,10 @@
  * ! ffdec_h264 ! fakesink
  * ]| Read from a pcap dump file using filesrc, extract the raw UDP packets,
  * depayload and decode them.
+ * |[
+ * gst-launch-1.0 filesrc location=capture.pcapng ! pcapparse multi-stream=true
+ * name=p p.src_0 ! fakesink p.src_1 ! fakesink
+ * ]| Extract the first two flows of a pcapng capture.
  *
  */
 
@@ -64,6 +74,34 @@ const guint GST_PCAPPARSE_MAGIC_NANOSECOND_NO_SWAP_ENDIAN = 0xa1b23c4d;
 const guint GST_PCAPPARSE_MAGIC_MILLISECOND_SWAP_ENDIAN = 0xd4c3b2a1;
 const guint GST_PCAPPARSE_MAGIC_NANOSECOND_SWAP_ENDIAN = 0x4d3cb2a1;
 
+#define PCAPNG_BLOCK_TYPE_IDB 0x00000001
+#define PCAPNG_BLOCK_TYPE_OPB 0x00000002
+#define PCAPNG_BLOCK_TYPE_SPB 0x00000003
+#define PCAPNG_BLOCK_TYPE_EPB 0x00000006
+#define PCAPNG_BLOCK_TYPE_SHB 0x0a0d0d0a
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1a2b3c4d
+
+#define PCAPNG_OPT_ENDOFOPT 0
+#define PCAPNG_OPT_IF_TSRESOL 9
+
+/* Identifies a flow in multi-stream mode */
+typedef struct
+{
+  guint32 src_ip;
+  guint32 dst_ip;
+  guint16 src_port;
+  guint16 dst_port;
+  guint8 protocol;
+} GstPcapParseStreamKey;
+
+typedef struct
+{
+  GstPcapParseStreamKey key;
+  GstPad *pad;
+  gboolean first_packet;
+  GstBufferList *list;
+} GstPcapParseStream;
+
 
 enum
 {
@@ -73,9 +111,12 @@ enum
   PROP_SRC_PORT,
   PROP_DST_PORT,
   PROP_CAPS,
-  PROP_TS_OFFSET
+  PROP_TS_OFFSET,
+  PROP_MULTI_STREAM
 };
 
+#define DEFAULT_MULTI_STREAM FALSE
+
 GST_DEBUG_CATEGORY_STATIC (gst_pcap_parse_debug);
 #define GST_CAT_DEFAULT gst_pcap_parse_debug
 
@@ -89,6 +130,12 @@ static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS_ANY);
 
+static GstStaticPadTemplate src_stream_template =
+GST_STATIC_PAD_TEMPLATE ("src_%u",
+    GST_PAD_SRC,
+    GST_PAD_SOMETIMES,
+    GST_STATIC_CAPS_ANY);
+
 static void gst_pcap_parse_finalize (GObject * object);
 static void gst_pcap_parse_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
@@ -98,6 +145,7 @@ static GstStateChangeReturn
 gst_pcap_parse_change_state (GstElement * element, GstStateChange transition);
 
 static void gst_pcap_parse_reset (GstPcapParse * self);
+static void gst_pcap_parse_remove_streams (GstPcapParse * self);
 
 static GstFlowReturn gst_pcap_parse_chain (GstPad * pad,
     GstObject * parent, GstBuffer * buffer);
@@ -108,6 +156,33 @@ static gboolean gst_pcap_sink_event (GstPad * pad,
 #define parent_class gst_pcap_parse_parent_class
 G_DEFINE_TYPE (GstPcapParse, gst_pcap_parse, GST_TYPE_ELEMENT);
 
+static guint
+gst_pcap_parse_stream_key_hash (gconstpointer v)
+{
+  const GstPcapParseStreamKey *key = v;
+
+  return key->src_ip ^ (key->dst_ip * 31) ^
+      ((key->src_port << 16) | key->dst_port) ^ key->protocol;
+}
+
+static gboolean
+gst_pcap_parse_stream_key_equal (gconstpointer v1, gconstpointer v2)
+{
+  const GstPcapParseStreamKey *k1 = v1, *k2 = v2;
+
+  return k1->src_ip == k2->src_ip && k1->dst_ip == k2->dst_ip &&
+      k1->src_port == k2->src_port && k1->dst_port == k2->dst_port &&
+      k1->protocol == k2->protocol;
+}
+
+static void
+gst_pcap_parse_stream_free (GstPcapParseStream * stream)
+{
+  if (stream->list)
+    gst_buffer_list_unref (stream->list);
+  g_free (stream);
+}
+
 static void
 gst_pcap_parse_class_init (GstPcapParseClass * klass)
 {
@@ -148,8 +223,23 @@ gst_pcap_parse_class_init (GstPcapParseClass * klass)
           "Relative timestamp offset (ns) to apply (-1 = use absolute packet time)",
           -1, G_MAXINT64, -1, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstPcapParse:multi-stream:
+   *
+   * Output the payload of each flow, identified by its addresses, ports
+   * and protocol, on its own `src_%u` pad instead of the `src` pad.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_MULTI_STREAM,
+      g_param_spec_boolean ("multi-stream", "Multi Stream",
+          "Output each flow on its own pad", DEFAULT_MULTI_STREAM,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (element_class, &sink_template);
   gst_element_class_add_static_pad_template (element_class, &src_template);
+  gst_element_class_add_static_pad_template (element_class,
+      &src_stream_template);
 
   element_class->change_state = gst_pcap_parse_change_state;
 
@@ -181,8 +271,15 @@ gst_pcap_parse_init (GstPcapParse * self)
   self->src_port = -1;
   self->dst_port = -1;
   self->offset = -1;
+  self->multi_stream = DEFAULT_MULTI_STREAM;
 
   self->adapter = gst_adapter_new ();
+  self->interfaces =
+      g_array_new (FALSE, FALSE, sizeof (GstPcapParseInterface));
+  self->streams = g_hash_table_new_full (gst_pcap_parse_stream_key_hash,
+      gst_pcap_parse_stream_key_equal, NULL,
+      (GDestroyNotify) gst_pcap_parse_stream_free);
+  self->flowcombiner = gst_flow_combiner_new ();
 
   gst_pcap_parse_reset (self);
 }
@@ -192,6 +289,9 @@ gst_pcap_parse_finalize (GObject * object)
 {
   GstPcapParse *self = GST_PCAP_PARSE (object);
 
+  g_hash_table_unref (self->streams);
+  gst_flow_combiner_free (self->flowcombiner);
+  g_array_free (self->interfaces, TRUE);
   g_object_unref (self->adapter);
   if (self->caps)
     gst_caps_unref (self->caps);
@@ -254,6 +354,10 @@ gst_pcap_parse_get_property (GObject * object, guint prop_id,
       g_value_set_int64 (value, self->offset);
       break;
 
+    case PROP_MULTI_STREAM:
+      g_value_set_boolean (value, self->multi_stream);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -308,6 +412,10 @@ gst_pcap_parse_set_property (GObject * object, guint prop_id,
       self->offset = g_value_get_int64 (value);
       break;
 
+    case PROP_MULTI_STREAM:
+      self->multi_stream = g_value_get_boolean (value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -325,10 +433,94 @@ gst_pcap_parse_reset (GstPcapParse * self)
   self->base_ts = GST_CLOCK_TIME_NONE;
   self->newsegment_sent = FALSE;
   self->first_packet = TRUE;
+  self->pcapng = FALSE;
+  g_array_set_size (self->interfaces, 0);
 
   gst_adapter_clear (self->adapter);
 }
 
+static void
+gst_pcap_parse_remove_streams (GstPcapParse * self)
+{
+  GHashTableIter iter;
+  gpointer value;
+
+  g_hash_table_iter_init (&iter, self->streams);
+  while (g_hash_table_iter_next (&iter, NULL, &value)) {
+    GstPcapParseStream *stream = value;
+
+    gst_flow_combiner_remove_pad (self->flowcombiner, stream->pad);
+    gst_pad_set_active (stream->pad, FALSE);
+    gst_element_remove_pad (GST_ELEMENT_CAST (self), stream->pad);
+  }
+  g_hash_table_remove_all (self->streams);
+  self->n_streams = 0;
+}
+
+static GstPcapParseStream *
+gst_pcap_parse_get_stream (GstPcapParse * self,
+    const GstPcapParseStreamKey * key)
+{
+  GstPcapParseStream *stream;
+  GstSegment segment;
+  gchar *name, *stream_id;
+
+  stream = g_hash_table_lookup (self->streams, key);
+  if (stream)
+    return stream;
+
+  stream = g_new0 (GstPcapParseStream, 1);
+  stream->key = *key;
+  stream->first_packet = TRUE;
+
+  name = g_strdup_printf ("src_%u", self->n_streams++);
+  stream->pad = gst_pad_new_from_static_template (&src_stream_template, name);
+  g_free (name);
+
+  GST_DEBUG_OBJECT (self, "New flow %08x:%u -> %08x:%u (protocol %u) on %"
+      GST_PTR_FORMAT, g_ntohl (key->src_ip), key->src_port,
+      g_ntohl (key->dst_ip), key->dst_port, key->protocol, stream->pad);
+
+  gst_pad_use_fixed_caps (stream->pad);
+  gst_pad_set_active (stream->pad, TRUE);
+
+  stream_id = gst_pad_create_stream_id_printf (stream->pad,
+      GST_ELEMENT_CAST (self), "%08x:%u-%08x:%u-%u", g_ntohl (key->src_ip),
+      key->src_port, g_ntohl (key->dst_ip), key->dst_port, key->protocol);
+  gst_pad_push_event (stream->pad, gst_event_new_stream_start (stream_id));
+  g_free (stream_id);
+
+  if (self->caps)
+    gst_pad_set_caps (stream->pad, self->caps);
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  if (GST_CLOCK_TIME_IS_VALID (self->base_ts))
+    segment.start = self->base_ts;
+  gst_pad_push_event (stream->pad, gst_event_new_segment (&segment));
+
+  g_hash_table_insert (self->streams, &stream->key, stream);
+  gst_flow_combiner_add_pad (self->flowcombiner, stream->pad);
+  gst_element_add_pad (GST_ELEMENT_CAST (self), stream->pad);
+
+  return stream;
+}
+
+static guint16
+gst_pcap_parse_read_uint16 (GstPcapParse * self, const guint8 * p)
+{
+  guint16 val = *((guint16 *) p);
+
+  if (self->swap_endian) {
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+    return GUINT16_FROM_BE (val);
+#else
+    return GUINT16_FROM_LE (val);
+#endif
+  } else {
+    return val;
+  }
+}
+
 static guint32
 gst_pcap_parse_read_uint32 (GstPcapParse * self, const guint8 * p)
 {
@@ -357,9 +549,9 @@ gst_pcap_parse_read_uint32 (GstPcapParse * self, const guint8 * p)
 
 
 static gboolean
-gst_pcap_parse_scan_frame (GstPcapParse * self,
-    const guint8 * buf,
-    gint buf_size, const guint8 ** payload, gint * payload_size)
+gst_pcap_parse_scan_frame (GstPcapParse * self, GstPcapParseLinktype linktype,
+    const guint8 * buf, gint buf_size, const guint8 ** payload,
+    gint * payload_size, GstPcapParseStreamKey * key)
 {
   const guint8 *buf_ip = 0;
   const guint8 *buf_proto;
@@ -376,7 +568,7 @@ gst_pcap_parse_scan_frame (GstPcapParse * self,
   guint16 len;
   guint16 ip_packet_len;
 
-  switch (self->linktype) {
+  switch (linktype) {
     case LINKTYPE_ETHER:
       if (buf_size < ETH_HEADER_LEN + IP_HEADER_MIN_LEN + UDP_HEADER_LEN)
         return FALSE;
@@ -417,7 +609,7 @@ gst_pcap_parse_scan_frame (GstPcapParse * self,
   if (eth_type != 0x800) {
     GST_ERROR_OBJECT (self,
         "Link type %d: Ethernet type %d is not supported; only type 0x800",
-        (gint) self->linktype, (gint) eth_type);
+        (gint) linktype, (gint) eth_type);
     return FALSE;
   }
 
@@ -473,6 +665,8 @@ gst_pcap_parse_scan_frame (GstPcapParse * self,
     /* all remaining data following tcp header is payload */
     *payload = buf_proto + len;
     *payload_size = ip_packet_len - ip_header_size - len;
+    if (*payload_size < 0 || *payload + *payload_size > buf + buf_size)
+      return FALSE;
   }
 
   /* but still filter as configured */
@@ -488,6 +682,230 @@ gst_pcap_parse_scan_frame (GstPcapParse * self,
   if (self->dst_port >= 0 && dst_port != self->dst_port)
     return FALSE;
 
+  key->src_ip = ip_src_addr;
+  key->dst_ip = ip_dst_addr;
+  key->src_port = src_port;
+  key->dst_port = dst_port;
+  key->protocol = ip_protocol;
+
+  return TRUE;
+}
+
+/* Examines the packet of @packet_size bytes at @packet_offset in the
+ * @block_size bytes of adapter data mapped at @data, and adds its payload
+ * to the pending list of its pad. Unmaps and flushes the block */
+static void
+gst_pcap_parse_handle_packet (GstPcapParse * self, const guint8 * data,
+    gsize block_size, gsize packet_offset, gsize packet_size,
+    GstPcapParseLinktype linktype, GstBufferList ** list)
+{
+  const guint8 *payload_data;
+  gint payload_size;
+  GstPcapParseStreamKey key;
+  GstBuffer *out_buf;
+  gboolean *first_packet;
+  guintptr offset;
+
+  GST_LOG_OBJECT (self, "examining packet size %" G_GSIZE_FORMAT,
+      packet_size);
+
+  if (!gst_pcap_parse_scan_frame (self, linktype, data + packet_offset,
+          packet_size, &payload_data, &payload_size, &key)) {
+    gst_adapter_unmap (self->adapter);
+    gst_adapter_flush (self->adapter, block_size);
+    return;
+  }
+
+  offset = payload_data - data;
+
+  gst_adapter_unmap (self->adapter);
+  gst_adapter_flush (self->adapter, offset);
+  /* we don't use _take_buffer_fast() on purpose here, we need a
+   * buffer with a single memory, since the RTP depayloaders expect
+   * the complete RTP header to be in the first memory if there are
+   * multiple ones and we can't guarantee that with _fast() */
+  if (payload_size > 0) {
+    out_buf = gst_adapter_take_buffer (self->adapter, payload_size);
+  } else {
+    out_buf = gst_buffer_new ();
+  }
+  gst_adapter_flush (self->adapter, block_size - offset - payload_size);
+
+  if (GST_CLOCK_TIME_IS_VALID (self->cur_ts)) {
+    if (!GST_CLOCK_TIME_IS_VALID (self->base_ts))
+      self->base_ts = self->cur_ts;
+    if (self->offset >= 0) {
+      self->cur_ts -= self->base_ts;
+      self->cur_ts += self->offset;
+    }
+  }
+  GST_BUFFER_TIMESTAMP (out_buf) = self->cur_ts;
+
+  if (self->multi_stream) {
+    GstPcapParseStream *stream = gst_pcap_parse_get_stream (self, &key);
+
+    first_packet = &stream->first_packet;
+    list = &stream->list;
+  } else {
+    first_packet = &self->first_packet;
+  }
+
+  /* only first packet should have DISCONT flag */
+  if (G_LIKELY (!*first_packet)) {
+    GST_BUFFER_FLAG_UNSET (out_buf, GST_BUFFER_FLAG_DISCONT);
+  } else {
+    GST_BUFFER_FLAG_SET (out_buf, GST_BUFFER_FLAG_DISCONT);
+    *first_packet = FALSE;
+  }
+
+  if (*list == NULL)
+    *list = gst_buffer_list_new ();
+  gst_buffer_list_add (*list, out_buf);
+}
+
+static void
+gst_pcap_parse_ng_add_interface (GstPcapParse * self, const guint8 * data,
+    guint32 block_len)
+{
+  GstPcapParseInterface iface;
+  guint32 pos = 16;
+
+  if (block_len < 20) {
+    GST_WARNING_OBJECT (self, "Invalid interface description block");
+    return;
+  }
+
+  iface.linktype = gst_pcap_parse_read_uint16 (self, data + 8);
+  iface.ts_units_per_sec = G_USEC_PER_SEC;
+
+  while (pos + 4 <= block_len - 4) {
+    guint16 code = gst_pcap_parse_read_uint16 (self, data + pos);
+    guint16 len = gst_pcap_parse_read_uint16 (self, data + pos + 2);
+
+    if (code == PCAPNG_OPT_ENDOFOPT || pos + 4 + len > block_len - 4)
+      break;
+
+    if (code == PCAPNG_OPT_IF_TSRESOL && len >= 1) {
+      guint8 tsresol = data[pos + 4];
+      guint64 units = 0;
+
+      if (tsresol & 0x80) {
+        if ((tsresol & 0x7f) < 64)
+          units = G_GUINT64_CONSTANT (1) << (tsresol & 0x7f);
+      } else if (tsresol <= 19) {
+        units = 1;
+        while (tsresol--)
+          units *= 10;
+      }
+
+      if (units > 0)
+        iface.ts_units_per_sec = units;
+      else
+        GST_WARNING_OBJECT (self, "Unsupported timestamp resolution");
+    }
+
+    pos += 4 + GST_ROUND_UP_4 (len);
+  }
+
+  if (iface.linktype != LINKTYPE_ETHER && iface.linktype != LINKTYPE_SLL &&
+      iface.linktype != LINKTYPE_RAW) {
+    GST_WARNING_OBJECT (self, "Interface %u has unsupported link type %d, "
+        "skipping its packets", self->interfaces->len, iface.linktype);
+  }
+
+  GST_DEBUG_OBJECT (self, "interface %u: linktype %u, %" G_GUINT64_FORMAT
+      " timestamp units per second", self->interfaces->len, iface.linktype,
+      iface.ts_units_per_sec);
+
+  g_array_append_val (self->interfaces, iface);
+}
+
+/* Handles the pcapng block of @block_len bytes of adapter data mapped at
+ * @data. Unmaps and flushes the block */
+static gboolean
+gst_pcap_parse_ng_block (GstPcapParse * self, const guint8 * data,
+    guint32 block_type, guint32 block_len, GstBufferList ** list)
+{
+  GstPcapParseInterface *iface;
+  guint32 if_id, packet_offset, packet_size;
+  guint64 ts = GST_CLOCK_TIME_NONE;
+
+  switch (block_type) {
+    case PCAPNG_BLOCK_TYPE_SHB:{
+      guint16 major_version;
+
+      if (block_len < 28)
+        goto invalid;
+
+      major_version = gst_pcap_parse_read_uint16 (self, data + 12);
+      if (major_version != 1) {
+        gst_adapter_unmap (self->adapter);
+        GST_ELEMENT_ERROR (self, STREAM, WRONG_TYPE, (NULL),
+            ("File is not a pcapng major version 1, but %u",
+                major_version));
+        return FALSE;
+      }
+
+      /* Interfaces are numbered per section */
+      g_array_set_size (self->interfaces, 0);
+      goto skip;
+    }
+    case PCAPNG_BLOCK_TYPE_IDB:
+      gst_pcap_parse_ng_add_interface (self, data, block_len);
+      goto skip;
+    case PCAPNG_BLOCK_TYPE_EPB:
+    case PCAPNG_BLOCK_TYPE_OPB:
+      if (block_len < 32)
+        goto invalid;
+
+      if (block_type == PCAPNG_BLOCK_TYPE_EPB)
+        if_id = gst_pcap_parse_read_uint32 (self, data + 8);
+      else
+        if_id = gst_pcap_parse_read_uint16 (self, data + 8);
+      ts = ((guint64) gst_pcap_parse_read_uint32 (self, data + 12) << 32) |
+          gst_pcap_parse_read_uint32 (self, data + 16);
+      packet_size = gst_pcap_parse_read_uint32 (self, data + 20);
+      packet_offset = 28;
+      break;
+    case PCAPNG_BLOCK_TYPE_SPB:
+      if (block_len < 16)
+        goto invalid;
+
+      if_id = 0;
+      packet_size = MIN (gst_pcap_parse_read_uint32 (self, data + 8),
+          block_len - 16);
+      packet_offset = 12;
+      break;
+    default:
+      GST_LOG_OBJECT (self, "skipping block of type 0x%08x", block_type);
+      goto skip;
+  }
+
+  if (packet_size > block_len - 4 - packet_offset)
+    goto invalid;
+
+  if (if_id >= self->interfaces->len) {
+    GST_WARNING_OBJECT (self, "Packet for unknown interface %u", if_id);
+    goto skip;
+  }
+
+  iface = &g_array_index (self->interfaces, GstPcapParseInterface, if_id);
+  if (ts != GST_CLOCK_TIME_NONE)
+    self->cur_ts = gst_util_uint64_scale (ts, GST_SECOND,
+        iface->ts_units_per_sec);
+  else
+    self->cur_ts = GST_CLOCK_TIME_NONE;
+
+  gst_pcap_parse_handle_packet (self, data, block_len, packet_offset,
+      packet_size, iface->linktype, list);
+
+  return TRUE;
+
+invalid:
+  GST_WARNING_OBJECT (self, "Invalid block of type 0x%08x", block_type);
+skip:
+  gst_adapter_unmap (self->adapter);
+  gst_adapter_flush (self->adapter, block_len);
   return TRUE;
 }
 
@@ -506,67 +924,62 @@ gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 
     avail = gst_adapter_available (self->adapter);
 
-    if (self->initialized) {
+    if (self->initialized && self->pcapng) {
+      guint32 block_type, block_len;
+
+      /* Smallest block with its type and both lengths */
+      if (avail < 12)
+        break;
+
+      data = gst_adapter_map (self->adapter, 12);
+
+      /* The section header block type reads the same in both byte orders
+       * and sets the byte order of the section */
+      if (*((guint32 *) data) == PCAPNG_BLOCK_TYPE_SHB) {
+        guint32 magic = *((guint32 *) (data + 8));
+
+        if (magic == PCAPNG_BYTE_ORDER_MAGIC) {
+          self->swap_endian = FALSE;
+        } else if (magic == GUINT32_SWAP_LE_BE (PCAPNG_BYTE_ORDER_MAGIC)) {
+          self->swap_endian = TRUE;
+        } else {
+          gst_adapter_unmap (self->adapter);
+          GST_ELEMENT_ERROR (self, STREAM, WRONG_TYPE, (NULL),
+              ("Invalid pcapng byte order magic %X", magic));
+          ret = GST_FLOW_ERROR;
+          goto out;
+        }
+      }
+
+      block_type = gst_pcap_parse_read_uint32 (self, data);
+      block_len = gst_pcap_parse_read_uint32 (self, data + 4);
+      gst_adapter_unmap (self->adapter);
+
+      if (block_len < 12 || block_len % 4 != 0) {
+        GST_ELEMENT_ERROR (self, STREAM, DECODE, (NULL),
+            ("Invalid pcapng block length %u", block_len));
+        ret = GST_FLOW_ERROR;
+        goto out;
+      }
+
+      if (avail < block_len)
+        break;
+
+      data = gst_adapter_map (self->adapter, block_len);
+      if (!gst_pcap_parse_ng_block (self, data, block_type, block_len, &list)) {
+        ret = GST_FLOW_ERROR;
+        goto out;
+      }
+    } else if (self->initialized) {
       if (self->cur_packet_size >= 0) {
         /* Parse the Packet Data */
         if (avail < self->cur_packet_size)
           break;
 
         if (self->cur_packet_size > 0) {
-          const guint8 *payload_data;
-          gint payload_size;
-
           data = gst_adapter_map (self->adapter, self->cur_packet_size);
-
-          GST_LOG_OBJECT (self, "examining packet size %" G_GINT64_FORMAT,
-              self->cur_packet_size);
-
-          if (gst_pcap_parse_scan_frame (self, data, self->cur_packet_size,
-                  &payload_data, &payload_size)) {
-            GstBuffer *out_buf;
-            guintptr offset = payload_data - data;
-
-            gst_adapter_unmap (self->adapter);
-            gst_adapter_flush (self->adapter, offset);
-            /* we don't use _take_buffer_fast() on purpose here, we need a
-             * buffer with a single memory, since the RTP depayloaders expect
-             * the complete RTP header to be in the first memory if there are
-             * multiple ones and we can't guarantee that with _fast() */
-            if (payload_size > 0) {
-              out_buf = gst_adapter_take_buffer (self->adapter, payload_size);
-            } else {
-              out_buf = gst_buffer_new ();
-            }
-
-            /* only first packet should have DISCONT flag */
-            if (G_LIKELY (!self->first_packet)) {
-              GST_BUFFER_FLAG_UNSET (out_buf, GST_BUFFER_FLAG_DISCONT);
-            } else {
-              GST_BUFFER_FLAG_SET (out_buf, GST_BUFFER_FLAG_DISCONT);
-              self->first_packet = FALSE;
-            }
-
-            gst_adapter_flush (self->adapter,
-                self->cur_packet_size - offset - payload_size);
-
-            if (GST_CLOCK_TIME_IS_VALID (self->cur_ts)) {
-              if (!GST_CLOCK_TIME_IS_VALID (self->base_ts))
-                self->base_ts = self->cur_ts;
-              if (self->offset >= 0) {
-                self->cur_ts -= self->base_ts;
-                self->cur_ts += self->offset;
-              }
-            }
-            GST_BUFFER_TIMESTAMP (out_buf) = self->cur_ts;
-
-
-            if (list == NULL)
-              list = gst_buffer_list_new ();
-            gst_buffer_list_add (list, out_buf);
-          } else {
-            gst_adapter_unmap (self->adapter);
-            gst_adapter_flush (self->adapter, self->cur_packet_size);
-          }
+          gst_pcap_parse_handle_packet (self, data, self->cur_packet_size, 0,
+              self->cur_packet_size, self->linktype, &list);
         }
 
         self->cur_packet_size = -1;
@@ -612,6 +1025,14 @@ gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
       linktype = *((guint32 *) (data + 20));
       gst_adapter_unmap (self->adapter);
 
+      if (magic == PCAPNG_BLOCK_TYPE_SHB) {
+        /* Handled like any other block */
+        GST_DEBUG_OBJECT (self, "pcapng file");
+        self->pcapng = TRUE;
+        self->initialized = TRUE;
+        continue;
+      }
+
       if (magic == GST_PCAPPARSE_MAGIC_MILLISECOND_NO_SWAP_ENDIAN ||
           magic == GST_PCAPPARSE_MAGIC_NANOSECOND_NO_SWAP_ENDIAN) {
         self->swap_endian = FALSE;
@@ -626,7 +1047,7 @@ gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
         linktype = GUINT32_SWAP_LE_BE (linktype);
       } else {
         GST_ELEMENT_ERROR (self, STREAM, WRONG_TYPE, (NULL),
-            ("File is not a libpcap file, magic is %X", magic));
+            ("File is not a libpcap or pcapng file, magic is %X", magic));
         ret = GST_FLOW_ERROR;
         goto out;
       }
@@ -671,6 +1092,25 @@ gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
     list = NULL;
   }
 
+  if (self->multi_stream && ret == GST_FLOW_OK) {
+    GHashTableIter iter;
+    gpointer value;
+
+    g_hash_table_iter_init (&iter, self->streams);
+    while (g_hash_table_iter_next (&iter, NULL, &value)) {
+      GstPcapParseStream *stream = value;
+      GstFlowReturn flow;
+
+      if (stream->list == NULL)
+        continue;
+
+      flow = gst_pad_push_list (stream->pad, stream->list);
+      stream->list = NULL;
+      ret = gst_flow_combiner_update_pad_flow (self->flowcombiner,
+          stream->pad, flow);
+    }
+  }
+
 out:
 
   if (list)
@@ -692,10 +1132,12 @@ gst_pcap_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
       break;
     case GST_EVENT_FLUSH_STOP:
       gst_pcap_parse_reset (self);
+      gst_flow_combiner_reset (self->flowcombiner);
       /* Push event down the pipeline so that other elements stop flushing */
       /* fall through */
     default:
-      ret = gst_pad_push_event (self->src_pad, event);
+      /* Goes to the pads of all flows too in multi-stream mode */
+      ret = gst_pad_event_default (pad, parent, event);
       break;
   }
 
@@ -713,6 +1155,7 @@ gst_pcap_parse_change_state (GstElement * element, GstStateChange transition)
   switch (transition) {
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       gst_pcap_parse_reset (self);
+      gst_pcap_parse_remove_streams (self);
       break;
     default:
       break;
@@ -22,6 +22,7 @@
 
 #include <gst/gst.h>
 #include <gst/base/gstadapter.h>
+#include <gst/base/gstflowcombiner.h>
 
 G_BEGIN_DECLS
 
@@ -52,6 +53,13 @@ typedef enum
   LINKTYPE_SLL = 113
 } GstPcapParseLinktype;
 
+/* Interface of a pcapng section */
+typedef struct
+{
+  GstPcapParseLinktype linktype;
+  guint64 ts_units_per_sec;
+} GstPcapParseInterface;
+
 /**
  * GstPcapParse:
  *
@@ -73,6 +81,7 @@ struct _GstPcapParse
   gint32 dst_port;
   GstCaps *caps;
   gint64 offset;
+  gboolean multi_stream;
 
   /* state */
   GstAdapter * adapter;
@@ -84,8 +93,17 @@ struct _GstPcapParse
   GstClockTime base_ts;
   GstPcapParseLinktype linktype;
 
+  /* pcapng */
+  gboolean pcapng;
+  GArray *interfaces;
+
   gboolean newsegment_sent;
   gboolean first_packet;
+
+  /* multi-stream mode: GstPcapParseStreamKey -> GstPcapParseStream */
+  GHashTable *streams;
+  guint n_streams;
+  GstFlowCombiner *flowcombiner;
 };
 
 struct _GstPcapParseClass
@@ -27,7 +27,10 @@
 G_BEGIN_DECLS
 
 G_GNUC_INTERNAL
-void gst_proxy_sink_set_proxysrc (GstProxySink *sink, GstProxySrc *src);
+void gst_proxy_sink_add_proxysrc (GstProxySink *sink, GstProxySrc *src);
+
+G_GNUC_INTERNAL
+void gst_proxy_sink_remove_proxysrc (GstProxySink *sink, GstProxySrc *src);
 
 G_GNUC_INTERNAL
 GstPad* gst_proxy_sink_get_internal_sinkpad (GstProxySink *sink);
@@ -30,6 +30,12 @@
  *
  * This element also copies sticky events onto the matching proxysrc element.
  *
+ * Since 1.20 a proxysink can feed several proxysrc
+ * elements. Every buffer and event is then passed to all of them, each
+ * proxysrc queues them independently of the others, see
+ * #GstProxySrc:leaky for how to handle slow consumers. Queries are answered
+ * by the first proxysrc that handles them.
+ *
  * For example usage, see proxysrc.
  */
 
@@ -70,14 +76,25 @@ static GstStateChangeReturn gst_proxy_sink_change_state (GstElement * element,
 static gboolean gst_proxy_sink_send_event (GstElement * element,
     GstEvent * event);
 static gboolean gst_proxy_sink_query (GstElement * element, GstQuery * query);
+static void gst_proxy_sink_finalize (GObject * object);
+
+static void
+free_weak_ref (GWeakRef * ref)
+{
+  g_weak_ref_clear (ref);
+  g_free (ref);
+}
 
 static void
 gst_proxy_sink_class_init (GstProxySinkClass * klass)
 {
+  GObjectClass *gobject_class = (GObjectClass *) klass;
   GstElementClass *gstelement_class = (GstElementClass *) klass;
 
   GST_DEBUG_CATEGORY_INIT (gst_proxy_sink_debug, "proxysink", 0, "proxy sink");
 
+  gobject_class->finalize = gst_proxy_sink_finalize;
+
   gstelement_class->change_state = gst_proxy_sink_change_state;
   gstelement_class->send_event = gst_proxy_sink_send_event;
   gstelement_class->query = gst_proxy_sink_query;
@@ -104,9 +121,58 @@ gst_proxy_sink_init (GstProxySink * self)
       GST_DEBUG_FUNCPTR (gst_proxy_sink_sink_query));
   gst_element_add_pad (GST_ELEMENT (self), self->sinkpad);
 
+  self->proxysrcs = g_ptr_array_new_with_free_func ((GDestroyNotify)
+      free_weak_ref);
+
   GST_OBJECT_FLAG_SET (self, GST_ELEMENT_FLAG_SINK);
 }
 
+static void
+gst_proxy_sink_finalize (GObject * object)
+{
+  GstProxySink *self = GST_PROXY_SINK (object);
+
+  g_ptr_array_unref (self->proxysrcs);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+/* Returns strong references to all proxysrcs that are still alive */
+static GPtrArray *
+gst_proxy_sink_get_proxysrcs (GstProxySink * self)
+{
+  GPtrArray *srcs = g_ptr_array_new_with_free_func (gst_object_unref);
+  guint i = 0;
+
+  GST_OBJECT_LOCK (self);
+  while (i < self->proxysrcs->len) {
+    GstProxySrc *src = g_weak_ref_get (g_ptr_array_index (self->proxysrcs, i));
+
+    if (src) {
+      g_ptr_array_add (srcs, src);
+      i++;
+    } else {
+      g_ptr_array_remove_index (self->proxysrcs, i);
+    }
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  return srcs;
+}
+
+static void
+gst_proxy_sink_set_pending_sticky_events (GstProxySink * self,
+    gboolean pending)
+{
+  GPtrArray *srcs = gst_proxy_sink_get_proxysrcs (self);
+  guint i;
+
+  for (i = 0; i < srcs->len; i++)
+    ((GstProxySrc *) g_ptr_array_index (srcs, i))->pending_sticky_events =
+        pending;
+  g_ptr_array_unref (srcs);
+}
+
 static GstStateChangeReturn
 gst_proxy_sink_change_state (GstElement * element, GstStateChange transition)
 {
@@ -117,7 +183,7 @@ gst_proxy_sink_change_state (GstElement * element, GstStateChange transition)
 
   switch (transition) {
     case GST_STATE_CHANGE_READY_TO_PAUSED:
-      self->pending_sticky_events = FALSE;
+      gst_proxy_sink_set_pending_sticky_events (self, FALSE);
       break;
     default:
       break;
@@ -157,21 +223,22 @@ static gboolean
 gst_proxy_sink_sink_query (GstPad * pad, GstObject * parent, GstQuery * query)
 {
   GstProxySink *self = GST_PROXY_SINK (parent);
-  GstProxySrc *src;
+  GPtrArray *srcs;
   gboolean ret = FALSE;
+  guint i;
 
   GST_LOG_OBJECT (pad, "Handling query of type '%s'",
       gst_query_type_get_name (GST_QUERY_TYPE (query)));
 
-  src = g_weak_ref_get (&self->proxysrc);
-  if (src) {
+  srcs = gst_proxy_sink_get_proxysrcs (self);
+  for (i = 0; i < srcs->len && !ret; i++) {
     GstPad *srcpad;
-    srcpad = gst_proxy_src_get_internal_srcpad (src);
 
+    srcpad = gst_proxy_src_get_internal_srcpad (g_ptr_array_index (srcs, i));
     ret = gst_pad_peer_query (srcpad, query);
     gst_object_unref (srcpad);
-    gst_object_unref (src);
   }
+  g_ptr_array_unref (srcs);
 
   return ret;
 }
@@ -193,43 +260,61 @@ copy_sticky_events (G_GNUC_UNUSED GstPad * pad, GstEvent ** event,
   return data->ret == GST_FLOW_OK;
 }
 
+static void
+gst_proxy_sink_copy_sticky_events (GstProxySink * self, GstProxySrc * src,
+    GstPad * srcpad)
+{
+  CopyStickyEventsData data = { srcpad, GST_FLOW_OK };
+
+  if (!src->pending_sticky_events)
+    return;
+
+  gst_pad_sticky_events_foreach (self->sinkpad, copy_sticky_events, &data);
+  src->pending_sticky_events = data.ret != GST_FLOW_OK;
+}
+
 static gboolean
 gst_proxy_sink_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
   GstProxySink *self = GST_PROXY_SINK (parent);
-  GstProxySrc *src;
+  GPtrArray *srcs;
   gboolean ret = FALSE;
   gboolean sticky = GST_EVENT_IS_STICKY (event);
+  guint i;
 
   GST_LOG_OBJECT (pad, "Got %s event", GST_EVENT_TYPE_NAME (event));
 
   if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP)
-    self->pending_sticky_events = FALSE;
+    gst_proxy_sink_set_pending_sticky_events (self, FALSE);
+
+  srcs = gst_proxy_sink_get_proxysrcs (self);
+  if (srcs->len == 0) {
+    gst_event_unref (event);
+    ret = TRUE;
+  }
 
-  src = g_weak_ref_get (&self->proxysrc);
-  if (src) {
+  for (i = 0; i < srcs->len; i++) {
+    GstProxySrc *src = g_ptr_array_index (srcs, i);
     GstPad *srcpad;
-    srcpad = gst_proxy_src_get_internal_srcpad (src);
+    gboolean src_ret;
 
-    if (sticky && self->pending_sticky_events) {
-      CopyStickyEventsData data = { srcpad, GST_FLOW_OK };
+    srcpad = gst_proxy_src_get_internal_srcpad (src);
 
-      gst_pad_sticky_events_foreach (pad, copy_sticky_events, &data);
-      self->pending_sticky_events = data.ret != GST_FLOW_OK;
-    }
+    if (sticky)
+      gst_proxy_sink_copy_sticky_events (self, src, srcpad);
 
-    ret = gst_pad_push_event (srcpad, event);
+    /* The last one gets our reference */
+    src_ret = gst_pad_push_event (srcpad,
+        i + 1 == srcs->len ? event : gst_event_ref (event));
     gst_object_unref (srcpad);
-    gst_object_unref (src);
 
-    if (!ret && sticky) {
-      self->pending_sticky_events = TRUE;
-      ret = TRUE;
+    if (!src_ret && sticky) {
+      src->pending_sticky_events = TRUE;
+      src_ret = TRUE;
     }
-  } else {
-    gst_event_unref (event);
-    ret = TRUE;
+    ret |= src_ret;
   }
+  g_ptr_array_unref (srcs);
 
   return ret;
 }
@@ -238,33 +323,34 @@ static GstFlowReturn
 gst_proxy_sink_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 {
   GstProxySink *self = GST_PROXY_SINK (parent);
-  GstProxySrc *src;
+  GPtrArray *srcs;
   GstFlowReturn ret = GST_FLOW_OK;
+  guint i;
 
   GST_LOG_OBJECT (pad, "Chaining buffer %p", buffer);
 
-  src = g_weak_ref_get (&self->proxysrc);
-  if (src) {
-    GstPad *srcpad;
-    srcpad = gst_proxy_src_get_internal_srcpad (src);
+  srcs = gst_proxy_sink_get_proxysrcs (self);
+  if (srcs->len == 0) {
+    gst_buffer_unref (buffer);
+    GST_LOG_OBJECT (pad, "Dropped buffer %p: no otherpad", buffer);
+  }
 
-    if (self->pending_sticky_events) {
-      CopyStickyEventsData data = { srcpad, GST_FLOW_OK };
+  for (i = 0; i < srcs->len; i++) {
+    GstProxySrc *src = g_ptr_array_index (srcs, i);
+    GstPad *srcpad;
 
-      gst_pad_sticky_events_foreach (pad, copy_sticky_events, &data);
-      self->pending_sticky_events = data.ret != GST_FLOW_OK;
-    }
+    srcpad = gst_proxy_src_get_internal_srcpad (src);
+    gst_proxy_sink_copy_sticky_events (self, src, srcpad);
 
-    ret = gst_pad_push (srcpad, buffer);
+    /* All proxysrcs share the buffer, the last one gets our reference */
+    ret = gst_pad_push (srcpad,
+        i + 1 == srcs->len ? buffer : gst_buffer_ref (buffer));
     gst_object_unref (srcpad);
-    gst_object_unref (src);
 
-    GST_LOG_OBJECT (pad, "Chained buffer %p: %s", buffer,
-        gst_flow_get_name (ret));
-  } else {
-    gst_buffer_unref (buffer);
-    GST_LOG_OBJECT (pad, "Dropped buffer %p: no otherpad", buffer);
+    GST_LOG_OBJECT (pad, "Chained buffer %p to %" GST_PTR_FORMAT ": %s",
+        buffer, src, gst_flow_get_name (ret));
   }
+  g_ptr_array_unref (srcs);
 
   return GST_FLOW_OK;
 }
@@ -274,32 +360,33 @@ gst_proxy_sink_sink_chain_list (GstPad * pad, GstObject * parent,
     GstBufferList * list)
 {
   GstProxySink *self = GST_PROXY_SINK (parent);
-  GstProxySrc *src;
+  GPtrArray *srcs;
   GstFlowReturn ret = GST_FLOW_OK;
+  guint i;
 
   GST_LOG_OBJECT (pad, "Chaining buffer list %p", list);
 
-  src = g_weak_ref_get (&self->proxysrc);
-  if (src) {
-    GstPad *srcpad;
-    srcpad = gst_proxy_src_get_internal_srcpad (src);
+  srcs = gst_proxy_sink_get_proxysrcs (self);
+  if (srcs->len == 0) {
+    gst_buffer_list_unref (list);
+    GST_LOG_OBJECT (pad, "Dropped buffer list %p: no otherpad", list);
+  }
 
-    if (self->pending_sticky_events) {
-      CopyStickyEventsData data = { srcpad, GST_FLOW_OK };
+  for (i = 0; i < srcs->len; i++) {
+    GstProxySrc *src = g_ptr_array_index (srcs, i);
+    GstPad *srcpad;
 
-      gst_pad_sticky_events_foreach (pad, copy_sticky_events, &data);
-      self->pending_sticky_events = data.ret != GST_FLOW_OK;
-    }
+    srcpad = gst_proxy_src_get_internal_srcpad (src);
+    gst_proxy_sink_copy_sticky_events (self, src, srcpad);
 
-    ret = gst_pad_push_list (srcpad, list);
+    ret = gst_pad_push_list (srcpad,
+        i + 1 == srcs->len ? list : gst_buffer_list_ref (list));
     gst_object_unref (srcpad);
-    gst_object_unref (src);
-    GST_LOG_OBJECT (pad, "Chained buffer list %p: %s", list,
-        gst_flow_get_name (ret));
-  } else {
-    gst_buffer_list_unref (list);
-    GST_LOG_OBJECT (pad, "Dropped buffer list %p: no otherpad", list);
+
+    GST_LOG_OBJECT (pad, "Chained buffer list %p to %" GST_PTR_FORMAT ": %s",
+        list, src, gst_flow_get_name (ret));
   }
+  g_ptr_array_unref (srcs);
 
   return GST_FLOW_OK;
 }
@@ -315,8 +402,42 @@ gst_proxy_sink_get_internal_sinkpad (GstProxySink * self)
 }
 
 void
-gst_proxy_sink_set_proxysrc (GstProxySink * self, GstProxySrc * src)
+gst_proxy_sink_add_proxysrc (GstProxySink * self, GstProxySrc * src)
 {
+  GWeakRef *ref;
+
   g_return_if_fail (self);
-  g_weak_ref_set (&self->proxysrc, src);
+  g_return_if_fail (src);
+
+  /* Copy the sticky events before the first buffer it gets */
+  src->pending_sticky_events = TRUE;
+
+  ref = g_new0 (GWeakRef, 1);
+  g_weak_ref_init (ref, src);
+
+  GST_OBJECT_LOCK (self);
+  g_ptr_array_add (self->proxysrcs, ref);
+  GST_OBJECT_UNLOCK (self);
+}
+
+void
+gst_proxy_sink_remove_proxysrc (GstProxySink * self, GstProxySrc * src)
+{
+  guint i;
+
+  g_return_if_fail (self);
+
+  GST_OBJECT_LOCK (self);
+  for (i = 0; i < self->proxysrcs->len; i++) {
+    GstProxySrc *other = g_weak_ref_get (g_ptr_array_index (self->proxysrcs,
+            i));
+
+    if (other)
+      g_object_unref (other);
+    if (other == src) {
+      g_ptr_array_remove_index (self->proxysrcs, i);
+      break;
+    }
+  }
+  GST_OBJECT_UNLOCK (self);
 }
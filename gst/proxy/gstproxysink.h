@@ -43,11 +43,9 @@ struct _GstProxySink {
   /* < private > */
   GstPad *sinkpad;
 
-  /* The proxysrc that we push events, buffers, queries to */
-  GWeakRef proxysrc;
-
-  /* Whether there are sticky events pending */
-  gboolean pending_sticky_events;
+  /* The proxysrcs that we push events, buffers, queries to, as GWeakRef *.
+   * Protected by the object lock */
+  GPtrArray *proxysrcs;
 };
 
 struct _GstProxySinkClass {
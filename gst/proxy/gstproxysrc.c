@@ -32,6 +32,14 @@
  * so everything downstream is properly decoupled from the upstream pipeline.
  * However, the queue may get filled up if the downstream pipeline does not
  * accept buffers quickly enough; perhaps because it is not yet PLAYING.
+ * The limits of the queue and what to do when it is full can be configured
+ * with the #GstProxySrc:max-size-buffers, #GstProxySrc:max-size-bytes,
+ * #GstProxySrc:max-size-time and #GstProxySrc:leaky properties.
+ *
+ * Multiple proxysrc elements can use the same proxysink, in which case each
+ * of them gets all buffers and events of the proxysink. As every proxysrc has
+ * its own queue, one slow consumer only blocks the others if its queue
+ * fills up and is not leaky.
  *
  * ## Usage
  * 
@@ -87,12 +95,41 @@ static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS_ANY);
 
+#define DEFAULT_MAX_SIZE_BUFFERS 200
+#define DEFAULT_MAX_SIZE_BYTES (10 * 1024 * 1024)
+#define DEFAULT_MAX_SIZE_TIME GST_SECOND
+#define DEFAULT_LEAKY GST_PROXY_SRC_LEAKY_NO
+
 enum
 {
   PROP_0,
   PROP_PROXYSINK,
+  PROP_MAX_SIZE_BUFFERS,
+  PROP_MAX_SIZE_BYTES,
+  PROP_MAX_SIZE_TIME,
+  PROP_LEAKY,
 };
 
+#define GST_TYPE_PROXY_SRC_LEAKY (gst_proxy_src_leaky_get_type ())
+static GType
+gst_proxy_src_leaky_get_type (void)
+{
+  static GType leaky_type = 0;
+  static const GEnumValue leaky[] = {
+    {GST_PROXY_SRC_LEAKY_NO, "Not Leaky", "no"},
+    {GST_PROXY_SRC_LEAKY_UPSTREAM, "Leaky on upstream (new buffers)",
+        "upstream"},
+    {GST_PROXY_SRC_LEAKY_DOWNSTREAM, "Leaky on downstream (old buffers)",
+        "downstream"},
+    {0, NULL, NULL},
+  };
+
+  if (!leaky_type)
+    leaky_type = g_enum_register_static ("GstProxySrcLeaky", leaky);
+
+  return leaky_type;
+}
+
 /* We're not subclassing from basesrc because we don't want any of the special
  * handling it has for events/queries/etc. We just pass-through everything. */
 
@@ -123,6 +160,18 @@ gst_proxy_src_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_PROXYSINK:
       g_value_take_object (value, g_weak_ref_get (&self->proxysink));
       break;
+    case PROP_MAX_SIZE_BUFFERS:
+    case PROP_MAX_SIZE_BYTES:
+    case PROP_MAX_SIZE_TIME:
+      g_object_get_property (G_OBJECT (self->queue), spec->name, value);
+      break;
+    case PROP_LEAKY:{
+      gint leaky;
+
+      g_object_get (self->queue, "leaky", &leaky, NULL);
+      g_value_set_enum (value, leaky);
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, spec);
       break;
@@ -137,23 +186,37 @@ gst_proxy_src_set_property (GObject * object, guint prop_id,
   GstProxySink *sink;
 
   switch (prop_id) {
-    case PROP_PROXYSINK:
+    case PROP_PROXYSINK:{
+      GstProxySink *old_sink = g_weak_ref_get (&self->proxysink);
+
       sink = g_value_dup_object (value);
-      if (sink == NULL) {
-        /* Unset proxysrc property on the existing proxysink to break the
-         * connection in that direction */
-        GstProxySink *old_sink = g_weak_ref_get (&self->proxysink);
-        if (old_sink) {
-          gst_proxy_sink_set_proxysrc (old_sink, NULL);
-          g_object_unref (old_sink);
-        }
-        g_weak_ref_set (&self->proxysink, NULL);
-      } else {
-        /* Set proxysrc property on the new proxysink to point to us */
-        gst_proxy_sink_set_proxysrc (sink, self);
-        g_weak_ref_set (&self->proxysink, sink);
-        g_object_unref (sink);
+      if (old_sink == sink) {
+        g_clear_object (&old_sink);
+        g_clear_object (&sink);
+        break;
+      }
+
+      /* Remove ourselves from the existing proxysink to break the
+       * connection in that direction */
+      if (old_sink) {
+        gst_proxy_sink_remove_proxysrc (old_sink, self);
+        g_object_unref (old_sink);
       }
+
+      /* Add ourselves to the consumers of the new proxysink */
+      if (sink)
+        gst_proxy_sink_add_proxysrc (sink, self);
+      g_weak_ref_set (&self->proxysink, sink);
+      g_clear_object (&sink);
+      break;
+    }
+    case PROP_MAX_SIZE_BUFFERS:
+    case PROP_MAX_SIZE_BYTES:
+    case PROP_MAX_SIZE_TIME:
+      g_object_set_property (G_OBJECT (self->queue), spec->name, value);
+      break;
+    case PROP_LEAKY:
+      g_object_set (self->queue, "leaky", g_value_get_enum (value), NULL);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, spec);
@@ -177,6 +240,61 @@ gst_proxy_src_class_init (GstProxySrcClass * klass)
       g_param_spec_object ("proxysink", "Proxysink", "Matching proxysink",
           GST_TYPE_PROXY_SINK, G_PARAM_READWRITE));
 
+  /**
+   * GstProxySrc:max-size-buffers:
+   *
+   * Maximum number of buffers in the internal queue (0=disable).
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_SIZE_BUFFERS,
+      g_param_spec_uint ("max-size-buffers", "Max. size (buffers)",
+          "Max. number of buffers in the internal queue (0=disable)",
+          0, G_MAXUINT, DEFAULT_MAX_SIZE_BUFFERS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstProxySrc:max-size-bytes:
+   *
+   * Maximum amount of data in the internal queue (0=disable).
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_SIZE_BYTES,
+      g_param_spec_uint ("max-size-bytes", "Max. size (kB)",
+          "Max. amount of data in the internal queue (bytes, 0=disable)",
+          0, G_MAXUINT, DEFAULT_MAX_SIZE_BYTES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstProxySrc:max-size-time:
+   *
+   * Maximum amount of data in the internal queue (0=disable).
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_SIZE_TIME,
+      g_param_spec_uint64 ("max-size-time", "Max. size (ns)",
+          "Max. amount of data in the internal queue (in ns, 0=disable)",
+          0, G_MAXUINT64, DEFAULT_MAX_SIZE_TIME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstProxySrc:leaky:
+   *
+   * Whether to drop buffers once the internal queue is full, instead of
+   * blocking the matching proxysink and all its other proxysrcs.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_LEAKY,
+      g_param_spec_enum ("leaky", "Leaky",
+          "Where the internal queue leaks, if at all",
+          GST_TYPE_PROXY_SRC_LEAKY, DEFAULT_LEAKY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_type_mark_as_plugin_api (GST_TYPE_PROXY_SRC_LEAKY, 0);
+
   gstelement_class->change_state = gst_proxy_src_change_state;
   gstelement_class->send_event = gst_proxy_src_send_event;
   gstelement_class->query = gst_proxy_src_query;
@@ -37,6 +37,20 @@ typedef struct _GstProxySrc GstProxySrc;
 typedef struct _GstProxySrcClass GstProxySrcClass;
 typedef struct _GstProxySrcPrivate GstProxySrcPrivate;
 
+/**
+ * GstProxySrcLeaky:
+ * @GST_PROXY_SRC_LEAKY_NO: Not leaky
+ * @GST_PROXY_SRC_LEAKY_UPSTREAM: Drop new buffers when the queue is full
+ * @GST_PROXY_SRC_LEAKY_DOWNSTREAM: Drop old buffers when the queue is full
+ *
+ * Since: 1.20
+ */
+typedef enum {
+  GST_PROXY_SRC_LEAKY_NO,
+  GST_PROXY_SRC_LEAKY_UPSTREAM,
+  GST_PROXY_SRC_LEAKY_DOWNSTREAM
+} GstProxySrcLeaky;
+
 struct _GstProxySrc {
   GstBin parent;
 
@@ -56,6 +70,10 @@ struct _GstProxySrc {
 
   /* The matching proxysink; queries and events are sent to its sinkpad */
   GWeakRef proxysink;
+
+  /* Whether the sticky events of the proxysink still have to be copied to
+   * our internal srcpad. Only used by the proxysink */
+  gboolean pending_sticky_events;
 };
 
 struct _GstProxySrcClass {
@@ -123,6 +123,11 @@ G_DEFINE_TYPE_WITH_CODE (GstRistRtxSend, gst_rist_rtx_send, GST_TYPE_ELEMENT,
     GST_DEBUG_CATEGORY_INIT (gst_rist_rtx_send_debug, "ristrtxsend", 0,
         "RIST retransmission sender"));
 
+/* Initial number of slots of the history ring, it grows as needed */
+#define HISTORY_MIN_SIZE 128
+/* A larger jump of the extended seqnum restarts the history */
+#define HISTORY_MAX_GAP G_MAXINT16
+
 typedef struct
 {
   guint32 extseqnum;
@@ -130,21 +135,19 @@ typedef struct
   GstBuffer *buffer;
 } BufferQueueItem;
 
-static void
-buffer_queue_item_free (BufferQueueItem * item)
-{
-  gst_buffer_unref (item->buffer);
-  g_slice_free (BufferQueueItem, item);
-}
-
 typedef struct
 {
   guint32 rtx_ssrc;
   guint16 seqnum_base, next_seqnum;
   gint clock_rate;
 
-  /* history of rtp packets */
-  GSequence *queue;
+  /* history of rtp packets, a ring indexed by extseqnum. It holds the
+   * extseqnums [history_first, history_first + history_len), the first and
+   * last slots are always used, the ones in between may be empty. */
+  BufferQueueItem *history;
+  guint history_size;           /* power of 2 */
+  guint32 history_first;
+  guint history_len;
   guint32 max_extseqnum;
 
   /* current rtcp app seqnum extension */
@@ -159,19 +162,127 @@ ssrc_rtx_data_new (guint32 rtx_ssrc)
 
   data->rtx_ssrc = rtx_ssrc;
   data->next_seqnum = data->seqnum_base = g_random_int_range (0, G_MAXUINT16);
-  data->queue = g_sequence_new ((GDestroyNotify) buffer_queue_item_free);
+  data->history_size = HISTORY_MIN_SIZE;
+  data->history = g_new0 (BufferQueueItem, data->history_size);
   data->max_extseqnum = -1;
 
   return data;
 }
 
+static inline BufferQueueItem *
+history_slot (SSRCRtxData * data, guint32 extseqnum)
+{
+  return &data->history[extseqnum & (data->history_size - 1)];
+}
+
+static void
+history_clear (SSRCRtxData * data)
+{
+  guint i;
+
+  for (i = 0; i < data->history_size; i++)
+    gst_clear_buffer (&data->history[i].buffer);
+  data->history_len = 0;
+}
+
 static void
 ssrc_rtx_data_free (SSRCRtxData * data)
 {
-  g_sequence_free (data->queue);
+  history_clear (data);
+  g_free (data->history);
   g_slice_free (SSRCRtxData, data);
 }
 
+/* Drops the oldest packet, and any empty slot following it */
+static void
+history_pop_oldest (SSRCRtxData * data)
+{
+  do {
+    gst_clear_buffer (&history_slot (data, data->history_first)->buffer);
+    data->history_first++;
+    data->history_len--;
+  } while (data->history_len > 0
+      && !history_slot (data, data->history_first)->buffer);
+}
+
+static void
+history_grow (SSRCRtxData * data, guint len)
+{
+  BufferQueueItem *old = data->history;
+  guint old_size = data->history_size;
+  guint i;
+
+  while (data->history_size < len)
+    data->history_size <<= 1;
+
+  if (data->history_size == old_size)
+    return;
+
+  data->history = g_new0 (BufferQueueItem, data->history_size);
+  for (i = 0; i < data->history_len; i++) {
+    guint32 extseqnum = data->history_first + i;
+
+    *history_slot (data, extseqnum) = old[extseqnum & (old_size - 1)];
+  }
+  g_free (old);
+}
+
+static BufferQueueItem *
+history_lookup (SSRCRtxData * data, guint32 extseqnum)
+{
+  BufferQueueItem *item;
+
+  if (data->history_len == 0
+      || extseqnum - data->history_first >= data->history_len)
+    return NULL;
+
+  item = history_slot (data, extseqnum);
+  if (!item->buffer || item->extseqnum != extseqnum)
+    return NULL;
+
+  return item;
+}
+
+static void
+history_insert (SSRCRtxData * data, guint32 extseqnum, guint32 timestamp,
+    GstBuffer * buffer, guint max_packets)
+{
+  BufferQueueItem *item;
+
+  if (data->history_len == 0) {
+    data->history_first = extseqnum;
+  } else if ((gint32) (extseqnum - data->history_first) < 0) {
+    /* older than anything we still have */
+    return;
+  } else if (extseqnum - data->history_first >= data->history_len) {
+    guint32 last = data->history_first + data->history_len - 1;
+
+    if (extseqnum - last > HISTORY_MAX_GAP)
+      history_clear (data);
+
+    if (max_packets) {
+      while (data->history_len > 0
+          && extseqnum - data->history_first >= max_packets)
+        history_pop_oldest (data);
+    }
+
+    if (data->history_len == 0) {
+      data->history_first = extseqnum;
+    } else {
+      history_grow (data, extseqnum - data->history_first + 1);
+    }
+  }
+
+  item = history_slot (data, extseqnum);
+  gst_clear_buffer (&item->buffer);
+  item->extseqnum = extseqnum;
+  item->timestamp = timestamp;
+  item->buffer = gst_buffer_ref (buffer);
+
+  data->history_len = MAX (data->history_len,
+      extseqnum - data->history_first + 1);
+}
+
 static void
 gst_rist_rtx_send_class_init (GstRistRtxSendClass * klass)
 {
@@ -367,16 +478,6 @@ gst_rtp_rist_buffer_new (GstRistRtxSend * rtx, GstBuffer * buffer, guint32 ssrc)
   return buffer;
 }
 
-static gint
-buffer_queue_items_cmp (BufferQueueItem * a, BufferQueueItem * b,
-    gpointer user_data)
-{
-  /* gst_rtp_buffer_compare_seqnum returns the opposite of what we want,
-   * it returns negative when seqnum1 > seqnum2 and we want negative
-   * when b > a, i.e. a is smaller, so it comes first in the sequence */
-  return a->extseqnum - b->extseqnum;
-}
-
 static gboolean
 gst_rist_rtx_send_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
@@ -408,8 +509,7 @@ gst_rist_rtx_send_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
         /* check if request is for us */
         if (g_hash_table_contains (rtx->ssrc_data, GUINT_TO_POINTER (ssrc))) {
           SSRCRtxData *data;
-          GSequenceIter *iter;
-          BufferQueueItem search_item;
+          BufferQueueItem *item;
           guint32 extseqnum;
 
           /* update statistics */
@@ -425,27 +525,18 @@ gst_rist_rtx_send_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
             extseqnum = gst_rist_rtp_ext_seq (&max_extseqnum, seqnum);
           }
 
-          search_item.extseqnum = extseqnum;
-          iter = g_sequence_lookup (data->queue, &search_item,
-              (GCompareDataFunc) buffer_queue_items_cmp, NULL);
-          if (iter) {
-            BufferQueueItem *item = g_sequence_get (iter);
+          item = history_lookup (data, extseqnum);
+          if (item) {
             GST_LOG_OBJECT (rtx, "found %u (%u:%u)", item->extseqnum,
                 item->extseqnum >> 16, item->extseqnum & 0xFFFF);
             rtx_buf = gst_rtp_rist_buffer_new (rtx, item->buffer, ssrc);
           }
 #ifndef GST_DISABLE_DEBUG
           else {
-            BufferQueueItem *item = NULL;
-
-            iter = g_sequence_get_begin_iter (data->queue);
-            if (!g_sequence_iter_is_end (iter))
-              item = g_sequence_get (iter);
-
-            if (item && extseqnum < item->extseqnum) {
+            if (data->history_len > 0 && extseqnum < data->history_first) {
               GST_DEBUG_OBJECT (rtx, "requested seqnum %u has already been "
                   "removed from the rtx queue; the first available is %u",
-                  seqnum, item->extseqnum);
+                  seqnum, data->history_first);
             } else {
               GST_WARNING_OBJECT (rtx, "requested seqnum %u has not been "
                   "transmitted yet in the original stream; either the remote end "
@@ -551,14 +642,12 @@ gst_rist_rtx_send_get_ts_diff (SSRCRtxData * data)
   BufferQueueItem *high_buf, *low_buf;
   guint32 result;
 
-  high_buf =
-      g_sequence_get (g_sequence_iter_prev (g_sequence_get_end_iter
-          (data->queue)));
-  low_buf = g_sequence_get (g_sequence_get_begin_iter (data->queue));
-
-  if (!high_buf || !low_buf || high_buf == low_buf)
+  if (data->history_len < 2)
     return 0;
 
+  high_buf = history_slot (data, data->history_first + data->history_len - 1);
+  low_buf = history_slot (data, data->history_first);
+
   high_ts = high_buf->timestamp;
   low_ts = low_buf->timestamp;
 
@@ -578,7 +667,6 @@ static void
 process_buffer (GstRistRtxSend * rtx, GstBuffer * buffer)
 {
   GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
-  BufferQueueItem *item;
   SSRCRtxData *data;
   guint16 seqnum;
   guint32 ssrc, rtptime;
@@ -613,21 +701,13 @@ process_buffer (GstRistRtxSend * rtx, GstBuffer * buffer)
   else
     extseqnum = gst_rist_rtp_ext_seq (&data->max_extseqnum, seqnum);
 
-  /* add current rtp buffer to queue history */
-  item = g_slice_new0 (BufferQueueItem);
-  item->extseqnum = extseqnum;
-  item->timestamp = rtptime;
-  item->buffer = gst_buffer_ref (buffer);
-  g_sequence_append (data->queue, item);
+  /* add current rtp buffer to queue history, this also removes the oldest
+   * packets from history if they are too many */
+  history_insert (data, extseqnum, rtptime, buffer, rtx->max_size_packets);
 
-  /* remove oldest packets from history if they are too many */
-  if (rtx->max_size_packets) {
-    while (g_sequence_get_length (data->queue) > rtx->max_size_packets)
-      g_sequence_remove (g_sequence_get_begin_iter (data->queue));
-  }
   if (rtx->max_size_time) {
     while (gst_rist_rtx_send_get_ts_diff (data) > rtx->max_size_time)
-      g_sequence_remove (g_sequence_get_begin_iter (data->queue));
+      history_pop_oldest (data);
   }
 }
 
@@ -51,13 +51,16 @@
  * mapped to its own RTP session. RTX request are only replied to on the
  * link the NACK was received from.
  *
- * There are currently two bonding methods in place: "broadcast" and "round-robin".
- * In "broadcast" mode, all the packets are duplicated over all sessions.
- * While in "round-robin" mode, packets are evenly distributed over the links. One
- * can also implement its own dispatcher element and configure it using the
- * "dispatcher" property. As a reference, "broadcast" mode is implemented with
- * the "tee" element, while "round-robin" mode is implemented with the
- * "round-robin" element.
+ * There are currently three bonding methods in place: "broadcast", "round-robin"
+ * and "weighted". In "broadcast" mode, all the packets are duplicated over all
+ * sessions. While in "round-robin" mode, packets are evenly distributed over
+ * the links. The "weighted" mode distributes packets proportionally to the
+ * health of each link, estimated from the round-trip time reported over RTCP
+ * and from the ratio of retransmission requests, so that a weak link is not
+ * loaded as much as a good one. One can also implement its own dispatcher
+ * element and configure it using the "dispatcher" property. As a reference,
+ * "broadcast" mode is implemented with the "tee" element, while "round-robin"
+ * and "weighted" modes are implemented with the "round-robin" element.
  *
  * ## Example gst-launch line for bonding
  * |[
@@ -80,6 +83,7 @@
 #include <stdlib.h>
 
 #include "gstrist.h"
+#include "gstroundrobin.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_rist_sink_debug);
 #define GST_CAT_DEFAULT gst_rist_sink_debug
@@ -108,8 +112,14 @@ typedef enum
 {
   GST_RIST_BONDING_METHOD_BROADCAST,
   GST_RIST_BONDING_METHOD_ROUND_ROBIN,
+  GST_RIST_BONDING_METHOD_WEIGHTED,
 } GstRistBondingMethod;
 
+/* How often the link weights are re-evaluated in "weighted" mode */
+#define WEIGHTS_UPDATE_INTERVAL (500 * GST_MSECOND)
+/* The weight given to a link with no loss and the lowest round-trip time */
+#define MAX_BOND_WEIGHT 100
+
 static GstStaticPadTemplate sink_templ = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
@@ -127,6 +137,12 @@ typedef struct
   GstElement *rtx_send;
   GstElement *rtx_queue;
   guint32 rtcp_ssrc;
+
+  /* For the "weighted" bonding method */
+  guint weight;
+  gdouble loss;
+  guint64 last_pkt_sent;
+  guint last_rtx_requests;
 } RistSenderBond;
 
 struct _GstRistSink
@@ -159,6 +175,7 @@ struct _GstRistSink
   guint stats_interval;
   guint32 rtp_ssrc;
   GstClockID stats_cid;
+  GstClockID weights_cid;
 
   /* This is set whenever there is a pipeline construction failure, and used
    * to fail state changes later */
@@ -175,6 +192,15 @@ gst_rist_bonding_method_get_type (void)
         "GST_RIST_BONDING_METHOD_BROADCAST", "broadcast"},
     {GST_RIST_BONDING_METHOD_ROUND_ROBIN,
         "GST_RIST_BONDING_METHOD_ROUND_ROBIN", "round-robin"},
+    /**
+     * GstRistBondingMethodType::weighted:
+     *
+     * Distribute packets proportionally to the health of each link.
+     *
+     * Since: 1.20
+     */
+    {GST_RIST_BONDING_METHOD_WEIGHTED,
+        "GST_RIST_BONDING_METHOD_WEIGHTED", "weighted"},
     {0, NULL, NULL}
   };
 
@@ -200,6 +226,7 @@ gst_rist_sink_add_bond (GstRistSink * sink)
 
   bond->session = sink->bonds->len;
   bond->address = g_strdup ("localhost");
+  bond->weight = MAX_BOND_WEIGHT;
 
   g_snprintf (name, 32, "rist_rtp_udpsink%u", bond->session);
   bond->rtp_sink = gst_element_factory_make ("udpsink", name);
@@ -468,12 +495,11 @@ gst_rist_sink_on_new_receiver_ssrc (GstRistSink * sink, guint session_id,
 {
   RistSenderBond *bond;
 
-  if (session_id != 0)
-    return;
-
-  GST_INFO_OBJECT (sink, "Got RTCP remote SSRC %u", ssrc);
+  GST_INFO_OBJECT (sink, "Got RTCP remote SSRC %u on session %u", ssrc,
+      session_id);
   bond = g_ptr_array_index (sink->bonds, session_id);
-  bond->rtcp_ssrc = ssrc;
+  if (bond)
+    bond->rtcp_ssrc = ssrc;
 }
 
 static GstPadProbeReturn
@@ -724,6 +750,7 @@ gst_rist_sink_start (GstRistSink * sink)
         }
         break;
       case GST_RIST_BONDING_METHOD_ROUND_ROBIN:
+      case GST_RIST_BONDING_METHOD_WEIGHTED:
         sink->dispatcher = gst_element_factory_make ("roundrobin",
             "rist_dispatcher");
         g_assert (sink->dispatcher);
@@ -826,6 +853,9 @@ gst_rist_sink_create_stats (GstRistSink * sink)
         "sent-retransmitted-packets", G_TYPE_UINT64, rtx_sent,
         "round-trip-time", G_TYPE_UINT64, rtt, NULL);
 
+    if (sink->weights_cid)
+      gst_structure_set (stats, "weight", G_TYPE_UINT, bond->weight, NULL);
+
     g_value_init (&value, GST_TYPE_STRUCTURE);
     g_value_take_boxed (&value, stats);
     g_value_array_append (session_stats, &value);
@@ -887,6 +917,139 @@ gst_rist_sink_disable_stats_interval (GstRistSink * sink)
   }
 }
 
+/* Derive each link's share of the packets from its retransmission request
+ * ratio (a loss estimate) and its round-trip time relative to the best
+ * link. RTCP receiver report loss can't be used, since with bonding each
+ * link only carries part of the sequence numbers. */
+static gboolean
+gst_rist_sink_update_weights (GstClock * clock, GstClockTime time,
+    GstClockID id, gpointer user_data)
+{
+  GstRistSink *sink = GST_RIST_SINK (user_data);
+  GstClockTime *rtts, min_rtt = GST_CLOCK_TIME_NONE;
+  gint i;
+
+  rtts = g_newa (GstClockTime, sink->bonds->len);
+
+  for (i = 0; i < sink->bonds->len; i++) {
+    RistSenderBond *bond = g_ptr_array_index (sink->bonds, i);
+    GObject *session = NULL, *source = NULL;
+    GstStructure *sstats = NULL;
+    guint64 pkt_sent = 0;
+    guint rtx_requests = 0, rb_rtt = 0;
+
+    rtts[i] = 0;
+
+    g_signal_emit_by_name (sink->rtpbin, "get-internal-session", i, &session);
+    if (!session)
+      continue;
+
+    g_signal_emit_by_name (session, "get-source-by-ssrc", sink->rtp_ssrc,
+        &source);
+    if (source) {
+      g_object_get (source, "stats", &sstats, NULL);
+      gst_structure_get_uint64 (sstats, "packets-sent", &pkt_sent);
+      gst_structure_free (sstats);
+      g_clear_object (&source);
+    }
+
+    g_signal_emit_by_name (session, "get-source-by-ssrc", bond->rtcp_ssrc,
+        &source);
+    if (source) {
+      g_object_get (source, "stats", &sstats, NULL);
+      gst_structure_get_uint (sstats, "rb-round-trip", &rb_rtt);
+      gst_structure_free (sstats);
+      g_clear_object (&source);
+    }
+    g_object_unref (session);
+
+    g_object_get (bond->rtx_send, "num-rtx-requests", &rtx_requests, NULL);
+
+    if (pkt_sent > bond->last_pkt_sent) {
+      gdouble loss = (gdouble) (rtx_requests - bond->last_rtx_requests) /
+          (pkt_sent - bond->last_pkt_sent);
+
+      /* Smooth out bursts */
+      bond->loss = 0.75 * bond->loss + 0.25 * MIN (loss, 1.0);
+    }
+    bond->last_pkt_sent = pkt_sent;
+    bond->last_rtx_requests = rtx_requests;
+
+    /* rb_rtt is in Q16 in NTP time */
+    rtts[i] = gst_util_uint64_scale (rb_rtt, GST_SECOND, 65536);
+    if (rtts[i] > 0 && (min_rtt == GST_CLOCK_TIME_NONE || rtts[i] < min_rtt))
+      min_rtt = rtts[i];
+  }
+
+  for (i = 0; i < sink->bonds->len; i++) {
+    RistSenderBond *bond = g_ptr_array_index (sink->bonds, i);
+    gdouble score = (1.0 - bond->loss) * (1.0 - bond->loss);
+    GstPad *pad;
+    gchar name[32];
+
+    if (rtts[i] > 0 && min_rtt != GST_CLOCK_TIME_NONE)
+      score *= (gdouble) min_rtt / rtts[i];
+
+    /* Never stop using a link entirely, so that it keeps being measured */
+    bond->weight = MAX (1, (guint) (score * MAX_BOND_WEIGHT + 0.5));
+
+    GST_LOG_OBJECT (sink, "Link %u: loss %f, rtt %" GST_TIME_FORMAT
+        ", weight %u", bond->session, bond->loss, GST_TIME_ARGS (rtts[i]),
+        bond->weight);
+
+    g_snprintf (name, 32, "src_%u", bond->session);
+    pad = gst_element_get_static_pad (sink->dispatcher, name);
+    if (pad) {
+      g_object_set (pad, "weight", bond->weight, NULL);
+      gst_object_unref (pad);
+    }
+  }
+
+  return TRUE;
+}
+
+static void
+gst_rist_sink_enable_weights_update (GstRistSink * sink)
+{
+  GstClock *clock;
+  GstClockTime start;
+  gint i;
+
+  if (sink->bonding_method != GST_RIST_BONDING_METHOD_WEIGHTED
+      || sink->bonds->len < 2 || !G_TYPE_CHECK_INSTANCE_TYPE (sink->dispatcher,
+          GST_TYPE_ROUND_ROBIN))
+    return;
+
+  for (i = 0; i < sink->bonds->len; i++) {
+    RistSenderBond *bond = g_ptr_array_index (sink->bonds, i);
+
+    bond->weight = MAX_BOND_WEIGHT;
+    bond->loss = 0.0;
+    bond->last_pkt_sent = 0;
+    bond->last_rtx_requests = 0;
+  }
+
+  clock = gst_system_clock_obtain ();
+  start = gst_clock_get_time (clock) + WEIGHTS_UPDATE_INTERVAL;
+
+  sink->weights_cid = gst_clock_new_periodic_id (clock, start,
+      WEIGHTS_UPDATE_INTERVAL);
+  gst_clock_id_wait_async (sink->weights_cid, gst_rist_sink_update_weights,
+      gst_object_ref (sink), (GDestroyNotify) gst_object_unref);
+
+  gst_object_unref (clock);
+}
+
+static void
+gst_rist_sink_disable_weights_update (GstRistSink * sink)
+{
+  if (sink->weights_cid) {
+    gst_clock_id_unschedule (sink->weights_cid);
+    gst_clock_id_unref (sink->weights_cid);
+    sink->weights_cid = NULL;
+  }
+}
+
 static GstStateChangeReturn
 gst_rist_sink_change_state (GstElement * element, GstStateChange transition)
 {
@@ -896,6 +1059,7 @@ gst_rist_sink_change_state (GstElement * element, GstStateChange transition)
   switch (transition) {
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       gst_rist_sink_disable_stats_interval (sink);
+      gst_rist_sink_disable_weights_update (sink);
       break;
     default:
       break;
@@ -910,6 +1074,7 @@ gst_rist_sink_change_state (GstElement * element, GstStateChange transition)
       break;
     case GST_STATE_CHANGE_READY_TO_PAUSED:
       gst_rist_sink_enable_stats_interval (sink);
+      gst_rist_sink_enable_weights_update (sink);
       break;
     default:
       break;
@@ -27,6 +27,10 @@
  * element, which duplicates buffers over all pads. This element 
  * can be used to distrute load across multiple branches when the buffer
  * can be processed independently.
+ *
+ * Each src pad has a #GstRoundRobinPad:weight. Buffers are distributed
+ * proportionally to the weights, interleaving the pads as evenly as
+ * possible. With equal weights this is plain round robin.
  */
 
 #include "gstroundrobin.h"
@@ -47,30 +51,124 @@ static GstStaticPadTemplate src_templ = GST_STATIC_PAD_TEMPLATE ("src_%d",
 struct _GstRoundRobin
 {
   GstElement parent;
-  gint index;
 };
 
+struct _GstRoundRobinPad
+{
+  GstPad parent;
+
+  gint weight;
+  /* Smooth weighted round robin state, protected by the element lock */
+  gint64 current;
+};
+
+enum
+{
+  PROP_PAD_0,
+  PROP_PAD_WEIGHT,
+};
+
+#define DEFAULT_PAD_WEIGHT 1
+
 G_DEFINE_TYPE_WITH_CODE (GstRoundRobin, gst_round_robin,
     GST_TYPE_ELEMENT, GST_DEBUG_CATEGORY_INIT (gst_round_robin_debug,
         "roundrobin", 0, "Round Robin"));
 
+G_DEFINE_TYPE (GstRoundRobinPad, gst_round_robin_pad, GST_TYPE_PAD);
+
+static void
+gst_round_robin_pad_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstRoundRobinPad *pad = GST_ROUND_ROBIN_PAD (object);
+
+  switch (prop_id) {
+    case PROP_PAD_WEIGHT:
+      g_atomic_int_set (&pad->weight, g_value_get_uint (value));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_round_robin_pad_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstRoundRobinPad *pad = GST_ROUND_ROBIN_PAD (object);
+
+  switch (prop_id) {
+    case PROP_PAD_WEIGHT:
+      g_value_set_uint (value, g_atomic_int_get (&pad->weight));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_round_robin_pad_init (GstRoundRobinPad * pad)
+{
+  pad->weight = DEFAULT_PAD_WEIGHT;
+}
+
+static void
+gst_round_robin_pad_class_init (GstRoundRobinPadClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+
+  gobject_class->set_property = gst_round_robin_pad_set_property;
+  gobject_class->get_property = gst_round_robin_pad_get_property;
+
+  /**
+   * GstRoundRobinPad:weight:
+   *
+   * The share of the buffers sent to this pad, relative to the weights of
+   * the other pads. A pad with weight 0 receives no buffers.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_PAD_WEIGHT,
+      g_param_spec_uint ("weight", "Weight",
+          "Relative share of the buffers pushed on this pad",
+          0, G_MAXINT, DEFAULT_PAD_WEIGHT,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
+          G_PARAM_STATIC_STRINGS));
+}
+
 static GstFlowReturn
 gst_round_robin_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 {
   GstRoundRobin *disp = (GstRoundRobin *) parent;
   GstElement *elem = (GstElement *) parent;
+  GstRoundRobinPad *best = NULL;
   GstPad *src_pad = NULL;
+  gint64 total = 0;
   GstFlowReturn ret;
+  GList *l;
 
+  /* Smooth weighted round robin: every pad accumulates its weight, the one
+   * with the highest credit gets the buffer and pays back the total */
   GST_OBJECT_LOCK (disp);
-  if (disp->index >= elem->numsrcpads)
-    disp->index = 0;
+  for (l = elem->srcpads; l; l = l->next) {
+    GstRoundRobinPad *rrpad = l->data;
+    gint weight = g_atomic_int_get (&rrpad->weight);
 
-  src_pad = g_list_nth_data (elem->srcpads, disp->index);
+    if (weight == 0)
+      continue;
 
-  if (src_pad) {
-    gst_object_ref (src_pad);
-    disp->index += 1;
+    rrpad->current += weight;
+    total += weight;
+
+    if (!best || rrpad->current > best->current)
+      best = rrpad;
+  }
+
+  if (best) {
+    best->current -= total;
+    src_pad = gst_object_ref (best);
   }
   GST_OBJECT_UNLOCK (disp);
 
@@ -96,7 +194,8 @@ gst_round_robin_request_pad (GstElement * element, GstPadTemplate * templ,
     return NULL;
   }
 
-  pad = gst_pad_new_from_static_template (&src_templ, name);
+  pad = g_object_new (GST_TYPE_ROUND_ROBIN_PAD, "name", name,
+      "direction", templ->direction, "template", templ, NULL);
   gst_element_add_pad (element, pad);
 
   return pad;
@@ -128,8 +227,11 @@ gst_round_robin_class_init (GstRoundRobinClass * klass)
       "Nicolas Dufresne <nicolas.dufresne@collabora.com");
 
   gst_element_class_add_static_pad_template (element_class, &sink_templ);
-  gst_element_class_add_static_pad_template (element_class, &src_templ);
+  gst_element_class_add_static_pad_template_with_gtype (element_class,
+      &src_templ, GST_TYPE_ROUND_ROBIN_PAD);
 
   element_class->request_new_pad =
       GST_DEBUG_FUNCPTR (gst_round_robin_request_pad);
+
+  gst_type_mark_as_plugin_api (GST_TYPE_ROUND_ROBIN_PAD, 0);
 }
@@ -31,4 +31,12 @@ typedef struct {
 } GstRoundRobinClass;
 GType gst_round_robin_get_type (void);
 
+#define GST_TYPE_ROUND_ROBIN_PAD (gst_round_robin_pad_get_type())
+#define GST_ROUND_ROBIN_PAD(obj) (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_ROUND_ROBIN_PAD,GstRoundRobinPad))
+typedef struct _GstRoundRobinPad GstRoundRobinPad;
+typedef struct {
+  GstPadClass parent;
+} GstRoundRobinPadClass;
+GType gst_round_robin_pad_get_type (void);
+
 #endif
@@ -25,6 +25,7 @@
 
 #include "gstrtmp2src.h"
 #include "gstrtmp2sink.h"
+#include "gstrtmp2serversrc.h"
 
 #include "rtmp/rtmpclient.h"
 
@@ -35,6 +36,8 @@ plugin_init (GstPlugin * plugin)
       GST_TYPE_RTMP2_SRC);
   gst_element_register (plugin, "rtmp2sink", GST_RANK_PRIMARY + 1,
       GST_TYPE_RTMP2_SINK);
+  gst_element_register (plugin, "rtmp2serversrc", GST_RANK_NONE,
+      GST_TYPE_RTMP2_SERVER_SRC);
 
   gst_type_mark_as_plugin_api (GST_TYPE_RTMP_SCHEME, 0);
   gst_type_mark_as_plugin_api (GST_TYPE_RTMP_AUTHMOD, 0);
@@ -0,0 +1,1295 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+/**
+ * SECTION:element-rtmp2serversrc
+ * @title: rtmp2serversrc
+ *
+ * The rtmp2serversrc element listens for RTMP clients and accepts streams
+ * they publish, without the need for a separate RTMP server.
+ *
+ * Every accepted publisher gets its own "src_%u" pad, which outputs the
+ * published stream as FLV. The pad goes EOS and is removed when the
+ * publisher stops. All connections are served from a single thread.
+ *
+ * If #GstRtmp2ServerSrc:stream-keys is set, only those stream names may be
+ * published; any query string after a '?' in the published name is
+ * ignored when matching. Each stream key can only be published by one
+ * client at a time.
+ *
+ * ## Example launch line
+ * |[
+ * gst-launch-1.0 rtmp2serversrc port=1935 stream-keys="<key1,key2>" ! flvdemux ! decodebin ! autovideosink
+ * ]|
+ *
+ * Since: 1.20
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstrtmp2serversrc.h"
+
+#include "rtmp/rtmpconnection.h"
+#include "rtmp/rtmphandshake.h"
+#include "rtmp/rtmpmessage.h"
+
+#include <string.h>
+
+GST_DEBUG_CATEGORY_STATIC (gst_rtmp2_server_src_debug_category);
+#define GST_CAT_DEFAULT gst_rtmp2_server_src_debug_category
+
+/* prototypes */
+#define GST_RTMP2_SERVER_SRC(obj)   (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_RTMP2_SERVER_SRC,GstRtmp2ServerSrc))
+#define GST_IS_RTMP2_SERVER_SRC(obj)   (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_RTMP2_SERVER_SRC))
+
+/* Messages a publisher can have waiting for its pad. The connections share
+ * one thread, so a publisher whose pad is not keeping up gets its messages
+ * dropped instead of stalling everyone else. */
+#define MAX_QUEUED_MESSAGES 1024
+
+typedef struct _GstRtmp2ServerSrc GstRtmp2ServerSrc;
+
+typedef struct
+{
+  gint refcount;
+
+  /* not owned */
+  GstRtmp2ServerSrc *self;
+
+  /* loop thread only */
+  GstRtmpConnection *connection;
+  gchar *application;
+  guint32 next_stream_id;
+  guint32 stream_id;
+
+  /* set once when publishing starts */
+  gchar *stream_key;
+  GstPad *pad;
+
+  /* protected by self->lock */
+  GCond cond;
+  GQueue messages;
+  gboolean eos, flushing;
+
+  /* streaming thread only */
+  gboolean sent_header;
+  GstClockTime last_ts;
+} Session;
+
+struct _GstRtmp2ServerSrc
+{
+  GstElement parent_instance;
+
+  /* properties */
+  gchar *host;
+  gint port;
+  gchar *application;
+  gchar **stream_keys;
+
+  /* If both self->lock and OBJECT_LOCK are needed,
+   * self->lock must be taken first */
+  GMutex lock;
+
+  gboolean running;
+
+  GstTask *task;
+  GRecMutex task_lock;
+
+  GMainLoop *loop;
+  GMainContext *context;
+
+  GCancellable *cancellable;
+  GSocketService *service;
+
+  /* protected by lock */
+  GList *sessions;
+  GHashTable *publishing;
+  guint next_pad_id;
+};
+
+typedef struct
+{
+  GstElementClass parent_class;
+} GstRtmp2ServerSrcClass;
+
+/* GObject virtual functions */
+static void gst_rtmp2_server_src_set_property (GObject * object,
+    guint property_id, const GValue * value, GParamSpec * pspec);
+static void gst_rtmp2_server_src_get_property (GObject * object,
+    guint property_id, GValue * value, GParamSpec * pspec);
+static void gst_rtmp2_server_src_finalize (GObject * object);
+
+/* GstElement virtual functions */
+static GstStateChangeReturn gst_rtmp2_server_src_change_state (GstElement *
+    element, GstStateChange transition);
+
+/* Internal API */
+static void gst_rtmp2_server_src_task_func (gpointer user_data);
+static gboolean on_incoming (GSocketService * service,
+    GSocketConnection * connection, GObject * source_object,
+    GstRtmp2ServerSrc * self);
+static void handshake_done (GObject * source, GAsyncResult * result,
+    gpointer user_data);
+static void session_remove (GstRtmp2ServerSrc * self, Session * s);
+
+enum
+{
+  PROP_0,
+  PROP_HOST,
+  PROP_PORT,
+  PROP_APPLICATION,
+  PROP_STREAM_KEYS,
+};
+
+#define DEFAULT_HOST NULL
+#define DEFAULT_PORT 1935
+#define DEFAULT_APPLICATION NULL
+
+/* pad templates */
+
+static GstStaticPadTemplate gst_rtmp2_server_src_src_template =
+GST_STATIC_PAD_TEMPLATE ("src_%u",
+    GST_PAD_SRC,
+    GST_PAD_SOMETIMES,
+    GST_STATIC_CAPS ("video/x-flv")
+    );
+
+/* class initialization */
+
+G_DEFINE_TYPE (GstRtmp2ServerSrc, gst_rtmp2_server_src, GST_TYPE_ELEMENT);
+
+static void
+gst_rtmp2_server_src_class_init (GstRtmp2ServerSrcClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+
+  gst_element_class_add_static_pad_template (element_class,
+      &gst_rtmp2_server_src_src_template);
+
+  gst_element_class_set_static_metadata (element_class,
+      "RTMP server source element", "Source/Network",
+      "Accepts RTMP streams published by clients",
+      "GStreamer developers");
+
+  gobject_class->set_property = gst_rtmp2_server_src_set_property;
+  gobject_class->get_property = gst_rtmp2_server_src_get_property;
+  gobject_class->finalize = gst_rtmp2_server_src_finalize;
+  element_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_rtmp2_server_src_change_state);
+
+  /**
+   * GstRtmp2ServerSrc:host:
+   *
+   * The address to listen on, or %NULL to listen on all interfaces.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_HOST,
+      g_param_spec_string ("host", "Host",
+          "Address to listen on (NULL = all interfaces)", DEFAULT_HOST,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtmp2ServerSrc:port:
+   *
+   * The TCP port to listen on.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_PORT,
+      g_param_spec_int ("port", "Port", "Port to listen on",
+          1, 65535, DEFAULT_PORT,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtmp2ServerSrc:application:
+   *
+   * The application name clients have to connect to, or %NULL to accept
+   * any.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_APPLICATION,
+      g_param_spec_string ("application", "Application",
+          "Application name clients have to connect to (NULL = any)",
+          DEFAULT_APPLICATION,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstRtmp2ServerSrc:stream-keys:
+   *
+   * The stream names clients may publish, or %NULL to accept any.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_STREAM_KEYS,
+      g_param_spec_boxed ("stream-keys", "Stream keys",
+          "Stream names clients may publish (NULL = any)", G_TYPE_STRV,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  GST_DEBUG_CATEGORY_INIT (gst_rtmp2_server_src_debug_category,
+      "rtmp2serversrc", 0, "debug category for rtmp2serversrc element");
+}
+
+static void
+gst_rtmp2_server_src_init (GstRtmp2ServerSrc * self)
+{
+  self->host = g_strdup (DEFAULT_HOST);
+  self->port = DEFAULT_PORT;
+  self->application = g_strdup (DEFAULT_APPLICATION);
+
+  g_mutex_init (&self->lock);
+
+  self->task = gst_task_new (gst_rtmp2_server_src_task_func, self, NULL);
+  g_rec_mutex_init (&self->task_lock);
+  gst_task_set_lock (self->task, &self->task_lock);
+
+  self->publishing = g_hash_table_new (g_str_hash, g_str_equal);
+
+  GST_OBJECT_FLAG_SET (self, GST_ELEMENT_FLAG_SOURCE);
+}
+
+static void
+gst_rtmp2_server_src_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstRtmp2ServerSrc *self = GST_RTMP2_SERVER_SRC (object);
+
+  switch (property_id) {
+    case PROP_HOST:
+      GST_OBJECT_LOCK (self);
+      g_free (self->host);
+      self->host = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_PORT:
+      GST_OBJECT_LOCK (self);
+      self->port = g_value_get_int (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_APPLICATION:
+      GST_OBJECT_LOCK (self);
+      g_free (self->application);
+      self->application = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_STREAM_KEYS:
+      GST_OBJECT_LOCK (self);
+      g_strfreev (self->stream_keys);
+      self->stream_keys = g_value_dup_boxed (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_rtmp2_server_src_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstRtmp2ServerSrc *self = GST_RTMP2_SERVER_SRC (object);
+
+  switch (property_id) {
+    case PROP_HOST:
+      GST_OBJECT_LOCK (self);
+      g_value_set_string (value, self->host);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_PORT:
+      GST_OBJECT_LOCK (self);
+      g_value_set_int (value, self->port);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_APPLICATION:
+      GST_OBJECT_LOCK (self);
+      g_value_set_string (value, self->application);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_STREAM_KEYS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_boxed (value, self->stream_keys);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_rtmp2_server_src_finalize (GObject * object)
+{
+  GstRtmp2ServerSrc *self = GST_RTMP2_SERVER_SRC (object);
+
+  g_clear_object (&self->cancellable);
+  g_clear_object (&self->service);
+
+  g_clear_object (&self->task);
+  g_rec_mutex_clear (&self->task_lock);
+
+  g_mutex_clear (&self->lock);
+
+  g_clear_pointer (&self->publishing, g_hash_table_unref);
+
+  g_free (self->host);
+  g_free (self->application);
+  g_strfreev (self->stream_keys);
+
+  G_OBJECT_CLASS (gst_rtmp2_server_src_parent_class)->finalize (object);
+}
+
+static Session *
+session_new (GstRtmp2ServerSrc * self, GstRtmpConnection * connection)
+{
+  Session *s = g_slice_new0 (Session);
+
+  s->refcount = 1;
+  s->self = self;
+  s->connection = connection;
+  s->next_stream_id = 1;
+  s->last_ts = GST_CLOCK_TIME_NONE;
+
+  g_cond_init (&s->cond);
+  g_queue_init (&s->messages);
+
+  return s;
+}
+
+static Session *
+session_ref (Session * s)
+{
+  g_atomic_int_inc (&s->refcount);
+  return s;
+}
+
+static void
+session_unref (gpointer ptr)
+{
+  Session *s = ptr;
+
+  if (!g_atomic_int_dec_and_test (&s->refcount)) {
+    return;
+  }
+
+  /* session_close () already dropped the connection */
+  g_warn_if_fail (!s->connection);
+
+  g_queue_foreach (&s->messages, (GFunc) gst_buffer_unref, NULL);
+  g_queue_clear (&s->messages);
+  g_cond_clear (&s->cond);
+
+  if (s->pad) {
+    gst_object_unref (s->pad);
+  }
+
+  g_free (s->application);
+  g_free (s->stream_key);
+  g_slice_free (Session, s);
+}
+
+/* Drops the connection of @s. Loop thread only. */
+static void
+session_close (Session * s)
+{
+  GstRtmpConnection *connection = s->connection;
+
+  if (!connection) {
+    return;
+  }
+
+  s->connection = NULL;
+
+  g_signal_handlers_disconnect_by_data (connection, s);
+  gst_rtmp_connection_set_input_handler (connection, NULL, NULL, NULL);
+  gst_rtmp_connection_set_command_handler (connection, NULL, NULL, NULL);
+  gst_rtmp_connection_close_and_unref (connection);
+}
+
+/* The client went away or stopped publishing. The pad, if any, sends out
+ * whatever is still queued followed by EOS, then gets removed. */
+static gboolean
+session_end (gpointer user_data)
+{
+  Session *s = user_data;
+  GstRtmp2ServerSrc *self = s->self;
+  gboolean has_pad;
+
+  GST_INFO_OBJECT (self, "Ending session %p (stream '%s')", s,
+      GST_STR_NULL (s->stream_key));
+
+  session_close (s);
+
+  g_mutex_lock (&self->lock);
+  if (s->stream_key &&
+      g_hash_table_lookup (self->publishing, s->stream_key) == s) {
+    g_hash_table_remove (self->publishing, s->stream_key);
+  }
+  has_pad = s->pad != NULL;
+  s->eos = TRUE;
+  g_cond_signal (&s->cond);
+  g_mutex_unlock (&self->lock);
+
+  /* A pad whose task already stopped on a flow error won't get to EOS */
+  if (!has_pad || gst_pad_get_task_state (s->pad) == GST_TASK_PAUSED) {
+    session_remove (self, s);
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Defers session_end () out of connection callbacks, which must not tear
+ * down the connection that is calling them */
+static void
+session_end_later (Session * s)
+{
+  GSource *source = g_idle_source_new ();
+
+  g_source_set_callback (source, session_end, session_ref (s), session_unref);
+  g_source_attach (source, s->self->context);
+  g_source_unref (source);
+}
+
+static gboolean
+session_remove_idle (gpointer user_data)
+{
+  Session *s = user_data;
+
+  session_remove (s->self, s);
+  return G_SOURCE_REMOVE;
+}
+
+/* Removes @s from the element along with its pad. Must not be called from
+ * the pad's streaming thread. */
+static void
+session_remove (GstRtmp2ServerSrc * self, Session * s)
+{
+  GList *l;
+
+  g_mutex_lock (&self->lock);
+  l = g_list_find (self->sessions, s);
+  if (!l) {
+    g_mutex_unlock (&self->lock);
+    return;
+  }
+
+  self->sessions = g_list_delete_link (self->sessions, l);
+  if (s->stream_key &&
+      g_hash_table_lookup (self->publishing, s->stream_key) == s) {
+    g_hash_table_remove (self->publishing, s->stream_key);
+  }
+  s->flushing = TRUE;
+  g_cond_signal (&s->cond);
+  g_mutex_unlock (&self->lock);
+
+  if (s->pad) {
+    GST_DEBUG_OBJECT (self, "Removing pad %" GST_PTR_FORMAT, s->pad);
+    gst_pad_stop_task (s->pad);
+    gst_element_remove_pad (GST_ELEMENT (self), s->pad);
+  }
+
+  session_unref (s);
+}
+
+static GstBuffer *
+session_make_buffer (Session * s, GstBuffer * message)
+{
+  GstBuffer *buffer;
+  guint32 timestamp = 0;
+
+  static const guint8 flv_header_data[] = {
+    0x46, 0x4c, 0x56, 0x01, 0x01, 0x00, 0x00, 0x00,
+    0x09, 0x00, 0x00, 0x00, 0x00,
+  };
+
+  if (GST_BUFFER_DTS_IS_VALID (message)) {
+    GstClockTime last_ts = s->last_ts, ts = GST_BUFFER_DTS (message);
+
+    if (GST_CLOCK_TIME_IS_VALID (last_ts) && last_ts > ts) {
+      GST_LOG_OBJECT (s->pad, "Timestamp regression: %" GST_TIME_FORMAT
+          " > %" GST_TIME_FORMAT, GST_TIME_ARGS (last_ts), GST_TIME_ARGS (ts));
+    }
+
+    s->last_ts = ts;
+    timestamp = ts / GST_MSECOND;
+  }
+
+  buffer = gst_rtmp_message_to_flv_tag (message, timestamp);
+
+  if (!s->sent_header) {
+    GstMemory *memory = gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
+        (guint8 *) flv_header_data, sizeof flv_header_data, 0,
+        sizeof flv_header_data, NULL, NULL);
+    gst_buffer_prepend_memory (buffer, memory);
+    s->sent_header = TRUE;
+  }
+
+  GST_BUFFER_DTS (buffer) = s->last_ts;
+
+  return buffer;
+}
+
+static void
+session_pause (Session * s)
+{
+  GstRtmp2ServerSrc *self = s->self;
+
+  gst_pad_pause_task (s->pad);
+
+  g_mutex_lock (&self->lock);
+  if (s->eos && !s->flushing && self->context) {
+    GSource *source = g_idle_source_new ();
+
+    g_source_set_callback (source, session_remove_idle, session_ref (s),
+        session_unref);
+    g_source_attach (source, self->context);
+    g_source_unref (source);
+  }
+  g_mutex_unlock (&self->lock);
+}
+
+/* Pad task of a publishing session */
+static void
+session_loop (gpointer user_data)
+{
+  Session *s = user_data;
+  GstRtmp2ServerSrc *self = s->self;
+  GstBuffer *message;
+  GstFlowReturn ret;
+
+  g_mutex_lock (&self->lock);
+  while (g_queue_is_empty (&s->messages) && !s->eos && !s->flushing) {
+    g_cond_wait (&s->cond, &self->lock);
+  }
+
+  if (s->flushing) {
+    g_mutex_unlock (&self->lock);
+    GST_DEBUG_OBJECT (s->pad, "Flushing, pausing");
+    gst_pad_pause_task (s->pad);
+    return;
+  }
+
+  message = g_queue_pop_head (&s->messages);
+  g_mutex_unlock (&self->lock);
+
+  if (!message) {
+    GST_INFO_OBJECT (s->pad, "Publisher is gone, sending EOS");
+    gst_pad_push_event (s->pad, gst_event_new_eos ());
+    session_pause (s);
+    return;
+  }
+
+  ret = gst_pad_push (s->pad, session_make_buffer (s, message));
+  gst_buffer_unref (message);
+
+  switch (ret) {
+    case GST_FLOW_OK:
+      break;
+
+    case GST_FLOW_NOT_LINKED:
+      /* Other publishers may be linked; this one is simply discarded */
+      GST_LOG_OBJECT (s->pad, "Not linked");
+      break;
+
+    default:
+      GST_DEBUG_OBJECT (s->pad, "Pausing task, reason %s",
+          gst_flow_get_name (ret));
+
+      if (ret == GST_FLOW_NOT_NEGOTIATED || ret < GST_FLOW_EOS) {
+        GST_ELEMENT_FLOW_ERROR (self, ret);
+        gst_pad_push_event (s->pad, gst_event_new_eos ());
+      }
+
+      session_pause (s);
+      break;
+  }
+}
+
+static void
+session_start_output (Session * s)
+{
+  GstRtmp2ServerSrc *self = s->self;
+  GstPad *pad;
+  GstCaps *caps;
+  GstSegment segment;
+  gchar *name, *stream_id;
+
+  g_mutex_lock (&self->lock);
+  name = g_strdup_printf ("src_%u", self->next_pad_id++);
+  g_mutex_unlock (&self->lock);
+
+  pad = gst_pad_new_from_static_template (&gst_rtmp2_server_src_src_template,
+      name);
+  g_free (name);
+
+  gst_pad_use_fixed_caps (pad);
+  gst_pad_set_active (pad, TRUE);
+
+  stream_id = gst_pad_create_stream_id (pad, GST_ELEMENT (self),
+      s->stream_key);
+  gst_pad_push_event (pad, gst_event_new_stream_start (stream_id));
+  g_free (stream_id);
+
+  caps = gst_static_pad_template_get_caps (&gst_rtmp2_server_src_src_template);
+  gst_pad_push_event (pad, gst_event_new_caps (caps));
+  gst_caps_unref (caps);
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_pad_push_event (pad, gst_event_new_segment (&segment));
+
+  g_mutex_lock (&self->lock);
+  s->pad = gst_object_ref (pad);
+  g_mutex_unlock (&self->lock);
+
+  GST_INFO_OBJECT (self, "Publishing '%s' on %" GST_PTR_FORMAT,
+      s->stream_key, pad);
+
+  gst_element_add_pad (GST_ELEMENT (self), pad);
+  gst_pad_start_task (pad, session_loop, session_ref (s), session_unref);
+}
+
+static gboolean
+stream_key_allowed (GstRtmp2ServerSrc * self, const gchar * key)
+{
+  gboolean ret;
+
+  GST_OBJECT_LOCK (self);
+  ret = !self->stream_keys ||
+      g_strv_contains ((const gchar * const *) self->stream_keys, key);
+  GST_OBJECT_UNLOCK (self);
+
+  return ret;
+}
+
+static void
+send_status (Session * s, guint32 stream_id, const gchar * level,
+    const gchar * code, const gchar * description)
+{
+  GstAmfNode *command_object = gst_amf_node_new_null ();
+  GstAmfNode *info_object = gst_amf_node_new_object ();
+
+  gst_amf_node_append_field_string (info_object, "level", level, -1);
+  gst_amf_node_append_field_string (info_object, "code", code, -1);
+  gst_amf_node_append_field_string (info_object, "description",
+      description, -1);
+
+  gst_rtmp_connection_send_command (s->connection, NULL, NULL, stream_id,
+      "onStatus", command_object, info_object, NULL);
+
+  gst_amf_node_free (command_object);
+  gst_amf_node_free (info_object);
+}
+
+static void
+send_null_result (Session * s, guint32 stream_id, gdouble transaction_id)
+{
+  GstAmfNode *command_object;
+
+  if (transaction_id == 0) {
+    return;
+  }
+
+  command_object = gst_amf_node_new_null ();
+  gst_rtmp_connection_send_response (s->connection, stream_id,
+      transaction_id, "_result", command_object, NULL);
+  gst_amf_node_free (command_object);
+}
+
+static void
+handle_connect (Session * s, gdouble transaction_id, GPtrArray * args)
+{
+  GstRtmp2ServerSrc *self = s->self;
+  const GstAmfNode *app_node = NULL;
+  GstAmfNode *properties, *information;
+  gboolean accept;
+
+  if (s->application) {
+    GST_WARNING_OBJECT (self, "Client connected twice");
+    session_end_later (s);
+    return;
+  }
+
+  if (args->len > 0) {
+    app_node = gst_amf_node_get_field (g_ptr_array_index (args, 0), "app");
+  }
+
+  if (app_node && gst_amf_node_get_type (app_node) == GST_AMF_TYPE_STRING) {
+    s->application = gst_amf_node_get_string (app_node, NULL);
+  } else {
+    s->application = g_strdup ("");
+  }
+
+  GST_OBJECT_LOCK (self);
+  accept = !self->application ||
+      g_strcmp0 (self->application, s->application) == 0;
+  GST_OBJECT_UNLOCK (self);
+
+  properties = gst_amf_node_new_object ();
+  information = gst_amf_node_new_object ();
+
+  if (accept) {
+    GstRtmpProtocolControl pc = {
+      .type = GST_RTMP_MESSAGE_TYPE_SET_PEER_BANDWIDTH,
+      .param = GST_RTMP_DEFAULT_WINDOW_ACK_SIZE,
+      .param2 = 2,              /* dynamic */
+    };
+
+    GST_INFO_OBJECT (self, "Client connected to application '%s'",
+        s->application);
+
+    gst_rtmp_connection_request_window_size (s->connection,
+        GST_RTMP_DEFAULT_WINDOW_ACK_SIZE);
+    gst_rtmp_connection_queue_message (s->connection,
+        gst_rtmp_message_new_protocol_control (&pc));
+
+    /* Matches what librtmp clients expect from FMS */
+    gst_amf_node_append_field_string (properties, "fmsVer",
+        "FMS/3,0,1,123", -1);
+    gst_amf_node_append_field_number (properties, "capabilities", 31);
+
+    gst_amf_node_append_field_string (information, "level", "status", -1);
+    gst_amf_node_append_field_string (information, "code",
+        "NetConnection.Connect.Success", -1);
+    gst_amf_node_append_field_string (information, "description",
+        "Connection succeeded.", -1);
+    gst_amf_node_append_field_number (information, "objectEncoding", 0);
+
+    gst_rtmp_connection_send_response (s->connection, 0, transaction_id,
+        "_result", properties, information, NULL);
+  } else {
+    GST_WARNING_OBJECT (self, "Rejecting client for application '%s'",
+        s->application);
+
+    gst_amf_node_append_field_string (information, "level", "error", -1);
+    gst_amf_node_append_field_string (information, "code",
+        "NetConnection.Connect.Rejected", -1);
+    gst_amf_node_append_field_string (information, "description",
+        "Unknown application.", -1);
+
+    gst_rtmp_connection_send_response (s->connection, 0, transaction_id,
+        "_error", properties, information, NULL);
+    session_end_later (s);
+  }
+
+  gst_amf_node_free (properties);
+  gst_amf_node_free (information);
+}
+
+static void
+handle_create_stream (Session * s, gdouble transaction_id)
+{
+  GstAmfNode *command_object, *stream_id;
+  guint32 id = s->next_stream_id++;
+
+  GST_DEBUG_OBJECT (s->self, "Creating stream %" G_GUINT32_FORMAT, id);
+
+  command_object = gst_amf_node_new_null ();
+  stream_id = gst_amf_node_new_number (id);
+
+  gst_rtmp_connection_send_response (s->connection, 0, transaction_id,
+      "_result", command_object, stream_id, NULL);
+
+  gst_amf_node_free (command_object);
+  gst_amf_node_free (stream_id);
+}
+
+static void
+handle_publish (Session * s, guint32 stream_id, GPtrArray * args)
+{
+  GstRtmp2ServerSrc *self = s->self;
+  const GstAmfNode *name_node = NULL;
+  const gchar *name;
+  gchar *key;
+  gboolean in_use;
+
+  if (!s->application || stream_id == 0 || stream_id >= s->next_stream_id) {
+    GST_WARNING_OBJECT (self, "Publish on invalid stream %" G_GUINT32_FORMAT,
+        stream_id);
+    session_end_later (s);
+    return;
+  }
+
+  if (s->stream_id) {
+    GST_WARNING_OBJECT (self, "Client is already publishing '%s'",
+        s->stream_key);
+    send_status (s, stream_id, "error", "NetStream.Publish.BadName",
+        "Already publishing.");
+    return;
+  }
+
+  if (args->len > 1) {
+    name_node = g_ptr_array_index (args, 1);
+  }
+
+  if (!name_node || gst_amf_node_get_type (name_node) != GST_AMF_TYPE_STRING) {
+    GST_WARNING_OBJECT (self, "Publish without stream name");
+    send_status (s, stream_id, "error", "NetStream.Publish.BadName",
+        "Missing stream name.");
+    return;
+  }
+
+  name = gst_amf_node_peek_string (name_node, NULL);
+  key = g_strndup (name, strcspn (name, "?"));
+
+  if (!stream_key_allowed (self, key)) {
+    GST_WARNING_OBJECT (self, "Rejecting publish of unknown stream '%s'", key);
+    send_status (s, stream_id, "error", "NetStream.Publish.Denied",
+        "Unknown stream key.");
+    session_end_later (s);
+    g_free (key);
+    return;
+  }
+
+  g_mutex_lock (&self->lock);
+  in_use = g_hash_table_contains (self->publishing, key);
+  if (!in_use) {
+    s->stream_key = key;
+    g_hash_table_insert (self->publishing, s->stream_key, s);
+  }
+  g_mutex_unlock (&self->lock);
+
+  if (in_use) {
+    GST_WARNING_OBJECT (self, "Stream '%s' is already being published", key);
+    send_status (s, stream_id, "error", "NetStream.Publish.BadName",
+        "Stream already exists.");
+    session_end_later (s);
+    g_free (key);
+    return;
+  }
+
+  s->stream_id = stream_id;
+  session_start_output (s);
+
+  {
+    GstRtmpUserControl uc = {
+      .type = GST_RTMP_USER_CONTROL_TYPE_STREAM_BEGIN,
+      .param = stream_id,
+    };
+
+    gst_rtmp_connection_queue_message (s->connection,
+        gst_rtmp_message_new_user_control (&uc));
+  }
+
+  send_status (s, stream_id, "status", "NetStream.Publish.Start",
+      "Publishing started.");
+}
+
+static void
+got_command (GstRtmpConnection * connection, guint32 stream_id,
+    gdouble transaction_id, const gchar * command_name, GPtrArray * args,
+    gpointer user_data)
+{
+  Session *s = user_data;
+
+  if (g_strcmp0 (command_name, "connect") == 0) {
+    handle_connect (s, transaction_id, args);
+  } else if (g_strcmp0 (command_name, "createStream") == 0) {
+    handle_create_stream (s, transaction_id);
+  } else if (g_strcmp0 (command_name, "publish") == 0) {
+    handle_publish (s, stream_id, args);
+  } else if (g_strcmp0 (command_name, "releaseStream") == 0 ||
+      g_strcmp0 (command_name, "FCPublish") == 0) {
+    send_null_result (s, stream_id, transaction_id);
+  } else if (g_strcmp0 (command_name, "FCUnpublish") == 0 ||
+      g_strcmp0 (command_name, "closeStream") == 0 ||
+      g_strcmp0 (command_name, "deleteStream") == 0) {
+    send_null_result (s, stream_id, transaction_id);
+    if (s->stream_id) {
+      GST_INFO_OBJECT (s->self, "Client stopped publishing ('%s')",
+          command_name);
+      session_end_later (s);
+    }
+  } else if (g_strcmp0 (command_name, "play") == 0) {
+    GST_WARNING_OBJECT (s->self, "Client tried to play; only publishing is "
+        "supported");
+    session_end_later (s);
+  } else {
+    GST_DEBUG_OBJECT (s->self, "Ignoring command '%s'", command_name);
+    send_null_result (s, stream_id, transaction_id);
+  }
+}
+
+static void
+got_message (GstRtmpConnection * connection, GstBuffer * buffer,
+    gpointer user_data)
+{
+  Session *s = user_data;
+  GstRtmp2ServerSrc *self = s->self;
+  GstRtmpMeta *meta = gst_buffer_get_rtmp_meta (buffer);
+  guint32 min_size = 1;
+
+  /* "@setDataFrame" as an AMF0 string */
+  static const guint8 set_data_frame[] = {
+    0x02, 0x00, 0x0d, '@', 's', 'e', 't', 'D', 'a', 't', 'a', 'F', 'r', 'a',
+    'm', 'e',
+  };
+
+  g_return_if_fail (meta);
+
+  if (!s->stream_id || meta->mstream != s->stream_id) {
+    GST_DEBUG_OBJECT (self, "Ignoring %s message with stream %" G_GUINT32_FORMAT
+        " != %" G_GUINT32_FORMAT, gst_rtmp_message_type_get_nick (meta->type),
+        meta->mstream, s->stream_id);
+    return;
+  }
+
+  switch (meta->type) {
+    case GST_RTMP_MESSAGE_TYPE_VIDEO:
+      min_size = 6;
+      break;
+
+    case GST_RTMP_MESSAGE_TYPE_AUDIO:
+      min_size = 2;
+      break;
+
+    case GST_RTMP_MESSAGE_TYPE_DATA_AMF0:
+      break;
+
+    default:
+      GST_DEBUG_OBJECT (self, "Ignoring %s message, wrong type",
+          gst_rtmp_message_type_get_nick (meta->type));
+      return;
+  }
+
+  if (meta->size < min_size) {
+    GST_DEBUG_OBJECT (self, "Ignoring too small %s message (%" G_GUINT32_FORMAT
+        " < %" G_GUINT32_FORMAT ")",
+        gst_rtmp_message_type_get_nick (meta->type), meta->size, min_size);
+    return;
+  }
+
+  if (meta->type == GST_RTMP_MESSAGE_TYPE_DATA_AMF0 &&
+      meta->size > sizeof set_data_frame &&
+      gst_buffer_memcmp (buffer, 0, set_data_frame,
+          sizeof set_data_frame) == 0) {
+    /* FLV carries the metadata itself, without the command wrapping it */
+    GstClockTime dts = GST_BUFFER_DTS (buffer);
+
+    buffer = gst_buffer_copy_region (buffer, GST_BUFFER_COPY_ALL,
+        sizeof set_data_frame, -1);
+    GST_BUFFER_DTS (buffer) = dts;
+
+    meta = gst_buffer_get_rtmp_meta (buffer);
+    meta->size -= sizeof set_data_frame;
+  } else {
+    gst_buffer_ref (buffer);
+  }
+
+  g_mutex_lock (&self->lock);
+  if (s->eos || s->flushing) {
+    gst_buffer_unref (buffer);
+  } else if (s->messages.length >= MAX_QUEUED_MESSAGES) {
+    GST_WARNING_OBJECT (s->pad, "Too many queued messages, dropping %s",
+        gst_rtmp_message_type_get_nick (meta->type));
+    gst_buffer_unref (buffer);
+  } else {
+    g_queue_push_tail (&s->messages, buffer);
+    g_cond_signal (&s->cond);
+  }
+  g_mutex_unlock (&self->lock);
+}
+
+static void
+error_callback (GstRtmpConnection * connection, Session * s)
+{
+  GST_INFO_OBJECT (s->self, "Connection error");
+  session_end_later (s);
+}
+
+static gboolean
+on_incoming (GSocketService * service, GSocketConnection * connection,
+    GObject * source_object, GstRtmp2ServerSrc * self)
+{
+  GST_INFO_OBJECT (self, "Incoming connection");
+
+  gst_rtmp_server_handshake (G_IO_STREAM (connection), FALSE,
+      self->cancellable, handshake_done, self);
+
+  return TRUE;
+}
+
+static void
+handshake_done (GObject * source, GAsyncResult * result, gpointer user_data)
+{
+  GIOStream *stream = G_IO_STREAM (source);
+  GstRtmp2ServerSrc *self = GST_RTMP2_SERVER_SRC (user_data);
+  GstRtmpConnection *connection;
+  GError *error = NULL;
+  Session *s;
+
+  if (!gst_rtmp_server_handshake_finish (stream, result, &error)) {
+    if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+      GST_DEBUG_OBJECT (self, "Handshake was cancelled");
+    } else {
+      GST_WARNING_OBJECT (self, "Handshake failed: %s", error->message);
+    }
+    g_error_free (error);
+    return;
+  }
+
+  g_mutex_lock (&self->lock);
+  if (!self->running) {
+    g_mutex_unlock (&self->lock);
+    GST_DEBUG_OBJECT (self, "Stopping, dropping new connection");
+    return;
+  }
+  g_mutex_unlock (&self->lock);
+
+  /* Each connection has its own cancellable so closing one does not take
+   * the others down */
+  connection = gst_rtmp_connection_new (G_SOCKET_CONNECTION (stream), NULL);
+  s = session_new (self, connection);
+
+  gst_rtmp_connection_set_input_handler (connection, got_message,
+      session_ref (s), session_unref);
+  gst_rtmp_connection_set_command_handler (connection, got_command,
+      session_ref (s), session_unref);
+  g_signal_connect (connection, "error", G_CALLBACK (error_callback), s);
+
+  g_mutex_lock (&self->lock);
+  self->sessions = g_list_prepend (self->sessions, s);
+  g_mutex_unlock (&self->lock);
+
+  GST_DEBUG_OBJECT (self, "New session %p", s);
+}
+
+static gboolean
+gst_rtmp2_server_src_start (GstRtmp2ServerSrc * self)
+{
+  GSocketService *service;
+  GError *error = NULL;
+  gchar *host;
+  gint port;
+  gboolean res;
+
+  GST_OBJECT_LOCK (self);
+  host = g_strdup (self->host);
+  port = self->port;
+  GST_OBJECT_UNLOCK (self);
+
+  GST_INFO_OBJECT (self, "Listening on %s:%d", GST_STR_NULL (host), port);
+
+  service = g_socket_service_new ();
+
+  /* Services start out active; keep it from accepting on this thread's
+   * context until the loop thread starts it */
+  g_socket_service_stop (service);
+
+  if (host) {
+    GSocketAddress *address = g_inet_socket_address_new_from_string (host,
+        port);
+
+    if (!address) {
+      GST_ELEMENT_ERROR (self, RESOURCE, SETTINGS,
+          ("Invalid host address '%s'", host), (NULL));
+      g_object_unref (service);
+      g_free (host);
+      return FALSE;
+    }
+
+    res = g_socket_listener_add_address (G_SOCKET_LISTENER (service),
+        address, G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_TCP, NULL, NULL,
+        &error);
+    g_object_unref (address);
+  } else {
+    res = g_socket_listener_add_inet_port (G_SOCKET_LISTENER (service),
+        port, NULL, &error);
+  }
+
+  if (!res) {
+    GST_ELEMENT_ERROR (self, RESOURCE, OPEN_READ,
+        ("Could not listen on %s:%d", host ? host : "*", port),
+        ("%s", error->message));
+    g_error_free (error);
+    g_object_unref (service);
+    g_free (host);
+    return FALSE;
+  }
+
+  g_free (host);
+
+  g_mutex_lock (&self->lock);
+  self->running = TRUE;
+  self->service = service;
+  self->cancellable = g_cancellable_new ();
+  g_signal_connect (service, "incoming", G_CALLBACK (on_incoming), self);
+  gst_task_start (self->task);
+  g_mutex_unlock (&self->lock);
+
+  return TRUE;
+}
+
+static gboolean
+quit_invoker (gpointer user_data)
+{
+  g_main_loop_quit (user_data);
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gst_rtmp2_server_src_stop (GstRtmp2ServerSrc * self)
+{
+  GST_DEBUG_OBJECT (self, "stop");
+
+  g_mutex_lock (&self->lock);
+  gst_task_stop (self->task);
+  self->running = FALSE;
+
+  if (self->cancellable) {
+    GST_DEBUG_OBJECT (self, "Cancelling");
+    g_cancellable_cancel (self->cancellable);
+  }
+
+  if (self->loop) {
+    GST_DEBUG_OBJECT (self, "Stopping loop");
+    g_main_context_invoke_full (self->context, G_PRIORITY_DEFAULT_IDLE,
+        quit_invoker, g_main_loop_ref (self->loop),
+        (GDestroyNotify) g_main_loop_unref);
+  }
+  g_mutex_unlock (&self->lock);
+
+  gst_task_join (self->task);
+
+  /* The loop thread closed all connections; now drop the pads */
+  while (TRUE) {
+    Session *s = NULL;
+
+    g_mutex_lock (&self->lock);
+    if (self->sessions) {
+      s = session_ref (self->sessions->data);
+    }
+    g_mutex_unlock (&self->lock);
+
+    if (!s) {
+      break;
+    }
+
+    session_remove (self, s);
+    session_unref (s);
+  }
+
+  g_mutex_lock (&self->lock);
+  if (self->service) {
+    g_signal_handlers_disconnect_by_data (self->service, self);
+    g_clear_object (&self->service);
+  }
+  g_clear_object (&self->cancellable);
+  self->next_pad_id = 0;
+  g_mutex_unlock (&self->lock);
+}
+
+static GstStateChangeReturn
+gst_rtmp2_server_src_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstRtmp2ServerSrc *self = GST_RTMP2_SERVER_SRC (element);
+  GstStateChangeReturn ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      if (!gst_rtmp2_server_src_start (self)) {
+        return GST_STATE_CHANGE_FAILURE;
+      }
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_rtmp2_server_src_stop (self);
+      break;
+    default:
+      break;
+  }
+
+  ret = GST_ELEMENT_CLASS (gst_rtmp2_server_src_parent_class)->change_state
+      (element, transition);
+  if (ret == GST_STATE_CHANGE_FAILURE) {
+    return ret;
+  }
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+    case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
+      ret = GST_STATE_CHANGE_NO_PREROLL;
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+}
+
+/* Mainloop task, serving all connections */
+static void
+gst_rtmp2_server_src_task_func (gpointer user_data)
+{
+  GstRtmp2ServerSrc *self = GST_RTMP2_SERVER_SRC (user_data);
+  GMainContext *context;
+  GMainLoop *loop;
+  GList *sessions, *l;
+
+  GST_DEBUG_OBJECT (self, "gst_rtmp2_server_src_task starting");
+  g_mutex_lock (&self->lock);
+
+  if (!self->running) {
+    g_mutex_unlock (&self->lock);
+    return;
+  }
+
+  context = self->context = g_main_context_new ();
+  g_main_context_push_thread_default (context);
+  loop = self->loop = g_main_loop_new (context, TRUE);
+
+  /* Accepts on the thread-default context */
+  g_socket_service_start (self->service);
+
+  /* Run loop */
+  g_mutex_unlock (&self->lock);
+  g_main_loop_run (loop);
+  g_mutex_lock (&self->lock);
+
+  g_socket_service_stop (self->service);
+  g_socket_listener_close (G_SOCKET_LISTENER (self->service));
+
+  g_clear_pointer (&self->loop, g_main_loop_unref);
+
+  sessions = g_list_copy_deep (self->sessions, (GCopyFunc) session_ref, NULL);
+  g_mutex_unlock (&self->lock);
+
+  for (l = sessions; l; l = g_list_next (l)) {
+    session_close (l->data);
+  }
+  g_list_free_full (sessions, session_unref);
+
+  /* Run loop cleanup */
+  while (g_main_context_pending (context)) {
+    GST_DEBUG_OBJECT (self, "iterating main context to clean up");
+    g_main_context_iteration (context, FALSE);
+  }
+  g_main_context_pop_thread_default (context);
+
+  g_mutex_lock (&self->lock);
+  g_clear_pointer (&self->context, g_main_context_unref);
+  g_mutex_unlock (&self->lock);
+
+  GST_DEBUG_OBJECT (self, "gst_rtmp2_server_src_task exiting");
+}
@@ -68,6 +68,8 @@ typedef struct
   guint peak_kbps;
   guint32 chunk_size;
   GstRtmpStopCommands stop_commands;
+  GstClockTime max_queued_time;
+  guint64 max_queued_bytes;
   GstStructure *stats;
 
   /* If both self->lock and OBJECT_LOCK are needed,
@@ -89,6 +91,11 @@ typedef struct
 
   GPtrArray *headers;
   guint64 last_ts, base_ts;     /* timestamp fixup */
+
+  /* queue limits, protected by self->lock */
+  GstClockTime queued_dts;
+  gboolean dropping_video;
+  guint64 dropped_video, dropped_audio;
 } GstRtmp2Sink;
 
 typedef struct
@@ -150,6 +157,8 @@ enum
   PROP_CHUNK_SIZE,
   PROP_STATS,
   PROP_STOP_COMMANDS,
+  PROP_MAX_QUEUED_TIME,
+  PROP_MAX_QUEUED_BYTES,
 };
 
 /* pad templates */
@@ -244,6 +253,41 @@ gst_rtmp2_sink_class_init (GstRtmp2SinkClass * klass)
           GST_TYPE_RTMP_STOP_COMMANDS, GST_RTMP_DEFAULT_STOP_COMMANDS,
           (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
+  /**
+   * GstRtmp2Sink:max-queued-time:
+   *
+   * Maximum duration of the messages waiting to be written to the network.
+   * When this or #GstRtmp2Sink:max-queued-bytes is set, rendering no longer
+   * blocks on a slow connection. Instead, past the limit, video messages are
+   * dropped until the next keyframe, and audio and metadata messages only
+   * once the queue reaches twice the limit. Codec configuration messages are
+   * never dropped. The drops are counted in #GstRtmp2Sink:stats.
+   * 0 means no limit.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_QUEUED_TIME,
+      g_param_spec_uint64 ("max-queued-time", "Max queued time",
+          "Maximum duration of queued outgoing messages before dropping "
+          "(in ns, 0 = no limit)", 0, G_MAXUINT64, 0,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PLAYING));
+
+  /**
+   * GstRtmp2Sink:max-queued-bytes:
+   *
+   * Maximum size of the messages waiting to be written to the network.
+   * See #GstRtmp2Sink:max-queued-time. 0 means no limit.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_QUEUED_BYTES,
+      g_param_spec_uint64 ("max-queued-bytes", "Max queued bytes",
+          "Maximum size of queued outgoing messages before dropping "
+          "(0 = no limit)", 0, G_MAXUINT64, 0,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PLAYING));
+
   gst_type_mark_as_plugin_api (GST_TYPE_RTMP_LOCATION_HANDLER, 0);
   GST_DEBUG_CATEGORY_INIT (gst_rtmp2_sink_debug_category, "rtmp2sink", 0,
       "debug category for rtmp2sink element");
@@ -383,6 +427,18 @@ gst_rtmp2_sink_set_property (GObject * object, guint property_id,
       self->stop_commands = g_value_get_flags (value);
       GST_OBJECT_UNLOCK (self);
       break;
+    case PROP_MAX_QUEUED_TIME:
+      g_mutex_lock (&self->lock);
+      self->max_queued_time = g_value_get_uint64 (value);
+      g_cond_broadcast (&self->cond);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_MAX_QUEUED_BYTES:
+      g_mutex_lock (&self->lock);
+      self->max_queued_bytes = g_value_get_uint64 (value);
+      g_cond_broadcast (&self->cond);
+      g_mutex_unlock (&self->lock);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -485,6 +541,16 @@ gst_rtmp2_sink_get_property (GObject * object, guint property_id,
       g_value_set_flags (value, self->stop_commands);
       GST_OBJECT_UNLOCK (self);
       break;
+    case PROP_MAX_QUEUED_TIME:
+      g_mutex_lock (&self->lock);
+      g_value_set_uint64 (value, self->max_queued_time);
+      g_mutex_unlock (&self->lock);
+      break;
+    case PROP_MAX_QUEUED_BYTES:
+      g_mutex_lock (&self->lock);
+      g_value_set_uint64 (value, self->max_queued_bytes);
+      g_mutex_unlock (&self->lock);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -533,6 +599,13 @@ gst_rtmp2_sink_start (GstBaseSink * sink)
   self->last_ts = 0;
   self->base_ts = 0;
 
+  g_mutex_lock (&self->lock);
+  self->queued_dts = GST_CLOCK_TIME_NONE;
+  self->dropping_video = FALSE;
+  self->dropped_video = 0;
+  self->dropped_audio = 0;
+  g_mutex_unlock (&self->lock);
+
   if (async) {
     gst_task_start (self->task);
   }
@@ -814,6 +887,87 @@ is_running (GstRtmp2Sink * self)
   return G_LIKELY (self->running && !self->flushing);
 }
 
+static inline gboolean
+has_queue_limits (GstRtmp2Sink * self)
+{
+  return self->max_queued_time > 0 || self->max_queued_bytes > 0;
+}
+
+/* Whether the queue exceeds @factor times the limits */
+static gboolean
+queue_exceeds (GstRtmp2Sink * self, guint factor)
+{
+  if (self->max_queued_bytes > 0 &&
+      gst_rtmp_connection_get_bytes_queued (self->connection) >
+      factor * self->max_queued_bytes)
+    return TRUE;
+
+  if (self->max_queued_time > 0) {
+    GstClockTime dequeued_dts =
+        gst_rtmp_connection_get_dequeued_dts (self->connection);
+
+    if (GST_CLOCK_TIME_IS_VALID (dequeued_dts) &&
+        GST_CLOCK_TIME_IS_VALID (self->queued_dts) &&
+        self->queued_dts > dequeued_dts &&
+        self->queued_dts - dequeued_dts > factor * self->max_queued_time)
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+/* Called with self->lock, when the queue limits are enabled */
+static gboolean
+should_drop_message (GstRtmp2Sink * self, GstBuffer * message)
+{
+  GstRtmpMeta *meta = gst_buffer_get_rtmp_meta (message);
+  guint8 tag[2] = { 0, };
+  gboolean is_config = FALSE;
+
+  gst_buffer_extract (message, 0, tag, sizeof tag);
+
+  switch (meta->type) {
+    case GST_RTMP_MESSAGE_TYPE_VIDEO:{
+      gboolean keyframe = (tag[0] >> 4) == 1;
+
+      /* AVC sequence header */
+      is_config = keyframe && (tag[0] & 0x0f) == 7 && tag[1] == 0;
+      if (is_config)
+        return FALSE;
+
+      if (queue_exceeds (self, 1)) {
+        if (!self->dropping_video)
+          GST_WARNING_OBJECT (self, "Output queue full, dropping video until "
+              "the next keyframe");
+        self->dropping_video = TRUE;
+      } else if (self->dropping_video && keyframe) {
+        GST_INFO_OBJECT (self, "Resuming video on keyframe");
+        self->dropping_video = FALSE;
+      }
+
+      if (self->dropping_video)
+        self->dropped_video++;
+
+      return self->dropping_video;
+    }
+
+    case GST_RTMP_MESSAGE_TYPE_AUDIO:
+      /* AAC sequence header */
+      is_config = (tag[0] >> 4) == 10 && tag[1] == 0;
+      /* fallthrough */
+
+    default:
+      if (is_config || !queue_exceeds (self, 2))
+        return FALSE;
+
+      GST_WARNING_OBJECT (self, "Output queue overflowing, dropping %"
+          GST_PTR_FORMAT, message);
+      if (meta->type == GST_RTMP_MESSAGE_TYPE_AUDIO)
+        self->dropped_audio++;
+      return TRUE;
+  }
+}
+
 static GstFlowReturn
 gst_rtmp2_sink_render (GstBaseSink * sink, GstBuffer * buffer)
 {
@@ -853,6 +1007,7 @@ gst_rtmp2_sink_render (GstBaseSink * sink, GstBuffer * buffer)
   }
 
   while (G_UNLIKELY (is_running (self) && self->connection &&
+          !has_queue_limits (self) &&
           gst_rtmp_connection_get_num_queued (self->connection) > 3)) {
     GST_LOG_OBJECT (self, "Waiting for queue");
     g_cond_wait (&self->cond, &self->lock);
@@ -865,8 +1020,18 @@ gst_rtmp2_sink_render (GstBaseSink * sink, GstBuffer * buffer)
     gst_buffer_unref (message);
     /* send_connect_error has sent an ERROR message */
     ret = GST_FLOW_ERROR;
+  } else if (has_queue_limits (self) && self->headers->len == 0 &&
+      should_drop_message (self, message)) {
+    GST_LOG_OBJECT (self, "Dropping %" GST_PTR_FORMAT, message);
+    gst_buffer_unref (message);
+    ret = GST_FLOW_OK;
   } else {
+    GstRtmpMessageType type = gst_rtmp_message_get_type (message);
+
     send_streamheader (self);
+    if (type == GST_RTMP_MESSAGE_TYPE_VIDEO ||
+        type == GST_RTMP_MESSAGE_TYPE_AUDIO)
+      self->queued_dts = GST_BUFFER_DTS (message);
     send_message (self, message);
     ret = GST_FLOW_OK;
   }
@@ -1223,6 +1388,10 @@ gst_rtmp2_sink_get_stats (GstRtmp2Sink * self)
     s = gst_rtmp_connection_get_null_stats ();
   }
 
+  gst_structure_set (s,
+      "dropped-video-messages", G_TYPE_UINT64, self->dropped_video,
+      "dropped-audio-messages", G_TYPE_UINT64, self->dropped_audio, NULL);
+
   g_mutex_unlock (&self->lock);
 
   return s;
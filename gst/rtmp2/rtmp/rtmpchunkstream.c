@@ -666,21 +666,30 @@ gst_rtmp_chunk_stream_serialize_next (GstRtmpChunkStream * cstream,
   return serialize_next (cstream, chunk_size, CHUNK_TYPE_3);
 }
 
-GstBuffer *
+/* Each chunk is a buffer made of its header and a share of the message
+ * memory. Keeping them in a list, rather than appending them into a single
+ * buffer, avoids merging (and so copying) the payload once the buffer would
+ * exceed its maximum number of memories. */
+GstBufferList *
 gst_rtmp_chunk_stream_serialize_all (GstRtmpChunkStream * cstream,
     GstBuffer * buffer, guint32 chunk_size)
 {
-  GstBuffer *outbuf, *nextbuf;
+  GstBufferList *list;
+  GstBuffer *nextbuf;
+
+  nextbuf = gst_rtmp_chunk_stream_serialize_start (cstream, buffer, chunk_size);
+  if (!nextbuf)
+    return NULL;
 
-  outbuf = gst_rtmp_chunk_stream_serialize_start (cstream, buffer, chunk_size);
-  nextbuf = gst_rtmp_chunk_stream_serialize_next (cstream, chunk_size);
+  list = gst_buffer_list_new_sized (1 + gst_buffer_get_size (buffer) /
+      MAX (chunk_size, 1));
 
   while (nextbuf) {
-    outbuf = gst_buffer_append (outbuf, nextbuf);
+    gst_buffer_list_add (list, nextbuf);
     nextbuf = gst_rtmp_chunk_stream_serialize_next (cstream, chunk_size);
   }
 
-  return outbuf;
+  return list;
 }
 
 GstRtmpChunkStreams *
@@ -71,6 +71,10 @@ struct _GstRtmpConnection
   gpointer output_handler_user_data;
   GDestroyNotify output_handler_user_data_destroy;
 
+  GstRtmpConnectionCommandFunc command_handler;
+  gpointer command_handler_user_data;
+  GDestroyNotify command_handler_user_data_destroy;
+
   gboolean writing;
 
   /* Protects the values below during concurrent access.
@@ -89,6 +93,10 @@ struct _GstRtmpConnection
   guint64 out_bytes_total;
   guint64 in_bytes_acked;
   guint64 out_bytes_acked;
+
+  /* Messages in output_queue */
+  guint64 out_bytes_queued;
+  GstClockTime out_dequeued_dts;
 };
 
 
@@ -263,6 +271,7 @@ gst_rtmp_connection_init (GstRtmpConnection * rtmpconnection)
   rtmpconnection->input_needed_bytes = 1;
 
   g_mutex_init (&rtmpconnection->stats_lock);
+  rtmpconnection->out_dequeued_dts = GST_CLOCK_TIME_NONE;
 }
 
 void
@@ -277,6 +286,7 @@ gst_rtmp_connection_dispose (GObject * object)
   g_cancellable_cancel (rtmpconnection->cancellable);
   gst_rtmp_connection_set_input_handler (rtmpconnection, NULL, NULL, NULL);
   gst_rtmp_connection_set_output_handler (rtmpconnection, NULL, NULL, NULL);
+  gst_rtmp_connection_set_command_handler (rtmpconnection, NULL, NULL, NULL);
 
   G_OBJECT_CLASS (gst_rtmp_connection_parent_class)->dispose (object);
 }
@@ -434,6 +444,24 @@ gst_rtmp_connection_set_output_handler (GstRtmpConnection * sc,
   sc->output_handler_user_data_destroy = user_data_destroy;
 }
 
+/* Commands the peer sends that are neither responses nor expected are
+ * passed to the command handler, which is what a server needs to answer
+ * connect, createStream, publish, etc. Such a peer numbers transactions
+ * on its own, so they are not checked against ours. */
+void
+gst_rtmp_connection_set_command_handler (GstRtmpConnection * sc,
+    GstRtmpConnectionCommandFunc callback, gpointer user_data,
+    GDestroyNotify user_data_destroy)
+{
+  if (sc->command_handler_user_data_destroy) {
+    sc->command_handler_user_data_destroy (sc->command_handler_user_data);
+  }
+
+  sc->command_handler = callback;
+  sc->command_handler_user_data = user_data;
+  sc->command_handler_user_data_destroy = user_data_destroy;
+}
+
 static gboolean
 gst_rtmp_connection_input_ready (GInputStream * is, gpointer user_data)
 {
@@ -495,7 +523,8 @@ static void
 gst_rtmp_connection_start_write (GstRtmpConnection * self)
 {
   GOutputStream *os;
-  GstBuffer *message, *chunks;
+  GstBuffer *message;
+  GstBufferList *chunks;
   GstRtmpMeta *meta;
   GstRtmpChunkStream *cstream;
 
@@ -508,6 +537,12 @@ gst_rtmp_connection_start_write (GstRtmpConnection * self)
     return;
   }
 
+  g_mutex_lock (&self->stats_lock);
+  self->out_bytes_queued -= gst_buffer_get_size (message);
+  if (GST_BUFFER_DTS_IS_VALID (message))
+    self->out_dequeued_dts = GST_BUFFER_DTS (message);
+  g_mutex_unlock (&self->stats_lock);
+
   meta = gst_buffer_get_rtmp_meta (message);
   if (!meta) {
     GST_ERROR_OBJECT (self, "No RTMP meta on %" GST_PTR_FORMAT, message);
@@ -542,11 +577,11 @@ gst_rtmp_connection_start_write (GstRtmpConnection * self)
   }
 
   os = g_io_stream_get_output_stream (G_IO_STREAM (self->connection));
-  gst_rtmp_output_stream_write_all_buffer_async (os, chunks, G_PRIORITY_DEFAULT,
-      self->cancellable, gst_rtmp_connection_write_buffer_done,
-      g_object_ref (self));
+  gst_rtmp_output_stream_write_all_buffer_list_async (os, chunks,
+      G_PRIORITY_DEFAULT, self->cancellable,
+      gst_rtmp_connection_write_buffer_done, g_object_ref (self));
 
-  gst_buffer_unref (chunks);
+  gst_buffer_list_unref (chunks);
 
 out:
   gst_buffer_unref (message);
@@ -579,7 +614,7 @@ gst_rtmp_connection_write_buffer_done (GObject * obj,
 
   self->writing = FALSE;
 
-  res = gst_rtmp_output_stream_write_all_buffer_finish (os, result,
+  res = gst_rtmp_output_stream_write_all_buffer_list_finish (os, result,
       &bytes_written, &error);
 
   g_mutex_lock (&self->stats_lock);
@@ -1020,7 +1055,7 @@ gst_rtmp_connection_handle_cm (GstRtmpConnection * sc, GstBuffer * buffer)
     GST_WARNING_OBJECT (sc,
         "Server sent command \"%s\" with extreme transaction ID %.0f",
         GST_STR_NULL (command_name), transaction_id);
-  } else if (transaction_id > sc->transaction_count) {
+  } else if (!sc->command_handler && transaction_id > sc->transaction_count) {
     GST_WARNING_OBJECT (sc,
         "Server sent command \"%s\" with unused transaction ID (%.0f > %u)",
         GST_STR_NULL (command_name), transaction_id, sc->transaction_count);
@@ -1056,11 +1091,7 @@ gst_rtmp_connection_handle_cm (GstRtmpConnection * sc, GstBuffer * buffer)
     }
   } else {
     GList *l;
-
-    if (transaction_id != 0) {
-      GST_FIXME_OBJECT (sc, "Server sent command \"%s\" expecting reply",
-          GST_STR_NULL (command_name));
-    }
+    gboolean handled = FALSE;
 
     for (l = sc->expected_commands; l; l = g_list_next (l)) {
       ExpectedCommand *ec = l->data;
@@ -1078,8 +1109,21 @@ gst_rtmp_connection_handle_cm (GstRtmpConnection * sc, GstBuffer * buffer)
       sc->expected_commands = g_list_remove_link (sc->expected_commands, l);
       ec->func (command_name, args, ec->user_data);
       g_list_free_full (l, expected_command_free);
+      handled = TRUE;
       break;
     }
+
+    if (handled) {
+      /* consumed by an expected command */
+    } else if (sc->command_handler) {
+      GST_LOG_OBJECT (sc, "calling command handler %s",
+          GST_DEBUG_FUNCPTR_NAME (sc->command_handler));
+      sc->command_handler (sc, meta->mstream, transaction_id, command_name,
+          args, sc->command_handler_user_data);
+    } else if (transaction_id != 0) {
+      GST_FIXME_OBJECT (sc, "Server sent command \"%s\" expecting reply",
+          GST_STR_NULL (command_name));
+    }
   }
 
   g_free (command_name);
@@ -1100,6 +1144,10 @@ gst_rtmp_connection_queue_message (GstRtmpConnection * self, GstBuffer * buffer)
   g_return_if_fail (GST_IS_RTMP_CONNECTION (self));
   g_return_if_fail (GST_IS_BUFFER (buffer));
 
+  g_mutex_lock (&self->stats_lock);
+  self->out_bytes_queued += gst_buffer_get_size (buffer);
+  g_mutex_unlock (&self->stats_lock);
+
   g_async_queue_push (self->output_queue, buffer);
   g_main_context_invoke_full (self->main_context, G_PRIORITY_DEFAULT,
       start_write, g_object_ref (self), g_object_unref);
@@ -1111,18 +1159,59 @@ gst_rtmp_connection_get_num_queued (GstRtmpConnection * connection)
   return g_async_queue_length (connection->output_queue);
 }
 
+guint64
+gst_rtmp_connection_get_bytes_queued (GstRtmpConnection * connection)
+{
+  guint64 ret;
+
+  g_mutex_lock (&connection->stats_lock);
+  ret = connection->out_bytes_queued;
+  g_mutex_unlock (&connection->stats_lock);
+
+  return ret;
+}
+
+/* DTS of the last message taken off the output queue to be written */
+GstClockTime
+gst_rtmp_connection_get_dequeued_dts (GstRtmpConnection * connection)
+{
+  GstClockTime ret;
+
+  g_mutex_lock (&connection->stats_lock);
+  ret = connection->out_dequeued_dts;
+  g_mutex_unlock (&connection->stats_lock);
+
+  return ret;
+}
+
+static void
+queue_command_valist (GstRtmpConnection * connection, guint32 stream_id,
+    gdouble transaction_id, const gchar * command_name,
+    const GstAmfNode * argument, va_list ap)
+{
+  GstBuffer *buffer;
+  GBytes *payload;
+  guint8 *data;
+  gsize size;
+
+  payload = gst_amf_serialize_command_valist (transaction_id,
+      command_name, argument, ap);
+
+  data = g_bytes_unref_to_data (payload, &size);
+  buffer = gst_rtmp_message_new_wrapped (GST_RTMP_MESSAGE_TYPE_COMMAND_AMF0,
+      3, stream_id, data, size);
+
+  gst_rtmp_connection_queue_message (connection, buffer);
+}
+
 guint
 gst_rtmp_connection_send_command (GstRtmpConnection * connection,
     GstRtmpCommandCallback response_command, gpointer user_data,
     guint32 stream_id, const gchar * command_name, const GstAmfNode * argument,
     ...)
 {
-  GstBuffer *buffer;
   gdouble transaction_id = 0;
   va_list ap;
-  GBytes *payload;
-  guint8 *data;
-  gsize size;
 
   g_return_val_if_fail (GST_IS_RTMP_CONNECTION (connection), 0);
 
@@ -1148,18 +1237,39 @@ gst_rtmp_connection_send_command (GstRtmpConnection * connection,
   }
 
   va_start (ap, argument);
-  payload = gst_amf_serialize_command_valist (transaction_id,
-      command_name, argument, ap);
+  queue_command_valist (connection, stream_id, transaction_id, command_name,
+      argument, ap);
   va_end (ap);
 
-  data = g_bytes_unref_to_data (payload, &size);
-  buffer = gst_rtmp_message_new_wrapped (GST_RTMP_MESSAGE_TYPE_COMMAND_AMF0,
-      3, stream_id, data, size);
-
-  gst_rtmp_connection_queue_message (connection, buffer);
   return transaction_id;
 }
 
+/* Answers a command the peer sent with @transaction_id, with
+ * @command_name being "_result" or "_error" */
+void
+gst_rtmp_connection_send_response (GstRtmpConnection * connection,
+    guint32 stream_id, gdouble transaction_id, const gchar * command_name,
+    const GstAmfNode * argument, ...)
+{
+  va_list ap;
+
+  g_return_if_fail (GST_IS_RTMP_CONNECTION (connection));
+  g_return_if_fail (is_command_response (command_name));
+
+  if (connection->thread != g_thread_self ()) {
+    GST_ERROR_OBJECT (connection, "Called from wrong thread");
+  }
+
+  GST_DEBUG_OBJECT (connection,
+      "Sending response '%s' to transaction %.0f on stream id %"
+      G_GUINT32_FORMAT, command_name, transaction_id, stream_id);
+
+  va_start (ap, argument);
+  queue_command_valist (connection, stream_id, transaction_id, command_name,
+      argument, ap);
+  va_end (ap);
+}
+
 void
 gst_rtmp_connection_expect_command (GstRtmpConnection * connection,
     GstRtmpCommandCallback response_command, gpointer user_data,
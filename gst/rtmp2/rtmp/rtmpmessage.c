@@ -413,7 +413,7 @@ gst_rtmp_message_new_protocol_control (GstRtmpProtocolControl * pc)
   data = g_malloc (size);
   GST_WRITE_UINT32_BE (data, pc->param);
   if (pc_has_param2 (pc->type)) {
-    GST_WRITE_UINT32_BE (data + 4, pc->param2);
+    GST_WRITE_UINT8 (data + 4, pc->param2);
   }
 
   return gst_rtmp_message_new_wrapped (pc->type,
@@ -538,3 +538,38 @@ err:
   gst_buffer_unmap (buffer, &map);
   return ret;
 }
+
+/* Wraps the payload of @message into an FLV tag with the given timestamp
+ * (in milliseconds), sharing the payload memory */
+GstBuffer *
+gst_rtmp_message_to_flv_tag (GstBuffer * message, guint32 timestamp)
+{
+  GstRtmpMeta *meta = gst_buffer_get_rtmp_meta (message);
+  GstBuffer *buffer;
+
+  g_return_val_if_fail (meta, NULL);
+
+  buffer = gst_buffer_copy_region (message, GST_BUFFER_COPY_MEMORY, 0, -1);
+
+  {
+    guint8 *tag_header = g_malloc (11);
+    GstMemory *memory =
+        gst_memory_new_wrapped (0, tag_header, 11, 0, 11, tag_header, g_free);
+    GST_WRITE_UINT8 (tag_header, meta->type);
+    GST_WRITE_UINT24_BE (tag_header + 1, meta->size);
+    GST_WRITE_UINT24_BE (tag_header + 4, timestamp);
+    GST_WRITE_UINT8 (tag_header + 7, timestamp >> 24);
+    GST_WRITE_UINT24_BE (tag_header + 8, 0);
+    gst_buffer_prepend_memory (buffer, memory);
+  }
+
+  {
+    guint8 *tag_footer = g_malloc (4);
+    GstMemory *memory =
+        gst_memory_new_wrapped (0, tag_footer, 4, 0, 4, tag_footer, g_free);
+    GST_WRITE_UINT32_BE (tag_footer, meta->size + 11);
+    gst_buffer_append_memory (buffer, memory);
+  }
+
+  return buffer;
+}
@@ -32,6 +32,8 @@ static void write_all_bytes_done (GObject * source, GAsyncResult * result,
     gpointer user_data);
 static void write_all_buffer_done (GObject * source, GAsyncResult * result,
     gpointer user_data);
+static void write_all_buffer_list_done (GObject * source,
+    GAsyncResult * result, gpointer user_data);
 
 void
 gst_rtmp_byte_array_append_bytes (GByteArray * bytearray, GBytes * bytes)
@@ -257,6 +259,191 @@ gst_rtmp_output_stream_write_all_buffer_finish (GOutputStream * stream,
   return g_task_propagate_boolean (task, error);
 }
 
+typedef struct
+{
+  GstBufferList *list;
+  GstMapInfo *maps;
+  guint n_maps;
+  gsize bytes_written;
+#if GLIB_CHECK_VERSION(2,60,0)
+  GOutputVector *vectors;
+#else
+  guint next_map;
+#endif
+} WriteAllBufferListData;
+
+static void
+write_all_buffer_list_data_unmap (WriteAllBufferListData * data)
+{
+  guint i;
+
+  for (i = 0; i < data->n_maps; i++) {
+    gst_memory_unmap (data->maps[i].memory, &data->maps[i]);
+  }
+  data->n_maps = 0;
+}
+
+static void
+write_all_buffer_list_data_free (gpointer ptr)
+{
+  WriteAllBufferListData *data = ptr;
+
+  write_all_buffer_list_data_unmap (data);
+  g_free (data->maps);
+#if GLIB_CHECK_VERSION(2,60,0)
+  g_free (data->vectors);
+#endif
+  g_clear_pointer (&data->list, gst_buffer_list_unref);
+  g_slice_free (WriteAllBufferListData, data);
+}
+
+static gboolean
+write_all_buffer_list_data_map (WriteAllBufferListData * data)
+{
+  guint i, j, n_buffers, n_memories = 0;
+
+  n_buffers = gst_buffer_list_length (data->list);
+  for (i = 0; i < n_buffers; i++) {
+    n_memories += gst_buffer_n_memory (gst_buffer_list_get (data->list, i));
+  }
+
+  data->maps = g_new (GstMapInfo, n_memories);
+
+  for (i = 0; i < n_buffers; i++) {
+    GstBuffer *buffer = gst_buffer_list_get (data->list, i);
+    guint n = gst_buffer_n_memory (buffer);
+
+    for (j = 0; j < n; j++) {
+      GstMemory *mem = gst_buffer_peek_memory (buffer, j);
+
+      if (!gst_memory_map (mem, &data->maps[data->n_maps], GST_MAP_READ)) {
+        return FALSE;
+      }
+      data->n_maps++;
+    }
+  }
+
+  return TRUE;
+}
+
+#if !GLIB_CHECK_VERSION(2,60,0)
+static void
+write_all_buffer_list_next (GTask * task)
+{
+  WriteAllBufferListData *data = g_task_get_task_data (task);
+  GstMapInfo *map;
+
+  if (data->next_map >= data->n_maps) {
+    g_task_return_boolean (task, TRUE);
+    g_object_unref (task);
+    return;
+  }
+
+  map = &data->maps[data->next_map++];
+  g_output_stream_write_all_async (g_task_get_source_object (task),
+      map->data, map->size, g_task_get_priority (task),
+      g_task_get_cancellable (task), write_all_buffer_list_done, task);
+}
+#endif
+
+/* Writes all the memories of all the buffers of @list without merging
+ * them, using a single vectored write when available */
+void
+gst_rtmp_output_stream_write_all_buffer_list_async (GOutputStream * stream,
+    GstBufferList * list, int io_priority, GCancellable * cancellable,
+    GAsyncReadyCallback callback, gpointer user_data)
+{
+  GTask *task;
+  WriteAllBufferListData *data;
+
+  g_return_if_fail (G_IS_OUTPUT_STREAM (stream));
+  g_return_if_fail (GST_IS_BUFFER_LIST (list));
+
+  task = g_task_new (stream, cancellable, callback, user_data);
+  g_task_set_priority (task, io_priority);
+
+  data = g_slice_new0 (WriteAllBufferListData);
+  data->list = gst_buffer_list_ref (list);
+  g_task_set_task_data (task, data, write_all_buffer_list_data_free);
+
+  if (!write_all_buffer_list_data_map (data)) {
+    g_task_return_new_error (task, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_READ,
+        "Failed to map buffer for reading");
+    g_object_unref (task);
+    return;
+  }
+
+#if GLIB_CHECK_VERSION(2,60,0)
+  {
+    guint i;
+
+    data->vectors = g_new (GOutputVector, data->n_maps);
+    for (i = 0; i < data->n_maps; i++) {
+      data->vectors[i].buffer = data->maps[i].data;
+      data->vectors[i].size = data->maps[i].size;
+    }
+  }
+
+  g_output_stream_writev_all_async (stream, data->vectors, data->n_maps,
+      io_priority, cancellable, write_all_buffer_list_done, task);
+#else
+  write_all_buffer_list_next (task);
+#endif
+}
+
+static void
+write_all_buffer_list_done (GObject * source, GAsyncResult * result,
+    gpointer user_data)
+{
+  GOutputStream *os = G_OUTPUT_STREAM (source);
+  GTask *task = user_data;
+  WriteAllBufferListData *data = g_task_get_task_data (task);
+  GError *error = NULL;
+  gsize bytes_written = 0;
+  gboolean res;
+
+#if GLIB_CHECK_VERSION(2,60,0)
+  res = g_output_stream_writev_all_finish (os, result, &bytes_written,
+      &error);
+#else
+  res = g_output_stream_write_all_finish (os, result, &bytes_written, &error);
+#endif
+  data->bytes_written += bytes_written;
+
+  if (!res) {
+    write_all_buffer_list_data_unmap (data);
+    g_task_return_error (task, error);
+    g_object_unref (task);
+    return;
+  }
+
+#if GLIB_CHECK_VERSION(2,60,0)
+  write_all_buffer_list_data_unmap (data);
+  g_task_return_boolean (task, TRUE);
+  g_object_unref (task);
+#else
+  write_all_buffer_list_next (task);
+#endif
+}
+
+gboolean
+gst_rtmp_output_stream_write_all_buffer_list_finish (GOutputStream * stream,
+    GAsyncResult * result, gsize * bytes_written, GError ** error)
+{
+  WriteAllBufferListData *data;
+  GTask *task;
+
+  g_return_val_if_fail (g_task_is_valid (result, stream), FALSE);
+  task = G_TASK (result);
+
+  data = g_task_get_task_data (task);
+  if (bytes_written) {
+    *bytes_written = data->bytes_written;
+  }
+
+  return g_task_propagate_boolean (task, error);
+}
+
 static const gchar ascii_table[128] = {
   0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0,
   0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0,
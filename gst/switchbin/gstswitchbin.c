@@ -56,6 +56,13 @@
  * formats, like the example above (it applies volume only to 44.1 kHz PCM audio).
  * </refsect2>
  *
+ * By default, the element of a path is shut down to NULL when another path
+ * becomes the current one and has to go through all state changes again
+ * when it is selected later. With #GstSwitchBin:idle-state set to READY or
+ * PAUSED, the elements of all paths are kept in that state while they are
+ * not current, so a switch only needs to block the input and relink,
+ * which is noticeably faster with elements like hardware decoders.
+ *
  */
 
 #include <string.h>
@@ -71,10 +78,12 @@ enum
   PROP_0,
   PROP_NUM_PATHS,
   PROP_CURRENT_PATH,
+  PROP_IDLE_STATE,
   PROP_LAST
 };
 
 #define DEFAULT_NUM_PATHS 0
+#define DEFAULT_IDLE_STATE GST_STATE_NULL
 GParamSpec *switchbin_props[PROP_LAST];
 
 #define PATH_LOCK(obj) g_mutex_lock(&(GST_SWITCH_BIN_CAST (obj)->path_mutex))
@@ -118,6 +127,8 @@ static void gst_switch_bin_dispose (GObject * object);
 static void gst_switch_bin_finalize (GObject * object);
 static void gst_switch_bin_set_property (GObject * object, guint prop_id,
     GValue const *value, GParamSpec * pspec);
+static GstStateChangeReturn gst_switch_bin_change_state (GstElement *
+    element, GstStateChange transition);
 static void gst_switch_bin_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 
@@ -139,9 +150,13 @@ static GstSwitchBinPath *gst_switch_bin_find_matching_path (GstSwitchBin *
 
 static void gst_switch_bin_set_sinkpad_block (GstSwitchBin * switch_bin,
     gboolean do_block);
+static GstPadProbeReturn gst_switch_bin_drop_pad_probe (GstPad * pad,
+    GstPadProbeInfo * info, gpointer user_data);
 static GstPadProbeReturn gst_switch_bin_blocking_pad_probe (GstPad * pad,
     GstPadProbeInfo * info, gpointer user_data);
 
+static void gst_switch_bin_set_idle_path_state (GstSwitchBin * switch_bin,
+    GstSwitchBinPath * switch_bin_path, GstState bin_state);
 static GstCaps *gst_switch_bin_get_allowed_caps (GstSwitchBin * switch_bin,
     gchar const *pad_name, GstCaps * filter);
 static gboolean gst_switch_bin_are_caps_acceptable (GstSwitchBin *
@@ -255,6 +270,29 @@ gst_switch_bin_class_init (GstSwitchBinClass * klass)
   g_object_class_install_property (object_class,
       PROP_CURRENT_PATH, switchbin_props[PROP_CURRENT_PATH]);
 
+  /**
+   * GstSwitchBin:idle-state
+   *
+   * State the elements of the paths that are not the current one are kept
+   * in, at most the state of the switchbin itself. With NULL, a path
+   * element is shut down whenever another path is selected. READY and
+   * PAUSED keep the elements warm so switching to them does not have to go
+   * through a full state cycle. PAUSED is only safe for path elements that
+   * do not need data to complete the state change, i.e. not for sinks.
+   *
+   * Since: 1.20
+   */
+  switchbin_props[PROP_IDLE_STATE] =
+      g_param_spec_enum ("idle-state", "Idle state",
+      "State of the path elements that are not in use (NULL, READY or PAUSED)",
+      GST_TYPE_STATE, DEFAULT_IDLE_STATE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class,
+      PROP_IDLE_STATE, switchbin_props[PROP_IDLE_STATE]);
+
+  element_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_switch_bin_change_state);
+
   gst_element_class_set_static_metadata (element_class,
       "switchbin",
       "Generic/Bin",
@@ -275,6 +313,7 @@ gst_switch_bin_init (GstSwitchBin * switch_bin)
   switch_bin->blocking_probe_id = 0;
   switch_bin->drop_probe_id = 0;
   switch_bin->last_caps = NULL;
+  switch_bin->idle_state = DEFAULT_IDLE_STATE;
 
   switch_bin->sinkpad = gst_ghost_pad_new_no_target_from_template ("sink",
       gst_element_class_get_pad_template (GST_ELEMENT_GET_CLASS (switch_bin),
@@ -350,6 +389,26 @@ gst_switch_bin_set_property (GObject * object, guint prop_id,
       gst_switch_bin_set_num_paths (switch_bin, g_value_get_uint (value));
       PATH_UNLOCK_AND_CHECK (switch_bin);
       break;
+    case PROP_IDLE_STATE:
+    {
+      GstState state = g_value_get_enum (value);
+      guint i;
+
+      if (state > GST_STATE_PAUSED) {
+        GST_WARNING_OBJECT (switch_bin, "idle paths can at most be PAUSED");
+        state = GST_STATE_PAUSED;
+      } else if (state == GST_STATE_VOID_PENDING) {
+        state = GST_STATE_NULL;
+      }
+
+      PATH_LOCK (switch_bin);
+      switch_bin->idle_state = state;
+      for (i = 0; i < switch_bin->num_paths; ++i)
+        gst_switch_bin_set_idle_path_state (switch_bin, switch_bin->paths[i],
+            GST_STATE (switch_bin));
+      PATH_UNLOCK (switch_bin);
+      break;
+    }
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -385,6 +444,11 @@ gst_switch_bin_get_property (GObject * object, guint prop_id, GValue * value,
       }
       PATH_UNLOCK (switch_bin);
       break;
+    case PROP_IDLE_STATE:
+      PATH_LOCK (switch_bin);
+      g_value_set_enum (value, switch_bin->idle_state);
+      PATH_UNLOCK (switch_bin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -392,6 +456,31 @@ gst_switch_bin_get_property (GObject * object, guint prop_id, GValue * value,
 }
 
 
+static GstStateChangeReturn
+gst_switch_bin_change_state (GstElement * element, GstStateChange transition)
+{
+  GstSwitchBin *switch_bin = GST_SWITCH_BIN (element);
+  GstStateChangeReturn ret;
+  guint i;
+
+  ret = GST_ELEMENT_CLASS (gst_switch_bin_parent_class)->change_state (element,
+      transition);
+  if (ret == GST_STATE_CHANGE_FAILURE)
+    return ret;
+
+  /* The idle path elements are state locked and do not follow the bin on
+   * their own, so keep them within the configured idle state and the state
+   * the bin is going to */
+  PATH_LOCK (switch_bin);
+  for (i = 0; i < switch_bin->num_paths; ++i)
+    gst_switch_bin_set_idle_path_state (switch_bin, switch_bin->paths[i],
+        GST_STATE_TRANSITION_NEXT (transition));
+  PATH_UNLOCK (switch_bin);
+
+  return ret;
+}
+
+
 static gboolean
 gst_switch_bin_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
@@ -675,6 +764,7 @@ gst_switch_bin_switch_to_path (GstSwitchBin * switch_bin,
   /* must be called with path lock held */
 
   gboolean ret = TRUE;
+  GstPad *idle_srcpad = NULL, *idle_sinkpad = NULL;
 
   if (switch_bin_path != NULL)
     GST_DEBUG_OBJECT (switch_bin, "switching to path \"%s\" (%p)",
@@ -699,7 +789,22 @@ gst_switch_bin_switch_to_path (GstSwitchBin * switch_bin,
     GstSwitchBinPath *cur_path = switch_bin->current_path;
 
     if (cur_path->element != NULL) {
-      gst_element_set_state (cur_path->element, GST_STATE_NULL);
+      if (switch_bin->idle_state == GST_STATE_NULL) {
+        gst_element_set_state (cur_path->element, GST_STATE_NULL);
+      } else {
+        /* The element stays up, so stop it from pushing anything more
+         * downstream and flush out what it still holds from the old
+         * stream, without letting the flush itself out of the switchbin */
+        idle_srcpad = gst_element_get_static_pad (cur_path->element, "src");
+        idle_sinkpad = gst_element_get_static_pad (cur_path->element, "sink");
+        if (idle_srcpad != NULL)
+          switch_bin->drop_probe_id = gst_pad_add_probe (idle_srcpad,
+              GST_PAD_PROBE_TYPE_DATA_DOWNSTREAM,
+              gst_switch_bin_drop_pad_probe, NULL, NULL);
+        if (idle_sinkpad != NULL
+            && GST_STATE (cur_path->element) >= GST_STATE_PAUSED)
+          gst_pad_send_event (idle_sinkpad, gst_event_new_flush_start ());
+      }
       gst_element_unlink (switch_bin->input_identity, cur_path->element);
     }
 
@@ -707,6 +812,26 @@ gst_switch_bin_switch_to_path (GstSwitchBin * switch_bin,
 
     switch_bin->current_path = NULL;
     switch_bin->path_changed = TRUE;
+
+    /* Now that it is disconnected, the old path element can be put into
+     * its idle state */
+    if (cur_path->element != NULL && switch_bin->idle_state != GST_STATE_NULL) {
+      gst_element_set_locked_state (cur_path->element, TRUE);
+
+      if (idle_sinkpad != NULL) {
+        if (GST_STATE (cur_path->element) >= GST_STATE_PAUSED)
+          gst_pad_send_event (idle_sinkpad, gst_event_new_flush_stop (TRUE));
+        gst_object_unref (GST_OBJECT (idle_sinkpad));
+      }
+      if (idle_srcpad != NULL) {
+        gst_pad_remove_probe (idle_srcpad, switch_bin->drop_probe_id);
+        switch_bin->drop_probe_id = 0;
+        gst_object_unref (GST_OBJECT (idle_srcpad));
+      }
+
+      gst_switch_bin_set_idle_path_state (switch_bin, cur_path,
+          GST_STATE (switch_bin));
+    }
   }
 
   /* Link the new path's element (if a new path is specified) */
@@ -886,6 +1011,32 @@ gst_switch_bin_get_allowed_caps (GstSwitchBin * switch_bin,
 }
 
 
+static void
+gst_switch_bin_set_idle_path_state (GstSwitchBin * switch_bin,
+    GstSwitchBinPath * switch_bin_path, GstState bin_state)
+{
+  /* must be called with path lock held */
+
+  GstState state;
+
+  if ((switch_bin_path->element == NULL)
+      || (switch_bin_path == switch_bin->current_path))
+    return;
+
+  state = MIN (switch_bin->idle_state, bin_state);
+  if (GST_STATE_TARGET (switch_bin_path->element) == state)
+    return;
+
+  GST_DEBUG_OBJECT (switch_bin, "setting idle path \"%s\" to %s",
+      GST_OBJECT_NAME (switch_bin_path), gst_element_state_get_name (state));
+
+  if (gst_element_set_state (switch_bin_path->element,
+          state) == GST_STATE_CHANGE_FAILURE)
+    GST_WARNING_OBJECT (switch_bin, "could not set idle path \"%s\" to %s",
+        GST_OBJECT_NAME (switch_bin_path), gst_element_state_get_name (state));
+}
+
+
 static gboolean
 gst_switch_bin_are_caps_acceptable (GstSwitchBin * switch_bin,
     GstCaps const *caps)
@@ -940,6 +1091,13 @@ gst_switch_bin_blocking_pad_probe (G_GNUC_UNUSED GstPad * pad,
   return GST_PAD_PROBE_OK;
 }
 
+static GstPadProbeReturn
+gst_switch_bin_drop_pad_probe (G_GNUC_UNUSED GstPad * pad,
+    G_GNUC_UNUSED GstPadProbeInfo * info, G_GNUC_UNUSED gpointer user_data)
+{
+  return GST_PAD_PROBE_DROP;
+}
+
 /************ GstSwitchBinPath ************/
 
 
@@ -1155,6 +1313,10 @@ gst_switch_bin_path_use_new_element (GstSwitchBinPath * switch_bin_path,
      * but is unable to do so as long as it isn't linked. By locking the state,
      * it won't follow state changes, so the freeze does not happen. */
     gst_element_set_locked_state (new_element, TRUE);
+
+    /* Bring it to the idle state already if paths are kept warm */
+    gst_switch_bin_set_idle_path_state (switch_bin_path->bin, switch_bin_path,
+        GST_STATE (switch_bin_path->bin));
   }
 
   /* We are done. Switch back to the path if it is the current one,
@@ -60,6 +60,8 @@ struct _GstSwitchBin
 	gulong blocking_probe_id, drop_probe_id;
 
 	GstCaps *last_caps;
+
+	GstState idle_state;
 };
 
 
@@ -94,7 +94,8 @@ enum
   PROP_END_TIME_CODE,
   PROP_END_RUNNING_TIME,
   PROP_RECORDING,
-  PROP_MODE
+  PROP_MODE,
+  PROP_SCHEDULE
 };
 
 #define DEFAULT_TARGET_TIMECODE_STR "00:00:00:00"
@@ -111,6 +112,18 @@ enum
   END_MESSAGE_AUDIO_PUSHED = 4
 };
 
+/* one entry of the "schedule" property */
+typedef struct
+{
+  GstVideoTimeCode *start_tc, *end_tc;
+  GstClockTime start_running_time, end_running_time;
+} GstAvWaitWindow;
+
+typedef struct
+{
+  GstClockTime start, end;
+} GstAvWaitAudioWindow;
+
 static void gst_avwait_set_property (GObject * object,
     guint prop_id, const GValue * value, GParamSpec * pspec);
 static void gst_avwait_get_property (GObject * object,
@@ -218,6 +231,30 @@ gst_avwait_class_init (GstAvWaitClass * klass)
           "If set to FALSE, all buffers will be dropped regardless of settings.",
           TRUE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstAvWait:schedule:
+   *
+   * Start/stop windows to apply one after the other, so that several
+   * recordings can be made without restarting the element. Each entry is a
+   * "window" #GstStructure with "start-running-time" and "end-running-time"
+   * (#guint64) fields for the running-time mode, or "start-timecode" and
+   * "end-timecode" fields (a string in the form 00:00:00:00 or a
+   * #GstVideoTimeCode) for the timecode mode.
+   *
+   * When the end of the current window is reached, the first entry replaces
+   * the targets and is removed from the schedule. Windows must not overlap
+   * and should be at least one audio buffer apart.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_SCHEDULE,
+      gst_param_spec_array ("schedule", "Schedule",
+          "Start/stop windows to apply after the current one",
+          g_param_spec_boxed ("window", "Window",
+              "Start and end running time or timecode of a window",
+              GST_TYPE_STRUCTURE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS),
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gobject_class->finalize = gst_avwait_finalize;
   gstelement_class->change_state = gst_avwait_change_state;
 
@@ -303,6 +340,9 @@ gst_avwait_init (GstAvWait * self)
   self->end_running_time = DEFAULT_TARGET_RUNNING_TIME;
   self->mode = DEFAULT_MODE;
 
+  g_queue_init (&self->schedule);
+  g_queue_init (&self->audio_windows);
+
   gst_video_info_init (&self->vinfo);
   g_mutex_init (&self->mutex);
   g_cond_init (&self->cond);
@@ -323,6 +363,190 @@ gst_avwait_send_element_message (GstAvWait * self, gboolean dropping,
   }
 }
 
+static GstVideoTimeCode *
+gst_avwait_time_code_from_string (GstAvWait * self, const gchar * tc_str)
+{
+  GstVideoTimeCode *tc;
+  gchar **parts;
+  guint hours, minutes, seconds, frames;
+
+  parts = g_strsplit (tc_str, ":", 4);
+  if (!parts || parts[3] == NULL) {
+    GST_ERROR_OBJECT (self,
+        "Error: Could not parse timecode %s. Please input a timecode in the form 00:00:00:00",
+        tc_str);
+    g_strfreev (parts);
+    return NULL;
+  }
+  hours = g_ascii_strtoll (parts[0], NULL, 10);
+  minutes = g_ascii_strtoll (parts[1], NULL, 10);
+  seconds = g_ascii_strtoll (parts[2], NULL, 10);
+  frames = g_ascii_strtoll (parts[3], NULL, 10);
+  tc = gst_video_time_code_new (0, 1, NULL, 0, hours, minutes, seconds,
+      frames, 0);
+  g_strfreev (parts);
+
+  return tc;
+}
+
+static void
+gst_avwait_window_free (GstAvWaitWindow * window)
+{
+  if (window->start_tc)
+    gst_video_time_code_free (window->start_tc);
+  if (window->end_tc)
+    gst_video_time_code_free (window->end_tc);
+  g_free (window);
+}
+
+static gboolean
+gst_avwait_window_get_time_code (GstAvWait * self, const GstStructure * s,
+    const gchar * field, GstVideoTimeCode ** tc)
+{
+  const GValue *value = gst_structure_get_value (s, field);
+
+  *tc = NULL;
+  if (!value)
+    return TRUE;
+
+  if (G_VALUE_HOLDS_STRING (value))
+    *tc = gst_avwait_time_code_from_string (self, g_value_get_string (value));
+  else if (G_VALUE_HOLDS (value, GST_TYPE_VIDEO_TIME_CODE))
+    *tc = g_value_dup_boxed (value);
+  else
+    GST_ERROR_OBJECT (self, "Invalid type for %s in %" GST_PTR_FORMAT, field,
+        s);
+
+  return *tc != NULL;
+}
+
+static GstAvWaitWindow *
+gst_avwait_window_new_from_structure (GstAvWait * self,
+    const GstStructure * s)
+{
+  GstAvWaitWindow *window = g_new0 (GstAvWaitWindow, 1);
+
+  window->start_running_time = GST_CLOCK_TIME_NONE;
+  window->end_running_time = GST_CLOCK_TIME_NONE;
+
+  if (!gst_avwait_window_get_time_code (self, s, "start-timecode",
+          &window->start_tc)
+      || !gst_avwait_window_get_time_code (self, s, "end-timecode",
+          &window->end_tc)) {
+    gst_avwait_window_free (window);
+    return NULL;
+  }
+  gst_structure_get_uint64 (s, "start-running-time",
+      &window->start_running_time);
+  gst_structure_get_uint64 (s, "end-running-time", &window->end_running_time);
+
+  return window;
+}
+
+static GstStructure *
+gst_avwait_window_to_structure (const GstAvWaitWindow * window)
+{
+  GstStructure *s = gst_structure_new_empty ("window");
+
+  if (window->start_tc)
+    gst_structure_take_string (s, "start-timecode",
+        gst_video_time_code_to_string (window->start_tc));
+  if (window->end_tc)
+    gst_structure_take_string (s, "end-timecode",
+        gst_video_time_code_to_string (window->end_tc));
+  if (GST_CLOCK_TIME_IS_VALID (window->start_running_time))
+    gst_structure_set (s, "start-running-time", G_TYPE_UINT64,
+        window->start_running_time, NULL);
+  if (GST_CLOCK_TIME_IS_VALID (window->end_running_time))
+    gst_structure_set (s, "end-running-time", G_TYPE_UINT64,
+        window->end_running_time, NULL);
+
+  return s;
+}
+
+/* Called with the mutex held. Audio start/end targets set by the video
+ * thread belong to the newest window */
+static void
+gst_avwait_set_audio_start (GstAvWait * self, GstClockTime running_time)
+{
+  GstAvWaitAudioWindow *window = g_queue_peek_tail (&self->audio_windows);
+
+  if (window)
+    window->start = running_time;
+  else
+    self->audio_running_time_to_wait_for = running_time;
+}
+
+static void
+gst_avwait_set_audio_end (GstAvWait * self, GstClockTime running_time)
+{
+  GstAvWaitAudioWindow *window = g_queue_peek_tail (&self->audio_windows);
+
+  if (window)
+    window->end = running_time;
+  else
+    self->audio_running_time_to_end_at = running_time;
+}
+
+static void
+gst_avwait_reset_audio_targets (GstAvWait * self)
+{
+  g_queue_foreach (&self->audio_windows, (GFunc) g_free, NULL);
+  g_queue_clear (&self->audio_windows);
+  self->audio_running_time_to_wait_for = GST_CLOCK_TIME_NONE;
+  self->audio_running_time_to_end_at = GST_CLOCK_TIME_NONE;
+}
+
+/* Called with the mutex held once the video has reached the end of the
+ * current window: makes the next scheduled window the target */
+static void
+gst_avwait_start_next_window (GstAvWait * self)
+{
+  GstAvWaitWindow *window = g_queue_pop_head (&self->schedule);
+
+  if (!window)
+    return;
+
+  if (self->mode == MODE_TIMECODE) {
+    if (window->start_tc) {
+      if (self->tc)
+        gst_video_time_code_free (self->tc);
+      self->tc = g_steal_pointer (&window->start_tc);
+    }
+    if (self->end_tc)
+      gst_video_time_code_free (self->end_tc);
+    self->end_tc = g_steal_pointer (&window->end_tc);
+    if (self->vinfo.fps_n != 0) {
+      if (self->tc && self->tc->config.fps_n == 0) {
+        self->tc->config.fps_n = self->vinfo.fps_n;
+        self->tc->config.fps_d = self->vinfo.fps_d;
+      }
+      if (self->end_tc && self->end_tc->config.fps_n == 0) {
+        self->end_tc->config.fps_n = self->vinfo.fps_n;
+        self->end_tc->config.fps_d = self->vinfo.fps_d;
+      }
+    }
+  } else if (self->mode == MODE_RUNNING_TIME) {
+    self->target_running_time = window->start_running_time;
+    self->end_running_time = window->end_running_time;
+  }
+  gst_avwait_window_free (window);
+
+  GST_INFO_OBJECT (self, "Moving on to the next scheduled window");
+  self->running_time_to_wait_for = GST_CLOCK_TIME_NONE;
+  self->running_time_to_end_at = GST_CLOCK_TIME_NONE;
+  self->dropping = TRUE;
+
+  /* The audio may still be catching up with the window that just ended */
+  {
+    GstAvWaitAudioWindow *audio_window = g_new (GstAvWaitAudioWindow, 1);
+
+    audio_window->start = GST_CLOCK_TIME_NONE;
+    audio_window->end = GST_CLOCK_TIME_NONE;
+    g_queue_push_tail (&self->audio_windows, audio_window);
+  }
+}
+
 static GstStateChangeReturn
 gst_avwait_change_state (GstElement * element, GstStateChange transition)
 {
@@ -361,8 +585,7 @@ gst_avwait_change_state (GstElement * element, GstStateChange transition)
         GST_DEBUG_OBJECT (self, "First time reset in paused to ready");
         self->running_time_to_wait_for = GST_CLOCK_TIME_NONE;
         self->running_time_to_end_at = GST_CLOCK_TIME_NONE;
-        self->audio_running_time_to_wait_for = GST_CLOCK_TIME_NONE;
-        self->audio_running_time_to_end_at = GST_CLOCK_TIME_NONE;
+        gst_avwait_reset_audio_targets (self);
       }
       if (!self->dropping) {
         self->dropping = TRUE;
@@ -406,6 +629,16 @@ gst_avwait_finalize (GObject * object)
     self->end_tc = NULL;
   }
 
+  g_queue_foreach (&self->schedule, (GFunc) gst_avwait_window_free, NULL);
+  g_queue_clear (&self->schedule);
+  g_queue_foreach (&self->audio_windows, (GFunc) g_free, NULL);
+  g_queue_clear (&self->audio_windows);
+
+  if (self->last_seen_tc) {
+    gst_video_time_code_free (self->last_seen_tc);
+    self->last_seen_tc = NULL;
+  }
+
   g_mutex_clear (&self->mutex);
   g_cond_clear (&self->cond);
   g_cond_clear (&self->audio_cond);
@@ -465,6 +698,20 @@ gst_avwait_get_property (GObject * object, guint prop_id,
       g_mutex_unlock (&self->mutex);
       break;
     }
+    case PROP_SCHEDULE:{
+      GList *l;
+
+      g_mutex_lock (&self->mutex);
+      for (l = self->schedule.head; l; l = l->next) {
+        GValue v = G_VALUE_INIT;
+
+        g_value_init (&v, GST_TYPE_STRUCTURE);
+        g_value_take_boxed (&v, gst_avwait_window_to_structure (l->data));
+        gst_value_array_append_and_take_value (value, &v);
+      }
+      g_mutex_unlock (&self->mutex);
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -479,35 +726,21 @@ gst_avwait_set_property (GObject * object, guint prop_id,
 
   switch (prop_id) {
     case PROP_TARGET_TIME_CODE_STRING:{
-      gchar **parts;
-      const gchar *tc_str;
-      guint hours, minutes, seconds, frames;
-
-      tc_str = g_value_get_string (value);
-      parts = g_strsplit (tc_str, ":", 4);
-      if (!parts || parts[3] == NULL) {
-        GST_ERROR_OBJECT (self,
-            "Error: Could not parse timecode %s. Please input a timecode in the form 00:00:00:00",
-            tc_str);
-        g_strfreev (parts);
+      GstVideoTimeCode *tc;
+
+      tc = gst_avwait_time_code_from_string (self, g_value_get_string (value));
+      if (!tc)
         return;
-      }
-      hours = g_ascii_strtoll (parts[0], NULL, 10);
-      minutes = g_ascii_strtoll (parts[1], NULL, 10);
-      seconds = g_ascii_strtoll (parts[2], NULL, 10);
-      frames = g_ascii_strtoll (parts[3], NULL, 10);
       g_mutex_lock (&self->mutex);
       if (self->tc)
         gst_video_time_code_free (self->tc);
-      self->tc = gst_video_time_code_new (0, 1, NULL, 0, hours, minutes,
-          seconds, frames, 0);
+      self->tc = tc;
       if (GST_VIDEO_INFO_FORMAT (&self->vinfo) != GST_VIDEO_FORMAT_UNKNOWN
           && self->vinfo.fps_n != 0) {
         self->tc->config.fps_n = self->vinfo.fps_n;
         self->tc->config.fps_d = self->vinfo.fps_d;
       }
       g_mutex_unlock (&self->mutex);
-      g_strfreev (parts);
       break;
     }
     case PROP_TARGET_TIME_CODE:{
@@ -602,6 +835,33 @@ gst_avwait_set_property (GObject * object, guint prop_id,
       g_mutex_unlock (&self->mutex);
       break;
     }
+    case PROP_SCHEDULE:{
+      GQueue schedule = G_QUEUE_INIT;
+      guint i, n = gst_value_array_get_size (value);
+
+      for (i = 0; i < n; i++) {
+        const GValue *v = gst_value_array_get_value (value, i);
+        const GstStructure *s = gst_value_get_structure (v);
+        GstAvWaitWindow *window;
+
+        window = s ? gst_avwait_window_new_from_structure (self, s) : NULL;
+        if (!window) {
+          GST_ERROR_OBJECT (self, "Invalid window %u in schedule", i);
+          g_queue_foreach (&schedule, (GFunc) gst_avwait_window_free, NULL);
+          g_queue_clear (&schedule);
+          return;
+        }
+        g_queue_push_tail (&schedule, window);
+      }
+
+      g_mutex_lock (&self->mutex);
+      g_queue_foreach (&self->schedule, (GFunc) gst_avwait_window_free,
+          NULL);
+      g_queue_clear (&self->schedule);
+      self->schedule = schedule;
+      g_mutex_unlock (&self->mutex);
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -629,8 +889,7 @@ gst_avwait_vsink_event (GstPad * pad, GstObject * parent, GstEvent * event)
       GST_DEBUG_OBJECT (self, "First time reset in video segment");
       self->running_time_to_wait_for = GST_CLOCK_TIME_NONE;
       self->running_time_to_end_at = GST_CLOCK_TIME_NONE;
-      self->audio_running_time_to_wait_for = GST_CLOCK_TIME_NONE;
-      self->audio_running_time_to_end_at = GST_CLOCK_TIME_NONE;
+      gst_avwait_reset_audio_targets (self);
       if (!self->dropping) {
         self->dropping = TRUE;
         send_message = TRUE;
@@ -663,11 +922,11 @@ gst_avwait_vsink_event (GstPad * pad, GstObject * parent, GstEvent * event)
         if (running_time > self->running_time_to_wait_for
             && running_time <= self->running_time_to_end_at) {
           /* We just stopped recording: synchronise the audio */
-          self->audio_running_time_to_end_at = running_time;
+          gst_avwait_set_audio_end (self, running_time);
           self->must_send_end_message |= END_MESSAGE_STREAM_ENDED;
         } else if (running_time < self->running_time_to_wait_for
             && self->running_time_to_wait_for != GST_CLOCK_TIME_NONE) {
-          self->audio_running_time_to_wait_for = GST_CLOCK_TIME_NONE;
+          gst_avwait_set_audio_start (self, GST_CLOCK_TIME_NONE);
         }
       }
 
@@ -701,8 +960,7 @@ gst_avwait_vsink_event (GstPad * pad, GstObject * parent, GstEvent * event)
       GST_DEBUG_OBJECT (self, "First time reset in video flush");
       self->running_time_to_wait_for = GST_CLOCK_TIME_NONE;
       self->running_time_to_end_at = GST_CLOCK_TIME_NONE;
-      self->audio_running_time_to_wait_for = GST_CLOCK_TIME_NONE;
-      self->audio_running_time_to_end_at = GST_CLOCK_TIME_NONE;
+      gst_avwait_reset_audio_targets (self);
       if (!self->dropping) {
         self->dropping = TRUE;
         send_message = TRUE;
@@ -848,11 +1106,17 @@ gst_avwait_vsink_chain (GstPad * pad, GstObject * parent, GstBuffer * inbuf)
 
   tc_meta = gst_buffer_get_video_time_code_meta (inbuf);
   if (tc_meta) {
-    tc = gst_video_time_code_copy (&tc_meta->tc);
-    if (self->last_seen_tc) {
-      gst_video_time_code_free (self->last_seen_tc);
-    }
-    self->last_seen_tc = tc;
+    /* Update the last seen timecode in place rather than allocating a copy
+     * for every frame */
+    if (self->last_seen_tc)
+      gst_video_time_code_clear (self->last_seen_tc);
+    else
+      self->last_seen_tc = gst_video_time_code_new_empty ();
+    gst_video_time_code_init (self->last_seen_tc, tc_meta->tc.config.fps_n,
+        tc_meta->tc.config.fps_d, tc_meta->tc.config.latest_daily_jam,
+        tc_meta->tc.config.flags, tc_meta->tc.hours, tc_meta->tc.minutes,
+        tc_meta->tc.seconds, tc_meta->tc.frames, tc_meta->tc.field_count);
+    tc = self->last_seen_tc;
   }
 
   while (self->mode == MODE_VIDEO_FIRST
@@ -904,10 +1168,8 @@ gst_avwait_vsink_chain (GstPad * pad, GstObject * parent, GstBuffer * inbuf)
           emit_passthrough_signal = self->dropping;
           self->dropping = FALSE;
           self->running_time_to_wait_for = running_time;
-          if (self->recording) {
-            self->audio_running_time_to_wait_for =
-                self->running_time_to_wait_for;
-          }
+          if (self->recording)
+            gst_avwait_set_audio_start (self, self->running_time_to_wait_for);
         }
 
         if (self->end_tc && gst_video_time_code_compare (tc, self->end_tc) >= 0) {
@@ -917,9 +1179,10 @@ gst_avwait_vsink_chain (GstPad * pad, GstObject * parent, GstBuffer * inbuf)
             self->dropping = TRUE;
             self->running_time_to_end_at = running_time;
             if (self->recording) {
-              self->audio_running_time_to_end_at = self->running_time_to_end_at;
+              gst_avwait_set_audio_end (self, self->running_time_to_end_at);
               self->must_send_end_message |= END_MESSAGE_STREAM_ENDED;
             }
+            gst_avwait_start_next_window (self);
           }
 
           if (inbuf) {
@@ -952,7 +1215,7 @@ gst_avwait_vsink_chain (GstPad * pad, GstObject * parent, GstBuffer * inbuf)
         self->dropping = FALSE;
         self->running_time_to_wait_for = running_time;
         if (self->recording) {
-          self->audio_running_time_to_wait_for = running_time;
+          gst_avwait_set_audio_start (self, running_time);
         }
         if (self->recording) {
           send_message = TRUE;
@@ -971,9 +1234,10 @@ gst_avwait_vsink_chain (GstPad * pad, GstObject * parent, GstBuffer * inbuf)
           self->dropping = TRUE;
           self->running_time_to_end_at = running_time;
           if (self->recording) {
-            self->audio_running_time_to_end_at = running_time;
+            gst_avwait_set_audio_end (self, running_time);
             self->must_send_end_message |= END_MESSAGE_STREAM_ENDED;
           }
+          gst_avwait_start_next_window (self);
         }
 
         if (inbuf) {
@@ -994,7 +1258,7 @@ gst_avwait_vsink_chain (GstPad * pad, GstObject * parent, GstBuffer * inbuf)
         GST_DEBUG_OBJECT (self, "First video running time is %" GST_TIME_FORMAT,
             GST_TIME_ARGS (self->running_time_to_wait_for));
         if (self->recording) {
-          self->audio_running_time_to_wait_for = self->running_time_to_wait_for;
+          gst_avwait_set_audio_start (self, self->running_time_to_wait_for);
         }
         if (self->dropping) {
           self->dropping = FALSE;
@@ -1020,11 +1284,11 @@ gst_avwait_vsink_chain (GstPad * pad, GstObject * parent, GstBuffer * inbuf)
         /* We just stopped recording: synchronise the audio */
         if (self->running_time_to_end_at == GST_CLOCK_TIME_NONE)
           self->running_time_to_end_at = running_time;
-        self->audio_running_time_to_end_at = running_time;
+        gst_avwait_set_audio_end (self, running_time);
         self->must_send_end_message |= END_MESSAGE_STREAM_ENDED;
       } else if (running_time < self->running_time_to_wait_for
           && self->running_time_to_wait_for != GST_CLOCK_TIME_NONE) {
-        self->audio_running_time_to_wait_for = GST_CLOCK_TIME_NONE;
+        gst_avwait_set_audio_start (self, GST_CLOCK_TIME_NONE);
       }
     }
 
@@ -1050,17 +1314,16 @@ gst_avwait_vsink_chain (GstPad * pad, GstObject * parent, GstBuffer * inbuf)
           if (self->running_time_to_wait_for != GST_CLOCK_TIME_NONE
               && running_time > self->running_time_to_wait_for) {
             /* We just started recording: synchronise the audio */
-            self->audio_running_time_to_wait_for = running_time;
+            gst_avwait_set_audio_start (self, running_time);
             send_message = TRUE;
             message_running_time = running_time;
             message_dropping = FALSE;
           } else {
             /* We will start in the future when running_time_to_wait_for is
              * reached */
-            self->audio_running_time_to_wait_for =
-                self->running_time_to_wait_for;
+            gst_avwait_set_audio_start (self, self->running_time_to_wait_for);
           }
-          self->audio_running_time_to_end_at = self->running_time_to_end_at;
+          gst_avwait_set_audio_end (self, self->running_time_to_end_at);
         }
       } else {
         /* We are in video-first mode and behind the first audio timestamp. We
@@ -1232,6 +1495,19 @@ gst_avwait_asink_chain (GstPad * pad, GstObject * parent, GstBuffer * inbuf)
     return GST_FLOW_FLUSHING;
   }
 
+  /* Once past the end of the current window, and once its end message has
+   * been taken care of, move on to the next scheduled window if video
+   * already started one */
+  if (current_running_time >= self->audio_running_time_to_end_at
+      && !(self->must_send_end_message & END_MESSAGE_STREAM_ENDED)
+      && !g_queue_is_empty (&self->audio_windows)) {
+    GstAvWaitAudioWindow *window = g_queue_pop_head (&self->audio_windows);
+
+    self->audio_running_time_to_wait_for = window->start;
+    self->audio_running_time_to_end_at = window->end;
+    g_free (window);
+  }
+
   if (self->audio_running_time_to_wait_for == GST_CLOCK_TIME_NONE
       /* Audio ends before start : drop */
       || gst_avwait_compare_guint64_with_signs (esign,
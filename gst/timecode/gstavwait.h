@@ -76,6 +76,13 @@ struct _GstAvWait
   GstClockTime audio_running_time_to_wait_for;
   GstClockTime audio_running_time_to_end_at;
 
+  /* Start/stop windows still to be applied after the current one */
+  GQueue schedule;
+  /* Audio start/end of the windows video has moved on to while audio is
+   * still in an earlier one. The audio targets above are the ones of the
+   * oldest window */
+  GQueue audio_windows;
+
   gboolean video_eos_flag;
   gboolean audio_eos_flag;
   gboolean video_flush_flag;
@@ -6,23 +6,41 @@
 #ifdef HAVE_GETRUSAGE
 #include "gst-cpu-throttling-clock.h"
 
+#include <stdio.h>
 #include <unistd.h>
 #include <sys/resource.h>
 
-#include "gst-cpu-throttling-clock.h"
-
 /**
  * SECTION: gst-cpu-throttling-clock
  * @title: GstCpuThrottlingClock
- * @short_description: TODO
+ * @short_description: Clock slowing down a pipeline to a CPU budget
+ *
+ * Every clock wait is lengthened by a delay driven by a PID controller so
+ * that the measured CPU usage converges to #GstCpuThrottlingClock:cpu-usage.
  *
- * TODO
+ * On Linux with cgroup v2, the usage of the whole cgroup of the process is
+ * measured from its `cpu.stat` and compared to the capacity granted by the
+ * `cpu.max` limits of the cgroup and its parents. Background transcodes
+ * sharing a container with other workloads then only take the CPU time
+ * those leave unused. Elsewhere the usage of the process is measured with
+ * getrusage() against the number of available processors.
  */
 
 /* *INDENT-OFF* */
 GST_DEBUG_CATEGORY_STATIC (gst_cpu_throttling_clock_debug);
 #define GST_CAT_DEFAULT gst_cpu_throttling_clock_debug
 
+#define CGROUP_ROOT "/sys/fs/cgroup"
+
+/* Controller gains, the error is in percent of the CPU capacity and the
+ * output is the wait time in nanoseconds */
+#define PID_KP (20.0 * GST_USECOND)
+#define PID_KI (100.0 * GST_USECOND)
+#define PID_KD (2.0 * GST_USECOND)
+#define MAX_WAIT_TIME GST_SECOND
+/* Weight of the latest sample in the smoothed usage */
+#define USAGE_SMOOTHING 0.5
+
 struct _GstCpuThrottlingClockPrivate
 {
   guint wanted_cpu_usage;
@@ -30,7 +48,15 @@ struct _GstCpuThrottlingClockPrivate
   GstClock *sclock;
   GstClockTime current_wait_time;
   GstPoll *timer;
-  struct rusage last_usage;
+
+  /* cgroup v2 directory of the process, NULL to use getrusage() */
+  gchar *cgroup_dir;
+  GstClockTime last_cpu_time;
+  GstClockTime last_eval_time;
+
+  gdouble integral;
+  gdouble last_error;
+  gdouble achieved_cpu_usage;
 
   GstClockID evaluate_wait_time;
   GstClockTime time_between_evals;
@@ -43,6 +69,7 @@ enum
 {
   PROP_FIRST,
   PROP_CPU_USAGE,
+  PROP_ACHIEVED_CPU_USAGE,
   PROP_LAST
 };
 
@@ -59,6 +86,11 @@ gst_cpu_throttling_clock_get_property (GObject * object,
     case PROP_CPU_USAGE:
       g_value_set_uint (value, self->priv->wanted_cpu_usage);
       break;
+    case PROP_ACHIEVED_CPU_USAGE:
+      GST_OBJECT_LOCK (self);
+      g_value_set_double (value, self->priv->achieved_cpu_usage);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -83,35 +115,165 @@ gst_cpu_throttling_clock_set_property (GObject * object,
   }
 }
 
+static gchar *
+find_cgroup_dir (void)
+{
+#ifdef __linux__
+  gchar *contents = NULL, *dir = NULL, *stat;
+  gchar **lines, **line;
+
+  if (!g_file_get_contents ("/proc/self/cgroup", &contents, NULL, NULL))
+    return NULL;
+
+  /* The cgroup v2 hierarchy is the one with ID 0 and no controller list */
+  lines = g_strsplit (contents, "\n", -1);
+  for (line = lines; *line; line++) {
+    if (g_str_has_prefix (*line, "0::")) {
+      dir = g_build_filename (CGROUP_ROOT, *line + 3, NULL);
+      break;
+    }
+  }
+  g_strfreev (lines);
+  g_free (contents);
+
+  if (!dir)
+    return NULL;
+
+  stat = g_build_filename (dir, "cpu.stat", NULL);
+  if (!g_file_test (stat, G_FILE_TEST_EXISTS))
+    g_clear_pointer (&dir, g_free);
+  g_free (stat);
+
+  return dir;
+#else
+  return NULL;
+#endif
+}
+
 static gboolean
-gst_transcoder_adjust_wait_time (GstClock * sync_clock, GstClockTime time,
-    GstClockID id, GstCpuThrottlingClock * self)
+read_cgroup_cpu_time (const gchar * dir, GstClockTime * cpu_time)
+{
+  gchar *path, *contents = NULL;
+  gchar **lines, **line;
+  gboolean ret = FALSE;
+
+  path = g_build_filename (dir, "cpu.stat", NULL);
+  if (!g_file_get_contents (path, &contents, NULL, NULL)) {
+    g_free (path);
+    return FALSE;
+  }
+  g_free (path);
+
+  lines = g_strsplit (contents, "\n", -1);
+  for (line = lines; *line; line++) {
+    guint64 usec;
+
+    if (sscanf (*line, "usage_usec %" G_GUINT64_FORMAT, &usec) == 1) {
+      *cpu_time = usec * GST_USECOND;
+      ret = TRUE;
+      break;
+    }
+  }
+  g_strfreev (lines);
+  g_free (contents);
+
+  return ret;
+}
+
+/* Number of CPUs worth of time the measured usage can reach */
+static gdouble
+get_cpu_capacity (GstCpuThrottlingClock * self)
 {
+  gdouble capacity = g_get_num_processors ();
+  gchar *dir;
+
+  if (!self->priv->cgroup_dir)
+    return capacity;
+
+  /* The most restrictive cpu.max up the hierarchy is what applies */
+  dir = g_strdup (self->priv->cgroup_dir);
+  while (g_str_has_prefix (dir, CGROUP_ROOT "/")) {
+    gchar *path = g_build_filename (dir, "cpu.max", NULL);
+    gchar *contents = NULL, *parent;
+    guint64 quota, period;
+
+    if (g_file_get_contents (path, &contents, NULL, NULL) &&
+        sscanf (contents, "%" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT,
+            &quota, &period) == 2 && period > 0)
+      capacity = MIN (capacity, (gdouble) quota / period);
+    g_free (contents);
+    g_free (path);
+
+    parent = g_path_get_dirname (dir);
+    g_free (dir);
+    dir = parent;
+  }
+  g_free (dir);
+
+  return capacity;
+}
+
+static GstClockTime
+get_cpu_time (GstCpuThrottlingClock * self)
+{
+  GstClockTime cpu_time;
   struct rusage ru;
-  float delta_usage, usage, coef;
 
-  GstCpuThrottlingClockPrivate *priv = self->priv;
+  if (self->priv->cgroup_dir &&
+      read_cgroup_cpu_time (self->priv->cgroup_dir, &cpu_time))
+    return cpu_time;
 
   getrusage (RUSAGE_SELF, &ru);
-  delta_usage = GST_TIMEVAL_TO_TIME (ru.ru_utime) -
-      GST_TIMEVAL_TO_TIME (self->priv->last_usage.ru_utime);
-  usage =
-      ((float) delta_usage / self->priv->time_between_evals * 100) /
-      g_get_num_processors ();
 
-  self->priv->last_usage = ru;
+  return GST_TIMEVAL_TO_TIME (ru.ru_utime) + GST_TIMEVAL_TO_TIME (ru.ru_stime);
+}
 
-  coef = GST_MSECOND / 10;
-  if (usage < (gfloat) priv->wanted_cpu_usage) {
-    coef = -coef;
-  }
+static gboolean
+gst_transcoder_adjust_wait_time (GstClock * sync_clock, GstClockTime time,
+    GstClockID id, GstCpuThrottlingClock * self)
+{
+  GstCpuThrottlingClockPrivate *priv = self->priv;
+  GstClockTime now, cpu_time;
+  gdouble dt, usage, error, derivative, wait_time;
+
+  now = gst_clock_get_time (priv->sclock);
+  cpu_time = get_cpu_time (self);
+
+  if (now <= priv->last_eval_time || cpu_time < priv->last_cpu_time)
+    goto done;
+
+  dt = (gdouble) (now - priv->last_eval_time) / GST_SECOND;
+  usage = (gdouble) (cpu_time - priv->last_cpu_time) /
+      (now - priv->last_eval_time) * 100 / get_cpu_capacity (self);
+
+  GST_OBJECT_LOCK (self);
+  priv->achieved_cpu_usage = USAGE_SMOOTHING * usage +
+      (1 - USAGE_SMOOTHING) * priv->achieved_cpu_usage;
+  usage = priv->achieved_cpu_usage;
+  GST_OBJECT_UNLOCK (self);
+
+  /* Positive when using too much, the wait time must then grow */
+  error = usage - priv->wanted_cpu_usage;
+  derivative = (error - priv->last_error) / dt;
+  priv->last_error = error;
 
-  priv->current_wait_time = CLAMP (0,
-      (GstClockTime) priv->current_wait_time + coef, GST_SECOND);
+  wait_time = PID_KP * error + PID_KI * (priv->integral + error * dt) +
+      PID_KD * derivative;
+
+  /* Only integrate while not saturated so that the controller reacts as
+   * soon as the load changes, even after running unthrottled for long */
+  if ((wait_time > 0 || error > 0) && (wait_time < MAX_WAIT_TIME || error < 0))
+    priv->integral += error * dt;
+
+  priv->current_wait_time = CLAMP (wait_time, 0, MAX_WAIT_TIME);
 
   GST_DEBUG_OBJECT (self,
-      "Avg is %f (wanted %d) => %" GST_TIME_FORMAT, usage,
-      self->priv->wanted_cpu_usage, GST_TIME_ARGS (priv->current_wait_time));
+      "Usage is %f (wanted %d) => %" GST_TIME_FORMAT, usage,
+      priv->wanted_cpu_usage, GST_TIME_ARGS (priv->current_wait_time));
+
+done:
+  priv->last_eval_time = now;
+  priv->last_cpu_time = cpu_time;
 
   return TRUE;
 }
@@ -165,6 +327,18 @@ gst_cpu_throttling_clock_dispose (GObject * object)
     gst_clock_id_unref (self->priv->evaluate_wait_time);
     self->priv->evaluate_wait_time = 0;
   }
+
+  G_OBJECT_CLASS (parent_class)->dispose (object);
+}
+
+static void
+gst_cpu_throttling_clock_finalize (GObject * object)
+{
+  GstCpuThrottlingClock *self = GST_CPU_THROTTLING_CLOCK (object);
+
+  g_free (self->priv->cgroup_dir);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
 static void
@@ -179,6 +353,7 @@ gst_cpu_throttling_clock_class_init (GstCpuThrottlingClockClass * klass)
   oclass->get_property = gst_cpu_throttling_clock_get_property;
   oclass->set_property = gst_cpu_throttling_clock_set_property;
   oclass->dispose = gst_cpu_throttling_clock_dispose;
+  oclass->finalize = gst_cpu_throttling_clock_finalize;
 
   /**
    * GstCpuThrottlingClock:cpu-usage:
@@ -190,6 +365,19 @@ gst_cpu_throttling_clock_class_init (GstCpuThrottlingClockClass * klass)
       "pipeline driven by the clock", 0, 100,
       100, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+  /**
+   * GstCpuThrottlingClock:achieved-cpu-usage:
+   *
+   * The smoothed CPU usage measured over the last evaluation periods, as a
+   * percentage of the available CPU capacity.
+   *
+   * Since: 1.20
+   */
+  param_specs[PROP_ACHIEVED_CPU_USAGE] =
+      g_param_spec_double ("achieved-cpu-usage", "Achieved CPU usage",
+      "The percentage of CPU currently used", 0, G_MAXDOUBLE, 0,
+      G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+
   g_object_class_install_properties (oclass, PROP_LAST, param_specs);
 
   clock_klass->wait = GST_DEBUG_FUNCPTR (_wait);
@@ -201,14 +389,18 @@ gst_cpu_throttling_clock_init (GstCpuThrottlingClock * self)
 {
   self->priv = gst_cpu_throttling_clock_get_instance_private (self);
 
-  self->priv->current_wait_time = GST_MSECOND;
+  self->priv->current_wait_time = 0;
   self->priv->wanted_cpu_usage = 100;
   self->priv->timer = gst_poll_new_timer ();
   self->priv->time_between_evals = GST_SECOND / 4;
   self->priv->sclock = GST_CLOCK (gst_system_clock_obtain ());
+  self->priv->cgroup_dir = find_cgroup_dir ();
 
+  GST_INFO_OBJECT (self, "Measuring CPU usage from %s",
+      self->priv->cgroup_dir ? self->priv->cgroup_dir : "getrusage()");
 
-  getrusage (RUSAGE_SELF, &self->priv->last_usage);
+  self->priv->last_eval_time = gst_clock_get_time (self->priv->sclock);
+  self->priv->last_cpu_time = get_cpu_time (self);
 }
 
 GstCpuThrottlingClock *
@@ -54,6 +54,12 @@ typedef struct
 
   GstClock *cpu_clock;
 
+  GstClockTime start_time;
+  GstClockTime stop_time;
+  /* Protected by the object lock */
+  GList *range_probes;
+  gboolean range_seeking;
+  gboolean range_seeked;
 } GstUriTranscodeBin;
 
 typedef struct
@@ -72,6 +78,8 @@ typedef struct
 #define GST_URI_TRANSCODE_BIN_GET_CLASS(obj) (G_TYPE_INSTANCE_GET_CLASS ((obj), GST_URI_TRANSCODE_BIN_TYPE, GstUriTranscodeBinClass))
 
 #define DEFAULT_AVOID_REENCODING   FALSE
+#define DEFAULT_START_TIME         GST_CLOCK_TIME_NONE
+#define DEFAULT_STOP_TIME          GST_CLOCK_TIME_NONE
 
 G_DEFINE_TYPE (GstUriTranscodeBin, gst_uri_transcode_bin, GST_TYPE_PIPELINE)
 enum
@@ -84,8 +92,11 @@ enum
  PROP_SINK,
  PROP_SRC,
  PROP_CPU_USAGE,
+ PROP_ACHIEVED_CPU_USAGE,
  PROP_VIDEO_FILTER,
  PROP_AUDIO_FILTER,
+ PROP_START_TIME,
+ PROP_STOP_TIME,
  LAST_PROP
 };
 
@@ -347,9 +358,124 @@ no_urisourcebin:
 
 }
 
+typedef struct
+{
+  GstPad *pad;
+  gulong probe_id;
+} RangeProbe;
+
+static void
+range_probe_free (RangeProbe * probe)
+{
+  gst_pad_remove_probe (probe->pad, probe->probe_id);
+  gst_object_unref (probe->pad);
+  g_free (probe);
+}
+
+static void
+clear_range_probes (GstUriTranscodeBin * self)
+{
+  GList *probes;
+
+  GST_OBJECT_LOCK (self);
+  probes = self->range_probes;
+  self->range_probes = NULL;
+  GST_OBJECT_UNLOCK (self);
+
+  g_list_free_full (probes, (GDestroyNotify) range_probe_free);
+}
+
+static void
+range_seek (GstElement * element, GstPad * pad)
+{
+  GstUriTranscodeBin *self = GST_URI_TRANSCODE_BIN (element);
+  GstSeekType start_type, stop_type;
+  GstEvent *seek;
+
+  start_type = GST_CLOCK_TIME_IS_VALID (self->start_time) ?
+      GST_SEEK_TYPE_SET : GST_SEEK_TYPE_NONE;
+  stop_type = GST_CLOCK_TIME_IS_VALID (self->stop_time) ?
+      GST_SEEK_TYPE_SET : GST_SEEK_TYPE_NONE;
+
+  GST_DEBUG_OBJECT (self, "Seeking to range %" GST_TIME_FORMAT " - %"
+      GST_TIME_FORMAT, GST_TIME_ARGS (self->start_time),
+      GST_TIME_ARGS (self->stop_time));
+
+  /* Accurate so that consecutive ranges join up exactly whatever the
+   * keyframe distance of the input is */
+  seek = gst_event_new_seek (1.0, GST_FORMAT_TIME,
+      GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE, start_type,
+      self->start_time, stop_type, self->stop_time);
+  if (!gst_pad_send_event (pad, seek))
+    GST_ELEMENT_ERROR (self, CORE, SEEK, (NULL),
+        ("Could not seek to the configured time range"));
+
+  GST_OBJECT_LOCK (self);
+  self->range_seeked = TRUE;
+  GST_OBJECT_UNLOCK (self);
+
+  clear_range_probes (self);
+}
+
+static GstPadProbeReturn
+range_probe_cb (GstPad * pad, G_GNUC_UNUSED GstPadProbeInfo * info,
+    GstUriTranscodeBin * self)
+{
+  gboolean seek = FALSE;
+
+  GST_OBJECT_LOCK (self);
+  if (self->range_seeked) {
+    GST_OBJECT_UNLOCK (self);
+    return GST_PAD_PROBE_PASS;
+  }
+
+  if (!self->range_seeking) {
+    self->range_seeking = TRUE;
+    seek = TRUE;
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  /* Seeking from the streaming thread would deadlock on the demuxer's
+   * stream lock */
+  if (seek)
+    gst_element_call_async (GST_ELEMENT (self),
+        (GstElementCallAsyncFunc) range_seek, gst_object_ref (pad),
+        gst_object_unref);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+decodebin_pad_added_cb (G_GNUC_UNUSED GstElement * decodebin, GstPad * pad,
+    GstUriTranscodeBin * self)
+{
+  RangeProbe *probe;
+
+  if (!GST_PAD_IS_SRC (pad))
+    return;
+
+  GST_OBJECT_LOCK (self);
+  if (self->range_seeked) {
+    GST_OBJECT_UNLOCK (self);
+    return;
+  }
+
+  /* Hold back the data until we seeked to the configured range so none of
+   * it reaches the encoders and muxer */
+  probe = g_new0 (RangeProbe, 1);
+  probe->pad = gst_object_ref (pad);
+  probe->probe_id = gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BLOCK |
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+      (GstPadProbeCallback) range_probe_cb, self, NULL);
+  self->range_probes = g_list_prepend (self->range_probes, probe);
+  GST_OBJECT_UNLOCK (self);
+}
+
 static void
 remove_all_children (GstUriTranscodeBin * self)
 {
+  clear_range_probes (self);
+
   if (self->sink) {
     gst_element_set_state (self->sink, GST_STATE_NULL);
     gst_bin_remove (GST_BIN (self), self->sink);
@@ -411,6 +537,17 @@ deep_element_added (GstBin * bin, GstBin * sub_bin, GstElement * child)
   GstUriTranscodeBin *self = GST_URI_TRANSCODE_BIN (bin);
 
   set_location_on_muxer_if_sink (self, child);
+
+  if ((GST_CLOCK_TIME_IS_VALID (self->start_time)
+          || GST_CLOCK_TIME_IS_VALID (self->stop_time))
+      && self->transcodebin && sub_bin == GST_BIN (self->transcodebin)
+      && gst_element_get_factory (child)
+      && !g_strcmp0 (GST_OBJECT_NAME (gst_element_get_factory (child)),
+          "decodebin3")) {
+    g_signal_connect (child, "pad-added",
+        G_CALLBACK (decodebin_pad_added_cb), self);
+  }
+
   g_signal_emit (bin, signals[SIGNAL_ELEMENT_SETUP], 0, child);
 
   GST_BIN_CLASS (parent_class)->deep_element_added (bin, sub_bin, child);
@@ -425,6 +562,10 @@ gst_uri_transcode_bin_change_state (GstElement * element,
 
   switch (transition) {
     case GST_STATE_CHANGE_READY_TO_PAUSED:
+      GST_OBJECT_LOCK (self);
+      self->range_seeking = FALSE;
+      self->range_seeked = FALSE;
+      GST_OBJECT_UNLOCK (self);
 
       if (!make_transcodebin (self))
         goto setup_failed;
@@ -538,6 +679,14 @@ gst_uri_transcode_bin_get_property (GObject * object,
       g_value_set_uint (value, self->wanted_cpu_usage);
       GST_OBJECT_UNLOCK (self);
       break;
+    case PROP_ACHIEVED_CPU_USAGE:
+#if HAVE_GETRUSAGE
+      g_object_get_property (G_OBJECT (self->cpu_clock), "achieved-cpu-usage",
+          value);
+#else
+      g_value_set_double (value, 0);
+#endif
+      break;
     case PROP_VIDEO_FILTER:
       GST_OBJECT_LOCK (self);
       g_value_set_object (value, self->video_filter);
@@ -548,6 +697,16 @@ gst_uri_transcode_bin_get_property (GObject * object,
       g_value_set_object (value, self->audio_filter);
       GST_OBJECT_UNLOCK (self);
       break;
+    case PROP_START_TIME:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint64 (value, self->start_time);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_STOP_TIME:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint64 (value, self->stop_time);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -603,6 +762,16 @@ gst_uri_transcode_bin_set_property (GObject * object,
       self->video_filter = g_value_dup_object (value);
       GST_OBJECT_UNLOCK (self);
       break;
+    case PROP_START_TIME:
+      GST_OBJECT_LOCK (self);
+      self->start_time = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_STOP_TIME:
+      GST_OBJECT_LOCK (self);
+      self->stop_time = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -681,6 +850,20 @@ gst_uri_transcode_bin_class_init (GstUriTranscodeBinClass * klass)
           "pipeline driven by the clock", 0, 100,
           100, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstUriTranscodeBin:achieved-cpu-usage:
+   *
+   * The CPU usage currently measured by the clock throttling the pipeline
+   * to #GstUriTranscodeBin:cpu-usage, as a percentage of the CPU capacity
+   * available to the process or its cgroup.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (object_class, PROP_ACHIEVED_CPU_USAGE,
+      g_param_spec_double ("achieved-cpu-usage", "Achieved CPU usage",
+          "The percentage of CPU currently used", 0, G_MAXDOUBLE, 0,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   /**
    * GstUriTranscodeBin:video-filter:
    *
@@ -700,6 +883,35 @@ gst_uri_transcode_bin_class_init (GstUriTranscodeBinClass * klass)
           "the audio filter(s) to apply, if possible",
           GST_TYPE_ELEMENT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstUriTranscodeBin:start-time:
+   *
+   * Position in the source stream at which transcoding starts. The output
+   * starts at running time 0 with the frame at that position. This
+   * property must be set before going to %GST_STATE_PAUSED or higher.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (object_class, PROP_START_TIME,
+      g_param_spec_uint64 ("start-time", "Start time",
+          "Position of the source stream to start transcoding from "
+          "(GST_CLOCK_TIME_NONE = beginning)", 0, G_MAXUINT64,
+          DEFAULT_START_TIME, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstUriTranscodeBin:stop-time:
+   *
+   * Position in the source stream at which transcoding stops. This
+   * property must be set before going to %GST_STATE_PAUSED or higher.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (object_class, PROP_STOP_TIME,
+      g_param_spec_uint64 ("stop-time", "Stop time",
+          "Position of the source stream to stop transcoding at "
+          "(GST_CLOCK_TIME_NONE = end)", 0, G_MAXUINT64,
+          DEFAULT_STOP_TIME, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /**
    * GstUriTranscodeBin::source-setup:
    * @uritranscodebin: a #GstUriTranscodeBin
@@ -745,4 +957,6 @@ static void
 gst_uri_transcode_bin_init (GstUriTranscodeBin * self)
 {
   self->wanted_cpu_usage = 100;
+  self->start_time = DEFAULT_START_TIME;
+  self->stop_time = DEFAULT_STOP_TIME;
 }
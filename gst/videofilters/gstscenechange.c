@@ -33,6 +33,15 @@
  *
  * The scenechange element does not work with compressed video.
  *
+ * The pictures can be compared at a reduced resolution with the
+ * #GstSceneChange:analysis-scale property, which is usually just as
+ * accurate and a lot cheaper for high resolution video. When
+ * #GstSceneChange:post-messages is enabled, an element message named
+ * "scenechange" is posted for every picture, containing the "timestamp",
+ * "stream-time", "running-time" and "duration" of the picture along with
+ * its "score" (gdouble) and whether it was detected as a "scene-change"
+ * (gboolean). The "score" is also added to the force key unit events.
+ *
  * ## Example launch line
  * |[
  * gst-launch-1.0 -v filesrc location=some_file.ogv ! decodebin !
@@ -90,6 +99,12 @@ GST_DEBUG_CATEGORY_STATIC (gst_scene_change_debug_category);
 /* prototypes */
 
 
+static void gst_scene_change_set_property (GObject * object,
+    guint property_id, const GValue * value, GParamSpec * pspec);
+static void gst_scene_change_get_property (GObject * object,
+    guint property_id, GValue * value, GParamSpec * pspec);
+static void gst_scene_change_finalize (GObject * object);
+static gboolean gst_scene_change_stop (GstBaseTransform * trans);
 static GstFlowReturn gst_scene_change_transform_frame_ip (GstVideoFilter *
     filter, GstVideoFrame * frame);
 
@@ -100,9 +115,63 @@ static gboolean is_shot_change (int frame_number);
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_ANALYSIS_SCALE,
+  PROP_N_THREADS,
+  PROP_POST_MESSAGES
 };
 
+#define DEFAULT_ANALYSIS_SCALE GST_SCENE_CHANGE_ANALYSIS_SCALE_FULL
+#define DEFAULT_N_THREADS 1
+#define DEFAULT_POST_MESSAGES FALSE
+
+/* don't split the analysis in jobs of less rows than this */
+#define MIN_ROWS_PER_JOB 16
+
+#define GST_TYPE_SCENE_CHANGE_ANALYSIS_SCALE \
+    (gst_scene_change_analysis_scale_get_type ())
+static GType
+gst_scene_change_analysis_scale_get_type (void)
+{
+  static GType scale_type = 0;
+
+  static const GEnumValue scale_types[] = {
+    {GST_SCENE_CHANGE_ANALYSIS_SCALE_FULL, "Full resolution", "full"},
+    {GST_SCENE_CHANGE_ANALYSIS_SCALE_HALF, "Half resolution", "half"},
+    {GST_SCENE_CHANGE_ANALYSIS_SCALE_QUARTER, "Quarter resolution",
+        "quarter"},
+    {GST_SCENE_CHANGE_ANALYSIS_SCALE_EIGHTH, "Eighth resolution", "eighth"},
+    {0, NULL, NULL}
+  };
+
+  if (!scale_type) {
+    scale_type =
+        g_enum_register_static ("GstSceneChangeAnalysisScale", scale_types);
+  }
+  return scale_type;
+}
+
+typedef struct
+{
+  /* luma of the current picture and, at full scale, of the previous one */
+  const guint8 *src;
+  int src_stride;
+  const guint8 *ref;
+  int ref_stride;
+
+  /* downscaled luma of the current and the previous picture */
+  guint8 *cur;
+  const guint8 *prev;
+
+  /* analysis width and rows [y_start, y_end) */
+  int width;
+  int scale;
+  int y_start;
+  int y_end;
+
+  guint32 score;
+} GstSceneChangeJob;
+
 #define VIDEO_CAPS \
     GST_VIDEO_CAPS_MAKE("{ I420, Y42B, Y41B, Y444 }")
 
@@ -116,6 +185,9 @@ G_DEFINE_TYPE_WITH_CODE (GstSceneChange, gst_scene_change,
 static void
 gst_scene_change_class_init (GstSceneChangeClass * klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstBaseTransformClass *base_transform_class =
+      GST_BASE_TRANSFORM_CLASS (klass);
   GstVideoFilterClass *video_filter_class = GST_VIDEO_FILTER_CLASS (klass);
 
   gst_element_class_add_pad_template (GST_ELEMENT_CLASS (klass),
@@ -130,30 +202,402 @@ gst_scene_change_class_init (GstSceneChangeClass * klass)
       "Video/Filter", "Detects scene changes in video",
       "David Schleef <ds@entropywave.com>");
 
+  gobject_class->set_property = gst_scene_change_set_property;
+  gobject_class->get_property = gst_scene_change_get_property;
+  gobject_class->finalize = gst_scene_change_finalize;
+  base_transform_class->stop = GST_DEBUG_FUNCPTR (gst_scene_change_stop);
   video_filter_class->transform_frame_ip =
       GST_DEBUG_FUNCPTR (gst_scene_change_transform_frame_ip);
 
+  /**
+   * GstSceneChange:analysis-scale:
+   *
+   * Resolution at which consecutive pictures are compared. The luma is
+   * downscaled by averaging blocks of pixels before computing the
+   * difference.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_ANALYSIS_SCALE,
+      g_param_spec_enum ("analysis-scale", "Analysis scale",
+          "Resolution at which pictures are compared",
+          GST_TYPE_SCENE_CHANGE_ANALYSIS_SCALE, DEFAULT_ANALYSIS_SCALE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstSceneChange:n-threads:
+   *
+   * Maximum number of threads the analysis rows are split across,
+   * 0 means one thread per CPU.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Threads",
+          "Maximum number of threads to use", 0, G_MAXUINT,
+          DEFAULT_N_THREADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstSceneChange:post-messages:
+   *
+   * Post an element message with the score of every picture.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_POST_MESSAGES,
+      g_param_spec_boolean ("post-messages", "Post messages",
+          "Post an element message with the score of every picture",
+          DEFAULT_POST_MESSAGES, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_type_mark_as_plugin_api (GST_TYPE_SCENE_CHANGE_ANALYSIS_SCALE, 0);
 }
 
 static void
 gst_scene_change_init (GstSceneChange * scenechange)
 {
+  scenechange->analysis_scale = DEFAULT_ANALYSIS_SCALE;
+  scenechange->n_threads = DEFAULT_N_THREADS;
+  scenechange->post_messages = DEFAULT_POST_MESSAGES;
+  g_mutex_init (&scenechange->jobs_lock);
+  g_cond_init (&scenechange->jobs_cond);
+}
+
+static void
+gst_scene_change_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstSceneChange *scenechange = GST_SCENE_CHANGE (object);
+
+  GST_DEBUG_OBJECT (scenechange, "set_property");
+
+  GST_OBJECT_LOCK (scenechange);
+  switch (property_id) {
+    case PROP_ANALYSIS_SCALE:
+      scenechange->analysis_scale = g_value_get_enum (value);
+      break;
+    case PROP_N_THREADS:
+      scenechange->n_threads = g_value_get_uint (value);
+      break;
+    case PROP_POST_MESSAGES:
+      scenechange->post_messages = g_value_get_boolean (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (scenechange);
 }
 
+static void
+gst_scene_change_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstSceneChange *scenechange = GST_SCENE_CHANGE (object);
+
+  GST_DEBUG_OBJECT (scenechange, "get_property");
+
+  GST_OBJECT_LOCK (scenechange);
+  switch (property_id) {
+    case PROP_ANALYSIS_SCALE:
+      g_value_set_enum (value, scenechange->analysis_scale);
+      break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, scenechange->n_threads);
+      break;
+    case PROP_POST_MESSAGES:
+      g_value_set_boolean (value, scenechange->post_messages);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (scenechange);
+}
 
-static double
-get_frame_score (GstVideoFrame * f1, GstVideoFrame * f2)
+static void
+gst_scene_change_reset (GstSceneChange * scenechange)
 {
-  guint32 score = 0;
+  gst_buffer_replace (&scenechange->oldbuf, NULL);
+  g_free (scenechange->planes[0]);
+  g_free (scenechange->planes[1]);
+  scenechange->planes[0] = scenechange->planes[1] = NULL;
+  scenechange->plane_width = scenechange->plane_height = 0;
+  scenechange->ref_scale = 0;
+}
+
+static void
+gst_scene_change_finalize (GObject * object)
+{
+  GstSceneChange *scenechange = GST_SCENE_CHANGE (object);
+
+  gst_scene_change_reset (scenechange);
+
+  if (scenechange->pool)
+    g_thread_pool_free (scenechange->pool, FALSE, TRUE);
+  g_mutex_clear (&scenechange->jobs_lock);
+  g_cond_clear (&scenechange->jobs_cond);
+
+  G_OBJECT_CLASS (gst_scene_change_parent_class)->finalize (object);
+}
+
+static gboolean
+gst_scene_change_stop (GstBaseTransform * trans)
+{
+  GstSceneChange *scenechange = GST_SCENE_CHANGE (trans);
+
+  GST_DEBUG_OBJECT (scenechange, "stop");
+
+  gst_scene_change_reset (scenechange);
+
+  return TRUE;
+}
+
+
+/* Averages scale x scale blocks of src into one row of dest. Called with
+ * a constant scale so that the compiler can unroll the inner loops. */
+static inline void
+decimate_row (const guint8 * src, int stride, guint8 * dest, int width,
+    const int scale, const int shift)
+{
+  int x, i, j;
+
+  for (x = 0; x < width; x++) {
+    const guint8 *s = src + x * scale;
+    guint sum = 0;
+
+    for (j = 0; j < scale; j++) {
+      for (i = 0; i < scale; i++)
+        sum += s[i];
+      s += stride;
+    }
+    dest[x] = (sum + (1 << (shift - 1))) >> shift;
+  }
+}
+
+static void
+decimate_rows (GstSceneChangeJob * job)
+{
+  int y;
+
+  for (y = job->y_start; y < job->y_end; y++) {
+    const guint8 *src = job->src + y * job->scale * job->src_stride;
+    guint8 *dest = job->cur + y * job->width;
+
+    switch (job->scale) {
+      case 2:
+        decimate_row (src, job->src_stride, dest, job->width, 2, 2);
+        break;
+      case 4:
+        decimate_row (src, job->src_stride, dest, job->width, 4, 4);
+        break;
+      case 8:
+        decimate_row (src, job->src_stride, dest, job->width, 8, 6);
+        break;
+      default:
+        g_assert_not_reached ();
+        break;
+    }
+  }
+}
+
+static void
+analyse_rows (GstSceneChangeJob * job)
+{
+  int rows = job->y_end - job->y_start;
+
+  job->score = 0;
+
+  if (job->scale == 1) {
+    if (job->ref) {
+      orc_sad_nxm_u8 (&job->score,
+          job->src + job->y_start * job->src_stride, job->src_stride,
+          job->ref + job->y_start * job->ref_stride, job->ref_stride,
+          job->width, rows);
+    }
+    return;
+  }
+
+  decimate_rows (job);
+
+  if (job->prev) {
+    orc_sad_nxm_u8 (&job->score, job->cur + job->y_start * job->width,
+        job->width, job->prev + job->y_start * job->width, job->width,
+        job->width, rows);
+  }
+}
+
+static void
+analyse_job (gpointer data, gpointer user_data)
+{
+  GstSceneChange *scenechange = user_data;
+
+  analyse_rows (data);
+
+  g_mutex_lock (&scenechange->jobs_lock);
+  if (--scenechange->jobs_pending == 0)
+    g_cond_signal (&scenechange->jobs_cond);
+  g_mutex_unlock (&scenechange->jobs_lock);
+}
+
+/* Splits the analysis rows of the template job across up to n_threads
+ * threads and returns the total SAD */
+static guint32
+get_frame_sad (GstSceneChange * scenechange, const GstSceneChangeJob * tmpl,
+    int height, guint n_threads)
+{
+  GstSceneChangeJob *jobs;
+  guint32 score;
+  guint n_jobs, i;
+  int rows;
+
+  n_jobs = n_threads;
+  if (n_jobs == 0)
+    n_jobs = g_get_num_processors ();
+  n_jobs = CLAMP (height / MIN_ROWS_PER_JOB, 1, n_jobs);
+
+  jobs = g_newa (GstSceneChangeJob, n_jobs);
+  rows = (height + n_jobs - 1) / n_jobs;
+
+  for (i = 0; i < n_jobs; i++) {
+    jobs[i] = *tmpl;
+    jobs[i].y_start = MIN (i * rows, height);
+    jobs[i].y_end = MIN ((i + 1) * rows, height);
+  }
+
+  if (n_jobs > 1) {
+    if (scenechange->pool == NULL) {
+      scenechange->pool = g_thread_pool_new (analyse_job, scenechange, -1,
+          FALSE, NULL);
+    }
+
+    scenechange->jobs_pending = n_jobs - 1;
+    for (i = 1; i < n_jobs; i++)
+      g_thread_pool_push (scenechange->pool, &jobs[i], NULL);
+  }
+
+  analyse_rows (&jobs[0]);
+
+  if (n_jobs > 1) {
+    g_mutex_lock (&scenechange->jobs_lock);
+    while (scenechange->jobs_pending > 0)
+      g_cond_wait (&scenechange->jobs_cond, &scenechange->jobs_lock);
+    g_mutex_unlock (&scenechange->jobs_lock);
+  }
+
+  score = 0;
+  for (i = 0; i < n_jobs; i++)
+    score += jobs[i].score;
+
+  return score;
+}
+
+/* Computes the mean absolute luma difference between frame and the
+ * previous picture, or a negative value if there is no previous picture
+ * to compare with, and makes frame the reference for the next one */
+static gboolean
+get_frame_score (GstSceneChange * scenechange, GstVideoFrame * frame,
+    int scale, guint n_threads, double *frame_score)
+{
+  GstSceneChangeJob job = { NULL, };
+  GstVideoFrame oldframe;
+  gboolean have_ref;
   int width, height;
+  guint32 score = 0;
+
+  width = GST_VIDEO_FRAME_WIDTH (frame);
+  height = GST_VIDEO_FRAME_HEIGHT (frame);
+
+  have_ref = scenechange->ref_scale == scale &&
+      scenechange->oldinfo.width == width &&
+      scenechange->oldinfo.height == height;
 
-  width = f1->info.width;
-  height = f1->info.height;
+  job.src = GST_VIDEO_FRAME_COMP_DATA (frame, 0);
+  job.src_stride = GST_VIDEO_FRAME_COMP_STRIDE (frame, 0);
+  job.scale = scale;
 
-  orc_sad_nxm_u8 (&score, f1->data[0], f1->info.stride[0],
-      f2->data[0], f2->info.stride[0], width, height);
+  if (scale == 1) {
+    if (have_ref) {
+      if (!gst_video_frame_map (&oldframe, &scenechange->oldinfo,
+              scenechange->oldbuf, GST_MAP_READ)) {
+        GST_ERROR_OBJECT (scenechange, "failed to map old video frame");
+        return FALSE;
+      }
+      job.ref = GST_VIDEO_FRAME_COMP_DATA (&oldframe, 0);
+      job.ref_stride = GST_VIDEO_FRAME_COMP_STRIDE (&oldframe, 0);
+      job.width = width;
 
-  return ((double) score) / (width * height);
+      score = get_frame_sad (scenechange, &job, height, n_threads);
+
+      gst_video_frame_unmap (&oldframe);
+    }
+
+    gst_buffer_replace (&scenechange->oldbuf, frame->buffer);
+  } else {
+    int plane_width = width / scale;
+    int plane_height = height / scale;
+    guint8 *tmp;
+
+    if (plane_width != scenechange->plane_width ||
+        plane_height != scenechange->plane_height) {
+      g_free (scenechange->planes[0]);
+      g_free (scenechange->planes[1]);
+      scenechange->planes[0] = g_malloc (plane_width * plane_height);
+      scenechange->planes[1] = g_malloc (plane_width * plane_height);
+      scenechange->plane_width = plane_width;
+      scenechange->plane_height = plane_height;
+    }
+
+    job.cur = scenechange->planes[0];
+    job.prev = have_ref ? scenechange->planes[1] : NULL;
+    job.width = plane_width;
+
+    score = get_frame_sad (scenechange, &job, plane_height, n_threads);
+
+    /* the current picture is the reference for the next one */
+    tmp = scenechange->planes[0];
+    scenechange->planes[0] = scenechange->planes[1];
+    scenechange->planes[1] = tmp;
+    gst_buffer_replace (&scenechange->oldbuf, NULL);
+
+    width = plane_width;
+    height = plane_height;
+  }
+
+  scenechange->oldinfo = frame->info;
+  scenechange->ref_scale = scale;
+
+  if (have_ref)
+    *frame_score = ((double) score) / (width * height);
+  else
+    *frame_score = -1.0;
+
+  return TRUE;
+}
+
+static void
+gst_scene_change_post_message (GstSceneChange * scenechange,
+    GstBuffer * buffer, double score, gboolean change)
+{
+  GstSegment *segment = &GST_BASE_TRANSFORM (scenechange)->segment;
+  GstClockTime timestamp, stream_time, running_time;
+  GstStructure *s;
+
+  timestamp = GST_BUFFER_PTS (buffer);
+  stream_time =
+      gst_segment_to_stream_time (segment, GST_FORMAT_TIME, timestamp);
+  running_time =
+      gst_segment_to_running_time (segment, GST_FORMAT_TIME, timestamp);
+
+  s = gst_structure_new ("scenechange",
+      "timestamp", G_TYPE_UINT64, timestamp,
+      "stream-time", G_TYPE_UINT64, stream_time,
+      "running-time", G_TYPE_UINT64, running_time,
+      "duration", G_TYPE_UINT64, GST_BUFFER_DURATION (buffer),
+      "score", G_TYPE_DOUBLE, score,
+      "scene-change", G_TYPE_BOOLEAN, change, NULL);
+
+  gst_element_post_message (GST_ELEMENT_CAST (scenechange),
+      gst_message_new_element (GST_OBJECT_CAST (scenechange), s));
 }
 
 static GstFlowReturn
@@ -161,41 +605,38 @@ gst_scene_change_transform_frame_ip (GstVideoFilter * filter,
     GstVideoFrame * frame)
 {
   GstSceneChange *scenechange = GST_SCENE_CHANGE (filter);
-  GstVideoFrame oldframe;
   double score_min;
   double score_max;
   double threshold;
   double score;
   gboolean change;
-  gboolean ret;
+  gboolean post_messages;
+  guint n_threads;
+  int scale;
   int i;
 
   GST_DEBUG_OBJECT (scenechange, "transform_frame_ip");
 
-  if (!scenechange->oldbuf) {
+  GST_OBJECT_LOCK (scenechange);
+  scale = scenechange->analysis_scale;
+  n_threads = scenechange->n_threads;
+  post_messages = scenechange->post_messages;
+  GST_OBJECT_UNLOCK (scenechange);
+
+  if (GST_VIDEO_FRAME_WIDTH (frame) < scale ||
+      GST_VIDEO_FRAME_HEIGHT (frame) < scale)
+    scale = 1;
+
+  if (!get_frame_score (scenechange, frame, scale, n_threads, &score))
+    return GST_FLOW_ERROR;
+
+  if (score < 0) {
+    /* nothing to compare with yet */
     scenechange->n_diffs = 0;
     memset (scenechange->diffs, 0, sizeof (double) * SC_N_DIFFS);
-    scenechange->oldbuf = gst_buffer_ref (frame->buffer);
-    memcpy (&scenechange->oldinfo, &frame->info, sizeof (GstVideoInfo));
     return GST_FLOW_OK;
   }
 
-  ret =
-      gst_video_frame_map (&oldframe, &scenechange->oldinfo,
-      scenechange->oldbuf, GST_MAP_READ);
-  if (!ret) {
-    GST_ERROR_OBJECT (scenechange, "failed to map old video frame");
-    return GST_FLOW_ERROR;
-  }
-
-  score = get_frame_score (&oldframe, frame);
-
-  gst_video_frame_unmap (&oldframe);
-
-  gst_buffer_unref (scenechange->oldbuf);
-  scenechange->oldbuf = gst_buffer_ref (frame->buffer);
-  memcpy (&scenechange->oldinfo, &frame->info, sizeof (GstVideoInfo));
-
   memmove (scenechange->diffs, scenechange->diffs + 1,
       sizeof (double) * (SC_N_DIFFS - 1));
   scenechange->diffs[SC_N_DIFFS - 1] = score;
@@ -240,6 +681,9 @@ gst_scene_change_transform_frame_ip (GstVideoFilter * filter,
   }
 #endif
 
+  if (post_messages)
+    gst_scene_change_post_message (scenechange, frame->buffer, score, change);
+
   if (change) {
     GstEvent *event;
 
@@ -250,6 +694,8 @@ gst_scene_change_transform_frame_ip (GstVideoFilter * filter,
         gst_video_event_new_downstream_force_key_unit (GST_BUFFER_PTS
         (frame->buffer), GST_CLOCK_TIME_NONE, GST_CLOCK_TIME_NONE, FALSE,
         scenechange->count++);
+    gst_structure_set (gst_event_writable_structure (event),
+        "score", G_TYPE_DOUBLE, score, NULL);
 
     gst_pad_push_event (GST_BASE_TRANSFORM_SRC_PAD (scenechange), event);
   }
@@ -36,6 +36,14 @@ typedef struct _GstSceneChangeClass GstSceneChangeClass;
 
 #define SC_N_DIFFS 5
 
+typedef enum
+{
+  GST_SCENE_CHANGE_ANALYSIS_SCALE_FULL = 1,
+  GST_SCENE_CHANGE_ANALYSIS_SCALE_HALF = 2,
+  GST_SCENE_CHANGE_ANALYSIS_SCALE_QUARTER = 4,
+  GST_SCENE_CHANGE_ANALYSIS_SCALE_EIGHTH = 8
+} GstSceneChangeAnalysisScale;
+
 struct _GstSceneChange
 {
   GstVideoFilter base_scenechange;
@@ -45,6 +53,24 @@ struct _GstSceneChange
   GstBuffer *oldbuf;
   GstVideoInfo oldinfo;
   int count;
+
+  /* properties */
+  GstSceneChangeAnalysisScale analysis_scale;
+  guint n_threads;
+  gboolean post_messages;
+
+  /* scale the reference picture was analysed at, 0 if there is none */
+  int ref_scale;
+
+  /* downscaled luma of the current and the previous picture */
+  guint8 *planes[2];
+  int plane_width;
+  int plane_height;
+
+  GThreadPool *pool;
+  GMutex jobs_lock;
+  GCond jobs_cond;
+  guint jobs_pending;
 };
 
 struct _GstSceneChangeClass
@@ -199,6 +199,35 @@ gst_zebra_stripe_stop (GstBaseTransform * trans)
   return TRUE;
 }
 
+/* Stripes the samples at or above threshold. Written as a select without
+ * branches so that the compiler can vectorize it, the planar case being
+ * the common one. */
+static void
+zebra_stripe_row_planar (guint8 * data, int width, int threshold, int phase)
+{
+  int i;
+
+  for (i = 0; i < width; i++) {
+    guint8 v = data[i];
+
+    data[i] = (v >= threshold && ((i + phase) & 0x4)) ? 16 : v;
+  }
+}
+
+static void
+zebra_stripe_row_packed (guint8 * data, int width, int pixel_stride,
+    int threshold, int phase)
+{
+  int i;
+
+  for (i = 0; i < width; i++) {
+    guint8 v = data[pixel_stride * i];
+
+    data[pixel_stride * i] =
+        (v >= threshold && ((i + phase) & 0x4)) ? 16 : v;
+  }
+}
+
 static GstFlowReturn
 gst_zebra_stripe_transform_frame_ip (GstVideoFilter * filter,
     GstVideoFrame * frame)
@@ -206,7 +235,7 @@ gst_zebra_stripe_transform_frame_ip (GstVideoFilter * filter,
   GstZebraStripe *zebrastripe = GST_ZEBRA_STRIPE (filter);
   int width = frame->info.width;
   int height = frame->info.height;
-  int i, j;
+  int j;
   int threshold = zebrastripe->y_threshold;
   int t = zebrastripe->t;
   int offset = 0;
@@ -237,14 +266,13 @@ gst_zebra_stripe_transform_frame_ip (GstVideoFilter * filter,
   }
 
   for (j = 0; j < height; j++) {
-    guint8 *data =
-        (guint8 *) frame->data[0] + frame->info.stride[0] * j + offset;
-    for (i = 0; i < width; i++) {
-      if (data[pixel_stride * i + y_position] >= threshold) {
-        if ((i + j + t) & 0x4)
-          data[pixel_stride * i + y_position] = 16;
-      }
-    }
+    guint8 *data = (guint8 *) frame->data[0] + frame->info.stride[0] * j +
+        offset + y_position;
+
+    if (pixel_stride == 1)
+      zebra_stripe_row_planar (data, width, threshold, j + t);
+    else
+      zebra_stripe_row_packed (data, width, pixel_stride, threshold, j + t);
   }
 
   return GST_FLOW_OK;
@@ -121,6 +121,10 @@ struct _GstAV1Parse
   gboolean discont;
   gboolean header;
   gboolean keyframe;
+
+  /* last parsed sequence header OBU payload */
+  guint8 *seq_header_data;
+  guint seq_header_size;
 };
 
 static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
@@ -284,6 +288,8 @@ gst_av1_parse_reset (GstAV1Parse * self)
   self->last_parsed_offset = 0;
   self->highest_spatial_id = 0;
   g_clear_pointer (&self->colorimetry, g_free);
+  g_clear_pointer (&self->seq_header_data, g_free);
+  self->seq_header_size = 0;
   g_clear_pointer (&self->parser, gst_av1_parser_free);
   gst_adapter_clear (self->cache_out);
   gst_adapter_clear (self->frame_cache);
@@ -793,7 +799,7 @@ gst_av1_parse_push_data (GstAV1Parse * self, GstBaseParseFrame * frame,
     /* Still some left in the frame cache */
     len = gst_adapter_available (self->frame_cache);
     if (len) {
-      buf = gst_adapter_take_buffer (self->frame_cache, len);
+      buf = gst_adapter_take_buffer_fast (self->frame_cache, len);
 
       /* frame_unit_size */
       _write_leb128 (size_data, &size_len, len);
@@ -805,7 +811,7 @@ gst_av1_parse_push_data (GstAV1Parse * self, GstBaseParseFrame * frame,
 
     len = gst_adapter_available (self->cache_out);
     if (len) {
-      buf = gst_adapter_take_buffer (self->cache_out, len);
+      buf = gst_adapter_take_buffer_fast (self->cache_out, len);
 
       /* temporal_unit_size */
       _write_leb128 (size_data, &size_len, len);
@@ -818,7 +824,7 @@ gst_av1_parse_push_data (GstAV1Parse * self, GstBaseParseFrame * frame,
 
   sz = gst_adapter_available (self->cache_out);
   if (sz) {
-    buf = gst_adapter_take_buffer (self->cache_out, sz);
+    buf = gst_adapter_take_buffer_fast (self->cache_out, sz);
     gst_buffer_copy_into (buf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
     if (self->discont) {
       GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DISCONT);
@@ -848,16 +854,33 @@ gst_av1_parse_push_data (GstAV1Parse * self, GstBaseParseFrame * frame,
   return ret;
 }
 
+/* Creates a buffer holding @prefix followed by the payload of @obu, which
+ * starts at @offset of @buffer. The payload memory is shared, not copied. */
+static GstBuffer *
+gst_av1_parse_wrap_obu (GstAV1Parse * self, GstAV1OBU * obu,
+    const guint8 * prefix, guint prefix_size, GstBuffer * buffer, gsize offset)
+{
+  GstBuffer *buf;
+
+  buf = gst_buffer_new_allocate (NULL, prefix_size, NULL);
+  gst_buffer_fill (buf, 0, prefix, prefix_size);
+  if (obu->obu_size)
+    gst_buffer_copy_into (buf, buffer, GST_BUFFER_COPY_MEMORY, offset,
+        obu->obu_size);
+
+  return buf;
+}
+
 static void
 gst_av1_parse_convert_to_annexb (GstAV1Parse * self, GstAV1OBU * obu,
-    gboolean frame_complete)
+    GstBuffer * buffer, gsize offset, gboolean frame_complete)
 {
   guint8 size_data[GST_AV1_MAX_LEB_128_SIZE];
+  guint8 prefix[GST_AV1_MAX_LEB_128_SIZE + 2];
   guint size_len = 0;
   GstBitWriter bs;
   GstBuffer *buf, *buf2;
-  guint8 *data;
-  guint len, len2, offset;
+  guint len, len2;
 
   /* obu_length */
   _write_leb128 (size_data, &size_len,
@@ -884,30 +907,20 @@ gst_av1_parse_convert_to_annexb (GstAV1Parse * self, GstAV1OBU * obu,
   }
   g_assert (GST_BIT_WRITER_BIT_SIZE (&bs) % 8 == 0);
 
+  memcpy (prefix, size_data, size_len);
   len = size_len;
-  len += GST_BIT_WRITER_BIT_SIZE (&bs) / 8;
-  len += obu->obu_size;
-
-  data = g_malloc (len);
-  offset = 0;
-
-  memcpy (data + offset, size_data, size_len);
-  offset += size_len;
-
-  memcpy (data + offset, GST_BIT_WRITER_DATA (&bs),
+  memcpy (prefix + len, GST_BIT_WRITER_DATA (&bs),
       GST_BIT_WRITER_BIT_SIZE (&bs) / 8);
-  offset += GST_BIT_WRITER_BIT_SIZE (&bs) / 8;
-
-  memcpy (data + offset, obu->data, obu->obu_size);
+  len += GST_BIT_WRITER_BIT_SIZE (&bs) / 8;
 
   /* The buf of this OBU */
-  buf = gst_buffer_new_wrapped (data, len);
+  buf = gst_av1_parse_wrap_obu (self, obu, prefix, len, buffer, offset);
 
   gst_adapter_push (self->frame_cache, buf);
 
   if (frame_complete) {
     len2 = gst_adapter_available (self->frame_cache);
-    buf2 = gst_adapter_take_buffer (self->frame_cache, len2);
+    buf2 = gst_adapter_take_buffer_fast (self->frame_cache, len2);
 
     /* frame_unit_size */
     _write_leb128 (size_data, &size_len, len2);
@@ -921,24 +934,18 @@ gst_av1_parse_convert_to_annexb (GstAV1Parse * self, GstAV1OBU * obu,
 }
 
 static void
-gst_av1_parse_convert_from_annexb (GstAV1Parse * self, GstAV1OBU * obu)
+gst_av1_parse_convert_from_annexb (GstAV1Parse * self, GstAV1OBU * obu,
+    GstBuffer * buffer, gsize offset)
 {
   guint8 size_data[GST_AV1_MAX_LEB_128_SIZE];
+  guint8 prefix[GST_AV1_MAX_LEB_128_SIZE + 2];
   guint size_len = 0;
   GstBuffer *buf;
-  guint len, offset;
-  guint8 *data;
+  guint len;
   GstBitWriter bs;
 
   _write_leb128 (size_data, &size_len, obu->obu_size);
 
-  /* obu_header */
-  len = 1;
-  if (obu->header.obu_extention_flag)
-    len += 1;
-  len += size_len;
-  len += obu->obu_size;
-
   gst_bit_writer_init_with_size (&bs, 128, FALSE);
   /* obu_forbidden_bit */
   gst_bit_writer_put_bits_uint8 (&bs, 0, 1);
@@ -960,28 +967,26 @@ gst_av1_parse_convert_from_annexb (GstAV1Parse * self, GstAV1OBU * obu)
   }
   g_assert (GST_BIT_WRITER_BIT_SIZE (&bs) % 8 == 0);
 
-  data = g_malloc (len);
-  offset = 0;
-  memcpy (data + offset, GST_BIT_WRITER_DATA (&bs),
-      GST_BIT_WRITER_BIT_SIZE (&bs) / 8);
-  offset += GST_BIT_WRITER_BIT_SIZE (&bs) / 8;
-
-  memcpy (data + offset, size_data, size_len);
-  offset += size_len;
-
-  memcpy (data + offset, obu->data, obu->obu_size);
+  /* obu_header */
+  len = GST_BIT_WRITER_BIT_SIZE (&bs) / 8;
+  memcpy (prefix, GST_BIT_WRITER_DATA (&bs), len);
+  memcpy (prefix + len, size_data, size_len);
+  len += size_len;
 
-  buf = gst_buffer_new_wrapped (data, len);
+  buf = gst_av1_parse_wrap_obu (self, obu, prefix, len, buffer, offset);
   gst_adapter_push (self->cache_out, buf);
 
   gst_bit_writer_reset (&bs);
 }
 
+/* Caches the @size bytes of @obu found at @offset of @buffer for output,
+ * sharing its memory */
 static void
 gst_av1_parse_cache_one_obu (GstAV1Parse * self, GstAV1OBU * obu,
-    guint8 * data, guint32 size, gboolean frame_complete)
+    GstBuffer * buffer, gsize offset, guint32 size, gboolean frame_complete)
 {
   gboolean need_convert = FALSE;
+  gsize payload_offset;
   GstBuffer *buf;
 
   if (self->in_align != self->align
@@ -989,17 +994,23 @@ gst_av1_parse_cache_one_obu (GstAV1Parse * self, GstAV1OBU * obu,
           || self->align == GST_AV1_PARSE_ALIGN_TEMPORAL_UNIT_ANNEX_B))
     need_convert = TRUE;
 
+  /* the OBU payload is at the end of the consumed data */
+  payload_offset = offset + size - obu->obu_size;
+
   if (need_convert) {
     if (self->in_align == GST_AV1_PARSE_ALIGN_TEMPORAL_UNIT_ANNEX_B) {
-      gst_av1_parse_convert_from_annexb (self, obu);
+      gst_av1_parse_convert_from_annexb (self, obu, buffer, payload_offset);
     } else {
-      gst_av1_parse_convert_to_annexb (self, obu, frame_complete);
+      gst_av1_parse_convert_to_annexb (self, obu, buffer, payload_offset,
+          frame_complete);
     }
   } else if (self->align == GST_AV1_PARSE_ALIGN_TEMPORAL_UNIT_ANNEX_B) {
     g_assert (self->in_align == GST_AV1_PARSE_ALIGN_TEMPORAL_UNIT_ANNEX_B);
-    gst_av1_parse_convert_to_annexb (self, obu, frame_complete);
+    gst_av1_parse_convert_to_annexb (self, obu, buffer, payload_offset,
+        frame_complete);
   } else {
-    buf = gst_buffer_new_wrapped (g_memdup (data, size), size);
+    buf = gst_buffer_copy_region (buffer, GST_BUFFER_COPY_MEMORY, offset,
+        size);
     gst_adapter_push (self->cache_out, buf);
   }
 }
@@ -1084,9 +1095,95 @@ gst_av1_parse_handle_sequence_obu (GstAV1Parse * self, GstAV1OBU * obu)
       self->highest_spatial_id = i;
   }
 
+  g_free (self->seq_header_data);
+  self->seq_header_data = g_memdup (obu->data, obu->obu_size);
+  self->seq_header_size = obu->obu_size;
+
   return GST_AV1_PARSER_OK;
 }
 
+/* Whether the output can be produced from the OBU headers and sizes
+ * alone. Frame boundaries are only needed for frame alignment, and for
+ * building the frame units of annex-b output from an obu-stream. */
+static gboolean
+gst_av1_parse_can_skip_frame_parsing (GstAV1Parse * self)
+{
+  if (self->align == GST_AV1_PARSE_ALIGN_TEMPORAL_UNIT)
+    return TRUE;
+
+  return self->align == GST_AV1_PARSE_ALIGN_TEMPORAL_UNIT_ANNEX_B &&
+      self->in_align == GST_AV1_PARSE_ALIGN_TEMPORAL_UNIT_ANNEX_B;
+}
+
+/* Lightweight version of gst_av1_parse_handle_one_obu(): the sequence header
+ * is only parsed again when it changed, and frame headers, tile groups and
+ * metadata are not parsed at all. */
+static GstAV1ParserResult
+gst_av1_parse_handle_one_obu_fast (GstAV1Parse * self, GstAV1OBU * obu,
+    gboolean * frame_complete)
+{
+  GstAV1ParserResult res = GST_AV1_PARSER_OK;
+
+  *frame_complete = FALSE;
+
+  switch (obu->obu_type) {
+    case GST_AV1_OBU_SEQUENCE_HEADER:
+      /* the parser drops its sequence header when reset */
+      if (self->parser->seq_header && self->seq_header_data
+          && self->seq_header_size == obu->obu_size
+          && !memcmp (self->seq_header_data, obu->data, obu->obu_size))
+        break;
+
+      res = gst_av1_parse_handle_sequence_obu (self, obu);
+      break;
+    case GST_AV1_OBU_FRAME_HEADER:
+    case GST_AV1_OBU_FRAME:
+      /* show_existing_frame is absent from reduced still picture headers,
+       * those are always key frames. Otherwise frame_type follows it. */
+      if (self->parser->seq_header &&
+          self->parser->seq_header->reduced_still_picture_header) {
+        self->keyframe = TRUE;
+      } else if (obu->obu_size && (obu->data[0] & 0xe0) == 0) {
+        /* show_existing_frame == 0 && frame_type == GST_AV1_KEY_FRAME */
+        self->keyframe = TRUE;
+      }
+      break;
+    case GST_AV1_OBU_TEMPORAL_DELIMITER:
+    case GST_AV1_OBU_REDUNDANT_FRAME_HEADER:
+    case GST_AV1_OBU_METADATA:
+    case GST_AV1_OBU_TILE_GROUP:
+    case GST_AV1_OBU_TILE_LIST:
+    case GST_AV1_OBU_PADDING:
+      break;
+    default:
+      GST_WARNING_OBJECT (self, "an unrecognized obu type %d", obu->obu_type);
+      res = GST_AV1_PARSER_BITSTREAM_ERROR;
+      break;
+  }
+
+  GST_LOG_OBJECT (self, "handled the obu %s, result is %d",
+      _obu_name (obu->obu_type), res);
+  if (res != GST_AV1_PARSER_OK)
+    return res;
+
+  if (obu->header.obu_spatial_id > self->highest_spatial_id) {
+    GST_WARNING_OBJECT (self,
+        "spatial_id %d is bigger than highest_spatial_id %d",
+        obu->header.obu_spatial_id, self->highest_spatial_id);
+    return GST_AV1_PARSER_BITSTREAM_ERROR;
+  }
+
+  if (obu->obu_type == GST_AV1_OBU_SEQUENCE_HEADER)
+    self->header = TRUE;
+
+  /* annex-b input already tells where each frame unit ends */
+  if (self->in_align == GST_AV1_PARSE_ALIGN_TEMPORAL_UNIT_ANNEX_B &&
+      self->parser->frame_unit_consumed == self->parser->frame_unit_size)
+    *frame_complete = TRUE;
+
+  return res;
+}
+
 static GstAV1ParserResult
 gst_av1_parse_handle_one_obu (GstAV1Parse * self, GstAV1OBU * obu,
     gboolean * frame_complete)
@@ -1098,6 +1195,9 @@ gst_av1_parse_handle_one_obu (GstAV1Parse * self, GstAV1OBU * obu,
   GstAV1TileGroupOBU tile_group;
   GstAV1FrameOBU frame;
 
+  if (gst_av1_parse_can_skip_frame_parsing (self))
+    return gst_av1_parse_handle_one_obu_fast (self, obu, frame_complete);
+
   *frame_complete = FALSE;
 
   switch (obu->obu_type) {
@@ -1337,8 +1437,8 @@ again:
       break;
     }
 
-    gst_av1_parse_cache_one_obu (self, &obu,
-        map_info.data + total_consumed, consumed, frame_complete);
+    gst_av1_parse_cache_one_obu (self, &obu, buffer, total_consumed,
+        consumed, frame_complete);
 
     total_consumed += consumed;
 
@@ -1444,7 +1544,8 @@ again:
           self->last_parsed_offset, consumed);
       gst_adapter_push (self->cache_out, buf);
     } else if (self->align == GST_AV1_PARSE_ALIGN_TEMPORAL_UNIT_ANNEX_B) {
-      gst_av1_parse_convert_to_annexb (self, &obu, frame_complete);
+      gst_av1_parse_convert_to_annexb (self, &obu, buffer,
+          obu.data - map_info.data, frame_complete);
     } else {
       g_assert_not_reached ();
     }
@@ -38,12 +38,14 @@ GST_DEBUG_CATEGORY (h264_parse_debug);
 
 #define DEFAULT_CONFIG_INTERVAL      (0)
 #define DEFAULT_UPDATE_TIMECODE       FALSE
+#define DEFAULT_LIGHTWEIGHT           FALSE
 
 enum
 {
   PROP_0,
   PROP_CONFIG_INTERVAL,
   PROP_UPDATE_TIMECODE,
+  PROP_LIGHTWEIGHT,
 };
 
 enum
@@ -169,6 +171,27 @@ gst_h264_parse_class_init (GstH264ParseClass * klass)
           "VUI and pic_struct_present_flag of VUI must be non-zero",
           DEFAULT_UPDATE_TIMECODE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstH264Parse:lightweight:
+   *
+   * Only parse what is needed to find access unit boundaries and keyframes.
+   * Slice headers are read up to slice_type, SEI messages are skipped
+   * unless #GstH264Parse:update-timecode is enabled, and SPS/PPS are only
+   * parsed again when their content changes.
+   *
+   * As a consequence, closed captions, HDR metadata, frame packing and
+   * picture timing information are not extracted from SEI messages. This
+   * is meant for passthrough and repackaging pipelines that don't need
+   * them.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_LIGHTWEIGHT,
+      g_param_spec_boolean ("lightweight", "Lightweight",
+          "Only parse what is needed for access unit boundaries and keyframe "
+          "flags, skipping SEI and unchanged parameter sets",
+          DEFAULT_LIGHTWEIGHT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /* Override BaseParse vfuncs */
   parse_class->start = GST_DEBUG_FUNCPTR (gst_h264_parse_start);
   parse_class->stop = GST_DEBUG_FUNCPTR (gst_h264_parse_stop);
@@ -201,6 +224,7 @@ gst_h264_parse_init (GstH264Parse * h264parse)
   h264parse->aud_needed = TRUE;
   h264parse->aud_insert = TRUE;
   h264parse->update_timecode = DEFAULT_UPDATE_TIMECODE;
+  h264parse->lightweight = DEFAULT_LIGHTWEIGHT;
 }
 
 static void
@@ -213,6 +237,16 @@ gst_h264_parse_finalize (GObject * object)
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gst_h264_parse_clear_codec_nals (GstH264Parse * h264parse)
+{
+  if (h264parse->codec_nals) {
+    gst_buffer_list_unref (h264parse->codec_nals);
+    h264parse->codec_nals = NULL;
+  }
+  gst_buffer_replace (&h264parse->codec_nals_block, NULL);
+}
+
 static void
 gst_h264_parse_reset_frame (GstH264Parse * h264parse)
 {
@@ -279,6 +313,7 @@ gst_h264_parse_reset_stream_info (GstH264Parse * h264parse)
     gst_buffer_replace (&h264parse->sps_nals[i], NULL);
   for (i = 0; i < GST_H264_MAX_PPS_COUNT; i++)
     gst_buffer_replace (&h264parse->pps_nals[i], NULL);
+  gst_h264_parse_clear_codec_nals (h264parse);
 
   gst_video_mastering_display_info_init (&h264parse->mastering_display_info);
   h264parse->mastering_display_info_state = GST_H264_PARSE_SEI_EXPIRED;
@@ -498,6 +533,33 @@ gst_h264_parse_wrap_nal (GstH264Parse * h264parse, guint format, guint8 * data,
   return buf;
 }
 
+/* Same as gst_h264_parse_wrap_nal(), but only allocates the length prefix
+ * or start code and shares the NAL payload memory of @src */
+static GstBuffer *
+gst_h264_parse_wrap_nal_shared (GstH264Parse * h264parse, guint format,
+    GstBuffer * src, guint offset, guint size)
+{
+  GstBuffer *buf;
+  guint nl = h264parse->nal_length_size;
+  guint32 tmp;
+
+  GST_DEBUG_OBJECT (h264parse, "nal length %d, sharing payload", size);
+
+  if (format == GST_H264_PARSE_FORMAT_AVC
+      || format == GST_H264_PARSE_FORMAT_AVC3) {
+    tmp = GUINT32_TO_BE (size << (32 - 8 * nl));
+  } else {
+    nl = 4;
+    tmp = GUINT32_TO_BE (1);
+  }
+
+  buf = gst_buffer_new_allocate (NULL, nl, NULL);
+  gst_buffer_fill (buf, 0, &tmp, nl);
+  gst_buffer_copy_into (buf, src, GST_BUFFER_COPY_MEMORY, offset, size);
+
+  return buf;
+}
+
 static void
 gst_h264_parser_store_nal (GstH264Parse * h264parse, guint id,
     GstH264NalUnitType naltype, GstH264NalUnit * nalu)
@@ -521,6 +583,15 @@ gst_h264_parser_store_nal (GstH264Parse * h264parse, guint id,
     return;
   }
 
+  /* keep the stored buffer, and the wrapped copies, if nothing changed */
+  if (store[id] && gst_buffer_get_size (store[id]) == size &&
+      GST_BUFFER_FLAG_IS_SET (store[id], GST_BUFFER_FLAG_HEADER) ==
+      (naltype != GST_H264_NAL_SUBSET_SPS) &&
+      gst_buffer_memcmp (store[id], 0, nalu->data + nalu->offset, size) == 0) {
+    GST_LOG_OBJECT (h264parse, "nal %u unchanged", id);
+    return;
+  }
+
   buf = gst_buffer_new_allocate (NULL, size, NULL);
   gst_buffer_fill (buf, 0, nalu->data + nalu->offset, size);
 
@@ -532,6 +603,80 @@ gst_h264_parser_store_nal (GstH264Parse * h264parse, guint id,
     gst_buffer_unref (store[id]);
 
   store[id] = buf;
+  gst_h264_parse_clear_codec_nals (h264parse);
+}
+
+/* Returns the stored SPS and PPS NALs wrapped for the current output
+ * format. They are only wrapped again when a parameter set or the output
+ * format changed. */
+static GstBufferList *
+gst_h264_parse_get_codec_nals (GstH264Parse * h264parse)
+{
+  GstBufferList *nals;
+  guint i;
+
+  if (h264parse->codec_nals &&
+      h264parse->codec_nals_format == h264parse->format &&
+      h264parse->codec_nals_nl == h264parse->nal_length_size)
+    return h264parse->codec_nals;
+
+  gst_h264_parse_clear_codec_nals (h264parse);
+
+  nals = gst_buffer_list_new ();
+  for (i = 0; i < GST_H264_MAX_SPS_COUNT + GST_H264_MAX_PPS_COUNT; i++) {
+    GstBuffer *nal;
+    GstMapInfo map;
+
+    if (i < GST_H264_MAX_SPS_COUNT)
+      nal = h264parse->sps_nals[i];
+    else
+      nal = h264parse->pps_nals[i - GST_H264_MAX_SPS_COUNT];
+    if (!nal)
+      continue;
+
+    gst_buffer_map (nal, &map, GST_MAP_READ);
+    gst_buffer_list_add (nals, gst_h264_parse_wrap_nal (h264parse,
+            h264parse->format, map.data, map.size));
+    gst_buffer_unmap (nal, &map);
+  }
+
+  GST_DEBUG_OBJECT (h264parse, "wrapped %u SPS/PPS nals",
+      gst_buffer_list_length (nals));
+
+  h264parse->codec_nals = nals;
+  h264parse->codec_nals_format = h264parse->format;
+  h264parse->codec_nals_nl = h264parse->nal_length_size;
+
+  return nals;
+}
+
+/* Same as gst_h264_parse_get_codec_nals(), but with all NALs in a single
+ * memory for inserting into an AU */
+static GstBuffer *
+gst_h264_parse_get_codec_nals_block (GstH264Parse * h264parse)
+{
+  GstBufferList *nals = gst_h264_parse_get_codec_nals (h264parse);
+  GstBuffer *block;
+  GstMapInfo map;
+  gsize offset = 0;
+  guint i;
+
+  if (h264parse->codec_nals_block)
+    return h264parse->codec_nals_block;
+
+  block = gst_buffer_new_allocate (NULL,
+      gst_buffer_list_calculate_size (nals), NULL);
+  gst_buffer_map (block, &map, GST_MAP_WRITE);
+  for (i = 0; i < gst_buffer_list_length (nals); i++) {
+    GstBuffer *nal = gst_buffer_list_get (nals, i);
+
+    offset += gst_buffer_extract (nal, 0, map.data + offset, map.size - offset);
+  }
+  gst_buffer_unmap (block, &map);
+
+  h264parse->codec_nals_block = block;
+
+  return block;
 }
 
 #ifndef GST_DISABLE_GST_DEBUG
@@ -921,6 +1066,137 @@ gst_h264_parse_process_sei (GstH264Parse * h264parse, GstH264NalUnit * nalu)
   g_array_free (messages, TRUE);
 }
 
+/* Returns the index of a stored parameter set NAL with the same content as
+ * @nalu, or -1 */
+static gint
+gst_h264_parse_find_stored_nal (GstH264Parse * h264parse,
+    GstH264NalUnit * nalu)
+{
+  GstBuffer **store;
+  guint i, store_size;
+  gboolean header;
+
+  if (nalu->type == GST_H264_NAL_PPS) {
+    store_size = GST_H264_MAX_PPS_COUNT;
+    store = h264parse->pps_nals;
+  } else {
+    store_size = GST_H264_MAX_SPS_COUNT;
+    store = h264parse->sps_nals;
+  }
+
+  /* subset SPS share the SPS store, but are stored without the header flag */
+  header = nalu->type != GST_H264_NAL_SUBSET_SPS;
+
+  for (i = 0; i < store_size; i++) {
+    GstBuffer *buf = store[i];
+
+    if (buf && gst_buffer_get_size (buf) == nalu->size &&
+        !!GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_HEADER) == header &&
+        gst_buffer_memcmp (buf, 0, nalu->data + nalu->offset,
+            nalu->size) == 0)
+      return i;
+  }
+
+  return -1;
+}
+
+/* In lightweight mode, checks whether the SPS in @nalu is identical to one
+ * that was already parsed, and makes it the active one if so */
+static gboolean
+gst_h264_parse_sps_unchanged (GstH264Parse * h264parse, GstH264NalUnit * nalu)
+{
+  GstH264NalParser *nalparser = h264parse->nalparser;
+  gint id;
+
+  if (!h264parse->lightweight)
+    return FALSE;
+
+  id = gst_h264_parse_find_stored_nal (h264parse, nalu);
+  if (id < 0 || !nalparser->sps[id].valid)
+    return FALSE;
+
+  GST_LOG_OBJECT (h264parse, "SPS %d unchanged, not parsing", id);
+  nalparser->last_sps = &nalparser->sps[id];
+
+  return TRUE;
+}
+
+/* In lightweight mode, checks whether the PPS in @nalu is identical to one
+ * that was already parsed. A PPS depends on its SPS, so it is parsed again
+ * whenever an SPS changed since the last caps update. */
+static gboolean
+gst_h264_parse_pps_unchanged (GstH264Parse * h264parse, GstH264NalUnit * nalu)
+{
+  gint id;
+
+  if (!h264parse->lightweight || h264parse->update_caps)
+    return FALSE;
+
+  id = gst_h264_parse_find_stored_nal (h264parse, nalu);
+  if (id < 0 || !h264parse->nalparser->pps[id].valid)
+    return FALSE;
+
+  GST_LOG_OBJECT (h264parse, "PPS %d unchanged, not parsing", id);
+
+  return TRUE;
+}
+
+static gboolean
+gst_h264_parse_read_ue (GstBitReader * br, guint32 * val)
+{
+  guint zeros = 0;
+  guint32 value = 0;
+  guint8 bit;
+
+  for (;;) {
+    if (!gst_bit_reader_get_bits_uint8 (br, &bit, 1))
+      return FALSE;
+    if (bit)
+      break;
+    if (++zeros > 31)
+      return FALSE;
+  }
+
+  if (zeros > 0 && !gst_bit_reader_get_bits_uint32 (br, &value, zeros))
+    return FALSE;
+
+  *val = (1U << zeros) - 1 + value;
+
+  return TRUE;
+}
+
+/* Reads first_mb_in_slice and slice_type, the two leading fields of a slice
+ * header, without resolving the referenced PPS and SPS */
+static gboolean
+gst_h264_parse_peek_slice_type (GstH264NalUnit * nalu, GstH264SliceHdr * slice)
+{
+  const guint8 *src = nalu->data + nalu->offset + nalu->header_bytes;
+  guint avail = nalu->size - nalu->header_bytes;
+  guint8 data[16];
+  guint i, n = 0, zeros = 0;
+  guint32 slice_type;
+  GstBitReader br;
+
+  /* strip emulation prevention bytes from the few bytes needed */
+  for (i = 0; i < avail && n < sizeof (data); i++) {
+    if (zeros >= 2 && src[i] == 0x03) {
+      zeros = 0;
+      continue;
+    }
+    zeros = src[i] == 0x00 ? zeros + 1 : 0;
+    data[n++] = src[i];
+  }
+
+  gst_bit_reader_init (&br, data, n);
+  if (!gst_h264_parse_read_ue (&br, &slice->first_mb_in_slice) ||
+      !gst_h264_parse_read_ue (&br, &slice_type) || slice_type > 9)
+    return FALSE;
+
+  slice->type = slice_type;
+
+  return TRUE;
+}
+
 /* caller guarantees 2 bytes of nal payload */
 static gboolean
 gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
@@ -931,6 +1207,7 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
   GstH264NalParser *nalparser = h264parse->nalparser;
   GstH264ParserResult pres;
   GstH264SliceHdr slice;
+  gboolean unchanged;
 
   /* nothing to do for broken input */
   if (G_UNLIKELY (nalu->size < 2)) {
@@ -948,12 +1225,16 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
     case GST_H264_NAL_SUBSET_SPS:
       if (!GST_H264_PARSE_STATE_VALID (h264parse, GST_H264_PARSE_STATE_GOT_SPS))
         return FALSE;
+      if (gst_h264_parse_sps_unchanged (h264parse, nalu))
+        goto sps_unchanged;
       pres = gst_h264_parser_parse_subset_sps (nalparser, nalu, &sps);
       goto process_sps;
 
     case GST_H264_NAL_SPS:
       /* reset state, everything else is obsolete */
       h264parse->state &= GST_H264_PARSE_STATE_GOT_PPS;
+      if (gst_h264_parse_sps_unchanged (h264parse, nalu))
+        goto sps_unchanged;
       pres = gst_h264_parser_parse_sps (nalparser, nalu, &sps);
 
     process_sps:
@@ -967,6 +1248,11 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
 
       GST_DEBUG_OBJECT (h264parse, "triggering src caps check");
       h264parse->update_caps = TRUE;
+
+      gst_h264_parser_store_nal (h264parse, sps.id, nal_type, nalu);
+      gst_h264_sps_clear (&sps);
+
+    sps_unchanged:
       h264parse->have_sps = TRUE;
       h264parse->have_sps_in_frame = TRUE;
       if (h264parse->push_codec && h264parse->have_pps) {
@@ -978,8 +1264,6 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
         h264parse->have_pps = FALSE;
       }
 
-      gst_h264_parser_store_nal (h264parse, sps.id, nal_type, nalu);
-      gst_h264_sps_clear (&sps);
       h264parse->state |= GST_H264_PARSE_STATE_GOT_SPS;
       h264parse->header = TRUE;
       break;
@@ -989,12 +1273,15 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
       if (!GST_H264_PARSE_STATE_VALID (h264parse, GST_H264_PARSE_STATE_GOT_SPS))
         return FALSE;
 
-      pres = gst_h264_parser_parse_pps (nalparser, nalu, &pps);
-      /* arranged for a fallback pps.id, so use that one and only warn */
-      if (pres != GST_H264_PARSER_OK) {
-        GST_WARNING_OBJECT (h264parse, "failed to parse PPS:");
-        if (pres != GST_H264_PARSER_BROKEN_LINK)
-          return FALSE;
+      unchanged = gst_h264_parse_pps_unchanged (h264parse, nalu);
+      if (!unchanged) {
+        pres = gst_h264_parser_parse_pps (nalparser, nalu, &pps);
+        /* arranged for a fallback pps.id, so use that one and only warn */
+        if (pres != GST_H264_PARSER_OK) {
+          GST_WARNING_OBJECT (h264parse, "failed to parse PPS:");
+          if (pres != GST_H264_PARSER_BROKEN_LINK)
+            return FALSE;
+        }
       }
 
       /* parameters might have changed, force caps check */
@@ -1013,7 +1300,8 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
         h264parse->have_pps = FALSE;
       }
 
-      gst_h264_parser_store_nal (h264parse, pps.id, nal_type, nalu);
+      if (!unchanged)
+        gst_h264_parser_store_nal (h264parse, pps.id, nal_type, nalu);
       gst_h264_pps_clear (&pps);
       h264parse->state |= GST_H264_PARSE_STATE_GOT_PPS;
       h264parse->header = TRUE;
@@ -1024,7 +1312,9 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
         return FALSE;
 
       h264parse->header = TRUE;
-      gst_h264_parse_process_sei (h264parse, nalu);
+      /* picture timing SEI is still needed to update timecodes */
+      if (!h264parse->lightweight || h264parse->update_timecode)
+        gst_h264_parse_process_sei (h264parse, nalu);
       /* mark SEI pos */
       if (h264parse->sei_pos == -1) {
         if (h264parse->transform)
@@ -1063,8 +1353,17 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
       if (nal_type == GST_H264_NAL_SLICE_EXT && !GST_H264_IS_MVC_NALU (nalu))
         break;
 
-      pres = gst_h264_parser_parse_slice_hdr (nalparser, nalu, &slice,
-          FALSE, FALSE);
+      if (h264parse->lightweight) {
+        memset (&slice, 0, sizeof (slice));
+        slice.field_pic_flag = h264parse->field_pic_flag;
+        if (gst_h264_parse_peek_slice_type (nalu, &slice))
+          pres = GST_H264_PARSER_OK;
+        else
+          pres = GST_H264_PARSER_BROKEN_DATA;
+      } else {
+        pres = gst_h264_parser_parse_slice_hdr (nalparser, nalu, &slice,
+            FALSE, FALSE);
+      }
       GST_DEBUG_OBJECT (h264parse,
           "parse result %d, first MB: %u, slice type: %u",
           pres, slice.first_mb_in_slice, slice.type);
@@ -1144,8 +1443,12 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
     GstBuffer *buf;
 
     GST_LOG_OBJECT (h264parse, "collecting NAL in AVC frame");
-    buf = gst_h264_parse_wrap_nal (h264parse, h264parse->format,
-        nalu->data + nalu->offset, nalu->size);
+    if (h264parse->nal_buffer)
+      buf = gst_h264_parse_wrap_nal_shared (h264parse, h264parse->format,
+          h264parse->nal_buffer, nalu->offset, nalu->size);
+    else
+      buf = gst_h264_parse_wrap_nal (h264parse, h264parse->format,
+          nalu->data + nalu->offset, nalu->size);
     gst_adapter_push (h264parse->frame_out, buf);
   }
   return TRUE;
@@ -1235,7 +1538,9 @@ gst_h264_parse_handle_frame_packetized (GstBaseParse * parse,
     GST_DEBUG_OBJECT (h264parse, "AVC nal offset %d", nalu.offset + nalu.size);
 
     /* either way, have a look at it */
+    h264parse->nal_buffer = buffer;
     gst_h264_parse_process_nal (h264parse, &nalu);
+    h264parse->nal_buffer = NULL;
 
     /* dispatch per NALU if needed */
     if (h264parse->split_packetized) {
@@ -1310,7 +1615,7 @@ gst_h264_parse_handle_frame (GstBaseParse * parse,
   guint8 *data;
   gsize size;
   gint current_off = 0;
-  gboolean drain, nonext;
+  gboolean drain, nonext, processed;
   GstH264NalParser *nalparser = h264parse->nalparser;
   GstH264NalUnit nalu;
   GstH264ParserResult pres;
@@ -1486,7 +1791,11 @@ gst_h264_parse_handle_frame (GstBaseParse * parse,
       }
     }
 
-    if (!gst_h264_parse_process_nal (h264parse, &nalu)) {
+    h264parse->nal_buffer = buffer;
+    processed = gst_h264_parse_process_nal (h264parse, &nalu);
+    h264parse->nal_buffer = NULL;
+
+    if (!processed) {
       GST_WARNING_OBJECT (h264parse,
           "broken/invalid nal Type: %d %s, Size: %u will be dropped",
           nalu.type, _nal_name (nalu.type), nalu.size);
@@ -2679,7 +2988,8 @@ gst_h264_parse_parse_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
   if (av) {
     GstBuffer *buf;
 
-    buf = gst_adapter_take_buffer (h264parse->frame_out, av);
+    /* keeps the shared NAL memories instead of merging them */
+    buf = gst_adapter_take_buffer_fast (h264parse->frame_out, av);
     gst_buffer_copy_into (buf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
     gst_buffer_replace (&frame->out_buffer, buf);
     gst_buffer_unref (buf);
@@ -2815,8 +3125,8 @@ static gboolean
 gst_h264_parse_handle_sps_pps_nals (GstH264Parse * h264parse,
     GstBuffer * buffer, GstBaseParseFrame * frame)
 {
-  GstBuffer *codec_nal;
-  gint i;
+  GstBufferList *codec_nals;
+  guint i, n_nals;
   gboolean send_done = FALSE;
 
   if (h264parse->have_sps_in_frame && h264parse->have_pps_in_frame) {
@@ -2824,68 +3134,38 @@ gst_h264_parse_handle_sps_pps_nals (GstH264Parse * h264parse,
     return TRUE;
   }
 
+  codec_nals = gst_h264_parse_get_codec_nals (h264parse);
+  n_nals = gst_buffer_list_length (codec_nals);
+
   if (h264parse->align == GST_H264_PARSE_ALIGN_NAL) {
     /* send separate config NAL buffers */
-    GST_DEBUG_OBJECT (h264parse, "- sending SPS/PPS");
-    for (i = 0; i < GST_H264_MAX_SPS_COUNT; i++) {
-      if ((codec_nal = h264parse->sps_nals[i])) {
-        GST_DEBUG_OBJECT (h264parse, "sending SPS nal");
-        gst_h264_parse_push_codec_buffer (h264parse, codec_nal, buffer);
-        send_done = TRUE;
-      }
-    }
-    for (i = 0; i < GST_H264_MAX_PPS_COUNT; i++) {
-      if ((codec_nal = h264parse->pps_nals[i])) {
-        GST_DEBUG_OBJECT (h264parse, "sending PPS nal");
-        gst_h264_parse_push_codec_buffer (h264parse, codec_nal, buffer);
-        send_done = TRUE;
-      }
+    GST_DEBUG_OBJECT (h264parse, "- sending %u SPS/PPS", n_nals);
+    for (i = 0; i < n_nals; i++) {
+      GstBuffer *nal = gst_buffer_copy (gst_buffer_list_get (codec_nals, i));
+
+      GST_BUFFER_PTS (nal) = GST_BUFFER_PTS (buffer);
+      GST_BUFFER_DTS (nal) = GST_BUFFER_DTS (buffer);
+      GST_BUFFER_DURATION (nal) = 0;
+
+      gst_pad_push (GST_BASE_PARSE_SRC_PAD (h264parse), nal);
+      send_done = TRUE;
     }
-  } else {
-    /* insert config NALs into AU */
-    GstByteWriter bw;
-    GstBuffer *new_buf;
-    const gboolean bs = h264parse->format == GST_H264_PARSE_FORMAT_BYTE;
-    const gint nls = 4 - h264parse->nal_length_size;
+  } else if (n_nals > 0) {
+    /* insert config NALs into AU, sharing the frame and SPS/PPS memory */
+    GstBuffer *new_buf = gst_buffer_new ();
     gboolean ok;
 
-    gst_byte_writer_init_with_size (&bw, gst_buffer_get_size (buffer), FALSE);
-    ok = gst_byte_writer_put_buffer (&bw, buffer, 0, h264parse->idr_pos);
-    GST_DEBUG_OBJECT (h264parse, "- inserting SPS/PPS");
-    for (i = 0; i < GST_H264_MAX_SPS_COUNT; i++) {
-      if ((codec_nal = h264parse->sps_nals[i])) {
-        gsize nal_size = gst_buffer_get_size (codec_nal);
-        GST_DEBUG_OBJECT (h264parse, "inserting SPS nal");
-        if (bs) {
-          ok &= gst_byte_writer_put_uint32_be (&bw, 1);
-        } else {
-          ok &= gst_byte_writer_put_uint32_be (&bw, (nal_size << (nls * 8)));
-          ok &= gst_byte_writer_set_pos (&bw,
-              gst_byte_writer_get_pos (&bw) - nls);
-        }
+    GST_DEBUG_OBJECT (h264parse, "- inserting %u SPS/PPS", n_nals);
+    ok = gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_MEMORY, 0,
+        h264parse->idr_pos);
+    ok &= gst_buffer_copy_into (new_buf,
+        gst_h264_parse_get_codec_nals_block (h264parse),
+        GST_BUFFER_COPY_MEMORY, 0, -1);
+    ok &= gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_MEMORY,
+        h264parse->idr_pos, -1);
+    send_done = TRUE;
 
-        ok &= gst_byte_writer_put_buffer (&bw, codec_nal, 0, nal_size);
-        send_done = TRUE;
-      }
-    }
-    for (i = 0; i < GST_H264_MAX_PPS_COUNT; i++) {
-      if ((codec_nal = h264parse->pps_nals[i])) {
-        gsize nal_size = gst_buffer_get_size (codec_nal);
-        GST_DEBUG_OBJECT (h264parse, "inserting PPS nal");
-        if (bs) {
-          ok &= gst_byte_writer_put_uint32_be (&bw, 1);
-        } else {
-          ok &= gst_byte_writer_put_uint32_be (&bw, (nal_size << (nls * 8)));
-          ok &= gst_byte_writer_set_pos (&bw,
-              gst_byte_writer_get_pos (&bw) - nls);
-        }
-        ok &= gst_byte_writer_put_buffer (&bw, codec_nal, 0, nal_size);
-        send_done = TRUE;
-      }
-    }
-    ok &= gst_byte_writer_put_buffer (&bw, buffer, h264parse->idr_pos, -1);
     /* collect result and push */
-    new_buf = gst_byte_writer_reset_and_get_buffer (&bw);
     gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
     /* should already be keyframe/IDR, but it may not have been,
      * so mark it as such to avoid being discarded by picky decoder */
@@ -3762,6 +4042,9 @@ gst_h264_parse_set_property (GObject * object, guint prop_id,
     case PROP_UPDATE_TIMECODE:
       parse->update_timecode = g_value_get_boolean (value);
       break;
+    case PROP_LIGHTWEIGHT:
+      parse->lightweight = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -3783,6 +4066,9 @@ gst_h264_parse_get_property (GObject * object, guint prop_id,
     case PROP_UPDATE_TIMECODE:
       g_value_set_boolean (value, parse->update_timecode);
       break;
+    case PROP_LIGHTWEIGHT:
+      g_value_set_boolean (value, parse->lightweight);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -98,6 +98,12 @@ struct _GstH264Parse
   GstBuffer *sps_nals[GST_H264_MAX_SPS_COUNT];
   GstBuffer *pps_nals[GST_H264_MAX_PPS_COUNT];
 
+  /* the NALUs above wrapped for the output format, for insertion */
+  GstBufferList *codec_nals;
+  GstBuffer *codec_nals_block;
+  guint codec_nals_format;
+  guint codec_nals_nl;
+
   /* collected SEI timestamps */
   guint num_clock_timestamp;
   GstH264PicTiming pic_timing_sei;
@@ -126,6 +132,9 @@ struct _GstH264Parse
   gint pic_timing_sei_size;
   gboolean update_caps;
   GstAdapter *frame_out;
+  /* input buffer the NAL being processed was mapped from, if its payload
+   * can be shared into frame_out */
+  GstBuffer *nal_buffer;
   gboolean keyframe;
   gboolean predicted;
   gboolean bidirectional;
@@ -137,6 +146,7 @@ struct _GstH264Parse
   /* props */
   gint interval;
   gboolean update_timecode;
+  gboolean lightweight;
 
   GstClockTime pending_key_unit_ts;
   GstEvent *force_key_unit_event;
@@ -32,11 +32,13 @@ GST_DEBUG_CATEGORY (h265_parse_debug);
 #define GST_CAT_DEFAULT h265_parse_debug
 
 #define DEFAULT_CONFIG_INTERVAL      (0)
+#define DEFAULT_LIGHTWEIGHT          FALSE
 
 enum
 {
   PROP_0,
-  PROP_CONFIG_INTERVAL
+  PROP_CONFIG_INTERVAL,
+  PROP_LIGHTWEIGHT
 };
 
 enum
@@ -139,6 +141,28 @@ gst_h265_parse_class_init (GstH265ParseClass * klass)
           "(0 = disabled, -1 = send with every IDR frame)",
           -1, 3600, DEFAULT_CONFIG_INTERVAL,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstH265Parse:lightweight:
+   *
+   * Only parse what is needed to find access unit boundaries and keyframes.
+   * Slice headers are not parsed, keyframes are taken from IRAP NAL unit
+   * types, SEI messages are skipped, and VPS/SPS/PPS are only parsed again
+   * when their content changes. Full slice headers are still parsed while
+   * bidirectional frames are being discarded for trick modes.
+   *
+   * As a consequence, closed captions, HDR metadata and picture timing
+   * information are not extracted from SEI messages. This is meant for
+   * passthrough and repackaging pipelines that don't need them.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_LIGHTWEIGHT,
+      g_param_spec_boolean ("lightweight", "Lightweight",
+          "Only parse what is needed for access unit boundaries and keyframe "
+          "flags, skipping SEI and unchanged parameter sets",
+          DEFAULT_LIGHTWEIGHT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /* Override BaseParse vfuncs */
   parse_class->start = GST_DEBUG_FUNCPTR (gst_h265_parse_start);
   parse_class->stop = GST_DEBUG_FUNCPTR (gst_h265_parse_stop);
@@ -167,6 +191,7 @@ gst_h265_parse_init (GstH265Parse * h265parse)
   gst_base_parse_set_infer_ts (GST_BASE_PARSE (h265parse), FALSE);
   GST_PAD_SET_ACCEPT_INTERSECT (GST_BASE_PARSE_SINK_PAD (h265parse));
   GST_PAD_SET_ACCEPT_TEMPLATE (GST_BASE_PARSE_SINK_PAD (h265parse));
+  h265parse->lightweight = DEFAULT_LIGHTWEIGHT;
 }
 
 
@@ -180,6 +205,16 @@ gst_h265_parse_finalize (GObject * object)
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gst_h265_parse_clear_codec_nals (GstH265Parse * h265parse)
+{
+  if (h265parse->codec_nals) {
+    gst_buffer_list_unref (h265parse->codec_nals);
+    h265parse->codec_nals = NULL;
+  }
+  gst_buffer_replace (&h265parse->codec_nals_block, NULL);
+}
+
 static void
 gst_h265_parse_reset_frame (GstH265Parse * h265parse)
 {
@@ -242,6 +277,7 @@ gst_h265_parse_reset_stream_info (GstH265Parse * h265parse)
     gst_buffer_replace (&h265parse->sps_nals[i], NULL);
   for (i = 0; i < GST_H265_MAX_PPS_COUNT; i++)
     gst_buffer_replace (&h265parse->pps_nals[i], NULL);
+  gst_h265_parse_clear_codec_nals (h265parse);
 
   gst_video_mastering_display_info_init (&h265parse->mastering_display_info);
   h265parse->mastering_display_info_state = GST_H265_PARSE_SEI_EXPIRED;
@@ -446,6 +482,33 @@ gst_h265_parse_wrap_nal (GstH265Parse * h265parse, guint format, guint8 * data,
   return buf;
 }
 
+/* Same as gst_h265_parse_wrap_nal(), but only allocates the length prefix
+ * or start code and shares the NAL payload memory of @src */
+static GstBuffer *
+gst_h265_parse_wrap_nal_shared (GstH265Parse * h265parse, guint format,
+    GstBuffer * src, guint offset, guint size)
+{
+  GstBuffer *buf;
+  guint nl = h265parse->nal_length_size;
+  guint32 tmp;
+
+  GST_DEBUG_OBJECT (h265parse, "nal length %d, sharing payload", size);
+
+  if (format == GST_H265_PARSE_FORMAT_HVC1
+      || format == GST_H265_PARSE_FORMAT_HEV1) {
+    tmp = GUINT32_TO_BE (size << (32 - 8 * nl));
+  } else {
+    nl = 4;
+    tmp = GUINT32_TO_BE (1);
+  }
+
+  buf = gst_buffer_new_allocate (NULL, nl, NULL);
+  gst_buffer_fill (buf, 0, &tmp, nl);
+  gst_buffer_copy_into (buf, src, GST_BUFFER_COPY_MEMORY, offset, size);
+
+  return buf;
+}
+
 static void
 gst_h265_parser_store_nal (GstH265Parse * h265parse, guint id,
     GstH265NalUnitType naltype, GstH265NalUnit * nalu)
@@ -473,6 +536,13 @@ gst_h265_parser_store_nal (GstH265Parse * h265parse, guint id,
     return;
   }
 
+  /* keep the stored buffer, and the wrapped copies, if nothing changed */
+  if (store[id] && gst_buffer_get_size (store[id]) == size &&
+      gst_buffer_memcmp (store[id], 0, nalu->data + nalu->offset, size) == 0) {
+    GST_LOG_OBJECT (h265parse, "nal %u unchanged", id);
+    return;
+  }
+
   buf = gst_buffer_new_allocate (NULL, size, NULL);
   gst_buffer_fill (buf, 0, nalu->data + nalu->offset, size);
 
@@ -484,6 +554,84 @@ gst_h265_parser_store_nal (GstH265Parse * h265parse, guint id,
     gst_buffer_unref (store[id]);
 
   store[id] = buf;
+  gst_h265_parse_clear_codec_nals (h265parse);
+}
+
+/* Returns the stored VPS, SPS and PPS NALs wrapped for the current output
+ * format. They are only wrapped again when a parameter set or the output
+ * format changed. */
+static GstBufferList *
+gst_h265_parse_get_codec_nals (GstH265Parse * h265parse)
+{
+  GstBuffer **stores[] = { h265parse->vps_nals, h265parse->sps_nals,
+    h265parse->pps_nals
+  };
+  const guint store_sizes[] = { GST_H265_MAX_VPS_COUNT,
+    GST_H265_MAX_SPS_COUNT, GST_H265_MAX_PPS_COUNT
+  };
+  GstBufferList *nals;
+  guint i, j;
+
+  if (h265parse->codec_nals &&
+      h265parse->codec_nals_format == h265parse->format &&
+      h265parse->codec_nals_nl == h265parse->nal_length_size)
+    return h265parse->codec_nals;
+
+  gst_h265_parse_clear_codec_nals (h265parse);
+
+  nals = gst_buffer_list_new ();
+  for (i = 0; i < G_N_ELEMENTS (stores); i++) {
+    for (j = 0; j < store_sizes[i]; j++) {
+      GstBuffer *nal = stores[i][j];
+      GstMapInfo map;
+
+      if (!nal)
+        continue;
+
+      gst_buffer_map (nal, &map, GST_MAP_READ);
+      gst_buffer_list_add (nals, gst_h265_parse_wrap_nal (h265parse,
+              h265parse->format, map.data, map.size));
+      gst_buffer_unmap (nal, &map);
+    }
+  }
+
+  GST_DEBUG_OBJECT (h265parse, "wrapped %u VPS/SPS/PPS nals",
+      gst_buffer_list_length (nals));
+
+  h265parse->codec_nals = nals;
+  h265parse->codec_nals_format = h265parse->format;
+  h265parse->codec_nals_nl = h265parse->nal_length_size;
+
+  return nals;
+}
+
+/* Same as gst_h265_parse_get_codec_nals(), but with all NALs in a single
+ * memory for inserting into an AU */
+static GstBuffer *
+gst_h265_parse_get_codec_nals_block (GstH265Parse * h265parse)
+{
+  GstBufferList *nals = gst_h265_parse_get_codec_nals (h265parse);
+  GstBuffer *block;
+  GstMapInfo map;
+  gsize offset = 0;
+  guint i;
+
+  if (h265parse->codec_nals_block)
+    return h265parse->codec_nals_block;
+
+  block = gst_buffer_new_allocate (NULL,
+      gst_buffer_list_calculate_size (nals), NULL);
+  gst_buffer_map (block, &map, GST_MAP_WRITE);
+  for (i = 0; i < gst_buffer_list_length (nals); i++) {
+    GstBuffer *nal = gst_buffer_list_get (nals, i);
+
+    offset += gst_buffer_extract (nal, 0, map.data + offset, map.size - offset);
+  }
+  gst_buffer_unmap (block, &map);
+
+  h265parse->codec_nals_block = block;
+
+  return block;
 }
 
 #ifndef GST_DISABLE_GST_DEBUG
@@ -540,6 +688,67 @@ _nal_name (GstH265NalUnitType nal_type)
 }
 #endif
 
+/* In lightweight mode, checks whether the parameter set in @nalu is
+ * identical to one that was already parsed, and makes an identical SPS the
+ * active one. A PPS depends on its SPS, so it is parsed again whenever an
+ * SPS changed since the last caps update. */
+static gboolean
+gst_h265_parse_param_set_unchanged (GstH265Parse * h265parse,
+    GstH265NalUnit * nalu)
+{
+  GstH265Parser *nalparser = h265parse->nalparser;
+  GstBuffer **store;
+  guint i, store_size;
+
+  if (!h265parse->lightweight)
+    return FALSE;
+
+  if (nalu->type == GST_H265_NAL_VPS) {
+    store_size = GST_H265_MAX_VPS_COUNT;
+    store = h265parse->vps_nals;
+  } else if (nalu->type == GST_H265_NAL_SPS) {
+    store_size = GST_H265_MAX_SPS_COUNT;
+    store = h265parse->sps_nals;
+  } else {
+    if (h265parse->update_caps)
+      return FALSE;
+    store_size = GST_H265_MAX_PPS_COUNT;
+    store = h265parse->pps_nals;
+  }
+
+  for (i = 0; i < store_size; i++) {
+    GstBuffer *buf = store[i];
+
+    if (buf && gst_buffer_get_size (buf) == nalu->size &&
+        gst_buffer_memcmp (buf, 0, nalu->data + nalu->offset,
+            nalu->size) == 0)
+      break;
+  }
+  if (i == store_size)
+    return FALSE;
+
+  switch (nalu->type) {
+    case GST_H265_NAL_VPS:
+      if (!nalparser->vps[i].valid)
+        return FALSE;
+      break;
+    case GST_H265_NAL_SPS:
+      if (!nalparser->sps[i].valid)
+        return FALSE;
+      nalparser->last_sps = &nalparser->sps[i];
+      break;
+    default:
+      if (!nalparser->pps[i].valid)
+        return FALSE;
+      break;
+  }
+
+  GST_LOG_OBJECT (h265parse, "%s %u unchanged, not parsing",
+      _nal_name (nalu->type), i);
+
+  return TRUE;
+}
+
 static void
 gst_h265_parse_process_sei (GstH265Parse * h265parse, GstH265NalUnit * nalu)
 {
@@ -715,6 +924,7 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
   guint nal_type;
   GstH265Parser *nalparser = h265parse->nalparser;
   GstH265ParserResult pres = GST_H265_PARSER_ERROR;
+  gboolean unchanged;
 
   /* nothing to do for broken input */
   if (G_UNLIKELY (nalu->size < 2)) {
@@ -731,14 +941,17 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
     case GST_H265_NAL_VPS:
       /* It is not mandatory to have VPS in the stream. But it might
        * be needed for other extensions like svc */
-      pres = gst_h265_parser_parse_vps (nalparser, nalu, &vps);
-      if (pres != GST_H265_PARSER_OK) {
-        GST_WARNING_OBJECT (h265parse, "failed to parse VPS");
-        return FALSE;
-      }
+      unchanged = gst_h265_parse_param_set_unchanged (h265parse, nalu);
+      if (!unchanged) {
+        pres = gst_h265_parser_parse_vps (nalparser, nalu, &vps);
+        if (pres != GST_H265_PARSER_OK) {
+          GST_WARNING_OBJECT (h265parse, "failed to parse VPS");
+          return FALSE;
+        }
 
-      GST_DEBUG_OBJECT (h265parse, "triggering src caps check");
-      h265parse->update_caps = TRUE;
+        GST_DEBUG_OBJECT (h265parse, "triggering src caps check");
+        h265parse->update_caps = TRUE;
+      }
       h265parse->have_vps = TRUE;
       h265parse->have_vps_in_frame = TRUE;
       if (h265parse->push_codec && h265parse->have_pps) {
@@ -751,32 +964,35 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
         h265parse->have_pps = FALSE;
       }
 
-      gst_h265_parser_store_nal (h265parse, vps.id, nal_type, nalu);
+      if (!unchanged)
+        gst_h265_parser_store_nal (h265parse, vps.id, nal_type, nalu);
       h265parse->header = TRUE;
       break;
     case GST_H265_NAL_SPS:
       /* reset state, everything else is obsolete */
       h265parse->state = 0;
 
-      pres = gst_h265_parser_parse_sps (nalparser, nalu, &sps, TRUE);
-
+      unchanged = gst_h265_parse_param_set_unchanged (h265parse, nalu);
+      if (!unchanged) {
+        pres = gst_h265_parser_parse_sps (nalparser, nalu, &sps, TRUE);
 
-      /* arranged for a fallback sps.id, so use that one and only warn */
-      if (pres != GST_H265_PARSER_OK) {
-        /* try to not parse VUI */
-        pres = gst_h265_parser_parse_sps (nalparser, nalu, &sps, FALSE);
+        /* arranged for a fallback sps.id, so use that one and only warn */
         if (pres != GST_H265_PARSER_OK) {
-          GST_WARNING_OBJECT (h265parse, "failed to parse SPS:");
-          h265parse->state |= GST_H265_PARSE_STATE_GOT_SPS;
-          h265parse->header = TRUE;
-          return FALSE;
+          /* try to not parse VUI */
+          pres = gst_h265_parser_parse_sps (nalparser, nalu, &sps, FALSE);
+          if (pres != GST_H265_PARSER_OK) {
+            GST_WARNING_OBJECT (h265parse, "failed to parse SPS:");
+            h265parse->state |= GST_H265_PARSE_STATE_GOT_SPS;
+            h265parse->header = TRUE;
+            return FALSE;
+          }
+          GST_WARNING_OBJECT (h265parse,
+              "failed to parse VUI of SPS, ignore VUI");
         }
-        GST_WARNING_OBJECT (h265parse,
-            "failed to parse VUI of SPS, ignore VUI");
-      }
 
-      GST_DEBUG_OBJECT (h265parse, "triggering src caps check");
-      h265parse->update_caps = TRUE;
+        GST_DEBUG_OBJECT (h265parse, "triggering src caps check");
+        h265parse->update_caps = TRUE;
+      }
       h265parse->have_sps = TRUE;
       h265parse->have_sps_in_frame = TRUE;
       if (h265parse->push_codec && h265parse->have_pps) {
@@ -788,7 +1004,8 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
         h265parse->have_pps = FALSE;
       }
 
-      gst_h265_parser_store_nal (h265parse, sps.id, nal_type, nalu);
+      if (!unchanged)
+        gst_h265_parser_store_nal (h265parse, sps.id, nal_type, nalu);
       h265parse->header = TRUE;
       h265parse->state |= GST_H265_PARSE_STATE_GOT_SPS;
       break;
@@ -798,14 +1015,16 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
       if (!GST_H265_PARSE_STATE_VALID (h265parse, GST_H265_PARSE_STATE_GOT_SPS))
         return FALSE;
 
-      pres = gst_h265_parser_parse_pps (nalparser, nalu, &pps);
+      unchanged = gst_h265_parse_param_set_unchanged (h265parse, nalu);
+      if (!unchanged) {
+        pres = gst_h265_parser_parse_pps (nalparser, nalu, &pps);
 
-
-      /* arranged for a fallback pps.id, so use that one and only warn */
-      if (pres != GST_H265_PARSER_OK) {
-        GST_WARNING_OBJECT (h265parse, "failed to parse PPS:");
-        if (pres != GST_H265_PARSER_BROKEN_LINK)
-          return FALSE;
+        /* arranged for a fallback pps.id, so use that one and only warn */
+        if (pres != GST_H265_PARSER_OK) {
+          GST_WARNING_OBJECT (h265parse, "failed to parse PPS:");
+          if (pres != GST_H265_PARSER_BROKEN_LINK)
+            return FALSE;
+        }
       }
 
       /* parameters might have changed, force caps check */
@@ -824,7 +1043,8 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
         h265parse->have_pps = FALSE;
       }
 
-      gst_h265_parser_store_nal (h265parse, pps.id, nal_type, nalu);
+      if (!unchanged)
+        gst_h265_parser_store_nal (h265parse, pps.id, nal_type, nalu);
       h265parse->header = TRUE;
       h265parse->state |= GST_H265_PARSE_STATE_GOT_PPS;
       break;
@@ -836,7 +1056,8 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
 
       h265parse->header = TRUE;
 
-      gst_h265_parse_process_sei (h265parse, nalu);
+      if (!h265parse->lightweight)
+        gst_h265_parse_process_sei (h265parse, nalu);
 
       /* mark SEI pos */
       if (nal_type == GST_H265_NAL_PREFIX_SEI && h265parse->sei_pos == -1) {
@@ -880,17 +1101,30 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
        * AU is complete. This is used to keep track of AU */
       h265parse->picture_start = TRUE;
 
-      pres = gst_h265_parser_parse_slice_hdr (nalparser, nalu, &slice);
-
-      if (pres == GST_H265_PARSER_OK) {
-        if (GST_H265_IS_I_SLICE (&slice))
+      if (h265parse->lightweight && !h265parse->discard_bidirectional) {
+        /* slice_type comes after fields sized from the PPS/SPS, so only
+         * look at first_slice_segment_in_pic_flag and take keyframes from
+         * the IRAP NAL unit types, which only contain I slices */
+        memset (&slice, 0, sizeof (slice));
+        slice.first_slice_segment_in_pic_flag =
+            nalu->data[nalu->offset + nalu->header_bytes] >> 7;
+        if (GST_H265_IS_NAL_TYPE_IRAP (nal_type))
           h265parse->keyframe = TRUE;
-        else if (GST_H265_IS_P_SLICE (&slice))
-          h265parse->predicted = TRUE;
-        else if (GST_H265_IS_B_SLICE (&slice))
-          h265parse->bidirectional = TRUE;
-
         h265parse->state |= GST_H265_PARSE_STATE_GOT_SLICE;
+        pres = GST_H265_PARSER_OK;
+      } else {
+        pres = gst_h265_parser_parse_slice_hdr (nalparser, nalu, &slice);
+
+        if (pres == GST_H265_PARSER_OK) {
+          if (GST_H265_IS_I_SLICE (&slice))
+            h265parse->keyframe = TRUE;
+          else if (GST_H265_IS_P_SLICE (&slice))
+            h265parse->predicted = TRUE;
+          else if (GST_H265_IS_B_SLICE (&slice))
+            h265parse->bidirectional = TRUE;
+
+          h265parse->state |= GST_H265_PARSE_STATE_GOT_SLICE;
+        }
       }
       if (slice.first_slice_segment_in_pic_flag == 1)
         GST_DEBUG_OBJECT (h265parse,
@@ -978,8 +1212,12 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
     GstBuffer *buf;
 
     GST_LOG_OBJECT (h265parse, "collecting NAL in HEVC frame");
-    buf = gst_h265_parse_wrap_nal (h265parse, h265parse->format,
-        nalu->data + nalu->offset, nalu->size);
+    if (h265parse->nal_buffer)
+      buf = gst_h265_parse_wrap_nal_shared (h265parse, h265parse->format,
+          h265parse->nal_buffer, nalu->offset, nalu->size);
+    else
+      buf = gst_h265_parse_wrap_nal (h265parse, h265parse->format,
+          nalu->data + nalu->offset, nalu->size);
     gst_adapter_push (h265parse->frame_out, buf);
   }
 
@@ -1059,7 +1297,9 @@ gst_h265_parse_handle_frame_packetized (GstBaseParse * parse,
     GST_DEBUG_OBJECT (h265parse, "HEVC nal offset %d", nalu.offset + nalu.size);
 
     /* either way, have a look at it */
+    h265parse->nal_buffer = buffer;
     gst_h265_parse_process_nal (h265parse, &nalu);
+    h265parse->nal_buffer = NULL;
 
     /* dispatch per NALU if needed */
     if (h265parse->split_packetized) {
@@ -1134,7 +1374,7 @@ gst_h265_parse_handle_frame (GstBaseParse * parse,
   guint8 *data;
   gsize size;
   gint current_off = 0;
-  gboolean drain, nonext;
+  gboolean drain, nonext, processed;
   GstH265Parser *nalparser = h265parse->nalparser;
   GstH265NalUnit nalu;
   GstH265ParserResult pres;
@@ -1307,7 +1547,11 @@ gst_h265_parse_handle_frame (GstBaseParse * parse,
       }
     }
 
-    if (!gst_h265_parse_process_nal (h265parse, &nalu)) {
+    h265parse->nal_buffer = buffer;
+    processed = gst_h265_parse_process_nal (h265parse, &nalu);
+    h265parse->nal_buffer = NULL;
+
+    if (!processed) {
       GST_WARNING_OBJECT (h265parse,
           "broken/invalid nal Type: %d %s, Size: %u will be dropped",
           nalu.type, _nal_name (nalu.type), nalu.size);
@@ -2414,7 +2658,8 @@ gst_h265_parse_parse_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
   if (av) {
     GstBuffer *buf;
 
-    buf = gst_adapter_take_buffer (h265parse->frame_out, av);
+    /* keeps the shared NAL memories instead of merging them */
+    buf = gst_adapter_take_buffer_fast (h265parse->frame_out, av);
     gst_buffer_copy_into (buf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
     gst_buffer_replace (&frame->out_buffer, buf);
     gst_buffer_unref (buf);
@@ -2431,19 +2676,12 @@ discard:
 
 }
 
-/* sends a codec NAL downstream, decorating and transforming as needed.
- * No ownership is taken of @nal */
+/* sends a wrapped codec NAL downstream, decorating as needed.
+ * Takes ownership of @nal */
 static GstFlowReturn
 gst_h265_parse_push_codec_buffer (GstH265Parse * h265parse, GstBuffer * nal,
     GstBuffer * buffer)
 {
-  GstMapInfo map;
-
-  gst_buffer_map (nal, &map, GST_MAP_READ);
-  nal = gst_h265_parse_wrap_nal (h265parse, h265parse->format,
-      map.data, map.size);
-  gst_buffer_unmap (nal, &map);
-
   if (h265parse->discont) {
     GST_BUFFER_FLAG_SET (nal, GST_BUFFER_FLAG_DISCONT);
     h265parse->discont = FALSE;
@@ -2561,8 +2799,8 @@ static gboolean
 gst_h265_parse_handle_vps_sps_pps_nals (GstH265Parse * h265parse,
     GstBuffer * buffer, GstBaseParseFrame * frame)
 {
-  GstBuffer *codec_nal;
-  gint i;
+  GstBufferList *codec_nals;
+  guint i, n_nals;
   gboolean send_done = FALSE;
 
   if (h265parse->have_vps_in_frame && h265parse->have_sps_in_frame
@@ -2571,91 +2809,33 @@ gst_h265_parse_handle_vps_sps_pps_nals (GstH265Parse * h265parse,
     return TRUE;
   }
 
+  codec_nals = gst_h265_parse_get_codec_nals (h265parse);
+  n_nals = gst_buffer_list_length (codec_nals);
+
   if (h265parse->align == GST_H265_PARSE_ALIGN_NAL) {
     /* send separate config NAL buffers */
-    GST_DEBUG_OBJECT (h265parse, "- sending VPS/SPS/PPS");
-    for (i = 0; i < GST_H265_MAX_VPS_COUNT; i++) {
-      if ((codec_nal = h265parse->vps_nals[i])) {
-        GST_DEBUG_OBJECT (h265parse, "sending VPS nal");
-        gst_h265_parse_push_codec_buffer (h265parse, codec_nal, buffer);
-        send_done = TRUE;
-      }
-    }
-    for (i = 0; i < GST_H265_MAX_SPS_COUNT; i++) {
-      if ((codec_nal = h265parse->sps_nals[i])) {
-        GST_DEBUG_OBJECT (h265parse, "sending SPS nal");
-        gst_h265_parse_push_codec_buffer (h265parse, codec_nal, buffer);
-        send_done = TRUE;
-      }
-    }
-    for (i = 0; i < GST_H265_MAX_PPS_COUNT; i++) {
-      if ((codec_nal = h265parse->pps_nals[i])) {
-        GST_DEBUG_OBJECT (h265parse, "sending PPS nal");
-        gst_h265_parse_push_codec_buffer (h265parse, codec_nal, buffer);
-        send_done = TRUE;
-      }
-    }
-  } else {
-    /* insert config NALs into AU */
-    GstByteWriter bw;
-    GstBuffer *new_buf;
-    const gboolean bs = h265parse->format == GST_H265_PARSE_FORMAT_BYTE;
-    const gint nls = 4 - h265parse->nal_length_size;
+    GST_DEBUG_OBJECT (h265parse, "- sending %u VPS/SPS/PPS", n_nals);
+    for (i = 0; i < n_nals; i++) {
+      gst_h265_parse_push_codec_buffer (h265parse,
+          gst_buffer_copy (gst_buffer_list_get (codec_nals, i)), buffer);
+      send_done = TRUE;
+    }
+  } else if (n_nals > 0) {
+    /* insert config NALs into AU, sharing the frame and VPS/SPS/PPS memory */
+    GstBuffer *new_buf = gst_buffer_new ();
     gboolean ok;
 
-    gst_byte_writer_init_with_size (&bw, gst_buffer_get_size (buffer), FALSE);
-    ok = gst_byte_writer_put_buffer (&bw, buffer, 0, h265parse->idr_pos);
-    GST_DEBUG_OBJECT (h265parse, "- inserting VPS/SPS/PPS");
-    for (i = 0; i < GST_H265_MAX_VPS_COUNT; i++) {
-      if ((codec_nal = h265parse->vps_nals[i])) {
-        gsize nal_size = gst_buffer_get_size (codec_nal);
-        GST_DEBUG_OBJECT (h265parse, "inserting VPS nal");
-        if (bs) {
-          ok &= gst_byte_writer_put_uint32_be (&bw, 1);
-        } else {
-          ok &= gst_byte_writer_put_uint32_be (&bw, (nal_size << (nls * 8)));
-          ok &= gst_byte_writer_set_pos (&bw,
-              gst_byte_writer_get_pos (&bw) - nls);
-        }
-
-        ok &= gst_byte_writer_put_buffer (&bw, codec_nal, 0, nal_size);
-        send_done = TRUE;
-      }
-    }
-    for (i = 0; i < GST_H265_MAX_SPS_COUNT; i++) {
-      if ((codec_nal = h265parse->sps_nals[i])) {
-        gsize nal_size = gst_buffer_get_size (codec_nal);
-        GST_DEBUG_OBJECT (h265parse, "inserting SPS nal");
-        if (bs) {
-          ok &= gst_byte_writer_put_uint32_be (&bw, 1);
-        } else {
-          ok &= gst_byte_writer_put_uint32_be (&bw, (nal_size << (nls * 8)));
-          ok &= gst_byte_writer_set_pos (&bw,
-              gst_byte_writer_get_pos (&bw) - nls);
-        }
+    GST_DEBUG_OBJECT (h265parse, "- inserting %u VPS/SPS/PPS", n_nals);
+    ok = gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_MEMORY, 0,
+        h265parse->idr_pos);
+    ok &= gst_buffer_copy_into (new_buf,
+        gst_h265_parse_get_codec_nals_block (h265parse),
+        GST_BUFFER_COPY_MEMORY, 0, -1);
+    ok &= gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_MEMORY,
+        h265parse->idr_pos, -1);
+    send_done = TRUE;
 
-        ok &= gst_byte_writer_put_buffer (&bw, codec_nal, 0, nal_size);
-        send_done = TRUE;
-      }
-    }
-    for (i = 0; i < GST_H265_MAX_PPS_COUNT; i++) {
-      if ((codec_nal = h265parse->pps_nals[i])) {
-        gsize nal_size = gst_buffer_get_size (codec_nal);
-        GST_DEBUG_OBJECT (h265parse, "inserting PPS nal");
-        if (bs) {
-          ok &= gst_byte_writer_put_uint32_be (&bw, 1);
-        } else {
-          ok &= gst_byte_writer_put_uint32_be (&bw, (nal_size << (nls * 8)));
-          ok &= gst_byte_writer_set_pos (&bw,
-              gst_byte_writer_get_pos (&bw) - nls);
-        }
-        ok &= gst_byte_writer_put_buffer (&bw, codec_nal, 0, nal_size);
-        send_done = TRUE;
-      }
-    }
-    ok &= gst_byte_writer_put_buffer (&bw, buffer, h265parse->idr_pos, -1);
     /* collect result and push */
-    new_buf = gst_byte_writer_reset_and_get_buffer (&bw);
     gst_buffer_copy_into (new_buf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
     /* should already be keyframe/IDR, but it may not have been,
      * so mark it as such to avoid being discarded by picky decoder */
@@ -3253,6 +3433,9 @@ gst_h265_parse_set_property (GObject * object, guint prop_id,
     case PROP_CONFIG_INTERVAL:
       parse->interval = g_value_get_int (value);
       break;
+    case PROP_LIGHTWEIGHT:
+      parse->lightweight = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -3270,6 +3453,9 @@ gst_h265_parse_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_CONFIG_INTERVAL:
       g_value_set_int (value, parse->interval);
       break;
+    case PROP_LIGHTWEIGHT:
+      g_value_set_boolean (value, parse->lightweight);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
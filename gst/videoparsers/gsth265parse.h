@@ -93,6 +93,12 @@ struct _GstH265Parse
   GstBuffer *sps_nals[GST_H265_MAX_SPS_COUNT];
   GstBuffer *pps_nals[GST_H265_MAX_PPS_COUNT];
 
+  /* the NALUs above wrapped for the output format, for insertion */
+  GstBufferList *codec_nals;
+  GstBuffer *codec_nals_block;
+  guint codec_nals_format;
+  guint codec_nals_nl;
+
   /* Infos we need to keep track of */
   guint8 sei_pic_struct;
 
@@ -106,6 +112,9 @@ struct _GstH265Parse
   gint idr_pos, sei_pos;
   gboolean update_caps;
   GstAdapter *frame_out;
+  /* input buffer the NAL being processed was mapped from, if its payload
+   * can be shared into frame_out */
+  GstBuffer *nal_buffer;
   gboolean keyframe;
   gboolean predicted;
   gboolean bidirectional;
@@ -118,6 +127,7 @@ struct _GstH265Parse
 
   /* props */
   gint interval;
+  gboolean lightweight;
 
   GstClockTime pending_key_unit_ts;
   GstEvent *force_key_unit_event;
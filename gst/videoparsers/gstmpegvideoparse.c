@@ -54,14 +54,26 @@ GST_STATIC_PAD_TEMPLATE ("sink", GST_PAD_SINK,
 /* Properties */
 #define DEFAULT_PROP_DROP       TRUE
 #define DEFAULT_PROP_GOP_SPLIT  FALSE
+#define DEFAULT_PROP_GOP_INDEX  FALSE
 
 enum
 {
   PROP_0,
   PROP_DROP,
-  PROP_GOP_SPLIT
+  PROP_GOP_SPLIT,
+  PROP_GOP_INDEX
 };
 
+#define GOP_INDEX_QUERY_NAME "GstMpegvParseGopIndex"
+
+typedef struct
+{
+  guint64 offset;
+  GstClockTime pts;
+  guint16 tsn;
+  gboolean gop;
+} GstMpegvParseIndexEntry;
+
 #define parent_class gst_mpegv_parse_parent_class
 G_DEFINE_TYPE (GstMpegvParse, gst_mpegv_parse, GST_TYPE_BASE_PARSE);
 
@@ -78,6 +90,8 @@ static GstFlowReturn gst_mpegv_parse_pre_push_frame (GstBaseParse * parse,
     GstBaseParseFrame * frame);
 static gboolean gst_mpegv_parse_sink_query (GstBaseParse * parse,
     GstQuery * query);
+static gboolean gst_mpegv_parse_src_query (GstBaseParse * parse,
+    GstQuery * query);
 
 static void gst_mpegv_parse_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
@@ -97,6 +111,9 @@ gst_mpegv_parse_set_property (GObject * object, guint property_id,
     case PROP_GOP_SPLIT:
       parse->gop_split = g_value_get_boolean (value);
       break;
+    case PROP_GOP_INDEX:
+      parse->gop_index = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -115,6 +132,9 @@ gst_mpegv_parse_get_property (GObject * object, guint property_id,
     case PROP_GOP_SPLIT:
       g_value_set_boolean (value, parse->gop_split);
       break;
+    case PROP_GOP_INDEX:
+      g_value_set_boolean (value, parse->gop_index);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -146,6 +166,26 @@ gst_mpegv_parse_class_init (GstMpegvParseClass * klass)
           "Split frame when encountering GOP", DEFAULT_PROP_GOP_SPLIT,
           G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstMpegvParse:gop-index:
+   *
+   * Record the input byte offset, PTS and temporal reference of every GOP
+   * start and I-frame that is output.
+   *
+   * The index can be retrieved with a %GST_QUERY_CUSTOM query carrying a
+   * structure named "GstMpegvParseGopIndex". On success the structure gets
+   * an "entries" array of structures with the "offset" (guint64), "pts"
+   * (guint64), "temporal-reference" (guint) and "gop" (gboolean) fields,
+   * sorted by offset.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_GOP_INDEX,
+      g_param_spec_boolean ("gop-index", "GOP index",
+          "Build an index of GOP starts and I-frames, retrievable with a "
+          "custom query", DEFAULT_PROP_GOP_INDEX,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (element_class, &src_template);
   gst_element_class_add_static_pad_template (element_class, &sink_template);
 
@@ -166,6 +206,7 @@ gst_mpegv_parse_class_init (GstMpegvParseClass * klass)
   parse_class->pre_push_frame =
       GST_DEBUG_FUNCPTR (gst_mpegv_parse_pre_push_frame);
   parse_class->sink_query = GST_DEBUG_FUNCPTR (gst_mpegv_parse_sink_query);
+  parse_class->src_query = GST_DEBUG_FUNCPTR (gst_mpegv_parse_src_query);
 }
 
 static void
@@ -187,6 +228,7 @@ gst_mpegv_parse_reset_frame (GstMpegvParse * mpvparse)
   mpvparse->seq_size = 0;
   mpvparse->seq_offset = -1;
   mpvparse->pic_offset = -1;
+  mpvparse->frame_has_gop = FALSE;
   mpvparse->frame_repeat_count = 0;
   memset (mpvparse->ext_offsets, 0, sizeof (mpvparse->ext_offsets));
   mpvparse->ext_count = 0;
@@ -215,6 +257,13 @@ gst_mpegv_parse_reset (GstMpegvParse * mpvparse)
   mpvparse->seqdispext_updated = FALSE;
   mpvparse->picext_updated = FALSE;
   mpvparse->quantmatrext_updated = FALSE;
+
+  GST_OBJECT_LOCK (mpvparse);
+  if (mpvparse->index) {
+    g_array_free (mpvparse->index, TRUE);
+    mpvparse->index = NULL;
+  }
+  GST_OBJECT_UNLOCK (mpvparse);
 }
 
 static gboolean
@@ -237,6 +286,108 @@ gst_mpegv_parse_sink_query (GstBaseParse * parse, GstQuery * query)
   return res;
 }
 
+static gboolean
+gst_mpegv_parse_handle_index_query (GstMpegvParse * mpvparse, GstQuery * query)
+{
+  GstStructure *s;
+  GValue entries = G_VALUE_INIT;
+  guint i;
+
+  if (!mpvparse->gop_index)
+    return FALSE;
+
+  g_value_init (&entries, GST_TYPE_ARRAY);
+
+  GST_OBJECT_LOCK (mpvparse);
+  for (i = 0; mpvparse->index && i < mpvparse->index->len; i++) {
+    GstMpegvParseIndexEntry *entry =
+        &g_array_index (mpvparse->index, GstMpegvParseIndexEntry, i);
+    GValue v = G_VALUE_INIT;
+
+    g_value_init (&v, GST_TYPE_STRUCTURE);
+    g_value_take_boxed (&v, gst_structure_new ("entry",
+            "offset", G_TYPE_UINT64, entry->offset,
+            "pts", G_TYPE_UINT64, entry->pts,
+            "temporal-reference", G_TYPE_UINT, (guint) entry->tsn,
+            "gop", G_TYPE_BOOLEAN, entry->gop, NULL));
+    gst_value_array_append_and_take_value (&entries, &v);
+  }
+  GST_OBJECT_UNLOCK (mpvparse);
+
+  GST_DEBUG_OBJECT (mpvparse, "answering GOP index query with %u entries", i);
+
+  s = gst_query_writable_structure (query);
+  gst_structure_take_value (s, "entries", &entries);
+
+  return TRUE;
+}
+
+static gboolean
+gst_mpegv_parse_src_query (GstBaseParse * parse, GstQuery * query)
+{
+  GstMpegvParse *mpvparse = GST_MPEGVIDEO_PARSE (parse);
+
+  if (GST_QUERY_TYPE (query) == GST_QUERY_CUSTOM) {
+    const GstStructure *s = gst_query_get_structure (query);
+
+    if (s && gst_structure_has_name (s, GOP_INDEX_QUERY_NAME))
+      return gst_mpegv_parse_handle_index_query (mpvparse, query);
+  }
+
+  return GST_BASE_PARSE_CLASS (parent_class)->src_query (parse, query);
+}
+
+/* keeps the index sorted on offset, so entries seen again after a seek
+ * are not duplicated */
+static void
+gst_mpegv_parse_add_index_entry (GstMpegvParse * mpvparse,
+    GstBaseParseFrame * frame)
+{
+  GstMpegvParseIndexEntry entry;
+  GArray *index;
+  guint lo, hi;
+
+  entry.offset = frame->offset;
+  entry.pts = GST_BUFFER_PTS (frame->buffer);
+  entry.tsn = mpvparse->pichdr.tsn;
+  entry.gop = mpvparse->frame_has_gop;
+
+  GST_LOG_OBJECT (mpvparse, "index entry at offset %" G_GUINT64_FORMAT
+      ", pts %" GST_TIME_FORMAT ", tsn %u, gop %d", entry.offset,
+      GST_TIME_ARGS (entry.pts), entry.tsn, entry.gop);
+
+  GST_OBJECT_LOCK (mpvparse);
+  if (!mpvparse->index)
+    mpvparse->index = g_array_new (FALSE, FALSE,
+        sizeof (GstMpegvParseIndexEntry));
+  index = mpvparse->index;
+
+  lo = 0;
+  hi = index->len;
+  if (hi > 0 && g_array_index (index, GstMpegvParseIndexEntry,
+          hi - 1).offset < entry.offset) {
+    lo = hi;
+  }
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    if (g_array_index (index, GstMpegvParseIndexEntry, mid).offset <
+        entry.offset)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  if (lo < index->len &&
+      g_array_index (index, GstMpegvParseIndexEntry, lo).offset ==
+      entry.offset) {
+    g_array_index (index, GstMpegvParseIndexEntry, lo) = entry;
+  } else {
+    g_array_insert_val (index, lo, entry);
+  }
+  GST_OBJECT_UNLOCK (mpvparse);
+}
+
 static gboolean
 gst_mpegv_parse_start (GstBaseParse * parse)
 {
@@ -518,6 +669,9 @@ gst_mpegv_parse_process_sc (GstMpegvParse * mpvparse,
         ret = mpvparse->gop_split;
       else
         ret = TRUE;
+      /* a terminating GOP belongs to the next frame */
+      if (!ret || off == 4)
+        mpvparse->frame_has_gop = TRUE;
       break;
     case GST_MPEG_VIDEO_PACKET_EXTENSION:
       mpvparse->config_flags |= FLAG_MPEG2;
@@ -1002,6 +1156,11 @@ gst_mpegv_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
   /* usual clipping applies */
   frame->flags |= GST_BASE_PARSE_FRAME_FLAG_CLIP;
 
+  if (mpvparse->gop_index && !(frame->flags & GST_BASE_PARSE_FRAME_FLAG_NO_FRAME)
+      && (mpvparse->frame_has_gop
+          || mpvparse->pichdr.pic_type == GST_MPEG_VIDEO_PICTURE_TYPE_I))
+    gst_mpegv_parse_add_index_entry (mpvparse, frame);
+
   if (mpvparse->send_mpeg_meta) {
     GstBuffer *buf;
 
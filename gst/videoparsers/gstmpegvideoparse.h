@@ -65,6 +65,7 @@ struct _GstMpegvParse {
   gint seq_offset;
   gint seq_size;
   gint pic_offset;
+  gboolean frame_has_gop;
   guint slice_count;
   guint slice_offset;
   gboolean update_caps;
@@ -92,6 +93,10 @@ struct _GstMpegvParse {
   /* properties */
   gboolean drop;
   gboolean gop_split;
+  gboolean gop_index;
+
+  /* GOP / I-frame index, protected by the object lock */
+  GArray *index;
 
   int fps_num;
   int fps_den;
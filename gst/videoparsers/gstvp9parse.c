@@ -429,11 +429,12 @@ gst_vp9_parse_handle_frame (GstBaseParse * parse, GstBaseParseFrame * frame,
       subframe.buffer = gst_buffer_copy_region (buffer, GST_BUFFER_COPY_ALL,
           offset, frame_size);
 
-      /* note we don't need to come up with a sub-buffer, since
-       * subsequent code only considers input buffer's metadata.
-       * Real data is either taken from input by baseclass or
-       * a replacement output buffer is provided anyway. */
       gst_vp9_parse_parse_frame (self, &subframe, &frame_hdr);
+
+      /* output the sub-buffer itself rather than letting the baseclass take
+       * the data from its adapter, which would merge the memory if the
+       * superframe arrived in more than one buffer */
+      subframe.out_buffer = gst_buffer_ref (subframe.buffer);
       ret = gst_base_parse_finish_frame (parse, &subframe, frame_size);
     } else {
       /* FIXME: need to parse all frames belong to this superframe? */
@@ -38,6 +38,19 @@
  *
  * * #gdouble`luma-variance`: the brightness variance of the frame.
  *
+ * * #gdouble`luma-difference`: the average absolute brightness difference
+ *   with the previous analysed frame. Range: 0.0-1.0. Since: 1.20
+ *
+ * * #gboolean`frozen`: whether `luma-difference` is below the
+ *   #GstVideoAnalyse:frozen-threshold. Since: 1.20
+ *
+ * The last two fields are only present when a previous frame was analysed.
+ *
+ * To lower the cost of monitoring many streams, the statistics can be
+ * computed on a subset of the luma samples with the
+ * #GstVideoAnalyse:row-step and #GstVideoAnalyse:column-step properties, and
+ * on a subset of the frames with #GstVideoAnalyse:frame-interval.
+ *
  * ## Example launch line
  * |[
  * gst-launch-1.0 -m videotestsrc ! videoanalyse ! videoconvert ! ximagesink
@@ -66,16 +79,28 @@ static void gst_video_analyse_get_property (GObject * object,
     guint property_id, GValue * value, GParamSpec * pspec);
 static void gst_video_analyse_finalize (GObject * object);
 
+static gboolean gst_video_analyse_set_info (GstVideoFilter * filter,
+    GstCaps * incaps, GstVideoInfo * in_info, GstCaps * outcaps,
+    GstVideoInfo * out_info);
 static GstFlowReturn gst_video_analyse_transform_frame_ip (GstVideoFilter *
     filter, GstVideoFrame * frame);
 
 enum
 {
   PROP_0,
-  PROP_MESSAGE
+  PROP_MESSAGE,
+  PROP_ROW_STEP,
+  PROP_COLUMN_STEP,
+  PROP_FRAME_INTERVAL,
+  PROP_FROZEN_THRESHOLD
 };
 
 #define DEFAULT_MESSAGE TRUE
+#define DEFAULT_ROW_STEP 1
+#define DEFAULT_COLUMN_STEP 1
+#define DEFAULT_FRAME_INTERVAL 1
+/* about half a level on average */
+#define DEFAULT_FROZEN_THRESHOLD 0.002
 
 #define VIDEO_CAPS \
     GST_VIDEO_CAPS_MAKE("{ I420, YV12, Y444, Y42B, Y41B }")
@@ -108,6 +133,7 @@ gst_video_analyse_class_init (GstVideoAnalyseClass * klass)
   gobject_class->set_property = gst_video_analyse_set_property;
   gobject_class->get_property = gst_video_analyse_get_property;
   gobject_class->finalize = gst_video_analyse_finalize;
+  video_filter_class->set_info = GST_DEBUG_FUNCPTR (gst_video_analyse_set_info);
   video_filter_class->transform_frame_ip =
       GST_DEBUG_FUNCPTR (gst_video_analyse_transform_frame_ip);
 
@@ -116,12 +142,68 @@ gst_video_analyse_class_init (GstVideoAnalyseClass * klass)
           "Post statics messages",
           DEFAULT_MESSAGE,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstVideoAnalyse:row-step:
+   *
+   * Only use the luma samples of every Nth row of the frames.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_ROW_STEP,
+      g_param_spec_uint ("row-step", "Row step",
+          "Analyse every Nth row only", 1, G_MAXUINT16, DEFAULT_ROW_STEP,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstVideoAnalyse:column-step:
+   *
+   * Only use the luma samples of every Nth column of the frames.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_COLUMN_STEP,
+      g_param_spec_uint ("column-step", "Column step",
+          "Analyse every Nth column only", 1, G_MAXUINT16,
+          DEFAULT_COLUMN_STEP, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstVideoAnalyse:frame-interval:
+   *
+   * Only analyse one frame out of N, messages are only posted for those.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass),
+      PROP_FRAME_INTERVAL, g_param_spec_uint ("frame-interval",
+          "Frame interval", "Analyse every Nth frame only", 1, G_MAXUINT,
+          DEFAULT_FRAME_INTERVAL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstVideoAnalyse:frozen-threshold:
+   *
+   * Frames whose average absolute brightness difference with the previous
+   * analysed frame is below this value are reported as frozen.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass),
+      PROP_FROZEN_THRESHOLD, g_param_spec_double ("frozen-threshold",
+          "Frozen threshold",
+          "Maximum average brightness difference with the previous frame "
+          "for frames to be reported as frozen", 0.0, 1.0,
+          DEFAULT_FROZEN_THRESHOLD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
   //trans_class->passthrough_on_same_caps = TRUE;
 }
 
 static void
 gst_video_analyse_init (GstVideoAnalyse * videoanalyse)
 {
+  videoanalyse->row_step = DEFAULT_ROW_STEP;
+  videoanalyse->column_step = DEFAULT_COLUMN_STEP;
+  videoanalyse->frame_interval = DEFAULT_FRAME_INTERVAL;
+  videoanalyse->frozen_threshold = DEFAULT_FROZEN_THRESHOLD;
 }
 
 void
@@ -136,6 +218,18 @@ gst_video_analyse_set_property (GObject * object, guint property_id,
     case PROP_MESSAGE:
       videoanalyse->message = g_value_get_boolean (value);
       break;
+    case PROP_ROW_STEP:
+      videoanalyse->row_step = g_value_get_uint (value);
+      break;
+    case PROP_COLUMN_STEP:
+      videoanalyse->column_step = g_value_get_uint (value);
+      break;
+    case PROP_FRAME_INTERVAL:
+      videoanalyse->frame_interval = g_value_get_uint (value);
+      break;
+    case PROP_FROZEN_THRESHOLD:
+      videoanalyse->frozen_threshold = g_value_get_double (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -154,6 +248,18 @@ gst_video_analyse_get_property (GObject * object, guint property_id,
     case PROP_MESSAGE:
       g_value_set_boolean (value, videoanalyse->message);
       break;
+    case PROP_ROW_STEP:
+      g_value_set_uint (value, videoanalyse->row_step);
+      break;
+    case PROP_COLUMN_STEP:
+      g_value_set_uint (value, videoanalyse->column_step);
+      break;
+    case PROP_FRAME_INTERVAL:
+      g_value_set_uint (value, videoanalyse->frame_interval);
+      break;
+    case PROP_FROZEN_THRESHOLD:
+      g_value_set_double (value, videoanalyse->frozen_threshold);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -168,16 +274,32 @@ gst_video_analyse_finalize (GObject * object)
   GST_DEBUG_OBJECT (videoanalyse, "finalize");
 
   /* clean up object here */
+  g_free (videoanalyse->prev);
+  videoanalyse->prev = NULL;
 
   G_OBJECT_CLASS (gst_video_analyse_parent_class)->finalize (object);
 }
 
+static gboolean
+gst_video_analyse_set_info (GstVideoFilter * filter, GstCaps * incaps,
+    GstVideoInfo * in_info, GstCaps * outcaps, GstVideoInfo * out_info)
+{
+  GstVideoAnalyse *videoanalyse = GST_VIDEO_ANALYSE (filter);
+
+  /* don't compare frames of different sizes */
+  videoanalyse->have_prev = FALSE;
+  videoanalyse->frame_count = 0;
+
+  return TRUE;
+}
+
 static void
 gst_video_analyse_post_message (GstVideoAnalyse * videoanalyse,
     GstVideoFrame * frame)
 {
   GstBaseTransform *trans;
   GstMessage *m;
+  GstStructure *s;
   guint64 duration, timestamp, running_time, stream_time;
 
   trans = GST_BASE_TRANSFORM_CAST (videoanalyse);
@@ -190,54 +312,108 @@ gst_video_analyse_post_message (GstVideoAnalyse * videoanalyse,
   stream_time = gst_segment_to_stream_time (&trans->segment, GST_FORMAT_TIME,
       timestamp);
 
-  m = gst_message_new_element (GST_OBJECT_CAST (videoanalyse),
-      gst_structure_new ("GstVideoAnalyse",
-          "timestamp", G_TYPE_UINT64, timestamp,
-          "stream-time", G_TYPE_UINT64, stream_time,
-          "running-time", G_TYPE_UINT64, running_time,
-          "duration", G_TYPE_UINT64, duration,
-          "luma-average", G_TYPE_DOUBLE, videoanalyse->luma_average,
-          "luma-variance", G_TYPE_DOUBLE, videoanalyse->luma_variance, NULL));
+  s = gst_structure_new ("GstVideoAnalyse",
+      "timestamp", G_TYPE_UINT64, timestamp,
+      "stream-time", G_TYPE_UINT64, stream_time,
+      "running-time", G_TYPE_UINT64, running_time,
+      "duration", G_TYPE_UINT64, duration,
+      "luma-average", G_TYPE_DOUBLE, videoanalyse->luma_average,
+      "luma-variance", G_TYPE_DOUBLE, videoanalyse->luma_variance, NULL);
+
+  if (videoanalyse->have_prev) {
+    gst_structure_set (s,
+        "luma-difference", G_TYPE_DOUBLE, videoanalyse->luma_difference,
+        "frozen", G_TYPE_BOOLEAN,
+        videoanalyse->luma_difference <= videoanalyse->frozen_threshold,
+        NULL);
+  }
+
+  m = gst_message_new_element (GST_OBJECT_CAST (videoanalyse), s);
 
   gst_element_post_message (GST_ELEMENT_CAST (videoanalyse), m);
 }
 
+/* accumulates the sum, the sum of squares and the sum of absolute
+ * differences with the previous samples of @n samples, @step bytes apart,
+ * and replaces the previous samples with them */
+static void
+gst_video_analyse_line (const guint8 * d, guint8 * prev, gint n, gint step,
+    guint64 * sum, guint64 * sum2, guint64 * sad)
+{
+  guint64 s = 0, s2 = 0, a = 0;
+  gint j;
+
+  /* the common case is kept separate so the compiler can vectorize it */
+  if (step == 1) {
+    for (j = 0; j < n; j++) {
+      guint v = d[j];
+
+      s += v;
+      s2 += v * v;
+      a += ABS ((gint) v - prev[j]);
+      prev[j] = v;
+    }
+  } else {
+    for (j = 0; j < n; j++) {
+      guint v = d[j * step];
+
+      s += v;
+      s2 += v * v;
+      a += ABS ((gint) v - prev[j]);
+      prev[j] = v;
+    }
+  }
+
+  *sum += s;
+  *sum2 += s2;
+  *sad += a;
+}
+
 static void
 gst_video_analyse_planar (GstVideoAnalyse * videoanalyse, GstVideoFrame * frame)
 {
-  guint64 sum;
-  gint avg, diff;
-  gint i, j;
-  guint8 *d;
+  guint64 sum, sum2, sad, n, avg;
+  gint i, rows, columns;
+  guint8 *d, *prev;
   gint width = frame->info.width;
   gint height = frame->info.height;
+  gint row_step = videoanalyse->row_step;
+  gint column_step = videoanalyse->column_step;
   gint stride;
 
-  d = frame->data[0];
-  stride = frame->info.stride[0];
-  sum = 0;
-  /* do brightness as average of pixel brightness in 0.0 to 1.0 */
-  for (i = 0; i < height; i++) {
-    for (j = 0; j < width; j++) {
-      sum += d[j];
-    }
-    d += stride;
+  rows = (height + row_step - 1) / row_step;
+  columns = (width + column_step - 1) / column_step;
+
+  if (videoanalyse->prev_rows != rows ||
+      videoanalyse->prev_columns != columns) {
+    g_free (videoanalyse->prev);
+    videoanalyse->prev = g_malloc0 (rows * columns);
+    videoanalyse->prev_rows = rows;
+    videoanalyse->prev_columns = columns;
+    videoanalyse->have_prev = FALSE;
   }
-  avg = sum / (width * height);
-  videoanalyse->luma_average = sum / (255.0 * width * height);
 
   d = frame->data[0];
   stride = frame->info.stride[0];
-  sum = 0;
-  /* do variance */
-  for (i = 0; i < height; i++) {
-    for (j = 0; j < width; j++) {
-      diff = (avg - d[j]);
-      sum += diff * diff;
-    }
-    d += stride;
+  prev = videoanalyse->prev;
+  sum = sum2 = sad = 0;
+  /* all statistics are computed in a single pass over the samples */
+  for (i = 0; i < rows; i++) {
+    gst_video_analyse_line (d, prev, columns, column_step, &sum, &sum2, &sad);
+    d += stride * row_step;
+    prev += columns;
   }
-  videoanalyse->luma_variance = sum / (255.0 * 255.0 * width * height);
+  n = (guint64) rows * columns;
+
+  /* do brightness as average of pixel brightness in 0.0 to 1.0 */
+  avg = sum / n;
+  videoanalyse->luma_average = sum / (255.0 * n);
+
+  /* do variance, around the truncated average as it always was */
+  videoanalyse->luma_variance =
+      (sum2 + n * avg * avg - 2 * avg * sum) / (255.0 * 255.0 * n);
+
+  videoanalyse->luma_difference = sad / (255.0 * n);
 }
 
 static GstFlowReturn
@@ -248,10 +424,16 @@ gst_video_analyse_transform_frame_ip (GstVideoFilter * filter,
 
   GST_DEBUG_OBJECT (videoanalyse, "transform_frame_ip");
 
+  if (videoanalyse->frame_count++ % videoanalyse->frame_interval != 0)
+    return GST_FLOW_OK;
+
   gst_video_analyse_planar (videoanalyse, frame);
 
   if (videoanalyse->message)
     gst_video_analyse_post_message (videoanalyse, frame);
 
+  /* now compare the next frames to this one */
+  videoanalyse->have_prev = TRUE;
+
   return GST_FLOW_OK;
 }
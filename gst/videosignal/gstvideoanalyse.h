@@ -43,6 +43,19 @@ struct _GstVideoAnalyse
   guint64 interval;
   gdouble luma_average;
   gdouble luma_variance;
+
+  guint row_step;
+  guint column_step;
+  guint frame_interval;
+  gdouble frozen_threshold;
+
+  guint64 frame_count;
+
+  /* luma samples of the previous analysed frame */
+  guint8 *prev;
+  gint prev_rows, prev_columns;
+  gboolean have_prev;
+  gdouble luma_difference;
 };
 
 struct _GstVideoAnalyseClass
@@ -41,6 +41,7 @@
 #include <string.h>
 
 #define MAX_SIZE 32768
+#define MAX_HEADER_LENGTH 80
 
 GST_DEBUG_CATEGORY (y4mdec_debug);
 #define GST_CAT_DEFAULT y4mdec_debug
@@ -55,8 +56,12 @@ static void gst_y4m_dec_get_property (GObject * object,
 static void gst_y4m_dec_dispose (GObject * object);
 static void gst_y4m_dec_finalize (GObject * object);
 
+static gboolean gst_y4m_dec_sink_activate (GstPad * pad, GstObject * parent);
+static gboolean gst_y4m_dec_sink_activate_mode (GstPad * pad,
+    GstObject * parent, GstPadMode mode, gboolean active);
 static GstFlowReturn gst_y4m_dec_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buffer);
+static void gst_y4m_dec_loop (GstPad * pad);
 static gboolean gst_y4m_dec_sink_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
 
@@ -127,6 +132,10 @@ gst_y4m_dec_init (GstY4mDec * y4mdec)
       GST_DEBUG_FUNCPTR (gst_y4m_dec_sink_event));
   gst_pad_set_chain_function (y4mdec->sinkpad,
       GST_DEBUG_FUNCPTR (gst_y4m_dec_chain));
+  gst_pad_set_activate_function (y4mdec->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_y4m_dec_sink_activate));
+  gst_pad_set_activatemode_function (y4mdec->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_y4m_dec_sink_activate_mode));
   gst_element_add_pad (GST_ELEMENT (y4mdec), y4mdec->sinkpad);
 
   y4mdec->srcpad = gst_pad_new_from_static_template (&gst_y4m_dec_src_template,
@@ -207,6 +216,10 @@ gst_y4m_dec_change_state (GstElement * element, GstStateChange transition)
     case GST_STATE_CHANGE_NULL_TO_READY:
       break;
     case GST_STATE_CHANGE_READY_TO_PAUSED:
+      gst_adapter_clear (y4mdec->adapter);
+      y4mdec->have_header = FALSE;
+      y4mdec->frame_index = 0;
+      y4mdec->offset = 0;
       break;
     case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
       break;
@@ -481,13 +494,167 @@ error:
   return FALSE;
 }
 
+/* Sets the output caps and decides whether downstream can take the frames
+ * with their natural Y4M layout through GstVideoMeta, or whether they need
+ * to be copied into buffers with the default strides */
+static gboolean
+gst_y4m_dec_negotiate (GstY4mDec * y4mdec)
+{
+  gboolean ret;
+  GstCaps *caps;
+  GstQuery *query;
+
+  caps = gst_video_info_to_caps (&y4mdec->info);
+  ret = gst_pad_set_caps (y4mdec->srcpad, caps);
+
+  query = gst_query_new_allocation (caps, FALSE);
+  y4mdec->video_meta = FALSE;
+
+  if (y4mdec->pool) {
+    gst_buffer_pool_set_active (y4mdec->pool, FALSE);
+    gst_object_unref (y4mdec->pool);
+  }
+  y4mdec->pool = NULL;
+
+  if (gst_pad_peer_query (y4mdec->srcpad, query)) {
+    y4mdec->video_meta =
+        gst_query_find_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
+
+    /* We only need a pool if we need to do stride conversion for downstream */
+    if (!y4mdec->video_meta && memcmp (&y4mdec->info, &y4mdec->out_info,
+            sizeof (y4mdec->info)) != 0) {
+      GstBufferPool *pool = NULL;
+      GstAllocator *allocator = NULL;
+      GstAllocationParams params;
+      GstStructure *config;
+      guint size, min, max;
+
+      if (gst_query_get_n_allocation_params (query) > 0) {
+        gst_query_parse_nth_allocation_param (query, 0, &allocator, &params);
+      } else {
+        allocator = NULL;
+        gst_allocation_params_init (&params);
+      }
+
+      if (gst_query_get_n_allocation_pools (query) > 0) {
+        gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min,
+            &max);
+        size = MAX (size, y4mdec->out_info.size);
+      } else {
+        pool = NULL;
+        size = y4mdec->out_info.size;
+        min = max = 0;
+      }
+
+      if (pool == NULL) {
+        pool = gst_video_buffer_pool_new ();
+      }
+
+      config = gst_buffer_pool_get_config (pool);
+      gst_buffer_pool_config_set_params (config, caps, size, min, max);
+      gst_buffer_pool_config_set_allocator (config, allocator, &params);
+      gst_buffer_pool_set_config (pool, config);
+
+      if (allocator)
+        gst_object_unref (allocator);
+
+      y4mdec->pool = pool;
+    }
+  } else if (memcmp (&y4mdec->info, &y4mdec->out_info,
+          sizeof (y4mdec->info)) != 0) {
+    GstBufferPool *pool;
+    GstStructure *config;
+
+    /* No pool, create our own if we need to do stride conversion */
+    pool = gst_video_buffer_pool_new ();
+    config = gst_buffer_pool_get_config (pool);
+    gst_buffer_pool_config_set_params (config, caps, y4mdec->out_info.size, 0,
+        0);
+    gst_buffer_pool_set_config (pool, config);
+    y4mdec->pool = pool;
+  }
+  if (y4mdec->pool) {
+    gst_buffer_pool_set_active (y4mdec->pool, TRUE);
+  }
+  gst_query_unref (query);
+  gst_caps_unref (caps);
+  if (!ret) {
+    GST_DEBUG_OBJECT (y4mdec, "Couldn't set caps on src pad");
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_y4m_dec_push_frame (GstY4mDec * y4mdec, GstBuffer * buffer)
+{
+  GstFlowReturn flow_ret;
+
+  GST_BUFFER_TIMESTAMP (buffer) =
+      gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->frame_index);
+  GST_BUFFER_DURATION (buffer) =
+      gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->frame_index + 1) -
+      GST_BUFFER_TIMESTAMP (buffer);
+
+  y4mdec->frame_index++;
+
+  if (y4mdec->video_meta) {
+    gst_buffer_add_video_meta_full (buffer, 0, y4mdec->info.finfo->format,
+        y4mdec->info.width, y4mdec->info.height, y4mdec->info.finfo->n_planes,
+        y4mdec->info.offset, y4mdec->info.stride);
+  } else if (memcmp (&y4mdec->info, &y4mdec->out_info,
+          sizeof (y4mdec->info)) != 0) {
+    GstBuffer *outbuf;
+    GstVideoFrame iframe, oframe;
+    gint i, j;
+    gint w, h, istride, ostride;
+    guint8 *src, *dest;
+
+    /* Allocate a new buffer and do stride conversion */
+    g_assert (y4mdec->pool != NULL);
+
+    flow_ret = gst_buffer_pool_acquire_buffer (y4mdec->pool, &outbuf, NULL);
+    if (flow_ret != GST_FLOW_OK) {
+      gst_buffer_unref (buffer);
+      return flow_ret;
+    }
+
+    gst_video_frame_map (&iframe, &y4mdec->info, buffer, GST_MAP_READ);
+    gst_video_frame_map (&oframe, &y4mdec->out_info, outbuf, GST_MAP_WRITE);
+
+    for (i = 0; i < 3; i++) {
+      w = GST_VIDEO_FRAME_COMP_WIDTH (&iframe, i);
+      h = GST_VIDEO_FRAME_COMP_HEIGHT (&iframe, i);
+      istride = GST_VIDEO_FRAME_COMP_STRIDE (&iframe, i);
+      ostride = GST_VIDEO_FRAME_COMP_STRIDE (&oframe, i);
+      src = GST_VIDEO_FRAME_COMP_DATA (&iframe, i);
+      dest = GST_VIDEO_FRAME_COMP_DATA (&oframe, i);
+
+      for (j = 0; j < h; j++) {
+        memcpy (dest, src, w);
+
+        dest += ostride;
+        src += istride;
+      }
+    }
+
+    gst_video_frame_unmap (&iframe);
+    gst_video_frame_unmap (&oframe);
+    gst_buffer_copy_into (outbuf, buffer, GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+    gst_buffer_unref (buffer);
+    buffer = outbuf;
+  }
+
+  return gst_pad_push (y4mdec->srcpad, buffer);
+}
+
 static GstFlowReturn
 gst_y4m_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 {
   GstY4mDec *y4mdec;
   int n_avail;
   GstFlowReturn flow_ret = GST_FLOW_OK;
-#define MAX_HEADER_LENGTH 80
   char header[MAX_HEADER_LENGTH];
   int i;
   int len;
@@ -506,8 +673,6 @@ gst_y4m_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 
   if (!y4mdec->have_header) {
     gboolean ret;
-    GstCaps *caps;
-    GstQuery *query;
 
     if (n_avail < MAX_HEADER_LENGTH)
       return GST_FLOW_OK;
@@ -530,84 +695,8 @@ gst_y4m_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
     y4mdec->header_size = strlen (header) + 1;
     gst_adapter_flush (y4mdec->adapter, y4mdec->header_size);
 
-    caps = gst_video_info_to_caps (&y4mdec->info);
-    ret = gst_pad_set_caps (y4mdec->srcpad, caps);
-
-    query = gst_query_new_allocation (caps, FALSE);
-    y4mdec->video_meta = FALSE;
-
-    if (y4mdec->pool) {
-      gst_buffer_pool_set_active (y4mdec->pool, FALSE);
-      gst_object_unref (y4mdec->pool);
-    }
-    y4mdec->pool = NULL;
-
-    if (gst_pad_peer_query (y4mdec->srcpad, query)) {
-      y4mdec->video_meta =
-          gst_query_find_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
-
-      /* We only need a pool if we need to do stride conversion for downstream */
-      if (!y4mdec->video_meta && memcmp (&y4mdec->info, &y4mdec->out_info,
-              sizeof (y4mdec->info)) != 0) {
-        GstBufferPool *pool = NULL;
-        GstAllocator *allocator = NULL;
-        GstAllocationParams params;
-        GstStructure *config;
-        guint size, min, max;
-
-        if (gst_query_get_n_allocation_params (query) > 0) {
-          gst_query_parse_nth_allocation_param (query, 0, &allocator, &params);
-        } else {
-          allocator = NULL;
-          gst_allocation_params_init (&params);
-        }
-
-        if (gst_query_get_n_allocation_pools (query) > 0) {
-          gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min,
-              &max);
-          size = MAX (size, y4mdec->out_info.size);
-        } else {
-          pool = NULL;
-          size = y4mdec->out_info.size;
-          min = max = 0;
-        }
-
-        if (pool == NULL) {
-          pool = gst_video_buffer_pool_new ();
-        }
-
-        config = gst_buffer_pool_get_config (pool);
-        gst_buffer_pool_config_set_params (config, caps, size, min, max);
-        gst_buffer_pool_config_set_allocator (config, allocator, &params);
-        gst_buffer_pool_set_config (pool, config);
-
-        if (allocator)
-          gst_object_unref (allocator);
-
-        y4mdec->pool = pool;
-      }
-    } else if (memcmp (&y4mdec->info, &y4mdec->out_info,
-            sizeof (y4mdec->info)) != 0) {
-      GstBufferPool *pool;
-      GstStructure *config;
-
-      /* No pool, create our own if we need to do stride conversion */
-      pool = gst_video_buffer_pool_new ();
-      config = gst_buffer_pool_get_config (pool);
-      gst_buffer_pool_config_set_params (config, caps, y4mdec->out_info.size, 0,
-          0);
-      gst_buffer_pool_set_config (pool, config);
-      y4mdec->pool = pool;
-    }
-    if (y4mdec->pool) {
-      gst_buffer_pool_set_active (y4mdec->pool, TRUE);
-    }
-    gst_query_unref (query);
-    gst_caps_unref (caps);
-    if (!ret) {
-      GST_DEBUG_OBJECT (y4mdec, "Couldn't set caps on src pad");
+    if (!gst_y4m_dec_negotiate (y4mdec))
       return GST_FLOW_ERROR;
-    }
 
     y4mdec->have_header = TRUE;
   }
@@ -668,69 +757,329 @@ gst_y4m_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 
     buffer = gst_adapter_take_buffer (y4mdec->adapter, y4mdec->info.size);
 
-    GST_BUFFER_TIMESTAMP (buffer) =
-        gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->frame_index);
-    GST_BUFFER_DURATION (buffer) =
-        gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->frame_index + 1) -
-        GST_BUFFER_TIMESTAMP (buffer);
+    flow_ret = gst_y4m_dec_push_frame (y4mdec, buffer);
+    if (flow_ret != GST_FLOW_OK)
+      break;
+  }
+
+  GST_DEBUG ("returning %d", flow_ret);
 
-    y4mdec->frame_index++;
+  return flow_ret;
+}
 
-    if (y4mdec->video_meta) {
-      gst_buffer_add_video_meta_full (buffer, 0, y4mdec->info.finfo->format,
-          y4mdec->info.width, y4mdec->info.height, y4mdec->info.finfo->n_planes,
-          y4mdec->info.offset, y4mdec->info.stride);
-    } else if (memcmp (&y4mdec->info, &y4mdec->out_info,
-            sizeof (y4mdec->info)) != 0) {
-      GstBuffer *outbuf;
-      GstVideoFrame iframe, oframe;
-      gint i, j;
-      gint w, h, istride, ostride;
-      guint8 *src, *dest;
-
-      /* Allocate a new buffer and do stride conversion */
-      g_assert (y4mdec->pool != NULL);
-
-      flow_ret = gst_buffer_pool_acquire_buffer (y4mdec->pool, &outbuf, NULL);
-      if (flow_ret != GST_FLOW_OK) {
-        gst_buffer_unref (buffer);
-        break;
-      }
+static gboolean
+gst_y4m_dec_sink_activate (GstPad * pad, GstObject * parent)
+{
+  GstQuery *query;
+  gboolean pull_mode;
+
+  query = gst_query_new_scheduling ();
+
+  if (!gst_pad_peer_query (pad, query)) {
+    gst_query_unref (query);
+    goto activate_push;
+  }
 
-      gst_video_frame_map (&iframe, &y4mdec->info, buffer, GST_MAP_READ);
-      gst_video_frame_map (&oframe, &y4mdec->out_info, outbuf, GST_MAP_WRITE);
+  pull_mode = gst_query_has_scheduling_mode_with_flags (query,
+      GST_PAD_MODE_PULL, GST_SCHEDULING_FLAG_SEEKABLE);
+  gst_query_unref (query);
 
-      for (i = 0; i < 3; i++) {
-        w = GST_VIDEO_FRAME_COMP_WIDTH (&iframe, i);
-        h = GST_VIDEO_FRAME_COMP_HEIGHT (&iframe, i);
-        istride = GST_VIDEO_FRAME_COMP_STRIDE (&iframe, i);
-        ostride = GST_VIDEO_FRAME_COMP_STRIDE (&oframe, i);
-        src = GST_VIDEO_FRAME_COMP_DATA (&iframe, i);
-        dest = GST_VIDEO_FRAME_COMP_DATA (&oframe, i);
+  if (!pull_mode)
+    goto activate_push;
 
-        for (j = 0; j < h; j++) {
-          memcpy (dest, src, w);
+  GST_DEBUG_OBJECT (pad, "activating pull");
+  return gst_pad_activate_mode (pad, GST_PAD_MODE_PULL, TRUE);
 
-          dest += ostride;
-          src += istride;
-        }
+activate_push:
+  {
+    GST_DEBUG_OBJECT (pad, "activating push");
+    return gst_pad_activate_mode (pad, GST_PAD_MODE_PUSH, TRUE);
+  }
+}
+
+static gboolean
+gst_y4m_dec_sink_activate_mode (GstPad * pad, GstObject * parent,
+    GstPadMode mode, gboolean active)
+{
+  GstY4mDec *y4mdec = GST_Y4M_DEC (parent);
+
+  switch (mode) {
+    case GST_PAD_MODE_PUSH:
+      return TRUE;
+    case GST_PAD_MODE_PULL:
+      if (active) {
+        /* we produce a time segment ourselves */
+        gst_segment_init (&y4mdec->segment, GST_FORMAT_TIME);
+        y4mdec->have_new_segment = TRUE;
+        y4mdec->seqnum = gst_util_seqnum_next ();
+        return gst_pad_start_task (pad, (GstTaskFunction) gst_y4m_dec_loop,
+            pad, NULL);
       }
+      return gst_pad_stop_task (pad);
+    default:
+      return FALSE;
+  }
+}
 
-      gst_video_frame_unmap (&iframe);
-      gst_video_frame_unmap (&oframe);
-      gst_buffer_copy_into (outbuf, buffer, GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
-      gst_buffer_unref (buffer);
-      buffer = outbuf;
+static GstFlowReturn
+gst_y4m_dec_pull_header (GstY4mDec * y4mdec)
+{
+  GstBuffer *buffer = NULL;
+  GstFlowReturn flow_ret;
+  char header[MAX_HEADER_LENGTH];
+  gchar *stream_id;
+  gsize size, i;
+
+  flow_ret = gst_pad_pull_range (y4mdec->sinkpad, 0, MAX_HEADER_LENGTH,
+      &buffer);
+  if (flow_ret != GST_FLOW_OK)
+    return flow_ret;
+
+  size = gst_buffer_extract (buffer, 0, header, MAX_HEADER_LENGTH - 1);
+  gst_buffer_unref (buffer);
+
+  header[size] = 0;
+  for (i = 0; i < size; i++) {
+    if (header[i] == 0x0a)
+      header[i] = 0;
+  }
+
+  if (!gst_y4m_dec_parse_header (y4mdec, header)) {
+    GST_ELEMENT_ERROR (y4mdec, STREAM, DECODE,
+        ("Failed to parse YUV4MPEG header"), (NULL));
+    return GST_FLOW_ERROR;
+  }
+
+  y4mdec->header_size = strlen (header) + 1;
+  y4mdec->offset = gst_y4m_dec_frames_to_bytes (y4mdec, y4mdec->frame_index);
+
+  stream_id = gst_pad_create_stream_id (y4mdec->srcpad,
+      GST_ELEMENT_CAST (y4mdec), NULL);
+  gst_pad_push_event (y4mdec->srcpad, gst_event_new_stream_start (stream_id));
+  g_free (stream_id);
+
+  if (!gst_y4m_dec_negotiate (y4mdec))
+    return GST_FLOW_NOT_NEGOTIATED;
+
+  y4mdec->have_header = TRUE;
+
+  return GST_FLOW_OK;
+}
+
+/* Pull mode: every frame is read with a single pull_range covering the
+ * frame header and the planes, and the planes are pushed as a sub-buffer
+ * of it, so the data is never copied in the common case */
+static void
+gst_y4m_dec_loop (GstPad * pad)
+{
+  GstY4mDec *y4mdec = GST_Y4M_DEC (GST_PAD_PARENT (pad));
+  GstFlowReturn flow_ret;
+  GstBuffer *buffer = NULL;
+  GstBuffer *outbuf;
+  GstMapInfo map;
+  guint8 *nl = NULL;
+  gsize len;
+
+  if (!y4mdec->have_header) {
+    flow_ret = gst_y4m_dec_pull_header (y4mdec);
+    if (flow_ret != GST_FLOW_OK)
+      goto pause;
+  }
+
+  if (y4mdec->have_new_segment) {
+    GstEvent *event;
+
+    event = gst_event_new_segment (&y4mdec->segment);
+    gst_event_set_seqnum (event, y4mdec->seqnum);
+    gst_pad_push_event (y4mdec->srcpad, event);
+
+    y4mdec->have_new_segment = FALSE;
+  }
+
+  if (GST_CLOCK_TIME_IS_VALID (y4mdec->segment.stop) &&
+      gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->frame_index) >=
+      y4mdec->segment.stop) {
+    GST_DEBUG_OBJECT (y4mdec, "reached segment stop");
+    flow_ret = GST_FLOW_EOS;
+    goto pause;
+  }
+
+  /* "FRAME\n" followed by the planes, unless the frame header carries
+   * parameters, which is handled below */
+  flow_ret = gst_pad_pull_range (pad, y4mdec->offset,
+      y4mdec->info.size + 6, &buffer);
+  if (flow_ret != GST_FLOW_OK)
+    goto pause;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  if (map.size >= 6 && memcmp (map.data, "FRAME", 5) == 0)
+    nl = memchr (map.data, '\n', MIN (map.size, MAX_HEADER_LENGTH));
+  len = nl ? nl - map.data + 1 : 0;
+  gst_buffer_unmap (buffer, &map);
+
+  if (len == 0) {
+    if (gst_buffer_get_size (buffer) < 6) {
+      GST_DEBUG_OBJECT (y4mdec, "no more frames");
+      flow_ret = GST_FLOW_EOS;
+    } else {
+      GST_ELEMENT_ERROR (y4mdec, STREAM, DECODE,
+          ("Failed to parse YUV4MPEG frame"), (NULL));
+      flow_ret = GST_FLOW_ERROR;
     }
+    gst_buffer_unref (buffer);
+    goto pause;
+  }
 
-    flow_ret = gst_pad_push (y4mdec->srcpad, buffer);
+  if (len + y4mdec->info.size > gst_buffer_get_size (buffer) && len != 6) {
+    gst_buffer_unref (buffer);
+    buffer = NULL;
+
+    flow_ret = gst_pad_pull_range (pad, y4mdec->offset,
+        y4mdec->info.size + len, &buffer);
     if (flow_ret != GST_FLOW_OK)
-      break;
+      goto pause;
   }
 
-  GST_DEBUG ("returning %d", flow_ret);
+  if (len + y4mdec->info.size > gst_buffer_get_size (buffer)) {
+    GST_WARNING_OBJECT (y4mdec, "truncated frame at offset %" G_GUINT64_FORMAT,
+        y4mdec->offset);
+    gst_buffer_unref (buffer);
+    flow_ret = GST_FLOW_EOS;
+    goto pause;
+  }
 
-  return flow_ret;
+  outbuf = gst_buffer_copy_region (buffer, GST_BUFFER_COPY_MEMORY, len,
+      y4mdec->info.size);
+  gst_buffer_unref (buffer);
+
+  GST_BUFFER_OFFSET (outbuf) = y4mdec->offset + len;
+  y4mdec->offset += len + y4mdec->info.size;
+
+  flow_ret = gst_y4m_dec_push_frame (y4mdec, outbuf);
+  if (flow_ret != GST_FLOW_OK)
+    goto pause;
+
+  return;
+
+pause:
+  {
+    GST_DEBUG_OBJECT (y4mdec, "pausing task, reason %s",
+        gst_flow_get_name (flow_ret));
+    gst_pad_pause_task (pad);
+
+    if (flow_ret == GST_FLOW_EOS) {
+      if (y4mdec->segment.flags & GST_SEGMENT_FLAG_SEGMENT) {
+        GstMessage *message;
+        GstEvent *event;
+        gint64 stop = y4mdec->segment.stop;
+
+        if (stop == -1)
+          stop = gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->frame_index);
+
+        message = gst_message_new_segment_done (GST_OBJECT_CAST (y4mdec),
+            GST_FORMAT_TIME, stop);
+        gst_message_set_seqnum (message, y4mdec->seqnum);
+        gst_element_post_message (GST_ELEMENT_CAST (y4mdec), message);
+
+        event = gst_event_new_segment_done (GST_FORMAT_TIME, stop);
+        gst_event_set_seqnum (event, y4mdec->seqnum);
+        gst_pad_push_event (y4mdec->srcpad, event);
+      } else {
+        GstEvent *event = gst_event_new_eos ();
+
+        gst_event_set_seqnum (event, y4mdec->seqnum);
+        gst_pad_push_event (y4mdec->srcpad, event);
+      }
+    } else if (flow_ret == GST_FLOW_NOT_LINKED || flow_ret < GST_FLOW_EOS) {
+      GstEvent *event = gst_event_new_eos ();
+
+      /* errors we detected ourselves have already been posted */
+      if (flow_ret != GST_FLOW_ERROR)
+        GST_ELEMENT_FLOW_ERROR (y4mdec, flow_ret);
+
+      gst_event_set_seqnum (event, y4mdec->seqnum);
+      gst_pad_push_event (y4mdec->srcpad, event);
+    }
+  }
+}
+
+/* Seeking in pull mode: Y4M frames have a fixed size, so the byte offset
+ * of any frame can be computed directly from its index */
+static gboolean
+gst_y4m_dec_do_seek (GstY4mDec * y4mdec, GstEvent * event)
+{
+  gdouble rate;
+  GstFormat format;
+  GstSeekFlags flags;
+  GstSeekType start_type, stop_type;
+  gint64 start, stop;
+  gint64 framenum;
+  gboolean flush;
+  GstSegment seg;
+  guint32 seqnum;
+
+  if (!y4mdec->have_header) {
+    GST_DEBUG_OBJECT (y4mdec, "no header yet, can't seek");
+    return FALSE;
+  }
+
+  gst_event_parse_seek (event, &rate, &format, &flags, &start_type,
+      &start, &stop_type, &stop);
+
+  if (format != GST_FORMAT_TIME || rate <= 0.0) {
+    GST_DEBUG_OBJECT (y4mdec, "only forward seeks in time are supported");
+    return FALSE;
+  }
+
+  seqnum = gst_event_get_seqnum (event);
+  flush = !!(flags & GST_SEEK_FLAG_FLUSH);
+
+  if (flush) {
+    GstEvent *flush_event = gst_event_new_flush_start ();
+
+    gst_event_set_seqnum (flush_event, seqnum);
+    gst_pad_push_event (y4mdec->srcpad, flush_event);
+  } else {
+    gst_pad_pause_task (y4mdec->sinkpad);
+  }
+
+  GST_PAD_STREAM_LOCK (y4mdec->sinkpad);
+
+  seg = y4mdec->segment;
+  gst_segment_do_seek (&seg, rate, format, flags, start_type, start,
+      stop_type, stop, NULL);
+
+  framenum = gst_y4m_dec_timestamp_to_frames (y4mdec, seg.start);
+  GST_DEBUG_OBJECT (y4mdec, "seeking to frame %" G_GINT64_FORMAT, framenum);
+
+  if (flush) {
+    GstEvent *flush_event = gst_event_new_flush_stop (TRUE);
+
+    gst_event_set_seqnum (flush_event, seqnum);
+    gst_pad_push_event (y4mdec->srcpad, flush_event);
+  }
+
+  y4mdec->segment = seg;
+  y4mdec->frame_index = framenum;
+  y4mdec->offset = gst_y4m_dec_frames_to_bytes (y4mdec, framenum);
+  y4mdec->have_new_segment = TRUE;
+  y4mdec->seqnum = seqnum;
+
+  if (flags & GST_SEEK_FLAG_SEGMENT) {
+    GstMessage *message;
+
+    message = gst_message_new_segment_start (GST_OBJECT_CAST (y4mdec),
+        GST_FORMAT_TIME, seg.start);
+    gst_message_set_seqnum (message, seqnum);
+    gst_element_post_message (GST_ELEMENT_CAST (y4mdec), message);
+  }
+
+  gst_pad_start_task (y4mdec->sinkpad, (GstTaskFunction) gst_y4m_dec_loop,
+      y4mdec->sinkpad, NULL);
+
+  GST_PAD_STREAM_UNLOCK (y4mdec->sinkpad);
+
+  return TRUE;
 }
 
 static gboolean
@@ -800,6 +1149,12 @@ gst_y4m_dec_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
       gint64 framenum;
       guint64 byte;
 
+      if (GST_PAD_MODE (y4mdec->sinkpad) == GST_PAD_MODE_PULL) {
+        res = gst_y4m_dec_do_seek (y4mdec, event);
+        gst_event_unref (event);
+        break;
+      }
+
       gst_event_parse_seek (event, &rate, &format, &flags, &start_type,
           &start, &stop_type, &stop);
 
@@ -882,6 +1237,21 @@ gst_y4m_dec_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
       gst_query_unref (peer_query);
       break;
     }
+    case GST_QUERY_SEEKING:
+    {
+      GstFormat format;
+
+      gst_query_parse_seeking (query, &format, NULL, NULL, NULL);
+
+      if (GST_PAD_MODE (y4mdec->sinkpad) != GST_PAD_MODE_PULL) {
+        res = gst_pad_query_default (pad, parent, query);
+        break;
+      }
+
+      gst_query_set_seeking (query, format, format == GST_FORMAT_TIME, 0, -1);
+      res = TRUE;
+      break;
+    }
     default:
       res = gst_pad_query_default (pad, parent, query);
       break;
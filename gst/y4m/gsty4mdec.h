@@ -54,6 +54,10 @@ struct _GstY4mDec
   GstVideoInfo out_info;
   gboolean video_meta;
   GstBufferPool *pool;
+
+  /* pull mode */
+  guint64 offset;
+  guint32 seqnum;
 };
 
 struct _GstY4mDecClass
@@ -54,6 +54,7 @@ GstAmcCodec * gst_amc_codec_new (const gchar *name, gboolean is_encoder, GError
 void gst_amc_codec_free (GstAmcCodec * codec);
 
 gboolean gst_amc_codec_configure (GstAmcCodec * codec, GstAmcFormat * format, GstAmcSurfaceTexture * surface_texture, GError **err);
+gboolean gst_amc_codec_configure_with_input_surface (GstAmcCodec * codec, GstAmcFormat * format, GstAmcCodec * encoder, GError **err);
 GstAmcFormat * gst_amc_codec_get_output_format (GstAmcCodec * codec, GError **err);
 
 gboolean gst_amc_codec_start (GstAmcCodec * codec, GError **err);
@@ -63,6 +64,9 @@ gboolean gst_amc_codec_release (GstAmcCodec * codec, GError **err);
 gboolean gst_amc_codec_request_key_frame (GstAmcCodec * codec, GError **err);
 gboolean gst_amc_codec_have_dynamic_bitrate (void);
 gboolean gst_amc_codec_set_dynamic_bitrate (GstAmcCodec * codec, GError **err, gint bitrate);
+gboolean gst_amc_codec_have_input_surface (void);
+gboolean gst_amc_codec_create_input_surface (GstAmcCodec * codec, GError **err);
+gboolean gst_amc_codec_signal_end_of_input_stream (GstAmcCodec * codec, GError **err);
 
 GstAmcBuffer * gst_amc_codec_get_output_buffer (GstAmcCodec * codec, gint index, GError **err);
 GstAmcBuffer * gst_amc_codec_get_input_buffer (GstAmcCodec * codec, gint index, GError **err);
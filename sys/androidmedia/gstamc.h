@@ -102,6 +102,15 @@ gboolean gst_amc_audio_channel_mask_to_positions (guint32 channel_mask, gint cha
 guint32 gst_amc_audio_channel_mask_from_positions (GstAudioChannelPosition *positions, gint channels);
 void gst_amc_codec_info_to_caps (const GstAmcCodecInfo * codec_info, GstCaps **sink_caps, GstCaps **src_caps);
 
+/* Negotiated between amcvideodec and amcvideoenc when the decoder renders
+ * directly into the input surface of the encoder. Buffers with this caps
+ * feature carry no data, only the timing and flags of each frame */
+#define GST_CAPS_FEATURE_MEMORY_AMC_SURFACE "memory:AMCSurface"
+
+/* Name of the custom query structure the decoder uses to get the encoder's
+ * codec in that case, returned in the "codec" field as a pointer */
+#define GST_AMC_INPUT_SURFACE_QUERY "GstAmcInputSurfaceQuery"
+
 #define GST_ELEMENT_ERROR_FROM_ERROR(el, err) G_STMT_START {            \
   gchar *__dbg;                                                         \
   g_assert (err != NULL);                                               \
@@ -354,6 +354,12 @@ gst_amc_video_dec_base_init (gpointer g_class)
       gst_caps_from_string ("video/x-raw(" GST_CAPS_FEATURE_MEMORY_GL_MEMORY
       "), format = (string) RGBA, texture-target = (string) external-oes");
 
+  /* Direct rendering into the input surface of amcvideoenc */
+  if (gst_amc_codec_have_input_surface ())
+    all_src_caps = gst_caps_merge (gst_caps_from_string ("video/x-raw("
+            GST_CAPS_FEATURE_MEMORY_AMC_SURFACE "), format = (string) RGBA"),
+        all_src_caps);
+
   if (codec_info->gl_output_only) {
     gst_caps_unref (src_caps);
   } else {
@@ -503,6 +509,7 @@ gst_amc_video_dec_close (GstVideoDecoder * decoder)
   self->started = FALSE;
   self->flushing = TRUE;
   self->downstream_supports_gl = FALSE;
+  self->downstream_supports_amc_surface = FALSE;
 
   self->codec = NULL;
   self->codec_config = AMC_CODEC_CONFIG_NONE;
@@ -723,7 +730,10 @@ gst_amc_video_dec_check_codec_config (GstAmcVideoDec * self)
       || (self->codec_config == AMC_CODEC_CONFIG_WITH_SURFACE
           && self->downstream_supports_gl)
       || (self->codec_config == AMC_CODEC_CONFIG_WITHOUT_SURFACE
-          && !self->downstream_supports_gl));
+          && !self->downstream_supports_gl
+          && !self->downstream_supports_amc_surface)
+      || (self->codec_config == AMC_CODEC_CONFIG_WITH_ENCODER_SURFACE
+          && self->downstream_supports_amc_surface));
 
   if (!ret) {
     GST_ERROR_OBJECT
@@ -779,7 +789,8 @@ gst_amc_video_dec_set_src_caps (GstAmcVideoDec * self, GstAmcFormat * format)
     return FALSE;
   }
 
-  if (self->codec_config == AMC_CODEC_CONFIG_WITH_SURFACE) {
+  if (self->codec_config == AMC_CODEC_CONFIG_WITH_SURFACE
+      || self->codec_config == AMC_CODEC_CONFIG_WITH_ENCODER_SURFACE) {
     gst_format = GST_VIDEO_FORMAT_RGBA;
   } else {
     gst_format =
@@ -802,15 +813,22 @@ gst_amc_video_dec_set_src_caps (GstAmcVideoDec * self, GstAmcFormat * format)
   }
 
   memset (&self->color_format_info, 0, sizeof (self->color_format_info));
-  if (self->codec_config == AMC_CODEC_CONFIG_WITH_SURFACE) {
+  if (self->codec_config == AMC_CODEC_CONFIG_WITH_SURFACE
+      || self->codec_config == AMC_CODEC_CONFIG_WITH_ENCODER_SURFACE) {
     if (output_state->caps)
       gst_caps_unref (output_state->caps);
     output_state->caps = gst_video_info_to_caps (&output_state->info);
-    gst_caps_set_features (output_state->caps, 0,
-        gst_caps_features_new (GST_CAPS_FEATURE_MEMORY_GL_MEMORY, NULL));
-    gst_caps_set_simple (output_state->caps, "texture-target", G_TYPE_STRING,
-        "external-oes", NULL);
-    GST_DEBUG_OBJECT (self, "Configuring for Surface output");
+    if (self->codec_config == AMC_CODEC_CONFIG_WITH_ENCODER_SURFACE) {
+      gst_caps_set_features (output_state->caps, 0,
+          gst_caps_features_new (GST_CAPS_FEATURE_MEMORY_AMC_SURFACE, NULL));
+      GST_DEBUG_OBJECT (self, "Configuring for encoder Surface output");
+    } else {
+      gst_caps_set_features (output_state->caps, 0,
+          gst_caps_features_new (GST_CAPS_FEATURE_MEMORY_GL_MEMORY, NULL));
+      gst_caps_set_simple (output_state->caps, "texture-target",
+          G_TYPE_STRING, "external-oes", NULL);
+      GST_DEBUG_OBJECT (self, "Configuring for Surface output");
+    }
 
     /* The width/height values are used in other places for
      * checking if the resolution changed. Set everything
@@ -1374,7 +1392,7 @@ retry:
     goto failed_to_get_output_buffer;
   }
 
-  if (self->codec_config != AMC_CODEC_CONFIG_WITH_SURFACE && !buf)
+  if (self->codec_config == AMC_CODEC_CONFIG_WITHOUT_SURFACE && !buf)
     goto got_null_output_buffer;
 
   frame =
@@ -1485,6 +1503,25 @@ retry:
     frame->output_buffer = outbuf;
     flow_ret = gst_video_decoder_finish_frame (GST_VIDEO_DECODER (self), frame);
 
+    release_buffer = FALSE;
+  } else if (frame
+      && self->codec_config == AMC_CODEC_CONFIG_WITH_ENCODER_SURFACE) {
+    /* Let the encoder know about the frame before it arrives on its
+     * input surface, the buffer itself only carries the timing */
+    frame->output_buffer = gst_buffer_new ();
+    flow_ret = gst_video_decoder_finish_frame (GST_VIDEO_DECODER (self), frame);
+
+    if (!gst_amc_codec_release_output_buffer (self->codec, idx,
+            flow_ret == GST_FLOW_OK, &err)) {
+      if (buf)
+        gst_amc_buffer_free (buf);
+      if (self->flushing) {
+        g_clear_error (&err);
+        goto flushing;
+      }
+      goto failed_release;
+    }
+
     release_buffer = FALSE;
   } else if (self->codec_config == AMC_CODEC_CONFIG_WITHOUT_SURFACE && !frame
       && buffer_info.size > 0) {
@@ -1782,6 +1819,74 @@ gst_amc_video_dec_stop (GstVideoDecoder * decoder)
   return TRUE;
 }
 
+/* If downstream is an amcvideoenc that accepts our output on its input
+ * surface, negotiate with it and return its codec so that frames can be
+ * rendered into that surface directly */
+static GstAmcCodec *
+gst_amc_video_dec_negotiate_encoder_surface (GstAmcVideoDec * self,
+    GstVideoCodecState * state)
+{
+  GstVideoDecoder *decoder = GST_VIDEO_DECODER (self);
+  GstPad *src_pad = GST_VIDEO_DECODER_SRC_PAD (decoder);
+  GstStaticCaps static_caps =
+      GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE_WITH_FEATURES
+      (GST_CAPS_FEATURE_MEMORY_AMC_SURFACE, "RGBA"));
+  GstCaps *surface_caps, *peer_caps;
+  GstVideoCodecState *output_state;
+  GstQuery *query;
+  const GValue *value;
+  GstAmcCodec *encoder = NULL;
+  gboolean supported;
+
+  if (!gst_amc_codec_have_input_surface ())
+    return NULL;
+
+  surface_caps = gst_static_caps_get (&static_caps);
+  peer_caps = gst_pad_peer_query_caps (src_pad, surface_caps);
+  gst_caps_unref (surface_caps);
+
+  supported = peer_caps && !gst_caps_is_empty (peer_caps);
+  if (peer_caps)
+    gst_caps_unref (peer_caps);
+
+  if (!supported)
+    return NULL;
+
+  output_state =
+      gst_video_decoder_set_output_state (decoder, GST_VIDEO_FORMAT_RGBA,
+      state->info.width, state->info.height, state);
+  if (output_state->caps)
+    gst_caps_unref (output_state->caps);
+  output_state->caps = gst_video_info_to_caps (&output_state->info);
+  gst_caps_set_features (output_state->caps, 0,
+      gst_caps_features_new (GST_CAPS_FEATURE_MEMORY_AMC_SURFACE, NULL));
+  gst_video_codec_state_unref (output_state);
+
+  /* This makes the encoder configure itself and create its input surface,
+   * gst_amc_video_dec_decide_allocation will update
+   * self->downstream_supports_amc_surface */
+  if (!gst_video_decoder_negotiate (decoder)
+      || !self->downstream_supports_amc_surface) {
+    GST_DEBUG_OBJECT (self, "Failed to negotiate encoder surface output");
+    return NULL;
+  }
+
+  query = gst_query_new_custom (GST_QUERY_CUSTOM,
+      gst_structure_new_empty (GST_AMC_INPUT_SURFACE_QUERY));
+  if (gst_pad_peer_query (src_pad, query)) {
+    value = gst_structure_get_value (gst_query_get_structure (query),
+        "codec");
+    if (value && G_VALUE_HOLDS_POINTER (value))
+      encoder = g_value_get_pointer (value);
+  }
+  gst_query_unref (query);
+
+  GST_INFO_OBJECT (self, "Encoder surface output: %s",
+      encoder ? "enabled" : "disabled");
+
+  return encoder;
+}
+
 static gboolean
 gst_amc_video_dec_set_format (GstVideoDecoder * decoder,
     GstVideoCodecState * state)
@@ -1795,6 +1900,8 @@ gst_amc_video_dec_set_format (GstVideoDecoder * decoder,
   gchar *format_string;
   guint8 *codec_data = NULL;
   gsize codec_data_size = 0;
+  GstAmcCodec *encoder;
+  gboolean configured;
   GError *err = NULL;
 
   self = GST_AMC_VIDEO_DEC (decoder);
@@ -1890,7 +1997,9 @@ gst_amc_video_dec_set_format (GstVideoDecoder * decoder,
       GST_ELEMENT_WARNING_FROM_ERROR (self, err);
   }
 
-  {
+  encoder = gst_amc_video_dec_negotiate_encoder_surface (self, state);
+
+  if (!encoder) {
     gboolean downstream_supports_gl = FALSE;
     GstVideoDecoder *decoder = GST_VIDEO_DECODER (self);
     GstPad *src_pad = GST_VIDEO_DECODER_SRC_PAD (decoder);
@@ -1980,13 +2089,16 @@ gst_amc_video_dec_set_format (GstVideoDecoder * decoder,
   GST_INFO_OBJECT (self, "GL output: %s",
       self->downstream_supports_gl ? "enabled" : "disabled");
 
-  if (klass->codec_info->gl_output_only && !self->downstream_supports_gl) {
+  if (klass->codec_info->gl_output_only && !self->downstream_supports_gl
+      && !encoder) {
     GST_ERROR_OBJECT (self,
         "Codec only supports GL output but downstream does not");
     return FALSE;
   }
 
-  if (self->downstream_supports_gl && self->surface) {
+  if (encoder) {
+    self->codec_config = AMC_CODEC_CONFIG_WITH_ENCODER_SURFACE;
+  } else if (self->downstream_supports_gl && self->surface) {
     self->codec_config = AMC_CODEC_CONFIG_WITH_SURFACE;
   } else if (self->downstream_supports_gl && !self->surface) {
     int ret = TRUE;
@@ -2021,7 +2133,14 @@ gst_amc_video_dec_set_format (GstVideoDecoder * decoder,
       GST_STR_NULL (format_string));
   g_free (format_string);
 
-  if (!gst_amc_codec_configure (self->codec, format, self->surface, &err)) {
+  if (self->codec_config == AMC_CODEC_CONFIG_WITH_ENCODER_SURFACE)
+    configured = gst_amc_codec_configure_with_input_surface (self->codec,
+        format, encoder, &err);
+  else
+    configured = gst_amc_codec_configure (self->codec, format, self->surface,
+        &err);
+
+  if (!configured) {
     GST_ERROR_OBJECT (self, "Failed to configure codec");
     GST_ELEMENT_ERROR_FROM_ERROR (self, err);
     return FALSE;
@@ -2427,6 +2546,21 @@ _caps_are_rgba_with_gl_memory (GstCaps * caps)
       GST_CAPS_FEATURE_MEMORY_GL_MEMORY);
 }
 
+static gboolean
+_caps_have_amc_surface (GstCaps * caps)
+{
+  GstCapsFeatures *features;
+
+  if (!caps || gst_caps_is_empty (caps))
+    return FALSE;
+
+  if (!(features = gst_caps_get_features (caps, 0)))
+    return FALSE;
+
+  return gst_caps_features_contains (features,
+      GST_CAPS_FEATURE_MEMORY_AMC_SURFACE);
+}
+
 static gboolean
 _find_local_gl_context (GstAmcVideoDec * self)
 {
@@ -2449,6 +2583,7 @@ gst_amc_video_dec_decide_allocation (GstVideoDecoder * bdec, GstQuery * query)
 
   self->downstream_supports_gl = FALSE;
   gst_query_parse_allocation (query, &caps, &need_pool);
+  self->downstream_supports_amc_surface = _caps_have_amc_surface (caps);
   if (_caps_are_rgba_with_gl_memory (caps)) {
 
     if (!gst_gl_ensure_element_data (self, &self->gl_display,
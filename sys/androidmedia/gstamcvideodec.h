@@ -53,6 +53,8 @@ enum _GstAmcCodecConfig
   AMC_CODEC_CONFIG_NONE,
   AMC_CODEC_CONFIG_WITH_SURFACE,
   AMC_CODEC_CONFIG_WITHOUT_SURFACE,
+  /* Rendering into the input surface of a downstream amcvideoenc */
+  AMC_CODEC_CONFIG_WITH_ENCODER_SURFACE,
 };
 
 struct _GstAmcVideoDec
@@ -98,6 +100,7 @@ struct _GstAmcVideoDec
   GstGLContext *other_gl_context;
 
   gboolean downstream_supports_gl;
+  gboolean downstream_supports_amc_surface;
   GstFlowReturn downstream_flow_ret;
 
   gboolean gl_mem_attached;
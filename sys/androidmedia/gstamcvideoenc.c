@@ -90,6 +90,8 @@ static gboolean gst_amc_video_enc_flush (GstVideoEncoder * encoder);
 static GstFlowReturn gst_amc_video_enc_handle_frame (GstVideoEncoder * encoder,
     GstVideoCodecFrame * frame);
 static GstFlowReturn gst_amc_video_enc_finish (GstVideoEncoder * encoder);
+static gboolean gst_amc_video_enc_sink_query (GstVideoEncoder * encoder,
+    GstQuery * query);
 
 static GstFlowReturn gst_amc_video_enc_drain (GstAmcVideoEnc * self);
 
@@ -231,11 +233,16 @@ create_amc_format (GstAmcVideoEnc * encoder, GstVideoCodecState * input_state,
     return NULL;
   }
 
-  color_format =
-      gst_amc_video_format_to_color_format (klass->codec_info,
-      mime, info->finfo->format);
-  if (color_format == -1)
-    goto video_format_failed_to_convert;
+  if (encoder->use_input_surface) {
+    /* COLOR_FormatSurface */
+    color_format = COLOR_FormatAndroidOpaque;
+  } else {
+    color_format =
+        gst_amc_video_format_to_color_format (klass->codec_info,
+        mime, info->finfo->format);
+    if (color_format == -1)
+      goto video_format_failed_to_convert;
+  }
 
   gst_amc_format_set_int (format, "bitrate", encoder->bitrate, &err);
   if (err)
@@ -244,13 +251,15 @@ create_amc_format (GstAmcVideoEnc * encoder, GstVideoCodecState * input_state,
   if (err)
     GST_ELEMENT_WARNING_FROM_ERROR (encoder, err);
   stride = GST_ROUND_UP_4 (info->width);        /* safe (?) */
-  gst_amc_format_set_int (format, "stride", stride, &err);
-  if (err)
-    GST_ELEMENT_WARNING_FROM_ERROR (encoder, err);
   slice_height = info->height;
-  gst_amc_format_set_int (format, "slice-height", slice_height, &err);
-  if (err)
-    GST_ELEMENT_WARNING_FROM_ERROR (encoder, err);
+  if (!encoder->use_input_surface) {
+    gst_amc_format_set_int (format, "stride", stride, &err);
+    if (err)
+      GST_ELEMENT_WARNING_FROM_ERROR (encoder, err);
+    gst_amc_format_set_int (format, "slice-height", slice_height, &err);
+    if (err)
+      GST_ELEMENT_WARNING_FROM_ERROR (encoder, err);
+  }
 
   if (profile_string) {
     if (amc_profile.id == -1)
@@ -294,7 +303,15 @@ create_amc_format (GstAmcVideoEnc * encoder, GstVideoCodecState * input_state,
     GST_ELEMENT_WARNING_FROM_ERROR (encoder, err);
 
   encoder->format = info->finfo->format;
-  if (!gst_amc_color_format_info_set (&encoder->color_format_info,
+  if (encoder->use_input_surface) {
+    /* There is no memory layout to describe, only keep what is needed to
+     * detect format changes */
+    memset (&encoder->color_format_info, 0,
+        sizeof (encoder->color_format_info));
+    encoder->color_format_info.color_format = color_format;
+    encoder->color_format_info.width = info->width;
+    encoder->color_format_info.height = info->height;
+  } else if (!gst_amc_color_format_info_set (&encoder->color_format_info,
           klass->codec_info, mime, color_format, info->width, info->height,
           stride, slice_height, 0, 0, 0, 0))
     goto color_format_info_failed_to_set;
@@ -461,6 +478,18 @@ gst_amc_video_enc_base_init (gpointer g_class)
   videoenc_class->codec_info = codec_info;
 
   gst_amc_codec_info_to_caps (codec_info, &sink_caps, &src_caps);
+
+  /* Allow amcvideodec to render directly into our input surface */
+  if (gst_amc_codec_have_input_surface () && !gst_caps_is_empty (sink_caps)) {
+    GstCaps *surface_caps;
+
+    surface_caps = gst_caps_copy (sink_caps);
+    gst_caps_set_features_simple (surface_caps,
+        gst_caps_features_new (GST_CAPS_FEATURE_MEMORY_AMC_SURFACE, NULL));
+    gst_caps_set_simple (surface_caps, "format", G_TYPE_STRING, "RGBA", NULL);
+    sink_caps = gst_caps_merge (sink_caps, surface_caps);
+  }
+
   /* Add pad templates */
   templ =
       gst_pad_template_new ("sink", GST_PAD_SINK, GST_PAD_ALWAYS, sink_caps);
@@ -593,6 +622,7 @@ gst_amc_video_enc_class_init (GstAmcVideoEncClass * klass)
   videoenc_class->handle_frame =
       GST_DEBUG_FUNCPTR (gst_amc_video_enc_handle_frame);
   videoenc_class->finish = GST_DEBUG_FUNCPTR (gst_amc_video_enc_finish);
+  videoenc_class->sink_query = GST_DEBUG_FUNCPTR (gst_amc_video_enc_sink_query);
 
   // On Android >= 19, we can set bitrate dynamically
   // so add the flag so apps can detect it.
@@ -1312,6 +1342,7 @@ gst_amc_video_enc_set_format (GstVideoEncoder * encoder,
   GstCaps *allowed_caps = NULL;
   gboolean is_format_change = FALSE;
   gboolean needs_disable = FALSE;
+  gboolean use_input_surface;
   gchar *format_string;
   gboolean r = FALSE;
   GError *err = NULL;
@@ -1320,11 +1351,16 @@ gst_amc_video_enc_set_format (GstVideoEncoder * encoder,
 
   GST_DEBUG_OBJECT (self, "Setting new caps %" GST_PTR_FORMAT, state->caps);
 
+  use_input_surface =
+      gst_caps_features_contains (gst_caps_get_features (state->caps, 0),
+      GST_CAPS_FEATURE_MEMORY_AMC_SURFACE);
+
   /* Check if the caps change is a real format change or if only irrelevant
    * parts of the caps have changed or nothing at all.
    */
   is_format_change |= self->color_format_info.width != state->info.width;
   is_format_change |= self->color_format_info.height != state->info.height;
+  is_format_change |= self->use_input_surface != use_input_surface;
   needs_disable = self->started;
 
   /* If the component is not started and a real format change happens
@@ -1372,6 +1408,7 @@ gst_amc_video_enc_set_format (GstVideoEncoder * encoder,
   GST_DEBUG_OBJECT (self, "chose caps %" GST_PTR_FORMAT, allowed_caps);
   allowed_caps = gst_caps_truncate (allowed_caps);
 
+  self->use_input_surface = use_input_surface;
   format = create_amc_format (self, state, allowed_caps);
   if (!format)
     goto quit;
@@ -1389,6 +1426,13 @@ gst_amc_video_enc_set_format (GstVideoEncoder * encoder,
     goto quit;
   }
 
+  if (self->use_input_surface &&
+      !gst_amc_codec_create_input_surface (self->codec, &err)) {
+    GST_ERROR_OBJECT (self, "Failed to create input surface");
+    GST_ELEMENT_ERROR_FROM_ERROR (self, err);
+    goto quit;
+  }
+
   if (!gst_amc_codec_start (self->codec, &err)) {
     GST_ERROR_OBJECT (self, "Failed to start codec");
     GST_ELEMENT_ERROR_FROM_ERROR (self, err);
@@ -1502,6 +1546,26 @@ gst_amc_video_enc_handle_frame (GstVideoEncoder * encoder,
     }
   }
 
+  if (self->use_input_surface) {
+    /* The frame was already rendered into our input surface by upstream,
+     * the buffer only carries its timing. Keep track of it so that _loop()
+     * can match it with the encoded output */
+    if (timestamp != GST_CLOCK_TIME_NONE)
+      self->last_upstream_ts = timestamp;
+    if (duration != GST_CLOCK_TIME_NONE)
+      self->last_upstream_ts += duration;
+
+    id = buffer_identification_new (timestamp);
+    gst_video_codec_frame_set_user_data (frame, id,
+        (GDestroyNotify) buffer_identification_free);
+
+    self->drained = FALSE;
+
+    gst_video_codec_frame_unref (frame);
+
+    return self->downstream_flow_ret;
+  }
+
 again:
   /* Make sure to release the base class stream lock, otherwise
    * _loop() can't call _finish_frame() and we might block forever
@@ -1662,6 +1726,34 @@ flushing:
   }
 }
 
+static gboolean
+gst_amc_video_enc_sink_query (GstVideoEncoder * encoder, GstQuery * query)
+{
+  GstAmcVideoEnc *self = GST_AMC_VIDEO_ENC (encoder);
+
+  if (GST_QUERY_TYPE (query) == GST_QUERY_CUSTOM) {
+    GstStructure *s = gst_query_writable_structure (query);
+
+    if (gst_structure_has_name (s, GST_AMC_INPUT_SURFACE_QUERY)) {
+      gboolean ret = FALSE;
+
+      /* The codec stays valid until the next caps change, which is
+       * triggered by the querying decoder itself */
+      g_mutex_lock (&self->codec_lock);
+      if (self->codec && self->started && self->use_input_surface) {
+        gst_structure_set (s, "codec", G_TYPE_POINTER, self->codec, NULL);
+        ret = TRUE;
+      }
+      g_mutex_unlock (&self->codec_lock);
+
+      GST_DEBUG_OBJECT (self, "Input surface query: %d", ret);
+      return ret;
+    }
+  }
+
+  return GST_VIDEO_ENCODER_CLASS (parent_class)->sink_query (encoder, query);
+}
+
 static GstFlowReturn
 gst_amc_video_enc_finish (GstVideoEncoder * encoder)
 {
@@ -1691,6 +1783,37 @@ gst_amc_video_enc_drain (GstAmcVideoEnc * self)
     return GST_FLOW_OK;
   }
 
+  if (self->use_input_surface) {
+    /* There are no input buffers, the codec produces the EOS buffer
+     * on the output port after the last frame of the surface */
+    GST_VIDEO_ENCODER_STREAM_UNLOCK (self);
+    g_mutex_lock (&self->drain_lock);
+    self->draining = TRUE;
+
+    if (gst_amc_codec_signal_end_of_input_stream (self->codec, &err)) {
+      GST_DEBUG_OBJECT (self, "Waiting until codec is drained");
+      g_cond_wait (&self->drain_cond, &self->drain_lock);
+      GST_DEBUG_OBJECT (self, "Drained codec");
+      ret = GST_FLOW_OK;
+    } else {
+      GST_ERROR_OBJECT (self, "Failed to signal end of input stream");
+      if (self->flushing) {
+        g_clear_error (&err);
+        ret = GST_FLOW_FLUSHING;
+      } else {
+        GST_ELEMENT_WARNING_FROM_ERROR (self, err);
+        ret = GST_FLOW_ERROR;
+      }
+    }
+
+    self->drained = TRUE;
+    self->draining = FALSE;
+    g_mutex_unlock (&self->drain_lock);
+    GST_VIDEO_ENCODER_STREAM_LOCK (self);
+
+    return ret;
+  }
+
   /* Make sure to release the base class stream lock, otherwise
    * _loop() can't call _finish_frame() and we might block forever
    * because no input buffers are released */
@@ -62,6 +62,10 @@ struct _GstAmcVideoEnc
   GstVideoFormat format;
   GstAmcColorFormatInfo color_format_info;
 
+  /* TRUE if upstream renders into the input surface of the codec
+   * instead of passing raw frames */
+  gboolean use_input_surface;
+
   guint bitrate;
   gfloat i_frame_int;
 
@@ -40,6 +40,7 @@ struct _GstAmcCodec
   RealBuffer *input_buffers, *output_buffers;
   gsize n_input_buffers, n_output_buffers;
   GstAmcSurface *surface;
+  jobject input_surface;        /* global reference */
   gboolean is_encoder;
 };
 
@@ -62,6 +63,8 @@ static struct
   jmethodID start;
   jmethodID stop;
   jmethodID setParameters;
+  jmethodID create_input_surface;
+  jmethodID signal_end_of_input_stream;
 } media_codec;
 
 static struct
@@ -280,6 +283,20 @@ gst_amc_codec_static_init (void)
   if ((*env)->ExceptionCheck (env))
     (*env)->ExceptionClear (env);
 
+  /* Android >= 18 */
+  media_codec.create_input_surface =
+      (*env)->GetMethodID (env, media_codec.klass, "createInputSurface",
+      "()Landroid/view/Surface;");
+  if ((*env)->ExceptionCheck (env))
+    (*env)->ExceptionClear (env);
+
+  /* Android >= 18 */
+  media_codec.signal_end_of_input_stream =
+      (*env)->GetMethodID (env, media_codec.klass, "signalEndOfInputStream",
+      "()V");
+  if ((*env)->ExceptionCheck (env))
+    (*env)->ExceptionClear (env);
+
   /* Android >= 21 */
   media_codec.get_output_buffer =
       (*env)->GetMethodID (env, media_codec.klass, "getOutputBuffer",
@@ -567,6 +584,10 @@ gst_amc_codec_free (GstAmcCodec * codec)
 
   g_clear_object (&codec->surface);
 
+  if (codec->input_surface)
+    gst_amc_jni_object_unref (env, codec->input_surface);
+  codec->input_surface = NULL;
+
   gst_amc_jni_object_unref (env, codec->object);
   g_slice_free (GstAmcCodec, codec);
 }
@@ -601,6 +622,88 @@ gst_amc_codec_configure (GstAmcCodec * codec, GstAmcFormat * format,
       codec->surface ? codec->surface->jobject : NULL, NULL, flags);
 }
 
+gboolean
+gst_amc_codec_configure_with_input_surface (GstAmcCodec * codec,
+    GstAmcFormat * format, GstAmcCodec * encoder, GError ** err)
+{
+  JNIEnv *env;
+
+  g_return_val_if_fail (codec != NULL, FALSE);
+  g_return_val_if_fail (format != NULL, FALSE);
+  g_return_val_if_fail (encoder != NULL, FALSE);
+  g_return_val_if_fail (!codec->is_encoder && encoder->is_encoder, FALSE);
+
+  if (!encoder->input_surface) {
+    g_set_error (err, GST_LIBRARY_ERROR, GST_LIBRARY_ERROR_SETTINGS,
+        "Encoder has no input surface");
+    return FALSE;
+  }
+
+  env = gst_amc_jni_get_env ();
+  return gst_amc_jni_call_void_method (env, err, codec->object,
+      media_codec.configure, format->object, encoder->input_surface, NULL, 0);
+}
+
+gboolean
+gst_amc_codec_have_input_surface (void)
+{
+  /* Input surfaces are supported on Android >= 18 */
+  return (media_codec.create_input_surface != NULL
+      && media_codec.signal_end_of_input_stream != NULL);
+}
+
+gboolean
+gst_amc_codec_create_input_surface (GstAmcCodec * codec, GError ** err)
+{
+  JNIEnv *env;
+  jobject object = NULL;
+
+  g_return_val_if_fail (codec != NULL, FALSE);
+  g_return_val_if_fail (codec->is_encoder, FALSE);
+
+  if (!gst_amc_codec_have_input_surface ()) {
+    g_set_error (err, GST_LIBRARY_ERROR, GST_LIBRARY_ERROR_FAILED,
+        "Input surfaces are not available on this Android version");
+    return FALSE;
+  }
+
+  env = gst_amc_jni_get_env ();
+
+  if (!gst_amc_jni_call_object_method (env, err, codec->object,
+          media_codec.create_input_surface, &object))
+    return FALSE;
+
+  if (codec->input_surface)
+    gst_amc_jni_object_unref (env, codec->input_surface);
+  codec->input_surface = gst_amc_jni_object_make_global (env, object);
+  if (!codec->input_surface) {
+    gst_amc_jni_set_error (env, err, GST_LIBRARY_ERROR,
+        GST_LIBRARY_ERROR_SETTINGS,
+        "Failed to create global input surface reference");
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+gboolean
+gst_amc_codec_signal_end_of_input_stream (GstAmcCodec * codec, GError ** err)
+{
+  JNIEnv *env;
+
+  g_return_val_if_fail (codec != NULL, FALSE);
+
+  if (media_codec.signal_end_of_input_stream == NULL) {
+    g_set_error (err, GST_LIBRARY_ERROR, GST_LIBRARY_ERROR_FAILED,
+        "Input surfaces are not available on this Android version");
+    return FALSE;
+  }
+
+  env = gst_amc_jni_get_env ();
+  return gst_amc_jni_call_void_method (env, err, codec->object,
+      media_codec.signal_end_of_input_stream);
+}
+
 GstAmcFormat *
 gst_amc_codec_get_output_format (GstAmcCodec * codec, GError ** err)
 {
@@ -141,6 +141,15 @@ gst_amc_codec_get_output_format (GstAmcCodec * codec, GError ** err)
   return gst_amc_format_new_handle (format_handle);
 }
 
+gboolean
+gst_amc_codec_configure_with_input_surface (GstAmcCodec * codec,
+    GstAmcFormat * format, GstAmcCodec * encoder, GError ** err)
+{
+  g_set_error (err, GST_LIBRARY_ERROR, GST_LIBRARY_ERROR_FAILED,
+      "Input surfaces are not available on MagicLeap");
+  return FALSE;
+}
+
 gboolean
 gst_amc_codec_start (GstAmcCodec * codec, GError ** err)
 {
@@ -217,6 +226,28 @@ gst_amc_codec_have_dynamic_bitrate ()
   return FALSE;
 }
 
+gboolean
+gst_amc_codec_have_input_surface (void)
+{
+  return FALSE;
+}
+
+gboolean
+gst_amc_codec_create_input_surface (GstAmcCodec * codec, GError ** err)
+{
+  g_set_error (err, GST_LIBRARY_ERROR, GST_LIBRARY_ERROR_FAILED,
+      "Input surfaces are not available on MagicLeap");
+  return FALSE;
+}
+
+gboolean
+gst_amc_codec_signal_end_of_input_stream (GstAmcCodec * codec, GError ** err)
+{
+  g_set_error (err, GST_LIBRARY_ERROR, GST_LIBRARY_ERROR_FAILED,
+      "Input surfaces are not available on MagicLeap");
+  return FALSE;
+}
+
 gboolean
 gst_amc_codec_release (GstAmcCodec * codec, GError ** err)
 {
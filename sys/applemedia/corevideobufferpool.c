@@ -0,0 +1,142 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "corevideobufferpool.h"
+#include "corevideobuffer.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_core_video_buffer_pool_debug);
+#define GST_CAT_DEFAULT gst_core_video_buffer_pool_debug
+
+#define gst_core_video_buffer_pool_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstCoreVideoBufferPool, gst_core_video_buffer_pool,
+    GST_TYPE_BUFFER_POOL,
+    GST_DEBUG_CATEGORY_INIT (gst_core_video_buffer_pool_debug,
+        "corevideobufferpool", 0, "CoreVideo buffer pool"));
+
+static const gchar **
+gst_core_video_buffer_pool_get_options (GstBufferPool * pool)
+{
+  static const gchar *options[] = { GST_BUFFER_POOL_OPTION_VIDEO_META, NULL };
+
+  return options;
+}
+
+static gboolean
+gst_core_video_buffer_pool_set_config (GstBufferPool * pool,
+    GstStructure * config)
+{
+  GstCoreVideoBufferPool *self = GST_CORE_VIDEO_BUFFER_POOL (pool);
+  GstCaps *caps;
+
+  if (!gst_buffer_pool_config_get_params (config, &caps, NULL, NULL, NULL)
+      || !caps) {
+    GST_WARNING_OBJECT (pool, "no caps in config");
+    return FALSE;
+  }
+
+  if (!gst_video_info_from_caps (&self->info, caps)) {
+    GST_WARNING_OBJECT (pool, "failed getting video info from caps %"
+        GST_PTR_FORMAT, caps);
+    return FALSE;
+  }
+
+  return GST_BUFFER_POOL_CLASS (parent_class)->set_config (pool, config);
+}
+
+static GstFlowReturn
+gst_core_video_buffer_pool_alloc_buffer (GstBufferPool * pool,
+    GstBuffer ** buffer, GstBufferPoolAcquireParams * params)
+{
+  GstCoreVideoBufferPool *self = GST_CORE_VIDEO_BUFFER_POOL (pool);
+  CVPixelBufferRef pixbuf = NULL;
+  CVReturn cv_ret;
+
+  cv_ret = CVPixelBufferPoolCreatePixelBuffer (NULL, self->cvpool, &pixbuf);
+  if (cv_ret != kCVReturnSuccess) {
+    GST_ERROR_OBJECT (pool, "CVPixelBufferPoolCreatePixelBuffer failed: %d",
+        (int) cv_ret);
+    return GST_FLOW_ERROR;
+  }
+
+  *buffer = gst_core_video_buffer_new ((CVBufferRef) pixbuf, &self->info,
+      NULL);
+  CVPixelBufferRelease (pixbuf);
+
+  return *buffer ? GST_FLOW_OK : GST_FLOW_ERROR;
+}
+
+static void
+gst_core_video_buffer_pool_release_buffer (GstBufferPool * pool,
+    GstBuffer * buffer)
+{
+  /* The consumer may still hold on to the pixel buffer, e.g. VideoToolbox
+   * while it looks ahead, so never hand it out again from here. Dropping
+   * the buffer gives the pixel buffer back to the CVPixelBufferPool once
+   * everybody is done with it */
+  GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_TAG_MEMORY);
+
+  GST_BUFFER_POOL_CLASS (parent_class)->release_buffer (pool, buffer);
+}
+
+static void
+gst_core_video_buffer_pool_finalize (GObject * object)
+{
+  GstCoreVideoBufferPool *self = GST_CORE_VIDEO_BUFFER_POOL (object);
+
+  CVPixelBufferPoolRelease (self->cvpool);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_core_video_buffer_pool_class_init (GstCoreVideoBufferPoolClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+  GstBufferPoolClass *pool_class = (GstBufferPoolClass *) klass;
+
+  gobject_class->finalize = gst_core_video_buffer_pool_finalize;
+
+  pool_class->get_options = gst_core_video_buffer_pool_get_options;
+  pool_class->set_config = gst_core_video_buffer_pool_set_config;
+  pool_class->alloc_buffer = gst_core_video_buffer_pool_alloc_buffer;
+  pool_class->release_buffer = gst_core_video_buffer_pool_release_buffer;
+}
+
+static void
+gst_core_video_buffer_pool_init (GstCoreVideoBufferPool * self)
+{
+  gst_video_info_init (&self->info);
+}
+
+GstBufferPool *
+gst_core_video_buffer_pool_new (CVPixelBufferPoolRef cvpool)
+{
+  GstCoreVideoBufferPool *self;
+
+  g_return_val_if_fail (cvpool != NULL, NULL);
+
+  self = g_object_new (GST_TYPE_CORE_VIDEO_BUFFER_POOL, NULL);
+  self->cvpool = CVPixelBufferPoolRetain (cvpool);
+  gst_object_ref_sink (self);
+
+  return GST_BUFFER_POOL (self);
+}
@@ -25,6 +25,7 @@
 
 #include "coremediabuffer.h"
 #include "corevideobuffer.h"
+#include "corevideobufferpool.h"
 #include "vtutil.h"
 #include <gst/pbutils/codec-utils.h>
 
@@ -32,6 +33,7 @@
 #define VTENC_DEFAULT_BITRATE     0
 #define VTENC_DEFAULT_FRAME_REORDERING TRUE
 #define VTENC_DEFAULT_REALTIME FALSE
+#define VTENC_DEFAULT_LOW_LATENCY FALSE
 #define VTENC_DEFAULT_QUALITY 0.5
 #define VTENC_DEFAULT_MAX_KEYFRAME_INTERVAL 0
 #define VTENC_DEFAULT_MAX_KEYFRAME_INTERVAL_DURATION 0
@@ -60,6 +62,12 @@ CFSTR ("H264_Baseline_AutoLevel");
 const CFStringRef kVTCompressionPropertyKey_Quality = CFSTR ("Quality");
 #endif
 
+/* Only exported by the macOS 11.3 / iOS 14.5 SDKs and later. The encoder
+ * ignores encoder specification keys it doesn't know about */
+static const CFStringRef
+    gst_vtenc_encoder_specification_enable_low_latency_rate_control =
+CFSTR ("EnableLowLatencyRateControl");
+
 #ifdef HAVE_VIDEOTOOLBOX_10_9_6
 extern OSStatus
 VTCompressionSessionPrepareToEncodeFrames (VTCompressionSessionRef session)
@@ -75,7 +83,8 @@ enum
   PROP_REALTIME,
   PROP_QUALITY,
   PROP_MAX_KEYFRAME_INTERVAL,
-  PROP_MAX_KEYFRAME_INTERVAL_DURATION
+  PROP_MAX_KEYFRAME_INTERVAL_DURATION,
+  PROP_LOW_LATENCY
 };
 
 typedef struct _GstVTEncFrame GstVTEncFrame;
@@ -102,6 +111,8 @@ static GstFlowReturn gst_vtenc_handle_frame (GstVideoEncoder * enc,
     GstVideoCodecFrame * frame);
 static GstFlowReturn gst_vtenc_finish (GstVideoEncoder * enc);
 static gboolean gst_vtenc_flush (GstVideoEncoder * enc);
+static gboolean gst_vtenc_propose_allocation (GstVideoEncoder * enc,
+    GstQuery * query);
 
 static void gst_vtenc_clear_cached_caps_downstream (GstVTEnc * self);
 
@@ -219,6 +230,7 @@ gst_vtenc_class_init (GstVTEncClass * klass)
   gstvideoencoder_class->handle_frame = gst_vtenc_handle_frame;
   gstvideoencoder_class->finish = gst_vtenc_finish;
   gstvideoencoder_class->flush = gst_vtenc_flush;
+  gstvideoencoder_class->propose_allocation = gst_vtenc_propose_allocation;
 
   g_object_class_install_property (gobject_class, PROP_BITRATE,
       g_param_spec_uint ("bitrate", "Bitrate",
@@ -257,6 +269,25 @@ gst_vtenc_class_init (GstVTEncClass * klass)
           "Maximum number of nanoseconds between keyframes (0 = no limit)", 0,
           G_MAXUINT64, VTENC_DEFAULT_MAX_KEYFRAME_INTERVAL_DURATION,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * vtenc_h264:low-latency:
+   *
+   * Use the low-latency rate control of the encoder, which trades some
+   * compression efficiency for a minimal encoding delay. This implies
+   * realtime encoding without frame reordering. Only supported since
+   * macOS 11.3 and iOS 14.5, and only taken into account when the
+   * compression session is created.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_LOW_LATENCY,
+      g_param_spec_boolean ("low-latency", "Low latency",
+          "Use the low-latency rate control, implies realtime and no "
+          "frame reordering",
+          VTENC_DEFAULT_LOW_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
 }
 
 static void
@@ -274,6 +305,7 @@ gst_vtenc_init (GstVTEnc * self)
   self->latency_frames = -1;
   self->session = NULL;
   self->profile_level = NULL;
+  self->low_latency = VTENC_DEFAULT_LOW_LATENCY;
 
   self->keyframe_props =
       CFDictionaryCreate (NULL, (const void **) keyframe_props_keys,
@@ -463,6 +495,11 @@ gst_vtenc_get_property (GObject * obj, guint prop_id, GValue * value,
       g_value_set_uint64 (value,
           gst_vtenc_get_max_keyframe_interval_duration (self));
       break;
+    case PROP_LOW_LATENCY:
+      GST_OBJECT_LOCK (self);
+      g_value_set_boolean (value, self->low_latency);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
       break;
@@ -495,6 +532,11 @@ gst_vtenc_set_property (GObject * obj, guint prop_id, const GValue * value,
       gst_vtenc_set_max_keyframe_interval_duration (self,
           g_value_get_uint64 (value));
       break;
+    case PROP_LOW_LATENCY:
+      GST_OBJECT_LOCK (self);
+      self->low_latency = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
       break;
@@ -821,12 +863,77 @@ gst_vtenc_flush (GstVideoEncoder * enc)
   return (ret == GST_FLOW_OK);
 }
 
+static gboolean
+gst_vtenc_propose_allocation (GstVideoEncoder * enc, GstQuery * query)
+{
+  GstVTEnc *self = GST_VTENC_CAST (enc);
+  CVPixelBufferPoolRef cvpool = NULL;
+  GstVideoInfo info;
+  GstCaps *caps;
+
+  gst_query_parse_allocation (query, &caps, NULL);
+
+  /* Offer buffers from the compression session's own pool, those can be
+   * encoded without wrapping or copying them */
+  if (caps && gst_video_info_from_caps (&info, caps)
+      && GST_VIDEO_INFO_FORMAT (&info) ==
+      GST_VIDEO_INFO_FORMAT (&self->video_info)
+      && info.width == self->negotiated_width
+      && info.height == self->negotiated_height) {
+    GST_OBJECT_LOCK (self);
+    if (self->session)
+      cvpool = VTCompressionSessionGetPixelBufferPool (self->session);
+    if (cvpool)
+      CVPixelBufferPoolRetain (cvpool);
+    GST_OBJECT_UNLOCK (self);
+  }
+
+  if (cvpool) {
+    GstBufferPool *pool = gst_core_video_buffer_pool_new (cvpool);
+    GstStructure *config = gst_buffer_pool_get_config (pool);
+
+    gst_buffer_pool_config_set_params (config, caps, info.size, 0, 0);
+    gst_buffer_pool_config_add_option (config,
+        GST_BUFFER_POOL_OPTION_VIDEO_META);
+    if (gst_buffer_pool_set_config (pool, config)) {
+      GST_DEBUG_OBJECT (self, "proposing the compression session pool");
+      gst_query_add_allocation_pool (query, pool, info.size, 0, 0);
+    }
+    gst_object_unref (pool);
+    CVPixelBufferPoolRelease (cvpool);
+  }
+
+  return GST_VIDEO_ENCODER_CLASS (parent_class)->propose_allocation (enc,
+      query);
+}
+
+static OSType
+gst_vtenc_get_pixel_format (GstVideoFormat format)
+{
+  switch (format) {
+    case GST_VIDEO_FORMAT_I420:
+      return kCVPixelFormatType_420YpCbCr8Planar;
+    case GST_VIDEO_FORMAT_NV12:
+      return kCVPixelFormatType_420YpCbCr8BiPlanarVideoRange;
+    case GST_VIDEO_FORMAT_UYVY:
+      return kCVPixelFormatType_422YpCbCr8;
+    default:
+      return 0;
+  }
+}
+
 static VTCompressionSessionRef
 gst_vtenc_create_session (GstVTEnc * self)
 {
   VTCompressionSessionRef session = NULL;
   CFMutableDictionaryRef encoder_spec = NULL, pb_attrs;
   OSStatus status;
+  OSType pixel_format;
+  gboolean low_latency;
+
+  GST_OBJECT_LOCK (self);
+  low_latency = self->low_latency;
+  GST_OBJECT_UNLOCK (self);
 
 #if !HAVE_IOS
   const GstVTEncoderDetails *codec_details =
@@ -843,12 +950,29 @@ gst_vtenc_create_session (GstVTEnc * self)
         TRUE);
 #endif
 
+  if (low_latency) {
+    if (!encoder_spec)
+      encoder_spec =
+          CFDictionaryCreateMutable (NULL, 0, &kCFTypeDictionaryKeyCallBacks,
+          &kCFTypeDictionaryValueCallBacks);
+    gst_vtutil_dict_set_boolean (encoder_spec,
+        gst_vtenc_encoder_specification_enable_low_latency_rate_control,
+        TRUE);
+  }
+
   pb_attrs = CFDictionaryCreateMutable (NULL, 0, &kCFTypeDictionaryKeyCallBacks,
       &kCFTypeDictionaryValueCallBacks);
   gst_vtutil_dict_set_i32 (pb_attrs, kCVPixelBufferWidthKey,
       self->negotiated_width);
   gst_vtutil_dict_set_i32 (pb_attrs, kCVPixelBufferHeightKey,
       self->negotiated_height);
+  /* Make the session's pixel buffer pool match the input, so its buffers
+   * can be proposed upstream */
+  pixel_format =
+      gst_vtenc_get_pixel_format (GST_VIDEO_INFO_FORMAT (&self->video_info));
+  if (pixel_format != 0)
+    gst_vtutil_dict_set_i32 (pb_attrs, kCVPixelBufferPixelFormatTypeKey,
+        pixel_format);
 
   status = VTCompressionSessionCreate (NULL,
       self->negotiated_width, self->negotiated_height,
@@ -882,10 +1006,10 @@ gst_vtenc_create_session (GstVTEnc * self)
 
   gst_vtenc_session_configure_bitrate (self, session,
       gst_vtenc_get_bitrate (self));
-  gst_vtenc_session_configure_realtime (self, session,
+  gst_vtenc_session_configure_realtime (self, session, low_latency ||
       gst_vtenc_get_realtime (self));
   gst_vtenc_session_configure_allow_frame_reordering (self, session,
-      gst_vtenc_get_allow_frame_reordering (self));
+      !low_latency && gst_vtenc_get_allow_frame_reordering (self));
   gst_vtenc_set_quality (self, self->quality);
 
   if (self->dump_properties) {
@@ -1136,6 +1260,13 @@ gst_vtenc_encode_frame (GstVTEnc * self, GstVideoCodecFrame * frame)
   meta = gst_buffer_get_core_media_meta (frame->input_buffer);
   if (meta != NULL) {
     pbuf = gst_core_media_buffer_get_pixel_buffer (frame->input_buffer);
+  } else {
+    /* e.g. buffers from our own pool or from vtdec */
+    GstCoreVideoMeta *cvmeta =
+        gst_buffer_get_core_video_meta (frame->input_buffer);
+
+    if (cvmeta != NULL && cvmeta->pixbuf != NULL)
+      pbuf = CVPixelBufferRetain (cvmeta->pixbuf);
   }
 #ifdef HAVE_IOS
   if (pbuf == NULL) {
@@ -62,6 +62,7 @@ struct _GstVTEnc
   guint bitrate;
   gboolean allow_frame_reordering;
   gboolean realtime;
+  gboolean low_latency;
   gdouble quality;
   gint max_keyframe_interval;
   GstClockTime max_keyframe_interval_duration;
@@ -282,8 +282,10 @@ public:
     return GST_FLOW_OK;
   }
 
+  /* Appends the regions of the shared texture updated by this capture to
+   * @damage, if any */
   GstFlowReturn
-  Capture (gboolean draw_mouse)
+  Capture (gboolean draw_mouse, GArray * damage)
   {
     GstFlowReturn ret;
     bool timeout = false;
@@ -321,6 +323,26 @@ public:
       return ret;
     }
 
+    if (damage) {
+      GetDamage (shared_texture_.Get(), &output_desc_, move_count,
+          dirty_count, &frame_info, damage);
+
+      /* The pointer is drawn onto the output texture, both the previous and
+       * the new pointer regions need updating */
+      if (draw_mouse && frame_info.LastMouseUpdateTime.QuadPart != 0) {
+        D3D11_TEXTURE2D_DESC FullDesc;
+        RECT full;
+
+        shared_texture_->GetDesc(&FullDesc);
+        full.left = 0;
+        full.top = 0;
+        full.right = FullDesc.Width;
+        full.bottom = FullDesc.Height;
+        g_array_set_size (damage, 0);
+        g_array_append_val (damage, full);
+      }
+    }
+
     HRESULT hr = dupl_->ReleaseFrame ();
     if (!gst_d3d11_result (hr, device_)) {
       GST_WARNING ("Couldn't release frame");
@@ -961,6 +983,39 @@ private:
     return GST_FLOW_OK;
   }
 
+  void
+  SetDirtyRect (RECT* DestDirty, RECT* Dirty, DXGI_OUTPUT_DESC* DeskDesc,
+      INT Width, INT Height)
+  {
+    *DestDirty = *Dirty;
+
+    switch (DeskDesc->Rotation)
+    {
+      case DXGI_MODE_ROTATION_ROTATE90:
+        DestDirty->left = Width - Dirty->bottom;
+        DestDirty->top = Dirty->left;
+        DestDirty->right = Width - Dirty->top;
+        DestDirty->bottom = Dirty->right;
+        break;
+      case DXGI_MODE_ROTATION_ROTATE180:
+        DestDirty->left = Width - Dirty->right;
+        DestDirty->top = Height - Dirty->bottom;
+        DestDirty->right = Width - Dirty->left;
+        DestDirty->bottom = Height - Dirty->top;
+        break;
+      case DXGI_MODE_ROTATION_ROTATE270:
+        DestDirty->left = Dirty->top;
+        DestDirty->top = Height - Dirty->right;
+        DestDirty->right = Dirty->bottom;
+        DestDirty->bottom = Height - Dirty->left;
+        break;
+      case DXGI_MODE_ROTATION_UNSPECIFIED:
+      case DXGI_MODE_ROTATION_IDENTITY:
+      default:
+        break;
+    }
+  }
+
   void
   SetDirtyVert (VERTEX* Vertices, RECT* Dirty,
       DXGI_OUTPUT_DESC* DeskDesc, D3D11_TEXTURE2D_DESC* FullDesc,
@@ -973,17 +1028,14 @@ private:
     INT Height = FullDesc->Height;
 
     /* Rotation compensated destination rect */
-    RECT DestDirty = *Dirty;
+    RECT DestDirty;
+
+    SetDirtyRect (&DestDirty, Dirty, DeskDesc, Width, Height);
 
     /* Set appropriate coordinates compensated for rotation */
     switch (DeskDesc->Rotation)
     {
       case DXGI_MODE_ROTATION_ROTATE90:
-        DestDirty.left = Width - Dirty->bottom;
-        DestDirty.top = Dirty->left;
-        DestDirty.right = Width - Dirty->top;
-        DestDirty.bottom = Dirty->right;
-
         Vertices[0].TexCoord =
             MyFLOAT2(Dirty->right / static_cast<FLOAT>(ThisDesc->Width),
                      Dirty->bottom / static_cast<FLOAT>(ThisDesc->Height));
@@ -998,11 +1050,6 @@ private:
                      Dirty->top / static_cast<FLOAT>(ThisDesc->Height));
         break;
       case DXGI_MODE_ROTATION_ROTATE180:
-        DestDirty.left = Width - Dirty->right;
-        DestDirty.top = Height - Dirty->bottom;
-        DestDirty.right = Width - Dirty->left;
-        DestDirty.bottom = Height - Dirty->top;
-
         Vertices[0].TexCoord =
             MyFLOAT2(Dirty->right / static_cast<FLOAT>(ThisDesc->Width),
                      Dirty->top / static_cast<FLOAT>(ThisDesc->Height));
@@ -1017,11 +1064,6 @@ private:
                      Dirty->bottom / static_cast<FLOAT>(ThisDesc->Height));
         break;
       case DXGI_MODE_ROTATION_ROTATE270:
-        DestDirty.left = Dirty->top;
-        DestDirty.top = Height - Dirty->right;
-        DestDirty.right = Dirty->bottom;
-        DestDirty.bottom = Height - Dirty->left;
-
         Vertices[0].TexCoord =
             MyFLOAT2(Dirty->left / static_cast<FLOAT>(ThisDesc->Width),
                      Dirty->top / static_cast<FLOAT>(ThisDesc->Height));
@@ -1231,6 +1273,43 @@ private:
     return ret;
   }
 
+  /* Collects the destination of the move and dirty rects in the shared
+   * texture coordinates, i.e. the regions ProcessFrame() updated */
+  void
+  GetDamage (ID3D11Texture2D* SharedSurf, DXGI_OUTPUT_DESC* DeskDesc,
+      UINT move_count, UINT dirty_count, DXGI_OUTDUPL_FRAME_INFO * frame_info,
+      GArray * damage)
+  {
+    D3D11_TEXTURE2D_DESC FullDesc;
+    DXGI_OUTDUPL_MOVE_RECT *move_rects;
+    RECT *dirty_rects;
+
+    if (!frame_info->TotalMetadataBufferSize)
+      return;
+
+    SharedSurf->GetDesc(&FullDesc);
+
+    move_rects = (DXGI_OUTDUPL_MOVE_RECT *) metadata_buffer_;
+    for (UINT i = 0; i < move_count; i++) {
+      RECT SrcRect;
+      RECT DestRect;
+
+      SetMoveRect(&SrcRect, &DestRect, DeskDesc, &move_rects[i],
+          FullDesc.Width, FullDesc.Height);
+      g_array_append_val (damage, DestRect);
+    }
+
+    dirty_rects = (RECT *)(metadata_buffer_ +
+        (move_count * sizeof(DXGI_OUTDUPL_MOVE_RECT)));
+    for (UINT i = 0; i < dirty_count; i++) {
+      RECT DestDirty;
+
+      SetDirtyRect (&DestDirty, &dirty_rects[i], DeskDesc,
+          FullDesc.Width, FullDesc.Height);
+      g_array_append_val (damage, DestDirty);
+    }
+  }
+
   /* To draw mouse */
   bool
   ProcessMonoMask (bool IsMono, PTR_INFO* PtrInfo, INT* PtrWidth,
@@ -1423,6 +1502,7 @@ struct _GstD3D11DesktopDup
   gint monitor_index;
   RECT desktop_coordinates;
   gboolean prepared;
+  gboolean full_damage;
 
   GRecMutex lock;
 };
@@ -1796,10 +1876,12 @@ gst_d3d11_desktop_dup_get_coordinates (GstD3D11DesktopDup * desktop,
   return TRUE;
 }
 
+/* @damage: (nullable): filled with the RECTs updated since the previous
+ * capture, left empty when nothing changed */
 GstFlowReturn
 gst_d3d11_desktop_dup_capture (GstD3D11DesktopDup * desktop,
     ID3D11Texture2D * texture, ID3D11RenderTargetView * rtv,
-    gboolean draw_mouse)
+    gboolean draw_mouse, GArray * damage)
 {
   GstFlowReturn ret = GST_FLOW_OK;
   ID3D11DeviceContext *device_context_handle;
@@ -1807,9 +1889,15 @@ gst_d3d11_desktop_dup_capture (GstD3D11DesktopDup * desktop,
   g_return_val_if_fail (GST_IS_D3D11_DESKTOP_DUP (desktop), GST_FLOW_ERROR);
   g_return_val_if_fail (texture != nullptr, GST_FLOW_ERROR);
 
+  if (damage)
+    g_array_set_size (damage, 0);
+
   g_rec_mutex_lock (&desktop->lock);
-  if (!desktop->prepared)
+  if (!desktop->prepared) {
     ret = gst_d3d11_desktop_dup_prepare (desktop);
+    /* the internal texture starts over */
+    desktop->full_damage = TRUE;
+  }
 
   if (ret != GST_FLOW_OK) {
     GST_WARNING_OBJECT (desktop, "We are not prepared");
@@ -1818,7 +1906,7 @@ gst_d3d11_desktop_dup_capture (GstD3D11DesktopDup * desktop,
   }
 
   gst_d3d11_device_lock (desktop->device);
-  ret = desktop->dupl_obj->Capture (draw_mouse);
+  ret = desktop->dupl_obj->Capture (draw_mouse, damage);
   if (ret != GST_FLOW_OK) {
     gst_d3d11_device_unlock (desktop->device);
 
@@ -1839,6 +1927,17 @@ gst_d3d11_desktop_dup_capture (GstD3D11DesktopDup * desktop,
 
   GST_LOG_OBJECT (desktop, "Capture done");
 
+  /* Updates are consumed by a single capture, we cannot know which regions
+   * changed since the previous capture of each user of a shared object */
+  if (damage && (desktop->full_damage ||
+          GST_OBJECT_REFCOUNT_VALUE (desktop) > 1)) {
+    RECT full = { 0, 0, (LONG) desktop->width, (LONG) desktop->height };
+
+    g_array_set_size (damage, 0);
+    g_array_append_val (damage, full);
+  }
+  desktop->full_damage = FALSE;
+
   device_context_handle =
       gst_d3d11_device_get_device_context_handle (desktop->device);
   device_context_handle->CopySubresourceRegion (texture, 0, 0, 0, 0,
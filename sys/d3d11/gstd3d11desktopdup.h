@@ -44,7 +44,8 @@ gboolean        gst_d3d11_desktop_dup_get_coordinates (GstD3D11DesktopDup * desk
 GstFlowReturn   gst_d3d11_desktop_dup_capture (GstD3D11DesktopDup * desktop,
                                                ID3D11Texture2D * texture,
                                                ID3D11RenderTargetView *rtv,
-                                               gboolean draw_mouse);
+                                               gboolean draw_mouse,
+                                               GArray * damage);
 
 G_END_DECLS
 
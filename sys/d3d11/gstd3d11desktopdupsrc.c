@@ -29,6 +29,11 @@
  * gst-launch-1.0 d3d11desktopdupsrc ! queue ! d3d11videosink
  * ```
  *
+ * When #GstD3D11DesktopDupSrc:damage-meta is enabled, each buffer carries a
+ * #GstVideoRegionOfInterestMeta of type "damage" for every region updated
+ * since the previous buffer.  A buffer without such meta is identical to the
+ * previous one, so that downstream can skip static frames.
+ *
  * Since: 1.20
  */
 
@@ -50,6 +55,7 @@ enum
   PROP_0,
   PROP_MONITOR_INDEX,
   PROP_SHOW_CURSOR,
+  PROP_DAMAGE_META,
 
   PROP_LAST,
 };
@@ -58,6 +64,7 @@ static GParamSpec *properties[PROP_LAST];
 
 #define DEFAULT_MONITOR_INDEX -1
 #define DEFAULT_SHOW_CURSOR FALSE
+#define DEFAULT_DAMAGE_META FALSE
 
 static GstStaticCaps template_caps =
 GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE_WITH_FEATURES
@@ -77,6 +84,12 @@ struct _GstD3D11DesktopDupSrc
   gint adapter;
   gint monitor_index;
   gboolean show_cursor;
+  gboolean damage_meta;
+
+  /* updated regions of the last capture */
+  GArray *damage;
+  gboolean full_damage;
+  gboolean last_draw_mouse;
 
   gboolean flushing;
   GstClockTime min_latency;
@@ -138,6 +151,20 @@ gst_d3d11_desktop_dup_src_class_init (GstD3D11DesktopDupSrcClass * klass)
       "Show Mouse Cursor", "Whether to show mouse cursor",
       DEFAULT_SHOW_CURSOR, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+  /**
+   * GstD3D11DesktopDupSrc:damage-meta:
+   *
+   * Attach a #GstVideoRegionOfInterestMeta of type "damage" for each region
+   * updated since the previous buffer
+   *
+   * Since: 1.20
+   */
+  properties[PROP_DAMAGE_META] =
+      g_param_spec_boolean ("damage-meta",
+      "Damage Meta", "Attach region of interest metas of type \"damage\" "
+      "describing the regions updated since the previous frame",
+      DEFAULT_DAMAGE_META, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
   g_object_class_install_properties (gobject_class, PROP_LAST, properties);
 
   element_class->set_context =
@@ -209,6 +236,9 @@ gst_d3d11_desktop_dup_src_set_property (GObject * object, guint prop_id,
     case PROP_SHOW_CURSOR:
       self->show_cursor = g_value_get_boolean (value);
       break;
+    case PROP_DAMAGE_META:
+      self->damage_meta = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -228,6 +258,9 @@ gst_d3d11_desktop_dup_src_get_property (GObject * object, guint prop_id,
     case PROP_SHOW_CURSOR:
       g_value_set_boolean (value, self->show_cursor);
       break;
+    case PROP_DAMAGE_META:
+      g_value_set_boolean (value, self->damage_meta);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -409,6 +442,7 @@ gst_d3d11_desktop_dup_src_start (GstBaseSrc * bsrc)
 
   self->last_frame_no = -1;
   self->min_latency = self->max_latency = GST_CLOCK_TIME_NONE;
+  self->full_damage = TRUE;
 
   return TRUE;
 }
@@ -420,6 +454,7 @@ gst_d3d11_desktop_dup_src_stop (GstBaseSrc * bsrc)
 
   gst_clear_object (&self->dupl);
   gst_clear_object (&self->device);
+  g_clear_pointer (&self->damage, g_array_unref);
 
   return TRUE;
 }
@@ -499,6 +534,7 @@ gst_d3d11_desktop_dup_src_fill (GstPushSrc * pushsrc, GstBuffer * buffer)
   gboolean update_latency = FALSE;
   gint64 next_frame_no;
   gboolean draw_mouse;
+  GArray *damage = NULL;
 
   if (!self->dupl) {
     GST_ELEMENT_ERROR (self, RESOURCE, OPEN_READ,
@@ -605,9 +641,16 @@ again:
     goto out;
   }
 
+  if (self->damage_meta) {
+    if (!self->damage)
+      self->damage = g_array_new (FALSE, FALSE, sizeof (RECT));
+    damage = self->damage;
+  }
+
   texture = (ID3D11Texture2D *) info.data;
   before_capture = gst_clock_get_time (clock);
-  ret = gst_d3d11_desktop_dup_capture (self->dupl, texture, rtv, draw_mouse);
+  ret = gst_d3d11_desktop_dup_capture (self->dupl, texture, rtv, draw_mouse,
+      damage);
   gst_memory_unmap (mem, &info);
 
   GST_BUFFER_DTS (buffer) = GST_CLOCK_TIME_NONE;
@@ -617,9 +660,38 @@ again:
   if (ret == GST_D3D11_DESKTOP_DUP_FLOW_EXPECTED_ERROR) {
     GST_WARNING_OBJECT (self, "Got expected error, try again");
     gst_clear_object (&clock);
+    self->full_damage = TRUE;
     goto again;
   }
 
+  if (ret == GST_FLOW_OK && damage) {
+    guint i;
+
+    if (self->full_damage || draw_mouse != self->last_draw_mouse) {
+      gst_buffer_add_video_region_of_interest_meta (buffer, "damage", 0, 0,
+          GST_VIDEO_INFO_WIDTH (&self->video_info),
+          GST_VIDEO_INFO_HEIGHT (&self->video_info));
+    } else {
+      for (i = 0; i < damage->len; i++) {
+        RECT *rect = &g_array_index (damage, RECT, i);
+
+        if (rect->right <= rect->left || rect->bottom <= rect->top)
+          continue;
+
+        gst_buffer_add_video_region_of_interest_meta (buffer, "damage",
+            rect->left, rect->top, rect->right - rect->left,
+            rect->bottom - rect->top);
+      }
+    }
+  }
+
+  if (ret == GST_FLOW_OK) {
+    /* without damage metas, downstream has to assume a full update once
+     * they are enabled */
+    self->full_damage = !damage;
+    self->last_draw_mouse = draw_mouse;
+  }
+
   after_capture = gst_clock_get_time (clock);
   latency = after_capture - before_capture;
   if (!GST_CLOCK_TIME_IS_VALID (self->min_latency)) {
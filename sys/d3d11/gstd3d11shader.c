@@ -30,6 +30,11 @@ GST_DEBUG_CATEGORY_EXTERN (gst_d3d11_shader_debug);
 static GModule *d3d_compiler_module = NULL;
 static pD3DCompile GstD3DCompileFunc = NULL;
 
+/* Compiled bytecode shared by all devices and elements of the process,
+ * keyed on the shader target and source */
+G_LOCK_DEFINE_STATIC (shader_cache_lock);
+static GHashTable *shader_cache = NULL;
+
 gboolean
 gst_d3d11_shader_init (void)
 {
@@ -77,16 +82,18 @@ gst_d3d11_shader_init (void)
   return ! !GstD3DCompileFunc;
 }
 
-static ID3DBlob *
+static GBytes *
 compile_shader (GstD3D11Device * device, const gchar * shader_source,
     gboolean is_pixel_shader)
 {
-  ID3DBlob *ret;
+  ID3DBlob *blob;
   ID3DBlob *error = NULL;
   const gchar *shader_target;
   D3D_FEATURE_LEVEL feature_level;
   HRESULT hr;
   ID3D11Device *device_handle;
+  GBytes *ret;
+  gchar *key;
 
   if (!gst_d3d11_shader_init ()) {
     GST_ERROR ("D3DCompiler is unavailable");
@@ -112,12 +119,30 @@ compile_shader (GstD3D11Device * device, const gchar * shader_source,
       shader_target = "vs_4_0_level_9_1";
   }
 
+  key = g_strconcat (shader_target, "\n", shader_source, NULL);
+
+  G_LOCK (shader_cache_lock);
+  if (!shader_cache) {
+    shader_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify) g_bytes_unref);
+  }
+  ret = g_hash_table_lookup (shader_cache, key);
+  if (ret)
+    g_bytes_ref (ret);
+  G_UNLOCK (shader_cache_lock);
+
+  if (ret) {
+    GST_TRACE ("Reusing compiled %s bytecode", shader_target);
+    g_free (key);
+    return ret;
+  }
+
   g_assert (GstD3DCompileFunc);
 
   GST_TRACE ("Compile code \n%s", shader_source);
 
   hr = GstD3DCompileFunc (shader_source, strlen (shader_source), NULL, NULL,
-      NULL, "main", shader_target, 0, 0, &ret, &error);
+      NULL, "main", shader_target, 0, 0, &blob, &error);
 
   if (!gst_d3d11_result (hr, device)) {
     const gchar *err = NULL;
@@ -131,6 +156,7 @@ compile_shader (GstD3D11Device * device, const gchar * shader_source,
     if (error)
       ID3D10Blob_Release (error);
 
+    g_free (key);
     return NULL;
   }
 
@@ -142,6 +168,16 @@ compile_shader (GstD3D11Device * device, const gchar * shader_source,
     ID3D10Blob_Release (error);
   }
 
+  ret = g_bytes_new (ID3D10Blob_GetBufferPointer (blob),
+      ID3D10Blob_GetBufferSize (blob));
+  ID3D10Blob_Release (blob);
+
+  /* another thread may have compiled the same source meanwhile, both
+   * results are identical */
+  G_LOCK (shader_cache_lock);
+  g_hash_table_replace (shader_cache, key, g_bytes_ref (ret));
+  G_UNLOCK (shader_cache_lock);
+
   return ret;
 }
 
@@ -149,7 +185,7 @@ gboolean
 gst_d3d11_create_pixel_shader (GstD3D11Device * device,
     const gchar * source, ID3D11PixelShader ** shader)
 {
-  ID3DBlob *ps_blob;
+  GBytes *ps_blob;
   ID3D11Device *device_handle;
   HRESULT hr;
 
@@ -157,29 +193,27 @@ gst_d3d11_create_pixel_shader (GstD3D11Device * device,
   g_return_val_if_fail (source != NULL, FALSE);
   g_return_val_if_fail (shader != NULL, FALSE);
 
-  gst_d3d11_device_lock (device);
+  /* compiling doesn't need the device, don't block other threads meanwhile */
   ps_blob = compile_shader (device, source, TRUE);
 
   if (!ps_blob) {
     GST_ERROR ("Failed to compile pixel shader");
-    gst_d3d11_device_unlock (device);
     return FALSE;
   }
 
+  gst_d3d11_device_lock (device);
   device_handle = gst_d3d11_device_get_device_handle (device);
   hr = ID3D11Device_CreatePixelShader (device_handle,
-      (gpointer) ID3D10Blob_GetBufferPointer (ps_blob),
-      ID3D10Blob_GetBufferSize (ps_blob), NULL, shader);
+      g_bytes_get_data (ps_blob, NULL), g_bytes_get_size (ps_blob), NULL,
+      shader);
+  gst_d3d11_device_unlock (device);
+  g_bytes_unref (ps_blob);
 
   if (!gst_d3d11_result (hr, device)) {
     GST_ERROR ("could not create pixel shader, hr: 0x%x", (guint) hr);
-    gst_d3d11_device_unlock (device);
     return FALSE;
   }
 
-  ID3D10Blob_Release (ps_blob);
-  gst_d3d11_device_unlock (device);
-
   return TRUE;
 }
 
@@ -188,7 +222,7 @@ gst_d3d11_create_vertex_shader (GstD3D11Device * device, const gchar * source,
     const D3D11_INPUT_ELEMENT_DESC * input_desc, guint desc_len,
     ID3D11VertexShader ** shader, ID3D11InputLayout ** layout)
 {
-  ID3DBlob *vs_blob;
+  GBytes *vs_blob;
   ID3D11Device *device_handle;
   HRESULT hr;
   ID3D11VertexShader *vshader = NULL;
@@ -202,38 +236,34 @@ gst_d3d11_create_vertex_shader (GstD3D11Device * device, const gchar * source,
   g_return_val_if_fail (shader != NULL, FALSE);
   g_return_val_if_fail (layout != NULL, FALSE);
 
-  gst_d3d11_device_lock (device);
   vs_blob = compile_shader (device, source, FALSE);
   if (!vs_blob) {
     GST_ERROR ("Failed to compile shader code");
-    goto done;
+    return FALSE;
   }
 
+  gst_d3d11_device_lock (device);
   device_handle = gst_d3d11_device_get_device_handle (device);
 
   hr = ID3D11Device_CreateVertexShader (device_handle,
-      (gpointer) ID3D10Blob_GetBufferPointer (vs_blob),
-      ID3D10Blob_GetBufferSize (vs_blob), NULL, &vshader);
+      g_bytes_get_data (vs_blob, NULL), g_bytes_get_size (vs_blob), NULL,
+      &vshader);
 
   if (!gst_d3d11_result (hr, device)) {
     GST_ERROR ("could not create vertex shader, hr: 0x%x", (guint) hr);
-    ID3D10Blob_Release (vs_blob);
     goto done;
   }
 
   hr = ID3D11Device_CreateInputLayout (device_handle, input_desc,
-      desc_len, (gpointer) ID3D10Blob_GetBufferPointer (vs_blob),
-      ID3D10Blob_GetBufferSize (vs_blob), &in_layout);
+      desc_len, g_bytes_get_data (vs_blob, NULL), g_bytes_get_size (vs_blob),
+      &in_layout);
 
   if (!gst_d3d11_result (hr, device)) {
     GST_ERROR ("could not create input layout shader, hr: 0x%x", (guint) hr);
-    ID3D10Blob_Release (vs_blob);
     ID3D11VertexShader_Release (vshader);
     goto done;
   }
 
-  ID3D10Blob_Release (vs_blob);
-
   *shader = vshader;
   *layout = in_layout;
 
@@ -241,6 +271,7 @@ gst_d3d11_create_vertex_shader (GstD3D11Device * device, const gchar * source,
 
 done:
   gst_d3d11_device_unlock (device);
+  g_bytes_unref (vs_blob);
 
   return ret;
 }
@@ -1133,15 +1133,32 @@ public:
   }
 };
 
+/* Every buffer handed out is preceded by a small header with the size of
+ * the allocation and the distance to the start of the allocated memory */
+#define DECKLINK_BUFFER_HEADER_SIZE 16
+
 class GStreamerDecklinkMemoryAllocator:public IDeckLinkMemoryAllocator
 {
 private:
   GMutex m_mutex;
   uint32_t m_lastBufferSize;
   uint32_t m_nonEmptyCalls;
+  uint32_t m_alignment;
   GstQueueArray *m_buffers;
   gint m_refcount;
 
+  static uint32_t _bufferSize (uint8_t * buf)
+  {
+    return *(uint32_t *) (buf - 4);
+  }
+
+  static void _freeBuffer (uint8_t * buf)
+  {
+    uint32_t offset = *(uint32_t *) (buf - 8);
+
+    g_free (buf - offset);
+  }
+
   void _clearBufferPool ()
   {
     uint8_t *buf;
@@ -1149,18 +1166,16 @@ private:
     if (!m_buffers)
         return;
 
-    while ((buf = (uint8_t *) gst_queue_array_pop_head (m_buffers))) {
-      uint8_t offset = *(buf - 1);
-      void *alloc_buf = buf - 128 + offset;
-        g_free (alloc_buf);
-    }
+    while ((buf = (uint8_t *) gst_queue_array_pop_head (m_buffers)))
+      _freeBuffer (buf);
   }
 
 public:
-    GStreamerDecklinkMemoryAllocator ()
+    GStreamerDecklinkMemoryAllocator (uint32_t alignment)
   : IDeckLinkMemoryAllocator (),
       m_lastBufferSize (0),
-      m_nonEmptyCalls (0), m_buffers (NULL), m_refcount (1)
+      m_nonEmptyCalls (0), m_alignment (alignment), m_buffers (NULL),
+      m_refcount (1)
   {
     g_mutex_init (&m_mutex);
 
@@ -1213,7 +1228,7 @@ public:
       AllocateBuffer (uint32_t bufferSize, void **allocatedBuffer)
   {
     uint8_t *buf;
-    uint8_t offset = 0;
+    uint32_t offset;
 
     g_mutex_lock (&m_mutex);
 
@@ -1225,25 +1240,24 @@ public:
 
     /* Look if there is a free buffer in the pool */
     if (!(buf = (uint8_t *) gst_queue_array_pop_head (m_buffers))) {
-      /* If not, alloc a new one */
-      buf = (uint8_t *) g_malloc (bufferSize + 128);
-
-      /* The Decklink SDK requires 16 byte aligned memory at least but for us
-       * to work nicely let's align to 64 bytes (512 bits) as this allows
-       * aligned AVX2 operations for example */
-      if (((guintptr) buf) % 64 != 0) {
-        offset = ((guintptr) buf) % 64;
-      }
-
-      /* Write the allocation size at the very beginning. It's guaranteed by
-       * malloc() to be allocated aligned enough for doing this. */
-      *((uint32_t *) buf) = bufferSize;
-
-      /* Align our buffer */
-      buf += 128 - offset;
-
-      /* And write the alignment offset right before the buffer */
-      *(buf - 1) = offset;
+      uint8_t *alloc_buf;
+
+      /* If not, alloc a new one. The Decklink SDK requires 16 byte aligned
+       * memory at least, the alignment defaults to 64 bytes (512 bits) as
+       * this allows aligned AVX2 operations for example, and page
+       * alignment allows downstream to register the memory for DMA */
+      alloc_buf = (uint8_t *) g_malloc (bufferSize + m_alignment +
+          DECKLINK_BUFFER_HEADER_SIZE);
+
+      /* Align our buffer, leaving space for the header */
+      buf = (uint8_t *) GSIZE_TO_POINTER (GPOINTER_TO_SIZE (alloc_buf +
+              DECKLINK_BUFFER_HEADER_SIZE + m_alignment - 1) &
+          ~((gsize) m_alignment - 1));
+      offset = buf - alloc_buf;
+
+      /* And write the alignment offset and size right before the buffer */
+      *(uint32_t *) (buf - 8) = offset;
+      *(uint32_t *) (buf - 4) = bufferSize;
     }
     *allocatedBuffer = (void *) buf;
 
@@ -1251,10 +1265,7 @@ public:
      * remove one of them every fifth call */
     if (gst_queue_array_get_length (m_buffers) > 0) {
       if (++m_nonEmptyCalls >= 5) {
-        buf = (uint8_t *) gst_queue_array_pop_head (m_buffers);
-        uint8_t offset = *(buf - 1);
-        void *alloc_buf = buf - 128 + offset;
-        g_free (alloc_buf);
+        _freeBuffer ((uint8_t *) gst_queue_array_pop_head (m_buffers));
         m_nonEmptyCalls = 0;
       }
     } else {
@@ -1271,13 +1282,10 @@ public:
     g_mutex_lock (&m_mutex);
 
     /* Put the buffer back to the pool if size matches with current pool */
-    uint8_t offset = *(((uint8_t *) buffer) - 1);
-    uint8_t *alloc_buffer = ((uint8_t *) buffer) - 128 + offset;
-    uint32_t size = *(uint32_t *) alloc_buffer;
-    if (size == m_lastBufferSize) {
+    if (_bufferSize ((uint8_t *) buffer) == m_lastBufferSize) {
       gst_queue_array_push_tail (m_buffers, buffer);
     } else {
-      g_free (alloc_buffer);
+      _freeBuffer ((uint8_t *) buffer);
     }
 
     g_mutex_unlock (&m_mutex);
@@ -1793,8 +1801,12 @@ gst_decklink_acquire_nth_input (gint n, GstElement * src, gboolean is_audio)
   }
 
   g_mutex_lock (&input->lock);
-  input->input->SetVideoInputFrameMemoryAllocator (new
-      GStreamerDecklinkMemoryAllocator);
+  if (!is_audio && !input->videosrc) {
+    GstDecklinkVideoSrc *videosrc = (GstDecklinkVideoSrc *) (src);
+
+    input->input->SetVideoInputFrameMemoryAllocator (new
+        GStreamerDecklinkMemoryAllocator (videosrc->frame_alignment));
+  }
   if (is_audio && !input->audiosrc) {
     input->audiosrc = GST_ELEMENT_CAST (gst_object_ref (src));
     g_mutex_unlock (&input->lock);
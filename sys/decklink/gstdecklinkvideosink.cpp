@@ -232,6 +232,260 @@ private:
   gint m_refcount;
 };
 
+class GstDecklinkTimecode:public IDeckLinkTimecode
+{
+public:
+  GstDecklinkTimecode (GstVideoTimeCode * timecode):m_string (NULL),
+      m_refcount (1)
+  {
+    m_timecode = gst_video_time_code_copy (timecode);
+  }
+
+  virtual HRESULT WINAPI QueryInterface (REFIID, LPVOID *)
+  {
+    return E_NOINTERFACE;
+  }
+
+  virtual ULONG WINAPI AddRef (void)
+  {
+    return g_atomic_int_add (&m_refcount, 1) + 1;
+  }
+
+  virtual ULONG WINAPI Release (void)
+  {
+    gint ret = g_atomic_int_add (&m_refcount, -1) - 1;
+
+    if (ret == 0)
+      delete this;
+
+    return ret;
+  }
+
+  virtual BMDTimecodeBCD WINAPI GetBCD (void)
+  {
+    BMDTimecodeBCD bcd = 0;
+
+    bcd |= (m_timecode->frames % 10) << 0;
+    bcd |= ((m_timecode->frames / 10) & 0x0f) << 4;
+    bcd |= (m_timecode->seconds % 10) << 8;
+    bcd |= ((m_timecode->seconds / 10) & 0x0f) << 12;
+    bcd |= (m_timecode->minutes % 10) << 16;
+    bcd |= ((m_timecode->minutes / 10) & 0x0f) << 20;
+    bcd |= (m_timecode->hours % 10) << 24;
+    bcd |= ((m_timecode->hours / 10) & 0x0f) << 28;
+
+    return bcd;
+  }
+
+  virtual HRESULT WINAPI GetComponents (uint8_t * hours, uint8_t * minutes,
+      uint8_t * seconds, uint8_t * frames)
+  {
+    if (hours)
+      *hours = m_timecode->hours;
+    if (minutes)
+      *minutes = m_timecode->minutes;
+    if (seconds)
+      *seconds = m_timecode->seconds;
+    if (frames)
+      *frames = m_timecode->frames;
+
+    return S_OK;
+  }
+
+  virtual HRESULT WINAPI GetString (const char **timecode)
+  {
+    if (!m_string)
+      m_string = gst_video_time_code_to_string (m_timecode);
+    *timecode = m_string;
+
+    return S_OK;
+  }
+
+  virtual BMDTimecodeFlags WINAPI GetFlags (void)
+  {
+    BMDTimecodeFlags flags = (BMDTimecodeFlags) 0;
+
+    if (((GstVideoTimeCodeFlags) (m_timecode->config.flags)) &
+        GST_VIDEO_TIME_CODE_FLAGS_DROP_FRAME)
+      flags = (BMDTimecodeFlags) (flags | bmdTimecodeIsDropFrame);
+    else
+      flags = (BMDTimecodeFlags) (flags | bmdTimecodeFlagDefault);
+    if (m_timecode->field_count == 2)
+      flags = (BMDTimecodeFlags) (flags | bmdTimecodeFieldMark);
+
+    return flags;
+  }
+
+  virtual HRESULT WINAPI GetTimecodeUserBits (BMDTimecodeUserBits * userBits)
+  {
+    *userBits = 0;
+
+    return S_OK;
+  }
+
+private:
+  virtual ~ GstDecklinkTimecode () {
+    gst_video_time_code_free (m_timecode);
+    g_free (m_string);
+  }
+
+  GstVideoTimeCode *m_timecode;
+  gchar *m_string;
+  gint m_refcount;
+};
+
+/* A frame for the scheduled playback that either directly uses the memory
+ * of a mapped buffer, or wraps a frame allocated by the device that the
+ * buffer was copied into, and carries the timecode and ancillary data */
+class GstDecklinkVideoFrame:public IDeckLinkVideoFrame
+{
+public:
+  GstDecklinkVideoFrame (GstVideoFrame * vframe, BMDPixelFormat format)
+  :m_dframe (NULL), m_format (format), m_timecode (NULL),
+      m_timecode_format ((BMDTimecodeFormat) 0), m_ancillary (NULL),
+      m_refcount (1)
+  {
+    m_vframe = g_new (GstVideoFrame, 1);
+    *m_vframe = *vframe;
+  }
+
+  GstDecklinkVideoFrame (IDeckLinkMutableVideoFrame * dframe)
+  :m_vframe (NULL), m_dframe (dframe), m_timecode (NULL),
+      m_timecode_format ((BMDTimecodeFormat) 0), m_ancillary (NULL),
+      m_refcount (1)
+  {
+    m_format = dframe->GetPixelFormat ();
+  }
+
+  virtual HRESULT WINAPI QueryInterface (REFIID, LPVOID *)
+  {
+    return E_NOINTERFACE;
+  }
+
+  virtual ULONG WINAPI AddRef (void)
+  {
+    return g_atomic_int_add (&m_refcount, 1) + 1;
+  }
+
+  virtual ULONG WINAPI Release (void)
+  {
+    gint ret = g_atomic_int_add (&m_refcount, -1) - 1;
+
+    if (ret == 0)
+      delete this;
+
+    return ret;
+  }
+
+  virtual long WINAPI GetWidth (void)
+  {
+    if (m_dframe)
+      return m_dframe->GetWidth ();
+    return GST_VIDEO_FRAME_WIDTH (m_vframe);
+  }
+
+  virtual long WINAPI GetHeight (void)
+  {
+    if (m_dframe)
+      return m_dframe->GetHeight ();
+    return GST_VIDEO_FRAME_HEIGHT (m_vframe);
+  }
+
+  virtual long WINAPI GetRowBytes (void)
+  {
+    if (m_dframe)
+      return m_dframe->GetRowBytes ();
+    return GST_VIDEO_FRAME_PLANE_STRIDE (m_vframe, 0);
+  }
+
+  virtual BMDPixelFormat WINAPI GetPixelFormat (void)
+  {
+    return m_format;
+  }
+
+  virtual BMDFrameFlags WINAPI GetFlags (void)
+  {
+    return bmdFrameFlagDefault;
+  }
+
+  virtual HRESULT WINAPI GetBytes (void **buffer)
+  {
+    if (m_dframe)
+      return m_dframe->GetBytes (buffer);
+
+    *buffer = GST_VIDEO_FRAME_PLANE_DATA (m_vframe, 0);
+    return S_OK;
+  }
+
+  virtual HRESULT WINAPI GetTimecode (BMDTimecodeFormat format,
+      IDeckLinkTimecode ** timecode)
+  {
+    gboolean rp188 = format == bmdTimecodeRP188VITC1
+        || format == bmdTimecodeRP188VITC2 || format == bmdTimecodeRP188LTC;
+
+    if (!m_timecode || (format != m_timecode_format
+            && !(rp188 && m_timecode_format == bmdTimecodeRP188Any))) {
+      *timecode = NULL;
+      return S_FALSE;
+    }
+
+    m_timecode->AddRef ();
+    *timecode = m_timecode;
+    return S_OK;
+  }
+
+  virtual HRESULT WINAPI GetAncillaryData (IDeckLinkVideoFrameAncillary **
+      ancillary)
+  {
+    if (!m_ancillary) {
+      *ancillary = NULL;
+      return S_FALSE;
+    }
+
+    m_ancillary->AddRef ();
+    *ancillary = m_ancillary;
+    return S_OK;
+  }
+
+  void SetTimecode (BMDTimecodeFormat format, GstVideoTimeCode * timecode)
+  {
+    if (m_timecode)
+      m_timecode->Release ();
+    m_timecode = new GstDecklinkTimecode (timecode);
+    m_timecode_format = format;
+  }
+
+  void SetAncillaryData (IDeckLinkVideoFrameAncillary * ancillary)
+  {
+    if (m_ancillary)
+      m_ancillary->Release ();
+    ancillary->AddRef ();
+    m_ancillary = ancillary;
+  }
+
+private:
+  virtual ~ GstDecklinkVideoFrame () {
+    if (m_vframe) {
+      gst_video_frame_unmap (m_vframe);
+      g_free (m_vframe);
+    }
+    if (m_dframe)
+      m_dframe->Release ();
+    if (m_timecode)
+      m_timecode->Release ();
+    if (m_ancillary)
+      m_ancillary->Release ();
+  }
+
+  GstVideoFrame *m_vframe;
+  IDeckLinkMutableVideoFrame *m_dframe;
+  BMDPixelFormat m_format;
+  GstDecklinkTimecode *m_timecode;
+  BMDTimecodeFormat m_timecode_format;
+  IDeckLinkVideoFrameAncillary *m_ancillary;
+  gint m_refcount;
+};
+
 enum
 {
   PROP_0,
@@ -924,7 +1178,7 @@ convert_cea708_cc_data_cea708_cdp_internal (GstDecklinkVideoSink * self,
 
 static void
 write_vbi (GstDecklinkVideoSink * self, GstBuffer * buffer,
-    BMDPixelFormat format, IDeckLinkMutableVideoFrame * frame,
+    BMDPixelFormat format, GstDecklinkVideoFrame * frame,
     GstVideoTimeCodeMeta * tc_meta)
 {
   IDeckLinkVideoFrameAncillary *vanc_frame = NULL;
@@ -1193,9 +1447,7 @@ write_vbi (GstDecklinkVideoSink * self, GstBuffer * buffer,
       }
     }
 
-    if (frame->SetAncillaryData (vanc_frame) != S_OK) {
-      GST_WARNING_OBJECT (self, "Failed to set ancillary data");
-    }
+    frame->SetAncillaryData (vanc_frame);
 
     vanc_frame->Release ();
   } else if (got_captions || self->afd_bar_line != 0) {
@@ -1208,7 +1460,8 @@ gst_decklink_video_sink_prepare (GstBaseSink * bsink, GstBuffer * buffer)
 {
   GstDecklinkVideoSink *self = GST_DECKLINK_VIDEO_SINK_CAST (bsink);
   GstVideoFrame vframe;
-  IDeckLinkMutableVideoFrame *frame;
+  GstDecklinkVideoFrame *frame;
+  IDeckLinkMutableVideoFrame *dframe;
   guint8 *outdata, *indata;
   GstFlowReturn flow_ret;
   HRESULT ret;
@@ -1268,58 +1521,52 @@ gst_decklink_video_sink_prepare (GstBaseSink * bsink, GstBuffer * buffer)
   else
     running_time = 0;
 
-  ret = self->output->output->CreateVideoFrame (self->info.width,
-      self->info.height, self->info.stride[0], format, bmdFrameFlagDefault,
-      &frame);
-  if (ret != S_OK) {
-    GST_ELEMENT_ERROR (self, STREAM, FAILED,
-        (NULL), ("Failed to create video frame: 0x%08lx", (unsigned long) ret));
-    return GST_FLOW_ERROR;
-  }
-
   if (!gst_video_frame_map (&vframe, &self->info, buffer, GST_MAP_READ)) {
     GST_ERROR_OBJECT (self, "Failed to map video frame");
-    flow_ret = GST_FLOW_ERROR;
-    goto out;
+    return GST_FLOW_ERROR;
   }
 
-  frame->GetBytes ((void **) &outdata);
+  /* The device can read directly from the buffer if it has the row stride
+   * of the device frames, and the alignment the SDK requires. The frame
+   * then keeps the buffer mapped until it was played out */
   indata = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (&vframe, 0);
-  stride =
-      MIN (GST_VIDEO_FRAME_PLANE_STRIDE (&vframe, 0), frame->GetRowBytes ());
-  for (i = 0; i < self->info.height; i++) {
-    memcpy (outdata, indata, stride);
-    indata += GST_VIDEO_FRAME_PLANE_STRIDE (&vframe, 0);
-    outdata += frame->GetRowBytes ();
+  if (GST_VIDEO_FRAME_PLANE_STRIDE (&vframe, 0) == self->info.stride[0]
+      && (GPOINTER_TO_SIZE (indata) & 15) == 0) {
+    frame = new GstDecklinkVideoFrame (&vframe, format);
+  } else {
+    ret = self->output->output->CreateVideoFrame (self->info.width,
+        self->info.height, self->info.stride[0], format, bmdFrameFlagDefault,
+        &dframe);
+    if (ret != S_OK) {
+      gst_video_frame_unmap (&vframe);
+      GST_ELEMENT_ERROR (self, STREAM, FAILED,
+          (NULL), ("Failed to create video frame: 0x%08lx",
+              (unsigned long) ret));
+      return GST_FLOW_ERROR;
+    }
+
+    GST_LOG_OBJECT (self, "Copying buffer into video frame");
+
+    dframe->GetBytes ((void **) &outdata);
+    stride =
+        MIN (GST_VIDEO_FRAME_PLANE_STRIDE (&vframe, 0), dframe->GetRowBytes ());
+    for (i = 0; i < self->info.height; i++) {
+      memcpy (outdata, indata, stride);
+      indata += GST_VIDEO_FRAME_PLANE_STRIDE (&vframe, 0);
+      outdata += dframe->GetRowBytes ();
+    }
+    gst_video_frame_unmap (&vframe);
+
+    frame = new GstDecklinkVideoFrame (dframe);
   }
-  gst_video_frame_unmap (&vframe);
 
   tc_meta = gst_buffer_get_video_time_code_meta (buffer);
   if (tc_meta) {
-    BMDTimecodeFlags bflags = (BMDTimecodeFlags) 0;
     gchar *tc_str;
 
-    if (((GstVideoTimeCodeFlags) (tc_meta->tc.
-                config.flags)) & GST_VIDEO_TIME_CODE_FLAGS_DROP_FRAME)
-      bflags = (BMDTimecodeFlags) (bflags | bmdTimecodeIsDropFrame);
-    else
-      bflags = (BMDTimecodeFlags) (bflags | bmdTimecodeFlagDefault);
-    if (tc_meta->tc.field_count == 2)
-      bflags = (BMDTimecodeFlags) (bflags | bmdTimecodeFieldMark);
+    frame->SetTimecode (self->timecode_format, &tc_meta->tc);
 
     tc_str = gst_video_time_code_to_string (&tc_meta->tc);
-    ret = frame->SetTimecodeFromComponents (self->timecode_format,
-        (uint8_t) tc_meta->tc.hours,
-        (uint8_t) tc_meta->tc.minutes,
-        (uint8_t) tc_meta->tc.seconds, (uint8_t) tc_meta->tc.frames, bflags);
-    if (ret != S_OK) {
-      GST_ERROR_OBJECT (self,
-          "Failed to set timecode %s to video frame: 0x%08lx", tc_str,
-          (unsigned long) ret);
-      flow_ret = GST_FLOW_ERROR;
-      g_free (tc_str);
-      goto out;
-    }
     GST_DEBUG_OBJECT (self, "Set frame timecode to %s", tc_str);
     g_free (tc_str);
   }
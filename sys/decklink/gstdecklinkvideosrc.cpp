@@ -149,6 +149,7 @@ GST_DEBUG_CATEGORY_STATIC (gst_decklink_video_src_debug);
 #define DEFAULT_DROP_NO_SIGNAL_FRAMES (FALSE)
 #define DEFAULT_OUTPUT_CC (FALSE)
 #define DEFAULT_OUTPUT_AFD_BAR (FALSE)
+#define DEFAULT_FRAME_ALIGNMENT (64)
 
 #ifndef ABSDIFF
 #define ABSDIFF(x, y) ( (x) > (y) ? ((x) - (y)) : ((y) - (x)) )
@@ -171,6 +172,7 @@ enum
   PROP_HW_SERIAL_NUMBER,
   PROP_OUTPUT_CC,
   PROP_OUTPUT_AFD_BAR,
+  PROP_FRAME_ALIGNMENT,
 };
 
 typedef struct
@@ -372,6 +374,22 @@ gst_decklink_video_src_class_init (GstDecklinkVideoSrcClass * klass)
           DEFAULT_OUTPUT_AFD_BAR,
           (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
+  /**
+   * GstDecklinkVideoSrc:frame-alignment:
+   *
+   * Alignment in bytes of the memory the device captures frames into.
+   * Captured frames are output without copying, so this is also the
+   * alignment of the output buffers. Rounded up to a power of two. Use the
+   * page size to allow downstream to register the memory for DMA.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_FRAME_ALIGNMENT,
+      g_param_spec_uint ("frame-alignment", "Frame Alignment",
+          "Alignment in bytes of the captured frames (applied on start)",
+          16, 65536, DEFAULT_FRAME_ALIGNMENT,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
   templ_caps = gst_decklink_mode_get_template_caps (TRUE);
   gst_element_class_add_pad_template (element_class,
       gst_pad_template_new ("src", GST_PAD_SRC, GST_PAD_ALWAYS, templ_caps));
@@ -404,6 +422,7 @@ gst_decklink_video_src_init (GstDecklinkVideoSrc * self)
   self->drop_no_signal_frames = DEFAULT_DROP_NO_SIGNAL_FRAMES;
   self->output_cc = DEFAULT_OUTPUT_CC;
   self->output_afd_bar = DEFAULT_OUTPUT_AFD_BAR;
+  self->frame_alignment = DEFAULT_FRAME_ALIGNMENT;
 
   self->window_size = 64;
   self->times = g_new (GstClockTime, 4 * self->window_size);
@@ -494,6 +513,10 @@ gst_decklink_video_src_set_property (GObject * object, guint property_id,
     case PROP_OUTPUT_AFD_BAR:
       self->output_afd_bar = g_value_get_boolean (value);
       break;
+    case PROP_FRAME_ALIGNMENT:
+      self->frame_alignment = g_bit_storage (g_value_get_uint (value) - 1);
+      self->frame_alignment = 1 << self->frame_alignment;
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -553,6 +576,9 @@ gst_decklink_video_src_get_property (GObject * object, guint property_id,
     case PROP_OUTPUT_AFD_BAR:
       g_value_set_boolean (value, self->output_afd_bar);
       break;
+    case PROP_FRAME_ALIGNMENT:
+      g_value_set_uint (value, self->frame_alignment);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
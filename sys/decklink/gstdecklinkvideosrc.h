@@ -112,6 +112,8 @@ struct _GstDecklinkVideoSrc
   gint last_afd_bar_vbi_line;
   gint last_afd_bar_vbi_line_field2;
 
+  guint frame_alignment;
+
   guint skipped_last;
   GstClockTime skip_from_timestamp;
   GstClockTime skip_to_timestamp;
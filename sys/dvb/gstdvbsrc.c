@@ -97,6 +97,7 @@
 #include <gst/gst.h>
 #include <gst/glib-compat-private.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <sys/poll.h>
 #include <fcntl.h>
 #include <errno.h>
@@ -198,7 +199,8 @@ enum
   ARG_DVBSRC_LNB_SLOF,
   ARG_DVBSRC_LNB_LOF1,
   ARG_DVBSRC_LNB_LOF2,
-  ARG_DVBSRC_INTERLEAVING
+  ARG_DVBSRC_INTERLEAVING,
+  ARG_DVBSRC_MMAP_BUFFERS
 };
 
 #define DEFAULT_ADAPTER 0
@@ -221,7 +223,9 @@ enum
 #define DEFAULT_TIMEOUT 1000000 /* 1 second */
 #define DEFAULT_TUNING_TIMEOUT 10 * GST_SECOND  /* 10 seconds */
 #define DEFAULT_DVB_BUFFER_SIZE (10*188*1024)   /* kernel default is 8192 */
-#define DEFAULT_BUFFER_SIZE 8192        /* not a property */
+#define DEFAULT_BUFFER_SIZE 8192        /* default blocksize */
+#define DEFAULT_MMAP_BUFFERS 0
+#define TS_PACKET_SIZE 188
 #define DEFAULT_DELSYS SYS_UNDEFINED
 #define DEFAULT_PILOT PILOT_AUTO
 #define DEFAULT_ROLLOFF ROLLOFF_AUTO
@@ -543,6 +547,8 @@ static void gst_dvbsrc_get_property (GObject * object, guint prop_id,
 
 static GstFlowReturn gst_dvbsrc_create (GstPushSrc * element,
     GstBuffer ** buffer);
+static gboolean gst_dvbsrc_decide_allocation (GstBaseSrc * bsrc,
+    GstQuery * query);
 
 static gboolean gst_dvbsrc_start (GstBaseSrc * bsrc);
 static gboolean gst_dvbsrc_stop (GstBaseSrc * bsrc);
@@ -583,6 +589,59 @@ static gboolean gst_dvbsrc_is_valid_bandwidth (guint delsys, guint bw);
 #define LOOP_WHILE_EINTR(v,func) do { (v) = (func); } \
 		while ((v) == -1 && errno == EINTR);
 
+#ifdef DMX_REQBUFS
+/* The buffers of the DVR device mapped into our address space, kept alive
+ * until the last buffer wrapping one of them was freed */
+struct _GstDvbSrcMmap
+{
+  gint refcount;
+  gint fd;
+  guint n_buffers;
+  gsize length;
+  guint8 **data;
+};
+
+typedef struct
+{
+  GstDvbSrcMmap *mmap;
+  guint index;
+} GstDvbSrcMmapBuffer;
+
+static void
+gst_dvbsrc_mmap_unref (GstDvbSrcMmap * mmap_info)
+{
+  guint i;
+
+  if (!g_atomic_int_dec_and_test (&mmap_info->refcount))
+    return;
+
+  for (i = 0; i < mmap_info->n_buffers; i++) {
+    if (mmap_info->data[i])
+      munmap (mmap_info->data[i], mmap_info->length);
+  }
+  close (mmap_info->fd);
+  g_free (mmap_info->data);
+  g_free (mmap_info);
+}
+
+/* gives the buffer back to the driver once downstream is done with it */
+static void
+gst_dvbsrc_mmap_buffer_free (GstDvbSrcMmapBuffer * mbuf)
+{
+  struct dmx_buffer b = { 0, };
+  gint err;
+
+  b.index = mbuf->index;
+  LOOP_WHILE_EINTR (err, ioctl (mbuf->mmap->fd, DMX_QBUF, &b));
+  if (err)
+    GST_WARNING ("failed to queue DVR buffer %u: %s", mbuf->index,
+        g_strerror (errno));
+
+  gst_dvbsrc_mmap_unref (mbuf->mmap);
+  g_free (mbuf);
+}
+#endif
+
 static GstStaticPadTemplate ts_src_factory = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
@@ -641,6 +700,8 @@ gst_dvbsrc_class_init (GstDvbSrcClass * klass)
   gstbasesrc_class->unlock_stop = GST_DEBUG_FUNCPTR (gst_dvbsrc_unlock_stop);
   gstbasesrc_class->is_seekable = GST_DEBUG_FUNCPTR (gst_dvbsrc_is_seekable);
   gstbasesrc_class->get_size = GST_DEBUG_FUNCPTR (gst_dvbsrc_get_size);
+  gstbasesrc_class->decide_allocation =
+      GST_DEBUG_FUNCPTR (gst_dvbsrc_decide_allocation);
 
   gstpushsrc_class->create = GST_DEBUG_FUNCPTR (gst_dvbsrc_create);
 
@@ -969,6 +1030,23 @@ gst_dvbsrc_class_init (GstDvbSrcClass * klass)
           GST_TYPE_INTERLEAVING, DEFAULT_INTERLEAVING,
           GST_PARAM_MUTABLE_PLAYING | G_PARAM_READWRITE));
 
+  /**
+   * GstDvbSrc:mmap-buffers:
+   *
+   * Number of buffers of the DVR device to map into memory and push
+   * downstream without copying, each of the blocksize. This needs a kernel
+   * with DVB memory mapping support, otherwise the element falls back to
+   * reading from the device. 0 always reads from the device.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class,
+      ARG_DVBSRC_MMAP_BUFFERS,
+      g_param_spec_uint ("mmap-buffers", "Memory-mapped buffers",
+          "Number of memory-mapped DVR buffers, or 0 to read from the DVR "
+          "device (applied on start)", 0, 64, DEFAULT_MMAP_BUFFERS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /**
    * GstDvbSrc::tuning-start:
    * @gstdvbsrc: the element on which the signal is emitted
@@ -1057,6 +1135,11 @@ gst_dvbsrc_init (GstDvbSrc * object)
   object->pids[0] = 8192;
   object->pids[1] = G_MAXUINT16;
   object->dvb_buffer_size = DEFAULT_DVB_BUFFER_SIZE;
+  object->mmap_buffers = DEFAULT_MMAP_BUFFERS;
+
+  /* reads of up to this size, rounded to whole packets, are pushed as one
+   * buffer. Raise it when capturing whole transponders */
+  gst_base_src_set_blocksize (GST_BASE_SRC (object), DEFAULT_BUFFER_SIZE);
 
   adapter = g_getenv ("GST_DVB_ADAPTER");
   if (adapter)
@@ -1363,6 +1446,9 @@ gst_dvbsrc_set_property (GObject * _object, guint prop_id,
     case ARG_DVBSRC_INTERLEAVING:
       object->interleaving = g_value_get_enum (value);
       break;
+    case ARG_DVBSRC_MMAP_BUFFERS:
+      object->mmap_buffers = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -1535,6 +1621,9 @@ gst_dvbsrc_get_property (GObject * _object, guint prop_id,
     case ARG_DVBSRC_INTERLEAVING:
       g_value_set_enum (value, object->interleaving);
       break;
+    case ARG_DVBSRC_MMAP_BUFFERS:
+      g_value_set_uint (value, object->mmap_buffers);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -1545,6 +1634,13 @@ gst_dvbsrc_close_devices (GstDvbSrc * object)
 {
   gst_dvbsrc_unset_pes_filters (object);
 
+#ifdef DMX_REQBUFS
+  if (object->mmap) {
+    gst_dvbsrc_mmap_unref (object->mmap);
+    object->mmap = NULL;
+  }
+#endif
+
   close (object->fd_dvr);
   object->fd_dvr = -1;
   close (object->fd_frontend);
@@ -1826,6 +1922,79 @@ gst_dvbsrc_open_dvr (GstDvbSrc * object)
   return TRUE;
 }
 
+static guint
+gst_dvbsrc_get_read_size (GstDvbSrc * object)
+{
+  guint size = gst_base_src_get_blocksize (GST_BASE_SRC (object));
+
+  /* only read whole packets */
+  return MAX (size - size % TS_PACKET_SIZE, TS_PACKET_SIZE);
+}
+
+#ifdef DMX_REQBUFS
+static void
+gst_dvbsrc_setup_mmap (GstDvbSrc * object)
+{
+  struct dmx_requestbuffers req = { 0, };
+  GstDvbSrcMmap *mmap_info;
+  guint i;
+  gint err;
+
+  req.count = object->mmap_buffers;
+  req.size = gst_dvbsrc_get_read_size (object);
+
+  LOOP_WHILE_EINTR (err, ioctl (object->fd_dvr, DMX_REQBUFS, &req));
+  if (err || req.count == 0) {
+    GST_WARNING_OBJECT (object, "DVR device can't be memory-mapped (%s), "
+        "reading from it instead", g_strerror (errno));
+    return;
+  }
+
+  mmap_info = g_new0 (GstDvbSrcMmap, 1);
+  mmap_info->refcount = 1;
+  mmap_info->fd = dup (object->fd_dvr);
+  mmap_info->n_buffers = req.count;
+  mmap_info->length = req.size;
+  mmap_info->data = g_new0 (guint8 *, req.count);
+
+  for (i = 0; i < req.count; i++) {
+    struct dmx_buffer b = { 0, };
+    gpointer data;
+
+    b.index = i;
+    LOOP_WHILE_EINTR (err, ioctl (object->fd_dvr, DMX_QUERYBUF, &b));
+    if (err)
+      goto error;
+
+    data = mmap (NULL, b.length, PROT_READ, MAP_SHARED, object->fd_dvr,
+        b.offset);
+    if (data == MAP_FAILED)
+      goto error;
+    mmap_info->data[i] = (guint8 *) data;
+    mmap_info->length = b.length;
+
+    LOOP_WHILE_EINTR (err, ioctl (object->fd_dvr, DMX_QBUF, &b));
+    if (err)
+      goto error;
+  }
+
+  GST_INFO_OBJECT (object, "Capturing into %u memory-mapped buffers of %"
+      G_GSIZE_FORMAT " bytes", mmap_info->n_buffers, mmap_info->length);
+  object->mmap = mmap_info;
+
+  return;
+
+error:
+  GST_WARNING_OBJECT (object, "Failed to map DVR buffer %u (%s), reading "
+      "from the device instead", i, g_strerror (errno));
+  gst_dvbsrc_mmap_unref (mmap_info);
+
+  /* and release the buffers again */
+  req.count = 0;
+  LOOP_WHILE_EINTR (err, ioctl (object->fd_dvr, DMX_REQBUFS, &req));
+}
+#endif
+
 static void
 gst_dvbsrc_finalize (GObject * _object)
 {
@@ -1868,20 +2037,112 @@ gst_dvbsrc_plugin_init (GstPlugin * plugin)
       GST_TYPE_DVBSRC);
 }
 
+#ifdef DMX_REQBUFS
+static GstFlowReturn
+gst_dvbsrc_read_mmap (GstDvbSrc * object, GstBuffer ** buffer)
+{
+  GstDvbSrcMmap *mmap_info = object->mmap;
+  GstClockTime timeout = object->timeout * GST_USECOND;
+  GstDvbSrcMmapBuffer *mbuf;
+  struct dmx_buffer b;
+  gint ret_val = 0;
+  GstBuffer *buf;
+
+  while (TRUE) {
+    ret_val = gst_poll_wait (object->poll, timeout);
+    GST_LOG_OBJECT (object, "select returned %d", ret_val);
+    if (G_UNLIKELY (ret_val < 0)) {
+      if (errno == EBUSY)
+        goto stopped;
+      else if (errno == EINTR)
+        continue;
+      else
+        goto select_error;
+    } else if (G_UNLIKELY (!ret_val)) {
+      /* timeout, post element message */
+      gst_element_post_message (GST_ELEMENT_CAST (object),
+          gst_message_new_element (GST_OBJECT (object),
+              gst_structure_new_empty ("dvb-read-failure")));
+      continue;
+    }
+
+    memset (&b, 0, sizeof (b));
+    if (ioctl (object->fd_dvr, DMX_DQBUF, &b) < 0) {
+      if (errno == EAGAIN || errno == EINTR)
+        continue;
+
+      GST_WARNING_OBJECT (object,
+          "Unable to dequeue buffer from device: /dev/dvb/adapter%d/dvr%d "
+          "(%d)", object->adapter_number, object->frontend_number, errno);
+      gst_element_post_message (GST_ELEMENT_CAST (object),
+          gst_message_new_element (GST_OBJECT (object),
+              gst_structure_new_empty ("dvb-read-failure")));
+      continue;
+    }
+
+    if (G_LIKELY (b.index < mmap_info->n_buffers))
+      break;
+  }
+
+  mbuf = g_new (GstDvbSrcMmapBuffer, 1);
+  mbuf->mmap = mmap_info;
+  mbuf->index = b.index;
+  g_atomic_int_inc (&mmap_info->refcount);
+
+  buf = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+      mmap_info->data[b.index], mmap_info->length, 0,
+      MIN (b.bytesused, mmap_info->length), mbuf,
+      (GDestroyNotify) gst_dvbsrc_mmap_buffer_free);
+
+  if (b.flags & (DMX_BUFFER_FLAG_DISCONTINUITY_DETECTED |
+          DMX_BUFFER_PKT_COUNTER_MISMATCH))
+    GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DISCONT);
+
+  *buffer = buf;
+
+  return GST_FLOW_OK;
+
+stopped:
+  {
+    GST_DEBUG_OBJECT (object, "stop called");
+    return GST_FLOW_FLUSHING;
+  }
+select_error:
+  {
+    GST_ELEMENT_ERROR (object, RESOURCE, READ, (NULL),
+        ("select error %d: %s (%d)", ret_val, g_strerror (errno), errno));
+    return GST_FLOW_ERROR;
+  }
+}
+#endif
+
 static GstFlowReturn
 gst_dvbsrc_read_device (GstDvbSrc * object, int size, GstBuffer ** buffer)
 {
   gint count = 0;
   gint ret_val = 0;
-  GstBuffer *buf = gst_buffer_new_and_alloc (size);
+  GstBuffer *buf = NULL;
   GstClockTime timeout = object->timeout * GST_USECOND;
+  GstFlowReturn flow;
   GstMapInfo map;
 
-  g_return_val_if_fail (GST_IS_BUFFER (buf), GST_FLOW_ERROR);
-
   if (object->fd_dvr < 0)
     return GST_FLOW_ERROR;
 
+#ifdef DMX_REQBUFS
+  if (object->mmap)
+    return gst_dvbsrc_read_mmap (object, buffer);
+#endif
+
+  /* from the pool set up in decide_allocation */
+  flow = GST_BASE_SRC_GET_CLASS (object)->alloc (GST_BASE_SRC (object), -1,
+      size, &buf);
+  if (flow != GST_FLOW_OK)
+    return flow;
+
+  if (gst_buffer_get_size (buf) < size)
+    size = gst_buffer_get_size (buf);
+
   gst_buffer_map (buf, &map, GST_MAP_WRITE);
   while (count < size) {
     ret_val = gst_poll_wait (object->poll, timeout);
@@ -1948,7 +2209,7 @@ gst_dvbsrc_create (GstPushSrc * element, GstBuffer ** buf)
   object = GST_DVBSRC (element);
   GST_LOG ("fd_dvr: %d", object->fd_dvr);
 
-  buffer_size = DEFAULT_BUFFER_SIZE;
+  buffer_size = gst_dvbsrc_get_read_size (object);
 
   /* device can not be tuned during read */
   g_mutex_lock (&object->tune_mutex);
@@ -2028,6 +2289,15 @@ gst_dvbsrc_start (GstBaseSrc * bsrc)
   gst_poll_add_fd (src->poll, &src->poll_fd_dvr);
   gst_poll_fd_ctl_read (src->poll, &src->poll_fd_dvr, TRUE);
 
+#ifdef DMX_REQBUFS
+  if (src->mmap_buffers > 0)
+    gst_dvbsrc_setup_mmap (src);
+#else
+  if (src->mmap_buffers > 0)
+    GST_WARNING_OBJECT (src, "Memory-mapped capture not supported by the "
+        "DVB headers, reading from the DVR device instead");
+#endif
+
   return TRUE;
 
 fail:
@@ -2036,6 +2306,24 @@ fail:
   return FALSE;
 }
 
+/* Reuse the buffers the DVR device is read into instead of allocating a
+ * new one for every read */
+static gboolean
+gst_dvbsrc_decide_allocation (GstBaseSrc * bsrc, GstQuery * query)
+{
+  GstDvbSrc *src = GST_DVBSRC (bsrc);
+
+  if (gst_query_get_n_allocation_pools (query) == 0) {
+    GstBufferPool *pool = gst_buffer_pool_new ();
+
+    gst_query_add_allocation_pool (query, pool,
+        gst_dvbsrc_get_read_size (src), 2, 0);
+    gst_object_unref (pool);
+  }
+
+  return GST_BASE_SRC_CLASS (parent_class)->decide_allocation (bsrc, query);
+}
+
 static gboolean
 gst_dvbsrc_stop (GstBaseSrc * bsrc)
 {
@@ -54,6 +54,7 @@ G_BEGIN_DECLS
   (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_DVBSRC))
 
 typedef struct _GstDvbSrc GstDvbSrc;
+typedef struct _GstDvbSrcMmap GstDvbSrcMmap;
 typedef struct _GstDvbSrcClass GstDvbSrcClass;
 typedef struct _GstDvbSrcParam GstDvbSrcParam;
 
@@ -103,6 +104,8 @@ struct _GstDvbSrc
   gboolean need_unlock;
 
   guint dvb_buffer_size;
+  guint mmap_buffers;
+  GstDvbSrcMmap *mmap;
 
   unsigned int isdbt_layer_enabled;
   int isdbt_partial_reception;
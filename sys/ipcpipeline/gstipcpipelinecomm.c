@@ -33,8 +33,14 @@
 #endif
 #include <errno.h>
 #include <string.h>
+#ifdef G_OS_UNIX
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#endif
 #include <gst/base/gstbytewriter.h>
 #include <gst/gstprotection.h>
+#include <gst/allocators/allocators.h>
 #include "gstipcpipelinecomm.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_ipc_pipeline_comm_debug);
@@ -42,6 +48,14 @@ GST_DEBUG_CATEGORY_STATIC (gst_ipc_pipeline_comm_debug);
 
 #define DEFAULT_ACK_TIME (10 * G_TIME_SPAN_SECOND)
 
+/* system memory payloads smaller than this are written to the socket */
+#define FD_PAYLOAD_MIN_SIZE 16384
+/* the most fds we expect to receive along with a single read */
+#define MAX_RECEIVED_FDS 16
+
+/* flags of a buffer fd payload */
+#define COMM_FD_DMABUF (1 << 0)
+
 GQuark QUARK_ID;
 
 typedef enum
@@ -69,6 +83,8 @@ typedef struct
   GstQuery *query;
   CommRequestType type;
   GCond cond;
+  /* buffer sent without waiting, nobody waits on the cond */
+  gboolean async;
 } CommRequest;
 
 static const gchar *comm_request_ret_get_name (CommRequestType type,
@@ -88,6 +104,7 @@ comm_request_new (guint32 id, CommRequestType type, GstQuery * query)
   req->query = query;
   req->ret = comm_request_ret_get_failure_value (type);
   req->type = type;
+  req->async = FALSE;
 
   return req;
 }
@@ -178,6 +195,8 @@ gst_ipc_pipeline_comm_data_type_get_name (GstIpcPipelineCommDataType type)
       return "QUERY_RESULT";
     case GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER:
       return "BUFFER";
+    case GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER_FD:
+      return "BUFFER_FD";
     case GST_IPC_PIPELINE_COMM_DATA_TYPE_EVENT:
       return "EVENT";
     case GST_IPC_PIPELINE_COMM_DATA_TYPE_SINK_MESSAGE_EVENT:
@@ -246,6 +265,58 @@ done:
   return ret;
 }
 
+#ifdef G_OS_UNIX
+static gboolean
+fd_is_socket (int fd)
+{
+  struct stat st;
+
+  return fd >= 0 && fstat (fd, &st) == 0 && S_ISSOCK (st.st_mode);
+}
+
+/* Sends @fd along with the first bytes of @data */
+static gboolean
+write_to_fd_with_fd (GstIpcPipelineComm * comm, const void *data,
+    size_t size, int fd)
+{
+  struct msghdr msg = { 0, };
+  struct iovec iov;
+  union
+  {
+    struct cmsghdr hdr;
+    char buf[CMSG_SPACE (sizeof (int))];
+  } cmsg;
+  ssize_t written;
+
+  memset (&cmsg, 0, sizeof (cmsg));
+  iov.iov_base = (void *) data;
+  iov.iov_len = size;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = cmsg.buf;
+  msg.msg_controllen = sizeof (cmsg.buf);
+  cmsg.hdr.cmsg_level = SOL_SOCKET;
+  cmsg.hdr.cmsg_type = SCM_RIGHTS;
+  cmsg.hdr.cmsg_len = CMSG_LEN (sizeof (int));
+  memcpy (CMSG_DATA (&cmsg.hdr), &fd, sizeof (int));
+
+  GST_TRACE_OBJECT (comm->element, "Writing %u bytes with fd %d to fdout",
+      (unsigned) size, fd);
+  do {
+    written = sendmsg (comm->fdout, &msg, 0);
+  } while (written < 0 && (errno == EAGAIN || errno == EINTR));
+
+  if (written < 0) {
+    GST_ERROR_OBJECT (comm->element, "Failed to send fd: %s",
+        strerror (errno));
+    return FALSE;
+  }
+
+  return write_to_fd_raw (comm, (const guint8 *) data + written,
+      size - written);
+}
+#endif
+
 static gboolean
 write_byte_writer_to_fd (GstIpcPipelineComm * comm, GstByteWriter * bw)
 {
@@ -503,11 +574,96 @@ typedef struct
   guint64 flags;
 } CommBufferMetadata;
 
+/* Returns an fd holding the payload of @buffer if it can be sent that way,
+ * or -1. DMABuf and other fd memory is passed as is, other big enough
+ * payloads are copied into a memfd, which saves copying them through the
+ * socket on both ends */
+static int
+gst_ipc_pipeline_comm_get_payload_fd (GstIpcPipelineComm * comm,
+    GstBuffer * buffer, guint32 * flags, guint64 * fd_size,
+    guint64 * fd_offset, gboolean * close_fd)
+{
+#ifdef G_OS_UNIX
+  gsize size = gst_buffer_get_size (buffer);
+
+  if (!comm->pass_fds || size == 0)
+    return -1;
+
+  if (comm->checked_fdout != comm->fdout) {
+    comm->checked_fdout = comm->fdout;
+    comm->fdout_is_socket = fd_is_socket (comm->fdout);
+    if (!comm->fdout_is_socket)
+      GST_WARNING_OBJECT (comm->element, "fdout %d is not a socket, can't "
+          "pass fds", comm->fdout);
+  }
+  if (!comm->fdout_is_socket)
+    return -1;
+
+  if (gst_buffer_n_memory (buffer) == 1) {
+    GstMemory *mem = gst_buffer_peek_memory (buffer, 0);
+
+    if (gst_is_fd_memory (mem)) {
+      gsize offset, maxsize;
+
+      gst_memory_get_sizes (mem, &offset, &maxsize);
+      *flags = gst_is_dmabuf_memory (mem) ? COMM_FD_DMABUF : 0;
+      *fd_size = maxsize;
+      *fd_offset = offset;
+      *close_fd = FALSE;
+      return gst_fd_memory_get_fd (mem);
+    }
+  }
+#ifdef HAVE_MEMFD_CREATE
+  if (size >= FD_PAYLOAD_MIN_SIZE) {
+    guint8 *data;
+    int fd;
+
+    fd = memfd_create ("gst-ipc-pipeline", MFD_CLOEXEC);
+    if (fd < 0) {
+      GST_WARNING_OBJECT (comm->element, "Failed to create memfd: %s",
+          strerror (errno));
+      return -1;
+    }
+    if (ftruncate (fd, size) < 0 ||
+        (data = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                0)) == MAP_FAILED) {
+      GST_WARNING_OBJECT (comm->element, "Failed to map memfd: %s",
+          strerror (errno));
+      close (fd);
+      return -1;
+    }
+    gst_buffer_extract (buffer, 0, data, size);
+    munmap (data, size);
+
+    *flags = 0;
+    *fd_size = size;
+    *fd_offset = 0;
+    *close_fd = TRUE;
+    return fd;
+  }
+#endif
+#endif
+
+  return -1;
+}
+
+/* Called with the comm lock. Waits until there is room for another buffer
+ * that does not wait for its ack */
+static void
+gst_ipc_pipeline_comm_wait_pending (GstIpcPipelineComm * comm)
+{
+  while (comm->n_pending_buffers >= comm->max_pending_buffers) {
+    GST_TRACE_OBJECT (comm->element, "Waiting for one of %u buffer acks",
+        comm->n_pending_buffers);
+    g_cond_wait (&comm->pending_cond, &comm->mutex);
+  }
+}
+
 GstFlowReturn
 gst_ipc_pipeline_comm_write_buffer_to_fd (GstIpcPipelineComm * comm,
     GstBuffer * buffer)
 {
-  const unsigned char payload_type = GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER;
+  unsigned char payload_type = GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER;
   GstMapInfo map;
   guint32 ret32 = GST_FLOW_OK;
   guint32 size, n;
@@ -515,15 +671,36 @@ gst_ipc_pipeline_comm_write_buffer_to_fd (GstIpcPipelineComm * comm,
   GstFlowReturn ret;
   MetaListRepresentation repr = { comm, 0, 4, NULL };   /* starts a 4 for n_meta */
   GstByteWriter bw;
+  guint32 fd_flags = 0;
+  guint64 fd_size = 0, fd_offset = 0;
+  gboolean close_fd = FALSE;
+  int fd;
+
+  /* outside of the lock, this might copy the payload */
+  fd = gst_ipc_pipeline_comm_get_payload_fd (comm, buffer, &fd_flags,
+      &fd_size, &fd_offset, &close_fd);
+  if (fd >= 0)
+    payload_type = GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER_FD;
 
   g_mutex_lock (&comm->mutex);
+  gst_byte_writer_init (&bw);
+
+  if (comm->max_pending_buffers > 0) {
+    gst_ipc_pipeline_comm_wait_pending (comm);
+    /* report errors of earlier buffers */
+    if (comm->pending_ret != GST_FLOW_OK) {
+      ret = comm->pending_ret;
+      GST_DEBUG_OBJECT (comm->element, "Earlier buffer returned %s",
+          gst_flow_get_name (ret));
+      goto done;
+    }
+  }
+
   ++comm->send_id;
 
   GST_TRACE_OBJECT (comm->element, "Writing buffer %u: %" GST_PTR_FORMAT,
       comm->send_id, buffer);
 
-  gst_byte_writer_init (&bw);
-
   meta.pts = GST_BUFFER_PTS (buffer);
   meta.dts = GST_BUFFER_DTS (buffer);
   meta.duration = GST_BUFFER_DURATION (buffer);
@@ -538,25 +715,49 @@ gst_ipc_pipeline_comm_write_buffer_to_fd (GstIpcPipelineComm * comm,
     goto write_failed;
   if (!gst_byte_writer_put_uint32_le (&bw, comm->send_id))
     goto write_failed;
-  size =
-      gst_buffer_get_size (buffer) + sizeof (guint32) +
-      sizeof (CommBufferMetadata) + repr.total_bytes;
+  if (fd >= 0)
+    size = sizeof (guint32) + 2 * sizeof (guint64);
+  else
+    size = gst_buffer_get_size (buffer);
+  size += sizeof (guint32) + sizeof (CommBufferMetadata) + repr.total_bytes;
   if (!gst_byte_writer_put_uint32_le (&bw, size))
     goto write_failed;
   if (!gst_byte_writer_put_data (&bw, (const guint8 *) &meta, sizeof (meta)))
     goto write_failed;
+  if (fd >= 0) {
+    if (!gst_byte_writer_put_uint32_le (&bw, fd_flags))
+      goto write_failed;
+    if (!gst_byte_writer_put_uint64_le (&bw, fd_size))
+      goto write_failed;
+    if (!gst_byte_writer_put_uint64_le (&bw, fd_offset))
+      goto write_failed;
+  }
   size = gst_buffer_get_size (buffer);
   if (!gst_byte_writer_put_uint32_le (&bw, size))
     goto write_failed;
-  if (!write_byte_writer_to_fd (comm, &bw))
-    goto write_failed;
 
-  if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
-    goto map_failed;
-  ret = write_to_fd_raw (comm, map.data, map.size);
-  gst_buffer_unmap (buffer, &map);
-  if (!ret)
-    goto write_failed;
+  if (fd >= 0) {
+#ifdef G_OS_UNIX
+    guint8 *data;
+    guint data_size = gst_byte_writer_get_size (&bw);
+
+    data = gst_byte_writer_reset_and_get_data (&bw);
+    ret = write_to_fd_with_fd (comm, data, data_size, fd);
+    g_free (data);
+    if (!ret)
+      goto write_failed;
+#endif
+  } else {
+    if (!write_byte_writer_to_fd (comm, &bw))
+      goto write_failed;
+
+    if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+      goto map_failed;
+    ret = write_to_fd_raw (comm, map.data, map.size);
+    gst_buffer_unmap (buffer, &map);
+    if (!ret)
+      goto write_failed;
+  }
 
   /* meta */
   gst_byte_writer_init (&bw);
@@ -595,10 +796,23 @@ gst_ipc_pipeline_comm_write_buffer_to_fd (GstIpcPipelineComm * comm,
   if (!write_byte_writer_to_fd (comm, &bw))
     goto write_failed;
 
-  if (!gst_ipc_pipeline_comm_sync_fd (comm, comm->send_id, NULL, &ret32,
-          ACK_TYPE_BLOCKING, COMM_REQUEST_TYPE_BUFFER))
-    goto wait_failed;
-  ret = ret32;
+  if (comm->max_pending_buffers > 0) {
+    CommRequest *req;
+
+    /* The ack is handled by the reader thread, errors are returned for one
+     * of the following buffers */
+    req = comm_request_new (comm->send_id, COMM_REQUEST_TYPE_BUFFER, NULL);
+    req->async = TRUE;
+    g_hash_table_insert (comm->waiting_ids, GINT_TO_POINTER (comm->send_id),
+        req);
+    comm->n_pending_buffers++;
+    ret = GST_FLOW_OK;
+  } else {
+    if (!gst_ipc_pipeline_comm_sync_fd (comm, comm->send_id, NULL, &ret32,
+            ACK_TYPE_BLOCKING, COMM_REQUEST_TYPE_BUFFER))
+      goto wait_failed;
+    ret = ret32;
+  }
 
 done:
   g_mutex_unlock (&comm->mutex);
@@ -606,6 +820,11 @@ done:
   for (n = 0; n < repr.n_meta; ++n)
     g_free (repr.info[n].str);
   g_free (repr.info);
+#ifdef G_OS_UNIX
+  /* the peer has its own copy of the fd now */
+  if (close_fd)
+    close (fd);
+#endif
   return ret;
 
 write_failed:
@@ -627,37 +846,105 @@ map_failed:
   goto done;
 }
 
+/* Wraps the next fd we received from the peer. Only the reader thread
+ * touches the received fds */
 static GstBuffer *
-gst_ipc_pipeline_comm_read_buffer (GstIpcPipelineComm * comm, guint32 size)
+gst_ipc_pipeline_comm_import_fd (GstIpcPipelineComm * comm, guint32 flags,
+    guint64 fd_size, guint64 fd_offset, guint32 size)
+{
+#ifdef G_OS_UNIX
+  GstBuffer *buffer;
+  GstMemory *mem;
+  int fd;
+
+  if (g_queue_is_empty (&comm->received_fds)) {
+    GST_ERROR_OBJECT (comm->element, "Got buffer fd payload without fd");
+    return NULL;
+  }
+  fd = GPOINTER_TO_INT (g_queue_pop_head (&comm->received_fds));
+
+  if (fd_offset + size > fd_size) {
+    GST_ERROR_OBJECT (comm->element, "Invalid fd payload at %"
+        G_GUINT64_FORMAT " of size %u in %" G_GUINT64_FORMAT " bytes",
+        fd_offset, size, fd_size);
+    close (fd);
+    return NULL;
+  }
+
+  if (flags & COMM_FD_DMABUF) {
+    if (!comm->dmabuf_allocator)
+      comm->dmabuf_allocator = gst_dmabuf_allocator_new ();
+    mem = gst_dmabuf_allocator_alloc (comm->dmabuf_allocator, fd, fd_size);
+  } else {
+    if (!comm->fd_allocator)
+      comm->fd_allocator = gst_fd_allocator_new ();
+    mem = gst_fd_allocator_alloc (comm->fd_allocator, fd, fd_size,
+        GST_FD_MEMORY_FLAG_NONE);
+  }
+  if (!mem) {
+    GST_ERROR_OBJECT (comm->element, "Failed to wrap fd %d", fd);
+    close (fd);
+    return NULL;
+  }
+  gst_memory_resize (mem, fd_offset, size);
+
+  buffer = gst_buffer_new ();
+  gst_buffer_append_memory (buffer, mem);
+  return buffer;
+#else
+  GST_ERROR_OBJECT (comm->element, "Got buffer fd payload, not supported");
+  return NULL;
+#endif
+}
+
+static GstBuffer *
+gst_ipc_pipeline_comm_read_buffer (GstIpcPipelineComm * comm, guint32 size,
+    gboolean with_fd)
 {
   GstBuffer *buffer;
   CommBufferMetadata meta;
   guint32 n_meta, n;
   const guint8 *payload = NULL;
   guint32 mapped_size, buffer_data_size;
+  guint32 fd_flags = 0;
+  guint64 fd_size = 0, fd_offset = 0;
 
   /* this should not be called if we don't have enough yet */
   g_return_val_if_fail (gst_adapter_available (comm->adapter) >= size, NULL);
   g_return_val_if_fail (size >= sizeof (CommBufferMetadata), NULL);
 
   mapped_size = sizeof (CommBufferMetadata) + sizeof (buffer_data_size);
+  if (with_fd)
+    mapped_size += sizeof (fd_flags) + sizeof (fd_size) + sizeof (fd_offset);
   payload = gst_adapter_map (comm->adapter, mapped_size);
   if (!payload)
     return NULL;
   memcpy (&meta, payload, sizeof (CommBufferMetadata));
   payload += sizeof (CommBufferMetadata);
+  if (with_fd) {
+    fd_flags = GST_READ_UINT32_LE (payload);
+    fd_size = GST_READ_UINT64_LE (payload + 4);
+    fd_offset = GST_READ_UINT64_LE (payload + 12);
+    payload += sizeof (fd_flags) + sizeof (fd_size) + sizeof (fd_offset);
+  }
   memcpy (&buffer_data_size, payload, sizeof (buffer_data_size));
   size -= mapped_size;
   gst_adapter_unmap (comm->adapter);
   gst_adapter_flush (comm->adapter, mapped_size);
 
-  if (buffer_data_size == 0) {
+  if (with_fd) {
+    buffer = gst_ipc_pipeline_comm_import_fd (comm, fd_flags, fd_size,
+        fd_offset, buffer_data_size);
+    if (!buffer)
+      return NULL;
+  } else if (buffer_data_size == 0) {
     buffer = gst_buffer_new ();
   } else {
     buffer = gst_adapter_get_buffer (comm->adapter, buffer_data_size);
     gst_adapter_flush (comm->adapter, buffer_data_size);
   }
-  size -= buffer_data_size;
+  if (!with_fd)
+    size -= buffer_data_size;
 
   GST_BUFFER_PTS (buffer) = meta.pts;
   GST_BUFFER_DTS (buffer) = meta.dts;
@@ -920,6 +1207,10 @@ gst_ipc_pipeline_comm_write_event_to_fd (GstIpcPipelineComm * comm,
   GST_TRACE_OBJECT (comm->element, "Writing event %u: %" GST_PTR_FORMAT,
       comm->send_id, event);
 
+  /* errors returned for buffers before the flush don't matter anymore */
+  if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP)
+    comm->pending_ret = GST_FLOW_OK;
+
   gst_byte_writer_init (&bw);
   if (!gst_byte_writer_put_uint8 (&bw, payload_type))
     goto write_failed;
@@ -1193,6 +1484,9 @@ gst_ipc_pipeline_comm_write_state_change_to_fd (GstIpcPipelineComm * comm,
   g_mutex_lock (&comm->mutex);
   ++comm->send_id;
 
+  if (transition == GST_STATE_CHANGE_READY_TO_PAUSED)
+    comm->pending_ret = GST_FLOW_OK;
+
   GST_TRACE_OBJECT (comm->element, "Writing state change %u: %s -> %s",
       comm->send_id,
       gst_element_state_get_name (GST_STATE_TRANSITION_CURRENT (transition)),
@@ -1614,11 +1908,24 @@ gst_ipc_pipeline_comm_init (GstIpcPipelineComm * comm, GstElement * element)
   comm->adapter = gst_adapter_new ();
   comm->poll = gst_poll_new (TRUE);
   gst_poll_fd_init (&comm->pollFDin);
+  comm->checked_fdout = -1;
+  g_queue_init (&comm->received_fds);
+  comm->pending_ret = GST_FLOW_OK;
+  g_cond_init (&comm->pending_cond);
 }
 
 void
 gst_ipc_pipeline_comm_clear (GstIpcPipelineComm * comm)
 {
+#ifdef G_OS_UNIX
+  while (!g_queue_is_empty (&comm->received_fds))
+    close (GPOINTER_TO_INT (g_queue_pop_head (&comm->received_fds)));
+#endif
+  if (comm->fd_allocator)
+    gst_object_unref (comm->fd_allocator);
+  if (comm->dmabuf_allocator)
+    gst_object_unref (comm->dmabuf_allocator);
+  g_cond_clear (&comm->pending_cond);
   g_hash_table_destroy (comm->waiting_ids);
   gst_object_unref (comm->adapter);
   gst_poll_free (comm->poll);
@@ -1640,6 +1947,14 @@ cancel_request (gpointer key, gpointer value, gpointer user_data,
   g_cond_signal (&req->cond);
 }
 
+static gboolean
+remove_async_request (gpointer key, gpointer value, gpointer user_data)
+{
+  CommRequest *req = (CommRequest *) value;
+
+  return req->async;
+}
+
 static void
 cancel_request_error (gpointer key, gpointer value, gpointer user_data)
 {
@@ -1653,6 +1968,10 @@ void
 gst_ipc_pipeline_comm_cancel (GstIpcPipelineComm * comm, gboolean cleanup)
 {
   g_mutex_lock (&comm->mutex);
+  /* nobody waits for the acks of those */
+  g_hash_table_foreach_remove (comm->waiting_ids, remove_async_request, comm);
+  comm->n_pending_buffers = 0;
+  g_cond_broadcast (&comm->pending_cond);
   g_hash_table_foreach (comm->waiting_ids, cancel_request_error, comm);
   if (cleanup) {
     g_hash_table_unref (comm->waiting_ids);
@@ -1687,6 +2006,16 @@ gst_ipc_pipeline_comm_reply_request (GstIpcPipelineComm * comm, guint32 id,
 
   GST_TRACE_OBJECT (comm->element, "Got reply %d (%s) for request %u", ret,
       comm_request_ret_get_name (req->type, ret), req->id);
+
+  if (req->async) {
+    if (ret != GST_FLOW_OK)
+      comm->pending_ret = ret;
+    g_hash_table_remove (comm->waiting_ids, GINT_TO_POINTER (id));
+    comm->n_pending_buffers--;
+    g_cond_broadcast (&comm->pending_cond);
+    return TRUE;
+  }
+
   req->replied = TRUE;
   req->ret = ret;
   if (query) {
@@ -1706,6 +2035,58 @@ gst_ipc_pipeline_comm_reply_request (GstIpcPipelineComm * comm, guint32 id,
   return TRUE;
 }
 
+/* Reads from fdin, collecting any fds that came along */
+static ssize_t
+read_from_fd (GstIpcPipelineComm * comm, void *data, size_t size)
+{
+#ifdef G_OS_UNIX
+  if (comm->fdin_is_socket) {
+    struct msghdr msg = { 0, };
+    struct iovec iov;
+    union
+    {
+      struct cmsghdr hdr;
+      char buf[CMSG_SPACE (sizeof (int) * MAX_RECEIVED_FDS)];
+    } cmsg;
+    struct cmsghdr *hdr;
+    ssize_t sz;
+
+    iov.iov_base = data;
+    iov.iov_len = size;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cmsg.buf;
+    msg.msg_controllen = sizeof (cmsg.buf);
+
+    sz = recvmsg (comm->pollFDin.fd, &msg, 0);
+    if (sz < 0)
+      return sz;
+
+    for (hdr = CMSG_FIRSTHDR (&msg); hdr; hdr = CMSG_NXTHDR (&msg, hdr)) {
+      guint i, n;
+
+      if (hdr->cmsg_level != SOL_SOCKET || hdr->cmsg_type != SCM_RIGHTS)
+        continue;
+
+      n = (hdr->cmsg_len - CMSG_LEN (0)) / sizeof (int);
+      for (i = 0; i < n; i++) {
+        int fd;
+
+        memcpy (&fd, CMSG_DATA (hdr) + i * sizeof (int), sizeof (int));
+        GST_TRACE_OBJECT (comm->element, "Received fd %d", fd);
+        g_queue_push_tail (&comm->received_fds, GINT_TO_POINTER (fd));
+      }
+    }
+    if (msg.msg_flags & MSG_CTRUNC)
+      GST_WARNING_OBJECT (comm->element, "Lost some of the received fds");
+
+    return sz;
+  }
+#endif
+
+  return read (comm->pollFDin.fd, data, size);
+}
+
 static gint
 update_adapter (GstIpcPipelineComm * comm)
 {
@@ -1731,6 +2112,9 @@ again:
     if (comm->fdin != -1 && GST_OBJECT_PARENT (comm->element)) {
       GST_DEBUG_OBJECT (comm->element, "Start watching fd %d", comm->fdin);
       comm->pollFDin.fd = comm->fdin;
+#ifdef G_OS_UNIX
+      comm->fdin_is_socket = fd_is_socket (comm->fdin);
+#endif
       gst_poll_add_fd (comm->poll, &comm->pollFDin);
       gst_poll_fd_ctl_read (comm->poll, &comm->pollFDin, TRUE);
     }
@@ -1752,7 +2136,7 @@ again:
       mem = gst_allocator_alloc (NULL, comm->read_chunk_size, NULL);
 
     gst_memory_map (mem, &map, GST_MAP_WRITE);
-    sz = read (comm->pollFDin.fd, map.data, map.size);
+    sz = read_from_fd (comm, map.data, map.size);
     gst_memory_unmap (mem, &map);
 
     if (sz <= 0) {
@@ -1817,6 +2201,7 @@ read_many (GstIpcPipelineComm * comm)
           case GST_IPC_PIPELINE_COMM_DATA_TYPE_STATE_LOST:
           case GST_IPC_PIPELINE_COMM_DATA_TYPE_MESSAGE:
           case GST_IPC_PIPELINE_COMM_DATA_TYPE_GERROR_MESSAGE:
+          case GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER_FD:
             GST_TRACE_OBJECT (comm->element, "switching to state %s",
                 gst_ipc_pipeline_comm_data_type_get_name (type));
             comm->state = type;
@@ -1881,6 +2266,7 @@ read_many (GstIpcPipelineComm * comm)
         break;
       }
       case GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER:
+      case GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER_FD:
       {
         GstBuffer *buf;
 
@@ -1888,7 +2274,8 @@ read_many (GstIpcPipelineComm * comm)
         if (available < comm->payload_length)
           goto done;
 
-        buf = gst_ipc_pipeline_comm_read_buffer (comm, comm->payload_length);
+        buf = gst_ipc_pipeline_comm_read_buffer (comm, comm->payload_length,
+            comm->state == GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER_FD);
         if (!buf)
           goto buffer_failed;
 
@@ -51,6 +51,7 @@ typedef enum {
   GST_IPC_PIPELINE_COMM_DATA_TYPE_STATE_LOST,
   GST_IPC_PIPELINE_COMM_DATA_TYPE_MESSAGE,
   GST_IPC_PIPELINE_COMM_DATA_TYPE_GERROR_MESSAGE,
+  GST_IPC_PIPELINE_COMM_DATA_TYPE_BUFFER_FD,
 } GstIpcPipelineCommDataType;
 
 typedef struct
@@ -76,6 +77,21 @@ typedef struct
   guint read_chunk_size;
   GstClockTime ack_time;
 
+  /* sending buffer payloads as fds over a unix socket */
+  gboolean pass_fds;
+  int checked_fdout;
+  gboolean fdout_is_socket;
+  gboolean fdin_is_socket;
+  GQueue received_fds;
+  GstAllocator *fd_allocator;
+  GstAllocator *dmabuf_allocator;
+
+  /* buffers sent without waiting for their ack */
+  guint max_pending_buffers;
+  guint n_pending_buffers;
+  GstFlowReturn pending_ret;
+  GCond pending_cond;
+
   void (*on_buffer) (guint32, GstBuffer *, gpointer);
   void (*on_event) (guint32, GstEvent *, gboolean, gpointer);
   void (*on_query) (guint32, GstQuery *, gboolean, gpointer);
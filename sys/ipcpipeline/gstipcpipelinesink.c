@@ -98,11 +98,15 @@ enum
   PROP_FDOUT,
   PROP_READ_CHUNK_SIZE,
   PROP_ACK_TIME,
+  PROP_PASS_FDS,
+  PROP_MAX_PENDING_BUFFERS,
 };
 
 
 #define DEFAULT_READ_CHUNK_SIZE 4096
 #define DEFAULT_ACK_TIME (10 * G_TIME_SPAN_SECOND)
+#define DEFAULT_PASS_FDS FALSE
+#define DEFAULT_MAX_PENDING_BUFFERS 0
 
 #define _do_init \
     GST_DEBUG_CATEGORY_INIT (gst_ipc_pipeline_sink_debug, "ipcpipelinesink", 0, "ipcpipelinesink element");
@@ -175,6 +179,42 @@ gst_ipc_pipeline_sink_class_init (GstIpcPipelineSinkClass * klass)
           0, G_MAXUINT64, DEFAULT_ACK_TIME,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstIpcPipelineSink:pass-fds:
+   *
+   * Pass buffer payloads to the ipcpipelinesrc as file descriptors instead
+   * of writing them to #GstIpcPipelineSink:fdout. DMABuf and other fd
+   * backed memory is passed as is, other big payloads are copied into a
+   * memfd. Only metadata goes through fdout then.
+   *
+   * This requires fdout to be a unix domain socket, otherwise payloads are
+   * written to it as usual.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_PASS_FDS,
+      g_param_spec_boolean ("pass-fds", "Pass fds",
+          "Pass buffer payloads as file descriptors over a unix socket",
+          DEFAULT_PASS_FDS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstIpcPipelineSink:max-pending-buffers:
+   *
+   * Maximum number of buffers sent without waiting for the ipcpipelinesrc
+   * to acknowledge them. Flow errors are then returned for one of the
+   * following buffers. 0 waits for every buffer to be acknowledged before
+   * returning.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_PENDING_BUFFERS,
+      g_param_spec_uint ("max-pending-buffers", "Max pending buffers",
+          "Maximum number of buffers sent without waiting for their ack "
+          "(0 = wait for every ack)", 0, G_MAXUINT,
+          DEFAULT_MAX_PENDING_BUFFERS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
   gst_ipc_pipeline_sink_signals[SIGNAL_DISCONNECT] =
       g_signal_new ("disconnect",
       G_TYPE_FROM_CLASS (klass),
@@ -210,6 +250,8 @@ gst_ipc_pipeline_sink_init (GstIpcPipelineSink * sink)
   gst_ipc_pipeline_comm_init (&sink->comm, GST_ELEMENT (sink));
   sink->comm.read_chunk_size = DEFAULT_READ_CHUNK_SIZE;
   sink->comm.ack_time = DEFAULT_ACK_TIME;
+  sink->comm.pass_fds = DEFAULT_PASS_FDS;
+  sink->comm.max_pending_buffers = DEFAULT_MAX_PENDING_BUFFERS;
   sink->comm.fdin = -1;
   sink->comm.fdout = -1;
   sink->threads = g_thread_pool_new (pusher, sink, -1, FALSE, NULL);
@@ -271,6 +313,14 @@ gst_ipc_pipeline_sink_set_property (GObject * object, guint prop_id,
     case PROP_ACK_TIME:
       sink->comm.ack_time = g_value_get_uint64 (value);
       break;
+    case PROP_PASS_FDS:
+      sink->comm.pass_fds = g_value_get_boolean (value);
+      break;
+    case PROP_MAX_PENDING_BUFFERS:
+      g_mutex_lock (&sink->comm.mutex);
+      sink->comm.max_pending_buffers = g_value_get_uint (value);
+      g_mutex_unlock (&sink->comm.mutex);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -296,6 +346,12 @@ gst_ipc_pipeline_sink_get_property (GObject * object, guint prop_id,
     case PROP_ACK_TIME:
       g_value_set_uint64 (value, sink->comm.ack_time);
       break;
+    case PROP_PASS_FDS:
+      g_value_set_boolean (value, sink->comm.pass_fds);
+      break;
+    case PROP_MAX_PENDING_BUFFERS:
+      g_value_set_uint (value, sink->comm.max_pending_buffers);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -84,7 +84,8 @@ GstKMSMemory* gst_kms_allocator_dmabuf_import (GstAllocator *allocator,
 					       gint *prime_fds,
 					       gint n_planes,
 					       gsize offsets[GST_VIDEO_MAX_PLANES],
-					       GstVideoInfo *vinfo);
+					       GstVideoInfo *vinfo,
+					       guint64 modifier);
 
 GstMemory*    gst_kms_allocator_dmabuf_export (GstAllocator *allocator,
                                                GstMemory *kmsmem);
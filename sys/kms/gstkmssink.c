@@ -73,6 +73,7 @@ static GstFlowReturn gst_kms_sink_show_frame (GstVideoSink * vsink,
     GstBuffer * buf);
 static void gst_kms_sink_video_overlay_init (GstVideoOverlayInterface * iface);
 static void gst_kms_sink_drain (GstKMSSink * self);
+static gboolean gst_kms_sink_wait_flip (GstKMSSink * self);
 
 #define parent_class gst_kms_sink_parent_class
 G_DEFINE_TYPE_WITH_CODE (GstKMSSink, gst_kms_sink, GST_TYPE_VIDEO_SINK,
@@ -95,6 +96,7 @@ enum
   PROP_DISPLAY_HEIGHT,
   PROP_CONNECTOR_PROPS,
   PROP_PLANE_PROPS,
+  PROP_ATOMIC,
   PROP_N,
 };
 
@@ -380,6 +382,7 @@ get_drm_caps (GstKMSSink * self)
   guint64 has_dumb_buffer;
   guint64 has_prime;
   guint64 has_async_page_flip;
+  guint64 has_addfb2_modifiers;
 
   has_dumb_buffer = 0;
   ret = drmGetCap (self->fd, DRM_CAP_DUMB_BUFFER, &has_dumb_buffer);
@@ -406,11 +409,20 @@ get_drm_caps (GstKMSSink * self)
   else
     self->has_async_page_flip = (gboolean) has_async_page_flip;
 
+  has_addfb2_modifiers = 0;
+  ret = drmGetCap (self->fd, DRM_CAP_ADDFB2_MODIFIERS, &has_addfb2_modifiers);
+  if (ret)
+    GST_WARNING_OBJECT (self, "could not get framebuffer modifiers capability");
+  else
+    self->has_addfb2_modifiers = (gboolean) has_addfb2_modifiers;
+
   GST_INFO_OBJECT (self,
-      "prime import (%s) / prime export (%s) / async page flip (%s)",
+      "prime import (%s) / prime export (%s) / async page flip (%s) / "
+      "framebuffer modifiers (%s)",
       self->has_prime_import ? "✓" : "✗",
       self->has_prime_export ? "✓" : "✗",
-      self->has_async_page_flip ? "✓" : "✗");
+      self->has_async_page_flip ? "✓" : "✗",
+      self->has_addfb2_modifiers ? "✓" : "✗");
 
   return TRUE;
 }
@@ -706,6 +718,113 @@ gst_kms_sink_update_plane_properties (GstKMSSink * self)
   gst_kms_sink_update_properties (&iter, self->plane_props);
 }
 
+static void
+parse_in_formats (GstKMSSink * self, guint32 blob_id)
+{
+  drmModePropertyBlobPtr blob;
+  struct drm_format_modifier_blob *header;
+  struct drm_format_modifier *modifiers;
+  guint32 *formats;
+  guint i, j;
+
+  blob = drmModeGetPropertyBlob (self->fd, blob_id);
+  if (!blob)
+    return;
+
+  header = blob->data;
+  formats = (guint32 *) ((guint8 *) header + header->formats_offset);
+  modifiers = (struct drm_format_modifier *)
+      ((guint8 *) header + header->modifiers_offset);
+
+  for (i = 0; i < header->count_modifiers; i++) {
+    if (modifiers[i].modifier != DRM_FORMAT_MOD_LINEAR)
+      continue;
+
+    /* each modifier covers a window of 64 formats starting at offset */
+    for (j = 0; j < 64; j++) {
+      guint idx = modifiers[i].offset + j;
+
+      if (!(modifiers[i].formats & (G_GUINT64_CONSTANT (1) << j)))
+        continue;
+      if (idx >= header->count_formats)
+        break;
+
+      g_array_append_val (self->linear_formats, formats[idx]);
+    }
+  }
+
+  drmModeFreePropertyBlob (blob);
+}
+
+/* Looks up the plane properties needed for atomic commits, and the formats
+ * that can be imported with an explicit linear modifier */
+static void
+gst_kms_sink_inspect_plane (GstKMSSink * self, gboolean atomic)
+{
+  drmModeObjectPropertiesPtr properties;
+  struct
+  {
+    const gchar *name;
+    guint32 *id;
+  } props[] = {
+    {"FB_ID", &self->plane_prop_ids.fb_id},
+    {"CRTC_ID", &self->plane_prop_ids.crtc_id},
+    {"SRC_X", &self->plane_prop_ids.src_x},
+    {"SRC_Y", &self->plane_prop_ids.src_y},
+    {"SRC_W", &self->plane_prop_ids.src_w},
+    {"SRC_H", &self->plane_prop_ids.src_h},
+    {"CRTC_X", &self->plane_prop_ids.crtc_x},
+    {"CRTC_Y", &self->plane_prop_ids.crtc_y},
+    {"CRTC_W", &self->plane_prop_ids.crtc_w},
+    {"CRTC_H", &self->plane_prop_ids.crtc_h},
+  };
+  guint i, j;
+
+  memset (&self->plane_prop_ids, 0, sizeof (self->plane_prop_ids));
+  self->linear_formats = g_array_new (FALSE, FALSE, sizeof (guint32));
+  self->has_atomic = FALSE;
+
+  properties = drmModeObjectGetProperties (self->fd, self->plane_id,
+      DRM_MODE_OBJECT_PLANE);
+  if (!properties)
+    return;
+
+  for (i = 0; i < properties->count_props; i++) {
+    drmModePropertyPtr property;
+
+    property = drmModeGetProperty (self->fd, properties->props[i]);
+    if (!property)
+      continue;
+
+    for (j = 0; j < G_N_ELEMENTS (props); j++) {
+      if (!strcmp (property->name, props[j].name))
+        *props[j].id = property->prop_id;
+    }
+
+    if (!strcmp (property->name, "IN_FORMATS"))
+      parse_in_formats (self, properties->prop_values[i]);
+
+    drmModeFreeProperty (property);
+  }
+  drmModeFreeObjectProperties (properties);
+
+  GST_DEBUG_OBJECT (self, "plane takes %u formats with linear modifier",
+      self->linear_formats->len);
+
+  if (!atomic)
+    return;
+
+  for (j = 0; j < G_N_ELEMENTS (props); j++) {
+    if (*props[j].id == 0) {
+      GST_WARNING_OBJECT (self, "plane has no %s property, not using atomic "
+          "modesetting", props[j].name);
+      return;
+    }
+  }
+
+  self->has_atomic = TRUE;
+}
+
 static gboolean
 gst_kms_sink_start (GstBaseSink * bsink)
 {
@@ -716,10 +835,12 @@ gst_kms_sink_start (GstBaseSink * bsink)
   drmModePlaneRes *pres;
   drmModePlane *plane;
   gboolean universal_planes;
+  gboolean atomic;
   gboolean ret;
 
   self = GST_KMS_SINK (bsink);
   universal_planes = FALSE;
+  atomic = FALSE;
   ret = FALSE;
   res = NULL;
   conn = NULL;
@@ -763,6 +884,17 @@ gst_kms_sink_start (GstBaseSink * bsink)
     self->saved_crtc = (drmModeCrtc *) crtc;
   }
 
+  /* full mode setting keeps using the legacy page flips */
+  if (self->use_atomic && !self->modesetting_enabled) {
+    if (drmSetClientCap (self->fd, DRM_CLIENT_CAP_ATOMIC, 1) == 0) {
+      atomic = TRUE;
+      universal_planes = TRUE;
+    } else {
+      GST_WARNING_OBJECT (self, "atomic modesetting not supported: %s",
+          g_strerror (errno));
+    }
+  }
+
 retry_find_plane:
   if (universal_planes &&
       drmSetClientCap (self->fd, DRM_CLIENT_CAP_UNIVERSAL_PLANES, 1))
@@ -789,6 +921,10 @@ retry_find_plane:
   GST_INFO_OBJECT (self, "connector id = %d / crtc id = %d / plane id = %d",
       self->conn_id, self->crtc_id, self->plane_id);
 
+  gst_kms_sink_inspect_plane (self, atomic);
+  GST_INFO_OBJECT (self, "atomic modesetting (%s)",
+      self->has_atomic ? "✓" : "✗");
+
   GST_OBJECT_LOCK (self);
   self->hdisplay = crtc->mode.hdisplay;
   self->vdisplay = crtc->mode.vdisplay;
@@ -917,6 +1053,12 @@ gst_kms_sink_stop (GstBaseSink * bsink)
 
   self = GST_KMS_SINK (bsink);
 
+  if (self->flip_pending)
+    gst_kms_sink_wait_flip (self);
+  gst_buffer_replace (&self->flip_buffer, NULL);
+  self->has_atomic = FALSE;
+  g_clear_pointer (&self->linear_formats, g_array_unref);
+
   if (self->allocator)
     gst_kms_allocator_clear_cache (self->allocator);
 
@@ -1226,8 +1368,11 @@ gst_kms_sink_propose_allocation (GstBaseSink * bsink, GstQuery * query)
     }
   }
 
-  /* we need at least 2 buffer because we hold on to the last one */
-  gst_query_add_allocation_pool (query, pool, size, 2, 0);
+  /* we need at least 2 buffer because we hold on to the last one, and one
+   * more with atomic commits as the previous one is scanned out until the
+   * pending flip completes */
+  gst_query_add_allocation_pool (query, pool, size, self->has_atomic ? 3 : 2,
+      0);
   if (pool)
     gst_object_unref (pool);
 
@@ -1331,6 +1476,123 @@ event_failed:
   }
 }
 
+static void
+flip_handler (gint fd, guint frame, guint sec, guint usec, gpointer data)
+{
+  GstKMSSink *self = data;
+
+  self->flip_pending = FALSE;
+}
+
+/* Waits for the last atomic commit to be on screen, which releases the
+ * buffer it replaced */
+static gboolean
+gst_kms_sink_wait_flip (GstKMSSink * self)
+{
+  gint ret;
+  drmEventContext evctxt = {
+    .version = DRM_EVENT_CONTEXT_VERSION,
+    .page_flip_handler = flip_handler,
+  };
+
+  while (self->flip_pending) {
+    do {
+      ret = gst_poll_wait (self->poll, 3 * GST_SECOND);
+    } while (ret == -1 && (errno == EAGAIN || errno == EINTR));
+
+    if (ret == 0)
+      goto timeout;
+
+    ret = drmHandleEvent (self->fd, &evctxt);
+    if (ret)
+      goto event_failed;
+  }
+
+  gst_buffer_replace (&self->flip_buffer, NULL);
+
+  return TRUE;
+
+  /* ERRORS */
+timeout:
+  {
+    GST_WARNING_OBJECT (self, "timeout waiting for page flip");
+    self->flip_pending = FALSE;
+    gst_buffer_replace (&self->flip_buffer, NULL);
+    return FALSE;
+  }
+event_failed:
+  {
+    GST_ERROR_OBJECT (self, "drmHandleEvent failed: %s (%d)",
+        g_strerror (errno), errno);
+    self->flip_pending = FALSE;
+    gst_buffer_replace (&self->flip_buffer, NULL);
+    return FALSE;
+  }
+}
+
+/* Non-blocking replacement for drmModeSetPlane(). Scaling from @src to
+ * @dst is done by the display controller */
+static gint
+gst_kms_sink_atomic_set_plane (GstKMSSink * self, guint32 fb_id,
+    GstVideoRectangle * dst, GstVideoRectangle * src)
+{
+  drmModeAtomicReq *req;
+  guint32 plane_id = self->plane_id;
+  gint ret;
+
+  req = drmModeAtomicAlloc ();
+  if (!req) {
+    errno = ENOMEM;
+    return -1;
+  }
+
+  drmModeAtomicAddProperty (req, plane_id, self->plane_prop_ids.fb_id, fb_id);
+  drmModeAtomicAddProperty (req, plane_id, self->plane_prop_ids.crtc_id,
+      self->crtc_id);
+  drmModeAtomicAddProperty (req, plane_id, self->plane_prop_ids.crtc_x, dst->x);
+  drmModeAtomicAddProperty (req, plane_id, self->plane_prop_ids.crtc_y, dst->y);
+  drmModeAtomicAddProperty (req, plane_id, self->plane_prop_ids.crtc_w, dst->w);
+  drmModeAtomicAddProperty (req, plane_id, self->plane_prop_ids.crtc_h, dst->h);
+  /* source/cropping coordinates are given in Q16 */
+  drmModeAtomicAddProperty (req, plane_id, self->plane_prop_ids.src_x,
+      (guint64) src->x << 16);
+  drmModeAtomicAddProperty (req, plane_id, self->plane_prop_ids.src_y,
+      (guint64) src->y << 16);
+  drmModeAtomicAddProperty (req, plane_id, self->plane_prop_ids.src_w,
+      (guint64) src->w << 16);
+  drmModeAtomicAddProperty (req, plane_id, self->plane_prop_ids.src_h,
+      (guint64) src->h << 16);
+
+  ret = drmModeAtomicCommit (self->fd, req,
+      DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT, self);
+  drmModeAtomicFree (req);
+
+  if (ret == 0) {
+    self->flip_pending = TRUE;
+    gst_buffer_replace (&self->flip_buffer, self->last_buffer);
+  }
+
+  return ret;
+}
+
+static gboolean
+gst_kms_sink_can_import_linear (GstKMSSink * self)
+{
+  guint32 fmt;
+  guint i;
+
+  if (!self->has_addfb2_modifiers || !self->linear_formats)
+    return FALSE;
+
+  fmt = gst_drm_format_from_video (GST_VIDEO_INFO_FORMAT (&self->vinfo));
+  for (i = 0; i < self->linear_formats->len; i++) {
+    if (g_array_index (self->linear_formats, guint32, i) == fmt)
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
 static gboolean
 gst_kms_sink_import_dmabuf (GstKMSSink * self, GstBuffer * inbuf,
     GstBuffer ** outbuf)
@@ -1409,7 +1671,15 @@ gst_kms_sink_import_dmabuf (GstKMSSink * self, GstBuffer * inbuf,
       prime_fds[1], prime_fds[2], prime_fds[3]);
 
   kmsmem = gst_kms_allocator_dmabuf_import (self->allocator,
-      prime_fds, n_planes, mems_skip, &self->vinfo);
+      prime_fds, n_planes, mems_skip, &self->vinfo, DRM_FORMAT_MOD_INVALID);
+
+  /* Some drivers refuse DMABufs without modifier, while the plane takes
+   * the format with an explicit linear layout (from IN_FORMATS) */
+  if (!kmsmem && gst_kms_sink_can_import_linear (self)) {
+    GST_DEBUG_OBJECT (self, "retrying import with linear modifier");
+    kmsmem = gst_kms_allocator_dmabuf_import (self->allocator,
+        prime_fds, n_planes, mems_skip, &self->vinfo, DRM_FORMAT_MOD_LINEAR);
+  }
   if (!kmsmem)
     return FALSE;
 
@@ -1578,6 +1848,14 @@ gst_kms_sink_show_frame (GstVideoSink * vsink, GstBuffer * buf)
 
   res = GST_FLOW_ERROR;
 
+  /* the buffer replaced by the previous commit has to be released before
+   * picking a new one from our pool */
+  if (self->has_atomic) {
+    GST_OBJECT_LOCK (self);
+    gst_kms_sink_wait_flip (self);
+    GST_OBJECT_UNLOCK (self);
+  }
+
   if (buf) {
     buffer = gst_kms_sink_get_input_buffer (self, buf);
     vinfo = &self->vinfo;
@@ -1657,13 +1935,18 @@ retry_set_plane:
   }
 
   GST_TRACE_OBJECT (self,
-      "drmModeSetPlane at (%i,%i) %ix%i sourcing at (%i,%i) %ix%i",
+      "%s at (%i,%i) %ix%i sourcing at (%i,%i) %ix%i",
+      self->has_atomic ? "atomic commit" : "drmModeSetPlane",
       result.x, result.y, result.w, result.h, src.x, src.y, src.w, src.h);
 
-  ret = drmModeSetPlane (self->fd, self->plane_id, self->crtc_id, fb_id, 0,
-      result.x, result.y, result.w, result.h,
-      /* source/cropping coordinates are given in Q16 */
-      src.x << 16, src.y << 16, src.w << 16, src.h << 16);
+  if (self->has_atomic) {
+    ret = gst_kms_sink_atomic_set_plane (self, fb_id, &result, &src);
+  } else {
+    ret = drmModeSetPlane (self->fd, self->plane_id, self->crtc_id, fb_id, 0,
+        result.x, result.y, result.w, result.h,
+        /* source/cropping coordinates are given in Q16 */
+        src.x << 16, src.y << 16, src.w << 16, src.h << 16);
+  }
   if (ret) {
     if (self->can_scale) {
       self->can_scale = FALSE;
@@ -1673,8 +1956,9 @@ retry_set_plane:
   }
 
 sync_frame:
-  /* Wait for the previous frame to complete redraw */
-  if (!gst_kms_sink_sync (self)) {
+  /* Wait for the previous frame to complete redraw. Atomic commits are
+   * waited for before the next one instead */
+  if (!self->has_atomic && !gst_kms_sink_sync (self)) {
     GST_OBJECT_UNLOCK (self);
     goto bail;
   }
@@ -1709,7 +1993,9 @@ set_plane_failed:
         result.w, result.h, src.x, src.y, src.w, src.h, dst.x, dst.y, dst.w,
         dst.h);
     GST_ELEMENT_ERROR (self, RESOURCE, FAILED,
-        (NULL), ("drmModeSetPlane failed: %s (%d)", g_strerror (errno), errno));
+        (NULL), ("%s failed: %s (%d)",
+            self->has_atomic ? "atomic commit" : "drmModeSetPlane",
+            g_strerror (errno), errno));
     goto bail;
   }
 no_disp_ratio:
@@ -1750,6 +2036,13 @@ gst_kms_sink_drain (GstKMSSink * self)
 
     gst_kms_allocator_clear_cache (self->allocator);
     gst_kms_sink_show_frame (GST_VIDEO_SINK (self), NULL);
+
+    /* the upstream buffer is scanned out until the copy is on screen */
+    if (self->has_atomic) {
+      GST_OBJECT_LOCK (self);
+      gst_kms_sink_wait_flip (self);
+      GST_OBJECT_UNLOCK (self);
+    }
     gst_buffer_unref (last_buf);
   }
 }
@@ -1805,6 +2098,9 @@ gst_kms_sink_set_property (GObject * object, guint prop_id,
     case PROP_CAN_SCALE:
       sink->can_scale = g_value_get_boolean (value);
       break;
+    case PROP_ATOMIC:
+      sink->use_atomic = g_value_get_boolean (value);
+      break;
     case PROP_CONNECTOR_PROPS:{
       const GstStructure *s = gst_value_get_structure (value);
 
@@ -1862,6 +2158,9 @@ gst_kms_sink_get_property (GObject * object, guint prop_id,
     case PROP_CAN_SCALE:
       g_value_set_boolean (value, sink->can_scale);
       break;
+    case PROP_ATOMIC:
+      g_value_set_boolean (value, sink->use_atomic);
+      break;
     case PROP_DISPLAY_WIDTH:
       GST_OBJECT_LOCK (sink);
       g_value_set_int (value, sink->hdisplay);
@@ -2076,6 +2375,22 @@ gst_kms_sink_class_init (GstKMSSinkClass * klass)
       "Additional properties for the plane",
       GST_TYPE_STRUCTURE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+  /**
+   * kmssink:atomic:
+   *
+   * Update the plane with non-blocking atomic commits instead of
+   * drmModeSetPlane() followed by waiting for the vertical blank. The
+   * display controller scales the video if #kmssink:can-scale is
+   * enabled. Falls back to the legacy API if the driver doesn't support
+   * atomic modesetting, and isn't used together with mode setting.
+   *
+   * Since: 1.20
+   */
+  g_properties[PROP_ATOMIC] =
+      g_param_spec_boolean ("atomic", "Atomic modesetting",
+      "Use non-blocking atomic commits for updating the plane", FALSE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | G_PARAM_CONSTRUCT);
+
   g_object_class_install_properties (gobject_class, PROP_N, g_properties);
 
   gst_video_overlay_install_properties (gobject_class, PROP_N);
@@ -62,8 +62,24 @@ struct _GstKMSSink {
   gboolean has_prime_import;
   gboolean has_prime_export;
   gboolean has_async_page_flip;
+  gboolean has_addfb2_modifiers;
   gboolean can_scale;
 
+  /* atomic plane updates */
+  gboolean use_atomic;
+  gboolean has_atomic;
+  struct {
+    guint32 fb_id, crtc_id;
+    guint32 src_x, src_y, src_w, src_h;
+    guint32 crtc_x, crtc_y, crtc_w, crtc_h;
+  } plane_prop_ids;
+  gboolean flip_pending;
+  /* still scanned out until the pending flip completes */
+  GstBuffer *flip_buffer;
+
+  /* formats the plane takes with an explicit linear modifier */
+  GArray *linear_formats;
+
   gboolean modesetting_enabled;
   gboolean restore_crtc;
   GstStructure *connector_props;
@@ -289,6 +289,24 @@ gst_mf_source_object_set_client (GstMFSourceObject * object,
   return TRUE;
 }
 
+gboolean
+gst_mf_source_object_set_d3d11_device (GstMFSourceObject * object,
+    GstObject * d3d11_device)
+{
+  GstMFSourceObjectClass *klass;
+
+  g_return_val_if_fail (GST_IS_MF_SOURCE_OBJECT (object), FALSE);
+  g_return_val_if_fail (GST_IS_OBJECT (d3d11_device), FALSE);
+
+  klass = GST_MF_SOURCE_OBJECT_GET_CLASS (object);
+
+  /* Not every implementation can output textures */
+  if (!klass->set_d3d11_device)
+    return FALSE;
+
+  return klass->set_d3d11_device (object, d3d11_device);
+}
+
 GstClockTime
 gst_mf_source_object_get_running_time (GstMFSourceObject * object)
 {
@@ -80,6 +80,9 @@ struct _GstMFSourceObjectClass
 
   gboolean      (*set_caps)    (GstMFSourceObject * object,
                                 GstCaps * caps);
+
+  gboolean      (*set_d3d11_device) (GstMFSourceObject * object,
+                                     GstObject * d3d11_device);
 };
 
 GType           gst_mf_source_object_get_type     (void);
@@ -107,6 +110,10 @@ gboolean        gst_mf_source_object_set_caps     (GstMFSourceObject * object,
 gboolean        gst_mf_source_object_set_client   (GstMFSourceObject * object,
                                                    GstElement * element);
 
+/* Optional, for texture output. d3d11_device should be a GstD3D11Device */
+gboolean        gst_mf_source_object_set_d3d11_device (GstMFSourceObject * object,
+                                                       GstObject * d3d11_device);
+
 GstClockTime    gst_mf_source_object_get_running_time (GstMFSourceObject * object);
 
 /* A factory method for subclass impl. selection */
@@ -22,6 +22,8 @@
 #include "config.h"
 #endif
 
+#include "gstmfconfig.h"
+
 #include <gst/base/base.h>
 #include <gst/video/video.h>
 #include "gstmfsourcereader.h"
@@ -40,6 +42,16 @@ GST_DEBUG_CATEGORY_EXTERN (gst_mf_source_object_debug);
 
 G_END_DECLS
 
+#if GST_MF_HAVE_D3D11
+#include <gst/d3d11/gstd3d11.h>
+#include <d3d11_4.h>
+
+/* Private data of the downstream textures, holding the texture opened on
+ * the device of the source reader */
+DEFINE_GUID(GST_GUID_MF_SOURCE_SHARED_TEXTURE,
+    0x6fc4495f, 0xa321, 0x4929, 0xbd, 0xa3, 0x5d, 0xd3, 0xff, 0xa5, 0xe4, 0x0c);
+#endif
+
 typedef struct _GstMFStreamMediaType
 {
   IMFMediaType *media_type;
@@ -83,6 +95,19 @@ struct _GstMFSourceReader
   GstVideoInfo info;
 
   gboolean flushing;
+
+#if GST_MF_HAVE_D3D11
+  /* Created with D3D11_CREATE_DEVICE_VIDEO_SUPPORT on the adapter of
+   * the device given by the element */
+  GstD3D11Device *d3d11_device;
+  IMFDXGIDeviceManager *device_manager;
+  UINT reset_token;
+
+  /* TRUE if the reader was created with device_manager */
+  gboolean reader_d3d11;
+  /* TRUE if negotiated caps has the D3D11 memory feature */
+  gboolean use_d3d11;
+#endif
 };
 
 typedef struct _GstMFSourceReaderSample
@@ -105,6 +130,10 @@ static gboolean gst_mf_source_reader_unlock_stop (GstMFSourceObject * object);
 static GstCaps * gst_mf_source_reader_get_caps (GstMFSourceObject * object);
 static gboolean gst_mf_source_reader_set_caps (GstMFSourceObject * object,
     GstCaps * caps);
+#if GST_MF_HAVE_D3D11
+static gboolean gst_mf_source_reader_set_d3d11_device (GstMFSourceObject *
+    object, GstObject * d3d11_device);
+#endif
 static void
 gst_mf_source_reader_sample_clear (GstMFSourceReaderSample * reader_sample);
 
@@ -138,6 +167,10 @@ gst_mf_source_reader_class_init (GstMFSourceReaderClass * klass)
       GST_DEBUG_FUNCPTR (gst_mf_source_reader_unlock_stop);
   source_class->get_caps = GST_DEBUG_FUNCPTR (gst_mf_source_reader_get_caps);
   source_class->set_caps = GST_DEBUG_FUNCPTR (gst_mf_source_reader_set_caps);
+#if GST_MF_HAVE_D3D11
+  source_class->set_d3d11_device =
+      GST_DEBUG_FUNCPTR (gst_mf_source_reader_set_d3d11_device);
+#endif
 }
 
 static void
@@ -275,31 +308,61 @@ compare_caps_func (gconstpointer a, gconstpointer b)
 }
 
 static gboolean
-gst_mf_source_reader_open (GstMFSourceReader * self, IMFActivate * activate)
+gst_mf_source_reader_create_reader (GstMFSourceReader * self,
+    IMFMediaSource * source, gboolean use_d3d11, IMFSourceReader ** reader)
 {
-  GList *iter;
   HRESULT hr;
-  ComPtr<IMFSourceReader> reader;
-  ComPtr<IMFMediaSource> source;
   ComPtr<IMFAttributes> attr;
 
-  hr = activate->ActivateObject (IID_IMFMediaSource, (void **) &source);
+  hr = MFCreateAttributes (&attr, 3);
   if (!gst_mf_result (hr))
     return FALSE;
 
-  hr = MFCreateAttributes (&attr, 2);
+  hr = attr->SetUINT32 (MF_READWRITE_DISABLE_CONVERTERS, TRUE);
   if (!gst_mf_result (hr))
     return FALSE;
 
-  hr = attr->SetUINT32 (MF_READWRITE_DISABLE_CONVERTERS, TRUE);
+  /* We shut down the source by ourselves, and the reader might be replaced
+   * by one with another configuration */
+  hr = attr->SetUINT32 (MF_SOURCE_READER_DISCONNECT_MEDIASOURCE_ON_SHUTDOWN,
+      TRUE);
+  if (!gst_mf_result (hr))
+    return FALSE;
+
+#if GST_MF_HAVE_D3D11
+  if (use_d3d11) {
+    hr = attr->SetUnknown (MF_SOURCE_READER_D3D_MANAGER,
+        self->device_manager);
+    if (!gst_mf_result (hr))
+      return FALSE;
+  }
+#endif
+
+  hr = MFCreateSourceReaderFromMediaSource (source, attr.Get (), reader);
   if (!gst_mf_result (hr))
     return FALSE;
 
-  hr = MFCreateSourceReaderFromMediaSource (source.Get (),
-      attr.Get (), &reader);
+  return TRUE;
+}
+
+static gboolean
+gst_mf_source_reader_open (GstMFSourceReader * self, IMFActivate * activate)
+{
+  GList *iter;
+  HRESULT hr;
+  ComPtr<IMFSourceReader> reader;
+  ComPtr<IMFMediaSource> source;
+
+  hr = activate->ActivateObject (IID_IMFMediaSource, (void **) &source);
   if (!gst_mf_result (hr))
     return FALSE;
 
+  if (!gst_mf_source_reader_create_reader (self, source.Get (), FALSE,
+          &reader)) {
+    source->Shutdown ();
+    return FALSE;
+  }
+
   if (!gst_mf_enum_media_type_from_source_reader (reader.Get (),
           &self->media_types)) {
     GST_ERROR_OBJECT (self, "No available media types");
@@ -349,6 +412,17 @@ gst_mf_source_reader_close (GstMFSourceReader * self)
     self->source = NULL;
   }
 
+#if GST_MF_HAVE_D3D11
+  if (self->device_manager) {
+    self->device_manager->Release ();
+    self->device_manager = nullptr;
+  }
+
+  gst_clear_object (&self->d3d11_device);
+  self->reader_d3d11 = FALSE;
+  self->use_d3d11 = FALSE;
+#endif
+
   return TRUE;
 }
 
@@ -524,6 +598,164 @@ done:
   return GST_FLOW_OK;
 }
 
+#if GST_MF_HAVE_D3D11
+static gboolean
+gst_mf_source_reader_copy_d3d11 (GstMFSourceReader * self,
+    IMFMediaBuffer * media_buffer, GstMemory * mem)
+{
+  HRESULT hr;
+  ComPtr<IMFDXGIBuffer> dxgi_buffer;
+  ComPtr<ID3D11Texture2D> mf_texture;
+  ComPtr<IDXGIResource> dxgi_resource;
+  ComPtr<ID3D11Texture2D> shared_texture;
+  ComPtr<ID3D11Query> query;
+  D3D11_QUERY_DESC query_desc;
+  BOOL sync_done = FALSE;
+  HANDLE shared_handle;
+  UINT data_size;
+  UINT mf_subidx = 0;
+  GstD3D11Memory *dmem = (GstD3D11Memory *) mem;
+  ID3D11Texture2D *texture;
+  ID3D11Device *device_handle;
+  ID3D11DeviceContext *context_handle;
+  GstMapInfo info;
+  D3D11_BOX src_box = { 0, };
+  D3D11_TEXTURE2D_DESC dst_desc, src_desc;
+  guint subidx;
+  gboolean ret = FALSE;
+
+  /* Drivers are allowed to deliver system memory even if we've configured
+   * DXGI device manager */
+  hr = media_buffer->QueryInterface (IID_PPV_ARGS (&dxgi_buffer));
+  if (FAILED (hr)) {
+    GST_LOG_OBJECT (self, "Not a DXGI buffer");
+    return FALSE;
+  }
+
+  hr = dxgi_buffer->GetResource (IID_PPV_ARGS (&mf_texture));
+  if (!gst_mf_result (hr)) {
+    GST_WARNING_OBJECT (self,
+        "Couldn't get ID3D11Texture2D from IMFDXGIBuffer");
+    return FALSE;
+  }
+
+  hr = dxgi_buffer->GetSubresourceIndex (&mf_subidx);
+  if (!gst_mf_result (hr)) {
+    GST_WARNING_OBJECT (self, "Couldn't get subresource index");
+    return FALSE;
+  }
+
+  device_handle = gst_d3d11_device_get_device_handle (self->d3d11_device);
+  context_handle =
+      gst_d3d11_device_get_device_context_handle (self->d3d11_device);
+
+  /* Map memory so that ensure pending upload from staging texture */
+  if (!gst_memory_map (mem, &info,
+          (GstMapFlags) (GST_MAP_WRITE | GST_MAP_D3D11))) {
+    GST_ERROR_OBJECT (self, "Couldn't map d3d11 memory");
+    return FALSE;
+  }
+
+  texture = (ID3D11Texture2D *) info.data;
+  texture->GetDesc (&dst_desc);
+  mf_texture->GetDesc (&src_desc);
+  subidx = gst_d3d11_memory_get_subresource_index (dmem);
+
+  if (src_desc.Format != dst_desc.Format) {
+    GST_WARNING_OBJECT (self, "Captured texture format %d does not match "
+        "output texture format %d", src_desc.Format, dst_desc.Format);
+    goto out;
+  }
+
+  /* Downstream textures are recycled by the pool, reuse the texture opened
+   * on our device at the first use of this one */
+  data_size = sizeof (ID3D11Texture2D *);
+  hr = texture->GetPrivateData (GST_GUID_MF_SOURCE_SHARED_TEXTURE,
+      &data_size, shared_texture.GetAddressOf ());
+  if (SUCCEEDED (hr) && shared_texture) {
+    ComPtr<ID3D11Device> shared_device;
+
+    /* the texture might have been opened by another source reader */
+    shared_texture->GetDevice (&shared_device);
+    if (shared_device.Get () != device_handle)
+      shared_texture = nullptr;
+  } else {
+    shared_texture = nullptr;
+  }
+
+  if (!shared_texture) {
+    hr = texture->QueryInterface (IID_PPV_ARGS (&dxgi_resource));
+    if (!gst_mf_result (hr)) {
+      GST_WARNING_OBJECT (self,
+          "Couldn't get IDXGIResource from ID3D11Texture2D");
+      goto out;
+    }
+
+    hr = dxgi_resource->GetSharedHandle (&shared_handle);
+    if (!gst_mf_result (hr)) {
+      GST_WARNING_OBJECT (self,
+          "Couldn't get shared handle from IDXGIResource");
+      goto out;
+    }
+
+    hr = device_handle->OpenSharedResource (shared_handle,
+        IID_PPV_ARGS (&shared_texture));
+    if (!gst_mf_result (hr)) {
+      GST_WARNING_OBJECT (self, "Couldn't open shared resource");
+      goto out;
+    }
+
+    /* Holds a reference until the pool releases the texture */
+    hr = texture->SetPrivateDataInterface (GST_GUID_MF_SOURCE_SHARED_TEXTURE,
+        shared_texture.Get ());
+    if (!gst_mf_result (hr))
+      GST_WARNING_OBJECT (self, "Couldn't store opened shared texture");
+  }
+
+  /* src/dst texture size might be different if padding was used.
+   * select smaller size */
+  src_box.left = 0;
+  src_box.top = 0;
+  src_box.front = 0;
+  src_box.back = 1;
+  src_box.right = MIN (src_desc.Width, dst_desc.Width);
+  src_box.bottom = MIN (src_desc.Height, dst_desc.Height);
+
+  /* The output texture will be used by another device, wait for
+   * the copy to be finished */
+  query_desc.Query = D3D11_QUERY_EVENT;
+  query_desc.MiscFlags = 0;
+
+  hr = device_handle->CreateQuery (&query_desc, &query);
+  if (!gst_d3d11_result (hr, self->d3d11_device)) {
+    GST_ERROR_OBJECT (self, "Couldn't Create event query");
+    goto out;
+  }
+
+  gst_d3d11_device_lock (self->d3d11_device);
+  context_handle->CopySubresourceRegion (shared_texture.Get (), subidx,
+      0, 0, 0, mf_texture.Get (), mf_subidx, &src_box);
+  context_handle->End (query.Get ());
+
+  do {
+    hr = context_handle->GetData (query.Get (), &sync_done, sizeof (BOOL), 0);
+  } while (!sync_done && (hr == S_OK || hr == S_FALSE));
+  gst_d3d11_device_unlock (self->d3d11_device);
+
+  if (!gst_d3d11_result (hr, self->d3d11_device)) {
+    GST_ERROR_OBJECT (self, "Couldn't sync GPU operation");
+    goto out;
+  }
+
+  ret = TRUE;
+
+out:
+  gst_memory_unmap (mem, &info);
+
+  return ret;
+}
+#endif
+
 static GstFlowReturn
 gst_mf_source_reader_fill (GstMFSourceObject * object, GstBuffer * buffer)
 {
@@ -545,6 +777,17 @@ gst_mf_source_reader_fill (GstMFSourceObject * object, GstBuffer * buffer)
   if (ret != GST_FLOW_OK)
     return ret;
 
+#if GST_MF_HAVE_D3D11
+  if (self->use_d3d11 && gst_buffer_n_memory (buffer) == 1 &&
+      gst_is_d3d11_memory (gst_buffer_peek_memory (buffer, 0)) &&
+      gst_mf_source_reader_copy_d3d11 (self, media_buffer.Get (),
+          gst_buffer_peek_memory (buffer, 0))) {
+    goto done;
+  }
+
+  /* Otherwise copy through the staging texture of the memory */
+#endif
+
   hr = media_buffer->Lock (&data, NULL, NULL);
   if (!gst_mf_result (hr)) {
     GST_ERROR_OBJECT (self, "Failed to lock media buffer");
@@ -580,6 +823,9 @@ gst_mf_source_reader_fill (GstMFSourceObject * object, GstBuffer * buffer)
   gst_video_frame_unmap (&frame);
   media_buffer->Unlock ();
 
+#if GST_MF_HAVE_D3D11
+done:
+#endif
   GST_BUFFER_PTS (buffer) = timestamp;
   GST_BUFFER_DTS (buffer) = GST_CLOCK_TIME_NONE;
   GST_BUFFER_DURATION (buffer) = duration;
@@ -673,21 +919,65 @@ gst_mf_source_reader_get_caps (GstMFSourceObject * object)
   return NULL;
 }
 
+#if GST_MF_HAVE_D3D11
+static gboolean
+gst_mf_source_reader_reset_reader (GstMFSourceReader * self,
+    gboolean use_d3d11)
+{
+  ComPtr<IMFSourceReader> reader;
+
+  GST_DEBUG_OBJECT (self, "Creating new reader, use d3d11: %d", use_d3d11);
+
+  if (!gst_mf_source_reader_create_reader (self, self->source, use_d3d11,
+          &reader)) {
+    GST_ERROR_OBJECT (self, "Couldn't create new source reader");
+    return FALSE;
+  }
+
+  /* Samples of the previous reader are not needed anymore */
+  gst_queue_array_clear (self->queue);
+
+  self->reader->Release ();
+  self->reader = reader.Detach ();
+  self->reader_d3d11 = use_d3d11;
+
+  return TRUE;
+}
+#endif
+
 static gboolean
 gst_mf_source_reader_set_caps (GstMFSourceObject * object, GstCaps * caps)
 {
   GstMFSourceReader *self = GST_MF_SOURCE_READER (object);
   GList *iter;
   GstMFStreamMediaType *best_type = NULL;
+  GstCaps *target_caps = gst_caps_ref (caps);
+#if GST_MF_HAVE_D3D11
+  GstCapsFeatures *features;
+  gboolean use_d3d11 = FALSE;
+
+  features = gst_caps_get_features (caps, 0);
+  if (self->d3d11_device && features &&
+      gst_caps_features_contains (features,
+          GST_CAPS_FEATURE_MEMORY_D3D11_MEMORY)) {
+    use_d3d11 = TRUE;
+
+    /* Our media types are described with system memory caps */
+    target_caps = gst_caps_make_writable (target_caps);
+    gst_caps_set_features (target_caps, 0, NULL);
+  }
+#endif
 
   for (iter = self->media_types; iter; iter = g_list_next (iter)) {
     GstMFStreamMediaType *minfo = (GstMFStreamMediaType *) iter->data;
-    if (gst_caps_is_subset (minfo->caps, caps)) {
+    if (gst_caps_is_subset (minfo->caps, target_caps)) {
       best_type = minfo;
       break;
     }
   }
 
+  gst_caps_unref (target_caps);
+
   if (!best_type) {
     GST_ERROR_OBJECT (self,
         "Could not determine target media type with given caps %"
@@ -696,12 +986,85 @@ gst_mf_source_reader_set_caps (GstMFSourceObject * object, GstCaps * caps)
     return FALSE;
   }
 
+#if GST_MF_HAVE_D3D11
+  if (use_d3d11 != self->reader_d3d11 &&
+      !gst_mf_source_reader_reset_reader (self, use_d3d11)) {
+    return FALSE;
+  }
+
+  self->use_d3d11 = use_d3d11;
+#endif
+
   self->cur_type = best_type;
   gst_video_info_from_caps (&self->info, best_type->caps);
 
   return TRUE;
 }
 
+#if GST_MF_HAVE_D3D11
+static gboolean
+gst_mf_source_reader_set_d3d11_device (GstMFSourceObject * object,
+    GstObject * d3d11_device)
+{
+  GstMFSourceReader *self = GST_MF_SOURCE_READER (object);
+  GstD3D11Device *device;
+  ID3D11Device *device_handle;
+  ComPtr<ID3D11Multithread> multi_thread;
+  guint adapter = 0;
+  HRESULT hr;
+
+  g_return_val_if_fail (GST_IS_D3D11_DEVICE (d3d11_device), FALSE);
+
+  if (self->d3d11_device)
+    return TRUE;
+
+  g_object_get (d3d11_device, "adapter", &adapter, NULL);
+
+  /* Capture devices need D3D11_CREATE_DEVICE_VIDEO_SUPPORT which the given
+   * device might not have been created with. Create our own device on the
+   * same adapter so that textures can be shared */
+  device = gst_d3d11_device_new (adapter, D3D11_CREATE_DEVICE_VIDEO_SUPPORT);
+  if (!device) {
+    GST_WARNING_OBJECT (self, "Couldn't create d3d11 device for adapter %d",
+        adapter);
+    return FALSE;
+  }
+
+  device_handle = gst_d3d11_device_get_device_handle (device);
+
+  /* Media Foundation will use the device from its own threads */
+  hr = device_handle->QueryInterface (IID_PPV_ARGS (&multi_thread));
+  if (!gst_mf_result (hr)) {
+    GST_WARNING_OBJECT (self, "ID3D11Multithread interface is unavailable");
+    gst_object_unref (device);
+    return FALSE;
+  }
+
+  multi_thread->SetMultithreadProtected (TRUE);
+
+  hr = MFCreateDXGIDeviceManager (&self->reset_token, &self->device_manager);
+  if (!gst_mf_result (hr)) {
+    GST_WARNING_OBJECT (self, "Couldn't create DXGI device manager");
+    gst_object_unref (device);
+    return FALSE;
+  }
+
+  hr = self->device_manager->ResetDevice ((IUnknown *) device_handle,
+      self->reset_token);
+  if (!gst_mf_result (hr)) {
+    GST_WARNING_OBJECT (self, "Couldn't reset device with d3d11 device");
+    self->device_manager->Release ();
+    self->device_manager = nullptr;
+    gst_object_unref (device);
+    return FALSE;
+  }
+
+  self->d3d11_device = device;
+
+  return TRUE;
+}
+#endif
+
 static gboolean
 gst_mf_source_reader_main_loop_running_cb (GstMFSourceReader * self)
 {
@@ -37,6 +37,13 @@ GST_DEBUG_CATEGORY_EXTERN (gst_mf_video_enc_debug);
 
 G_END_DECLS
 
+#if GST_MF_HAVE_D3D11
+/* Private data of the textures allocated by IMFVideoSampleAllocatorEx,
+ * holding the texture opened on the upstream device */
+DEFINE_GUID(GST_GUID_MF_SHARED_TEXTURE,
+    0xb45d35e9, 0x3953, 0x47ce, 0x90, 0x75, 0xea, 0xd6, 0x11, 0x74, 0x37, 0xcb);
+#endif
+
 #define gst_mf_video_enc_parent_class parent_class
 G_DEFINE_ABSTRACT_TYPE (GstMFVideoEnc, gst_mf_video_enc,
     GST_TYPE_VIDEO_ENCODER);
@@ -930,6 +937,7 @@ gst_mf_video_enc_create_input_sample_d3d11 (GstMFVideoEnc * self,
   D3D11_QUERY_DESC query_desc;
   BOOL sync_done = FALSE;
   HANDLE shared_handle;
+  UINT data_size;
   GstMemory *mem;
   GstD3D11Memory *dmem;
   ID3D11Texture2D *texture;
@@ -982,27 +990,52 @@ gst_mf_video_enc_create_input_sample_d3d11 (GstMFVideoEnc * self,
     return FALSE;
   }
 
-  hr = mf_texture.As (&dxgi_resource);
-  if (!gst_mf_result (hr)) {
-    GST_WARNING_OBJECT (self,
-        "Couldn't get IDXGIResource from ID3D11Texture2D");
-    return FALSE;
-  }
+  /* The allocator recycles its textures, reuse the texture opened on the
+   * upstream device at the first use of this one */
+  data_size = sizeof (ID3D11Texture2D *);
+  hr = mf_texture->GetPrivateData (GST_GUID_MF_SHARED_TEXTURE, &data_size,
+      shared_texture.GetAddressOf ());
+  if (SUCCEEDED (hr) && shared_texture) {
+    ComPtr<ID3D11Device> shared_device;
 
-  hr = dxgi_resource->GetSharedHandle (&shared_handle);
-  if (!gst_mf_result (hr)) {
-    GST_WARNING_OBJECT (self,
-        "Couldn't get shared handle from IDXGIResource");
-    return FALSE;
+    /* upstream device might have been changed */
+    shared_texture->GetDevice (&shared_device);
+    if (shared_device.Get () != device_handle)
+      shared_texture = nullptr;
+  } else {
+    shared_texture = nullptr;
   }
 
-  /* Allocation succeeded. Now open shared texture to access it from
-   * other device */
-  hr = device_handle->OpenSharedResource (shared_handle,
-      IID_PPV_ARGS (&shared_texture));
-  if (!gst_mf_result (hr)) {
-    GST_WARNING_OBJECT (self, "Couldn't open shared resource");
-    return FALSE;
+  if (!shared_texture) {
+
+    hr = mf_texture.As (&dxgi_resource);
+    if (!gst_mf_result (hr)) {
+      GST_WARNING_OBJECT (self,
+          "Couldn't get IDXGIResource from ID3D11Texture2D");
+      return FALSE;
+    }
+
+    hr = dxgi_resource->GetSharedHandle (&shared_handle);
+    if (!gst_mf_result (hr)) {
+      GST_WARNING_OBJECT (self,
+          "Couldn't get shared handle from IDXGIResource");
+      return FALSE;
+    }
+
+    /* Allocation succeeded. Now open shared texture to access it from
+     * other device */
+    hr = device_handle->OpenSharedResource (shared_handle,
+        IID_PPV_ARGS (&shared_texture));
+    if (!gst_mf_result (hr)) {
+      GST_WARNING_OBJECT (self, "Couldn't open shared resource");
+      return FALSE;
+    }
+
+    /* Holds a reference until the allocator releases the texture */
+    hr = mf_texture->SetPrivateDataInterface (GST_GUID_MF_SHARED_TEXTURE,
+        shared_texture.Get ());
+    if (!gst_mf_result (hr))
+      GST_WARNING_OBJECT (self, "Couldn't store opened shared texture");
   }
 
   /* 2) Copy upstream texture to mf's texture */
@@ -1044,7 +1077,7 @@ gst_mf_video_enc_create_input_sample_d3d11 (GstMFVideoEnc * self,
 
   /* Wait until all issued GPU commands are finished */
   do {
-    context_handle->GetData (query.Get(), &sync_done, sizeof (BOOL), 0);
+    hr = context_handle->GetData (query.Get(), &sync_done, sizeof (BOOL), 0);
   } while (!sync_done && (hr == S_OK || hr == S_FALSE));
 
   if (!gst_d3d11_result (hr, dmem->device)) {
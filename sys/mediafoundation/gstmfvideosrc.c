@@ -32,6 +32,11 @@
  * |[
  * gst-launch-1.0 -v mfvideosrc device-index=1 ! fakesink
  * ]| Capture from the second video device (if available) and render to fakesink.
+ *
+ * |[
+ * gst-launch-1.0 -v mfvideosrc ! "video/x-raw(memory:D3D11Memory)" ! d3d11videosink
+ * ]| Capture into Direct3D11 textures and render them without a round trip
+ * through system memory (since 1.20).
  */
 
 #ifdef HAVE_CONFIG_H
@@ -45,15 +50,35 @@
 #include "gstmfsourceobject.h"
 #include <string.h>
 
+#if GST_MF_HAVE_D3D11
+#include <gst/d3d11/gstd3d11.h>
+#endif
+
 GST_DEBUG_CATEGORY (gst_mf_video_src_debug);
 #define GST_CAT_DEFAULT gst_mf_video_src_debug
 
+#if GST_MF_HAVE_D3D11
+/* Formats which can be copied from captured textures into
+ * GstD3D11Memory of the same DXGI format */
+#define D3D11_TEMPLATE_CAPS \
+    GST_VIDEO_CAPS_MAKE_WITH_FEATURES (GST_CAPS_FEATURE_MEMORY_D3D11_MEMORY, \
+        "{ BGRA, VUYA, YUY2, UYVY, NV12, P010_10LE, P016_LE }")
+
+static GstStaticCaps d3d11_static_caps = GST_STATIC_CAPS (D3D11_TEMPLATE_CAPS);
+
+#define SRC_D3D11_TEMPLATE_CAPS D3D11_TEMPLATE_CAPS "; "
+#else
+#define SRC_D3D11_TEMPLATE_CAPS ""
+#endif
+
 #if (GST_MF_WINAPI_APP && !GST_MF_WINAPI_DESKTOP)
 /* FIXME: need support JPEG for UWP */
 #define SRC_TEMPLATE_CAPS \
+    SRC_D3D11_TEMPLATE_CAPS \
     GST_VIDEO_CAPS_MAKE (GST_MF_VIDEO_FORMATS)
 #else
 #define SRC_TEMPLATE_CAPS \
+    SRC_D3D11_TEMPLATE_CAPS \
     GST_VIDEO_CAPS_MAKE (GST_MF_VIDEO_FORMATS) "; " \
         "image/jpeg, width = " GST_VIDEO_SIZE_RANGE ", " \
         "height = " GST_VIDEO_SIZE_RANGE ", " \
@@ -76,6 +101,14 @@ struct _GstMFVideoSrc
   guint64 n_frames;
   GstClockTime latency;
 
+#if GST_MF_HAVE_D3D11
+  GstD3D11Device *d3d11_device;
+  /* TRUE if the capture object can output textures */
+  gboolean d3d11_supported;
+  /* TRUE if negotiated caps has the D3D11 memory feature */
+  gboolean use_d3d11;
+#endif
+
   /* properties */
   gchar *device_path;
   gchar *device_name;
@@ -101,6 +134,8 @@ static void gst_mf_video_src_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 static void gst_mf_video_src_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
+static void gst_mf_video_src_set_context (GstElement * element,
+    GstContext * context);
 
 static gboolean gst_mf_video_src_start (GstBaseSrc * src);
 static gboolean gst_mf_video_src_stop (GstBaseSrc * src);
@@ -110,6 +145,8 @@ static GstCaps *gst_mf_video_src_fixate (GstBaseSrc * src, GstCaps * caps);
 static gboolean gst_mf_video_src_unlock (GstBaseSrc * src);
 static gboolean gst_mf_video_src_unlock_stop (GstBaseSrc * src);
 static gboolean gst_mf_video_src_query (GstBaseSrc * src, GstQuery * query);
+static gboolean gst_mf_video_src_decide_allocation (GstBaseSrc * src,
+    GstQuery * query);
 
 static GstFlowReturn gst_mf_video_src_create (GstPushSrc * pushsrc,
     GstBuffer ** buffer);
@@ -172,6 +209,8 @@ gst_mf_video_src_class_init (GstMFVideoSrcClass * klass)
 
   gst_element_class_add_static_pad_template (element_class, &src_template);
 
+  element_class->set_context = GST_DEBUG_FUNCPTR (gst_mf_video_src_set_context);
+
   basesrc_class->start = GST_DEBUG_FUNCPTR (gst_mf_video_src_start);
   basesrc_class->stop = GST_DEBUG_FUNCPTR (gst_mf_video_src_stop);
   basesrc_class->set_caps = GST_DEBUG_FUNCPTR (gst_mf_video_src_set_caps);
@@ -180,6 +219,8 @@ gst_mf_video_src_class_init (GstMFVideoSrcClass * klass)
   basesrc_class->unlock = GST_DEBUG_FUNCPTR (gst_mf_video_src_unlock);
   basesrc_class->unlock_stop = GST_DEBUG_FUNCPTR (gst_mf_video_src_unlock_stop);
   basesrc_class->query = GST_DEBUG_FUNCPTR (gst_mf_video_src_query);
+  basesrc_class->decide_allocation =
+      GST_DEBUG_FUNCPTR (gst_mf_video_src_decide_allocation);
 
   pushsrc_class->create = GST_DEBUG_FUNCPTR (gst_mf_video_src_create);
 
@@ -203,6 +244,9 @@ gst_mf_video_src_finalize (GObject * object)
 
   g_free (self->device_name);
   g_free (self->device_path);
+#if GST_MF_HAVE_D3D11
+  gst_clear_object (&self->d3d11_device);
+#endif
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -258,6 +302,18 @@ gst_mf_video_src_set_property (GObject * object, guint prop_id,
   }
 }
 
+static void
+gst_mf_video_src_set_context (GstElement * element, GstContext * context)
+{
+#if GST_MF_HAVE_D3D11
+  GstMFVideoSrc *self = GST_MF_VIDEO_SRC (element);
+
+  gst_d3d11_handle_set_context (element, context, -1, &self->d3d11_device);
+#endif
+
+  GST_ELEMENT_CLASS (parent_class)->set_context (element, context);
+}
+
 static gboolean
 gst_mf_video_src_start (GstBaseSrc * src)
 {
@@ -278,6 +334,21 @@ gst_mf_video_src_start (GstBaseSrc * src)
 
   gst_mf_source_object_set_client (self->source, GST_ELEMENT (self));
 
+#if GST_MF_HAVE_D3D11
+  self->d3d11_supported = FALSE;
+  self->use_d3d11 = FALSE;
+
+  if (gst_d3d11_ensure_element_data (GST_ELEMENT_CAST (self), -1,
+          &self->d3d11_device)) {
+    self->d3d11_supported =
+        gst_mf_source_object_set_d3d11_device (self->source,
+        GST_OBJECT (self->d3d11_device));
+  }
+
+  if (!self->d3d11_supported)
+    GST_INFO_OBJECT (self, "D3D11 texture output is unavailable");
+#endif
+
   return TRUE;
 }
 
@@ -296,6 +367,12 @@ gst_mf_video_src_stop (GstBaseSrc * src)
 
   self->started = FALSE;
 
+#if GST_MF_HAVE_D3D11
+  gst_clear_object (&self->d3d11_device);
+  self->d3d11_supported = FALSE;
+  self->use_d3d11 = FALSE;
+#endif
+
   return TRUE;
 }
 
@@ -320,9 +397,42 @@ gst_mf_video_src_set_caps (GstBaseSrc * src, GstCaps * caps)
   if (GST_VIDEO_INFO_FORMAT (&self->info) != GST_VIDEO_FORMAT_ENCODED)
     gst_base_src_set_blocksize (src, GST_VIDEO_INFO_SIZE (&self->info));
 
+#if GST_MF_HAVE_D3D11
+  {
+    GstCapsFeatures *features = gst_caps_get_features (caps, 0);
+
+    self->use_d3d11 = self->d3d11_supported && features &&
+        gst_caps_features_contains (features,
+        GST_CAPS_FEATURE_MEMORY_D3D11_MEMORY);
+  }
+#endif
+
   return TRUE;
 }
 
+#if GST_MF_HAVE_D3D11
+static GstCaps *
+gst_mf_video_src_make_d3d11_caps (GstMFVideoSrc * self, GstCaps * caps)
+{
+  GstCaps *d3d11_template;
+  GstCaps *d3d11_caps;
+  GstCaps *ret;
+
+  d3d11_caps = gst_caps_copy (caps);
+  gst_caps_set_features_simple (d3d11_caps,
+      gst_caps_features_new (GST_CAPS_FEATURE_MEMORY_D3D11_MEMORY, NULL));
+
+  /* Drops compressed formats and the ones we cannot output as textures */
+  d3d11_template = gst_static_caps_get (&d3d11_static_caps);
+  ret = gst_caps_intersect_full (d3d11_caps, d3d11_template,
+      GST_CAPS_INTERSECT_FIRST);
+  gst_caps_unref (d3d11_template);
+  gst_caps_unref (d3d11_caps);
+
+  return ret;
+}
+#endif
+
 static GstCaps *
 gst_mf_video_src_get_caps (GstBaseSrc * src, GstCaps * filter)
 {
@@ -332,6 +442,14 @@ gst_mf_video_src_get_caps (GstBaseSrc * src, GstCaps * filter)
   if (self->source)
     caps = gst_mf_source_object_get_caps (self->source);
 
+#if GST_MF_HAVE_D3D11
+  /* Prefer textures if downstream can accept them */
+  if (caps && self->d3d11_supported) {
+    caps = gst_caps_merge (gst_mf_video_src_make_d3d11_caps (self, caps),
+        caps);
+  }
+#endif
+
   if (!caps)
     caps = gst_pad_get_pad_template_caps (GST_BASE_SRC_PAD (src));
 
@@ -404,6 +522,14 @@ gst_mf_video_src_query (GstBaseSrc * src, GstQuery * query)
         return TRUE;
       }
       break;
+#if GST_MF_HAVE_D3D11
+    case GST_QUERY_CONTEXT:
+      if (gst_d3d11_handle_context_query (GST_ELEMENT (self), query,
+              self->d3d11_device)) {
+        return TRUE;
+      }
+      break;
+#endif
     default:
       break;
   }
@@ -411,6 +537,79 @@ gst_mf_video_src_query (GstBaseSrc * src, GstQuery * query)
   return GST_BASE_SRC_CLASS (parent_class)->query (src, query);
 }
 
+static gboolean
+gst_mf_video_src_decide_allocation (GstBaseSrc * src, GstQuery * query)
+{
+#if GST_MF_HAVE_D3D11
+  GstMFVideoSrc *self = GST_MF_VIDEO_SRC (src);
+  GstBufferPool *pool = NULL;
+  GstStructure *config;
+  GstCaps *caps;
+  GstD3D11AllocationParams *d3d11_params;
+  guint size, min = 0, max = 0;
+  gboolean update_pool = FALSE;
+  gint i;
+
+  if (!self->use_d3d11)
+    return GST_BASE_SRC_CLASS (parent_class)->decide_allocation (src, query);
+
+  gst_query_parse_allocation (query, &caps, NULL);
+  if (!caps)
+    return FALSE;
+
+  size = GST_VIDEO_INFO_SIZE (&self->info);
+
+  if (gst_query_get_n_allocation_pools (query) > 0) {
+    gst_query_parse_nth_allocation_pool (query, 0, &pool, NULL, &min, &max);
+    update_pool = TRUE;
+
+    /* Textures of downstream pool might not be shareable, always use
+     * our own pool */
+    gst_clear_object (&pool);
+  }
+
+  pool = gst_d3d11_buffer_pool_new (self->d3d11_device);
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_add_option (config,
+      GST_BUFFER_POOL_OPTION_VIDEO_META);
+
+  d3d11_params = gst_buffer_pool_config_get_d3d11_allocation_params (config);
+  if (!d3d11_params) {
+    d3d11_params = gst_d3d11_allocation_params_new (self->d3d11_device,
+        &self->info, (GstD3D11AllocationFlags) 0, 0);
+  }
+
+  /* Captured textures will be copied from the device of capture object */
+  for (i = 0; i < GST_VIDEO_INFO_N_PLANES (&self->info); i++)
+    d3d11_params->desc[i].MiscFlags |= D3D11_RESOURCE_MISC_SHARED;
+
+  gst_buffer_pool_config_set_d3d11_allocation_params (config, d3d11_params);
+  gst_d3d11_allocation_params_free (d3d11_params);
+
+  gst_buffer_pool_config_set_params (config, caps, size, min, max);
+
+  if (!gst_buffer_pool_set_config (pool, config)) {
+    GST_ERROR_OBJECT (self, "Failed to set config");
+    gst_object_unref (pool);
+    return FALSE;
+  }
+
+  /* d3d11 buffer pool might update buffer size by self */
+  size = GST_D3D11_BUFFER_POOL (pool)->buffer_size;
+
+  if (update_pool)
+    gst_query_set_nth_allocation_pool (query, 0, pool, size, min, max);
+  else
+    gst_query_add_allocation_pool (query, pool, size, min, max);
+
+  gst_object_unref (pool);
+
+  return TRUE;
+#else
+  return GST_BASE_SRC_CLASS (parent_class)->decide_allocation (src, query);
+#endif
+}
+
 static GstFlowReturn
 gst_mf_video_src_create (GstPushSrc * pushsrc, GstBuffer ** buffer)
 {
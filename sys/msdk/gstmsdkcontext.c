@@ -53,6 +53,9 @@ struct _GstMsdkContextPrivate
   gint shared_async_depth;
   GMutex mutex;
   GList *child_session_list;
+  /* the context this one was joined to. Joined contexts share the surfaces
+   * allocated by the parent context */
+  GstMsdkContext *parent_context;
 #ifndef _WIN32
   gint fd;
   VADisplay dpy;
@@ -265,10 +268,12 @@ gst_msdk_context_finalize (GObject * obj)
   GstMsdkContextPrivate *priv = context->priv;
 
   /* child sessions will be closed when the parent session is closed */
-  if (priv->is_joined)
+  if (priv->is_joined) {
+    gst_object_unref (priv->parent_context);
     goto done;
-  else
-    g_list_free_full (priv->child_session_list, release_child_session);
+  }
+
+  g_list_free_full (priv->child_session_list, release_child_session);
 
   msdk_close_session (priv->session);
   g_mutex_clear (&priv->mutex);
@@ -312,7 +317,13 @@ gst_msdk_context_new_with_parent (GstMsdkContext * parent)
   mfxStatus status;
   GstMsdkContext *obj = g_object_new (GST_TYPE_MSDK_CONTEXT, NULL);
   GstMsdkContextPrivate *priv = obj->priv;
-  GstMsdkContextPrivate *parent_priv = parent->priv;
+  GstMsdkContextPrivate *parent_priv;
+
+  /* Always join the session of the root context, so that there's a single
+   * surface cache for the whole group of joined sessions */
+  if (parent->priv->is_joined)
+    parent = parent->priv->parent_context;
+  parent_priv = parent->priv;
 
   status = MFXCloneSession (parent_priv->session, &priv->session);
   if (status != MFX_ERR_NONE) {
@@ -322,6 +333,7 @@ gst_msdk_context_new_with_parent (GstMsdkContext * parent)
   }
 
   priv->is_joined = TRUE;
+  priv->parent_context = gst_object_ref (parent);
   priv->hardware = parent_priv->hardware;
   priv->job_type = parent_priv->job_type;
   parent_priv->child_session_list =
@@ -373,6 +385,17 @@ gst_msdk_context_get_fd (GstMsdkContext * context)
 #endif
 }
 
+/* Allocation responses and surface lists live in the root context, so
+ * every element of a group of joined sessions picks surfaces from, and
+ * returns them to, the same lists */
+static inline GstMsdkContextPrivate *
+_get_shared_priv (GstMsdkContext * context)
+{
+  GstMsdkContextPrivate *priv = context->priv;
+
+  return priv->is_joined ? priv->parent_context->priv : priv;
+}
+
 static gint
 _find_response (gconstpointer resp, gconstpointer comp_resp)
 {
@@ -397,15 +420,42 @@ _requested_frame_size_is_equal_or_lower (mfxFrameAllocRequest * _req,
   return FALSE;
 }
 
+#define MSDK_MEMTYPE_PRODUCER (MFX_MEMTYPE_FROM_DECODE | MFX_MEMTYPE_FROM_VPPOUT)
+#define MSDK_MEMTYPE_CONSUMER (MFX_MEMTYPE_FROM_VPPIN | MFX_MEMTYPE_FROM_ENCODE)
+
+/* The input surfaces of a VPP or an encoder can be served from the output
+ * surfaces of the upstream decoder or VPP when they have exactly the same
+ * layout, so that a chain of joined sessions works in a single pool */
+static inline gboolean
+_request_can_share_producer_frames (mfxFrameAllocRequest * _req,
+    GstMsdkAllocResponse * cached_resp)
+{
+  mfxFrameAllocRequest *cached_req = &cached_resp->request;
+
+  return (_req->Type & MSDK_MEMTYPE_CONSUMER) &&
+      (cached_req->Type & MSDK_MEMTYPE_PRODUCER) &&
+      (_req->Type & MFX_MEMTYPE_EXPORT_FRAME) ==
+      (cached_req->Type & MFX_MEMTYPE_EXPORT_FRAME) &&
+      _req->Info.FourCC == cached_req->Info.FourCC &&
+      _req->Info.ChromaFormat == cached_req->Info.ChromaFormat &&
+      _req->Info.Width == cached_req->Info.Width &&
+      _req->Info.Height == cached_req->Info.Height;
+}
+
 static gint
 _find_request (gconstpointer resp, gconstpointer req)
 {
   GstMsdkAllocResponse *cached_resp = (GstMsdkAllocResponse *) resp;
   mfxFrameAllocRequest *_req = (mfxFrameAllocRequest *) req;
 
+  if (_req->NumFrameSuggested > cached_resp->request.NumFrameSuggested)
+    return -1;
+
+  if (_request_can_share_producer_frames (_req, cached_resp))
+    return 0;
+
   /* Confirm if it's under the size of the cached response */
-  if (_req->NumFrameSuggested <= cached_resp->request.NumFrameSuggested &&
-      _requested_frame_size_is_equal_or_lower (_req, cached_resp))
+  if (_requested_frame_size_is_equal_or_lower (_req, cached_resp))
     return _req->Type & cached_resp->
         request.Type & MFX_MEMTYPE_FROM_DECODE ? 0 : -1;
 
@@ -416,9 +466,12 @@ GstMsdkAllocResponse *
 gst_msdk_context_get_cached_alloc_responses (GstMsdkContext * context,
     mfxFrameAllocResponse * resp)
 {
-  GstMsdkContextPrivate *priv = context->priv;
-  GList *l =
-      g_list_find_custom (priv->cached_alloc_responses, resp, _find_response);
+  GstMsdkContextPrivate *priv = _get_shared_priv (context);
+  GList *l;
+
+  g_mutex_lock (&priv->mutex);
+  l = g_list_find_custom (priv->cached_alloc_responses, resp, _find_response);
+  g_mutex_unlock (&priv->mutex);
 
   if (l)
     return l->data;
@@ -430,14 +483,23 @@ GstMsdkAllocResponse *
 gst_msdk_context_get_cached_alloc_responses_by_request (GstMsdkContext *
     context, mfxFrameAllocRequest * req)
 {
-  GstMsdkContextPrivate *priv = context->priv;
-  GList *l =
-      g_list_find_custom (priv->cached_alloc_responses, req, _find_request);
+  GstMsdkContextPrivate *priv = _get_shared_priv (context);
+  GList *l;
 
-  if (l)
-    return l->data;
-  else
+  g_mutex_lock (&priv->mutex);
+  l = g_list_find_custom (priv->cached_alloc_responses, req, _find_request);
+  g_mutex_unlock (&priv->mutex);
+
+  if (l) {
+    GstMsdkAllocResponse *cached = l->data;
+
+    GST_DEBUG ("Reusing %d cached surfaces of type 0x%x for request of "
+        "type 0x%x", cached->response.NumFrameActual, cached->request.Type,
+        req->Type);
+    return cached;
+  } else {
     return NULL;
+  }
 }
 
 static void
@@ -477,10 +539,14 @@ void
 gst_msdk_context_add_alloc_response (GstMsdkContext * context,
     GstMsdkAllocResponse * resp)
 {
-  context->priv->cached_alloc_responses =
-      g_list_prepend (context->priv->cached_alloc_responses, resp);
+  GstMsdkContextPrivate *priv = _get_shared_priv (context);
 
   create_surfaces (context, resp);
+
+  g_mutex_lock (&priv->mutex);
+  priv->cached_alloc_responses =
+      g_list_prepend (priv->cached_alloc_responses, resp);
+  g_mutex_unlock (&priv->mutex);
 }
 
 gboolean
@@ -488,20 +554,24 @@ gst_msdk_context_remove_alloc_response (GstMsdkContext * context,
     mfxFrameAllocResponse * resp)
 {
   GstMsdkAllocResponse *msdk_resp;
-  GstMsdkContextPrivate *priv = context->priv;
-  GList *l =
-      g_list_find_custom (priv->cached_alloc_responses, resp, _find_response);
+  GstMsdkContextPrivate *priv = _get_shared_priv (context);
+  GList *l;
 
-  if (!l)
+  g_mutex_lock (&priv->mutex);
+  l = g_list_find_custom (priv->cached_alloc_responses, resp, _find_response);
+  if (!l) {
+    g_mutex_unlock (&priv->mutex);
     return FALSE;
+  }
 
   msdk_resp = l->data;
+  priv->cached_alloc_responses =
+      g_list_delete_link (priv->cached_alloc_responses, l);
+  g_mutex_unlock (&priv->mutex);
 
   remove_surfaces (context, msdk_resp);
 
   g_slice_free1 (sizeof (GstMsdkAllocResponse), msdk_resp);
-  priv->cached_alloc_responses =
-      g_list_delete_link (priv->cached_alloc_responses, l);
 
   return TRUE;
 }
@@ -511,7 +581,7 @@ check_surfaces_available (GstMsdkContext * context, GstMsdkAllocResponse * resp)
 {
   GList *l;
   mfxFrameSurface1 *surface = NULL;
-  GstMsdkContextPrivate *priv = context->priv;
+  GstMsdkContextPrivate *priv = _get_shared_priv (context);
   gboolean ret = FALSE;
 
   g_mutex_lock (&priv->mutex);
@@ -547,7 +617,7 @@ gst_msdk_context_get_surface_available (GstMsdkContext * context,
   GstMsdkAllocResponse *msdk_resp =
       gst_msdk_context_get_cached_alloc_responses (context, resp);
   gint retry = 0;
-  GstMsdkContextPrivate *priv = context->priv;
+  GstMsdkContextPrivate *priv = _get_shared_priv (context);
 
 retry:
   g_mutex_lock (&priv->mutex);
@@ -590,7 +660,7 @@ void
 gst_msdk_context_put_surface_locked (GstMsdkContext * context,
     mfxFrameAllocResponse * resp, mfxFrameSurface1 * surface)
 {
-  GstMsdkContextPrivate *priv = context->priv;
+  GstMsdkContextPrivate *priv = _get_shared_priv (context);
   GstMsdkAllocResponse *msdk_resp =
       gst_msdk_context_get_cached_alloc_responses (context, resp);
 
@@ -608,7 +678,7 @@ void
 gst_msdk_context_put_surface_available (GstMsdkContext * context,
     mfxFrameAllocResponse * resp, mfxFrameSurface1 * surface)
 {
-  GstMsdkContextPrivate *priv = context->priv;
+  GstMsdkContextPrivate *priv = _get_shared_priv (context);
   GstMsdkAllocResponse *msdk_resp =
       gst_msdk_context_get_cached_alloc_responses (context, resp);
 
@@ -94,6 +94,9 @@ gint gst_msdk_context_get_fd (GstMsdkContext * context);
 
 /* GstMsdkContext contains mfxFrameAllocResponses,
  * if app calls MFXVideoCORE_SetFrameAllocator.
+ * Contexts created by gst_msdk_context_new_with_parent() share the
+ * responses of their parent, so the surfaces of a response can be used
+ * by any element of the joined sessions.
  */
 typedef struct _GstMsdkAllocResponse GstMsdkAllocResponse;
 
@@ -56,6 +56,7 @@
 #define DIV_UP(size,block) (((size) + ((block) - 1)) / (block))
 
 static gboolean cuda_converter_lookup_path (GstCudaConverter * convert);
+static void convert_flush_pending_textures (GstCudaConverter * convert);
 
 #ifndef GST_DISABLE_GST_DEBUG
 #define GST_CAT_DEFAULT ensure_debug_category()
@@ -728,6 +729,7 @@ typedef struct
 } GstCudaStageBuffer;
 
 #define CONVERTER_MAX_NUM_FUNC 4
+#define CONVERTER_MAX_NUM_TEXTURE 4
 
 struct _GstCudaConverter
 {
@@ -759,6 +761,12 @@ struct _GstCudaConverter
   GstCudaRGBOrder in_rgb_order;
   GstCudaStageBuffer unpack_surface;
   GstCudaStageBuffer y444_surface[GST_VIDEO_MAX_PLANES];
+
+  /* set while converting as part of gst_cuda_converter_frame_multi(),
+   * textures are then destroyed once the whole batch is done */
+  gboolean deferred;
+  CUtexObject pending_texture[CONVERTER_MAX_NUM_TEXTURE];
+  guint n_pending_textures;
 };
 
 #define LOAD_CUDA_FUNC(module,func,name) G_STMT_START { \
@@ -954,6 +962,60 @@ gst_cuda_converter_frame_unlocked (GstCudaConverter * convert,
   return convert->convert (convert, src, in_info, dst, out_info, cuda_stream);
 }
 
+/**
+ * gst_cuda_converter_frame_multi_unlocked:
+ * @converts: (array length=n_converts): #GstCudaConverter objects
+ *   sharing the same input format
+ * @n_converts: the number of converters, destinations and output infos
+ * @src: a #GstCudaMemory
+ * @in_info: a #GstVideoInfo representing @src
+ * @dst: (array length=n_converts): a #GstCudaMemory per converter
+ * @out_info: (array length=n_converts): a #GstVideoInfo representing
+ *   each @dst
+ * @cuda_stream: a #CUstream
+ *
+ * Convert the pixels of @src into every @dst. All the kernels are
+ * queued on @cuda_stream back to back and the stream is synchronized
+ * once, after the last of them, instead of once per converter.
+ * Caller should call this method after gst_cuda_context_push()
+ *
+ * Returns: %TRUE if all the conversions could be queued
+ */
+gboolean
+gst_cuda_converter_frame_multi_unlocked (GstCudaConverter ** converts,
+    guint n_converts, const GstCudaMemory * src, GstVideoInfo * in_info,
+    GstCudaMemory ** dst, GstVideoInfo ** out_info, CUstream cuda_stream)
+{
+  gboolean ret = TRUE;
+  guint i;
+
+  g_return_val_if_fail (converts, FALSE);
+  g_return_val_if_fail (src, FALSE);
+  g_return_val_if_fail (in_info, FALSE);
+  g_return_val_if_fail (dst, FALSE);
+  g_return_val_if_fail (out_info, FALSE);
+
+  for (i = 0; i < n_converts; i++) {
+    GstCudaConverter *convert = converts[i];
+
+    convert->deferred = TRUE;
+    if (!convert->convert (convert, src, in_info, dst[i], out_info[i],
+            cuda_stream)) {
+      GST_ERROR ("conversion %u out of %u failed", i, n_converts);
+      ret = FALSE;
+    }
+  }
+
+  gst_cuda_result (CuStreamSynchronize (cuda_stream));
+
+  for (i = 0; i < n_converts; i++) {
+    convert_flush_pending_textures (converts[i]);
+    converts[i]->deferred = FALSE;
+  }
+
+  return ret;
+}
+
 /* allocate fallback memory for texture alignment requirement */
 static gboolean
 convert_ensure_fallback_memory (GstCudaConverter * convert,
@@ -986,7 +1048,7 @@ convert_ensure_fallback_memory (GstCudaConverter * convert,
 static CUtexObject
 convert_create_texture_unchecked (const CUdeviceptr src, gint width,
     gint height, gint channels, gint stride, CUarray_format format,
-    CUfilter_mode mode, CUstream cuda_stream)
+    CUfilter_mode mode, gboolean sync, CUstream cuda_stream)
 {
   CUDA_TEXTURE_DESC texture_desc;
   CUDA_RESOURCE_DESC resource_desc;
@@ -1007,7 +1069,8 @@ convert_create_texture_unchecked (const CUdeviceptr src, gint width,
   texture_desc.filterMode = mode;
   texture_desc.flags = CU_TRSF_READ_AS_INTEGER;
 
-  gst_cuda_result (CuStreamSynchronize (cuda_stream));
+  if (sync)
+    gst_cuda_result (CuStreamSynchronize (cuda_stream));
   cuda_ret = CuTexObjectCreate (&texture, &resource_desc, &texture_desc, NULL);
 
   if (!gst_cuda_result (cuda_ret)) {
@@ -1081,7 +1144,34 @@ convert_create_texture (GstCudaConverter * convert, const GstCudaMemory * src,
   return convert_create_texture_unchecked (src_ptr,
       GST_VIDEO_INFO_COMP_WIDTH (info, plane),
       GST_VIDEO_INFO_COMP_HEIGHT (info, plane), channels, stride, format, mode,
-      cuda_stream);
+      !convert->deferred, cuda_stream);
+}
+
+/* destroy @texture now, or once the batch is synchronized if deferred */
+static void
+convert_release_texture (GstCudaConverter * convert, CUtexObject texture)
+{
+  if (!texture)
+    return;
+
+  if (convert->deferred &&
+      convert->n_pending_textures < CONVERTER_MAX_NUM_TEXTURE) {
+    convert->pending_texture[convert->n_pending_textures++] = texture;
+    return;
+  }
+
+  gst_cuda_result (CuTexObjectDestroy (texture));
+}
+
+static void
+convert_flush_pending_textures (GstCudaConverter * convert)
+{
+  guint i;
+
+  for (i = 0; i < convert->n_pending_textures; i++)
+    gst_cuda_result (CuTexObjectDestroy (convert->pending_texture[i]));
+
+  convert->n_pending_textures = 0;
 }
 
 /* main conversion function for YUV to YUV conversion */
@@ -1137,13 +1227,12 @@ convert_YUV_TO_YUV (GstCudaConverter * convert,
   }
 
   ret = TRUE;
-  gst_cuda_result (CuStreamSynchronize (cuda_stream));
+  if (!convert->deferred)
+    gst_cuda_result (CuStreamSynchronize (cuda_stream));
 
 done:
-  for (i = 0; i < GST_VIDEO_INFO_N_PLANES (in_info); i++) {
-    if (texture[i])
-      gst_cuda_result (CuTexObjectDestroy (texture[i]));
-  }
+  for (i = 0; i < GST_VIDEO_INFO_N_PLANES (in_info); i++)
+    convert_release_texture (convert, texture[i]);
 
   return ret;
 }
@@ -1199,13 +1288,12 @@ convert_YUV_TO_RGB (GstCudaConverter * convert,
   }
 
   ret = TRUE;
-  gst_cuda_result (CuStreamSynchronize (cuda_stream));
+  if (!convert->deferred)
+    gst_cuda_result (CuStreamSynchronize (cuda_stream));
 
 done:
-  for (i = 0; i < GST_VIDEO_INFO_N_PLANES (in_info); i++) {
-    if (texture[i])
-      gst_cuda_result (CuTexObjectDestroy (texture[i]));
-  }
+  for (i = 0; i < GST_VIDEO_INFO_N_PLANES (in_info); i++)
+    convert_release_texture (convert, texture[i]);
 
   return ret;
 }
@@ -1327,7 +1415,7 @@ convert_RGB_TO_YUV (GstCudaConverter * convert,
   texture =
       convert_create_texture_unchecked (convert->unpack_surface.device_ptr,
       in_width, in_height, 4, convert->unpack_surface.cuda_stride, format,
-      mode, cuda_stream);
+      mode, !convert->deferred, cuda_stream);
 
   if (!texture) {
     GST_ERROR ("could not create texture");
@@ -1357,7 +1445,7 @@ convert_RGB_TO_YUV (GstCudaConverter * convert,
     yuv_texture[i] =
         convert_create_texture_unchecked (convert->y444_surface[i].device_ptr,
         in_width, in_height, 1, convert->y444_surface[i].cuda_stride, format,
-        mode, cuda_stream);
+        mode, !convert->deferred, cuda_stream);
 
     if (!yuv_texture[i]) {
       GST_ERROR ("could not create %dth yuv texture", i);
@@ -1379,15 +1467,13 @@ convert_RGB_TO_YUV (GstCudaConverter * convert,
   }
 
   ret = TRUE;
-  gst_cuda_result (CuStreamSynchronize (cuda_stream));
+  if (!convert->deferred)
+    gst_cuda_result (CuStreamSynchronize (cuda_stream));
 
 done:
-  if (texture)
-    gst_cuda_result (CuTexObjectDestroy (texture));
-  for (i = 0; i < 3; i++) {
-    if (yuv_texture[i])
-      gst_cuda_result (CuTexObjectDestroy (yuv_texture[i]));
-  }
+  convert_release_texture (convert, texture);
+  for (i = 0; i < 3; i++)
+    convert_release_texture (convert, yuv_texture[i]);
 
   return ret;
 }
@@ -1447,7 +1533,7 @@ convert_RGB_TO_RGB (GstCudaConverter * convert,
   texture =
       convert_create_texture_unchecked (convert->unpack_surface.device_ptr,
       in_width, in_height, 4, convert->unpack_surface.cuda_stride, format,
-      mode, cuda_stream);
+      mode, !convert->deferred, cuda_stream);
 
   if (!texture) {
     GST_ERROR ("could not create texture");
@@ -1465,11 +1551,11 @@ convert_RGB_TO_RGB (GstCudaConverter * convert,
   }
 
   ret = TRUE;
-  gst_cuda_result (CuStreamSynchronize (cuda_stream));
+  if (!convert->deferred)
+    gst_cuda_result (CuStreamSynchronize (cuda_stream));
 
 done:
-  if (texture)
-    gst_cuda_result (CuTexObjectDestroy (texture));
+  convert_release_texture (convert, texture);
 
   return ret;
 }
@@ -56,6 +56,14 @@ gboolean             gst_cuda_converter_frame_unlocked (GstCudaConverter * conve
                                                         GstVideoInfo * out_info,
                                                         CUstream cuda_stream);
 
+G_GNUC_INTERNAL
+gboolean             gst_cuda_converter_frame_multi_unlocked (GstCudaConverter ** converts,
+                                                              guint n_converts,
+                                                              const GstCudaMemory * src,
+                                                              GstVideoInfo * in_info,
+                                                              GstCudaMemory ** dst,
+                                                              GstVideoInfo ** out_info,
+                                                              CUstream cuda_stream);
 
 G_END_DECLS
 
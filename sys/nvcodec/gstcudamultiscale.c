@@ -0,0 +1,892 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-cudamultiscale
+ * @title: cudamultiscale
+ * @see_also: cudascale, cudaconvert
+ *
+ * This element resizes and converts each CUDA frame into every one of
+ * its request source pads, for example to feed the renditions of an
+ * adaptive bitrate ladder. The size and format of each output is
+ * negotiated with its downstream peer. All the conversion kernels of
+ * an input frame are queued on a single CUDA stream, which is only
+ * synchronized once per input frame.
+ *
+ * Only CUDA memory is handled, so upload the frames with cudaupload
+ * first if needed.
+ *
+ * ## Example pipelines
+ * |[
+ * gst-launch-1.0 filesrc location=video.mp4 ! qtdemux ! h264parse ! nvh264dec ! cudamultiscale name=s \
+ *     s.src_0 ! "video/x-raw(memory:CUDAMemory),width=1280,height=720" ! nvh264enc ! fakesink \
+ *     s.src_1 ! "video/x-raw(memory:CUDAMemory),width=640,height=360" ! nvh264enc ! fakesink
+ * ]|
+ *  Decode an mp4/h264 and encode it again in two resolutions.
+ *
+ * Since: 1.20
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include "gstcudamultiscale.h"
+#include "gstcudabufferpool.h"
+#include "gstcudamemory.h"
+#include "gstcudautils.h"
+#include "cuda-converter.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_cuda_multi_scale_debug);
+#define GST_CAT_DEFAULT gst_cuda_multi_scale_debug
+
+enum
+{
+  PROP_0,
+  PROP_DEVICE_ID,
+};
+
+#define DEFAULT_DEVICE_ID -1
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE_WITH_FEATURES
+        (GST_CAPS_FEATURE_MEMORY_CUDA_MEMORY, GST_CUDA_CONVERTER_FORMATS))
+    );
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src_%u",
+    GST_PAD_SRC,
+    GST_PAD_REQUEST,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE_WITH_FEATURES
+        (GST_CAPS_FEATURE_MEMORY_CUDA_MEMORY, GST_CUDA_CONVERTER_FORMATS))
+    );
+
+/* source pads */
+
+#define GST_TYPE_CUDA_MULTI_SCALE_PAD (gst_cuda_multi_scale_pad_get_type ())
+#define GST_CUDA_MULTI_SCALE_PAD(obj) ((GstCudaMultiScalePad *) (obj))
+
+typedef struct _GstCudaMultiScalePad GstCudaMultiScalePad;
+typedef struct _GstCudaMultiScalePadClass GstCudaMultiScalePadClass;
+
+struct _GstCudaMultiScalePad
+{
+  GstPad parent;
+
+  /* only used by the streaming thread */
+  GstCaps *caps;
+  GstVideoInfo info;
+  GstBufferPool *pool;
+  GstCudaConverter *converter;
+  gboolean negotiated;
+};
+
+struct _GstCudaMultiScalePadClass
+{
+  GstPadClass parent_class;
+};
+
+static GType gst_cuda_multi_scale_pad_get_type (void);
+G_DEFINE_TYPE (GstCudaMultiScalePad, gst_cuda_multi_scale_pad, GST_TYPE_PAD);
+
+static void
+gst_cuda_multi_scale_pad_reset (GstCudaMultiScalePad * pad)
+{
+  if (pad->pool) {
+    gst_buffer_pool_set_active (pad->pool, FALSE);
+    gst_clear_object (&pad->pool);
+  }
+
+  if (pad->converter) {
+    gst_cuda_converter_free (pad->converter);
+    pad->converter = NULL;
+  }
+
+  gst_clear_caps (&pad->caps);
+  pad->negotiated = FALSE;
+}
+
+static void
+gst_cuda_multi_scale_pad_dispose (GObject * object)
+{
+  gst_cuda_multi_scale_pad_reset (GST_CUDA_MULTI_SCALE_PAD (object));
+
+  G_OBJECT_CLASS (gst_cuda_multi_scale_pad_parent_class)->dispose (object);
+}
+
+static void
+gst_cuda_multi_scale_pad_class_init (GstCudaMultiScalePadClass * klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = gst_cuda_multi_scale_pad_dispose;
+}
+
+static void
+gst_cuda_multi_scale_pad_init (GstCudaMultiScalePad * pad)
+{
+}
+
+/* element */
+
+#define gst_cuda_multi_scale_parent_class parent_class
+G_DEFINE_TYPE (GstCudaMultiScale, gst_cuda_multi_scale, GST_TYPE_ELEMENT);
+
+static void gst_cuda_multi_scale_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec);
+static void gst_cuda_multi_scale_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec);
+static void gst_cuda_multi_scale_dispose (GObject * object);
+static GstStateChangeReturn gst_cuda_multi_scale_change_state (GstElement *
+    element, GstStateChange transition);
+static void gst_cuda_multi_scale_set_context (GstElement * element,
+    GstContext * context);
+static GstPad *gst_cuda_multi_scale_request_new_pad (GstElement * element,
+    GstPadTemplate * templ, const gchar * name, const GstCaps * caps);
+static void gst_cuda_multi_scale_release_pad (GstElement * element,
+    GstPad * pad);
+static GstFlowReturn gst_cuda_multi_scale_chain (GstPad * pad,
+    GstObject * parent, GstBuffer * inbuf);
+static gboolean gst_cuda_multi_scale_sink_event (GstPad * pad,
+    GstObject * parent, GstEvent * event);
+static gboolean gst_cuda_multi_scale_sink_query (GstPad * pad,
+    GstObject * parent, GstQuery * query);
+static gboolean gst_cuda_multi_scale_src_query (GstPad * pad,
+    GstObject * parent, GstQuery * query);
+
+static void
+gst_cuda_multi_scale_class_init (GstCudaMultiScaleClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+
+  gobject_class->set_property = gst_cuda_multi_scale_set_property;
+  gobject_class->get_property = gst_cuda_multi_scale_get_property;
+  gobject_class->dispose = gst_cuda_multi_scale_dispose;
+
+  g_object_class_install_property (gobject_class, PROP_DEVICE_ID,
+      g_param_spec_int ("cuda-device-id",
+          "Cuda Device ID",
+          "Set the GPU device to use for operations (-1 = auto)",
+          -1, G_MAXINT, DEFAULT_DEVICE_ID,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_add_static_pad_template (element_class, &sink_template);
+  gst_element_class_add_static_pad_template_with_gtype (element_class,
+      &src_template, GST_TYPE_CUDA_MULTI_SCALE_PAD);
+
+  gst_element_class_set_static_metadata (element_class,
+      "CUDA Multiple Output Video scaler",
+      "Filter/Converter/Video/Scaler/Hardware",
+      "Resizes Video into several outputs using CUDA",
+      "GStreamer developers");
+
+  element_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_cuda_multi_scale_change_state);
+  element_class->set_context =
+      GST_DEBUG_FUNCPTR (gst_cuda_multi_scale_set_context);
+  element_class->request_new_pad =
+      GST_DEBUG_FUNCPTR (gst_cuda_multi_scale_request_new_pad);
+  element_class->release_pad =
+      GST_DEBUG_FUNCPTR (gst_cuda_multi_scale_release_pad);
+
+  GST_DEBUG_CATEGORY_INIT (gst_cuda_multi_scale_debug,
+      "cudamultiscale", 0, "Video Resize into several outputs using CUDA");
+}
+
+static void
+gst_cuda_multi_scale_init (GstCudaMultiScale * self)
+{
+  self->sinkpad = gst_pad_new_from_static_template (&sink_template, "sink");
+  gst_pad_set_chain_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_cuda_multi_scale_chain));
+  gst_pad_set_event_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_cuda_multi_scale_sink_event));
+  gst_pad_set_query_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_cuda_multi_scale_sink_query));
+  GST_PAD_SET_PROXY_SCHEDULING (self->sinkpad);
+  gst_element_add_pad (GST_ELEMENT (self), self->sinkpad);
+
+  self->flow_combiner = gst_flow_combiner_new ();
+  self->device_id = DEFAULT_DEVICE_ID;
+}
+
+static void
+gst_cuda_multi_scale_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstCudaMultiScale *self = GST_CUDA_MULTI_SCALE (object);
+
+  switch (prop_id) {
+    case PROP_DEVICE_ID:
+      self->device_id = g_value_get_int (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_cuda_multi_scale_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstCudaMultiScale *self = GST_CUDA_MULTI_SCALE (object);
+
+  switch (prop_id) {
+    case PROP_DEVICE_ID:
+      g_value_set_int (value, self->device_id);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_cuda_multi_scale_dispose (GObject * object)
+{
+  GstCudaMultiScale *self = GST_CUDA_MULTI_SCALE (object);
+
+  gst_clear_caps (&self->incaps);
+  gst_clear_object (&self->context);
+
+  if (self->flow_combiner) {
+    gst_flow_combiner_free (self->flow_combiner);
+    self->flow_combiner = NULL;
+  }
+
+  G_OBJECT_CLASS (parent_class)->dispose (object);
+}
+
+static gboolean
+gst_cuda_multi_scale_open (GstCudaMultiScale * self)
+{
+  CUresult cuda_ret;
+
+  if (!gst_cuda_ensure_element_context (GST_ELEMENT_CAST (self),
+          self->device_id, &self->context)) {
+    GST_ERROR_OBJECT (self, "Failed to get CUDA context");
+    return FALSE;
+  }
+
+  if (gst_cuda_context_push (self->context)) {
+    cuda_ret = CuStreamCreate (&self->cuda_stream, CU_STREAM_DEFAULT);
+    if (!gst_cuda_result (cuda_ret)) {
+      GST_WARNING_OBJECT (self,
+          "Could not create cuda stream, will use default stream");
+      self->cuda_stream = NULL;
+    }
+    gst_cuda_context_pop (NULL);
+  }
+
+  return TRUE;
+}
+
+static void
+gst_cuda_multi_scale_close (GstCudaMultiScale * self)
+{
+  if (self->context && self->cuda_stream) {
+    if (gst_cuda_context_push (self->context)) {
+      gst_cuda_result (CuStreamDestroy (self->cuda_stream));
+      gst_cuda_context_pop (NULL);
+    }
+  }
+
+  gst_clear_object (&self->context);
+  self->cuda_stream = NULL;
+}
+
+static GstStateChangeReturn
+gst_cuda_multi_scale_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstCudaMultiScale *self = GST_CUDA_MULTI_SCALE (element);
+  GstStateChangeReturn ret;
+  GList *l;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_NULL_TO_READY:
+      if (!gst_cuda_multi_scale_open (self))
+        return GST_STATE_CHANGE_FAILURE;
+      break;
+    default:
+      break;
+  }
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+  switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      GST_OBJECT_LOCK (self);
+      for (l = element->srcpads; l; l = l->next)
+        gst_cuda_multi_scale_pad_reset (l->data);
+      gst_flow_combiner_reset (self->flow_combiner);
+      GST_OBJECT_UNLOCK (self);
+      gst_clear_caps (&self->incaps);
+      break;
+    case GST_STATE_CHANGE_READY_TO_NULL:
+      gst_cuda_multi_scale_close (self);
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+}
+
+static void
+gst_cuda_multi_scale_set_context (GstElement * element, GstContext * context)
+{
+  GstCudaMultiScale *self = GST_CUDA_MULTI_SCALE (element);
+
+  gst_cuda_handle_set_context (element,
+      context, self->device_id, &self->context);
+
+  GST_ELEMENT_CLASS (parent_class)->set_context (element, context);
+}
+
+static GstPad *
+gst_cuda_multi_scale_request_new_pad (GstElement * element,
+    GstPadTemplate * templ, const gchar * name, const GstCaps * caps)
+{
+  GstCudaMultiScale *self = GST_CUDA_MULTI_SCALE (element);
+  GstPad *pad;
+
+  pad = g_object_new (GST_TYPE_CUDA_MULTI_SCALE_PAD, "name", name,
+      "direction", templ->direction, "template", templ, NULL);
+  gst_pad_set_query_function (pad,
+      GST_DEBUG_FUNCPTR (gst_cuda_multi_scale_src_query));
+
+  if (!gst_element_add_pad (element, pad)) {
+    GST_WARNING_OBJECT (self, "Failed to add pad %s", name);
+    gst_object_unref (pad);
+    return NULL;
+  }
+
+  GST_OBJECT_LOCK (self);
+  gst_flow_combiner_add_pad (self->flow_combiner, pad);
+  GST_OBJECT_UNLOCK (self);
+
+  GST_DEBUG_OBJECT (self, "Added pad %s:%s", GST_DEBUG_PAD_NAME (pad));
+
+  return pad;
+}
+
+static void
+gst_cuda_multi_scale_release_pad (GstElement * element, GstPad * pad)
+{
+  GstCudaMultiScale *self = GST_CUDA_MULTI_SCALE (element);
+
+  GST_DEBUG_OBJECT (self, "Releasing pad %s:%s", GST_DEBUG_PAD_NAME (pad));
+
+  GST_OBJECT_LOCK (self);
+  gst_flow_combiner_remove_pad (self->flow_combiner, pad);
+  GST_OBJECT_UNLOCK (self);
+
+  gst_pad_set_active (pad, FALSE);
+  gst_element_remove_pad (element, pad);
+}
+
+/* Keeps the aspect ratio of the input frame when downstream only
+ * constrains one dimension, otherwise the nearest size to the input
+ * one is chosen. Framerate and interlacing can't be converted. */
+static GstCaps *
+_fixate_caps (GstCudaMultiScale * self, GstCaps * caps)
+{
+  GstStructure *s;
+  gint in_width, in_height, width = 0, height = 0;
+  gboolean has_width, has_height;
+
+  caps = gst_caps_make_writable (gst_caps_truncate (caps));
+  s = gst_caps_get_structure (caps, 0);
+
+  in_width = GST_VIDEO_INFO_WIDTH (&self->in_info);
+  in_height = GST_VIDEO_INFO_HEIGHT (&self->in_info);
+
+  gst_structure_fixate_field_string (s, "format",
+      GST_VIDEO_INFO_NAME (&self->in_info));
+
+  has_width = gst_structure_get_int (s, "width", &width);
+  has_height = gst_structure_get_int (s, "height", &height);
+
+  if (has_width && !has_height) {
+    height = gst_util_uint64_scale_int (width, in_height, in_width);
+    gst_structure_fixate_field_nearest_int (s, "height", height);
+  } else if (!has_width && has_height) {
+    width = gst_util_uint64_scale_int (height, in_width, in_height);
+    gst_structure_fixate_field_nearest_int (s, "width", width);
+  } else if (!has_width && !has_height) {
+    gst_structure_fixate_field_nearest_int (s, "width", in_width);
+    gst_structure_fixate_field_nearest_int (s, "height", in_height);
+  }
+
+  if (gst_structure_has_field (s, "pixel-aspect-ratio")) {
+    gst_structure_fixate_field_nearest_fraction (s, "pixel-aspect-ratio",
+        GST_VIDEO_INFO_PAR_N (&self->in_info),
+        GST_VIDEO_INFO_PAR_D (&self->in_info));
+  }
+
+  gst_structure_set (s, "framerate", GST_TYPE_FRACTION,
+      GST_VIDEO_INFO_FPS_N (&self->in_info),
+      GST_VIDEO_INFO_FPS_D (&self->in_info), NULL);
+
+  if (GST_VIDEO_INFO_IS_INTERLACED (&self->in_info)) {
+    gst_structure_set (s, "interlace-mode", G_TYPE_STRING,
+        gst_video_interlace_mode_to_string (GST_VIDEO_INFO_INTERLACE_MODE
+            (&self->in_info)), NULL);
+  }
+
+  return gst_caps_fixate (caps);
+}
+
+static GstBufferPool *
+_create_pool (GstCudaMultiScale * self, GstCudaMultiScalePad * srcpad)
+{
+  GstBufferPool *pool;
+  GstQuery *query;
+  GstStructure *config;
+  guint min = 0, max = 0;
+
+  /* only the buffer count is taken from downstream, the output
+   * memory has to belong to our CUDA context */
+  query = gst_query_new_allocation (srcpad->caps, TRUE);
+  if (gst_pad_peer_query (GST_PAD (srcpad), query)
+      && gst_query_get_n_allocation_pools (query) > 0)
+    gst_query_parse_nth_allocation_pool (query, 0, NULL, NULL, &min, &max);
+  gst_query_unref (query);
+
+  pool = gst_cuda_buffer_pool_new (self->context);
+
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_add_option (config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+  gst_buffer_pool_config_set_params (config, srcpad->caps,
+      GST_VIDEO_INFO_SIZE (&srcpad->info), min, max);
+
+  if (!gst_buffer_pool_set_config (pool, config)
+      || !gst_buffer_pool_set_active (pool, TRUE)) {
+    GST_WARNING_OBJECT (srcpad, "Failed to configure pool");
+    gst_clear_object (&pool);
+  }
+
+  return pool;
+}
+
+static gboolean
+_replay_sticky_event (GstPad * sinkpad, GstEvent ** event, gpointer user_data)
+{
+  GstPad *srcpad = user_data;
+
+  /* caps are negotiated per pad and EOS is never replayed */
+  if (GST_EVENT_TYPE (*event) != GST_EVENT_CAPS
+      && GST_EVENT_TYPE (*event) != GST_EVENT_EOS)
+    gst_pad_store_sticky_event (srcpad, *event);
+
+  return TRUE;
+}
+
+static gboolean
+_negotiate_pad (GstCudaMultiScale * self, GstCudaMultiScalePad * srcpad)
+{
+  GstPad *pad = GST_PAD (srcpad);
+  GstCaps *templ, *caps;
+  GstVideoInfo info;
+
+  templ = gst_pad_get_pad_template_caps (pad);
+  caps = gst_pad_peer_query_caps (pad, templ);
+  gst_caps_unref (templ);
+
+  if (gst_caps_is_empty (caps)) {
+    gst_caps_unref (caps);
+    GST_WARNING_OBJECT (pad, "No common caps with downstream");
+    return FALSE;
+  }
+
+  caps = _fixate_caps (self, caps);
+
+  if (!gst_video_info_from_caps (&info, caps)) {
+    GST_WARNING_OBJECT (pad, "Invalid caps %" GST_PTR_FORMAT, caps);
+    gst_caps_unref (caps);
+    return FALSE;
+  }
+
+  if (srcpad->negotiated && gst_caps_is_equal (caps, srcpad->caps)) {
+    gst_caps_unref (caps);
+    return TRUE;
+  }
+
+  GST_DEBUG_OBJECT (pad, "negotiated %" GST_PTR_FORMAT, caps);
+
+  gst_cuda_multi_scale_pad_reset (srcpad);
+  srcpad->caps = caps;
+  srcpad->info = info;
+
+  srcpad->converter = gst_cuda_converter_new (&self->in_info, &srcpad->info,
+      self->context);
+  if (!srcpad->converter) {
+    GST_ERROR_OBJECT (pad, "could not create converter");
+    return FALSE;
+  }
+
+  /* stream-start has to go before the caps, and segment and tags
+   * after them */
+  gst_pad_sticky_events_foreach (self->sinkpad, _replay_sticky_event, pad);
+
+  if (!gst_pad_push_event (pad, gst_event_new_caps (caps)))
+    return FALSE;
+
+  if (!(srcpad->pool = _create_pool (self, srcpad)))
+    return FALSE;
+
+  srcpad->negotiated = TRUE;
+
+  return TRUE;
+}
+
+static gboolean
+gst_cuda_multi_scale_set_caps (GstCudaMultiScale * self, GstCaps * caps)
+{
+  GstVideoInfo info;
+  GList *l;
+
+  if (!self->context) {
+    GST_ERROR_OBJECT (self, "No available CUDA context");
+    return FALSE;
+  }
+
+  if (!gst_video_info_from_caps (&info, caps)) {
+    GST_WARNING_OBJECT (self, "Invalid caps %" GST_PTR_FORMAT, caps);
+    return FALSE;
+  }
+
+  gst_caps_replace (&self->incaps, caps);
+  self->in_info = info;
+
+  /* converters depend on the input format, so every source pad is
+   * (re)negotiated when the next buffer arrives */
+  GST_OBJECT_LOCK (self);
+  for (l = GST_ELEMENT (self)->srcpads; l; l = l->next)
+    gst_pad_mark_reconfigure (l->data);
+  GST_OBJECT_UNLOCK (self);
+
+  return TRUE;
+}
+
+static gboolean
+gst_cuda_multi_scale_sink_event (GstPad * pad, GstObject * parent,
+    GstEvent * event)
+{
+  GstCudaMultiScale *self = GST_CUDA_MULTI_SCALE (parent);
+  gboolean ret;
+  GList *srcpads, *l;
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_CAPS:{
+      GstCaps *caps;
+
+      gst_event_parse_caps (event, &caps);
+      ret = gst_cuda_multi_scale_set_caps (self, caps);
+      gst_event_unref (event);
+      return ret;
+    }
+    case GST_EVENT_EOS:
+      break;
+    default:
+      if (!GST_EVENT_IS_STICKY (event)
+          || GST_EVENT_TYPE (event) < GST_EVENT_CAPS)
+        break;
+
+      /* pads without caps get it when they are negotiated */
+      GST_OBJECT_LOCK (self);
+      srcpads = g_list_copy_deep (GST_ELEMENT (self)->srcpads,
+          (GCopyFunc) gst_object_ref, NULL);
+      GST_OBJECT_UNLOCK (self);
+
+      for (l = srcpads; l; l = l->next) {
+        if (GST_CUDA_MULTI_SCALE_PAD (l->data)->negotiated)
+          gst_pad_push_event (l->data, gst_event_ref (event));
+      }
+
+      g_list_free_full (srcpads, gst_object_unref);
+      gst_event_unref (event);
+      return TRUE;
+  }
+
+  return gst_pad_event_default (pad, parent, event);
+}
+
+static gboolean
+gst_cuda_multi_scale_propose_allocation (GstCudaMultiScale * self,
+    GstQuery * query)
+{
+  GstBufferPool *pool;
+  GstStructure *config;
+  GstVideoInfo info;
+  GstCaps *caps;
+  guint size;
+
+  gst_query_parse_allocation (query, &caps, NULL);
+
+  if (caps == NULL)
+    return FALSE;
+
+  if (!gst_video_info_from_caps (&info, caps))
+    return FALSE;
+
+  if (gst_query_get_n_allocation_pools (query) > 0)
+    return TRUE;
+
+  size = GST_VIDEO_INFO_SIZE (&info);
+
+  pool = gst_cuda_buffer_pool_new (self->context);
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_add_option (config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+  gst_buffer_pool_config_set_params (config, caps, size, 0, 0);
+
+  if (!gst_buffer_pool_set_config (pool, config)) {
+    GST_ERROR_OBJECT (self, "failed to set config");
+    gst_object_unref (pool);
+    return FALSE;
+  }
+
+  gst_query_add_allocation_pool (query, pool, size, 0, 0);
+  gst_query_add_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
+  gst_object_unref (pool);
+
+  return TRUE;
+}
+
+static gboolean
+gst_cuda_multi_scale_sink_query (GstPad * pad, GstObject * parent,
+    GstQuery * query)
+{
+  GstCudaMultiScale *self = GST_CUDA_MULTI_SCALE (parent);
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CAPS:{
+      GstCaps *filter, *caps;
+
+      /* any size can be produced, so it doesn't depend on downstream */
+      gst_query_parse_caps (query, &filter);
+      caps = gst_pad_get_pad_template_caps (pad);
+      if (filter) {
+        GstCaps *tmp = gst_caps_intersect_full (filter, caps,
+            GST_CAPS_INTERSECT_FIRST);
+        gst_caps_unref (caps);
+        caps = tmp;
+      }
+      gst_query_set_caps_result (query, caps);
+      gst_caps_unref (caps);
+      return TRUE;
+    }
+    case GST_QUERY_ALLOCATION:
+      if (!self->context)
+        return FALSE;
+      return gst_cuda_multi_scale_propose_allocation (self, query);
+    case GST_QUERY_CONTEXT:
+      if (gst_cuda_handle_context_query (GST_ELEMENT (self), query,
+              self->context))
+        return TRUE;
+      break;
+    default:
+      break;
+  }
+
+  return gst_pad_query_default (pad, parent, query);
+}
+
+static gboolean
+gst_cuda_multi_scale_src_query (GstPad * pad, GstObject * parent,
+    GstQuery * query)
+{
+  GstCudaMultiScale *self = GST_CUDA_MULTI_SCALE (parent);
+
+  if (GST_QUERY_TYPE (query) == GST_QUERY_CONTEXT &&
+      gst_cuda_handle_context_query (GST_ELEMENT (self), query,
+          self->context))
+    return TRUE;
+
+  return gst_pad_query_default (pad, parent, query);
+}
+
+static gboolean
+_is_usable_cuda_memory (GstCudaMultiScale * self, GstBuffer * buffer)
+{
+  GstMemory *mem;
+  GstCudaMemory *cmem;
+
+  if (gst_buffer_n_memory (buffer) != 1)
+    return FALSE;
+
+  mem = gst_buffer_peek_memory (buffer, 0);
+  if (!gst_is_cuda_memory (mem))
+    return FALSE;
+
+  cmem = GST_CUDA_MEMORY_CAST (mem);
+
+  return cmem->context == self->context ||
+      gst_cuda_context_get_handle (cmem->context) ==
+      gst_cuda_context_get_handle (self->context) ||
+      (gst_cuda_context_can_access_peer (cmem->context, self->context) &&
+      gst_cuda_context_can_access_peer (self->context, cmem->context));
+}
+
+static GstFlowReturn
+_update_flow (GstCudaMultiScale * self, GstPad * pad, GstFlowReturn flow)
+{
+  GstFlowReturn ret;
+
+  GST_OBJECT_LOCK (self);
+  ret = gst_flow_combiner_update_pad_flow (self->flow_combiner, pad, flow);
+  GST_OBJECT_UNLOCK (self);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_cuda_multi_scale_chain (GstPad * pad, GstObject * parent,
+    GstBuffer * inbuf)
+{
+  GstCudaMultiScale *self = GST_CUDA_MULTI_SCALE (parent);
+  GstCudaMultiScalePad **srcpads;
+  GstCudaConverter **converters;
+  GstCudaMemory **out_mems;
+  GstVideoInfo **out_infos;
+  GstVideoFrame in_frame, *out_frames;
+  GstBuffer **outbufs;
+  GstFlowReturn ret = GST_FLOW_NOT_LINKED;
+  GList *pads, *l;
+  guint i, num = 0, num_pads;
+  gboolean converted = FALSE;
+
+  if (!_is_usable_cuda_memory (self, inbuf)) {
+    GST_ELEMENT_ERROR (self, STREAM, FAILED, (NULL),
+        ("Input buffer is not accessible CUDA memory"));
+    gst_buffer_unref (inbuf);
+    return GST_FLOW_ERROR;
+  }
+
+  GST_OBJECT_LOCK (self);
+  pads = g_list_copy_deep (GST_ELEMENT (self)->srcpads,
+      (GCopyFunc) gst_object_ref, NULL);
+  GST_OBJECT_UNLOCK (self);
+
+  num_pads = g_list_length (pads);
+  srcpads = g_new (GstCudaMultiScalePad *, num_pads);
+  converters = g_new (GstCudaConverter *, num_pads);
+  out_mems = g_new (GstCudaMemory *, num_pads);
+  out_infos = g_new (GstVideoInfo *, num_pads);
+  out_frames = g_new (GstVideoFrame, num_pads);
+  outbufs = g_new (GstBuffer *, num_pads);
+
+  for (l = pads; l; l = l->next) {
+    GstCudaMultiScalePad *srcpad = l->data;
+    GstFlowReturn flow;
+
+    if (!gst_pad_is_linked (GST_PAD (srcpad))) {
+      ret = _update_flow (self, GST_PAD (srcpad), GST_FLOW_NOT_LINKED);
+      continue;
+    }
+
+    if (gst_pad_check_reconfigure (GST_PAD (srcpad)) || !srcpad->negotiated) {
+      if (!_negotiate_pad (self, srcpad)) {
+        gst_cuda_multi_scale_pad_reset (srcpad);
+        gst_pad_mark_reconfigure (GST_PAD (srcpad));
+        flow = GST_PAD_IS_FLUSHING (GST_PAD (srcpad)) ?
+            GST_FLOW_FLUSHING : GST_FLOW_NOT_NEGOTIATED;
+        ret = _update_flow (self, GST_PAD (srcpad), flow);
+        continue;
+      }
+    }
+
+    flow = gst_buffer_pool_acquire_buffer (srcpad->pool, &outbufs[num], NULL);
+    if (flow != GST_FLOW_OK) {
+      ret = _update_flow (self, GST_PAD (srcpad), flow);
+      continue;
+    }
+
+    srcpads[num] = srcpad;
+    num++;
+  }
+
+  if (num == 0)
+    goto done;
+
+  /* mapping with GST_MAP_CUDA makes sure the device memory is up to
+   * date, the converters only access it through the CUDA pointers */
+  if (!gst_video_frame_map (&in_frame, &self->in_info, inbuf,
+          GST_MAP_READ | GST_MAP_CUDA | GST_VIDEO_FRAME_MAP_FLAG_NO_REF)) {
+    GST_ERROR_OBJECT (self, "Failed to map input buffer");
+    goto push;
+  }
+
+  for (i = 0; i < num; i++) {
+    if (!gst_video_frame_map (&out_frames[i], &srcpads[i]->info, outbufs[i],
+            GST_MAP_WRITE | GST_MAP_CUDA | GST_VIDEO_FRAME_MAP_FLAG_NO_REF)) {
+      GST_ERROR_OBJECT (srcpads[i], "Failed to map output buffer");
+      break;
+    }
+
+    converters[i] = srcpads[i]->converter;
+    out_mems[i] = GST_CUDA_MEMORY_CAST (gst_buffer_peek_memory (outbufs[i], 0));
+    out_infos[i] = &srcpads[i]->info;
+  }
+
+  if (i == num && gst_cuda_context_push (self->context)) {
+    converted = gst_cuda_converter_frame_multi_unlocked (converters, num,
+        GST_CUDA_MEMORY_CAST (gst_buffer_peek_memory (inbuf, 0)),
+        &self->in_info, out_mems, out_infos, self->cuda_stream);
+    gst_cuda_context_pop (NULL);
+  }
+
+  while (i > 0)
+    gst_video_frame_unmap (&out_frames[--i]);
+  gst_video_frame_unmap (&in_frame);
+
+push:
+  if (!converted) {
+    GST_ELEMENT_WARNING (self, STREAM, FAILED, (NULL),
+        ("Failed to convert input frame"));
+  }
+
+  for (i = 0; i < num; i++) {
+    GstFlowReturn flow;
+
+    gst_buffer_copy_into (outbufs[i], inbuf,
+        GST_BUFFER_COPY_FLAGS | GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+    if (!converted)
+      GST_BUFFER_FLAG_SET (outbufs[i], GST_BUFFER_FLAG_CORRUPTED);
+
+    flow = gst_pad_push (GST_PAD (srcpads[i]), outbufs[i]);
+    ret = _update_flow (self, GST_PAD (srcpads[i]), flow);
+  }
+
+done:
+  g_free (srcpads);
+  g_free (converters);
+  g_free (out_mems);
+  g_free (out_infos);
+  g_free (out_frames);
+  g_free (outbufs);
+  g_list_free_full (pads, gst_object_unref);
+  gst_buffer_unref (inbuf);
+
+  return ret;
+}
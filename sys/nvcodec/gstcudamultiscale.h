@@ -0,0 +1,67 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_CUDA_MULTI_SCALE_H__
+#define __GST_CUDA_MULTI_SCALE_H__
+
+#include <gst/gst.h>
+#include <gst/base/gstflowcombiner.h>
+#include <gst/video/video.h>
+
+#include "gstcudacontext.h"
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_CUDA_MULTI_SCALE             (gst_cuda_multi_scale_get_type())
+#define GST_CUDA_MULTI_SCALE(obj)             (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_CUDA_MULTI_SCALE,GstCudaMultiScale))
+#define GST_CUDA_MULTI_SCALE_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST((klass), GST_TYPE_CUDA_MULTI_SCALE,GstCudaMultiScaleClass))
+#define GST_CUDA_MULTI_SCALE_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS((obj), GST_TYPE_CUDA_MULTI_SCALE,GstCudaMultiScaleClass))
+#define GST_IS_CUDA_MULTI_SCALE(obj)          (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_CUDA_MULTI_SCALE))
+#define GST_IS_CUDA_MULTI_SCALE_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE((klass), GST_TYPE_CUDA_MULTI_SCALE))
+
+typedef struct _GstCudaMultiScale GstCudaMultiScale;
+typedef struct _GstCudaMultiScaleClass GstCudaMultiScaleClass;
+
+struct _GstCudaMultiScale
+{
+  GstElement parent;
+
+  GstPad *sinkpad;
+
+  GstCudaContext *context;
+  CUstream cuda_stream;
+
+  GstCaps *incaps;
+  GstVideoInfo in_info;
+
+  /* protected by the object lock */
+  GstFlowCombiner *flow_combiner;
+
+  gint device_id;
+};
+
+struct _GstCudaMultiScaleClass
+{
+  GstElementClass parent_class;
+};
+
+GType gst_cuda_multi_scale_get_type (void);
+
+G_END_DECLS
+
+#endif /* __GST_CUDA_MULTI_SCALE_H__ */
@@ -23,9 +23,17 @@
 
 #include "gstcudanvrtc.h"
 
+#include <string.h>
+#include <glib/gstdio.h>
+
 GST_DEBUG_CATEGORY_STATIC (gst_cuda_nvrtc_debug);
 #define GST_CAT_DEFAULT gst_cuda_nvrtc_debug
 
+/* Compiled PTX, keyed by checksum of source, compile option and driver
+ * version. Shared by every converter/filter instance in this process */
+G_LOCK_DEFINE_STATIC (ptx_cache_lock);
+static GHashTable *ptx_cache = NULL;
+
 static void
 _init_debug (void)
 {
@@ -39,31 +47,14 @@ _init_debug (void)
   }
 }
 
-gchar *
-gst_cuda_nvrtc_compile (const gchar * source)
+static gchar *
+gst_cuda_nvrtc_compile_program (const gchar * source, const gchar * arch_opt)
 {
   nvrtcProgram prog;
   nvrtcResult ret;
-  CUresult curet;
-  const gchar *opts[] = { "--gpu-architecture=compute_30" };
+  const gchar *opts[] = { arch_opt };
   gsize ptx_size;
   gchar *ptx = NULL;
-  int driverVersion;
-
-  g_return_val_if_fail (source != NULL, FALSE);
-
-  _init_debug ();
-
-  GST_TRACE ("CUDA kernel source \n%s", source);
-
-  curet = CuDriverGetVersion (&driverVersion);
-  if (curet != CUDA_SUCCESS) {
-    GST_ERROR ("Failed to query CUDA Driver version, ret %d", curet);
-    return NULL;
-  }
-
-  GST_DEBUG ("CUDA Driver Version %d.%d", driverVersion / 1000,
-      (driverVersion % 1000) / 10);
 
   ret = NvrtcCreateProgram (&prog, source, NULL, 0, NULL, NULL);
   if (ret != NVRTC_SUCCESS) {
@@ -71,10 +62,6 @@ gst_cuda_nvrtc_compile (const gchar * source)
     return NULL;
   }
 
-  /* Starting from CUDA 11, the lowest supported architecture is 5.2 */
-  if (driverVersion >= 11000)
-    opts[0] = "--gpu-architecture=compute_52";
-
   ret = NvrtcCompileProgram (prog, 1, opts);
   if (ret != NVRTC_SUCCESS) {
     gsize log_size;
@@ -118,3 +105,159 @@ error:
 
   return NULL;
 }
+
+/* Directory of the on-disk PTX cache, or %NULL if disabled.
+ * GST_CUDA_KERNEL_CACHE_DIR overrides the default location, and setting it
+ * to an empty string disables the on-disk cache */
+static const gchar *
+gst_cuda_nvrtc_get_cache_dir (void)
+{
+  static gchar *cache_dir = NULL;
+  static volatile gsize once_init = 0;
+
+  if (g_once_init_enter (&once_init)) {
+    const gchar *env = g_getenv ("GST_CUDA_KERNEL_CACHE_DIR");
+
+    if (env) {
+      if (*env)
+        cache_dir = g_strdup (env);
+    } else {
+      cache_dir = g_build_filename (g_get_user_cache_dir (),
+          "gstreamer-" GST_API_VERSION, "cuda-kernels", NULL);
+    }
+
+    if (cache_dir && g_mkdir_with_parents (cache_dir, 0700) != 0) {
+      GST_WARNING ("Couldn't create kernel cache directory %s", cache_dir);
+      g_clear_pointer (&cache_dir, g_free);
+    }
+
+    GST_DEBUG ("Using kernel cache directory %s", GST_STR_NULL (cache_dir));
+    g_once_init_leave (&once_init, 1);
+  }
+
+  return cache_dir;
+}
+
+static gchar *
+gst_cuda_nvrtc_load_cached_ptx (const gchar * path)
+{
+  gchar *ptx = NULL;
+  gsize len = 0;
+
+  if (!g_file_get_contents (path, &ptx, &len, NULL))
+    return NULL;
+
+  /* Written by ourselves, but don't hand truncated or foreign files
+   * to the driver */
+  if (len == 0 || strlen (ptx) != len || !strstr (ptx, ".target")) {
+    GST_WARNING ("Ignoring invalid cached PTX %s", path);
+    g_free (ptx);
+    g_unlink (path);
+    return NULL;
+  }
+
+  return ptx;
+}
+
+/**
+ * gst_cuda_nvrtc_compile:
+ * @source: CUDA kernel source
+ *
+ * Compiles @source to PTX. The result is cached in memory for the lifetime of
+ * the process and on disk, keyed by @source, the target architecture and
+ * the CUDA driver version, so identical kernels are compiled only once.
+ *
+ * Returns: (transfer full) (nullable): PTX string to be freed with g_free(),
+ * or %NULL on failure
+ */
+gchar *
+gst_cuda_nvrtc_compile (const gchar * source)
+{
+  CUresult curet;
+  const gchar *arch_opt = "--gpu-architecture=compute_30";
+  gchar *ptx = NULL;
+  gchar *key_data;
+  gchar *key;
+  gchar *path = NULL;
+  const gchar *cache_dir;
+  int driverVersion;
+
+  g_return_val_if_fail (source != NULL, FALSE);
+
+  _init_debug ();
+
+  GST_TRACE ("CUDA kernel source \n%s", source);
+
+  curet = CuDriverGetVersion (&driverVersion);
+  if (curet != CUDA_SUCCESS) {
+    GST_ERROR ("Failed to query CUDA Driver version, ret %d", curet);
+    return NULL;
+  }
+
+  GST_DEBUG ("CUDA Driver Version %d.%d", driverVersion / 1000,
+      (driverVersion % 1000) / 10);
+
+  /* Starting from CUDA 11, the lowest supported architecture is 5.2 */
+  if (driverVersion >= 11000)
+    arch_opt = "--gpu-architecture=compute_52";
+
+  key_data = g_strdup_printf ("%d\n%s\n%s", driverVersion, arch_opt, source);
+  key = g_compute_checksum_for_string (G_CHECKSUM_SHA256, key_data, -1);
+  g_free (key_data);
+
+  G_LOCK (ptx_cache_lock);
+  if (ptx_cache)
+    ptx = g_strdup (g_hash_table_lookup (ptx_cache, key));
+  G_UNLOCK (ptx_cache_lock);
+
+  if (ptx) {
+    GST_DEBUG ("Found kernel %s in memory cache", key);
+    g_free (key);
+    return ptx;
+  }
+
+  cache_dir = gst_cuda_nvrtc_get_cache_dir ();
+  if (cache_dir) {
+    gchar *filename = g_strconcat (key, ".ptx", NULL);
+
+    path = g_build_filename (cache_dir, filename, NULL);
+    g_free (filename);
+
+    ptx = gst_cuda_nvrtc_load_cached_ptx (path);
+    if (ptx)
+      GST_DEBUG ("Loaded kernel from %s", path);
+  }
+
+  if (!ptx) {
+    ptx = gst_cuda_nvrtc_compile_program (source, arch_opt);
+    if (!ptx) {
+      g_free (path);
+      g_free (key);
+      return NULL;
+    }
+
+    if (path) {
+      GError *err = NULL;
+
+      /* g_file_set_contents() writes to a temporary file and renames it,
+       * so concurrent processes never see partial files */
+      if (!g_file_set_contents (path, ptx, -1, &err)) {
+        GST_WARNING ("Couldn't store kernel to %s: %s", path, err->message);
+        g_clear_error (&err);
+      }
+    }
+  }
+
+  g_free (path);
+
+  G_LOCK (ptx_cache_lock);
+  if (!ptx_cache) {
+    ptx_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+        g_free, g_free);
+  }
+  /* takes ownership of key */
+  g_hash_table_replace (ptx_cache, key, g_strdup (ptx));
+  G_UNLOCK (ptx_cache_lock);
+
+  return ptx;
+}
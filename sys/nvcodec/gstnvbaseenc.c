@@ -171,6 +171,7 @@ enum
   PROP_QP_CONST_I,
   PROP_QP_CONST_P,
   PROP_QP_CONST_B,
+  PROP_EXTRA_BUFFERS,
 };
 
 #define DEFAULT_PRESET GST_NV_PRESET_DEFAULT
@@ -189,6 +190,7 @@ enum
 #define DEFAULT_CONST_QUALITY 0
 #define DEFAULT_I_ADAPT FALSE
 #define DEFAULT_QP_DETAIL -1
+#define DEFAULT_EXTRA_BUFFERS 0
 
 /* This lock is needed to prevent the situation where multiple encoders are
  * initialised at the same time which appears to cause excessive CPU usage over
@@ -214,6 +216,9 @@ typedef struct
   /* whether nv_mapped_resource was mapped via NvEncMapInputResource()
    * and therefore should unmap via NvEncUnmapInputResource or not */
   gboolean mapped;
+
+  /* Upstream CUDA memory registered in place of cuda_pointer, if any */
+  GstMemory *mem;
 } GstNvEncInputResource;
 
 /* The pair of GstNvEncInputResource () and NV_ENC_OUTPUT_PTR.
@@ -222,8 +227,15 @@ typedef struct
 {
   GstNvEncInputResource *in_buf;
   NV_ENC_OUTPUT_PTR out_buf;
+
+  /* registered upstream memory encoded instead of in_buf, if any */
+  GstNvEncInputResource *direct_buf;
 } GstNvEncFrameState;
 
+/* upper bound of upstream memories registered at once, in case upstream
+ * doesn't use a pool */
+#define MAX_REGISTERED_MEMORIES 64
+
 static gboolean gst_nv_base_enc_open (GstVideoEncoder * enc);
 static gboolean gst_nv_base_enc_close (GstVideoEncoder * enc);
 static gboolean gst_nv_base_enc_start (GstVideoEncoder * enc);
@@ -445,6 +457,23 @@ gst_nv_base_enc_class_init (GstNvBaseEncClass * klass)
           G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
           G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstNvBaseEnc:extra-buffers:
+   *
+   * Number of input/output buffers allocated on top of the minimum
+   * required by the encoder configuration. More buffers let more
+   * frames be in flight, so that the NVENC engine is kept busy when
+   * many encoders share a GPU, at the cost of memory and latency.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_EXTRA_BUFFERS,
+      g_param_spec_uint ("extra-buffers", "Extra Buffers",
+          "Number of input/output buffers to allocate in addition to "
+          "the minimum required", 0, 32, DEFAULT_EXTRA_BUFFERS,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
   gst_type_mark_as_plugin_api (GST_TYPE_NV_BASE_ENC, 0);
   gst_type_mark_as_plugin_api (GST_TYPE_NV_PRESET, 0);
   gst_type_mark_as_plugin_api (GST_TYPE_NV_RC_MODE, 0);
@@ -462,7 +491,24 @@ gst_nv_base_enc_open_encode_session (GstNvBaseEnc * nvenc)
   params.deviceType = NV_ENC_DEVICE_TYPE_CUDA;
   nv_ret = NvEncOpenEncodeSessionEx (&params, &nvenc->encoder);
 
-  return nv_ret == NV_ENC_SUCCESS;
+  if (nv_ret != NV_ENC_SUCCESS)
+    return FALSE;
+
+  /* Let NVENC process the input on our own stream so that it's ordered
+   * after the uploads without a host side synchronization, and doesn't
+   * serialize with the other encoders on the default stream */
+  nvenc->io_streams_set = FALSE;
+  if (nvenc->cuda_stream) {
+    nv_ret = NvEncSetIOCudaStreams (nvenc->encoder,
+        (NV_ENC_CUSTREAM_PTR) & nvenc->cuda_stream,
+        (NV_ENC_CUSTREAM_PTR) & nvenc->cuda_stream);
+    if (nv_ret == NV_ENC_SUCCESS)
+      nvenc->io_streams_set = TRUE;
+    else
+      GST_DEBUG_OBJECT (nvenc, "Couldn't set IO cuda streams, ret %d", nv_ret);
+  }
+
+  return TRUE;
 }
 
 static gboolean
@@ -480,7 +526,9 @@ gst_nv_base_enc_open (GstVideoEncoder * enc)
   }
 
   if (gst_cuda_context_push (nvenc->cuda_ctx)) {
-    cuda_ret = CuStreamCreate (&nvenc->cuda_stream, CU_STREAM_DEFAULT);
+    /* a blocking stream would be serialized against any work submitted
+     * on the default stream, by other elements in the process too */
+    cuda_ret = CuStreamCreate (&nvenc->cuda_stream, CU_STREAM_NON_BLOCKING);
     if (!gst_cuda_result (cuda_ret)) {
       GST_WARNING_OBJECT (nvenc,
           "Could not create cuda stream, will use default stream");
@@ -721,6 +769,7 @@ gst_nv_base_enc_start (GstVideoEncoder * enc)
   nvenc->pending_queue = g_async_queue_new ();
   nvenc->bitstream_queue = g_async_queue_new ();
   nvenc->items = g_array_new (FALSE, TRUE, sizeof (GstNvEncFrameState));
+  nvenc->registered_memories = g_hash_table_new (NULL, NULL);
 
   nvenc->last_flow = GST_FLOW_OK;
   memset (&nvenc->init_params, 0, sizeof (NV_ENC_INITIALIZE_PARAMS));
@@ -787,6 +836,11 @@ gst_nv_base_enc_stop (GstVideoEncoder * enc)
     nvenc->items = NULL;
   }
 
+  if (nvenc->registered_memories) {
+    g_hash_table_unref (nvenc->registered_memories);
+    nvenc->registered_memories = NULL;
+  }
+
   return TRUE;
 }
 
@@ -1042,6 +1096,7 @@ gst_nv_base_enc_init (GstNvBaseEnc * nvenc)
   nvenc->strict_gop = DEFAULT_STRICT_GOP;
   nvenc->const_quality = DEFAULT_CONST_QUALITY;
   nvenc->i_adapt = DEFAULT_I_ADAPT;
+  nvenc->extra_buffers = DEFAULT_EXTRA_BUFFERS;
   nvenc->qp_min_detail = qp_detail;
   nvenc->qp_max_detail = qp_detail;
   nvenc->qp_const_detail = qp_detail;
@@ -1146,7 +1201,8 @@ gst_nv_base_enc_bitstream_thread (gpointer user_data)
       goto exit_thread;
 
     out_buf = state_in_queue->out_buf;
-    resource = state_in_queue->in_buf;
+    resource = state_in_queue->direct_buf ?
+        state_in_queue->direct_buf : state_in_queue->in_buf;
 
     GST_LOG_OBJECT (nvenc, "waiting for output buffer %p to be ready", out_buf);
 
@@ -1227,6 +1283,7 @@ gst_nv_base_enc_bitstream_thread (gpointer user_data)
 
     memset (&resource->nv_mapped_resource, 0,
         sizeof (resource->nv_mapped_resource));
+    state_in_queue->direct_buf = NULL;
 
     g_async_queue_push (nvenc->available_queue, state_in_queue);
 
@@ -1401,6 +1458,29 @@ gst_nv_base_enc_reset_queues (GstNvBaseEnc * nvenc)
   }
 }
 
+/* GHRFunc, must be called with the CUDA context pushed */
+static gboolean
+_unregister_memory (GstMemory * mem, GstNvEncInputResource * resource,
+    GstNvBaseEnc * nvenc)
+{
+  NVENCSTATUS nv_ret;
+
+  /* still used by the encoder */
+  if (resource->mapped)
+    return FALSE;
+
+  nv_ret = NvEncUnregisterResource (nvenc->encoder,
+      resource->nv_resource.registeredResource);
+  if (nv_ret != NV_ENC_SUCCESS)
+    GST_ERROR_OBJECT (nvenc, "Failed to unregister resource %p, ret %d",
+        resource, nv_ret);
+
+  gst_memory_unref (resource->mem);
+  g_free (resource);
+
+  return TRUE;
+}
+
 static void
 gst_nv_base_enc_free_buffers (GstNvBaseEnc * nvenc)
 {
@@ -1422,6 +1502,22 @@ gst_nv_base_enc_free_buffers (GstNvBaseEnc * nvenc)
         g_array_index (nvenc->items, GstNvEncFrameState, i).out_buf;
     GstNvEncInputResource *in_buf =
         g_array_index (nvenc->items, GstNvEncFrameState, i).in_buf;
+    GstNvEncInputResource *direct_buf =
+        g_array_index (nvenc->items, GstNvEncFrameState, i).direct_buf;
+
+    if (direct_buf && direct_buf->mapped) {
+      GST_LOG_OBJECT (nvenc, "Unmap resource %p", direct_buf);
+
+      nv_ret =
+          NvEncUnmapInputResource (nvenc->encoder,
+          direct_buf->nv_mapped_resource.mappedResource);
+
+      if (nv_ret != NV_ENC_SUCCESS) {
+        GST_ERROR_OBJECT (nvenc, "Failed to unmap input resource %p, ret %d",
+            direct_buf, nv_ret);
+      }
+      direct_buf->mapped = FALSE;
+    }
 
     if (in_buf->mapped) {
       GST_LOG_OBJECT (nvenc, "Unmap resource %p", in_buf);
@@ -1458,6 +1554,11 @@ gst_nv_base_enc_free_buffers (GstNvBaseEnc * nvenc)
           out_buf, nv_ret);
     }
   }
+
+  if (nvenc->registered_memories) {
+    g_hash_table_foreach_remove (nvenc->registered_memories,
+        (GHRFunc) _unregister_memory, nvenc);
+  }
   gst_cuda_context_pop (NULL);
   g_array_set_size (nvenc->items, 0);
 }
@@ -1615,9 +1716,13 @@ gst_nv_base_enc_calculate_num_prealloc_buffers (GstNvBaseEnc * enc,
    * "4 + 32 + 5" < "48" so it seems to sufficiently safe upper bound */
   num_buffers = MIN (num_buffers, 48);
 
+  /* + user requested in-flight buffers */
+  num_buffers += enc->extra_buffers;
+
   GST_DEBUG_OBJECT (enc, "Calculated num buffers: %d "
-      "(lookahead %d, frameIntervalP %d)",
-      num_buffers, config->rcParams.lookaheadDepth, config->frameIntervalP);
+      "(lookahead %d, frameIntervalP %d, extra %d)",
+      num_buffers, config->rcParams.lookaheadDepth, config->frameIntervalP,
+      enc->extra_buffers);
 
   return num_buffers;
 }
@@ -2223,6 +2328,81 @@ _map_gl_input_buffer (GstGLContext * context, GstNvEncGLMapData * data)
 }
 #endif
 
+/* Returns @mem, a CUDA memory of our context, registered to NVENC so that
+ * it can be encoded in place, or NULL if its layout is not the one NVENC
+ * expects */
+static GstNvEncInputResource *
+gst_nv_base_enc_get_registered_memory (GstNvBaseEnc * nvenc, GstMemory * mem)
+{
+  GstCudaMemory *cmem = GST_CUDA_MEMORY_CAST (mem);
+  GstVideoInfo *info = &nvenc->input_info;
+  GstVideoInfo *mem_info = &cmem->alloc_params.info;
+  GstNvEncInputResource *resource;
+  NVENCSTATUS nv_ret;
+  gsize offset = 0;
+  guint i;
+
+  resource = g_hash_table_lookup (nvenc->registered_memories, mem);
+  if (resource)
+    return resource;
+
+  if (gst_cuda_context_get_handle (cmem->context) !=
+      gst_cuda_context_get_handle (nvenc->cuda_ctx))
+    return NULL;
+
+  if (GST_VIDEO_INFO_FORMAT (mem_info) != GST_VIDEO_INFO_FORMAT (info) ||
+      GST_VIDEO_INFO_WIDTH (mem_info) < GST_VIDEO_INFO_WIDTH (info) ||
+      GST_VIDEO_INFO_HEIGHT (mem_info) < GST_VIDEO_INFO_HEIGHT (info))
+    return NULL;
+
+  /* NVENC takes a single pitch and expects the planes to be contiguous */
+  for (i = 0; i < GST_VIDEO_INFO_N_PLANES (info); i++) {
+    if (_get_cuda_device_stride (info, i, cmem->stride) != cmem->stride ||
+        cmem->offset[i] != offset)
+      return NULL;
+
+    offset += cmem->stride * _get_plane_height (info, i);
+  }
+
+  if (!gst_cuda_context_push (nvenc->cuda_ctx))
+    return NULL;
+
+  if (g_hash_table_size (nvenc->registered_memories) >=
+      MAX_REGISTERED_MEMORIES) {
+    GST_DEBUG_OBJECT (nvenc, "Too many registered memories, releasing them");
+    g_hash_table_foreach_remove (nvenc->registered_memories,
+        (GHRFunc) _unregister_memory, nvenc);
+  }
+
+  resource = g_new0 (GstNvEncInputResource, 1);
+
+  resource->nv_resource.version = gst_nvenc_get_registure_resource_version ();
+  resource->nv_resource.resourceType = NV_ENC_INPUT_RESOURCE_TYPE_CUDADEVICEPTR;
+  resource->nv_resource.width = GST_VIDEO_INFO_WIDTH (info);
+  resource->nv_resource.height = GST_VIDEO_INFO_HEIGHT (info);
+  resource->nv_resource.pitch = cmem->stride;
+  resource->nv_resource.bufferFormat =
+      gst_nvenc_get_nv_buffer_format (GST_VIDEO_INFO_FORMAT (info));
+  resource->nv_resource.resourceToRegister = (gpointer) cmem->data;
+
+  nv_ret = NvEncRegisterResource (nvenc->encoder, &resource->nv_resource);
+  gst_cuda_context_pop (NULL);
+
+  if (nv_ret != NV_ENC_SUCCESS) {
+    GST_WARNING_OBJECT (nvenc, "Failed to register memory %p, ret %d",
+        mem, nv_ret);
+    g_free (resource);
+    return NULL;
+  }
+
+  resource->mem = gst_memory_ref (mem);
+  g_hash_table_insert (nvenc->registered_memories, mem, resource);
+
+  GST_LOG_OBJECT (nvenc, "Registered memory %p as resource %p", mem, resource);
+
+  return resource;
+}
+
 static gboolean
 gst_nv_base_enc_upload_frame (GstNvBaseEnc * nvenc, GstVideoFrame * frame,
     GstNvEncInputResource * resource, gboolean use_device_memory)
@@ -2274,7 +2454,9 @@ gst_nv_base_enc_upload_frame (GstNvBaseEnc * nvenc, GstVideoFrame * frame,
     dst += dest_stride * _get_plane_height (&nvenc->input_info, i);
   }
 
-  gst_cuda_result (CuStreamSynchronize (nvenc->cuda_stream));
+  /* otherwise NVENC waits for the copy on the GPU side */
+  if (!nvenc->io_streams_set)
+    gst_cuda_result (CuStreamSynchronize (nvenc->cuda_stream));
   gst_cuda_context_pop (NULL);
 
   return TRUE;
@@ -2479,6 +2661,20 @@ gst_nv_base_enc_handle_frame (GstVideoEncoder * enc, GstVideoCodecFrame * frame)
     goto unmap_and_drop;
 
   resource = state->in_buf;
+  state->direct_buf = NULL;
+
+  if (use_device_memory && gst_buffer_n_memory (frame->input_buffer) == 1) {
+    GstNvEncInputResource *direct_buf;
+
+    direct_buf = gst_nv_base_enc_get_registered_memory (nvenc,
+        gst_buffer_peek_memory (frame->input_buffer, 0));
+
+    /* the same memory might be still encoded for a previous frame */
+    if (direct_buf && !direct_buf->mapped) {
+      state->direct_buf = direct_buf;
+      resource = direct_buf;
+    }
+  }
 
 #if HAVE_NVCODEC_GST_GL
   if (nvenc->mem_type == GST_NVENC_MEM_TYPE_GL) {
@@ -2501,7 +2697,9 @@ gst_nv_base_enc_handle_frame (GstVideoEncoder * enc, GstVideoCodecFrame * frame)
     }
   } else
 #endif
-  if (!gst_nv_base_enc_upload_frame (nvenc,
+  if (state->direct_buf) {
+    GST_TRACE_OBJECT (nvenc, "Encoding input memory without copy");
+  } else if (!gst_nv_base_enc_upload_frame (nvenc,
           &vframe, resource, use_device_memory)) {
     flow = GST_FLOW_ERROR;
     goto unmap_and_drop;
@@ -2555,6 +2753,11 @@ gst_nv_base_enc_handle_frame (GstVideoEncoder * enc, GstVideoCodecFrame * frame)
 /* ERRORS */
 unmap_and_drop:
   {
+    /* the input frame might still be read by a pending upload */
+    if (nvenc->io_streams_set && gst_cuda_context_push (nvenc->cuda_ctx)) {
+      gst_cuda_result (CuStreamSynchronize (nvenc->cuda_stream));
+      gst_cuda_context_pop (NULL);
+    }
     gst_video_frame_unmap (&vframe);
     goto drop;
   }
@@ -2734,6 +2937,11 @@ gst_nv_base_enc_set_property (GObject * object, guint prop_id,
     case PROP_QP_CONST_B:
       nvenc->qp_const_detail.qp_b = g_value_get_int (value);
       break;
+    case PROP_EXTRA_BUFFERS:
+      /* only used when the buffers are allocated */
+      nvenc->extra_buffers = g_value_get_uint (value);
+      reconfig = FALSE;
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       reconfig = FALSE;
@@ -2827,6 +3035,9 @@ gst_nv_base_enc_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_QP_CONST_B:
       g_value_set_int (value, nvenc->qp_const_detail.qp_b);
       break;
+    case PROP_EXTRA_BUFFERS:
+      g_value_set_uint (value, nvenc->extra_buffers);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
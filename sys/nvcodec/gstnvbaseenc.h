@@ -109,8 +109,12 @@ typedef struct {
   gdouble         const_quality;
   gboolean        i_adapt;
 
+  guint           extra_buffers;
+
   GstCudaContext * cuda_ctx;
   CUstream         cuda_stream;
+  /* TRUE if NVENC reads its input on cuda_stream */
+  gboolean         io_streams_set;
   void          * encoder;
   NV_ENC_INITIALIZE_PARAMS init_params;
   NV_ENC_CONFIG            config;
@@ -126,6 +130,10 @@ typedef struct {
    * and hold the ownership of the GstNvEncFrameState. */
   GArray            *items;
 
+  /* (GstMemory -> GstNvEncInputResource) upstream CUDA memory registered
+   * to NVENC directly, and hold a reference of the memory */
+  GHashTable        *registered_memories;
+
   /* (GstNvEncFrameState) available empty items which could be submitted
    * to encoder */
   GAsyncQueue       *available_queue;
@@ -261,6 +261,17 @@ NvEncEncodePicture (void *encoder, NV_ENC_PIC_PARAMS * pic_params)
   return nvenc_api.nvEncEncodePicture (encoder, pic_params);
 }
 
+/* Only available since SDK 9.0 */
+NVENCSTATUS NVENCAPI
+NvEncSetIOCudaStreams (void *encoder, NV_ENC_CUSTREAM_PTR input_stream,
+    NV_ENC_CUSTREAM_PTR output_stream)
+{
+  if (nvenc_api.nvEncSetIOCudaStreams == NULL)
+    return NV_ENC_ERR_UNIMPLEMENTED;
+  return nvenc_api.nvEncSetIOCudaStreams (encoder, input_stream,
+      output_stream);
+}
+
 gboolean
 gst_nvenc_cmp_guid (GUID g1, GUID g2)
 {
@@ -791,17 +802,22 @@ gst_nv_enc_register (GstPlugin * plugin, GUID codec_id, const gchar * codec,
     }
 
     {
-      GstCaps *cuda_caps = gst_caps_copy (sink_templ);
+      /* CUDA memory goes first since it can be encoded without any copy */
+      GstCaps *sysmem_caps = sink_templ;
+#if HAVE_NVCODEC_GST_GL
+      GstCaps *gl_caps = gst_caps_copy (sysmem_caps);
+#endif
+
+      sink_templ = gst_caps_copy (sysmem_caps);
+      gst_caps_set_features_simple (sink_templ,
+          gst_caps_features_from_string (GST_CAPS_FEATURE_MEMORY_CUDA_MEMORY));
+
 #if HAVE_NVCODEC_GST_GL
-      GstCaps *gl_caps = gst_caps_copy (sink_templ);
       gst_caps_set_features_simple (gl_caps,
           gst_caps_features_from_string (GST_CAPS_FEATURE_MEMORY_GL_MEMORY));
       gst_caps_append (sink_templ, gl_caps);
 #endif
-
-      gst_caps_set_features_simple (cuda_caps,
-          gst_caps_features_from_string (GST_CAPS_FEATURE_MEMORY_CUDA_MEMORY));
-      gst_caps_append (sink_templ, cuda_caps);
+      gst_caps_append (sink_templ, sysmem_caps);
     }
 
     name = g_strdup_printf ("video/x-%s", codec);
@@ -78,6 +78,8 @@
 #include "gstcudautils.h"
 #include "gstnvdecoder.h"
 
+#include <gst/codecs/gstcodecslicebuffer.h>
+
 #include <string.h>
 
 GST_DEBUG_CATEGORY_STATIC (gst_nv_h264_dec_debug);
@@ -97,16 +99,8 @@ struct _GstNvH264Dec
   GstNvDecoder *decoder;
   CUVIDPICPARAMS params;
 
-  /* slice buffer which will be passed to CUVIDPICPARAMS::pBitstreamData */
-  guint8 *bitstream_buffer;
-  /* allocated memory size of bitstream_buffer */
-  gsize bitstream_buffer_alloc_size;
-  /* current offset of bitstream_buffer (per frame) */
-  gsize bitstream_buffer_offset;
-
-  guint *slice_offsets;
-  guint slice_offsets_alloc_len;
-  guint num_slices;
+  /* slices which will be passed to CUVIDPICPARAMS::pBitstreamData */
+  GstCodecSliceBuffer *slice_buffer;
 
   guint width, height;
   guint coded_width, coded_height;
@@ -210,6 +204,7 @@ gst_nv_h264_dec_class_init (GstNvH264DecClass * klass)
 static void
 gst_nv_h264_dec_init (GstNvH264Dec * self)
 {
+  self->slice_buffer = gst_codec_slice_buffer_new ();
 }
 
 static void
@@ -217,8 +212,7 @@ gst_nv_h264_decoder_finalize (GObject * object)
 {
   GstNvH264Dec *self = GST_NV_H264_DEC (object);
 
-  g_free (self->bitstream_buffer);
-  g_free (self->slice_offsets);
+  gst_codec_slice_buffer_free (self->slice_buffer);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -619,8 +613,7 @@ gst_nv_h264_dec_picture_params_from_pps (GstNvH264Dec * self,
 static void
 gst_nv_h264_dec_reset_bitstream_params (GstNvH264Dec * self)
 {
-  self->bitstream_buffer_offset = 0;
-  self->num_slices = 0;
+  gst_codec_slice_buffer_reset (self->slice_buffer);
 
   self->params.nBitstreamDataLen = 0;
   self->params.pBitstreamData = NULL;
@@ -751,33 +744,13 @@ gst_nv_h264_dec_decode_slice (GstH264Decoder * decoder,
     GArray * ref_pic_list1)
 {
   GstNvH264Dec *self = GST_NV_H264_DEC (decoder);
-  gsize new_size;
+  guint offset;
 
   GST_LOG_OBJECT (self, "Decode slice, nalu size %u", slice->nalu.size);
 
-  if (self->slice_offsets_alloc_len < self->num_slices + 1) {
-    self->slice_offsets = (guint *) g_realloc_n (self->slice_offsets,
-        self->num_slices + 1, sizeof (guint));
-  }
-  self->slice_offsets[self->num_slices] = self->bitstream_buffer_offset;
-  GST_LOG_OBJECT (self, "Slice offset %u for slice %d",
-      self->slice_offsets[self->num_slices], self->num_slices);
-
-  self->num_slices++;
-
-  new_size = self->bitstream_buffer_offset + slice->nalu.size + 3;
-  if (self->bitstream_buffer_alloc_size < new_size) {
-    self->bitstream_buffer =
-        (guint8 *) g_realloc (self->bitstream_buffer, new_size);
-  }
-
-  self->bitstream_buffer[self->bitstream_buffer_offset] = 0;
-  self->bitstream_buffer[self->bitstream_buffer_offset + 1] = 0;
-  self->bitstream_buffer[self->bitstream_buffer_offset + 2] = 1;
-
-  memcpy (self->bitstream_buffer + self->bitstream_buffer_offset + 3,
-      slice->nalu.data + slice->nalu.offset, slice->nalu.size);
-  self->bitstream_buffer_offset = new_size;
+  offset = gst_codec_slice_buffer_add_slice (self->slice_buffer,
+      slice->nalu.data + slice->nalu.offset, slice->nalu.size, TRUE);
+  GST_LOG_OBJECT (self, "Slice offset %u", offset);
 
   if (!GST_H264_IS_I_SLICE (&slice->header) &&
       !GST_H264_IS_SI_SLICE (&slice->header))
@@ -792,14 +765,18 @@ gst_nv_h264_dec_end_picture (GstH264Decoder * decoder, GstH264Picture * picture)
   GstNvH264Dec *self = GST_NV_H264_DEC (decoder);
   gboolean ret;
   CUVIDPICPARAMS *params = &self->params;
+  gsize size;
+  guint num_slices;
 
-  params->nBitstreamDataLen = self->bitstream_buffer_offset;
-  params->pBitstreamData = self->bitstream_buffer;
-  params->nNumSlices = self->num_slices;
-  params->pSliceDataOffsets = self->slice_offsets;
+  params->pBitstreamData =
+      gst_codec_slice_buffer_get_data (self->slice_buffer, &size);
+  params->nBitstreamDataLen = size;
+  params->pSliceDataOffsets =
+      gst_codec_slice_buffer_get_offsets (self->slice_buffer, &num_slices);
+  params->nNumSlices = num_slices;
 
   GST_LOG_OBJECT (self, "End picture, bitstream len: %" G_GSIZE_FORMAT
-      ", num slices %d", self->bitstream_buffer_offset, self->num_slices);
+      ", num slices %d", size, num_slices);
 
   ret = gst_nv_decoder_decode_picture (self->decoder, &self->params);
 
@@ -78,6 +78,8 @@
 #include "gstcudautils.h"
 #include "gstnvdecoder.h"
 
+#include <gst/codecs/gstcodecslicebuffer.h>
+
 #include <string.h>
 
 GST_DEBUG_CATEGORY_STATIC (gst_nv_h265_dec_debug);
@@ -97,16 +99,8 @@ struct _GstNvH265Dec
   GstNvDecoder *decoder;
   CUVIDPICPARAMS params;
 
-  /* slice buffer which will be passed to CUVIDPICPARAMS::pBitstreamData */
-  guint8 *bitstream_buffer;
-  /* allocated memory size of bitstream_buffer */
-  gsize bitstream_buffer_alloc_size;
-  /* current offset of bitstream_buffer (per frame) */
-  gsize bitstream_buffer_offset;
-
-  guint *slice_offsets;
-  guint slice_offsets_alloc_len;
-  guint num_slices;
+  /* slices which will be passed to CUVIDPICPARAMS::pBitstreamData */
+  GstCodecSliceBuffer *slice_buffer;
 
   guint width, height;
   guint coded_width, coded_height;
@@ -156,6 +150,9 @@ static gboolean gst_nv_h265_dec_decode_slice (GstH265Decoder * decoder,
     GArray * ref_pic_list0, GArray * ref_pic_list1);
 static gboolean gst_nv_h265_dec_end_picture (GstH265Decoder * decoder,
     GstH265Picture * picture);
+static guint
+gst_nv_h265_dec_get_preferred_output_delay (GstH265Decoder * decoder,
+    gboolean live);
 
 static void
 gst_nv_h265_dec_class_init (GstNvH265DecClass * klass)
@@ -194,6 +191,8 @@ gst_nv_h265_dec_class_init (GstNvH265DecClass * klass)
       GST_DEBUG_FUNCPTR (gst_nv_h265_dec_decode_slice);
   h265decoder_class->end_picture =
       GST_DEBUG_FUNCPTR (gst_nv_h265_dec_end_picture);
+  h265decoder_class->get_preferred_output_delay =
+      GST_DEBUG_FUNCPTR (gst_nv_h265_dec_get_preferred_output_delay);
 
   GST_DEBUG_CATEGORY_INIT (gst_nv_h265_dec_debug,
       "nvh265dec", 0, "Nvidia H.265 Decoder");
@@ -204,6 +203,7 @@ gst_nv_h265_dec_class_init (GstNvH265DecClass * klass)
 static void
 gst_nv_h265_dec_init (GstNvH265Dec * self)
 {
+  self->slice_buffer = gst_codec_slice_buffer_new ();
 }
 
 static void
@@ -211,8 +211,7 @@ gst_nv_h265_decoder_finalize (GObject * object)
 {
   GstNvH265Dec *self = GST_NV_H265_DEC (object);
 
-  g_free (self->bitstream_buffer);
-  g_free (self->slice_offsets);
+  gst_codec_slice_buffer_free (self->slice_buffer);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -666,8 +665,7 @@ gst_nv_h265_dec_picture_params_from_pps (GstNvH265Dec * self,
 static void
 gst_nv_h265_dec_reset_bitstream_params (GstNvH265Dec * self)
 {
-  self->bitstream_buffer_offset = 0;
-  self->num_slices = 0;
+  gst_codec_slice_buffer_reset (self->slice_buffer);
 
   self->params.nBitstreamDataLen = 0;
   self->params.pBitstreamData = NULL;
@@ -903,33 +901,13 @@ gst_nv_h265_dec_decode_slice (GstH265Decoder * decoder,
     GArray * ref_pic_list0, GArray * ref_pic_list1)
 {
   GstNvH265Dec *self = GST_NV_H265_DEC (decoder);
-  gsize new_size;
+  guint offset;
 
   GST_LOG_OBJECT (self, "Decode slice, nalu size %u", slice->nalu.size);
 
-  if (self->slice_offsets_alloc_len < self->num_slices + 1) {
-    self->slice_offsets = (guint *) g_realloc_n (self->slice_offsets,
-        self->num_slices + 1, sizeof (guint));
-  }
-  self->slice_offsets[self->num_slices] = self->bitstream_buffer_offset;
-  GST_LOG_OBJECT (self, "Slice offset %u for slice %d",
-      self->slice_offsets[self->num_slices], self->num_slices);
-
-  self->num_slices++;
-
-  new_size = self->bitstream_buffer_offset + slice->nalu.size + 3;
-  if (self->bitstream_buffer_alloc_size < new_size) {
-    self->bitstream_buffer =
-        (guint8 *) g_realloc (self->bitstream_buffer, new_size);
-  }
-
-  self->bitstream_buffer[self->bitstream_buffer_offset] = 0;
-  self->bitstream_buffer[self->bitstream_buffer_offset + 1] = 0;
-  self->bitstream_buffer[self->bitstream_buffer_offset + 2] = 1;
-
-  memcpy (self->bitstream_buffer + self->bitstream_buffer_offset + 3,
-      slice->nalu.data + slice->nalu.offset, slice->nalu.size);
-  self->bitstream_buffer_offset = new_size;
+  offset = gst_codec_slice_buffer_add_slice (self->slice_buffer,
+      slice->nalu.data + slice->nalu.offset, slice->nalu.size, TRUE);
+  GST_LOG_OBJECT (self, "Slice offset %u", offset);
 
   return TRUE;
 }
@@ -940,14 +918,18 @@ gst_nv_h265_dec_end_picture (GstH265Decoder * decoder, GstH265Picture * picture)
   GstNvH265Dec *self = GST_NV_H265_DEC (decoder);
   gboolean ret;
   CUVIDPICPARAMS *params = &self->params;
+  gsize size;
+  guint num_slices;
 
-  params->nBitstreamDataLen = self->bitstream_buffer_offset;
-  params->pBitstreamData = self->bitstream_buffer;
-  params->nNumSlices = self->num_slices;
-  params->pSliceDataOffsets = self->slice_offsets;
+  params->pBitstreamData =
+      gst_codec_slice_buffer_get_data (self->slice_buffer, &size);
+  params->nBitstreamDataLen = size;
+  params->pSliceDataOffsets =
+      gst_codec_slice_buffer_get_offsets (self->slice_buffer, &num_slices);
+  params->nNumSlices = num_slices;
 
   GST_LOG_OBJECT (self, "End picture, bitstream len: %" G_GSIZE_FORMAT
-      ", num slices %d", self->bitstream_buffer_offset, self->num_slices);
+      ", num slices %d", size, num_slices);
 
   ret = gst_nv_decoder_decode_picture (self->decoder, &self->params);
 
@@ -957,6 +939,18 @@ gst_nv_h265_dec_end_picture (GstH265Decoder * decoder, GstH265Picture * picture)
   return ret;
 }
 
+static guint
+gst_nv_h265_dec_get_preferred_output_delay (GstH265Decoder * decoder,
+    gboolean live)
+{
+  /* Prefer to zero latency for live pipeline */
+  if (live)
+    return 0;
+
+  /* NVCODEC SDK uses 4 frame delay for better throughput performance */
+  return 4;
+}
+
 typedef struct
 {
   GstCaps *sink_caps;
@@ -33,6 +33,9 @@ GST_DEBUG_CATEGORY_STATIC (gst_nv_vp9_dec_debug);
 /* reference list 8 + 2 margin */
 #define NUM_OUTPUT_VIEW 10
 
+/* NVCODEC SDK uses 4 frame delay for better throughput performance */
+#define PREFERRED_OUTPUT_DELAY 4
+
 struct _GstNvVp9Dec
 {
   GstVp9Decoder parent;
@@ -93,6 +96,8 @@ static gboolean gst_nv_vp9_dec_decode_picture (GstVp9Decoder * decoder,
     GstVp9Picture * picture, GstVp9Dpb * dpb);
 static GstFlowReturn gst_nv_vp9_dec_output_picture (GstVp9Decoder *
     decoder, GstVideoCodecFrame * frame, GstVp9Picture * picture);
+static guint gst_nv_vp9_dec_get_preferred_output_delay (GstVp9Decoder *
+    decoder, gboolean live);
 
 static void
 gst_nv_vp9_dec_class_init (GstNvVp9DecClass * klass)
@@ -120,6 +125,8 @@ gst_nv_vp9_dec_class_init (GstNvVp9DecClass * klass)
       GST_DEBUG_FUNCPTR (gst_nv_vp9_dec_decode_picture);
   vp9decoder_class->output_picture =
       GST_DEBUG_FUNCPTR (gst_nv_vp9_dec_output_picture);
+  vp9decoder_class->get_preferred_output_delay =
+      GST_DEBUG_FUNCPTR (gst_nv_vp9_dec_get_preferred_output_delay);
 
   GST_DEBUG_CATEGORY_INIT (gst_nv_vp9_dec_debug,
       "nvvp9dec", 0, "NVIDIA VP9 Decoder");
@@ -291,7 +298,7 @@ gst_nv_vp9_dec_new_sequence (GstVp9Decoder * decoder,
         self->out_format, self->width, self->height);
 
     self->decoder = gst_nv_decoder_new (self->context, cudaVideoCodec_VP9,
-        &info, NUM_OUTPUT_VIEW);
+        &info, NUM_OUTPUT_VIEW + PREFERRED_OUTPUT_DELAY);
 
     if (!self->decoder) {
       GST_ERROR_OBJECT (self, "Failed to create decoder");
@@ -570,6 +577,17 @@ error:
   return GST_FLOW_ERROR;
 }
 
+static guint
+gst_nv_vp9_dec_get_preferred_output_delay (GstVp9Decoder * decoder,
+    gboolean live)
+{
+  /* Prefer to zero latency for live pipeline */
+  if (live)
+    return 0;
+
+  return PREFERRED_OUTPUT_DELAY;
+}
+
 typedef struct
 {
   GstCaps *sink_caps;
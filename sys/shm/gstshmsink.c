@@ -39,6 +39,7 @@
 #include "gstshmsink.h"
 
 #include <gst/gst.h>
+#include <gst/allocators/allocators.h>
 
 #include <string.h>
 
@@ -58,7 +59,9 @@ enum
   PROP_PERMS,
   PROP_SHM_SIZE,
   PROP_WAIT_FOR_CONNECTION,
-  PROP_BUFFER_TIME
+  PROP_BUFFER_TIME,
+  PROP_USE_RING,
+  PROP_PASS_FDS
 };
 
 struct GstShmClient
@@ -69,6 +72,8 @@ struct GstShmClient
 
 #define DEFAULT_SIZE ( 64 * 1024 * 1024 )
 #define DEFAULT_WAIT_FOR_CONNECTION (TRUE)
+#define DEFAULT_USE_RING (FALSE)
+#define DEFAULT_PASS_FDS (FALSE)
 /* Default is user read/write, group read */
 #define DEFAULT_PERMS ( S_IRUSR | S_IWUSR | S_IRGRP )
 
@@ -355,6 +360,8 @@ gst_shm_sink_init (GstShmSink * self)
   self->unlock = FALSE;
   self->wait_for_connection = DEFAULT_WAIT_FOR_CONNECTION;
   self->perms = DEFAULT_PERMS;
+  self->use_ring = DEFAULT_USE_RING;
+  self->pass_fds = DEFAULT_PASS_FDS;
 
   gst_allocation_params_init (&self->params);
 }
@@ -417,6 +424,39 @@ gst_shm_sink_class_init (GstShmSinkClass * klass)
           -1, G_MAXINT64, -1,
           G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstShmSink:use-ring:
+   *
+   * Offer new clients a ring in shared memory to pass the buffers and
+   * their releases instead of one message on the control socket per
+   * buffer. Clients that don't support it keep using the socket. A
+   * client that falls more than 1024 buffers behind misses buffers.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_USE_RING,
+      g_param_spec_boolean ("use-ring",
+          "Use a ring buffer",
+          "Pass buffers to the clients through a shared memory ring",
+          DEFAULT_USE_RING, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstShmSink:pass-fds:
+   *
+   * Pass buffers backed by a single DMABuf or other fd memory, like
+   * memfds, to the clients over the control socket instead of copying
+   * them in the shared memory area. The clients keep the fds of the
+   * last few memories around so each one is only passed once. This is
+   * only done while all the connected clients support it.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_PASS_FDS,
+      g_param_spec_boolean ("pass-fds",
+          "Pass fds",
+          "Pass fd backed memory to the clients instead of copying it",
+          DEFAULT_PASS_FDS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   signals[SIGNAL_CLIENT_CONNECTED] = g_signal_new ("client-connected",
       GST_TYPE_SHM_SINK, G_SIGNAL_RUN_LAST, 0, NULL, NULL, NULL,
       G_TYPE_NONE, 1, G_TYPE_INT);
@@ -505,6 +545,20 @@ gst_shm_sink_set_property (GObject * object, guint prop_id,
       GST_OBJECT_UNLOCK (object);
       g_cond_broadcast (&self->cond);
       break;
+    case PROP_USE_RING:
+      GST_OBJECT_LOCK (object);
+      self->use_ring = g_value_get_boolean (value);
+      if (self->pipe)
+        sp_writer_enable_ring (self->pipe, self->use_ring);
+      GST_OBJECT_UNLOCK (object);
+      break;
+    case PROP_PASS_FDS:
+      GST_OBJECT_LOCK (object);
+      self->pass_fds = g_value_get_boolean (value);
+      if (self->pipe)
+        sp_writer_enable_fds (self->pipe, self->pass_fds);
+      GST_OBJECT_UNLOCK (object);
+      break;
     default:
       break;
   }
@@ -534,6 +588,12 @@ gst_shm_sink_get_property (GObject * object, guint prop_id,
     case PROP_BUFFER_TIME:
       g_value_set_int64 (value, self->buffer_time);
       break;
+    case PROP_USE_RING:
+      g_value_set_boolean (value, self->use_ring);
+      break;
+    case PROP_PASS_FDS:
+      g_value_set_boolean (value, self->pass_fds);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -570,6 +630,8 @@ gst_shm_sink_start (GstBaseSink * bsink)
   }
 
   sp_set_data (self->pipe, self);
+  sp_writer_enable_ring (self->pipe, self->use_ring);
+  sp_writer_enable_fds (self->pipe, self->pass_fds);
   g_free (self->socket_path);
   self->socket_path = g_strdup (sp_writer_get_path (self->pipe));
 
@@ -640,6 +702,37 @@ gst_shm_sink_stop (GstBaseSink * bsink)
   return TRUE;
 }
 
+static void
+free_buffer_locked (GstBuffer * buffer, void *data)
+{
+  GSList **list = data;
+
+  g_assert (buffer != NULL);
+
+  *list = g_slist_prepend (*list, buffer);
+}
+
+/* Called with the object lock, which is released while the buffers the
+ * ring clients are done with are unreffed, as freeing their memory
+ * takes it. Returns TRUE if anything was released. */
+static gboolean
+gst_shm_sink_reap_ring_locked (GstShmSink * self, gboolean want_wakeup)
+{
+  GSList *list = NULL;
+
+  if (!sp_writer_reap_ring (self->pipe, want_wakeup,
+          (sp_buffer_free_callback) free_buffer_locked, (void **) &list))
+    return FALSE;
+
+  GST_OBJECT_UNLOCK (self);
+  GST_LOG_OBJECT (self, "Released %u buffers from the rings",
+      g_slist_length (list));
+  g_slist_free_full (list, (GDestroyNotify) gst_buffer_unref);
+  GST_OBJECT_LOCK (self);
+
+  return TRUE;
+}
+
 static gboolean
 gst_shm_sink_can_render (GstShmSink * self, GstClockTime time)
 {
@@ -671,6 +764,7 @@ gst_shm_sink_render (GstBaseSink * bsink, GstBuffer * buf)
   gsize written_bytes;
 
   GST_OBJECT_LOCK (self);
+  gst_shm_sink_reap_ring_locked (self, FALSE);
   if (self->unlock) {
     GST_OBJECT_UNLOCK (self);
     return GST_FLOW_FLUSHING;
@@ -689,7 +783,8 @@ gst_shm_sink_render (GstBaseSink * bsink, GstBuffer * buf)
   }
 
   while (!gst_shm_sink_can_render (self, GST_BUFFER_TIMESTAMP (buf))) {
-    g_cond_wait (&self->cond, GST_OBJECT_GET_LOCK (self));
+    if (!gst_shm_sink_reap_ring_locked (self, TRUE))
+      g_cond_wait (&self->cond, GST_OBJECT_GET_LOCK (self));
     if (self->unlock) {
       GST_OBJECT_UNLOCK (self);
       ret = gst_base_sink_wait_preroll (bsink);
@@ -701,6 +796,26 @@ gst_shm_sink_render (GstBaseSink * bsink, GstBuffer * buf)
   }
 
 
+  if (self->pass_fds && gst_buffer_n_memory (buf) == 1 &&
+      gst_is_fd_memory (gst_buffer_peek_memory (buf, 0)) &&
+      sp_writer_clients_want_fds (self->pipe)) {
+    memory = gst_buffer_peek_memory (buf, 0);
+
+    GST_LOG_OBJECT (self, "Passing fd of memory %p", memory);
+
+    sendbuf = gst_buffer_ref (buf);
+    rv = sp_writer_send_fd (self->pipe, gst_fd_memory_get_fd (memory),
+        memory->maxsize, gst_is_dmabuf_memory (memory) ? SP_FD_DMABUF : 0,
+        memory->offset, memory->size, sendbuf);
+    if (rv == -1) {
+      GST_ELEMENT_ERROR (self, STREAM, FAILED,
+          (NULL), ("Failed to pass fd over SHM"));
+      gst_buffer_unref (sendbuf);
+      goto error;
+    }
+    goto sent;
+  }
+
   if (gst_buffer_n_memory (buf) > 1) {
     GST_LOG_OBJECT (self, "Buffer %p has %d GstMemory, we only support a single"
         " one, need to do a memcpy", buf, gst_buffer_n_memory (buf));
@@ -728,7 +843,8 @@ gst_shm_sink_render (GstBaseSink * bsink, GstBuffer * buf)
     while ((memory =
             gst_shm_sink_allocator_alloc_locked (self->allocator,
                 gst_buffer_get_size (buf), &self->params)) == NULL) {
-      g_cond_wait (&self->cond, GST_OBJECT_GET_LOCK (self));
+      if (!gst_shm_sink_reap_ring_locked (self, TRUE))
+        g_cond_wait (&self->cond, GST_OBJECT_GET_LOCK (self));
       if (self->unlock) {
         GST_OBJECT_UNLOCK (self);
         ret = gst_base_sink_wait_preroll (bsink);
@@ -798,6 +914,7 @@ gst_shm_sink_render (GstBaseSink * bsink, GstBuffer * buf)
 
   gst_buffer_unmap (sendbuf, &map);
 
+sent:
   GST_OBJECT_UNLOCK (self);
 
   if (rv == 0) {
@@ -812,16 +929,6 @@ error:
   return GST_FLOW_ERROR;
 }
 
-static void
-free_buffer_locked (GstBuffer * buffer, void *data)
-{
-  GSList **list = data;
-
-  g_assert (buffer != NULL);
-
-  *list = g_slist_prepend (*list, buffer);
-}
-
 static gpointer
 pollthread_func (gpointer data)
 {
@@ -909,11 +1016,17 @@ pollthread_func (gpointer data)
       if (gst_poll_fd_can_read (self->poll, &gclient->pollfd)) {
         int rv;
         gpointer tag = NULL;
+        GSList *list = NULL;
 
         GST_OBJECT_LOCK (self);
         rv = sp_writer_recv (self->pipe, gclient->client, &tag);
+        if (rv >= 0)
+          sp_writer_reap_ring (self->pipe, FALSE,
+              (sp_buffer_free_callback) free_buffer_locked, (void **) &list);
         GST_OBJECT_UNLOCK (self);
 
+        g_slist_free_full (list, (GDestroyNotify) gst_buffer_unref);
+
         if (rv < 0) {
           GST_WARNING_OBJECT (self, "One client has read error,"
               " closing (retval: %d errno: %d)", rv, errno);
@@ -961,8 +1074,10 @@ gst_shm_sink_event (GstBaseSink * bsink, GstEvent * event)
     case GST_EVENT_EOS:
       GST_OBJECT_LOCK (self);
       while (self->wait_for_connection && sp_writer_pending_writes (self->pipe)
-          && !self->unlock)
-        g_cond_wait (&self->cond, GST_OBJECT_GET_LOCK (self));
+          && !self->unlock) {
+        if (!gst_shm_sink_reap_ring_locked (self, TRUE))
+          g_cond_wait (&self->cond, GST_OBJECT_GET_LOCK (self));
+      }
       GST_OBJECT_UNLOCK (self);
       break;
     default:
@@ -63,6 +63,8 @@ struct _GstShmSink
   gboolean stop;
   gboolean unlock;
   GstClockTimeDiff buffer_time;
+  gboolean use_ring;
+  gboolean pass_fds;
 
   GCond cond;
 
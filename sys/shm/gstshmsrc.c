@@ -41,8 +41,10 @@
 #include "gstshmsrc.h"
 
 #include <gst/gst.h>
+#include <gst/allocators/allocators.h>
 
 #include <string.h>
+#include <unistd.h>
 
 /* signals */
 enum
@@ -61,7 +63,9 @@ enum
 
 struct GstShmBuffer
 {
+  /* NULL if the buffer is in a passed fd */
   char *buf;
+  ShmFdBuffer fd;
   GstShmPipe *pipe;
 };
 
@@ -152,6 +156,9 @@ gst_shm_src_init (GstShmSrc * self)
 {
   self->poll = gst_poll_new (TRUE);
   gst_poll_fd_init (&self->pollfd);
+
+  self->fd_allocator = gst_fd_allocator_new ();
+  self->dmabuf_allocator = gst_dmabuf_allocator_new ();
 }
 
 static void
@@ -161,6 +168,8 @@ gst_shm_src_finalize (GObject * object)
 
   gst_poll_free (self->poll);
   g_free (self->socket_path);
+  gst_object_unref (self->fd_allocator);
+  gst_object_unref (self->dmabuf_allocator);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -240,6 +249,8 @@ gst_shm_src_start_reading (GstShmSrc * self)
 
   GST_OBJECT_LOCK (self);
   gstpipe->pipe = sp_client_open (self->socket_path);
+  if (gstpipe->pipe)
+    sp_client_enable_fds (gstpipe->pipe, TRUE);
   GST_OBJECT_UNLOCK (self);
 
   if (!gstpipe->pipe) {
@@ -310,7 +321,10 @@ free_buffer (gpointer data)
   GST_LOG ("Freeing buffer %p", gsb->buf);
 
   GST_OBJECT_LOCK (gsb->pipe->src);
-  sp_client_recv_finish (gsb->pipe->pipe, gsb->buf);
+  if (gsb->buf)
+    sp_client_recv_finish (gsb->pipe->pipe, gsb->buf);
+  else
+    sp_client_recv_finish_fd (gsb->pipe->pipe, &gsb->fd);
   GST_OBJECT_UNLOCK (gsb->pipe->src);
 
   gst_shm_pipe_dec (gsb->pipe);
@@ -324,6 +338,7 @@ gst_shm_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
   GstShmSrc *self = GST_SHM_SRC (psrc);
   GstShmPipe *pipe;
   gchar *buf = NULL;
+  ShmFdBuffer fdbuf = { -1, };
   int rv = 0;
   struct GstShmBuffer *gsb;
 
@@ -340,7 +355,14 @@ gst_shm_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
   GST_OBJECT_UNLOCK (self);
 
   do {
-    if (gst_poll_wait (self->poll, GST_CLOCK_TIME_NONE) < 0) {
+    gboolean ready;
+
+    /* Buffers coming through a ring don't wake up the socket */
+    GST_OBJECT_LOCK (self);
+    ready = sp_client_prepare_wait (pipe->pipe);
+    GST_OBJECT_UNLOCK (self);
+
+    if (!ready && gst_poll_wait (self->poll, GST_CLOCK_TIME_NONE) < 0) {
       if (errno == EBUSY)
         goto flushing;
       GST_ELEMENT_ERROR (self, RESOURCE, READ, ("Failed to read from shmsrc"),
@@ -363,11 +385,11 @@ gst_shm_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
       goto error;
     }
 
-    if (gst_poll_fd_can_read (self->poll, &self->pollfd)) {
+    if (ready || gst_poll_fd_can_read (self->poll, &self->pollfd)) {
       buf = NULL;
       GST_LOG_OBJECT (self, "Reading from pipe");
       GST_OBJECT_LOCK (self);
-      rv = sp_client_recv (pipe->pipe, &buf);
+      rv = sp_client_recv_fd (pipe->pipe, &buf, &fdbuf);
       GST_OBJECT_UNLOCK (self);
       if (rv < 0) {
         GST_ELEMENT_ERROR (self, RESOURCE, READ, ("Failed to read from shmsrc"),
@@ -375,16 +397,50 @@ gst_shm_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
         goto error;
       }
     }
-  } while (buf == NULL);
-
-  GST_LOG_OBJECT (self, "Got buffer %p of size %d", buf, rv);
+  } while (buf == NULL && fdbuf.fd < 0);
 
   gsb = g_slice_new0 (struct GstShmBuffer);
   gsb->buf = buf;
   gsb->pipe = pipe;
 
-  *outbuf = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
-      buf, rv, 0, rv, gsb, free_buffer);
+  if (buf) {
+    GST_LOG_OBJECT (self, "Got buffer %p of size %d", buf, rv);
+
+    *outbuf = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+        buf, rv, 0, rv, gsb, free_buffer);
+  } else {
+    GstMemory *mem;
+
+    GST_LOG_OBJECT (self, "Got buffer of size %d at offset %lu in %s fd %d",
+        rv, fdbuf.offset, (fdbuf.flags & SP_FD_DMABUF) ? "DMABuf" : "memory",
+        fdbuf.fd);
+
+    gsb->fd = fdbuf;
+
+    /* The memory owns the fd, the buffer is released once it is freed */
+    if (fdbuf.flags & SP_FD_DMABUF)
+      mem = gst_dmabuf_allocator_alloc (self->dmabuf_allocator, fdbuf.fd,
+          fdbuf.fd_size);
+    else
+      mem = gst_fd_allocator_alloc (self->fd_allocator, fdbuf.fd,
+          fdbuf.fd_size, GST_FD_MEMORY_FLAG_NONE);
+
+    if (!mem) {
+      close (fdbuf.fd);
+      free_buffer (gsb);
+      GST_ELEMENT_ERROR (self, RESOURCE, READ, ("Failed to read from shmsrc"),
+          ("Could not import fd of size %" G_GSIZE_FORMAT, fdbuf.fd_size));
+      return GST_FLOW_ERROR;
+    }
+
+    gst_memory_resize (mem, fdbuf.offset, rv);
+    GST_MINI_OBJECT_FLAG_SET (mem, GST_MEMORY_FLAG_READONLY);
+    gst_mini_object_set_qdata (GST_MINI_OBJECT_CAST (mem),
+        g_quark_from_static_string ("GstShmSrcBuffer"), gsb, free_buffer);
+
+    *outbuf = gst_buffer_new ();
+    gst_buffer_append_memory (*outbuf, mem);
+  }
 
   return GST_FLOW_OK;
 
@@ -56,6 +56,9 @@ struct _GstShmSrc
 
   GstFlowReturn flow_return;
   gboolean unlocked;
+
+  GstAllocator *fd_allocator;
+  GstAllocator *dmabuf_allocator;
 };
 
 struct _GstShmSrcClass
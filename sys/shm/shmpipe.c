@@ -45,6 +45,7 @@
 #include <fcntl.h>
 #include <limits.h>
 #include <sys/mman.h>
+#include <stdint.h>
 #include <assert.h>
 
 #include "shmalloc.h"
@@ -67,9 +68,48 @@
  * type 4: ack buffer
  * offset
  *
- * Type 4 goes from the client to the server
+ * type 5: request ring
+ * No payload
+ *
+ * type 6: new ring
+ * Ring length
+ * Size of path (followed by path)
+ *
+ * type 7: ring doorbell
+ * No payload
+ *
+ * type 8: new fd
+ * Size of the memory behind the fd
+ * Flags
+ * The fd itself is passed with SCM_RIGHTS
+ *
+ * type 9: close fd
+ * No payload
+ *
+ * type 10: request fds
+ * No payload
+ *
+ * Types 4, 5 and 10 go from the client to the server, type 7 goes both ways
  * The rest are from the server to the client
  * The client should never write in the SHM
+ *
+ * If the server supports rings, the path sent with the first new shm area
+ * is followed by "ring" after its NUL terminator, old clients just ignore
+ * it. A client can then request a ring, which is a separate shm area that
+ * the server creates for that client only. From then on, the server
+ * publishes buffers in the ring slots instead of sending a type 3 packet
+ * and the client releases them by moving the release cursor of the ring
+ * instead of sending a type 4 packet. A doorbell is only sent when the
+ * other side announced that it is going to sleep, so on a busy pipe
+ * buffers go through without any syscall. The ring is the only part of
+ * the SHM the client writes to.
+ *
+ * In the same way "fds" means that the server can pass buffers that
+ * live in memory of their own, like DMABufs, instead of copying them in
+ * the shm area. A client that requests it gets each such memory passed
+ * once as a new fd, which it keeps until the server closes it. Buffers
+ * in there use the negated fd id as area id, both on the socket and in
+ * the ring.
  */
 
 
@@ -80,7 +120,83 @@ enum
   COMMAND_NEW_SHM_AREA = 1,
   COMMAND_CLOSE_SHM_AREA = 2,
   COMMAND_NEW_BUFFER = 3,
-  COMMAND_ACK_BUFFER = 4
+  COMMAND_ACK_BUFFER = 4,
+  COMMAND_REQUEST_RING = 5,
+  COMMAND_NEW_RING = 6,
+  COMMAND_RING_DOORBELL = 7,
+  COMMAND_NEW_FD = 8,
+  COMMAND_CLOSE_FD = 9,
+  COMMAND_REQUEST_FDS = 10
+};
+
+#define SHM_FDS_CAPS "fds"
+/* How many fds the server keeps passed to the clients at most */
+#define SHM_FD_CACHE 32
+
+#define SHM_RING_CAPS "ring"
+#define SHM_RING_MAGIC 0x52505053
+/* must be a power of two so the sequence numbers can wrap */
+#define SHM_RING_SLOTS 1024
+#define SHM_RING_CACHELINE 64
+
+#define SHM_RING_LOAD(p) __atomic_load_n ((p), __ATOMIC_SEQ_CST)
+#define SHM_RING_STORE(p, v) __atomic_store_n ((p), (v), __ATOMIC_SEQ_CST)
+#define SHM_RING_XCHG(p, v) __atomic_exchange_n ((p), (v), __ATOMIC_SEQ_CST)
+
+typedef struct
+{
+  int32_t area_id;
+  uint32_t reserved;
+  uint64_t offset;
+  uint64_t size;
+} ShmRingSlot;
+
+/* The layout of the ring in the shared memory, each side writes to its
+ * own cache line */
+typedef struct
+{
+  uint32_t magic;
+  uint32_t n_slots;
+  char pad0[SHM_RING_CACHELINE - 2 * sizeof (uint32_t)];
+
+  /* Written by the server */
+  uint32_t write_seq;
+  uint32_t writer_waiting;
+  char pad1[SHM_RING_CACHELINE - 2 * sizeof (uint32_t)];
+
+  /* Written by the client */
+  uint32_t release_seq;
+  uint32_t reader_sleeping;
+  char pad2[SHM_RING_CACHELINE - 2 * sizeof (uint32_t)];
+
+  ShmRingSlot slots[0];
+} ShmRingHeader;
+
+typedef struct _ShmRing ShmRing;
+
+struct _ShmRing
+{
+  int is_writer;
+
+  int fd;
+  char *name;
+  size_t len;
+
+  ShmRingHeader *header;
+  uint32_t n_slots;
+
+  /* Server side: our own copy of what was published, so a client can't
+   * make us release something else, and the next slot to release */
+  ShmRingSlot *sent;
+  uint32_t write_seq;
+  uint32_t reaped_seq;
+
+  /* Client side: what every consumed slot was and whether it was
+   * released already, releases can come in any order */
+  ShmRingSlot *consumed;
+  unsigned char *released;
+  uint32_t read_seq;
+  uint32_t release_seq;
 };
 
 typedef struct _ShmArea ShmArea;
@@ -101,6 +217,11 @@ struct _ShmArea
 
   ShmAllocSpace *allocspace;
 
+  /* Client side: the server closed the area, but slots published in
+   * the ring before that still reference it */
+  int closing;
+  uint32_t close_seq;
+
   ShmArea *next;
 };
 
@@ -108,7 +229,10 @@ struct _ShmBuffer
 {
   int use_count;
 
+  /* One of the two */
   ShmArea *shm_area;
+  int fd_id;
+
   unsigned long offset;
   size_t size;
 
@@ -124,6 +248,37 @@ struct _ShmBuffer
 };
 
 
+typedef struct _ShmFd ShmFd;
+
+/* Server side: an fd that was passed to some clients, we keep a dup of
+ * it so that the inode it is identified with can't be reused */
+struct _ShmFd
+{
+  int id;
+  int fd;
+  dev_t dev;
+  ino_t ino;
+  unsigned int last_used;
+
+  ShmFd *next;
+};
+
+typedef struct _ShmClientFd ShmClientFd;
+
+/* Client side: an fd that was passed by the server */
+struct _ShmClientFd
+{
+  int id;
+  int fd;
+  size_t size;
+  unsigned int flags;
+
+  int closing;
+  uint32_t close_seq;
+
+  ShmClientFd *next;
+};
+
 struct _ShmPipe
 {
   int main_socket;
@@ -141,12 +296,33 @@ struct _ShmPipe
   ShmClient *clients;
 
   mode_t perms;
+
+  /* Server side: offer rings and fd passing to new clients */
+  int use_ring;
+  int use_fds;
+  ShmFd *fds;
+  int num_fds;
+  int next_fd_id;
+  unsigned int fd_use_counter;
+
+  /* Client side */
+  int ring_requested;
+  ShmRing *ring;
+  int want_fds;
+  int fds_requested;
+  ShmClientFd *client_fds;
 };
 
 struct _ShmClient
 {
   int fd;
 
+  ShmRing *ring;
+
+  int wants_fds;
+  int known_fds[SHM_FD_CACHE];
+  int num_known_fds;
+
   ShmClient *next;
 };
 
@@ -179,6 +355,11 @@ struct CommandBuffer
     {
       unsigned long offset;
     } ack_buffer;
+    struct
+    {
+      size_t size;
+      unsigned int flags;
+    } new_fd;
   } payload;
 };
 
@@ -187,6 +368,7 @@ static void sp_close_shm (ShmArea * area);
 static int sp_shmbuf_dec (ShmPipe * self, ShmBuffer * buf,
     ShmBuffer * prev_buf, ShmClient * client, void **tag);
 static void sp_shm_area_dec (ShmPipe * self, ShmArea * area);
+static void sp_ring_close (ShmRing * ring);
 
 
 
@@ -364,6 +546,117 @@ sp_close_shm (ShmArea * area)
   spalloc_free (ShmArea, area);
 }
 
+/* sp_ring_open:
+ * @path: Path of the ring for a reader,
+ *  NULL if this is a writer (then it will create its own)
+ *
+ * Opens a ShmRing, both sides map it read-write
+ */
+
+static ShmRing *
+sp_ring_open (const char *path, mode_t perms, size_t size)
+{
+  ShmRing *ring = spalloc_new (ShmRing);
+  ShmRingHeader *header;
+  char tmppath[32];
+  int i = 0;
+
+  memset (ring, 0, sizeof (ShmRing));
+
+  ring->fd = -1;
+  ring->header = MAP_FAILED;
+  ring->is_writer = (path == NULL);
+
+  if (path) {
+    ring->fd = shm_open (path, O_RDWR, 0);
+  } else {
+    size = sizeof (ShmRingHeader) + SHM_RING_SLOTS * sizeof (ShmRingSlot);
+    do {
+      snprintf (tmppath, sizeof (tmppath), "/shmpipe.%5d.r%5d", getpid (),
+          i++);
+      ring->fd = shm_open (tmppath, O_RDWR | O_CREAT | O_EXCL, perms);
+    } while (ring->fd < 0 && errno == EEXIST);
+  }
+
+  if (ring->fd < 0) {
+    fprintf (stderr, "shm_open failed on ring %s (%d): %s\n",
+        path ? path : tmppath, errno, strerror (errno));
+    goto error;
+  }
+
+  ring->name = strdup (path ? path : tmppath);
+
+  if (!path && ftruncate (ring->fd, size)) {
+    fprintf (stderr, "Could not resize ring, ftruncate failed (%d): %s\n",
+        errno, strerror (errno));
+    goto error;
+  }
+
+  if (size < sizeof (ShmRingHeader))
+    goto error;
+
+  ring->len = size;
+  ring->header = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+      ring->fd, 0);
+  if (ring->header == MAP_FAILED) {
+    fprintf (stderr, "mmap failed on ring (%d): %s\n", errno,
+        strerror (errno));
+    goto error;
+  }
+
+  header = ring->header;
+
+  if (!path) {
+    header->magic = SHM_RING_MAGIC;
+    header->n_slots = SHM_RING_SLOTS;
+  }
+
+  /* Copy it, the other side could change it later */
+  ring->n_slots = header->n_slots;
+
+  if (header->magic != SHM_RING_MAGIC || ring->n_slots == 0 ||
+      (ring->n_slots & (ring->n_slots - 1)) != 0 ||
+      (size - sizeof (ShmRingHeader)) / sizeof (ShmRingSlot) < ring->n_slots)
+    goto error;
+
+  if (ring->is_writer) {
+    ring->sent = malloc (ring->n_slots * sizeof (ShmRingSlot));
+  } else {
+    ring->consumed = malloc (ring->n_slots * sizeof (ShmRingSlot));
+    ring->released = calloc (ring->n_slots, 1);
+    ring->read_seq = ring->release_seq =
+        SHM_RING_LOAD (&header->release_seq);
+  }
+
+  return ring;
+
+error:
+  sp_ring_close (ring);
+  return NULL;
+}
+
+static void
+sp_ring_close (ShmRing * ring)
+{
+  if (ring->header != MAP_FAILED)
+    munmap (ring->header, ring->len);
+
+  if (ring->fd >= 0)
+    close (ring->fd);
+
+  if (ring->name) {
+    if (ring->is_writer)
+      shm_unlink (ring->name);
+    free (ring->name);
+  }
+
+  free (ring->sent);
+  free (ring->consumed);
+  free (ring->released);
+
+  spalloc_free (ShmRing, ring);
+}
+
 static void
 sp_shm_area_inc (ShmArea * area)
 {
@@ -425,6 +718,23 @@ sp_dec (ShmPipe * self)
   while (self->shm_area)
     sp_shm_area_dec (self, self->shm_area);
 
+  if (self->ring)
+    sp_ring_close (self->ring);
+
+  while (self->fds) {
+    ShmFd *item = self->fds;
+    self->fds = item->next;
+    close (item->fd);
+    spalloc_free (ShmFd, item);
+  }
+
+  while (self->client_fds) {
+    ShmClientFd *item = self->client_fds;
+    self->client_fds = item->next;
+    close (item->fd);
+    spalloc_free (ShmClientFd, item);
+  }
+
   spalloc_free (ShmPipe, self);
 }
 
@@ -460,10 +770,14 @@ sp_writer_setperms_shm (ShmPipe * self, mode_t perms)
 {
   int ret = 0;
   ShmArea *area;
+  ShmClient *client;
 
   self->perms = perms;
   for (area = self->shm_area; area; area = area->next)
     ret |= fchmod (area->shm_fd, perms);
+  for (client = self->clients; client; client = client->next)
+    if (client->ring)
+      ret |= fchmod (client->ring->fd, perms);
 
   ret |= chmod (self->socket_path, perms);
 
@@ -484,6 +798,43 @@ send_command (int fd, struct CommandBuffer *cb, unsigned short int type,
   return 1;
 }
 
+static int
+send_command_with_fd (int fd, struct CommandBuffer *cb,
+    unsigned short int type, int area_id, int passed_fd)
+{
+  struct msghdr msg;
+  struct iovec iov;
+  union
+  {
+    struct cmsghdr hdr;
+    char buf[CMSG_SPACE (sizeof (int))];
+  } control;
+  struct cmsghdr *cmsg;
+
+  cb->type = type;
+  cb->area_id = area_id;
+
+  memset (&msg, 0, sizeof (msg));
+  memset (&control, 0, sizeof (control));
+  iov.iov_base = cb;
+  iov.iov_len = sizeof (struct CommandBuffer);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof (control.buf);
+
+  cmsg = CMSG_FIRSTHDR (&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN (sizeof (int));
+  memcpy (CMSG_DATA (cmsg), &passed_fd, sizeof (int));
+
+  if (sendmsg (fd, &msg, MSG_NOSIGNAL) != sizeof (struct CommandBuffer))
+    return 0;
+
+  return 1;
+}
+
 int
 sp_writer_resize (ShmPipe * self, size_t size)
 {
@@ -572,6 +923,209 @@ sp_writer_free_block (ShmBlock * block)
   spalloc_free (ShmBlock, block);
 }
 
+/* Publishes a buffer in the ring of a client, fails if the client didn't
+ * release enough of the previous ones yet */
+
+static int
+sp_ring_push (ShmRing * ring, int area_id, unsigned long offset,
+    unsigned long size)
+{
+  uint32_t idx = ring->write_seq & (ring->n_slots - 1);
+  ShmRingSlot *slot = &ring->header->slots[idx];
+
+  if (ring->write_seq - ring->reaped_seq >= ring->n_slots)
+    return 0;
+
+  slot->area_id = area_id;
+  slot->offset = offset;
+  slot->size = size;
+  ring->sent[idx] = *slot;
+
+  ring->write_seq++;
+  SHM_RING_STORE (&ring->header->write_seq, ring->write_seq);
+
+  return 1;
+}
+
+static void
+sp_writer_forget_fd (ShmPipe * self, ShmFd * fd)
+{
+  ShmClient *client;
+  ShmFd *item = NULL;
+  ShmFd *prev_item = NULL;
+  int i;
+
+  for (client = self->clients; client; client = client->next) {
+    for (i = 0; i < client->num_known_fds; i++) {
+      if (client->known_fds[i] == fd->id) {
+        struct CommandBuffer cb = { 0 };
+
+        send_command (client->fd, &cb, COMMAND_CLOSE_FD, fd->id);
+        client->known_fds[i] = client->known_fds[--client->num_known_fds];
+        break;
+      }
+    }
+  }
+
+  for (item = self->fds; item; item = item->next) {
+    if (item == fd) {
+      if (prev_item)
+        prev_item->next = item->next;
+      else
+        self->fds = item->next;
+      break;
+    }
+    prev_item = item;
+  }
+  assert (item);
+
+  self->num_fds--;
+  close (fd->fd);
+  spalloc_free (ShmFd, fd);
+}
+
+/* Finds the passed fd for the memory, or makes room for it */
+
+static ShmFd *
+sp_writer_get_fd (ShmPipe * self, int fd)
+{
+  struct stat st;
+  ShmFd *item, *oldest = NULL;
+
+  if (fstat (fd, &st) < 0)
+    return NULL;
+
+  for (item = self->fds; item; item = item->next) {
+    if (item->dev == st.st_dev && item->ino == st.st_ino)
+      goto done;
+    if (!oldest || item->last_used < oldest->last_used)
+      oldest = item;
+  }
+
+  if (self->num_fds >= SHM_FD_CACHE)
+    sp_writer_forget_fd (self, oldest);
+
+  item = spalloc_new (ShmFd);
+  item->fd = dup (fd);
+  if (item->fd < 0) {
+    spalloc_free (ShmFd, item);
+    return NULL;
+  }
+  item->id = ++self->next_fd_id;
+  item->dev = st.st_dev;
+  item->ino = st.st_ino;
+  item->next = self->fds;
+  self->fds = item;
+  self->num_fds++;
+
+done:
+  item->last_used = ++self->fd_use_counter;
+  return item;
+}
+
+static int
+sp_writer_client_knows_fd (ShmClient * client, int fd_id)
+{
+  int i;
+
+  for (i = 0; i < client->num_known_fds; i++)
+    if (client->known_fds[i] == fd_id)
+      return 1;
+
+  return 0;
+}
+
+/* Returns the number of client this has successfully been sent to */
+
+int
+sp_writer_send_fd (ShmPipe * self, int fd, size_t fd_size, unsigned int flags,
+    unsigned long offset, size_t size, void *tag)
+{
+  ShmFd *item;
+  ShmBuffer *sb;
+  ShmClient *client = NULL;
+  int i = 0;
+  int c = 0;
+
+  if (self->num_clients == 0)
+    return 0;
+
+  if (offset > fd_size || size > fd_size - offset)
+    return -1;
+
+  item = sp_writer_get_fd (self, fd);
+  if (!item)
+    return -1;
+
+  sb = spalloc_alloc (sizeof (ShmBuffer) + sizeof (int) * self->num_clients);
+  memset (sb, 0, sizeof (ShmBuffer));
+  memset (sb->clients, -1, sizeof (int) * self->num_clients);
+  sb->fd_id = item->id;
+  sb->offset = offset;
+  sb->size = size;
+  sb->num_clients = self->num_clients;
+  sb->tag = tag;
+
+  for (client = self->clients; client; client = client->next) {
+    struct CommandBuffer cb = { 0 };
+
+    if (!client->wants_fds)
+      continue;
+
+    if (!sp_writer_client_knows_fd (client, item->id)) {
+      cb.payload.new_fd.size = fd_size;
+      cb.payload.new_fd.flags = flags;
+      if (!send_command_with_fd (client->fd, &cb, COMMAND_NEW_FD, item->id,
+              item->fd))
+        continue;
+      client->known_fds[client->num_known_fds++] = item->id;
+      memset (&cb, 0, sizeof (cb));
+    }
+
+    if (client->ring) {
+      if (!sp_ring_push (client->ring, -item->id, offset, size))
+        continue;
+      if (SHM_RING_XCHG (&client->ring->header->reader_sleeping, 0))
+        send_command (client->fd, &cb, COMMAND_RING_DOORBELL, 0);
+    } else {
+      cb.payload.buffer.offset = offset;
+      cb.payload.buffer.size = size;
+      if (!send_command (client->fd, &cb, COMMAND_NEW_BUFFER, -item->id))
+        continue;
+    }
+
+    sb->clients[i++] = client->fd;
+    c++;
+  }
+
+  if (c == 0) {
+    spalloc_free1 (sizeof (ShmBuffer) + sizeof (int) * sb->num_clients, sb);
+    return 0;
+  }
+
+  sb->use_count = c;
+
+  sb->next = self->buffers;
+  self->buffers = sb;
+
+  return c;
+}
+
+int
+sp_writer_clients_want_fds (ShmPipe * self)
+{
+  ShmClient *client;
+
+  if (!self->use_fds || self->num_clients == 0)
+    return 0;
+
+  for (client = self->clients; client; client = client->next)
+    if (!client->wants_fds)
+      return 0;
+
+  return 1;
+}
+
 /* Returns the number of client this has successfully been sent to */
 
 int
@@ -614,6 +1168,19 @@ sp_writer_send_buf (ShmPipe * self, char *buf, size_t size, void *tag)
 
   for (client = self->clients; client; client = client->next) {
     struct CommandBuffer cb = { 0 };
+
+    if (client->ring) {
+      /* The client may have closed older areas already */
+      if (area != self->shm_area ||
+          !sp_ring_push (client->ring, area->id, offset, bsize))
+        continue;
+      if (SHM_RING_XCHG (&client->ring->header->reader_sleeping, 0))
+        send_command (client->fd, &cb, COMMAND_RING_DOORBELL, 0);
+      sb->clients[i++] = client->fd;
+      c++;
+      continue;
+    }
+
     cb.payload.buffer.offset = offset;
     cb.payload.buffer.size = bsize;
     if (!send_command (client->fd, &cb, COMMAND_NEW_BUFFER, self->shm_area->id))
@@ -651,62 +1218,483 @@ recv_command (int fd, struct CommandBuffer *cb)
   }
 }
 
-long int
-sp_client_recv (ShmPipe * self, char **buf)
+static int
+recv_command_with_fd (int fd, struct CommandBuffer *cb, int *passed_fd)
 {
-  char *area_name = NULL;
-  ShmArea *newarea;
-  ShmArea *area;
-  struct CommandBuffer cb;
+  struct msghdr msg;
+  struct iovec iov;
+  union
+  {
+    struct cmsghdr hdr;
+    char buf[CMSG_SPACE (sizeof (int))];
+  } control;
+  struct cmsghdr *cmsg;
   int retval;
 
-  if (!recv_command (self->main_socket, &cb))
-    return -1;
+  *passed_fd = -1;
 
-  switch (cb.type) {
-    case COMMAND_NEW_SHM_AREA:
-      assert (cb.payload.new_shm_area.path_size > 0);
-      assert (cb.payload.new_shm_area.size > 0);
+  memset (&msg, 0, sizeof (msg));
+  iov.iov_base = cb;
+  iov.iov_len = sizeof (struct CommandBuffer);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof (control.buf);
 
-      area_name = malloc (cb.payload.new_shm_area.path_size + 1);
-      retval = recv (self->main_socket, area_name,
-          cb.payload.new_shm_area.path_size, 0);
-      if (retval != cb.payload.new_shm_area.path_size) {
-        free (area_name);
-        return -3;
-      }
-      /* Ensure area_name is NULL terminated */
-      area_name[retval] = 0;
+  retval = recvmsg (fd, &msg, MSG_DONTWAIT);
+  if (retval < 0)
+    return 0;
 
-      newarea = sp_open_shm (area_name, cb.area_id, 0,
+  for (cmsg = CMSG_FIRSTHDR (&msg); cmsg; cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+    unsigned char *data = CMSG_DATA (cmsg);
+    size_t len;
+
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+      continue;
+
+    for (len = CMSG_LEN (0); len + sizeof (int) <= cmsg->cmsg_len;
+        len += sizeof (int)) {
+      int received;
+
+      memcpy (&received, data, sizeof (int));
+      data += sizeof (int);
+
+      if (*passed_fd < 0) {
+        *passed_fd = received;
+        fcntl (received, F_SETFD, FD_CLOEXEC);
+      } else {
+        close (received);
+      }
+    }
+  }
+
+  if (retval != sizeof (struct CommandBuffer)) {
+    if (*passed_fd >= 0)
+      close (*passed_fd);
+    *passed_fd = -1;
+    return 0;
+  }
+
+  return 1;
+}
+
+static ShmArea *
+sp_client_find_area (ShmPipe * self, int area_id)
+{
+  ShmArea *area;
+
+  for (area = self->shm_area; area; area = area->next)
+    if (area->id == area_id)
+      return area;
+
+  return NULL;
+}
+
+static ShmClientFd *
+sp_client_find_fd (ShmPipe * self, int fd_id)
+{
+  ShmClientFd *item;
+
+  for (item = self->client_fds; item; item = item->next)
+    if (item->id == fd_id)
+      return item;
+
+  return NULL;
+}
+
+static void
+sp_client_close_fd (ShmPipe * self, ShmClientFd * fd)
+{
+  ShmClientFd *item = NULL;
+  ShmClientFd *prev_item = NULL;
+
+  for (item = self->client_fds; item; item = item->next) {
+    if (item == fd) {
+      if (prev_item)
+        prev_item->next = item->next;
+      else
+        self->client_fds = item->next;
+      break;
+    }
+    prev_item = item;
+  }
+  assert (item);
+
+  close (fd->fd);
+  spalloc_free (ShmClientFd, fd);
+}
+
+/* Drops the areas and fds that were closed by the server once we
+ * consumed all the slots that were published before that */
+
+static void
+sp_client_ring_close_areas (ShmPipe * self)
+{
+  ShmArea *area;
+  ShmClientFd *fd;
+
+again:
+  for (area = self->shm_area; area; area = area->next) {
+    if (area->closing &&
+        (int32_t) (self->ring->read_seq - area->close_seq) >= 0) {
+      area->closing = 0;
+      sp_shm_area_dec (self, area);
+      goto again;
+    }
+  }
+
+  for (fd = self->client_fds; fd; fd = fd->next) {
+    if (fd->closing &&
+        (int32_t) (self->ring->read_seq - fd->close_seq) >= 0) {
+      sp_client_close_fd (self, fd);
+      goto again;
+    }
+  }
+}
+
+/* Resolves a buffer announced by the server, either in one of the areas
+ * or in one of the fds */
+
+static long int
+sp_client_get_buffer (ShmPipe * self, int area_id, unsigned long offset,
+    unsigned long size, char **buf, ShmFdBuffer * fdbuf)
+{
+  assert (buf);
+
+  if (area_id < 0) {
+    ShmClientFd *fd = sp_client_find_fd (self, -area_id);
+
+    if (!fd || !fdbuf)
+      return -23;
+
+    if (offset > fd->size || size > fd->size - offset)
+      return -24;
+
+    fdbuf->fd = dup (fd->fd);
+    if (fdbuf->fd < 0)
+      return -25;
+    fcntl (fdbuf->fd, F_SETFD, FD_CLOEXEC);
+
+    fdbuf->id = fd->id;
+    fdbuf->flags = fd->flags;
+    fdbuf->fd_size = fd->size;
+    fdbuf->offset = offset;
+    *buf = NULL;
+  } else {
+    ShmArea *area = sp_client_find_area (self, area_id);
+
+    if (!area)
+      return -23;
+
+    if (offset > area->shm_area_len || size > area->shm_area_len - offset)
+      return -24;
+
+    *buf = area->shm_area_buf + offset;
+    sp_shm_area_inc (area);
+  }
+
+  return size;
+}
+
+/* Returns the head slot of the ring if it can be consumed, it can't if
+ * the announcement of its area or fd is still in the socket */
+
+static ShmRingSlot *
+sp_client_ring_peek (ShmPipe * self)
+{
+  ShmRing *ring = self->ring;
+  ShmRingSlot *slot;
+
+  if (ring->read_seq == SHM_RING_LOAD (&ring->header->write_seq))
+    return NULL;
+
+  slot = &ring->header->slots[ring->read_seq & (ring->n_slots - 1)];
+
+  if (slot->area_id < 0) {
+    if (!sp_client_find_fd (self, -slot->area_id))
+      return NULL;
+  } else if (!sp_client_find_area (self, slot->area_id)) {
+    return NULL;
+  }
+
+  return slot;
+}
+
+/* Moves the release cursor over the slots that were released in a row
+ * and rings the server if it is waiting for that */
+
+static void
+sp_client_ring_advance (ShmPipe * self)
+{
+  ShmRing *ring = self->ring;
+  uint32_t release_seq = ring->release_seq;
+
+  while (ring->release_seq != ring->read_seq &&
+      ring->released[ring->release_seq & (ring->n_slots - 1)])
+    ring->release_seq++;
+
+  if (ring->release_seq == release_seq)
+    return;
+
+  SHM_RING_STORE (&ring->header->release_seq, ring->release_seq);
+
+  if (SHM_RING_XCHG (&ring->header->writer_waiting, 0)) {
+    struct CommandBuffer cb = { 0 };
+    send_command (self->main_socket, &cb, COMMAND_RING_DOORBELL, 0);
+  }
+}
+
+static long int
+sp_client_ring_pop (ShmPipe * self, char **buf, ShmFdBuffer * fdbuf)
+{
+  ShmRing *ring = self->ring;
+  ShmRingSlot slot, *p;
+  long int retval;
+  uint32_t idx;
+
+  sp_client_ring_close_areas (self);
+
+  while ((p = sp_client_ring_peek (self))) {
+    slot = *p;
+    idx = ring->read_seq & (ring->n_slots - 1);
+    ring->read_seq++;
+
+    /* Would look like an internal message, give it back right away */
+    if (slot.size == 0) {
+      ring->released[idx] = 1;
+      sp_client_ring_advance (self);
+      continue;
+    }
+
+    retval = sp_client_get_buffer (self, slot.area_id, slot.offset,
+        slot.size, buf, fdbuf);
+    if (retval < 0)
+      return retval;
+
+    ring->consumed[idx] = slot;
+    ring->released[idx] = 0;
+
+    return retval;
+  }
+
+  return 0;
+}
+
+/* Returns 1 if the buffer came from the ring */
+
+static int
+sp_client_ring_release (ShmPipe * self, int area_id, unsigned long offset)
+{
+  ShmRing *ring = self->ring;
+  uint32_t seq;
+
+  for (seq = ring->release_seq; seq != ring->read_seq; seq++) {
+    uint32_t idx = seq & (ring->n_slots - 1);
+
+    if (!ring->released[idx] && ring->consumed[idx].area_id == area_id &&
+        ring->consumed[idx].offset == offset) {
+      ring->released[idx] = 1;
+      sp_client_ring_advance (self);
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+int
+sp_client_prepare_wait (ShmPipe * self)
+{
+  if (!self->ring)
+    return 0;
+
+  /* Announce that we're going to sleep before looking, the server
+   * publishes before it looks */
+  SHM_RING_STORE (&self->ring->header->reader_sleeping, 1);
+
+  if (sp_client_ring_peek (self)) {
+    SHM_RING_STORE (&self->ring->header->reader_sleeping, 0);
+    return 1;
+  }
+
+  return 0;
+}
+
+static char *
+recv_path (ShmPipe * self, struct CommandBuffer *cb, int *path_size)
+{
+  char *path;
+  int retval;
+
+  assert (cb->payload.new_shm_area.path_size > 0);
+  assert (cb->payload.new_shm_area.size > 0);
+
+  path = malloc (cb->payload.new_shm_area.path_size + 1);
+  retval = recv (self->main_socket, path,
+      cb->payload.new_shm_area.path_size, 0);
+  if (retval != cb->payload.new_shm_area.path_size) {
+    free (path);
+    return NULL;
+  }
+  /* Ensure path is NULL terminated */
+  path[retval] = 0;
+
+  if (path_size)
+    *path_size = retval;
+
+  return path;
+}
+
+static int
+has_caps (const char *path, int path_size, const char *caps)
+{
+  const char *p = path + strlen (path) + 1;
+
+  while (p < path + path_size) {
+    if (!strcmp (p, caps))
+      return 1;
+    p += strlen (p) + 1;
+  }
+
+  return 0;
+}
+
+long int
+sp_client_recv (ShmPipe * self, char **buf)
+{
+  return sp_client_recv_fd (self, buf, NULL);
+}
+
+long int
+sp_client_recv_fd (ShmPipe * self, char **buf, ShmFdBuffer * fdbuf)
+{
+  char *area_name = NULL;
+  ShmArea *newarea;
+  ShmArea *area;
+  ShmClientFd *cfd;
+  struct CommandBuffer cb;
+  int path_size;
+  int passed_fd = -1;
+  long int retval;
+
+  if (fdbuf)
+    fdbuf->fd = -1;
+
+  /* The ring has the buffers that were published after anything that is
+   * in the socket, except for the areas and fds they reference */
+  if (self->ring) {
+    retval = sp_client_ring_pop (self, buf, fdbuf);
+    if (retval != 0)
+      return retval;
+  }
+
+  if (!recv_command_with_fd (self->main_socket, &cb, &passed_fd))
+    return -1;
+
+  /* Only new fd messages come with one */
+  if (passed_fd >= 0 && cb.type != COMMAND_NEW_FD) {
+    close (passed_fd);
+    passed_fd = -1;
+  }
+
+  switch (cb.type) {
+    case COMMAND_NEW_SHM_AREA:
+      area_name = recv_path (self, &cb, &path_size);
+      if (!area_name)
+        return -3;
+
+      newarea = sp_open_shm (area_name, cb.area_id, 0,
           cb.payload.new_shm_area.size);
-      free (area_name);
-      if (!newarea)
+      if (!newarea) {
+        free (area_name);
         return -4;
+      }
 
       newarea->next = self->shm_area;
       self->shm_area = newarea;
+
+      if (!self->ring_requested &&
+          has_caps (area_name, path_size, SHM_RING_CAPS)) {
+        struct CommandBuffer rcb = { 0 };
+
+        self->ring_requested = 1;
+        send_command (self->main_socket, &rcb, COMMAND_REQUEST_RING, 0);
+      }
+      if (self->want_fds && !self->fds_requested &&
+          has_caps (area_name, path_size, SHM_FDS_CAPS)) {
+        struct CommandBuffer rcb = { 0 };
+
+        self->fds_requested = 1;
+        send_command (self->main_socket, &rcb, COMMAND_REQUEST_FDS, 0);
+      }
+      free (area_name);
       break;
 
     case COMMAND_CLOSE_SHM_AREA:
-      for (area = self->shm_area; area; area = area->next) {
-        if (area->id == cb.area_id) {
+      area = sp_client_find_area (self, cb.area_id);
+      if (area && !area->closing) {
+        if (self->ring) {
+          /* The server published these before closing the area */
+          area->closing = 1;
+          area->close_seq = SHM_RING_LOAD (&self->ring->header->write_seq);
+          sp_client_ring_close_areas (self);
+        } else {
           sp_shm_area_dec (self, area);
-          break;
         }
       }
       break;
 
-    case COMMAND_NEW_BUFFER:
-      assert (buf);
-      for (area = self->shm_area; area; area = area->next) {
-        if (area->id == cb.area_id) {
-          *buf = area->shm_area_buf + cb.payload.buffer.offset;
-          sp_shm_area_inc (area);
-          return cb.payload.buffer.size;
+    case COMMAND_NEW_RING:
+      if (self->ring)
+        return -5;
+
+      area_name = recv_path (self, &cb, NULL);
+      if (!area_name)
+        return -3;
+
+      self->ring = sp_ring_open (area_name, 0, cb.payload.new_shm_area.size);
+      free (area_name);
+      if (!self->ring)
+        return -4;
+      break;
+
+    case COMMAND_RING_DOORBELL:
+      break;
+
+    case COMMAND_NEW_FD:
+      if (passed_fd < 0 || cb.area_id <= 0 ||
+          sp_client_find_fd (self, cb.area_id)) {
+        if (passed_fd >= 0)
+          close (passed_fd);
+        return -6;
+      }
+
+      cfd = spalloc_new (ShmClientFd);
+      memset (cfd, 0, sizeof (ShmClientFd));
+      cfd->id = cb.area_id;
+      cfd->fd = passed_fd;
+      cfd->size = cb.payload.new_fd.size;
+      cfd->flags = cb.payload.new_fd.flags;
+      cfd->next = self->client_fds;
+      self->client_fds = cfd;
+      break;
+
+    case COMMAND_CLOSE_FD:
+      cfd = sp_client_find_fd (self, cb.area_id);
+      if (cfd && !cfd->closing) {
+        if (self->ring) {
+          cfd->closing = 1;
+          cfd->close_seq = SHM_RING_LOAD (&self->ring->header->write_seq);
+          sp_client_ring_close_areas (self);
+        } else {
+          sp_client_close_fd (self, cfd);
         }
       }
-      return -23;
+      break;
+
+    case COMMAND_NEW_BUFFER:
+      return sp_client_get_buffer (self, cb.area_id,
+          cb.payload.buffer.offset, cb.payload.buffer.size, buf, fdbuf);
 
     default:
       return -99;
@@ -715,10 +1703,65 @@ sp_client_recv (ShmPipe * self, char **buf)
   return 0;
 }
 
+void
+sp_client_enable_fds (ShmPipe * self, int enable)
+{
+  self->want_fds = enable;
+}
+
+static int
+sp_writer_ack (ShmPipe * self, ShmClient * client, int area_id,
+    unsigned long offset, void **tag)
+{
+  ShmBuffer *buf = NULL, *prev_buf = NULL;
+  int i;
+
+  for (buf = self->buffers; buf; buf = buf->next) {
+    int buf_id = buf->shm_area ? buf->shm_area->id : -buf->fd_id;
+
+    if (buf_id == area_id && buf->offset == offset) {
+      for (i = 0; i < buf->num_clients; i++)
+        if (buf->clients[i] == client->fd)
+          return sp_shmbuf_dec (self, buf, prev_buf, client, tag);
+    }
+    prev_buf = buf;
+  }
+
+  return -2;
+}
+
+static int
+sp_writer_open_ring (ShmPipe * self, ShmClient * client)
+{
+  struct CommandBuffer cb = { 0 };
+  ShmRing *ring;
+  int pathlen;
+
+  /* Not fatal, the client keeps using the socket */
+  if (client->ring || !self->use_ring)
+    return 1;
+
+  ring = sp_ring_open (NULL, self->perms, 0);
+  if (!ring)
+    return 1;
+
+  pathlen = strlen (ring->name) + 1;
+  cb.payload.new_shm_area.size = ring->len;
+  cb.payload.new_shm_area.path_size = pathlen;
+  if (!send_command (client->fd, &cb, COMMAND_NEW_RING, 0) ||
+      send (client->fd, ring->name, pathlen, MSG_NOSIGNAL) != pathlen) {
+    sp_ring_close (ring);
+    return -3;
+  }
+
+  client->ring = ring;
+
+  return 1;
+}
+
 int
 sp_writer_recv (ShmPipe * self, ShmClient * client, void **tag)
 {
-  ShmBuffer *buf = NULL, *prev_buf = NULL;
   struct CommandBuffer cb;
 
   if (!recv_command (client->fd, &cb))
@@ -726,16 +1769,17 @@ sp_writer_recv (ShmPipe * self, ShmClient * client, void **tag)
 
   switch (cb.type) {
     case COMMAND_ACK_BUFFER:
-
-      for (buf = self->buffers; buf; buf = buf->next) {
-        if (buf->shm_area->id == cb.area_id &&
-            buf->offset == cb.payload.ack_buffer.offset) {
-          return sp_shmbuf_dec (self, buf, prev_buf, client, tag);
-        }
-        prev_buf = buf;
-      }
-
-      return -2;
+      return sp_writer_ack (self, client, cb.area_id,
+          cb.payload.ack_buffer.offset, tag);
+    case COMMAND_REQUEST_RING:
+      return sp_writer_open_ring (self, client);
+    case COMMAND_RING_DOORBELL:
+      /* The releases are picked up by sp_writer_reap_ring() */
+      return 1;
+    case COMMAND_REQUEST_FDS:
+      if (self->use_fds)
+        client->wants_fds = 1;
+      return 1;
     default:
       return -99;
   }
@@ -743,11 +1787,66 @@ sp_writer_recv (ShmPipe * self, ShmClient * client, void **tag)
   return 0;
 }
 
+int
+sp_writer_reap_ring (ShmPipe * self, int want_wakeup,
+    sp_buffer_free_callback callback, void *user_data)
+{
+  ShmClient *client;
+  int freed = 0;
+
+  for (client = self->clients; client; client = client->next) {
+    ShmRing *ring = client->ring;
+    uint32_t release_seq;
+
+    if (!ring)
+      continue;
+
+    /* Set it before looking, the client releases before it looks */
+    if (want_wakeup)
+      SHM_RING_STORE (&ring->header->writer_waiting, 1);
+
+    release_seq = SHM_RING_LOAD (&ring->header->release_seq);
+
+    /* Don't trust the client to not release what we never sent */
+    if (release_seq - ring->reaped_seq > ring->write_seq - ring->reaped_seq)
+      continue;
+
+    while (ring->reaped_seq != release_seq) {
+      ShmRingSlot *slot = &ring->sent[ring->reaped_seq & (ring->n_slots - 1)];
+      void *tag = NULL;
+
+      ring->reaped_seq++;
+
+      if (sp_writer_ack (self, client, slot->area_id, slot->offset,
+              &tag) == 0) {
+        if (callback)
+          callback (tag, user_data);
+        freed++;
+      }
+    }
+  }
+
+  return freed;
+}
+
+void
+sp_writer_enable_ring (ShmPipe * self, int enable)
+{
+  self->use_ring = enable;
+}
+
+void
+sp_writer_enable_fds (ShmPipe * self, int enable)
+{
+  self->use_fds = enable;
+}
+
 int
 sp_client_recv_finish (ShmPipe * self, char *buf)
 {
   ShmArea *shm_area = NULL;
   unsigned long offset;
+  int area_id;
   struct CommandBuffer cb = { 0 };
 
   for (shm_area = self->shm_area; shm_area; shm_area = shm_area->next) {
@@ -759,14 +1858,31 @@ sp_client_recv_finish (ShmPipe * self, char *buf)
   assert (shm_area);
 
   offset = buf - shm_area->shm_area_buf;
+  area_id = shm_area->id;
 
   sp_shm_area_dec (self, shm_area);
 
+  if (self->ring && sp_client_ring_release (self, area_id, offset))
+    return 1;
+
   cb.payload.ack_buffer.offset = offset;
   return send_command (self->main_socket, &cb, COMMAND_ACK_BUFFER,
       self->shm_area->id);
 }
 
+int
+sp_client_recv_finish_fd (ShmPipe * self, ShmFdBuffer * fdbuf)
+{
+  struct CommandBuffer cb = { 0 };
+
+  if (self->ring && sp_client_ring_release (self, -fdbuf->id, fdbuf->offset))
+    return 1;
+
+  cb.payload.ack_buffer.offset = fdbuf->offset;
+  return send_command (self->main_socket, &cb, COMMAND_ACK_BUFFER,
+      -fdbuf->id);
+}
+
 ShmPipe *
 sp_client_open (const char *path)
 {
@@ -811,6 +1927,8 @@ sp_writer_accept_client (ShmPipe * self)
   int fd;
   struct CommandBuffer cb = { 0 };
   int pathlen = strlen (self->shm_area->shm_area_name) + 1;
+  char *path = self->shm_area->shm_area_name;
+  char *with_caps = NULL;
 
 
   fd = accept (self->main_socket, NULL, NULL);
@@ -820,6 +1938,21 @@ sp_writer_accept_client (ShmPipe * self)
     return NULL;
   }
 
+  if (self->use_ring || self->use_fds) {
+    with_caps = malloc (pathlen + sizeof (SHM_RING_CAPS) +
+        sizeof (SHM_FDS_CAPS));
+    memcpy (with_caps, path, pathlen);
+    if (self->use_ring) {
+      memcpy (with_caps + pathlen, SHM_RING_CAPS, sizeof (SHM_RING_CAPS));
+      pathlen += sizeof (SHM_RING_CAPS);
+    }
+    if (self->use_fds) {
+      memcpy (with_caps + pathlen, SHM_FDS_CAPS, sizeof (SHM_FDS_CAPS));
+      pathlen += sizeof (SHM_FDS_CAPS);
+    }
+    path = with_caps;
+  }
+
   cb.payload.new_shm_area.size = self->shm_area->shm_area_len;
   cb.payload.new_shm_area.path_size = pathlen;
   if (!send_command (fd, &cb, COMMAND_NEW_SHM_AREA, self->shm_area->id)) {
@@ -827,13 +1960,15 @@ sp_writer_accept_client (ShmPipe * self)
     goto error;
   }
 
-  if (send (fd, self->shm_area->shm_area_name, pathlen, MSG_NOSIGNAL) !=
-      pathlen) {
+  if (send (fd, path, pathlen, MSG_NOSIGNAL) != pathlen) {
     fprintf (stderr, "Sending new shm area path failed: %s", strerror (errno));
     goto error;
   }
 
+  free (with_caps);
+
   client = spalloc_new (ShmClient);
+  memset (client, 0, sizeof (ShmClient));
   client->fd = fd;
 
   /* Prepend ot linked list */
@@ -844,6 +1979,7 @@ sp_writer_accept_client (ShmPipe * self)
   return client;
 
 error:
+  free (with_caps);
   shutdown (fd, SHUT_RDWR);
   close (fd);
   return NULL;
@@ -881,8 +2017,10 @@ sp_shmbuf_dec (ShmPipe * self, ShmBuffer * buf, ShmBuffer * prev_buf,
 
     if (tag)
       *tag = buf->tag;
-    shm_alloc_space_block_dec (buf->ablock);
-    sp_shm_area_dec (self, buf->shm_area);
+    if (buf->shm_area) {
+      shm_alloc_space_block_dec (buf->ablock);
+      sp_shm_area_dec (self, buf->shm_area);
+    }
     spalloc_free1 (sizeof (ShmBuffer) + sizeof (int) * buf->num_clients, buf);
     return 0;
   }
@@ -931,6 +2069,9 @@ again:
 
   self->num_clients--;
 
+  if (client->ring)
+    sp_ring_close (client->ring);
+
   spalloc_free (ShmClient, client);
 }
 
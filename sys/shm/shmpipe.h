@@ -56,6 +56,24 @@
  * buffers are no longer valid. If was valid buffer was received, the
  * client must release it with sp_client_recv_finish() when it is done
  * reading from it.
+ *
+ * If the writer enabled rings with sp_writer_enable_ring(), new
+ * clients get their buffers through a ring in shared memory instead of
+ * one message per buffer on the socket. The client must then call
+ * sp_client_prepare_wait() before select()ing, if it returns 1 there
+ * is a buffer to read with sp_client_recv() already. The writer gets
+ * the buffers released through the rings with sp_writer_reap_ring(),
+ * it must call it before sending and before waiting for buffers to be
+ * released, asking for a wakeup on the client fd in the second case,
+ * and every time sp_writer_recv() succeeded.
+ *
+ * If the writer enabled fd passing with sp_writer_enable_fds(), it can
+ * send buffers that live in memory of their own with
+ * sp_writer_send_fd() to clients that asked for it with
+ * sp_client_enable_fds() before the first sp_client_recv_fd(). Such a
+ * client gets them from sp_client_recv_fd() with a NULL buffer and a
+ * new fd it owns in the ShmFdBuffer, and releases them with
+ * sp_client_recv_finish_fd().
  */
 
 
@@ -80,6 +98,20 @@ typedef struct _ShmBuffer ShmBuffer;
 
 typedef void (*sp_buffer_free_callback) (void * tag, void * user_data);
 
+/* The fd is a DMABuf */
+#define SP_FD_DMABUF (1 << 0)
+
+typedef struct _ShmFdBuffer ShmFdBuffer;
+
+struct _ShmFdBuffer
+{
+  int fd;
+  int id;
+  unsigned int flags;
+  size_t fd_size;
+  unsigned long offset;
+};
+
 ShmPipe *sp_writer_create (const char *path, size_t size, mode_t perms);
 const char *sp_writer_get_path (ShmPipe *pipe);
 void sp_writer_close (ShmPipe * self, sp_buffer_free_callback callback,
@@ -97,6 +129,8 @@ int sp_writer_get_client_fd (ShmClient * client);
 ShmBlock *sp_writer_alloc_block (ShmPipe * self, size_t size);
 void sp_writer_free_block (ShmBlock *block);
 int sp_writer_send_buf (ShmPipe * self, char *buf, size_t size, void * tag);
+int sp_writer_send_fd (ShmPipe * self, int fd, size_t fd_size,
+    unsigned int flags, unsigned long offset, size_t size, void * tag);
 char *sp_writer_block_get_buf (ShmBlock *block);
 ShmPipe *sp_writer_block_get_pipe (ShmBlock *block);
 size_t sp_writer_get_max_buf_size (ShmPipe * self);
@@ -105,6 +139,11 @@ ShmClient * sp_writer_accept_client (ShmPipe * self);
 void sp_writer_close_client (ShmPipe *self, ShmClient * client,
     sp_buffer_free_callback callback, void * user_data);
 int sp_writer_recv (ShmPipe * self, ShmClient * client, void ** tag);
+void sp_writer_enable_ring (ShmPipe * self, int enable);
+void sp_writer_enable_fds (ShmPipe * self, int enable);
+int sp_writer_clients_want_fds (ShmPipe * self);
+int sp_writer_reap_ring (ShmPipe * self, int want_wakeup,
+    sp_buffer_free_callback callback, void * user_data);
 
 int sp_writer_pending_writes (ShmPipe * self);
 
@@ -115,6 +154,10 @@ void *sp_writer_buf_get_tag (ShmBuffer * buffer);
 ShmPipe *sp_client_open (const char *path);
 long int sp_client_recv (ShmPipe * self, char **buf);
 int sp_client_recv_finish (ShmPipe * self, char *buf);
+void sp_client_enable_fds (ShmPipe * self, int enable);
+long int sp_client_recv_fd (ShmPipe * self, char **buf, ShmFdBuffer * fdbuf);
+int sp_client_recv_finish_fd (ShmPipe * self, ShmFdBuffer * fdbuf);
+int sp_client_prepare_wait (ShmPipe * self);
 void sp_client_close (ShmPipe * self);
 
 #ifdef __cplusplus
@@ -43,6 +43,7 @@ struct _GstV4l2CodecAllocator
 
   GQueue pool;
   gint pool_size;
+  gint max_pool_size;
   gboolean detached;
 
   GCond buffer_cond;
@@ -251,6 +252,7 @@ gst_v4l2_codec_allocator_new (GstV4l2Decoder * decoder,
   self->decoder = g_object_ref (decoder);
   self->direction = direction;
   self->pool_size = num_buffers;
+  self->max_pool_size = num_buffers;
 
   if (!gst_v4l2_codec_allocator_prepare (self)) {
     g_object_unref (self);
@@ -260,6 +262,32 @@ gst_v4l2_codec_allocator_new (GstV4l2Decoder * decoder,
   return self;
 }
 
+/* Like gst_v4l2_codec_allocator_new(), but only @num_buffers are allocated
+ * upfront, more are created on demand up to @max_buffers. If the driver
+ * does not support VIDIOC_CREATE_BUFS, @max_buffers are allocated
+ * upfront. */
+GstV4l2CodecAllocator *
+gst_v4l2_codec_allocator_new_growable (GstV4l2Decoder * decoder,
+    GstPadDirection direction, guint num_buffers, guint max_buffers)
+{
+  GstV4l2CodecAllocator *self;
+
+  max_buffers = MAX (num_buffers, max_buffers);
+
+  if (num_buffers < max_buffers &&
+      gst_v4l2_decoder_create_buffers (decoder, direction, 0) < 0) {
+    GST_INFO_OBJECT (decoder, "Driver cannot grow its queue, allocating "
+        "%u buffers upfront", max_buffers);
+    num_buffers = max_buffers;
+  }
+
+  self = gst_v4l2_codec_allocator_new (decoder, direction, num_buffers);
+  if (self)
+    self->max_pool_size = max_buffers;
+
+  return self;
+}
+
 GstMemory *
 gst_v4l2_codec_allocator_alloc (GstV4l2CodecAllocator * self)
 {
@@ -283,7 +311,38 @@ gst_v4l2_codec_allocator_alloc (GstV4l2CodecAllocator * self)
 gboolean
 gst_v4l2_codec_allocator_create_buffer (GstV4l2CodecAllocator * self)
 {
-  /* TODO implement */
+  GstV4l2CodecBuffer *buf;
+  gint index;
+
+  GST_OBJECT_LOCK (self);
+
+  if (self->detached || self->pool_size >= self->max_pool_size)
+    goto failed;
+
+  index = gst_v4l2_decoder_create_buffers (self->decoder, self->direction, 1);
+  if (index < 0)
+    goto failed;
+
+  buf = gst_v4l2_codec_buffer_new (GST_ALLOCATOR (self), self->decoder,
+      self->direction, index);
+  if (!buf) {
+    /* The driver still owns it and releases it along with the others */
+    self->max_pool_size = self->pool_size;
+    goto failed;
+  }
+
+  self->pool_size++;
+  g_queue_push_tail (&self->pool, buf);
+
+  GST_DEBUG_OBJECT (self, "Grew pool to %i buffers (max %i)", self->pool_size,
+      self->max_pool_size);
+
+  GST_OBJECT_UNLOCK (self);
+
+  return TRUE;
+
+failed:
+  GST_OBJECT_UNLOCK (self);
   return FALSE;
 }
 
@@ -36,6 +36,11 @@ GstV4l2CodecAllocator  *gst_v4l2_codec_allocator_new (GstV4l2Decoder * decoder,
                                                       GstPadDirection direction,
                                                       guint num_buffers);
 
+GstV4l2CodecAllocator  *gst_v4l2_codec_allocator_new_growable (GstV4l2Decoder * decoder,
+                                                               GstPadDirection direction,
+                                                               guint num_buffers,
+                                                               guint max_buffers);
+
 GstMemory              *gst_v4l2_codec_allocator_alloc (GstV4l2CodecAllocator * allocator);
 
 
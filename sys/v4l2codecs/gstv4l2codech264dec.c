@@ -73,6 +73,7 @@ struct _GstV4l2CodecH264Dec
   GstV4l2CodecAllocator *src_allocator;
   GstV4l2CodecPool *src_pool;
   gint min_pool_size;
+  gint start_pool_size;
   gboolean has_videometa;
   gboolean need_negotiation;
   gboolean interlaced;
@@ -422,8 +423,9 @@ gst_v4l2_codec_h264_dec_decide_allocation (GstVideoDecoder * decoder,
 
   self->sink_allocator = gst_v4l2_codec_allocator_new (self->decoder,
       GST_PAD_SINK, num_bitstream);
-  self->src_allocator = gst_v4l2_codec_allocator_new (self->decoder,
-      GST_PAD_SRC, self->min_pool_size + min + 4);
+  self->src_allocator = gst_v4l2_codec_allocator_new_growable (self->decoder,
+      GST_PAD_SRC, self->start_pool_size + min + 4,
+      self->min_pool_size + min + 4);
   self->src_pool = gst_v4l2_codec_pool_new (self->src_allocator, &self->vinfo);
 
   /* Our buffer pool is internal, we will let the base class create a video
@@ -762,12 +764,19 @@ gst_v4l2_codec_h264_dec_new_sequence (GstH264Decoder * decoder,
   if (self->vinfo.finfo->format == GST_VIDEO_FORMAT_UNKNOWN)
     negotiation_needed = TRUE;
 
-  /* TODO check if CREATE_BUFS is supported, and simply grow the pool */
   if (self->min_pool_size < max_dpb_size) {
     self->min_pool_size = max_dpb_size;
     negotiation_needed = TRUE;
   }
 
+  /* Start with what the references need, or what the previous sequence
+   * actually used, the allocator grows up to the DPB size if the driver
+   * allows it */
+  self->start_pool_size = MAX (sps->num_ref_frames, 1) + 1;
+  self->start_pool_size = MAX (self->start_pool_size,
+      gst_h264_decoder_get_max_pictures_in_use (decoder));
+  self->start_pool_size = MIN (self->start_pool_size, self->min_pool_size);
+
   if (sps->frame_cropping_flag) {
     crop_width = sps->crop_rect_width;
     crop_height = sps->crop_rect_height;
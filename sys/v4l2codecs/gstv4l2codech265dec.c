@@ -0,0 +1,1446 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "gstv4l2codecallocator.h"
+#include "gstv4l2codech265dec.h"
+#include "gstv4l2codecpool.h"
+#include "linux/v4l2-controls.h"
+#include "linux/hevc-ctrls.h"
+
+#define KERNEL_VERSION(a,b,c) (((a) << 16) + ((b) << 8) + (c))
+
+#define V4L2_MIN_KERNEL_VER_MAJOR 6
+#define V4L2_MIN_KERNEL_VER_MINOR 0
+#define V4L2_MIN_KERNEL_VERSION KERNEL_VERSION(V4L2_MIN_KERNEL_VER_MAJOR, V4L2_MIN_KERNEL_VER_MINOR, 0)
+
+GST_DEBUG_CATEGORY_STATIC (v4l2_h265dec_debug);
+#define GST_CAT_DEFAULT v4l2_h265dec_debug
+
+enum
+{
+  PROP_0,
+  PROP_LAST = PROP_0
+};
+
+static GstStaticPadTemplate sink_template =
+GST_STATIC_PAD_TEMPLATE (GST_VIDEO_DECODER_SINK_NAME,
+    GST_PAD_SINK, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-h265, "
+        "stream-format=(string) { hvc1, hev1, byte-stream }, "
+        "alignment=(string) au")
+    );
+
+static GstStaticPadTemplate src_template =
+GST_STATIC_PAD_TEMPLATE (GST_VIDEO_DECODER_SRC_NAME,
+    GST_PAD_SRC, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE ("{ NV12, YUY2, NV12_32L32 }")));
+
+struct _GstV4l2CodecH265Dec
+{
+  GstH265Decoder parent;
+  GstV4l2Decoder *decoder;
+  GstVideoCodecState *output_state;
+  GstVideoInfo vinfo;
+  gint display_width;
+  gint display_height;
+  gint coded_width;
+  gint coded_height;
+  guint bitdepth;
+  guint chroma_format_idc;
+  guint num_slices;
+  gboolean first_slice;
+
+  GstV4l2CodecAllocator *sink_allocator;
+  GstV4l2CodecAllocator *src_allocator;
+  GstV4l2CodecPool *src_pool;
+  gint min_pool_size;
+  gint start_pool_size;
+  gboolean has_videometa;
+  gboolean need_negotiation;
+  gboolean need_sequence;
+  gboolean copy_frames;
+  gboolean need_slice_params;
+  gboolean scaling_matrix_present;
+
+  struct v4l2_ctrl_hevc_sps sps;
+  struct v4l2_ctrl_hevc_pps pps;
+  struct v4l2_ctrl_hevc_scaling_matrix scaling_matrix;
+  struct v4l2_ctrl_hevc_decode_params decode_params;
+  GArray *slice_params;
+
+  enum v4l2_stateless_hevc_decode_mode decode_mode;
+  enum v4l2_stateless_hevc_start_code start_code;
+
+  GstMemory *bitstream;
+  GstMapInfo bitstream_map;
+};
+
+G_DEFINE_ABSTRACT_TYPE_WITH_CODE (GstV4l2CodecH265Dec,
+    gst_v4l2_codec_h265_dec, GST_TYPE_H265_DECODER,
+    GST_DEBUG_CATEGORY_INIT (v4l2_h265dec_debug, "v4l2codecs-h265dec", 0,
+        "V4L2 stateless h265 decoder"));
+#define parent_class gst_v4l2_codec_h265_dec_parent_class
+
+static gboolean
+is_frame_based (GstV4l2CodecH265Dec * self)
+{
+  return self->decode_mode == V4L2_STATELESS_HEVC_DECODE_MODE_FRAME_BASED;
+}
+
+static gboolean
+is_slice_based (GstV4l2CodecH265Dec * self)
+{
+  return self->decode_mode == V4L2_STATELESS_HEVC_DECODE_MODE_SLICE_BASED;
+}
+
+static gboolean
+needs_start_codes (GstV4l2CodecH265Dec * self)
+{
+  return self->start_code == V4L2_STATELESS_HEVC_START_CODE_ANNEX_B;
+}
+
+static gboolean
+gst_v4l2_decoder_h265_api_check (GstV4l2CodecH265Dec * self)
+{
+  guint i, ret_size;
+  /* *INDENT-OFF* */
+  struct
+  {
+    unsigned int id;
+    unsigned int size;
+  } controls[] = {
+    {
+      .id = V4L2_CID_STATELESS_HEVC_SPS,
+      .size = sizeof(struct v4l2_ctrl_hevc_sps),
+    }, {
+      .id = V4L2_CID_STATELESS_HEVC_PPS,
+      .size = sizeof(struct v4l2_ctrl_hevc_pps),
+    }, {
+      .id = V4L2_CID_STATELESS_HEVC_SCALING_MATRIX,
+      .size = sizeof(struct v4l2_ctrl_hevc_scaling_matrix),
+    }, {
+      .id = V4L2_CID_STATELESS_HEVC_DECODE_PARAMS,
+      .size = sizeof(struct v4l2_ctrl_hevc_decode_params),
+    }, {
+      .id = V4L2_CID_STATELESS_HEVC_SLICE_PARAMS,
+      .size = sizeof(struct v4l2_ctrl_hevc_slice_params),
+    }
+  };
+  /* *INDENT-ON* */
+
+  /*
+   * Compatibility check: make sure the pointer controls are
+   * the right size.
+   */
+  for (i = 0; i < G_N_ELEMENTS (controls); i++) {
+    if (gst_v4l2_decoder_query_control_size (self->decoder, controls[i].id,
+            &ret_size) && ret_size != controls[i].size) {
+      GST_ELEMENT_ERROR (self, RESOURCE, OPEN_READ_WRITE,
+          ("H265 API mismatch!"),
+          ("%d control size mismatch: got %d bytes but %d expected.",
+              controls[i].id, ret_size, controls[i].size));
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+static gboolean
+gst_v4l2_codec_h265_dec_open (GstVideoDecoder * decoder)
+{
+  GstV4l2CodecH265Dec *self = GST_V4L2_CODEC_H265_DEC (decoder);
+  guint version, ret_size;
+
+  /* *INDENT-OFF* */
+  struct v4l2_ext_control control[] = {
+    {
+      .id = V4L2_CID_STATELESS_HEVC_DECODE_MODE,
+    },
+    {
+      .id = V4L2_CID_STATELESS_HEVC_START_CODE,
+    },
+  };
+  /* *INDENT-ON* */
+
+  if (!gst_v4l2_decoder_open (self->decoder)) {
+    GST_ELEMENT_ERROR (self, RESOURCE, OPEN_READ_WRITE,
+        ("Failed to open H265 decoder"),
+        ("gst_v4l2_decoder_open() failed: %s", g_strerror (errno)));
+    return FALSE;
+  }
+
+  version = gst_v4l2_decoder_get_version (self->decoder);
+  if (version < V4L2_MIN_KERNEL_VERSION)
+    GST_WARNING_OBJECT (self,
+        "V4L2 API v%u.%u too old, at least v%u.%u required",
+        (version >> 16) & 0xff, (version >> 8) & 0xff,
+        V4L2_MIN_KERNEL_VER_MAJOR, V4L2_MIN_KERNEL_VER_MINOR);
+
+  if (!gst_v4l2_decoder_h265_api_check (self)) {
+    GST_ELEMENT_ERROR (self, RESOURCE, OPEN_READ_WRITE,
+        ("Failed to open H265 decoder"),
+        ("gst_v4l2_decoder_h265_api_check() failed"));
+    return FALSE;
+  }
+
+  if (!gst_v4l2_decoder_get_controls (self->decoder, control,
+          G_N_ELEMENTS (control))) {
+    GST_ELEMENT_ERROR (self, RESOURCE, OPEN_READ_WRITE,
+        ("Driver did not report framing and start code method."),
+        ("gst_v4l2_decoder_get_controls() failed: %s", g_strerror (errno)));
+    return FALSE;
+  }
+
+  self->decode_mode = control[0].value;
+  self->start_code = control[1].value;
+
+  /* Frame based drivers may still want the parameters of each slice of
+   * the frame, they are passed whenever the driver exposes the control */
+  self->need_slice_params = is_slice_based (self) ||
+      gst_v4l2_decoder_query_control_size (self->decoder,
+      V4L2_CID_STATELESS_HEVC_SLICE_PARAMS, &ret_size);
+
+  GST_INFO_OBJECT (self, "Opened H265 %s decoder %s",
+      is_frame_based (self) ? "frame based" : "slice based",
+      needs_start_codes (self) ? "using start-codes" : "without start-codes");
+  gst_h265_decoder_set_process_ref_pic_lists (GST_H265_DECODER (self),
+      self->need_slice_params);
+
+  return TRUE;
+}
+
+static gboolean
+gst_v4l2_codec_h265_dec_close (GstVideoDecoder * decoder)
+{
+  GstV4l2CodecH265Dec *self = GST_V4L2_CODEC_H265_DEC (decoder);
+  gst_v4l2_decoder_close (self->decoder);
+  return TRUE;
+}
+
+static void
+gst_v4l2_codec_h265_dec_reset_allocation (GstV4l2CodecH265Dec * self)
+{
+  if (self->sink_allocator) {
+    gst_v4l2_codec_allocator_detach (self->sink_allocator);
+    g_clear_object (&self->sink_allocator);
+  }
+
+  if (self->src_allocator) {
+    gst_v4l2_codec_allocator_detach (self->src_allocator);
+    g_clear_object (&self->src_allocator);
+    g_clear_object (&self->src_pool);
+  }
+}
+
+static gboolean
+gst_v4l2_codec_h265_dec_stop (GstVideoDecoder * decoder)
+{
+  GstV4l2CodecH265Dec *self = GST_V4L2_CODEC_H265_DEC (decoder);
+
+  gst_v4l2_decoder_streamoff (self->decoder, GST_PAD_SINK);
+  gst_v4l2_decoder_streamoff (self->decoder, GST_PAD_SRC);
+
+  gst_v4l2_codec_h265_dec_reset_allocation (self);
+
+  if (self->output_state)
+    gst_video_codec_state_unref (self->output_state);
+  self->output_state = NULL;
+
+  return GST_VIDEO_DECODER_CLASS (parent_class)->stop (decoder);
+}
+
+static gint
+get_pixel_bitdepth (GstV4l2CodecH265Dec * self)
+{
+  gint depth;
+
+  switch (self->chroma_format_idc) {
+    case 0:
+      /* 4:0:0 */
+      depth = self->bitdepth;
+      break;
+    case 1:
+      /* 4:2:0 */
+      depth = self->bitdepth + self->bitdepth / 2;
+      break;
+    case 2:
+      /* 4:2:2 */
+      depth = 2 * self->bitdepth;
+      break;
+    case 3:
+      /* 4:4:4 */
+      depth = 3 * self->bitdepth;
+      break;
+    default:
+      GST_WARNING_OBJECT (self, "Unsupported chroma format %i",
+          self->chroma_format_idc);
+      depth = 0;
+      break;
+  }
+
+  return depth;
+}
+
+static gboolean
+gst_v4l2_codec_h265_dec_negotiate (GstVideoDecoder * decoder)
+{
+  GstV4l2CodecH265Dec *self = GST_V4L2_CODEC_H265_DEC (decoder);
+  GstH265Decoder *h265dec = GST_H265_DECODER (decoder);
+  /* *INDENT-OFF* */
+  struct v4l2_ext_control control[] = {
+    {
+      .id = V4L2_CID_STATELESS_HEVC_SPS,
+      .ptr = &self->sps,
+      .size = sizeof (self->sps),
+    },
+  };
+  /* *INDENT-ON* */
+  GstCaps *filter, *caps;
+
+  /* Ignore downstream renegotiation request. */
+  if (!self->need_negotiation)
+    return TRUE;
+  self->need_negotiation = FALSE;
+
+  GST_DEBUG_OBJECT (self, "Negotiate");
+
+  gst_v4l2_codec_h265_dec_reset_allocation (self);
+
+  gst_v4l2_decoder_streamoff (self->decoder, GST_PAD_SINK);
+  gst_v4l2_decoder_streamoff (self->decoder, GST_PAD_SRC);
+
+  if (!gst_v4l2_decoder_set_sink_fmt (self->decoder, V4L2_PIX_FMT_HEVC_SLICE,
+          self->coded_width, self->coded_height, get_pixel_bitdepth (self))) {
+    GST_ELEMENT_ERROR (self, CORE, NEGOTIATION,
+        ("Failed to configure H265 decoder"),
+        ("gst_v4l2_decoder_set_sink_fmt() failed: %s", g_strerror (errno)));
+    gst_v4l2_decoder_close (self->decoder);
+    return FALSE;
+  }
+
+  if (!gst_v4l2_decoder_set_controls (self->decoder, NULL, control,
+          G_N_ELEMENTS (control))) {
+    GST_ELEMENT_ERROR (decoder, RESOURCE, WRITE,
+        ("Driver does not support the selected stream."), (NULL));
+    return FALSE;
+  }
+
+  filter = gst_v4l2_decoder_enum_src_formats (self->decoder);
+  if (!filter) {
+    GST_ELEMENT_ERROR (self, CORE, NEGOTIATION,
+        ("No supported decoder output formats"), (NULL));
+    return FALSE;
+  }
+  GST_DEBUG_OBJECT (self, "Supported output formats: %" GST_PTR_FORMAT, filter);
+
+  caps = gst_pad_peer_query_caps (decoder->srcpad, filter);
+  gst_caps_unref (filter);
+  GST_DEBUG_OBJECT (self, "Peer supported formats: %" GST_PTR_FORMAT, caps);
+
+  if (!gst_v4l2_decoder_select_src_format (self->decoder, caps, &self->vinfo)) {
+    GST_ELEMENT_ERROR (self, CORE, NEGOTIATION,
+        ("Unsupported bitdepth/chroma format"),
+        ("No support for %ux%u %ubit chroma IDC %i", self->coded_width,
+            self->coded_height, self->bitdepth, self->chroma_format_idc));
+    gst_caps_unref (caps);
+    return FALSE;
+  }
+  gst_caps_unref (caps);
+
+  if (self->output_state)
+    gst_video_codec_state_unref (self->output_state);
+
+  self->output_state =
+      gst_video_decoder_set_output_state (GST_VIDEO_DECODER (self),
+      self->vinfo.finfo->format, self->display_width,
+      self->display_height, h265dec->input_state);
+
+  self->output_state->caps = gst_video_info_to_caps (&self->output_state->info);
+
+  if (GST_VIDEO_DECODER_CLASS (parent_class)->negotiate (decoder)) {
+    if (!gst_v4l2_decoder_streamon (self->decoder, GST_PAD_SINK)) {
+      GST_ELEMENT_ERROR (self, RESOURCE, FAILED,
+          ("Could not enable the decoder driver."),
+          ("VIDIOC_STREAMON(SINK) failed: %s", g_strerror (errno)));
+      return FALSE;
+    }
+
+    if (!gst_v4l2_decoder_streamon (self->decoder, GST_PAD_SRC)) {
+      GST_ELEMENT_ERROR (self, RESOURCE, FAILED,
+          ("Could not enable the decoder driver."),
+          ("VIDIOC_STREAMON(SRC) failed: %s", g_strerror (errno)));
+      return FALSE;
+    }
+
+    return TRUE;
+  }
+
+  return FALSE;
+}
+
+static gboolean
+gst_v4l2_codec_h265_dec_decide_allocation (GstVideoDecoder * decoder,
+    GstQuery * query)
+{
+  GstV4l2CodecH265Dec *self = GST_V4L2_CODEC_H265_DEC (decoder);
+  guint min = 0, num_bitstream;
+
+  self->has_videometa = gst_query_find_allocation_meta (query,
+      GST_VIDEO_META_API_TYPE, NULL);
+
+  g_clear_object (&self->src_pool);
+  g_clear_object (&self->src_allocator);
+
+  if (gst_query_get_n_allocation_pools (query) > 0)
+    gst_query_parse_nth_allocation_pool (query, 0, NULL, NULL, &min, NULL);
+
+  min = MAX (2, min);
+
+  num_bitstream = 1 +
+      MAX (1, gst_v4l2_decoder_get_render_delay (self->decoder));
+
+  self->sink_allocator = gst_v4l2_codec_allocator_new (self->decoder,
+      GST_PAD_SINK, num_bitstream);
+  self->src_allocator = gst_v4l2_codec_allocator_new_growable (self->decoder,
+      GST_PAD_SRC, self->start_pool_size + min + 4,
+      self->min_pool_size + min + 4);
+  self->src_pool = gst_v4l2_codec_pool_new (self->src_allocator, &self->vinfo);
+
+  /* Our buffer pool is internal, we will let the base class create a video
+   * pool, and use it if we are running out of buffers or if downstream does
+   * not support GstVideoMeta */
+  return GST_VIDEO_DECODER_CLASS (parent_class)->decide_allocation
+      (decoder, query);
+}
+
+static void
+gst_v4l2_codec_h265_dec_fill_sequence (GstV4l2CodecH265Dec * self,
+    const GstH265SPS * sps)
+{
+  guint max_sub_layers_minus1 = sps->max_sub_layers_minus1;
+
+  /* *INDENT-OFF* */
+  self->sps = (struct v4l2_ctrl_hevc_sps) {
+    .video_parameter_set_id = sps->vps ? sps->vps->id : 0,
+    .seq_parameter_set_id = sps->id,
+    .pic_width_in_luma_samples = sps->pic_width_in_luma_samples,
+    .pic_height_in_luma_samples = sps->pic_height_in_luma_samples,
+    .bit_depth_luma_minus8 = sps->bit_depth_luma_minus8,
+    .bit_depth_chroma_minus8 = sps->bit_depth_chroma_minus8,
+    .log2_max_pic_order_cnt_lsb_minus4 = sps->log2_max_pic_order_cnt_lsb_minus4,
+    .sps_max_dec_pic_buffering_minus1 = sps->max_dec_pic_buffering_minus1[max_sub_layers_minus1],
+    .sps_max_num_reorder_pics = sps->max_num_reorder_pics[max_sub_layers_minus1],
+    .sps_max_latency_increase_plus1 = sps->max_latency_increase_plus1[max_sub_layers_minus1],
+    .log2_min_luma_coding_block_size_minus3 = sps->log2_min_luma_coding_block_size_minus3,
+    .log2_diff_max_min_luma_coding_block_size = sps->log2_diff_max_min_luma_coding_block_size,
+    .log2_min_luma_transform_block_size_minus2 = sps->log2_min_transform_block_size_minus2,
+    .log2_diff_max_min_luma_transform_block_size = sps->log2_diff_max_min_transform_block_size,
+    .max_transform_hierarchy_depth_inter = sps->max_transform_hierarchy_depth_inter,
+    .max_transform_hierarchy_depth_intra = sps->max_transform_hierarchy_depth_intra,
+    .pcm_sample_bit_depth_luma_minus1 = sps->pcm_sample_bit_depth_luma_minus1,
+    .pcm_sample_bit_depth_chroma_minus1 = sps->pcm_sample_bit_depth_chroma_minus1,
+    .log2_min_pcm_luma_coding_block_size_minus3 = sps->log2_min_pcm_luma_coding_block_size_minus3,
+    .log2_diff_max_min_pcm_luma_coding_block_size = sps->log2_diff_max_min_pcm_luma_coding_block_size,
+    .num_short_term_ref_pic_sets = sps->num_short_term_ref_pic_sets,
+    .num_long_term_ref_pics_sps = sps->num_long_term_ref_pics_sps,
+    .chroma_format_idc = sps->chroma_format_idc,
+    .sps_max_sub_layers_minus1 = sps->max_sub_layers_minus1,
+    .flags = (sps->separate_colour_plane_flag ? V4L2_HEVC_SPS_FLAG_SEPARATE_COLOUR_PLANE : 0)
+        | (sps->scaling_list_enabled_flag ? V4L2_HEVC_SPS_FLAG_SCALING_LIST_ENABLED : 0)
+        | (sps->amp_enabled_flag ? V4L2_HEVC_SPS_FLAG_AMP_ENABLED : 0)
+        | (sps->sample_adaptive_offset_enabled_flag ? V4L2_HEVC_SPS_FLAG_SAMPLE_ADAPTIVE_OFFSET : 0)
+        | (sps->pcm_enabled_flag ? V4L2_HEVC_SPS_FLAG_PCM_ENABLED : 0)
+        | (sps->pcm_loop_filter_disabled_flag ? V4L2_HEVC_SPS_FLAG_PCM_LOOP_FILTER_DISABLED : 0)
+        | (sps->long_term_ref_pics_present_flag ? V4L2_HEVC_SPS_FLAG_LONG_TERM_REF_PICS_PRESENT : 0)
+        | (sps->temporal_mvp_enabled_flag ? V4L2_HEVC_SPS_FLAG_SPS_TEMPORAL_MVP_ENABLED : 0)
+        | (sps->strong_intra_smoothing_enabled_flag ? V4L2_HEVC_SPS_FLAG_STRONG_INTRA_SMOOTHING_ENABLED : 0),
+  };
+  /* *INDENT-ON* */
+}
+
+static void
+gst_v4l2_codec_h265_dec_fill_pps (GstV4l2CodecH265Dec * self, GstH265PPS * pps)
+{
+  gint i;
+
+  /* *INDENT-OFF* */
+  self->pps = (struct v4l2_ctrl_hevc_pps) {
+    .pic_parameter_set_id = pps->id,
+    .num_extra_slice_header_bits = pps->num_extra_slice_header_bits,
+    .num_ref_idx_l0_default_active_minus1 = pps->num_ref_idx_l0_default_active_minus1,
+    .num_ref_idx_l1_default_active_minus1 = pps->num_ref_idx_l1_default_active_minus1,
+    .init_qp_minus26 = pps->init_qp_minus26,
+    .diff_cu_qp_delta_depth = pps->diff_cu_qp_delta_depth,
+    .pps_cb_qp_offset = pps->cb_qp_offset,
+    .pps_cr_qp_offset = pps->cr_qp_offset,
+    .num_tile_columns_minus1 = pps->num_tile_columns_minus1,
+    .num_tile_rows_minus1 = pps->num_tile_rows_minus1,
+    .pps_beta_offset_div2 = pps->beta_offset_div2,
+    .pps_tc_offset_div2 = pps->tc_offset_div2,
+    .log2_parallel_merge_level_minus2 = pps->log2_parallel_merge_level_minus2,
+    .flags = 0
+        | (pps->dependent_slice_segments_enabled_flag ? V4L2_HEVC_PPS_FLAG_DEPENDENT_SLICE_SEGMENT_ENABLED : 0)
+        | (pps->output_flag_present_flag ? V4L2_HEVC_PPS_FLAG_OUTPUT_FLAG_PRESENT : 0)
+        | (pps->sign_data_hiding_enabled_flag ? V4L2_HEVC_PPS_FLAG_SIGN_DATA_HIDING_ENABLED : 0)
+        | (pps->cabac_init_present_flag ? V4L2_HEVC_PPS_FLAG_CABAC_INIT_PRESENT : 0)
+        | (pps->constrained_intra_pred_flag ? V4L2_HEVC_PPS_FLAG_CONSTRAINED_INTRA_PRED : 0)
+        | (pps->transform_skip_enabled_flag ? V4L2_HEVC_PPS_FLAG_TRANSFORM_SKIP_ENABLED : 0)
+        | (pps->cu_qp_delta_enabled_flag ? V4L2_HEVC_PPS_FLAG_CU_QP_DELTA_ENABLED : 0)
+        | (pps->slice_chroma_qp_offsets_present_flag ? V4L2_HEVC_PPS_FLAG_PPS_SLICE_CHROMA_QP_OFFSETS_PRESENT : 0)
+        | (pps->weighted_pred_flag ? V4L2_HEVC_PPS_FLAG_WEIGHTED_PRED : 0)
+        | (pps->weighted_bipred_flag ? V4L2_HEVC_PPS_FLAG_WEIGHTED_BIPRED : 0)
+        | (pps->transquant_bypass_enabled_flag ? V4L2_HEVC_PPS_FLAG_TRANSQUANT_BYPASS_ENABLED : 0)
+        | (pps->tiles_enabled_flag ? V4L2_HEVC_PPS_FLAG_TILES_ENABLED : 0)
+        | (pps->entropy_coding_sync_enabled_flag ? V4L2_HEVC_PPS_FLAG_ENTROPY_CODING_SYNC_ENABLED : 0)
+        | (pps->loop_filter_across_tiles_enabled_flag ? V4L2_HEVC_PPS_FLAG_LOOP_FILTER_ACROSS_TILES_ENABLED : 0)
+        | (pps->loop_filter_across_slices_enabled_flag ? V4L2_HEVC_PPS_FLAG_PPS_LOOP_FILTER_ACROSS_SLICES_ENABLED : 0)
+        | (pps->deblocking_filter_override_enabled_flag ? V4L2_HEVC_PPS_FLAG_DEBLOCKING_FILTER_OVERRIDE_ENABLED : 0)
+        | (pps->deblocking_filter_disabled_flag ? V4L2_HEVC_PPS_FLAG_PPS_DISABLE_DEBLOCKING_FILTER : 0)
+        | (pps->lists_modification_present_flag ? V4L2_HEVC_PPS_FLAG_LISTS_MODIFICATION_PRESENT : 0)
+        | (pps->slice_segment_header_extension_present_flag ? V4L2_HEVC_PPS_FLAG_SLICE_SEGMENT_HEADER_EXTENSION_PRESENT : 0)
+        | (pps->deblocking_filter_control_present_flag ? V4L2_HEVC_PPS_FLAG_DEBLOCKING_FILTER_CONTROL_PRESENT : 0)
+        | (pps->uniform_spacing_flag ? V4L2_HEVC_PPS_FLAG_UNIFORM_SPACING : 0),
+  };
+  /* *INDENT-ON* */
+
+  if (pps->tiles_enabled_flag) {
+    for (i = 0; i <= pps->num_tile_columns_minus1; i++)
+      self->pps.column_width_minus1[i] = pps->column_width_minus1[i];
+
+    for (i = 0; i <= pps->num_tile_rows_minus1; i++)
+      self->pps.row_height_minus1[i] = pps->row_height_minus1[i];
+  }
+}
+
+static void
+gst_v4l2_codec_h265_dec_fill_scaling_matrix (GstV4l2CodecH265Dec * self,
+    GstH265PPS * pps)
+{
+  GstH265SPS *sps = pps->sps;
+  GstH265ScalingList *sl = NULL;
+  gint i;
+
+  /* The PPS list overrides the SPS one, and the default lists are set in
+   * the PPS list by the parser when neither carries one */
+  if (pps->scaling_list_data_present_flag ||
+      (sps->scaling_list_enabled_flag && !sps->scaling_list_data_present_flag))
+    sl = &pps->scaling_list;
+  else if (sps->scaling_list_enabled_flag
+      && sps->scaling_list_data_present_flag)
+    sl = &sps->scaling_list;
+
+  self->scaling_matrix_present = (sl != NULL);
+  if (!sl)
+    return;
+
+  for (i = 0; i < G_N_ELEMENTS (self->scaling_matrix.scaling_list_4x4); i++)
+    gst_h265_quant_matrix_4x4_get_raster_from_uprightdiagonal
+        (self->scaling_matrix.scaling_list_4x4[i], sl->scaling_lists_4x4[i]);
+
+  for (i = 0; i < G_N_ELEMENTS (self->scaling_matrix.scaling_list_8x8); i++)
+    gst_h265_quant_matrix_8x8_get_raster_from_uprightdiagonal
+        (self->scaling_matrix.scaling_list_8x8[i], sl->scaling_lists_8x8[i]);
+
+  for (i = 0; i < G_N_ELEMENTS (self->scaling_matrix.scaling_list_16x16); i++)
+    gst_h265_quant_matrix_16x16_get_raster_from_uprightdiagonal
+        (self->scaling_matrix.scaling_list_16x16[i],
+        sl->scaling_lists_16x16[i]);
+
+  for (i = 0; i < G_N_ELEMENTS (self->scaling_matrix.scaling_list_32x32); i++)
+    gst_h265_quant_matrix_32x32_get_raster_from_uprightdiagonal
+        (self->scaling_matrix.scaling_list_32x32[i],
+        sl->scaling_lists_32x32[i]);
+
+  for (i = 0; i < 6; i++)
+    self->scaling_matrix.scaling_list_dc_coef_16x16[i] =
+        sl->scaling_list_dc_coef_minus8_16x16[i] + 8;
+
+  for (i = 0; i < 2; i++)
+    self->scaling_matrix.scaling_list_dc_coef_32x32[i] =
+        sl->scaling_list_dc_coef_minus8_32x32[i] + 8;
+}
+
+static guint8
+lookup_dpb_index (struct v4l2_hevc_dpb_entry dpb[16], guint num_entries,
+    GstH265Picture * ref_pic)
+{
+  guint64 ref_ts;
+  gint i;
+
+  /* Reference list may have holes in case a ref is missing, we should mark
+   * the hole and avoid moving items in the list */
+  if (!ref_pic)
+    return 0xff;
+
+  ref_ts = (guint64) ref_pic->system_frame_number * 1000;
+  for (i = 0; i < num_entries; i++) {
+    if (dpb[i].timestamp == ref_ts)
+      return i;
+  }
+
+  return 0xff;
+}
+
+static void
+gst_v4l2_codec_h265_dec_fill_decoder_params (GstV4l2CodecH265Dec * self,
+    GstH265Slice * slice, GstH265Picture * picture, GstH265Dpb * dpb)
+{
+  GstH265Decoder *decoder = GST_H265_DECODER (self);
+  GstH265SliceHdr *slice_hdr = &slice->header;
+  GArray *refs = gst_h265_dpb_get_pictures_all (dpb);
+  struct v4l2_ctrl_hevc_decode_params *params = &self->decode_params;
+  guint i, num_entries = 0;
+
+  /* *INDENT-OFF* */
+  *params = (struct v4l2_ctrl_hevc_decode_params) {
+    .pic_order_cnt_val = picture->pic_order_cnt,
+    .short_term_ref_pic_set_size = slice_hdr->short_term_ref_pic_set_size,
+    .num_poc_st_curr_before = decoder->NumPocStCurrBefore,
+    .num_poc_st_curr_after = decoder->NumPocStCurrAfter,
+    .num_poc_lt_curr = decoder->NumPocLtCurr,
+    .num_delta_pocs_of_ref_rps_idx = slice_hdr->short_term_ref_pic_set_sps_flag ?
+        0 : slice_hdr->short_term_ref_pic_sets.NumDeltaPocsOfRefRpsIdx,
+    .flags = (picture->RapPicFlag ? V4L2_HEVC_DECODE_PARAM_FLAG_IRAP_PIC : 0)
+        | (GST_H265_IS_NAL_TYPE_IDR (slice->nalu.type) ? V4L2_HEVC_DECODE_PARAM_FLAG_IDR_PIC : 0)
+        | (picture->NoOutputOfPriorPicsFlag ? V4L2_HEVC_DECODE_PARAM_FLAG_NO_OUTPUT_OF_PRIOR : 0),
+  };
+
+  for (i = 0; i < refs->len && num_entries < V4L2_HEVC_DPB_ENTRIES_NUM_MAX; i++) {
+    GstH265Picture *ref_pic = g_array_index (refs, GstH265Picture *, i);
+
+    if (!ref_pic->ref)
+      continue;
+
+    params->dpb[num_entries++] = (struct v4l2_hevc_dpb_entry) {
+      /*
+       * The reference is multiplied by 1000 because it's passed as micro
+       * seconds and this TS is nanosecond.
+       */
+      .timestamp = (guint64) ref_pic->system_frame_number * 1000,
+      .flags = ref_pic->long_term ? V4L2_HEVC_DPB_ENTRY_LONG_TERM_REFERENCE : 0,
+      .field_pic = ref_pic->pic_struct,
+      .pic_order_cnt_val = ref_pic->pic_order_cnt,
+    };
+  }
+  /* *INDENT-ON* */
+
+  params->num_active_dpb_entries = num_entries;
+
+  for (i = 0; i < decoder->NumPocStCurrBefore; i++)
+    params->poc_st_curr_before[i] = lookup_dpb_index (params->dpb,
+        num_entries, decoder->RefPicSetStCurrBefore[i]);
+
+  for (i = 0; i < decoder->NumPocStCurrAfter; i++)
+    params->poc_st_curr_after[i] = lookup_dpb_index (params->dpb,
+        num_entries, decoder->RefPicSetStCurrAfter[i]);
+
+  for (i = 0; i < decoder->NumPocLtCurr; i++)
+    params->poc_lt_curr[i] = lookup_dpb_index (params->dpb,
+        num_entries, decoder->RefPicSetLtCurr[i]);
+
+  g_array_unref (refs);
+}
+
+static void
+gst_v4l2_codec_h265_dec_fill_pred_weight (GstV4l2CodecH265Dec * self,
+    struct v4l2_ctrl_hevc_slice_params *params, GstH265SliceHdr * slice_hdr)
+{
+  struct v4l2_hevc_pred_weight_table *table = &params->pred_weight_table;
+  GstH265PredWeightTable *pwt = &slice_hdr->pred_weight_table;
+  GstH265PPS *pps = slice_hdr->pps;
+  gint i, j;
+
+  if (GST_H265_IS_I_SLICE (slice_hdr) ||
+      (!pps->weighted_pred_flag && GST_H265_IS_P_SLICE (slice_hdr)) ||
+      (!pps->weighted_bipred_flag && GST_H265_IS_B_SLICE (slice_hdr)))
+    return;
+
+  table->luma_log2_weight_denom = pwt->luma_log2_weight_denom;
+  if (pps->sps->chroma_array_type != 0)
+    table->delta_chroma_log2_weight_denom =
+        pwt->delta_chroma_log2_weight_denom;
+
+  for (i = 0; i <= slice_hdr->num_ref_idx_l0_active_minus1; i++) {
+    if (pwt->luma_weight_l0_flag[i]) {
+      table->delta_luma_weight_l0[i] = pwt->delta_luma_weight_l0[i];
+      table->luma_offset_l0[i] = pwt->luma_offset_l0[i];
+    }
+
+    if (pwt->chroma_weight_l0_flag[i]) {
+      for (j = 0; j < 2; j++) {
+        table->delta_chroma_weight_l0[i][j] = pwt->delta_chroma_weight_l0[i][j];
+        table->chroma_offset_l0[i][j] = pwt->delta_chroma_offset_l0[i][j];
+      }
+    }
+  }
+
+  /* Skip l1 if this is not a B-Frame. */
+  if (!GST_H265_IS_B_SLICE (slice_hdr))
+    return;
+
+  for (i = 0; i <= slice_hdr->num_ref_idx_l1_active_minus1; i++) {
+    if (pwt->luma_weight_l1_flag[i]) {
+      table->delta_luma_weight_l1[i] = pwt->delta_luma_weight_l1[i];
+      table->luma_offset_l1[i] = pwt->luma_offset_l1[i];
+    }
+
+    if (pwt->chroma_weight_l1_flag[i]) {
+      for (j = 0; j < 2; j++) {
+        table->delta_chroma_weight_l1[i][j] = pwt->delta_chroma_weight_l1[i][j];
+        table->chroma_offset_l1[i][j] = pwt->delta_chroma_offset_l1[i][j];
+      }
+    }
+  }
+}
+
+static guint
+get_slice_header_byte_offset (GstH265Slice * slice)
+{
+  return slice->nalu.header_bytes + (slice->header.header_size + 7) / 8
+      - slice->header.n_emulation_prevention_bytes;
+}
+
+static void
+gst_v4l2_codec_h265_dec_fill_references (GstV4l2CodecH265Dec * self,
+    guint8 ref_idx[16], GArray * ref_pic_list)
+{
+  gint i = 0;
+
+  if (ref_pic_list) {
+    for (; i < ref_pic_list->len && i < V4L2_HEVC_DPB_ENTRIES_NUM_MAX; i++) {
+      GstH265Picture *ref_pic =
+          g_array_index (ref_pic_list, GstH265Picture *, i);
+      ref_idx[i] = lookup_dpb_index (self->decode_params.dpb,
+          self->decode_params.num_active_dpb_entries, ref_pic);
+    }
+  }
+
+  for (; i < V4L2_HEVC_DPB_ENTRIES_NUM_MAX; i++)
+    ref_idx[i] = 0xff;
+}
+
+static void
+gst_v4l2_codec_h265_dec_fill_slice_params (GstV4l2CodecH265Dec * self,
+    GstH265Picture * picture, GstH265Slice * slice, GArray * ref_pic_list0,
+    GArray * ref_pic_list1)
+{
+  GstH265SliceHdr *slice_hdr = &slice->header;
+  gint n = self->num_slices++;
+  gsize slice_size = slice->nalu.size;
+  guint sc_off = 0;
+  struct v4l2_ctrl_hevc_slice_params *params;
+
+  /* Ensure array is large enough */
+  if (self->slice_params->len < self->num_slices)
+    g_array_set_size (self->slice_params, self->slice_params->len * 2);
+
+  if (needs_start_codes (self))
+    sc_off = 3;
+  slice_size += sc_off;
+
+  /* *INDENT-OFF* */
+  params = &g_array_index (self->slice_params, struct v4l2_ctrl_hevc_slice_params, n);
+  *params = (struct v4l2_ctrl_hevc_slice_params) {
+    .bit_size = slice_size * 8,
+    .data_byte_offset = sc_off + get_slice_header_byte_offset (slice),
+    .num_entry_point_offsets = slice_hdr->num_entry_point_offsets,
+    .nal_unit_type = slice->nalu.type,
+    .nuh_temporal_id_plus1 = slice->nalu.temporal_id_plus1,
+    .slice_type = slice_hdr->type,
+    .colour_plane_id = slice_hdr->colour_plane_id,
+    .slice_pic_order_cnt = picture->pic_order_cnt,
+    .num_ref_idx_l0_active_minus1 = slice_hdr->num_ref_idx_l0_active_minus1,
+    .num_ref_idx_l1_active_minus1 = slice_hdr->num_ref_idx_l1_active_minus1,
+    .collocated_ref_idx = slice_hdr->temporal_mvp_enabled_flag ? slice_hdr->collocated_ref_idx : 0,
+    .five_minus_max_num_merge_cand = slice_hdr->five_minus_max_num_merge_cand,
+    .slice_qp_delta = slice_hdr->qp_delta,
+    .slice_cb_qp_offset = slice_hdr->cb_qp_offset,
+    .slice_cr_qp_offset = slice_hdr->cr_qp_offset,
+    .slice_act_y_qp_offset = slice_hdr->slice_act_y_qp_offset,
+    .slice_act_cb_qp_offset = slice_hdr->slice_act_cb_qp_offset,
+    .slice_act_cr_qp_offset = slice_hdr->slice_act_cr_qp_offset,
+    .slice_beta_offset_div2 = slice_hdr->beta_offset_div2,
+    .slice_tc_offset_div2 = slice_hdr->tc_offset_div2,
+    .pic_struct = picture->pic_struct,
+    .slice_segment_addr = slice_hdr->segment_address,
+    .short_term_ref_pic_set_size = slice_hdr->short_term_ref_pic_set_size,
+    .flags = (slice_hdr->sao_luma_flag ? V4L2_HEVC_SLICE_PARAMS_FLAG_SLICE_SAO_LUMA : 0)
+        | (slice_hdr->sao_chroma_flag ? V4L2_HEVC_SLICE_PARAMS_FLAG_SLICE_SAO_CHROMA : 0)
+        | (slice_hdr->temporal_mvp_enabled_flag ? V4L2_HEVC_SLICE_PARAMS_FLAG_SLICE_TEMPORAL_MVP_ENABLED : 0)
+        | (slice_hdr->mvd_l1_zero_flag ? V4L2_HEVC_SLICE_PARAMS_FLAG_MVD_L1_ZERO : 0)
+        | (slice_hdr->cabac_init_flag ? V4L2_HEVC_SLICE_PARAMS_FLAG_CABAC_INIT : 0)
+        | (slice_hdr->collocated_from_l0_flag ? V4L2_HEVC_SLICE_PARAMS_FLAG_COLLOCATED_FROM_L0 : 0)
+        | (slice_hdr->use_integer_mv_flag ? V4L2_HEVC_SLICE_PARAMS_FLAG_USE_INTEGER_MV : 0)
+        | (slice_hdr->deblocking_filter_disabled_flag ? V4L2_HEVC_SLICE_PARAMS_FLAG_SLICE_DEBLOCKING_FILTER_DISABLED : 0)
+        | (slice_hdr->loop_filter_across_slices_enabled_flag ? V4L2_HEVC_SLICE_PARAMS_FLAG_SLICE_LOOP_FILTER_ACROSS_SLICES_ENABLED : 0)
+        | (slice_hdr->dependent_slice_segment_flag ? V4L2_HEVC_SLICE_PARAMS_FLAG_DEPENDENT_SLICE_SEGMENT : 0),
+  };
+  /* *INDENT-ON* */
+
+  gst_v4l2_codec_h265_dec_fill_references (self, params->ref_idx_l0,
+      ref_pic_list0);
+  gst_v4l2_codec_h265_dec_fill_references (self, params->ref_idx_l1,
+      ref_pic_list1);
+  gst_v4l2_codec_h265_dec_fill_pred_weight (self, params, slice_hdr);
+}
+
+static gboolean
+gst_v4l2_codec_h265_dec_new_sequence (GstH265Decoder * decoder,
+    const GstH265SPS * sps, gint max_dpb_size)
+{
+  GstV4l2CodecH265Dec *self = GST_V4L2_CODEC_H265_DEC (decoder);
+  gint crop_width = sps->width;
+  gint crop_height = sps->height;
+  gboolean negotiation_needed = FALSE;
+
+  if (self->vinfo.finfo->format == GST_VIDEO_FORMAT_UNKNOWN)
+    negotiation_needed = TRUE;
+
+  if (self->min_pool_size < max_dpb_size) {
+    self->min_pool_size = max_dpb_size;
+    negotiation_needed = TRUE;
+  }
+
+  /* Start with what the references need, or what the previous sequence
+   * actually used, the allocator grows up to the DPB size if the driver
+   * allows it */
+  self->start_pool_size =
+      sps->max_dec_pic_buffering_minus1[sps->max_sub_layers_minus1] + 1;
+  self->start_pool_size = MAX (self->start_pool_size,
+      gst_h265_decoder_get_max_pictures_in_use (decoder));
+  self->start_pool_size = MIN (self->start_pool_size, self->min_pool_size);
+
+  if (sps->conformance_window_flag) {
+    crop_width = sps->crop_rect_width;
+    crop_height = sps->crop_rect_height;
+  }
+
+  /* TODO Check if current buffers are large enough, and reuse them */
+  if (self->display_width != crop_width || self->display_height != crop_height
+      || self->coded_width != sps->width || self->coded_height != sps->height) {
+    self->display_width = crop_width;
+    self->display_height = crop_height;
+    self->coded_width = sps->width;
+    self->coded_height = sps->height;
+    negotiation_needed = TRUE;
+    GST_INFO_OBJECT (self, "Resolution changed to %dx%d (%ix%i)",
+        self->display_width, self->display_height,
+        self->coded_width, self->coded_height);
+  }
+
+  if (self->bitdepth != sps->bit_depth_luma_minus8 + 8) {
+    self->bitdepth = sps->bit_depth_luma_minus8 + 8;
+    negotiation_needed = TRUE;
+    GST_INFO_OBJECT (self, "Bitdepth changed to %u", self->bitdepth);
+  }
+
+  if (self->chroma_format_idc != sps->chroma_format_idc) {
+    self->chroma_format_idc = sps->chroma_format_idc;
+    negotiation_needed = TRUE;
+    GST_INFO_OBJECT (self, "Chroma format changed to %i",
+        self->chroma_format_idc);
+  }
+
+  gst_v4l2_codec_h265_dec_fill_sequence (self, sps);
+  self->need_sequence = TRUE;
+
+  if (negotiation_needed) {
+    self->need_negotiation = TRUE;
+    if (!gst_video_decoder_negotiate (GST_VIDEO_DECODER (self))) {
+      GST_ERROR_OBJECT (self, "Failed to negotiate with downstream");
+      return FALSE;
+    }
+  }
+
+  /* Check if we can zero-copy buffers */
+  if (!self->has_videometa) {
+    GstVideoInfo ref_vinfo;
+    gint i;
+
+    gst_video_info_set_format (&ref_vinfo, GST_VIDEO_INFO_FORMAT (&self->vinfo),
+        self->display_width, self->display_height);
+
+    for (i = 0; i < GST_VIDEO_INFO_N_PLANES (&self->vinfo); i++) {
+      if (self->vinfo.stride[i] != ref_vinfo.stride[i] ||
+          self->vinfo.offset[i] != ref_vinfo.offset[i]) {
+        GST_WARNING_OBJECT (self,
+            "GstVideoMeta support required, copying frames.");
+        self->copy_frames = TRUE;
+        break;
+      }
+    }
+  } else {
+    self->copy_frames = FALSE;
+  }
+
+  return TRUE;
+}
+
+static gboolean
+gst_v4l2_codec_h265_dec_ensure_bitstream (GstV4l2CodecH265Dec * self)
+{
+  if (self->bitstream)
+    goto done;
+
+  self->bitstream = gst_v4l2_codec_allocator_alloc (self->sink_allocator);
+
+  if (!self->bitstream) {
+    GST_ELEMENT_ERROR (self, RESOURCE, NO_SPACE_LEFT,
+        ("Not enough memory to decode H265 stream."), (NULL));
+    return FALSE;
+  }
+
+  if (!gst_memory_map (self->bitstream, &self->bitstream_map, GST_MAP_WRITE)) {
+    GST_ELEMENT_ERROR (self, RESOURCE, WRITE,
+        ("Could not access bitstream memory for writing"), (NULL));
+    g_clear_pointer (&self->bitstream, gst_memory_unref);
+    return FALSE;
+  }
+
+done:
+  /* We use this field to track how much we have written */
+  self->bitstream_map.size = 0;
+
+  return TRUE;
+}
+
+static gboolean
+gst_v4l2_codec_h265_dec_start_picture (GstH265Decoder * decoder,
+    GstH265Picture * picture, GstH265Slice * slice, GstH265Dpb * dpb)
+{
+  GstV4l2CodecH265Dec *self = GST_V4L2_CODEC_H265_DEC (decoder);
+
+  /* FIXME base class should not call us if negotiation failed */
+  if (!self->sink_allocator)
+    return FALSE;
+
+  if (!gst_v4l2_codec_h265_dec_ensure_bitstream (self))
+    return FALSE;
+
+  gst_v4l2_codec_h265_dec_fill_pps (self, slice->header.pps);
+  gst_v4l2_codec_h265_dec_fill_scaling_matrix (self, slice->header.pps);
+  gst_v4l2_codec_h265_dec_fill_decoder_params (self, slice, picture, dpb);
+
+  self->first_slice = TRUE;
+
+  return TRUE;
+}
+
+static gboolean
+gst_v4l2_codec_h265_dec_copy_output_buffer (GstV4l2CodecH265Dec * self,
+    GstVideoCodecFrame * codec_frame)
+{
+  GstVideoFrame src_frame;
+  GstVideoFrame dest_frame;
+  GstVideoInfo dest_vinfo;
+  GstBuffer *buffer;
+
+  gst_video_info_set_format (&dest_vinfo, GST_VIDEO_INFO_FORMAT (&self->vinfo),
+      self->display_width, self->display_height);
+
+  buffer = gst_video_decoder_allocate_output_buffer (GST_VIDEO_DECODER (self));
+  if (!buffer)
+    goto fail;
+
+  if (!gst_video_frame_map (&src_frame, &self->vinfo,
+          codec_frame->output_buffer, GST_MAP_READ))
+    goto fail;
+
+  if (!gst_video_frame_map (&dest_frame, &dest_vinfo, buffer, GST_MAP_WRITE)) {
+    gst_video_frame_unmap (&src_frame);
+    goto fail;
+  }
+
+  /* gst_video_frame_copy can crop this, but does not know, so let make it
+   * think it's all right */
+  GST_VIDEO_INFO_WIDTH (&src_frame.info) = self->display_width;
+  GST_VIDEO_INFO_HEIGHT (&src_frame.info) = self->display_height;
+
+  if (!gst_video_frame_copy (&dest_frame, &src_frame)) {
+    gst_video_frame_unmap (&src_frame);
+    gst_video_frame_unmap (&dest_frame);
+    goto fail;
+  }
+
+  gst_video_frame_unmap (&src_frame);
+  gst_video_frame_unmap (&dest_frame);
+  gst_buffer_replace (&codec_frame->output_buffer, buffer);
+  gst_buffer_unref (buffer);
+
+  return TRUE;
+
+fail:
+  if (buffer)
+    gst_buffer_unref (buffer);
+  GST_ERROR_OBJECT (self, "Failed copy output buffer.");
+  return FALSE;
+}
+
+static GstFlowReturn
+gst_v4l2_codec_h265_dec_output_picture (GstH265Decoder * decoder,
+    GstVideoCodecFrame * frame, GstH265Picture * picture)
+{
+  GstV4l2CodecH265Dec *self = GST_V4L2_CODEC_H265_DEC (decoder);
+  GstVideoDecoder *vdec = GST_VIDEO_DECODER (decoder);
+  GstV4l2Request *request = gst_h265_picture_get_user_data (picture);
+  gint ret;
+
+  GST_DEBUG_OBJECT (self, "Output picture %u", picture->system_frame_number);
+
+  ret = gst_v4l2_request_set_done (request);
+  if (ret == 0) {
+    GST_ELEMENT_ERROR (self, STREAM, DECODE,
+        ("Decoding frame %u took too long", picture->system_frame_number),
+        (NULL));
+    goto error;
+  } else if (ret < 0) {
+    GST_ELEMENT_ERROR (self, STREAM, DECODE,
+        ("Decoding request failed: %s", g_strerror (errno)), (NULL));
+    goto error;
+  }
+  g_return_val_if_fail (frame->output_buffer, GST_FLOW_ERROR);
+
+  if (gst_v4l2_request_failed (request)) {
+    GST_ELEMENT_ERROR (self, STREAM, DECODE,
+        ("Failed to decode frame %u", picture->system_frame_number), (NULL));
+    goto error;
+  }
+
+  /* Hold on reference buffers for the rest of the picture lifetime */
+  gst_h265_picture_set_user_data (picture,
+      gst_buffer_ref (frame->output_buffer), (GDestroyNotify) gst_buffer_unref);
+
+  if (self->copy_frames)
+    gst_v4l2_codec_h265_dec_copy_output_buffer (self, frame);
+
+  gst_h265_picture_unref (picture);
+
+  return gst_video_decoder_finish_frame (vdec, frame);
+
+error:
+  gst_video_decoder_drop_frame (vdec, frame);
+  gst_h265_picture_unref (picture);
+
+  return GST_FLOW_ERROR;
+}
+
+static void
+gst_v4l2_codec_h265_dec_reset_picture (GstV4l2CodecH265Dec * self)
+{
+  if (self->bitstream) {
+    if (self->bitstream_map.memory)
+      gst_memory_unmap (self->bitstream, &self->bitstream_map);
+    g_clear_pointer (&self->bitstream, gst_memory_unref);
+    self->bitstream_map = (GstMapInfo) GST_MAP_INFO_INIT;
+  }
+
+  self->num_slices = 0;
+}
+
+static gboolean
+gst_v4l2_codec_h265_dec_ensure_output_buffer (GstV4l2CodecH265Dec * self,
+    GstVideoCodecFrame * frame)
+{
+  GstBuffer *buffer;
+  GstFlowReturn flow_ret;
+
+  if (frame->output_buffer)
+    return TRUE;
+
+  flow_ret = gst_buffer_pool_acquire_buffer (GST_BUFFER_POOL (self->src_pool),
+      &buffer, NULL);
+  if (flow_ret != GST_FLOW_OK) {
+    if (flow_ret == GST_FLOW_FLUSHING)
+      GST_DEBUG_OBJECT (self, "Frame decoding aborted, we are flushing.");
+    else
+      GST_ELEMENT_ERROR (self, RESOURCE, WRITE,
+          ("No more picture buffer available."), (NULL));
+    return FALSE;
+  }
+
+  frame->output_buffer = buffer;
+  return TRUE;
+}
+
+static gboolean
+gst_v4l2_codec_h265_dec_submit_bitstream (GstV4l2CodecH265Dec * self,
+    GstH265Picture * picture, guint flags)
+{
+  GstV4l2Request *prev_request, *request = NULL;
+  gsize bytesused;
+  gboolean ret = FALSE;
+  guint count = 0;
+
+  /* *INDENT-OFF* */
+  /* Reserve space for controls */
+  struct v4l2_ext_control control[] = {
+    { }, /* SPS */
+    { }, /* PPS */
+    { }, /* DECODE_PARAMS */
+    { }, /* SLICE_PARAMS */
+    { }, /* SCALING_MATRIX */
+  };
+  /* *INDENT-ON* */
+
+  prev_request = gst_h265_picture_get_user_data (picture);
+
+  bytesused = self->bitstream_map.size;
+  gst_memory_unmap (self->bitstream, &self->bitstream_map);
+  self->bitstream_map = (GstMapInfo) GST_MAP_INFO_INIT;
+  gst_memory_resize (self->bitstream, 0, bytesused);
+
+  if (prev_request) {
+    request = gst_v4l2_decoder_alloc_sub_request (self->decoder, prev_request,
+        self->bitstream);
+  } else {
+    GstVideoCodecFrame *frame;
+
+    frame = gst_video_decoder_get_frame (GST_VIDEO_DECODER (self),
+        picture->system_frame_number);
+    g_return_val_if_fail (frame, FALSE);
+
+    if (!gst_v4l2_codec_h265_dec_ensure_output_buffer (self, frame))
+      goto done;
+
+    request = gst_v4l2_decoder_alloc_request (self->decoder,
+        picture->system_frame_number, self->bitstream, frame->output_buffer);
+
+    gst_video_codec_frame_unref (frame);
+  }
+
+  if (!request) {
+    GST_ELEMENT_ERROR (self, RESOURCE, NO_SPACE_LEFT,
+        ("Failed to allocate a media request object."), (NULL));
+    goto done;
+  }
+
+  if (self->need_sequence) {
+    control[count].id = V4L2_CID_STATELESS_HEVC_SPS;
+    control[count].ptr = &self->sps;
+    control[count].size = sizeof (self->sps);
+    count++;
+    self->need_sequence = FALSE;
+  }
+
+  if (self->first_slice) {
+    control[count].id = V4L2_CID_STATELESS_HEVC_PPS;
+    control[count].ptr = &self->pps;
+    control[count].size = sizeof (self->pps);
+    count++;
+
+    if (self->scaling_matrix_present) {
+      control[count].id = V4L2_CID_STATELESS_HEVC_SCALING_MATRIX;
+      control[count].ptr = &self->scaling_matrix;
+      control[count].size = sizeof (self->scaling_matrix);
+      count++;
+    }
+
+    control[count].id = V4L2_CID_STATELESS_HEVC_DECODE_PARAMS;
+    control[count].ptr = &self->decode_params;
+    control[count].size = sizeof (self->decode_params);
+    count++;
+
+    self->first_slice = FALSE;
+  }
+
+  /* The slice parameters control is an array, with one entry per slice
+   * of the bitstream buffer */
+  if (self->need_slice_params && self->num_slices) {
+    control[count].id = V4L2_CID_STATELESS_HEVC_SLICE_PARAMS;
+    control[count].ptr = self->slice_params->data;
+    control[count].size = g_array_get_element_size (self->slice_params)
+        * self->num_slices;
+    count++;
+  }
+
+  if (!gst_v4l2_decoder_set_controls (self->decoder, request, control, count)) {
+    GST_ELEMENT_ERROR (self, RESOURCE, WRITE,
+        ("Driver did not accept the bitstream parameters."), (NULL));
+    goto done;
+  }
+
+  if (!gst_v4l2_request_queue (request, flags)) {
+    GST_ELEMENT_ERROR (self, RESOURCE, WRITE,
+        ("Driver did not accept the decode request."), (NULL));
+    goto done;
+  }
+
+  gst_h265_picture_set_user_data (picture, g_steal_pointer (&request),
+      (GDestroyNotify) gst_v4l2_request_unref);
+  ret = TRUE;
+
+done:
+  if (request)
+    gst_v4l2_request_unref (request);
+
+  gst_v4l2_codec_h265_dec_reset_picture (self);
+
+  return ret;
+}
+
+static gboolean
+gst_v4l2_codec_h265_dec_decode_slice (GstH265Decoder * decoder,
+    GstH265Picture * picture, GstH265Slice * slice, GArray * ref_pic_list0,
+    GArray * ref_pic_list1)
+{
+  GstV4l2CodecH265Dec *self = GST_V4L2_CODEC_H265_DEC (decoder);
+  gsize sc_off = 0;
+  gsize nal_size;
+  guint8 *bitstream_data;
+
+  if (is_slice_based (self) && self->bitstream_map.size) {
+    /* In slice mode, we submit the pending slice asking the accelerator to
+     * hold on the picture */
+    if (!gst_v4l2_codec_h265_dec_submit_bitstream (self, picture,
+            V4L2_BUF_FLAG_M2M_HOLD_CAPTURE_BUF)
+        || !gst_v4l2_codec_h265_dec_ensure_bitstream (self))
+      return FALSE;
+  }
+
+  if (self->need_slice_params)
+    gst_v4l2_codec_h265_dec_fill_slice_params (self, picture, slice,
+        ref_pic_list0, ref_pic_list1);
+
+  bitstream_data = self->bitstream_map.data + self->bitstream_map.size;
+
+  if (needs_start_codes (self))
+    sc_off = 3;
+  nal_size = sc_off + slice->nalu.size;
+
+  if (self->bitstream_map.size + nal_size > self->bitstream_map.maxsize) {
+    GST_ELEMENT_ERROR (decoder, RESOURCE, NO_SPACE_LEFT,
+        ("Not enough space to send all slice of an H265 frame."), (NULL));
+    return FALSE;
+  }
+
+  if (needs_start_codes (self)) {
+    bitstream_data[0] = 0x00;
+    bitstream_data[1] = 0x00;
+    bitstream_data[2] = 0x01;
+  }
+
+  memcpy (bitstream_data + sc_off, slice->nalu.data + slice->nalu.offset,
+      slice->nalu.size);
+  self->bitstream_map.size += nal_size;
+
+  return TRUE;
+}
+
+static gboolean
+gst_v4l2_codec_h265_dec_end_picture (GstH265Decoder * decoder,
+    GstH265Picture * picture)
+{
+  GstV4l2CodecH265Dec *self = GST_V4L2_CODEC_H265_DEC (decoder);
+  return gst_v4l2_codec_h265_dec_submit_bitstream (self, picture, 0);
+}
+
+static guint
+gst_v4l2_codec_h265_dec_get_preferred_output_delay (GstH265Decoder * decoder,
+    gboolean live)
+{
+  GstV4l2CodecH265Dec *self = GST_V4L2_CODEC_H265_DEC (decoder);
+  guint delay;
+
+  if (live)
+    delay = 0;
+  else
+    /* Just one for now, perhaps we can make this configurable in the future. */
+    delay = 1;
+
+  gst_v4l2_decoder_set_render_delay (self->decoder, delay);
+
+  return delay;
+}
+
+static void
+gst_v4l2_codec_h265_dec_set_flushing (GstV4l2CodecH265Dec * self,
+    gboolean flushing)
+{
+  if (self->sink_allocator)
+    gst_v4l2_codec_allocator_set_flushing (self->sink_allocator, flushing);
+  if (self->src_allocator)
+    gst_v4l2_codec_allocator_set_flushing (self->src_allocator, flushing);
+}
+
+static gboolean
+gst_v4l2_codec_h265_dec_flush (GstVideoDecoder * decoder)
+{
+  GstV4l2CodecH265Dec *self = GST_V4L2_CODEC_H265_DEC (decoder);
+
+  GST_DEBUG_OBJECT (self, "Flushing decoder state.");
+
+  gst_v4l2_decoder_flush (self->decoder);
+  gst_v4l2_codec_h265_dec_set_flushing (self, FALSE);
+
+  return GST_VIDEO_DECODER_CLASS (parent_class)->flush (decoder);
+}
+
+static gboolean
+gst_v4l2_codec_h265_dec_sink_event (GstVideoDecoder * decoder, GstEvent * event)
+{
+  GstV4l2CodecH265Dec *self = GST_V4L2_CODEC_H265_DEC (decoder);
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_FLUSH_START:
+      GST_DEBUG_OBJECT (self, "flush start");
+      gst_v4l2_codec_h265_dec_set_flushing (self, TRUE);
+      break;
+    default:
+      break;
+  }
+
+  return GST_VIDEO_DECODER_CLASS (parent_class)->sink_event (decoder, event);
+}
+
+static GstStateChangeReturn
+gst_v4l2_codec_h265_dec_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstV4l2CodecH265Dec *self = GST_V4L2_CODEC_H265_DEC (element);
+
+  if (transition == GST_STATE_CHANGE_PAUSED_TO_READY)
+    gst_v4l2_codec_h265_dec_set_flushing (self, TRUE);
+
+  return GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+}
+
+static void
+gst_v4l2_codec_h265_dec_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstV4l2CodecH265Dec *self = GST_V4L2_CODEC_H265_DEC (object);
+  GObject *dec = G_OBJECT (self->decoder);
+
+  switch (prop_id) {
+    default:
+      gst_v4l2_decoder_set_property (dec, prop_id - PROP_LAST, value, pspec);
+      break;
+  }
+}
+
+static void
+gst_v4l2_codec_h265_dec_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstV4l2CodecH265Dec *self = GST_V4L2_CODEC_H265_DEC (object);
+  GObject *dec = G_OBJECT (self->decoder);
+
+  switch (prop_id) {
+    default:
+      gst_v4l2_decoder_get_property (dec, prop_id - PROP_LAST, value, pspec);
+      break;
+  }
+}
+
+static void
+gst_v4l2_codec_h265_dec_init (GstV4l2CodecH265Dec * self)
+{
+}
+
+static void
+gst_v4l2_codec_h265_dec_subinit (GstV4l2CodecH265Dec * self,
+    GstV4l2CodecH265DecClass * klass)
+{
+  self->decoder = gst_v4l2_decoder_new (klass->device);
+  gst_video_info_init (&self->vinfo);
+  self->slice_params = g_array_sized_new (FALSE, TRUE,
+      sizeof (struct v4l2_ctrl_hevc_slice_params), 4);
+  g_array_set_size (self->slice_params, 4);
+}
+
+static void
+gst_v4l2_codec_h265_dec_dispose (GObject * object)
+{
+  GstV4l2CodecH265Dec *self = GST_V4L2_CODEC_H265_DEC (object);
+
+  g_clear_object (&self->decoder);
+  g_clear_pointer (&self->slice_params, g_array_unref);
+
+  G_OBJECT_CLASS (parent_class)->dispose (object);
+}
+
+static void
+gst_v4l2_codec_h265_dec_class_init (GstV4l2CodecH265DecClass * klass)
+{
+}
+
+static void
+gst_v4l2_codec_h265_dec_subclass_init (GstV4l2CodecH265DecClass * klass,
+    GstV4l2CodecDevice * device)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstVideoDecoderClass *decoder_class = GST_VIDEO_DECODER_CLASS (klass);
+  GstH265DecoderClass *h265decoder_class = GST_H265_DECODER_CLASS (klass);
+
+  gobject_class->set_property = gst_v4l2_codec_h265_dec_set_property;
+  gobject_class->get_property = gst_v4l2_codec_h265_dec_get_property;
+  gobject_class->dispose = gst_v4l2_codec_h265_dec_dispose;
+
+  gst_element_class_set_static_metadata (element_class,
+      "V4L2 Stateless H.265 Video Decoder",
+      "Codec/Decoder/Video/Hardware",
+      "A V4L2 based H.265 video decoder", "GStreamer developers");
+
+  gst_element_class_add_static_pad_template (element_class, &sink_template);
+  gst_element_class_add_static_pad_template (element_class, &src_template);
+  element_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_v4l2_codec_h265_dec_change_state);
+
+  decoder_class->open = GST_DEBUG_FUNCPTR (gst_v4l2_codec_h265_dec_open);
+  decoder_class->close = GST_DEBUG_FUNCPTR (gst_v4l2_codec_h265_dec_close);
+  decoder_class->stop = GST_DEBUG_FUNCPTR (gst_v4l2_codec_h265_dec_stop);
+  decoder_class->negotiate =
+      GST_DEBUG_FUNCPTR (gst_v4l2_codec_h265_dec_negotiate);
+  decoder_class->decide_allocation =
+      GST_DEBUG_FUNCPTR (gst_v4l2_codec_h265_dec_decide_allocation);
+  decoder_class->flush = GST_DEBUG_FUNCPTR (gst_v4l2_codec_h265_dec_flush);
+  decoder_class->sink_event =
+      GST_DEBUG_FUNCPTR (gst_v4l2_codec_h265_dec_sink_event);
+
+  h265decoder_class->new_sequence =
+      GST_DEBUG_FUNCPTR (gst_v4l2_codec_h265_dec_new_sequence);
+  h265decoder_class->output_picture =
+      GST_DEBUG_FUNCPTR (gst_v4l2_codec_h265_dec_output_picture);
+  h265decoder_class->start_picture =
+      GST_DEBUG_FUNCPTR (gst_v4l2_codec_h265_dec_start_picture);
+  h265decoder_class->decode_slice =
+      GST_DEBUG_FUNCPTR (gst_v4l2_codec_h265_dec_decode_slice);
+  h265decoder_class->end_picture =
+      GST_DEBUG_FUNCPTR (gst_v4l2_codec_h265_dec_end_picture);
+  h265decoder_class->get_preferred_output_delay =
+      GST_DEBUG_FUNCPTR (gst_v4l2_codec_h265_dec_get_preferred_output_delay);
+
+  klass->device = device;
+  gst_v4l2_decoder_install_properties (gobject_class, PROP_LAST, device);
+}
+
+void
+gst_v4l2_codec_h265_dec_register (GstPlugin * plugin,
+    GstV4l2CodecDevice * device, guint rank)
+{
+  gst_v4l2_decoder_register (plugin, GST_TYPE_V4L2_CODEC_H265_DEC,
+      (GClassInitFunc) gst_v4l2_codec_h265_dec_subclass_init,
+      (GInstanceInitFunc) gst_v4l2_codec_h265_dec_subinit,
+      "v4l2sl%sh265dec", device, rank);
+}
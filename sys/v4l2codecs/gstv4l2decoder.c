@@ -486,6 +486,45 @@ gst_v4l2_decoder_request_buffers (GstV4l2Decoder * self,
   return reqbufs.count;
 }
 
+/* Allocates @num_buffers more buffers on top of the ones obtained with
+ * gst_v4l2_decoder_request_buffers() and returns the index of the first new
+ * one, or -1 on failure. With @num_buffers set to 0, nothing is allocated
+ * and this only tells whether the driver supports growing its queue. */
+gint
+gst_v4l2_decoder_create_buffers (GstV4l2Decoder * self,
+    GstPadDirection direction, guint num_buffers)
+{
+  gint ret;
+  struct v4l2_create_buffers createbufs = {
+    .count = num_buffers,
+    .memory = V4L2_MEMORY_MMAP,
+    .format.type = direction_to_buffer_type (self, direction),
+  };
+
+  ret = ioctl (self->video_fd, VIDIOC_G_FMT, &createbufs.format);
+  if (ret < 0) {
+    GST_ERROR_OBJECT (self, "VIDIOC_G_FMT failed: %s", g_strerror (errno));
+    return -1;
+  }
+
+  GST_DEBUG_OBJECT (self, "Creating %u buffers", num_buffers);
+
+  ret = ioctl (self->video_fd, VIDIOC_CREATE_BUFS, &createbufs);
+  if (ret < 0) {
+    GST_DEBUG_OBJECT (self, "VIDIOC_CREATE_BUFS failed: %s",
+        g_strerror (errno));
+    return -1;
+  }
+
+  if (createbufs.count < num_buffers) {
+    GST_WARNING_OBJECT (self, "%u buffers requested, but only %u created",
+        num_buffers, createbufs.count);
+    return -1;
+  }
+
+  return createbufs.index;
+}
+
 gboolean
 gst_v4l2_decoder_export_buffer (GstV4l2Decoder * self,
     GstPadDirection direction, gint index, gint * fds, gsize * sizes,
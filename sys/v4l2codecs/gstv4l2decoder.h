@@ -66,6 +66,10 @@ gint              gst_v4l2_decoder_request_buffers (GstV4l2Decoder * self,
                                                     GstPadDirection direction,
                                                     guint num_buffers);
 
+gint              gst_v4l2_decoder_create_buffers (GstV4l2Decoder * self,
+                                                   GstPadDirection direction,
+                                                   guint num_buffers);
+
 gboolean          gst_v4l2_decoder_export_buffer (GstV4l2Decoder * self,
                                                   GstPadDirection directon,
                                                   gint index,
@@ -34,6 +34,10 @@
 #define GST_CAT_DEFAULT gst_va_memory_debug
 GST_DEBUG_CATEGORY_STATIC (gst_va_memory_debug);
 
+#ifndef DRM_FORMAT_MOD_LINEAR
+#define DRM_FORMAT_MOD_LINEAR 0ULL
+#endif
+
 static void
 _init_debug_category (void)
 {
@@ -585,6 +589,21 @@ _get_fd_size (gint fd)
   return lseek (fd, 0, SEEK_END);
 }
 
+/* Foreign dmabufs carry no modifier, so they are assumed to be
+ * linear, as any producer negotiating through plain caps does */
+guint64
+gst_va_dmabuf_memory_get_drm_modifier (GstMemory * mem)
+{
+  guint64 *drm_mod;
+
+  g_return_val_if_fail (mem, DRM_FORMAT_MOD_LINEAR);
+
+  drm_mod = gst_mini_object_get_qdata (GST_MINI_OBJECT (mem),
+      gst_va_drm_mod_quark ());
+
+  return drm_mod ? *drm_mod : DRM_FORMAT_MOD_LINEAR;
+}
+
 static gboolean
 gst_va_dmabuf_memory_release (GstMiniObject * mini_object)
 {
@@ -926,6 +945,91 @@ gst_va_dmabuf_allocator_get_format (GstAllocator * allocator,
   return TRUE;
 }
 
+/* Imports the planes as one layer of a DRM PRIME 2 descriptor, which,
+ * unlike the external buffer attribute, can express planes sharing a
+ * dmabuf and non-linear layouts. */
+static gboolean
+_import_prime_2_surface (GstVaDisplay * display, GstVideoInfo * info,
+    guint n_planes, GstMemory * mem[GST_VIDEO_MAX_PLANES], uintptr_t * fds,
+    gsize offset[GST_VIDEO_MAX_PLANES], guint usage_hint, guint rt_format,
+    guint32 fourcc, VASurfaceID * surface)
+{
+  VADisplay dpy = gst_va_display_get_va_dpy (display);
+  VADRMPRIMESurfaceDescriptor desc = { 0, };
+  VASurfaceAttrib attrs[3];
+  VAStatus status;
+  guint32 drm_fourcc;
+  guint i, j;
+
+  drm_fourcc = gst_va_drm_fourcc_from_video_format (GST_VIDEO_INFO_FORMAT
+      (info));
+  if (drm_fourcc == 0)
+    return FALSE;
+
+  desc.fourcc = fourcc;
+  desc.width = GST_VIDEO_INFO_WIDTH (info);
+  desc.height = GST_VIDEO_INFO_HEIGHT (info);
+  desc.num_layers = 1;
+  desc.layers[0].drm_format = drm_fourcc;
+  desc.layers[0].num_planes = n_planes;
+
+  for (i = 0; i < n_planes; i++) {
+    for (j = 0; j < desc.num_objects; j++) {
+      if ((uintptr_t) desc.objects[j].fd == fds[i])
+        break;
+    }
+
+    if (j == desc.num_objects) {
+      desc.objects[j].fd = (gint) fds[i];
+      desc.objects[j].size = (guint32) _get_fd_size (fds[i]);
+      desc.objects[j].drm_format_modifier =
+          gst_va_dmabuf_memory_get_drm_modifier (mem[i]);
+      desc.num_objects++;
+    }
+
+    desc.layers[0].object_index[i] = j;
+    desc.layers[0].offset[i] = offset[i];
+    desc.layers[0].pitch[i] = GST_VIDEO_INFO_PLANE_STRIDE (info, i);
+  }
+
+  /* *INDENT-OFF* */
+  attrs[0] = (VASurfaceAttrib) {
+    .type = VASurfaceAttribUsageHint,
+    .flags = VA_SURFACE_ATTRIB_SETTABLE,
+    .value.type = VAGenericValueTypeInteger,
+    .value.value.i = usage_hint,
+  };
+  attrs[1] = (VASurfaceAttrib) {
+    .type = VASurfaceAttribMemoryType,
+    .flags = VA_SURFACE_ATTRIB_SETTABLE,
+    .value.type = VAGenericValueTypeInteger,
+    .value.value.i = VA_SURFACE_ATTRIB_MEM_TYPE_DRM_PRIME_2,
+  };
+  attrs[2] = (VASurfaceAttrib) {
+    .type = VASurfaceAttribExternalBufferDescriptor,
+    .flags = VA_SURFACE_ATTRIB_SETTABLE,
+    .value.type = VAGenericValueTypePointer,
+    .value.value.p = &desc,
+  };
+  /* *INDENT-ON* */
+
+  gst_va_display_lock (display);
+  status = vaCreateSurfaces (dpy, rt_format, desc.width, desc.height, surface,
+      1, attrs, G_N_ELEMENTS (attrs));
+  gst_va_display_unlock (display);
+  if (status != VA_STATUS_SUCCESS) {
+    GST_DEBUG_OBJECT (display, "Can't import DRM PRIME 2 surface: %s",
+        vaErrorStr (status));
+    return FALSE;
+  }
+
+  GST_LOG_OBJECT (display, "Imported %u dmabufs with modifier %#"
+      G_GINT64_MODIFIER "x", desc.num_objects,
+      desc.objects[0].drm_format_modifier);
+
+  return TRUE;
+}
+
 /* XXX: use a surface pool to control the created surfaces */
 gboolean
 gst_va_dmabuf_memories_setup (GstVaDisplay * display, GstVideoInfo * info,
@@ -971,8 +1075,12 @@ gst_va_dmabuf_memories_setup (GstVaDisplay * display, GstVideoInfo * info,
     ext_buf.offsets[i] = offset[i];
   }
 
-  ret = _create_surfaces (display, rt_format, ext_buf.pixel_format,
-      ext_buf.width, ext_buf.height, usage_hint, &ext_buf, &surface, 1);
+  ret = _import_prime_2_surface (display, info, n_planes, mem, fds, offset,
+      usage_hint, rt_format, fourcc, &surface);
+  if (!ret) {
+    ret = _create_surfaces (display, rt_format, ext_buf.pixel_format,
+        ext_buf.width, ext_buf.height, usage_hint, &ext_buf, &surface, 1);
+  }
   if (!ret)
     return FALSE;
 
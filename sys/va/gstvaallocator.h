@@ -44,6 +44,7 @@ gboolean              gst_va_dmabuf_allocator_get_format  (GstAllocator * alloca
                                                            GstVideoInfo * info,
                                                            guint * usage_hint);
 
+guint64               gst_va_dmabuf_memory_get_drm_modifier (GstMemory * mem);
 gboolean              gst_va_dmabuf_memories_setup        (GstVaDisplay * display,
                                                            GstVideoInfo * info,
                                                            guint n_planes,
@@ -778,36 +778,57 @@ gst_va_av1_dec_start_picture (GstAV1Decoder * decoder, GstAV1Picture * picture,
 }
 
 static gboolean
-gst_va_av1_dec_decode_tile (GstAV1Decoder * decoder, GstAV1Picture * picture,
-    GstAV1Tile * tile)
+gst_va_av1_dec_decode_tiles (GstAV1Decoder * decoder, GstAV1Picture * picture,
+    GstAV1Tile * tiles, guint num_tiles)
 {
   GstVaAV1Dec *self = GST_VA_AV1_DEC (decoder);
   GstVaBaseDec *base = GST_VA_BASE_DEC (decoder);
-  GstAV1TileGroupOBU *tile_group = &tile->tile_group;
   GstVaDecodePicture *va_pic;
-  guint i;
+  guint8 *data = tiles[0].obu.data;
+  gsize size;
+  guint i, j, n = 0;
   VASliceParameterBufferAV1 slice_param[GST_AV1_MAX_TILE_COUNT];
 
   GST_TRACE_OBJECT (self, "-");
 
-  for (i = 0; i < tile_group->tg_end - tile_group->tg_start + 1; i++) {
-    slice_param[i] = (VASliceParameterBufferAV1) {
-    };
-    slice_param[i].slice_data_size =
-        tile_group->entry[tile_group->tg_start + i].tile_size;
-    slice_param[i].slice_data_offset =
-        tile_group->entry[tile_group->tg_start + i].tile_offset;
-    slice_param[i].tile_row =
-        tile_group->entry[tile_group->tg_start + i].tile_row;
-    slice_param[i].tile_column =
-        tile_group->entry[tile_group->tg_start + i].tile_col;
-    slice_param[i].slice_data_flag = 0;
+  /* All tile groups of the frame come from the same input buffer, so a
+   * single slice data buffer spanning all of them is submitted, and the
+   * tile offsets are made relative to the first tile group */
+  for (i = 0; i < num_tiles; i++) {
+    GstAV1TileGroupOBU *tile_group = &tiles[i].tile_group;
+    guint32 tg_offset;
+
+    if (tiles[i].obu.data < data) {
+      GST_ERROR_OBJECT (self, "Tile groups are not in bitstream order");
+      return FALSE;
+    }
+
+    tg_offset = tiles[i].obu.data - data;
+
+    for (j = tile_group->tg_start; j <= tile_group->tg_end; j++) {
+      if (n >= GST_AV1_MAX_TILE_COUNT) {
+        GST_ERROR_OBJECT (self, "Too many tiles");
+        return FALSE;
+      }
+
+      slice_param[n] = (VASliceParameterBufferAV1) {
+      };
+      slice_param[n].slice_data_size = tile_group->entry[j].tile_size;
+      slice_param[n].slice_data_offset =
+          tg_offset + tile_group->entry[j].tile_offset;
+      slice_param[n].tile_row = tile_group->entry[j].tile_row;
+      slice_param[n].tile_column = tile_group->entry[j].tile_col;
+      slice_param[n].slice_data_flag = 0;
+      n++;
+    }
   }
 
+  size = tiles[num_tiles - 1].obu.data + tiles[num_tiles - 1].obu.obu_size -
+      data;
+
   va_pic = gst_av1_picture_get_user_data (picture);
   return gst_va_decoder_add_slice_buffer_with_n_params (base->decoder, va_pic,
-      slice_param, sizeof (VASliceParameterBufferAV1), i, tile->obu.data,
-      tile->obu.obu_size);
+      slice_param, sizeof (VASliceParameterBufferAV1), n, data, size);
 }
 
 static gboolean
@@ -917,8 +938,8 @@ gst_va_av1_dec_class_init (gpointer g_class, gpointer class_data)
       GST_DEBUG_FUNCPTR (gst_va_av1_dec_duplicate_picture);
   av1decoder_class->start_picture =
       GST_DEBUG_FUNCPTR (gst_va_av1_dec_start_picture);
-  av1decoder_class->decode_tile =
-      GST_DEBUG_FUNCPTR (gst_va_av1_dec_decode_tile);
+  av1decoder_class->decode_tiles =
+      GST_DEBUG_FUNCPTR (gst_va_av1_dec_decode_tiles);
   av1decoder_class->end_picture =
       GST_DEBUG_FUNCPTR (gst_va_av1_dec_end_picture);
   av1decoder_class->output_picture =
@@ -0,0 +1,980 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstvabaseenc.h"
+
+#include <gst/allocators/allocators.h>
+
+#include "gstvaallocator.h"
+#include "gstvacaps.h"
+#include "gstvapool.h"
+#include "gstvautils.h"
+
+#define GST_CAT_DEFAULT (base->debug_category)
+
+/* number of frames kept in flight in the hardware when the stream is
+ * not live */
+#define DEFAULT_OUTPUT_DELAY 4
+
+#define parent_class gst_va_base_enc_parent_class
+gpointer gst_va_base_enc_parent_class = NULL;
+
+extern GRecMutex GST_VA_SHARED_LOCK;
+
+GType
+gst_va_encoder_rate_control_get_type (void)
+{
+  static gsize type = 0;
+
+  static const GEnumValue values[] = {
+    {VA_RC_CQP, "Constant Quantizer", "cqp"},
+    {VA_RC_CBR, "Constant Bitrate", "cbr"},
+    {VA_RC_VBR, "Variable Bitrate", "vbr"},
+    {0, NULL, NULL}
+  };
+
+  if (g_once_init_enter (&type)) {
+    GType _type = g_enum_register_static ("GstVaEncoderRateControl", values);
+    g_once_init_leave (&type, _type);
+  }
+
+  return type;
+}
+
+GstVaEncFrame *
+gst_va_base_enc_get_frame (GstVideoCodecFrame * frame)
+{
+  return gst_video_codec_frame_get_user_data (frame);
+}
+
+void
+gst_va_enc_frame_free (gpointer frame)
+{
+  GstVaEncFrame *enc_frame = frame;
+
+  g_clear_pointer (&enc_frame->picture, gst_va_encode_picture_free);
+  g_free (enc_frame);
+}
+
+static gboolean
+gst_va_base_enc_open (GstVideoEncoder * venc)
+{
+  GstVaBaseEnc *base = GST_VA_BASE_ENC (venc);
+  GstVaBaseEncClass *klass = GST_VA_BASE_ENC_GET_CLASS (venc);
+  gboolean ret = FALSE;
+
+  if (!gst_va_ensure_element_data (venc, klass->render_device_path,
+          &base->display))
+    return FALSE;
+
+  if (!g_atomic_pointer_get (&base->encoder)) {
+    GstVaEncoder *va_encoder;
+
+    va_encoder = gst_va_encoder_new (base->display, klass->codec,
+        klass->entrypoint);
+    if (va_encoder)
+      ret = TRUE;
+
+    gst_object_replace ((GstObject **) (&base->encoder),
+        (GstObject *) va_encoder);
+    gst_clear_object (&va_encoder);
+  } else {
+    ret = TRUE;
+  }
+
+  return ret;
+}
+
+gboolean
+gst_va_base_enc_close (GstVideoEncoder * venc)
+{
+  GstVaBaseEnc *base = GST_VA_BASE_ENC (venc);
+
+  gst_clear_object (&base->encoder);
+  gst_clear_object (&base->display);
+
+  return TRUE;
+}
+
+/* Waits for the pending frames and releases them without output */
+static void
+_drop_pending_frames (GstVaBaseEnc * base)
+{
+  GstVideoCodecFrame *frame;
+
+  while ((frame = g_queue_pop_head (&base->output_list))) {
+    GstVaEncFrame *enc_frame = gst_va_base_enc_get_frame (frame);
+    GstBuffer *buf;
+
+    buf = gst_va_encoder_get_coded_buffer (base->encoder, enc_frame->picture);
+    gst_clear_buffer (&buf);
+    gst_video_codec_frame_unref (frame);
+  }
+}
+
+static void
+_release_raw_pool (GstVaBaseEnc * base)
+{
+  if (base->raw_pool)
+    gst_buffer_pool_set_active (base->raw_pool, FALSE);
+  gst_clear_object (&base->raw_pool);
+}
+
+static gboolean
+gst_va_base_enc_start (GstVideoEncoder * venc)
+{
+  GstVaBaseEnc *base = GST_VA_BASE_ENC (venc);
+
+  base->preferred_output_delay = DEFAULT_OUTPUT_DELAY;
+  base->is_live = FALSE;
+
+  return TRUE;
+}
+
+static gboolean
+gst_va_base_enc_stop (GstVideoEncoder * venc)
+{
+  GstVaBaseEnc *base = GST_VA_BASE_ENC (venc);
+  GstVaBaseEncClass *klass = GST_VA_BASE_ENC_GET_CLASS (venc);
+
+  _drop_pending_frames (base);
+
+  /* releases the reconstructed surfaces kept as references */
+  if (klass->reset_state)
+    klass->reset_state (base);
+
+  if (!gst_va_encoder_close (base->encoder))
+    return FALSE;
+
+  _release_raw_pool (base);
+
+  g_clear_pointer (&base->input_state, gst_video_codec_state_unref);
+
+  return TRUE;
+}
+
+static GstCaps *
+gst_va_base_enc_getcaps (GstVideoEncoder * venc, GstCaps * filter)
+{
+  GstCaps *caps = NULL, *tmp;
+  GstVaBaseEnc *base = GST_VA_BASE_ENC (venc);
+  GstVaEncoder *va_encoder = NULL;
+
+  gst_object_replace ((GstObject **) & va_encoder, (GstObject *) base->encoder);
+
+  if (va_encoder) {
+    caps = gst_va_encoder_get_sinkpad_caps (va_encoder);
+    gst_object_unref (va_encoder);
+  }
+
+  if (caps) {
+    if (filter) {
+      tmp = gst_caps_intersect_full (filter, caps, GST_CAPS_INTERSECT_FIRST);
+      gst_caps_unref (caps);
+      caps = tmp;
+    }
+    GST_LOG_OBJECT (base, "Returning caps %" GST_PTR_FORMAT, caps);
+  } else {
+    caps = gst_video_encoder_proxy_getcaps (venc, NULL, filter);
+  }
+
+  return caps;
+}
+
+static gboolean
+_query_context (GstVaBaseEnc * self, GstQuery * query)
+{
+  GstVaDisplay *display = NULL;
+  gboolean ret;
+
+  gst_object_replace ((GstObject **) & display, (GstObject *) self->display);
+  ret = gst_va_handle_context_query (GST_ELEMENT_CAST (self), query, display);
+  gst_clear_object (&display);
+
+  return ret;
+}
+
+static gboolean
+gst_va_base_enc_src_query (GstVideoEncoder * venc, GstQuery * query)
+{
+  if (GST_QUERY_TYPE (query) == GST_QUERY_CONTEXT)
+    return _query_context (GST_VA_BASE_ENC (venc), query);
+  return GST_VIDEO_ENCODER_CLASS (parent_class)->src_query (venc, query);
+}
+
+static gboolean
+gst_va_base_enc_sink_query (GstVideoEncoder * venc, GstQuery * query)
+{
+  if (GST_QUERY_TYPE (query) == GST_QUERY_CONTEXT)
+    return _query_context (GST_VA_BASE_ENC (venc), query);
+  return GST_VIDEO_ENCODER_CLASS (parent_class)->sink_query (venc, query);
+}
+
+static GstAllocator *
+_create_allocator (GstVaBaseEnc * base, GstCaps * caps)
+{
+  GstAllocator *allocator = NULL;
+
+  if (gst_caps_is_dmabuf (caps))
+    allocator = gst_va_dmabuf_allocator_new (base->display);
+  else {
+    GArray *surface_formats =
+        gst_va_encoder_get_surface_formats (base->encoder);
+    allocator = gst_va_allocator_new (base->display, surface_formats);
+  }
+
+  return allocator;
+}
+
+static GstBufferPool *
+_create_pool (GstCaps * caps, guint size, guint min_buffers,
+    GstAllocator * allocator, GstAllocationParams * params)
+{
+  GstBufferPool *pool;
+  GstStructure *config;
+
+  pool = gst_va_pool_new ();
+
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, caps, size, min_buffers, 0);
+  gst_buffer_pool_config_set_va_allocation_params (config,
+      VA_SURFACE_ATTRIB_USAGE_HINT_ENCODER);
+  gst_buffer_pool_config_set_allocator (config, allocator, params);
+  gst_buffer_pool_config_add_option (config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+
+  if (!gst_buffer_pool_set_config (pool, config))
+    gst_clear_object (&pool);
+
+  return pool;
+}
+
+/* Offer upstream a pool of VA surfaces so its frames can be encoded
+ * without a copy. The in flight frames are kept by the encoder, hence
+ * the minimum number of buffers. */
+static gboolean
+gst_va_base_enc_propose_allocation (GstVideoEncoder * venc, GstQuery * query)
+{
+  GstVaBaseEnc *base = GST_VA_BASE_ENC (venc);
+  GstAllocator *allocator;
+  GstAllocationParams params;
+  GstBufferPool *pool;
+  GstCaps *caps;
+  GstVideoInfo info;
+  gboolean need_pool = FALSE;
+  guint size, min_buffers;
+
+  gst_query_parse_allocation (query, &caps, &need_pool);
+
+  if (!caps)
+    return FALSE;
+
+  if (!gst_video_info_from_caps (&info, caps)) {
+    GST_ERROR_OBJECT (base, "Cannot parse caps %" GST_PTR_FORMAT, caps);
+    return FALSE;
+  }
+
+  if (!gst_va_encoder_is_open (base->encoder))
+    return GST_VIDEO_ENCODER_CLASS (parent_class)->propose_allocation (venc,
+        query);
+
+  size = GST_VIDEO_INFO_SIZE (&info);
+  min_buffers = base->preferred_output_delay + 1;
+
+  gst_allocation_params_init (&params);
+
+  if (!(allocator = _create_allocator (base, caps)))
+    return FALSE;
+
+  pool = _create_pool (caps, size, min_buffers, allocator, &params);
+  if (!pool) {
+    GST_ERROR_OBJECT (base, "failed to set config");
+    gst_object_unref (allocator);
+    return FALSE;
+  }
+
+  if (need_pool)
+    gst_query_add_allocation_pool (query, pool, size, min_buffers, 0);
+  gst_query_add_allocation_param (query, allocator, &params);
+  gst_query_add_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
+
+  GST_DEBUG_OBJECT (base,
+      "proposing %" GST_PTR_FORMAT " with allocator %" GST_PTR_FORMAT,
+      pool, allocator);
+
+  gst_object_unref (allocator);
+  gst_object_unref (pool);
+
+  return TRUE;
+}
+
+static inline gsize
+_get_plane_data_size (GstVideoInfo * info, guint plane)
+{
+  gint height, padded_height;
+
+  height = GST_VIDEO_INFO_HEIGHT (info);
+  padded_height =
+      GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (info->finfo, plane, height);
+
+  return GST_VIDEO_INFO_PLANE_STRIDE (info, plane) * padded_height;
+}
+
+static gboolean
+_try_import_dmabuf_unlocked (GstVaBaseEnc * base, GstBuffer * inbuf)
+{
+  GstVideoMeta *meta;
+  GstVideoInfo in_info = base->input_state->info;
+  GstMemory *mems[GST_VIDEO_MAX_PLANES];
+  guint i, n_mem, n_planes;
+  gsize offset[GST_VIDEO_MAX_PLANES];
+  uintptr_t fd[GST_VIDEO_MAX_PLANES];
+
+  n_planes = GST_VIDEO_INFO_N_PLANES (&in_info);
+  n_mem = gst_buffer_n_memory (inbuf);
+  meta = gst_buffer_get_video_meta (inbuf);
+
+  /* This will eliminate most non-dmabuf out there */
+  if (!gst_is_dmabuf_memory (gst_buffer_peek_memory (inbuf, 0)))
+    return FALSE;
+
+  /* We cannot have multiple dmabuf per plane */
+  if (n_mem > n_planes)
+    return FALSE;
+
+  /* Update video info based on video meta */
+  if (meta) {
+    GST_VIDEO_INFO_WIDTH (&in_info) = meta->width;
+    GST_VIDEO_INFO_HEIGHT (&in_info) = meta->height;
+
+    for (i = 0; i < meta->n_planes; i++) {
+      GST_VIDEO_INFO_PLANE_OFFSET (&in_info, i) = meta->offset[i];
+      GST_VIDEO_INFO_PLANE_STRIDE (&in_info, i) = meta->stride[i];
+    }
+  }
+
+  /* Find and validate all memories */
+  for (i = 0; i < n_planes; i++) {
+    guint plane_size;
+    guint length;
+    guint mem_idx;
+    gsize mem_skip;
+
+    plane_size = _get_plane_data_size (&in_info, i);
+
+    if (!gst_buffer_find_memory (inbuf, in_info.offset[i], plane_size,
+            &mem_idx, &length, &mem_skip))
+      return FALSE;
+
+    /* We can't have more then one dmabuf per plane */
+    if (length != 1)
+      return FALSE;
+
+    mems[i] = gst_buffer_peek_memory (inbuf, mem_idx);
+
+    /* And all memory found must be dmabuf */
+    if (!gst_is_dmabuf_memory (mems[i]))
+      return FALSE;
+
+    offset[i] = mems[i]->offset + mem_skip;
+    fd[i] = gst_dmabuf_memory_get_fd (mems[i]);
+  }
+
+  /* Now create a VASurfaceID for the buffer */
+  return gst_va_dmabuf_memories_setup (base->display, &in_info, n_planes, mems,
+      fd, offset, VA_SURFACE_ATTRIB_USAGE_HINT_ENCODER);
+}
+
+static gboolean
+_try_import_buffer (GstVaBaseEnc * base, GstBuffer * inbuf)
+{
+  VASurfaceID surface;
+  gboolean ret;
+
+  surface = gst_va_buffer_get_surface (inbuf);
+  if (surface != VA_INVALID_ID)
+    return TRUE;
+
+  g_rec_mutex_lock (&GST_VA_SHARED_LOCK);
+  ret = _try_import_dmabuf_unlocked (base, inbuf);
+  g_rec_mutex_unlock (&GST_VA_SHARED_LOCK);
+
+  return ret;
+}
+
+static GstBufferPool *
+_get_raw_pool (GstVaBaseEnc * base)
+{
+  GstAllocator *allocator;
+  GstAllocationParams params;
+  GstCaps *caps;
+  guint size;
+
+  if (base->raw_pool)
+    return base->raw_pool;
+
+  gst_allocation_params_init (&params);
+
+  caps = gst_video_info_to_caps (&base->input_state->info);
+  gst_caps_set_features_simple (caps,
+      gst_caps_features_from_string ("memory:VAMemory"));
+
+  size = GST_VIDEO_INFO_SIZE (&base->input_state->info);
+
+  allocator = _create_allocator (base, caps);
+  if (allocator) {
+    base->raw_pool = _create_pool (caps, size, 0, allocator, &params);
+
+    if (!gst_va_allocator_get_format (allocator, &base->raw_pool_info, NULL))
+      base->raw_pool_info = base->input_state->info;
+
+    gst_object_unref (allocator);
+  }
+
+  gst_caps_unref (caps);
+
+  if (base->raw_pool && !gst_buffer_pool_set_active (base->raw_pool, TRUE)) {
+    GST_WARNING_OBJECT (base, "Failed to activate the raw pool");
+    gst_clear_object (&base->raw_pool);
+  }
+
+  return base->raw_pool;
+}
+
+static GstFlowReturn
+_import_input_buffer (GstVaBaseEnc * base, GstBuffer * inbuf, GstBuffer ** buf)
+{
+  GstBuffer *buffer = NULL;
+  GstBufferPool *pool;
+  GstFlowReturn ret;
+  GstVideoFrame in_frame, out_frame;
+  gboolean imported, copied;
+
+  imported = _try_import_buffer (base, inbuf);
+  if (imported) {
+    *buf = gst_buffer_ref (inbuf);
+    return GST_FLOW_OK;
+  }
+
+  /* input buffer doesn't come from a vapool, thus it is required to
+   * have a pool, grab from it a new buffer and copy the input
+   * buffer to the new one */
+  if (!(pool = _get_raw_pool (base)))
+    return GST_FLOW_ERROR;
+
+  ret = gst_buffer_pool_acquire_buffer (pool, &buffer, NULL);
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  GST_LOG_OBJECT (base, "copying input frame");
+
+  if (!gst_video_frame_map (&in_frame, &base->input_state->info, inbuf,
+          GST_MAP_READ))
+    goto invalid_buffer;
+
+  if (!gst_video_frame_map (&out_frame, &base->raw_pool_info, buffer,
+          GST_MAP_WRITE)) {
+    gst_video_frame_unmap (&in_frame);
+    goto invalid_buffer;
+  }
+
+  copied = gst_video_frame_copy (&out_frame, &in_frame);
+
+  gst_video_frame_unmap (&out_frame);
+  gst_video_frame_unmap (&in_frame);
+
+  if (!copied)
+    goto invalid_buffer;
+
+  *buf = buffer;
+
+  return GST_FLOW_OK;
+
+invalid_buffer:
+  {
+    GST_ELEMENT_WARNING (base, CORE, NOT_IMPLEMENTED, (NULL),
+        ("invalid video buffer received"));
+    gst_buffer_unref (buffer);
+    return GST_FLOW_ERROR;
+  }
+}
+
+static GstFlowReturn
+_push_out_one_buffer (GstVaBaseEnc * base)
+{
+  GstVaBaseEncClass *klass = GST_VA_BASE_ENC_GET_CLASS (base);
+  GstVideoCodecFrame *frame;
+  GstVaEncFrame *enc_frame;
+  GstBuffer *buf;
+
+  frame = g_queue_pop_head (&base->output_list);
+  enc_frame = gst_va_base_enc_get_frame (frame);
+
+  buf = gst_va_encoder_get_coded_buffer (base->encoder, enc_frame->picture);
+
+  /* the input surface can go back upstream, the reconstructed one is
+   * kept while the frame is a reference */
+  gst_clear_buffer (&enc_frame->picture->raw_buffer);
+
+  if (!buf) {
+    GST_ELEMENT_ERROR (base, STREAM, ENCODE, (NULL),
+        ("Failed to read the coded data of frame %d",
+            frame->system_frame_number));
+    gst_video_encoder_finish_frame (GST_VIDEO_ENCODER (base), frame);
+    return GST_FLOW_ERROR;
+  }
+
+  if (klass->prepare_output)
+    klass->prepare_output (base, frame);
+
+  frame->output_buffer = buf;
+
+  GST_LOG_OBJECT (base, "Push to downstream: frame system_frame_number: %d,"
+      " pts: %" GST_TIME_FORMAT ", dts: %" GST_TIME_FORMAT
+      " duration: %" GST_TIME_FORMAT ", buffer size: %" G_GSIZE_FORMAT,
+      frame->system_frame_number, GST_TIME_ARGS (frame->pts),
+      GST_TIME_ARGS (frame->dts), GST_TIME_ARGS (frame->duration),
+      gst_buffer_get_size (buf));
+
+  return gst_video_encoder_finish_frame (GST_VIDEO_ENCODER (base), frame);
+}
+
+static GstFlowReturn
+_push_out_buffers (GstVaBaseEnc * base, guint num_pending)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  while (g_queue_get_length (&base->output_list) > num_pending) {
+    GstFlowReturn flow_ret = _push_out_one_buffer (base);
+
+    /* keep draining, but report the first error */
+    if (flow_ret != GST_FLOW_OK && ret == GST_FLOW_OK)
+      ret = flow_ret;
+  }
+
+  return ret;
+}
+
+static void
+gst_va_base_enc_set_latency (GstVaBaseEnc * base)
+{
+  GstClockTime latency;
+  gint fps_n = 25, fps_d = 1;
+
+  if (base->input_state && GST_VIDEO_INFO_FPS_N (&base->input_state->info)) {
+    fps_n = GST_VIDEO_INFO_FPS_N (&base->input_state->info);
+    fps_d = GST_VIDEO_INFO_FPS_D (&base->input_state->info);
+  }
+
+  latency = gst_util_uint64_scale_int (base->preferred_output_delay *
+      GST_SECOND, fps_d, fps_n);
+
+  GST_LOG_OBJECT (base, "latency %" GST_TIME_FORMAT, GST_TIME_ARGS (latency));
+
+  gst_video_encoder_set_latency (GST_VIDEO_ENCODER (base), latency, latency);
+}
+
+static gboolean
+gst_va_base_enc_set_format (GstVideoEncoder * venc, GstVideoCodecState * state)
+{
+  GstVaBaseEnc *base = GST_VA_BASE_ENC (venc);
+  GstVaBaseEncClass *klass = GST_VA_BASE_ENC_GET_CLASS (venc);
+  GstQuery *query;
+
+  g_return_val_if_fail (state->caps != NULL, FALSE);
+
+  /* finish the frames encoded with the previous configuration */
+  if (_push_out_buffers (base, 0) != GST_FLOW_OK)
+    return FALSE;
+
+  if (klass->reset_state)
+    klass->reset_state (base);
+
+  if (!gst_va_encoder_close (base->encoder)) {
+    GST_ERROR_OBJECT (base, "Failed to close the previous encoder");
+    return FALSE;
+  }
+
+  _release_raw_pool (base);
+
+  if (base->input_state)
+    gst_video_codec_state_unref (base->input_state);
+  base->input_state = gst_video_codec_state_ref (state);
+
+  base->is_live = FALSE;
+  query = gst_query_new_latency ();
+  if (gst_pad_peer_query (GST_VIDEO_ENCODER_SINK_PAD (venc), query))
+    gst_query_parse_latency (query, &base->is_live, NULL, NULL);
+  gst_query_unref (query);
+
+  /* a live source can't wait for the hardware pipeline to fill up */
+  base->preferred_output_delay = base->is_live ? 0 : DEFAULT_OUTPUT_DELAY;
+
+  if (!klass->reconfig (base)) {
+    GST_ERROR_OBJECT (base, "Failed to configure the encoder");
+    return FALSE;
+  }
+
+  gst_va_base_enc_set_latency (base);
+
+  return gst_video_encoder_negotiate (venc);
+}
+
+static GstFlowReturn
+gst_va_base_enc_handle_frame (GstVideoEncoder * venc,
+    GstVideoCodecFrame * frame)
+{
+  GstVaBaseEnc *base = GST_VA_BASE_ENC (venc);
+  GstVaBaseEncClass *klass = GST_VA_BASE_ENC_GET_CLASS (venc);
+  GstVaEncFrame *enc_frame;
+  GstBuffer *in_buf = NULL;
+  GstFlowReturn ret;
+
+  GST_LOG_OBJECT (venc, "handle frame id %d, dts %" GST_TIME_FORMAT
+      ", pts %" GST_TIME_FORMAT, frame->system_frame_number,
+      GST_TIME_ARGS (GST_BUFFER_DTS (frame->input_buffer)),
+      GST_TIME_ARGS (GST_BUFFER_PTS (frame->input_buffer)));
+
+  ret = _import_input_buffer (base, frame->input_buffer, &in_buf);
+  if (ret != GST_FLOW_OK)
+    goto error_buffer_invalid;
+
+  if (!klass->new_frame (base, frame)) {
+    gst_buffer_unref (in_buf);
+    goto error_new_frame;
+  }
+
+  enc_frame = gst_va_base_enc_get_frame (frame);
+  enc_frame->picture = gst_va_encode_picture_new (base->encoder, in_buf);
+  gst_buffer_unref (in_buf);
+
+  if (!enc_frame->picture)
+    goto error_new_frame;
+
+  if (!klass->encode_frame (base, frame))
+    goto error_encode;
+
+  g_queue_push_tail (&base->output_list, frame);
+
+  return _push_out_buffers (base, base->preferred_output_delay);
+
+error_buffer_invalid:
+  {
+    if (ret != GST_FLOW_FLUSHING) {
+      GST_ELEMENT_ERROR (venc, STREAM, ENCODE,
+          ("Failed to import the input frame."), (NULL));
+    }
+    gst_clear_buffer (&in_buf);
+    gst_video_encoder_finish_frame (venc, frame);
+    return ret;
+  }
+error_new_frame:
+  {
+    GST_ELEMENT_ERROR (venc, STREAM, ENCODE,
+        ("Failed to create the input frame."), (NULL));
+    gst_video_encoder_finish_frame (venc, frame);
+    return GST_FLOW_ERROR;
+  }
+error_encode:
+  {
+    GST_ELEMENT_ERROR (venc, STREAM, ENCODE,
+        ("Failed to encode the frame."), (NULL));
+    gst_video_encoder_finish_frame (venc, frame);
+    return GST_FLOW_ERROR;
+  }
+}
+
+static GstFlowReturn
+gst_va_base_enc_finish (GstVideoEncoder * venc)
+{
+  GstVaBaseEnc *base = GST_VA_BASE_ENC (venc);
+
+  return _push_out_buffers (base, 0);
+}
+
+static gboolean
+gst_va_base_enc_flush (GstVideoEncoder * venc)
+{
+  GstVaBaseEnc *base = GST_VA_BASE_ENC (venc);
+  GstVaBaseEncClass *klass = GST_VA_BASE_ENC_GET_CLASS (venc);
+
+  _drop_pending_frames (base);
+
+  if (klass->reset_state)
+    klass->reset_state (base);
+
+  return GST_VIDEO_ENCODER_CLASS (parent_class)->flush (venc);
+}
+
+static void
+gst_va_base_enc_set_context (GstElement * element, GstContext * context)
+{
+  GstVaDisplay *old_display, *new_display;
+  GstVaBaseEnc *base = GST_VA_BASE_ENC (element);
+  GstVaBaseEncClass *klass = GST_VA_BASE_ENC_GET_CLASS (base);
+  gboolean ret;
+
+  old_display = base->display ? gst_object_ref (base->display) : NULL;
+  ret = gst_va_handle_set_context (element, context, klass->render_device_path,
+      &base->display);
+  new_display = base->display ? gst_object_ref (base->display) : NULL;
+
+  if (!ret
+      || (old_display && new_display && old_display != new_display
+          && base->encoder)) {
+    GST_ELEMENT_WARNING (base, RESOURCE, BUSY,
+        ("Can't replace VA display while operating"), (NULL));
+  }
+
+  gst_clear_object (&old_display);
+  gst_clear_object (&new_display);
+
+  GST_ELEMENT_CLASS (parent_class)->set_context (element, context);
+}
+
+void
+gst_va_base_enc_init (GstVaBaseEnc * base, GstDebugCategory * cat)
+{
+  base->debug_category = cat;
+  g_queue_init (&base->output_list);
+}
+
+void
+gst_va_base_enc_class_init (GstVaBaseEncClass * klass, GstVaCodecs codec,
+    VAEntrypoint entrypoint, const gchar * render_device_path,
+    GstCaps * sink_caps, GstCaps * src_caps, GstCaps * doc_src_caps,
+    GstCaps * doc_sink_caps)
+{
+  GstPadTemplate *sink_pad_templ, *src_pad_templ;
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstVideoEncoderClass *encoder_class = GST_VIDEO_ENCODER_CLASS (klass);
+
+  gst_va_base_enc_parent_class = g_type_class_peek_parent (klass);
+
+  klass->codec = codec;
+  klass->entrypoint = entrypoint;
+  klass->render_device_path = g_strdup (render_device_path);
+
+  sink_pad_templ = gst_pad_template_new ("sink", GST_PAD_SINK, GST_PAD_ALWAYS,
+      sink_caps);
+  gst_element_class_add_pad_template (element_class, sink_pad_templ);
+
+  if (doc_sink_caps) {
+    gst_pad_template_set_documentation_caps (sink_pad_templ, doc_sink_caps);
+    gst_caps_unref (doc_sink_caps);
+  }
+
+  src_pad_templ = gst_pad_template_new ("src", GST_PAD_SRC, GST_PAD_ALWAYS,
+      src_caps);
+  gst_element_class_add_pad_template (element_class, src_pad_templ);
+
+  if (doc_src_caps) {
+    gst_pad_template_set_documentation_caps (src_pad_templ, doc_src_caps);
+    gst_caps_unref (doc_src_caps);
+  }
+
+  element_class->set_context = GST_DEBUG_FUNCPTR (gst_va_base_enc_set_context);
+
+  encoder_class->open = GST_DEBUG_FUNCPTR (gst_va_base_enc_open);
+  encoder_class->close = GST_DEBUG_FUNCPTR (gst_va_base_enc_close);
+  encoder_class->start = GST_DEBUG_FUNCPTR (gst_va_base_enc_start);
+  encoder_class->stop = GST_DEBUG_FUNCPTR (gst_va_base_enc_stop);
+  encoder_class->getcaps = GST_DEBUG_FUNCPTR (gst_va_base_enc_getcaps);
+  encoder_class->src_query = GST_DEBUG_FUNCPTR (gst_va_base_enc_src_query);
+  encoder_class->sink_query = GST_DEBUG_FUNCPTR (gst_va_base_enc_sink_query);
+  encoder_class->propose_allocation =
+      GST_DEBUG_FUNCPTR (gst_va_base_enc_propose_allocation);
+  encoder_class->set_format = GST_DEBUG_FUNCPTR (gst_va_base_enc_set_format);
+  encoder_class->handle_frame =
+      GST_DEBUG_FUNCPTR (gst_va_base_enc_handle_frame);
+  encoder_class->finish = GST_DEBUG_FUNCPTR (gst_va_base_enc_finish);
+  encoder_class->flush = GST_DEBUG_FUNCPTR (gst_va_base_enc_flush);
+}
+
+/* Falls back to another supported mode if @rc_mode is not available
+ * for @profile. Returns 0 if the driver doesn't report any. */
+guint32
+gst_va_base_enc_get_rate_control (GstVaBaseEnc * base, VAProfile profile,
+    guint32 rc_mode)
+{
+  static const guint32 fallbacks[] = { VA_RC_CQP, VA_RC_CBR, VA_RC_VBR };
+  guint32 rc_modes;
+  guint i;
+
+  rc_modes = gst_va_encoder_get_rate_control_mode (base->encoder, profile);
+
+  if (rc_modes & rc_mode)
+    return rc_mode;
+
+  for (i = 0; i < G_N_ELEMENTS (fallbacks); i++) {
+    if (rc_modes & fallbacks[i]) {
+      GST_WARNING_OBJECT (base, "Rate control mode %#x is not supported, "
+          "using %#x", rc_mode, fallbacks[i]);
+      return fallbacks[i];
+    }
+  }
+
+  return 0;
+}
+
+gboolean
+gst_va_base_enc_add_rate_control_parameter (GstVaBaseEnc * base,
+    GstVaEncodePicture * picture, guint32 rc_mode, guint bitrate,
+    guint target_percentage, guint qp_i, guint min_qp)
+{
+  /* *INDENT-OFF* */
+  struct
+  {
+    VAEncMiscParameterType type;
+    VAEncMiscParameterRateControl rate_control;
+  } rate_control = {
+    .type = VAEncMiscParameterTypeRateControl,
+    .rate_control = {
+      .bits_per_second = bitrate * 1000,
+      .target_percentage = target_percentage,
+      .window_size = 1000,
+      .initial_qp = qp_i,
+      .min_qp = min_qp,
+      .rc_flags.bits.disable_frame_skip = 1,
+    },
+  };
+  /* *INDENT-ON* */
+
+  if (rc_mode == VA_RC_CQP || rc_mode == 0)
+    return TRUE;
+
+  if (!gst_va_encoder_add_param (base->encoder, picture,
+          VAEncMiscParameterBufferType, &rate_control,
+          sizeof (rate_control))) {
+    GST_ERROR_OBJECT (base, "Failed to create the rate control parameter");
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+gboolean
+gst_va_base_enc_add_frame_rate_parameter (GstVaBaseEnc * base,
+    GstVaEncodePicture * picture)
+{
+  gint fps_n = GST_VIDEO_INFO_FPS_N (&base->input_state->info);
+  gint fps_d = GST_VIDEO_INFO_FPS_D (&base->input_state->info);
+  /* *INDENT-OFF* */
+  struct
+  {
+    VAEncMiscParameterType type;
+    VAEncMiscParameterFrameRate fr;
+  } framerate = {
+    .type = VAEncMiscParameterTypeFrameRate,
+  };
+  /* *INDENT-ON* */
+
+  if (fps_n <= 0 || fps_d <= 0)
+    return TRUE;
+
+  /* the denominator goes in the upper 16 bits, when it fits */
+  if (fps_n <= G_MAXUINT16 && fps_d <= G_MAXUINT16)
+    framerate.fr.framerate = ((guint32) fps_d << 16) | fps_n;
+  else
+    framerate.fr.framerate = MAX (1, fps_n / fps_d);
+
+  if (!gst_va_encoder_add_param (base->encoder, picture,
+          VAEncMiscParameterBufferType, &framerate, sizeof (framerate))) {
+    GST_ERROR_OBJECT (base, "Failed to create the frame rate parameter");
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+gboolean
+gst_va_base_enc_add_hrd_parameter (GstVaBaseEnc * base,
+    GstVaEncodePicture * picture, guint32 rc_mode, guint bitrate)
+{
+  /* *INDENT-OFF* */
+  struct
+  {
+    VAEncMiscParameterType type;
+    VAEncMiscParameterHRD hrd;
+  } hrd = {
+    .type = VAEncMiscParameterTypeHRD,
+    .hrd = {
+      /* one second of buffering, starting half full */
+      .buffer_size = bitrate * 1000,
+      .initial_buffer_fullness = bitrate * 500,
+    },
+  };
+  /* *INDENT-ON* */
+
+  if (rc_mode == VA_RC_CQP || rc_mode == 0)
+    return TRUE;
+
+  if (!gst_va_encoder_add_param (base->encoder, picture,
+          VAEncMiscParameterBufferType, &hrd, sizeof (hrd))) {
+    GST_ERROR_OBJECT (base, "Failed to create the HRD parameter");
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* Bitstream helpers for the packed headers, which are written without
+ * emulation prevention bytes */
+
+gboolean
+gst_va_bit_writer_put_ue (GstBitWriter * bw, guint32 value)
+{
+  guint32 code;
+  guint nbits;
+
+  g_return_val_if_fail (value < G_MAXUINT32, FALSE);
+
+  code = value + 1;
+  nbits = g_bit_storage (code);
+
+  /* nbits - 1 leading zeros followed by the code */
+  if (nbits > 1 && !gst_bit_writer_put_bits_uint32 (bw, 0, nbits - 1))
+    return FALSE;
+
+  return gst_bit_writer_put_bits_uint32 (bw, code, nbits);
+}
+
+gboolean
+gst_va_bit_writer_put_se (GstBitWriter * bw, gint32 value)
+{
+  guint32 code;
+
+  if (value > 0)
+    code = 2 * (guint32) value - 1;
+  else
+    code = -2 * (gint64) value;
+
+  return gst_va_bit_writer_put_ue (bw, code);
+}
+
+gboolean
+gst_va_bit_writer_put_trailing_bits (GstBitWriter * bw)
+{
+  if (!gst_bit_writer_put_bits_uint8 (bw, 1, 1))
+    return FALSE;
+
+  return gst_bit_writer_align_bytes (bw, 0);
+}
@@ -0,0 +1,143 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#pragma once
+
+#include <gst/base/gstbitwriter.h>
+#include <gst/video/video.h>
+
+#include "gstvadevice.h"
+#include "gstvaencoder.h"
+#include "gstvaprofile.h"
+
+G_BEGIN_DECLS
+
+#define GST_VA_BASE_ENC(obj) ((GstVaBaseEnc *)(obj))
+#define GST_VA_BASE_ENC_GET_CLASS(obj) (G_TYPE_INSTANCE_GET_CLASS ((obj), G_TYPE_FROM_INSTANCE (obj), GstVaBaseEncClass))
+#define GST_VA_BASE_ENC_CLASS(klass) ((GstVaBaseEncClass *)(klass))
+
+#define GST_TYPE_VA_ENCODER_RATE_CONTROL (gst_va_encoder_rate_control_get_type())
+GType gst_va_encoder_rate_control_get_type (void);
+
+typedef struct _GstVaBaseEnc GstVaBaseEnc;
+typedef struct _GstVaBaseEncClass GstVaBaseEncClass;
+typedef struct _GstVaEncFrame GstVaEncFrame;
+
+/* Codec specific frame data, set as user data of each
+ * GstVideoCodecFrame, must start with this structure. */
+struct _GstVaEncFrame
+{
+  GstVaEncodePicture *picture;
+};
+
+struct _GstVaBaseEnc
+{
+  /* <private> */
+  GstVideoEncoder parent;
+
+  GstDebugCategory *debug_category;
+
+  GstVaDisplay *display;
+  GstVaEncoder *encoder;
+
+  GstVideoCodecState *input_state;
+
+  /* number of submitted frames whose coded data is not waited for */
+  guint preferred_output_delay;
+  gboolean is_live;
+
+  GstBufferPool *raw_pool;
+  GstVideoInfo raw_pool_info;
+
+  /* frames submitted to the driver, in encoding order */
+  GQueue output_list;
+};
+
+struct _GstVaBaseEncClass
+{
+  /* <private> */
+  GstVideoEncoderClass parent_class;
+
+  /* configures and opens base->encoder for base->input_state, and
+   * sets the output state */
+  gboolean (*reconfig)        (GstVaBaseEnc * encoder);
+  /* restarts the coded video sequence */
+  void     (*reset_state)     (GstVaBaseEnc * encoder);
+  /* sets a GstVaEncFrame derived structure as @frame user data */
+  gboolean (*new_frame)       (GstVaBaseEnc * encoder,
+                               GstVideoCodecFrame * frame);
+  /* fills the parameters of @frame picture and submits it */
+  gboolean (*encode_frame)    (GstVaBaseEnc * encoder,
+                               GstVideoCodecFrame * frame);
+  /* finishes @frame before it's pushed downstream */
+  void     (*prepare_output)  (GstVaBaseEnc * encoder,
+                               GstVideoCodecFrame * frame);
+
+  GstVaCodecs codec;
+  VAEntrypoint entrypoint;
+  gchar *render_device_path;
+};
+
+struct CData
+{
+  gchar *render_device_path;
+  gchar *description;
+  GstCaps *sink_caps;
+  GstCaps *src_caps;
+  VAEntrypoint entrypoint;
+};
+
+void                  gst_va_base_enc_init                (GstVaBaseEnc * base,
+                                                           GstDebugCategory * cat);
+void                  gst_va_base_enc_class_init          (GstVaBaseEncClass * klass,
+                                                           GstVaCodecs codec,
+                                                           VAEntrypoint entrypoint,
+                                                           const gchar * render_device_path,
+                                                           GstCaps * sink_caps,
+                                                           GstCaps * src_caps,
+                                                           GstCaps * doc_src_caps,
+                                                           GstCaps * doc_sink_caps);
+
+gboolean              gst_va_base_enc_close               (GstVideoEncoder * encoder);
+GstVaEncFrame *       gst_va_base_enc_get_frame           (GstVideoCodecFrame * frame);
+void                  gst_va_enc_frame_free               (gpointer frame);
+guint32               gst_va_base_enc_get_rate_control    (GstVaBaseEnc * base,
+                                                           VAProfile profile,
+                                                           guint32 rc_mode);
+
+gboolean              gst_va_base_enc_add_rate_control_parameter (GstVaBaseEnc * base,
+                                                           GstVaEncodePicture * picture,
+                                                           guint32 rc_mode,
+                                                           guint bitrate,
+                                                           guint target_percentage,
+                                                           guint qp_i,
+                                                           guint min_qp);
+gboolean              gst_va_base_enc_add_frame_rate_parameter (GstVaBaseEnc * base,
+                                                           GstVaEncodePicture * picture);
+gboolean              gst_va_base_enc_add_hrd_parameter   (GstVaBaseEnc * base,
+                                                           GstVaEncodePicture * picture,
+                                                           guint32 rc_mode,
+                                                           guint bitrate);
+
+gboolean              gst_va_bit_writer_put_ue            (GstBitWriter * bw,
+                                                           guint32 value);
+gboolean              gst_va_bit_writer_put_se            (GstBitWriter * bw,
+                                                           gint32 value);
+gboolean              gst_va_bit_writer_put_trailing_bits (GstBitWriter * bw);
+
+G_END_DECLS
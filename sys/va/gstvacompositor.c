@@ -0,0 +1,1044 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-vacompositor
+ * @title: vacompositor
+ * @short_description: A VA-API based video compositor
+ *
+ * vacompositor blends several VA surfaces into one output surface,
+ * without mapping them onto main memory. Each sink pad has its own
+ * position, size and alpha, and the pictures are stacked following
+ * their zorder.
+ *
+ * The blending is done by the
+ * [VA-API](https://01.org/linuxmedia/vaapi) driver's post-processor,
+ * thus alpha is only honored if the driver supports global alpha
+ * blending.
+ *
+ * ## Example launch line
+ * ```
+ * gst-launch-1.0 vacompositor name=c sink_1::xpos=320 sink_1::alpha=0.5 ! vapostproc ! autovideosink \
+ *     videotestsrc ! video/x-raw,width=320,height=240 ! vapostproc ! c. \
+ *     videotestsrc pattern=ball ! video/x-raw,width=320,height=240 ! vapostproc ! c.
+ * ```
+ *
+ * Since: 1.20
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstvacompositor.h"
+
+#include <gst/video/video.h>
+#include <gst/video/gstvideoaggregator.h>
+
+#include "gstvaallocator.h"
+#include "gstvacaps.h"
+#include "gstvadisplay_drm.h"
+#include "gstvafilter.h"
+#include "gstvapool.h"
+#include "gstvautils.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_va_compositor_debug);
+#define GST_CAT_DEFAULT gst_va_compositor_debug
+
+#define GST_VA_COMPOSITOR(obj)           ((GstVaCompositor *) obj)
+#define GST_VA_COMPOSITOR_GET_CLASS(obj) (G_TYPE_INSTANCE_GET_CLASS ((obj), G_TYPE_FROM_INSTANCE (obj), GstVaCompositorClass))
+#define GST_VA_COMPOSITOR_CLASS(klass)    ((GstVaCompositorClass *) klass)
+
+typedef struct _GstVaCompositor GstVaCompositor;
+typedef struct _GstVaCompositorClass GstVaCompositorClass;
+
+struct _GstVaCompositorClass
+{
+  GstVideoAggregatorClass parent_class;
+
+  gchar *render_device_path;
+};
+
+struct _GstVaCompositor
+{
+  GstVideoAggregator parent;
+
+  GstVaDisplay *display;
+  GstVaFilter *filter;
+};
+
+static GstElementClass *parent_class = NULL;
+
+struct CData
+{
+  gchar *render_device_path;
+  gchar *description;
+};
+
+/* *INDENT-OFF* */
+static const gchar *caps_str = GST_VIDEO_CAPS_MAKE_WITH_FEATURES ("memory:VAMemory",
+            "{ NV12, I420, YV12, YUY2, RGBA, BGRA, P010_10LE, ARGB, ABGR }");
+/* *INDENT-ON* */
+
+/* sink pads */
+
+#define GST_TYPE_VA_COMPOSITOR_PAD (gst_va_compositor_pad_get_type ())
+#define GST_VA_COMPOSITOR_PAD(obj) ((GstVaCompositorPad *) obj)
+
+typedef struct _GstVaCompositorPad GstVaCompositorPad;
+typedef struct _GstVaCompositorPadClass GstVaCompositorPadClass;
+
+struct _GstVaCompositorPad
+{
+  GstVideoAggregatorPad parent;
+
+  /* properties */
+  gint xpos;
+  gint ypos;
+  gint width;
+  gint height;
+  gdouble alpha;
+};
+
+struct _GstVaCompositorPadClass
+{
+  GstVideoAggregatorPadClass parent_class;
+};
+
+enum
+{
+  PROP_PAD_0,
+  PROP_PAD_XPOS,
+  PROP_PAD_YPOS,
+  PROP_PAD_WIDTH,
+  PROP_PAD_HEIGHT,
+  PROP_PAD_ALPHA,
+};
+
+#define DEFAULT_PAD_XPOS   0
+#define DEFAULT_PAD_YPOS   0
+#define DEFAULT_PAD_WIDTH  0
+#define DEFAULT_PAD_HEIGHT 0
+#define DEFAULT_PAD_ALPHA  1.0
+
+static GType gst_va_compositor_pad_get_type (void);
+G_DEFINE_TYPE (GstVaCompositorPad, gst_va_compositor_pad,
+    GST_TYPE_VIDEO_AGGREGATOR_PAD);
+
+static void
+gst_va_compositor_pad_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstVaCompositorPad *pad = GST_VA_COMPOSITOR_PAD (object);
+
+  switch (prop_id) {
+    case PROP_PAD_XPOS:
+      pad->xpos = g_value_get_int (value);
+      break;
+    case PROP_PAD_YPOS:
+      pad->ypos = g_value_get_int (value);
+      break;
+    case PROP_PAD_WIDTH:
+      pad->width = g_value_get_int (value);
+      break;
+    case PROP_PAD_HEIGHT:
+      pad->height = g_value_get_int (value);
+      break;
+    case PROP_PAD_ALPHA:
+      pad->alpha = g_value_get_double (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_va_compositor_pad_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstVaCompositorPad *pad = GST_VA_COMPOSITOR_PAD (object);
+
+  switch (prop_id) {
+    case PROP_PAD_XPOS:
+      g_value_set_int (value, pad->xpos);
+      break;
+    case PROP_PAD_YPOS:
+      g_value_set_int (value, pad->ypos);
+      break;
+    case PROP_PAD_WIDTH:
+      g_value_set_int (value, pad->width);
+      break;
+    case PROP_PAD_HEIGHT:
+      g_value_set_int (value, pad->height);
+      break;
+    case PROP_PAD_ALPHA:
+      g_value_set_double (value, pad->alpha);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_va_compositor_pad_get_output_size (GstVaCompositorPad * cpad,
+    gint out_par_n, gint out_par_d, gint * width, gint * height)
+{
+  GstVideoAggregatorPad *vagg_pad = GST_VIDEO_AGGREGATOR_PAD (cpad);
+  gint pad_width, pad_height;
+  guint dar_n, dar_d;
+
+  if (!vagg_pad->info.finfo
+      || vagg_pad->info.finfo->format == GST_VIDEO_FORMAT_UNKNOWN) {
+    GST_DEBUG_OBJECT (cpad, "Have no caps yet");
+    *width = 0;
+    *height = 0;
+    return;
+  }
+
+  pad_width = cpad->width <= 0 ?
+      GST_VIDEO_INFO_WIDTH (&vagg_pad->info) : cpad->width;
+  pad_height = cpad->height <= 0 ?
+      GST_VIDEO_INFO_HEIGHT (&vagg_pad->info) : cpad->height;
+
+  if (!gst_video_calculate_display_ratio (&dar_n, &dar_d, pad_width, pad_height,
+          GST_VIDEO_INFO_PAR_N (&vagg_pad->info),
+          GST_VIDEO_INFO_PAR_D (&vagg_pad->info), out_par_n, out_par_d)) {
+    GST_WARNING_OBJECT (cpad, "Cannot calculate display aspect ratio");
+    *width = *height = 0;
+    return;
+  }
+
+  /* Pick either height or width, whichever is an integer multiple of the
+   * display aspect ratio. However, prefer preserving the height to account
+   * for interlaced video. */
+  if (pad_height % dar_n == 0) {
+    pad_width = gst_util_uint64_scale_int (pad_height, dar_n, dar_d);
+  } else if (pad_width % dar_d == 0) {
+    pad_height = gst_util_uint64_scale_int (pad_width, dar_d, dar_n);
+  } else {
+    pad_width = gst_util_uint64_scale_int (pad_height, dar_n, dar_d);
+  }
+
+  *width = pad_width;
+  *height = pad_height;
+}
+
+/* Fills the regions of @sample with the visible part of @cpad's frame
+ * in the output frame. Returns FALSE if nothing is visible. */
+static gboolean
+gst_va_compositor_pad_get_regions (GstVaCompositorPad * cpad,
+    GstVideoInfo * out_info, GstVaComposeSample * sample)
+{
+  GstVideoInfo *in_info = &GST_VIDEO_AGGREGATOR_PAD (cpad)->info;
+  gint width, height, x1, y1, x2, y2;
+  gint in_width, in_height;
+
+  gst_va_compositor_pad_get_output_size (cpad, GST_VIDEO_INFO_PAR_N (out_info),
+      GST_VIDEO_INFO_PAR_D (out_info), &width, &height);
+
+  if (width <= 0 || height <= 0)
+    return FALSE;
+
+  x1 = CLAMP (cpad->xpos, 0, GST_VIDEO_INFO_WIDTH (out_info));
+  y1 = CLAMP (cpad->ypos, 0, GST_VIDEO_INFO_HEIGHT (out_info));
+  x2 = CLAMP (cpad->xpos + width, 0, GST_VIDEO_INFO_WIDTH (out_info));
+  y2 = CLAMP (cpad->ypos + height, 0, GST_VIDEO_INFO_HEIGHT (out_info));
+
+  if (x2 <= x1 || y2 <= y1)
+    return FALSE;
+
+  in_width = GST_VIDEO_INFO_WIDTH (in_info);
+  in_height = GST_VIDEO_INFO_HEIGHT (in_info);
+
+  /* *INDENT-OFF* */
+  sample->output_region = (VARectangle) {
+    .x = x1,
+    .y = y1,
+    .width = x2 - x1,
+    .height = y2 - y1,
+  };
+
+  /* crop the input as much as the output was clamped */
+  sample->input_region = (VARectangle) {
+    .x = gst_util_uint64_scale_int (x1 - cpad->xpos, in_width, width),
+    .y = gst_util_uint64_scale_int (y1 - cpad->ypos, in_height, height),
+    .width = gst_util_uint64_scale_int (x2 - x1, in_width, width),
+    .height = gst_util_uint64_scale_int (y2 - y1, in_height, height),
+  };
+  /* *INDENT-ON* */
+
+  if (sample->input_region.width == 0 || sample->input_region.height == 0)
+    return FALSE;
+
+  sample->info = in_info;
+  sample->alpha = cpad->alpha;
+
+  return TRUE;
+}
+
+/* The input surfaces are handed to the driver as they are, so there's
+ * no need to map them. */
+static gboolean
+gst_va_compositor_pad_prepare_frame (GstVideoAggregatorPad * pad,
+    GstVideoAggregator * vagg, GstBuffer * buffer,
+    GstVideoFrame * prepared_frame)
+{
+  if (gst_va_buffer_get_surface (buffer) == VA_INVALID_ID) {
+    GST_ERROR_OBJECT (pad, "Input buffer is not a VA surface");
+    return FALSE;
+  }
+
+  prepared_frame->info = pad->info;
+  prepared_frame->buffer = gst_buffer_ref (buffer);
+
+  return TRUE;
+}
+
+static void
+gst_va_compositor_pad_clean_frame (GstVideoAggregatorPad * pad,
+    GstVideoAggregator * vagg, GstVideoFrame * prepared_frame)
+{
+  gst_clear_buffer (&prepared_frame->buffer);
+  memset (prepared_frame, 0, sizeof (GstVideoFrame));
+}
+
+static void
+gst_va_compositor_pad_class_init (GstVaCompositorPadClass * klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GstVideoAggregatorPadClass *vaggpad_class =
+      GST_VIDEO_AGGREGATOR_PAD_CLASS (klass);
+
+  object_class->set_property = gst_va_compositor_pad_set_property;
+  object_class->get_property = gst_va_compositor_pad_get_property;
+
+  g_object_class_install_property (object_class, PROP_PAD_XPOS,
+      g_param_spec_int ("xpos", "X Position", "X position of the picture",
+          G_MININT, G_MAXINT, DEFAULT_PAD_XPOS,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_PAD_YPOS,
+      g_param_spec_int ("ypos", "Y Position", "Y position of the picture",
+          G_MININT, G_MAXINT, DEFAULT_PAD_YPOS,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_PAD_WIDTH,
+      g_param_spec_int ("width", "Width",
+          "Width of the picture (0: input width)", 0, G_MAXINT,
+          DEFAULT_PAD_WIDTH,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_PAD_HEIGHT,
+      g_param_spec_int ("height", "Height",
+          "Height of the picture (0: input height)", 0, G_MAXINT,
+          DEFAULT_PAD_HEIGHT,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_PAD_ALPHA,
+      g_param_spec_double ("alpha", "Alpha", "Alpha of the picture", 0.0, 1.0,
+          DEFAULT_PAD_ALPHA,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  vaggpad_class->prepare_frame =
+      GST_DEBUG_FUNCPTR (gst_va_compositor_pad_prepare_frame);
+  vaggpad_class->clean_frame =
+      GST_DEBUG_FUNCPTR (gst_va_compositor_pad_clean_frame);
+}
+
+static void
+gst_va_compositor_pad_init (GstVaCompositorPad * pad)
+{
+  pad->xpos = DEFAULT_PAD_XPOS;
+  pad->ypos = DEFAULT_PAD_YPOS;
+  pad->width = DEFAULT_PAD_WIDTH;
+  pad->height = DEFAULT_PAD_HEIGHT;
+  pad->alpha = DEFAULT_PAD_ALPHA;
+}
+
+/* element */
+
+static void
+gst_va_compositor_dispose (GObject * object)
+{
+  GstVaCompositor *self = GST_VA_COMPOSITOR (object);
+
+  gst_clear_object (&self->filter);
+  gst_clear_object (&self->display);
+
+  G_OBJECT_CLASS (parent_class)->dispose (object);
+}
+
+static GstStateChangeReturn
+gst_va_compositor_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstVaCompositor *self = GST_VA_COMPOSITOR (element);
+  GstVaCompositorClass *klass = GST_VA_COMPOSITOR_GET_CLASS (element);
+  GstStateChangeReturn ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_NULL_TO_READY:
+      if (!gst_va_ensure_element_data (element, klass->render_device_path,
+              &self->display))
+        goto open_failed;
+      if (!self->filter)
+        self->filter = gst_va_filter_new (self->display);
+      if (!gst_va_filter_open (self->filter))
+        goto open_failed;
+      break;
+    default:
+      break;
+  }
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_NULL:
+      if (self->filter)
+        gst_va_filter_close (self->filter);
+      gst_clear_object (&self->filter);
+      gst_clear_object (&self->display);
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+
+  /* Errors */
+open_failed:
+  {
+    GST_ELEMENT_ERROR (self, LIBRARY, INIT, (NULL), ("Failed to open VPP"));
+    return GST_STATE_CHANGE_FAILURE;
+  }
+}
+
+static void
+gst_va_compositor_set_context (GstElement * element, GstContext * context)
+{
+  GstVaDisplay *old_display, *new_display;
+  GstVaCompositor *self = GST_VA_COMPOSITOR (element);
+  GstVaCompositorClass *klass = GST_VA_COMPOSITOR_GET_CLASS (self);
+  gboolean ret;
+
+  old_display = self->display ? gst_object_ref (self->display) : NULL;
+  ret = gst_va_handle_set_context (element, context, klass->render_device_path,
+      &self->display);
+  new_display = self->display ? gst_object_ref (self->display) : NULL;
+
+  if (!ret
+      || (old_display && new_display && old_display != new_display
+          && self->filter)) {
+    GST_ELEMENT_WARNING (element, RESOURCE, BUSY,
+        ("Can't replace VA display while operating"), (NULL));
+  }
+
+  gst_clear_object (&old_display);
+  gst_clear_object (&new_display);
+
+  GST_ELEMENT_CLASS (parent_class)->set_context (element, context);
+}
+
+static GstPad *
+gst_va_compositor_request_new_pad (GstElement * element,
+    GstPadTemplate * templ, const gchar * name, const GstCaps * caps)
+{
+  GstPad *pad;
+
+  pad = GST_ELEMENT_CLASS (parent_class)->request_new_pad (element,
+      templ, name, caps);
+  if (!pad) {
+    GST_DEBUG_OBJECT (element, "could not create/add pad");
+    return NULL;
+  }
+
+  gst_child_proxy_child_added (GST_CHILD_PROXY (element), G_OBJECT (pad),
+      GST_OBJECT_NAME (pad));
+
+  GST_DEBUG_OBJECT (element, "Created new pad %s:%s", GST_DEBUG_PAD_NAME (pad));
+
+  return pad;
+}
+
+static void
+gst_va_compositor_release_pad (GstElement * element, GstPad * pad)
+{
+  GST_DEBUG_OBJECT (element, "Releasing pad %s:%s", GST_DEBUG_PAD_NAME (pad));
+
+  gst_child_proxy_child_removed (GST_CHILD_PROXY (element), G_OBJECT (pad),
+      GST_OBJECT_NAME (pad));
+
+  GST_ELEMENT_CLASS (parent_class)->release_pad (element, pad);
+}
+
+static gboolean
+_handle_context_query (GstVaCompositor * self, GstQuery * query)
+{
+  GstVaDisplay *display = NULL;
+  gboolean ret;
+
+  gst_object_replace ((GstObject **) & display, (GstObject *) self->display);
+  ret = gst_va_handle_context_query (GST_ELEMENT_CAST (self), query, display);
+  gst_clear_object (&display);
+
+  return ret;
+}
+
+static gboolean
+gst_va_compositor_sink_query (GstAggregator * aggregator,
+    GstAggregatorPad * pad, GstQuery * query)
+{
+  GstVaCompositor *self = GST_VA_COMPOSITOR (aggregator);
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CONTEXT:
+      if (_handle_context_query (self, query))
+        return TRUE;
+      break;
+    case GST_QUERY_CAPS:{
+      GstCaps *filter, *caps;
+
+      /* every input is scaled and converted by the driver, so any
+       * of the template caps is fine, regardless other pads */
+      gst_query_parse_caps (query, &filter);
+      caps = gst_pad_get_pad_template_caps (GST_PAD (pad));
+      if (filter) {
+        GstCaps *tmp = gst_caps_intersect_full (filter, caps,
+            GST_CAPS_INTERSECT_FIRST);
+        gst_caps_unref (caps);
+        caps = tmp;
+      }
+      gst_query_set_caps_result (query, caps);
+      gst_caps_unref (caps);
+      return TRUE;
+    }
+    case GST_QUERY_ACCEPT_CAPS:{
+      GstCaps *caps, *templ;
+
+      gst_query_parse_accept_caps (query, &caps);
+      templ = gst_pad_get_pad_template_caps (GST_PAD (pad));
+      gst_query_set_accept_caps_result (query,
+          gst_caps_can_intersect (caps, templ));
+      gst_caps_unref (templ);
+      return TRUE;
+    }
+    default:
+      break;
+  }
+
+  return GST_AGGREGATOR_CLASS (parent_class)->sink_query (aggregator, pad,
+      query);
+}
+
+static gboolean
+gst_va_compositor_src_query (GstAggregator * aggregator, GstQuery * query)
+{
+  GstVaCompositor *self = GST_VA_COMPOSITOR (aggregator);
+
+  if (GST_QUERY_TYPE (query) == GST_QUERY_CONTEXT
+      && _handle_context_query (self, query))
+    return TRUE;
+
+  return GST_AGGREGATOR_CLASS (parent_class)->src_query (aggregator, query);
+}
+
+static GstCaps *
+gst_va_compositor_fixate_src_caps (GstAggregator * aggregator, GstCaps * caps)
+{
+  GstVideoAggregator *vagg = GST_VIDEO_AGGREGATOR (aggregator);
+  GList *l;
+  gint best_width = -1, best_height = -1;
+  gint best_fps_n = -1, best_fps_d = -1;
+  gint par_n, par_d;
+  gdouble best_fps = 0.;
+  GstCaps *ret;
+  GstStructure *s;
+
+  ret = gst_caps_make_writable (caps);
+
+  /* we need this to calculate how large to make the output frame */
+  s = gst_caps_get_structure (ret, 0);
+  if (gst_structure_has_field (s, "pixel-aspect-ratio")) {
+    gst_structure_fixate_field_nearest_fraction (s, "pixel-aspect-ratio", 1, 1);
+    gst_structure_get_fraction (s, "pixel-aspect-ratio", &par_n, &par_d);
+  } else {
+    par_n = par_d = 1;
+  }
+
+  GST_OBJECT_LOCK (vagg);
+  for (l = GST_ELEMENT (vagg)->sinkpads; l; l = l->next) {
+    GstVideoAggregatorPad *vaggpad = l->data;
+    GstVaCompositorPad *cpad = GST_VA_COMPOSITOR_PAD (vaggpad);
+    gint this_width, this_height;
+    gint width, height;
+    gint fps_n, fps_d;
+    gdouble cur_fps;
+
+    fps_n = GST_VIDEO_INFO_FPS_N (&vaggpad->info);
+    fps_d = GST_VIDEO_INFO_FPS_D (&vaggpad->info);
+    gst_va_compositor_pad_get_output_size (cpad, par_n, par_d, &width,
+        &height);
+
+    if (width == 0 || height == 0)
+      continue;
+
+    this_width = width + MAX (cpad->xpos, 0);
+    this_height = height + MAX (cpad->ypos, 0);
+
+    if (best_width < this_width)
+      best_width = this_width;
+    if (best_height < this_height)
+      best_height = this_height;
+
+    if (fps_d == 0)
+      cur_fps = 0.0;
+    else
+      gst_util_fraction_to_double (fps_n, fps_d, &cur_fps);
+
+    if (best_fps < cur_fps) {
+      best_fps = cur_fps;
+      best_fps_n = fps_n;
+      best_fps_d = fps_d;
+    }
+  }
+  GST_OBJECT_UNLOCK (vagg);
+
+  if (best_fps_n <= 0 || best_fps_d <= 0 || best_fps == 0.0) {
+    best_fps_n = 25;
+    best_fps_d = 1;
+    best_fps = 25.0;
+  }
+
+  gst_structure_fixate_field_nearest_int (s, "width", best_width);
+  gst_structure_fixate_field_nearest_int (s, "height", best_height);
+  gst_structure_fixate_field_nearest_fraction (s, "framerate", best_fps_n,
+      best_fps_d);
+  ret = gst_caps_fixate (ret);
+
+  GST_LOG_OBJECT (aggregator, "Fixated caps %" GST_PTR_FORMAT, ret);
+
+  return ret;
+}
+
+static gboolean
+gst_va_compositor_negotiated_src_caps (GstAggregator * aggregator,
+    GstCaps * caps)
+{
+  GstVaCompositor *self = GST_VA_COMPOSITOR (aggregator);
+  GstVideoInfo info;
+
+  if (!gst_video_info_from_caps (&info, caps))
+    return FALSE;
+
+  /* only the output part is used when composing */
+  if (!gst_va_filter_set_formats (self->filter, &info, &info))
+    return FALSE;
+
+  return GST_AGGREGATOR_CLASS (parent_class)->negotiated_src_caps (aggregator,
+      caps);
+}
+
+static GstBufferPool *
+_create_pool (GstVaCompositor * self, GstCaps * caps, guint size,
+    guint min_buffers, guint max_buffers, guint usage_hint,
+    GstAllocator ** allocator_out)
+{
+  GstAllocator *allocator;
+  GstBufferPool *pool;
+  GstStructure *config;
+
+  allocator = gst_va_allocator_new (self->display,
+      gst_va_filter_get_surface_formats (self->filter));
+
+  pool = gst_va_pool_new ();
+
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, caps, size, min_buffers,
+      max_buffers);
+  gst_buffer_pool_config_set_va_allocation_params (config, usage_hint);
+  gst_buffer_pool_config_set_allocator (config, allocator, NULL);
+  gst_buffer_pool_config_add_option (config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+
+  if (!gst_buffer_pool_set_config (pool, config)) {
+    gst_clear_object (&pool);
+    gst_clear_object (&allocator);
+  }
+
+  *allocator_out = allocator;
+
+  return pool;
+}
+
+static gboolean
+gst_va_compositor_propose_allocation (GstAggregator * aggregator,
+    GstAggregatorPad * pad, GstQuery * decide_query, GstQuery * query)
+{
+  GstVaCompositor *self = GST_VA_COMPOSITOR (aggregator);
+  GstAllocator *allocator = NULL;
+  GstBufferPool *pool;
+  GstVideoInfo info;
+  GstCaps *caps;
+  guint size;
+
+  gst_query_parse_allocation (query, &caps, NULL);
+
+  if (caps == NULL)
+    return FALSE;
+
+  if (!gst_video_info_from_caps (&info, caps))
+    return FALSE;
+
+  if (gst_query_get_n_allocation_pools (query) == 0) {
+    size = GST_VIDEO_INFO_SIZE (&info);
+
+    /* it migth be used by a va decoder */
+    pool = _create_pool (self, caps, size, 0, 0,
+        VA_SURFACE_ATTRIB_USAGE_HINT_GENERIC, &allocator);
+    if (!pool) {
+      GST_ERROR_OBJECT (self, "failed to set config");
+      return FALSE;
+    }
+
+    gst_query_add_allocation_param (query, allocator, NULL);
+    gst_query_add_allocation_pool (query, pool, size, 0, 0);
+
+    gst_object_unref (allocator);
+    gst_object_unref (pool);
+  }
+
+  gst_query_add_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
+
+  return TRUE;
+}
+
+/* output buffers must be from our VA-based pool, they cannot be
+ * system-allocated */
+static gboolean
+gst_va_compositor_decide_allocation (GstAggregator * aggregator,
+    GstQuery * query)
+{
+  GstVaCompositor *self = GST_VA_COMPOSITOR (aggregator);
+  GstAllocator *allocator = NULL;
+  GstBufferPool *pool;
+  GstVideoInfo info;
+  GstCaps *caps;
+  guint size, min = 0, max = 0;
+
+  gst_query_parse_allocation (query, &caps, NULL);
+
+  if (!caps || !gst_video_info_from_caps (&info, caps)) {
+    GST_DEBUG_OBJECT (self, "No output caps");
+    return FALSE;
+  }
+
+  if (gst_query_get_n_allocation_pools (query) > 0)
+    gst_query_parse_nth_allocation_pool (query, 0, NULL, NULL, &min, &max);
+
+  size = GST_VIDEO_INFO_SIZE (&info);
+
+  pool = _create_pool (self, caps, size, min, max,
+      VA_SURFACE_ATTRIB_USAGE_HINT_VPP_WRITE, &allocator);
+  if (!pool) {
+    GST_ERROR_OBJECT (self, "failed to set config");
+    return FALSE;
+  }
+
+  if (gst_query_get_n_allocation_params (query) > 0)
+    gst_query_set_nth_allocation_param (query, 0, allocator, NULL);
+  else
+    gst_query_add_allocation_param (query, allocator, NULL);
+
+  if (gst_query_get_n_allocation_pools (query) > 0)
+    gst_query_set_nth_allocation_pool (query, 0, pool, size, min, max);
+  else
+    gst_query_add_allocation_pool (query, pool, size, min, max);
+
+  GST_DEBUG_OBJECT (self, "decided pool %" GST_PTR_FORMAT, pool);
+
+  gst_object_unref (allocator);
+  gst_object_unref (pool);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_va_compositor_aggregate_frames (GstVideoAggregator * vagg,
+    GstBuffer * outbuf)
+{
+  GstVaCompositor *self = GST_VA_COMPOSITOR (vagg);
+  GstVaComposeSample *samples;
+  VASurfaceID out_surface;
+  GList *l;
+  guint num = 0;
+  gboolean ret;
+
+  out_surface = gst_va_buffer_get_surface (outbuf);
+  if (out_surface == VA_INVALID_ID) {
+    GST_ERROR_OBJECT (self, "Output buffer is not a VA surface");
+    return GST_FLOW_ERROR;
+  }
+
+  GST_OBJECT_LOCK (self);
+  samples = g_new (GstVaComposeSample, GST_ELEMENT (self)->numsinkpads);
+
+  /* sink pads are sorted by zorder */
+  for (l = GST_ELEMENT (self)->sinkpads; l; l = l->next) {
+    GstVideoAggregatorPad *pad = l->data;
+    GstVideoFrame *prepared_frame =
+        gst_video_aggregator_pad_get_prepared_frame (pad);
+
+    if (!prepared_frame)
+      continue;
+
+    if (!gst_va_compositor_pad_get_regions (GST_VA_COMPOSITOR_PAD (pad),
+            &vagg->info, &samples[num]))
+      continue;
+
+    samples[num].surface = gst_va_buffer_get_surface (prepared_frame->buffer);
+    num++;
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  if (num == 0) {
+    /* nothing to blend, the driver can't clear the surface on its
+     * own */
+    GST_LOG_OBJECT (self, "No visible input, marking output as gap");
+    GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_GAP);
+    g_free (samples);
+    return GST_FLOW_OK;
+  }
+
+  ret = gst_va_filter_compose (self->filter, samples, num, out_surface);
+  g_free (samples);
+
+  if (!ret) {
+    GST_ELEMENT_ERROR (self, STREAM, FAILED, (NULL),
+        ("Failed to compose %u surfaces", num));
+    return GST_FLOW_ERROR;
+  }
+
+  return GST_FLOW_OK;
+}
+
+static GObject *
+gst_va_compositor_child_proxy_get_child_by_index (GstChildProxy * proxy,
+    guint index)
+{
+  GstVaCompositor *self = GST_VA_COMPOSITOR (proxy);
+  GObject *obj = NULL;
+
+  GST_OBJECT_LOCK (self);
+  obj = g_list_nth_data (GST_ELEMENT_CAST (self)->sinkpads, index);
+  if (obj)
+    gst_object_ref (obj);
+  GST_OBJECT_UNLOCK (self);
+
+  return obj;
+}
+
+static guint
+gst_va_compositor_child_proxy_get_children_count (GstChildProxy * proxy)
+{
+  GstVaCompositor *self = GST_VA_COMPOSITOR (proxy);
+  guint count;
+
+  GST_OBJECT_LOCK (self);
+  count = GST_ELEMENT_CAST (self)->numsinkpads;
+  GST_OBJECT_UNLOCK (self);
+
+  return count;
+}
+
+static void
+gst_va_compositor_child_proxy_init (gpointer g_iface, gpointer iface_data)
+{
+  GstChildProxyInterface *iface = g_iface;
+
+  iface->get_child_by_index = gst_va_compositor_child_proxy_get_child_by_index;
+  iface->get_children_count = gst_va_compositor_child_proxy_get_children_count;
+}
+
+static void
+gst_va_compositor_class_init (gpointer g_class, gpointer class_data)
+{
+  GstCaps *doc_caps, *filter_caps, *caps = NULL;
+  GstPadTemplate *sink_pad_templ, *src_pad_templ;
+  GObjectClass *object_class = G_OBJECT_CLASS (g_class);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (g_class);
+  GstAggregatorClass *agg_class = GST_AGGREGATOR_CLASS (g_class);
+  GstVideoAggregatorClass *vagg_class = GST_VIDEO_AGGREGATOR_CLASS (g_class);
+  GstVaDisplay *display;
+  GstVaFilter *filter;
+  GstVaCompositorClass *klass = GST_VA_COMPOSITOR_CLASS (g_class);
+  struct CData *cdata = class_data;
+  gchar *long_name;
+
+  parent_class = g_type_class_peek_parent (g_class);
+
+  klass->render_device_path = g_strdup (cdata->render_device_path);
+
+  if (cdata->description) {
+    long_name = g_strdup_printf ("VA-API Video Compositor in %s",
+        cdata->description);
+  } else {
+    long_name = g_strdup ("VA-API Video Compositor");
+  }
+
+  gst_element_class_set_metadata (element_class, long_name,
+      "Filter/Editor/Video/Compositor/Hardware",
+      "VA-API based video compositor", "GStreamer developers");
+
+  doc_caps = gst_caps_from_string (caps_str);
+
+  display = gst_va_display_drm_new_from_path (klass->render_device_path);
+  filter = gst_va_filter_new (display);
+
+  if (gst_va_filter_open (filter)) {
+    filter_caps = gst_va_filter_get_caps (filter);
+    caps = gst_caps_intersect (filter_caps, doc_caps);
+    gst_caps_unref (filter_caps);
+  } else {
+    caps = gst_caps_ref (doc_caps);
+  }
+
+  sink_pad_templ = gst_pad_template_new_with_gtype ("sink_%u", GST_PAD_SINK,
+      GST_PAD_REQUEST, caps, GST_TYPE_VA_COMPOSITOR_PAD);
+  gst_element_class_add_pad_template (element_class, sink_pad_templ);
+  gst_pad_template_set_documentation_caps (sink_pad_templ,
+      gst_caps_ref (doc_caps));
+
+  src_pad_templ = gst_pad_template_new_with_gtype ("src", GST_PAD_SRC,
+      GST_PAD_ALWAYS, caps, GST_TYPE_AGGREGATOR_PAD);
+  gst_element_class_add_pad_template (element_class, src_pad_templ);
+  gst_pad_template_set_documentation_caps (src_pad_templ,
+      gst_caps_ref (doc_caps));
+  gst_caps_unref (doc_caps);
+
+  gst_caps_unref (caps);
+
+  object_class->dispose = gst_va_compositor_dispose;
+
+  element_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_va_compositor_change_state);
+  element_class->set_context = GST_DEBUG_FUNCPTR (gst_va_compositor_set_context);
+  element_class->request_new_pad =
+      GST_DEBUG_FUNCPTR (gst_va_compositor_request_new_pad);
+  element_class->release_pad =
+      GST_DEBUG_FUNCPTR (gst_va_compositor_release_pad);
+
+  agg_class->sink_query = GST_DEBUG_FUNCPTR (gst_va_compositor_sink_query);
+  agg_class->src_query = GST_DEBUG_FUNCPTR (gst_va_compositor_src_query);
+  agg_class->fixate_src_caps =
+      GST_DEBUG_FUNCPTR (gst_va_compositor_fixate_src_caps);
+  agg_class->negotiated_src_caps =
+      GST_DEBUG_FUNCPTR (gst_va_compositor_negotiated_src_caps);
+  agg_class->propose_allocation =
+      GST_DEBUG_FUNCPTR (gst_va_compositor_propose_allocation);
+  agg_class->decide_allocation =
+      GST_DEBUG_FUNCPTR (gst_va_compositor_decide_allocation);
+
+  vagg_class->aggregate_frames =
+      GST_DEBUG_FUNCPTR (gst_va_compositor_aggregate_frames);
+
+  gst_type_mark_as_plugin_api (GST_TYPE_VA_COMPOSITOR_PAD, 0);
+
+  g_free (long_name);
+  g_free (cdata->description);
+  g_free (cdata->render_device_path);
+  g_free (cdata);
+  gst_object_unref (filter);
+  gst_object_unref (display);
+}
+
+static void
+gst_va_compositor_init (GTypeInstance * instance, gpointer g_class)
+{
+}
+
+static gpointer
+_register_debug_category (gpointer data)
+{
+  GST_DEBUG_CATEGORY_INIT (gst_va_compositor_debug, "vacompositor", 0,
+      "VA Video Compositor");
+
+  return NULL;
+}
+
+gboolean
+gst_va_compositor_register (GstPlugin * plugin, GstVaDevice * device,
+    guint rank)
+{
+  static GOnce debug_once = G_ONCE_INIT;
+  GType type;
+  GTypeInfo type_info = {
+    .class_size = sizeof (GstVaCompositorClass),
+    .class_init = gst_va_compositor_class_init,
+    .instance_size = sizeof (GstVaCompositor),
+    .instance_init = gst_va_compositor_init,
+  };
+  const GInterfaceInfo child_proxy_info = {
+    gst_va_compositor_child_proxy_init, NULL, NULL
+  };
+  struct CData *cdata;
+  gboolean ret;
+  gchar *type_name, *feature_name;
+
+  g_return_val_if_fail (GST_IS_PLUGIN (plugin), FALSE);
+  g_return_val_if_fail (GST_IS_VA_DEVICE (device), FALSE);
+
+  cdata = g_new (struct CData, 1);
+  cdata->description = NULL;
+  cdata->render_device_path = g_strdup (device->render_device_path);
+
+  type_info.class_data = cdata;
+
+  type_name = g_strdup ("GstVaCompositor");
+  feature_name = g_strdup ("vacompositor");
+
+  /* The first compositor to be registered should use a constant
+   * name, like vacompositor, for any additional compositors, we
+   * create unique names, using inserting the render device name. */
+  if (g_type_from_name (type_name)) {
+    gchar *basename = g_path_get_basename (device->render_device_path);
+    g_free (type_name);
+    g_free (feature_name);
+    type_name = g_strdup_printf ("GstVa%sCompositor", basename);
+    feature_name = g_strdup_printf ("va%scompositor", basename);
+    cdata->description = basename;
+
+    /* lower rank for non-first device */
+    if (rank > 0)
+      rank--;
+  }
+
+  g_once (&debug_once, _register_debug_category, NULL);
+
+  type = g_type_register_static (GST_TYPE_VIDEO_AGGREGATOR, type_name,
+      &type_info, 0);
+  g_type_add_interface_static (type, GST_TYPE_CHILD_PROXY, &child_proxy_info);
+
+  ret = gst_element_register (plugin, feature_name, rank, type);
+
+  g_free (type_name);
+  g_free (feature_name);
+
+  return ret;
+}
@@ -0,0 +1,914 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstvaencoder.h"
+
+#include <string.h>
+
+#include "gstvaallocator.h"
+#include "gstvacaps.h"
+#include "gstvadisplay_wrapped.h"
+#include "gstvapool.h"
+#include "gstvavideoformat.h"
+
+/* room for the packed headers the driver writes with the slice data */
+#define CODED_BUFFER_HEADROOM 4096
+
+struct _GstVaEncoder
+{
+  GstObject parent;
+
+  GArray *available_profiles;
+  GstCaps *srcpad_caps;
+  GstCaps *sinkpad_caps;
+  GstVaDisplay *display;
+  VAEntrypoint entrypoint;
+  VAConfigID config;
+  VAContextID context;
+  VAProfile profile;
+  guint rt_format;
+  gint coded_width;
+  gint coded_height;
+  guint codedbuf_size;
+
+  GstBufferPool *recon_pool;
+};
+
+GST_DEBUG_CATEGORY_STATIC (gst_va_encoder_debug);
+#define GST_CAT_DEFAULT gst_va_encoder_debug
+
+#define gst_va_encoder_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstVaEncoder, gst_va_encoder, GST_TYPE_OBJECT,
+    GST_DEBUG_CATEGORY_INIT (gst_va_encoder_debug, "vaencoder", 0,
+        "VA Encoder"));
+
+enum
+{
+  PROP_DISPLAY = 1,
+  PROP_PROFILE,
+  PROP_WIDTH,
+  PROP_HEIGHT,
+  PROP_CHROMA,
+  N_PROPERTIES
+};
+
+static GParamSpec *g_properties[N_PROPERTIES];
+
+static gboolean _destroy_buffers (GstVaEncodePicture * pic);
+
+static void
+gst_va_encoder_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstVaEncoder *self = GST_VA_ENCODER (object);
+
+  switch (prop_id) {
+    case PROP_DISPLAY:{
+      g_assert (!self->display);
+      self->display = g_value_dup_object (value);
+      break;
+    }
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_va_encoder_get_property (GObject * object, guint prop_id, GValue * value,
+    GParamSpec * pspec)
+{
+  GstVaEncoder *self = GST_VA_ENCODER (object);
+
+  switch (prop_id) {
+    case PROP_DISPLAY:
+      g_value_set_object (value, self->display);
+      break;
+    case PROP_PROFILE:
+      g_value_set_int (value, self->profile);
+      break;
+    case PROP_CHROMA:
+      g_value_set_uint (value, self->rt_format);
+      break;
+    case PROP_WIDTH:
+      g_value_set_int (value, self->coded_width);
+      break;
+    case PROP_HEIGHT:
+      g_value_set_int (value, self->coded_height);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_va_encoder_dispose (GObject * object)
+{
+  GstVaEncoder *self = GST_VA_ENCODER (object);
+
+  gst_va_encoder_close (self);
+
+  g_clear_pointer (&self->available_profiles, g_array_unref);
+  gst_clear_object (&self->display);
+
+  G_OBJECT_CLASS (parent_class)->dispose (object);
+}
+
+static void
+gst_va_encoder_class_init (GstVaEncoderClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->set_property = gst_va_encoder_set_property;
+  gobject_class->get_property = gst_va_encoder_get_property;
+  gobject_class->dispose = gst_va_encoder_dispose;
+
+  g_properties[PROP_DISPLAY] =
+      g_param_spec_object ("display", "GstVaDisplay", "GstVADisplay object",
+      GST_TYPE_VA_DISPLAY,
+      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
+
+  g_properties[PROP_PROFILE] =
+      g_param_spec_int ("va-profile", "VAProfile", "VA Profile",
+      VAProfileNone, 50, VAProfileNone,
+      G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+
+  g_properties[PROP_CHROMA] =
+      g_param_spec_uint ("va-rt-format", "VARTFormat", "VA RT Fromat or chroma",
+      VA_RT_FORMAT_YUV420, VA_RT_FORMAT_PROTECTED, VA_RT_FORMAT_YUV420,
+      G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+
+  g_properties[PROP_WIDTH] =
+      g_param_spec_int ("coded-width", "coded-picture-width",
+      "coded picture width", 0, G_MAXINT, 0,
+      G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+
+  g_properties[PROP_HEIGHT] =
+      g_param_spec_int ("coded-height", "coded-picture-height",
+      "coded picture height", 0, G_MAXINT, 0,
+      G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+
+  g_object_class_install_properties (gobject_class, N_PROPERTIES, g_properties);
+}
+
+static void
+gst_va_encoder_init (GstVaEncoder * self)
+{
+  self->profile = VAProfileNone;
+  self->config = VA_INVALID_ID;
+  self->context = VA_INVALID_ID;
+  self->rt_format = 0;
+  self->coded_width = 0;
+  self->coded_height = 0;
+  self->codedbuf_size = 0;
+}
+
+static gboolean
+gst_va_encoder_initialize (GstVaEncoder * self, guint32 codec)
+{
+  if (self->available_profiles)
+    return FALSE;
+
+  self->available_profiles = gst_va_display_get_profiles (self->display, codec,
+      self->entrypoint);
+
+  return (self->available_profiles != NULL);
+}
+
+GstVaEncoder *
+gst_va_encoder_new (GstVaDisplay * display, guint32 codec,
+    VAEntrypoint entrypoint)
+{
+  GstVaEncoder *self;
+
+  g_return_val_if_fail (GST_IS_VA_DISPLAY (display), NULL);
+
+  self = g_object_new (GST_TYPE_VA_ENCODER, "display", display, NULL);
+  self->entrypoint = entrypoint;
+  if (!gst_va_encoder_initialize (self, codec))
+    gst_clear_object (&self);
+
+  return self;
+}
+
+gboolean
+gst_va_encoder_is_open (GstVaEncoder * self)
+{
+  gboolean ret;
+
+  g_return_val_if_fail (GST_IS_VA_ENCODER (self), FALSE);
+
+  GST_OBJECT_LOCK (self);
+  ret = (self->config != VA_INVALID_ID && self->profile != VAProfileNone);
+  GST_OBJECT_UNLOCK (self);
+  return ret;
+}
+
+gboolean
+gst_va_encoder_is_low_power (GstVaEncoder * self)
+{
+  g_return_val_if_fail (GST_IS_VA_ENCODER (self), FALSE);
+
+  return self->entrypoint == VAEntrypointEncSliceLP;
+}
+
+static GstBufferPool *
+_create_reconstruct_pool (GstVaDisplay * display, GArray * surface_formats,
+    GstVideoFormat format, gint coded_width, gint coded_height,
+    guint max_buffers)
+{
+  GstAllocator *allocator;
+  GstAllocationParams params = { 0, };
+  GstBufferPool *pool;
+  GstStructure *config;
+  GstVideoInfo info;
+  GstCaps *caps;
+
+  gst_video_info_set_format (&info, format, coded_width, coded_height);
+  caps = gst_video_info_to_caps (&info);
+  gst_caps_set_features_simple (caps,
+      gst_caps_features_from_string ("memory:VAMemory"));
+
+  allocator = gst_va_allocator_new (display, surface_formats);
+
+  pool = gst_va_pool_new ();
+
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, caps,
+      GST_VIDEO_INFO_SIZE (&info), 0, max_buffers);
+  gst_buffer_pool_config_set_va_allocation_params (config,
+      VA_SURFACE_ATTRIB_USAGE_HINT_ENCODER);
+  gst_buffer_pool_config_set_allocator (config, allocator, &params);
+
+  gst_caps_unref (caps);
+  gst_object_unref (allocator);
+
+  if (!gst_buffer_pool_set_config (pool, config)) {
+    gst_object_unref (pool);
+    return NULL;
+  }
+
+  if (!gst_buffer_pool_set_active (pool, TRUE)) {
+    gst_object_unref (pool);
+    return NULL;
+  }
+
+  return pool;
+}
+
+gboolean
+gst_va_encoder_open (GstVaEncoder * self, VAProfile profile, guint rt_format,
+    GstVideoFormat video_format, gint coded_width, gint coded_height,
+    guint32 rc_ctrl, guint32 packed_headers, guint max_reconstruct_surfaces)
+{
+  VAConfigAttrib attribs[3] = {
+    {.type = VAConfigAttribRTFormat,.value = rt_format,},
+  };
+  guint num_attribs = 1;
+  GstBufferPool *recon_pool;
+  GstVideoInfo info;
+  VAConfigID config;
+  VAContextID context;
+  VADisplay dpy;
+  VAStatus status;
+
+  g_return_val_if_fail (GST_IS_VA_ENCODER (self), FALSE);
+
+  if (gst_va_encoder_is_open (self))
+    return TRUE;
+
+  if (!gst_va_encoder_has_profile (self, profile)) {
+    GST_ERROR_OBJECT (self, "Unsupported profile: %d", profile);
+    return FALSE;
+  }
+
+  if (rc_ctrl != 0) {
+    attribs[num_attribs].type = VAConfigAttribRateControl;
+    attribs[num_attribs].value = rc_ctrl;
+    num_attribs++;
+  }
+
+  if (packed_headers != 0) {
+    attribs[num_attribs].type = VAConfigAttribEncPackedHeaders;
+    attribs[num_attribs].value = packed_headers;
+    num_attribs++;
+  }
+
+  dpy = gst_va_display_get_va_dpy (self->display);
+
+  gst_va_display_lock (self->display);
+  status = vaCreateConfig (dpy, profile, self->entrypoint, attribs, num_attribs,
+      &config);
+  gst_va_display_unlock (self->display);
+  if (status != VA_STATUS_SUCCESS) {
+    GST_ERROR_OBJECT (self, "vaCreateConfig: %s", vaErrorStr (status));
+    return FALSE;
+  }
+
+  /* reconstructed surfaces are handed to the driver with each
+   * picture, so the context doesn't need the render targets */
+  gst_va_display_lock (self->display);
+  status = vaCreateContext (dpy, config, coded_width, coded_height,
+      VA_PROGRESSIVE, NULL, 0, &context);
+  gst_va_display_unlock (self->display);
+  if (status != VA_STATUS_SUCCESS) {
+    GST_ERROR_OBJECT (self, "vaCreateContext: %s", vaErrorStr (status));
+    goto error_destroy_config;
+  }
+
+  GST_OBJECT_LOCK (self);
+  self->config = config;
+  GST_OBJECT_UNLOCK (self);
+
+  recon_pool = _create_reconstruct_pool (self->display,
+      gst_va_encoder_get_surface_formats (self), video_format, coded_width,
+      coded_height, max_reconstruct_surfaces);
+  if (!recon_pool) {
+    GST_ERROR_OBJECT (self, "Failed to create reconstruct pool");
+    goto error_destroy_context;
+  }
+
+  gst_video_info_set_format (&info, video_format, coded_width, coded_height);
+
+  GST_OBJECT_LOCK (self);
+  self->context = context;
+  self->profile = profile;
+  self->rt_format = rt_format;
+  self->coded_width = coded_width;
+  self->coded_height = coded_height;
+  self->codedbuf_size = GST_VIDEO_INFO_SIZE (&info) + CODED_BUFFER_HEADROOM;
+  self->recon_pool = recon_pool;
+  GST_OBJECT_UNLOCK (self);
+
+  /* now we should return now only this profile's caps */
+  gst_caps_replace (&self->sinkpad_caps, NULL);
+
+  return TRUE;
+
+error_destroy_context:
+  {
+    gst_va_display_lock (self->display);
+    status = vaDestroyContext (dpy, context);
+    gst_va_display_unlock (self->display);
+    if (status != VA_STATUS_SUCCESS)
+      GST_ERROR_OBJECT (self, "vaDestroyContext: %s", vaErrorStr (status));
+
+    GST_OBJECT_LOCK (self);
+    self->config = VA_INVALID_ID;
+    GST_OBJECT_UNLOCK (self);
+  }
+error_destroy_config:
+  {
+    gst_va_display_lock (self->display);
+    status = vaDestroyConfig (dpy, config);
+    gst_va_display_unlock (self->display);
+    if (status != VA_STATUS_SUCCESS)
+      GST_ERROR_OBJECT (self, "vaDestroyConfig: %s", vaErrorStr (status));
+
+    return FALSE;
+  }
+}
+
+gboolean
+gst_va_encoder_close (GstVaEncoder * self)
+{
+  VADisplay dpy;
+  VAStatus status;
+
+  g_return_val_if_fail (GST_IS_VA_ENCODER (self), FALSE);
+
+  if (!gst_va_encoder_is_open (self))
+    return TRUE;
+
+  if (self->recon_pool) {
+    gst_buffer_pool_set_active (self->recon_pool, FALSE);
+    gst_clear_object (&self->recon_pool);
+  }
+
+  dpy = gst_va_display_get_va_dpy (self->display);
+
+  if (self->context != VA_INVALID_ID) {
+    gst_va_display_lock (self->display);
+    status = vaDestroyContext (dpy, self->context);
+    gst_va_display_unlock (self->display);
+    if (status != VA_STATUS_SUCCESS)
+      GST_ERROR_OBJECT (self, "vaDestroyContext: %s", vaErrorStr (status));
+  }
+
+  gst_va_display_lock (self->display);
+  status = vaDestroyConfig (dpy, self->config);
+  gst_va_display_unlock (self->display);
+  if (status != VA_STATUS_SUCCESS) {
+    GST_ERROR_OBJECT (self, "vaDestroyConfig: %s", vaErrorStr (status));
+    return FALSE;
+  }
+
+  GST_OBJECT_LOCK (self);
+  gst_va_encoder_init (self);
+  GST_OBJECT_UNLOCK (self);
+
+  gst_caps_replace (&self->srcpad_caps, NULL);
+  gst_caps_replace (&self->sinkpad_caps, NULL);
+
+  return TRUE;
+}
+
+static gboolean
+_get_codec_caps (GstVaEncoder * self)
+{
+  GstCaps *sinkpad_caps = NULL, *srcpad_caps = NULL;
+
+  if (!gst_va_encoder_is_open (self)
+      && GST_IS_VA_DISPLAY_WRAPPED (self->display)) {
+    if (gst_va_caps_from_profiles (self->display, self->available_profiles,
+            self->entrypoint, &srcpad_caps, &sinkpad_caps)) {
+      gst_caps_replace (&self->sinkpad_caps, sinkpad_caps);
+      gst_caps_replace (&self->srcpad_caps, srcpad_caps);
+      gst_caps_unref (srcpad_caps);
+      gst_caps_unref (sinkpad_caps);
+
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+GstCaps *
+gst_va_encoder_get_sinkpad_caps (GstVaEncoder * self)
+{
+  GstCaps *sinkpad_caps = NULL;
+
+  g_return_val_if_fail (GST_IS_VA_ENCODER (self), NULL);
+
+  if (g_atomic_pointer_get (&self->sinkpad_caps))
+    return gst_caps_ref (self->sinkpad_caps);
+
+  if (_get_codec_caps (self))
+    return gst_caps_ref (self->sinkpad_caps);
+
+  if (gst_va_encoder_is_open (self)) {
+    sinkpad_caps = gst_va_create_raw_caps_from_config (self->display,
+        self->config);
+    gst_caps_replace (&self->sinkpad_caps, sinkpad_caps);
+    gst_caps_unref (sinkpad_caps);
+
+    return gst_caps_ref (self->sinkpad_caps);
+  }
+
+  return NULL;
+}
+
+GstCaps *
+gst_va_encoder_get_srcpad_caps (GstVaEncoder * self)
+{
+  g_return_val_if_fail (GST_IS_VA_ENCODER (self), NULL);
+
+  if (g_atomic_pointer_get (&self->srcpad_caps))
+    return gst_caps_ref (self->srcpad_caps);
+
+  if (_get_codec_caps (self))
+    return gst_caps_ref (self->srcpad_caps);
+
+  return NULL;
+}
+
+gboolean
+gst_va_encoder_has_profile (GstVaEncoder * self, VAProfile profile)
+{
+  gint i;
+
+  g_return_val_if_fail (GST_IS_VA_ENCODER (self), FALSE);
+
+  if (profile == VAProfileNone)
+    return FALSE;
+
+  for (i = 0; i < self->available_profiles->len; i++) {
+    if (g_array_index (self->available_profiles, VAProfile, i) == profile)
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+GArray *
+gst_va_encoder_get_surface_formats (GstVaEncoder * self)
+{
+  GArray *formats;
+  GstVideoFormat format;
+  VASurfaceAttrib *attribs;
+  guint i, attrib_count;
+
+  g_return_val_if_fail (GST_IS_VA_ENCODER (self), NULL);
+
+  if (self->config == VA_INVALID_ID)
+    return NULL;
+
+  attribs = gst_va_get_surface_attribs (self->display, self->config,
+      &attrib_count);
+  if (!attribs)
+    return NULL;
+
+  formats = g_array_new (FALSE, FALSE, sizeof (GstVideoFormat));
+
+  for (i = 0; i < attrib_count; i++) {
+    if (attribs[i].value.type != VAGenericValueTypeInteger)
+      continue;
+    switch (attribs[i].type) {
+      case VASurfaceAttribPixelFormat:
+        format = gst_va_video_format_from_va_fourcc (attribs[i].value.value.i);
+        if (format != GST_VIDEO_FORMAT_UNKNOWN)
+          g_array_append_val (formats, format);
+        break;
+      default:
+        break;
+    }
+  }
+
+  g_free (attribs);
+
+  if (formats->len == 0) {
+    g_array_unref (formats);
+    return NULL;
+  }
+
+  return formats;
+}
+
+static guint32
+_get_config_attrib (GstVaEncoder * self, VAProfile profile,
+    VAConfigAttribType type)
+{
+  VAConfigAttrib attrib = {.type = type, };
+  VADisplay dpy;
+  VAStatus status;
+
+  if (!gst_va_encoder_has_profile (self, profile))
+    return 0;
+
+  dpy = gst_va_display_get_va_dpy (self->display);
+  gst_va_display_lock (self->display);
+  status = vaGetConfigAttributes (dpy, profile, self->entrypoint, &attrib, 1);
+  gst_va_display_unlock (self->display);
+  if (status != VA_STATUS_SUCCESS) {
+    GST_WARNING_OBJECT (self, "vaGetConfigAttributes: %s", vaErrorStr (status));
+    return 0;
+  }
+
+  if (attrib.value == VA_ATTRIB_NOT_SUPPORTED)
+    return 0;
+
+  return attrib.value;
+}
+
+/* Returns the mask of VA_RC_* modes supported for @profile */
+guint32
+gst_va_encoder_get_rate_control_mode (GstVaEncoder * self, VAProfile profile)
+{
+  g_return_val_if_fail (GST_IS_VA_ENCODER (self), 0);
+
+  return _get_config_attrib (self, profile, VAConfigAttribRateControl);
+}
+
+/* Returns the mask of VA_ENC_PACKED_HEADER_* accepted for @profile */
+guint32
+gst_va_encoder_get_packed_headers (GstVaEncoder * self, VAProfile profile)
+{
+  g_return_val_if_fail (GST_IS_VA_ENCODER (self), 0);
+
+  return _get_config_attrib (self, profile, VAConfigAttribEncPackedHeaders);
+}
+
+static gboolean
+_create_buffer (GstVaEncoder * self, VABufferType type, gpointer data,
+    gsize size, VABufferID * buffer)
+{
+  VADisplay dpy;
+  VAStatus status;
+
+  dpy = gst_va_display_get_va_dpy (self->display);
+  gst_va_display_lock (self->display);
+  status = vaCreateBuffer (dpy, self->context, type, size, 1, data, buffer);
+  gst_va_display_unlock (self->display);
+  if (status != VA_STATUS_SUCCESS) {
+    GST_ERROR_OBJECT (self, "vaCreateBuffer: %s", vaErrorStr (status));
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+gboolean
+gst_va_encoder_add_param (GstVaEncoder * self, GstVaEncodePicture * pic,
+    VABufferType type, gpointer data, gsize size)
+{
+  VABufferID buffer;
+
+  g_return_val_if_fail (GST_IS_VA_ENCODER (self), FALSE);
+  g_return_val_if_fail (self->context != VA_INVALID_ID, FALSE);
+  g_return_val_if_fail (pic && data && size > 0, FALSE);
+
+  if (!_create_buffer (self, type, data, size, &buffer))
+    return FALSE;
+
+  g_array_append_val (pic->params, buffer);
+  return TRUE;
+}
+
+gboolean
+gst_va_encoder_add_packed_header (GstVaEncoder * self,
+    GstVaEncodePicture * pic, guint type, gpointer data, gsize size_in_bits,
+    gboolean has_emulation_bytes)
+{
+  VAEncPackedHeaderParameterBuffer param = {
+    .type = type,
+    .bit_length = size_in_bits,
+    .has_emulation_bytes = has_emulation_bytes,
+  };
+  VABufferID buffer;
+
+  g_return_val_if_fail (GST_IS_VA_ENCODER (self), FALSE);
+  g_return_val_if_fail (self->context != VA_INVALID_ID, FALSE);
+  g_return_val_if_fail (pic && data && size_in_bits > 0, FALSE);
+
+  if (!_create_buffer (self, VAEncPackedHeaderParameterBufferType, &param,
+          sizeof (param), &buffer))
+    return FALSE;
+  g_array_append_val (pic->params, buffer);
+
+  if (!_create_buffer (self, VAEncPackedHeaderDataBufferType, data,
+          (size_in_bits + 7) / 8, &buffer))
+    return FALSE;
+  g_array_append_val (pic->params, buffer);
+
+  return TRUE;
+}
+
+gboolean
+gst_va_encoder_encode (GstVaEncoder * self, GstVaEncodePicture * pic)
+{
+  VADisplay dpy;
+  VAStatus status;
+  VASurfaceID surface;
+  gboolean ret = FALSE;
+
+  g_return_val_if_fail (GST_IS_VA_ENCODER (self), FALSE);
+  g_return_val_if_fail (self->context != VA_INVALID_ID, FALSE);
+  g_return_val_if_fail (pic, FALSE);
+
+  surface = gst_va_encode_picture_get_raw_surface (pic);
+  if (surface == VA_INVALID_ID) {
+    GST_ERROR_OBJECT (self, "Encode picture without VASurfaceID");
+    return FALSE;
+  }
+
+  GST_TRACE_OBJECT (self, "Encode surface %#x", surface);
+
+  dpy = gst_va_display_get_va_dpy (self->display);
+
+  gst_va_display_lock (self->display);
+  status = vaBeginPicture (dpy, self->context, surface);
+  gst_va_display_unlock (self->display);
+  if (status != VA_STATUS_SUCCESS) {
+    GST_WARNING_OBJECT (self, "vaBeginPicture: %s", vaErrorStr (status));
+    goto bail;
+  }
+
+  if (pic->params->len > 0) {
+    gst_va_display_lock (self->display);
+    status = vaRenderPicture (dpy, self->context,
+        (VABufferID *) pic->params->data, pic->params->len);
+    gst_va_display_unlock (self->display);
+    if (status != VA_STATUS_SUCCESS) {
+      GST_WARNING_OBJECT (self, "vaRenderPicture: %s", vaErrorStr (status));
+      goto fail_end_pic;
+    }
+  }
+
+  gst_va_display_lock (self->display);
+  status = vaEndPicture (dpy, self->context);
+  gst_va_display_unlock (self->display);
+  if (status != VA_STATUS_SUCCESS)
+    GST_WARNING_OBJECT (self, "vaEndPicture: %s", vaErrorStr (status));
+  else
+    ret = TRUE;
+
+bail:
+  _destroy_buffers (pic);
+
+  return ret;
+
+fail_end_pic:
+  {
+    gst_va_display_lock (self->display);
+    status = vaEndPicture (dpy, self->context);
+    gst_va_display_unlock (self->display);
+    goto bail;
+  }
+}
+
+/* Waits for the encoding of @pic to finish and copies out its coded
+ * data */
+GstBuffer *
+gst_va_encoder_get_coded_buffer (GstVaEncoder * self, GstVaEncodePicture * pic)
+{
+  VACodedBufferSegment *segment, *seg_list = NULL;
+  GstBuffer *buffer = NULL;
+  GstMapInfo map;
+  VADisplay dpy;
+  VAStatus status;
+  gsize size = 0, offset = 0;
+
+  g_return_val_if_fail (GST_IS_VA_ENCODER (self), NULL);
+  g_return_val_if_fail (pic && pic->coded_buffer != VA_INVALID_ID, NULL);
+
+  dpy = gst_va_display_get_va_dpy (self->display);
+
+  gst_va_display_lock (self->display);
+  status = vaSyncSurface (dpy, gst_va_encode_picture_get_raw_surface (pic));
+  gst_va_display_unlock (self->display);
+  if (status != VA_STATUS_SUCCESS) {
+    GST_WARNING_OBJECT (self, "vaSyncSurface: %s", vaErrorStr (status));
+    return NULL;
+  }
+
+  gst_va_display_lock (self->display);
+  status = vaMapBuffer (dpy, pic->coded_buffer, (gpointer *) & seg_list);
+  gst_va_display_unlock (self->display);
+  if (status != VA_STATUS_SUCCESS) {
+    GST_WARNING_OBJECT (self, "vaMapBuffer: %s", vaErrorStr (status));
+    return NULL;
+  }
+
+  for (segment = seg_list; segment; segment = segment->next)
+    size += segment->size;
+
+  if (size == 0) {
+    GST_WARNING_OBJECT (self, "Empty coded buffer");
+    goto bail;
+  }
+
+  buffer = gst_buffer_new_allocate (NULL, size, NULL);
+  if (!buffer || !gst_buffer_map (buffer, &map, GST_MAP_WRITE)) {
+    GST_ERROR_OBJECT (self, "Failed to allocate output buffer");
+    gst_clear_buffer (&buffer);
+    goto bail;
+  }
+
+  for (segment = seg_list; segment; segment = segment->next) {
+    memcpy (map.data + offset, segment->buf, segment->size);
+    offset += segment->size;
+  }
+
+  gst_buffer_unmap (buffer, &map);
+
+bail:
+  gst_va_display_lock (self->display);
+  status = vaUnmapBuffer (dpy, pic->coded_buffer);
+  gst_va_display_unlock (self->display);
+  if (status != VA_STATUS_SUCCESS)
+    GST_WARNING_OBJECT (self, "vaUnmapBuffer: %s", vaErrorStr (status));
+
+  return buffer;
+}
+
+static gboolean
+_destroy_buffers (GstVaEncodePicture * pic)
+{
+  VABufferID buffer;
+  VADisplay dpy;
+  VAStatus status;
+  guint i;
+  gboolean ret = TRUE;
+
+  g_return_val_if_fail (GST_IS_VA_DISPLAY (pic->display), FALSE);
+
+  dpy = gst_va_display_get_va_dpy (pic->display);
+
+  for (i = 0; i < pic->params->len; i++) {
+    buffer = g_array_index (pic->params, VABufferID, i);
+    gst_va_display_lock (pic->display);
+    status = vaDestroyBuffer (dpy, buffer);
+    gst_va_display_unlock (pic->display);
+    if (status != VA_STATUS_SUCCESS) {
+      ret = FALSE;
+      GST_WARNING ("Failed to destroy parameter buffer: %s",
+          vaErrorStr (status));
+    }
+  }
+
+  pic->params = g_array_set_size (pic->params, 0);
+
+  return ret;
+}
+
+GstVaEncodePicture *
+gst_va_encode_picture_new (GstVaEncoder * self, GstBuffer * raw_buffer)
+{
+  GstVaEncodePicture *pic;
+  GstBuffer *reconstruct_buffer = NULL;
+  VABufferID coded_buffer;
+  VADisplay dpy;
+  VAStatus status;
+
+  g_return_val_if_fail (self && GST_IS_VA_ENCODER (self), NULL);
+  g_return_val_if_fail (raw_buffer && GST_IS_BUFFER (raw_buffer), NULL);
+
+  if (!gst_va_encoder_is_open (self)) {
+    GST_ERROR_OBJECT (self, "encoder has not been opened yet");
+    return NULL;
+  }
+
+  if (gst_buffer_pool_acquire_buffer (self->recon_pool, &reconstruct_buffer,
+          NULL) != GST_FLOW_OK) {
+    GST_ERROR_OBJECT (self, "Failed to acquire a reconstruct surface");
+    return NULL;
+  }
+
+  dpy = gst_va_display_get_va_dpy (self->display);
+  gst_va_display_lock (self->display);
+  status = vaCreateBuffer (dpy, self->context, VAEncCodedBufferType,
+      self->codedbuf_size, 1, NULL, &coded_buffer);
+  gst_va_display_unlock (self->display);
+  if (status != VA_STATUS_SUCCESS) {
+    GST_ERROR_OBJECT (self, "vaCreateBuffer: %s", vaErrorStr (status));
+    gst_buffer_unref (reconstruct_buffer);
+    return NULL;
+  }
+
+  pic = g_slice_new (GstVaEncodePicture);
+  pic->raw_buffer = gst_buffer_ref (raw_buffer);
+  pic->reconstruct_buffer = reconstruct_buffer;
+  pic->coded_buffer = coded_buffer;
+  pic->params = g_array_sized_new (FALSE, FALSE, sizeof (VABufferID), 8);
+  pic->display = gst_object_ref (self->display);
+
+  return pic;
+}
+
+VASurfaceID
+gst_va_encode_picture_get_raw_surface (GstVaEncodePicture * pic)
+{
+  g_return_val_if_fail (pic, VA_INVALID_ID);
+  g_return_val_if_fail (pic->raw_buffer, VA_INVALID_ID);
+
+  return gst_va_buffer_get_surface (pic->raw_buffer);
+}
+
+VASurfaceID
+gst_va_encode_picture_get_reconstruct_surface (GstVaEncodePicture * pic)
+{
+  g_return_val_if_fail (pic, VA_INVALID_ID);
+  g_return_val_if_fail (pic->reconstruct_buffer, VA_INVALID_ID);
+
+  return gst_va_buffer_get_surface (pic->reconstruct_buffer);
+}
+
+void
+gst_va_encode_picture_free (GstVaEncodePicture * pic)
+{
+  VADisplay dpy;
+  VAStatus status;
+
+  g_return_if_fail (pic);
+
+  /* only if add_param() or add_packed_header() failed */
+  if (pic->params != NULL && pic->params->len > 0)
+    _destroy_buffers (pic);
+
+  if (pic->coded_buffer != VA_INVALID_ID) {
+    dpy = gst_va_display_get_va_dpy (pic->display);
+    gst_va_display_lock (pic->display);
+    status = vaDestroyBuffer (dpy, pic->coded_buffer);
+    gst_va_display_unlock (pic->display);
+    if (status != VA_STATUS_SUCCESS)
+      GST_WARNING ("Failed to destroy coded buffer: %s", vaErrorStr (status));
+  }
+
+  gst_clear_buffer (&pic->raw_buffer);
+  gst_clear_buffer (&pic->reconstruct_buffer);
+  g_clear_pointer (&pic->params, g_array_unref);
+  gst_clear_object (&pic->display);
+
+  g_slice_free (GstVaEncodePicture, pic);
+}
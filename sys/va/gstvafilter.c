@@ -59,12 +59,11 @@ struct _GstVaFilter
   GstVideoOrientationMethod orientation;
 
   VARectangle input_region;
-  VARectangle output_region;
-
   VAProcColorStandardType input_color_standard;
   VAProcColorProperties input_color_properties;
-  VAProcColorStandardType output_color_standard;
-  VAProcColorProperties output_color_properties;
+
+  /* the destination of gst_va_filter_convert_surface() */
+  GstVaFilterOutput output;
 
   GArray *filters;
 };
@@ -1118,42 +1117,96 @@ _config_color_properties (VAProcColorStandardType * std,
   /* *INDENT-ON* */
 }
 
-gboolean
-gst_va_filter_set_formats (GstVaFilter * self, GstVideoInfo * in_info,
-    GstVideoInfo * out_info)
+static void
+_set_input_format_unlocked (GstVaFilter * self, GstVideoInfo * in_info)
 {
-  g_return_val_if_fail (GST_IS_VA_FILTER (self), FALSE);
-  g_return_val_if_fail (out_info && in_info, FALSE);
-
-  if (!gst_va_filter_is_open (self))
-    return FALSE;
-
-  GST_OBJECT_LOCK (self);
   /* *INDENT-OFF* */
   self->input_region = (VARectangle) {
     .width = GST_VIDEO_INFO_WIDTH (in_info),
     .height = GST_VIDEO_INFO_HEIGHT (in_info),
   };
-
-  self->output_region = (VARectangle) {
-    .width = GST_VIDEO_INFO_WIDTH (out_info),
-    .height = GST_VIDEO_INFO_HEIGHT (out_info),
-  };
   /* *INDENT-ON* */
 
   _config_color_properties (&self->input_color_standard,
       &self->input_color_properties, in_info,
       self->pipeline_caps.input_color_standards,
       self->pipeline_caps.num_input_color_standards);
-  _config_color_properties (&self->output_color_standard,
-      &self->output_color_properties, out_info,
+}
+
+static void
+_set_output_format_unlocked (GstVaFilter * self, GstVideoInfo * out_info,
+    GstVaFilterOutput * output)
+{
+  /* *INDENT-OFF* */
+  output->region = (VARectangle) {
+    .width = GST_VIDEO_INFO_WIDTH (out_info),
+    .height = GST_VIDEO_INFO_HEIGHT (out_info),
+  };
+  /* *INDENT-ON* */
+
+  _config_color_properties (&output->color_standard,
+      &output->color_properties, out_info,
       self->pipeline_caps.output_color_standards,
       self->pipeline_caps.num_output_color_standards);
+}
+
+gboolean
+gst_va_filter_set_formats (GstVaFilter * self, GstVideoInfo * in_info,
+    GstVideoInfo * out_info)
+{
+  g_return_val_if_fail (GST_IS_VA_FILTER (self), FALSE);
+  g_return_val_if_fail (out_info && in_info, FALSE);
+
+  if (!gst_va_filter_is_open (self))
+    return FALSE;
+
+  GST_OBJECT_LOCK (self);
+  _set_input_format_unlocked (self, in_info);
+  _set_output_format_unlocked (self, out_info, &self->output);
+  GST_OBJECT_UNLOCK (self);
+
+  return TRUE;
+}
+
+/* Only configures the source of the conversions, for filters with
+ * several destinations. */
+gboolean
+gst_va_filter_set_input_format (GstVaFilter * self, GstVideoInfo * in_info)
+{
+  g_return_val_if_fail (GST_IS_VA_FILTER (self), FALSE);
+  g_return_val_if_fail (in_info, FALSE);
+
+  if (!gst_va_filter_is_open (self))
+    return FALSE;
+
+  GST_OBJECT_LOCK (self);
+  _set_input_format_unlocked (self, in_info);
   GST_OBJECT_UNLOCK (self);
 
   return TRUE;
 }
 
+/* Fills the region and the color properties of @output for @out_info,
+ * so they are set up once per negotiation rather than per frame. */
+gboolean
+gst_va_filter_set_output_format (GstVaFilter * self, GstVideoInfo * out_info,
+    GstVaFilterOutput * output)
+{
+  g_return_val_if_fail (GST_IS_VA_FILTER (self), FALSE);
+  g_return_val_if_fail (out_info && output, FALSE);
+
+  if (!gst_va_filter_is_open (self))
+    return FALSE;
+
+  GST_OBJECT_LOCK (self);
+  _set_output_format_unlocked (self, out_info, output);
+  GST_OBJECT_UNLOCK (self);
+
+  output->surface = VA_INVALID_ID;
+
+  return TRUE;
+}
+
 static gboolean
 _destroy_filters_unlocked (GstVaFilter * self)
 {
@@ -1222,7 +1275,7 @@ gst_va_filter_add_filter_buffer (GstVaFilter * self, gpointer data, gsize size,
 
 static gboolean
 _create_pipeline_buffer (GstVaFilter * self, VASurfaceID surface,
-    VARectangle * src_rect, VARectangle * dst_rect, VABufferID * buffer)
+    VARectangle * src_rect, GstVaFilterOutput * output, VABufferID * buffer)
 {
   VADisplay dpy;
   VAStatus status;
@@ -1242,15 +1295,15 @@ _create_pipeline_buffer (GstVaFilter * self, VASurfaceID surface,
     .surface = surface,
     .surface_region = src_rect,
     .surface_color_standard = self->input_color_standard,
-    .output_region = dst_rect,
+    .output_region = &output->region,
     .output_background_color = 0xff000000, /* ARGB black */
-    .output_color_standard = self->output_color_standard,
+    .output_color_standard = output->color_standard,
     .filters = filters,
     .num_filters = num_filters,
     .rotation_state = self->rotation,
     .mirror_state = self->mirror,
     .input_color_properties = self->input_color_properties,
-    .output_color_properties = self->output_color_properties,
+    .output_color_properties = output->color_properties,
   };
   /* *INDENT-ON* */
 
@@ -1276,31 +1329,56 @@ gboolean
 gst_va_filter_convert_surface (GstVaFilter * self, VASurfaceID in_surface,
     VASurfaceID out_surface)
 {
-  VABufferID buffer;
+  GstVaFilterOutput output;
+
+  g_return_val_if_fail (GST_IS_VA_FILTER (self), FALSE);
+  g_return_val_if_fail (out_surface != VA_INVALID_ID, FALSE);
+
+  GST_OBJECT_LOCK (self);
+  output = self->output;
+  GST_OBJECT_UNLOCK (self);
+
+  output.surface = out_surface;
+
+  return gst_va_filter_convert_surfaces (self, in_surface, &output, 1);
+}
+
+/* Converts @in_surface into each of @outputs. The pipeline buffers are
+ * created first and the pictures are then submitted back to back, so
+ * the source surface is processed as one batch. */
+gboolean
+gst_va_filter_convert_surfaces (GstVaFilter * self, VASurfaceID in_surface,
+    GstVaFilterOutput * outputs, guint num_outputs)
+{
+  VABufferID *buffers;
   VADisplay dpy;
   VAProcPipelineCaps pipeline_caps = { 0, };
   VARectangle src_rect;
-  VARectangle dst_rect;
   VAStatus status;
   VABufferID *filters = NULL;
+  GArray *filters_array = NULL;
   guint32 num_filters = 0;
+  guint i, num_buffers = 0;
   gboolean ret = FALSE;
 
   g_return_val_if_fail (GST_IS_VA_FILTER (self), FALSE);
-  g_return_val_if_fail (in_surface != VA_INVALID_ID
-      && out_surface != VA_INVALID_ID, FALSE);
+  g_return_val_if_fail (in_surface != VA_INVALID_ID, FALSE);
+  g_return_val_if_fail (outputs && num_outputs > 0, FALSE);
+
+  for (i = 0; i < num_outputs; i++)
+    g_return_val_if_fail (outputs[i].surface != VA_INVALID_ID, FALSE);
 
   if (!gst_va_filter_is_open (self))
     return FALSE;
 
-  GST_TRACE_OBJECT (self, "Processing %#x", in_surface);
+  GST_TRACE_OBJECT (self, "Processing %#x into %u surfaces", in_surface,
+      num_outputs);
 
   GST_OBJECT_LOCK (self);
   src_rect = self->input_region;
-  dst_rect = self->output_region;
 
   if (self->filters) {
-    g_array_ref (self->filters);
+    filters_array = g_array_ref (self->filters);
     num_filters = self->filters->len;
     filters = (num_filters > 0) ? (VABufferID *) self->filters->data : NULL;
   }
@@ -1315,64 +1393,184 @@ gst_va_filter_convert_surface (GstVaFilter * self, VASurfaceID in_surface,
   if (status != VA_STATUS_SUCCESS) {
     GST_ERROR_OBJECT (self, "vaQueryVideoProcPipelineCaps: %s",
         vaErrorStr (status));
-    return FALSE;
+    goto bail;
   }
 
-  if (!_create_pipeline_buffer (self, in_surface, &src_rect, &dst_rect,
-          &buffer))
-    return FALSE;
+  buffers = g_new (VABufferID, num_outputs);
 
-  gst_va_display_lock (self->display);
-  status = vaBeginPicture (dpy, self->context, out_surface);
-  gst_va_display_unlock (self->display);
-  if (status != VA_STATUS_SUCCESS) {
-    GST_ERROR_OBJECT (self, "vaBeginPicture: %s", vaErrorStr (status));
-    return FALSE;
+  for (i = 0; i < num_outputs; i++) {
+    if (!_create_pipeline_buffer (self, in_surface, &src_rect, &outputs[i],
+            &buffers[i]))
+      goto destroy_buffers;
+    num_buffers++;
   }
 
   gst_va_display_lock (self->display);
-  status = vaRenderPicture (dpy, self->context, &buffer, 1);
-  gst_va_display_unlock (self->display);
-  if (status != VA_STATUS_SUCCESS) {
-    GST_ERROR_OBJECT (self, "vaRenderPicture: %s", vaErrorStr (status));
-    goto fail_end_pic;
-  }
+  for (i = 0; i < num_outputs; i++) {
+    status = vaBeginPicture (dpy, self->context, outputs[i].surface);
+    if (status != VA_STATUS_SUCCESS) {
+      GST_ERROR_OBJECT (self, "vaBeginPicture: %s", vaErrorStr (status));
+      break;
+    }
 
-  gst_va_display_lock (self->display);
-  status = vaEndPicture (dpy, self->context);
-  gst_va_display_unlock (self->display);
-  if (status != VA_STATUS_SUCCESS) {
-    GST_ERROR_OBJECT (self, "vaEndPicture: %s", vaErrorStr (status));
-    goto bail;
+    status = vaRenderPicture (dpy, self->context, &buffers[i], 1);
+    if (status != VA_STATUS_SUCCESS) {
+      GST_ERROR_OBJECT (self, "vaRenderPicture: %s", vaErrorStr (status));
+      status = vaEndPicture (dpy, self->context);
+      if (status != VA_STATUS_SUCCESS)
+        GST_ERROR_OBJECT (self, "vaEndPicture: %s", vaErrorStr (status));
+      break;
+    }
+
+    status = vaEndPicture (dpy, self->context);
+    if (status != VA_STATUS_SUCCESS) {
+      GST_ERROR_OBJECT (self, "vaEndPicture: %s", vaErrorStr (status));
+      break;
+    }
   }
+  gst_va_display_unlock (self->display);
 
-  ret = TRUE;
+  ret = (i == num_outputs);
+
+destroy_buffers:
+  for (i = 0; i < num_buffers; i++) {
+    gst_va_display_lock (self->display);
+    status = vaDestroyBuffer (dpy, buffers[i]);
+    gst_va_display_unlock (self->display);
+    if (status != VA_STATUS_SUCCESS) {
+      GST_WARNING_OBJECT (self, "Failed to destroy pipeline buffer: %s",
+          vaErrorStr (status));
+    }
+  }
+  g_free (buffers);
 
 bail:
   GST_OBJECT_LOCK (self);
-  if (self->filters) {
-    g_array_unref (self->filters);
+  if (filters_array) {
+    g_array_unref (filters_array);
     _destroy_filters_unlocked (self);
   }
+  GST_OBJECT_UNLOCK (self);
+
+  return ret;
+}
+
+/* Blends @samples, in order, into @out_surface, which has to be
+ * configured as output with gst_va_filter_set_formats(). Every sample
+ * is scaled from its input region into its output region, and its
+ * alpha is applied if the driver supports global alpha blending. */
+gboolean
+gst_va_filter_compose (GstVaFilter * self, GstVaComposeSample * samples,
+    guint num_samples, VASurfaceID out_surface)
+{
+  GstVaFilterOutput output;
+  VABlendState *blend_states;
+  VABufferID *buffers;
+  VADisplay dpy;
+  VAStatus status;
+  gboolean has_alpha, ret = FALSE;
+  guint i, num_buffers = 0;
+
+  g_return_val_if_fail (GST_IS_VA_FILTER (self), FALSE);
+  g_return_val_if_fail (samples && num_samples > 0, FALSE);
+  g_return_val_if_fail (out_surface != VA_INVALID_ID, FALSE);
+
+  if (!gst_va_filter_is_open (self))
+    return FALSE;
+
+  GST_TRACE_OBJECT (self, "Composing %u surfaces into %#x", num_samples,
+      out_surface);
+
+  /* the pipeline parameters only point to the regions and blend
+   * states, so they have to be kept until the picture is rendered */
+  buffers = g_new (VABufferID, num_samples);
+  blend_states = g_new0 (VABlendState, num_samples);
+
+  dpy = gst_va_display_get_va_dpy (self->display);
+
+  GST_OBJECT_LOCK (self);
+  output = self->output;
+  has_alpha = (self->pipeline_caps.blend_flags & VA_BLEND_GLOBAL_ALPHA) != 0;
+  GST_OBJECT_UNLOCK (self);
+
+  for (i = 0; i < num_samples; i++) {
+    VAProcPipelineParameterBuffer params;
+    VAProcColorStandardType color_standard;
+    VAProcColorProperties color_properties;
+    gboolean do_blend;
+
+    _config_color_properties (&color_standard, &color_properties,
+        samples[i].info, self->pipeline_caps.input_color_standards,
+        self->pipeline_caps.num_input_color_standards);
+
+    do_blend = has_alpha && samples[i].alpha < 1.0;
+    if (do_blend) {
+      blend_states[i].flags = VA_BLEND_GLOBAL_ALPHA;
+      blend_states[i].global_alpha = samples[i].alpha;
+    }
+
+    /* *INDENT-OFF* */
+    params = (VAProcPipelineParameterBuffer) {
+      .surface = samples[i].surface,
+      .surface_region = &samples[i].input_region,
+      .surface_color_standard = color_standard,
+      .output_region = &samples[i].output_region,
+      .output_background_color = 0xff000000, /* ARGB black */
+      .output_color_standard = output.color_standard,
+      .blend_state = do_blend ? &blend_states[i] : NULL,
+      .input_color_properties = color_properties,
+      .output_color_properties = output.color_properties,
+    };
+    /* *INDENT-ON* */
+
+    gst_va_display_lock (self->display);
+    status = vaCreateBuffer (dpy, self->context,
+        VAProcPipelineParameterBufferType, sizeof (params), 1, &params,
+        &buffers[i]);
+    gst_va_display_unlock (self->display);
+    if (status != VA_STATUS_SUCCESS) {
+      GST_ERROR_OBJECT (self, "vaCreateBuffer: %s", vaErrorStr (status));
+      break;
+    }
+    num_buffers++;
+  }
+
+  if (num_buffers < num_samples)
+    goto bail;
 
   gst_va_display_lock (self->display);
-  status = vaDestroyBuffer (dpy, buffer);
-  gst_va_display_unlock (self->display);
+  status = vaBeginPicture (dpy, self->context, out_surface);
   if (status != VA_STATUS_SUCCESS) {
-    GST_WARNING_OBJECT (self, "Failed to destroy pipeline buffer: %s",
-        vaErrorStr (status));
+    gst_va_display_unlock (self->display);
+    GST_ERROR_OBJECT (self, "vaBeginPicture: %s", vaErrorStr (status));
+    goto bail;
   }
-  GST_OBJECT_UNLOCK (self);
 
-  return ret;
+  status = vaRenderPicture (dpy, self->context, buffers, num_buffers);
+  if (status != VA_STATUS_SUCCESS)
+    GST_ERROR_OBJECT (self, "vaRenderPicture: %s", vaErrorStr (status));
+  else
+    ret = TRUE;
 
-fail_end_pic:
-  {
+  status = vaEndPicture (dpy, self->context);
+  gst_va_display_unlock (self->display);
+  if (status != VA_STATUS_SUCCESS) {
+    GST_ERROR_OBJECT (self, "vaEndPicture: %s", vaErrorStr (status));
+    ret = FALSE;
+  }
+
+bail:
+  for (i = 0; i < num_buffers; i++) {
     gst_va_display_lock (self->display);
-    status = vaEndPicture (dpy, self->context);
+    status = vaDestroyBuffer (dpy, buffers[i]);
     gst_va_display_unlock (self->display);
-    if (status != VA_STATUS_SUCCESS)
-      GST_ERROR_OBJECT (self, "vaEndPicture: %s", vaErrorStr (status));
-    goto bail;
+    if (status != VA_STATUS_SUCCESS) {
+      GST_WARNING_OBJECT (self, "Failed to destroy pipeline buffer: %s",
+          vaErrorStr (status));
+    }
   }
+  g_free (buffers);
+  g_free (blend_states);
+
+  return ret;
 }
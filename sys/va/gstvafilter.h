@@ -46,6 +46,32 @@ enum {
   GST_VA_FILTER_PROP_LAST
 };
 
+typedef struct _GstVaFilterOutput GstVaFilterOutput;
+
+/* One of the destinations of gst_va_filter_convert_surfaces(),
+ * configured with gst_va_filter_set_output_format() */
+struct _GstVaFilterOutput
+{
+  VASurfaceID surface;
+
+  /* <private> */
+  VARectangle region;
+  VAProcColorStandardType color_standard;
+  VAProcColorProperties color_properties;
+};
+
+typedef struct _GstVaComposeSample GstVaComposeSample;
+
+/* One of the sources blended by gst_va_filter_compose() */
+struct _GstVaComposeSample
+{
+  VASurfaceID surface;
+  GstVideoInfo *info;
+  VARectangle input_region;
+  VARectangle output_region;
+  gdouble alpha;
+};
+
 GstVaFilter *         gst_va_filter_new                   (GstVaDisplay * display);
 gboolean              gst_va_filter_open                  (GstVaFilter * self);
 gboolean              gst_va_filter_close                 (GstVaFilter * self);
@@ -66,6 +92,11 @@ GstCaps *             gst_va_filter_get_caps              (GstVaFilter * self);
 gboolean              gst_va_filter_set_formats           (GstVaFilter * self,
                                                            GstVideoInfo * in_info,
                                                            GstVideoInfo * out_info);
+gboolean              gst_va_filter_set_input_format      (GstVaFilter * self,
+                                                           GstVideoInfo * in_info);
+gboolean              gst_va_filter_set_output_format     (GstVaFilter * self,
+                                                           GstVideoInfo * out_info,
+                                                           GstVaFilterOutput * output);
 gboolean              gst_va_filter_add_filter_buffer     (GstVaFilter * self,
                                                            gpointer data,
                                                            gsize size,
@@ -73,5 +104,13 @@ gboolean              gst_va_filter_add_filter_buffer     (GstVaFilter * self,
 gboolean              gst_va_filter_convert_surface       (GstVaFilter * self,
                                                            VASurfaceID in_surface,
                                                            VASurfaceID out_surface);
+gboolean              gst_va_filter_convert_surfaces      (GstVaFilter * self,
+                                                           VASurfaceID in_surface,
+                                                           GstVaFilterOutput * outputs,
+                                                           guint num_outputs);
+gboolean              gst_va_filter_compose               (GstVaFilter * self,
+                                                           GstVaComposeSample * samples,
+                                                           guint num_samples,
+                                                           VASurfaceID out_surface);
 
 G_END_DECLS
@@ -647,6 +647,7 @@ gst_va_h264_dec_new_sequence (GstH264Decoder * decoder, const GstH264SPS * sps,
   gint display_width;
   gint display_height;
   guint rt_format;
+  gint min_buffers;
   gboolean negotiation_needed = FALSE;
   gboolean interlaced;
 
@@ -711,7 +712,12 @@ gst_va_h264_dec_new_sequence (GstH264Decoder * decoder, const GstH264SPS * sps,
     /* *INDENT-ON* */
   }
 
-  base->min_buffers = self->dpb_size + 4;       /* dpb size + scratch surfaces */
+  /* The pool grows on demand up to the DPB size, so only preallocate what
+   * the references need, or what the previous sequence actually used, plus
+   * scratch surfaces */
+  min_buffers = MAX (MAX (sps->num_ref_frames, 1) + 1,
+      gst_h264_decoder_get_max_pictures_in_use (decoder));
+  base->min_buffers = MIN (min_buffers, self->dpb_size) + 4;
 
   if (negotiation_needed) {
     self->need_negotiation = TRUE;
@@ -0,0 +1,1174 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-vah264enc
+ * @title: vah264enc
+ * @short_description: A VA-API based H264 video encoder
+ *
+ * vah264enc encodes raw video VA surfaces into H264 bitstreams using
+ * the installed and chosen [VA-API](https://01.org/linuxmedia/vaapi)
+ * driver.
+ *
+ * The raw video frames in main memory can be imported into VA
+ * surfaces.
+ *
+ * ## Example launch line
+ * ```
+ * gst-launch-1.0 videotestsrc num-buffers=60 ! timeoverlay ! vah264enc ! h264parse ! mp4mux ! filesink location=test.mp4
+ * ```
+ *
+ * Since: 1.20
+ *
+ */
+
+/**
+ * SECTION:element-vah264lpenc
+ * @title: vah264lpenc
+ * @short_description: A VA-API based H264 low power video encoder
+ *
+ * vah264lpenc encodes raw video VA surfaces into H264 bitstreams using
+ * the low power entrypoint of the installed and chosen
+ * [VA-API](https://01.org/linuxmedia/vaapi) driver.
+ *
+ * ## Example launch line
+ * ```
+ * gst-launch-1.0 videotestsrc num-buffers=60 ! timeoverlay ! vah264lpenc ! h264parse ! mp4mux ! filesink location=test.mp4
+ * ```
+ *
+ * Since: 1.20
+ *
+ */
+
+/* ToDo:
+ *
+ * + B frames and frame reordering
+ * + multiple slices and multiple reference frames
+ * + interlaced streams
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstvah264enc.h"
+
+#include <gst/codecparsers/gsth264parser.h>
+
+#include "gstvabaseenc.h"
+#include "gstvavideoformat.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_va_h264enc_debug);
+#ifndef GST_DISABLE_GST_DEBUG
+#define GST_CAT_DEFAULT gst_va_h264enc_debug
+#else
+#define GST_CAT_DEFAULT NULL
+#endif
+
+#define GST_VA_H264_ENC(obj)           ((GstVaH264Enc *) obj)
+#define GST_VA_H264_ENC_GET_CLASS(obj) (G_TYPE_INSTANCE_GET_CLASS ((obj), G_TYPE_FROM_INSTANCE (obj), GstVaH264EncClass))
+#define GST_VA_H264_ENC_CLASS(klass)   ((GstVaH264EncClass *) klass)
+
+typedef struct _GstVaH264Enc GstVaH264Enc;
+typedef struct _GstVaH264EncClass GstVaH264EncClass;
+typedef struct _GstVaH264EncFrame GstVaH264EncFrame;
+
+enum
+{
+  PROP_KEY_INT_MAX = 1,
+  PROP_RATE_CONTROL,
+  PROP_BITRATE,
+  PROP_QP_I,
+  PROP_QP_P,
+};
+
+#define DEFAULT_KEY_INT_MAX 30
+#define DEFAULT_RATE_CONTROL VA_RC_CQP
+#define DEFAULT_BITRATE 0
+#define DEFAULT_QP 26
+
+struct _GstVaH264EncClass
+{
+  GstVaBaseEncClass parent_class;
+};
+
+struct _GstVaH264Enc
+{
+  GstVaBaseEnc parent;
+
+  /* properties, protected by the object lock */
+  struct
+  {
+    guint key_int_max;
+    guint32 rc_ctrl;
+    guint bitrate;
+    guint qp_i;
+    guint qp_p;
+  } prop;
+
+  /* configuration of the current coded video sequence */
+  VAProfile profile;
+  const gchar *profile_name;
+  guint8 level_idc;
+  const gchar *level_name;
+  guint mb_width;
+  guint mb_height;
+  guint32 rc_ctrl;
+  guint bitrate;
+  guint qp_i;
+  guint qp_p;
+  guint key_int_max;
+  guint32 packed_headers;
+  gboolean use_cabac;
+  gboolean use_dct8x8;
+  guint log2_max_frame_num;
+  guint log2_max_poc_lsb;
+
+  VAEncSequenceParameterBufferH264 sequence;
+
+  /* encoding state */
+  guint frame_num;
+  guint idr_pic_id;
+  guint gop_frame_count;
+  /* the previous frame, the only reference of P frames */
+  GstVideoCodecFrame *last_ref;
+};
+
+struct _GstVaH264EncFrame
+{
+  GstVaEncFrame base;
+
+  gboolean is_idr;
+  guint frame_num;
+  gint poc;
+};
+
+#define parent_class gst_va_base_enc_parent_class
+extern gpointer gst_va_base_enc_parent_class;
+
+/* *INDENT-OFF* */
+static const gchar *sink_caps_str = GST_VIDEO_CAPS_MAKE_WITH_FEATURES ("memory:VAMemory",
+            "{ NV12 }") " ;" GST_VIDEO_CAPS_MAKE ("{ NV12 }");
+/* *INDENT-ON* */
+
+static const gchar *src_caps_str = "video/x-h264";
+
+/* in order of preference */
+static const struct
+{
+  VAProfile profile;
+  const gchar *name;
+  /* a constrained baseline stream is also a valid baseline stream */
+  const gchar *alt_name;
+} profile_map[] = {
+  {VAProfileH264High, "high", NULL},
+  {VAProfileH264Main, "main", NULL},
+  {VAProfileH264ConstrainedBaseline, "constrained-baseline", "baseline"},
+};
+
+/* Table A-1, MaxBR in 1000 bits/s for the Baseline and Main profiles */
+static const struct
+{
+  const gchar *name;
+  guint8 level_idc;
+  guint32 max_mbps;
+  guint32 max_fs;
+  guint32 max_br;
+} level_map[] = {
+  {"1", 10, 1485, 99, 64},
+  {"1.1", 11, 3000, 396, 192},
+  {"1.2", 12, 6000, 396, 384},
+  {"1.3", 13, 11880, 396, 768},
+  {"2", 20, 11880, 396, 2000},
+  {"2.1", 21, 19800, 792, 4000},
+  {"2.2", 22, 20250, 1620, 4000},
+  {"3", 30, 40500, 1620, 10000},
+  {"3.1", 31, 108000, 3600, 14000},
+  {"3.2", 32, 216000, 5120, 20000},
+  {"4", 40, 245760, 8192, 20000},
+  {"4.1", 41, 245760, 8192, 50000},
+  {"4.2", 42, 522240, 8704, 50000},
+  {"5", 50, 589824, 22080, 135000},
+  {"5.1", 51, 983040, 36864, 240000},
+  {"5.2", 52, 2073600, 36864, 240000},
+  {"6", 60, 4177920, 139264, 240000},
+  {"6.1", 61, 8355840, 139264, 480000},
+  {"6.2", 62, 16711680, 139264, 800000},
+};
+
+static void
+_get_framerate (GstVaBaseEnc * base, gint * fps_n, gint * fps_d)
+{
+  GstVideoInfo *info = &base->input_state->info;
+
+  if (GST_VIDEO_INFO_FPS_N (info) > 0 && GST_VIDEO_INFO_FPS_D (info) > 0) {
+    *fps_n = GST_VIDEO_INFO_FPS_N (info);
+    *fps_d = GST_VIDEO_INFO_FPS_D (info);
+  } else {
+    *fps_n = 25;
+    *fps_d = 1;
+  }
+}
+
+static gboolean
+_profile_is_allowed (GstCaps * allowed_caps, const gchar * name)
+{
+  GstCaps *caps;
+  gboolean ret;
+
+  if (!name)
+    return FALSE;
+
+  caps = gst_caps_new_simple ("video/x-h264", "profile", G_TYPE_STRING, name,
+      NULL);
+  ret = gst_caps_can_intersect (allowed_caps, caps);
+  gst_caps_unref (caps);
+
+  return ret;
+}
+
+/* Picks the first profile supported by the driver which downstream
+ * accepts */
+static gboolean
+_decide_profile (GstVaH264Enc * self)
+{
+  GstVaBaseEnc *base = GST_VA_BASE_ENC (self);
+  GstCaps *allowed_caps;
+  guint i;
+
+  self->profile = VAProfileNone;
+  self->profile_name = NULL;
+
+  allowed_caps = gst_pad_get_allowed_caps (GST_VIDEO_ENCODER_SRC_PAD (self));
+
+  for (i = 0; i < G_N_ELEMENTS (profile_map); i++) {
+    if (!gst_va_encoder_has_profile (base->encoder, profile_map[i].profile))
+      continue;
+
+    if (!allowed_caps || gst_caps_is_any (allowed_caps)
+        || _profile_is_allowed (allowed_caps, profile_map[i].name)) {
+      self->profile_name = profile_map[i].name;
+    } else if (_profile_is_allowed (allowed_caps, profile_map[i].alt_name)) {
+      self->profile_name = profile_map[i].alt_name;
+    } else {
+      continue;
+    }
+
+    self->profile = profile_map[i].profile;
+    break;
+  }
+
+  gst_clear_caps (&allowed_caps);
+
+  if (self->profile == VAProfileNone)
+    return FALSE;
+
+  GST_INFO_OBJECT (self, "Using profile %s", self->profile_name);
+
+  return TRUE;
+}
+
+static void
+_decide_level (GstVaH264Enc * self)
+{
+  GstVaBaseEnc *base = GST_VA_BASE_ENC (self);
+  guint frame_size = self->mb_width * self->mb_height;
+  guint cpb_factor = self->profile == VAProfileH264High ? 1250 : 1000;
+  guint64 mbps;
+  gint fps_n, fps_d;
+  guint i;
+
+  _get_framerate (base, &fps_n, &fps_d);
+  mbps = gst_util_uint64_scale_int_ceil (frame_size, fps_n, fps_d);
+
+  for (i = 0; i < G_N_ELEMENTS (level_map); i++) {
+    /* A.3.1 f) and g), the frame dimensions are bounded too */
+    if (frame_size <= level_map[i].max_fs
+        && self->mb_width * self->mb_width <= 8 * level_map[i].max_fs
+        && self->mb_height * self->mb_height <= 8 * level_map[i].max_fs
+        && mbps <= level_map[i].max_mbps
+        && (guint64) self->bitrate * 1000 <=
+        (guint64) level_map[i].max_br * cpb_factor)
+      break;
+  }
+
+  if (i == G_N_ELEMENTS (level_map)) {
+    GST_WARNING_OBJECT (self, "The stream exceeds the highest level");
+    i = G_N_ELEMENTS (level_map) - 1;
+  }
+
+  self->level_idc = level_map[i].level_idc;
+  self->level_name = level_map[i].name;
+
+  GST_INFO_OBJECT (self, "Using level %s", self->level_name);
+}
+
+static void
+_fill_sequence_param (GstVaH264Enc * self)
+{
+  GstVaBaseEnc *base = GST_VA_BASE_ENC (self);
+  GstVideoInfo *info = &base->input_state->info;
+  guint crop_right, crop_bottom;
+  gint par_n = GST_VIDEO_INFO_PAR_N (info);
+  gint par_d = GST_VIDEO_INFO_PAR_D (info);
+  gboolean has_par, has_timing;
+
+  /* in chroma samples, 4:2:0 only */
+  crop_right = (self->mb_width * 16 - GST_VIDEO_INFO_WIDTH (info)) / 2;
+  crop_bottom = (self->mb_height * 16 - GST_VIDEO_INFO_HEIGHT (info)) / 2;
+
+  has_par = par_n > 0 && par_d > 0 && par_n != par_d
+      && par_n <= G_MAXUINT16 && par_d <= G_MAXUINT16;
+  has_timing = GST_VIDEO_INFO_FPS_N (info) > 0
+      && GST_VIDEO_INFO_FPS_D (info) > 0;
+
+  /* *INDENT-OFF* */
+  self->sequence = (VAEncSequenceParameterBufferH264) {
+    .seq_parameter_set_id = 0,
+    .level_idc = self->level_idc,
+    .intra_period = self->key_int_max,
+    .intra_idr_period = self->key_int_max,
+    .ip_period = 1,
+    .bits_per_second = self->rc_ctrl == VA_RC_CQP ? 0 : self->bitrate * 1000,
+    .max_num_ref_frames = 1,
+    .picture_width_in_mbs = self->mb_width,
+    .picture_height_in_mbs = self->mb_height,
+    .seq_fields.bits = {
+      .chroma_format_idc = 1,
+      .frame_mbs_only_flag = 1,
+      .direct_8x8_inference_flag = 1,
+      .log2_max_frame_num_minus4 = self->log2_max_frame_num - 4,
+      .pic_order_cnt_type = 0,
+      .log2_max_pic_order_cnt_lsb_minus4 = self->log2_max_poc_lsb - 4,
+    },
+    .frame_cropping_flag = crop_right > 0 || crop_bottom > 0,
+    .frame_crop_right_offset = crop_right,
+    .frame_crop_bottom_offset = crop_bottom,
+    .vui_parameters_present_flag = 1,
+    .vui_fields.bits = {
+      .aspect_ratio_info_present_flag = has_par,
+      .timing_info_present_flag = has_timing,
+      .log2_max_mv_length_horizontal = 15,
+      .log2_max_mv_length_vertical = 15,
+    },
+    /* Extended_SAR */
+    .aspect_ratio_idc = has_par ? 255 : 0,
+    .sar_width = has_par ? par_n : 0,
+    .sar_height = has_par ? par_d : 0,
+    .num_units_in_tick = has_timing ? GST_VIDEO_INFO_FPS_D (info) : 0,
+    .time_scale = has_timing ? 2 * (guint32) GST_VIDEO_INFO_FPS_N (info) : 0,
+  };
+  /* *INDENT-ON* */
+}
+
+#define WRITE_BITS(val, nbits) G_STMT_START {                   \
+  if (!gst_bit_writer_put_bits_uint32 (bw, val, nbits))         \
+    goto error;                                                 \
+} G_STMT_END
+#define WRITE_UE(val) G_STMT_START {                            \
+  if (!gst_va_bit_writer_put_ue (bw, val))                      \
+    goto error;                                                 \
+} G_STMT_END
+#define WRITE_SE(val) G_STMT_START {                            \
+  if (!gst_va_bit_writer_put_se (bw, val))                      \
+    goto error;                                                 \
+} G_STMT_END
+
+static gboolean
+_write_nal_header (GstBitWriter * bw, guint nal_ref_idc, guint nal_unit_type)
+{
+  /* start code */
+  WRITE_BITS (0x00000001, 32);
+  /* forbidden_zero_bit */
+  WRITE_BITS (0, 1);
+  WRITE_BITS (nal_ref_idc, 2);
+  WRITE_BITS (nal_unit_type, 5);
+
+  return TRUE;
+
+error:
+  return FALSE;
+}
+
+/* 7.3.2.1.1 */
+static gboolean
+_write_sps (GstVaH264Enc * self, GstBitWriter * bw)
+{
+  const VAEncSequenceParameterBufferH264 *seq = &self->sequence;
+  guint8 profile_idc, constraint_flags;
+
+  switch (self->profile) {
+    case VAProfileH264ConstrainedBaseline:
+      profile_idc = 66;
+      /* constraint_set0_flag and constraint_set1_flag */
+      constraint_flags = 0xc0;
+      break;
+    case VAProfileH264Main:
+      profile_idc = 77;
+      /* constraint_set1_flag */
+      constraint_flags = 0x40;
+      break;
+    case VAProfileH264High:
+      profile_idc = 100;
+      constraint_flags = 0;
+      break;
+    default:
+      g_assert_not_reached ();
+      return FALSE;
+  }
+
+  if (!_write_nal_header (bw, 3, GST_H264_NAL_SPS))
+    goto error;
+
+  WRITE_BITS (profile_idc, 8);
+  WRITE_BITS (constraint_flags, 8);
+  WRITE_BITS (seq->level_idc, 8);
+  WRITE_UE (seq->seq_parameter_set_id);
+
+  if (profile_idc == 100) {
+    WRITE_UE (seq->seq_fields.bits.chroma_format_idc);
+    /* bit_depth_luma_minus8 and bit_depth_chroma_minus8 */
+    WRITE_UE (0);
+    WRITE_UE (0);
+    /* qpprime_y_zero_transform_bypass_flag */
+    WRITE_BITS (0, 1);
+    /* seq_scaling_matrix_present_flag */
+    WRITE_BITS (0, 1);
+  }
+
+  WRITE_UE (seq->seq_fields.bits.log2_max_frame_num_minus4);
+  WRITE_UE (seq->seq_fields.bits.pic_order_cnt_type);
+  WRITE_UE (seq->seq_fields.bits.log2_max_pic_order_cnt_lsb_minus4);
+  WRITE_UE (seq->max_num_ref_frames);
+  /* gaps_in_frame_num_value_allowed_flag */
+  WRITE_BITS (0, 1);
+  WRITE_UE (seq->picture_width_in_mbs - 1);
+  WRITE_UE (seq->picture_height_in_mbs - 1);
+  WRITE_BITS (seq->seq_fields.bits.frame_mbs_only_flag, 1);
+  WRITE_BITS (seq->seq_fields.bits.direct_8x8_inference_flag, 1);
+
+  WRITE_BITS (seq->frame_cropping_flag, 1);
+  if (seq->frame_cropping_flag) {
+    WRITE_UE (seq->frame_crop_left_offset);
+    WRITE_UE (seq->frame_crop_right_offset);
+    WRITE_UE (seq->frame_crop_top_offset);
+    WRITE_UE (seq->frame_crop_bottom_offset);
+  }
+
+  WRITE_BITS (seq->vui_parameters_present_flag, 1);
+  if (seq->vui_parameters_present_flag) {
+    /* E.1.1 */
+    WRITE_BITS (seq->vui_fields.bits.aspect_ratio_info_present_flag, 1);
+    if (seq->vui_fields.bits.aspect_ratio_info_present_flag) {
+      WRITE_BITS (seq->aspect_ratio_idc, 8);
+      WRITE_BITS (seq->sar_width, 16);
+      WRITE_BITS (seq->sar_height, 16);
+    }
+    /* overscan_info_present_flag, video_signal_type_present_flag and
+     * chroma_loc_info_present_flag */
+    WRITE_BITS (0, 3);
+    WRITE_BITS (seq->vui_fields.bits.timing_info_present_flag, 1);
+    if (seq->vui_fields.bits.timing_info_present_flag) {
+      WRITE_BITS (seq->num_units_in_tick, 32);
+      WRITE_BITS (seq->time_scale, 32);
+      /* fixed_frame_rate_flag */
+      WRITE_BITS (1, 1);
+    }
+    /* nal_hrd_parameters_present_flag, vcl_hrd_parameters_present_flag
+     * and pic_struct_present_flag */
+    WRITE_BITS (0, 3);
+    /* bitstream_restriction_flag */
+    WRITE_BITS (0, 1);
+  }
+
+  return gst_va_bit_writer_put_trailing_bits (bw);
+
+error:
+  return FALSE;
+}
+
+/* 7.3.2.2 */
+static gboolean
+_write_pps (GstVaH264Enc * self, GstBitWriter * bw,
+    const VAEncPictureParameterBufferH264 * pic_param)
+{
+  if (!_write_nal_header (bw, 3, GST_H264_NAL_PPS))
+    goto error;
+
+  WRITE_UE (pic_param->pic_parameter_set_id);
+  WRITE_UE (pic_param->seq_parameter_set_id);
+  WRITE_BITS (pic_param->pic_fields.bits.entropy_coding_mode_flag, 1);
+  /* bottom_field_pic_order_in_frame_present_flag */
+  WRITE_BITS (0, 1);
+  /* num_slice_groups_minus1 */
+  WRITE_UE (0);
+  WRITE_UE (pic_param->num_ref_idx_l0_active_minus1);
+  WRITE_UE (pic_param->num_ref_idx_l1_active_minus1);
+  WRITE_BITS (pic_param->pic_fields.bits.weighted_pred_flag, 1);
+  WRITE_BITS (pic_param->pic_fields.bits.weighted_bipred_idc, 2);
+  WRITE_SE ((gint) pic_param->pic_init_qp - 26);
+  /* pic_init_qs_minus26 */
+  WRITE_SE (0);
+  WRITE_SE (pic_param->chroma_qp_index_offset);
+  WRITE_BITS (pic_param->pic_fields.bits.
+      deblocking_filter_control_present_flag, 1);
+  WRITE_BITS (pic_param->pic_fields.bits.constrained_intra_pred_flag, 1);
+  WRITE_BITS (pic_param->pic_fields.bits.redundant_pic_cnt_present_flag, 1);
+
+  if (self->profile == VAProfileH264High) {
+    WRITE_BITS (pic_param->pic_fields.bits.transform_8x8_mode_flag, 1);
+    /* pic_scaling_matrix_present_flag */
+    WRITE_BITS (0, 1);
+    WRITE_SE (pic_param->second_chroma_qp_index_offset);
+  }
+
+  return gst_va_bit_writer_put_trailing_bits (bw);
+
+error:
+  return FALSE;
+}
+
+#undef WRITE_BITS
+#undef WRITE_UE
+#undef WRITE_SE
+
+static gboolean
+_add_sequence_header (GstVaH264Enc * self, GstVaH264EncFrame * frame)
+{
+  GstVaBaseEnc *base = GST_VA_BASE_ENC (self);
+  GstBitWriter bw;
+  gboolean ret;
+
+  if (!gst_va_encoder_add_param (base->encoder, frame->base.picture,
+          VAEncSequenceParameterBufferType, &self->sequence,
+          sizeof (self->sequence))) {
+    GST_ERROR_OBJECT (self, "Failed to create the sequence parameter");
+    return FALSE;
+  }
+
+  if (!(self->packed_headers & VA_ENC_PACKED_HEADER_SEQUENCE))
+    return TRUE;
+
+  gst_bit_writer_init (&bw);
+  ret = _write_sps (self, &bw)
+      && gst_va_encoder_add_packed_header (base->encoder, frame->base.picture,
+      VAEncPackedHeaderSequence, gst_bit_writer_get_data (&bw),
+      gst_bit_writer_get_size (&bw), FALSE);
+  gst_bit_writer_reset (&bw);
+
+  if (!ret)
+    GST_ERROR_OBJECT (self, "Failed to create the packed SPS");
+
+  return ret;
+}
+
+static gboolean
+_add_picture_header (GstVaH264Enc * self, GstVaH264EncFrame * frame,
+    VAEncPictureParameterBufferH264 * pic_param)
+{
+  GstVaBaseEnc *base = GST_VA_BASE_ENC (self);
+  GstBitWriter bw;
+  gboolean ret;
+
+  if (!gst_va_encoder_add_param (base->encoder, frame->base.picture,
+          VAEncPictureParameterBufferType, pic_param, sizeof (*pic_param))) {
+    GST_ERROR_OBJECT (self, "Failed to create the picture parameter");
+    return FALSE;
+  }
+
+  /* the PPS only changes along with the SPS */
+  if (!frame->is_idr || !(self->packed_headers & VA_ENC_PACKED_HEADER_PICTURE))
+    return TRUE;
+
+  gst_bit_writer_init (&bw);
+  ret = _write_pps (self, &bw, pic_param)
+      && gst_va_encoder_add_packed_header (base->encoder, frame->base.picture,
+      VAEncPackedHeaderPicture, gst_bit_writer_get_data (&bw),
+      gst_bit_writer_get_size (&bw), FALSE);
+  gst_bit_writer_reset (&bw);
+
+  if (!ret)
+    GST_ERROR_OBJECT (self, "Failed to create the packed PPS");
+
+  return ret;
+}
+
+static void
+_fill_va_picture (VAPictureH264 * va_pic, GstVaH264EncFrame * frame,
+    guint flags)
+{
+  /* *INDENT-OFF* */
+  *va_pic = (VAPictureH264) {
+    .picture_id =
+        gst_va_encode_picture_get_reconstruct_surface (frame->base.picture),
+    .frame_idx = frame->frame_num,
+    .flags = flags,
+    .TopFieldOrderCnt = frame->poc,
+    .BottomFieldOrderCnt = frame->poc,
+  };
+  /* *INDENT-ON* */
+}
+
+static void
+_invalidate_va_pictures (VAPictureH264 * va_pics, guint num)
+{
+  guint i;
+
+  for (i = 0; i < num; i++) {
+    va_pics[i].picture_id = VA_INVALID_SURFACE;
+    va_pics[i].flags = VA_PICTURE_H264_INVALID;
+  }
+}
+
+static gboolean
+gst_va_h264_enc_reconfig (GstVaBaseEnc * base)
+{
+  GstVaH264Enc *self = GST_VA_H264_ENC (base);
+  GstVideoInfo *info = &base->input_state->info;
+  GstVideoCodecState *output_state;
+  GstCaps *out_caps;
+  guint rt_format, max_surfaces;
+  gint fps_n, fps_d;
+
+  rt_format = gst_va_chroma_from_video_format (GST_VIDEO_INFO_FORMAT (info));
+  if (rt_format != VA_RT_FORMAT_YUV420) {
+    GST_ERROR_OBJECT (self, "Unsupported format %s",
+        gst_video_format_to_string (GST_VIDEO_INFO_FORMAT (info)));
+    return FALSE;
+  }
+
+  if (!_decide_profile (self)) {
+    GST_ERROR_OBJECT (self, "No profile supported by the driver is accepted "
+        "downstream");
+    return FALSE;
+  }
+
+  GST_OBJECT_LOCK (self);
+  self->key_int_max = self->prop.key_int_max;
+  self->rc_ctrl = self->prop.rc_ctrl;
+  self->bitrate = self->prop.bitrate;
+  self->qp_i = self->prop.qp_i;
+  self->qp_p = self->prop.qp_p;
+  GST_OBJECT_UNLOCK (self);
+
+  self->mb_width = GST_ROUND_UP_16 (GST_VIDEO_INFO_WIDTH (info)) / 16;
+  self->mb_height = GST_ROUND_UP_16 (GST_VIDEO_INFO_HEIGHT (info)) / 16;
+
+  self->rc_ctrl = gst_va_base_enc_get_rate_control (base, self->profile,
+      self->rc_ctrl);
+  if (self->rc_ctrl == VA_RC_CQP || self->rc_ctrl == 0) {
+    self->bitrate = 0;
+  } else if (self->bitrate == 0) {
+    /* about 0.1 bits per pixel */
+    _get_framerate (base, &fps_n, &fps_d);
+    self->bitrate = MAX (1, gst_util_uint64_scale (GST_VIDEO_INFO_WIDTH (info)
+            * GST_VIDEO_INFO_HEIGHT (info), fps_n, fps_d * 10000));
+  }
+
+  self->packed_headers =
+      gst_va_encoder_get_packed_headers (base->encoder, self->profile)
+      & (VA_ENC_PACKED_HEADER_SEQUENCE | VA_ENC_PACKED_HEADER_PICTURE);
+
+  self->use_cabac = self->profile != VAProfileH264ConstrainedBaseline;
+  self->use_dct8x8 = self->profile == VAProfileH264High;
+
+  self->log2_max_frame_num = CLAMP (g_bit_storage (self->key_int_max), 4, 16);
+  self->log2_max_poc_lsb = CLAMP (self->log2_max_frame_num + 1, 4, 16);
+
+  _decide_level (self);
+  _fill_sequence_param (self);
+
+  GST_INFO_OBJECT (self, "rate control %#x, bitrate %u kbps, key-int-max %u, "
+      "packed headers %#x", self->rc_ctrl, self->bitrate, self->key_int_max,
+      self->packed_headers);
+
+  /* the reference, the frames in flight and the one being encoded */
+  max_surfaces = base->preferred_output_delay + 3;
+
+  if (!gst_va_encoder_open (base->encoder, self->profile, rt_format,
+          GST_VIDEO_FORMAT_NV12, self->mb_width * 16, self->mb_height * 16,
+          self->rc_ctrl, self->packed_headers, max_surfaces)) {
+    GST_ERROR_OBJECT (self, "Failed to open the VA encoder");
+    return FALSE;
+  }
+
+  out_caps = gst_caps_new_simple ("video/x-h264",
+      "stream-format", G_TYPE_STRING, "byte-stream",
+      "alignment", G_TYPE_STRING, "au",
+      "profile", G_TYPE_STRING, self->profile_name,
+      "level", G_TYPE_STRING, self->level_name, NULL);
+
+  output_state = gst_video_encoder_set_output_state (GST_VIDEO_ENCODER (self),
+      out_caps, base->input_state);
+  gst_video_codec_state_unref (output_state);
+
+  return TRUE;
+}
+
+static void
+gst_va_h264_enc_reset_state (GstVaBaseEnc * base)
+{
+  GstVaH264Enc *self = GST_VA_H264_ENC (base);
+
+  self->frame_num = 0;
+  self->idr_pic_id = 0;
+  self->gop_frame_count = 0;
+  g_clear_pointer (&self->last_ref, gst_video_codec_frame_unref);
+}
+
+static gboolean
+gst_va_h264_enc_new_frame (GstVaBaseEnc * base, GstVideoCodecFrame * frame)
+{
+  GstVaH264EncFrame *frame_in;
+
+  frame_in = g_new0 (GstVaH264EncFrame, 1);
+  gst_video_codec_frame_set_user_data (frame, frame_in, gst_va_enc_frame_free);
+
+  return TRUE;
+}
+
+static gboolean
+gst_va_h264_enc_encode_frame (GstVaBaseEnc * base,
+    GstVideoCodecFrame * gst_frame)
+{
+  GstVaH264Enc *self = GST_VA_H264_ENC (base);
+  GstVaH264EncFrame *frame, *ref = NULL;
+  GstVaEncodePicture *picture;
+  VAEncPictureParameterBufferH264 pic_param;
+  VAEncSliceParameterBufferH264 slice;
+
+  frame = (GstVaH264EncFrame *) gst_va_base_enc_get_frame (gst_frame);
+  picture = frame->base.picture;
+
+  if (!self->last_ref || self->gop_frame_count >= self->key_int_max
+      || GST_VIDEO_CODEC_FRAME_IS_FORCE_KEYFRAME (gst_frame)) {
+    frame->is_idr = TRUE;
+    self->frame_num = 0;
+    self->gop_frame_count = 0;
+  } else {
+    ref = (GstVaH264EncFrame *) gst_va_base_enc_get_frame (self->last_ref);
+  }
+
+  frame->frame_num = self->frame_num;
+  frame->poc = self->gop_frame_count * 2;
+
+  GST_LOG_OBJECT (self, "Encoding frame %d as %s, frame_num %u, poc %d",
+      gst_frame->system_frame_number, frame->is_idr ? "IDR" : "P",
+      frame->frame_num, frame->poc);
+
+  if (frame->is_idr && !_add_sequence_header (self, frame))
+    return FALSE;
+
+  if (!gst_va_base_enc_add_rate_control_parameter (base, picture,
+          self->rc_ctrl, self->bitrate, 100, self->qp_i, 0))
+    return FALSE;
+
+  if (!gst_va_base_enc_add_hrd_parameter (base, picture, self->rc_ctrl,
+          self->bitrate))
+    return FALSE;
+
+  if (!gst_va_base_enc_add_frame_rate_parameter (base, picture))
+    return FALSE;
+
+  /* *INDENT-OFF* */
+  pic_param = (VAEncPictureParameterBufferH264) {
+    .coded_buf = picture->coded_buffer,
+    .pic_parameter_set_id = 0,
+    .seq_parameter_set_id = 0,
+    .frame_num = frame->frame_num,
+    .pic_init_qp = self->qp_i,
+    .num_ref_idx_l0_active_minus1 = 0,
+    .pic_fields.bits = {
+      .idr_pic_flag = frame->is_idr,
+      .reference_pic_flag = 1,
+      .entropy_coding_mode_flag = self->use_cabac,
+      .transform_8x8_mode_flag = self->use_dct8x8,
+      .deblocking_filter_control_present_flag = 1,
+    },
+  };
+  /* *INDENT-ON* */
+
+  _fill_va_picture (&pic_param.CurrPic, frame, 0);
+  _invalidate_va_pictures (pic_param.ReferenceFrames,
+      G_N_ELEMENTS (pic_param.ReferenceFrames));
+  if (ref) {
+    _fill_va_picture (&pic_param.ReferenceFrames[0], ref,
+        VA_PICTURE_H264_SHORT_TERM_REFERENCE);
+  }
+
+  if (!_add_picture_header (self, frame, &pic_param))
+    return FALSE;
+
+  /* *INDENT-OFF* */
+  slice = (VAEncSliceParameterBufferH264) {
+    .macroblock_address = 0,
+    .num_macroblocks = self->mb_width * self->mb_height,
+    .macroblock_info = VA_INVALID_ID,
+    .slice_type = ref ? GST_H264_P_SLICE : GST_H264_I_SLICE,
+    .pic_parameter_set_id = 0,
+    .idr_pic_id = self->idr_pic_id,
+    .pic_order_cnt_lsb = frame->poc % (1 << self->log2_max_poc_lsb),
+    .direct_spatial_mv_pred_flag = 1,
+    .num_ref_idx_l0_active_minus1 = 0,
+    .slice_qp_delta = (self->rc_ctrl == VA_RC_CQP && ref) ?
+        (gint) self->qp_p - (gint) self->qp_i : 0,
+  };
+  /* *INDENT-ON* */
+
+  _invalidate_va_pictures (slice.RefPicList0, G_N_ELEMENTS (slice.RefPicList0));
+  _invalidate_va_pictures (slice.RefPicList1, G_N_ELEMENTS (slice.RefPicList1));
+  if (ref) {
+    _fill_va_picture (&slice.RefPicList0[0], ref,
+        VA_PICTURE_H264_SHORT_TERM_REFERENCE);
+  }
+
+  if (!gst_va_encoder_add_param (base->encoder, picture,
+          VAEncSliceParameterBufferType, &slice, sizeof (slice))) {
+    GST_ERROR_OBJECT (self, "Failed to create the slice parameter");
+    return FALSE;
+  }
+
+  if (!gst_va_encoder_encode (base->encoder, picture)) {
+    GST_ERROR_OBJECT (self, "Failed to encode frame %d",
+        gst_frame->system_frame_number);
+    return FALSE;
+  }
+
+  if (frame->is_idr)
+    self->idr_pic_id = (self->idr_pic_id + 1) % 65536;
+  self->frame_num = (self->frame_num + 1) % (1 << self->log2_max_frame_num);
+  self->gop_frame_count++;
+
+  if (self->last_ref)
+    gst_video_codec_frame_unref (self->last_ref);
+  self->last_ref = gst_video_codec_frame_ref (gst_frame);
+
+  return TRUE;
+}
+
+static void
+gst_va_h264_enc_prepare_output (GstVaBaseEnc * base,
+    GstVideoCodecFrame * gst_frame)
+{
+  GstVaH264EncFrame *frame;
+
+  frame = (GstVaH264EncFrame *) gst_va_base_enc_get_frame (gst_frame);
+
+  if (frame->is_idr)
+    GST_VIDEO_CODEC_FRAME_SET_SYNC_POINT (gst_frame);
+  else
+    GST_VIDEO_CODEC_FRAME_UNSET_SYNC_POINT (gst_frame);
+}
+
+static void
+gst_va_h264_enc_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstVaH264Enc *self = GST_VA_H264_ENC (object);
+
+  GST_OBJECT_LOCK (object);
+  switch (prop_id) {
+    case PROP_KEY_INT_MAX:
+      self->prop.key_int_max = g_value_get_uint (value);
+      break;
+    case PROP_RATE_CONTROL:
+      self->prop.rc_ctrl = g_value_get_enum (value);
+      break;
+    case PROP_BITRATE:
+      self->prop.bitrate = g_value_get_uint (value);
+      break;
+    case PROP_QP_I:
+      self->prop.qp_i = g_value_get_uint (value);
+      break;
+    case PROP_QP_P:
+      self->prop.qp_p = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (object);
+}
+
+static void
+gst_va_h264_enc_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstVaH264Enc *self = GST_VA_H264_ENC (object);
+
+  GST_OBJECT_LOCK (object);
+  switch (prop_id) {
+    case PROP_KEY_INT_MAX:
+      g_value_set_uint (value, self->prop.key_int_max);
+      break;
+    case PROP_RATE_CONTROL:
+      g_value_set_enum (value, self->prop.rc_ctrl);
+      break;
+    case PROP_BITRATE:
+      g_value_set_uint (value, self->prop.bitrate);
+      break;
+    case PROP_QP_I:
+      g_value_set_uint (value, self->prop.qp_i);
+      break;
+    case PROP_QP_P:
+      g_value_set_uint (value, self->prop.qp_p);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (object);
+}
+
+static void
+gst_va_h264_enc_dispose (GObject * object)
+{
+  GstVaH264Enc *self = GST_VA_H264_ENC (object);
+
+  g_clear_pointer (&self->last_ref, gst_video_codec_frame_unref);
+  gst_va_base_enc_close (GST_VIDEO_ENCODER (object));
+
+  G_OBJECT_CLASS (parent_class)->dispose (object);
+}
+
+static void
+gst_va_h264_enc_class_init (gpointer g_class, gpointer class_data)
+{
+  GstCaps *src_doc_caps, *sink_doc_caps;
+  GObjectClass *gobject_class = G_OBJECT_CLASS (g_class);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (g_class);
+  GstVaBaseEncClass *va_enc_class = GST_VA_BASE_ENC_CLASS (g_class);
+  struct CData *cdata = class_data;
+  gboolean low_power = cdata->entrypoint == VAEntrypointEncSliceLP;
+  gchar *long_name;
+
+  if (cdata->description) {
+    long_name = g_strdup_printf ("VA-API H.264 %sEncoder in %s",
+        low_power ? "Low Power " : "", cdata->description);
+  } else {
+    long_name = g_strdup_printf ("VA-API H.264 %sEncoder",
+        low_power ? "Low Power " : "");
+  }
+
+  gst_element_class_set_metadata (element_class, long_name,
+      "Codec/Encoder/Video/Hardware",
+      "VA-API based H.264 video encoder", "GStreamer developers");
+
+  sink_doc_caps = gst_caps_from_string (sink_caps_str);
+  src_doc_caps = gst_caps_from_string (src_caps_str);
+
+  gst_va_base_enc_class_init (va_enc_class, H264, cdata->entrypoint,
+      cdata->render_device_path, cdata->sink_caps, cdata->src_caps,
+      src_doc_caps, sink_doc_caps);
+
+  gobject_class->set_property = gst_va_h264_enc_set_property;
+  gobject_class->get_property = gst_va_h264_enc_get_property;
+  gobject_class->dispose = gst_va_h264_enc_dispose;
+
+  va_enc_class->reconfig = GST_DEBUG_FUNCPTR (gst_va_h264_enc_reconfig);
+  va_enc_class->reset_state = GST_DEBUG_FUNCPTR (gst_va_h264_enc_reset_state);
+  va_enc_class->new_frame = GST_DEBUG_FUNCPTR (gst_va_h264_enc_new_frame);
+  va_enc_class->encode_frame =
+      GST_DEBUG_FUNCPTR (gst_va_h264_enc_encode_frame);
+  va_enc_class->prepare_output =
+      GST_DEBUG_FUNCPTR (gst_va_h264_enc_prepare_output);
+
+  /**
+   * GstVaH264Enc:key-int-max:
+   *
+   * Maximal distance between two IDR frames.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_KEY_INT_MAX,
+      g_param_spec_uint ("key-int-max", "Key frame maximal interval",
+          "Maximal distance between two IDR frames", 1, 1024,
+          DEFAULT_KEY_INT_MAX, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstVaH264Enc:rate-control:
+   *
+   * The rate control mode. If the driver doesn't support it,
+   * another supported mode is used.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_RATE_CONTROL,
+      g_param_spec_enum ("rate-control", "Rate control",
+          "The rate control mode", GST_TYPE_VA_ENCODER_RATE_CONTROL,
+          DEFAULT_RATE_CONTROL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstVaH264Enc:bitrate:
+   *
+   * The target bitrate in kbit/s for the cbr and vbr rate control
+   * modes. 0 picks one from the resolution and the framerate.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_BITRATE,
+      g_param_spec_uint ("bitrate", "Bitrate (kbps)",
+          "The target bitrate in kbit/s (0: auto)", 0, 2000 * 1024,
+          DEFAULT_BITRATE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstVaH264Enc:qpi:
+   *
+   * The quantizer of I frames in cqp mode, and the initial one in
+   * the other modes.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_QP_I,
+      g_param_spec_uint ("qpi", "I frame QP",
+          "The quantizer value for I frames", 0, 51, DEFAULT_QP,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstVaH264Enc:qpp:
+   *
+   * The quantizer of P frames in cqp mode.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_QP_P,
+      g_param_spec_uint ("qpp", "P frame QP",
+          "The quantizer value for P frames", 0, 51, DEFAULT_QP,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_free (long_name);
+  g_free (cdata->description);
+  g_free (cdata->render_device_path);
+  gst_caps_unref (cdata->src_caps);
+  gst_caps_unref (cdata->sink_caps);
+  g_free (cdata);
+}
+
+static void
+gst_va_h264_enc_init (GTypeInstance * instance, gpointer g_class)
+{
+  GstVaH264Enc *self = GST_VA_H264_ENC (instance);
+
+  gst_va_base_enc_init (GST_VA_BASE_ENC (instance), GST_CAT_DEFAULT);
+
+  self->prop.key_int_max = DEFAULT_KEY_INT_MAX;
+  self->prop.rc_ctrl = DEFAULT_RATE_CONTROL;
+  self->prop.bitrate = DEFAULT_BITRATE;
+  self->prop.qp_i = DEFAULT_QP;
+  self->prop.qp_p = DEFAULT_QP;
+}
+
+static gpointer
+_register_debug_category (gpointer data)
+{
+  GST_DEBUG_CATEGORY_INIT (gst_va_h264enc_debug, "vah264enc", 0,
+      "VA h264 encoder");
+
+  return NULL;
+}
+
+static GstCaps *
+_complete_src_caps (GstCaps * srccaps)
+{
+  GstCaps *caps = gst_caps_copy (srccaps);
+
+  gst_caps_set_simple (caps, "stream-format", G_TYPE_STRING, "byte-stream",
+      "alignment", G_TYPE_STRING, "au", NULL);
+
+  return caps;
+}
+
+gboolean
+gst_va_h264_enc_register (GstPlugin * plugin, GstVaDevice * device,
+    GstCaps * sink_caps, GstCaps * src_caps, guint rank,
+    VAEntrypoint entrypoint)
+{
+  static GOnce debug_once = G_ONCE_INIT;
+  GType type;
+  GTypeInfo type_info = {
+    .class_size = sizeof (GstVaH264EncClass),
+    .class_init = gst_va_h264_enc_class_init,
+    .instance_size = sizeof (GstVaH264Enc),
+    .instance_init = gst_va_h264_enc_init,
+  };
+  struct CData *cdata;
+  gboolean ret;
+  gchar *type_name, *feature_name;
+
+  g_return_val_if_fail (GST_IS_PLUGIN (plugin), FALSE);
+  g_return_val_if_fail (GST_IS_VA_DEVICE (device), FALSE);
+  g_return_val_if_fail (GST_IS_CAPS (sink_caps), FALSE);
+  g_return_val_if_fail (GST_IS_CAPS (src_caps), FALSE);
+  g_return_val_if_fail (entrypoint == VAEntrypointEncSlice
+      || entrypoint == VAEntrypointEncSliceLP, FALSE);
+
+  cdata = g_new (struct CData, 1);
+  cdata->entrypoint = entrypoint;
+  cdata->description = NULL;
+  cdata->render_device_path = g_strdup (device->render_device_path);
+  cdata->sink_caps = gst_caps_ref (sink_caps);
+  cdata->src_caps = _complete_src_caps (src_caps);
+
+  /* class data will be leaked if the element never gets instantiated */
+  GST_MINI_OBJECT_FLAG_SET (sink_caps, GST_MINI_OBJECT_FLAG_MAY_BE_LEAKED);
+  GST_MINI_OBJECT_FLAG_SET (cdata->src_caps,
+      GST_MINI_OBJECT_FLAG_MAY_BE_LEAKED);
+
+  type_info.class_data = cdata;
+
+  if (entrypoint == VAEntrypointEncSlice) {
+    type_name = g_strdup ("GstVaH264Enc");
+    feature_name = g_strdup ("vah264enc");
+  } else {
+    type_name = g_strdup ("GstVaH264LPEnc");
+    feature_name = g_strdup ("vah264lpenc");
+  }
+
+  /* The first encoder to be registered should use a constant name,
+   * like vah264enc, for any additional encoders, we create unique
+   * names, using inserting the render device name. */
+  if (g_type_from_name (type_name)) {
+    gchar *basename = g_path_get_basename (device->render_device_path);
+    g_free (type_name);
+    g_free (feature_name);
+    if (entrypoint == VAEntrypointEncSlice) {
+      type_name = g_strdup_printf ("GstVa%sH264Enc", basename);
+      feature_name = g_strdup_printf ("va%sh264enc", basename);
+    } else {
+      type_name = g_strdup_printf ("GstVa%sH264LPEnc", basename);
+      feature_name = g_strdup_printf ("va%sh264lpenc", basename);
+    }
+    cdata->description = basename;
+
+    /* lower rank for non-first device */
+    if (rank > 0)
+      rank--;
+  }
+
+  g_once (&debug_once, _register_debug_category, NULL);
+
+  type = g_type_register_static (GST_TYPE_VIDEO_ENCODER,
+      type_name, &type_info, 0);
+
+  ret = gst_element_register (plugin, feature_name, rank, type);
+
+  g_free (type_name);
+  g_free (feature_name);
+
+  return ret;
+}
@@ -720,6 +720,7 @@ gst_va_h265_dec_new_sequence (GstH265Decoder * decoder, const GstH265SPS * sps,
   gint display_width;
   gint display_height;
   guint rt_format;
+  gint min_buffers;
   gboolean negotiation_needed = FALSE;
 
   if (self->dpb_size < max_dpb_size)
@@ -775,7 +776,14 @@ gst_va_h265_dec_new_sequence (GstH265Decoder * decoder, const GstH265SPS * sps,
     /* *INDENT-ON* */
   }
 
-  base->min_buffers = self->dpb_size + 4;       /* dpb size + scratch surfaces */
+  /* The pool grows on demand up to the DPB size, so only preallocate what
+   * the stream signals it needs, or what the previous sequence actually
+   * used, plus scratch surfaces */
+  min_buffers =
+      sps->max_dec_pic_buffering_minus1[sps->max_sub_layers_minus1] + 1;
+  min_buffers = MAX (min_buffers,
+      gst_h265_decoder_get_max_pictures_in_use (decoder));
+  base->min_buffers = MIN (min_buffers, self->dpb_size) + 4;
 
   if (negotiation_needed) {
     self->need_negotiation = TRUE;
@@ -0,0 +1,1408 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-vah265enc
+ * @title: vah265enc
+ * @short_description: A VA-API based H265 video encoder
+ *
+ * vah265enc encodes raw video VA surfaces into H265 bitstreams using
+ * the installed and chosen [VA-API](https://01.org/linuxmedia/vaapi)
+ * driver.
+ *
+ * The raw video frames in main memory can be imported into VA
+ * surfaces.
+ *
+ * ## Example launch line
+ * ```
+ * gst-launch-1.0 videotestsrc num-buffers=60 ! timeoverlay ! vah265enc ! h265parse ! mp4mux ! filesink location=test.mp4
+ * ```
+ *
+ * Since: 1.20
+ *
+ */
+
+/**
+ * SECTION:element-vah265lpenc
+ * @title: vah265lpenc
+ * @short_description: A VA-API based H265 low power video encoder
+ *
+ * vah265lpenc encodes raw video VA surfaces into H265 bitstreams using
+ * the low power entrypoint of the installed and chosen
+ * [VA-API](https://01.org/linuxmedia/vaapi) driver.
+ *
+ * ## Example launch line
+ * ```
+ * gst-launch-1.0 videotestsrc num-buffers=60 ! timeoverlay ! vah265lpenc ! h265parse ! mp4mux ! filesink location=test.mp4
+ * ```
+ *
+ * Since: 1.20
+ *
+ */
+
+/* ToDo:
+ *
+ * + B frames and frame reordering
+ * + multiple slices and multiple reference frames
+ * + sample adaptive offset
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstvah265enc.h"
+
+#include <gst/codecparsers/gsth265parser.h>
+
+#include "gstvabaseenc.h"
+#include "gstvavideoformat.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_va_h265enc_debug);
+#ifndef GST_DISABLE_GST_DEBUG
+#define GST_CAT_DEFAULT gst_va_h265enc_debug
+#else
+#define GST_CAT_DEFAULT NULL
+#endif
+
+#define GST_VA_H265_ENC(obj)           ((GstVaH265Enc *) obj)
+#define GST_VA_H265_ENC_GET_CLASS(obj) (G_TYPE_INSTANCE_GET_CLASS ((obj), G_TYPE_FROM_INSTANCE (obj), GstVaH265EncClass))
+#define GST_VA_H265_ENC_CLASS(klass)   ((GstVaH265EncClass *) klass)
+
+typedef struct _GstVaH265Enc GstVaH265Enc;
+typedef struct _GstVaH265EncClass GstVaH265EncClass;
+typedef struct _GstVaH265EncFrame GstVaH265EncFrame;
+
+enum
+{
+  PROP_KEY_INT_MAX = 1,
+  PROP_RATE_CONTROL,
+  PROP_BITRATE,
+  PROP_QP_I,
+  PROP_QP_P,
+};
+
+#define DEFAULT_KEY_INT_MAX 30
+#define DEFAULT_RATE_CONTROL VA_RC_CQP
+#define DEFAULT_BITRATE 0
+#define DEFAULT_QP 26
+
+/* all the headers are written by the element, or none */
+#define PACKED_HEADERS (VA_ENC_PACKED_HEADER_SEQUENCE \
+    | VA_ENC_PACKED_HEADER_PICTURE | VA_ENC_PACKED_HEADER_SLICE)
+
+/* the coding_type of VAEncPictureParameterBufferHEVC */
+enum
+{
+  CODING_TYPE_I = 1,
+  CODING_TYPE_P = 2,
+  CODING_TYPE_B = 3,
+};
+
+struct _GstVaH265EncClass
+{
+  GstVaBaseEncClass parent_class;
+};
+
+struct _GstVaH265Enc
+{
+  GstVaBaseEnc parent;
+
+  /* properties, protected by the object lock */
+  struct
+  {
+    guint key_int_max;
+    guint32 rc_ctrl;
+    guint bitrate;
+    guint qp_i;
+    guint qp_p;
+  } prop;
+
+  /* configuration of the current coded video sequence */
+  VAProfile profile;
+  const gchar *profile_name;
+  guint8 level_idc;
+  const gchar *level_name;
+  guint bit_depth;
+  guint width;
+  guint height;
+  guint ctb_size;
+  guint32 rc_ctrl;
+  guint bitrate;
+  guint qp_i;
+  guint qp_p;
+  guint key_int_max;
+  guint32 packed_headers;
+  /* low power entrypoints may only support B slices, P frames are
+   * encoded as low delay B ones there */
+  gboolean low_delay_b;
+  gboolean cu_qp_delta;
+  guint log2_max_poc_lsb;
+  guint conf_win_right;
+  guint conf_win_bottom;
+
+  VAEncSequenceParameterBufferHEVC sequence;
+
+  /* encoding state */
+  guint gop_frame_count;
+  /* the previous frame, the only reference of the inter frames */
+  GstVideoCodecFrame *last_ref;
+};
+
+struct _GstVaH265EncFrame
+{
+  GstVaEncFrame base;
+
+  gboolean is_idr;
+  gint poc;
+};
+
+#define parent_class gst_va_base_enc_parent_class
+extern gpointer gst_va_base_enc_parent_class;
+
+/* *INDENT-OFF* */
+static const gchar *sink_caps_str = GST_VIDEO_CAPS_MAKE_WITH_FEATURES ("memory:VAMemory",
+            "{ NV12, P010_10LE }") " ;" GST_VIDEO_CAPS_MAKE ("{ NV12, P010_10LE }");
+/* *INDENT-ON* */
+
+static const gchar *src_caps_str = "video/x-h265";
+
+static const struct
+{
+  VAProfile profile;
+  const gchar *name;
+  guint8 profile_idc;
+  guint bit_depth;
+} profile_map[] = {
+  {VAProfileHEVCMain, "main", 1, 8},
+  {VAProfileHEVCMain10, "main-10", 2, 10},
+};
+
+/* Table A.8, main tier, MaxBR in 1000 bits/s */
+static const struct
+{
+  const gchar *name;
+  guint8 level_idc;
+  guint32 max_luma_ps;
+  guint64 max_luma_sr;
+  guint32 max_br;
+} level_map[] = {
+  {"1", 30, 36864, 552960, 128},
+  {"2", 60, 122880, 3686400, 1500},
+  {"2.1", 63, 245760, 7372800, 3000},
+  {"3", 90, 552960, 16588800, 6000},
+  {"3.1", 93, 983040, 33177600, 10000},
+  {"4", 120, 2228224, 66846720, 12000},
+  {"4.1", 123, 2228224, 133693440, 20000},
+  {"5", 150, 8912896, 267386880, 25000},
+  {"5.1", 153, 8912896, 534773760, 40000},
+  {"5.2", 156, 8912896, 1069547520, 60000},
+  {"6", 180, 35651584, 1069547520, 60000},
+  {"6.1", 183, 35651584, 2139095040, 120000},
+  {"6.2", 186, 35651584, G_GUINT64_CONSTANT (4278190080), 240000},
+};
+
+static void
+_get_framerate (GstVaBaseEnc * base, gint * fps_n, gint * fps_d)
+{
+  GstVideoInfo *info = &base->input_state->info;
+
+  if (GST_VIDEO_INFO_FPS_N (info) > 0 && GST_VIDEO_INFO_FPS_D (info) > 0) {
+    *fps_n = GST_VIDEO_INFO_FPS_N (info);
+    *fps_d = GST_VIDEO_INFO_FPS_D (info);
+  } else {
+    *fps_n = 25;
+    *fps_d = 1;
+  }
+}
+
+/* The profile follows the bit depth of the input, it only has to be
+ * supported by the driver and accepted downstream */
+static gboolean
+_decide_profile (GstVaH265Enc * self, guint bit_depth)
+{
+  GstVaBaseEnc *base = GST_VA_BASE_ENC (self);
+  GstCaps *allowed_caps, *caps;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (profile_map); i++) {
+    if (profile_map[i].bit_depth == bit_depth)
+      break;
+  }
+
+  if (i == G_N_ELEMENTS (profile_map)) {
+    GST_ERROR_OBJECT (self, "Unsupported bit depth %u", bit_depth);
+    return FALSE;
+  }
+
+  if (!gst_va_encoder_has_profile (base->encoder, profile_map[i].profile)) {
+    GST_ERROR_OBJECT (self, "Profile %s is not supported by the driver",
+        profile_map[i].name);
+    return FALSE;
+  }
+
+  allowed_caps = gst_pad_get_allowed_caps (GST_VIDEO_ENCODER_SRC_PAD (self));
+  if (allowed_caps && !gst_caps_is_any (allowed_caps)) {
+    gboolean allowed;
+
+    caps = gst_caps_new_simple ("video/x-h265", "profile", G_TYPE_STRING,
+        profile_map[i].name, NULL);
+    allowed = gst_caps_can_intersect (allowed_caps, caps);
+    gst_caps_unref (caps);
+
+    if (!allowed) {
+      GST_ERROR_OBJECT (self, "Profile %s is not accepted downstream",
+          profile_map[i].name);
+      gst_caps_unref (allowed_caps);
+      return FALSE;
+    }
+  }
+  gst_clear_caps (&allowed_caps);
+
+  self->profile = profile_map[i].profile;
+  self->profile_name = profile_map[i].name;
+  self->bit_depth = bit_depth;
+
+  GST_INFO_OBJECT (self, "Using profile %s", self->profile_name);
+
+  return TRUE;
+}
+
+static void
+_decide_level (GstVaH265Enc * self)
+{
+  GstVaBaseEnc *base = GST_VA_BASE_ENC (self);
+  guint64 picture_size = (guint64) self->width * self->height;
+  guint64 sample_rate;
+  gint fps_n, fps_d;
+  guint i;
+
+  _get_framerate (base, &fps_n, &fps_d);
+  sample_rate = gst_util_uint64_scale_int_ceil (picture_size, fps_n, fps_d);
+
+  for (i = 0; i < G_N_ELEMENTS (level_map); i++) {
+    /* A.4.1, the picture dimensions are bounded too */
+    if (picture_size <= level_map[i].max_luma_ps
+        && (guint64) self->width * self->width <=
+        8 * (guint64) level_map[i].max_luma_ps
+        && (guint64) self->height * self->height <=
+        8 * (guint64) level_map[i].max_luma_ps
+        && sample_rate <= level_map[i].max_luma_sr
+        && self->bitrate <= level_map[i].max_br)
+      break;
+  }
+
+  if (i == G_N_ELEMENTS (level_map)) {
+    GST_WARNING_OBJECT (self, "The stream exceeds the highest level");
+    i = G_N_ELEMENTS (level_map) - 1;
+  }
+
+  self->level_idc = level_map[i].level_idc;
+  self->level_name = level_map[i].name;
+
+  GST_INFO_OBJECT (self, "Using level %s", self->level_name);
+}
+
+static void
+_fill_sequence_param (GstVaH265Enc * self)
+{
+  GstVaBaseEnc *base = GST_VA_BASE_ENC (self);
+  GstVideoInfo *info = &base->input_state->info;
+  gint par_n = GST_VIDEO_INFO_PAR_N (info);
+  gint par_d = GST_VIDEO_INFO_PAR_D (info);
+  gboolean has_par, has_timing;
+  guint profile_idc = 0, i;
+
+  for (i = 0; i < G_N_ELEMENTS (profile_map); i++) {
+    if (profile_map[i].profile == self->profile)
+      profile_idc = profile_map[i].profile_idc;
+  }
+
+  has_par = par_n > 0 && par_d > 0 && par_n != par_d
+      && par_n <= G_MAXUINT16 && par_d <= G_MAXUINT16;
+  has_timing = GST_VIDEO_INFO_FPS_N (info) > 0
+      && GST_VIDEO_INFO_FPS_D (info) > 0;
+
+  /* *INDENT-OFF* */
+  self->sequence = (VAEncSequenceParameterBufferHEVC) {
+    .general_profile_idc = profile_idc,
+    .general_level_idc = self->level_idc,
+    .general_tier_flag = 0,
+    .intra_period = self->key_int_max,
+    .intra_idr_period = self->key_int_max,
+    .ip_period = 1,
+    .bits_per_second = self->rc_ctrl == VA_RC_CQP ? 0 : self->bitrate * 1000,
+    .pic_width_in_luma_samples = self->width,
+    .pic_height_in_luma_samples = self->height,
+    .seq_fields.bits = {
+      .chroma_format_idc = 1,
+      .bit_depth_luma_minus8 = self->bit_depth - 8,
+      .bit_depth_chroma_minus8 = self->bit_depth - 8,
+      /* asymmetric motion partitions aren't supported by the low power
+       * entrypoints */
+      .amp_enabled_flag = !gst_va_encoder_is_low_power (base->encoder),
+      .sample_adaptive_offset_enabled_flag = 0,
+      .sps_temporal_mvp_enabled_flag = 1,
+    },
+    /* 8x8 minimum coding blocks, 4x4 to 32x32 transform blocks */
+    .log2_min_luma_coding_block_size_minus3 = 0,
+    .log2_diff_max_min_luma_coding_block_size =
+        g_bit_storage (self->ctb_size) - 1 - 3,
+    .log2_min_transform_block_size_minus2 = 0,
+    .log2_diff_max_min_transform_block_size = 3,
+    .max_transform_hierarchy_depth_inter = 2,
+    .max_transform_hierarchy_depth_intra = 2,
+    .vui_parameters_present_flag = 1,
+    .vui_fields.bits = {
+      .aspect_ratio_info_present_flag = has_par,
+      .vui_timing_info_present_flag = has_timing,
+      .log2_max_mv_length_horizontal = 15,
+      .log2_max_mv_length_vertical = 15,
+    },
+    /* EXTENDED_SAR */
+    .aspect_ratio_idc = has_par ? 255 : 0,
+    .sar_width = has_par ? par_n : 0,
+    .sar_height = has_par ? par_d : 0,
+    .vui_num_units_in_tick = has_timing ? GST_VIDEO_INFO_FPS_D (info) : 0,
+    .vui_time_scale = has_timing ? GST_VIDEO_INFO_FPS_N (info) : 0,
+  };
+  /* *INDENT-ON* */
+}
+
+#define WRITE_BITS(val, nbits) G_STMT_START {                   \
+  if (!gst_bit_writer_put_bits_uint32 (bw, val, nbits))         \
+    goto error;                                                 \
+} G_STMT_END
+#define WRITE_UE(val) G_STMT_START {                            \
+  if (!gst_va_bit_writer_put_ue (bw, val))                      \
+    goto error;                                                 \
+} G_STMT_END
+#define WRITE_SE(val) G_STMT_START {                            \
+  if (!gst_va_bit_writer_put_se (bw, val))                      \
+    goto error;                                                 \
+} G_STMT_END
+
+/* 7.3.1.2 */
+static gboolean
+_write_nal_header (GstBitWriter * bw, guint nal_unit_type)
+{
+  /* start code */
+  WRITE_BITS (0x00000001, 32);
+  /* forbidden_zero_bit */
+  WRITE_BITS (0, 1);
+  WRITE_BITS (nal_unit_type, 6);
+  /* nuh_layer_id */
+  WRITE_BITS (0, 6);
+  /* nuh_temporal_id_plus1 */
+  WRITE_BITS (1, 3);
+
+  return TRUE;
+
+error:
+  return FALSE;
+}
+
+/* 7.3.3, without sub-layers */
+static gboolean
+_write_profile_tier_level (GstVaH265Enc * self, GstBitWriter * bw)
+{
+  const VAEncSequenceParameterBufferHEVC *seq = &self->sequence;
+  guint32 compatibility_flags;
+
+  /* Main streams are Main 10 streams too */
+  compatibility_flags = 1U << (31 - seq->general_profile_idc);
+  if (seq->general_profile_idc == 1)
+    compatibility_flags |= 1U << (31 - 2);
+
+  /* general_profile_space */
+  WRITE_BITS (0, 2);
+  WRITE_BITS (seq->general_tier_flag, 1);
+  WRITE_BITS (seq->general_profile_idc, 5);
+  WRITE_BITS (compatibility_flags, 32);
+  /* general_progressive_source_flag */
+  WRITE_BITS (1, 1);
+  /* general_interlaced_source_flag */
+  WRITE_BITS (0, 1);
+  /* general_non_packed_constraint_flag */
+  WRITE_BITS (0, 1);
+  /* general_frame_only_constraint_flag */
+  WRITE_BITS (1, 1);
+  /* general_reserved_zero_43bits and general_inbld_flag */
+  WRITE_BITS (0, 32);
+  WRITE_BITS (0, 12);
+  WRITE_BITS (seq->general_level_idc, 8);
+
+  return TRUE;
+
+error:
+  return FALSE;
+}
+
+/* 7.3.2.1 */
+static gboolean
+_write_vps (GstVaH265Enc * self, GstBitWriter * bw)
+{
+  if (!_write_nal_header (bw, GST_H265_NAL_VPS))
+    goto error;
+
+  /* vps_video_parameter_set_id */
+  WRITE_BITS (0, 4);
+  /* vps_base_layer_internal_flag and vps_base_layer_available_flag */
+  WRITE_BITS (3, 2);
+  /* vps_max_layers_minus1 */
+  WRITE_BITS (0, 6);
+  /* vps_max_sub_layers_minus1 */
+  WRITE_BITS (0, 3);
+  /* vps_temporal_id_nesting_flag */
+  WRITE_BITS (1, 1);
+  /* vps_reserved_0xffff_16bits */
+  WRITE_BITS (0xffff, 16);
+
+  if (!_write_profile_tier_level (self, bw))
+    goto error;
+
+  /* vps_sub_layer_ordering_info_present_flag */
+  WRITE_BITS (1, 1);
+  /* vps_max_dec_pic_buffering_minus1, the reference and the current
+   * picture */
+  WRITE_UE (1);
+  /* vps_max_num_reorder_pics */
+  WRITE_UE (0);
+  /* vps_max_latency_increase_plus1 */
+  WRITE_UE (0);
+  /* vps_max_layer_id */
+  WRITE_BITS (0, 6);
+  /* vps_num_layer_sets_minus1 */
+  WRITE_UE (0);
+  /* vps_timing_info_present_flag */
+  WRITE_BITS (0, 1);
+  /* vps_extension_flag */
+  WRITE_BITS (0, 1);
+
+  return gst_va_bit_writer_put_trailing_bits (bw);
+
+error:
+  return FALSE;
+}
+
+/* 7.3.2.2.1 */
+static gboolean
+_write_sps (GstVaH265Enc * self, GstBitWriter * bw)
+{
+  const VAEncSequenceParameterBufferHEVC *seq = &self->sequence;
+  gboolean conformance_window;
+
+  if (!_write_nal_header (bw, GST_H265_NAL_SPS))
+    goto error;
+
+  /* sps_video_parameter_set_id */
+  WRITE_BITS (0, 4);
+  /* sps_max_sub_layers_minus1 */
+  WRITE_BITS (0, 3);
+  /* sps_temporal_id_nesting_flag */
+  WRITE_BITS (1, 1);
+
+  if (!_write_profile_tier_level (self, bw))
+    goto error;
+
+  /* sps_seq_parameter_set_id */
+  WRITE_UE (0);
+  WRITE_UE (seq->seq_fields.bits.chroma_format_idc);
+  WRITE_UE (seq->pic_width_in_luma_samples);
+  WRITE_UE (seq->pic_height_in_luma_samples);
+
+  /* in chroma samples, 4:2:0 only */
+  conformance_window = self->conf_win_right > 0 || self->conf_win_bottom > 0;
+  WRITE_BITS (conformance_window, 1);
+  if (conformance_window) {
+    WRITE_UE (0);
+    WRITE_UE (self->conf_win_right / 2);
+    WRITE_UE (0);
+    WRITE_UE (self->conf_win_bottom / 2);
+  }
+
+  WRITE_UE (seq->seq_fields.bits.bit_depth_luma_minus8);
+  WRITE_UE (seq->seq_fields.bits.bit_depth_chroma_minus8);
+  WRITE_UE (self->log2_max_poc_lsb - 4);
+  /* sps_sub_layer_ordering_info_present_flag */
+  WRITE_BITS (1, 1);
+  /* sps_max_dec_pic_buffering_minus1 */
+  WRITE_UE (1);
+  /* sps_max_num_reorder_pics */
+  WRITE_UE (0);
+  /* sps_max_latency_increase_plus1 */
+  WRITE_UE (0);
+  WRITE_UE (seq->log2_min_luma_coding_block_size_minus3);
+  WRITE_UE (seq->log2_diff_max_min_luma_coding_block_size);
+  WRITE_UE (seq->log2_min_transform_block_size_minus2);
+  WRITE_UE (seq->log2_diff_max_min_transform_block_size);
+  WRITE_UE (seq->max_transform_hierarchy_depth_inter);
+  WRITE_UE (seq->max_transform_hierarchy_depth_intra);
+  WRITE_BITS (seq->seq_fields.bits.scaling_list_enabled_flag, 1);
+  WRITE_BITS (seq->seq_fields.bits.amp_enabled_flag, 1);
+  WRITE_BITS (seq->seq_fields.bits.sample_adaptive_offset_enabled_flag, 1);
+  WRITE_BITS (seq->seq_fields.bits.pcm_enabled_flag, 1);
+  /* num_short_term_ref_pic_sets, each slice carries its own */
+  WRITE_UE (0);
+  /* long_term_ref_pics_present_flag */
+  WRITE_BITS (0, 1);
+  WRITE_BITS (seq->seq_fields.bits.sps_temporal_mvp_enabled_flag, 1);
+  WRITE_BITS (seq->seq_fields.bits.strong_intra_smoothing_enabled_flag, 1);
+
+  WRITE_BITS (seq->vui_parameters_present_flag, 1);
+  if (seq->vui_parameters_present_flag) {
+    /* E.2.1 */
+    WRITE_BITS (seq->vui_fields.bits.aspect_ratio_info_present_flag, 1);
+    if (seq->vui_fields.bits.aspect_ratio_info_present_flag) {
+      WRITE_BITS (seq->aspect_ratio_idc, 8);
+      WRITE_BITS (seq->sar_width, 16);
+      WRITE_BITS (seq->sar_height, 16);
+    }
+    /* overscan_info_present_flag, video_signal_type_present_flag,
+     * chroma_loc_info_present_flag, neutral_chroma_indication_flag,
+     * field_seq_flag, frame_field_info_present_flag and
+     * default_display_window_flag */
+    WRITE_BITS (0, 7);
+    WRITE_BITS (seq->vui_fields.bits.vui_timing_info_present_flag, 1);
+    if (seq->vui_fields.bits.vui_timing_info_present_flag) {
+      WRITE_BITS (seq->vui_num_units_in_tick, 32);
+      WRITE_BITS (seq->vui_time_scale, 32);
+      /* vui_poc_proportional_to_timing_flag and
+       * vui_hrd_parameters_present_flag */
+      WRITE_BITS (0, 2);
+    }
+    /* bitstream_restriction_flag */
+    WRITE_BITS (0, 1);
+  }
+
+  /* sps_extension_present_flag */
+  WRITE_BITS (0, 1);
+
+  return gst_va_bit_writer_put_trailing_bits (bw);
+
+error:
+  return FALSE;
+}
+
+/* 7.3.2.3.1 */
+static gboolean
+_write_pps (GstVaH265Enc * self, GstBitWriter * bw,
+    const VAEncPictureParameterBufferHEVC * pic_param)
+{
+  if (!_write_nal_header (bw, GST_H265_NAL_PPS))
+    goto error;
+
+  WRITE_UE (pic_param->slice_pic_parameter_set_id);
+  /* pps_seq_parameter_set_id */
+  WRITE_UE (0);
+  WRITE_BITS (pic_param->pic_fields.bits.
+      dependent_slice_segments_enabled_flag, 1);
+  /* output_flag_present_flag */
+  WRITE_BITS (0, 1);
+  /* num_extra_slice_header_bits */
+  WRITE_BITS (0, 3);
+  WRITE_BITS (pic_param->pic_fields.bits.sign_data_hiding_enabled_flag, 1);
+  /* cabac_init_present_flag */
+  WRITE_BITS (0, 1);
+  WRITE_UE (pic_param->num_ref_idx_l0_default_active_minus1);
+  WRITE_UE (pic_param->num_ref_idx_l1_default_active_minus1);
+  WRITE_SE ((gint) pic_param->pic_init_qp - 26);
+  WRITE_BITS (pic_param->pic_fields.bits.constrained_intra_pred_flag, 1);
+  WRITE_BITS (pic_param->pic_fields.bits.transform_skip_enabled_flag, 1);
+  WRITE_BITS (pic_param->pic_fields.bits.cu_qp_delta_enabled_flag, 1);
+  if (pic_param->pic_fields.bits.cu_qp_delta_enabled_flag)
+    WRITE_UE (pic_param->diff_cu_qp_delta_depth);
+  WRITE_SE (pic_param->pps_cb_qp_offset);
+  WRITE_SE (pic_param->pps_cr_qp_offset);
+  /* pps_slice_chroma_qp_offsets_present_flag */
+  WRITE_BITS (0, 1);
+  WRITE_BITS (pic_param->pic_fields.bits.weighted_pred_flag, 1);
+  WRITE_BITS (pic_param->pic_fields.bits.weighted_bipred_flag, 1);
+  WRITE_BITS (pic_param->pic_fields.bits.transquant_bypass_enabled_flag, 1);
+  WRITE_BITS (pic_param->pic_fields.bits.tiles_enabled_flag, 1);
+  WRITE_BITS (pic_param->pic_fields.bits.entropy_coding_sync_enabled_flag, 1);
+  WRITE_BITS (pic_param->pic_fields.bits.
+      pps_loop_filter_across_slices_enabled_flag, 1);
+  /* deblocking_filter_control_present_flag */
+  WRITE_BITS (0, 1);
+  WRITE_BITS (pic_param->pic_fields.bits.scaling_list_data_present_flag, 1);
+  /* lists_modification_present_flag */
+  WRITE_BITS (0, 1);
+  WRITE_UE (pic_param->log2_parallel_merge_level_minus2);
+  /* slice_segment_header_extension_present_flag */
+  WRITE_BITS (0, 1);
+  /* pps_extension_present_flag */
+  WRITE_BITS (0, 1);
+
+  return gst_va_bit_writer_put_trailing_bits (bw);
+
+error:
+  return FALSE;
+}
+
+/* 7.3.6.1, for the single slice segment of the picture */
+static gboolean
+_write_slice_header (GstVaH265Enc * self, GstBitWriter * bw,
+    GstVaH265EncFrame * frame, GstVaH265EncFrame * ref,
+    const VAEncPictureParameterBufferHEVC * pic_param,
+    const VAEncSliceParameterBufferHEVC * slice)
+{
+  if (!_write_nal_header (bw, pic_param->nal_unit_type))
+    goto error;
+
+  /* first_slice_segment_in_pic_flag */
+  WRITE_BITS (1, 1);
+  if (frame->is_idr) {
+    /* no_output_of_prior_pics_flag */
+    WRITE_BITS (0, 1);
+  }
+  WRITE_UE (slice->slice_pic_parameter_set_id);
+  WRITE_UE (slice->slice_type);
+
+  if (!frame->is_idr) {
+    WRITE_BITS (frame->poc % (1 << self->log2_max_poc_lsb),
+        self->log2_max_poc_lsb);
+    /* short_term_ref_pic_set_sps_flag */
+    WRITE_BITS (0, 1);
+    /* 7.3.7, st_ref_pic_set (0) with the previous picture */
+    /* num_negative_pics */
+    WRITE_UE (1);
+    /* num_positive_pics */
+    WRITE_UE (0);
+    /* delta_poc_s0_minus1 */
+    WRITE_UE (frame->poc - ref->poc - 1);
+    /* used_by_curr_pic_s0_flag */
+    WRITE_BITS (1, 1);
+
+    if (self->sequence.seq_fields.bits.sps_temporal_mvp_enabled_flag)
+      WRITE_BITS (slice->slice_fields.bits.slice_temporal_mvp_enabled_flag, 1);
+  }
+
+  if (slice->slice_type != GST_H265_I_SLICE) {
+    WRITE_BITS (slice->slice_fields.bits.num_ref_idx_active_override_flag, 1);
+    if (slice->slice_type == GST_H265_B_SLICE)
+      WRITE_BITS (slice->slice_fields.bits.mvd_l1_zero_flag, 1);
+    if (slice->slice_fields.bits.slice_temporal_mvp_enabled_flag
+        && slice->slice_type == GST_H265_B_SLICE)
+      WRITE_BITS (slice->slice_fields.bits.collocated_from_l0_flag, 1);
+    /* five_minus_max_num_merge_cand */
+    WRITE_UE (5 - slice->max_num_merge_cand);
+  }
+
+  WRITE_SE (slice->slice_qp_delta);
+
+  /* byte_alignment () */
+  WRITE_BITS (1, 1);
+  if (!gst_bit_writer_align_bytes (bw, 0))
+    goto error;
+
+  return TRUE;
+
+error:
+  return FALSE;
+}
+
+#undef WRITE_BITS
+#undef WRITE_UE
+#undef WRITE_SE
+
+static gboolean
+_add_sequence_header (GstVaH265Enc * self, GstVaH265EncFrame * frame)
+{
+  GstVaBaseEnc *base = GST_VA_BASE_ENC (self);
+  GstBitWriter bw;
+  gboolean ret;
+
+  if (!gst_va_encoder_add_param (base->encoder, frame->base.picture,
+          VAEncSequenceParameterBufferType, &self->sequence,
+          sizeof (self->sequence))) {
+    GST_ERROR_OBJECT (self, "Failed to create the sequence parameter");
+    return FALSE;
+  }
+
+  if (!self->packed_headers)
+    return TRUE;
+
+  gst_bit_writer_init (&bw);
+  ret = _write_vps (self, &bw) && _write_sps (self, &bw)
+      && gst_va_encoder_add_packed_header (base->encoder, frame->base.picture,
+      VAEncPackedHeaderSequence, gst_bit_writer_get_data (&bw),
+      gst_bit_writer_get_size (&bw), FALSE);
+  gst_bit_writer_reset (&bw);
+
+  if (!ret)
+    GST_ERROR_OBJECT (self, "Failed to create the packed VPS and SPS");
+
+  return ret;
+}
+
+static gboolean
+_add_picture_header (GstVaH265Enc * self, GstVaH265EncFrame * frame,
+    VAEncPictureParameterBufferHEVC * pic_param)
+{
+  GstVaBaseEnc *base = GST_VA_BASE_ENC (self);
+  GstBitWriter bw;
+  gboolean ret;
+
+  if (!gst_va_encoder_add_param (base->encoder, frame->base.picture,
+          VAEncPictureParameterBufferType, pic_param, sizeof (*pic_param))) {
+    GST_ERROR_OBJECT (self, "Failed to create the picture parameter");
+    return FALSE;
+  }
+
+  /* the PPS only changes along with the SPS */
+  if (!frame->is_idr || !self->packed_headers)
+    return TRUE;
+
+  gst_bit_writer_init (&bw);
+  ret = _write_pps (self, &bw, pic_param)
+      && gst_va_encoder_add_packed_header (base->encoder, frame->base.picture,
+      VAEncPackedHeaderPicture, gst_bit_writer_get_data (&bw),
+      gst_bit_writer_get_size (&bw), FALSE);
+  gst_bit_writer_reset (&bw);
+
+  if (!ret)
+    GST_ERROR_OBJECT (self, "Failed to create the packed PPS");
+
+  return ret;
+}
+
+static gboolean
+_add_slice (GstVaH265Enc * self, GstVaH265EncFrame * frame,
+    GstVaH265EncFrame * ref, VAEncPictureParameterBufferHEVC * pic_param,
+    VAEncSliceParameterBufferHEVC * slice)
+{
+  GstVaBaseEnc *base = GST_VA_BASE_ENC (self);
+  GstBitWriter bw;
+  gboolean ret;
+
+  if (!gst_va_encoder_add_param (base->encoder, frame->base.picture,
+          VAEncSliceParameterBufferType, slice, sizeof (*slice))) {
+    GST_ERROR_OBJECT (self, "Failed to create the slice parameter");
+    return FALSE;
+  }
+
+  if (!self->packed_headers)
+    return TRUE;
+
+  gst_bit_writer_init (&bw);
+  ret = _write_slice_header (self, &bw, frame, ref, pic_param, slice)
+      && gst_va_encoder_add_packed_header (base->encoder, frame->base.picture,
+      VAEncPackedHeaderSlice, gst_bit_writer_get_data (&bw),
+      gst_bit_writer_get_size (&bw), FALSE);
+  gst_bit_writer_reset (&bw);
+
+  if (!ret)
+    GST_ERROR_OBJECT (self, "Failed to create the packed slice header");
+
+  return ret;
+}
+
+static void
+_fill_va_picture (VAPictureHEVC * va_pic, GstVaH265EncFrame * frame)
+{
+  /* *INDENT-OFF* */
+  *va_pic = (VAPictureHEVC) {
+    .picture_id =
+        gst_va_encode_picture_get_reconstruct_surface (frame->base.picture),
+    .pic_order_cnt = frame->poc,
+    .flags = 0,
+  };
+  /* *INDENT-ON* */
+}
+
+static void
+_invalidate_va_pictures (VAPictureHEVC * va_pics, guint num)
+{
+  guint i;
+
+  for (i = 0; i < num; i++) {
+    va_pics[i].picture_id = VA_INVALID_SURFACE;
+    va_pics[i].flags = VA_PICTURE_HEVC_INVALID;
+  }
+}
+
+static gboolean
+gst_va_h265_enc_reconfig (GstVaBaseEnc * base)
+{
+  GstVaH265Enc *self = GST_VA_H265_ENC (base);
+  GstVideoInfo *info = &base->input_state->info;
+  GstVideoFormat format = GST_VIDEO_INFO_FORMAT (info);
+  GstVideoCodecState *output_state;
+  GstCaps *out_caps;
+  guint rt_format, max_surfaces, packed_headers;
+  gint fps_n, fps_d;
+
+  rt_format = gst_va_chroma_from_video_format (format);
+  if (rt_format != VA_RT_FORMAT_YUV420
+      && rt_format != VA_RT_FORMAT_YUV420_10) {
+    GST_ERROR_OBJECT (self, "Unsupported format %s",
+        gst_video_format_to_string (format));
+    return FALSE;
+  }
+
+  if (!_decide_profile (self, GST_VIDEO_INFO_COMP_DEPTH (info, 0)))
+    return FALSE;
+
+  GST_OBJECT_LOCK (self);
+  self->key_int_max = self->prop.key_int_max;
+  self->rc_ctrl = self->prop.rc_ctrl;
+  self->bitrate = self->prop.bitrate;
+  self->qp_i = self->prop.qp_i;
+  self->qp_p = self->prop.qp_p;
+  GST_OBJECT_UNLOCK (self);
+
+  self->low_delay_b = gst_va_encoder_is_low_power (base->encoder);
+  self->ctb_size = gst_va_encoder_is_low_power (base->encoder) ? 64 : 32;
+
+  self->width = GST_ROUND_UP_16 (GST_VIDEO_INFO_WIDTH (info));
+  self->height = GST_ROUND_UP_16 (GST_VIDEO_INFO_HEIGHT (info));
+  self->conf_win_right = self->width - GST_VIDEO_INFO_WIDTH (info);
+  self->conf_win_bottom = self->height - GST_VIDEO_INFO_HEIGHT (info);
+
+  self->rc_ctrl = gst_va_base_enc_get_rate_control (base, self->profile,
+      self->rc_ctrl);
+  if (self->rc_ctrl == VA_RC_CQP || self->rc_ctrl == 0) {
+    self->bitrate = 0;
+  } else if (self->bitrate == 0) {
+    /* about 0.066 bits per pixel */
+    _get_framerate (base, &fps_n, &fps_d);
+    self->bitrate = MAX (1, gst_util_uint64_scale (GST_VIDEO_INFO_WIDTH (info)
+            * GST_VIDEO_INFO_HEIGHT (info), fps_n, fps_d * 15000));
+  }
+
+  /* the bitrate control works at the coding unit level */
+  self->cu_qp_delta = (self->rc_ctrl != VA_RC_CQP && self->rc_ctrl != 0)
+      || gst_va_encoder_is_low_power (base->encoder);
+
+  /* The slice headers depend on SPS and PPS syntax elements the VA
+   * parameters don't carry, so either all the headers are packed or
+   * the driver writes them all. */
+  packed_headers =
+      gst_va_encoder_get_packed_headers (base->encoder, self->profile);
+  if ((packed_headers & PACKED_HEADERS) == PACKED_HEADERS) {
+    self->packed_headers = PACKED_HEADERS;
+  } else {
+    self->packed_headers = 0;
+    if (self->conf_win_right > 0 || self->conf_win_bottom > 0) {
+      GST_WARNING_OBJECT (self, "The driver doesn't support packed headers, "
+          "the stream will be coded as %ux%u", self->width, self->height);
+    }
+  }
+
+  self->log2_max_poc_lsb = CLAMP (g_bit_storage (self->key_int_max), 4, 16);
+
+  _decide_level (self);
+  _fill_sequence_param (self);
+
+  GST_INFO_OBJECT (self, "rate control %#x, bitrate %u kbps, key-int-max %u, "
+      "packed headers %#x", self->rc_ctrl, self->bitrate, self->key_int_max,
+      self->packed_headers);
+
+  /* the reference, the frames in flight and the one being encoded */
+  max_surfaces = base->preferred_output_delay + 3;
+
+  if (!gst_va_encoder_open (base->encoder, self->profile, rt_format,
+          self->bit_depth == 10 ? GST_VIDEO_FORMAT_P010_10LE :
+          GST_VIDEO_FORMAT_NV12, self->width, self->height, self->rc_ctrl,
+          self->packed_headers, max_surfaces)) {
+    GST_ERROR_OBJECT (self, "Failed to open the VA encoder");
+    return FALSE;
+  }
+
+  out_caps = gst_caps_new_simple ("video/x-h265",
+      "stream-format", G_TYPE_STRING, "byte-stream",
+      "alignment", G_TYPE_STRING, "au",
+      "profile", G_TYPE_STRING, self->profile_name,
+      "tier", G_TYPE_STRING, "main",
+      "level", G_TYPE_STRING, self->level_name, NULL);
+
+  output_state = gst_video_encoder_set_output_state (GST_VIDEO_ENCODER (self),
+      out_caps, base->input_state);
+  gst_video_codec_state_unref (output_state);
+
+  return TRUE;
+}
+
+static void
+gst_va_h265_enc_reset_state (GstVaBaseEnc * base)
+{
+  GstVaH265Enc *self = GST_VA_H265_ENC (base);
+
+  self->gop_frame_count = 0;
+  g_clear_pointer (&self->last_ref, gst_video_codec_frame_unref);
+}
+
+static gboolean
+gst_va_h265_enc_new_frame (GstVaBaseEnc * base, GstVideoCodecFrame * frame)
+{
+  GstVaH265EncFrame *frame_in;
+
+  frame_in = g_new0 (GstVaH265EncFrame, 1);
+  gst_video_codec_frame_set_user_data (frame, frame_in, gst_va_enc_frame_free);
+
+  return TRUE;
+}
+
+static gboolean
+gst_va_h265_enc_encode_frame (GstVaBaseEnc * base,
+    GstVideoCodecFrame * gst_frame)
+{
+  GstVaH265Enc *self = GST_VA_H265_ENC (base);
+  GstVaH265EncFrame *frame, *ref = NULL;
+  GstVaEncodePicture *picture;
+  VAEncPictureParameterBufferHEVC pic_param;
+  VAEncSliceParameterBufferHEVC slice;
+  guint coding_type, slice_type, nal_unit_type, ctbs;
+
+  frame = (GstVaH265EncFrame *) gst_va_base_enc_get_frame (gst_frame);
+  picture = frame->base.picture;
+
+  if (!self->last_ref || self->gop_frame_count >= self->key_int_max
+      || GST_VIDEO_CODEC_FRAME_IS_FORCE_KEYFRAME (gst_frame)) {
+    frame->is_idr = TRUE;
+    self->gop_frame_count = 0;
+  } else {
+    ref = (GstVaH265EncFrame *) gst_va_base_enc_get_frame (self->last_ref);
+  }
+
+  frame->poc = self->gop_frame_count;
+
+  if (!ref) {
+    coding_type = CODING_TYPE_I;
+    slice_type = GST_H265_I_SLICE;
+    nal_unit_type = GST_H265_NAL_SLICE_IDR_W_RADL;
+  } else if (self->low_delay_b) {
+    coding_type = CODING_TYPE_B;
+    slice_type = GST_H265_B_SLICE;
+    nal_unit_type = GST_H265_NAL_SLICE_TRAIL_R;
+  } else {
+    coding_type = CODING_TYPE_P;
+    slice_type = GST_H265_P_SLICE;
+    nal_unit_type = GST_H265_NAL_SLICE_TRAIL_R;
+  }
+
+  GST_LOG_OBJECT (self, "Encoding frame %d as %s, poc %d",
+      gst_frame->system_frame_number, ref ? (self->low_delay_b ? "B" : "P") :
+      "IDR", frame->poc);
+
+  if (frame->is_idr && !_add_sequence_header (self, frame))
+    return FALSE;
+
+  if (!gst_va_base_enc_add_rate_control_parameter (base, picture,
+          self->rc_ctrl, self->bitrate, 100, self->qp_i, 0))
+    return FALSE;
+
+  if (!gst_va_base_enc_add_hrd_parameter (base, picture, self->rc_ctrl,
+          self->bitrate))
+    return FALSE;
+
+  if (!gst_va_base_enc_add_frame_rate_parameter (base, picture))
+    return FALSE;
+
+  /* *INDENT-OFF* */
+  pic_param = (VAEncPictureParameterBufferHEVC) {
+    .coded_buf = picture->coded_buffer,
+    .collocated_ref_pic_index = ref ? 0 : 0xff,
+    .pic_init_qp = self->qp_i,
+    .diff_cu_qp_delta_depth = 0,
+    .num_ref_idx_l0_default_active_minus1 = 0,
+    .num_ref_idx_l1_default_active_minus1 = 0,
+    .slice_pic_parameter_set_id = 0,
+    .nal_unit_type = nal_unit_type,
+    .pic_fields.bits = {
+      .idr_pic_flag = frame->is_idr,
+      .coding_type = coding_type,
+      .reference_pic_flag = 1,
+      .cu_qp_delta_enabled_flag = self->cu_qp_delta,
+    },
+  };
+  /* *INDENT-ON* */
+
+  _fill_va_picture (&pic_param.decoded_curr_pic, frame);
+  _invalidate_va_pictures (pic_param.reference_frames,
+      G_N_ELEMENTS (pic_param.reference_frames));
+  if (ref)
+    _fill_va_picture (&pic_param.reference_frames[0], ref);
+
+  if (!_add_picture_header (self, frame, &pic_param))
+    return FALSE;
+
+  ctbs = ((self->width + self->ctb_size - 1) / self->ctb_size)
+      * ((self->height + self->ctb_size - 1) / self->ctb_size);
+
+  /* *INDENT-OFF* */
+  slice = (VAEncSliceParameterBufferHEVC) {
+    .slice_segment_address = 0,
+    .num_ctu_in_slice = ctbs,
+    .slice_type = slice_type,
+    .slice_pic_parameter_set_id = 0,
+    .num_ref_idx_l0_active_minus1 = 0,
+    .num_ref_idx_l1_active_minus1 = 0,
+    .max_num_merge_cand = 5,
+    .slice_qp_delta = (self->rc_ctrl == VA_RC_CQP && ref) ?
+        (gint) self->qp_p - (gint) self->qp_i : 0,
+    .slice_fields.bits = {
+      .last_slice_of_pic_flag = 1,
+      .slice_temporal_mvp_enabled_flag = ref != NULL &&
+          self->sequence.seq_fields.bits.sps_temporal_mvp_enabled_flag,
+      .collocated_from_l0_flag = 1,
+    },
+  };
+  /* *INDENT-ON* */
+
+  _invalidate_va_pictures (slice.ref_pic_list0,
+      G_N_ELEMENTS (slice.ref_pic_list0));
+  _invalidate_va_pictures (slice.ref_pic_list1,
+      G_N_ELEMENTS (slice.ref_pic_list1));
+  if (ref) {
+    _fill_va_picture (&slice.ref_pic_list0[0], ref);
+    /* low delay B frames predict from the past in both lists */
+    if (slice_type == GST_H265_B_SLICE)
+      _fill_va_picture (&slice.ref_pic_list1[0], ref);
+  }
+
+  if (!_add_slice (self, frame, ref, &pic_param, &slice))
+    return FALSE;
+
+  if (!gst_va_encoder_encode (base->encoder, picture)) {
+    GST_ERROR_OBJECT (self, "Failed to encode frame %d",
+        gst_frame->system_frame_number);
+    return FALSE;
+  }
+
+  self->gop_frame_count++;
+
+  if (self->last_ref)
+    gst_video_codec_frame_unref (self->last_ref);
+  self->last_ref = gst_video_codec_frame_ref (gst_frame);
+
+  return TRUE;
+}
+
+static void
+gst_va_h265_enc_prepare_output (GstVaBaseEnc * base,
+    GstVideoCodecFrame * gst_frame)
+{
+  GstVaH265EncFrame *frame;
+
+  frame = (GstVaH265EncFrame *) gst_va_base_enc_get_frame (gst_frame);
+
+  if (frame->is_idr)
+    GST_VIDEO_CODEC_FRAME_SET_SYNC_POINT (gst_frame);
+  else
+    GST_VIDEO_CODEC_FRAME_UNSET_SYNC_POINT (gst_frame);
+}
+
+static void
+gst_va_h265_enc_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstVaH265Enc *self = GST_VA_H265_ENC (object);
+
+  GST_OBJECT_LOCK (object);
+  switch (prop_id) {
+    case PROP_KEY_INT_MAX:
+      self->prop.key_int_max = g_value_get_uint (value);
+      break;
+    case PROP_RATE_CONTROL:
+      self->prop.rc_ctrl = g_value_get_enum (value);
+      break;
+    case PROP_BITRATE:
+      self->prop.bitrate = g_value_get_uint (value);
+      break;
+    case PROP_QP_I:
+      self->prop.qp_i = g_value_get_uint (value);
+      break;
+    case PROP_QP_P:
+      self->prop.qp_p = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (object);
+}
+
+static void
+gst_va_h265_enc_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstVaH265Enc *self = GST_VA_H265_ENC (object);
+
+  GST_OBJECT_LOCK (object);
+  switch (prop_id) {
+    case PROP_KEY_INT_MAX:
+      g_value_set_uint (value, self->prop.key_int_max);
+      break;
+    case PROP_RATE_CONTROL:
+      g_value_set_enum (value, self->prop.rc_ctrl);
+      break;
+    case PROP_BITRATE:
+      g_value_set_uint (value, self->prop.bitrate);
+      break;
+    case PROP_QP_I:
+      g_value_set_uint (value, self->prop.qp_i);
+      break;
+    case PROP_QP_P:
+      g_value_set_uint (value, self->prop.qp_p);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (object);
+}
+
+static void
+gst_va_h265_enc_dispose (GObject * object)
+{
+  GstVaH265Enc *self = GST_VA_H265_ENC (object);
+
+  g_clear_pointer (&self->last_ref, gst_video_codec_frame_unref);
+  gst_va_base_enc_close (GST_VIDEO_ENCODER (object));
+
+  G_OBJECT_CLASS (parent_class)->dispose (object);
+}
+
+static void
+gst_va_h265_enc_class_init (gpointer g_class, gpointer class_data)
+{
+  GstCaps *src_doc_caps, *sink_doc_caps;
+  GObjectClass *gobject_class = G_OBJECT_CLASS (g_class);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (g_class);
+  GstVaBaseEncClass *va_enc_class = GST_VA_BASE_ENC_CLASS (g_class);
+  struct CData *cdata = class_data;
+  gboolean low_power = cdata->entrypoint == VAEntrypointEncSliceLP;
+  gchar *long_name;
+
+  if (cdata->description) {
+    long_name = g_strdup_printf ("VA-API H.265 %sEncoder in %s",
+        low_power ? "Low Power " : "", cdata->description);
+  } else {
+    long_name = g_strdup_printf ("VA-API H.265 %sEncoder",
+        low_power ? "Low Power " : "");
+  }
+
+  gst_element_class_set_metadata (element_class, long_name,
+      "Codec/Encoder/Video/Hardware",
+      "VA-API based H.265 video encoder", "GStreamer developers");
+
+  sink_doc_caps = gst_caps_from_string (sink_caps_str);
+  src_doc_caps = gst_caps_from_string (src_caps_str);
+
+  gst_va_base_enc_class_init (va_enc_class, HEVC, cdata->entrypoint,
+      cdata->render_device_path, cdata->sink_caps, cdata->src_caps,
+      src_doc_caps, sink_doc_caps);
+
+  gobject_class->set_property = gst_va_h265_enc_set_property;
+  gobject_class->get_property = gst_va_h265_enc_get_property;
+  gobject_class->dispose = gst_va_h265_enc_dispose;
+
+  va_enc_class->reconfig = GST_DEBUG_FUNCPTR (gst_va_h265_enc_reconfig);
+  va_enc_class->reset_state = GST_DEBUG_FUNCPTR (gst_va_h265_enc_reset_state);
+  va_enc_class->new_frame = GST_DEBUG_FUNCPTR (gst_va_h265_enc_new_frame);
+  va_enc_class->encode_frame =
+      GST_DEBUG_FUNCPTR (gst_va_h265_enc_encode_frame);
+  va_enc_class->prepare_output =
+      GST_DEBUG_FUNCPTR (gst_va_h265_enc_prepare_output);
+
+  /**
+   * GstVaH265Enc:key-int-max:
+   *
+   * Maximal distance between two IDR frames.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_KEY_INT_MAX,
+      g_param_spec_uint ("key-int-max", "Key frame maximal interval",
+          "Maximal distance between two IDR frames", 1, 1024,
+          DEFAULT_KEY_INT_MAX, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstVaH265Enc:rate-control:
+   *
+   * The rate control mode. If the driver doesn't support it,
+   * another supported mode is used.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_RATE_CONTROL,
+      g_param_spec_enum ("rate-control", "Rate control",
+          "The rate control mode", GST_TYPE_VA_ENCODER_RATE_CONTROL,
+          DEFAULT_RATE_CONTROL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstVaH265Enc:bitrate:
+   *
+   * The target bitrate in kbit/s for the cbr and vbr rate control
+   * modes. 0 picks one from the resolution and the framerate.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_BITRATE,
+      g_param_spec_uint ("bitrate", "Bitrate (kbps)",
+          "The target bitrate in kbit/s (0: auto)", 0, 2000 * 1024,
+          DEFAULT_BITRATE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstVaH265Enc:qpi:
+   *
+   * The quantizer of I frames in cqp mode, and the initial one in
+   * the other modes.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_QP_I,
+      g_param_spec_uint ("qpi", "I frame QP",
+          "The quantizer value for I frames", 0, 51, DEFAULT_QP,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstVaH265Enc:qpp:
+   *
+   * The quantizer of inter frames in cqp mode.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_QP_P,
+      g_param_spec_uint ("qpp", "Inter frame QP",
+          "The quantizer value for inter frames", 0, 51, DEFAULT_QP,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_free (long_name);
+  g_free (cdata->description);
+  g_free (cdata->render_device_path);
+  gst_caps_unref (cdata->src_caps);
+  gst_caps_unref (cdata->sink_caps);
+  g_free (cdata);
+}
+
+static void
+gst_va_h265_enc_init (GTypeInstance * instance, gpointer g_class)
+{
+  GstVaH265Enc *self = GST_VA_H265_ENC (instance);
+
+  gst_va_base_enc_init (GST_VA_BASE_ENC (instance), GST_CAT_DEFAULT);
+
+  self->prop.key_int_max = DEFAULT_KEY_INT_MAX;
+  self->prop.rc_ctrl = DEFAULT_RATE_CONTROL;
+  self->prop.bitrate = DEFAULT_BITRATE;
+  self->prop.qp_i = DEFAULT_QP;
+  self->prop.qp_p = DEFAULT_QP;
+}
+
+static gpointer
+_register_debug_category (gpointer data)
+{
+  GST_DEBUG_CATEGORY_INIT (gst_va_h265enc_debug, "vah265enc", 0,
+      "VA h265 encoder");
+
+  return NULL;
+}
+
+static GstCaps *
+_complete_src_caps (GstCaps * srccaps)
+{
+  GstCaps *caps = gst_caps_copy (srccaps);
+
+  gst_caps_set_simple (caps, "stream-format", G_TYPE_STRING, "byte-stream",
+      "alignment", G_TYPE_STRING, "au", NULL);
+
+  return caps;
+}
+
+gboolean
+gst_va_h265_enc_register (GstPlugin * plugin, GstVaDevice * device,
+    GstCaps * sink_caps, GstCaps * src_caps, guint rank,
+    VAEntrypoint entrypoint)
+{
+  static GOnce debug_once = G_ONCE_INIT;
+  GType type;
+  GTypeInfo type_info = {
+    .class_size = sizeof (GstVaH265EncClass),
+    .class_init = gst_va_h265_enc_class_init,
+    .instance_size = sizeof (GstVaH265Enc),
+    .instance_init = gst_va_h265_enc_init,
+  };
+  struct CData *cdata;
+  gboolean ret;
+  gchar *type_name, *feature_name;
+
+  g_return_val_if_fail (GST_IS_PLUGIN (plugin), FALSE);
+  g_return_val_if_fail (GST_IS_VA_DEVICE (device), FALSE);
+  g_return_val_if_fail (GST_IS_CAPS (sink_caps), FALSE);
+  g_return_val_if_fail (GST_IS_CAPS (src_caps), FALSE);
+  g_return_val_if_fail (entrypoint == VAEntrypointEncSlice
+      || entrypoint == VAEntrypointEncSliceLP, FALSE);
+
+  cdata = g_new (struct CData, 1);
+  cdata->entrypoint = entrypoint;
+  cdata->description = NULL;
+  cdata->render_device_path = g_strdup (device->render_device_path);
+  cdata->sink_caps = gst_caps_ref (sink_caps);
+  cdata->src_caps = _complete_src_caps (src_caps);
+
+  /* class data will be leaked if the element never gets instantiated */
+  GST_MINI_OBJECT_FLAG_SET (sink_caps, GST_MINI_OBJECT_FLAG_MAY_BE_LEAKED);
+  GST_MINI_OBJECT_FLAG_SET (cdata->src_caps,
+      GST_MINI_OBJECT_FLAG_MAY_BE_LEAKED);
+
+  type_info.class_data = cdata;
+
+  if (entrypoint == VAEntrypointEncSlice) {
+    type_name = g_strdup ("GstVaH265Enc");
+    feature_name = g_strdup ("vah265enc");
+  } else {
+    type_name = g_strdup ("GstVaH265LPEnc");
+    feature_name = g_strdup ("vah265lpenc");
+  }
+
+  /* The first encoder to be registered should use a constant name,
+   * like vah265enc, for any additional encoders, we create unique
+   * names, using inserting the render device name. */
+  if (g_type_from_name (type_name)) {
+    gchar *basename = g_path_get_basename (device->render_device_path);
+    g_free (type_name);
+    g_free (feature_name);
+    if (entrypoint == VAEntrypointEncSlice) {
+      type_name = g_strdup_printf ("GstVa%sH265Enc", basename);
+      feature_name = g_strdup_printf ("va%sh265enc", basename);
+    } else {
+      type_name = g_strdup_printf ("GstVa%sH265LPEnc", basename);
+      feature_name = g_strdup_printf ("va%sh265lpenc", basename);
+    }
+    cdata->description = basename;
+
+    /* lower rank for non-first device */
+    if (rank > 0)
+      rank--;
+  }
+
+  g_once (&debug_once, _register_debug_category, NULL);
+
+  type = g_type_register_static (GST_TYPE_VIDEO_ENCODER,
+      type_name, &type_info, 0);
+
+  ret = gst_element_register (plugin, feature_name, rank, type);
+
+  g_free (type_name);
+  g_free (feature_name);
+
+  return ret;
+}
@@ -74,6 +74,9 @@ struct _GstVaMpeg2Dec
   gboolean need_negotiation;
 
   GstMpegVideoSequenceHdr seq;
+
+  /* VASliceParameterBufferMPEG2 of the current field, reused */
+  GArray *slice_params;
 };
 
 #define parent_class gst_va_base_dec_parent_class
@@ -512,42 +515,60 @@ gst_va_mpeg2_dec_start_picture (GstMpeg2Decoder * decoder,
 }
 
 static gboolean
-gst_va_mpeg2_dec_decode_slice (GstMpeg2Decoder * decoder,
-    GstMpeg2Picture * picture, GstMpeg2Slice * slice)
+gst_va_mpeg2_dec_decode_slices (GstMpeg2Decoder * decoder,
+    GstMpeg2Picture * picture, GstMpeg2Slice * slices, guint num_slices)
 {
+  GstVaMpeg2Dec *self = GST_VA_MPEG2_DEC (decoder);
   GstVaBaseDec *base = GST_VA_BASE_DEC (decoder);
-  GstMpegVideoSliceHdr *header = &slice->header;
-  GstMpegVideoPacket *packet = &slice->packet;
   GstVaDecodePicture *va_pic;
-  VASliceParameterBufferMPEG2 slice_param;
+  const guint8 *data;
+  gsize size;
+  guint i;
 
   /* The slice data pass to driver should be a full packet
      include the start code. The packet->offset return by
      gst_mpeg_video_parse does not include the start code
      and so we need to wrap back 4 bytes. */
-  g_assert (packet->offset >= 4);
+  g_assert (slices[0].packet.offset >= 4);
+  data = slices[0].packet.data + slices[0].packet.offset - 4;
+
+  /* All slices of the picture come from the same input buffer, so a single
+   * slice data buffer spanning all of them is submitted, and the slice
+   * offsets are made relative to the first slice */
+  g_array_set_size (self->slice_params, num_slices);
+  for (i = 0; i < num_slices; i++) {
+    GstMpegVideoSliceHdr *header = &slices[i].header;
+    GstMpegVideoPacket *packet = &slices[i].packet;
+    const guint8 *slice_data = packet->data + packet->offset - 4;
+
+    if (packet->data != slices[0].packet.data || slice_data < data) {
+      GST_ERROR_OBJECT (self, "Slices are not in bitstream order");
+      return FALSE;
+    }
 
-  /* *INDENT-OFF* */
-  slice_param = (VASliceParameterBufferMPEG2) {
-    .slice_data_size = packet->size + 4 /* start code */,
-    .slice_data_offset = 0,
-    .slice_data_flag = VA_SLICE_DATA_FLAG_ALL,
-    .macroblock_offset = header->header_size + 32,
-    .slice_horizontal_position = header->mb_column,
-    .slice_vertical_position = header->mb_row,
-    .quantiser_scale_code = header->quantiser_scale_code,
-    .intra_slice_flag = header->intra_slice,
-  };
-  /* *INDENT-ON* */
+    /* *INDENT-OFF* */
+    g_array_index (self->slice_params, VASliceParameterBufferMPEG2, i) =
+        (VASliceParameterBufferMPEG2) {
+      .slice_data_size = packet->size + 4 /* start code */,
+      .slice_data_offset = slice_data - data,
+      .slice_data_flag = VA_SLICE_DATA_FLAG_ALL,
+      .macroblock_offset = header->header_size + 32,
+      .slice_horizontal_position = header->mb_column,
+      .slice_vertical_position = header->mb_row,
+      .quantiser_scale_code = header->quantiser_scale_code,
+      .intra_slice_flag = header->intra_slice,
+    };
+    /* *INDENT-ON* */
+  }
 
-  va_pic = gst_mpeg2_picture_get_user_data (picture);
-  if (!gst_va_decoder_add_slice_buffer (base->decoder, va_pic,
-          &slice_param, sizeof (slice_param),
-          (guint8 *) (packet->data + packet->offset - 4 /* start code */ ),
-          packet->size + 4 /* start code */ ))
-    return FALSE;
+  size = slices[num_slices - 1].packet.data +
+      slices[num_slices - 1].packet.offset +
+      slices[num_slices - 1].packet.size - data;
 
-  return TRUE;
+  va_pic = gst_mpeg2_picture_get_user_data (picture);
+  return gst_va_decoder_add_slice_buffer_with_n_params (base->decoder, va_pic,
+      self->slice_params->data, sizeof (VASliceParameterBufferMPEG2),
+      num_slices, (gpointer) data, size);
 }
 
 static gboolean
@@ -597,12 +618,20 @@ gst_va_mpeg2_dec_output_picture (GstMpeg2Decoder * decoder,
 static void
 gst_va_mpeg2_dec_init (GTypeInstance * instance, gpointer g_class)
 {
+  GstVaMpeg2Dec *self = GST_VA_MPEG2_DEC (instance);
+
   gst_va_base_dec_init (GST_VA_BASE_DEC (instance), GST_CAT_DEFAULT);
+
+  self->slice_params =
+      g_array_new (FALSE, FALSE, sizeof (VASliceParameterBufferMPEG2));
 }
 
 static void
 gst_va_mpeg2_dec_dispose (GObject * object)
 {
+  GstVaMpeg2Dec *self = GST_VA_MPEG2_DEC (object);
+
+  g_clear_pointer (&self->slice_params, g_array_unref);
   gst_va_base_dec_close (GST_VIDEO_DECODER (object));
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
@@ -648,8 +677,8 @@ gst_va_mpeg2_dec_class_init (gpointer g_class, gpointer class_data)
       GST_DEBUG_FUNCPTR (gst_va_mpeg2_dec_new_field_picture);
   mpeg2decoder_class->start_picture =
       GST_DEBUG_FUNCPTR (gst_va_mpeg2_dec_start_picture);
-  mpeg2decoder_class->decode_slice =
-      GST_DEBUG_FUNCPTR (gst_va_mpeg2_dec_decode_slice);
+  mpeg2decoder_class->decode_slices =
+      GST_DEBUG_FUNCPTR (gst_va_mpeg2_dec_decode_slices);
   mpeg2decoder_class->end_picture =
       GST_DEBUG_FUNCPTR (gst_va_mpeg2_dec_end_picture);
   mpeg2decoder_class->output_picture =
@@ -0,0 +1,918 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:element-vamultipostproc
+ * @title: vamultipostproc
+ * @short_description: A VA-API video postprocessor with several outputs
+ *
+ * vamultipostproc scales and converts each VA surface into every one
+ * of its request source pads, for example to feed the renditions of
+ * an adaptive bitrate ladder. The size and format of each output is
+ * negotiated with its downstream peer, and all the outputs of an
+ * input frame are processed in one batch by the
+ * [VA-API](https://01.org/linuxmedia/vaapi) driver's post-processor.
+ *
+ * Unlike vapostproc, only VA memory is handled and no additional
+ * video filters are exposed.
+ *
+ * ## Example launch line
+ * ```
+ * gst-launch-1.0 videotestsrc ! video/x-raw,format=NV12,width=1920,height=1080 ! vapostproc ! vamultipostproc name=p \
+ *     p.src_0 ! video/x-raw(memory:VAMemory),width=1280,height=720 ! vah264enc ! fakesink \
+ *     p.src_1 ! video/x-raw(memory:VAMemory),width=640,height=360 ! vah264enc ! fakesink
+ * ```
+ *
+ * Since: 1.20
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstvamultipostproc.h"
+
+#include <gst/base/gstflowcombiner.h>
+#include <gst/video/video.h>
+
+#include "gstvaallocator.h"
+#include "gstvacaps.h"
+#include "gstvadisplay_drm.h"
+#include "gstvafilter.h"
+#include "gstvapool.h"
+#include "gstvautils.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_va_multi_post_proc_debug);
+#define GST_CAT_DEFAULT gst_va_multi_post_proc_debug
+
+#define GST_VA_MULTI_POST_PROC(obj)           ((GstVaMultiPostProc *) obj)
+#define GST_VA_MULTI_POST_PROC_GET_CLASS(obj) (G_TYPE_INSTANCE_GET_CLASS ((obj), G_TYPE_FROM_INSTANCE (obj), GstVaMultiPostProcClass))
+#define GST_VA_MULTI_POST_PROC_CLASS(klass)    ((GstVaMultiPostProcClass *) klass)
+
+typedef struct _GstVaMultiPostProc GstVaMultiPostProc;
+typedef struct _GstVaMultiPostProcClass GstVaMultiPostProcClass;
+
+struct _GstVaMultiPostProcClass
+{
+  GstElementClass parent_class;
+
+  gchar *render_device_path;
+};
+
+struct _GstVaMultiPostProc
+{
+  GstElement parent;
+
+  GstPad *sinkpad;
+
+  GstVaDisplay *display;
+  GstVaFilter *filter;
+
+  GstCaps *incaps;
+  GstVideoInfo in_info;
+
+  /* protected by the object lock */
+  GstFlowCombiner *flow_combiner;
+};
+
+static GstElementClass *parent_class = NULL;
+
+static gboolean gst_va_multi_post_proc_src_query (GstPad * pad,
+    GstObject * parent, GstQuery * query);
+
+struct CData
+{
+  gchar *render_device_path;
+  gchar *description;
+};
+
+/* *INDENT-OFF* */
+static const gchar *caps_str = GST_VIDEO_CAPS_MAKE_WITH_FEATURES ("memory:VAMemory",
+            "{ NV12, I420, YV12, YUY2, RGBA, BGRA, P010_10LE, ARGB, ABGR }");
+/* *INDENT-ON* */
+
+/* source pads */
+
+#define GST_TYPE_VA_MULTI_POST_PROC_PAD (gst_va_multi_post_proc_pad_get_type ())
+#define GST_VA_MULTI_POST_PROC_PAD(obj) ((GstVaMultiPostProcPad *) obj)
+
+typedef struct _GstVaMultiPostProcPad GstVaMultiPostProcPad;
+typedef struct _GstVaMultiPostProcPadClass GstVaMultiPostProcPadClass;
+
+struct _GstVaMultiPostProcPad
+{
+  GstPad parent;
+
+  /* only used by the streaming thread */
+  GstCaps *caps;
+  GstVideoInfo info;
+  GstBufferPool *pool;
+  GstVaFilterOutput output;
+  gboolean negotiated;
+};
+
+struct _GstVaMultiPostProcPadClass
+{
+  GstPadClass parent_class;
+};
+
+static GType gst_va_multi_post_proc_pad_get_type (void);
+G_DEFINE_TYPE (GstVaMultiPostProcPad, gst_va_multi_post_proc_pad, GST_TYPE_PAD);
+
+static void
+gst_va_multi_post_proc_pad_reset (GstVaMultiPostProcPad * pad)
+{
+  if (pad->pool) {
+    gst_buffer_pool_set_active (pad->pool, FALSE);
+    gst_clear_object (&pad->pool);
+  }
+  gst_clear_caps (&pad->caps);
+  pad->negotiated = FALSE;
+}
+
+static void
+gst_va_multi_post_proc_pad_dispose (GObject * object)
+{
+  gst_va_multi_post_proc_pad_reset (GST_VA_MULTI_POST_PROC_PAD (object));
+
+  G_OBJECT_CLASS (gst_va_multi_post_proc_pad_parent_class)->dispose (object);
+}
+
+static void
+gst_va_multi_post_proc_pad_class_init (GstVaMultiPostProcPadClass * klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = gst_va_multi_post_proc_pad_dispose;
+}
+
+static void
+gst_va_multi_post_proc_pad_init (GstVaMultiPostProcPad * pad)
+{
+  pad->output.surface = VA_INVALID_ID;
+}
+
+/* element */
+
+static void
+gst_va_multi_post_proc_dispose (GObject * object)
+{
+  GstVaMultiPostProc *self = GST_VA_MULTI_POST_PROC (object);
+
+  gst_clear_caps (&self->incaps);
+  gst_clear_object (&self->filter);
+  gst_clear_object (&self->display);
+
+  if (self->flow_combiner) {
+    gst_flow_combiner_free (self->flow_combiner);
+    self->flow_combiner = NULL;
+  }
+
+  G_OBJECT_CLASS (parent_class)->dispose (object);
+}
+
+static GstStateChangeReturn
+gst_va_multi_post_proc_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstVaMultiPostProc *self = GST_VA_MULTI_POST_PROC (element);
+  GstVaMultiPostProcClass *klass = GST_VA_MULTI_POST_PROC_GET_CLASS (element);
+  GstStateChangeReturn ret;
+  GList *l;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_NULL_TO_READY:
+      if (!gst_va_ensure_element_data (element, klass->render_device_path,
+              &self->display))
+        goto open_failed;
+      if (!self->filter)
+        self->filter = gst_va_filter_new (self->display);
+      if (!gst_va_filter_open (self->filter))
+        goto open_failed;
+      break;
+    default:
+      break;
+  }
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+  switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      GST_OBJECT_LOCK (self);
+      for (l = element->srcpads; l; l = l->next)
+        gst_va_multi_post_proc_pad_reset (l->data);
+      gst_flow_combiner_reset (self->flow_combiner);
+      GST_OBJECT_UNLOCK (self);
+      gst_clear_caps (&self->incaps);
+      break;
+    case GST_STATE_CHANGE_READY_TO_NULL:
+      if (self->filter)
+        gst_va_filter_close (self->filter);
+      gst_clear_object (&self->filter);
+      gst_clear_object (&self->display);
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+
+  /* Errors */
+open_failed:
+  {
+    GST_ELEMENT_ERROR (self, LIBRARY, INIT, (NULL), ("Failed to open VPP"));
+    return GST_STATE_CHANGE_FAILURE;
+  }
+}
+
+static void
+gst_va_multi_post_proc_set_context (GstElement * element, GstContext * context)
+{
+  GstVaDisplay *old_display, *new_display;
+  GstVaMultiPostProc *self = GST_VA_MULTI_POST_PROC (element);
+  GstVaMultiPostProcClass *klass = GST_VA_MULTI_POST_PROC_GET_CLASS (self);
+  gboolean ret;
+
+  old_display = self->display ? gst_object_ref (self->display) : NULL;
+  ret = gst_va_handle_set_context (element, context, klass->render_device_path,
+      &self->display);
+  new_display = self->display ? gst_object_ref (self->display) : NULL;
+
+  if (!ret
+      || (old_display && new_display && old_display != new_display
+          && self->filter)) {
+    GST_ELEMENT_WARNING (element, RESOURCE, BUSY,
+        ("Can't replace VA display while operating"), (NULL));
+  }
+
+  gst_clear_object (&old_display);
+  gst_clear_object (&new_display);
+
+  GST_ELEMENT_CLASS (parent_class)->set_context (element, context);
+}
+
+static GstPad *
+gst_va_multi_post_proc_request_new_pad (GstElement * element,
+    GstPadTemplate * templ, const gchar * name, const GstCaps * caps)
+{
+  GstVaMultiPostProc *self = GST_VA_MULTI_POST_PROC (element);
+  GstPad *pad;
+
+  pad = g_object_new (GST_TYPE_VA_MULTI_POST_PROC_PAD, "name", name,
+      "direction", templ->direction, "template", templ, NULL);
+  gst_pad_set_query_function (pad,
+      GST_DEBUG_FUNCPTR (gst_va_multi_post_proc_src_query));
+
+  if (!gst_element_add_pad (element, pad)) {
+    GST_WARNING_OBJECT (self, "Failed to add pad %s", name);
+    gst_object_unref (pad);
+    return NULL;
+  }
+
+  GST_OBJECT_LOCK (self);
+  gst_flow_combiner_add_pad (self->flow_combiner, pad);
+  GST_OBJECT_UNLOCK (self);
+
+  GST_DEBUG_OBJECT (self, "Added pad %s:%s", GST_DEBUG_PAD_NAME (pad));
+
+  return pad;
+}
+
+static void
+gst_va_multi_post_proc_release_pad (GstElement * element, GstPad * pad)
+{
+  GstVaMultiPostProc *self = GST_VA_MULTI_POST_PROC (element);
+
+  GST_DEBUG_OBJECT (self, "Releasing pad %s:%s", GST_DEBUG_PAD_NAME (pad));
+
+  GST_OBJECT_LOCK (self);
+  gst_flow_combiner_remove_pad (self->flow_combiner, pad);
+  GST_OBJECT_UNLOCK (self);
+
+  gst_pad_set_active (pad, FALSE);
+  gst_element_remove_pad (element, pad);
+}
+
+/* Keeps the aspect ratio of the input frame when downstream only
+ * constrains one dimension, otherwise the nearest size to the input
+ * one is chosen. */
+static GstCaps *
+_fixate_caps (GstVaMultiPostProc * self, GstCaps * caps)
+{
+  GstStructure *s;
+  gint in_width, in_height, width = 0, height = 0;
+  gboolean has_width, has_height;
+
+  caps = gst_caps_make_writable (gst_caps_truncate (caps));
+  s = gst_caps_get_structure (caps, 0);
+
+  in_width = GST_VIDEO_INFO_WIDTH (&self->in_info);
+  in_height = GST_VIDEO_INFO_HEIGHT (&self->in_info);
+
+  gst_structure_fixate_field_string (s, "format",
+      GST_VIDEO_INFO_NAME (&self->in_info));
+
+  has_width = gst_structure_get_int (s, "width", &width);
+  has_height = gst_structure_get_int (s, "height", &height);
+
+  if (has_width && !has_height) {
+    height = gst_util_uint64_scale_int (width, in_height, in_width);
+    gst_structure_fixate_field_nearest_int (s, "height", height);
+  } else if (!has_width && has_height) {
+    width = gst_util_uint64_scale_int (height, in_width, in_height);
+    gst_structure_fixate_field_nearest_int (s, "width", width);
+  } else if (!has_width && !has_height) {
+    gst_structure_fixate_field_nearest_int (s, "width", in_width);
+    gst_structure_fixate_field_nearest_int (s, "height", in_height);
+  }
+
+  if (gst_structure_has_field (s, "pixel-aspect-ratio")) {
+    gst_structure_fixate_field_nearest_fraction (s, "pixel-aspect-ratio",
+        GST_VIDEO_INFO_PAR_N (&self->in_info),
+        GST_VIDEO_INFO_PAR_D (&self->in_info));
+  }
+
+  gst_structure_fixate_field_nearest_fraction (s, "framerate",
+      GST_VIDEO_INFO_FPS_N (&self->in_info),
+      GST_VIDEO_INFO_FPS_D (&self->in_info));
+
+  return gst_caps_fixate (caps);
+}
+
+static GstBufferPool *
+_create_pool (GstVaMultiPostProc * self, GstVaMultiPostProcPad * srcpad)
+{
+  GstAllocator *allocator;
+  GstBufferPool *pool;
+  GstQuery *query;
+  GstStructure *config;
+  GArray *surface_formats;
+  guint min = 0, max = 0;
+
+  /* only the buffer count is taken from downstream, the output
+   * surfaces have to be allocated by the filter's display */
+  query = gst_query_new_allocation (srcpad->caps, TRUE);
+  if (gst_pad_peer_query (GST_PAD (srcpad), query)
+      && gst_query_get_n_allocation_pools (query) > 0)
+    gst_query_parse_nth_allocation_pool (query, 0, NULL, NULL, &min, &max);
+  gst_query_unref (query);
+
+  surface_formats = gst_va_filter_get_surface_formats (self->filter);
+  allocator = gst_va_allocator_new (self->display, surface_formats);
+
+  pool = gst_va_pool_new ();
+
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, srcpad->caps,
+      GST_VIDEO_INFO_SIZE (&srcpad->info), min, max);
+  gst_buffer_pool_config_set_va_allocation_params (config,
+      VA_SURFACE_ATTRIB_USAGE_HINT_VPP_WRITE);
+  gst_buffer_pool_config_set_allocator (config, allocator, NULL);
+  gst_buffer_pool_config_add_option (config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+  gst_object_unref (allocator);
+
+  if (!gst_buffer_pool_set_config (pool, config)
+      || !gst_buffer_pool_set_active (pool, TRUE)) {
+    GST_WARNING_OBJECT (srcpad, "Failed to configure pool");
+    gst_clear_object (&pool);
+  }
+
+  return pool;
+}
+
+static gboolean
+_replay_sticky_event (GstPad * sinkpad, GstEvent ** event, gpointer user_data)
+{
+  GstPad *srcpad = user_data;
+
+  /* caps are negotiated per pad and EOS is never replayed */
+  if (GST_EVENT_TYPE (*event) != GST_EVENT_CAPS
+      && GST_EVENT_TYPE (*event) != GST_EVENT_EOS)
+    gst_pad_store_sticky_event (srcpad, *event);
+
+  return TRUE;
+}
+
+static gboolean
+_negotiate_pad (GstVaMultiPostProc * self, GstVaMultiPostProcPad * srcpad)
+{
+  GstPad *pad = GST_PAD (srcpad);
+  GstCaps *templ, *caps;
+  GstVideoInfo info;
+
+  templ = gst_pad_get_pad_template_caps (pad);
+  caps = gst_pad_peer_query_caps (pad, templ);
+  gst_caps_unref (templ);
+
+  if (gst_caps_is_empty (caps)) {
+    gst_caps_unref (caps);
+    GST_WARNING_OBJECT (pad, "No common caps with downstream");
+    return FALSE;
+  }
+
+  caps = _fixate_caps (self, caps);
+
+  if (!gst_video_info_from_caps (&info, caps)) {
+    GST_WARNING_OBJECT (pad, "Invalid caps %" GST_PTR_FORMAT, caps);
+    gst_caps_unref (caps);
+    return FALSE;
+  }
+
+  if (srcpad->negotiated && gst_caps_is_equal (caps, srcpad->caps)) {
+    gst_caps_unref (caps);
+    return TRUE;
+  }
+
+  GST_DEBUG_OBJECT (pad, "negotiated %" GST_PTR_FORMAT, caps);
+
+  gst_va_multi_post_proc_pad_reset (srcpad);
+  srcpad->caps = caps;
+  srcpad->info = info;
+
+  if (!gst_va_filter_set_output_format (self->filter, &srcpad->info,
+          &srcpad->output))
+    return FALSE;
+
+  /* stream-start has to go before the caps, and segment and tags
+   * after them */
+  gst_pad_sticky_events_foreach (self->sinkpad, _replay_sticky_event, pad);
+
+  if (!gst_pad_push_event (pad, gst_event_new_caps (caps)))
+    return FALSE;
+
+  if (!(srcpad->pool = _create_pool (self, srcpad)))
+    return FALSE;
+
+  srcpad->negotiated = TRUE;
+
+  return TRUE;
+}
+
+static gboolean
+gst_va_multi_post_proc_set_caps (GstVaMultiPostProc * self, GstCaps * caps)
+{
+  GstVideoInfo info;
+  GList *l;
+
+  if (!gst_video_info_from_caps (&info, caps)) {
+    GST_WARNING_OBJECT (self, "Invalid caps %" GST_PTR_FORMAT, caps);
+    return FALSE;
+  }
+
+  if (!gst_va_filter_set_input_format (self->filter, &info))
+    return FALSE;
+
+  gst_caps_replace (&self->incaps, caps);
+  self->in_info = info;
+
+  /* source pads are (re)negotiated when the next buffer arrives */
+  GST_OBJECT_LOCK (self);
+  for (l = GST_ELEMENT (self)->srcpads; l; l = l->next)
+    gst_pad_mark_reconfigure (l->data);
+  GST_OBJECT_UNLOCK (self);
+
+  return TRUE;
+}
+
+static gboolean
+gst_va_multi_post_proc_sink_event (GstPad * pad, GstObject * parent,
+    GstEvent * event)
+{
+  GstVaMultiPostProc *self = GST_VA_MULTI_POST_PROC (parent);
+  gboolean ret;
+  GList *srcpads, *l;
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_CAPS:{
+      GstCaps *caps;
+
+      gst_event_parse_caps (event, &caps);
+      ret = gst_va_multi_post_proc_set_caps (self, caps);
+      gst_event_unref (event);
+      return ret;
+    }
+    case GST_EVENT_EOS:
+      break;
+    default:
+      if (!GST_EVENT_IS_STICKY (event)
+          || GST_EVENT_TYPE (event) < GST_EVENT_CAPS)
+        break;
+
+      /* pads without caps get it when they are negotiated */
+      GST_OBJECT_LOCK (self);
+      srcpads = g_list_copy_deep (GST_ELEMENT (self)->srcpads,
+          (GCopyFunc) gst_object_ref, NULL);
+      GST_OBJECT_UNLOCK (self);
+
+      for (l = srcpads; l; l = l->next) {
+        if (GST_VA_MULTI_POST_PROC_PAD (l->data)->negotiated)
+          gst_pad_push_event (l->data, gst_event_ref (event));
+      }
+
+      g_list_free_full (srcpads, gst_object_unref);
+      gst_event_unref (event);
+      return TRUE;
+  }
+
+  return gst_pad_event_default (pad, parent, event);
+}
+
+static gboolean
+gst_va_multi_post_proc_propose_allocation (GstVaMultiPostProc * self,
+    GstQuery * query)
+{
+  GstAllocator *allocator;
+  GstAllocationParams params;
+  GstBufferPool *pool;
+  GstStructure *config;
+  GstVideoInfo info;
+  GstCaps *caps;
+  guint size;
+
+  gst_query_parse_allocation (query, &caps, NULL);
+
+  if (caps == NULL)
+    return FALSE;
+
+  if (!gst_video_info_from_caps (&info, caps))
+    return FALSE;
+
+  if (gst_query_get_n_allocation_pools (query) > 0)
+    return TRUE;
+
+  size = GST_VIDEO_INFO_SIZE (&info);
+
+  allocator = gst_va_allocator_new (self->display,
+      gst_va_filter_get_surface_formats (self->filter));
+  gst_allocation_params_init (&params);
+
+  pool = gst_va_pool_new ();
+  config = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (config, caps, size, 0, 0);
+  /* it migth be used by a va decoder */
+  gst_buffer_pool_config_set_va_allocation_params (config,
+      VA_SURFACE_ATTRIB_USAGE_HINT_GENERIC);
+  gst_buffer_pool_config_set_allocator (config, allocator, &params);
+  gst_buffer_pool_config_add_option (config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+
+  if (!gst_buffer_pool_set_config (pool, config)) {
+    GST_ERROR_OBJECT (self, "failed to set config");
+    gst_object_unref (allocator);
+    gst_object_unref (pool);
+    return FALSE;
+  }
+
+  gst_query_add_allocation_param (query, allocator, &params);
+  gst_query_add_allocation_pool (query, pool, size, 0, 0);
+  gst_query_add_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
+
+  GST_DEBUG_OBJECT (self,
+      "proposing %" GST_PTR_FORMAT " with allocator %" GST_PTR_FORMAT,
+      pool, allocator);
+
+  gst_object_unref (allocator);
+  gst_object_unref (pool);
+
+  return TRUE;
+}
+
+static gboolean
+_handle_context_query (GstVaMultiPostProc * self, GstQuery * query)
+{
+  GstVaDisplay *display = NULL;
+  gboolean ret;
+
+  gst_object_replace ((GstObject **) & display, (GstObject *) self->display);
+  ret = gst_va_handle_context_query (GST_ELEMENT_CAST (self), query, display);
+  gst_clear_object (&display);
+
+  return ret;
+}
+
+static gboolean
+gst_va_multi_post_proc_sink_query (GstPad * pad, GstObject * parent,
+    GstQuery * query)
+{
+  GstVaMultiPostProc *self = GST_VA_MULTI_POST_PROC (parent);
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CAPS:{
+      GstCaps *filter, *caps;
+
+      /* any size can be produced, so it doesn't depend on downstream */
+      gst_query_parse_caps (query, &filter);
+      caps = gst_pad_get_pad_template_caps (pad);
+      if (filter) {
+        GstCaps *tmp = gst_caps_intersect_full (filter, caps,
+            GST_CAPS_INTERSECT_FIRST);
+        gst_caps_unref (caps);
+        caps = tmp;
+      }
+      gst_query_set_caps_result (query, caps);
+      gst_caps_unref (caps);
+      return TRUE;
+    }
+    case GST_QUERY_ALLOCATION:
+      return gst_va_multi_post_proc_propose_allocation (self, query);
+    case GST_QUERY_CONTEXT:
+      return _handle_context_query (self, query);
+    default:
+      break;
+  }
+
+  return gst_pad_query_default (pad, parent, query);
+}
+
+static gboolean
+gst_va_multi_post_proc_src_query (GstPad * pad, GstObject * parent,
+    GstQuery * query)
+{
+  GstVaMultiPostProc *self = GST_VA_MULTI_POST_PROC (parent);
+
+  if (GST_QUERY_TYPE (query) == GST_QUERY_CONTEXT)
+    return _handle_context_query (self, query);
+
+  return gst_pad_query_default (pad, parent, query);
+}
+
+static GstFlowReturn
+_update_flow (GstVaMultiPostProc * self, GstPad * pad, GstFlowReturn flow)
+{
+  GstFlowReturn ret;
+
+  GST_OBJECT_LOCK (self);
+  ret = gst_flow_combiner_update_pad_flow (self->flow_combiner, pad, flow);
+  GST_OBJECT_UNLOCK (self);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_va_multi_post_proc_chain (GstPad * pad, GstObject * parent,
+    GstBuffer * inbuf)
+{
+  GstVaMultiPostProc *self = GST_VA_MULTI_POST_PROC (parent);
+  GstVaMultiPostProcPad **srcpads;
+  GstVaFilterOutput *outputs;
+  GstBuffer **outbufs;
+  GstFlowReturn ret = GST_FLOW_NOT_LINKED;
+  GList *pads, *l;
+  VASurfaceID in_surface;
+  guint i, num = 0, num_pads;
+  gboolean converted;
+
+  in_surface = gst_va_buffer_get_surface (inbuf);
+  if (in_surface == VA_INVALID_ID) {
+    GST_ELEMENT_ERROR (self, STREAM, FAILED, (NULL),
+        ("Input buffer is not a VA surface"));
+    gst_buffer_unref (inbuf);
+    return GST_FLOW_ERROR;
+  }
+
+  GST_OBJECT_LOCK (self);
+  pads = g_list_copy_deep (GST_ELEMENT (self)->srcpads,
+      (GCopyFunc) gst_object_ref, NULL);
+  GST_OBJECT_UNLOCK (self);
+
+  num_pads = g_list_length (pads);
+  srcpads = g_new (GstVaMultiPostProcPad *, num_pads);
+  outputs = g_new (GstVaFilterOutput, num_pads);
+  outbufs = g_new (GstBuffer *, num_pads);
+
+  for (l = pads; l; l = l->next) {
+    GstVaMultiPostProcPad *srcpad = l->data;
+    GstFlowReturn flow;
+
+    if (!gst_pad_is_linked (GST_PAD (srcpad))) {
+      ret = _update_flow (self, GST_PAD (srcpad), GST_FLOW_NOT_LINKED);
+      continue;
+    }
+
+    if (gst_pad_check_reconfigure (GST_PAD (srcpad)) || !srcpad->negotiated) {
+      if (!_negotiate_pad (self, srcpad)) {
+        gst_va_multi_post_proc_pad_reset (srcpad);
+        gst_pad_mark_reconfigure (GST_PAD (srcpad));
+        flow = GST_PAD_IS_FLUSHING (GST_PAD (srcpad)) ?
+            GST_FLOW_FLUSHING : GST_FLOW_NOT_NEGOTIATED;
+        ret = _update_flow (self, GST_PAD (srcpad), flow);
+        continue;
+      }
+    }
+
+    flow = gst_buffer_pool_acquire_buffer (srcpad->pool, &outbufs[num], NULL);
+    if (flow != GST_FLOW_OK) {
+      ret = _update_flow (self, GST_PAD (srcpad), flow);
+      continue;
+    }
+
+    srcpads[num] = srcpad;
+    outputs[num] = srcpad->output;
+    outputs[num].surface = gst_va_buffer_get_surface (outbufs[num]);
+    num++;
+  }
+
+  if (num == 0)
+    goto done;
+
+  converted = gst_va_filter_convert_surfaces (self->filter, in_surface,
+      outputs, num);
+
+  for (i = 0; i < num; i++) {
+    GstFlowReturn flow;
+
+    gst_buffer_copy_into (outbufs[i], inbuf,
+        GST_BUFFER_COPY_FLAGS | GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+    if (!converted)
+      GST_BUFFER_FLAG_SET (outbufs[i], GST_BUFFER_FLAG_CORRUPTED);
+
+    flow = gst_pad_push (GST_PAD (srcpads[i]), outbufs[i]);
+    ret = _update_flow (self, GST_PAD (srcpads[i]), flow);
+  }
+
+done:
+  g_free (srcpads);
+  g_free (outputs);
+  g_free (outbufs);
+  g_list_free_full (pads, gst_object_unref);
+  gst_buffer_unref (inbuf);
+
+  return ret;
+}
+
+static void
+gst_va_multi_post_proc_class_init (gpointer g_class, gpointer class_data)
+{
+  GstCaps *doc_caps, *filter_caps, *caps = NULL;
+  GstPadTemplate *sink_pad_templ, *src_pad_templ;
+  GObjectClass *object_class = G_OBJECT_CLASS (g_class);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (g_class);
+  GstVaDisplay *display;
+  GstVaFilter *filter;
+  GstVaMultiPostProcClass *klass = GST_VA_MULTI_POST_PROC_CLASS (g_class);
+  struct CData *cdata = class_data;
+  gchar *long_name;
+
+  parent_class = g_type_class_peek_parent (g_class);
+
+  klass->render_device_path = g_strdup (cdata->render_device_path);
+
+  if (cdata->description) {
+    long_name = g_strdup_printf ("VA-API Multiple Output Video Postprocessor "
+        "in %s", cdata->description);
+  } else {
+    long_name = g_strdup ("VA-API Multiple Output Video Postprocessor");
+  }
+
+  gst_element_class_set_metadata (element_class, long_name,
+      "Filter/Converter/Video/Scaler/Hardware",
+      "VA-API based video postprocessor with several outputs",
+      "GStreamer developers");
+
+  doc_caps = gst_caps_from_string (caps_str);
+
+  display = gst_va_display_drm_new_from_path (klass->render_device_path);
+  filter = gst_va_filter_new (display);
+
+  if (gst_va_filter_open (filter)) {
+    filter_caps = gst_va_filter_get_caps (filter);
+    caps = gst_caps_intersect (filter_caps, doc_caps);
+    gst_caps_unref (filter_caps);
+  } else {
+    caps = gst_caps_ref (doc_caps);
+  }
+
+  sink_pad_templ = gst_pad_template_new ("sink", GST_PAD_SINK, GST_PAD_ALWAYS,
+      caps);
+  gst_element_class_add_pad_template (element_class, sink_pad_templ);
+  gst_pad_template_set_documentation_caps (sink_pad_templ,
+      gst_caps_ref (doc_caps));
+
+  src_pad_templ = gst_pad_template_new_with_gtype ("src_%u", GST_PAD_SRC,
+      GST_PAD_REQUEST, caps, GST_TYPE_VA_MULTI_POST_PROC_PAD);
+  gst_element_class_add_pad_template (element_class, src_pad_templ);
+  gst_pad_template_set_documentation_caps (src_pad_templ,
+      gst_caps_ref (doc_caps));
+  gst_caps_unref (doc_caps);
+
+  gst_caps_unref (caps);
+
+  object_class->dispose = gst_va_multi_post_proc_dispose;
+
+  element_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_va_multi_post_proc_change_state);
+  element_class->set_context =
+      GST_DEBUG_FUNCPTR (gst_va_multi_post_proc_set_context);
+  element_class->request_new_pad =
+      GST_DEBUG_FUNCPTR (gst_va_multi_post_proc_request_new_pad);
+  element_class->release_pad =
+      GST_DEBUG_FUNCPTR (gst_va_multi_post_proc_release_pad);
+
+  g_free (long_name);
+  g_free (cdata->description);
+  g_free (cdata->render_device_path);
+  g_free (cdata);
+  gst_object_unref (filter);
+  gst_object_unref (display);
+}
+
+static void
+gst_va_multi_post_proc_init (GTypeInstance * instance, gpointer g_class)
+{
+  GstVaMultiPostProc *self = GST_VA_MULTI_POST_PROC (instance);
+  GstPadTemplate *templ;
+
+  templ = gst_element_class_get_pad_template (GST_ELEMENT_CLASS (g_class),
+      "sink");
+  self->sinkpad = gst_pad_new_from_template (templ, "sink");
+  gst_pad_set_chain_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_va_multi_post_proc_chain));
+  gst_pad_set_event_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_va_multi_post_proc_sink_event));
+  gst_pad_set_query_function (self->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_va_multi_post_proc_sink_query));
+  GST_PAD_SET_PROXY_SCHEDULING (self->sinkpad);
+  gst_element_add_pad (GST_ELEMENT (self), self->sinkpad);
+
+  self->flow_combiner = gst_flow_combiner_new ();
+}
+
+static gpointer
+_register_debug_category (gpointer data)
+{
+  GST_DEBUG_CATEGORY_INIT (gst_va_multi_post_proc_debug, "vamultipostproc", 0,
+      "VA Multiple Output Video Postprocessor");
+
+  return NULL;
+}
+
+gboolean
+gst_va_multi_post_proc_register (GstPlugin * plugin, GstVaDevice * device,
+    guint rank)
+{
+  static GOnce debug_once = G_ONCE_INIT;
+  GType type;
+  GTypeInfo type_info = {
+    .class_size = sizeof (GstVaMultiPostProcClass),
+    .class_init = gst_va_multi_post_proc_class_init,
+    .instance_size = sizeof (GstVaMultiPostProc),
+    .instance_init = gst_va_multi_post_proc_init,
+  };
+  struct CData *cdata;
+  gboolean ret;
+  gchar *type_name, *feature_name;
+
+  g_return_val_if_fail (GST_IS_PLUGIN (plugin), FALSE);
+  g_return_val_if_fail (GST_IS_VA_DEVICE (device), FALSE);
+
+  cdata = g_new (struct CData, 1);
+  cdata->description = NULL;
+  cdata->render_device_path = g_strdup (device->render_device_path);
+
+  type_info.class_data = cdata;
+
+  type_name = g_strdup ("GstVaMultiPostProc");
+  feature_name = g_strdup ("vamultipostproc");
+
+  /* The first postprocessor to be registered should use a constant
+   * name, like vamultipostproc, for any additional postprocessors, we
+   * create unique names, using inserting the render device name. */
+  if (g_type_from_name (type_name)) {
+    gchar *basename = g_path_get_basename (device->render_device_path);
+    g_free (type_name);
+    g_free (feature_name);
+    type_name = g_strdup_printf ("GstVa%sMultiPostProc", basename);
+    feature_name = g_strdup_printf ("va%smultipostproc", basename);
+    cdata->description = basename;
+
+    /* lower rank for non-first device */
+    if (rank > 0)
+      rank--;
+  }
+
+  g_once (&debug_once, _register_debug_category, NULL);
+
+  type = g_type_register_static (GST_TYPE_ELEMENT, type_name, &type_info, 0);
+
+  ret = gst_element_register (plugin, feature_name, rank, type);
+
+  g_free (type_name);
+  g_free (feature_name);
+
+  return ret;
+}
@@ -99,6 +99,38 @@ static const struct FormatMap
 };
 /* *INDENT-ON* */
 
+/* DRM fourccs, as in drm_fourcc.h, are little-endian packed */
+/* *INDENT-OFF* */
+static const struct DRMFormatMap
+{
+  GstVideoFormat format;
+  guint32 drm_fourcc;
+} drm_format_map[] = {
+#define D(format, a, b, c, d) \
+    { G_PASTE (GST_VIDEO_FORMAT_, format), GST_MAKE_FOURCC (a, b, c, d) }
+  D (NV12, 'N', 'V', '1', '2'),
+  D (NV21, 'N', 'V', '2', '1'),
+  D (I420, 'Y', 'U', '1', '2'),
+  D (YV12, 'Y', 'V', '1', '2'),
+  D (YUY2, 'Y', 'U', 'Y', 'V'),
+  D (UYVY, 'U', 'Y', 'V', 'Y'),
+  D (VUYA, 'A', 'Y', 'U', 'V'),
+  D (Y210, 'Y', '2', '1', '0'),
+  D (Y410, 'Y', '4', '1', '0'),
+  D (P010_10LE, 'P', '0', '1', '0'),
+  D (GRAY8, 'R', '8', ' ', ' '),
+  D (RGBA, 'A', 'B', '2', '4'),
+  D (RGBx, 'X', 'B', '2', '4'),
+  D (BGRA, 'A', 'R', '2', '4'),
+  D (BGRx, 'X', 'R', '2', '4'),
+  D (ARGB, 'B', 'A', '2', '4'),
+  D (xRGB, 'B', 'X', '2', '4'),
+  D (ABGR, 'R', 'A', '2', '4'),
+  D (xBGR, 'R', 'X', '2', '4'),
+#undef D
+};
+/* *INDENT-ON* */
+
 static const struct FormatMap *
 get_format_map_from_va_fourcc (guint va_fourcc)
 {
@@ -189,6 +221,19 @@ gst_va_chroma_from_video_format (GstVideoFormat format)
   return map ? map->va_rtformat : 0;
 }
 
+guint32
+gst_va_drm_fourcc_from_video_format (GstVideoFormat format)
+{
+  int i;
+
+  for (i = 0; i < G_N_ELEMENTS (drm_format_map); i++) {
+    if (drm_format_map[i].format == format)
+      return drm_format_map[i].drm_fourcc;
+  }
+
+  return 0;
+}
+
 const VAImageFormat *
 gst_va_image_format_from_video_format (GstVideoFormat format)
 {
@@ -177,7 +177,12 @@ gst_va_vp9_new_sequence (GstVp9Decoder * decoder, const GstVp9Parser * parser,
     negotiation_needed = TRUE;
   }
 
-  base->min_buffers = GST_VP9_REF_FRAMES;
+  /* The pool grows on demand, usually only last, golden and altref
+   * pictures are alive besides the current one, so don't preallocate all
+   * the reference slots unless the previous sequence used them */
+  base->min_buffers = MAX (4,
+      gst_vp9_decoder_get_max_pictures_in_use (decoder));
+  base->min_buffers = MIN (base->min_buffers, GST_VP9_REF_FRAMES);
 
   if (negotiation_needed) {
     self->need_negotiation = TRUE;
@@ -28,10 +28,14 @@
 #endif
 
 #include "gstvacaps.h"
+#include "gstvacompositor.h"
 #include "gstvadevice.h"
 #include "gstvah264dec.h"
+#include "gstvah264enc.h"
 #include "gstvah265dec.h"
+#include "gstvah265enc.h"
 #include "gstvampeg2dec.h"
+#include "gstvamultipostproc.h"
 #include "gstvaprofile.h"
 #include "gstvavp8dec.h"
 #include "gstvavp9dec.h"
@@ -180,6 +184,31 @@ plugin_register_encoders (GstPlugin * plugin, GstVaDevice * device,
     GST_LOG ("sink caps: %" GST_PTR_FORMAT, sinkcaps);
     GST_LOG ("src caps: %" GST_PTR_FORMAT, srccaps);
 
+    /* only the slice based entrypoints are implemented */
+    if (entrypoint == VAEntrypointEncPicture)
+      codec = GST_MAKE_FOURCC ('N', 'O', 'N', 'E');
+
+    switch (codec) {
+      case H264:
+        if (!gst_va_h264_enc_register (plugin, device, sinkcaps, srccaps,
+                GST_RANK_NONE, entrypoint)) {
+          GST_WARNING ("Failed to register H264 %sencoder: %s", str,
+              device->render_device_path);
+        }
+        break;
+      case HEVC:
+        if (!gst_va_h265_enc_register (plugin, device, sinkcaps, srccaps,
+                GST_RANK_NONE, entrypoint)) {
+          GST_WARNING ("Failed to register H265 %sencoder: %s", str,
+              device->render_device_path);
+        }
+        break;
+      default:
+        GST_DEBUG ("No %sencoder implementation for %" GST_FOURCC_FORMAT,
+            str, GST_FOURCC_ARGS (codec));
+        break;
+    }
+
     gst_caps_unref (srccaps);
     gst_caps_unref (sinkcaps);
   }
@@ -190,6 +219,12 @@ plugin_register_vpp (GstPlugin * plugin, GstVaDevice * device)
 {
   if (!gst_va_vpp_register (plugin, device, GST_RANK_NONE))
     GST_WARNING ("Failed to register postproc: %s", device->render_device_path);
+  if (!gst_va_compositor_register (plugin, device, GST_RANK_NONE))
+    GST_WARNING ("Failed to register compositor: %s", device->render_device_path);
+  if (!gst_va_multi_post_proc_register (plugin, device, GST_RANK_NONE)) {
+    GST_WARNING ("Failed to register multiple output postproc: %s",
+        device->render_device_path);
+  }
 }
 
 static inline void
@@ -0,0 +1,345 @@
+/* GStreamer
+ *
+ * av1decoder.c: benchmark for tile group submission of GstAV1Decoder
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Decodes an AV1 stream with two dummy GstAV1Decoder subclasses, one
+ * implementing decode_tile() and thus called once per tile group, the
+ * other implementing decode_tiles() and called once per frame, and
+ * reports how many submissions each of them received.
+ *
+ * Nothing is decoded, each submission only spins for --submit-cost
+ * microseconds to model the per-call overhead of a hardware decoding API.
+ *
+ * The built-in stream has one tile group per frame. Streams with several
+ * tile groups per frame, which is where batching helps, can be passed with
+ * --av1 (low overhead OBU stream or IVF).
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/codecs/gstav1decoder.h>
+
+/* reference bitstream of the element tests */
+#include "../check/elements/av1parse.h"
+
+#define DEFAULT_REPEAT 20
+#define DEFAULT_SUBMIT_COST 20
+
+#define IVF_HEADER_SIZE 32
+#define IVF_FRAME_HEADER_SIZE 12
+
+typedef struct
+{
+  guint frames;
+  guint submissions;
+  guint tile_groups;
+  guint tiles;
+} BenchCounts;
+
+static BenchCounts counts;
+static guint submit_cost = DEFAULT_SUBMIT_COST;
+
+static void
+bench_submit (guint num_tile_groups, GstAV1Tile * tiles)
+{
+  gint64 end = g_get_monotonic_time () + submit_cost;
+  guint i;
+
+  counts.submissions++;
+  counts.tile_groups += num_tile_groups;
+  for (i = 0; i < num_tile_groups; i++)
+    counts.tiles += tiles[i].tile_group.tg_end - tiles[i].tile_group.tg_start
+        + 1;
+
+  while (g_get_monotonic_time () < end);
+}
+
+/* decoder submitting each tile group */
+
+typedef GstAV1Decoder BenchAV1Dec;
+typedef GstAV1DecoderClass BenchAV1DecClass;
+
+G_DEFINE_TYPE (BenchAV1Dec, bench_av1_dec, GST_TYPE_AV1_DECODER);
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-av1, stream-format = (string) obu-stream, "
+        "alignment = (string) frame"));
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS ("video/x-raw"));
+
+static gboolean
+bench_av1_dec_new_sequence (GstAV1Decoder * decoder,
+    const GstAV1SequenceHeaderOBU * seq_hdr)
+{
+  return TRUE;
+}
+
+static gboolean
+bench_av1_dec_decode_tile (GstAV1Decoder * decoder, GstAV1Picture * picture,
+    GstAV1Tile * tile)
+{
+  bench_submit (1, tile);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+bench_av1_dec_output_picture (GstAV1Decoder * decoder,
+    GstVideoCodecFrame * frame, GstAV1Picture * picture)
+{
+  counts.frames++;
+
+  gst_av1_picture_unref (picture);
+  gst_video_decoder_release_frame (GST_VIDEO_DECODER (decoder), frame);
+
+  return GST_FLOW_OK;
+}
+
+static void
+bench_av1_dec_class_init (BenchAV1DecClass * klass)
+{
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+
+  gst_element_class_add_static_pad_template (element_class, &sink_template);
+  gst_element_class_add_static_pad_template (element_class, &src_template);
+  gst_element_class_set_static_metadata (element_class,
+      "AV1 benchmark decoder", "Codec/Decoder/Video",
+      "Counts tile group submissions", "GStreamer developers");
+
+  klass->new_sequence = bench_av1_dec_new_sequence;
+  klass->decode_tile = bench_av1_dec_decode_tile;
+  klass->output_picture = bench_av1_dec_output_picture;
+}
+
+static void
+bench_av1_dec_init (BenchAV1Dec * self)
+{
+}
+
+/* decoder submitting all tile groups of a frame at once */
+
+typedef GstAV1Decoder BenchAV1BatchDec;
+typedef GstAV1DecoderClass BenchAV1BatchDecClass;
+
+G_DEFINE_TYPE (BenchAV1BatchDec, bench_av1_batch_dec, bench_av1_dec_get_type ());
+
+static gboolean
+bench_av1_batch_dec_decode_tiles (GstAV1Decoder * decoder,
+    GstAV1Picture * picture, GstAV1Tile * tiles, guint num_tiles)
+{
+  bench_submit (num_tiles, tiles);
+
+  return TRUE;
+}
+
+static void
+bench_av1_batch_dec_class_init (BenchAV1BatchDecClass * klass)
+{
+  klass->decode_tiles = bench_av1_batch_dec_decode_tiles;
+}
+
+static void
+bench_av1_batch_dec_init (BenchAV1BatchDec * self)
+{
+}
+
+/* input */
+
+/* Splits an IVF file into its temporal units, returns NULL if @data is not
+ * IVF */
+static GPtrArray *
+read_ivf_frames (const guint8 * data, gsize size)
+{
+  GPtrArray *frames;
+  gsize offset;
+
+  if (size < IVF_HEADER_SIZE || memcmp (data, "DKIF", 4))
+    return NULL;
+
+  frames = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+  offset = GST_READ_UINT16_LE (data + 6);
+  while (offset + IVF_FRAME_HEADER_SIZE <= size) {
+    guint32 frame_size = GST_READ_UINT32_LE (data + offset);
+
+    offset += IVF_FRAME_HEADER_SIZE;
+    if (frame_size > size - offset)
+      break;
+
+    g_ptr_array_add (frames, g_bytes_new (data + offset, frame_size));
+    offset += frame_size;
+  }
+
+  return frames;
+}
+
+static gboolean
+bench_run (const gchar * factory, GPtrArray * chunks, guint repeat,
+    GstClockTime * elapsed)
+{
+  GstElement *pipeline, *src;
+  GstMessage *msg;
+  GstClockTime start;
+  gchar *desc;
+  gboolean ret = TRUE;
+  guint i, n;
+
+  desc = g_strdup_printf ("appsrc name=src caps=video/x-av1 format=bytes ! "
+      "av1parse ! %s ! fakesink", factory);
+  pipeline = gst_parse_launch (desc, NULL);
+  g_free (desc);
+
+  if (!pipeline) {
+    g_printerr ("Could not create pipeline, is av1parse available?\n");
+    return FALSE;
+  }
+
+  src = gst_bin_get_by_name (GST_BIN (pipeline), "src");
+  memset (&counts, 0, sizeof (counts));
+
+  start = gst_util_get_timestamp ();
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  for (n = 0; n < repeat; n++) {
+    for (i = 0; i < chunks->len; i++) {
+      GBytes *chunk = g_ptr_array_index (chunks, i);
+
+      gst_app_src_push_buffer (GST_APP_SRC (src),
+          gst_buffer_new_wrapped_bytes (chunk));
+    }
+  }
+  gst_app_src_end_of_stream (GST_APP_SRC (src));
+
+  msg = gst_bus_timed_pop_filtered (GST_ELEMENT_BUS (pipeline),
+      GST_CLOCK_TIME_NONE, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  *elapsed = gst_util_get_timestamp () - start;
+
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+    GError *err = NULL;
+
+    gst_message_parse_error (msg, &err, NULL);
+    g_printerr ("%s: %s\n", factory, err->message);
+    g_clear_error (&err);
+    ret = FALSE;
+  }
+
+  gst_message_unref (msg);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (src);
+  gst_object_unref (pipeline);
+
+  return ret;
+}
+
+static void
+bench_print (const gchar * name, GstClockTime elapsed)
+{
+  g_print ("%-12s %8u %8u %8u %8u %10.2f %10.3f\n", name, counts.frames,
+      counts.tile_groups, counts.tiles, counts.submissions,
+      counts.frames ? (gdouble) counts.submissions / counts.frames : 0.0,
+      (gdouble) elapsed / GST_MSECOND);
+}
+
+int
+main (int argc, char **argv)
+{
+  guint repeat = DEFAULT_REPEAT;
+  gchar *av1 = NULL;
+  GOptionEntry options[] = {
+    {"repeat", 'r', 0, G_OPTION_ARG_INT, &repeat,
+        "Number of times the stream is decoded", "N"},
+    {"submit-cost", 'c', 0, G_OPTION_ARG_INT, &submit_cost,
+        "Time in microseconds spent per submission", "US"},
+    {"av1", 0, 0, G_OPTION_ARG_FILENAME, &av1,
+        "AV1 OBU stream or IVF file to decode instead of the built-in one",
+        "FILE"},
+    {NULL}
+  };
+  GOptionContext *ctx;
+  GError *err = NULL;
+  GPtrArray *chunks = NULL;
+  GstClockTime elapsed;
+  gboolean ok = TRUE;
+
+  ctx = g_option_context_new ("- AV1 tile group submission benchmark");
+  g_option_context_add_main_entries (ctx, options, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_option_context_free (ctx);
+    g_clear_error (&err);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  gst_element_register (NULL, "benchav1dec", GST_RANK_NONE,
+      bench_av1_dec_get_type ());
+  gst_element_register (NULL, "benchav1batchdec", GST_RANK_NONE,
+      bench_av1_batch_dec_get_type ());
+
+  if (av1) {
+    gchar *contents;
+    gsize size;
+
+    if (!g_file_get_contents (av1, &contents, &size, &err)) {
+      g_printerr ("Could not read %s: %s\n", av1, err->message);
+      g_clear_error (&err);
+      g_free (av1);
+      return 1;
+    }
+
+    chunks = read_ivf_frames ((const guint8 *) contents, size);
+    if (!chunks) {
+      chunks =
+          g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+      g_ptr_array_add (chunks, g_bytes_new_take (contents, size));
+    } else {
+      g_free (contents);
+    }
+  } else {
+    chunks = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+    g_ptr_array_add (chunks, g_bytes_new_static (stream_no_annexb_av1,
+            stream_no_annexb_av1_len));
+  }
+
+  g_print ("%-12s %8s %8s %8s %8s %10s %10s\n", "mode", "frames",
+      "groups", "tiles", "submits", "submits/f", "time (ms)");
+
+  if (bench_run ("benchav1dec", chunks, repeat, &elapsed))
+    bench_print ("per-group", elapsed);
+  else
+    ok = FALSE;
+
+  if (bench_run ("benchav1batchdec", chunks, repeat, &elapsed))
+    bench_print ("batched", elapsed);
+  else
+    ok = FALSE;
+
+  g_ptr_array_unref (chunks);
+  g_free (av1);
+
+  return ok ? 0 : 1;
+}
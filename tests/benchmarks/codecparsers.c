@@ -0,0 +1,839 @@
+/* GStreamer
+ *
+ * codecparsers.c: microbenchmark for the gst-libs codec parsers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Runs H.264, H.265, AV1, VP9 and MPEG-2 bitstreams through the parsing
+ * functions of gst-libs/gst/codecparsers, the same way the parser elements
+ * and the stateless decoders call them, and reports for every function the
+ * number of calls, the time per call and the throughput in bytes of
+ * bitstream handed to it per second.
+ *
+ * Small reference streams taken from the unit tests are built in. Real
+ * recordings can be passed with --h264, --h265 and --mpeg2 (elementary
+ * byte-streams), --av1 (low overhead OBU stream or IVF) and --vp9 (IVF).
+ *
+ * Every call is timed individually, the mean cost of reading the clock
+ * is measured once and subtracted.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/codecparsers/gsth264parser.h>
+#include <gst/codecparsers/gsth265parser.h>
+#include <gst/codecparsers/gstav1parser.h>
+#include <gst/codecparsers/gstvp9parser.h>
+#include <gst/codecparsers/gstmpegvideoparser.h>
+
+/* reference bitstreams of the element tests */
+#include "../check/elements/av1parse.h"
+#include "../check/elements/vp9parse.h"
+
+#define DEFAULT_REPEAT 2000
+
+/* 128x128 two slices IDR from openh264enc, see tests/check/elements/h264parse.c */
+static const guint8 h264_stream[] = {
+  /* SPS */
+  0x00, 0x00, 0x00, 0x01, 0x67, 0x42, 0xc0, 0x0b,
+  0x8c, 0x8d, 0x41, 0x02, 0x24, 0x03, 0xc2, 0x21,
+  0x1a, 0x80,
+  /* PPS */
+  0x00, 0x00, 0x00, 0x01, 0x68, 0xce, 0x3c, 0x80,
+  /* IDR slice 1 */
+  0x00, 0x00, 0x00, 0x01, 0x65, 0xb8, 0x00, 0x04,
+  0x00, 0x00, 0x11, 0xff, 0xff, 0xf8, 0x22, 0x8a,
+  0x1f, 0x1c, 0x00, 0x04, 0x0a, 0x63, 0x80, 0x00,
+  0x81, 0xec, 0x9a, 0x93, 0x93, 0x93, 0x93, 0x93,
+  0x93, 0xad, 0x57, 0x5d, 0x75, 0xd7, 0x5d, 0x75,
+  0xd7, 0x5d, 0x75, 0xd7, 0x5d, 0x75, 0xd7, 0x5d,
+  0x75, 0xd7, 0x5d, 0x78,
+  /* IDR slice 2 */
+  0x00, 0x00, 0x00, 0x01, 0x65, 0x04, 0x2e, 0x00,
+  0x01, 0x00, 0x00, 0x04, 0x7f, 0xff, 0xfe, 0x08,
+  0xa2, 0x87, 0xc7, 0x00, 0x01, 0x02, 0x98, 0xe0,
+  0x00, 0x20, 0x7b, 0x26, 0xa4, 0xe4, 0xe4, 0xe4,
+  0xe4, 0xe4, 0xeb, 0x55, 0xd7, 0x5d, 0x75, 0xd7,
+  0x5d, 0x75, 0xd7, 0x5d, 0x75, 0xd7, 0x5d, 0x75,
+  0xd7, 0x5d, 0x75, 0xd7, 0x5e
+};
+
+/* 128x128 two slices IDR from omxh265enc, see tests/check/elements/h265parse.c */
+static const guint8 h265_stream[] = {
+  /* VPS */
+  0x00, 0x00, 0x00, 0x01, 0x40, 0x01, 0x0c, 0x01,
+  0xff, 0xff, 0x01, 0x40, 0x00, 0x00, 0x03, 0x00,
+  0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00,
+  0x1e, 0x25, 0x02, 0x40,
+  /* SPS */
+  0x00, 0x00, 0x00, 0x01, 0x42, 0x01, 0x01, 0x01,
+  0x40, 0x00, 0x00, 0x03, 0x00, 0x90, 0x00, 0x00,
+  0x03, 0x00, 0x00, 0x03, 0x00, 0x1e, 0xa0, 0x10,
+  0x20, 0x20, 0x59, 0xe9, 0x6e, 0x44, 0xa1, 0x73,
+  0x50, 0x60, 0x20, 0x2e, 0x10, 0x00, 0x00, 0x03,
+  0x00, 0x10, 0x00, 0x00, 0x03, 0x01, 0xe5, 0x1a,
+  0xff, 0xff, 0x10, 0x3e, 0x80, 0x5d, 0xf7, 0xc2,
+  0x01, 0x04,
+  /* PPS */
+  0x00, 0x00, 0x00, 0x01, 0x44, 0x01, 0xc0, 0x71,
+  0x81, 0x8d, 0xb2,
+  /* IDR_N_LP slice 1 */
+  0x00, 0x00, 0x00, 0x01, 0x28, 0x01, 0xac, 0x46,
+  0x13, 0xb6, 0x45, 0x43, 0xaf, 0xee, 0x3d, 0x3f,
+  0x76, 0xe5, 0x73, 0x2f, 0xee, 0xd2, 0xeb, 0xbf,
+  0x80,
+  /* IDR_N_LP slice 2 */
+  0x00, 0x00, 0x00, 0x01, 0x28, 0x01, 0x30, 0xc4,
+  0x60, 0x13, 0xb6, 0x45, 0x43, 0xaf, 0xee, 0x3d,
+  0x3f, 0x76, 0xe5, 0x73, 0x2f, 0xee, 0xd2, 0xeb,
+  0xbf, 0x80
+};
+
+/* sequence header, extension and GOP from tests/check/libs/mpegvideoparser.c,
+ * followed by an I picture header with its coding extension */
+static const guint8 mpeg2_stream[] = {
+  0x00, 0x00, 0x01, 0xb3, 0x78, 0x04, 0x38, 0x37, 0xff, 0xff, 0xf0, 0x00,
+  0x00, 0x00, 0x01, 0xb5, 0x14, 0x8a, 0x00, 0x11, 0x03, 0x71,
+  0x00, 0x00, 0x01, 0xb8, 0x00, 0x08, 0x00, 0x00,
+  0x00, 0x00, 0x01, 0x00, 0x00, 0x0f, 0xff, 0xf8,
+  0x00, 0x00, 0x01, 0xb5, 0x8f, 0xff, 0xf3, 0x41, 0x80,
+  0x00, 0x00, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00
+};
+
+/* statistics */
+
+typedef struct
+{
+  const gchar *name;
+  guint64 calls;
+  guint64 bytes;
+  GstClockTime time;
+} BenchStat;
+
+static GstClockTime clock_overhead;
+
+static inline void
+bench_stat_add (BenchStat * stat, gsize bytes, GstClockTime start)
+{
+  GstClockTime elapsed = gst_util_get_timestamp () - start;
+
+  stat->calls++;
+  stat->bytes += bytes;
+  stat->time += elapsed > clock_overhead ? elapsed - clock_overhead : 0;
+}
+
+#define BENCH_CALL(stat, bytes, call) G_STMT_START { \
+  GstClockTime _start = gst_util_get_timestamp (); \
+  call; \
+  bench_stat_add (stat, bytes, _start); \
+} G_STMT_END
+
+static void
+bench_calibrate (void)
+{
+  GstClockTime start, total = 0;
+  guint i;
+
+  for (i = 0; i < 100000; i++) {
+    start = gst_util_get_timestamp ();
+    total += gst_util_get_timestamp () - start;
+  }
+
+  clock_overhead = total / 100000;
+}
+
+static void
+bench_print_header (void)
+{
+  g_print ("%-45s %10s %12s %12s\n", "function", "calls", "ns/call",
+      "MB/s");
+}
+
+static void
+bench_print (const gchar * codec, BenchStat * stats, guint n_stats)
+{
+  guint i;
+
+  for (i = 0; i < n_stats; i++) {
+    BenchStat *stat = &stats[i];
+    gchar *name;
+
+    if (!stat->calls)
+      continue;
+
+    name = g_strdup_printf ("%s %s", codec, stat->name);
+    g_print ("%-45s %10" G_GUINT64_FORMAT " %12.1f %12.1f\n", name,
+        stat->calls, (gdouble) stat->time / stat->calls,
+        stat->time ? stat->bytes * 1000.0 / stat->time : 0.0);
+    g_free (name);
+  }
+}
+
+/* H.264 */
+
+enum
+{
+  H264_IDENTIFY_NALU,
+  H264_PARSE_NAL,
+  H264_PARSE_SEI,
+  H264_PARSE_SLICE_HDR,
+  H264_N_STATS
+};
+
+static void
+bench_h264 (const guint8 * data, gsize size, guint repeat)
+{
+  BenchStat stats[H264_N_STATS] = {
+    {"gst_h264_parser_identify_nalu"},
+    {"gst_h264_parser_parse_nal"},
+    {"gst_h264_parser_parse_sei"},
+    {"gst_h264_parser_parse_slice_hdr"},
+  };
+  guint i;
+
+  for (i = 0; i < repeat; i++) {
+    GstH264NalParser *parser = gst_h264_nal_parser_new ();
+    GstH264ParserResult res;
+    GstH264NalUnit nalu;
+    guint offset = 0;
+
+    do {
+      BENCH_CALL (&stats[H264_IDENTIFY_NALU], 0,
+          res = gst_h264_parser_identify_nalu (parser, data, offset, size,
+              &nalu));
+      if (res != GST_H264_PARSER_OK && res != GST_H264_PARSER_NO_NAL_END)
+        break;
+
+      stats[H264_IDENTIFY_NALU].bytes += nalu.offset + nalu.size - offset;
+      offset = nalu.offset + nalu.size;
+
+      switch (nalu.type) {
+        case GST_H264_NAL_SPS:
+        case GST_H264_NAL_PPS:
+          BENCH_CALL (&stats[H264_PARSE_NAL], nalu.size,
+              gst_h264_parser_parse_nal (parser, &nalu));
+          break;
+        case GST_H264_NAL_SEI:{
+          GArray *messages = NULL;
+
+          BENCH_CALL (&stats[H264_PARSE_SEI], nalu.size,
+              gst_h264_parser_parse_sei (parser, &nalu, &messages));
+          if (messages)
+            g_array_free (messages, TRUE);
+          break;
+        }
+        case GST_H264_NAL_SLICE:
+        case GST_H264_NAL_SLICE_IDR:{
+          GstH264SliceHdr slice;
+
+          BENCH_CALL (&stats[H264_PARSE_SLICE_HDR], nalu.size,
+              gst_h264_parser_parse_slice_hdr (parser, &nalu, &slice, TRUE,
+                  TRUE));
+          break;
+        }
+        default:
+          break;
+      }
+    } while (res == GST_H264_PARSER_OK);
+
+    gst_h264_nal_parser_free (parser);
+  }
+
+  bench_print ("h264", stats, H264_N_STATS);
+}
+
+/* H.265 */
+
+enum
+{
+  H265_IDENTIFY_NALU,
+  H265_PARSE_NAL,
+  H265_PARSE_SEI,
+  H265_PARSE_SLICE_HDR,
+  H265_N_STATS
+};
+
+static void
+bench_h265 (const guint8 * data, gsize size, guint repeat)
+{
+  BenchStat stats[H265_N_STATS] = {
+    {"gst_h265_parser_identify_nalu"},
+    {"gst_h265_parser_parse_nal"},
+    {"gst_h265_parser_parse_sei"},
+    {"gst_h265_parser_parse_slice_hdr"},
+  };
+  guint i;
+
+  for (i = 0; i < repeat; i++) {
+    GstH265Parser *parser = gst_h265_parser_new ();
+    GstH265ParserResult res;
+    GstH265NalUnit nalu;
+    guint offset = 0;
+
+    do {
+      BENCH_CALL (&stats[H265_IDENTIFY_NALU], 0,
+          res = gst_h265_parser_identify_nalu (parser, data, offset, size,
+              &nalu));
+      if (res != GST_H265_PARSER_OK && res != GST_H265_PARSER_NO_NAL_END)
+        break;
+
+      stats[H265_IDENTIFY_NALU].bytes += nalu.offset + nalu.size - offset;
+      offset = nalu.offset + nalu.size;
+
+      switch (nalu.type) {
+        case GST_H265_NAL_VPS:
+        case GST_H265_NAL_SPS:
+        case GST_H265_NAL_PPS:
+          BENCH_CALL (&stats[H265_PARSE_NAL], nalu.size,
+              gst_h265_parser_parse_nal (parser, &nalu));
+          break;
+        case GST_H265_NAL_PREFIX_SEI:
+        case GST_H265_NAL_SUFFIX_SEI:{
+          GArray *messages = NULL;
+
+          BENCH_CALL (&stats[H265_PARSE_SEI], nalu.size,
+              gst_h265_parser_parse_sei (parser, &nalu, &messages));
+          if (messages)
+            g_array_free (messages, TRUE);
+          break;
+        }
+        default:
+          if (nalu.type <= GST_H265_NAL_SLICE_CRA_NUT) {
+            GstH265SliceHdr slice;
+            GstH265ParserResult slice_res;
+
+            BENCH_CALL (&stats[H265_PARSE_SLICE_HDR], nalu.size,
+                slice_res = gst_h265_parser_parse_slice_hdr (parser, &nalu,
+                    &slice));
+            if (slice_res == GST_H265_PARSER_OK)
+              gst_h265_slice_hdr_free (&slice);
+          }
+          break;
+      }
+    } while (res == GST_H265_PARSER_OK);
+
+    gst_h265_parser_free (parser);
+  }
+
+  bench_print ("h265", stats, H265_N_STATS);
+}
+
+/* AV1 */
+
+enum
+{
+  AV1_IDENTIFY_ONE_OBU,
+  AV1_PARSE_TEMPORAL_DELIMITER_OBU,
+  AV1_PARSE_SEQUENCE_HEADER_OBU,
+  AV1_PARSE_FRAME_HEADER_OBU,
+  AV1_PARSE_FRAME_OBU,
+  AV1_PARSE_TILE_GROUP_OBU,
+  AV1_PARSE_METADATA_OBU,
+  AV1_REFERENCE_FRAME_UPDATE,
+  AV1_N_STATS
+};
+
+static void
+bench_av1_reference_update (GstAV1Parser * parser, BenchStat * stat,
+    GstAV1FrameHeaderOBU * fh)
+{
+  if (!fh->show_existing_frame || fh->frame_type == GST_AV1_KEY_FRAME)
+    BENCH_CALL (stat, 0, gst_av1_parser_reference_frame_update (parser, fh));
+}
+
+static void
+bench_av1 (const guint8 * data, gsize size, gboolean annex_b, guint repeat)
+{
+  BenchStat stats[AV1_N_STATS] = {
+    {"gst_av1_parser_identify_one_obu"},
+    {"gst_av1_parser_parse_temporal_delimiter_obu"},
+    {"gst_av1_parser_parse_sequence_header_obu"},
+    {"gst_av1_parser_parse_frame_header_obu"},
+    {"gst_av1_parser_parse_frame_obu"},
+    {"gst_av1_parser_parse_tile_group_obu"},
+    {"gst_av1_parser_parse_metadata_obu"},
+    {"gst_av1_parser_reference_frame_update"},
+  };
+  guint i;
+
+  for (i = 0; i < repeat; i++) {
+    GstAV1Parser *parser = gst_av1_parser_new ();
+    GstAV1ParserResult res;
+    gsize offset = 0;
+
+    gst_av1_parser_reset (parser, annex_b);
+
+    while (offset < size) {
+      GstAV1OBU obu;
+      guint32 consumed;
+
+      BENCH_CALL (&stats[AV1_IDENTIFY_ONE_OBU], 0,
+          res = gst_av1_parser_identify_one_obu (parser, data + offset,
+              size - offset, &obu, &consumed));
+      stats[AV1_IDENTIFY_ONE_OBU].bytes += consumed;
+      if (res == GST_AV1_PARSER_DROP) {
+        offset += consumed;
+        continue;
+      }
+      if (res != GST_AV1_PARSER_OK)
+        break;
+      offset += consumed;
+
+      switch (obu.obu_type) {
+        case GST_AV1_OBU_TEMPORAL_DELIMITER:
+          BENCH_CALL (&stats[AV1_PARSE_TEMPORAL_DELIMITER_OBU], obu.obu_size,
+              gst_av1_parser_parse_temporal_delimiter_obu (parser, &obu));
+          break;
+        case GST_AV1_OBU_SEQUENCE_HEADER:{
+          GstAV1SequenceHeaderOBU seq_header;
+
+          BENCH_CALL (&stats[AV1_PARSE_SEQUENCE_HEADER_OBU], obu.obu_size,
+              gst_av1_parser_parse_sequence_header_obu (parser, &obu,
+                  &seq_header));
+          break;
+        }
+        case GST_AV1_OBU_FRAME_HEADER:{
+          GstAV1FrameHeaderOBU fh;
+
+          BENCH_CALL (&stats[AV1_PARSE_FRAME_HEADER_OBU], obu.obu_size,
+              res = gst_av1_parser_parse_frame_header_obu (parser, &obu,
+                  &fh));
+          if (res == GST_AV1_PARSER_OK)
+            bench_av1_reference_update (parser,
+                &stats[AV1_REFERENCE_FRAME_UPDATE], &fh);
+          break;
+        }
+        case GST_AV1_OBU_FRAME:{
+          GstAV1FrameOBU frame;
+
+          BENCH_CALL (&stats[AV1_PARSE_FRAME_OBU], obu.obu_size,
+              res = gst_av1_parser_parse_frame_obu (parser, &obu, &frame));
+          if (res == GST_AV1_PARSER_OK)
+            bench_av1_reference_update (parser,
+                &stats[AV1_REFERENCE_FRAME_UPDATE], &frame.frame_header);
+          break;
+        }
+        case GST_AV1_OBU_TILE_GROUP:{
+          GstAV1TileGroupOBU tile_group;
+
+          BENCH_CALL (&stats[AV1_PARSE_TILE_GROUP_OBU], obu.obu_size,
+              gst_av1_parser_parse_tile_group_obu (parser, &obu,
+                  &tile_group));
+          break;
+        }
+        case GST_AV1_OBU_METADATA:{
+          GstAV1MetadataOBU metadata;
+
+          BENCH_CALL (&stats[AV1_PARSE_METADATA_OBU], obu.obu_size,
+              gst_av1_parser_parse_metadata_obu (parser, &obu, &metadata));
+          break;
+        }
+        default:
+          break;
+      }
+    }
+
+    gst_av1_parser_free (parser);
+  }
+
+  bench_print (annex_b ? "av1-annexb" : "av1", stats, AV1_N_STATS);
+}
+
+/* VP9 */
+
+enum
+{
+  VP9_PARSE_SUPERFRAME_INFO,
+  VP9_PARSE_FRAME_HEADER,
+  VP9_N_STATS
+};
+
+static void
+bench_vp9 (GPtrArray * frames, guint repeat)
+{
+  BenchStat stats[VP9_N_STATS] = {
+    {"gst_vp9_parser_parse_superframe_info"},
+    {"gst_vp9_parser_parse_frame_header"},
+  };
+  guint i, j, k;
+
+  for (i = 0; i < repeat; i++) {
+    GstVp9Parser *parser = gst_vp9_parser_new ();
+
+    for (j = 0; j < frames->len; j++) {
+      GBytes *frame = g_ptr_array_index (frames, j);
+      gsize size;
+      const guint8 *data = g_bytes_get_data (frame, &size);
+      GstVp9SuperframeInfo info;
+      GstVp9ParserResult res;
+      gsize offset = 0;
+
+      BENCH_CALL (&stats[VP9_PARSE_SUPERFRAME_INFO], size,
+          res = gst_vp9_parser_parse_superframe_info (parser, &info, data,
+              size));
+      if (res != GST_VP9_PARSER_OK)
+        continue;
+
+      for (k = 0; k < info.frames_in_superframe; k++) {
+        GstVp9FrameHdr frame_hdr;
+
+        if (info.frame_sizes[k] > size - offset)
+          break;
+
+        BENCH_CALL (&stats[VP9_PARSE_FRAME_HEADER], info.frame_sizes[k],
+            gst_vp9_parser_parse_frame_header (parser, &frame_hdr,
+                data + offset, info.frame_sizes[k]));
+        offset += info.frame_sizes[k];
+      }
+    }
+
+    gst_vp9_parser_free (parser);
+  }
+
+  bench_print ("vp9", stats, VP9_N_STATS);
+}
+
+/* MPEG-2 */
+
+enum
+{
+  MPEG2_PARSE,
+  MPEG2_PARSE_SEQUENCE_HEADER,
+  MPEG2_PARSE_SEQUENCE_EXTENSION,
+  MPEG2_PARSE_GOP,
+  MPEG2_PARSE_PICTURE_HEADER,
+  MPEG2_PARSE_PICTURE_EXTENSION,
+  MPEG2_N_STATS
+};
+
+static void
+bench_mpeg2 (const guint8 * data, gsize size, guint repeat)
+{
+  BenchStat stats[MPEG2_N_STATS] = {
+    {"gst_mpeg_video_parse"},
+    {"gst_mpeg_video_packet_parse_sequence_header"},
+    {"gst_mpeg_video_packet_parse_sequence_extension"},
+    {"gst_mpeg_video_packet_parse_gop"},
+    {"gst_mpeg_video_packet_parse_picture_header"},
+    {"gst_mpeg_video_packet_parse_picture_extension"},
+  };
+  guint i;
+
+  for (i = 0; i < repeat; i++) {
+    GstMpegVideoPacket packet;
+    guint offset = 0;
+    gboolean found;
+
+    for (;;) {
+      gsize packet_size;
+
+      BENCH_CALL (&stats[MPEG2_PARSE], 0,
+          found = gst_mpeg_video_parse (&packet, data, size, offset));
+      if (!found)
+        break;
+
+      packet_size = packet.size >= 0 ? packet.size : size - packet.offset;
+      stats[MPEG2_PARSE].bytes += packet.offset + packet_size - offset;
+      packet.size = packet_size;
+      offset = packet.offset + packet_size;
+
+      switch (packet.type) {
+        case GST_MPEG_VIDEO_PACKET_SEQUENCE:{
+          GstMpegVideoSequenceHdr seqhdr;
+
+          BENCH_CALL (&stats[MPEG2_PARSE_SEQUENCE_HEADER], packet_size,
+              gst_mpeg_video_packet_parse_sequence_header (&packet, &seqhdr));
+          break;
+        }
+        case GST_MPEG_VIDEO_PACKET_GOP:{
+          GstMpegVideoGop gop;
+
+          BENCH_CALL (&stats[MPEG2_PARSE_GOP], packet_size,
+              gst_mpeg_video_packet_parse_gop (&packet, &gop));
+          break;
+        }
+        case GST_MPEG_VIDEO_PACKET_PICTURE:{
+          GstMpegVideoPictureHdr pichdr;
+
+          BENCH_CALL (&stats[MPEG2_PARSE_PICTURE_HEADER], packet_size,
+              gst_mpeg_video_packet_parse_picture_header (&packet, &pichdr));
+          break;
+        }
+        case GST_MPEG_VIDEO_PACKET_EXTENSION:{
+          guint8 ext_type;
+
+          if (!packet_size)
+            break;
+
+          ext_type = packet.data[packet.offset] >> 4;
+          if (ext_type == GST_MPEG_VIDEO_PACKET_EXT_SEQUENCE) {
+            GstMpegVideoSequenceExt seqext;
+
+            BENCH_CALL (&stats[MPEG2_PARSE_SEQUENCE_EXTENSION], packet_size,
+                gst_mpeg_video_packet_parse_sequence_extension (&packet,
+                    &seqext));
+          } else if (ext_type == GST_MPEG_VIDEO_PACKET_EXT_PICTURE) {
+            GstMpegVideoPictureExt picext;
+
+            BENCH_CALL (&stats[MPEG2_PARSE_PICTURE_EXTENSION], packet_size,
+                gst_mpeg_video_packet_parse_picture_extension (&packet,
+                    &picext));
+          }
+          break;
+        }
+        default:
+          break;
+      }
+    }
+  }
+
+  bench_print ("mpeg2", stats, MPEG2_N_STATS);
+}
+
+/* input */
+
+#define IVF_HEADER_SIZE 32
+#define IVF_FRAME_HEADER_SIZE 12
+
+/* Splits an IVF file into its frames, returns NULL if @data is not IVF */
+static GPtrArray *
+read_ivf_frames (const guint8 * data, gsize size)
+{
+  GPtrArray *frames;
+  gsize offset;
+
+  if (size < IVF_HEADER_SIZE || memcmp (data, "DKIF", 4))
+    return NULL;
+
+  frames = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+  offset = GST_READ_UINT16_LE (data + 6);
+  while (offset + IVF_FRAME_HEADER_SIZE <= size) {
+    guint32 frame_size = GST_READ_UINT32_LE (data + offset);
+
+    offset += IVF_FRAME_HEADER_SIZE;
+    if (frame_size > size - offset)
+      break;
+
+    g_ptr_array_add (frames, g_bytes_new (data + offset, frame_size));
+    offset += frame_size;
+  }
+
+  return frames;
+}
+
+static GBytes *
+read_file (const gchar * filename)
+{
+  GError *err = NULL;
+  gchar *contents;
+  gsize size;
+
+  if (!g_file_get_contents (filename, &contents, &size, &err)) {
+    g_printerr ("Could not read %s: %s\n", filename, err->message);
+    g_clear_error (&err);
+    return NULL;
+  }
+
+  return g_bytes_new_take (contents, size);
+}
+
+/* Scales @repeat for a bitstream of @size bytes, so that the small built-in
+ * streams are parsed more often than long recordings */
+static guint
+scale_repeat (guint repeat, gsize size)
+{
+  return MAX (1, repeat * (guint64) 4096 / MAX (size, 4096));
+}
+
+static gboolean
+run_byte_stream (const gchar * filename, const guint8 * builtin,
+    gsize builtin_size, guint repeat, void (*bench) (const guint8 *, gsize,
+        guint))
+{
+  GBytes *bytes = NULL;
+  const guint8 *data = builtin;
+  gsize size = builtin_size;
+
+  if (filename) {
+    if (!(bytes = read_file (filename)))
+      return FALSE;
+    data = g_bytes_get_data (bytes, &size);
+  }
+
+  bench (data, size, scale_repeat (repeat, size));
+
+  if (bytes)
+    g_bytes_unref (bytes);
+
+  return TRUE;
+}
+
+static gboolean
+run_av1 (const gchar * filename, guint repeat)
+{
+  GBytes *bytes;
+  GPtrArray *frames;
+  GByteArray *stream;
+  const guint8 *data;
+  gsize size;
+  guint i;
+
+  if (!filename) {
+    bench_av1 (stream_no_annexb_av1, stream_no_annexb_av1_len, FALSE,
+        scale_repeat (repeat, stream_no_annexb_av1_len));
+    bench_av1 (stream_annexb_av1, sizeof (stream_annexb_av1), TRUE,
+        scale_repeat (repeat, sizeof (stream_annexb_av1)));
+    return TRUE;
+  }
+
+  if (!(bytes = read_file (filename)))
+    return FALSE;
+
+  data = g_bytes_get_data (bytes, &size);
+  frames = read_ivf_frames (data, size);
+  if (!frames) {
+    bench_av1 (data, size, FALSE, scale_repeat (repeat, size));
+    g_bytes_unref (bytes);
+    return TRUE;
+  }
+
+  /* IVF holds one temporal unit per frame, join them to an OBU stream */
+  stream = g_byte_array_new ();
+  for (i = 0; i < frames->len; i++) {
+    gsize frame_size;
+    const guint8 *frame_data = g_bytes_get_data (g_ptr_array_index (frames,
+            i), &frame_size);
+
+    g_byte_array_append (stream, frame_data, frame_size);
+  }
+
+  bench_av1 (stream->data, stream->len, FALSE, scale_repeat (repeat,
+          stream->len));
+
+  g_byte_array_unref (stream);
+  g_ptr_array_unref (frames);
+  g_bytes_unref (bytes);
+
+  return TRUE;
+}
+
+static gboolean
+run_vp9 (const gchar * filename, guint repeat)
+{
+  GPtrArray *frames;
+  gsize total = 0;
+  guint i;
+
+  if (filename) {
+    GBytes *bytes;
+    const guint8 *data;
+    gsize size;
+
+    if (!(bytes = read_file (filename)))
+      return FALSE;
+
+    data = g_bytes_get_data (bytes, &size);
+    frames = read_ivf_frames (data, size);
+    g_bytes_unref (bytes);
+
+    if (!frames) {
+      g_printerr ("%s is not an IVF file\n", filename);
+      return FALSE;
+    }
+  } else {
+    frames = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+    g_ptr_array_add (frames, g_bytes_new_static (profile_0_frame0,
+            profile_0_frame0_len));
+    g_ptr_array_add (frames, g_bytes_new_static (profile_0_frame1,
+            profile_0_frame1_len));
+    g_ptr_array_add (frames, g_bytes_new_static (profile_0_frame2,
+            profile_0_frame2_len));
+  }
+
+  for (i = 0; i < frames->len; i++)
+    total += g_bytes_get_size (g_ptr_array_index (frames, i));
+
+  bench_vp9 (frames, scale_repeat (repeat, total));
+  g_ptr_array_unref (frames);
+
+  return TRUE;
+}
+
+int
+main (int argc, char **argv)
+{
+  guint repeat = DEFAULT_REPEAT;
+  gchar *h264 = NULL, *h265 = NULL, *av1 = NULL, *vp9 = NULL, *mpeg2 = NULL;
+  GOptionEntry options[] = {
+    {"repeat", 'r', 0, G_OPTION_ARG_INT, &repeat,
+        "Number of times a 4 KiB bitstream is parsed, "
+          "larger bitstreams are parsed fewer times", "N"},
+    {"h264", 0, 0, G_OPTION_ARG_FILENAME, &h264,
+        "H.264 byte-stream to parse instead of the built-in one", "FILE"},
+    {"h265", 0, 0, G_OPTION_ARG_FILENAME, &h265,
+        "H.265 byte-stream to parse instead of the built-in one", "FILE"},
+    {"av1", 0, 0, G_OPTION_ARG_FILENAME, &av1,
+        "AV1 OBU stream or IVF file to parse instead of the built-in one",
+        "FILE"},
+    {"vp9", 0, 0, G_OPTION_ARG_FILENAME, &vp9,
+        "VP9 IVF file to parse instead of the built-in one", "FILE"},
+    {"mpeg2", 0, 0, G_OPTION_ARG_FILENAME, &mpeg2,
+        "MPEG-2 video elementary stream to parse instead of the built-in one",
+        "FILE"},
+    {NULL}
+  };
+  GOptionContext *ctx;
+  GError *err = NULL;
+  gboolean ok = TRUE;
+
+  ctx = g_option_context_new ("- codec parsers microbenchmark");
+  g_option_context_add_main_entries (ctx, options, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_clear_error (&err);
+    g_option_context_free (ctx);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  bench_calibrate ();
+  g_print ("clock overhead: %" G_GUINT64_FORMAT " ns\n\n", clock_overhead);
+  bench_print_header ();
+
+  ok &= run_byte_stream (h264, h264_stream, sizeof (h264_stream), repeat,
+      bench_h264);
+  ok &= run_byte_stream (h265, h265_stream, sizeof (h265_stream), repeat,
+      bench_h265);
+  ok &= run_av1 (av1, repeat);
+  ok &= run_vp9 (vp9, repeat);
+  ok &= run_byte_stream (mpeg2, mpeg2_stream, sizeof (mpeg2_stream), repeat,
+      bench_mpeg2);
+
+  g_free (h264);
+  g_free (h265);
+  g_free (av1);
+  g_free (vp9);
+  g_free (mpeg2);
+
+  return ok ? 0 : 1;
+}
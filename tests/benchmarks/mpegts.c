@@ -0,0 +1,720 @@
+/* GStreamer
+ *
+ * mpegts.c: throughput benchmark for the MPEG-TS demuxers and muxers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Runs mpegtsmux and atscmux over synthetic multi-program elementary
+ * streams, then feeds the muxed output (or a recorded file given with
+ * --input) through tsparse and tsdemux.
+ *
+ * For every run it reports the number of 188 byte packets per second
+ * together with the number of buffers and memories created, the bytes
+ * allocated and the bytes copied, each divided by the packet count.
+ *
+ * Memories are allocated from a counting allocator installed as the
+ * default allocator, and gst_memory_copy() on them is accounted as
+ * copied bytes. Copies made with memcpy() into freshly allocated memory
+ * (adapters, buffer merges) show up as allocated bytes instead. Buffer
+ * and memory counts come from the mini-object-created tracer hook, so
+ * they are only available when GStreamer was built with tracer hooks.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+
+#define PACKET_SIZE 188
+#define FEED_CHUNK_PACKETS 1024
+
+#define DEFAULT_PROGRAMS 4
+#define DEFAULT_FRAMES 2000
+#define DEFAULT_FRAME_SIZE 16384
+#define DEFAULT_REPEAT 1
+
+/* counters */
+
+G_LOCK_DEFINE_STATIC (counters);
+
+typedef struct
+{
+  guint64 buffers;
+  guint64 memories;
+  guint64 allocations;
+  guint64 bytes_allocated;
+  guint64 bytes_copied;
+  guint64 inputs;
+} BenchCounters;
+
+static BenchCounters counters;
+
+static void
+counters_reset (void)
+{
+  G_LOCK (counters);
+  memset (&counters, 0, sizeof (counters));
+  G_UNLOCK (counters);
+}
+
+static void
+counters_get (BenchCounters * out)
+{
+  G_LOCK (counters);
+  *out = counters;
+  G_UNLOCK (counters);
+}
+
+/* counting allocator */
+
+typedef struct
+{
+  GstMemory mem;
+  guint8 *raw;
+  guint8 *data;
+} BenchMemory;
+
+typedef struct
+{
+  GstAllocator parent;
+} BenchAllocator;
+
+typedef struct
+{
+  GstAllocatorClass parent_class;
+} BenchAllocatorClass;
+
+static GType bench_allocator_get_type (void);
+G_DEFINE_TYPE (BenchAllocator, bench_allocator, GST_TYPE_ALLOCATOR);
+
+static GstMemory *
+bench_memory_new (GstAllocator * allocator, GstMemory * parent,
+    GstMemoryFlags flags, guint8 * raw, guint8 * data, gsize maxsize,
+    gsize align, gsize offset, gsize size)
+{
+  BenchMemory *mem = g_slice_new (BenchMemory);
+
+  gst_memory_init (GST_MEMORY_CAST (mem), flags, allocator, parent, maxsize,
+      align, offset, size);
+  mem->raw = raw;
+  mem->data = data;
+
+  return GST_MEMORY_CAST (mem);
+}
+
+static GstMemory *
+bench_allocator_alloc (GstAllocator * allocator, gsize size,
+    GstAllocationParams * params)
+{
+  gsize maxsize = size + params->prefix + params->padding;
+  gsize align = params->align | gst_memory_alignment;
+  guint8 *raw, *data;
+
+  raw = g_malloc (maxsize + align);
+  data = (guint8 *) (((guintptr) raw + align) & ~(guintptr) align);
+
+  if (params->prefix && (params->flags & GST_MEMORY_FLAG_ZERO_PREFIXED))
+    memset (data, 0, params->prefix);
+  if (params->padding && (params->flags & GST_MEMORY_FLAG_ZERO_PADDED))
+    memset (data + params->prefix + size, 0, params->padding);
+
+  G_LOCK (counters);
+  counters.allocations++;
+  counters.bytes_allocated += size;
+  G_UNLOCK (counters);
+
+  return bench_memory_new (allocator, NULL, params->flags, raw, data, maxsize,
+      align, params->prefix, size);
+}
+
+static void
+bench_allocator_free (GstAllocator * allocator, GstMemory * mem)
+{
+  BenchMemory *bmem = (BenchMemory *) mem;
+
+  if (mem->parent == NULL)
+    g_free (bmem->raw);
+  g_slice_free (BenchMemory, bmem);
+}
+
+static gpointer
+bench_memory_map (GstMemory * mem, gsize maxsize, GstMapFlags flags)
+{
+  return ((BenchMemory *) mem)->data;
+}
+
+static void
+bench_memory_unmap (GstMemory * mem)
+{
+}
+
+static GstMemory *
+bench_memory_share (GstMemory * mem, gssize offset, gssize size)
+{
+  BenchMemory *bmem = (BenchMemory *) mem;
+  GstMemory *parent;
+
+  if (size == -1)
+    size = mem->size - offset;
+
+  if ((parent = mem->parent) == NULL)
+    parent = mem;
+
+  return bench_memory_new (mem->allocator, parent,
+      GST_MINI_OBJECT_FLAGS (parent) | GST_MINI_OBJECT_FLAG_LOCK_READONLY,
+      bmem->raw, bmem->data, mem->maxsize, mem->align, mem->offset + offset,
+      size);
+}
+
+static GstMemory *
+bench_memory_copy (GstMemory * mem, gssize offset, gssize size)
+{
+  BenchMemory *bmem = (BenchMemory *) mem;
+  GstAllocationParams params = { 0, mem->align, 0, 0, };
+  GstMemory *copy;
+
+  if (size == -1)
+    size = mem->size > offset ? mem->size - offset : 0;
+
+  copy = bench_allocator_alloc (mem->allocator, size, &params);
+  memcpy (((BenchMemory *) copy)->data, bmem->data + mem->offset + offset,
+      size);
+
+  G_LOCK (counters);
+  counters.bytes_copied += size;
+  G_UNLOCK (counters);
+
+  return copy;
+}
+
+static gboolean
+bench_memory_is_span (GstMemory * mem1, GstMemory * mem2, gsize * offset)
+{
+  BenchMemory *bmem1 = (BenchMemory *) mem1;
+  BenchMemory *bmem2 = (BenchMemory *) mem2;
+
+  if (offset)
+    *offset = mem1->offset - mem1->parent->offset;
+
+  return bmem1->data + mem1->offset + mem1->size ==
+      bmem2->data + mem2->offset;
+}
+
+static void
+bench_allocator_class_init (BenchAllocatorClass * klass)
+{
+  GstAllocatorClass *allocator_class = GST_ALLOCATOR_CLASS (klass);
+
+  allocator_class->alloc = bench_allocator_alloc;
+  allocator_class->free = bench_allocator_free;
+}
+
+static void
+bench_allocator_init (BenchAllocator * self)
+{
+  GstAllocator *allocator = GST_ALLOCATOR_CAST (self);
+
+  allocator->mem_type = "BenchMemory";
+  allocator->mem_map = bench_memory_map;
+  allocator->mem_unmap = bench_memory_unmap;
+  allocator->mem_share = bench_memory_share;
+  allocator->mem_copy = bench_memory_copy;
+  allocator->mem_is_span = bench_memory_is_span;
+}
+
+/* mini object tracer hook */
+
+#ifndef GST_DISABLE_GST_TRACER_HOOKS
+typedef struct
+{
+  GstTracer parent;
+} BenchTracer;
+
+typedef struct
+{
+  GstTracerClass parent_class;
+} BenchTracerClass;
+
+static GType bench_tracer_get_type (void);
+G_DEFINE_TYPE (BenchTracer, bench_tracer, GST_TYPE_TRACER);
+
+static void
+bench_tracer_mini_object_created (GstTracer * tracer, GstClockTime ts,
+    GstMiniObject * object)
+{
+  if (GST_IS_BUFFER (object)) {
+    G_LOCK (counters);
+    counters.buffers++;
+    G_UNLOCK (counters);
+  } else if (GST_IS_MINI_OBJECT_TYPE (object, GST_TYPE_MEMORY)) {
+    G_LOCK (counters);
+    counters.memories++;
+    G_UNLOCK (counters);
+  }
+}
+
+static void
+bench_tracer_class_init (BenchTracerClass * klass)
+{
+}
+
+static void
+bench_tracer_init (BenchTracer * self)
+{
+  gst_tracing_register_hook (GST_TRACER (self), "mini-object-created",
+      G_CALLBACK (bench_tracer_mini_object_created));
+}
+#endif
+
+/* results */
+
+typedef struct
+{
+  const gchar *element;
+  const gchar *input;
+  guint64 packets;
+  GstClockTime elapsed;
+  BenchCounters counters;
+} BenchResult;
+
+static void
+print_header (void)
+{
+  g_print ("%-10s %-10s %10s %9s %12s %8s %8s %10s %10s %10s\n", "element",
+      "input", "packets", "time(ms)", "packets/s", "bufs/pkt", "mems/pkt",
+      "allocs/pkt", "bytes/pkt", "copied/pkt");
+}
+
+static void
+print_result (const BenchResult * res)
+{
+  gdouble secs = (gdouble) res->elapsed / GST_SECOND;
+  gdouble packets = MAX (res->packets, 1);
+
+  g_print ("%-10s %-10s %10" G_GUINT64_FORMAT " %9.1f %12.0f %8.3f %8.3f "
+      "%10.3f %10.1f %10.1f\n", res->element, res->input, res->packets,
+      secs * 1000, secs > 0 ? res->packets / secs : 0.0,
+      res->counters.buffers / packets, res->counters.memories / packets,
+      res->counters.allocations / packets,
+      res->counters.bytes_allocated / packets,
+      res->counters.bytes_copied / packets);
+}
+
+static gboolean
+run_pipeline (GstElement * pipeline, BenchResult * res)
+{
+  GstBus *bus;
+  GstMessage *msg;
+  GstClockTime start;
+  gboolean ret = TRUE;
+
+  bus = gst_pipeline_get_bus (GST_PIPELINE (pipeline));
+
+  counters_reset ();
+  start = gst_util_get_timestamp ();
+
+  if (gst_element_set_state (pipeline,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
+    g_printerr ("%s: failed to start pipeline\n", res->element);
+    ret = FALSE;
+    goto done;
+  }
+
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+
+  res->elapsed = gst_util_get_timestamp () - start;
+  counters_get (&res->counters);
+
+  /* Don't account for the wrapped input buffers pushed by the appsrcs */
+  res->counters.buffers -= MIN (res->counters.buffers, res->counters.inputs);
+  res->counters.memories -= MIN (res->counters.memories, res->counters.inputs);
+
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+    GError *err = NULL;
+    gchar *dbg = NULL;
+
+    gst_message_parse_error (msg, &err, &dbg);
+    g_printerr ("%s: %s\n%s\n", res->element, err->message,
+        GST_STR_NULL (dbg));
+    g_clear_error (&err);
+    g_free (dbg);
+    ret = FALSE;
+  }
+  gst_message_unref (msg);
+
+done:
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+
+  return ret;
+}
+
+/* output */
+
+typedef struct
+{
+  guint64 bytes;
+  GByteArray *capture;
+} SinkState;
+
+static void
+sink_handoff (GstElement * sink, GstBuffer * buf, GstPad * pad,
+    SinkState * state)
+{
+  gsize size = gst_buffer_get_size (buf);
+
+  G_LOCK (counters);
+  state->bytes += size;
+  G_UNLOCK (counters);
+
+  /* Extract rather than map, mapping would merge the packet memories */
+  if (state->capture) {
+    guint len = state->capture->len;
+
+    g_byte_array_set_size (state->capture, len + size);
+    gst_buffer_extract (buf, 0, state->capture->data + len, size);
+  }
+}
+
+static GstElement *
+make_sink (SinkState * state)
+{
+  GstElement *sink = gst_element_factory_make ("fakesink", NULL);
+
+  g_object_set (sink, "sync", FALSE, "async", FALSE, "signal-handoffs", TRUE,
+      NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (sink_handoff), state);
+
+  return sink;
+}
+
+/* muxers */
+
+typedef struct
+{
+  const guint8 *payload;
+  gsize frame_size;
+  guint frames_left;
+  GstClockTime ts;
+} EsFeed;
+
+static void
+es_need_data (GstAppSrc * src, guint length, gpointer user_data)
+{
+  EsFeed *feed = user_data;
+  GstBuffer *buf;
+
+  if (feed->frames_left == 0) {
+    gst_app_src_end_of_stream (src);
+    return;
+  }
+
+  buf = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+      (gpointer) feed->payload, feed->frame_size, 0, feed->frame_size, NULL,
+      NULL);
+  GST_BUFFER_PTS (buf) = GST_BUFFER_DTS (buf) = feed->ts;
+  GST_BUFFER_DURATION (buf) = GST_SECOND / 25;
+  feed->ts += GST_SECOND / 25;
+  feed->frames_left--;
+
+  G_LOCK (counters);
+  counters.inputs++;
+  G_UNLOCK (counters);
+
+  gst_app_src_push_buffer (src, buf);
+}
+
+static gboolean
+bench_mux (const gchar * factory, guint n_programs, guint n_frames,
+    const guint8 * payload, gsize frame_size, GByteArray * capture)
+{
+  GstAppSrcCallbacks callbacks = { es_need_data, NULL, NULL, };
+  BenchResult res = { factory, "synthetic", };
+  SinkState sink_state = { 0, capture, };
+  GstElement *pipeline, *mux, *sink;
+  GstStructure *prog_map;
+  GstCaps *caps;
+  EsFeed *feeds;
+  gboolean ret;
+  guint i;
+
+  mux = gst_element_factory_make (factory, NULL);
+  if (mux == NULL) {
+    g_printerr ("%s: element not available, skipping\n", factory);
+    return FALSE;
+  }
+
+  pipeline = gst_pipeline_new (NULL);
+  sink = make_sink (&sink_state);
+  gst_bin_add_many (GST_BIN (pipeline), mux, sink, NULL);
+  gst_element_link (mux, sink);
+
+  caps = gst_caps_from_string ("video/mpeg, mpegversion=(int)2, "
+      "systemstream=(boolean)false, parsed=(boolean)true, "
+      "width=(int)1920, height=(int)1080, framerate=(fraction)25/1");
+
+  prog_map = gst_structure_new_empty ("program_map");
+  feeds = g_new0 (EsFeed, n_programs);
+
+  for (i = 0; i < n_programs; i++) {
+    GstElement *src = gst_element_factory_make ("appsrc", NULL);
+    gchar *pad_name = g_strdup_printf ("sink_%u", 0x41 + i);
+
+    gst_structure_set (prog_map, pad_name, G_TYPE_INT, i + 1, NULL);
+
+    feeds[i].payload = payload;
+    feeds[i].frame_size = frame_size;
+    feeds[i].frames_left = n_frames;
+
+    g_object_set (src, "caps", caps, "format", GST_FORMAT_TIME, NULL);
+    gst_app_src_set_callbacks (GST_APP_SRC (src), &callbacks, &feeds[i],
+        NULL);
+
+    gst_bin_add (GST_BIN (pipeline), src);
+    if (!gst_element_link_pads (src, "src", mux, pad_name))
+      g_printerr ("%s: failed to link %s\n", factory, pad_name);
+
+    g_free (pad_name);
+  }
+
+  g_object_set (mux, "prog-map", prog_map, NULL);
+  gst_structure_free (prog_map);
+  gst_caps_unref (caps);
+
+  ret = run_pipeline (pipeline, &res);
+  res.packets = sink_state.bytes / PACKET_SIZE;
+
+  if (ret)
+    print_result (&res);
+
+  gst_object_unref (pipeline);
+  g_free (feeds);
+
+  return ret;
+}
+
+/* demuxers */
+
+typedef struct
+{
+  const guint8 *data;
+  gsize size;
+  gsize offset;
+  guint repeat;
+} TsFeed;
+
+static void
+ts_need_data (GstAppSrc * src, guint length, gpointer user_data)
+{
+  TsFeed *feed = user_data;
+  GstBuffer *buf;
+  gsize chunk;
+
+  if (feed->offset == feed->size) {
+    if (--feed->repeat == 0) {
+      gst_app_src_end_of_stream (src);
+      return;
+    }
+    feed->offset = 0;
+  }
+
+  chunk = MIN (feed->size - feed->offset, FEED_CHUNK_PACKETS * PACKET_SIZE);
+  buf = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+      (gpointer) feed->data, feed->size, feed->offset, chunk, NULL, NULL);
+  feed->offset += chunk;
+
+  G_LOCK (counters);
+  counters.inputs++;
+  G_UNLOCK (counters);
+
+  gst_app_src_push_buffer (src, buf);
+}
+
+static void
+demux_pad_added (GstElement * demux, GstPad * pad, SinkState * state)
+{
+  GstElement *pipeline = GST_ELEMENT (gst_element_get_parent (demux));
+  GstElement *sink = make_sink (state);
+  GstPad *sinkpad;
+
+  gst_bin_add (GST_BIN (pipeline), sink);
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_link (pad, sinkpad);
+  gst_object_unref (sinkpad);
+  gst_element_sync_state_with_parent (sink);
+
+  gst_object_unref (pipeline);
+}
+
+static gboolean
+bench_demux (const gchar * factory, const gchar * input, const guint8 * data,
+    gsize size, guint repeat)
+{
+  GstAppSrcCallbacks callbacks = { ts_need_data, NULL, NULL, };
+  BenchResult res = { factory, input, };
+  SinkState sink_state = { 0, NULL, };
+  TsFeed feed = { data, size, 0, repeat, };
+  GstElement *pipeline, *src, *demux;
+  GstPad *srcpad;
+  GstCaps *caps;
+  gboolean ret;
+
+  demux = gst_element_factory_make (factory, NULL);
+  if (demux == NULL) {
+    g_printerr ("%s: element not available, skipping\n", factory);
+    return FALSE;
+  }
+
+  pipeline = gst_pipeline_new (NULL);
+  src = gst_element_factory_make ("appsrc", NULL);
+  caps = gst_caps_from_string ("video/mpegts, systemstream=(boolean)true");
+  g_object_set (src, "caps", caps, "format", GST_FORMAT_BYTES, NULL);
+  gst_caps_unref (caps);
+  gst_app_src_set_callbacks (GST_APP_SRC (src), &callbacks, &feed, NULL);
+
+  gst_bin_add_many (GST_BIN (pipeline), src, demux, NULL);
+  gst_element_link (src, demux);
+
+  /* tsparse has an always src pad, tsdemux only exposes sometimes pads */
+  srcpad = gst_element_get_static_pad (demux, "src");
+  if (srcpad != NULL) {
+    GstElement *sink = make_sink (&sink_state);
+
+    gst_object_unref (srcpad);
+    gst_bin_add (GST_BIN (pipeline), sink);
+    gst_element_link (demux, sink);
+  } else {
+    g_signal_connect (demux, "pad-added", G_CALLBACK (demux_pad_added),
+        &sink_state);
+  }
+
+  ret = run_pipeline (pipeline, &res);
+  res.packets = (size / PACKET_SIZE) * repeat;
+
+  if (ret)
+    print_result (&res);
+
+  gst_object_unref (pipeline);
+
+  return ret;
+}
+
+/* main */
+
+int
+main (int argc, char **argv)
+{
+  static const gchar *muxers[] = { "mpegtsmux", "atscmux" };
+  static const gchar *demuxers[] = { "tsparse", "tsdemux" };
+  guint n_programs = DEFAULT_PROGRAMS;
+  guint n_frames = DEFAULT_FRAMES;
+  guint frame_size = DEFAULT_FRAME_SIZE;
+  guint repeat = DEFAULT_REPEAT;
+  gchar *input = NULL;
+  GOptionEntry options[] = {
+    {"programs", 'p', 0, G_OPTION_ARG_INT, &n_programs,
+        "Number of programs in the synthetic stream", "N"},
+    {"frames", 'n', 0, G_OPTION_ARG_INT, &n_frames,
+        "Number of frames per program", "N"},
+    {"frame-size", 's', 0, G_OPTION_ARG_INT, &frame_size,
+        "Size of each elementary stream frame in bytes", "BYTES"},
+    {"input", 'i', 0, G_OPTION_ARG_FILENAME, &input,
+        "Recorded transport stream to run the demuxers on", "FILE"},
+    {"repeat", 'r', 0, G_OPTION_ARG_INT, &repeat,
+        "Number of times each transport stream is fed to the demuxers", "N"},
+    {NULL}
+  };
+  GOptionContext *ctx;
+  GError *err = NULL;
+  GByteArray *synthetic;
+  guint8 *payload;
+  gboolean ok = TRUE;
+  guint i;
+
+  ctx = g_option_context_new ("- MPEG-TS mux/demux throughput benchmark");
+  g_option_context_add_main_entries (ctx, options, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_clear_error (&err);
+    g_option_context_free (ctx);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  n_programs = CLAMP (n_programs, 1, 64);
+  n_frames = MAX (n_frames, 1);
+  frame_size = MAX (frame_size, 1);
+  repeat = MAX (repeat, 1);
+
+  gst_allocator_set_default (g_object_new (bench_allocator_get_type (),
+          NULL));
+#ifndef GST_DISABLE_GST_TRACER_HOOKS
+  g_object_new (bench_tracer_get_type (), NULL);
+#endif
+
+  /* Random payload without start codes, shared by all the frames */
+  payload = g_malloc (frame_size);
+  for (i = 0; i < frame_size; i++)
+    payload[i] = g_random_int_range (0x01, 0x100);
+
+  synthetic = g_byte_array_new ();
+
+  g_print ("%u programs, %u frames of %u bytes per program\n\n", n_programs,
+      n_frames, frame_size);
+  print_header ();
+
+  for (i = 0; i < G_N_ELEMENTS (muxers); i++) {
+    ok &= bench_mux (muxers[i], n_programs, n_frames, payload, frame_size,
+        i == 0 ? synthetic : NULL);
+  }
+
+  if (synthetic->len >= PACKET_SIZE) {
+    for (i = 0; i < G_N_ELEMENTS (demuxers); i++) {
+      ok &= bench_demux (demuxers[i], "synthetic", synthetic->data,
+          synthetic->len, repeat);
+    }
+  }
+
+  if (input) {
+    gchar *contents = NULL;
+    gsize length = 0;
+
+    if (g_file_get_contents (input, &contents, &length, &err)) {
+      for (i = 0; i < G_N_ELEMENTS (demuxers); i++) {
+        ok &= bench_demux (demuxers[i], "recorded", (guint8 *) contents,
+            length, repeat);
+      }
+      g_free (contents);
+    } else {
+      g_printerr ("Could not read %s: %s\n", input, err->message);
+      g_clear_error (&err);
+      ok = FALSE;
+    }
+  }
+
+  g_byte_array_unref (synthetic);
+  g_free (payload);
+  g_free (input);
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,1524 @@
+/* GStreamer
+ *
+ * pipelines.c: benchmark suite of reproducible cross-plugin pipelines
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Runs a fixed set of pipelines covering the MPEG-TS demuxer and muxer,
+ * the H.264 and H.265 parsers, HLS and DASH demuxing from an HTTP server
+ * in this process, webrtcbin, SRT and RIST over the loopback interface,
+ * the shm and inter transports and the CPU video filters.
+ *
+ * Every scenario is a gst-launch line, optionally with a second one for
+ * the receiving side, in which the element named "src" is where buffers
+ * enter the measured part and the fakesink named "sink" is where they
+ * leave it. When "src" is an appsrc, numbered buffers of a fixed size
+ * are pushed into it, paced for the network transports, so that they
+ * can be recognized on the other side. Otherwise buffers are matched by
+ * timestamp where it is preserved.
+ *
+ * For every run it reports the buffers and bytes per second arriving at
+ * the sink, for numbered buffers how many did not arrive, the median,
+ * 90th and 99th percentile and maximum latency between "src" and "sink",
+ * the user and system CPU time of the whole process (which includes the
+ * HTTP server and for the looped back transports both ends) and its peak
+ * resident set size. On Linux the peak is reset before every run, on
+ * other systems it is the peak of the process so far.
+ *
+ * The encoded streams the parsers and demuxers work on are made once
+ * from videotestsrc in a temporary directory before the first scenario
+ * that needs them. This requires an H.264 encoder (x264enc or
+ * openh264enc) and for H.265 x265enc, scenarios whose input could not be
+ * made are skipped.
+ *
+ * With --format=json one JSON object per run is printed on its own line
+ * instead of the table.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/rtp/gstrtpbuffer.h>
+#include <gst/webrtc/webrtc.h>
+
+#ifdef G_OS_UNIX
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#endif
+
+#define DEFAULT_ASSET_FRAMES 600
+
+/* a run ends once nothing was sent or received for this long */
+#define IDLE_TIMEOUT (2 * G_USEC_PER_SEC)
+#define CONNECT_TIMEOUT (10 * G_USEC_PER_SEC)
+
+#define RTP_SSRC 0x42454e43
+
+#define I420_SIZE(w, h) ((w) * (h) * 3 / 2)
+
+#define RAW_1080P "video/x-raw,format=I420,width=1920,height=1080," \
+    "framerate=30/1"
+
+#define TEST_SRC_1080P(format) "videotestsrc name=src num-buffers=@N@ ! " \
+    "video/x-raw,format=" format ",width=1920,height=1080,framerate=30/1 ! "
+
+#define TEST_SRC_720P "videotestsrc num-buffers=@FRAMES@ pattern=ball ! " \
+    "video/x-raw,format=I420,width=1280,height=720,framerate=30/1 ! "
+
+/* encoded inputs */
+
+enum
+{
+  ASSET_H264,
+  ASSET_H265,
+  ASSET_TS,
+  ASSET_HLS,
+  ASSET_DASH,
+  N_ASSETS
+};
+
+#define NEEDS(asset) (1 << (asset))
+
+typedef struct
+{
+  const gchar *name;
+  /* created below the temporary directory before running the launch line */
+  const gchar *subdir;
+  const gchar *launch;
+} BenchAsset;
+
+static const BenchAsset assets[N_ASSETS] = {
+  {"h264", NULL, TEST_SRC_720P "@H264ENC@ ! h264parse ! "
+        "video/x-h264,stream-format=byte-stream,alignment=au ! "
+        "filesink location=@DIR@/stream.h264"},
+  {"h265", NULL, TEST_SRC_720P "@H265ENC@ ! h265parse ! "
+        "video/x-h265,stream-format=byte-stream,alignment=au ! "
+        "filesink location=@DIR@/stream.h265"},
+  {"ts", NULL, TEST_SRC_720P "@H264ENC@ ! h264parse ! mpegtsmux ! "
+        "filesink location=@DIR@/stream.ts"},
+  {"hls", "hls", TEST_SRC_720P "@H264ENC@ ! h264parse ! mpegtsmux ! "
+        "hlssink location=@DIR@/hls/segment%05d.ts "
+        "playlist-location=@DIR@/hls/playlist.m3u8 target-duration=2 "
+        "max-files=0 playlist-length=0"},
+  {"dash", "dash", TEST_SRC_720P "@H264ENC@ ! h264parse ! "
+        "dashsink mpd-root-path=@DIR@/dash mpd-filename=stream.mpd "
+        "target-duration=2 muxer=ts"},
+};
+
+/* first available of each, the factory name comes first */
+static const gchar *h264_encoders[] = {
+  "x264enc speed-preset=ultrafast key-int-max=30",
+  "openh264enc gop-size=30",
+};
+
+static const gchar *h265_encoders[] = {
+  "x265enc speed-preset=ultrafast key-int-max=30",
+};
+
+/* scenarios */
+
+typedef enum
+{
+  /* buffers are only counted */
+  MATCH_NONE,
+  /* by the timestamp of the buffers leaving "src" */
+  MATCH_PTS,
+  /* by a sequence number in the first four bytes of the buffer */
+  MATCH_SEQ,
+  /* by a sequence number in the first four bytes of the RTP payload */
+  MATCH_RTP_SEQ,
+} BenchMatch;
+
+typedef struct _Bench Bench;
+typedef struct _BenchEnv BenchEnv;
+
+/* called once both pipelines are playing, before the first buffer is
+ * fed, may block until the pipelines are connected */
+typedef gboolean (*BenchStartFunc) (Bench * bench);
+
+typedef struct
+{
+  const gchar *name;
+  const gchar *launch;
+  /* receiving side, started after the sending one */
+  const gchar *consumer;
+  /* number of buffers, @N@ in the launch lines */
+  guint count;
+  BenchMatch match;
+  guint assets;
+  gboolean http;
+  /* consecutive free UDP ports starting at @PORT@ */
+  guint ports;
+  /* buffers fed to an appsrc "src" */
+  gsize feed_size;
+  GstClockTime feed_duration;
+  /* feed in real time rather than as fast as possible */
+  gboolean feed_paced;
+  BenchStartFunc start;
+} BenchScenario;
+
+static gboolean webrtc_start (Bench * bench);
+
+static const BenchScenario scenarios[] = {
+  /* MPEG-TS */
+  {"tsdemux", "filesrc location=@DIR@/stream.ts ! tsdemux ! "
+        "fakesink name=sink", NULL, 0, MATCH_NONE, NEEDS (ASSET_TS)},
+  {"ts-remux", "filesrc location=@DIR@/stream.ts ! tsdemux ! h264parse ! "
+        "mpegtsmux ! fakesink name=sink", NULL, 0, MATCH_NONE,
+      NEEDS (ASSET_TS)},
+
+  /* parsers */
+  {"h264parse", "filesrc location=@DIR@/stream.h264 ! "
+        "video/x-h264,stream-format=byte-stream ! h264parse ! "
+        "video/x-h264,stream-format=avc,alignment=au ! fakesink name=sink",
+      NULL, 0, MATCH_NONE, NEEDS (ASSET_H264)},
+  {"h265parse", "filesrc location=@DIR@/stream.h265 ! "
+        "video/x-h265,stream-format=byte-stream ! h265parse ! "
+        "video/x-h265,stream-format=hvc1,alignment=au ! fakesink name=sink",
+      NULL, 0, MATCH_NONE, NEEDS (ASSET_H265)},
+
+  /* adaptive streaming */
+  {"hlsdemux", "souphttpsrc location=@HTTP@/hls/playlist.m3u8 ! hlsdemux ! "
+        "fakesink name=sink", NULL, 0, MATCH_NONE, NEEDS (ASSET_HLS), TRUE},
+  {"dashdemux", "souphttpsrc location=@HTTP@/dash/stream.mpd ! dashdemux ! "
+        "fakesink name=sink", NULL, 0, MATCH_NONE, NEEDS (ASSET_DASH), TRUE},
+
+  /* network transports, 1316 bytes every millisecond */
+  {"webrtcbin", "appsrc name=src caps=\"application/x-rtp,media=video,"
+        "encoding-name=VP8,payload=96,clock-rate=90000\" ! "
+        "webrtcbin name=send",
+        "webrtcbin name=recv latency=0 fakesink name=sink",
+        2000, MATCH_RTP_SEQ, 0, FALSE, 0, 1316 - 12, GST_MSECOND, TRUE,
+      webrtc_start},
+  {"srt", "appsrc name=src caps=application/octet-stream ! "
+        "srtsink uri=\"srt://:@PORT@?mode=listener\" latency=20 sync=false",
+        "srtsrc uri=\"srt://127.0.0.1:@PORT@\" latency=20 "
+        "messages-per-buffer=1 ! fakesink name=sink",
+      2000, MATCH_SEQ, 0, FALSE, 1, 1316, GST_MSECOND, TRUE},
+  {"rist", "appsrc name=src caps=\"application/x-rtp,media=video,"
+        "encoding-name=MP2T,payload=96,clock-rate=90000\" ! "
+        "ristsink address=127.0.0.1 port=@PORT@ sender-buffer=100",
+        "ristsrc address=127.0.0.1 port=@PORT@ receiver-buffer=50 ! "
+        "fakesink name=sink",
+      2000, MATCH_RTP_SEQ, 0, FALSE, 2, 1316 - 12, GST_MSECOND, TRUE},
+
+  /* intra-host transports, raw 1080p */
+  {"shm", "appsrc name=src caps=\"" RAW_1080P "\" ! "
+        "shmsink socket-path=@DIR@/shm shm-size=67108864 "
+        "wait-for-connection=true sync=false",
+        "shmsrc socket-path=@DIR@/shm is-live=true ! fakesink name=sink",
+        300, MATCH_SEQ, 0, FALSE, 0, I420_SIZE (1920, 1080), GST_SECOND / 30,
+      FALSE},
+  {"inter", "appsrc name=src caps=\"" RAW_1080P "\" ! "
+        "intervideosink channel=bench-pipelines queue-size=4 sync=false",
+        "intervideosrc channel=bench-pipelines mode=fifo ! "
+        "fakesink name=sink",
+        150, MATCH_SEQ, 0, FALSE, 0, I420_SIZE (1920, 1080), GST_SECOND / 30,
+      TRUE},
+
+  /* CPU video filters, 1080p, against the bare source */
+  {"videotestsrc", TEST_SRC_1080P ("I420") "fakesink name=sink", NULL, 120,
+      MATCH_PTS},
+  {"coloreffects", TEST_SRC_1080P ("I420") "coloreffects preset=sepia ! "
+        "fakesink name=sink", NULL, 120, MATCH_PTS},
+  {"gaussianblur", TEST_SRC_1080P ("AYUV") "gaussianblur ! "
+        "fakesink name=sink", NULL, 120, MATCH_PTS},
+  {"burn", TEST_SRC_1080P ("@RGBX@") "burn ! fakesink name=sink", NULL, 120,
+      MATCH_PTS},
+  {"dilate", TEST_SRC_1080P ("@RGBX@") "dilate ! fakesink name=sink", NULL,
+      120, MATCH_PTS},
+  {"bulge", TEST_SRC_1080P ("BGRx") "bulge ! fakesink name=sink", NULL, 120,
+      MATCH_PTS},
+  {"scenechange", TEST_SRC_1080P ("I420") "scenechange ! "
+        "fakesink name=sink", NULL, 120, MATCH_PTS},
+  {"zebrastripe", TEST_SRC_1080P ("I420") "zebrastripe ! "
+        "fakesink name=sink", NULL, 120, MATCH_PTS},
+};
+
+/* environment shared by all runs */
+
+struct _BenchEnv
+{
+  gchar *dir;
+  const gchar *h264enc;
+  const gchar *h265enc;
+  guint asset_frames;
+  /* 0 if not made yet, 1 if made, -1 if that failed */
+  gint assets[N_ASSETS];
+
+  GSocketService *server;
+  gchar *http;
+};
+
+/* run state */
+
+typedef struct
+{
+  GstClockTime pts;
+  gint64 time;
+} BenchStamp;
+
+struct _Bench
+{
+  const BenchScenario *scenario;
+  guint count;
+  GstElement *producer;
+  GstElement *consumer;
+  GstElement *src;
+  GstElement *sink;
+
+  GstBufferPool *pool;
+  GThread *feeder;
+
+  GMutex lock;
+  GCond cond;
+  gboolean stop;
+  gboolean fed;
+  gboolean connected;
+  guint64 sent;
+  guint64 received;
+  guint64 bytes;
+  gint64 start;
+  gint64 last_progress;
+  gint64 last_receive;
+
+  /* MATCH_SEQ and MATCH_RTP_SEQ, indexed by sequence number */
+  gint64 *send_times;
+  guint32 last_seq;
+  /* MATCH_PTS, in the order they were sent */
+  GArray *stamps;
+  guint next_stamp;
+  GArray *latencies;
+};
+
+typedef struct
+{
+  const gchar *name;
+  guint64 sent;
+  guint64 received;
+  guint64 bytes;
+  gboolean numbered;
+  gint64 elapsed;
+  gint64 cpu_user;
+  gint64 cpu_system;
+  guint64 peak_rss;
+  GArray *latencies;
+} BenchResult;
+
+/* process statistics */
+
+static void
+cpu_times (gint64 * user, gint64 * system)
+{
+#ifdef G_OS_UNIX
+  struct rusage usage;
+
+  if (getrusage (RUSAGE_SELF, &usage) == 0) {
+    *user = (gint64) usage.ru_utime.tv_sec * G_USEC_PER_SEC +
+        usage.ru_utime.tv_usec;
+    *system = (gint64) usage.ru_stime.tv_sec * G_USEC_PER_SEC +
+        usage.ru_stime.tv_usec;
+    return;
+  }
+#endif
+
+  *user = *system = 0;
+}
+
+static void
+peak_rss_reset (void)
+{
+#ifdef __linux__
+  gint fd = open ("/proc/self/clear_refs", O_WRONLY);
+
+  if (fd >= 0) {
+    if (write (fd, "5", 1) < 0)
+      GST_WARNING ("Could not reset the peak resident set size");
+    close (fd);
+  }
+#endif
+}
+
+/* in kB */
+static guint64
+peak_rss (void)
+{
+#ifdef __linux__
+  gchar *status = NULL;
+
+  if (g_file_get_contents ("/proc/self/status", &status, NULL, NULL)) {
+    const gchar *hwm = strstr (status, "VmHWM:");
+    guint64 ret = 0;
+
+    if (hwm)
+      ret = g_ascii_strtoull (hwm + strlen ("VmHWM:"), NULL, 10);
+    g_free (status);
+
+    if (ret)
+      return ret;
+  }
+#endif
+
+#ifdef G_OS_UNIX
+  {
+    struct rusage usage;
+
+    if (getrusage (RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+      return usage.ru_maxrss / 1024;
+#else
+      return usage.ru_maxrss;
+#endif
+    }
+  }
+#endif
+
+  return 0;
+}
+
+/* launch lines */
+
+static gchar *
+expand_launch (BenchEnv * env, const gchar * launch, guint count, guint port)
+{
+  gchar **parts = g_strsplit (launch, "@", -1);
+  GString *str = g_string_new (NULL);
+  guint i;
+
+  /* every other part is a variable name */
+  for (i = 0; parts[i]; i++) {
+    const gchar *var = parts[i];
+
+    if (i % 2 == 0 || parts[i + 1] == NULL) {
+      g_string_append (str, var);
+    } else if (strcmp (var, "DIR") == 0) {
+      g_string_append (str, env->dir);
+    } else if (strcmp (var, "HTTP") == 0) {
+      g_string_append (str, GST_STR_NULL (env->http));
+    } else if (strcmp (var, "N") == 0) {
+      g_string_append_printf (str, "%u", count);
+    } else if (strcmp (var, "FRAMES") == 0) {
+      g_string_append_printf (str, "%u", env->asset_frames);
+    } else if (strcmp (var, "PORT") == 0) {
+      g_string_append_printf (str, "%u", port);
+    } else if (strcmp (var, "H264ENC") == 0) {
+      g_string_append (str, GST_STR_NULL (env->h264enc));
+    } else if (strcmp (var, "H265ENC") == 0) {
+      g_string_append (str, GST_STR_NULL (env->h265enc));
+    } else if (strcmp (var, "RGBX") == 0) {
+      g_string_append (str, G_BYTE_ORDER == G_LITTLE_ENDIAN ? "BGRx" :
+          "xRGB");
+    } else {
+      g_string_append_printf (str, "@%s@", var);
+    }
+  }
+  g_strfreev (parts);
+
+  return g_string_free (str, FALSE);
+}
+
+/* Returns NULL without printing anything if an element is missing */
+static GstElement *
+parse_launch (BenchEnv * env, const gchar * what, const gchar * launch,
+    guint count, guint port, gboolean * missing)
+{
+  gchar *desc = expand_launch (env, launch, count, port);
+  GError *err = NULL;
+  GstElement *pipeline;
+
+  pipeline = gst_parse_launch_full (desc, NULL, GST_PARSE_FLAG_FATAL_ERRORS,
+      &err);
+  if (pipeline == NULL) {
+    if (g_error_matches (err, GST_PARSE_ERROR,
+            GST_PARSE_ERROR_NO_SUCH_ELEMENT))
+      *missing = TRUE;
+    else
+      g_printerr ("%s: could not create pipeline: %s\n", what, err->message);
+  } else if (!GST_IS_PIPELINE (pipeline)) {
+    GstElement *bin = gst_pipeline_new (NULL);
+
+    gst_bin_add (GST_BIN (bin), pipeline);
+    pipeline = bin;
+  }
+  g_clear_error (&err);
+  g_free (desc);
+
+  return pipeline;
+}
+
+static gboolean
+handle_error (GstMessage * msg, const gchar * what)
+{
+  GError *err = NULL;
+  gchar *dbg = NULL;
+
+  if (GST_MESSAGE_TYPE (msg) != GST_MESSAGE_ERROR)
+    return TRUE;
+
+  gst_message_parse_error (msg, &err, &dbg);
+  g_printerr ("%s: %s\n%s\n", what, err->message, GST_STR_NULL (dbg));
+  g_clear_error (&err);
+  g_free (dbg);
+
+  return FALSE;
+}
+
+static gboolean
+run_to_eos (GstElement * pipeline, const gchar * what)
+{
+  GstBus *bus = gst_pipeline_get_bus (GST_PIPELINE (pipeline));
+  gboolean ret = FALSE;
+  GstMessage *msg;
+
+  if (gst_element_set_state (pipeline,
+          GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE) {
+    msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+        GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+    ret = handle_error (msg, what);
+    gst_message_unref (msg);
+  } else {
+    g_printerr ("%s: failed to start pipeline\n", what);
+  }
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+
+  return ret;
+}
+
+static const gchar *
+find_encoder (const gchar ** candidates, guint n_candidates)
+{
+  guint i;
+
+  for (i = 0; i < n_candidates; i++) {
+    gchar *name = g_strndup (candidates[i], strcspn (candidates[i], " "));
+    GstElementFactory *factory = gst_element_factory_find (name);
+
+    g_free (name);
+    if (factory) {
+      gst_object_unref (factory);
+      return candidates[i];
+    }
+  }
+
+  return NULL;
+}
+
+static gboolean
+prepare_asset (BenchEnv * env, guint asset)
+{
+  const BenchAsset *info = &assets[asset];
+  gboolean missing = FALSE;
+  GstElement *pipeline;
+
+  if (env->assets[asset])
+    return env->assets[asset] > 0;
+  env->assets[asset] = -1;
+
+  if ((strstr (info->launch, "@H264ENC@") && !env->h264enc) ||
+      (strstr (info->launch, "@H265ENC@") && !env->h265enc)) {
+    g_printerr ("%s: no encoder available\n", info->name);
+    return FALSE;
+  }
+
+  if (info->subdir) {
+    gchar *path = g_build_filename (env->dir, info->subdir, NULL);
+
+    g_mkdir_with_parents (path, 0755);
+    g_free (path);
+  }
+
+  pipeline = parse_launch (env, info->name, info->launch, 0, 0, &missing);
+  if (pipeline == NULL) {
+    if (missing)
+      g_printerr ("%s: elements not available\n", info->name);
+    return FALSE;
+  }
+
+  if (run_to_eos (pipeline, info->name))
+    env->assets[asset] = 1;
+  gst_object_unref (pipeline);
+
+  return env->assets[asset] > 0;
+}
+
+/* HTTP server for the adaptive streaming demuxers */
+
+static const gchar *
+http_content_type (const gchar * path)
+{
+  if (g_str_has_suffix (path, ".m3u8"))
+    return "application/vnd.apple.mpegurl";
+  if (g_str_has_suffix (path, ".mpd"))
+    return "application/dash+xml";
+  if (g_str_has_suffix (path, ".ts"))
+    return "video/mp2t";
+
+  return "application/octet-stream";
+}
+
+/* Serves the files below the temporary directory with GET and HEAD on
+ * persistent connections, anything else is answered with a 404 */
+static gboolean
+http_run (GThreadedSocketService * service, GSocketConnection * connection,
+    GObject * source_object, BenchEnv * env)
+{
+  GInputStream *base = g_io_stream_get_input_stream (G_IO_STREAM (connection));
+  GOutputStream *out = g_io_stream_get_output_stream (G_IO_STREAM (connection));
+  GDataInputStream *in = g_data_input_stream_new (base);
+  gchar *line;
+
+  g_data_input_stream_set_newline_type (in, G_DATA_STREAM_NEWLINE_TYPE_CR_LF);
+
+  while ((line = g_data_input_stream_read_line (in, NULL, NULL, NULL))) {
+    gchar **request = g_strsplit (line, " ", 3);
+    gchar *header, *path = NULL, *contents = NULL;
+    gboolean keep_alive = TRUE, ok;
+    gsize length = 0;
+    GString *reply;
+
+    while ((header = g_data_input_stream_read_line (in, NULL, NULL, NULL))) {
+      gboolean end = header[0] == '\0';
+
+      if (g_ascii_strncasecmp (header, "Connection:", 11) == 0 &&
+          strstr (header + 11, "close"))
+        keep_alive = FALSE;
+      g_free (header);
+
+      if (end)
+        break;
+    }
+
+    if (g_strv_length (request) == 3 && request[1][0] == '/' &&
+        !strstr (request[1], "..")) {
+      gchar *query = strchr (request[1], '?');
+
+      if (query)
+        *query = '\0';
+      path = g_build_filename (env->dir, request[1], NULL);
+      if (!g_file_get_contents (path, &contents, &length, NULL))
+        length = 0;
+    }
+
+    reply = g_string_new (NULL);
+    if (contents)
+      g_string_append_printf (reply, "HTTP/1.1 200 OK\r\n"
+          "Content-Type: %s\r\n", http_content_type (path));
+    else
+      g_string_append (reply, "HTTP/1.1 404 Not Found\r\n");
+    g_string_append_printf (reply, "Content-Length: %" G_GSIZE_FORMAT "\r\n"
+        "%s\r\n", length, keep_alive ? "" : "Connection: close\r\n");
+
+    ok = g_output_stream_write_all (out, reply->str, reply->len, NULL, NULL,
+        NULL);
+    if (ok && contents && g_strcmp0 (request[0], "HEAD") != 0)
+      ok = g_output_stream_write_all (out, contents, length, NULL, NULL,
+          NULL);
+
+    g_string_free (reply, TRUE);
+    g_free (contents);
+    g_free (path);
+    g_strfreev (request);
+    g_free (line);
+
+    if (!ok || !keep_alive)
+      break;
+  }
+
+  g_object_unref (in);
+
+  return TRUE;
+}
+
+static gboolean
+start_http_server (BenchEnv * env)
+{
+  GSocketAddress *addr, *effective = NULL;
+  GInetAddress *inet;
+  GError *err = NULL;
+
+  if (env->server)
+    return env->http != NULL;
+
+  env->server = g_threaded_socket_service_new (16);
+  inet = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+  addr = g_inet_socket_address_new (inet, 0);
+  g_object_unref (inet);
+
+  if (!g_socket_listener_add_address (G_SOCKET_LISTENER (env->server), addr,
+          G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_TCP, NULL, &effective,
+          &err)) {
+    g_printerr ("Could not start HTTP server: %s\n", err->message);
+    g_clear_error (&err);
+    g_object_unref (addr);
+    return FALSE;
+  }
+  g_object_unref (addr);
+
+  env->http = g_strdup_printf ("http://127.0.0.1:%u",
+      g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (effective)));
+  g_object_unref (effective);
+
+  g_signal_connect (env->server, "run", G_CALLBACK (http_run), env);
+  g_socket_service_start (env->server);
+
+  return TRUE;
+}
+
+/* Returns a free UDP port on the loopback interface, for two ports an even
+ * one followed by a free odd one */
+static guint
+find_udp_port (guint n_ports)
+{
+  guint attempt;
+
+  for (attempt = 0; attempt < 100; attempt++) {
+    GSocket *sockets[2] = { NULL, NULL };
+    gboolean ok = TRUE;
+    guint port = 0, i;
+
+    for (i = 0; i < n_ports && ok; i++) {
+      GInetAddress *inet = g_inet_address_new_loopback (G_SOCKET_FAMILY_IPV4);
+      GSocketAddress *addr = g_inet_socket_address_new (inet,
+          i == 0 ? 0 : port + i);
+
+      sockets[i] = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM,
+          G_SOCKET_PROTOCOL_UDP, NULL);
+      ok = sockets[i] && g_socket_bind (sockets[i], addr, FALSE, NULL);
+
+      if (ok && i == 0) {
+        GSocketAddress *local = g_socket_get_local_address (sockets[0], NULL);
+
+        ok = local != NULL;
+        if (local) {
+          port =
+              g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (local));
+          g_object_unref (local);
+        }
+        if (n_ports > 1 && (port & 1))
+          ok = FALSE;
+      }
+
+      g_object_unref (addr);
+      g_object_unref (inet);
+    }
+
+    for (i = 0; i < n_ports; i++) {
+      if (sockets[i])
+        g_object_unref (sockets[i]);
+    }
+
+    if (ok)
+      return port;
+  }
+
+  return 0;
+}
+
+/* webrtcbin loopback */
+
+static void
+webrtc_on_ice_candidate (GstElement * webrtc, guint mline,
+    const gchar * candidate, GstElement * other)
+{
+  g_signal_emit_by_name (other, "add-ice-candidate", mline, candidate);
+}
+
+static void
+webrtc_answer_created (GstPromise * promise, Bench * bench)
+{
+  GstElement *send = gst_bin_get_by_name (GST_BIN (bench->producer), "send");
+  GstElement *recv = gst_bin_get_by_name (GST_BIN (bench->consumer), "recv");
+  GstWebRTCSessionDescription *answer = NULL;
+  const GstStructure *reply = gst_promise_get_reply (promise);
+
+  if (reply)
+    gst_structure_get (reply, "answer", GST_TYPE_WEBRTC_SESSION_DESCRIPTION,
+        &answer, NULL);
+  gst_promise_unref (promise);
+
+  if (answer) {
+    g_signal_emit_by_name (recv, "set-local-description", answer, NULL);
+    g_signal_emit_by_name (send, "set-remote-description", answer, NULL);
+    gst_webrtc_session_description_free (answer);
+  }
+
+  gst_object_unref (send);
+  gst_object_unref (recv);
+}
+
+static void
+webrtc_offer_created (GstPromise * promise, Bench * bench)
+{
+  GstElement *send = gst_bin_get_by_name (GST_BIN (bench->producer), "send");
+  GstElement *recv = gst_bin_get_by_name (GST_BIN (bench->consumer), "recv");
+  GstWebRTCSessionDescription *offer = NULL;
+  const GstStructure *reply = gst_promise_get_reply (promise);
+
+  if (reply)
+    gst_structure_get (reply, "offer", GST_TYPE_WEBRTC_SESSION_DESCRIPTION,
+        &offer, NULL);
+  gst_promise_unref (promise);
+
+  if (offer) {
+    g_signal_emit_by_name (send, "set-local-description", offer, NULL);
+    g_signal_emit_by_name (recv, "set-remote-description", offer, NULL);
+    g_signal_emit_by_name (recv, "create-answer", NULL,
+        gst_promise_new_with_change_func ((GstPromiseChangeFunc)
+            webrtc_answer_created, bench, NULL));
+    gst_webrtc_session_description_free (offer);
+  }
+
+  gst_object_unref (send);
+  gst_object_unref (recv);
+}
+
+static void
+webrtc_connection_state_changed (GstElement * webrtc, GParamSpec * pspec,
+    Bench * bench)
+{
+  GstWebRTCPeerConnectionState state;
+
+  g_object_get (webrtc, "connection-state", &state, NULL);
+  if (state != GST_WEBRTC_PEER_CONNECTION_STATE_CONNECTED)
+    return;
+
+  g_mutex_lock (&bench->lock);
+  bench->connected = TRUE;
+  g_cond_broadcast (&bench->cond);
+  g_mutex_unlock (&bench->lock);
+}
+
+static void
+webrtc_pad_added (GstElement * webrtc, GstPad * pad, Bench * bench)
+{
+  GstPad *sinkpad;
+
+  if (GST_PAD_DIRECTION (pad) != GST_PAD_SRC)
+    return;
+
+  sinkpad = gst_element_get_static_pad (bench->sink, "sink");
+  if (!gst_pad_is_linked (sinkpad))
+    gst_pad_link (pad, sinkpad);
+  gst_object_unref (sinkpad);
+}
+
+static gboolean
+webrtc_start (Bench * bench)
+{
+  GstElement *send = gst_bin_get_by_name (GST_BIN (bench->producer), "send");
+  GstElement *recv = gst_bin_get_by_name (GST_BIN (bench->consumer), "recv");
+  gint64 deadline = g_get_monotonic_time () + CONNECT_TIMEOUT;
+  gboolean ret;
+
+  g_signal_connect (send, "on-ice-candidate",
+      G_CALLBACK (webrtc_on_ice_candidate), recv);
+  g_signal_connect (recv, "on-ice-candidate",
+      G_CALLBACK (webrtc_on_ice_candidate), send);
+  g_signal_connect (recv, "notify::connection-state",
+      G_CALLBACK (webrtc_connection_state_changed), bench);
+  g_signal_connect (recv, "pad-added", G_CALLBACK (webrtc_pad_added), bench);
+
+  g_signal_emit_by_name (send, "create-offer", NULL,
+      gst_promise_new_with_change_func ((GstPromiseChangeFunc)
+          webrtc_offer_created, bench, NULL));
+
+  g_mutex_lock (&bench->lock);
+  while (!bench->connected &&
+      g_cond_wait_until (&bench->cond, &bench->lock, deadline));
+  ret = bench->connected;
+  g_mutex_unlock (&bench->lock);
+
+  if (!ret)
+    g_printerr ("webrtcbin: peers did not connect\n");
+
+  gst_object_unref (send);
+  gst_object_unref (recv);
+
+  return ret;
+}
+
+/* feeding */
+
+static GstBuffer *
+make_feed_buffer (Bench * bench, guint32 seq, GstClockTime ts)
+{
+  const BenchScenario *scenario = bench->scenario;
+  GstBuffer *buf = NULL;
+
+  if (scenario->match == MATCH_RTP_SEQ) {
+    GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+    guint8 *payload;
+
+    buf = gst_rtp_buffer_new_allocate (scenario->feed_size, 0, 0);
+    gst_rtp_buffer_map (buf, GST_MAP_WRITE, &rtp);
+    gst_rtp_buffer_set_payload_type (&rtp, 96);
+    gst_rtp_buffer_set_seq (&rtp, seq & 0xffff);
+    gst_rtp_buffer_set_timestamp (&rtp,
+        gst_util_uint64_scale (ts, 90000, GST_SECOND));
+    gst_rtp_buffer_set_ssrc (&rtp, RTP_SSRC);
+    gst_rtp_buffer_set_marker (&rtp, TRUE);
+    payload = gst_rtp_buffer_get_payload (&rtp);
+    memset (payload, 0, scenario->feed_size);
+    GST_WRITE_UINT32_LE (payload, seq);
+    gst_rtp_buffer_unmap (&rtp);
+  } else if (gst_buffer_pool_acquire_buffer (bench->pool, &buf,
+          NULL) == GST_FLOW_OK) {
+    GstMapInfo map;
+
+    gst_buffer_map (buf, &map, GST_MAP_WRITE);
+    GST_WRITE_UINT32_LE (map.data, seq);
+    gst_buffer_unmap (buf, &map);
+  } else {
+    return NULL;
+  }
+
+  GST_BUFFER_PTS (buf) = GST_BUFFER_DTS (buf) = ts;
+  GST_BUFFER_DURATION (buf) = scenario->feed_duration;
+
+  return buf;
+}
+
+/* Pushes the numbered buffers with running time timestamps, sequence
+ * numbers start at 1 so that a zeroed frame never matches one */
+static gpointer
+feeder_thread (Bench * bench)
+{
+  const BenchScenario *scenario = bench->scenario;
+  GstClockTime ts = 0;
+  GstClock *clock;
+  gint64 start = g_get_monotonic_time ();
+  guint32 seq;
+
+  clock = gst_element_get_clock (bench->producer);
+  if (clock) {
+    ts = gst_clock_get_time (clock) -
+        gst_element_get_base_time (bench->producer);
+    gst_object_unref (clock);
+  }
+
+  for (seq = 1; seq <= bench->count; seq++) {
+    GstBuffer *buf;
+
+    if (scenario->feed_paced) {
+      gint64 wait = start + (gint64) ((seq - 1) * scenario->feed_duration /
+          GST_USECOND) - g_get_monotonic_time ();
+
+      if (wait > 0)
+        g_usleep (wait);
+    }
+
+    g_mutex_lock (&bench->lock);
+    if (bench->stop) {
+      g_mutex_unlock (&bench->lock);
+      break;
+    }
+    g_mutex_unlock (&bench->lock);
+
+    buf = make_feed_buffer (bench, seq, ts);
+    if (buf == NULL ||
+        gst_app_src_push_buffer (GST_APP_SRC (bench->src), buf) != GST_FLOW_OK)
+      break;
+    ts += scenario->feed_duration;
+  }
+  gst_app_src_end_of_stream (GST_APP_SRC (bench->src));
+
+  g_mutex_lock (&bench->lock);
+  bench->fed = TRUE;
+  g_cond_broadcast (&bench->cond);
+  g_mutex_unlock (&bench->lock);
+
+  return NULL;
+}
+
+/* measuring */
+
+static guint32
+buffer_seq (Bench * bench, GstBuffer * buf)
+{
+  guint8 data[4];
+
+  if (bench->scenario->match == MATCH_RTP_SEQ) {
+    GstRTPBuffer rtp = GST_RTP_BUFFER_INIT;
+    guint32 seq = 0;
+
+    if (!gst_rtp_buffer_map (buf, GST_MAP_READ, &rtp))
+      return 0;
+    if (gst_rtp_buffer_get_payload_len (&rtp) >= 4)
+      seq = GST_READ_UINT32_LE (gst_rtp_buffer_get_payload (&rtp));
+    gst_rtp_buffer_unmap (&rtp);
+
+    return seq;
+  }
+
+  if (gst_buffer_extract (buf, 0, data, 4) < 4)
+    return 0;
+
+  return GST_READ_UINT32_LE (data);
+}
+
+static GstPadProbeReturn
+src_probe (GstPad * pad, GstPadProbeInfo * info, Bench * bench)
+{
+  GstBuffer *buf = GST_PAD_PROBE_INFO_BUFFER (info);
+  gint64 now = g_get_monotonic_time ();
+  guint32 seq = 0;
+
+  if (bench->scenario->match == MATCH_SEQ ||
+      bench->scenario->match == MATCH_RTP_SEQ)
+    seq = buffer_seq (bench, buf);
+
+  g_mutex_lock (&bench->lock);
+  switch (bench->scenario->match) {
+    case MATCH_PTS:
+      if (GST_BUFFER_PTS_IS_VALID (buf)) {
+        BenchStamp stamp = { GST_BUFFER_PTS (buf), now };
+
+        g_array_append_val (bench->stamps, stamp);
+      }
+      break;
+    case MATCH_SEQ:
+    case MATCH_RTP_SEQ:
+      if (seq > 0 && seq <= bench->count)
+        bench->send_times[seq] = now;
+      break;
+    case MATCH_NONE:
+      break;
+  }
+  bench->sent++;
+  bench->last_progress = now;
+  g_mutex_unlock (&bench->lock);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+sink_handoff (GstElement * sink, GstBuffer * buf, GstPad * pad, Bench * bench)
+{
+  gint64 now = g_get_monotonic_time ();
+  gint64 sent = 0;
+  guint32 seq = 0;
+
+  /* repeated and black frames of intervideosrc */
+  if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_GAP))
+    return;
+
+  if (bench->scenario->match == MATCH_SEQ ||
+      bench->scenario->match == MATCH_RTP_SEQ) {
+    seq = buffer_seq (bench, buf);
+    if (seq == 0 || seq > bench->count)
+      return;
+  }
+
+  g_mutex_lock (&bench->lock);
+  switch (bench->scenario->match) {
+    case MATCH_PTS:{
+      GstClockTime pts = GST_BUFFER_PTS (buf);
+
+      while (bench->next_stamp < bench->stamps->len &&
+          g_array_index (bench->stamps, BenchStamp,
+              bench->next_stamp).pts < pts)
+        bench->next_stamp++;
+      if (GST_CLOCK_TIME_IS_VALID (pts) &&
+          bench->next_stamp < bench->stamps->len &&
+          g_array_index (bench->stamps, BenchStamp,
+              bench->next_stamp).pts == pts) {
+        sent = g_array_index (bench->stamps, BenchStamp,
+            bench->next_stamp).time;
+        bench->next_stamp++;
+      }
+      bench->received++;
+      break;
+    }
+    case MATCH_SEQ:
+    case MATCH_RTP_SEQ:
+      if (seq <= bench->last_seq) {
+        g_mutex_unlock (&bench->lock);
+        return;
+      }
+      sent = bench->send_times[seq];
+      bench->last_seq = seq;
+      bench->received++;
+      break;
+    case MATCH_NONE:
+      bench->received++;
+      break;
+  }
+
+  if (sent > 0) {
+    gint64 latency = now - sent;
+
+    g_array_append_val (bench->latencies, latency);
+  }
+  bench->bytes += gst_buffer_get_size (buf);
+  bench->last_progress = bench->last_receive = now;
+  g_cond_broadcast (&bench->cond);
+  g_mutex_unlock (&bench->lock);
+}
+
+/* Returns FALSE if the pipeline posted an error, sets done on EOS */
+static gboolean
+poll_bus (GstElement * pipeline, const gchar * what, gboolean * eos)
+{
+  GstBus *bus;
+  GstMessage *msg;
+  gboolean ret = TRUE;
+
+  if (pipeline == NULL)
+    return TRUE;
+
+  bus = gst_pipeline_get_bus (GST_PIPELINE (pipeline));
+  while ((msg = gst_bus_pop_filtered (bus,
+              GST_MESSAGE_EOS | GST_MESSAGE_ERROR))) {
+    if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS)
+      *eos = TRUE;
+    ret &= handle_error (msg, what);
+    gst_message_unref (msg);
+  }
+  gst_object_unref (bus);
+
+  return ret;
+}
+
+static gint
+compare_latency (gconstpointer a, gconstpointer b)
+{
+  gint64 la = *(const gint64 *) a, lb = *(const gint64 *) b;
+
+  return la < lb ? -1 : la > lb;
+}
+
+static GstElement *
+find_element (Bench * bench, const gchar * name)
+{
+  GstElement *element = gst_bin_get_by_name (GST_BIN (bench->producer), name);
+
+  if (element == NULL && bench->consumer)
+    element = gst_bin_get_by_name (GST_BIN (bench->consumer), name);
+
+  return element;
+}
+
+static gboolean
+bench_setup_feed (Bench * bench)
+{
+  GstStructure *config;
+  GstCaps *caps;
+  gboolean ret;
+
+  g_object_set (bench->src, "format", GST_FORMAT_TIME, "block", TRUE, NULL);
+  if (bench->scenario->match == MATCH_RTP_SEQ)
+    return TRUE;
+
+  g_object_get (bench->src, "caps", &caps, NULL);
+  bench->pool = gst_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (bench->pool);
+  gst_buffer_pool_config_set_params (config, caps, bench->scenario->feed_size,
+      4, 0);
+  ret = gst_buffer_pool_set_config (bench->pool, config) &&
+      gst_buffer_pool_set_active (bench->pool, TRUE);
+  gst_caps_replace (&caps, NULL);
+
+  return ret;
+}
+
+/* Returns FALSE if the scenario failed, res is only filled in if it ran */
+static gboolean
+bench_run (BenchEnv * env, const BenchScenario * scenario, guint count,
+    BenchResult * res)
+{
+  Bench bench = { scenario, count, };
+  gboolean missing = FALSE, ret = TRUE, eos = FALSE;
+  gint64 user_start, system_start, user, system;
+  gboolean feed;
+  guint port = 0, i;
+
+  for (i = 0; i < N_ASSETS; i++) {
+    if ((scenario->assets & NEEDS (i)) && !prepare_asset (env, i)) {
+      g_printerr ("%s: input not available, skipping\n", scenario->name);
+      return TRUE;
+    }
+  }
+  if (scenario->http && !start_http_server (env))
+    return TRUE;
+  if (scenario->ports && (port = find_udp_port (scenario->ports)) == 0) {
+    g_printerr ("%s: no free port, skipping\n", scenario->name);
+    return TRUE;
+  }
+
+  bench.producer = parse_launch (env, scenario->name, scenario->launch, count,
+      port, &missing);
+  if (bench.producer && scenario->consumer)
+    bench.consumer = parse_launch (env, scenario->name, scenario->consumer,
+        count, port, &missing);
+  if (bench.producer == NULL || (scenario->consumer && !bench.consumer)) {
+    if (missing)
+      g_printerr ("%s: elements not available, skipping\n", scenario->name);
+    else
+      ret = FALSE;
+    goto done;
+  }
+  g_mutex_init (&bench.lock);
+  g_cond_init (&bench.cond);
+  bench.latencies = g_array_new (FALSE, FALSE, sizeof (gint64));
+  bench.stamps = g_array_new (FALSE, FALSE, sizeof (BenchStamp));
+  bench.send_times = g_new0 (gint64, count + 1);
+
+  bench.src = find_element (&bench, "src");
+  bench.sink = find_element (&bench, "sink");
+  if (bench.sink == NULL) {
+    g_printerr ("%s: no element named sink\n", scenario->name);
+    ret = FALSE;
+    goto cleanup;
+  }
+  g_object_set (bench.sink, "sync", FALSE, "async", FALSE, "signal-handoffs",
+      TRUE, NULL);
+  g_signal_connect (bench.sink, "handoff", G_CALLBACK (sink_handoff), &bench);
+
+  feed = bench.src && GST_IS_APP_SRC (bench.src);
+
+  if (bench.src) {
+    GstPad *pad = gst_element_get_static_pad (bench.src, "src");
+
+    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER,
+        (GstPadProbeCallback) src_probe, &bench, NULL);
+    gst_object_unref (pad);
+
+    if (feed && !bench_setup_feed (&bench)) {
+      g_printerr ("%s: could not set up buffer pool\n", scenario->name);
+      ret = FALSE;
+      goto cleanup;
+    }
+  }
+
+  peak_rss_reset ();
+  cpu_times (&user_start, &system_start);
+  bench.start = bench.last_progress = g_get_monotonic_time ();
+
+  if (gst_element_set_state (bench.producer,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE ||
+      (bench.consumer && gst_element_set_state (bench.consumer,
+              GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)) {
+    g_printerr ("%s: failed to start pipeline\n", scenario->name);
+    poll_bus (bench.producer, scenario->name, &eos);
+    poll_bus (bench.consumer, scenario->name, &eos);
+    ret = FALSE;
+    goto cleanup;
+  }
+
+  if (feed) {
+    if (scenario->start && !scenario->start (&bench)) {
+      ret = FALSE;
+      goto cleanup;
+    }
+
+    /* connecting is not part of the measurement */
+    peak_rss_reset ();
+    cpu_times (&user_start, &system_start);
+    g_mutex_lock (&bench.lock);
+    bench.start = bench.last_progress = g_get_monotonic_time ();
+    g_mutex_unlock (&bench.lock);
+
+    bench.feeder = g_thread_new ("feeder", (GThreadFunc) feeder_thread,
+        &bench);
+  }
+
+  g_mutex_lock (&bench.lock);
+  while (TRUE) {
+    gint64 now = g_get_monotonic_time ();
+    gboolean producer_eos = FALSE, consumer_eos = FALSE;
+
+    if (bench.feeder && bench.fed && bench.received >= bench.sent)
+      break;
+    if (now - bench.last_progress > IDLE_TIMEOUT)
+      break;
+
+    g_mutex_unlock (&bench.lock);
+    ret &= poll_bus (bench.producer, scenario->name, &producer_eos);
+    ret &= poll_bus (bench.consumer, scenario->name, &consumer_eos);
+    g_mutex_lock (&bench.lock);
+
+    if (!ret || (bench.consumer ? consumer_eos : producer_eos))
+      break;
+
+    g_cond_wait_until (&bench.cond, &bench.lock,
+        now + 50 * G_TIME_SPAN_MILLISECOND);
+  }
+
+  if (ret) {
+    cpu_times (&user, &system);
+    res->name = scenario->name;
+    res->sent = bench.sent;
+    res->received = bench.received;
+    res->bytes = bench.bytes;
+    res->numbered = feed;
+    res->elapsed = MAX ((bench.last_receive ? bench.last_receive :
+            g_get_monotonic_time ()) - bench.start, 1);
+    res->cpu_user = user - user_start;
+    res->cpu_system = system - system_start;
+    res->peak_rss = peak_rss ();
+    res->latencies = g_array_ref (bench.latencies);
+    g_array_sort (res->latencies, compare_latency);
+  }
+  g_mutex_unlock (&bench.lock);
+
+cleanup:
+  /* going to NULL unblocks the feeder */
+  g_mutex_lock (&bench.lock);
+  bench.stop = TRUE;
+  g_mutex_unlock (&bench.lock);
+  gst_element_set_state (bench.producer, GST_STATE_NULL);
+  if (bench.consumer)
+    gst_element_set_state (bench.consumer, GST_STATE_NULL);
+  if (bench.feeder)
+    g_thread_join (bench.feeder);
+
+  if (bench.pool) {
+    gst_buffer_pool_set_active (bench.pool, FALSE);
+    gst_object_unref (bench.pool);
+  }
+  gst_clear_object (&bench.src);
+  gst_clear_object (&bench.sink);
+  g_array_unref (bench.latencies);
+  g_array_unref (bench.stamps);
+  g_free (bench.send_times);
+  g_cond_clear (&bench.cond);
+  g_mutex_clear (&bench.lock);
+
+done:
+  gst_clear_object (&bench.producer);
+  gst_clear_object (&bench.consumer);
+
+  return ret;
+}
+
+/* output */
+
+static gint64
+latency_at (const BenchResult * res, gdouble q)
+{
+  GArray *latencies = res->latencies;
+
+  if (latencies->len == 0)
+    return 0;
+
+  return g_array_index (latencies, gint64, (guint) ((latencies->len - 1) * q));
+}
+
+static void
+print_header (void)
+{
+  g_print ("%-13s %8s %10s %9s %7s %8s %8s %8s %8s %8s %8s %8s\n",
+      "scenario", "buffers", "buffers/s", "MB/s", "lost %", "p50 us",
+      "p90 us", "p99 us", "max us", "user ms", "sys ms", "RSS MB");
+}
+
+static void
+print_result (const BenchResult * res, gboolean json)
+{
+  gdouble secs = (gdouble) res->elapsed / G_USEC_PER_SEC;
+  gdouble lost = res->sent ?
+      100.0 - res->received * 100.0 / res->sent : 0.0;
+  gchar *val;
+
+  if (!json) {
+    gchar lat[4][16];
+    guint i;
+    static const gdouble q[] = { 0.5, 0.9, 0.99, 1.0 };
+
+    for (i = 0; i < G_N_ELEMENTS (q); i++) {
+      if (res->latencies->len)
+        g_snprintf (lat[i], sizeof (lat[i]), "%" G_GINT64_FORMAT,
+            latency_at (res, q[i]));
+      else
+        g_strlcpy (lat[i], "-", sizeof (lat[i]));
+    }
+
+    val = res->numbered ? g_strdup_printf ("%.2f", MAX (lost, 0.0)) :
+        g_strdup ("-");
+    g_print ("%-13s %8" G_GUINT64_FORMAT " %10.1f %9.1f %7s %8s %8s %8s %8s "
+        "%8.1f %8.1f %8.1f\n", res->name, res->received,
+        res->received / secs, res->bytes / secs / (1024 * 1024), val,
+        lat[0], lat[1], lat[2], lat[3], res->cpu_user / 1000.0,
+        res->cpu_system / 1000.0, res->peak_rss / 1024.0);
+    g_free (val);
+    return;
+  }
+
+  g_print ("{\"scenario\": \"%s\", \"buffers\": %" G_GUINT64_FORMAT
+      ", \"bytes\": %" G_GUINT64_FORMAT ", \"elapsed_us\": %" G_GINT64_FORMAT
+      ", \"buffers_per_second\": %.3f, \"bytes_per_second\": %.1f",
+      res->name, res->received, res->bytes, res->elapsed,
+      res->received / secs, res->bytes / secs);
+
+  if (res->numbered)
+    g_print (", \"sent\": %" G_GUINT64_FORMAT ", \"lost_percent\": %.3f",
+        res->sent, MAX (lost, 0.0));
+
+  if (res->latencies->len)
+    g_print (", \"latency_us\": {\"samples\": %u, \"p50\": %" G_GINT64_FORMAT
+        ", \"p90\": %" G_GINT64_FORMAT ", \"p99\": %" G_GINT64_FORMAT
+        ", \"max\": %" G_GINT64_FORMAT "}", res->latencies->len,
+        latency_at (res, 0.5), latency_at (res, 0.9), latency_at (res, 0.99),
+        latency_at (res, 1.0));
+  else
+    g_print (", \"latency_us\": null");
+
+  g_print (", \"cpu_user_us\": %" G_GINT64_FORMAT ", \"cpu_system_us\": %"
+      G_GINT64_FORMAT ", \"peak_rss_kb\": %" G_GUINT64_FORMAT "}\n",
+      res->cpu_user, res->cpu_system, res->peak_rss);
+}
+
+/* main */
+
+static gboolean
+in_list (gchar ** list, const gchar * name)
+{
+  return list == NULL || g_strv_contains ((const gchar * const *) list, name);
+}
+
+static void
+remove_dir (const gchar * path)
+{
+  GDir *dir = g_dir_open (path, 0, NULL);
+  const gchar *name;
+
+  if (dir == NULL)
+    return;
+
+  while ((name = g_dir_read_name (dir))) {
+    gchar *child = g_build_filename (path, name, NULL);
+
+    if (g_file_test (child, G_FILE_TEST_IS_DIR))
+      remove_dir (child);
+    else
+      g_unlink (child);
+    g_free (child);
+  }
+  g_dir_close (dir);
+  g_rmdir (path);
+}
+
+int
+main (int argc, char **argv)
+{
+  BenchEnv env = { NULL, };
+  guint n_buffers = 0;
+  gchar *scenarios_str = NULL, *format = NULL;
+  gboolean list = FALSE;
+  GOptionEntry options[] = {
+    {"scenarios", 's', 0, G_OPTION_ARG_STRING, &scenarios_str,
+        "Comma separated scenarios to run (default all)", "LIST"},
+    {"buffers", 'n', 0, G_OPTION_ARG_INT, &n_buffers,
+        "Number of buffers per run instead of the scenario's default", "N"},
+    {"asset-frames", 0, 0, G_OPTION_ARG_INT, &env.asset_frames,
+        "Number of frames of the encoded inputs", "N"},
+    {"format", 'f', 0, G_OPTION_ARG_STRING, &format,
+        "Output format (table, json)", "FORMAT"},
+    {"list", 'l', 0, G_OPTION_ARG_NONE, &list,
+        "List the scenarios and exit", NULL},
+    {NULL}
+  };
+  gchar **names = NULL;
+  GOptionContext *ctx;
+  GError *err = NULL;
+  gboolean ok = TRUE, json;
+  guint i;
+
+  env.asset_frames = DEFAULT_ASSET_FRAMES;
+
+  ctx = g_option_context_new ("- cross-plugin pipeline benchmark");
+  g_option_context_add_main_entries (ctx, options, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_clear_error (&err);
+    g_option_context_free (ctx);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  if (list) {
+    for (i = 0; i < G_N_ELEMENTS (scenarios); i++)
+      g_print ("%s\n", scenarios[i].name);
+    return 0;
+  }
+
+  json = g_strcmp0 (format, "json") == 0;
+  if (format && !json && strcmp (format, "table") != 0) {
+    g_printerr ("Unknown output format %s\n", format);
+    g_free (format);
+    return 1;
+  }
+
+  env.asset_frames = MAX (env.asset_frames, 1);
+  env.dir = g_dir_make_tmp ("bench-pipelines-XXXXXX", &err);
+  if (env.dir == NULL) {
+    g_printerr ("Could not create temporary directory: %s\n", err->message);
+    g_clear_error (&err);
+    return 1;
+  }
+  env.h264enc = find_encoder (h264_encoders, G_N_ELEMENTS (h264_encoders));
+  env.h265enc = find_encoder (h265_encoders, G_N_ELEMENTS (h265_encoders));
+
+  if (scenarios_str)
+    names = g_strsplit (scenarios_str, ",", -1);
+
+  if (!json)
+    print_header ();
+
+  for (i = 0; i < G_N_ELEMENTS (scenarios); i++) {
+    const BenchScenario *scenario = &scenarios[i];
+    BenchResult res = { NULL, };
+    guint count;
+
+    if (!in_list (names, scenario->name))
+      continue;
+
+    count = n_buffers > 0 ? n_buffers : scenario->count;
+    ok &= bench_run (&env, scenario, MAX (count, 1), &res);
+    if (res.latencies) {
+      print_result (&res, json);
+      g_array_unref (res.latencies);
+    }
+  }
+
+  if (env.server) {
+    g_socket_service_stop (env.server);
+    g_socket_listener_close (G_SOCKET_LISTENER (env.server));
+    g_object_unref (env.server);
+  }
+  remove_dir (env.dir);
+
+  g_strfreev (names);
+  g_free (scenarios_str);
+  g_free (format);
+  g_free (env.http);
+  g_free (env.dir);
+
+  return ok ? 0 : 1;
+}
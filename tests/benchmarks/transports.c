@@ -0,0 +1,725 @@
+/* GStreamer
+ *
+ * transports.c: benchmark for the intra-host transport elements
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Pushes raw 1080p and 4K video and 7.1 audio from one producer to several
+ * consumer pipelines in this process, over shmsink/shmsrc,
+ * intervideosink/intervideosrc (interaudiosink/interaudiosrc for audio),
+ * proxysink/proxysrc and ipcpipelinesink/ipcpipelinesrc.
+ *
+ * For every run it reports the buffers and bytes per second summed over
+ * all consumers, how many of the buffers did not reach the consumers, the
+ * median, 99th percentile and maximum latency from the buffer leaving the
+ * producer's appsrc until a consumer got it, and the CPU time (user and
+ * system) of the whole process, per delivered buffer and as a share of
+ * one core.
+ *
+ * The producer stamps a sequence number on each buffer, on every frame for
+ * audio so that it survives the re-chunking in interaudiosrc. The inter
+ * sources are clocked, so for them the producer runs in real time and the
+ * throughput is bounded by the frame rate. ipcpipeline connects exactly
+ * one consumer to each sink, so its fan-out is a tee with one queue and
+ * ipcpipelinesink per consumer.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+
+#ifdef G_OS_UNIX
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#endif
+
+#define DEFAULT_FRAMES 120
+#define DEFAULT_CONSUMERS "1,2,4,8,16"
+#define MAX_CONSUMERS 16
+
+/* a run ends once nothing was produced or received for this long */
+#define DRAIN_TIMEOUT G_USEC_PER_SEC
+#define CONNECT_TIMEOUT (5 * G_USEC_PER_SEC)
+
+/* formats */
+
+typedef struct
+{
+  const gchar *name;
+  const gchar *caps;
+  gsize size;
+  /* distance of the sequence numbers in a buffer */
+  gsize stride;
+  GstClockTime duration;
+  gboolean audio;
+} BenchFormat;
+
+#define I420_SIZE(w, h) ((w) * (h) * 3 / 2)
+
+static const BenchFormat formats[] = {
+  {"1080p", "video/x-raw, format=(string)I420, width=(int)1920, "
+        "height=(int)1080, framerate=(fraction)30/1",
+      I420_SIZE (1920, 1080), I420_SIZE (1920, 1080), GST_SECOND / 30, FALSE},
+  {"4k", "video/x-raw, format=(string)I420, width=(int)3840, "
+        "height=(int)2160, framerate=(fraction)30/1",
+      I420_SIZE (3840, 2160), I420_SIZE (3840, 2160), GST_SECOND / 30, FALSE},
+  /* 10 ms of 7.1 S32 */
+  {"audio", "audio/x-raw, format=(string)S32LE, layout=(string)interleaved, "
+        "rate=(int)48000, channels=(int)8, channel-mask=(bitmask)0xc3f",
+      480 * 8 * 4, 8 * 4, GST_SECOND / 100, TRUE},
+};
+
+/* transports */
+
+typedef enum
+{
+  TRANSPORT_SHM,
+  TRANSPORT_INTER,
+  TRANSPORT_PROXY,
+  TRANSPORT_IPCPIPELINE,
+} BenchTransport;
+
+static const gchar *transport_names[] = { "shm", "inter", "proxy",
+  "ipcpipeline"
+};
+
+/* run state */
+
+typedef struct _Bench Bench;
+
+typedef struct
+{
+  Bench *bench;
+  GstElement *pipeline;
+  guint64 buffers;
+  guint64 bytes;
+  guint32 last_seq;
+  GArray *latencies;
+} Consumer;
+
+struct _Bench
+{
+  const BenchFormat *format;
+  guint n_frames;
+  guint n_consumers;
+
+  GstBufferPool *pool;
+  guint32 next_seq;
+  GstClockTime ts;
+  /* indexed by sequence number, in microseconds */
+  gint64 *send_times;
+
+  GMutex lock;
+  GCond cond;
+  gboolean eos;
+  guint connected;
+  gint64 last_progress;
+  gint64 last_receive;
+  Consumer consumers[MAX_CONSUMERS];
+};
+
+static gint64
+cpu_time (void)
+{
+#ifdef G_OS_UNIX
+  struct rusage usage;
+
+  if (getrusage (RUSAGE_SELF, &usage) < 0)
+    return 0;
+
+  return (gint64) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) *
+      G_USEC_PER_SEC + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+#else
+  return 0;
+#endif
+}
+
+/* producer */
+
+static void
+producer_need_data (GstAppSrc * src, guint length, gpointer user_data)
+{
+  Bench *bench = user_data;
+  GstBuffer *buf = NULL;
+  GstMapInfo map;
+  guint32 seq;
+  gsize i;
+
+  if (bench->next_seq == bench->n_frames ||
+      gst_buffer_pool_acquire_buffer (bench->pool, &buf,
+          NULL) != GST_FLOW_OK) {
+    gst_app_src_end_of_stream (src);
+    return;
+  }
+
+  /* sequence numbers start at 1 so that silence never matches one */
+  seq = ++bench->next_seq;
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  for (i = 0; i + 4 <= map.size; i += bench->format->stride)
+    GST_WRITE_UINT32_LE (map.data + i, seq);
+  gst_buffer_unmap (buf, &map);
+
+  GST_BUFFER_PTS (buf) = GST_BUFFER_DTS (buf) = bench->ts;
+  GST_BUFFER_DURATION (buf) = bench->format->duration;
+  bench->ts += bench->format->duration;
+
+  gst_app_src_push_buffer (src, buf);
+}
+
+/* Takes the send time when the buffer leaves the appsrc queue, so that
+ * only the time spent in the transport is accounted */
+static GstPadProbeReturn
+producer_probe (GstPad * pad, GstPadProbeInfo * info, Bench * bench)
+{
+  gint64 now = g_get_monotonic_time ();
+
+  g_mutex_lock (&bench->lock);
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER) {
+    guint8 data[4];
+
+    gst_buffer_extract (GST_PAD_PROBE_INFO_BUFFER (info), 0, data, 4);
+    bench->send_times[GST_READ_UINT32_LE (data)] = now;
+  } else if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) ==
+      GST_EVENT_EOS) {
+    bench->eos = TRUE;
+  }
+  bench->last_progress = now;
+  g_cond_broadcast (&bench->cond);
+  g_mutex_unlock (&bench->lock);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GstElement *
+make_producer (Bench * bench)
+{
+  GstAppSrcCallbacks callbacks = { producer_need_data, NULL, NULL, };
+  GstElement *pipeline, *src;
+  GstStructure *config;
+  GstCaps *caps;
+  GstPad *pad;
+
+  caps = gst_caps_from_string (bench->format->caps);
+
+  bench->pool = gst_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (bench->pool);
+  gst_buffer_pool_config_set_params (config, caps, bench->format->size, 4, 0);
+  gst_buffer_pool_set_config (bench->pool, config);
+  gst_buffer_pool_set_active (bench->pool, TRUE);
+
+  pipeline = gst_pipeline_new ("producer");
+  src = gst_element_factory_make ("appsrc", "src");
+  g_object_set (src, "caps", caps, "format", GST_FORMAT_TIME, NULL);
+  gst_app_src_set_callbacks (GST_APP_SRC (src), &callbacks, bench, NULL);
+  gst_bin_add (GST_BIN (pipeline), src);
+  gst_caps_unref (caps);
+
+  pad = gst_element_get_static_pad (src, "src");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER |
+      GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, (GstPadProbeCallback) producer_probe,
+      bench, NULL);
+  gst_object_unref (pad);
+
+  return pipeline;
+}
+
+/* consumers */
+
+static void
+consumer_handoff (GstElement * sink, GstBuffer * buf, GstPad * pad,
+    Consumer * consumer)
+{
+  Bench *bench = consumer->bench;
+  gint64 now = g_get_monotonic_time ();
+  gsize size = gst_buffer_get_size (buf);
+  guint8 data[4];
+  guint32 seq;
+
+  /* skip repeated frames, silence and black frames of the inter sources */
+  if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_GAP) || size < 4)
+    return;
+
+  gst_buffer_extract (buf, 0, data, 4);
+  seq = GST_READ_UINT32_LE (data);
+  if (seq == 0 || seq > bench->n_frames)
+    return;
+
+  g_mutex_lock (&bench->lock);
+  consumer->bytes += size;
+  if (seq > consumer->last_seq) {
+    gint64 latency = now - bench->send_times[seq];
+
+    g_array_append_val (consumer->latencies, latency);
+    consumer->buffers++;
+    consumer->last_seq = seq;
+  }
+  bench->last_progress = bench->last_receive = now;
+  g_cond_broadcast (&bench->cond);
+  g_mutex_unlock (&bench->lock);
+}
+
+static GstElement *
+make_consumer (Consumer * consumer, GstElement * pipeline, GstElement * src)
+{
+  GstElement *sink = gst_element_factory_make ("fakesink", NULL);
+
+  g_object_set (sink, "sync", FALSE, "async", FALSE, "signal-handoffs", TRUE,
+      NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (consumer_handoff), consumer);
+
+  gst_bin_add_many (GST_BIN (pipeline), src, sink, NULL);
+  gst_element_link (src, sink);
+  consumer->pipeline = pipeline;
+
+  return pipeline;
+}
+
+static void
+shm_client_connected (GstElement * sink, gint fd, Bench * bench)
+{
+  g_mutex_lock (&bench->lock);
+  bench->connected++;
+  g_cond_broadcast (&bench->cond);
+  g_mutex_unlock (&bench->lock);
+}
+
+/* Adds the transport sink(s) to the producer and creates the consumer
+ * pipelines. For ipcpipeline the connected sockets are stored in fds */
+static gboolean
+setup_transport (Bench * bench, BenchTransport transport,
+    GstElement * producer, gint * fds, gchar ** socket_path)
+{
+  GstElement *src = gst_bin_get_by_name (GST_BIN (producer), "src");
+  const gboolean audio = bench->format->audio;
+  gchar *channel = NULL;
+  GstElement *sink = NULL, *tee = NULL;
+  guint i;
+
+  switch (transport) {
+    case TRANSPORT_SHM:
+#ifdef G_OS_UNIX
+      *socket_path = g_strdup_printf ("%s/bench-transports-%d",
+          g_get_tmp_dir (), (gint) getpid ());
+      sink = gst_element_factory_make ("shmsink", NULL);
+      g_object_set (sink, "socket-path", *socket_path, "shm-size",
+          (guint) MAX (64 * 1024 * 1024, bench->format->size * 8),
+          "wait-for-connection", TRUE, "sync", FALSE, NULL);
+      g_signal_connect (sink, "client-connected",
+          G_CALLBACK (shm_client_connected), bench);
+#endif
+      break;
+    case TRANSPORT_INTER:
+      channel = g_strdup_printf ("bench-transports-%s", bench->format->name);
+      sink = gst_element_factory_make (audio ? "interaudiosink" :
+          "intervideosink", NULL);
+      g_object_set (sink, "channel", channel, NULL);
+      if (!audio)
+        g_object_set (sink, "queue-size", 4, NULL);
+      break;
+    case TRANSPORT_PROXY:
+      sink = gst_element_factory_make ("proxysink", NULL);
+      break;
+    case TRANSPORT_IPCPIPELINE:
+      tee = gst_element_factory_make ("tee", NULL);
+      gst_bin_add (GST_BIN (producer), tee);
+      gst_element_link (src, tee);
+      break;
+  }
+
+  if (sink) {
+    gst_bin_add (GST_BIN (producer), sink);
+    gst_element_link (src, sink);
+  }
+  gst_object_unref (src);
+
+  for (i = 0; i < bench->n_consumers; i++) {
+    Consumer *consumer = &bench->consumers[i];
+    GstElement *csrc = NULL, *pipeline;
+
+    switch (transport) {
+      case TRANSPORT_SHM:
+        csrc = gst_element_factory_make ("shmsrc", NULL);
+        g_object_set (csrc, "socket-path", *socket_path, "is-live", TRUE,
+            NULL);
+        break;
+      case TRANSPORT_INTER:
+        csrc = gst_element_factory_make (audio ? "interaudiosrc" :
+            "intervideosrc", NULL);
+        g_object_set (csrc, "channel", channel, NULL);
+        if (!audio)
+          gst_util_set_object_arg (G_OBJECT (csrc), "mode", "fifo");
+        break;
+      case TRANSPORT_PROXY:
+        csrc = gst_element_factory_make ("proxysrc", NULL);
+        g_object_set (csrc, "proxysink", sink, NULL);
+        break;
+      case TRANSPORT_IPCPIPELINE:{
+#ifdef G_OS_UNIX
+        GstElement *queue, *ipcsink;
+        gint sv[2];
+
+        if (socketpair (AF_UNIX, SOCK_STREAM, 0, sv) < 0) {
+          g_printerr ("Could not create sockets: %s\n", g_strerror (errno));
+          g_free (channel);
+          return FALSE;
+        }
+        fcntl (sv[0], F_SETFL, O_NONBLOCK);
+        fcntl (sv[1], F_SETFL, O_NONBLOCK);
+        fds[2 * i] = sv[0];
+        fds[2 * i + 1] = sv[1];
+
+        queue = gst_element_factory_make ("queue", NULL);
+        ipcsink = gst_element_factory_make ("ipcpipelinesink", NULL);
+        g_object_set (ipcsink, "fdin", sv[0], "fdout", sv[0], NULL);
+        gst_bin_add_many (GST_BIN (producer), queue, ipcsink, NULL);
+        gst_element_link_many (tee, queue, ipcsink, NULL);
+
+        csrc = gst_element_factory_make ("ipcpipelinesrc", NULL);
+        g_object_set (csrc, "fdin", sv[1], "fdout", sv[1], NULL);
+#endif
+        break;
+      }
+    }
+
+    if (transport == TRANSPORT_IPCPIPELINE)
+      pipeline = gst_element_factory_make ("ipcslavepipeline", NULL);
+    else
+      pipeline = gst_pipeline_new (NULL);
+
+    consumer->bench = bench;
+    consumer->latencies = g_array_new (FALSE, FALSE, sizeof (gint64));
+    make_consumer (consumer, pipeline, csrc);
+  }
+
+  g_free (channel);
+
+  return TRUE;
+}
+
+static gboolean
+check_bus (GstElement * pipeline, const gchar * what)
+{
+  GstBus *bus = gst_element_get_bus (pipeline);
+  gboolean ret = TRUE;
+  GstMessage *msg;
+
+  while ((msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ERROR))) {
+    GError *err = NULL;
+    gchar *dbg = NULL;
+
+    gst_message_parse_error (msg, &err, &dbg);
+    g_printerr ("%s: %s\n%s\n", what, err->message, GST_STR_NULL (dbg));
+    g_clear_error (&err);
+    g_free (dbg);
+    gst_message_unref (msg);
+    ret = FALSE;
+  }
+  gst_object_unref (bus);
+
+  return ret;
+}
+
+static gboolean
+bench_done (Bench * bench)
+{
+  guint i;
+
+  if (!bench->eos)
+    return FALSE;
+
+  for (i = 0; i < bench->n_consumers; i++) {
+    if (bench->consumers[i].last_seq < bench->n_frames)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+static gint
+compare_latency (gconstpointer a, gconstpointer b)
+{
+  gint64 la = *(const gint64 *) a, lb = *(const gint64 *) b;
+
+  return la < lb ? -1 : la > lb;
+}
+
+static void
+print_header (void)
+{
+  g_print ("%-12s %-6s %4s %10s %9s %7s %8s %8s %8s %6s %9s\n",
+      "transport", "format", "cons", "buffers/s", "MB/s", "lost %",
+      "p50 us", "p99 us", "max us", "CPU %", "CPU us/b");
+}
+
+static gboolean
+bench_run (BenchTransport transport, const BenchFormat * format,
+    guint n_frames, guint n_consumers)
+{
+  Bench bench = { format, n_frames, n_consumers, };
+  gint fds[2 * MAX_CONSUMERS];
+  gchar *socket_path = NULL;
+  GstElement *producer;
+  gint64 start, start_cpu, elapsed, cpu;
+  guint64 buffers = 0, bytes = 0;
+  GArray *latencies;
+  gboolean ret = TRUE;
+  guint i;
+
+  g_mutex_init (&bench.lock);
+  g_cond_init (&bench.cond);
+  bench.send_times = g_new0 (gint64, n_frames + 1);
+  for (i = 0; i < G_N_ELEMENTS (fds); i++)
+    fds[i] = -1;
+
+  producer = make_producer (&bench);
+  if (!setup_transport (&bench, transport, producer, fds, &socket_path)) {
+    ret = FALSE;
+    goto done;
+  }
+
+  /* shmsink creates its socket when going to READY, the clients have to
+   * connect before the producer starts or they miss the first buffers */
+  gst_element_set_state (producer, GST_STATE_READY);
+  for (i = 0; i < n_consumers; i++) {
+    if (transport != TRANSPORT_IPCPIPELINE)
+      gst_element_set_state (bench.consumers[i].pipeline, GST_STATE_PLAYING);
+  }
+
+  g_mutex_lock (&bench.lock);
+  if (transport == TRANSPORT_SHM) {
+    gint64 deadline = g_get_monotonic_time () + CONNECT_TIMEOUT;
+
+    while (bench.connected < n_consumers &&
+        g_cond_wait_until (&bench.cond, &bench.lock, deadline));
+    if (bench.connected < n_consumers) {
+      g_printerr ("shm: only %u of %u consumers connected\n", bench.connected,
+          n_consumers);
+      g_mutex_unlock (&bench.lock);
+      ret = FALSE;
+      goto done;
+    }
+  }
+  start = bench.last_progress = bench.last_receive = g_get_monotonic_time ();
+  start_cpu = cpu_time ();
+  g_mutex_unlock (&bench.lock);
+
+  if (gst_element_set_state (producer,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
+    g_printerr ("%s: failed to start producer\n", transport_names[transport]);
+    ret = FALSE;
+    goto done;
+  }
+
+  g_mutex_lock (&bench.lock);
+  while (!bench_done (&bench)) {
+    if (!g_cond_wait_until (&bench.cond, &bench.lock,
+            bench.last_progress + DRAIN_TIMEOUT) &&
+        g_get_monotonic_time () >= bench.last_progress + DRAIN_TIMEOUT)
+      break;
+  }
+  elapsed = MAX (bench.last_receive - start, 1);
+  cpu = cpu_time () - start_cpu;
+
+  latencies = g_array_new (FALSE, FALSE, sizeof (gint64));
+  for (i = 0; i < n_consumers; i++) {
+    Consumer *consumer = &bench.consumers[i];
+
+    buffers += consumer->buffers;
+    bytes += consumer->bytes;
+    g_array_append_vals (latencies, consumer->latencies->data,
+        consumer->latencies->len);
+  }
+  g_mutex_unlock (&bench.lock);
+
+  ret &= check_bus (producer, transport_names[transport]);
+  for (i = 0; i < n_consumers; i++)
+    ret &= check_bus (bench.consumers[i].pipeline, transport_names[transport]);
+
+  g_array_sort (latencies, compare_latency);
+
+#define LATENCY(q) (latencies->len ? \
+    g_array_index (latencies, gint64, (guint) ((latencies->len - 1) * (q))) : 0)
+
+  g_print ("%-12s %-6s %4u %10.1f %9.1f %7.2f %8" G_GINT64_FORMAT " %8"
+      G_GINT64_FORMAT " %8" G_GINT64_FORMAT " %6.1f %9.1f\n",
+      transport_names[transport], format->name, n_consumers,
+      buffers * (gdouble) G_USEC_PER_SEC / elapsed,
+      bytes * (gdouble) G_USEC_PER_SEC / elapsed / (1024 * 1024),
+      100.0 - buffers * 100.0 / ((guint64) n_frames * n_consumers),
+      LATENCY (0.5), LATENCY (0.99), LATENCY (1.0),
+      cpu * 100.0 / elapsed, buffers ? cpu / (gdouble) buffers : 0.0);
+
+#undef LATENCY
+
+  g_array_unref (latencies);
+
+done:
+  gst_element_set_state (producer, GST_STATE_NULL);
+  for (i = 0; i < n_consumers; i++) {
+    Consumer *consumer = &bench.consumers[i];
+
+    if (consumer->pipeline) {
+      gst_element_set_state (consumer->pipeline, GST_STATE_NULL);
+      gst_object_unref (consumer->pipeline);
+    }
+    if (consumer->latencies)
+      g_array_unref (consumer->latencies);
+  }
+  gst_object_unref (producer);
+
+#ifdef G_OS_UNIX
+  for (i = 0; i < G_N_ELEMENTS (fds); i++) {
+    if (fds[i] >= 0)
+      close (fds[i]);
+  }
+#endif
+
+  gst_buffer_pool_set_active (bench.pool, FALSE);
+  gst_object_unref (bench.pool);
+  g_free (bench.send_times);
+  g_free (socket_path);
+  g_cond_clear (&bench.cond);
+  g_mutex_clear (&bench.lock);
+
+  return ret;
+}
+
+static gboolean
+transport_available (BenchTransport transport)
+{
+  static const gchar *factories[][4] = {
+    {"shmsink", "shmsrc", NULL},
+    {"intervideosink", "intervideosrc", "interaudiosink", "interaudiosrc"},
+    {"proxysink", "proxysrc", NULL},
+    {"ipcpipelinesink", "ipcpipelinesrc", "ipcslavepipeline", NULL},
+  };
+  guint i;
+
+#ifndef G_OS_UNIX
+  if (transport == TRANSPORT_SHM || transport == TRANSPORT_IPCPIPELINE)
+    return FALSE;
+#endif
+
+  for (i = 0; i < G_N_ELEMENTS (factories[transport]); i++) {
+    GstElementFactory *factory;
+
+    if (!factories[transport][i])
+      break;
+
+    factory = gst_element_factory_find (factories[transport][i]);
+    if (!factory)
+      return FALSE;
+    gst_object_unref (factory);
+  }
+
+  return TRUE;
+}
+
+/* main */
+
+static gboolean
+in_list (gchar ** list, const gchar * name)
+{
+  return list == NULL || g_strv_contains ((const gchar * const *) list, name);
+}
+
+int
+main (int argc, char **argv)
+{
+  guint n_frames = DEFAULT_FRAMES;
+  gchar *transports_str = NULL, *formats_str = NULL, *consumers_str = NULL;
+  GOptionEntry options[] = {
+    {"transports", 't', 0, G_OPTION_ARG_STRING, &transports_str,
+        "Comma separated transports to run (shm, inter, proxy, ipcpipeline)",
+        "LIST"},
+    {"formats", 'f', 0, G_OPTION_ARG_STRING, &formats_str,
+        "Comma separated formats to run (1080p, 4k, audio)", "LIST"},
+    {"consumers", 'c', 0, G_OPTION_ARG_STRING, &consumers_str,
+        "Comma separated numbers of consumers (default " DEFAULT_CONSUMERS
+          ")", "LIST"},
+    {"frames", 'n', 0, G_OPTION_ARG_INT, &n_frames,
+        "Number of buffers per run", "N"},
+    {NULL}
+  };
+  gchar **transports = NULL, **format_names = NULL, **consumers;
+  GOptionContext *ctx;
+  GError *err = NULL;
+  gboolean ok = TRUE;
+  guint t, f, c;
+
+  ctx = g_option_context_new ("- intra-host transport benchmark");
+  g_option_context_add_main_entries (ctx, options, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_clear_error (&err);
+    g_option_context_free (ctx);
+    return 1;
+  }
+  g_option_context_free (ctx);
+
+  n_frames = MAX (n_frames, 1);
+  if (transports_str)
+    transports = g_strsplit (transports_str, ",", -1);
+  if (formats_str)
+    format_names = g_strsplit (formats_str, ",", -1);
+  consumers = g_strsplit (consumers_str ? consumers_str : DEFAULT_CONSUMERS,
+      ",", -1);
+
+  g_print ("%u buffers per run\n\n", n_frames);
+  print_header ();
+
+  for (t = 0; t < G_N_ELEMENTS (transport_names); t++) {
+    if (!in_list (transports, transport_names[t]))
+      continue;
+
+    if (!transport_available (t)) {
+      g_printerr ("%s: elements not available, skipping\n",
+          transport_names[t]);
+      continue;
+    }
+
+    for (f = 0; f < G_N_ELEMENTS (formats); f++) {
+      if (!in_list (format_names, formats[f].name))
+        continue;
+
+      for (c = 0; consumers[c]; c++) {
+        guint n_consumers = CLAMP (atoi (consumers[c]), 1, MAX_CONSUMERS);
+
+        ok &= bench_run (t, &formats[f], n_frames, n_consumers);
+      }
+    }
+  }
+
+  g_strfreev (transports);
+  g_strfreev (format_names);
+  g_strfreev (consumers);
+  g_free (transports_str);
+  g_free (formats_str);
+  g_free (consumers_str);
+
+  return ok ? 0 : 1;
+}
@@ -74,6 +74,56 @@ GST_START_TEST (test_buffer)
 
 GST_END_TEST;
 
+GST_START_TEST (test_buffer_split)
+{
+  GstHarness *h;
+  GstElement *element;
+  GstBuffer *in, *out;
+  GstMapInfo info;
+  struct avtp_stream_pdu *pdu;
+  const int BPF = 4;
+  const guint sizes[] = { 4, 4, 2 };
+  guint i, offset = 0;
+  guint64 val;
+
+  h = setup_harness ();
+  element = gst_harness_find_element (h, "avtpaafpay");
+  g_object_set (G_OBJECT (element), "frames-per-pdu", 4, NULL);
+
+  in = gst_harness_create_buffer (h, 10 * BPF);
+  GST_BUFFER_PTS (in) = 1000000;
+  fail_unless_equals_int (gst_harness_push (h, in), GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_buffers_received (h), 3);
+
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++) {
+    GstClockTime pts = 1000000 + gst_util_uint64_scale_int (offset,
+        GST_SECOND, 48000);
+
+    out = gst_harness_pull (h);
+    fail_unless_equals_int (gst_buffer_get_size (out),
+        sizeof (struct avtp_stream_pdu) + sizes[i] * BPF);
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (out), pts);
+
+    gst_buffer_map (out, &info, GST_MAP_READ);
+    pdu = (struct avtp_stream_pdu *) info.data;
+    avtp_aaf_pdu_get (pdu, AVTP_AAF_FIELD_STREAM_DATA_LEN, &val);
+    fail_unless_equals_uint64 (val, sizes[i] * BPF);
+    avtp_aaf_pdu_get (pdu, AVTP_AAF_FIELD_SEQ_NUM, &val);
+    fail_unless_equals_uint64 (val, i);
+    avtp_aaf_pdu_get (pdu, AVTP_AAF_FIELD_TIMESTAMP, &val);
+    fail_unless_equals_uint64 (val, (pts + 3000000) & 0xffffffff);
+    gst_buffer_unmap (out, &info);
+    gst_buffer_unref (out);
+
+    offset += sizes[i];
+  }
+
+  gst_object_unref (element);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_properties)
 {
   GstHarness *h;
@@ -105,6 +155,10 @@ GST_START_TEST (test_properties)
   g_object_get (G_OBJECT (element), "timestamp-mode", &val_uint, NULL);
   fail_unless (val_uint == tstamp_mode);
 
+  g_object_set (G_OBJECT (element), "frames-per-pdu", 6, NULL);
+  g_object_get (G_OBJECT (element), "frames-per-pdu", &val_uint, NULL);
+  fail_unless (val_uint == 6);
+
   g_object_set (G_OBJECT (element), "processing-deadline", processing_deadline,
       NULL);
   g_object_get (G_OBJECT (element), "processing-deadline", &val_uint64, NULL);
@@ -124,6 +178,7 @@ avtpaafpay_suite (void)
 
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_buffer);
+  tcase_add_test (tc_chain, test_buffer_split);
   tcase_add_test (tc_chain, test_properties);
 
   return s;
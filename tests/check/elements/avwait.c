@@ -41,6 +41,7 @@ static GstClockTime target_running_time;
 static gboolean recording;
 static gint mode;
 static gboolean audio_late;
+static GstStructure *schedule_window;
 
 static GstAudioInfo ainfo;
 
@@ -73,6 +74,7 @@ set_default_params (void)
   recording = TRUE;
   mode = 2;
   audio_late = FALSE;
+  schedule_window = NULL;
 
   first_audio_timestamp = GST_CLOCK_TIME_NONE;
   last_audio_timestamp = GST_CLOCK_TIME_NONE;
@@ -224,6 +226,17 @@ test_avwait_generic (void)
     g_object_set (avwait, "target-timecode", target_tc, NULL);
   if (end_tc != NULL)
     g_object_set (avwait, "end-timecode", end_tc, NULL);
+  if (schedule_window != NULL) {
+    GValue schedule = G_VALUE_INIT;
+    GValue window = G_VALUE_INIT;
+
+    g_value_init (&schedule, GST_TYPE_ARRAY);
+    g_value_init (&window, GST_TYPE_STRUCTURE);
+    g_value_take_boxed (&window, schedule_window);
+    gst_value_array_append_and_take_value (&schedule, &window);
+    g_object_set_property (G_OBJECT (avwait), "schedule", &schedule);
+    g_value_unset (&schedule);
+  }
 
   bus = gst_bus_new ();
   gst_element_set_bus (avwait, bus);
@@ -447,6 +460,42 @@ GST_START_TEST (test_avwait_3stc_switch_to_false)
 
 GST_END_TEST;
 
+GST_START_TEST (test_avwait_schedule)
+{
+  GstVideoTimeCode *schedule_tc, *schedule_end_tc;
+
+  set_default_params ();
+  mode = 0;
+  target_tc =
+      gst_video_time_code_new (40, 1, NULL, GST_VIDEO_TIME_CODE_FLAGS_NONE, 0,
+      0, 1, 0, 0);
+  end_tc =
+      gst_video_time_code_new (40, 1, NULL, GST_VIDEO_TIME_CODE_FLAGS_NONE, 0,
+      0, 2, 0, 0);
+  schedule_tc =
+      gst_video_time_code_new (40, 1, NULL, GST_VIDEO_TIME_CODE_FLAGS_NONE, 0,
+      0, 3, 0, 0);
+  schedule_end_tc =
+      gst_video_time_code_new (40, 1, NULL, GST_VIDEO_TIME_CODE_FLAGS_NONE, 0,
+      0, 4, 0, 0);
+  schedule_window = gst_structure_new ("window",
+      "start-timecode", GST_TYPE_VIDEO_TIME_CODE, schedule_tc,
+      "end-timecode", GST_TYPE_VIDEO_TIME_CODE, schedule_end_tc, NULL);
+  test_avwait_generic ();
+  gst_video_time_code_free (schedule_tc);
+  gst_video_time_code_free (schedule_end_tc);
+  gst_video_time_code_free (target_tc);
+  gst_video_time_code_free (end_tc);
+  fail_unless_equals_int (video_buffer_count, 80);
+  fail_unless_equals_int (audio_buffer_count, 2);
+  fail_unless_equals_uint64 (first_audio_timestamp, 1 * GST_SECOND);
+  fail_unless_equals_uint64 (first_video_timestamp, 1 * GST_SECOND);
+  fail_unless_equals_uint64 (last_audio_timestamp, 4 * GST_SECOND);
+  fail_unless_equals_uint64 (last_video_timestamp, 4 * GST_SECOND);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_avwait_audio_late)
 {
   set_default_params ();
@@ -477,6 +526,7 @@ avwait_suite (void)
   tcase_add_test (tc_chain, test_avwait_3stc_switch_to_true);
   tcase_add_test (tc_chain, test_avwait_3stc_switch_to_false);
   tcase_add_test (tc_chain, test_avwait_audio_late);
+  tcase_add_test (tc_chain, test_avwait_schedule);
   suite_add_tcase (s, tc_chain);
 
   return s;
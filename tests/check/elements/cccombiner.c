@@ -275,6 +275,49 @@ GST_START_TEST (captions_type_change_and_eos)
 
 GST_END_TEST;
 
+GST_START_TEST (sparse_captions)
+{
+  GstHarness *h, *h2;
+  GstBuffer *buf, *outbuf;
+  GstPad *caption_pad;
+  GstVideoCaptionMeta *meta;
+
+  h = gst_harness_new_with_padnames ("cccombiner", "sink", "src");
+  h2 = gst_harness_new_with_element (h->element, NULL, NULL);
+  caption_pad = gst_element_get_request_pad (h->element, "caption");
+  gst_harness_add_element_sink_pad (h2, caption_pad);
+  gst_object_unref (caption_pad);
+
+  g_object_set (h->element, "sparse-captions", TRUE, NULL);
+
+  gst_harness_set_src_caps_str (h, foo_bar_caps.string);
+  gst_harness_set_src_caps_str (h2, cea708_cc_data_caps.string);
+
+  buf = gst_buffer_new_and_alloc (128);
+  GST_BUFFER_PTS (buf) = 0;
+  GST_BUFFER_DURATION (buf) = 40 * GST_MSECOND;
+  gst_harness_push (h, buf);
+
+  buf = gst_buffer_new_and_alloc (128);
+  GST_BUFFER_PTS (buf) = 0;
+  GST_BUFFER_DURATION (buf) = 40 * GST_MSECOND;
+  gst_harness_push (h2, buf);
+
+  /* The video buffer is output without waiting for further caption data */
+  outbuf = gst_harness_pull (h);
+  fail_unless (outbuf != NULL);
+
+  meta = gst_buffer_get_video_caption_meta (outbuf);
+  fail_unless (meta != NULL);
+  fail_unless_equals_int (meta->size, 128);
+  gst_buffer_unref (outbuf);
+
+  gst_harness_teardown (h);
+  gst_harness_teardown (h2);
+}
+
+GST_END_TEST;
+
 static Suite *
 cccombiner_suite (void)
 {
@@ -286,6 +329,7 @@ cccombiner_suite (void)
   tcase_add_test (tc, no_captions);
   tcase_add_test (tc, captions_and_eos);
   tcase_add_test (tc, captions_type_change_and_eos);
+  tcase_add_test (tc, sparse_captions);
 
   return s;
 }
@@ -868,6 +868,52 @@ GST_START_TEST (dash_mpdparser_period_segmentTemplate)
 
 GST_END_TEST;
 
+/*
+ * Test parsing SegmentTemplate low latency availability attributes
+ *
+ */
+GST_START_TEST (dash_mpdparser_segmentTemplate_availability)
+{
+  GstMPDPeriodNode *periodNode;
+  GstMPDAdaptationSetNode *adapt_set;
+  GstMPDSegmentTemplateNode *segmentTemplate;
+  const gchar *xml =
+      "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\">"
+      "  <Period>"
+      "    <SegmentTemplate media=\"TestMedia\""
+      "                     duration=\"4\""
+      "                     availabilityTimeOffset=\"3.5\""
+      "                     availabilityTimeComplete=\"false\">"
+      "    </SegmentTemplate>"
+      "    <AdaptationSet>"
+      "      <SegmentTemplate media=\"TestMedia\" duration=\"4\">"
+      "      </SegmentTemplate>"
+      "    </AdaptationSet></Period></MPD>";
+
+  gboolean ret;
+  GstMPDClient *mpdclient = gst_mpd_client_new ();
+
+  ret = gst_mpd_client_parse (mpdclient, xml, (gint) strlen (xml));
+  assert_equals_int (ret, TRUE);
+
+  periodNode = (GstMPDPeriodNode *) mpdclient->mpd_root_node->Periods->data;
+  segmentTemplate = periodNode->SegmentTemplate;
+  assert_equals_float (segmentTemplate->availabilityTimeOffset, 3.5);
+  assert_equals_int (segmentTemplate->availabilityTimeComplete, FALSE);
+
+  /* inherited from the Period */
+  adapt_set = (GstMPDAdaptationSetNode *) periodNode->AdaptationSets->data;
+  segmentTemplate = adapt_set->SegmentTemplate;
+  assert_equals_float (segmentTemplate->availabilityTimeOffset, 3.5);
+  assert_equals_int (segmentTemplate->availabilityTimeComplete, FALSE);
+
+  gst_mpd_client_free (mpdclient);
+}
+
+GST_END_TEST;
+
 /*
  * Test parsing Period SegmentTemplate attributes where a
  * presentationTimeOffset attribute has been specified
@@ -4969,6 +5015,120 @@ GST_START_TEST (dash_mpdparser_segment_timeline)
 
 GST_END_TEST;
 
+/*
+ * Test updating a live MPD in place
+ *
+ */
+GST_START_TEST (dash_mpdparser_live_timeline_update)
+{
+  GList *adaptationSets;
+  GstMPDAdaptationSetNode *adapt_set;
+  GstActiveStream *activeStream;
+  GstMediaFragmentInfo fragment;
+  GstMediaSegment *segment;
+  GstMPDClient *update;
+  const gchar *xml =
+      "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+      "     type=\"dynamic\""
+      "     availabilityStartTime=\"2015-03-24T0:0:0\">"
+      "  <Period id=\"1\" start=\"P0Y0M0DT0H0M0S\">"
+      "    <AdaptationSet mimeType=\"video/mp4\">"
+      "      <Representation id=\"1\" bandwidth=\"250000\">"
+      "        <SegmentTemplate timescale=\"1000\" startNumber=\"1\""
+      "                         media=\"seg-$Number$.mp4\">"
+      "          <SegmentTimeline>"
+      "            <S t=\"0\" d=\"2000\" r=\"4\"/>"
+      "          </SegmentTimeline>"
+      "        </SegmentTemplate>"
+      "      </Representation></AdaptationSet></Period></MPD>";
+  const gchar *xml_update =
+      "<?xml version=\"1.0\"?>"
+      "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\""
+      "     profiles=\"urn:mpeg:dash:profile:isoff-live:2011\""
+      "     type=\"dynamic\""
+      "     availabilityStartTime=\"2015-03-24T0:0:0\">"
+      "  <Period id=\"1\" start=\"P0Y0M0DT0H0M0S\">"
+      "    <AdaptationSet mimeType=\"video/mp4\">"
+      "      <Representation id=\"1\" bandwidth=\"250000\">"
+      "        <SegmentTemplate timescale=\"1000\" startNumber=\"3\""
+      "                         media=\"seg-$Number$.mp4\">"
+      "          <SegmentTimeline>"
+      "            <S t=\"4000\" d=\"2000\" r=\"4\"/>"
+      "            <S d=\"1000\"/>"
+      "          </SegmentTimeline>"
+      "        </SegmentTemplate>"
+      "      </Representation></AdaptationSet></Period></MPD>";
+
+  gboolean ret;
+  GstMPDClient *mpdclient = gst_mpd_client_new ();
+
+  ret = gst_mpd_client_parse (mpdclient, xml, (gint) strlen (xml));
+  assert_equals_int (ret, TRUE);
+
+  ret =
+      gst_mpd_client_setup_media_presentation (mpdclient, GST_CLOCK_TIME_NONE,
+      -1, NULL);
+  assert_equals_int (ret, TRUE);
+
+  adaptationSets = gst_mpd_client_get_adaptation_sets (mpdclient);
+  fail_if (adaptationSets == NULL);
+  adapt_set = (GstMPDAdaptationSetNode *) g_list_nth_data (adaptationSets, 0);
+  fail_if (adapt_set == NULL);
+  ret = gst_mpd_client_setup_streaming (mpdclient, adapt_set);
+  assert_equals_int (ret, TRUE);
+
+  activeStream = gst_mpd_client_get_active_stream_by_index (mpdclient, 0);
+  fail_if (activeStream == NULL);
+  assert_equals_int (activeStream->segments->len, 1);
+
+  /* the new timeline overlaps the current one */
+  update = gst_mpd_client_new ();
+  ret = gst_mpd_client_parse (update, xml_update, (gint) strlen (xml_update));
+  assert_equals_int (ret, TRUE);
+  ret = gst_mpd_client_update_live (mpdclient, update);
+  assert_equals_int (ret, TRUE);
+  gst_mpd_client_free (update);
+
+  /* the stream kept its state and got the new segments */
+  fail_unless (activeStream ==
+      gst_mpd_client_get_active_stream_by_index (mpdclient, 0));
+  assert_equals_int (activeStream->segments->len, 3);
+  segment = g_ptr_array_index (activeStream->segments, 1);
+  assert_equals_int (segment->number, 6);
+  assert_equals_int (segment->repeat, 1);
+  assert_equals_uint64 (segment->start, 10 * GST_SECOND);
+  segment = g_ptr_array_index (activeStream->segments, 2);
+  assert_equals_int (segment->number, 8);
+  assert_equals_uint64 (segment->start, 14 * GST_SECOND);
+  assert_equals_uint64 (segment->duration, GST_SECOND);
+
+  ret = gst_mpd_client_stream_seek (mpdclient, activeStream, TRUE, 0,
+      14 * GST_SECOND, NULL);
+  assert_equals_int (ret, TRUE);
+  ret = gst_mpd_client_get_next_fragment (mpdclient, 0, &fragment);
+  assert_equals_int (ret, TRUE);
+  assert_equals_string (fragment.uri, "/seg-8.mp4");
+  assert_equals_uint64 (fragment.timestamp, 14 * GST_SECOND);
+  gst_mpdparser_media_fragment_info_clear (&fragment);
+
+  /* a different structure needs a full setup */
+  update = gst_mpd_client_new ();
+  ret = gst_mpd_client_parse (update, xml_update, (gint) strlen (xml_update));
+  assert_equals_int (ret, TRUE);
+  GST_MPD_REPRESENTATION_NODE (((GstMPDAdaptationSetNode *)
+          GST_MPD_PERIOD_NODE (update->mpd_root_node->Periods->data)->
+          AdaptationSets->data)->Representations->data)->bandwidth = 500000;
+  ret = gst_mpd_client_update_live (mpdclient, update);
+  assert_equals_int (ret, FALSE);
+  gst_mpd_client_free (update);
+
+  gst_mpd_client_free (mpdclient);
+}
+
+GST_END_TEST;
+
 /*
  * Test SegmentList with multiple inherited segmentURLs
  *
@@ -6362,6 +6522,7 @@ dash_suite (void)
       dash_mpdparser_period_segmentList_multipleSegmentBaseType_bitstreamSwitching);
   tcase_add_test (tc_simpleMPD, dash_mpdparser_period_segmentList_segmentURL);
   tcase_add_test (tc_simpleMPD, dash_mpdparser_period_segmentTemplate);
+  tcase_add_test (tc_simpleMPD, dash_mpdparser_segmentTemplate_availability);
   tcase_add_test (tc_simpleMPD,
       dash_mpdparser_period_segmentTemplateWithPresentationTimeOffset);
   tcase_add_test (tc_simpleMPD,
@@ -6483,6 +6644,7 @@ dash_suite (void)
   tcase_add_test (tc_complexMPD, dash_mpdparser_segment_list);
   tcase_add_test (tc_complexMPD, dash_mpdparser_segment_template);
   tcase_add_test (tc_complexMPD, dash_mpdparser_segment_timeline);
+  tcase_add_test (tc_complexMPD, dash_mpdparser_live_timeline_update);
   tcase_add_test (tc_complexMPD, dash_mpdparser_multiple_inherited_segmentURL);
 
   /* tests checking the parsing of missing/incomplete attributes of xml */
@@ -277,6 +277,80 @@ GST_START_TEST (test_audio_in_one_buffer)
 
 GST_END_TEST;
 
+/* contiguous payloads are pushed as sub-buffers of the input without being
+ * copied */
+GST_START_TEST (test_buffer_zero_copy)
+{
+  GstCaps *caps;
+  GstElement *gdpdepay;
+  GstBuffer *buffer, *outbuffer;
+  GstMemory *payload_mem;
+  GstEvent *event;
+  GstSegment segment;
+  guint8 data[1024];
+
+  gdpdepay = setup_gdpdepay ();
+
+  fail_unless (gst_element_set_state (gdpdepay,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_new_empty_simple ("application/x-gdp");
+  gst_check_setup_events (mysrcpad, gdpdepay, caps, GST_FORMAT_BYTES);
+  gst_caps_unref (caps);
+
+  event = gst_event_new_stream_start ("s-s-id-1234");
+  fail_unless_equals_int (gst_pad_push (mysrcpad,
+          gst_dp_payload_event (event, 0)), GST_FLOW_OK);
+  gst_event_unref (event);
+
+  caps = gst_caps_from_string (AUDIO_CAPS_STRING);
+  fail_unless_equals_int (gst_pad_push (mysrcpad,
+          gst_dp_payload_caps (caps, 0)), GST_FLOW_OK);
+  gst_caps_unref (caps);
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  event = gst_event_new_segment (&segment);
+  fail_unless_equals_int (gst_pad_push (mysrcpad,
+          gst_dp_payload_event (event, 0)), GST_FLOW_OK);
+  gst_event_unref (event);
+
+  memset (data, 0xab, sizeof (data));
+  buffer = gst_buffer_new_and_alloc (sizeof (data));
+  gst_buffer_fill (buffer, 0, data, sizeof (data));
+  GST_BUFFER_TIMESTAMP (buffer) = GST_SECOND;
+  outbuffer = gst_dp_payload_buffer (buffer, 0);
+
+  /* header and payload are separate memories, the payload is not copied */
+  fail_unless_equals_int (gst_buffer_n_memory (outbuffer), 2);
+  payload_mem = gst_buffer_peek_memory (outbuffer, 1);
+  fail_unless (payload_mem == gst_buffer_peek_memory (buffer, 0));
+  gst_buffer_unref (buffer);
+
+  gst_buffer_ref (outbuffer);
+  fail_unless_equals_int (gst_pad_push (mysrcpad, outbuffer), GST_FLOW_OK);
+
+  fail_unless_equals_int (g_list_length (buffers), 1);
+  buffer = GST_BUFFER (buffers->data);
+  fail_unless_equals_uint64 (GST_BUFFER_TIMESTAMP (buffer), GST_SECOND);
+  fail_unless_equals_int (gst_buffer_get_size (buffer), sizeof (data));
+  fail_unless_equals_int (gst_buffer_n_memory (buffer), 1);
+  fail_unless (gst_buffer_peek_memory (buffer, 0) == payload_mem);
+  fail_unless (gst_buffer_memcmp (buffer, 0, data, sizeof (data)) == 0);
+  gst_buffer_unref (outbuffer);
+
+  fail_unless (gst_element_set_state (gdpdepay,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+
+  g_list_foreach (buffers, (GFunc) gst_mini_object_unref, NULL);
+  g_list_free (buffers);
+  buffers = NULL;
+  ASSERT_OBJECT_REFCOUNT (gdpdepay, "gdpdepay", 1);
+  cleanup_gdpdepay (gdpdepay);
+}
+
+GST_END_TEST;
+
 static GstStaticPadTemplate shsinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
@@ -409,6 +483,7 @@ gdpdepay_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_audio_per_byte);
   tcase_add_test (tc_chain, test_audio_in_one_buffer);
+  tcase_add_test (tc_chain, test_buffer_zero_copy);
   tcase_add_test (tc_chain, test_streamheader);
 
   return s;
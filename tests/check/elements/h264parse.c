@@ -1168,37 +1168,40 @@ h264parse_sliced_suite (void)
 }
 
 
+static const guint8 cc_sei_plus_idr[] = {
+  0x00, 0x00, 0x00, 0x4b, 0x06, 0x04, 0x47, 0xb5, 0x00, 0x31, 0x47, 0x41,
+  0x39, 0x34, 0x03, 0xd4,
+  0xff, 0xfc, 0x80, 0x80, 0xfd, 0x80, 0x80, 0xfa, 0x00, 0x00, 0xfa, 0x00,
+  0x00, 0xfa, 0x00, 0x00,
+  0xfa, 0x00, 0x00, 0xfa, 0x00, 0x00, 0xfa, 0x00, 0x00, 0xfa, 0x00, 0x00,
+  0xfa, 0x00, 0x00, 0xfa,
+  0x00, 0x00, 0xfa, 0x00, 0x00, 0xfa, 0x00, 0x00, 0xfa, 0x00, 0x00, 0xfa,
+  0x00, 0x00, 0xfa, 0x00,
+  0x00, 0xfa, 0x00, 0x00, 0xfa, 0x00, 0x00, 0xfa, 0x00, 0x00, 0xfa, 0x00,
+  0x00, 0xff, 0x80,
+  /* IDR frame (doesn't necessarily match caps) */
+  0x00, 0x00, 0x00, 0x14, 0x65, 0x88, 0x84, 0x00,
+  0x10, 0xff, 0xfe, 0xf6, 0xf0, 0xfe, 0x05, 0x36,
+  0x56, 0x04, 0x50, 0x96, 0x7b, 0x3f, 0x53, 0xe1
+};
+static const gsize cc_sei_plus_idr_size = sizeof (cc_sei_plus_idr);
+
+#define CC_SEI_PLUS_IDR_CAPS \
+  "video/x-h264, stream-format=(string)avc, alignment=(string)au," \
+  " codec_data=(buffer)014d4015ffe10017674d4015eca4bf2e0220000003002ee6b28001e2c5b2c001000468ebecb2," \
+  " width=(int)32, height=(int)24, framerate=(fraction)30/1," \
+  " pixel-aspect-ratio=(fraction)1/1"
+
 GST_START_TEST (test_parse_sei_closedcaptions)
 {
   GstVideoCaptionMeta *cc;
   GstHarness *h;
   GstBuffer *buf;
 
-  const guint8 cc_sei_plus_idr[] = {
-    0x00, 0x00, 0x00, 0x4b, 0x06, 0x04, 0x47, 0xb5, 0x00, 0x31, 0x47, 0x41,
-    0x39, 0x34, 0x03, 0xd4,
-    0xff, 0xfc, 0x80, 0x80, 0xfd, 0x80, 0x80, 0xfa, 0x00, 0x00, 0xfa, 0x00,
-    0x00, 0xfa, 0x00, 0x00,
-    0xfa, 0x00, 0x00, 0xfa, 0x00, 0x00, 0xfa, 0x00, 0x00, 0xfa, 0x00, 0x00,
-    0xfa, 0x00, 0x00, 0xfa,
-    0x00, 0x00, 0xfa, 0x00, 0x00, 0xfa, 0x00, 0x00, 0xfa, 0x00, 0x00, 0xfa,
-    0x00, 0x00, 0xfa, 0x00,
-    0x00, 0xfa, 0x00, 0x00, 0xfa, 0x00, 0x00, 0xfa, 0x00, 0x00, 0xfa, 0x00,
-    0x00, 0xff, 0x80,
-    /* IDR frame (doesn't necessarily match caps) */
-    0x00, 0x00, 0x00, 0x14, 0x65, 0x88, 0x84, 0x00,
-    0x10, 0xff, 0xfe, 0xf6, 0xf0, 0xfe, 0x05, 0x36,
-    0x56, 0x04, 0x50, 0x96, 0x7b, 0x3f, 0x53, 0xe1
-  };
-  const gsize cc_sei_plus_idr_size = sizeof (cc_sei_plus_idr);
 
   h = gst_harness_new ("h264parse");
 
-  gst_harness_set_src_caps_str (h,
-      "video/x-h264, stream-format=(string)avc, alignment=(string)au,"
-      " codec_data=(buffer)014d4015ffe10017674d4015eca4bf2e0220000003002ee6b28001e2c5b2c001000468ebecb2,"
-      " width=(int)32, height=(int)24, framerate=(fraction)30/1,"
-      " pixel-aspect-ratio=(fraction)1/1");
+  gst_harness_set_src_caps_str (h, CC_SEI_PLUS_IDR_CAPS);
 
   buf = gst_buffer_new_and_alloc (cc_sei_plus_idr_size);
   gst_buffer_fill (buf, 0, cc_sei_plus_idr, cc_sei_plus_idr_size);
@@ -1218,6 +1221,34 @@ GST_START_TEST (test_parse_sei_closedcaptions)
 
 GST_END_TEST;
 
+GST_START_TEST (test_parse_lightweight)
+{
+  GstHarness *h;
+  GstBuffer *buf;
+  guint i;
+
+  h = gst_harness_new ("h264parse");
+  g_object_set (h->element, "lightweight", TRUE, NULL);
+
+  gst_harness_set_src_caps_str (h, CC_SEI_PLUS_IDR_CAPS);
+
+  for (i = 0; i < 2; i++) {
+    buf = gst_buffer_new_and_alloc (cc_sei_plus_idr_size);
+    gst_buffer_fill (buf, 0, cc_sei_plus_idr, cc_sei_plus_idr_size);
+    fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+
+    /* the I slice is still detected, but the SEI is skipped */
+    buf = gst_harness_pull (h);
+    fail_if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT));
+    fail_unless (gst_buffer_get_video_caption_meta (buf) == NULL);
+    gst_buffer_unref (buf);
+  }
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_parse_skip_to_4bytes_sc)
 {
   GstHarness *h;
@@ -1367,6 +1398,7 @@ main (int argc, char **argv)
     s = suite_create ("h264parse");
     suite_add_tcase (s, tc_chain);
     tcase_add_test (tc_chain, test_parse_sei_closedcaptions);
+    tcase_add_test (tc_chain, test_parse_lightweight);
     tcase_add_test (tc_chain, test_parse_compatible_caps);
     tcase_add_test (tc_chain, test_parse_skip_to_4bytes_sc);
     nf += gst_check_run_suite (s, "h264parse", __FILE__);
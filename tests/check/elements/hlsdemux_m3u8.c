@@ -82,6 +82,26 @@ https://priv.example.com/fileSequence3003.ts\n\
 #EXTINF:8,\n\
 https://priv.example.com/fileSequence3004.ts";
 
+static const gchar *LIVE_RELATIVE_PLAYLIST = "#EXTM3U\n\
+#EXT-X-TARGETDURATION:4\n\
+#EXT-X-MEDIA-SEQUENCE:10\n\
+#EXTINF:4,\n\
+seg10.ts\n\
+#EXTINF:4,\n\
+seg11.ts\n\
+#EXTINF:4,\n\
+seg12.ts";
+
+static const gchar *LIVE_RELATIVE_UPDATED_PLAYLIST = "#EXTM3U\n\
+#EXT-X-TARGETDURATION:4\n\
+#EXT-X-MEDIA-SEQUENCE:11\n\
+#EXTINF:4,\n\
+seg11.ts\n\
+#EXTINF:3,\n\
+seg12.ts\n\
+#EXTINF:4,\n\
+seg13.ts";
+
 static const gchar *VARIANT_PLAYLIST = "#EXTM3U \n\
 #EXT-X-STREAM-INF:PROGRAM-ID=1,BANDWIDTH=128000\n\
 http://example.com/low.m3u8\n\
@@ -335,6 +355,26 @@ main.mp4\n\
 main.mp4\n\
 #EXT-X-ENDLIST";
 
+static const gchar *LOW_LATENCY_PLAYLIST = "#EXTM3U \n\
+#EXT-X-VERSION:6\n\
+#EXT-X-TARGETDURATION:4\n\
+#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=4.0\n\
+#EXT-X-PART-INF:PART-TARGET=1.0\n\
+#EXT-X-MEDIA-SEQUENCE:10\n\
+#EXTINF:4.0,\n\
+seg10.mp4\n\
+#EXTINF:4.0,\n\
+seg11.mp4\n\
+#EXT-X-PART:DURATION=1.0,URI=\"seg12.0.mp4\",INDEPENDENT=YES\n\
+#EXT-X-PART:DURATION=1.0,URI=\"seg12.1.mp4\"\n\
+#EXT-X-PART:DURATION=1.0,URI=\"seg12.2.mp4\",INDEPENDENT=YES\n\
+#EXT-X-PART:DURATION=1.0,URI=\"seg12.3.mp4\"\n\
+#EXTINF:4.0,\n\
+seg12.mp4\n\
+#EXT-X-PART:DURATION=1.0,URI=\"seg13.mp4\",BYTERANGE=\"1000@0\",INDEPENDENT=YES\n\
+#EXT-X-PART:DURATION=1.0,URI=\"seg13.mp4\",BYTERANGE=\"1200\"\n\
+#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"seg13.mp4\",BYTERANGE-START=2200\n";
+
 static GstHLSMasterPlaylist *
 load_playlist (const gchar * data)
 {
@@ -587,6 +627,45 @@ GST_START_TEST (test_live_playlist_rotated)
 
 GST_END_TEST;
 
+GST_START_TEST (test_live_playlist_update_keeps_files)
+{
+  GstHLSMasterPlaylist *master;
+  GstM3U8 *pl;
+  GstM3U8MediaFile *file11, *file12, *file;
+  gboolean ret;
+
+  master = load_playlist (LIVE_RELATIVE_PLAYLIST);
+  pl = master->default_variant->m3u8;
+
+  file11 = gst_m3u8_media_file_ref (g_list_nth_data (pl->files, 1));
+  file12 = gst_m3u8_media_file_ref (g_list_nth_data (pl->files, 2));
+
+  ret = gst_m3u8_update (pl, g_strdup (LIVE_RELATIVE_UPDATED_PLAYLIST));
+  assert_equals_int (ret, TRUE);
+  assert_equals_int (g_list_length (pl->files), 3);
+
+  /* Unchanged entries are kept */
+  file = g_list_nth_data (pl->files, 0);
+  fail_unless (file == file11);
+  assert_equals_string (file->uri, "http://localhost/seg11.ts");
+
+  /* Changed and new ones are created */
+  file = g_list_nth_data (pl->files, 1);
+  fail_unless (file != file12);
+  assert_equals_int (file->sequence, 12);
+  assert_equals_uint64 (file->duration, 3 * GST_SECOND);
+
+  file = g_list_nth_data (pl->files, 2);
+  assert_equals_int (file->sequence, 13);
+  assert_equals_string (file->uri, "http://localhost/seg13.ts");
+
+  gst_m3u8_media_file_unref (file11);
+  gst_m3u8_media_file_unref (file12);
+  gst_hls_master_playlist_unref (master);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_playlist_with_doubles_duration)
 {
   GstHLSMasterPlaylist *master;
@@ -845,6 +924,128 @@ GST_START_TEST (test_get_next_fragment)
 
 GST_END_TEST;
 
+GST_START_TEST (test_peek_fragment)
+{
+  GstHLSMasterPlaylist *master;
+  GstM3U8 *pl;
+  GstM3U8MediaFile *mf;
+
+  master = load_playlist (BYTE_RANGES_PLAYLIST);
+  pl = master->default_variant->m3u8;
+
+  mf = gst_m3u8_get_next_fragment (pl, TRUE, NULL, NULL);
+  fail_unless (mf != NULL);
+  assert_equals_uint64 (mf->offset, 100);
+  gst_m3u8_media_file_unref (mf);
+
+  mf = gst_m3u8_peek_fragment (pl, TRUE, 0);
+  fail_unless (mf != NULL);
+  assert_equals_uint64 (mf->offset, 100);
+  gst_m3u8_media_file_unref (mf);
+
+  mf = gst_m3u8_peek_fragment (pl, TRUE, 1);
+  fail_unless (mf != NULL);
+  assert_equals_string (mf->uri, "http://media.example.com/all.ts");
+  assert_equals_uint64 (mf->offset, 1000);
+  gst_m3u8_media_file_unref (mf);
+
+  mf = gst_m3u8_peek_fragment (pl, TRUE, 3);
+  fail_unless (mf != NULL);
+  assert_equals_uint64 (mf->offset, 3000);
+  gst_m3u8_media_file_unref (mf);
+
+  fail_unless (gst_m3u8_peek_fragment (pl, TRUE, 4) == NULL);
+  fail_unless (gst_m3u8_peek_fragment (pl, FALSE, 1) == NULL);
+
+  /* Peeking doesn't advance */
+  mf = gst_m3u8_get_next_fragment (pl, TRUE, NULL, NULL);
+  fail_unless (mf != NULL);
+  assert_equals_uint64 (mf->offset, 100);
+  gst_m3u8_media_file_unref (mf);
+
+  gst_hls_master_playlist_unref (master);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_low_latency_playlist)
+{
+  GstHLSMasterPlaylist *master;
+  GstM3U8 *pl;
+  GstM3U8MediaFile *mf;
+  gchar *uri;
+
+  master = load_playlist (LOW_LATENCY_PLAYLIST);
+  pl = master->default_variant->m3u8;
+
+  assert_equals_uint64 (gst_m3u8_get_part_target (pl), GST_SECOND);
+  assert_equals_uint64 (pl->part_hold_back, 4 * GST_SECOND);
+  fail_unless (gst_m3u8_can_block_reload (pl));
+
+  assert_equals_int (g_list_length (pl->files), 3);
+  mf = g_list_last (pl->files)->data;
+  assert_equals_string (mf->uri, "http://localhost/seg12.mp4");
+  fail_unless (mf->parts != NULL);
+  assert_equals_int (mf->parts->len, 4);
+
+  fail_unless (pl->partial_file != NULL);
+  assert_equals_int (pl->partial_file->sequence, 13);
+  assert_equals_int (pl->partial_file->parts->len, 3);
+  assert_equals_uint64 (pl->partial_file->duration, 3 * GST_SECOND);
+
+  /* Starts at the independent part 4 seconds from the end */
+  mf = gst_m3u8_get_next_fragment (pl, TRUE, NULL, NULL);
+  fail_unless (mf != NULL);
+  assert_equals_string (mf->uri, "http://localhost/seg12.2.mp4");
+  fail_unless (mf->independent);
+  gst_m3u8_media_file_unref (mf);
+  /* No prefetching of parts */
+  fail_unless (gst_m3u8_peek_fragment (pl, TRUE, 1) == NULL);
+
+  gst_m3u8_advance_fragment (pl, TRUE);
+  mf = gst_m3u8_get_next_fragment (pl, TRUE, NULL, NULL);
+  fail_unless (mf != NULL);
+  assert_equals_string (mf->uri, "http://localhost/seg12.3.mp4");
+  gst_m3u8_media_file_unref (mf);
+
+  /* Continues with the parts of the segment being produced */
+  gst_m3u8_advance_fragment (pl, TRUE);
+  mf = gst_m3u8_get_next_fragment (pl, TRUE, NULL, NULL);
+  fail_unless (mf != NULL);
+  assert_equals_string (mf->uri, "http://localhost/seg13.mp4");
+  assert_equals_int64 (mf->offset, 0);
+  assert_equals_int64 (mf->size, 1000);
+  gst_m3u8_media_file_unref (mf);
+
+  gst_m3u8_advance_fragment (pl, TRUE);
+  mf = gst_m3u8_get_next_fragment (pl, TRUE, NULL, NULL);
+  fail_unless (mf != NULL);
+  assert_equals_int64 (mf->offset, 1000);
+  assert_equals_int64 (mf->size, 1200);
+  gst_m3u8_media_file_unref (mf);
+
+  gst_m3u8_advance_fragment (pl, TRUE);
+  mf = gst_m3u8_get_next_fragment (pl, TRUE, NULL, NULL);
+  fail_unless (mf != NULL);
+  fail_unless (mf->preload_hint);
+  assert_equals_int64 (mf->offset, 2200);
+  assert_equals_int64 (mf->size, -1);
+  gst_m3u8_media_file_unref (mf);
+
+  /* The next part isn't announced yet */
+  gst_m3u8_advance_fragment (pl, TRUE);
+  fail_unless (gst_m3u8_get_next_fragment (pl, TRUE, NULL, NULL) == NULL);
+
+  uri = gst_m3u8_get_blocking_reload_uri (pl);
+  assert_equals_string (uri,
+      "http://localhost/test.m3u8?_HLS_msn=13&_HLS_part=2");
+  g_free (uri);
+
+  gst_hls_master_playlist_unref (master);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_get_duration)
 {
   GstHLSMasterPlaylist *master;
@@ -1491,6 +1692,7 @@ hlsdemux_suite (void)
   tcase_add_test (tc_m3u8, test_empty_lines_playlist);
   tcase_add_test (tc_m3u8, test_live_playlist);
   tcase_add_test (tc_m3u8, test_live_playlist_rotated);
+  tcase_add_test (tc_m3u8, test_live_playlist_update_keeps_files);
   tcase_add_test (tc_m3u8, test_playlist_with_doubles_duration);
   tcase_add_test (tc_m3u8, test_playlist_with_encryption);
   tcase_add_test (tc_m3u8, test_update_invalid_playlist);
@@ -1498,6 +1700,8 @@ hlsdemux_suite (void)
   tcase_add_test (tc_m3u8, test_playlist_media_files);
   tcase_add_test (tc_m3u8, test_playlist_byte_range_media_files);
   tcase_add_test (tc_m3u8, test_get_next_fragment);
+  tcase_add_test (tc_m3u8, test_peek_fragment);
+  tcase_add_test (tc_m3u8, test_low_latency_playlist);
   tcase_add_test (tc_m3u8, test_get_duration);
   tcase_add_test (tc_m3u8, test_get_target_duration);
   tcase_add_test (tc_m3u8, test_get_stream_for_bitrate);
@@ -23,6 +23,8 @@
 #include <unistd.h>
 
 #include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/codecparsers/gstjpegrestartmeta.h>
 
 /* This test doesn't use actual JPEG data, but some fake data that we know
    will trigger certain paths in jpegparse. */
@@ -150,6 +152,22 @@ guint8 test_data_sof0[] = {
 
 guint8 test_data_eoi[] = { 0xff, 0xd9 };
 
+guint8 test_data_restart[] = {
+  0xff, 0xd8,                   /* SOI */
+  0xff, 0xdd, 0x00, 0x04,       /* DRI */
+  0x00, 0x01,                   /* 1 MCU per interval */
+  0xff, 0xc0, 0x00, 0x11, 0x08, 0x00, 0x3c, 0x00, 0x50, 0x03,   /* SOF0 */
+  0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11, 0x01,
+  0xff, 0xda, 0x00, 0x08,       /* SOS */
+  0x01, 0x01, 0x00, 0x00, 0x3f, 0x00,
+  /* 37: */ 0x12, 0x34, 0xff, 0x00, 0x56,
+  0xff, 0xd0,                   /* RST0 */
+  /* 44: */ 0x78, 0x9a,
+  0xff, 0xd1,                   /* RST1 */
+  /* 48: */ 0xbc,
+  0xff, 0xd9,                   /* EOI */
+};
+
 static GList *
 _make_buffers_in (GList * buffer_in, guint8 * test_data, gsize test_data_size)
 {
@@ -367,6 +385,63 @@ GST_START_TEST (test_parse_comment)
 
 GST_END_TEST;
 
+GST_START_TEST (test_parse_restart_meta)
+{
+  GstHarness *h;
+  GstQuery *query;
+  GstCaps *caps;
+  GstBuffer *buffer;
+  GstJpegRestartMeta *meta;
+
+  h = gst_harness_new ("jpegparse");
+  gst_harness_set_src_caps_str (h, "image/jpeg");
+
+  /* no meta until downstream asked for it */
+  buffer = gst_buffer_new_wrapped (g_memdup (test_data_restart,
+          sizeof (test_data_restart)), sizeof (test_data_restart));
+  fail_unless_equals_int (gst_harness_push (h, buffer), GST_FLOW_OK);
+  gst_harness_push_event (h, gst_event_new_eos ());
+  buffer = gst_harness_pull (h);
+  fail_unless (gst_buffer_get_jpeg_restart_meta (buffer) == NULL);
+  gst_buffer_unref (buffer);
+  gst_harness_teardown (h);
+
+  h = gst_harness_new ("jpegparse");
+  gst_harness_add_propose_allocation_meta (h, GST_JPEG_RESTART_META_API_TYPE,
+      NULL);
+  gst_harness_set_src_caps_str (h, "image/jpeg");
+
+  caps = gst_caps_new_empty_simple ("image/jpeg");
+  query = gst_query_new_allocation (caps, FALSE);
+  fail_unless (gst_pad_peer_query (h->srcpad, query));
+  gst_query_unref (query);
+  gst_caps_unref (caps);
+
+  buffer = gst_buffer_new_wrapped (g_memdup (test_data_restart,
+          sizeof (test_data_restart)), sizeof (test_data_restart));
+  fail_unless_equals_int (gst_harness_push (h, buffer), GST_FLOW_OK);
+  gst_harness_push_event (h, gst_event_new_eos ());
+
+  buffer = gst_harness_pull (h);
+  fail_unless_equals_int (gst_buffer_get_size (buffer),
+      sizeof (test_data_restart));
+  meta = gst_buffer_get_jpeg_restart_meta (buffer);
+  fail_unless (meta != NULL);
+  fail_unless_equals_int (meta->restart_interval, 1);
+  fail_unless_equals_int (meta->n_intervals, 3);
+  fail_unless_equals_int (meta->offsets[0], 37);
+  fail_unless_equals_int (meta->sizes[0], 5);
+  fail_unless_equals_int (meta->offsets[1], 44);
+  fail_unless_equals_int (meta->sizes[1], 2);
+  fail_unless_equals_int (meta->offsets[2], 48);
+  fail_unless_equals_int (meta->sizes[2], 1);
+  gst_buffer_unref (buffer);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 static Suite *
 jpegparse_suite (void)
 {
@@ -378,6 +453,7 @@ jpegparse_suite (void)
   tcase_add_test (tc_chain, test_parse_all_in_one_buf);
   tcase_add_test (tc_chain, test_parse_app1_exif);
   tcase_add_test (tc_chain, test_parse_comment);
+  tcase_add_test (tc_chain, test_parse_restart_meta);
 
   return s;
 }
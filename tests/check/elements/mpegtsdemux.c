@@ -284,6 +284,41 @@ GST_START_TEST (test_tsparse_align_split)
 
 GST_END_TEST;
 
+GST_START_TEST (test_tsparse_program_threads)
+{
+  GstElement *tsparse;
+  GstHarness *h;
+  GstBuffer *buf;
+  gsize size = 0;
+
+  tsparse = gst_element_factory_make ("tsparse", NULL);
+  g_object_set (tsparse, "program-threads", TRUE, NULL);
+  h = gst_harness_new_with_element (tsparse, "sink", "program_1");
+  gst_object_unref (tsparse);
+
+  gst_harness_set_src_caps_str (h, "video/mpegts,systemstream=true");
+
+  buf =
+      gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY, (guint8 *) aac_ts,
+      sizeof aac_ts, 0, sizeof aac_ts, NULL, NULL);
+  fail_unless (gst_harness_push (h, buf) == GST_FLOW_OK);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  /* the program pad is pushed from its own thread, wait for it to drain */
+  while (gst_harness_pull_until_eos (h, &buf) && buf) {
+    size += gst_buffer_get_size (buf);
+    gst_buffer_unref (buf);
+  }
+
+  fail_unless (size > 0);
+  fail_unless (size % PACKETSIZE == 0);
+  fail_unless (size <= sizeof aac_ts);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_tsparse_padding)
 {
   GstHarness *h = gst_harness_new ("tsparse");
@@ -377,6 +412,46 @@ GST_START_TEST (test_tsdemux_simple)
 
 GST_END_TEST;
 
+GST_START_TEST (test_tsdemux_resync)
+{
+  GstHarness *h = gst_harness_new_with_padnames ("tsdemux", "sink", NULL);
+  GstBuffer *buf;
+  GstCaps *caps;
+  GstSegment segment;
+  GstMapInfo map;
+
+  caps = gst_caps_from_string ("video/mpegts,systemstream=true");
+  gst_harness_push_event (h, gst_event_new_caps (caps));
+  gst_caps_unref (caps);
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_harness_push_event (h, gst_event_new_segment (&segment));
+
+  gst_harness_set_sink_caps_str (h,
+      "audio/mpeg,mpegversion=4,stream-format=adts");
+
+  g_signal_connect (h->element, "pad-added",
+      G_CALLBACK (tsdemux_simple_pad_added), h);
+
+  /* Prepend some garbage the packetizer has to skip before finding sync */
+  buf = gst_buffer_new_allocate (NULL, 100 + sizeof aac_ts, NULL);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  memset (map.data, 0xff, 100);
+  memcpy (map.data + 100, aac_ts, sizeof aac_ts);
+  gst_buffer_unmap (buf, &map);
+
+  fail_unless (gst_harness_push (h, buf) == GST_FLOW_OK);
+  gst_harness_push_event (h, gst_event_new_eos ());
+
+  buf = gst_harness_take_all_data_as_buffer (h);
+  gst_check_buffer_data (buf, aac_data, sizeof aac_data);
+  gst_buffer_unref (buf);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 static Suite *
 mpegtsdemux_suite (void)
 {
@@ -390,10 +465,12 @@ mpegtsdemux_suite (void)
   tcase_add_test (tc, test_tsparse_align_fuse);
   tcase_add_test (tc, test_tsparse_align_split);
   tcase_add_test (tc, test_tsparse_padding);
+  tcase_add_test (tc, test_tsparse_program_threads);
 
   tc = tcase_create ("tsdemux");
   suite_add_tcase (s, tc);
   tcase_add_test (tc, test_tsdemux_simple);
+  tcase_add_test (tc, test_tsdemux_resync);
 
   return s;
 }
@@ -557,6 +557,86 @@ GST_START_TEST (test_align)
 
 GST_END_TEST;
 
+static void
+test_align_pooled_check_output (GList * bufs)
+{
+  test_align_check_output (bufs);
+
+  while (bufs != NULL) {
+    GstBuffer *buf = bufs->data;
+    GstMapInfo map;
+    gsize i;
+
+    fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+    for (i = 0; i < map.size; i += 188)
+      fail_unless_equals_int (map.data[i], 0x47);
+    gst_buffer_unmap (buf, &map);
+    bufs = bufs->next;
+  }
+}
+
+GST_START_TEST (test_align_pooled)
+{
+  gchar *padname;
+  GstElement *mux;
+
+  mux = setup_tsmux (&video_src_template, "sink_%d", &padname);
+
+  g_object_set (mux, "alignment", 7, "packets-per-buffer", 7, NULL);
+
+  fail_unless (gst_element_set_state (mux,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  check_tsmux_pad_given_muxer (mux, VIDEO_CAPS_STRING, 0xE0, 0x1b,
+      test_align_pooled_check_output, 817, -1);
+
+  cleanup_tsmux (mux, padname);
+  g_free (padname);
+}
+
+GST_END_TEST;
+
+static void
+test_cbr_check_output (GList * bufs)
+{
+  GstClockTime next_pts = 0;
+
+  GST_LOG ("%u buffers", g_list_length (bufs));
+  while (bufs != NULL) {
+    GstBuffer *buf = bufs->data;
+
+    fail_unless (GST_BUFFER_PTS_IS_VALID (buf));
+    fail_unless (GST_BUFFER_DURATION_IS_VALID (buf));
+    /* packets are paced back to back at the configured bitrate */
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (buf), next_pts);
+    next_pts = GST_BUFFER_PTS (buf) + GST_BUFFER_DURATION (buf);
+    bufs = bufs->next;
+  }
+}
+
+GST_START_TEST (test_cbr)
+{
+  gchar *padname;
+  GstElement *mux;
+
+  mux = setup_tsmux (&video_src_template, "sink_%d", &padname);
+
+  g_object_set (mux, "bitrate", (guint64) 10000000, NULL);
+
+  fail_unless (gst_element_set_state (mux,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  check_tsmux_pad_given_muxer (mux, VIDEO_CAPS_STRING, 0xE0, 0x1b,
+      test_cbr_check_output, 50, -1);
+
+  cleanup_tsmux (mux, padname);
+  g_free (padname);
+}
+
+GST_END_TEST;
+
 static void
 test_keyframe_propagation_check_output (GList * bufs)
 {
@@ -598,6 +678,8 @@ mpegtsmux_suite (void)
   tcase_add_test (tc_chain, test_video);
   tcase_add_test (tc_chain, test_multiple_state_change);
   tcase_add_test (tc_chain, test_align);
+  tcase_add_test (tc_chain, test_align_pooled);
+  tcase_add_test (tc_chain, test_cbr);
   tcase_add_test (tc_chain, test_keyframe_flag_propagation);
   tcase_add_test (tc_chain, test_reappearing_pad_while_playing);
   tcase_add_test (tc_chain, test_reappearing_pad_while_stopped);
@@ -294,6 +294,86 @@ GST_START_TEST (test_parse_cea708_captions)
 
 GST_END_TEST;
 
+GST_START_TEST (test_parse_gop_index)
+{
+  GArray *keyframe_pts;
+  GstHarness *h;
+  GstBuffer *buf;
+  GstQuery *query;
+  const GstStructure *s;
+  const GValue *entries;
+  guint64 last_offset = 0;
+  gchar *fn;
+  guint i, j;
+
+  h = gst_harness_new_parse ("filesrc name=filesrc ! "
+      "mpegvideoparse gop-index=true");
+
+  fn = g_build_filename (GST_TEST_FILES_PATH, "mpeg2-es-with-cea708-cc.dat",
+      NULL);
+  gst_harness_set (h, "filesrc", "location", fn, NULL);
+  g_free (fn);
+
+  gst_harness_play (h);
+
+  keyframe_pts = g_array_new (FALSE, FALSE, sizeof (GstClockTime));
+  for (i = 0; i < 50; ++i) {
+    buf = gst_harness_pull (h);
+    if (!GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT))
+      g_array_append_val (keyframe_pts, GST_BUFFER_PTS (buf));
+    gst_buffer_unref (buf);
+  }
+  fail_unless (keyframe_pts->len > 0);
+
+  query = gst_query_new_custom (GST_QUERY_CUSTOM,
+      gst_structure_new_empty ("GstMpegvParseGopIndex"));
+  fail_unless (gst_pad_peer_query (h->sinkpad, query));
+
+  s = gst_query_get_structure (query);
+  entries = gst_structure_get_value (s, "entries");
+  fail_unless (entries != NULL);
+  fail_unless (gst_value_array_get_size (entries) >= keyframe_pts->len);
+
+  /* sorted on offset, without duplicates */
+  for (i = 0; i < gst_value_array_get_size (entries); i++) {
+    const GstStructure *entry =
+        gst_value_get_structure (gst_value_array_get_value (entries, i));
+    guint64 offset;
+
+    fail_unless (gst_structure_get_uint64 (entry, "offset", &offset));
+    if (i > 0)
+      fail_unless (offset > last_offset);
+    last_offset = offset;
+    fail_unless (gst_structure_has_field_typed (entry, "temporal-reference",
+            G_TYPE_UINT));
+    fail_unless (gst_structure_has_field_typed (entry, "gop",
+            G_TYPE_BOOLEAN));
+  }
+
+  /* every keyframe that went out is indexed */
+  for (j = 0; j < keyframe_pts->len; j++) {
+    GstClockTime pts = g_array_index (keyframe_pts, GstClockTime, j);
+    gboolean found = FALSE;
+
+    for (i = 0; !found && i < gst_value_array_get_size (entries); i++) {
+      const GstStructure *entry =
+          gst_value_get_structure (gst_value_array_get_value (entries, i));
+      guint64 entry_pts;
+
+      fail_unless (gst_structure_get_uint64 (entry, "pts", &entry_pts));
+      found = (entry_pts == pts);
+    }
+    fail_unless (found, "keyframe %" GST_TIME_FORMAT " not in the index",
+        GST_TIME_ARGS (pts));
+  }
+
+  gst_query_unref (query);
+  g_array_free (keyframe_pts, TRUE);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 static Suite *
 mpegvideoparse_suite (void)
 {
@@ -318,6 +398,7 @@ mpegvideoparse_suite (void)
   tcase_add_test (tc_chain, test_parse_detect_stream_mpeg2);
   tcase_add_test (tc_chain, test_parse_gop_split);
   tcase_add_test (tc_chain, test_parse_cea708_captions);
+  tcase_add_test (tc_chain, test_parse_gop_index);
 
   return s;
 }
@@ -39,7 +39,7 @@ run_split_superframe_with_caps (const gchar * in_caps)
 {
   GstHarness *h;
   GstBuffer *in_buf, *out_buf = NULL;
-  GstMapInfo map;
+  GstMapInfo map, out_map;
   GstFlowReturn ret;
   gint i = 0;
   GstVp9ParseTestFrameData frames[] = {
@@ -64,6 +64,8 @@ run_split_superframe_with_caps (const gchar * in_caps)
     memcpy (map.data, frames[i].data, frames[i].len);
     gst_buffer_unmap (in_buf, &map);
 
+    /* keep the input around to check that sub-frames share its memory */
+    gst_buffer_ref (in_buf);
     ret = gst_harness_push (h, in_buf);
     fail_unless (ret == GST_FLOW_OK, "GstFlowReturn was %s",
         gst_flow_get_name (ret));
@@ -109,11 +111,16 @@ run_split_superframe_with_caps (const gchar * in_caps)
     }
 
     if (frames[i].superframe) {
+      gst_buffer_map (in_buf, &map, GST_MAP_READ);
+
       /* this is decoding only frame */
       fail_unless (GST_BUFFER_FLAG_IS_SET (out_buf,
               GST_BUFFER_FLAG_DECODE_ONLY));
       fail_unless (GST_BUFFER_FLAG_IS_SET (out_buf,
               GST_BUFFER_FLAG_DELTA_UNIT));
+      gst_buffer_map (out_buf, &out_map, GST_MAP_READ);
+      fail_unless (out_map.data == map.data);
+      gst_buffer_unmap (out_buf, &out_map);
       gst_clear_buffer (&out_buf);
 
       out_buf = gst_harness_try_pull (h);
@@ -122,9 +129,15 @@ run_split_superframe_with_caps (const gchar * in_caps)
           frames[i].subframe_len[1]);
       fail_unless (GST_BUFFER_FLAG_IS_SET (out_buf,
               GST_BUFFER_FLAG_DELTA_UNIT));
+      gst_buffer_map (out_buf, &out_map, GST_MAP_READ);
+      fail_unless (out_map.data == map.data + frames[i].subframe_len[0]);
+      gst_buffer_unmap (out_buf, &out_map);
+
+      gst_buffer_unmap (in_buf, &map);
     }
 
     gst_clear_buffer (&out_buf);
+    gst_buffer_unref (in_buf);
   }
 
   gst_harness_teardown (h);
@@ -976,6 +976,62 @@ GST_START_TEST (test_ice_port_restriction)
 
 GST_END_TEST;
 
+static void
+_check_ice_lite (struct test_webrtc *t, GstElement * element,
+    GstWebRTCSessionDescription * desc, gpointer user_data)
+{
+  gboolean expected = GPOINTER_TO_INT (user_data);
+  gboolean have_ice_lite = FALSE;
+  guint i;
+
+  for (i = 0; i < gst_sdp_message_attributes_len (desc->sdp); i++) {
+    const GstSDPAttribute *attr = gst_sdp_message_get_attribute (desc->sdp, i);
+
+    if (g_strcmp0 (attr->key, "ice-lite") == 0)
+      have_ice_lite = TRUE;
+  }
+
+  fail_unless_equals_int (have_ice_lite, expected);
+}
+
+GST_START_TEST (test_ice_lite)
+{
+  struct test_webrtc *t = create_audio_test ();
+  VAL_SDP_INIT (offer_lite, _check_ice_lite, GINT_TO_POINTER (FALSE), NULL);
+  VAL_SDP_INIT (offer, _count_num_sdp_media, GUINT_TO_POINTER (1),
+      &offer_lite);
+  VAL_SDP_INIT (answer_lite, _check_ice_lite, GINT_TO_POINTER (TRUE), NULL);
+  VAL_SDP_INIT (answer, _count_num_sdp_media, GUINT_TO_POINTER (1),
+      &answer_lite);
+  GObject *webrtcice, *agent;
+  gboolean controlling;
+
+  /* the answerer is a lite agent, the offerer has to take control */
+  g_object_get (t->webrtc2, "ice-agent", &webrtcice, NULL);
+  g_object_set (webrtcice, "ice-lite", TRUE, NULL);
+  g_object_unref (webrtcice);
+
+  test_validate_sdp (t, &offer, &answer);
+
+  g_object_get (t->webrtc1, "ice-agent", &webrtcice, NULL);
+  g_object_get (webrtcice, "agent", &agent, NULL);
+  g_object_get (agent, "controlling-mode", &controlling, NULL);
+  fail_unless (controlling);
+  g_object_unref (agent);
+  g_object_unref (webrtcice);
+
+  g_object_get (t->webrtc2, "ice-agent", &webrtcice, NULL);
+  g_object_get (webrtcice, "agent", &agent, NULL);
+  g_object_get (agent, "controlling-mode", &controlling, NULL);
+  fail_unless (!controlling);
+  g_object_unref (agent);
+  g_object_unref (webrtcice);
+
+  test_webrtc_free (t);
+}
+
+GST_END_TEST;
+
 static struct test_webrtc *
 create_audio_video_test (void)
 {
@@ -1489,6 +1545,55 @@ GST_START_TEST (test_session_stats)
 
 GST_END_TEST;
 
+static gboolean
+_check_only_peer_connection_stats (GQuark field_id, const GValue * value,
+    gpointer user_data)
+{
+  GstWebRTCStatsType type;
+
+  fail_unless (GST_VALUE_HOLDS_STRUCTURE (value));
+  gst_structure_get (gst_value_get_structure (value), "type",
+      GST_TYPE_WEBRTC_STATS_TYPE, &type, NULL);
+  fail_unless_equals_int (type, GST_WEBRTC_STATS_PEER_CONNECTION);
+
+  return TRUE;
+}
+
+static void
+_on_pushed_stats (GstElement * webrtc, const GstStructure * stats,
+    struct test_webrtc *t)
+{
+  validate_stats (stats);
+  gst_structure_foreach (stats, _check_only_peer_connection_stats, NULL);
+
+  if (g_atomic_int_add ((gint *) t->user_data, 1) == 1)
+    test_webrtc_signal_state (t, STATE_CUSTOM);
+}
+
+GST_START_TEST (test_session_stats_interval)
+{
+  struct test_webrtc *t = test_webrtc_new ();
+  const gchar *types[] = { "peer-connection", NULL };
+  gint n_stats = 0;
+
+  /* test that stats are periodically pushed and filtered by type */
+  t->on_negotiation_needed = NULL;
+  t->user_data = &n_stats;
+  test_validate_sdp (t, NULL, NULL);
+
+  g_signal_connect (t->webrtc1, "on-stats", G_CALLBACK (_on_pushed_stats), t);
+  g_object_set (t->webrtc1, "stats-types", types, "stats-max-age", 5,
+      "stats-interval", 10, NULL);
+
+  test_webrtc_wait_for_state_mask (t, 1 << STATE_CUSTOM);
+
+  g_object_set (t->webrtc1, "stats-interval", 0, NULL);
+
+  test_webrtc_free (t);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_add_transceiver)
 {
   struct test_webrtc *t = test_webrtc_new ();
@@ -1566,6 +1671,75 @@ GST_START_TEST (test_add_recvonly_transceiver)
 
 GST_END_TEST;
 
+typedef struct
+{
+  const gchar *simulcast;
+  const gchar **rids;
+} ExpectedSimulcast;
+
+static void
+on_sdp_media_simulcast (struct test_webrtc *t, GstElement * element,
+    GstWebRTCSessionDescription * desc, gpointer user_data)
+{
+  ExpectedSimulcast *expected = user_data;
+  const GstSDPMedia *media = gst_sdp_message_get_media (desc->sdp, 0);
+  guint i, n_rids = 0;
+
+  fail_unless_equals_string (gst_sdp_media_get_attribute_val (media,
+          "simulcast"), expected->simulcast);
+
+  for (i = 0; i < gst_sdp_media_attributes_len (media); i++) {
+    const GstSDPAttribute *attr = gst_sdp_media_get_attribute (media, i);
+
+    if (g_strcmp0 (attr->key, "rid") == 0) {
+      fail_unless (expected->rids[n_rids] != NULL);
+      fail_unless_equals_string (attr->value, expected->rids[n_rids]);
+      n_rids++;
+    }
+  }
+  fail_unless (expected->rids[n_rids] == NULL);
+}
+
+GST_START_TEST (test_simulcast_rids)
+{
+  struct test_webrtc *t = test_webrtc_new ();
+  GstWebRTCRTPTransceiverDirection direction;
+  GstWebRTCRTPTransceiver *trans;
+  const gchar *offer_rids[] = { "h recv", "l recv max-width=320", NULL };
+  const gchar *answer_rids[] = { "h send", "l send max-width=320", NULL };
+  ExpectedSimulcast expected_offer = { "recv h;l", offer_rids };
+  ExpectedSimulcast expected_answer = { "send h;l", answer_rids };
+  VAL_SDP_INIT (offer, on_sdp_media_simulcast, &expected_offer, NULL);
+  VAL_SDP_INIT (answer, on_sdp_media_simulcast, &expected_answer, NULL);
+  GstCaps *caps;
+  GstHarness *h;
+
+  /* add a transceiver that will receive two simulcast layers and check that
+   * the answer accepts both of them for sending */
+  t->on_negotiation_needed = NULL;
+  t->on_ice_candidate = NULL;
+  t->on_pad_added = _pad_added_fakesink;
+
+  caps = gst_caps_from_string (VP8_RTP_CAPS (96)
+      ",rid-h=(string)recv,rid-l=(string)\"recv max-width=320\"");
+  direction = GST_WEBRTC_RTP_TRANSCEIVER_DIRECTION_RECVONLY;
+  g_signal_emit_by_name (t->webrtc1, "add-transceiver", direction, caps,
+      &trans);
+  gst_caps_unref (caps);
+  fail_unless (trans != NULL);
+  gst_object_unref (trans);
+
+  /* setup sendonly peer */
+  h = gst_harness_new_with_element (t->webrtc2, "sink_0", NULL);
+  add_fake_video_src_harness (h, 96);
+  t->harnesses = g_list_prepend (t->harnesses, h);
+  test_validate_sdp (t, &offer, &answer);
+
+  test_webrtc_free (t);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_recvonly_sendonly)
 {
   struct test_webrtc *t = test_webrtc_new ();
@@ -1886,6 +2060,91 @@ GST_START_TEST (test_data_channel_transfer_data)
 
 GST_END_TEST;
 
+static void
+on_message_data_list (GObject * channel, GBytes * data, struct test_webrtc *t)
+{
+  GQueue *expected = g_object_get_data (channel, "expected");
+  GBytes *next;
+
+  next = g_queue_pop_head (expected);
+  fail_unless (next != NULL);
+  g_assert_cmpbytes (data, next);
+  g_bytes_unref (next);
+
+  if (g_queue_is_empty (expected))
+    test_webrtc_signal_state (t, STATE_CUSTOM);
+}
+
+static void
+_free_bytes_queue (GQueue * queue)
+{
+  g_queue_free_full (queue, (GDestroyNotify) g_bytes_unref);
+}
+
+static void
+have_data_channel_transfer_data_list (struct test_webrtc *t,
+    GstElement * element, GObject * our, gpointer user_data)
+{
+  GObject *other = user_data;
+  GPtrArray *data =
+      g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+  GQueue *expected = g_queue_new ();
+  guint i;
+
+  for (i = 0; i < 3; i++) {
+    GBytes *bytes = g_bytes_new_static (test_string, strlen (test_string) - i);
+
+    g_ptr_array_add (data, bytes);
+    g_queue_push_tail (expected, g_bytes_ref (bytes));
+  }
+
+  g_object_set_data_full (our, "expected", expected,
+      (GDestroyNotify) _free_bytes_queue);
+  g_signal_connect (our, "on-message-data", G_CALLBACK (on_message_data_list),
+      t);
+
+  g_signal_connect (other, "on-error",
+      G_CALLBACK (on_channel_error_not_reached), NULL);
+  g_signal_emit_by_name (other, "send-data-list", data);
+  g_ptr_array_unref (data);
+}
+
+GST_START_TEST (test_data_channel_transfer_data_list)
+{
+  struct test_webrtc *t = test_webrtc_new ();
+  GObject *channel = NULL;
+  VAL_SDP_INIT (offer, on_sdp_has_datachannel, NULL, NULL);
+  VAL_SDP_INIT (answer, on_sdp_has_datachannel, NULL, NULL);
+
+  t->on_negotiation_needed = NULL;
+  t->on_ice_candidate = NULL;
+  t->on_data_channel = have_data_channel_transfer_data_list;
+
+  fail_if (gst_element_set_state (t->webrtc1,
+          GST_STATE_READY) == GST_STATE_CHANGE_FAILURE);
+  fail_if (gst_element_set_state (t->webrtc2,
+          GST_STATE_READY) == GST_STATE_CHANGE_FAILURE);
+
+  g_signal_emit_by_name (t->webrtc1, "create-data-channel", "label", NULL,
+      &channel);
+  g_assert_nonnull (channel);
+  t->data_channel_data = channel;
+  g_signal_connect (channel, "on-error",
+      G_CALLBACK (on_channel_error_not_reached), NULL);
+
+  fail_if (gst_element_set_state (t->webrtc1,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE);
+  fail_if (gst_element_set_state (t->webrtc2,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE);
+
+  test_validate_sdp_full (t, &offer, &answer, 1 << STATE_CUSTOM, FALSE);
+
+  g_object_unref (channel);
+  test_webrtc_free (t);
+}
+
+GST_END_TEST;
+
 static void
 have_data_channel_create_data_channel (struct test_webrtc *t,
     GstElement * element, GObject * our, gpointer user_data)
@@ -3059,14 +3318,17 @@ webrtcbin_suite (void)
   if (nicesrc && nicesink && dtlssrtpenc && dtlssrtpdec) {
     tcase_add_test (tc, test_sdp_no_media);
     tcase_add_test (tc, test_session_stats);
+    tcase_add_test (tc, test_session_stats_interval);
     tcase_add_test (tc, test_audio);
     tcase_add_test (tc, test_ice_port_restriction);
+    tcase_add_test (tc, test_ice_lite);
     tcase_add_test (tc, test_audio_video);
     tcase_add_test (tc, test_media_direction);
     tcase_add_test (tc, test_media_setup);
     tcase_add_test (tc, test_add_transceiver);
     tcase_add_test (tc, test_get_transceivers);
     tcase_add_test (tc, test_add_recvonly_transceiver);
+    tcase_add_test (tc, test_simulcast_rids);
     tcase_add_test (tc, test_recvonly_sendonly);
     tcase_add_test (tc, test_payload_types);
     tcase_add_test (tc, test_bundle_audio_video_max_bundle_max_bundle);
@@ -3086,6 +3348,7 @@ webrtcbin_suite (void)
       tcase_add_test (tc, test_data_channel_remote_notify);
       tcase_add_test (tc, test_data_channel_transfer_string);
       tcase_add_test (tc, test_data_channel_transfer_data);
+      tcase_add_test (tc, test_data_channel_transfer_data_list);
       tcase_add_test (tc, test_data_channel_create_after_negotiate);
       tcase_add_test (tc, test_data_channel_low_threshold);
       tcase_add_test (tc, test_data_channel_max_message_size);
@@ -229,6 +229,43 @@ GST_START_TEST (test_h264_parse_slice_5bytes)
 
 GST_END_TEST;
 
+GST_START_TEST (test_h264_parse_start_code_offsets)
+{
+  GstH264ParserResult res;
+  GstH264NalUnit nalu;
+  GstH264NalParser *const parser = gst_h264_nal_parser_new ();
+  guint8 buf[96];
+  guint sc, end;
+
+  /* Move a start code and the next one across every position so that the
+   * vectorized scanner sees them in each lane and in the scalar tail */
+  for (sc = 0; sc + 8 < sizeof (buf); sc++) {
+    for (end = sc + 5; end + 4 <= sizeof (buf); end += 7) {
+      memset (buf, 0xff, sizeof (buf));
+      buf[sc] = 0x00;
+      buf[sc + 1] = 0x00;
+      buf[sc + 2] = 0x01;
+      buf[sc + 3] = 0x09;
+      buf[end] = 0x00;
+      buf[end + 1] = 0x00;
+      buf[end + 2] = 0x01;
+      buf[end + 3] = 0x09;
+
+      res = gst_h264_parser_identify_nalu (parser, buf, 0, sizeof (buf),
+          &nalu);
+
+      assert_equals_int (res, GST_H264_PARSER_OK);
+      assert_equals_int (nalu.sc_offset, sc);
+      assert_equals_int (nalu.type, GST_H264_NAL_AU_DELIMITER);
+      assert_equals_int (nalu.size, end - sc - 3);
+    }
+  }
+
+  gst_h264_nal_parser_free (parser);
+}
+
+GST_END_TEST;
+
 static guint8 nalu_sps_with_vui[] = {
   0x00, 0x00, 0x00, 0x01, 0x67, 0x64, 0x00, 0x28,
   0xac, 0xd9, 0x40, 0x78, 0x04, 0x4f, 0xde, 0x03,
@@ -666,6 +703,7 @@ h264parser_suite (void)
   tcase_add_test (tc_chain, test_h264_parse_slice_dpa);
   tcase_add_test (tc_chain, test_h264_parse_slice_eoseq_slice);
   tcase_add_test (tc_chain, test_h264_parse_slice_5bytes);
+  tcase_add_test (tc_chain, test_h264_parse_start_code_offsets);
   tcase_add_test (tc_chain, test_h264_parse_invalid_sei);
   tcase_add_test (tc_chain, test_h264_create_sei);
 
@@ -62,6 +62,19 @@ success_cb (GstInsertBin * insertbin, GstElement * element, gboolean success,
   cb_count++;
 }
 
+static void
+timeout_cb (GstInsertBin * insertbin, GstElement * element, gboolean success,
+    gpointer user_data)
+{
+  gboolean *timed_out = user_data;
+
+  fail_unless (success == FALSE);
+  g_mutex_lock (&lock);
+  *timed_out = TRUE;
+  g_cond_broadcast (&cond);
+  g_mutex_unlock (&lock);
+}
+
 static void
 fail_cb (GstInsertBin * insertbin, GstElement * element, gboolean success,
     gpointer user_data)
@@ -365,6 +378,108 @@ GST_START_TEST (test_insertbin_simple)
 
 GST_END_TEST;
 
+GST_START_TEST (test_insertbin_transaction)
+{
+  GstElement *insertbin;
+  GstElement *elem;
+  GstElement *elem2;
+  GstElement *elem3;
+  GstElement *elem4;
+  GstPad *srcpad;
+  GstPad *sinkpad;
+  GstCaps *caps;
+  gboolean timed_out = FALSE;
+
+  g_mutex_init (&lock);
+  g_cond_init (&cond);
+
+  insertbin = gst_insert_bin_new (NULL);
+  fail_unless (insertbin != NULL);
+  srcpad = gst_check_setup_src_pad (insertbin, &srcpad_template);
+  sinkpad = gst_check_setup_sink_pad (insertbin, &sinkpad_template);
+
+  fail_unless (gst_pad_set_active (srcpad, TRUE));
+  fail_unless (gst_pad_set_active (sinkpad, TRUE));
+  fail_unless (gst_element_set_state (insertbin,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS);
+
+  caps = gst_caps_new_empty_simple ("video/test");
+  gst_check_setup_events (srcpad, insertbin, caps, GST_FORMAT_BYTES);
+  gst_caps_unref (caps);
+
+  push_thread = g_thread_self ();
+  push_buffer (srcpad, 0);
+
+  /* nothing happens before the commit, the sibling can be an element added
+   * in the same transaction, and the pads are idle so everything is applied
+   * from this thread */
+  elem = gst_element_factory_make ("identity", NULL);
+  elem2 = gst_element_factory_make ("identity", NULL);
+  elem3 = gst_element_factory_make ("identity", NULL);
+  gst_insert_bin_begin_transaction (GST_INSERT_BIN (insertbin));
+  gst_insert_bin_append (GST_INSERT_BIN (insertbin), elem, success_cb, NULL);
+  gst_insert_bin_append (GST_INSERT_BIN (insertbin), elem2, success_cb, NULL);
+  gst_insert_bin_insert_after (GST_INSERT_BIN (insertbin), elem3, elem,
+      success_cb, NULL);
+  check_reset_cb_count (0);
+  gst_insert_bin_commit_transaction (GST_INSERT_BIN (insertbin),
+      GST_CLOCK_TIME_NONE);
+  check_reset_cb_count (3);
+  push_buffer (srcpad, 0);
+
+  /* all changes are applied once the streaming thread is done */
+  push_thread = NULL;
+  block_thread ();
+  elem4 = gst_element_factory_make ("identity", NULL);
+  gst_insert_bin_begin_transaction (GST_INSERT_BIN (insertbin));
+  gst_insert_bin_remove (GST_INSERT_BIN (insertbin), elem3, success_cb, NULL);
+  gst_insert_bin_remove (GST_INSERT_BIN (insertbin), elem2, success_cb, NULL);
+  gst_insert_bin_prepend (GST_INSERT_BIN (insertbin), elem4, success_cb, NULL);
+  gst_insert_bin_commit_transaction (GST_INSERT_BIN (insertbin),
+      GST_CLOCK_TIME_NONE);
+  unblock_thread ();
+  check_reset_cb_count (3);
+  push_thread = g_thread_self ();
+  push_buffer (srcpad, 0);
+
+  /* the changes are dropped if the stream doesn't block in time */
+  push_thread = NULL;
+  block_thread ();
+  elem2 = gst_element_factory_make ("identity", NULL);
+  gst_object_ref (elem2);
+  gst_insert_bin_begin_transaction (GST_INSERT_BIN (insertbin));
+  gst_insert_bin_append (GST_INSERT_BIN (insertbin), elem2, timeout_cb,
+      &timed_out);
+  gst_insert_bin_commit_transaction (GST_INSERT_BIN (insertbin),
+      10 * GST_MSECOND);
+  g_mutex_lock (&lock);
+  while (!timed_out)
+    g_cond_wait (&cond, &lock);
+  g_mutex_unlock (&lock);
+  fail_unless (GST_OBJECT_PARENT (elem2) == NULL);
+  unblock_thread ();
+  push_thread = g_thread_self ();
+  push_buffer (srcpad, 0);
+  gst_object_unref (elem2);
+
+  fail_unless (gst_element_set_state (insertbin,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS);
+  gst_pad_set_active (srcpad, FALSE);
+  gst_pad_set_active (sinkpad, FALSE);
+
+  gst_check_teardown_sink_pad (insertbin);
+  gst_check_teardown_src_pad (insertbin);
+  gst_check_teardown_element (insertbin);
+
+  fail_unless (cb_count == 0);
+  push_thread = NULL;
+
+  g_mutex_clear (&lock);
+  g_cond_clear (&cond);
+}
+
+GST_END_TEST;
+
 
 static Suite *
 insert_bin_suite (void)
@@ -374,6 +489,7 @@ insert_bin_suite (void)
 
   suite_add_tcase (s, tc_basic);
   tcase_add_test (tc_basic, test_insertbin_simple);
+  tcase_add_test (tc_basic, test_insertbin_transaction);
 
   return s;
 }
@@ -245,6 +245,75 @@ GST_START_TEST (isoff_moof_parse_with_tfdt)
 
 GST_END_TEST;
 
+GST_START_TEST (isoff_moof_get_samples)
+{
+  /* INDENT-ON */
+  GstByteReader reader = GST_BYTE_READER_INIT (moof1, sizeof (moof1));
+  guint32 type;
+  guint header_size;
+  guint64 size, offset, decode_time;
+  GstMoofBox *moof;
+  GArray *samples;
+  guint i;
+
+  fail_unless (gst_isoff_parse_box_header (&reader, &type, NULL,
+          &header_size, &size));
+  moof = gst_isoff_moof_box_parse (&reader);
+  fail_unless (moof != NULL);
+
+  /* No tfdt, durations and data offsets from the tfhd/trun */
+  samples = gst_isoff_moof_box_get_samples (moof, 100);
+  fail_unless (samples != NULL);
+  fail_unless_equals_int (samples->len, 96);
+
+  offset = 100 + size + header_size;
+  for (i = 0; i < samples->len; i++) {
+    GstIsoffSample *sample = &g_array_index (samples, GstIsoffSample, i);
+
+    fail_unless_equals_int (sample->track_id, 1);
+    fail_unless_equals_uint64 (sample->offset, offset);
+    fail_unless_equals_int (sample->duration, 8);
+    fail_unless_equals_uint64 (sample->decode_time, GST_CLOCK_TIME_NONE);
+    fail_unless (sample->has_flags);
+    fail_unless_equals_int (sample->flags, i == 0 ? 0x02000000 : 0x01010000);
+    offset += sample->size;
+  }
+
+  g_array_free (samples, TRUE);
+  gst_isoff_moof_box_free (moof);
+
+  /* tfdt and default-base-is-moof */
+  gst_byte_reader_init (&reader, seg_2_m4f, sizeof (seg_2_m4f));
+  fail_unless (gst_isoff_parse_box_header (&reader, &type, NULL,
+          &header_size, &size));
+  moof = gst_isoff_moof_box_parse (&reader);
+  fail_unless (moof != NULL);
+
+  samples = gst_isoff_moof_box_get_samples (moof, 0);
+  fail_unless (samples != NULL);
+  fail_unless_equals_int (samples->len, 129);
+
+  offset = size + header_size;
+  decode_time = 132096;
+  for (i = 0; i < samples->len; i++) {
+    GstIsoffSample *sample = &g_array_index (samples, GstIsoffSample, i);
+
+    fail_unless_equals_int (sample->track_id, 2);
+    fail_unless_equals_uint64 (sample->offset, offset);
+    fail_unless_equals_int (sample->size, seg_2_sample_sizes[i]);
+    fail_unless_equals_int (sample->duration, seg_sample_duration);
+    fail_unless_equals_uint64 (sample->decode_time, decode_time);
+    fail_unless (!sample->has_flags);
+    offset += sample->size;
+    decode_time += sample->duration;
+  }
+
+  g_array_free (samples, TRUE);
+  gst_isoff_moof_box_free (moof);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (isoff_moof_parse_with_tfxd_tfrf)
 {
   GstByteReader reader =
@@ -356,6 +425,7 @@ dash_isoff_suite (void)
   tcase_add_test (tc_moof, isoff_moof_parse);
   tcase_add_test (tc_moof, isoff_moof_parse_with_tfdt);
   tcase_add_test (tc_moof, isoff_moof_parse_with_tfxd_tfrf);
+  tcase_add_test (tc_moof, isoff_moof_get_samples);
   suite_add_tcase (s, tc_moof);
 
   tcase_add_test (tc_moov, isoff_moov_parse);
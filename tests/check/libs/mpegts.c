@@ -667,6 +667,48 @@ GST_START_TEST (test_mpegts_dvb_descriptors)
 
 GST_END_TEST;
 
+static const guint8 descriptor_loop[] = {
+  /* registration descriptor */
+  0x05, 0x04, 0x48, 0x44, 0x4d, 0x56,
+  /* network name descriptor */
+  0x40, 0x04, 0x4e, 0x61, 0x6d, 0x65,
+  /* truncated descriptor */
+  0x48, 0x0f, 0x01
+};
+
+GST_START_TEST (test_mpegts_descriptor_iter)
+{
+  GstMpegtsDescriptorIter iter;
+  GstMpegtsDescriptor desc;
+  gchar *name = NULL;
+
+  gst_mpegts_descriptor_iter_init (&iter, descriptor_loop,
+      sizeof (descriptor_loop));
+
+  fail_unless (gst_mpegts_descriptor_iter_next (&iter, &desc));
+  fail_unless (desc.tag == 0x05);
+  fail_unless (desc.length == 4);
+  fail_unless (desc.data == descriptor_loop);
+
+  fail_unless (gst_mpegts_descriptor_iter_next (&iter, &desc));
+  fail_unless (desc.tag == 0x40);
+  fail_unless (desc.length == 4);
+  fail_unless (desc.data == descriptor_loop + 6);
+  fail_unless (gst_mpegts_descriptor_parse_dvb_network_name (&desc, &name));
+  fail_unless_equals_string (name, "Name");
+  g_free (name);
+
+  /* The truncated descriptor ends the iteration */
+  fail_if (gst_mpegts_descriptor_iter_next (&iter, &desc));
+  fail_if (gst_mpegts_descriptor_iter_next (&iter, &desc));
+
+  /* Empty loop */
+  gst_mpegts_descriptor_iter_init (&iter, descriptor_loop, 0);
+  fail_if (gst_mpegts_descriptor_iter_next (&iter, &desc));
+}
+
+GST_END_TEST;
+
 static Suite *
 mpegts_suite (void)
 {
@@ -685,6 +727,7 @@ mpegts_suite (void)
   tcase_add_test (tc_chain, test_mpegts_atsc_stt);
   tcase_add_test (tc_chain, test_mpegts_descriptors);
   tcase_add_test (tc_chain, test_mpegts_dvb_descriptors);
+  tcase_add_test (tc_chain, test_mpegts_descriptor_iter);
 
   return s;
 }
@@ -342,6 +342,76 @@ GST_START_TEST (test_retrieve_combined)
 
 GST_END_TEST;
 
+GST_START_TEST (test_retrieve_take_rest_for_write)
+{
+  GstPlanarAudioAdapter *adapter;
+  GstAudioInfo info;
+  GstBuffer *buf;
+  gpointer data;
+
+  adapter = gst_planar_audio_adapter_new ();
+
+  gst_audio_info_init (&info);
+  gst_audio_info_set_format (&info, GST_AUDIO_FORMAT_S16, 100, 2, NULL);
+  info.layout = GST_AUDIO_LAYOUT_NON_INTERLEAVED;
+
+  gst_planar_audio_adapter_configure (adapter, &info);
+  buf = generate_buffer (&info, 20, 0, 0, &data);
+  gst_planar_audio_adapter_push (adapter, buf);
+
+  gst_planar_audio_adapter_flush (adapter, 5);
+  fail_unless_equals_int (gst_planar_audio_adapter_available (adapter), 15);
+
+  /* the rest of the buffer is handed out as it is, without a copy */
+  buf = gst_planar_audio_adapter_take_buffer (adapter, 15, GST_MAP_WRITE);
+  fail_unless (buf);
+  fail_unless_equals_int (GST_MINI_OBJECT_REFCOUNT_VALUE (buf), 1);
+  fail_unless_equals_int (gst_planar_audio_adapter_available (adapter), 0);
+  verify_buffer_contents (buf, &info, 2, 15 * sizeof (gint16),
+      data, 20 * sizeof (gint16), 5 * sizeof (gint16));
+  gst_buffer_unref (buf);
+
+  g_object_unref (adapter);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_retrieve_combined_many_planes)
+{
+  GstPlanarAudioAdapter *adapter;
+  GstAudioInfo info;
+  GstBuffer *buf;
+  gint i;
+
+  adapter = gst_planar_audio_adapter_new ();
+
+  gst_audio_info_init (&info);
+  gst_audio_info_set_format (&info, GST_AUDIO_FORMAT_S16, 100, 8, NULL);
+  info.layout = GST_AUDIO_LAYOUT_NON_INTERLEAVED;
+
+  gst_planar_audio_adapter_configure (adapter, &info);
+  for (i = 0; i < 4; i++) {
+    buf = generate_buffer (&info, 10, 3, 2, NULL);
+    gst_planar_audio_adapter_push (adapter, buf);
+  }
+  fail_unless_equals_int (gst_planar_audio_adapter_available (adapter), 40);
+
+  gst_planar_audio_adapter_flush (adapter, 5);
+
+  /* 8 planes out of 4 buffers need more memories than a buffer can hold */
+  buf = gst_planar_audio_adapter_take_buffer (adapter, 32, GST_MAP_READ);
+  fail_unless (buf);
+  fail_unless_equals_int (GST_MINI_OBJECT_REFCOUNT_VALUE (buf), 1);
+  fail_unless_equals_int (gst_buffer_n_memory (buf), 1);
+  fail_unless_equals_int (gst_planar_audio_adapter_available (adapter), 3);
+  verify_buffer_contents (buf, &info, 8, 32 * sizeof (gint16), NULL, 0, 0);
+  gst_buffer_unref (buf);
+
+  g_object_unref (adapter);
+}
+
+GST_END_TEST;
+
 static Suite *
 planar_audio_adapter_suite (void)
 {
@@ -354,6 +424,8 @@ planar_audio_adapter_suite (void)
   tcase_add_test (tc_chain, test_retrieve_smaller_for_read);
   tcase_add_test (tc_chain, test_retrieve_smaller_for_write);
   tcase_add_test (tc_chain, test_retrieve_combined);
+  tcase_add_test (tc_chain, test_retrieve_take_rest_for_write);
+  tcase_add_test (tc_chain, test_retrieve_combined_many_planes);
 
   return s;
 }
@@ -540,6 +540,84 @@ START_TEST (test_play_audio_eos)
 
 END_TEST;
 
+static void
+test_play_preload_cb (GstPlay * player, TestPlayerStateChange change,
+    TestPlayerState * old_state, TestPlayerState * new_state)
+{
+  gint step = GPOINTER_TO_INT (new_state->test_data);
+  gchar *uri;
+
+  switch (step) {
+    case 0:
+      if (change != STATE_CHANGE_STATE_CHANGED
+          || new_state->state != GST_PLAY_STATE_PLAYING)
+        break;
+
+      uri = gst_filename_to_uri (TEST_PATH "/audio-video-short.ogg", NULL);
+      fail_unless (uri != NULL);
+      gst_play_preload_uri (player, uri);
+      gst_play_set_uri (player, uri);
+      g_free (uri);
+
+      gst_play_play (player);
+      new_state->test_data = GINT_TO_POINTER (step + 1);
+      break;
+    case 1:
+      if (change != STATE_CHANGE_URI_LOADED)
+        break;
+
+      fail_unless (g_str_has_suffix (new_state->uri_loaded,
+              "audio-video-short.ogg"));
+      new_state->test_data = GINT_TO_POINTER (step + 1);
+      break;
+    case 2:
+      if (change != STATE_CHANGE_STATE_CHANGED
+          || new_state->state != GST_PLAY_STATE_PLAYING)
+        break;
+
+      fail_unless (new_state->media_info != NULL);
+      fail_unless_equals_int
+          (gst_play_media_info_get_number_of_video_streams
+          (new_state->media_info), 1);
+      new_state->test_data = GINT_TO_POINTER (step + 1);
+      new_state->done = TRUE;
+      break;
+    default:
+      fail ();
+      break;
+  }
+}
+
+START_TEST (test_play_preload)
+{
+  GstPlay *player;
+  TestPlayerState state;
+  gchar *uri;
+
+  memset (&state, 0, sizeof (state));
+  state.test_callback = test_play_preload_cb;
+  state.test_data = GINT_TO_POINTER (0);
+
+  player = test_play_new (&state);
+
+  fail_unless (player != NULL);
+
+  uri = gst_filename_to_uri (TEST_PATH "/audio-short.ogg", NULL);
+  fail_unless (uri != NULL);
+  gst_play_set_uri (player, uri);
+  g_free (uri);
+
+  gst_play_play (player);
+  process_play_messages (player, &state);
+
+  fail_unless_equals_int (GPOINTER_TO_INT (state.test_data), 3);
+
+  stop_player (player, &state);
+  g_object_unref (player);
+}
+
+END_TEST;
+
 static void
 test_audio_info (GstPlayMediaInfo * media_info)
 {
@@ -1804,6 +1882,7 @@ play_suite (void)
   }
   tcase_add_test (tc_general, test_play_audio_eos);
   tcase_add_test (tc_general, test_play_audio_video_eos);
+  tcase_add_test (tc_general, test_play_preload);
   tcase_add_test (tc_general, test_play_error_invalid_uri);
   tcase_add_test (tc_general, test_play_error_invalid_uri_and_play);
   tcase_add_test (tc_general, test_play_media_info);
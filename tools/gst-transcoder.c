@@ -61,7 +61,7 @@ static const gchar *HELP_SUMMARY =
 
 typedef struct
 {
-  gint cpu_usage, rate;
+  gint cpu_usage, rate, parallel_segments;
   gboolean list;
   GstEncodingProfile *profile;
   gchar *src_uri, *dest_uri, *encoding_format, *size;
@@ -328,6 +328,7 @@ main (int argc, char *argv[])
   Settings settings = {
     .cpu_usage = 100,
     .rate = -1,
+    .parallel_segments = 1,
     .encoding_format = NULL,
     .size = NULL,
     .framerate = NULL,
@@ -346,6 +347,10 @@ main (int argc, char *argv[])
           " or a single number (24 for 24fps))", NULL},
     {"video-encoder", 'v', 0, G_OPTION_ARG_STRING, &settings.size,
         "The video encoder to use.", NULL},
+    {"parallel-segments", 'j', 0, G_OPTION_ARG_INT,
+          &settings.parallel_segments,
+          "Split seekable inputs into that many time ranges transcoded in"
+          " parallel", NULL},
     {NULL}
   };
 
@@ -417,6 +422,9 @@ main (int argc, char *argv[])
       settings.profile);
   gst_transcoder_set_avoid_reencoding (transcoder, TRUE);
   gst_transcoder_set_cpu_usage (transcoder, settings.cpu_usage);
+  if (settings.parallel_segments > 1)
+    gst_transcoder_set_parallel_segments (transcoder,
+        settings.parallel_segments);
 
   signal_adapter = gst_transcoder_get_signal_adapter (transcoder, NULL);
   g_signal_connect_swapped (signal_adapter, "position-updated",